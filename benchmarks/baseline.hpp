@@ -0,0 +1,515 @@
+/**
+ * @file baseline.hpp
+ *
+ * Baselines of the benchmarks: the wall-clock times of repeated trials of each
+ * run are saved to a file, and a later set of trials is compared against them
+ * with the median, distribution-free confidence intervals of the median, and
+ * a Mann-Whitney U test of whether the times changed.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_BENCHMARKS_BASELINE_HPP
+#define ENSMALLEN_BENCHMARKS_BASELINE_HPP
+
+#include "benchmark_tools.hpp"
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace ens {
+namespace benchmark {
+
+/**
+ * The trials of a single benchmark run: a problem of a given size solved by
+ * an optimizer with a given number of threads.
+ */
+struct Sample
+{
+  //! Name of the problem.
+  std::string problem;
+  //! Size of the problem.
+  size_t size;
+  //! Name of the optimizer.
+  std::string optimizer;
+  //! Number of threads.
+  size_t threads;
+  //! Wall-clock time of each trial in seconds.
+  std::vector<double> times;
+  //! Final objective of each trial.
+  std::vector<double> objectives;
+
+  //! Tell whether the sample is of the same run as the given one.
+  bool SameRun(const Sample& other) const
+  {
+    return problem == other.problem && size == other.size &&
+        optimizer == other.optimizer && threads == other.threads;
+  }
+};
+
+/**
+ * Group the results of repeated trials into one sample per run, in the order
+ * the runs first appear in the results.
+ *
+ * @param results Results of all trials.
+ * @param samples Vector to store the samples in.
+ */
+inline void CollectSamples(const std::vector<Result>& results,
+                           std::vector<Sample>& samples)
+{
+  samples.clear();
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    const Result& r = results[i];
+    Sample sample;
+    sample.problem = r.problem;
+    sample.size = r.size;
+    sample.optimizer = r.optimizer;
+    sample.threads = r.threads;
+
+    size_t j = 0;
+    while (j < samples.size() && !samples[j].SameRun(sample))
+      ++j;
+    if (j == samples.size())
+      samples.push_back(sample);
+
+    samples[j].times.push_back(r.time);
+    samples[j].objectives.push_back(r.objective);
+  }
+}
+
+/**
+ * Write the given samples as a baseline.  The baseline is a text file with a
+ * header line giving the version of ensmallen, and one tab-separated line per
+ * run: the problem, the size, the optimizer, the number of threads, and the
+ * comma-separated times and objectives of the trials.
+ *
+ * @param stream Stream to write to.
+ * @param samples Samples to write.
+ */
+inline void WriteBaseline(std::ostream& stream,
+                          const std::vector<Sample>& samples)
+{
+  stream << "# ensmallen benchmark baseline, version "
+      << version::as_string() << "\n";
+  stream << std::setprecision(17);
+  for (size_t i = 0; i < samples.size(); ++i)
+  {
+    const Sample& s = samples[i];
+    stream << s.problem << "\t" << s.size << "\t" << s.optimizer << "\t"
+        << s.threads << "\t";
+    for (size_t t = 0; t < s.times.size(); ++t)
+      stream << (t > 0 ? "," : "") << s.times[t];
+    stream << "\t";
+    for (size_t t = 0; t < s.objectives.size(); ++t)
+      stream << (t > 0 ? "," : "") << s.objectives[t];
+    stream << "\n";
+  }
+  stream.flush();
+}
+
+/**
+ * Read a baseline written by WriteBaseline().  A std::runtime_error is thrown
+ * if a line is malformed.
+ *
+ * @param stream Stream to read from.
+ * @param samples Vector to store the samples in.
+ */
+inline void ReadBaseline(std::istream& stream, std::vector<Sample>& samples)
+{
+  samples.clear();
+  std::string line;
+  size_t lineNumber = 0;
+  while (std::getline(stream, line))
+  {
+    ++lineNumber;
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    std::vector<std::string> fields;
+    std::stringstream lineStream(line);
+    std::string field;
+    while (std::getline(lineStream, field, '\t'))
+      fields.push_back(field);
+
+    Sample sample;
+    if (fields.size() == 6)
+    {
+      sample.problem = fields[0];
+      sample.size = std::strtoul(fields[1].c_str(), NULL, 10);
+      sample.optimizer = fields[2];
+      sample.threads = std::strtoul(fields[3].c_str(), NULL, 10);
+      for (size_t f = 4; f < 6; ++f)
+      {
+        std::vector<double>& values = (f == 4) ? sample.times :
+            sample.objectives;
+        std::stringstream valueStream(fields[f]);
+        std::string value;
+        while (std::getline(valueStream, value, ','))
+          values.push_back(std::strtod(value.c_str(), NULL));
+      }
+    }
+
+    if (sample.times.empty() ||
+        sample.times.size() != sample.objectives.size())
+    {
+      std::ostringstream oss;
+      oss << "ReadBaseline(): malformed line " << lineNumber
+          << " of the baseline.";
+      throw std::runtime_error(oss.str());
+    }
+
+    samples.push_back(sample);
+  }
+}
+
+/**
+ * Return the median of the given values (NaN if there are none).
+ */
+inline double Median(std::vector<double> values)
+{
+  if (values.empty())
+    return std::numeric_limits<double>::quiet_NaN();
+
+  std::sort(values.begin(), values.end());
+  const size_t n = values.size();
+  return (n % 2 == 1) ? values[n / 2] :
+      0.5 * (values[n / 2 - 1] + values[n / 2]);
+}
+
+/**
+ * Compute a distribution-free confidence interval of the median of the given
+ * values: the order statistics whose ranks bound the median with at least the
+ * given probability, by the binomial distribution of the number of values
+ * below the median.  With too few values for the requested confidence, the
+ * interval is the range of the values.
+ *
+ * @param values Values to compute the interval of.
+ * @param confidence Probability that the interval contains the median.
+ * @param lower Lower bound of the interval.
+ * @param upper Upper bound of the interval.
+ */
+inline void MedianInterval(std::vector<double> values,
+                           const double confidence,
+                           double& lower,
+                           double& upper)
+{
+  if (values.empty())
+  {
+    lower = upper = std::numeric_limits<double>::quiet_NaN();
+    return;
+  }
+
+  std::sort(values.begin(), values.end());
+  const size_t n = values.size();
+
+  // Find the largest k such that P(B < k) <= (1 - confidence) / 2 for
+  // B ~ Binomial(n, 1/2); the interval is then [x_(k), x_(n - k + 1)] (with
+  // one-based ranks).
+  const double tail = 0.5 * (1.0 - confidence);
+  double probability = std::pow(0.5, double(n));
+  double cumulative = 0.0;
+  size_t k = 0;
+  while (k < n / 2 && cumulative + probability <= tail)
+  {
+    cumulative += probability;
+    ++k;
+    probability *= double(n - k + 1) / double(k);
+  }
+
+  lower = values[(k > 0) ? k - 1 : 0];
+  upper = values[(k > 0) ? n - k : n - 1];
+}
+
+/**
+ * Return the two-sided p-value of the Mann-Whitney U test of whether the
+ * values of the two samples come from the same distribution.  The exact null
+ * distribution of U is used for small samples without ties; otherwise the
+ * normal approximation with the tie and continuity corrections is used.
+ *
+ * @param a The first sample.
+ * @param b The second sample.
+ */
+inline double MannWhitneyPValue(const std::vector<double>& a,
+                                const std::vector<double>& b)
+{
+  const size_t n1 = a.size();
+  const size_t n2 = b.size();
+  if (n1 == 0 || n2 == 0)
+    return std::numeric_limits<double>::quiet_NaN();
+
+  // Rank the pooled values, giving tied values their average rank.
+  std::vector<std::pair<double, size_t>> pooled;
+  for (size_t i = 0; i < n1; ++i)
+    pooled.push_back(std::make_pair(a[i], size_t(0)));
+  for (size_t i = 0; i < n2; ++i)
+    pooled.push_back(std::make_pair(b[i], size_t(1)));
+  std::sort(pooled.begin(), pooled.end());
+
+  const size_t n = n1 + n2;
+  double rankSum = 0.0;
+  double tieCorrection = 0.0;
+  for (size_t i = 0; i < n; )
+  {
+    size_t j = i;
+    while (j < n && pooled[j].first == pooled[i].first)
+      ++j;
+    const double rank = 0.5 * double(i + j + 1);
+    for (size_t l = i; l < j; ++l)
+    {
+      if (pooled[l].second == 0)
+        rankSum += rank;
+    }
+    const double ties = double(j - i);
+    tieCorrection += ties * ties * ties - ties;
+    i = j;
+  }
+
+  const double u = rankSum - 0.5 * double(n1 * (n1 + 1));
+  const double mean = 0.5 * double(n1 * n2);
+
+  if (tieCorrection == 0.0 && n1 <= 50 && n2 <= 50)
+  {
+    // counts[j][v] is the number of orderings of i values of the first sample
+    // and j of the second with U = v, for the current i: the largest value
+    // either belongs to the first sample and adds j to U, or to the second.
+    const size_t maxU = n1 * n2;
+    std::vector<std::vector<double>> counts(n2 + 1,
+        std::vector<double>(maxU + 1, 0.0));
+    for (size_t j = 0; j <= n2; ++j)
+      counts[j][0] = 1.0;
+    for (size_t i = 1; i <= n1; ++i)
+    {
+      std::vector<std::vector<double>> next(n2 + 1,
+          std::vector<double>(maxU + 1, 0.0));
+      for (size_t j = 0; j <= n2; ++j)
+      {
+        for (size_t v = 0; v <= maxU; ++v)
+        {
+          next[j][v] = (v >= j ? counts[j][v - j] : 0.0) +
+              (j > 0 ? next[j - 1][v] : 0.0);
+        }
+      }
+      counts.swap(next);
+    }
+
+    double total = 0.0;
+    double tail = 0.0;
+    const double distance = std::abs(u - mean);
+    for (size_t v = 0; v <= maxU; ++v)
+    {
+      total += counts[n2][v];
+      if (std::abs(double(v) - mean) >= distance - 1e-9)
+        tail += counts[n2][v];
+    }
+    return std::min(1.0, tail / total);
+  }
+
+  const double variance = double(n1 * n2) / 12.0 * (double(n + 1) -
+      tieCorrection / double(n * (n - 1)));
+  if (variance <= 0.0)
+    return 1.0;
+  const double z = std::max(0.0, std::abs(u - mean) - 0.5) /
+      std::sqrt(variance);
+  return std::erfc(z / std::sqrt(2.0));
+}
+
+/**
+ * The comparison of the trials of a run with its baseline.
+ */
+struct Comparison
+{
+  //! The status of the run.
+  enum Status
+  {
+    //! The times did not change significantly.
+    Unchanged,
+    //! The run is significantly slower than the baseline.
+    Regression,
+    //! The run is significantly faster than the baseline.
+    Improvement,
+    //! The run is not in the baseline.
+    New,
+    //! The run of the baseline was not run.
+    Missing
+  };
+
+  //! The baseline (empty for a new run).
+  Sample baseline;
+  //! The current trials (empty for a missing run).
+  Sample current;
+  //! Median time of the baseline.
+  double baselineMedian;
+  //! Confidence interval of the median time of the baseline.
+  double baselineLower, baselineUpper;
+  //! Median time of the current trials.
+  double currentMedian;
+  //! Confidence interval of the median time of the current trials.
+  double currentLower, currentUpper;
+  //! Ratio of the current median time to the baseline median time.
+  double ratio;
+  //! Two-sided p-value of the Mann-Whitney U test.
+  double pValue;
+  //! The status of the run.
+  Status status;
+
+  //! Get the status as a string.
+  const char* StatusString() const
+  {
+    switch (status)
+    {
+      case Regression: return "REGRESSION";
+      case Improvement: return "improvement";
+      case New: return "new";
+      case Missing: return "missing";
+      default: return "unchanged";
+    }
+  }
+};
+
+/**
+ * Compare the current trials with a baseline.  A run is a regression if its
+ * median time is more than the given relative threshold above the median of
+ * the baseline and the Mann-Whitney U test rejects equal distributions at the
+ * given level; it is an improvement under the same conditions with the median
+ * time below the baseline.  With a single trial on either side the test
+ * cannot reject, so at least three trials (five for the default level) are
+ * needed to detect any change.
+ *
+ * @param baseline Samples of the baseline.
+ * @param current Samples of the current trials.
+ * @param threshold Relative change of the median time that is reported.
+ * @param alpha Significance level of the test.
+ * @param confidence Confidence level of the intervals of the medians.
+ * @param comparisons Vector to store the comparisons in: the current runs in
+ *     order, and then the runs of the baseline that were not run.
+ * @return The number of regressions.
+ */
+inline size_t Compare(const std::vector<Sample>& baseline,
+                      const std::vector<Sample>& current,
+                      const double threshold,
+                      const double alpha,
+                      const double confidence,
+                      std::vector<Comparison>& comparisons)
+{
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  comparisons.clear();
+  std::vector<bool> matched(baseline.size(), false);
+  size_t regressions = 0;
+  for (size_t i = 0; i <= current.size(); ++i)
+  {
+    // After the current runs, add the runs of the baseline that were not
+    // matched.
+    if (i == current.size())
+    {
+      for (size_t j = 0; j < baseline.size(); ++j)
+      {
+        if (matched[j])
+          continue;
+        Comparison c;
+        c.baseline = baseline[j];
+        c.baselineMedian = Median(c.baseline.times);
+        MedianInterval(c.baseline.times, confidence, c.baselineLower,
+            c.baselineUpper);
+        c.currentMedian = c.currentLower = c.currentUpper = nan;
+        c.ratio = c.pValue = nan;
+        c.status = Comparison::Missing;
+        comparisons.push_back(c);
+      }
+      break;
+    }
+
+    Comparison c;
+    c.current = current[i];
+    c.currentMedian = Median(c.current.times);
+    MedianInterval(c.current.times, confidence, c.currentLower,
+        c.currentUpper);
+
+    size_t j = 0;
+    while (j < baseline.size() && !baseline[j].SameRun(current[i]))
+      ++j;
+    if (j == baseline.size())
+    {
+      c.baselineMedian = c.baselineLower = c.baselineUpper = nan;
+      c.ratio = c.pValue = nan;
+      c.status = Comparison::New;
+      comparisons.push_back(c);
+      continue;
+    }
+
+    matched[j] = true;
+    c.baseline = baseline[j];
+    c.baselineMedian = Median(c.baseline.times);
+    MedianInterval(c.baseline.times, confidence, c.baselineLower,
+        c.baselineUpper);
+    c.ratio = c.currentMedian / c.baselineMedian;
+    c.pValue = MannWhitneyPValue(c.baseline.times, c.current.times);
+
+    const bool significant = (c.pValue < alpha);
+    if (significant && c.ratio > 1.0 + threshold)
+    {
+      c.status = Comparison::Regression;
+      ++regressions;
+    }
+    else if (significant && c.ratio < 1.0 - threshold)
+    {
+      c.status = Comparison::Improvement;
+    }
+    else
+    {
+      c.status = Comparison::Unchanged;
+    }
+    comparisons.push_back(c);
+  }
+
+  return regressions;
+}
+
+/**
+ * Write the given comparisons as a table: for each run, the median time and
+ * its confidence interval in the baseline and now, their ratio, the p-value
+ * and the status.
+ *
+ * @param stream Stream to write to.
+ * @param comparisons Comparisons to write (see Compare()).
+ */
+inline void WriteComparison(std::ostream& stream,
+                            const std::vector<Comparison>& comparisons)
+{
+  stream << std::left << std::setw(32) << "problem" << std::right
+      << std::setw(8) << "size" << "  " << std::left << std::setw(32)
+      << "optimizer" << std::right << std::setw(8) << "threads"
+      << std::setw(28) << "baseline median [CI]" << std::setw(28)
+      << "current median [CI]" << std::setw(8) << "ratio" << std::setw(10)
+      << "p-value" << "  status\n";
+
+  for (size_t i = 0; i < comparisons.size(); ++i)
+  {
+    const Comparison& c = comparisons[i];
+    const Sample& s = (c.status == Comparison::Missing) ? c.baseline :
+        c.current;
+
+    std::ostringstream baselineTime, currentTime;
+    baselineTime << std::setprecision(3) << c.baselineMedian << " ["
+        << c.baselineLower << ", " << c.baselineUpper << "]";
+    currentTime << std::setprecision(3) << c.currentMedian << " ["
+        << c.currentLower << ", " << c.currentUpper << "]";
+
+    stream << std::left << std::setw(32) << s.problem << std::right
+        << std::setw(8) << s.size << "  " << std::left << std::setw(32)
+        << s.optimizer << std::right << std::setw(8) << s.threads
+        << std::setw(28) << baselineTime.str() << std::setw(28)
+        << currentTime.str() << std::setprecision(3) << std::setw(8)
+        << c.ratio << std::setw(10) << c.pValue << "  " << c.StatusString()
+        << "\n";
+  }
+  stream.flush();
+}
+
+} // namespace benchmark
+} // namespace ens
+
+#endif
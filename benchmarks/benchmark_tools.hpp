@@ -0,0 +1,714 @@
+/**
+ * @file benchmark_tools.hpp
+ *
+ * Utilities for the ensmallen benchmark program: a function wrapper that counts
+ * evaluations and data passes, a callback that counts iterations and epochs, a
+ * trace of the objective over time, peak memory measurement, speedup and
+ * time-to-target computation, a small JSON writer, and a leaderboard writer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_BENCHMARKS_BENCHMARK_TOOLS_HPP
+#define ENSMALLEN_BENCHMARKS_BENCHMARK_TOOLS_HPP
+
+#include <ensmallen.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+  #include <sys/resource.h>
+#endif
+
+namespace ens {
+namespace benchmark {
+
+/**
+ * The best objective found over the time of an optimization: the time and
+ * value of every objective that improves on all the previous ones, and the
+ * number of passes over the data made by then (if known).  Time can be
+ * excluded from the trace (for instance the objective evaluations that the
+ * benchmark adds between segments of a run), and points may be recorded by
+ * several threads at once.
+ */
+class ObjectiveTrace
+{
+ public:
+  //! Create an empty trace.
+  ObjectiveTrace() :
+      excluded(0.0),
+      pausedAt(0.0),
+      paused(false),
+      best(std::numeric_limits<double>::infinity())
+  { /* Nothing to do. */ }
+
+  //! Clear the trace and start its clock.
+  void Start()
+  {
+    points.clear();
+    passes.clear();
+    excluded = 0.0;
+    paused = false;
+    best = std::numeric_limits<double>::infinity();
+    timer.tic();
+  }
+
+  //! Stop the clock, until Resume() is called.
+  void Pause()
+  {
+    pausedAt = timer.toc();
+    paused = true;
+  }
+
+  //! Restart the clock after Pause().
+  void Resume()
+  {
+    excluded += timer.toc() - pausedAt;
+    paused = false;
+  }
+
+  //! Get the time since Start() that was not excluded, in seconds.
+  double Elapsed() { return (paused ? pausedAt : timer.toc()) - excluded; }
+
+  /**
+   * Record the given objective, if it is better than all the previous ones.
+   *
+   * @param objective The objective.
+   * @param dataPasses The number of passes over the data so far (NaN if not
+   *     known).
+   */
+  void Record(const double objective,
+              const double dataPasses =
+                  std::numeric_limits<double>::quiet_NaN())
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (objective < best)
+    {
+      best = objective;
+      points.push_back(std::make_pair(Elapsed(), objective));
+      passes.push_back(dataPasses);
+    }
+  }
+
+  //! Get the (time, objective) points of the trace.
+  const std::vector<std::pair<double, double>>& Points() const
+  {
+    return points;
+  }
+
+  //! Get the number of passes over the data at each point of the trace.
+  const std::vector<double>& Passes() const { return passes; }
+
+ private:
+  //! The clock of the trace.
+  arma::wall_clock timer;
+  //! The time excluded so far.
+  double excluded;
+  //! The time at which the clock was paused.
+  double pausedAt;
+  //! Whether the clock is paused.
+  bool paused;
+  //! The best objective so far.
+  double best;
+  //! The (time, objective) points.
+  std::vector<std::pair<double, double>> points;
+  //! The number of passes over the data at each point.
+  std::vector<double> passes;
+  //! The lock of the points.
+  std::mutex mutex;
+};
+
+/**
+ * Return the index of the first point at which the given trace reaches the
+ * target objective, or the size of the trace if it never does.
+ */
+inline size_t TargetIndex(const std::vector<std::pair<double, double>>& trace,
+                          const double target)
+{
+  size_t i = 0;
+  while (i < trace.size() && trace[i].second > target)
+    ++i;
+  return i;
+}
+
+/**
+ * Return the first time at which the given trace reaches the target
+ * objective, or NaN if it never does.
+ */
+inline double TimeToTarget(const std::vector<std::pair<double, double>>& trace,
+                           const double target)
+{
+  const size_t i = TargetIndex(trace, target);
+  return (i < trace.size()) ? trace[i].first :
+      std::numeric_limits<double>::quiet_NaN();
+}
+
+/**
+ * Wrap a function and count the number of objective and gradient evaluations
+ * performed by the optimizer, and the number of separable functions they
+ * visit.  All calls are forwarded to the Function<> wrapper of the given
+ * function, so any method that ensmallen can derive for the function is
+ * available (and counted) here as well.  The counters are atomic, so the
+ * wrapper may be used by parallel optimizers.
+ *
+ * With CheckInterval(), the objective of the whole function is also evaluated
+ * at the point of the first call after every given number of passes over the
+ * data, and recorded in the trace; the time of these checks is excluded from
+ * the trace, and they are not counted.  This traces the progress of
+ * optimizers that take no callbacks, but it is only meant for optimizers that
+ * evaluate the function from a single thread.
+ *
+ * @tparam FunctionType Type of the wrapped function.
+ * @tparam GradType Type of the gradient used by the optimizer.
+ */
+template<typename FunctionType, typename GradType = arma::mat>
+class CountingFunction
+{
+ public:
+  //! Convenience typedef for the wrapped function.
+  typedef Function<FunctionType, arma::mat, GradType> FullFunctionType;
+
+  //! Wrap the given function.
+  CountingFunction(FunctionType& function) :
+      function(static_cast<FullFunctionType&>(function)),
+      evaluations(0),
+      gradients(0),
+      functions(0),
+      fullPasses(0),
+      trace(NULL),
+      checkInterval(0.0),
+      nextCheck(0.0)
+  { /* Nothing to do. */ }
+
+  //! Record the objectives of the whole function in the given trace.
+  void Trace(ObjectiveTrace& objectiveTrace) { trace = &objectiveTrace; }
+
+  //! Also record the objective of the whole function in the trace after every
+  //! given number of passes over the data (0 means never).
+  void CheckInterval(const double passes)
+  {
+    checkInterval = passes;
+    nextCheck = Passes() + passes;
+  }
+
+  //! Get the wrapped function, to evaluate it without counting.
+  FullFunctionType& Wrapped() { return function; }
+
+  //! Return the number of separable functions.
+  size_t NumFunctions() const { return function.NumFunctions(); }
+
+  //! Shuffle the separable functions.
+  void Shuffle() { function.Shuffle(); }
+
+  //! Return the number of features (for coordinate descent).
+  size_t NumFeatures() const { return function.NumFeatures(); }
+
+  //! Evaluate the objective.
+  double Evaluate(const arma::mat& coordinates)
+  {
+    Check(coordinates);
+    ++evaluations;
+    ++fullPasses;
+    const double objective = function.Evaluate(coordinates);
+    if (trace)
+      trace->Record(objective, Passes());
+    return objective;
+  }
+
+  //! Evaluate the objective of a batch of separable functions.
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t begin,
+                  const size_t batchSize)
+  {
+    Check(coordinates);
+    ++evaluations;
+    functions += batchSize;
+    return function.Evaluate(coordinates, begin, batchSize);
+  }
+
+  //! Evaluate the gradient.
+  void Gradient(const arma::mat& coordinates, GradType& gradient)
+  {
+    Check(coordinates);
+    ++gradients;
+    ++fullPasses;
+    function.Gradient(coordinates, gradient);
+  }
+
+  //! Evaluate the gradient of a batch of separable functions.
+  void Gradient(const arma::mat& coordinates,
+                const size_t begin,
+                GradType& gradient,
+                const size_t batchSize = 1)
+  {
+    Check(coordinates);
+    ++gradients;
+    functions += batchSize;
+    function.Gradient(coordinates, begin, gradient, batchSize);
+  }
+
+  //! Evaluate the partial gradient with respect to the given feature (for
+  //! coordinate descent).
+  void PartialGradient(const arma::mat& coordinates,
+                       const size_t j,
+                       arma::sp_mat& gradient)
+  {
+    ++gradients;
+    function.PartialGradient(coordinates, j, gradient);
+  }
+
+  //! Evaluate the objective and the gradient.
+  double EvaluateWithGradient(const arma::mat& coordinates, GradType& gradient)
+  {
+    Check(coordinates);
+    ++evaluations;
+    ++gradients;
+    ++fullPasses;
+    const double objective = function.EvaluateWithGradient(coordinates,
+        gradient);
+    if (trace)
+      trace->Record(objective, Passes());
+    return objective;
+  }
+
+  //! Evaluate the objective and the gradient of a batch of separable
+  //! functions.
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              const size_t begin,
+                              GradType& gradient,
+                              const size_t batchSize)
+  {
+    Check(coordinates);
+    ++evaluations;
+    ++gradients;
+    functions += batchSize;
+    return function.EvaluateWithGradient(coordinates, begin, gradient,
+        batchSize);
+  }
+
+  //! Get the number of objective evaluations.
+  size_t Evaluations() const { return evaluations; }
+  //! Get the number of gradient evaluations.
+  size_t Gradients() const { return gradients; }
+
+  //! Get the number of passes over the data: the separable functions visited
+  //! by the evaluations, divided by their number, and one for each evaluation
+  //! of the whole function.
+  double Passes() const
+  {
+    return fullPasses + double(functions) / function.NumFunctions();
+  }
+
+ private:
+  //! Record the objective at the given point if a check is due.
+  void Check(const arma::mat& coordinates)
+  {
+    if (checkInterval <= 0.0 || trace == NULL || Passes() < nextCheck)
+      return;
+
+    const double passes = Passes();
+    trace->Pause();
+    trace->Record(function.Evaluate(coordinates), passes);
+    trace->Resume();
+    while (nextCheck <= passes)
+      nextCheck += checkInterval;
+  }
+
+  //! The wrapped function.
+  FullFunctionType& function;
+  //! The number of objective evaluations.
+  std::atomic<size_t> evaluations;
+  //! The number of gradient evaluations.
+  std::atomic<size_t> gradients;
+  //! The number of separable functions visited by the evaluations.
+  std::atomic<size_t> functions;
+  //! The number of evaluations of the whole function.
+  std::atomic<size_t> fullPasses;
+  //! The trace of the objectives (NULL for none).
+  ObjectiveTrace* trace;
+  //! The number of passes between two checks of the objective (0 for none).
+  double checkInterval;
+  //! The number of passes at which the next check is due.
+  double nextCheck;
+};
+
+/**
+ * Return the number of passes over the data made through the given function,
+ * if it is (or derives from) a CountingFunction.
+ */
+template<typename FunctionType>
+auto DataPasses(const FunctionType& function, int) ->
+    decltype(double(function.Passes()))
+{
+  return function.Passes();
+}
+
+//! The number of passes through other functions is not known.
+template<typename FunctionType>
+double DataPasses(const FunctionType& /* function */, long)
+{
+  return std::numeric_limits<double>::quiet_NaN();
+}
+
+/**
+ * Callback that counts the steps and epochs taken by an optimizer.
+ */
+class CountingCallback
+{
+ public:
+  //! Create the callback with zeroed counters.
+  CountingCallback() : steps(0), epochs(0), trace(NULL) { }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void StepTaken(OptimizerType& /* optimizer */,
+                 FunctionType& /* function */,
+                 MatType& /* coordinates */)
+  {
+    ++steps;
+  }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndEpoch(OptimizerType& /* optimizer */,
+                FunctionType& function,
+                const MatType& /* coordinates */,
+                const size_t /* epoch */,
+                const double objective)
+  {
+    ++epochs;
+    if (trace)
+      trace->Record(objective, DataPasses(function, 0));
+  }
+
+  //! The number of steps taken.
+  size_t steps;
+  //! The number of completed epochs.
+  size_t epochs;
+  //! The trace to record the objective of each epoch in (NULL for none).
+  ObjectiveTrace* trace;
+};
+
+/**
+ * Reset the peak resident set size of the process, if the platform allows it
+ * (Linux 4.0 and newer); otherwise the reported peak is the peak of the whole
+ * process so far.
+ */
+inline void ResetPeakMemory()
+{
+#if defined(__linux__)
+  std::ofstream clearRefs("/proc/self/clear_refs");
+  if (clearRefs.is_open())
+    clearRefs << "5";
+#endif
+}
+
+/**
+ * Return the peak resident set size of the process in kilobytes, or 0 if it
+ * cannot be determined.
+ */
+inline size_t PeakMemory()
+{
+#if defined(__linux__)
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line))
+  {
+    if (line.compare(0, 6, "VmHWM:") == 0)
+      return std::strtoul(line.c_str() + 6, NULL, 10);
+  }
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+  {
+  #if defined(__APPLE__)
+    return usage.ru_maxrss / 1024; // Bytes on macOS.
+  #else
+    return usage.ru_maxrss;
+  #endif
+  }
+#endif
+
+  return 0;
+}
+
+/**
+ * The result of a single benchmark run.
+ */
+struct Result
+{
+  //! Name of the problem.
+  std::string problem;
+  //! Size of the problem (dimensions or number of points).
+  size_t size;
+  //! Name of the optimizer.
+  std::string optimizer;
+  //! Number of threads.
+  size_t threads;
+  //! Wall-clock time of the whole optimization in seconds.
+  double time;
+  //! Number of steps taken (0 if unknown).
+  size_t steps;
+  //! Number of completed epochs (0 if unknown).
+  size_t epochs;
+  //! Number of objective evaluations.
+  size_t evaluations;
+  //! Number of gradient evaluations.
+  size_t gradients;
+  //! Number of passes over the data.
+  double passes;
+  //! Objective value at the final point.
+  double objective;
+  //! Peak resident set size in kilobytes (0 if unknown).
+  size_t peakMemory;
+  //! Objective value at the initial point.
+  double initialObjective;
+  //! The best objective over time.
+  std::vector<std::pair<double, double>> trace;
+  //! The number of passes over the data at each point of the trace.
+  std::vector<double> tracePasses;
+  //! Speedup over the run with one thread (NaN if there is none).
+  double speedup;
+  //! Speedup divided by the number of threads.
+  double efficiency;
+  //! The target objective (see ComputeScaling() and ComputeTargets()).
+  double target;
+  //! Time to reach the target objective.
+  double timeToTarget;
+  //! Number of passes over the data to reach the target objective.
+  double passesToTarget;
+  //! Speedup in the time to reach the target objective.
+  double targetSpeedup;
+};
+
+/**
+ * Set the target objective of the results of the given problem and size, and
+ * the time and number of passes over the data each of them took to reach it
+ * (NaN if it did not).
+ *
+ * @param results Results to compute the time to target of.
+ * @param problem Name of the problem.
+ * @param size Size of the problem.
+ * @param target Target objective.
+ */
+inline void ComputeTargets(std::vector<Result>& results,
+                           const std::string& problem,
+                           const size_t size,
+                           const double target)
+{
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    Result& r = results[i];
+    if (r.problem != problem || r.size != size)
+      continue;
+
+    r.speedup = r.efficiency = r.targetSpeedup = nan;
+    r.target = target;
+    const size_t j = TargetIndex(r.trace, target);
+    r.timeToTarget = (j < r.trace.size()) ? r.trace[j].first : nan;
+    r.passesToTarget = (j < r.tracePasses.size()) ? r.tracePasses[j] : nan;
+  }
+}
+
+/**
+ * Compute the speedup, the efficiency and the time to the target objective of
+ * each result, relative to the result of the same problem, size and optimizer
+ * with one thread.  The target is the objective at which the run with one
+ * thread achieved the given fraction of its improvement over the initial
+ * point, so that an optimizer that runs faster with more threads but
+ * converges to a worse point (as lock-free updates can) does not reach it.
+ *
+ * @param results Results to compute the scaling of.
+ * @param targetFraction Fraction of the improvement of the run with one
+ *     thread that defines the target.
+ */
+inline void ComputeScaling(std::vector<Result>& results,
+                           const double targetFraction = 0.99)
+{
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    Result& r = results[i];
+    r.speedup = r.efficiency = r.timeToTarget = r.targetSpeedup = nan;
+    r.target = r.passesToTarget = nan;
+
+    const Result* baseline = NULL;
+    for (size_t j = 0; j < results.size() && baseline == NULL; ++j)
+    {
+      if (results[j].threads == 1 && results[j].problem == r.problem &&
+          results[j].size == r.size && results[j].optimizer == r.optimizer)
+        baseline = &results[j];
+    }
+
+    if (baseline == NULL)
+      continue;
+
+    r.speedup = baseline->time / r.time;
+    r.efficiency = r.speedup / r.threads;
+
+    if (baseline->trace.empty())
+      continue;
+
+    const double best = baseline->trace.back().second;
+    r.target = baseline->initialObjective - targetFraction *
+        (baseline->initialObjective - best);
+    const size_t j = TargetIndex(r.trace, r.target);
+    r.timeToTarget = (j < r.trace.size()) ? r.trace[j].first : nan;
+    r.passesToTarget = (j < r.tracePasses.size()) ? r.tracePasses[j] : nan;
+    r.targetSpeedup = TimeToTarget(baseline->trace, r.target) /
+        r.timeToTarget;
+  }
+}
+
+/**
+ * Write a floating-point value as JSON; non-finite values become null.
+ */
+inline void WriteNumber(std::ostream& stream, const double value)
+{
+  if (std::isfinite(value))
+    stream << value;
+  else
+    stream << "null";
+}
+
+/**
+ * Write the given results as a JSON document.
+ *
+ * @param stream Stream to write to.
+ * @param results Results of all benchmark runs.
+ */
+inline void WriteJSON(std::ostream& stream, const std::vector<Result>& results)
+{
+  stream.precision(10);
+  stream << "{\n  \"ensmallen_version\": \"" << version::as_string()
+      << "\",\n  \"hardware_threads\": "
+      << std::thread::hardware_concurrency()
+      << ",\n  \"numa_nodes\": " << NumaNodes()
+      << ",\n  \"benchmarks\": [";
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    const Result& r = results[i];
+    stream << (i == 0 ? "\n" : ",\n") << "    { "
+        << "\"problem\": \"" << r.problem << "\", "
+        << "\"size\": " << r.size << ", "
+        << "\"optimizer\": \"" << r.optimizer << "\", "
+        << "\"threads\": " << r.threads << ", "
+        << "\"time\": ";
+    WriteNumber(stream, r.time);
+    stream << ", \"time_per_epoch\": ";
+    if (r.epochs > 0)
+      WriteNumber(stream, r.time / r.epochs);
+    else
+      stream << "null";
+    stream << ", \"steps\": " << r.steps
+        << ", \"epochs\": " << r.epochs
+        << ", \"evaluations\": " << r.evaluations
+        << ", \"gradient_evaluations\": " << r.gradients
+        << ", \"data_passes\": ";
+    WriteNumber(stream, r.passes);
+    stream << ", \"final_objective\": ";
+    WriteNumber(stream, r.objective);
+    stream << ", \"initial_objective\": ";
+    WriteNumber(stream, r.initialObjective);
+    stream << ", \"speedup\": ";
+    WriteNumber(stream, r.speedup);
+    stream << ", \"efficiency\": ";
+    WriteNumber(stream, r.efficiency);
+    stream << ", \"target_objective\": ";
+    WriteNumber(stream, r.target);
+    stream << ", \"time_to_target\": ";
+    WriteNumber(stream, r.timeToTarget);
+    stream << ", \"passes_to_target\": ";
+    WriteNumber(stream, r.passesToTarget);
+    stream << ", \"target_speedup\": ";
+    WriteNumber(stream, r.targetSpeedup);
+    stream << ", \"peak_memory_kb\": " << r.peakMemory << " }";
+  }
+  stream << "\n  ]\n}" << std::endl;
+}
+
+/**
+ * Write a leaderboard of the results of each problem and size (in the order
+ * they first appear in the results): the optimizers that reached the target
+ * objective, fastest first, and then the others, best final objective first.
+ *
+ * @param stream Stream to write to.
+ * @param results Results of all benchmark runs, with their targets (see
+ *     ComputeTargets()).
+ */
+inline void WriteLeaderboard(std::ostream& stream,
+                             const std::vector<Result>& results)
+{
+  std::vector<std::pair<std::string, size_t>> problems;
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    const std::pair<std::string, size_t> problem(results[i].problem,
+        results[i].size);
+    if (std::find(problems.begin(), problems.end(), problem) ==
+        problems.end())
+      problems.push_back(problem);
+  }
+
+  for (size_t p = 0; p < problems.size(); ++p)
+  {
+    std::vector<const Result*> board;
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+      if (results[i].problem == problems[p].first &&
+          results[i].size == problems[p].second)
+        board.push_back(&results[i]);
+    }
+
+    std::stable_sort(board.begin(), board.end(),
+        [](const Result* a, const Result* b)
+        {
+          const bool aReached = std::isfinite(a->timeToTarget);
+          const bool bReached = std::isfinite(b->timeToTarget);
+          if (aReached != bReached)
+            return aReached;
+          return aReached ? (a->timeToTarget < b->timeToTarget) :
+              (a->objective < b->objective);
+        });
+
+    stream << problems[p].first << " (" << problems[p].second
+        << "), target objective " << board[0]->target << ":\n";
+    stream << "  " << std::setw(4) << "rank" << "  " << std::left
+        << std::setw(16) << "optimizer" << std::right << std::setw(16)
+        << "time to target" << std::setw(18) << "passes to target"
+        << std::setw(16) << "final objective" << std::setw(12) << "time"
+        << std::setw(10) << "passes" << "\n";
+    for (size_t i = 0; i < board.size(); ++i)
+    {
+      const Result& r = *board[i];
+      stream << "  " << std::setw(4) << (i + 1) << "  " << std::left
+          << std::setw(16) << r.optimizer << std::right << std::setw(16);
+      if (std::isfinite(r.timeToTarget))
+        stream << r.timeToTarget;
+      else
+        stream << "-";
+      stream << std::setw(18);
+      if (std::isfinite(r.passesToTarget))
+        stream << r.passesToTarget;
+      else
+        stream << "-";
+      stream << std::setw(16) << r.objective << std::setw(12) << r.time
+          << std::setw(10) << r.passes << "\n";
+    }
+    stream << "\n";
+  }
+  stream.flush();
+}
+
+} // namespace benchmark
+} // namespace ens
+
+#endif
@@ -0,0 +1,854 @@
+/**
+ * @file benchmarks.cpp
+ *
+ * Performance benchmarks of the ensmallen optimizers.  Each optimizer is run on
+ * scalable problems at several sizes and thread counts, and the wall-clock
+ * time, the number of evaluations, the final objective and the peak memory are
+ * written as JSON, with the speedup, efficiency and time to a target objective
+ * of each run relative to the run with one thread.
+ *
+ * With --scaling, the parallel optimizers (ParallelSGD with each update
+ * policy, AsyncSGD, LocalSGD, EASGD, SCD with parallel updates, and CNE, DE
+ * and CMA-ES with parallel evaluation) are run instead on large generated
+ * problems, over thread counts that by default include the boundaries of the
+ * NUMA nodes.
+ *
+ * With --leaderboard, SGD, Adam, SVRG, SARAH, Katyusha, IQN, L-BFGS,
+ * BigBatchSGD and SPALeRASGD are run instead on logistic and softmax
+ * regression with the same budget of passes over the data, and ranked by the
+ * wall-clock time to reach an objective within the given relative accuracy
+ * (--target) of a tightly converged reference; the time and the number of
+ * passes to the target are printed as a table, and the JSON is only written
+ * with --output.
+ *
+ * With --trials, every run is repeated the given number of times (5 by default
+ * with --save-baseline or --compare, 1 otherwise).  --save-baseline writes the
+ * times of the trials of each run to a baseline file, and --compare compares
+ * them with a baseline saved earlier (for instance, by a previous version of
+ * ensmallen): the median time of each run and its 95% confidence interval are
+ * printed for both, and a run is reported as a regression if its median time
+ * grew by more than --threshold (5% by default) and a Mann-Whitney U test
+ * rejects equal times at level --alpha (0.05 by default).  The program then
+ * exits with status 2 if there is any regression.  The comparison is printed
+ * instead of the JSON, which is only written with --output.
+ *
+ * Usage:
+ *
+ *   ensmallen_benchmarks [--quick] [--scaling]
+ *       [--leaderboard [--passes 20] [--target 1e-3]] [--threads 1,2,4]
+ *       [--trials 5] [--save-baseline file]
+ *       [--compare file [--threshold 0.05] [--alpha 0.05]]
+ *       [--output file.json]
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "benchmark_tools.hpp"
+#include "baseline.hpp"
+
+using namespace ens;
+using namespace ens::test;
+using namespace ens::benchmark;
+
+/**
+ * Set the number of threads used by OpenMP (if available) and return the
+ * number of threads that will actually be used.
+ */
+size_t SetThreads(const size_t threads)
+{
+#ifdef ENS_USE_OPENMP
+  omp_set_num_threads(threads);
+  return threads;
+#else
+  (void) threads;
+  return 1;
+#endif
+}
+
+/**
+ * Run an optimizer that supports callbacks on the given function.
+ */
+template<typename OptimizerType, typename FunctionType>
+double RunOptimizer(OptimizerType& optimizer,
+                    FunctionType& function,
+                    arma::mat& coordinates,
+                    CountingCallback& callback)
+{
+  return optimizer.Optimize(function, coordinates, callback);
+}
+
+/**
+ * Run an optimizer that does not take callbacks one epoch at a time, so that
+ * the objective can be traced after each epoch; the evaluations of the
+ * objective are excluded from the time.  Its steps are not counted.
+ */
+template<typename OptimizerType, typename FunctionType>
+double RunEpochs(OptimizerType& optimizer,
+                 FunctionType& function,
+                 arma::mat& coordinates,
+                 CountingCallback& callback)
+{
+  const size_t epochs = optimizer.MaxIterations();
+  optimizer.MaxIterations() = 1;
+
+  double objective = 0.0;
+  for (size_t e = 0; e < epochs; ++e)
+  {
+    optimizer.Optimize(function, coordinates);
+
+    callback.trace->Pause();
+    objective = function.Wrapped().Evaluate(coordinates);
+    callback.trace->Record(objective, function.Passes());
+    ++callback.epochs;
+    callback.trace->Resume();
+  }
+
+  optimizer.MaxIterations() = epochs;
+  return objective;
+}
+
+/**
+ * ParallelSGD does not take callbacks, so it is run one epoch at a time.
+ */
+template<typename DecayPolicyType,
+         typename UpdatePolicyType,
+         typename FunctionType>
+double RunOptimizer(ParallelSGD<DecayPolicyType, UpdatePolicyType>& optimizer,
+                    FunctionType& function,
+                    arma::mat& coordinates,
+                    CountingCallback& callback)
+{
+  return RunEpochs(optimizer, function, coordinates, callback);
+}
+
+/**
+ * AsyncSGD does not take callbacks, so it is run one epoch at a time.
+ */
+template<typename DecayPolicyType, typename FunctionType>
+double RunOptimizer(AsyncSGD<DecayPolicyType>& optimizer,
+                    FunctionType& function,
+                    arma::mat& coordinates,
+                    CountingCallback& callback)
+{
+  return RunEpochs(optimizer, function, coordinates, callback);
+}
+
+/**
+ * SCD does not take callbacks; the objectives it computes every update
+ * interval are traced, and its steps and epochs are not counted.
+ */
+template<typename DescentPolicyType, typename FunctionType>
+double RunOptimizer(SCD<DescentPolicyType>& optimizer,
+                    FunctionType& function,
+                    arma::mat& coordinates,
+                    CountingCallback& /* callback */)
+{
+  return optimizer.Optimize(function, coordinates);
+}
+
+/**
+ * SARAH does not take callbacks; it is traced by the checks of the objective
+ * of the counting function (see Run()).
+ */
+template<typename UpdatePolicyType, typename FunctionType>
+double RunOptimizer(SARAHType<UpdatePolicyType>& optimizer,
+                    FunctionType& function,
+                    arma::mat& coordinates,
+                    CountingCallback& /* callback */)
+{
+  return optimizer.Optimize(function, coordinates);
+}
+
+/**
+ * Katyusha does not take callbacks; it is traced by the checks of the
+ * objective of the counting function (see Run()).
+ */
+template<bool Proximal, typename FunctionType>
+double RunOptimizer(KatyushaType<Proximal>& optimizer,
+                    FunctionType& function,
+                    arma::mat& coordinates,
+                    CountingCallback& /* callback */)
+{
+  return optimizer.Optimize(function, coordinates);
+}
+
+/**
+ * IQN does not take callbacks; it is traced by the checks of the objective of
+ * the counting function (see Run()).
+ */
+template<typename FunctionType>
+double RunOptimizer(IQN& optimizer,
+                    FunctionType& function,
+                    arma::mat& coordinates,
+                    CountingCallback& /* callback */)
+{
+  return optimizer.Optimize(function, coordinates);
+}
+
+/**
+ * BigBatchSGD does not take callbacks; it is traced by the checks of the
+ * objective of the counting function (see Run()).
+ */
+template<typename UpdatePolicyType, typename FunctionType>
+double RunOptimizer(BigBatchSGD<UpdatePolicyType>& optimizer,
+                    FunctionType& function,
+                    arma::mat& coordinates,
+                    CountingCallback& /* callback */)
+{
+  return optimizer.Optimize(function, coordinates);
+}
+
+/**
+ * SPALeRASGD does not take callbacks; it is traced by the checks of the
+ * objective of the counting function (see Run()).
+ */
+template<typename DecayPolicyType, typename FunctionType>
+double RunOptimizer(SPALeRASGD<DecayPolicyType>& optimizer,
+                    FunctionType& function,
+                    arma::mat& coordinates,
+                    CountingCallback& /* callback */)
+{
+  return optimizer.Optimize(function, coordinates);
+}
+
+/**
+ * Benchmark a single optimizer on a single problem and store the result.
+ *
+ * @param problem Name of the problem.
+ * @param size Size of the problem.
+ * @param name Name of the optimizer.
+ * @param threads Number of threads to use.
+ * @param optimizer Optimizer to benchmark.
+ * @param function Function to optimize.
+ * @param initialPoint Starting point of the optimization.
+ * @param results Vector to append the result to.
+ * @param checkInterval If nonzero, also trace the objective of the whole
+ *     function after every given number of passes over the data, for
+ *     optimizers that take no callbacks.
+ */
+template<typename GradType,
+         typename OptimizerType,
+         typename FunctionType>
+void Run(const std::string& problem,
+         const size_t size,
+         const std::string& name,
+         const size_t threads,
+         OptimizerType& optimizer,
+         FunctionType& function,
+         const arma::mat& initialPoint,
+         std::vector<Result>& results,
+         const double checkInterval = 0.0)
+{
+  CountingFunction<FunctionType, GradType> countingFunction(function);
+  ObjectiveTrace trace;
+  countingFunction.Trace(trace);
+  CountingCallback callback;
+  callback.trace = &trace;
+  arma::mat coordinates(initialPoint);
+
+  Result result;
+  result.problem = problem;
+  result.size = size;
+  result.optimizer = name;
+  result.threads = SetThreads(threads);
+  result.initialObjective = countingFunction.Wrapped().Evaluate(initialPoint);
+
+  ResetPeakMemory();
+  trace.Start();
+  countingFunction.CheckInterval(checkInterval);
+  result.objective = RunOptimizer(optimizer, countingFunction, coordinates,
+      callback);
+  trace.Record(result.objective, countingFunction.Passes());
+  result.time = trace.Elapsed();
+
+  result.trace = trace.Points();
+  result.tracePasses = trace.Passes();
+  result.passes = countingFunction.Passes();
+  result.peakMemory = PeakMemory();
+  result.steps = callback.steps;
+  result.epochs = callback.epochs;
+  result.evaluations = countingFunction.Evaluations();
+  result.gradients = countingFunction.Gradients();
+  results.push_back(result);
+
+  std::cerr << problem << " (" << size << "), " << name << ", "
+      << result.threads << " thread(s): " << result.time << "s, objective "
+      << result.objective << "." << std::endl;
+}
+
+/**
+ * Run the dense first-order optimizers and L-BFGS on the given separable
+ * function.  Every stochastic optimizer makes the given number of passes over
+ * the data; the tolerance is disabled so that the amount of work is fixed.
+ */
+template<typename FunctionType>
+void RunDense(const std::string& problem,
+              const size_t size,
+              const size_t threads,
+              const size_t epochs,
+              FunctionType& function,
+              const arma::mat& initialPoint,
+              std::vector<Result>& results)
+{
+  const size_t iterations = epochs * function.NumFunctions();
+
+  StandardSGD sgd(0.001, 32, iterations, -1.0, true);
+  Run<arma::mat>(problem, size, "SGD", threads, sgd, function, initialPoint,
+      results);
+
+  Adam adam(0.001, 32, 0.9, 0.999, 1e-8, iterations, -1.0, true);
+  Run<arma::mat>(problem, size, "Adam", threads, adam, function, initialPoint,
+      results);
+
+  RMSProp rmsprop(0.001, 32, 0.99, 1e-8, iterations, -1.0, true);
+  Run<arma::mat>(problem, size, "RMSProp", threads, rmsprop, function,
+      initialPoint, results);
+
+  L_BFGS lbfgs(10, 10 * epochs);
+  Run<arma::mat>(problem, size, "L_BFGS", threads, lbfgs, function,
+      initialPoint, results);
+}
+
+/**
+ * Run ParallelSGD with each update policy on the given function with sparse
+ * gradients.
+ */
+template<typename FunctionType>
+void RunSparse(const std::string& problem,
+               const size_t size,
+               const size_t threads,
+               const size_t epochs,
+               const double stepSize,
+               FunctionType& function,
+               const arma::mat& initialPoint,
+               std::vector<Result>& results)
+{
+  // Let each thread claim a few small shares per iteration.
+  const size_t threadShareSize = std::max<size_t>(1,
+      function.NumFunctions() / (16 * threads));
+  ParallelSGD<ConstantStep, AtomicUpdate> atomic(epochs, threadShareSize,
+      -1.0, true, ConstantStep(stepSize));
+  Run<arma::sp_mat>(problem, size, "ParallelSGD", threads, atomic, function,
+      initialPoint, results);
+
+  ParallelSGD<ConstantStep, HogwildUpdate> hogwild(epochs, threadShareSize,
+      -1.0, true, ConstantStep(stepSize));
+  Run<arma::sp_mat>(problem, size, "ParallelSGD<HogwildUpdate>", threads,
+      hogwild, function, initialPoint, results);
+
+  ParallelSGD<ConstantStep, DeltaBufferUpdate> buffered(epochs,
+      threadShareSize, -1.0, true, ConstantStep(stepSize));
+  Run<arma::sp_mat>(problem, size, "ParallelSGD<DeltaBufferUpdate>", threads,
+      buffered, function, initialPoint, results);
+}
+
+/**
+ * Run the parallel optimizers for separable functions with sparse gradients
+ * that do not need a fixed number of threads per run: ParallelSGD with each
+ * update policy, AsyncSGD, LocalSGD and EASGD.
+ */
+template<typename FunctionType>
+void RunParallelSGD(const std::string& problem,
+                    const size_t size,
+                    const size_t threads,
+                    const size_t epochs,
+                    const double stepSize,
+                    FunctionType& function,
+                    const arma::mat& initialPoint,
+                    std::vector<Result>& results)
+{
+  RunSparse(problem, size, threads, epochs, stepSize, function, initialPoint,
+      results);
+
+  AsyncSGD<> async(epochs, 1, 16 * threads, 16, -1.0, true,
+      ConstantStep(stepSize));
+  Run<arma::sp_mat>(problem, size, "AsyncSGD", threads, async, function,
+      initialPoint, results);
+
+  LocalSGD<> local(stepSize, 32, 16, 0, epochs * function.NumFunctions(),
+      -1.0, true);
+  Run<arma::mat>(problem, size, "LocalSGD", threads, local, function,
+      initialPoint, results);
+
+  EASGD<> easgd(stepSize, 32, 16, 0.9, 0, epochs * function.NumFunctions(),
+      -1.0, true);
+  Run<arma::mat>(problem, size, "EASGD", threads, easgd, function,
+      initialPoint, results);
+}
+
+/**
+ * Run the population-based optimizers with parallel evaluation of the
+ * population on the given function, for the given number of generations.
+ */
+template<typename FunctionType>
+void RunPopulation(const std::string& problem,
+                   const size_t size,
+                   const size_t threads,
+                   const size_t generations,
+                   FunctionType& function,
+                   const arma::mat& initialPoint,
+                   std::vector<Result>& results)
+{
+  CNE cne(64, generations, 0.1, 0.02, 0.2, -1.0, true);
+  Run<arma::mat>(problem, size, "CNE", threads, cne, function, initialPoint,
+      results);
+
+  DE de(64, generations, 0.6, 0.8, -1.0, true);
+  Run<arma::mat>(problem, size, "DE", threads, de, function, initialPoint,
+      results);
+
+  CMAES<> cmaes(64, -10, 10, function.NumFunctions(), generations, -1.0,
+      FullSelection(), true);
+  Run<arma::mat>(problem, size, "CMAES", threads, cmaes, function,
+      initialPoint, results);
+}
+
+/**
+ * Run the stochastic and quasi-Newton optimizers on the given separable
+ * function with the same budget of passes over the data, and set the time and
+ * number of passes each of them took to reach the target objective.  The
+ * target is the objective that closes all but the given fraction of the gap
+ * between the initial objective and a reference optimum, which is computed
+ * beforehand by a tightly converged L-BFGS run.  The optimizers that take no
+ * callbacks are traced by checks of the objective four times per pass.
+ */
+template<typename FunctionType>
+void RunLeaderboard(const std::string& problem,
+                    const size_t size,
+                    const size_t threads,
+                    const size_t passes,
+                    const double accuracy,
+                    FunctionType& function,
+                    const arma::mat& initialPoint,
+                    std::vector<Result>& results)
+{
+  SetThreads(threads);
+  L_BFGS reference(10, 0);
+  reference.MinGradientNorm() = 1e-12;
+  reference.Factr() = 0.0;
+  arma::mat optimum(initialPoint);
+  const double best = reference.Optimize(function, optimum);
+  const double initial = function.Evaluate(initialPoint);
+  const double target = best + accuracy * (initial - best);
+
+  const size_t n = function.NumFunctions();
+  const size_t outer = std::max<size_t>(1, passes / 2);
+  const double check = 0.25;
+
+  StandardSGD sgd(0.001, 32, passes * n, -1.0, true);
+  Run<arma::mat>(problem, size, "SGD", threads, sgd, function, initialPoint,
+      results, check);
+
+  Adam adam(0.001, 32, 0.9, 0.999, 1e-8, passes * n, -1.0, true);
+  Run<arma::mat>(problem, size, "Adam", threads, adam, function, initialPoint,
+      results, check);
+
+  // The variance-reduced optimizers make a full pass and about one pass of
+  // inner steps in each outer iteration.
+  SVRG svrg(0.005, 32, outer, 0, -1.0, true);
+  Run<arma::mat>(problem, size, "SVRG", threads, svrg, function, initialPoint,
+      results, check);
+
+  SARAH sarah(0.01, 32, outer, 0, -1.0, true);
+  Run<arma::mat>(problem, size, "SARAH", threads, sarah, function,
+      initialPoint, results, check);
+
+  Katyusha katyusha(1.0, 10.0, 32, outer, 0, -1.0, true);
+  Run<arma::mat>(problem, size, "Katyusha", threads, katyusha, function,
+      initialPoint, results, check);
+
+  // Each iteration of IQN is a pass, after the pass that initializes it.
+  IQN iqn(0.01, 32, passes + 1, -1.0);
+  Run<arma::mat>(problem, size, "IQN", threads, iqn, function, initialPoint,
+      results, check);
+
+  L_BFGS lbfgs(10, passes);
+  Run<arma::mat>(problem, size, "L_BFGS", threads, lbfgs, function,
+      initialPoint, results, check);
+
+  BBS_BB bigBatch(100, 0.01, 0.1, passes * n, -1.0, true);
+  Run<arma::mat>(problem, size, "BigBatchSGD", threads, bigBatch, function,
+      initialPoint, results, check);
+
+  SPALeRASGD<> spalera(0.05 / 32, 32, passes * n, -1.0);
+  Run<arma::mat>(problem, size, "SPALeRASGD", threads, spalera, function,
+      initialPoint, results, check);
+
+  ComputeTargets(results, problem, size, target);
+}
+
+/**
+ * Run the thread-scaling matrix: the parallel optimizers on large generated
+ * problems of each size, with each number of threads.
+ */
+void RunScaling(const std::vector<size_t>& threadCounts,
+                const bool quick,
+                std::vector<Result>& results)
+{
+  const size_t epochs = quick ? 2 : 10;
+  std::vector<size_t> sizes;
+  sizes.push_back(10000);
+  if (!quick)
+  {
+    sizes.push_back(100000);
+    sizes.push_back(1000000);
+  }
+
+  for (size_t s = 0; s < sizes.size(); ++s)
+  {
+    const size_t size = sizes[s];
+
+    // Sparse logistic regression with 20 nonzero features per point, out of
+    // size / 10 features.
+    arma::sp_mat predictors;
+    arma::Row<size_t> responses;
+    arma::rowvec parameters;
+    GenerateSparseLogisticRegression(size, size / 10, 200.0 / size, 10.0,
+        predictors, responses, parameters);
+    LogisticRegressionFunction<arma::sp_mat> lr(predictors, responses,
+        0.0001);
+
+    // Rank-10 factorization of a square matrix with size observed entries;
+    // 10% of the entries are observed.
+    const size_t dimension = size_t(std::sqrt(10.0 * size));
+    arma::umat locations;
+    arma::vec values;
+    GenerateMatrixFactorization(dimension, dimension, 10, 0.1, 10.0, 0.01,
+        locations, values);
+    MatrixFactorizationFunction mf(locations, values, dimension, dimension, 10,
+        0.001);
+
+    // Dense logistic regression in 10 dimensions, for the population-based
+    // optimizers, whose every evaluation is a pass over the data.
+    const arma::mat densePredictors = arma::randn<arma::mat>(10, size / 10);
+    const arma::rowvec plane = arma::randn<arma::rowvec>(10);
+    const arma::Row<size_t> denseResponses =
+        arma::conv_to<arma::Row<size_t>>::from(plane * densePredictors > 0);
+    LogisticRegressionFunction<> denseLr(densePredictors, denseResponses,
+        0.0001);
+
+    for (size_t t = 0; t < threadCounts.size(); ++t)
+    {
+      const size_t threads = threadCounts[t];
+
+      RunParallelSGD("SparseLogisticRegression", size, threads, epochs, 0.01,
+          lr, lr.InitialPoint(), results);
+      RunParallelSGD("MatrixFactorizationFunction", size, threads, epochs,
+          0.01, mf, mf.GetInitialPoint(), results);
+
+      // Each round of SCD updates as many coordinates as there are threads.
+      SCD<RandomDescent> scd(0.1, epochs * lr.NumFeatures(), -1.0,
+          lr.NumFeatures(), RandomDescent(), threads);
+      Run<arma::sp_mat>("SparseLogisticRegression", size, "SCD", threads, scd,
+          lr, lr.InitialPoint(), results);
+
+      RunPopulation("LogisticRegressionFunction", size / 10, threads,
+          quick ? 10 : 50, denseLr, denseLr.GetInitialPoint(), results);
+    }
+  }
+}
+
+/**
+ * Run the leaderboards: all the optimizers of RunLeaderboard() on logistic and
+ * softmax regression problems of each size, with the given number of threads.
+ * The budget is the given number of passes over the data (or a default if it
+ * is 0).
+ */
+void RunLeaderboards(const size_t threads,
+                     const bool quick,
+                     const size_t passes,
+                     const double accuracy,
+                     std::vector<Result>& results)
+{
+  const size_t budget = (passes > 0) ? passes : (quick ? 5 : 20);
+  std::vector<size_t> sizes;
+  sizes.push_back(1000);
+  if (!quick)
+    sizes.push_back(10000);
+
+  for (size_t s = 0; s < sizes.size(); ++s)
+  {
+    const size_t size = sizes[s];
+
+    // The same problems as the dense benchmarks: logistic regression with
+    // labels given by a random separating hyperplane, and softmax regression
+    // with five random classes.
+    const arma::mat predictors = arma::randn<arma::mat>(10, size);
+    const arma::rowvec plane = arma::randn<arma::rowvec>(10);
+    const arma::Row<size_t> responses =
+        arma::conv_to<arma::Row<size_t>>::from(plane * predictors > 0);
+    LogisticRegressionFunction<> lr(predictors, responses, 0.0001);
+    RunLeaderboard("LogisticRegressionFunction", size, threads, budget,
+        accuracy, lr, lr.GetInitialPoint(), results);
+
+    const arma::Row<size_t> labels = arma::randi<arma::Row<size_t>>(size,
+        arma::distr_param(0, 4));
+    SoftmaxRegressionFunction sr(predictors, labels, 5);
+    RunLeaderboard("SoftmaxRegressionFunction", size, threads, budget,
+        accuracy, sr, sr.GetInitialPoint(), results);
+  }
+}
+
+/**
+ * Run the standard matrix: the dense optimizers and ParallelSGD on the test
+ * problems of each size, with each number of threads.
+ */
+void RunStandard(const std::vector<size_t>& threadCounts,
+                 const bool quick,
+                 std::vector<Result>& results)
+{
+  const size_t epochs = quick ? 2 : 10;
+  std::vector<size_t> sizes;
+  sizes.push_back(100);
+  if (!quick)
+  {
+    sizes.push_back(1000);
+    sizes.push_back(10000);
+  }
+
+  for (size_t t = 0; t < threadCounts.size(); ++t)
+  {
+    const size_t threads = threadCounts[t];
+    for (size_t s = 0; s < sizes.size(); ++s)
+    {
+      const size_t size = sizes[s];
+
+      // The generalized Rosenbrock function in the given number of dimensions.
+      GeneralizedRosenbrockFunction rosenbrock(size);
+      RunDense("GeneralizedRosenbrockFunction", size, threads, epochs,
+          rosenbrock, rosenbrock.GetInitialPoint(), results);
+      RunSparse("GeneralizedRosenbrockFunction", size, threads, 100 * epochs,
+          0.0001, rosenbrock, rosenbrock.GetInitialPoint(), results);
+
+      // Logistic regression on the given number of points in 10 dimensions,
+      // with labels given by a random separating hyperplane.
+      const arma::mat predictors = arma::randn<arma::mat>(10, size);
+      const arma::rowvec plane = arma::randn<arma::rowvec>(10);
+      const arma::Row<size_t> responses =
+          arma::conv_to<arma::Row<size_t>>::from(plane * predictors > 0);
+      LogisticRegressionFunction<> lr(predictors, responses, 0.0001);
+      RunDense("LogisticRegressionFunction", size, threads, epochs, lr,
+          lr.GetInitialPoint(), results);
+
+      // Softmax regression on the same points with five random classes.
+      const arma::Row<size_t> labels = arma::randi<arma::Row<size_t>>(size,
+          arma::distr_param(0, 4));
+      SoftmaxRegressionFunction sr(predictors, labels, 5);
+      RunDense("SoftmaxRegressionFunction", size, threads, epochs, sr,
+          sr.GetInitialPoint(), results);
+    }
+
+    // The sparse test function has a fixed size.
+    SparseTestFunction sparse;
+    RunSparse("SparseTestFunction", sparse.NumFunctions(), threads,
+        1000 * epochs, 0.4, sparse, sparse.GetInitialPoint(), results);
+  }
+
+}
+
+/**
+ * Parse a comma-separated list of numbers.
+ */
+std::vector<size_t> ParseList(const std::string& list)
+{
+  std::vector<size_t> values;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ','))
+  {
+    const size_t value = std::strtoul(item.c_str(), NULL, 10);
+    if (value > 0)
+      values.push_back(value);
+  }
+  return values;
+}
+
+int main(int argc, char** argv)
+{
+  bool quick = false;
+  bool scaling = false;
+  bool leaderboard = false;
+  size_t passes = 0;
+  double accuracy = 1e-3;
+  size_t trials = 0;
+  std::string saveBaseline;
+  std::string compare;
+  double threshold = 0.05;
+  double alpha = 0.05;
+  std::string output;
+  std::vector<size_t> threadCounts;
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg(argv[i]);
+    if (arg == "--quick")
+    {
+      quick = true;
+    }
+    else if (arg == "--scaling")
+    {
+      scaling = true;
+    }
+    else if (arg == "--leaderboard")
+    {
+      leaderboard = true;
+    }
+    else if (arg == "--passes" && i + 1 < argc)
+    {
+      passes = std::strtoul(argv[++i], NULL, 10);
+    }
+    else if (arg == "--target" && i + 1 < argc)
+    {
+      accuracy = std::strtod(argv[++i], NULL);
+    }
+    else if (arg == "--trials" && i + 1 < argc)
+    {
+      trials = std::strtoul(argv[++i], NULL, 10);
+    }
+    else if (arg == "--save-baseline" && i + 1 < argc)
+    {
+      saveBaseline = argv[++i];
+    }
+    else if (arg == "--compare" && i + 1 < argc)
+    {
+      compare = argv[++i];
+    }
+    else if (arg == "--threshold" && i + 1 < argc)
+    {
+      threshold = std::strtod(argv[++i], NULL);
+    }
+    else if (arg == "--alpha" && i + 1 < argc)
+    {
+      alpha = std::strtod(argv[++i], NULL);
+    }
+    else if (arg == "--output" && i + 1 < argc)
+    {
+      output = argv[++i];
+    }
+    else if (arg == "--threads" && i + 1 < argc)
+    {
+      threadCounts = ParseList(argv[++i]);
+    }
+    else
+    {
+      std::cerr << "usage: " << argv[0] << " [--quick] [--scaling] "
+          << "[--leaderboard [--passes 20] [--target 1e-3]] "
+          << "[--threads 1,2,4] [--trials 5] [--save-baseline file] "
+          << "[--compare file [--threshold 0.05] [--alpha 0.05]] "
+          << "[--output file.json]" << std::endl;
+      return 1;
+    }
+  }
+
+  // By default, use one thread, the maximum number of threads, and the powers
+  // of two in between.  The scaling matrix also uses the multiples of the
+  // number of threads per NUMA node, where the memory traffic starts to cross
+  // nodes.
+  if (threadCounts.empty())
+  {
+    size_t maxThreads = 1;
+    #ifdef ENS_USE_OPENMP
+      maxThreads = omp_get_max_threads();
+    #endif
+    for (size_t t = 1; t < maxThreads; t *= 2)
+      threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    const size_t threadsPerNode = maxThreads / NumaNodes();
+    for (size_t t = threadsPerNode; scaling && t > 0 && t < maxThreads;
+        t += threadsPerNode)
+      threadCounts.push_back(t);
+    std::sort(threadCounts.begin(), threadCounts.end());
+    threadCounts.erase(std::unique(threadCounts.begin(), threadCounts.end()),
+        threadCounts.end());
+  }
+
+  // A baseline or a comparison needs repeated trials for the statistics.
+  if (trials == 0)
+    trials = (saveBaseline.empty() && compare.empty()) ? 1 : 5;
+
+  // Each trial runs the same problems from the same seed.
+  std::vector<Result> results;
+  for (size_t trial = 0; trial < trials; ++trial)
+  {
+    arma::arma_rng::set_seed(42);
+    if (leaderboard)
+      RunLeaderboards(threadCounts[0], quick, passes, accuracy, results);
+    else if (scaling)
+      RunScaling(threadCounts, quick, results);
+    else
+      RunStandard(threadCounts, quick, results);
+  }
+
+  std::vector<Sample> samples;
+  CollectSamples(results, samples);
+  if (!saveBaseline.empty())
+  {
+    std::ofstream stream(saveBaseline.c_str());
+    if (!stream.is_open())
+    {
+      std::cerr << "Cannot open '" << saveBaseline << "' for writing."
+          << std::endl;
+      return 1;
+    }
+    WriteBaseline(stream, samples);
+  }
+
+  // The leaderboard and the comparison are written instead of the JSON,
+  // unless an output file is given.
+  size_t regressions = 0;
+  if (!compare.empty())
+  {
+    std::ifstream stream(compare.c_str());
+    if (!stream.is_open())
+    {
+      std::cerr << "Cannot open '" << compare << "' for reading." << std::endl;
+      return 1;
+    }
+    std::vector<Sample> baseline;
+    try
+    {
+      ReadBaseline(stream, baseline);
+    }
+    catch (const std::runtime_error& e)
+    {
+      std::cerr << "Cannot read '" << compare << "': " << e.what()
+          << std::endl;
+      return 1;
+    }
+
+    std::vector<Comparison> comparisons;
+    regressions = Compare(baseline, samples, threshold, alpha, 0.95,
+        comparisons);
+    WriteComparison(std::cout, comparisons);
+    std::cerr << regressions << " regression(s) of more than "
+        << (100.0 * threshold) << "% at significance level " << alpha << "."
+        << std::endl;
+  }
+  if (leaderboard)
+    WriteLeaderboard(std::cout, results);
+  if ((leaderboard || !compare.empty()) && output.empty())
+    return (regressions > 0) ? 2 : 0;
+
+  if (!leaderboard)
+    ComputeScaling(results);
+  if (output.empty())
+  {
+    WriteJSON(std::cout, results);
+  }
+  else
+  {
+    std::ofstream stream(output.c_str());
+    if (!stream.is_open())
+    {
+      std::cerr << "Cannot open '" << output << "' for writing." << std::endl;
+      return 1;
+    }
+    WriteJSON(stream, results);
+  }
+
+  return (regressions > 0) ? 2 : 0;
+}
@@ -0,0 +1,307 @@
+/**
+ * @file update_benchmarks.cpp
+ *
+ * Microbenchmarks of the update and decay policies.  Each policy's Update() is
+ * timed in isolation on iterates of 10^3 to 10^9 elements, and its throughput
+ * is reported in GB/s relative to the bandwidth of memcpy() at the same size.
+ * The throughput counts the minimum traffic of any update, reading the
+ * iterate and the gradient and writing the iterate (24 bytes per element), so
+ * a policy that also streams its own state (such as the two moments of Adam)
+ * shows up as a lower fraction of the memcpy() bandwidth.
+ *
+ * Usage:
+ *
+ *   ensmallen_update_benchmarks [--max-elements 100000000] [--min-time 0.2]
+ *       [--output file.json]
+ *
+ * Sizes whose matrices cannot be allocated are skipped.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "benchmark_tools.hpp"
+
+#include <cstring>
+
+using namespace ens;
+using namespace ens::benchmark;
+
+/**
+ * The result of timing a single policy at a single size.
+ */
+struct UpdateResult
+{
+  //! Name of the policy.
+  std::string policy;
+  //! Number of elements of the iterate.
+  size_t elements;
+  //! Time of one call to Update() in seconds.
+  double time;
+  //! Throughput in GB/s, counting 24 bytes per element.
+  double bandwidth;
+  //! Bandwidth of memcpy() at the same size in GB/s.
+  double memcpyBandwidth;
+};
+
+/**
+ * Call the given function repeatedly for at least the given time (and at least
+ * once), and return the mean time of a call.
+ */
+template<typename CallType>
+double TimeCalls(CallType&& call, const double minTime)
+{
+  arma::wall_clock timer;
+  size_t calls = 0;
+  timer.tic();
+  do
+  {
+    call();
+    ++calls;
+  } while (timer.toc() < minTime);
+
+  return timer.toc() / calls;
+}
+
+/**
+ * Return the copy bandwidth of memcpy() on arrays of n doubles in GB/s,
+ * counting the bytes read and written.
+ */
+double MemcpyBandwidth(const size_t n, const double minTime)
+{
+  arma::vec source(n, arma::fill::randu), destination(n, arma::fill::zeros);
+  const double time = TimeCalls([&]()
+  {
+    std::memcpy(destination.memptr(), source.memptr(), n * sizeof(double));
+  }, minTime);
+
+  return 2.0 * n * sizeof(double) / time / 1e9;
+}
+
+/**
+ * Time the Update() of the given update policy on an iterate of n elements.
+ */
+template<typename UpdatePolicyType>
+void TimeUpdatePolicy(const std::string& name,
+                      const UpdatePolicyType& updatePolicy,
+                      const size_t n,
+                      const double minTime,
+                      const double memcpyBandwidth,
+                      std::vector<UpdateResult>& results)
+{
+  arma::mat iterate(n, 1, arma::fill::randu);
+  arma::mat gradient(n, 1, arma::fill::randu);
+  gradient -= 0.5;
+
+  typename UpdatePolicyType::template Policy<arma::mat, arma::mat> policy(
+      updatePolicy, n, 1);
+
+  // The first update touches the state of the policy for the first time.
+  policy.Update(iterate, 1e-8, gradient);
+
+  UpdateResult result;
+  result.policy = name;
+  result.elements = n;
+  result.time = TimeCalls([&]() { policy.Update(iterate, 1e-8, gradient); },
+      minTime);
+  result.bandwidth = 3.0 * n * sizeof(double) / result.time / 1e9;
+  result.memcpyBandwidth = memcpyBandwidth;
+  results.push_back(result);
+
+  std::cerr << name << " (" << n << "): " << result.bandwidth << " GB/s ("
+      << result.bandwidth / memcpyBandwidth << " of memcpy)." << std::endl;
+}
+
+/**
+ * Time the Update() of the given decay policy on an iterate of n elements.
+ */
+template<typename DecayPolicyType>
+void TimeDecayPolicy(const std::string& name,
+                     DecayPolicyType decayPolicy,
+                     const size_t n,
+                     const double minTime,
+                     const double memcpyBandwidth,
+                     std::vector<UpdateResult>& results)
+{
+  arma::mat iterate(n, 1, arma::fill::randu);
+  arma::mat gradient(n, 1, arma::fill::randu);
+  double stepSize = 0.01;
+
+  UpdateResult result;
+  result.policy = name;
+  result.elements = n;
+  result.time = TimeCalls([&]()
+  {
+    decayPolicy.Update(iterate, stepSize, gradient);
+  }, minTime);
+  result.bandwidth = 3.0 * n * sizeof(double) / result.time / 1e9;
+  result.memcpyBandwidth = memcpyBandwidth;
+  results.push_back(result);
+
+  std::cerr << name << " (" << n << "): " << result.time << "s per update."
+      << std::endl;
+}
+
+/**
+ * Time every update and decay policy on an iterate of n elements.
+ */
+void TimeAll(const size_t n,
+             const double minTime,
+             std::vector<UpdateResult>& results)
+{
+  const double memcpyBandwidth = MemcpyBandwidth(n, minTime);
+  VanillaUpdate clippedUpdate;
+
+  TimeUpdatePolicy("VanillaUpdate", VanillaUpdate(), n, minTime,
+      memcpyBandwidth, results);
+  TimeUpdatePolicy("MomentumUpdate", MomentumUpdate(), n, minTime,
+      memcpyBandwidth, results);
+  TimeUpdatePolicy("NesterovMomentumUpdate", NesterovMomentumUpdate(), n,
+      minTime, memcpyBandwidth, results);
+  TimeUpdatePolicy("DecoupledWeightDecayMomentumUpdate",
+      DecoupledWeightDecayMomentumUpdate(), n, minTime, memcpyBandwidth,
+      results);
+  TimeUpdatePolicy("GradientClipping<VanillaUpdate>",
+      GradientClipping<VanillaUpdate>(-1.0, 1.0, clippedUpdate), n, minTime,
+      memcpyBandwidth, results);
+  TimeUpdatePolicy("LARSUpdate", LARSUpdate(), n, minTime, memcpyBandwidth,
+      results);
+
+  TimeUpdatePolicy("AdamUpdate", AdamUpdate(), n, minTime, memcpyBandwidth,
+      results);
+  TimeUpdatePolicy("AdaMaxUpdate", AdaMaxUpdate(), n, minTime,
+      memcpyBandwidth, results);
+  TimeUpdatePolicy("AMSGradUpdate", AMSGradUpdate(), n, minTime,
+      memcpyBandwidth, results);
+  TimeUpdatePolicy("NadamUpdate", NadamUpdate(), n, minTime, memcpyBandwidth,
+      results);
+  TimeUpdatePolicy("NadaMaxUpdate", NadaMaxUpdate(), n, minTime,
+      memcpyBandwidth, results);
+  TimeUpdatePolicy("OptimisticAdamUpdate", OptimisticAdamUpdate(), n, minTime,
+      memcpyBandwidth, results);
+  TimeUpdatePolicy("LazyAdamUpdate", LazyAdamUpdate(), n, minTime,
+      memcpyBandwidth, results);
+  TimeUpdatePolicy("LAMBUpdate", LAMBUpdate(), n, minTime, memcpyBandwidth,
+      results);
+  TimeUpdatePolicy("ReducedPrecisionAdamUpdate", ReducedPrecisionAdamUpdate<>(),
+      n, minTime, memcpyBandwidth, results);
+  TimeUpdatePolicy("AdamWUpdate", AdamWUpdate(), n, minTime, memcpyBandwidth,
+      results);
+
+  TimeUpdatePolicy("RMSPropUpdate", RMSPropUpdate(), n, minTime,
+      memcpyBandwidth, results);
+  TimeUpdatePolicy("ReducedPrecisionRMSPropUpdate",
+      ReducedPrecisionRMSPropUpdate<>(), n, minTime, memcpyBandwidth, results);
+  TimeUpdatePolicy("AdaDeltaUpdate", AdaDeltaUpdate(), n, minTime,
+      memcpyBandwidth, results);
+  TimeUpdatePolicy("AdaGradUpdate", AdaGradUpdate(), n, minTime,
+      memcpyBandwidth, results);
+  TimeUpdatePolicy("SMORMS3Update", SMORMS3Update(), n, minTime,
+      memcpyBandwidth, results);
+  TimeUpdatePolicy("FTMLUpdate", FTMLUpdate(), n, minTime, memcpyBandwidth,
+      results);
+  TimeUpdatePolicy("WNGradUpdate", WNGradUpdate(), n, minTime,
+      memcpyBandwidth, results);
+  TimeUpdatePolicy("PadamUpdate", PadamUpdate(), n, minTime, memcpyBandwidth,
+      results);
+  TimeUpdatePolicy("SWATSUpdate", SWATSUpdate(), n, minTime, memcpyBandwidth,
+      results);
+
+  TimeDecayPolicy("NoDecay", NoDecay(), n, minTime, memcpyBandwidth, results);
+  TimeDecayPolicy("CyclicalDecay", CyclicalDecay(), n, minTime,
+      memcpyBandwidth, results);
+}
+
+/**
+ * Write the given results as a JSON document.
+ */
+void WriteUpdateJSON(std::ostream& stream,
+                     const std::vector<UpdateResult>& results)
+{
+  stream.precision(10);
+  stream << "{\n  \"ensmallen_version\": \"" << version::as_string()
+      << "\",\n  \"updates\": [";
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    const UpdateResult& r = results[i];
+    stream << (i == 0 ? "\n" : ",\n") << "    { "
+        << "\"policy\": \"" << r.policy << "\", "
+        << "\"elements\": " << r.elements << ", "
+        << "\"time\": ";
+    WriteNumber(stream, r.time);
+    stream << ", \"ns_per_element\": ";
+    WriteNumber(stream, 1e9 * r.time / r.elements);
+    stream << ", \"gb_per_s\": ";
+    WriteNumber(stream, r.bandwidth);
+    stream << ", \"memcpy_gb_per_s\": ";
+    WriteNumber(stream, r.memcpyBandwidth);
+    stream << ", \"relative_bandwidth\": ";
+    WriteNumber(stream, r.bandwidth / r.memcpyBandwidth);
+    stream << " }";
+  }
+  stream << "\n  ]\n}" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  size_t maxElements = 100000000;
+  double minTime = 0.2;
+  std::string output;
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg(argv[i]);
+    if (arg == "--max-elements" && i + 1 < argc)
+    {
+      maxElements = std::strtoul(argv[++i], NULL, 10);
+    }
+    else if (arg == "--min-time" && i + 1 < argc)
+    {
+      minTime = std::strtod(argv[++i], NULL);
+    }
+    else if (arg == "--output" && i + 1 < argc)
+    {
+      output = argv[++i];
+    }
+    else
+    {
+      std::cerr << "usage: " << argv[0] << " [--max-elements 100000000] "
+          << "[--min-time 0.2] [--output file.json]" << std::endl;
+      return 1;
+    }
+  }
+
+  arma::arma_rng::set_seed(42);
+  std::vector<UpdateResult> results;
+  for (size_t n = 1000; n <= std::min(maxElements, size_t(1000000000));
+      n *= 10)
+  {
+    try
+    {
+      TimeAll(n, minTime, results);
+    }
+    catch (const std::exception& e)
+    {
+      std::cerr << "Skipping " << n << " elements: " << e.what() << std::endl;
+    }
+  }
+
+  if (output.empty())
+  {
+    WriteUpdateJSON(std::cout, results);
+  }
+  else
+  {
+    std::ofstream stream(output.c_str());
+    if (!stream.is_open())
+    {
+      std::cerr << "Cannot open '" << output << "' for writing." << std::endl;
+      return 1;
+    }
+    WriteUpdateJSON(stream, results);
+  }
+
+  return 0;
+}
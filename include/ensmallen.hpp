@@ -21,8 +21,15 @@
   #define ARMA_USE_CXX11
 #endif
 
+// The allocation count may hook into Armadillo, so it comes first.
+#include "ensmallen_bits/utility/allocation_count.hpp"
+
 #include <armadillo>
 
+#if defined(ENS_USE_COOT)
+  #include <bandicoot>
+#endif
+
 #if !defined(ARMA_USE_CXX11)
   // armadillo automatically enables ARMA_USE_CXX11
   // when a C++11/C++14/C++17/etc compiler is detected
@@ -41,6 +48,8 @@
 #include <climits>
 #include <cfloat>
 #include <cstdint>
+#include <atomic>
+#include <random>
 #include <stdexcept>
 #include <tuple>
 #include <utility>
@@ -58,6 +67,35 @@
 #include "ensmallen_bits/config.hpp"
 #include "ensmallen_bits/ens_version.hpp"
 #include "ensmallen_bits/log.hpp" // TODO: should move to another place
+#include "ensmallen_bits/utility/alias_table.hpp"
+#include "ensmallen_bits/utility/any.hpp"
+#include "ensmallen_bits/utility/arma_traits.hpp"
+#include "ensmallen_bits/utility/deterministic_reduction.hpp"
+#include "ensmallen_bits/utility/executor.hpp"
+#include "ensmallen_bits/utility/mapped_matrix.hpp"
+#include "ensmallen_bits/utility/numa.hpp"
+#include "ensmallen_bits/utility/parallel_kernels.hpp"
+#include "ensmallen_bits/utility/partial_sort_index.hpp"
+#include "ensmallen_bits/utility/profile.hpp"
+#include "ensmallen_bits/utility/reduced_precision_state.hpp"
+#include "ensmallen_bits/utility/rng.hpp"
+#include "ensmallen_bits/utility/serialization.hpp"
+#include "ensmallen_bits/utility/thread_budget.hpp"
+#include "ensmallen_bits/utility/trust_ratio.hpp"
+#include "ensmallen_bits/utility/workspace.hpp"
+
+#include "ensmallen_bits/callbacks/callbacks.hpp"
+#include "ensmallen_bits/callbacks/allocation_tracker.hpp"
+#include "ensmallen_bits/callbacks/async_checkpoint.hpp"
+#include "ensmallen_bits/callbacks/budget.hpp"
+#include "ensmallen_bits/callbacks/cancellation_token.hpp"
+#include "ensmallen_bits/callbacks/early_stop_at_min_loss.hpp"
+#include "ensmallen_bits/callbacks/print_loss.hpp"
+#include "ensmallen_bits/callbacks/record_result.hpp"
+#include "ensmallen_bits/callbacks/store_best_coordinates.hpp"
+#include "ensmallen_bits/callbacks/telemetry.hpp"
+#include "ensmallen_bits/callbacks/throughput_tuner.hpp"
+#include "ensmallen_bits/callbacks/timer_stop.hpp"
 
 #include "ensmallen_bits/problems/problems.hpp" // TODO: should move to another place
 
@@ -68,44 +106,75 @@
 #include "ensmallen_bits/adamw/adamw.hpp"
 #include "ensmallen_bits/adamwr/adamwr.hpp"
 
+#include "ensmallen_bits/async_sgd/async_sgd.hpp"
 #include "ensmallen_bits/aug_lagrangian/aug_lagrangian.hpp"
+#include "ensmallen_bits/batched/batched_gradient_descent.hpp"
+#include "ensmallen_bits/batched/batched_lbfgs.hpp"
+#include "ensmallen_bits/bayesian_optimization/bayesian_optimization.hpp"
 #include "ensmallen_bits/bigbatch_sgd/bigbatch_sgd.hpp"
+#include "ensmallen_bits/cmaes/bipop_cmaes.hpp"
 #include "ensmallen_bits/cmaes/cmaes.hpp"
+#include "ensmallen_bits/cmaes/ipop_cmaes.hpp"
 #include "ensmallen_bits/cne/cne.hpp"
+#include "ensmallen_bits/consensus_admm/consensus_admm.hpp"
 #include "ensmallen_bits/de/de.hpp"
+#include "ensmallen_bits/distributed_sgd/distributed_sgd.hpp"
+#include "ensmallen_bits/easgd/easgd.hpp"
 #include "ensmallen_bits/eve/eve.hpp"
 #include "ensmallen_bits/ftml/ftml.hpp"
 
 #include "ensmallen_bits/function.hpp" // TODO: should move to function/
 
 #include "ensmallen_bits/fw/frank_wolfe.hpp"
+#include "ensmallen_bits/fw/stochastic_frank_wolfe.hpp"
 #include "ensmallen_bits/gradient_descent/gradient_descent.hpp"
 #include "ensmallen_bits/grid_search/grid_search.hpp"
+#include "ensmallen_bits/grid_search/hyperband.hpp"
 #include "ensmallen_bits/iqn/iqn.hpp"
 #include "ensmallen_bits/katyusha/katyusha.hpp"
 #include "ensmallen_bits/lbfgs/lbfgs.hpp"
+#include "ensmallen_bits/lbfgs/lbfgs_b.hpp"
+#include "ensmallen_bits/local_sgd/local_sgd.hpp"
+#include "ensmallen_bits/multi_start/multi_start.hpp"
+#include "ensmallen_bits/newton_cg/newton_cg.hpp"
+#include "ensmallen_bits/olbfgs/olbfgs.hpp"
 #include "ensmallen_bits/padam/padam.hpp"
 #include "ensmallen_bits/parallel_sgd/parallel_sgd.hpp"
+#include "ensmallen_bits/proximal_gradient/proximal_gradient.hpp"
+#include "ensmallen_bits/proximal_gradient/stochastic_proximal_gradient.hpp"
 #include "ensmallen_bits/rmsprop/rmsprop.hpp"
 
+#include "ensmallen_bits/sa/parallel_tempering.hpp"
 #include "ensmallen_bits/sa/sa.hpp"
+#include "ensmallen_bits/saga/saga.hpp"
 #include "ensmallen_bits/sarah/sarah.hpp"
 #include "ensmallen_bits/scd/scd.hpp"
 #include "ensmallen_bits/sdp/sdp.hpp"
+#include "ensmallen_bits/sdp/sdpa_reader.hpp"
 #include "ensmallen_bits/sdp/lrsdp.hpp"
 #include "ensmallen_bits/sdp/primal_dual.hpp"
+#include "ensmallen_bits/sdp/chordal_primal_dual.hpp"
 
 #include "ensmallen_bits/sgd/sgd.hpp"
+#include "ensmallen_bits/sgd/multi_sgd.hpp"
 // TODO: this should probably be included in sgd.hpp
 #include "ensmallen_bits/sgd/update_policies/gradient_clipping.hpp"
 #include "ensmallen_bits/sgdr/sgdr.hpp"
 #include "ensmallen_bits/sgdr/snapshot_ensembles.hpp"
 #include "ensmallen_bits/sgdr/snapshot_sgdr.hpp"
+#include "ensmallen_bits/sharded_sgd/sharded_sgd.hpp"
 #include "ensmallen_bits/smorms3/smorms3.hpp"
 #include "ensmallen_bits/spalera_sgd/spalera_sgd.hpp"
 #include "ensmallen_bits/spsa/spsa.hpp"
+#include "ensmallen_bits/streaming_sgd/streaming_sgd.hpp"
+#include "ensmallen_bits/svrg/async_svrg.hpp"
 #include "ensmallen_bits/svrg/svrg.hpp"
 #include "ensmallen_bits/swats/swats.hpp"
 #include "ensmallen_bits/wn_grad/wn_grad.hpp"
 
+// The optimizers compiled into the optional ensmallen library.
+#if defined(ENS_USE_EXTERN_TEMPLATES) || defined(ENS_INSTANTIATE_TEMPLATES)
+  #include "ensmallen_bits/extern_templates.hpp"
+#endif
+
 #endif
@@ -83,14 +83,25 @@ class AdaDelta
    * API consistency at compile time.
    *
    * @tparam DecomposableFunctionType Type of the function to optimize.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to optimize.
    * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
    * @return Objective value of the final point.
    */
-  template<typename DecomposableFunctionType>
-  double Optimize(DecomposableFunctionType& function, arma::mat& iterate)
+  template<typename DecomposableFunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(DecomposableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks)
   {
-    return optimizer.Optimize(function, iterate);
+    return optimizer.template Optimize<DecomposableFunctionType, MatType,
+        GradType, CallbackTypes...>(function, iterate,
+        std::forward<CallbackTypes>(callbacks)...);
   }
 
   //! Get the step size.
@@ -135,6 +146,21 @@ class AdaDelta
   //! are reset before Optimize call.
   bool& ResetPolicy() { return optimizer.ResetPolicy(); }
 
+  /**
+   * Estimate the number of bytes Optimize() allocates for an iterate of the
+   * given size (see SGD::EstimateMemory()).
+   *
+   * @param rows Number of rows of the iterate.
+   * @param cols Number of columns of the iterate.
+   * @param elemSize Size of an element of the iterate.
+   */
+  size_t EstimateMemory(const size_t rows,
+                        const size_t cols = 1,
+                        const size_t elemSize = sizeof(double)) const
+  {
+    return optimizer.EstimateMemory(rows, cols, elemSize);
+  }
+
  private:
   //! The Stochastic Gradient Descent object with AdaDelta policy.
   SGD<AdaDeltaUpdate> optimizer;
@@ -51,49 +51,6 @@ class AdaDeltaUpdate
     // Nothing to do.
   }
 
-  /**
-   * The Initialize method is called by SGD Optimizer method before the start of
-   * the iteration update process. In AdaDelta update policy, the mean squared
-   * and the delta mean squared gradient matrices are initialized to the zeros
-   * matrix with the same size as gradient matrix (see ens::SGD<>).
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
-   */
-  void Initialize(const size_t rows, const size_t cols)
-  {
-    // Initialize empty matrices for mean sum of squares of parameter gradient.
-    meanSquaredGradient = arma::zeros<arma::mat>(rows, cols);
-    meanSquaredGradientDx = arma::zeros<arma::mat>(rows, cols);
-  }
-
-  /**
-   * Update step for SGD. The AdaDelta update dynamically adapts over time using
-   * only first order information. Additionally, AdaDelta requires no manual
-   * tuning of a learning rate.
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
-   */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
-  {
-    // Accumulate gradient.
-    meanSquaredGradient *= rho;
-    meanSquaredGradient += (1 - rho) * (gradient % gradient);
-    arma::mat dx = arma::sqrt((meanSquaredGradientDx + epsilon) /
-        (meanSquaredGradient + epsilon)) % gradient;
-
-    // Accumulate updates.
-    meanSquaredGradientDx *= rho;
-    meanSquaredGradientDx += (1 - rho) * (dx % dx);
-
-    // Apply update.
-    iterate -= (stepSize * dx);
-  }
-
   //! Get the smoothing parameter.
   double Rho() const { return rho; }
   //! Modify the smoothing parameter.
@@ -104,18 +61,125 @@ class AdaDeltaUpdate
   //! Modify the value used to initialise the mean squared gradient parameter.
   double& Epsilon() { return epsilon; }
 
+  //! Get the number of bytes of the state (the mean squared gradients and
+  //! updates) for an iterate of the given size.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
+  {
+    return 2 * rows * cols * elemSize;
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process. In AdaDelta update policy, the mean squared and the delta
+     * mean squared gradient matrices are initialized to the zeros matrix with
+     * the same size as gradient matrix (see ens::SGD<>).
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const AdaDeltaUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        meanSquaredGradient(arma::zeros<MatType>(rows, cols)),
+        meanSquaredGradientDx(arma::zeros<MatType>(rows, cols))
+    {
+      // Nothing to do.
+    }
+
+    /**
+     * Update step for SGD. The AdaDelta update dynamically adapts over time
+     * using only first order information. Additionally, AdaDelta requires no
+     * manual tuning of a learning rate.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      Step(iterate, stepSize, gradient, IsFusableUpdate<MatType, GradType>());
+    }
+
+   private:
+    //! Update the accumulators and the iterate in a single loop.
+    void Step(MatType& iterate,
+              const double stepSize,
+              const GradType& gradient,
+              std::true_type /* fusable */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType rho = parent.rho;
+      const ElemType epsilon = parent.epsilon;
+      const ElemType step = stepSize;
+
+      ElemType* x = iterate.memptr();
+      ElemType* msg = meanSquaredGradient.memptr();
+      ElemType* msgDx = meanSquaredGradientDx.memptr();
+      const ElemType* g = gradient.memptr();
+
+      const size_t n = iterate.n_elem;
+      ENS_PRAGMA_OMP_SIMD
+      for (size_t i = 0; i < n; ++i)
+      {
+        msg[i] = rho * msg[i] + (1 - rho) * (g[i] * g[i]);
+        const ElemType dx = std::sqrt((msgDx[i] + epsilon) /
+            (msg[i] + epsilon)) * g[i];
+        msgDx[i] = rho * msgDx[i] + (1 - rho) * (dx * dx);
+        x[i] -= step * dx;
+      }
+    }
+
+    //! Update the accumulators and the iterate with Armadillo expressions.
+    void Step(MatType& iterate,
+              const double stepSize,
+              const GradType& gradient,
+              std::false_type /* fusable */)
+    {
+      // Accumulate gradient.
+      meanSquaredGradient *= parent.rho;
+      meanSquaredGradient += (1 - parent.rho) * (gradient % gradient);
+      MatType dx = arma::sqrt((meanSquaredGradientDx + parent.epsilon) /
+          (meanSquaredGradient + parent.epsilon)) % gradient;
+
+      // Accumulate updates.
+      meanSquaredGradientDx *= parent.rho;
+      meanSquaredGradientDx += (1 - parent.rho) * (dx % dx);
+
+      // Apply update.
+      iterate -= (stepSize * dx);
+    }
+
+    // Instantiated parent object.
+    const AdaDeltaUpdate& parent;
+
+    // The mean squared gradient matrix.
+    MatType meanSquaredGradient;
+
+    // The delta mean squared gradient matrix.
+    MatType meanSquaredGradientDx;
+  };
+
  private:
   // The smoothing parameter.
   double rho;
 
   // The epsilon value used to initialise the mean squared gradient parameter.
   double epsilon;
-
-  // The mean squared gradient matrix.
-  arma::mat meanSquaredGradient;
-
-  // The delta mean squared gradient matrix.
-  arma::mat meanSquaredGradientDx;
 };
 
 } // namespace ens
@@ -79,14 +79,25 @@ class AdaGrad
    * objective value is returned.
    *
    * @tparam DecomposableFunctionType Type of the function to optimize.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to optimize.
    * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
    * @return Objective value of the final point.
    */
-  template<typename DecomposableFunctionType>
-  double Optimize(DecomposableFunctionType& function, arma::mat& iterate)
+  template<typename DecomposableFunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(DecomposableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks)
   {
-    return optimizer.Optimize(function, iterate);
+    return optimizer.template Optimize<DecomposableFunctionType, MatType,
+        GradType, CallbackTypes...>(function, iterate,
+        std::forward<CallbackTypes>(callbacks)...);
   }
 
   //! Get the step size.
@@ -126,6 +137,34 @@ class AdaGrad
   //! are reset before Optimize call.
   bool& ResetPolicy() { return optimizer.ResetPolicy(); }
 
+  /**
+   * Save or load the state of the optimization (see SGD::Serialize()).
+   *
+   * @tparam MatType Type of matrix optimized with.
+   * @tparam GradType Type of matrix used to represent function gradients.
+   * @param ar Archive to save into or load from.
+   */
+  template<typename MatType = arma::mat, typename GradType = MatType>
+  void Serialize(BinaryArchive& ar)
+  {
+    optimizer.template Serialize<MatType, GradType>(ar);
+  }
+
+  /**
+   * Estimate the number of bytes Optimize() allocates for an iterate of the
+   * given size (see SGD::EstimateMemory()).
+   *
+   * @param rows Number of rows of the iterate.
+   * @param cols Number of columns of the iterate.
+   * @param elemSize Size of an element of the iterate.
+   */
+  size_t EstimateMemory(const size_t rows,
+                        const size_t cols = 1,
+                        const size_t elemSize = sizeof(double)) const
+  {
+    return optimizer.EstimateMemory(rows, cols, elemSize);
+  }
+
  private:
   //! The Stochastic Gradient Descent object with AdaGrad policy.
   SGD<AdaGradUpdate> optimizer;
@@ -49,49 +49,152 @@ class AdaGradUpdate
     // Nothing to do.
   }
 
+  //! Get the value used to initialise the squared gradient parameter.
+  double Epsilon() const { return epsilon; }
+  //! Modify the value used to initialise the squared gradient parameter.
+  double& Epsilon() { return epsilon; }
+
+  //! Get the number of bytes of the state (the squared gradient) for an
+  //! iterate of the given size.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
+  {
+    return rows * cols * elemSize;
+  }
+
   /**
-   * The Initialize method is called by SGD Optimizer method before the start of
-   * the iteration update process. In AdaGrad update policy, squared
-   * gradient matrix is initialized to the zeros matrix with the same size as
-   * gradient matrix (see ens::SGD<>).
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
    */
-  void Initialize(const size_t rows, const size_t cols)
+  template<typename MatType, typename GradType>
+  class Policy
   {
-    // Initialize an empty matrix for sum of squares of parameter gradient.
-    squaredGradient = arma::zeros<arma::mat>(rows, cols);
-  }
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process. In AdaGrad update policy, squared gradient matrix is
+     * initialized to the zeros matrix with the same size as gradient matrix
+     * (see ens::SGD<>).
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const AdaGradUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        squaredGradient(arma::zeros<MatType>(rows, cols))
+    {
+      // Nothing to do.
+    }
+
+    /**
+     * Update step for SGD. The AdaGrad update adapts the learning rate by
+     * performing larger updates for more sparse parameters and smaller updates
+     * for less sparse parameters .
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      squaredGradient += (gradient % gradient);
+      iterate -= (stepSize * gradient) / (arma::sqrt(squaredGradient) +
+          parent.epsilon);
+    }
+
+    /**
+     * Save or load the state of the policy, to resume an optimization.
+     *
+     * @param ar Archive to save into or load from.
+     */
+    void Serialize(BinaryArchive& ar)
+    {
+      ar(squaredGradient);
+    }
+
+   private:
+    // Instantiated parent object.
+    const AdaGradUpdate& parent;
+
+    // The squared gradient matrix.
+    MatType squaredGradient;
+  };
 
   /**
-   * Update step for SGD. The AdaGrad update adapts the learning rate by
-   * performing larger updates for more sparse parameters and smaller updates
-   * for less sparse parameters .
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
+   * The AdaGrad policy for sparse gradients.  Coordinates with a zero gradient
+   * keep their squared gradient and are not moved by the dense update, so only
+   * the nonzero elements of the gradient are visited and each step costs time
+   * proportional to the number of nonzeros instead of the number of
+   * parameters.  The iterates are the same as with a dense gradient.
    */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
+  template<typename MatType, typename eT>
+  class Policy<MatType, arma::SpMat<eT>>
   {
-    squaredGradient += (gradient % gradient);
-    iterate -= (stepSize * gradient) / (arma::sqrt(squaredGradient) + epsilon);
-  }
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.  The squared gradient matrix is initialized to zeros.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const AdaGradUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        squaredGradient(arma::zeros<MatType>(rows, cols))
+    {
+      // Nothing to do.
+    }
 
-  //! Get the value used to initialise the squared gradient parameter.
-  double Epsilon() const { return epsilon; }
-  //! Modify the value used to initialise the squared gradient parameter.
-  double& Epsilon() { return epsilon; }
+    /**
+     * Update step for SGD, visiting only the nonzero elements of the gradient.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The sparse gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const arma::SpMat<eT>& gradient)
+    {
+      typename arma::SpMat<eT>::const_iterator it = gradient.begin();
+      for ( ; it != gradient.end(); ++it)
+      {
+        const size_t row = it.row();
+        const size_t col = it.col();
+        squaredGradient(row, col) += (*it) * (*it);
+        iterate(row, col) -= (stepSize * (*it)) /
+            (std::sqrt(squaredGradient(row, col)) + parent.epsilon);
+      }
+    }
+
+    /**
+     * Save or load the state of the policy, to resume an optimization.
+     *
+     * @param ar Archive to save into or load from.
+     */
+    void Serialize(BinaryArchive& ar)
+    {
+      ar(squaredGradient);
+    }
+
+   private:
+    // Instantiated parent object.
+    const AdaGradUpdate& parent;
+
+    // The squared gradient matrix.
+    MatType squaredGradient;
+  };
 
  private:
   // The epsilon value used to initialise the squared gradient parameter.
   double epsilon;
-
-  // The squared gradient matrix.
-  arma::mat squaredGradient;
 };
 
 } // namespace ens
@@ -26,9 +26,12 @@
 #include "adam_update.hpp"
 #include "adamax_update.hpp"
 #include "amsgrad_update.hpp"
+#include "lamb_update.hpp"
+#include "lazy_adam_update.hpp"
 #include "nadam_update.hpp"
 #include "nadamax_update.hpp"
 #include "optimisticadam_update.hpp"
+#include "reduced_precision_adam_update.hpp"
 
 namespace ens {
 
@@ -105,14 +108,25 @@ class AdamType
    * objective value is returned.
    *
    * @tparam DecomposableFunctionType Type of the function to optimize.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to optimize.
    * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
    * @return Objective value of the final point.
    */
-  template<typename DecomposableFunctionType>
-  double Optimize(DecomposableFunctionType& function, arma::mat& iterate)
+  template<typename DecomposableFunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(DecomposableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks)
   {
-    return optimizer.Optimize(function, iterate);
+    return optimizer.template Optimize<DecomposableFunctionType, MatType,
+        GradType, CallbackTypes...>(function, iterate,
+        std::forward<CallbackTypes>(callbacks)...);
   }
 
   //! Get the step size.
@@ -162,11 +176,81 @@ class AdamType
   //! are reset before Optimize call.
   bool& ResetPolicy() { return optimizer.ResetPolicy(); }
 
+  //! Get whether or not the next batch is prefetched during each step.
+  bool Prefetch() const { return optimizer.Prefetch(); }
+  //! Modify whether or not the next batch is prefetched during each step.
+  bool& Prefetch() { return optimizer.Prefetch(); }
+
+  //! Get the size of the micro-batches each batch is evaluated in.
+  size_t MicroBatchSize() const { return optimizer.MicroBatchSize(); }
+  //! Modify the size of the micro-batches each batch is evaluated in (see
+  //! SGD::MicroBatchSize()).
+  size_t& MicroBatchSize() { return optimizer.MicroBatchSize(); }
+
   //! Get the update policy.
   const UpdateRule& UpdatePolicy() const { return optimizer.UpdatePolicy(); }
   //! Modify the update policy.
   UpdateRule& UpdatePolicy() { return optimizer.UpdatePolicy(); }
 
+  //! Get how the final objective is computed.
+  const ens::ObjectiveEstimate& ObjectiveEstimate() const
+  { return optimizer.ObjectiveEstimate(); }
+  //! Modify how the final objective is computed.
+  ens::ObjectiveEstimate& ObjectiveEstimate()
+  { return optimizer.ObjectiveEstimate(); }
+
+  //! Get the weights the functions are sampled with (empty for visiting them
+  //! in order).
+  const arma::vec& SamplingWeights() const
+  { return optimizer.SamplingWeights(); }
+  //! Modify the weights the functions are sampled with (see
+  //! SGD::SamplingWeights()).
+  arma::vec& SamplingWeights() { return optimizer.SamplingWeights(); }
+
+  //! Get whether the epochs only visit the new functions, with replay.
+  bool Incremental() const { return optimizer.Incremental(); }
+  //! Modify whether the epochs only visit the new functions, with replay (see
+  //! SGD::Incremental()).
+  bool& Incremental() { return optimizer.Incremental(); }
+
+  //! Get the number of old functions replayed per new function.
+  double ReplayRate() const { return optimizer.ReplayRate(); }
+  //! Modify the number of old functions replayed per new function.
+  double& ReplayRate() { return optimizer.ReplayRate(); }
+
+  //! Get the number of functions of the last call to Optimize().
+  size_t SeenFunctions() const { return optimizer.SeenFunctions(); }
+  //! Modify the number of functions considered old in the next call.
+  size_t& SeenFunctions() { return optimizer.SeenFunctions(); }
+
+  /**
+   * Save or load the state of the optimization (see SGD::Serialize()).
+   *
+   * @tparam MatType Type of matrix optimized with.
+   * @tparam GradType Type of matrix used to represent function gradients.
+   * @param ar Archive to save into or load from.
+   */
+  template<typename MatType = arma::mat, typename GradType = MatType>
+  void Serialize(BinaryArchive& ar)
+  {
+    optimizer.template Serialize<MatType, GradType>(ar);
+  }
+
+  /**
+   * Estimate the number of bytes Optimize() allocates for an iterate of the
+   * given size (see SGD::EstimateMemory()).
+   *
+   * @param rows Number of rows of the iterate.
+   * @param cols Number of columns of the iterate.
+   * @param elemSize Size of an element of the iterate.
+   */
+  size_t EstimateMemory(const size_t rows,
+                        const size_t cols = 1,
+                        const size_t elemSize = sizeof(double)) const
+  {
+    return optimizer.EstimateMemory(rows, cols, elemSize);
+  }
+
  private:
   //! The Stochastic Gradient Descent object with Adam policy.
   SGD<UpdateRule> optimizer;
@@ -178,12 +262,19 @@ using AdaMax = AdamType<AdaMaxUpdate>;
 
 using AMSGrad = AdamType<AMSGradUpdate>;
 
+using LAMB = AdamType<LAMBUpdate>;
+
+using LazyAdam = AdamType<LazyAdamUpdate>;
+
 using Nadam = AdamType<NadamUpdate>;
 
 using NadaMax = AdamType<NadaMaxUpdate>;
 
 using OptimisticAdam = AdamType<OptimisticAdamUpdate>;
 
+template<typename StateType = BFloat16State>
+using ReducedPrecisionAdam = AdamType<ReducedPrecisionAdamUpdate<StateType>>;
+
 } // namespace ens
 
 // Include implementation.
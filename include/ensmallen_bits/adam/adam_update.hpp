@@ -46,78 +46,301 @@ class AdamUpdate
    *        parameter.
    * @param beta1 The smoothing parameter.
    * @param beta2 The second moment coefficient.
+   * @param interleaved If true, the two moments of each coordinate are stored
+   *        next to each other in a single matrix, so that a dense update
+   *        streams two arrays (the iterate and the state) plus the gradient
+   *        instead of three.
    */
   AdamUpdate(const double epsilon = 1e-8,
              const double beta1 = 0.9,
-             const double beta2 = 0.999) :
+             const double beta2 = 0.999,
+             const bool interleaved = false) :
     epsilon(epsilon),
     beta1(beta1),
     beta2(beta2),
-    iteration(0)
+    interleaved(interleaved)
   {
     // Nothing to do.
   }
 
-  /**
-   * The Initialize method is called by SGD Optimizer method before the start of
-   * the iteration update process.
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
-   */
-  void Initialize(const size_t rows, const size_t cols)
+  //! Get the value used to initialise the squared gradient parameter.
+  double Epsilon() const { return epsilon; }
+  //! Modify the value used to initialise the squared gradient parameter.
+  double& Epsilon() { return epsilon; }
+
+  //! Get the smoothing parameter.
+  double Beta1() const { return beta1; }
+  //! Modify the smoothing parameter.
+  double& Beta1() { return beta1; }
+
+  //! Get the second moment coefficient.
+  double Beta2() const { return beta2; }
+  //! Modify the second moment coefficient.
+  double& Beta2() { return beta2; }
+
+  //! Get whether the moments are stored interleaved.
+  bool Interleaved() const { return interleaved; }
+  //! Modify whether the moments are stored interleaved.
+  bool& Interleaved() { return interleaved; }
+
+  //! Get the number of bytes of the state (the two moments) for an iterate
+  //! of the given size.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
   {
-    m = arma::zeros<arma::mat>(rows, cols);
-    v = arma::zeros<arma::mat>(rows, cols);
+    return 2 * rows * cols * elemSize;
   }
 
   /**
-   * Update step for Adam.
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
    */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
+  template<typename MatType, typename GradType>
+  class Policy
   {
-    // Increment the iteration counter variable.
-    ++iteration;
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const AdamUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        interleaved(parent.interleaved &&
+            IsFusableUpdate<MatType, GradType>::value),
+        iteration(0)
+    {
+      if (interleaved)
+      {
+        state.zeros(2, rows * cols);
+      }
+      else
+      {
+        m.zeros(rows, cols);
+        v.zeros(rows, cols);
+      }
+    }
 
-    // And update the iterate.
-    m *= beta1;
-    m += (1 - beta1) * gradient;
+    /**
+     * Update step for Adam.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      Update(iterate, stepSize, gradient, 0.0);
+    }
 
-    v *= beta2;
-    v += (1 - beta2) * (gradient % gradient);
+    /**
+     * Update step for Adam, followed by a decay of the iterate by the given
+     * weight decay rate (as in AdamW).  For dense matrices, the moments and the
+     * iterate are all updated in a single pass over memory.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     * @param weightDecay The weight decay rate (0 for plain Adam).
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                const double weightDecay)
+    {
+      // Increment the iteration counter variable.
+      ++iteration;
 
-    const double biasCorrection1 = 1.0 - std::pow(beta1, iteration);
-    const double biasCorrection2 = 1.0 - std::pow(beta2, iteration);
+      const double biasCorrection1 = 1.0 - std::pow(parent.beta1, iteration);
+      const double biasCorrection2 = 1.0 - std::pow(parent.beta2, iteration);
+
+      /**
+       * It should be noted that the term, m / (arma::sqrt(v) + eps), in the
+       * following expression is an approximation of the following actual term;
+       * m / (arma::sqrt(v) + (arma::sqrt(biasCorrection2) * eps).
+       */
+      Step(iterate, gradient, stepSize * std::sqrt(biasCorrection2) /
+          biasCorrection1, weightDecay, IsFusableUpdate<MatType, GradType>());
+    }
 
     /**
-     * It should be noted that the term, m / (arma::sqrt(v) + eps), in the
-     * following expression is an approximation of the following actual term;
-     * m / (arma::sqrt(v) + (arma::sqrt(biasCorrection2) * eps).
+     * Save or load the state of the policy, to resume an optimization.
+     *
+     * @param ar Archive to save into or load from.
      */
-    iterate -= (stepSize * std::sqrt(biasCorrection2) / biasCorrection1) *
-        m / (arma::sqrt(v) + epsilon);
-  }
+    void Serialize(BinaryArchive& ar)
+    {
+      // The layout of the moments depends on whether they are interleaved.
+      bool savedInterleaved = interleaved;
+      ar(savedInterleaved);
+      if (savedInterleaved != interleaved)
+      {
+        throw std::runtime_error("Serialize(): the moments were saved "
+            "with a different interleaving!");
+      }
 
-  //! Get the value used to initialise the squared gradient parameter.
-  double Epsilon() const { return epsilon; }
-  //! Modify the value used to initialise the squared gradient parameter.
-  double& Epsilon() { return epsilon; }
+      ar(m);
+      ar(v);
+      ar(state);
+      ar(iteration);
+    }
 
-  //! Get the smoothing parameter.
-  double Beta1() const { return beta1; }
-  //! Modify the smoothing parameter.
-  double& Beta1() { return beta1; }
+   private:
+    //! Update the moments and the iterate in a single loop.
+    void Step(MatType& iterate,
+              const GradType& gradient,
+              const double scaledStepSize,
+              const double weightDecay,
+              std::true_type /* fusable */)
+    {
+      typedef typename MatType::elem_type ElemType;
 
-  //! Get the second moment coefficient.
-  double Beta2() const { return beta2; }
-  //! Modify the second moment coefficient.
-  double& Beta2() { return beta2; }
+      const ElemType beta1 = parent.beta1;
+      const ElemType beta2 = parent.beta2;
+      const ElemType epsilon = parent.epsilon;
+      const ElemType step = scaledStepSize;
+      const ElemType decay = weightDecay;
+
+      ElemType* x = iterate.memptr();
+      ElemType* mem = m.memptr();
+      ElemType* vem = v.memptr();
+      const ElemType* g = gradient.memptr();
+
+      const size_t n = iterate.n_elem;
+      if (interleaved)
+      {
+        // Column i of the state holds the two moments of coordinate i.
+        ElemType* s = state.memptr();
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = 0; i < n; ++i)
+        {
+          s[2 * i] = beta1 * s[2 * i] + (1 - beta1) * g[i];
+          s[2 * i + 1] = beta2 * s[2 * i + 1] + (1 - beta2) * (g[i] * g[i]);
+
+          const ElemType xi = x[i] - step * s[2 * i] /
+              (std::sqrt(s[2 * i + 1]) + epsilon);
+          x[i] = xi - decay * xi;
+        }
+        return;
+      }
+
+      ENS_PRAGMA_OMP_SIMD
+      for (size_t i = 0; i < n; ++i)
+      {
+        mem[i] = beta1 * mem[i] + (1 - beta1) * g[i];
+        vem[i] = beta2 * vem[i] + (1 - beta2) * (g[i] * g[i]);
+
+        const ElemType xi = x[i] - step * mem[i] / (std::sqrt(vem[i]) +
+            epsilon);
+        x[i] = xi - decay * xi;
+      }
+    }
+
+    //! Update the moments and the iterate with Armadillo expressions.
+    void Step(MatType& iterate,
+              const GradType& gradient,
+              const double scaledStepSize,
+              const double weightDecay,
+              std::false_type /* fusable */)
+    {
+      m *= parent.beta1;
+      m += (1 - parent.beta1) * gradient;
+
+      v *= parent.beta2;
+      v += (1 - parent.beta2) * (gradient % gradient);
+
+      iterate -= scaledStepSize * m / (sqrt(v) + parent.epsilon);
+
+      if (weightDecay != 0)
+        iterate -= weightDecay * iterate;
+    }
+
+    // Instantiated parent object.
+    const AdamUpdate& parent;
+
+    // Whether the moments are stored interleaved in the state matrix.
+    bool interleaved;
+
+    // The exponential moving average of gradient values.
+    MatType m;
+
+    // The exponential moving average of squared gradient values.
+    MatType v;
+
+    // The interleaved moments (one column per coordinate), if used.
+    MatType state;
+
+    // The number of iterations.
+    double iteration;
+  };
+
+  /**
+   * The element-wise kernel of the Adam update, used to fuse it with other
+   * policies into one loop (see FusedUpdate).  The moments are stored
+   * interleaved, as with the interleaved option.
+   */
+  template<typename ElemType>
+  class Kernel
+  {
+   public:
+    //! Create the kernel for an iterate with n elements, with zero moments.
+    Kernel(const AdamUpdate& parent, const size_t n) :
+        parent(parent),
+        iteration(0),
+        step(0)
+    {
+      state.zeros(2, n);
+    }
+
+    //! Start a step with the given step size; this computes the bias
+    //! corrections of the step.
+    void Begin(const double stepSize)
+    {
+      ++iteration;
+      const double biasCorrection1 = 1.0 - std::pow(parent.beta1, iteration);
+      const double biasCorrection2 = 1.0 - std::pow(parent.beta2, iteration);
+      step = stepSize * std::sqrt(biasCorrection2) / biasCorrection1;
+    }
+
+    //! Update element i of the iterate with element g of the gradient.
+    void Apply(const size_t i, ElemType& x, ElemType& g)
+    {
+      const ElemType beta1 = parent.beta1;
+      const ElemType beta2 = parent.beta2;
+      ElemType* s = state.memptr() + 2 * i;
+      s[0] = beta1 * s[0] + (1 - beta1) * g;
+      s[1] = beta2 * s[1] + (1 - beta2) * (g * g);
+      x -= step * s[0] / (std::sqrt(s[1]) + ElemType(parent.epsilon));
+    }
+
+    //! Save or load the state of the kernel.
+    void Serialize(BinaryArchive& ar)
+    {
+      ar(state);
+      ar(iteration);
+    }
+
+   private:
+    //! Instantiated parent object.
+    const AdamUpdate& parent;
+
+    //! The two moments of each element, one column per element.
+    arma::Mat<ElemType> state;
+
+    //! The number of iterations.
+    double iteration;
+
+    //! The bias corrected step size of the current step.
+    ElemType step;
+  };
 
  private:
   // The epsilon value used to initialise the squared gradient parameter.
@@ -129,14 +352,8 @@ class AdamUpdate
   // The second moment coefficient.
   double beta2;
 
-  // The exponential moving average of gradient values.
-  arma::mat m;
-
-  // The exponential moving average of squared gradient values.
-  arma::mat v;
-
-  // The number of iterations.
-  double iteration;
+  // Whether the moments are stored interleaved.
+  bool interleaved;
 };
 
 } // namespace ens
@@ -54,53 +54,11 @@ class AdaMaxUpdate
                const double beta2 = 0.999) :
     epsilon(epsilon),
     beta1(beta1),
-    beta2(beta2),
-    iteration(0)
+    beta2(beta2)
   {
     // Nothing to do.
   }
 
-  /**
-   * The Initialize method is called by SGD Optimizer method before the start of
-   * the iteration update process.
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
-   */
-  void Initialize(const size_t rows, const size_t cols)
-  {
-    m = arma::zeros<arma::mat>(rows, cols);
-    u = arma::zeros<arma::mat>(rows, cols);
-  }
-
-  /**
-   * Update step for Adam.
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
-   */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
-  {
-    // Increment the iteration counter variable.
-    ++iteration;
-
-    // And update the iterate.
-    m *= beta1;
-    m += (1 - beta1) * gradient;
-
-    // Update the exponentially weighted infinity norm.
-    u *= beta2;
-    u = arma::max(u, arma::abs(gradient));
-
-    const double biasCorrection1 = 1.0 - std::pow(beta1, iteration);
-
-    if (biasCorrection1 != 0)
-      iterate -= (stepSize / biasCorrection1 * m / (u + epsilon));
-  }
-
   //! Get the value used to initialise the squared gradient parameter.
   double Epsilon() const { return epsilon; }
   //! Modify the value used to initialise the squared gradient parameter.
@@ -116,6 +74,137 @@ class AdaMaxUpdate
   //! Modify the second moment coefficient.
   double& Beta2() { return beta2; }
 
+  //! Get the number of bytes of the state (the first moment and the
+  //! exponentially weighted infinity norm) for an iterate of the given size.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
+  {
+    return 2 * rows * cols * elemSize;
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const AdaMaxUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        iteration(0)
+    {
+      m.zeros(rows, cols);
+      u.zeros(rows, cols);
+    }
+
+    /**
+     * Update step for Adam.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      // Increment the iteration counter variable.
+      ++iteration;
+
+      const double biasCorrection1 = 1.0 - std::pow(parent.beta1, iteration);
+
+      Step(iterate, gradient, stepSize / biasCorrection1,
+          biasCorrection1 != 0, IsFusableUpdate<MatType, GradType>());
+    }
+
+    /**
+     * Save or load the state of the policy, to resume an optimization.
+     *
+     * @param ar Archive to save into or load from.
+     */
+    void Serialize(BinaryArchive& ar)
+    {
+      ar(m);
+      ar(u);
+      ar(iteration);
+    }
+
+   private:
+    //! Update the state and the iterate in a single loop.
+    void Step(MatType& iterate,
+              const GradType& gradient,
+              const double scaledStepSize,
+              const bool takeStep,
+              std::true_type /* fusable */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType beta1 = parent.beta1;
+      const ElemType beta2 = parent.beta2;
+      const ElemType epsilon = parent.epsilon;
+      const ElemType step = takeStep ? scaledStepSize : 0;
+
+      ElemType* x = iterate.memptr();
+      ElemType* mem = m.memptr();
+      ElemType* uem = u.memptr();
+      const ElemType* g = gradient.memptr();
+
+      const size_t n = iterate.n_elem;
+      ENS_PRAGMA_OMP_SIMD
+      for (size_t i = 0; i < n; ++i)
+      {
+        mem[i] = beta1 * mem[i] + (1 - beta1) * g[i];
+
+        // Update the exponentially weighted infinity norm.
+        uem[i] = std::max(beta2 * uem[i], std::abs(g[i]));
+
+        x[i] -= step * mem[i] / (uem[i] + epsilon);
+      }
+    }
+
+    //! Update the state and the iterate with Armadillo expressions.
+    void Step(MatType& iterate,
+              const GradType& gradient,
+              const double scaledStepSize,
+              const bool takeStep,
+              std::false_type /* fusable */)
+    {
+      m *= parent.beta1;
+      m += (1 - parent.beta1) * gradient;
+
+      // Update the exponentially weighted infinity norm.
+      u *= parent.beta2;
+      u = max(u, abs(gradient));
+
+      if (takeStep)
+        iterate -= (scaledStepSize * m / (u + parent.epsilon));
+    }
+
+    // Instantiated parent object.
+    const AdaMaxUpdate& parent;
+
+    // The exponential moving average of gradient values.
+    MatType m;
+
+    // The exponentially weighted infinity norm.
+    MatType u;
+
+    // The number of iterations.
+    double iteration;
+  };
+
  private:
   // The epsilon value used to initialise the squared gradient parameter.
   double epsilon;
@@ -125,15 +214,6 @@ class AdaMaxUpdate
 
   // The second moment coefficient.
   double beta2;
-
-  // The exponential moving average of gradient values.
-  arma::mat m;
-
-  // The exponentially weighted infinity norm.
-  arma::mat u;
-
-  // The number of iterations.
-  double iteration;
 };
 
 } // namespace ens
@@ -41,63 +41,21 @@ class AMSGradUpdate
    *        parameter.
    * @param beta1 The smoothing parameter.
    * @param beta2 The second moment coefficient.
+   * @param interleaved If true, the three state values of each coordinate are
+   *        stored next to each other in a single matrix.
    */
   AMSGradUpdate(const double epsilon = 1e-8,
                 const double beta1 = 0.9,
-                const double beta2 = 0.999) :
+                const double beta2 = 0.999,
+                const bool interleaved = false) :
     epsilon(epsilon),
     beta1(beta1),
     beta2(beta2),
-    iteration(0)
+    interleaved(interleaved)
   {
     // Nothing to do.
   }
 
-  /**
-   * The Initialize method is called by SGD Optimizer method before the start of
-   * the iteration update process.
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
-   */
-  void Initialize(const size_t rows, const size_t cols)
-  {
-    m = arma::zeros<arma::mat>(rows, cols);
-    v = arma::zeros<arma::mat>(rows, cols);
-    vImproved = arma::zeros<arma::mat>(rows, cols);
-  }
-
-  /**
-   * Update step for AMSGrad.
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
-   */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
-  {
-    // Increment the iteration counter variable.
-    ++iteration;
-
-    // And update the iterate.
-    m *= beta1;
-    m += (1 - beta1) * gradient;
-
-    v *= beta2;
-    v += (1 - beta2) * (gradient % gradient);
-
-    const double biasCorrection1 = 1.0 - std::pow(beta1, iteration);
-    const double biasCorrection2 = 1.0 - std::pow(beta2, iteration);
-
-    // Element wise maximum of past and present squared gradients.
-    vImproved = arma::max(vImproved, v);
-
-    iterate -= (stepSize * std::sqrt(biasCorrection2) / biasCorrection1) *
-                m / (arma::sqrt(vImproved) + epsilon);
-  }
-
   //! Get the value used to initialise the squared gradient parameter.
   double Epsilon() const { return epsilon; }
   //! Modify the value used to initialise the squared gradient parameter.
@@ -113,6 +71,191 @@ class AMSGradUpdate
   //! Modify the second moment coefficient.
   double& Beta2() { return beta2; }
 
+  //! Get whether the state is stored interleaved.
+  bool Interleaved() const { return interleaved; }
+  //! Modify whether the state is stored interleaved.
+  bool& Interleaved() { return interleaved; }
+
+  //! Get the number of bytes of the state (the two moments and the maximum
+  //! of the second moment) for an iterate of the given size.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
+  {
+    return 3 * rows * cols * elemSize;
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const AMSGradUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        interleaved(parent.interleaved &&
+            IsFusableUpdate<MatType, GradType>::value),
+        iteration(0)
+    {
+      if (interleaved)
+      {
+        state.zeros(3, rows * cols);
+      }
+      else
+      {
+        m.zeros(rows, cols);
+        v.zeros(rows, cols);
+        vImproved.zeros(rows, cols);
+      }
+    }
+
+    /**
+     * Update step for AMSGrad.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      // Increment the iteration counter variable.
+      ++iteration;
+
+      const double biasCorrection1 = 1.0 - std::pow(parent.beta1, iteration);
+      const double biasCorrection2 = 1.0 - std::pow(parent.beta2, iteration);
+
+      Step(iterate, gradient, stepSize * std::sqrt(biasCorrection2) /
+          biasCorrection1, IsFusableUpdate<MatType, GradType>());
+    }
+
+    /**
+     * Save or load the state of the policy, to resume an optimization.
+     *
+     * @param ar Archive to save into or load from.
+     */
+    void Serialize(BinaryArchive& ar)
+    {
+      // The layout of the moments depends on whether they are interleaved.
+      bool savedInterleaved = interleaved;
+      ar(savedInterleaved);
+      if (savedInterleaved != interleaved)
+      {
+        throw std::runtime_error("Serialize(): the moments were saved "
+            "with a different interleaving!");
+      }
+
+      ar(m);
+      ar(v);
+      ar(vImproved);
+      ar(state);
+      ar(iteration);
+    }
+
+   private:
+    //! Update the state and the iterate in a single loop.
+    void Step(MatType& iterate,
+              const GradType& gradient,
+              const double scaledStepSize,
+              std::true_type /* fusable */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType beta1 = parent.beta1;
+      const ElemType beta2 = parent.beta2;
+      const ElemType epsilon = parent.epsilon;
+      const ElemType step = scaledStepSize;
+
+      ElemType* x = iterate.memptr();
+      ElemType* mem = m.memptr();
+      ElemType* vem = v.memptr();
+      ElemType* vImprovedMem = vImproved.memptr();
+      const ElemType* g = gradient.memptr();
+
+      const size_t n = iterate.n_elem;
+      if (interleaved)
+      {
+        // Column i of the state holds m, v and the maximum of v for
+        // coordinate i.
+        ElemType* s = state.memptr();
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = 0; i < n; ++i)
+        {
+          s[3 * i] = beta1 * s[3 * i] + (1 - beta1) * g[i];
+          s[3 * i + 1] = beta2 * s[3 * i + 1] + (1 - beta2) * (g[i] * g[i]);
+          s[3 * i + 2] = std::max(s[3 * i + 2], s[3 * i + 1]);
+
+          x[i] -= step * s[3 * i] / (std::sqrt(s[3 * i + 2]) + epsilon);
+        }
+        return;
+      }
+
+      ENS_PRAGMA_OMP_SIMD
+      for (size_t i = 0; i < n; ++i)
+      {
+        mem[i] = beta1 * mem[i] + (1 - beta1) * g[i];
+        vem[i] = beta2 * vem[i] + (1 - beta2) * (g[i] * g[i]);
+
+        // Element wise maximum of past and present squared gradients.
+        vImprovedMem[i] = std::max(vImprovedMem[i], vem[i]);
+
+        x[i] -= step * mem[i] / (std::sqrt(vImprovedMem[i]) + epsilon);
+      }
+    }
+
+    //! Update the state and the iterate with Armadillo expressions.
+    void Step(MatType& iterate,
+              const GradType& gradient,
+              const double scaledStepSize,
+              std::false_type /* fusable */)
+    {
+      m *= parent.beta1;
+      m += (1 - parent.beta1) * gradient;
+
+      v *= parent.beta2;
+      v += (1 - parent.beta2) * (gradient % gradient);
+
+      // Element wise maximum of past and present squared gradients.
+      vImproved = max(vImproved, v);
+
+      iterate -= scaledStepSize * m / (sqrt(vImproved) + parent.epsilon);
+    }
+
+    // Instantiated parent object.
+    const AMSGradUpdate& parent;
+
+    // Whether the state is stored interleaved in the state matrix.
+    bool interleaved;
+
+    // The exponential moving average of gradient values.
+    MatType m;
+
+    // The exponential moving average of squared gradient values.
+    MatType v;
+
+    // The optimal sqaured gradient value.
+    MatType vImproved;
+
+    // The interleaved state (one column per coordinate), if used.
+    MatType state;
+
+    // The number of iterations.
+    double iteration;
+  };
+
  private:
   // The epsilon value used to initialise the squared gradient parameter.
   double epsilon;
@@ -123,17 +266,8 @@ class AMSGradUpdate
   // The second moment coefficient.
   double beta2;
 
-  // The exponential moving average of gradient values.
-  arma::mat m;
-
-  // The exponential moving average of squared gradient values.
-  arma::mat v;
-
-  // The optimal sqaured gradient value.
-  arma::mat vImproved;
-
-  // The number of iterations.
-  double iteration;
+  // Whether the state is stored interleaved.
+  bool interleaved;
 };
 
 } // namespace ens
@@ -0,0 +1,233 @@
+/**
+ * @file lamb_update.hpp
+ *
+ * Implementation of the LAMB update policy: Adam with layer-wise trust ratios.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_ADAM_LAMB_UPDATE_HPP
+#define ENSMALLEN_ADAM_LAMB_UPDATE_HPP
+
+#include <ensmallen_bits/utility/trust_ratio.hpp>
+
+namespace ens {
+
+/**
+ * LAMB computes the Adam direction (with decoupled weight decay) of each block
+ * of the iterate (for instance each layer of a network), and scales the step
+ * of the block by its trust ratio, the ratio of the norm of the block to the
+ * norm of its direction.  Like LARS for SGD with momentum, this keeps Adam
+ * stable with very large batches, without retuning the step size per block:
+ *
+ * \f[
+ * m = \beta_1 m + (1 - \beta_1) \nabla f(w) \\
+ * v = \beta_2 v + (1 - \beta_2) \nabla f(w)^2 \\
+ * u = \frac{m / (1 - \beta_1^t)}{\sqrt{v / (1 - \beta_2^t)} + \epsilon} +
+ *     \lambda w \\
+ * w_b = w_b - \alpha \frac{\|w_b\|}{\|u_b\|} u_b
+ * \f]
+ *
+ * where \f$ \lambda \f$ is the weight decay (the trust ratio is 1 for a block
+ * whose weights or direction are zero).  The blocks are the blockRows x
+ * blockCols submatrices of the iterate (see ForEachBlock()); the default is
+ * one block.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{You2020,
+ *   title     = {Large Batch Optimization for Deep Learning: Training {BERT}
+ *                in 76 minutes},
+ *   author    = {You, Yang and Li, Jing and Reddi, Sashank and Hseu, Jonathan
+ *                and Kumar, Sanjiv and Bhojanapalli, Srinadh and Song, Xiaodan
+ *                and Demmel, James and Keutzer, Kurt and Hsieh, Cho-Jui},
+ *   booktitle = {International Conference on Learning Representations},
+ *   year      = {2020}
+ * }
+ * @endcode
+ */
+class LAMBUpdate
+{
+ public:
+  /**
+   * Construct the LAMB update policy with the given parameters.
+   *
+   * @param epsilon Value used to avoid division by zero.
+   * @param beta1 The smoothing parameter.
+   * @param beta2 The second moment coefficient.
+   * @param weightDecay The decoupled weight decay rate.
+   * @param blockRows Number of rows of a block (0 for all rows).
+   * @param blockCols Number of columns of a block (0 for all columns).
+   */
+  LAMBUpdate(const double epsilon = 1e-6,
+             const double beta1 = 0.9,
+             const double beta2 = 0.999,
+             const double weightDecay = 0.01,
+             const size_t blockRows = 0,
+             const size_t blockCols = 0) :
+      epsilon(epsilon),
+      beta1(beta1),
+      beta2(beta2),
+      weightDecay(weightDecay),
+      blockRows(blockRows),
+      blockCols(blockCols)
+  { /* Nothing to do. */ }
+
+  //! Get the value used to avoid division by zero.
+  double Epsilon() const { return epsilon; }
+  //! Modify the value used to avoid division by zero.
+  double& Epsilon() { return epsilon; }
+
+  //! Get the smoothing parameter.
+  double Beta1() const { return beta1; }
+  //! Modify the smoothing parameter.
+  double& Beta1() { return beta1; }
+
+  //! Get the second moment coefficient.
+  double Beta2() const { return beta2; }
+  //! Modify the second moment coefficient.
+  double& Beta2() { return beta2; }
+
+  //! Get the weight decay rate.
+  double WeightDecay() const { return weightDecay; }
+  //! Modify the weight decay rate.
+  double& WeightDecay() { return weightDecay; }
+
+  //! Get the number of rows of a block (0 for all rows).
+  size_t BlockRows() const { return blockRows; }
+  //! Modify the number of rows of a block (0 for all rows).
+  size_t& BlockRows() { return blockRows; }
+
+  //! Get the number of columns of a block (0 for all columns).
+  size_t BlockCols() const { return blockCols; }
+  //! Modify the number of columns of a block (0 for all columns).
+  size_t& BlockCols() { return blockCols; }
+
+  //! Get the number of bytes of the state (the two moments and the update
+  //! direction) for an iterate of the given size.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
+  {
+    return 3 * rows * cols * elemSize;
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const LAMBUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        iteration(0)
+    {
+      m.zeros(rows, cols);
+      v.zeros(rows, cols);
+      direction.zeros(rows, cols);
+    }
+
+    /**
+     * Update step for LAMB.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      // Increment the iteration counter variable.
+      ++iteration;
+
+      m *= parent.beta1;
+      m += (1 - parent.beta1) * gradient;
+
+      v *= parent.beta2;
+      v += (1 - parent.beta2) * (gradient % gradient);
+
+      const double biasCorrection1 = 1.0 - std::pow(parent.beta1, iteration);
+      const double biasCorrection2 = 1.0 - std::pow(parent.beta2, iteration);
+
+      direction = (m / biasCorrection1) / (arma::sqrt(v / biasCorrection2) +
+          parent.epsilon) + parent.weightDecay * iterate;
+
+      ForEachBlock(iterate.n_rows, iterate.n_cols, parent.blockRows,
+          parent.blockCols, [&](const size_t r0, const size_t c0,
+                                const size_t r1, const size_t c1)
+      {
+        const double ratio = TrustRatio(BlockNorm(iterate, r0, c0, r1, c1),
+            BlockNorm(direction, r0, c0, r1, c1));
+        iterate.submat(r0, c0, r1, c1) -= (stepSize * ratio) *
+            direction.submat(r0, c0, r1, c1);
+      });
+    }
+
+    /**
+     * Save or load the state of the policy, to resume an optimization.
+     *
+     * @param ar Archive to save into or load from.
+     */
+    void Serialize(BinaryArchive& ar)
+    {
+      ar(m);
+      ar(v);
+      ar(iteration);
+    }
+
+   private:
+    //! Instantiated parent object.
+    const LAMBUpdate& parent;
+
+    //! The exponential moving average of gradient values.
+    MatType m;
+
+    //! The exponential moving average of squared gradient values.
+    MatType v;
+
+    //! The direction of the current step.
+    MatType direction;
+
+    //! The number of iterations.
+    size_t iteration;
+  };
+
+ private:
+  //! The value used to avoid division by zero.
+  double epsilon;
+
+  //! The smoothing parameter.
+  double beta1;
+
+  //! The second moment coefficient.
+  double beta2;
+
+  //! The decoupled weight decay rate.
+  double weightDecay;
+
+  //! The number of rows of a block.
+  size_t blockRows;
+
+  //! The number of columns of a block.
+  size_t blockCols;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,177 @@
+/**
+ * @file lazy_adam_update.hpp
+ *
+ * Lazy Adam update for sparse gradients: only the moments and parameters of the
+ * coordinates with a nonzero gradient are updated.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_ADAM_LAZY_ADAM_UPDATE_HPP
+#define ENSMALLEN_ADAM_LAZY_ADAM_UPDATE_HPP
+
+#include "adam_update.hpp"
+
+namespace ens {
+
+/**
+ * LazyAdam is a variant of Adam for functions with sparse gradients
+ * (arma::sp_mat).  With a dense gradient it is the same as Adam.  With a
+ * sparse gradient, only the coordinates with a nonzero gradient are updated,
+ * so each step costs time proportional to the number of nonzeros of the
+ * gradient instead of the number of parameters.
+ *
+ * The decay of the moment estimates is deferred: each coordinate remembers the
+ * last iteration in which it was updated, and when its gradient is next
+ * nonzero the missed decay steps are applied at once, so its moments are the
+ * same as with Adam.  Unlike Adam, a coordinate is not moved in the
+ * iterations in which its gradient is zero, which is what makes the update
+ * sparse; for sparse problems this is usually a good thing, since the
+ * momentum of rarely seen features does not keep moving them.
+ */
+class LazyAdamUpdate : public AdamUpdate
+{
+ public:
+  /**
+   * Construct the LazyAdam update policy with the given parameters.
+   *
+   * @param epsilon The epsilon value used to initialise the squared gradient
+   *        parameter.
+   * @param beta1 The smoothing parameter.
+   * @param beta2 The second moment coefficient.
+   */
+  LazyAdamUpdate(const double epsilon = 1e-8,
+                 const double beta1 = 0.9,
+                 const double beta2 = 0.999) :
+      AdamUpdate(epsilon, beta1, beta2)
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * The LazyAdam policy for dense gradients is the Adam policy.
+   */
+  template<typename MatType, typename GradType>
+  class Policy : public AdamUpdate::Policy<MatType, GradType>
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const LazyAdamUpdate& parent, const size_t rows, const size_t cols) :
+        AdamUpdate::Policy<MatType, GradType>(parent, rows, cols)
+    {
+      // Nothing to do.
+    }
+  };
+
+  /**
+   * The LazyAdam policy for sparse gradients, which only visits the nonzero
+   * elements of the gradient.
+   */
+  template<typename MatType, typename eT>
+  class Policy<MatType, arma::SpMat<eT>>
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const LazyAdamUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        m(arma::zeros<MatType>(rows, cols)),
+        v(arma::zeros<MatType>(rows, cols)),
+        lastIteration(arma::zeros<arma::umat>(rows, cols)),
+        iteration(0)
+    {
+      // Nothing to do.
+    }
+
+    /**
+     * Update step for LazyAdam.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The sparse gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const arma::SpMat<eT>& gradient)
+    {
+      // Increment the iteration counter variable.
+      ++iteration;
+
+      const double beta1 = parent.Beta1();
+      const double beta2 = parent.Beta2();
+      const double biasCorrection1 = 1.0 - std::pow(beta1, (double) iteration);
+      const double biasCorrection2 = 1.0 - std::pow(beta2, (double) iteration);
+      const double scaledStepSize = stepSize * std::sqrt(biasCorrection2) /
+          biasCorrection1;
+
+      typename arma::SpMat<eT>::const_iterator it = gradient.begin();
+      for ( ; it != gradient.end(); ++it)
+      {
+        const size_t row = it.row();
+        const size_t col = it.col();
+
+        // Catch up on the decay of the iterations this coordinate missed.
+        const double missed = (double) (iteration - lastIteration(row, col));
+        lastIteration(row, col) = iteration;
+
+        m(row, col) = std::pow(beta1, missed) * m(row, col) +
+            (1 - beta1) * (*it);
+        v(row, col) = std::pow(beta2, missed) * v(row, col) +
+            (1 - beta2) * (*it) * (*it);
+
+        iterate(row, col) -= scaledStepSize * m(row, col) /
+            (std::sqrt(v(row, col)) + parent.Epsilon());
+      }
+    }
+
+    /**
+     * Save or load the state of the policy, to resume an optimization.
+     *
+     * @param ar Archive to save into or load from.
+     */
+    void Serialize(BinaryArchive& ar)
+    {
+      ar(m);
+      ar(v);
+      ar(lastIteration);
+      ar(iteration);
+    }
+
+   private:
+    // Instantiated parent object.
+    const LazyAdamUpdate& parent;
+
+    // The exponential moving average of gradient values, as of the last
+    // iteration in which each coordinate was updated.
+    MatType m;
+
+    // The exponential moving average of squared gradient values, as of the
+    // last iteration in which each coordinate was updated.
+    MatType v;
+
+    // The last iteration in which each coordinate was updated.
+    arma::umat lastIteration;
+
+    // The number of iterations.
+    size_t iteration;
+  };
+};
+
+} // namespace ens
+
+#endif
@@ -50,79 +50,16 @@ class NadamUpdate
       epsilon(epsilon),
       beta1(beta1),
       beta2(beta2),
-      scheduleDecay(scheduleDecay),
-      iteration(0),
-      cumBeta1(1)
+      scheduleDecay(scheduleDecay)
   {
     // Nothing to do.
   }
 
-  /**
-   * The Initialize() method is called by the optimizer before the start of the
-   * iteration update process.
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
-   */
-  void Initialize(const size_t rows, const size_t cols)
-  {
-    m = arma::zeros<arma::mat>(rows, cols);
-    v = arma::zeros<arma::mat>(rows, cols);
-  }
-
-  /**
-   * Update step for Nadam.
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
-   */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
-  {
-    // Increment the iteration counter variable.
-    ++iteration;
-
-    // And update the iterate.
-    m *= beta1;
-    m += (1 - beta1) * gradient;
-
-    v *= beta2;
-    v += (1 - beta2) * gradient % gradient;
-
-    double beta1T = beta1 * (1 - (0.5 *
-        std::pow(0.96, iteration * scheduleDecay)));
-
-    double beta1T1 = beta1 * (1 - (0.5 *
-        std::pow(0.96, (iteration + 1) * scheduleDecay)));
-
-    cumBeta1 *= beta1T;
-
-    const double biasCorrection1 = 1.0 - cumBeta1;
-
-    const double biasCorrection2 = 1.0 - std::pow(beta2, iteration);
-
-    const double biasCorrection3 = 1.0 - (cumBeta1 * beta1T1);
-
-    /* Note :- arma::sqrt(v) + epsilon * sqrt(biasCorrection2) is approximated
-     * as arma::sqrt(v) + epsilon
-     */
-    iterate -= (stepSize * (((1 - beta1T) / biasCorrection1) * gradient
-        + (beta1T1 / biasCorrection3) * m) * sqrt(biasCorrection2))
-        / (arma::sqrt(v) + epsilon);
-  }
-
   //! Get the value used to initialise the squared gradient parameter.
   double Epsilon() const { return epsilon; }
   //! Modify the value used to initialise the squared gradient parameter.
   double& Epsilon() { return epsilon; }
 
-  //! Get the value of the cumulative product of decay coefficients
-  double CumBeta1() const { return cumBeta1; }
-  //! Modify the value of the cumulative product of decay coefficients
-  double& CumBeta1() { return cumBeta1; }
-
   //! Get the smoothing parameter.
   double Beta1() const { return beta1; }
   //! Modify the smoothing parameter.
@@ -138,6 +75,158 @@ class NadamUpdate
   //! Modify the decay parameter for decay coefficients
   double& ScheduleDecay() { return scheduleDecay; }
 
+  //! Get the number of bytes of the state (the two moments) for an iterate
+  //! of the given size.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
+  {
+    return 2 * rows * cols * elemSize;
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const NadamUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        iteration(0),
+        cumBeta1(1)
+    {
+      m.zeros(rows, cols);
+      v.zeros(rows, cols);
+    }
+
+    /**
+     * Update step for Nadam.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      // Increment the iteration counter variable.
+      ++iteration;
+
+      double beta1T = parent.beta1 * (1 - (0.5 *
+          std::pow(0.96, iteration * parent.scheduleDecay)));
+
+      double beta1T1 = parent.beta1 * (1 - (0.5 *
+          std::pow(0.96, (iteration + 1) * parent.scheduleDecay)));
+
+      cumBeta1 *= beta1T;
+
+      const double biasCorrection1 = 1.0 - cumBeta1;
+
+      const double biasCorrection2 = 1.0 - std::pow(parent.beta2, iteration);
+
+      const double biasCorrection3 = 1.0 - (cumBeta1 * beta1T1);
+
+      /* Note :- arma::sqrt(v) + epsilon * sqrt(biasCorrection2) is approximated
+       * as arma::sqrt(v) + epsilon
+       */
+      Step(iterate, gradient,
+          stepSize * ((1 - beta1T) / biasCorrection1) * sqrt(biasCorrection2),
+          stepSize * (beta1T1 / biasCorrection3) * sqrt(biasCorrection2),
+          IsFusableUpdate<MatType, GradType>());
+    }
+
+    /**
+     * Save or load the state of the policy, to resume an optimization.
+     *
+     * @param ar Archive to save into or load from.
+     */
+    void Serialize(BinaryArchive& ar)
+    {
+      ar(m);
+      ar(v);
+      ar(iteration);
+      ar(cumBeta1);
+    }
+
+   private:
+    //! Update the state and the iterate in a single loop.
+    void Step(MatType& iterate,
+              const GradType& gradient,
+              const double gradientScale,
+              const double momentScale,
+              std::true_type /* fusable */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType beta1 = parent.beta1;
+      const ElemType beta2 = parent.beta2;
+      const ElemType epsilon = parent.epsilon;
+      const ElemType gScale = gradientScale;
+      const ElemType mScale = momentScale;
+
+      ElemType* x = iterate.memptr();
+      ElemType* mem = m.memptr();
+      ElemType* vem = v.memptr();
+      const ElemType* g = gradient.memptr();
+
+      const size_t n = iterate.n_elem;
+      ENS_PRAGMA_OMP_SIMD
+      for (size_t i = 0; i < n; ++i)
+      {
+        mem[i] = beta1 * mem[i] + (1 - beta1) * g[i];
+        vem[i] = beta2 * vem[i] + (1 - beta2) * (g[i] * g[i]);
+
+        x[i] -= (gScale * g[i] + mScale * mem[i]) / (std::sqrt(vem[i]) +
+            epsilon);
+      }
+    }
+
+    //! Update the state and the iterate with Armadillo expressions.
+    void Step(MatType& iterate,
+              const GradType& gradient,
+              const double gradientScale,
+              const double momentScale,
+              std::false_type /* fusable */)
+    {
+      m *= parent.beta1;
+      m += (1 - parent.beta1) * gradient;
+
+      v *= parent.beta2;
+      v += (1 - parent.beta2) * gradient % gradient;
+
+      iterate -= (gradientScale * gradient + momentScale * m) /
+          (sqrt(v) + parent.epsilon);
+    }
+
+    // Instantiated parent object.
+    const NadamUpdate& parent;
+
+    // The exponential moving average of gradient values.
+    MatType m;
+
+    // The exponential moving average of squared gradient values.
+    MatType v;
+
+    // The number of iterations.
+    double iteration;
+
+    // The cumulative product of decay coefficients
+    double cumBeta1;
+  };
+
  private:
   // The epsilon value used to initialise the squared gradient parameter.
   double epsilon;
@@ -148,20 +237,8 @@ class NadamUpdate
   // The second moment coefficient.
   double beta2;
 
-  // The exponential moving average of gradient values.
-  arma::mat m;
-
-  // The exponential moving average of squared gradient values.
-  arma::mat v;
-
   // The decay parameter for decay coefficients
   double scheduleDecay;
-
-  // The number of iterations.
-  double iteration;
-
-  // The cumulative product of decay coefficients
-  double cumBeta1;
 };
 
 } // namespace ens
@@ -50,89 +50,176 @@ class NadaMaxUpdate
       epsilon(epsilon),
       beta1(beta1),
       beta2(beta2),
-      scheduleDecay(scheduleDecay),
-      cumBeta1(1),
-      iteration(0)
+      scheduleDecay(scheduleDecay)
   {
     // Nothing to do.
   }
 
-  /**
-   * The Initialize() method is called by the optimizer before the start of the
-   * iteration update process.
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
-   */
-  void Initialize(const size_t rows, const size_t cols)
+  //! Get the value used to initialise the squared gradient parameter.
+  double Epsilon() const { return epsilon; }
+  //! Modify the value used to initialise the squared gradient parameter.
+  double& Epsilon() { return epsilon; }
+
+  //! Get the smoothing parameter.
+  double Beta1() const { return beta1; }
+  //! Modify the smoothing parameter.
+  double& Beta1() { return beta1; }
+
+  //! Get the second moment coefficient.
+  double Beta2() const { return beta2; }
+  //! Modify the second moment coefficient.
+  double& Beta2() { return beta2; }
+
+  //! Get the decay parameter for decay coefficients
+  double ScheduleDecay() const { return scheduleDecay; }
+  //! Modify the decay parameter for decay coefficients
+  double& ScheduleDecay() { return scheduleDecay; }
+
+  //! Get the number of bytes of the state (the first moment and the
+  //! exponentially weighted infinity norm) for an iterate of the given size.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
   {
-    m = arma::zeros<arma::mat>(rows, cols);
-    u = arma::zeros<arma::mat>(rows, cols);
+    return 2 * rows * cols * elemSize;
   }
 
   /**
-   * Update step for NadaMax.
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
    */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
+  template<typename MatType, typename GradType>
+  class Policy
   {
-    // Increment the iteration counter variable.
-    ++iteration;
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const NadaMaxUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        cumBeta1(1),
+        iteration(0)
+    {
+      m.zeros(rows, cols);
+      u.zeros(rows, cols);
+    }
 
-    // And update the iterate.
-    m *= beta1;
-    m += (1 - beta1) * gradient;
+    /**
+     * Update step for NadaMax.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      // Increment the iteration counter variable.
+      ++iteration;
 
-    u = arma::max(u * beta2, arma::abs(gradient));
+      double beta1T = parent.beta1 * (1 - (0.5 *
+          std::pow(0.96, iteration * parent.scheduleDecay)));
 
-    double beta1T = beta1 * (1 - (0.5 *
-        std::pow(0.96, iteration * scheduleDecay)));
+      double beta1T1 = parent.beta1 * (1 - (0.5 *
+          std::pow(0.96, (iteration + 1) * parent.scheduleDecay)));
 
-    double beta1T1 = beta1 * (1 - (0.5 *
-        std::pow(0.96, (iteration + 1) * scheduleDecay)));
+      cumBeta1 *= beta1T;
 
-    cumBeta1 *= beta1T;
+      const double biasCorrection1 = 1.0 - cumBeta1;
 
-    const double biasCorrection1 = 1.0 - cumBeta1;
+      const double biasCorrection2 = 1.0 - (cumBeta1 * beta1T1);
 
-    const double biasCorrection2 = 1.0 - (cumBeta1 * beta1T1);
+      const bool takeStep = (biasCorrection1 != 0) && (biasCorrection2 != 0);
+      Step(iterate, gradient,
+          takeStep ? stepSize * (1 - beta1T) / biasCorrection1 : 0.0,
+          takeStep ? stepSize * beta1T1 / biasCorrection2 : 0.0,
+          IsFusableUpdate<MatType, GradType>());
+    }
 
-    if ((biasCorrection1 != 0) && (biasCorrection2 != 0))
+    /**
+     * Save or load the state of the policy, to resume an optimization.
+     *
+     * @param ar Archive to save into or load from.
+     */
+    void Serialize(BinaryArchive& ar)
     {
-       iterate -= (stepSize * (((1 - beta1T) / biasCorrection1) * gradient
-           + (beta1T1 / biasCorrection2) * m)) / (u + epsilon);
+      ar(m);
+      ar(u);
+      ar(cumBeta1);
+      ar(iteration);
     }
-  }
 
-  //! Get the value used to initialise the squared gradient parameter.
-  double Epsilon() const { return epsilon; }
-  //! Modify the value used to initialise the squared gradient parameter.
-  double& Epsilon() { return epsilon; }
+   private:
+    //! Update the state and the iterate in a single loop.
+    void Step(MatType& iterate,
+              const GradType& gradient,
+              const double gradientScale,
+              const double momentScale,
+              std::true_type /* fusable */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType beta1 = parent.beta1;
+      const ElemType beta2 = parent.beta2;
+      const ElemType epsilon = parent.epsilon;
+      const ElemType gScale = gradientScale;
+      const ElemType mScale = momentScale;
+
+      ElemType* x = iterate.memptr();
+      ElemType* mem = m.memptr();
+      ElemType* uem = u.memptr();
+      const ElemType* g = gradient.memptr();
+
+      const size_t n = iterate.n_elem;
+      ENS_PRAGMA_OMP_SIMD
+      for (size_t i = 0; i < n; ++i)
+      {
+        mem[i] = beta1 * mem[i] + (1 - beta1) * g[i];
+        uem[i] = std::max(uem[i] * beta2, std::abs(g[i]));
+
+        x[i] -= (gScale * g[i] + mScale * mem[i]) / (uem[i] + epsilon);
+      }
+    }
 
-  //! Get the value of the cumulative product of decay coefficients
-  double CumBeta1() const { return cumBeta1; }
-  //! Modify the value of the cumulative product of decay coefficients
-  double& CumBeta1() { return cumBeta1; }
+    //! Update the state and the iterate with Armadillo expressions.
+    void Step(MatType& iterate,
+              const GradType& gradient,
+              const double gradientScale,
+              const double momentScale,
+              std::false_type /* fusable */)
+    {
+      m *= parent.beta1;
+      m += (1 - parent.beta1) * gradient;
 
-  //! Get the smoothing parameter.
-  double Beta1() const { return beta1; }
-  //! Modify the smoothing parameter.
-  double& Beta1() { return beta1; }
+      u = max(u * parent.beta2, abs(gradient));
 
-  //! Get the second moment coefficient.
-  double Beta2() const { return beta2; }
-  //! Modify the second moment coefficient.
-  double& Beta2() { return beta2; }
+      iterate -= (gradientScale * gradient + momentScale * m) /
+          (u + parent.epsilon);
+    }
 
-  //! Get the decay parameter for decay coefficients
-  double ScheduleDecay() const { return scheduleDecay; }
-  //! Modify the decay parameter for decay coefficients
-  double& ScheduleDecay() { return scheduleDecay; }
+    // Instantiated parent object.
+    const NadaMaxUpdate& parent;
+
+    // The exponential moving average of gradient values.
+    MatType m;
+
+    // The exponentially weighted infinity norm.
+    MatType u;
+
+    // The cumulative product of decay coefficients
+    double cumBeta1;
+
+    // The number of iterations.
+    double iteration;
+  };
 
  private:
   // The epsilon value used to initialise the squared gradient parameter.
@@ -144,20 +231,8 @@ class NadaMaxUpdate
   // The second moment coefficient.
   double beta2;
 
-  // The exponential moving average of gradient values.
-  arma::mat m;
-
-  // The exponentially weighted infinity norm.
-  arma::mat u;
-
   // The decay parameter for decay coefficients
   double scheduleDecay;
-
-  // The cumulative product of decay coefficients
-  double cumBeta1;
-
-  // The number of iterations.
-  double iteration;
 };
 
 } // namespace ens
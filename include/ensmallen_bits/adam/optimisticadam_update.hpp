@@ -51,71 +51,175 @@ class OptimisticAdamUpdate
                        const double beta2 = 0.999) :
     epsilon(epsilon),
     beta1(beta1),
-    beta2(beta2),
-    iteration(0)
+    beta2(beta2)
   {
     // Nothing to do.
   }
 
-  /**
-   * The Initialize method is called by SGD Optimizer method before the start of
-   * the iteration update process.
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
-   */
-  void Initialize(const size_t rows, const size_t cols)
+  //! Get the value used to initialize the squared gradient parameter.
+  double Epsilon() const { return epsilon; }
+  //! Modify the value used to initialize the squared gradient parameter.
+  double& Epsilon() { return epsilon; }
+
+  //! Get the smoothing parameter.
+  double Beta1() const { return beta1; }
+  //! Modify the smoothing parameter.
+  double& Beta1() { return beta1; }
+
+  //! Get the second moment coefficient.
+  double Beta2() const { return beta2; }
+  //! Modify the second moment coefficient.
+  double& Beta2() { return beta2; }
+
+  //! Get the number of bytes of the state (the two moments and the last
+  //! gradient) for an iterate of the given size.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
   {
-    m = arma::zeros<arma::mat>(rows, cols);
-    v = arma::zeros<arma::mat>(rows, cols);
-    g = arma::zeros<arma::mat>(rows, cols);
+    return 3 * rows * cols * elemSize;
   }
 
   /**
-   * Update step for OptimisticAdam.
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
    */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
+  template<typename MatType, typename GradType>
+  class Policy
   {
-    // Increment the iteration counter variable.
-    ++iteration;
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const OptimisticAdamUpdate& parent,
+           const size_t rows,
+           const size_t cols) :
+        parent(parent),
+        iteration(0)
+    {
+      m.zeros(rows, cols);
+      v.zeros(rows, cols);
+      g.zeros(rows, cols);
+    }
+
+    /**
+     * Update step for OptimisticAdam.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      // Increment the iteration counter variable.
+      ++iteration;
+
+      Step(iterate, gradient, stepSize,
+          1.0 - std::pow(parent.beta1, iteration),
+          1.0 - std::pow(parent.beta2, iteration),
+          IsFusableUpdate<MatType, GradType>());
+    }
+
+    /**
+     * Save or load the state of the policy, to resume an optimization.
+     *
+     * @param ar Archive to save into or load from.
+     */
+    void Serialize(BinaryArchive& ar)
+    {
+      ar(m);
+      ar(v);
+      ar(g);
+      ar(iteration);
+    }
+
+   private:
+    //! Update the state and the iterate in a single loop.
+    void Step(MatType& iterate,
+              const GradType& gradient,
+              const double stepSize,
+              const double biasCorrection1,
+              const double biasCorrection2,
+              std::true_type /* fusable */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType beta1 = parent.beta1;
+      const ElemType beta2 = parent.beta2;
+      const ElemType epsilon = parent.epsilon;
+      const ElemType step = stepSize;
+      const ElemType correction1 = biasCorrection1;
+      const ElemType correction2 = biasCorrection2;
+
+      ElemType* x = iterate.memptr();
+      ElemType* mem = m.memptr();
+      ElemType* vem = v.memptr();
+      ElemType* previous = g.memptr();
+      const ElemType* grad = gradient.memptr();
+
+      const size_t n = iterate.n_elem;
+      ENS_PRAGMA_OMP_SIMD
+      for (size_t i = 0; i < n; ++i)
+      {
+        mem[i] = beta1 * mem[i] + (1 - beta1) * grad[i];
+        vem[i] = beta2 * vem[i] + (1 - beta2) * (grad[i] * grad[i]);
+
+        const ElemType update = (mem[i] / correction1) /
+            (std::sqrt(vem[i] / correction2) + epsilon);
+
+        x[i] -= (2 * step * update - step * previous[i]);
+        previous[i] = update;
+      }
+    }
+
+    //! Update the state and the iterate with Armadillo expressions.
+    void Step(MatType& iterate,
+              const GradType& gradient,
+              const double stepSize,
+              const double biasCorrection1,
+              const double biasCorrection2,
+              std::false_type /* fusable */)
+    {
+      m *= parent.beta1;
+      m += (1 - parent.beta1) * gradient;
 
-    // And update the iterate.
-    m *= beta1;
-    m += (1 - beta1) * gradient;
+      v *= parent.beta2;
+      v += (1 - parent.beta2) * square(gradient);
 
-    v *= beta2;
-    v += (1 - beta2) * arma::square(gradient);
+      MatType mCorrected = m / biasCorrection1;
+      MatType vCorrected = v / biasCorrection2;
 
-    arma::mat mCorrected = m / (1.0 - std::pow(beta1, iteration));
-    arma::mat vCorrected = v / (1.0 - std::pow(beta2, iteration));
+      MatType update = mCorrected / (sqrt(vCorrected) + parent.epsilon);
 
-    arma::mat update = mCorrected / (arma::sqrt(vCorrected) + epsilon);
+      iterate -= (2 * stepSize * update - stepSize * g);
 
-    iterate -= (2 * stepSize * update - stepSize * g);
+      g = std::move(update);
+    }
 
-    g = std::move(update);
-  }
+    // Instantiated parent object.
+    const OptimisticAdamUpdate& parent;
 
-  //! Get the value used to initialize the squared gradient parameter.
-  double Epsilon() const { return epsilon; }
-  //! Modify the value used to initialize the squared gradient parameter.
-  double& Epsilon() { return epsilon; }
+    // The exponential moving average of gradient values.
+    MatType m;
 
-  //! Get the smoothing parameter.
-  double Beta1() const { return beta1; }
-  //! Modify the smoothing parameter.
-  double& Beta1() { return beta1; }
+    // The exponential moving average of squared gradient values.
+    MatType v;
 
-  //! Get the second moment coefficient.
-  double Beta2() const { return beta2; }
-  //! Modify the second moment coefficient.
-  double& Beta2() { return beta2; }
+    // The previous update.
+    MatType g;
+
+    // The number of iterations.
+    double iteration;
+  };
 
  private:
   // The epsilon value used to initialize the squared gradient parameter.
@@ -126,17 +230,6 @@ class OptimisticAdamUpdate
 
   // The second moment coefficient.
   double beta2;
-
-  // The exponential moving average of gradient values.
-  arma::mat m;
-
-  // The exponential moving average of squared gradient values.
-  arma::mat v;
-  // The previous update.
-  arma::mat g;
-
-  // The number of iterations.
-  double iteration;
 };
 
 } // namespace ens
@@ -0,0 +1,246 @@
+/**
+ * @file reduced_precision_adam_update.hpp
+ *
+ * Adam update that stores its moment estimates in reduced precision (float,
+ * bfloat16, half or 8-bit), to cut the memory used by the optimizer state.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_ADAM_REDUCED_PRECISION_ADAM_UPDATE_HPP
+#define ENSMALLEN_ADAM_REDUCED_PRECISION_ADAM_UPDATE_HPP
+
+#include <ensmallen_bits/utility/reduced_precision_state.hpp>
+
+namespace ens {
+
+/**
+ * The Adam update with the two moment estimates stored as the given
+ * StateType (Float32State, BFloat16State, Float16State or
+ * BlockQuantized8State).  The state is decoded to float one block at a time,
+ * updated in float, and encoded again, so only one block is ever held in full
+ * precision.  An optional weight decay gives the AdamW update.
+ *
+ * Instead of the second moment v itself, the policy stores its square root
+ * (the root mean square of the gradient), which has the same magnitude as the
+ * gradient.  This halves the dynamic range that the reduced precision format
+ * has to represent, so that, for instance, the squares of small gradients do
+ * not underflow in half precision.
+ *
+ * Only dense iterates are supported; sparse gradients are converted to dense
+ * matrices.
+ *
+ * @tparam StateType The type used to store each moment estimate.
+ */
+template<typename StateType = BFloat16State>
+class ReducedPrecisionAdamUpdate
+{
+ public:
+  /**
+   * Construct the reduced precision Adam update policy with the given
+   * parameters.
+   *
+   * @param epsilon The epsilon value used to initialise the squared gradient
+   *        parameter.
+   * @param beta1 The smoothing parameter.
+   * @param beta2 The second moment coefficient.
+   * @param weightDecay The rate at which the update decays the iterate (0 for
+   *        Adam; nonzero for AdamW).
+   */
+  ReducedPrecisionAdamUpdate(const double epsilon = 1e-8,
+                             const double beta1 = 0.9,
+                             const double beta2 = 0.999,
+                             const double weightDecay = 0.0) :
+    epsilon(epsilon),
+    beta1(beta1),
+    beta2(beta2),
+    weightDecay(weightDecay)
+  {
+    // Nothing to do.
+  }
+
+  //! Get the value used to initialise the squared gradient parameter.
+  double Epsilon() const { return epsilon; }
+  //! Modify the value used to initialise the squared gradient parameter.
+  double& Epsilon() { return epsilon; }
+
+  //! Get the smoothing parameter.
+  double Beta1() const { return beta1; }
+  //! Modify the smoothing parameter.
+  double& Beta1() { return beta1; }
+
+  //! Get the second moment coefficient.
+  double Beta2() const { return beta2; }
+  //! Modify the second moment coefficient.
+  double& Beta2() { return beta2; }
+
+  //! Get the weight decay rate.
+  double WeightDecay() const { return weightDecay; }
+  //! Modify the weight decay rate.
+  double& WeightDecay() { return weightDecay; }
+
+  //! Get the number of bytes of the state (the two encoded moments and
+  //! their decoding buffers) for an iterate of the given size; the element
+  //! size of the iterate does not matter.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t /* elemSize */ = sizeof(double)) const
+  {
+    return 2 * (StateType::BytesFor(rows * cols) +
+        StateType::BlockSize() * sizeof(float));
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const ReducedPrecisionAdamUpdate& parent,
+           const size_t rows,
+           const size_t cols) :
+        parent(parent),
+        mBlock(StateType::BlockSize()),
+        rmsBlock(StateType::BlockSize()),
+        iteration(0)
+    {
+      m.Zeros(rows * cols);
+      rms.Zeros(rows * cols);
+    }
+
+    /**
+     * Update step for Adam.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      // Increment the iteration counter variable.
+      ++iteration;
+
+      const double biasCorrection1 = 1.0 - std::pow(parent.beta1, iteration);
+      const double biasCorrection2 = 1.0 - std::pow(parent.beta2, iteration);
+
+      Step(iterate, gradient, stepSize * std::sqrt(biasCorrection2) /
+          biasCorrection1, IsFusableUpdate<MatType, GradType>());
+    }
+
+    //! Get the number of bytes used by the moment estimates.
+    size_t StateBytes() const { return m.Bytes() + rms.Bytes(); }
+
+   private:
+    //! Update with a dense gradient of the same type as the iterate.
+    void Step(MatType& iterate,
+              const GradType& gradient,
+              const double scaledStepSize,
+              std::true_type /* fusable */)
+    {
+      Step(iterate, gradient.memptr(), scaledStepSize);
+    }
+
+    //! Update with any other gradient, converted to a dense matrix.
+    void Step(MatType& iterate,
+              const GradType& gradient,
+              const double scaledStepSize,
+              std::false_type /* fusable */)
+    {
+      const arma::Mat<typename MatType::elem_type> denseGradient(gradient);
+      Step(iterate, denseGradient.memptr(), scaledStepSize);
+    }
+
+    //! Update the moments and the iterate, one block at a time.
+    void Step(MatType& iterate,
+              const typename MatType::elem_type* g,
+              const double scaledStepSize)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const float beta1 = parent.beta1;
+      const float beta2 = parent.beta2;
+      const float epsilon = parent.epsilon;
+      const ElemType step = scaledStepSize;
+      const ElemType decay = parent.weightDecay;
+
+      ElemType* x = iterate.memptr();
+      float* mb = mBlock.data();
+      float* rb = rmsBlock.data();
+
+      const size_t n = iterate.n_elem;
+      const size_t blockSize = StateType::BlockSize();
+      for (size_t begin = 0; begin < n; begin += blockSize)
+      {
+        const size_t count = std::min(blockSize, n - begin);
+        m.Decode(begin, count, mb);
+        rms.Decode(begin, count, rb);
+
+        for (size_t j = 0; j < count; ++j)
+        {
+          const float gj = g[begin + j];
+          mb[j] = beta1 * mb[j] + (1 - beta1) * gj;
+          rb[j] = std::sqrt(beta2 * (rb[j] * rb[j]) + (1 - beta2) * (gj * gj));
+
+          const ElemType xj = x[begin + j] -
+              step * ElemType(mb[j] / (rb[j] + epsilon));
+          x[begin + j] = xj - decay * xj;
+        }
+
+        m.Encode(begin, count, mb);
+        rms.Encode(begin, count, rb);
+      }
+    }
+
+    // Instantiated parent object.
+    const ReducedPrecisionAdamUpdate& parent;
+
+    // The exponential moving average of gradient values.
+    StateType m;
+
+    // The square root of the exponential moving average of squared gradient
+    // values.
+    StateType rms;
+
+    // The decoded block of m.
+    std::vector<float> mBlock;
+
+    // The decoded block of rms.
+    std::vector<float> rmsBlock;
+
+    // The number of iterations.
+    double iteration;
+  };
+
+ private:
+  // The epsilon value used to initialise the squared gradient parameter.
+  double epsilon;
+
+  // The smoothing parameter.
+  double beta1;
+
+  // The second moment coefficient.
+  double beta2;
+
+  // The weight decay rate.
+  double weightDecay;
+};
+
+} // namespace ens
+
+#endif
@@ -94,12 +94,21 @@ class AdamRType
    * objective value is returned.
    *
    * @tparam DecomposableFunctionType Type of the function to optimize.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to optimize.
    * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
    * @return Objective value of the final point.
    */
-  template<typename DecomposableFunctionType>
-  double Optimize(DecomposableFunctionType& function, arma::mat& iterate);
+  template<typename DecomposableFunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(DecomposableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks);
 
   //! Get the minimum step size.
   double StepSizeMin() const { return optimizer.DecayPolicy().StepSizeMin(); }
@@ -173,6 +182,21 @@ class AdamRType
   //! Modify the step size decay policy.
   DecayPolicyType& DecayPolicy() { return optimizer.DecayPolicy(); }
 
+  /**
+   * Estimate the number of bytes Optimize() allocates for an iterate of the
+   * given size (see SGD::EstimateMemory()).
+   *
+   * @param rows Number of rows of the iterate.
+   * @param cols Number of columns of the iterate.
+   * @param elemSize Size of an element of the iterate.
+   */
+  size_t EstimateMemory(const size_t rows,
+                        const size_t cols = 1,
+                        const size_t elemSize = sizeof(double)) const
+  {
+    return optimizer.EstimateMemory(rows, cols, elemSize);
+  }
+
  private:
   size_t batchSize;
   //! The SGD object with update policy and decay policy.
@@ -47,10 +47,15 @@ AdamRType<UpdateRule, DecayPolicyType>::AdamRType(
 { /* Nothing to do. */ }
 
 template<typename UpdatePolicyType, typename DecayPolicyType>
-template<typename DecomposableFunctionType>
-double AdamRType<UpdatePolicyType, DecayPolicyType>::Optimize(
+template<typename DecomposableFunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename MatType::elem_type
+AdamRType<UpdatePolicyType, DecayPolicyType>::Optimize(
     DecomposableFunctionType& function,
-    arma::mat& iterate)
+    MatType& iterate,
+    CallbackTypes&&... callbacks)
 {
   // If a user changed the step size he hasn't update the step size of the
   // cyclical decay instantiation, so we have to do it here.
@@ -69,7 +74,9 @@ double AdamRType<UpdatePolicyType, DecayPolicyType>::Optimize(
     batchSize = optimizer.BatchSize();
   }
 
-  return optimizer.Optimize(function, iterate);
+  return optimizer.template Optimize<DecomposableFunctionType, MatType,
+      GradType, CallbackTypes...>(function, iterate,
+      std::forward<CallbackTypes>(callbacks)...);
 }
 
 } // namespace ens
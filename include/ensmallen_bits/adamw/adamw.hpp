@@ -89,14 +89,25 @@ class AdamW
    * objective value is returned.
    *
    * @tparam DecomposableFunctionType Type of the function to optimize.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to optimize.
    * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
    * @return Objective value of the final point.
    */
-  template<typename DecomposableFunctionType>
-  double Optimize(DecomposableFunctionType& function, arma::mat& iterate)
+  template<typename DecomposableFunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(DecomposableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks)
   {
-    return optimizer.Optimize(function, iterate);
+    return optimizer.template Optimize<DecomposableFunctionType, MatType,
+        GradType, CallbackTypes...>(function, iterate,
+        std::forward<CallbackTypes>(callbacks)...);
   }
 
   //! Get the step size.
@@ -151,6 +162,21 @@ class AdamW
   //! Modify the weight decay parameter.
   double& WeightDecay() { return optimizer.UpdatePolicy().WeightDecay(); }
 
+  /**
+   * Estimate the number of bytes Optimize() allocates for an iterate of the
+   * given size (see SGD::EstimateMemory()).
+   *
+   * @param rows Number of rows of the iterate.
+   * @param cols Number of columns of the iterate.
+   * @param elemSize Size of an element of the iterate.
+   */
+  size_t EstimateMemory(const size_t rows,
+                        const size_t cols = 1,
+                        const size_t elemSize = sizeof(double)) const
+  {
+    return optimizer.EstimateMemory(rows, cols, elemSize);
+  }
+
  private:
   //! The Stochastic Gradient Descent object with AdamW policy.
   SGD<AdamWUpdate> optimizer;
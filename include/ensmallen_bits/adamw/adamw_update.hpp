@@ -60,37 +60,9 @@ class AdamWUpdate
               const double beta2 = 0.999,
               const double weightDecay = 0.0005) :
     update(epsilon, beta1, beta2),
-    weightDecay(weightDecay),
-    iteration(0)
+    weightDecay(weightDecay)
   {/* Nothing to do.*/ }
 
-  /**
-   * The Initialize method is called by SGD Optimizer method before the start of
-   * the iteration update process.
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
-   */
-  void Initialize(const size_t rows, const size_t cols)
-  {
-    update.Initialize(rows, cols);
-  }
-
-  /**
-   * Update step for AdamW.
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
-   */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
-  {
-    update.Update(iterate, stepSize, gradient);
-    iterate -= weightDecay * iterate;
-  }
-
   //! Get the value used to initialise the squared gradient parameter.
   double Epsilon() const { return update.Epsilon(); }
   //! Modify the value used to initialise the squared gradient parameter.
@@ -111,13 +83,68 @@ class AdamWUpdate
   //! Modify weight decay parameter.
   double& WeightDecay() { return weightDecay; }
 
+  //! Get the number of bytes of the state (that of Adam) for an iterate of
+  //! the given size.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
+  {
+    return update.EstimateStateBytes(rows, cols, elemSize);
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const AdamWUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        adamUpdate(parent.update, rows, cols)
+    {
+      // Nothing to do.
+    }
+
+    /**
+     * Update step for AdamW.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      // The decay is applied in the same pass over memory as the Adam step.
+      adamUpdate.Update(iterate, stepSize, gradient, parent.weightDecay);
+    }
+
+   private:
+    // Instantiated parent object.
+    const AdamWUpdate& parent;
+
+    // The instantiated Adam update policy.
+    AdamUpdate::Policy<MatType, GradType> adamUpdate;
+  };
+
  private:
-  // The number of iterations.
-  double iteration;
-  // The weight decay rate.
-  double weightDecay;
   // The AdamWUpdate optimser.
   AdamUpdate update;
+  // The weight decay rate.
+  double weightDecay;
 };
 
 } // namespace ens
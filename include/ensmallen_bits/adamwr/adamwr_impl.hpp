@@ -45,10 +45,14 @@ inline AdamWR::AdamWR(
               resetPolicy)
 { /* Nothing to do. */ }
 
-template<typename DecomposableFunctionType>
-double AdamWR::Optimize(
+template<typename DecomposableFunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename MatType::elem_type AdamWR::Optimize(
     DecomposableFunctionType& function,
-    arma::mat& iterate)
+    MatType& iterate,
+    CallbackTypes&&... callbacks)
 {
   // If a user changed the step size he hasn't update the step size of the
   // cyclical decay instantiation, so we have to do it here.
@@ -67,7 +71,9 @@ double AdamWR::Optimize(
     batchSize = optimizer.BatchSize();
   }
 
-  return optimizer.Optimize(function, iterate);
+  return optimizer.template Optimize<DecomposableFunctionType, MatType,
+      GradType, CallbackTypes...>(function, iterate,
+      std::forward<CallbackTypes>(callbacks)...);
 }
 
 } // namespace ens
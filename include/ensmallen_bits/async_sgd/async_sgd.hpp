@@ -0,0 +1,168 @@
+/**
+ * @file async_sgd.hpp
+ *
+ * Asynchronous SGD in the style of a parameter server: workers compute
+ * gradients on stale copies of the iterate, and push their sparse updates
+ * into a sharded parameter store.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_ASYNC_SGD_ASYNC_SGD_HPP
+#define ENSMALLEN_ASYNC_SGD_ASYNC_SGD_HPP
+
+#include <mutex>
+
+#include <ensmallen_bits/parallel_sgd/decay_policies/constant_step.hpp>
+#include <ensmallen_bits/parallel_sgd/decay_policies/exponential_backoff.hpp>
+
+namespace ens {
+
+/**
+ * AsyncSGD runs asynchronous SGD with the workers (OpenMP threads) of a
+ * parameter server.  The iterate is the parameter store; it is split into
+ * shards of consecutive coordinates, each with its own lock and version.  Each
+ * worker keeps its own copy of the iterate, and repeatedly
+ *
+ *  - claims the next batch of functions (so fast workers simply process more
+ *    batches than slow ones, and nobody waits for anybody),
+ *  - computes the sparse gradient of the batch on its copy, and
+ *  - pushes the update into the store, locking each shard that the gradient
+ *    touches once.
+ *
+ * A worker only pulls the store into its copy when the copy is stale: when
+ * more than maxStaleness updates have been pushed (by all the workers) since
+ * its last pull.  A pull only copies the shards whose version changed.  So
+ * each gradient is computed on an iterate that misses at most maxStaleness
+ * updates when the computation starts; with maxStaleness = 0, each gradient
+ * starts from the latest iterate.
+ *
+ * One iteration is a full pass over the functions, after which the objective
+ * is computed to check for convergence.
+ *
+ * For more information on parameter servers and bounded staleness, see the
+ * following.
+ *
+ * @code
+ * @inproceedings{ho2013more,
+ *   title     = {More Effective Distributed {ML} via a Stale Synchronous
+ *                Parallel Parameter Server},
+ *   author    = {Ho, Qirong and Cipar, James and Cui, Henggang and Lee,
+ *                Seunghak and Kim, Jin Kyu and Gibbons, Phillip B. and
+ *                Gibson, Garth A. and Ganger, Greg and Xing, Eric P.},
+ *   booktitle = {Advances in Neural Information Processing Systems},
+ *   pages     = {1223--1231},
+ *   year      = {2013}
+ * }
+ * @endcode
+ *
+ * AsyncSGD can optimize sparse differentiable separable functions, as
+ * ParallelSGD does.
+ *
+ * @tparam DecayPolicyType Step size update policy used to update the step
+ *     size after each iteration (see ens::ConstantStep).
+ */
+template<typename DecayPolicyType = ConstantStep>
+class AsyncSGD
+{
+ public:
+  /**
+   * Construct the AsyncSGD optimizer with the given parameters.
+   *
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *     limit); one iteration is a pass over all the functions.
+   * @param batchSize Number of consecutive functions in each gradient.
+   * @param shards Number of shards of the parameter store.
+   * @param maxStaleness Maximum number of updates a worker's copy may miss
+   *     before the worker pulls the store again.
+   * @param tolerance Maximum absolute tolerance to terminate the algorithm.
+   * @param shuffle If true, the batches are visited in a random order.
+   * @param decayPolicy The step size update policy to use.
+   */
+  AsyncSGD(const size_t maxIterations = 100,
+           const size_t batchSize = 1,
+           const size_t shards = 16,
+           const size_t maxStaleness = 16,
+           const double tolerance = 1e-5,
+           const bool shuffle = true,
+           const DecayPolicyType& decayPolicy = DecayPolicyType());
+
+  /**
+   * Optimize the given function.  The given starting point will be modified
+   * to store the finishing point of the algorithm, and the value of the
+   * objective at the final point is returned.
+   *
+   * @tparam SparseFunctionType Type of function to be optimized.
+   * @param function Function to be optimized (minimized).
+   * @param iterate Starting point (will be modified).
+   * @return Objective value at the final point.
+   */
+  template<typename SparseFunctionType>
+  double Optimize(SparseFunctionType& function, arma::mat& iterate);
+
+  //! Get the maximum number of iterations (0 indicates no limits).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limits).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the number of functions in each gradient.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the number of functions in each gradient.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the number of shards of the parameter store.
+  size_t Shards() const { return shards; }
+  //! Modify the number of shards of the parameter store.
+  size_t& Shards() { return shards; }
+
+  //! Get the maximum number of updates a copy may miss.
+  size_t MaxStaleness() const { return maxStaleness; }
+  //! Modify the maximum number of updates a copy may miss.
+  size_t& MaxStaleness() { return maxStaleness; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the batches are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the batches are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+  //! Get the step size decay policy.
+  const DecayPolicyType& DecayPolicy() const { return decayPolicy; }
+  //! Modify the step size decay policy.
+  DecayPolicyType& DecayPolicy() { return decayPolicy; }
+
+ private:
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The number of functions in each gradient.
+  size_t batchSize;
+
+  //! The number of shards of the parameter store.
+  size_t shards;
+
+  //! The maximum number of updates a copy may miss.
+  size_t maxStaleness;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the batches are shuffled.
+  bool shuffle;
+
+  //! The step size decay policy.
+  DecayPolicyType decayPolicy;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "async_sgd_impl.hpp"
+
+#endif
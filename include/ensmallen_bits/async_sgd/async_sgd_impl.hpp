@@ -0,0 +1,210 @@
+/**
+ * @file async_sgd_impl.hpp
+ *
+ * Implementation of asynchronous parameter-server SGD.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_ASYNC_SGD_ASYNC_SGD_IMPL_HPP
+#define ENSMALLEN_ASYNC_SGD_ASYNC_SGD_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "async_sgd.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+template<typename DecayPolicyType>
+AsyncSGD<DecayPolicyType>::AsyncSGD(const size_t maxIterations,
+                                    const size_t batchSize,
+                                    const size_t shards,
+                                    const size_t maxStaleness,
+                                    const double tolerance,
+                                    const bool shuffle,
+                                    const DecayPolicyType& decayPolicy) :
+    maxIterations(maxIterations),
+    batchSize(batchSize),
+    shards(shards),
+    maxStaleness(maxStaleness),
+    tolerance(tolerance),
+    shuffle(shuffle),
+    decayPolicy(decayPolicy)
+{ /* Nothing to do. */ }
+
+template<typename DecayPolicyType>
+template<typename SparseFunctionType>
+double AsyncSGD<DecayPolicyType>::Optimize(SparseFunctionType& function,
+                                           arma::mat& iterate)
+{
+  // Check that we have all the functions that we need.
+  traits::CheckSparseFunctionTypeAPI<SparseFunctionType>();
+
+  double overallObjective = DBL_MAX;
+  double lastObjective;
+
+  // The functions are visited in batches of batchSize consecutive functions;
+  // this is the order in which the batches will be visited.
+  const size_t numFunctions = function.NumFunctions();
+  const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+  arma::Col<size_t> visitationOrder = arma::linspace<arma::Col<size_t>>(0,
+      (numBatches - 1), numBatches);
+
+  size_t numWorkers = 1;
+  #ifdef ENS_USE_OPENMP
+    numWorkers = omp_get_max_threads();
+  #endif
+
+  // The parameter store is the iterate, split into shards of consecutive
+  // coordinates.  The version of a shard is incremented by every update to it,
+  // and is only accessed with the lock of the shard.
+  const size_t numShards = std::max<size_t>(1, std::min(shards,
+      size_t(iterate.n_elem)));
+  const size_t shardSize = (iterate.n_elem + numShards - 1) / numShards;
+  std::vector<std::mutex> locks(numShards);
+  std::vector<size_t> versions(numShards, 1);
+
+  // The number of updates pushed so far, by all the workers.
+  std::atomic<size_t> pushes(0);
+
+  // Each worker has its own copy of the iterate, with the versions of the
+  // shards it was copied from and the number of updates pushed at that time.
+  std::vector<arma::mat> copies(numWorkers,
+      arma::mat(iterate.n_rows, iterate.n_cols));
+  std::vector<std::vector<size_t>> copyVersions(numWorkers,
+      std::vector<size_t>(numShards, 0));
+  std::vector<size_t> pulledAt(numWorkers, 0);
+  std::vector<arma::sp_mat> gradients(numWorkers);
+
+  // Copy the shards of the store that changed since the last pull into the
+  // copy of the given worker.
+  auto pull = [&](const size_t worker)
+  {
+    pulledAt[worker] = pushes.load();
+    for (size_t s = 0; s < numShards; ++s)
+    {
+      std::lock_guard<std::mutex> lock(locks[s]);
+      if (versions[s] == copyVersions[worker][s])
+        continue;
+
+      const size_t begin = s * shardSize;
+      const size_t end = std::min(begin + shardSize, size_t(iterate.n_elem));
+      std::copy(iterate.memptr() + begin, iterate.memptr() + end,
+          copies[worker].memptr() + begin);
+      copyVersions[worker][s] = versions[s];
+    }
+  };
+
+  // Iterate till the objective is within tolerance or the maximum number of
+  // allowed iterations is reached.  If maxIterations is 0, this will iterate
+  // till convergence.
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+  for (size_t i = 1; i <= actualMaxIterations; ++i)
+  {
+    // Calculate the overall objective.
+    lastObjective = overallObjective;
+
+    overallObjective = function.Evaluate(iterate);
+
+    // Output current objective function.
+    Info << "AsyncSGD: iteration " << i << ", objective " << overallObjective
+        << ".\n";
+
+    if (std::isnan(overallObjective) || std::isinf(overallObjective))
+    {
+      Warn << "AsyncSGD: converged to " << overallObjective << "; "
+          << "terminating with failure.  Try a smaller step size?"
+          << std::endl;
+      return overallObjective;
+    }
+
+    if (std::abs(lastObjective - overallObjective) < tolerance)
+    {
+      Info << "AsyncSGD: minimized within tolerance " << tolerance << "; "
+          << "terminating optimization." << std::endl;
+      return overallObjective;
+    }
+
+    // Get the stepsize for this iteration.
+    const double stepSize = decayPolicy.StepSize(i);
+
+    // Shuffle for uniform sampling of functions by each worker.
+    if (shuffle)
+      visitationOrder = arma::shuffle(visitationOrder);
+
+    // The next position in visitationOrder that has not been claimed by any
+    // worker.  All batches are visited once per iteration.
+    std::atomic<size_t> nextBatch(0);
+
+    ENS_PRAGMA_OMP_PARALLEL
+    {
+      size_t worker = 0;
+      #ifdef ENS_USE_OPENMP
+        worker = omp_get_thread_num();
+      #endif
+      arma::mat& copy = copies[worker];
+      arma::sp_mat& gradient = gradients[worker];
+
+      // Every worker starts the iteration from the current store.
+      pull(worker);
+
+      for (size_t j = nextBatch++; j < numBatches; j = nextBatch++)
+      {
+        // Only pull again if the copy misses too many updates.
+        if (pushes.load() - pulledAt[worker] > maxStaleness)
+          pull(worker);
+
+        // The last batch may be smaller.
+        const size_t begin = visitationOrder[j] * batchSize;
+        const size_t effectiveBatchSize = std::min(batchSize,
+            numFunctions - begin);
+        function.Gradient(copy, begin, gradient, effectiveBatchSize);
+
+        // Push the update into the store.  The nonzeros are visited by
+        // increasing index, so each shard is locked only once.  The worker
+        // also sees its own update right away.
+        std::unique_lock<std::mutex> lock;
+        size_t shard = numShards;
+        for (size_t c = 0; c < gradient.n_cols; ++c)
+        {
+          for (arma::sp_mat::const_iterator cur = gradient.begin_col(c);
+              cur != gradient.end_col(c); ++cur)
+          {
+            const size_t index = cur.row() + c * iterate.n_rows;
+            if (index / shardSize != shard)
+            {
+              if (lock.owns_lock())
+                lock.unlock();
+              shard = index / shardSize;
+              lock = std::unique_lock<std::mutex>(locks[shard]);
+              ++versions[shard];
+            }
+
+            const double update = stepSize * (*cur);
+            iterate[index] -= update;
+            copy[index] -= update;
+          }
+        }
+        if (lock.owns_lock())
+          lock.unlock();
+
+        ++pushes;
+      }
+    }
+  }
+
+  Info << "AsyncSGD: maximum iterations (" << maxIterations << ") reached; "
+      << "terminating optimization." << std::endl;
+
+  // Calculate the final objective.
+  overallObjective = function.Evaluate(iterate);
+  return overallObjective;
+}
+
+} // namespace ens
+
+#endif
@@ -3,8 +3,8 @@
  * @author Ryan Curtin
  *
  * Definition of AugLagrangian class, which implements the Augmented Lagrangian
- * optimization method (also called the 'method of multipliers'.  This class
- * uses the L-BFGS optimizer.
+ * optimization method (also called the 'method of multipliers'.  By default
+ * this class uses the L-BFGS optimizer for the subproblems.
  *
  * ensmallen is free software; you may redistribute it and/or modify it under
  * the terms of the 3-clause BSD license.  You should have received a copy of
@@ -29,12 +29,41 @@ namespace ens {
  * AugLagrangian can optimize constrained functions.  For more details, see the
  * documentation on function types included with this distribution or on the
  * ensmallen website.
+ *
+ * Each subproblem (the minimization of the augmented Lagrangian for fixed
+ * Lagrange multipliers and penalty) is solved with the inner optimizer, which
+ * can be any optimizer for differentiable functions.  The subproblems of
+ * consecutive outer iterations differ only slightly when just the Lagrange
+ * multipliers were updated, so if warmStart is true, the state of the inner
+ * optimizer is kept from one subproblem to the next until sigma is increased.
+ * This requires an inner optimizer with a ResetHistory() modifier (like
+ * L_BFGS) or a ResetPolicy() modifier; for other inner optimizers warmStart
+ * has no effect.
+ *
+ * If adaptive is true, the subproblems are solved inexactly, in the style of
+ * LANCELOT and ALGENCAN: the gradient norm tolerance of each subproblem is
+ *
+ *   max(tol, InnerToleranceFactor() * ||c(x)||),
+ *
+ * for the current constraint violation ||c(x)|| (and never increases), where
+ * tol is the tolerance the inner optimizer was configured with.  So the early
+ * subproblems, whose solution is far from feasible anyway, are solved
+ * cheaply, and only the last ones are solved to full accuracy.  sigma is
+ * still only increased when the violation stalls (decreases by less than the
+ * penalty threshold factor).  The optimization terminates when the violation
+ * is below ConstraintTolerance() after a subproblem solved to full accuracy,
+ * instead of waiting for sigma to grow large.  The tolerance is set through a
+ * MinGradientNorm() modifier (as L_BFGS has); for other inner optimizers, only
+ * the termination test changes.
+ *
+ * @tparam InnerOptimizerType The optimizer used for the subproblems.
  */
-class AugLagrangian
+template<typename InnerOptimizerType = L_BFGS>
+class AugLagrangianType
 {
  public:
   /**
-   * Initialize the Augmented Lagrangian with the default L-BFGS optimizer.
+   * Initialize the Augmented Lagrangian with the given inner optimizer.
    * @param penaltyThresholdFactor When the penalty threshold is updated set
    *    the penalty threshold to the penalty multplied by this factor. The
    *    default value of 0.25 is is taken from Burer and Monteiro (2002).
@@ -42,11 +71,24 @@ class AugLagrangian
    *    value. The default value of 10 is taken from Burer and Monteiro (2002).
    * @param maxIterations Maximum number of iterations of the Augmented
    *     Lagrangian algorithm.  0 indicates no maximum.
+   * @param innerOptimizer The optimizer used for the subproblems.
+   * @param warmStart If true, keep the state of the inner optimizer between
+   *     subproblems with the same penalty.
+   * @param parallelConstraints If true, evaluate the constraints in parallel
+   *     (if OpenMP is enabled); the constraints of the function must then be
+   *     safe to evaluate from multiple threads at once.
+   * @param adaptive If true, tie the tolerance of the subproblems to the
+   *     constraint violation, and terminate when the constraints are
+   *     satisfied to ConstraintTolerance().
    */
-  AugLagrangian(const size_t maxIterations = 1000,
-                const double penaltyThresholdFactor = 0.25,
-                const double sigmaUpdateFactor = 10.0,
-                const L_BFGS& lbfgs = L_BFGS());
+  AugLagrangianType(const size_t maxIterations = 1000,
+                    const double penaltyThresholdFactor = 0.25,
+                    const double sigmaUpdateFactor = 10.0,
+                    const InnerOptimizerType& innerOptimizer =
+                        InnerOptimizerType(),
+                    const bool warmStart = false,
+                    const bool parallelConstraints = false,
+                    const bool adaptive = false);
 
   /**
    * Optimize the function.  The value '1' is used for the initial value of each
@@ -81,10 +123,17 @@ class AugLagrangian
                 const arma::vec& initLambda,
                 const double initSigma);
 
-  //! Get the L-BFGS object used for the actual optimization.
-  const L_BFGS& LBFGS() const { return lbfgs; }
-  //! Modify the L-BFGS object used for the actual optimization.
-  L_BFGS& LBFGS() { return lbfgs; }
+  //! Get the optimizer used for the subproblems.
+  const InnerOptimizerType& InnerOptimizer() const { return innerOptimizer; }
+  //! Modify the optimizer used for the subproblems.
+  InnerOptimizerType& InnerOptimizer() { return innerOptimizer; }
+
+  //! Get the L-BFGS object used for the actual optimization (the same as
+  //! InnerOptimizer()).
+  const InnerOptimizerType& LBFGS() const { return innerOptimizer; }
+  //! Modify the L-BFGS object used for the actual optimization (the same as
+  //! InnerOptimizer()).
+  InnerOptimizerType& LBFGS() { return innerOptimizer; }
 
   //! Get the Lagrange multipliers.
   const arma::vec& Lambda() const { return lambda; }
@@ -111,6 +160,34 @@ class AugLagrangian
   //! Modify the sigma update factor
   double& SigmaUpdateFactor() { return sigmaUpdateFactor; }
 
+  //! Get whether the inner optimizer is warm-started.
+  bool WarmStart() const { return warmStart; }
+  //! Modify whether the inner optimizer is warm-started.
+  bool& WarmStart() { return warmStart; }
+
+  //! Get whether the constraints are evaluated in parallel.
+  bool ParallelConstraints() const { return parallelConstraints; }
+  //! Modify whether the constraints are evaluated in parallel.
+  bool& ParallelConstraints() { return parallelConstraints; }
+
+  //! Get whether the subproblem tolerances are adaptive.
+  bool Adaptive() const { return adaptive; }
+  //! Modify whether the subproblem tolerances are adaptive.
+  bool& Adaptive() { return adaptive; }
+
+  //! Get the factor of the constraint violation that gives the subproblem
+  //! tolerance (if Adaptive()).
+  double InnerToleranceFactor() const { return innerToleranceFactor; }
+  //! Modify the factor of the constraint violation that gives the subproblem
+  //! tolerance (if Adaptive()).
+  double& InnerToleranceFactor() { return innerToleranceFactor; }
+
+  //! Get the constraint violation ||c(x)|| to terminate at (if Adaptive()).
+  double ConstraintTolerance() const { return constraintTolerance; }
+  //! Modify the constraint violation ||c(x)|| to terminate at (if
+  //! Adaptive()).
+  double& ConstraintTolerance() { return constraintTolerance; }
+
  private:
   //! Maximum number of iterations.
   size_t maxIterations;
@@ -121,8 +198,24 @@ class AugLagrangian
   //! Parameter for updating sigma
   double sigmaUpdateFactor;
 
-  //! The L-BFGS optimizer that we will use.
-  L_BFGS lbfgs;
+  //! The optimizer used for the subproblems.
+  InnerOptimizerType innerOptimizer;
+
+  //! Whether the inner optimizer is warm-started.
+  bool warmStart;
+
+  //! Whether the constraints are evaluated in parallel.
+  bool parallelConstraints;
+
+  //! Whether the subproblem tolerances are adaptive.
+  bool adaptive;
+
+  //! The factor of the constraint violation that gives the subproblem
+  //! tolerance.
+  double innerToleranceFactor;
+
+  //! The constraint violation to terminate at.
+  double constraintTolerance;
 
   //! Lagrange multipliers.
   arma::vec lambda;
@@ -138,6 +231,13 @@ class AugLagrangian
                 arma::mat& coordinates);
 };
 
+// Convenience typedefs.
+
+/**
+ * The Augmented Lagrangian method with L-BFGS for the subproblems.
+ */
+using AugLagrangian = AugLagrangianType<L_BFGS>;
+
 } // namespace ens
 
 #include "aug_lagrangian_impl.hpp"
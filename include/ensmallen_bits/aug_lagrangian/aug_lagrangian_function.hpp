@@ -29,6 +29,12 @@ namespace ens {
  * of the methods (unfortunately, C++ specialization rules mean you have to
  * re-implement everything).
  *
+ * The default implementation evaluates each constraint once per call, and if
+ * ParallelConstraints() is set (and OpenMP is enabled), the constraints are
+ * split between threads, each accumulating its own part of the objective and
+ * the gradient.  EvaluateConstraint() and GradientConstraint() of the
+ * LagrangianFunction must then be safe to call from multiple threads at once.
+ *
  * @tparam LagrangianFunction Lagrangian function to be used.
  */
 template<typename LagrangianFunction>
@@ -73,6 +79,19 @@ class AugLagrangianFunction
    */
   void Gradient(const arma::mat& coordinates, arma::mat& gradient) const;
 
+  /**
+   * Evaluate the objective function and the gradient of the Augmented
+   * Lagrangian function.  The value of each constraint is computed once for
+   * both.
+   *
+   * @param coordinates Coordinates to evaluate the function and the gradient
+   *     at.
+   * @param gradient Matrix to store gradient into.
+   * @return Objective function.
+   */
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              arma::mat& gradient) const;
+
   /**
    * Get the initial point of the optimization (supplied by the
    * LagrangianFunction).
@@ -96,7 +115,37 @@ class AugLagrangianFunction
   //! Modify the Lagrangian function.
   LagrangianFunction& Function() { return function; }
 
+  //! Get whether the constraints are evaluated in parallel.
+  bool ParallelConstraints() const { return parallelConstraints; }
+  //! Modify whether the constraints are evaluated in parallel.
+  bool& ParallelConstraints() { return parallelConstraints; }
+
  private:
+  /**
+   * Sum the Lagrangian and penalty terms of all the constraints, and add their
+   * gradient to the given gradient (if it is not NULL).
+   *
+   * @param coordinates Coordinates to evaluate the constraints at.
+   * @param gradient Gradient to add the gradient of the terms to, or NULL.
+   * @return The sum of the terms.
+   */
+  double ConstraintTerms(const arma::mat& coordinates,
+                         arma::mat* gradient) const;
+
+  /**
+   * Return the Lagrangian and penalty term of one constraint, and add its
+   * gradient to the given gradient (if it is not NULL).
+   *
+   * @param i Index of the constraint.
+   * @param coordinates Coordinates to evaluate the constraint at.
+   * @param gradient Gradient to add the gradient of the term to, or NULL.
+   * @param constraintGradient Workspace for the gradient of the constraint.
+   */
+  double ConstraintTerm(const size_t i,
+                        const arma::mat& coordinates,
+                        arma::mat* gradient,
+                        arma::mat& constraintGradient) const;
+
   //! Instantiation of the function to be optimized.
   LagrangianFunction& function;
 
@@ -104,6 +153,8 @@ class AugLagrangianFunction
   arma::vec lambda;
   //! The penalty parameter.
   double sigma;
+  //! Whether the constraints are evaluated in parallel.
+  bool parallelConstraints;
 };
 
 } // namespace ens
@@ -25,7 +25,8 @@ AugLagrangianFunction<LagrangianFunction>::AugLagrangianFunction(
     LagrangianFunction& function) :
     function(function),
     lambda(function.NumConstraints()),
-    sigma(10)
+    sigma(10),
+    parallelConstraints(false)
 {
   // Initialize lambda vector to all zeroes.
   lambda.zeros();
@@ -39,7 +40,8 @@ AugLagrangianFunction<LagrangianFunction>::AugLagrangianFunction(
     const double sigma) :
     function(function),
     lambda(lambda),
-    sigma(sigma)
+    sigma(sigma),
+    parallelConstraints(false)
 {
   // Nothing else to do.
 }
@@ -51,20 +53,7 @@ double AugLagrangianFunction<LagrangianFunction>::Evaluate(
 {
   // The augmented Lagrangian is evaluated as
   //    f(x) + {-lambda_i * c_i(x) + (sigma / 2) c_i(x)^2} for all constraints
-
-  // First get the function's objective value.
-  double objective = function.Evaluate(coordinates);
-
-  // Now loop for each constraint.
-  for (size_t i = 0; i < function.NumConstraints(); ++i)
-  {
-    double constraint = function.EvaluateConstraint(i, coordinates);
-
-    objective += (-lambda[i] * constraint) +
-        sigma * std::pow(constraint, 2) / 2;
-  }
-
-  return objective;
+  return function.Evaluate(coordinates) + ConstraintTerms(coordinates, NULL);
 }
 
 // Evaluate the gradient of the AugLagrangianFunction at the given coordinates.
@@ -77,18 +66,87 @@ void AugLagrangianFunction<LagrangianFunction>::Gradient(
   // f'(x) + {(-lambda_i + sigma * c_i(x)) * c'_i(x)} for all constraints
   gradient.zeros();
   function.Gradient(coordinates, gradient);
+  ConstraintTerms(coordinates, &gradient);
+}
+
+// Evaluate the AugLagrangianFunction and its gradient at the given
+// coordinates.
+template<typename LagrangianFunction>
+double AugLagrangianFunction<LagrangianFunction>::EvaluateWithGradient(
+    const arma::mat& coordinates,
+    arma::mat& gradient) const
+{
+  gradient.zeros();
+  function.Gradient(coordinates, gradient);
+  return function.Evaluate(coordinates) +
+      ConstraintTerms(coordinates, &gradient);
+}
+
+// Sum the terms of all the constraints.
+template<typename LagrangianFunction>
+double AugLagrangianFunction<LagrangianFunction>::ConstraintTerms(
+    const arma::mat& coordinates,
+    arma::mat* gradient) const
+{
+  const size_t numConstraints = function.NumConstraints();
+  double terms = 0;
+
+  #ifdef ENS_USE_OPENMP
+  if (parallelConstraints && numConstraints > 1)
+  {
+    // Each thread sums the terms of its constraints into its own accumulators,
+    // which are merged at the end.
+    #pragma omp parallel
+    {
+      double localTerms = 0;
+      arma::mat localGradient, constraintGradient;
+      if (gradient)
+        localGradient.zeros(gradient->n_rows, gradient->n_cols);
+
+      #pragma omp for schedule(static) nowait
+      for (size_t i = 0; i < numConstraints; ++i)
+      {
+        localTerms += ConstraintTerm(i, coordinates,
+            gradient ? &localGradient : NULL, constraintGradient);
+      }
+
+      #pragma omp critical
+      {
+        terms += localTerms;
+        if (gradient)
+          *gradient += localGradient;
+      }
+    }
+
+    return terms;
+  }
+  #endif
 
   arma::mat constraintGradient; // Temporary for constraint gradients.
-  for (size_t i = 0; i < function.NumConstraints(); i++)
+  for (size_t i = 0; i < numConstraints; ++i)
+    terms += ConstraintTerm(i, coordinates, gradient, constraintGradient);
+
+  return terms;
+}
+
+// Compute the term of one constraint.
+template<typename LagrangianFunction>
+double AugLagrangianFunction<LagrangianFunction>::ConstraintTerm(
+    const size_t i,
+    const arma::mat& coordinates,
+    arma::mat* gradient,
+    arma::mat& constraintGradient) const
+{
+  const double constraint = function.EvaluateConstraint(i, coordinates);
+
+  if (gradient)
   {
+    // Scale the gradient of the constraint and add it to the gradient.
     function.GradientConstraint(i, coordinates, constraintGradient);
-
-    // Now calculate scaling factor and add to existing gradient.
-    arma::mat tmpGradient;
-    tmpGradient = (-lambda[i] + sigma *
-        function.EvaluateConstraint(i, coordinates)) * constraintGradient;
-    gradient += tmpGradient;
+    *gradient += (-lambda[i] + sigma * constraint) * constraintGradient;
   }
+
+  return (-lambda[i] * constraint) + sigma * constraint * constraint / 2;
 }
 
 // Get the initial point.
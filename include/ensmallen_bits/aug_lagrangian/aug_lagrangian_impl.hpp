@@ -19,22 +19,86 @@
 
 namespace ens {
 
-inline AugLagrangian::AugLagrangian(const size_t maxIterations,
-                                    const double penaltyThresholdFactor,
-                                    const double sigmaUpdateFactor,
-                                    const L_BFGS& lbfgs) :
+/**
+ * Return the flag of the optimizer that controls whether its state is reset by
+ * Optimize().  This version is used for optimizers with a ResetHistory()
+ * modifier, such as L_BFGS.
+ */
+template<typename OptimizerType>
+typename std::enable_if<traits::HasResetHistory<OptimizerType,
+    traits::ResetFlagForm>::value, bool*>::type
+InnerResetFlag(OptimizerType& optimizer)
+{
+  return &optimizer.ResetHistory();
+}
+
+//! Return the ResetPolicy() flag of an optimizer that has one.
+template<typename OptimizerType>
+typename std::enable_if<!traits::HasResetHistory<OptimizerType,
+    traits::ResetFlagForm>::value && traits::HasResetPolicy<OptimizerType,
+    traits::ResetFlagForm>::value, bool*>::type
+InnerResetFlag(OptimizerType& optimizer)
+{
+  return &optimizer.ResetPolicy();
+}
+
+//! Optimizers without either flag cannot be warm-started.
+template<typename OptimizerType>
+typename std::enable_if<!traits::HasResetHistory<OptimizerType,
+    traits::ResetFlagForm>::value && !traits::HasResetPolicy<OptimizerType,
+    traits::ResetFlagForm>::value, bool*>::type
+InnerResetFlag(OptimizerType& /* optimizer */)
+{
+  return NULL;
+}
+
+//! Return the MinGradientNorm() tolerance of an optimizer that has one, which
+//! sets the accuracy of the subproblems.
+template<typename OptimizerType>
+typename std::enable_if<traits::HasMinGradientNorm<OptimizerType,
+    traits::ToleranceForm>::value, double*>::type
+InnerTolerance(OptimizerType& optimizer)
+{
+  return &optimizer.MinGradientNorm();
+}
+
+//! The accuracy of the subproblems of other optimizers can't be adapted.
+template<typename OptimizerType>
+typename std::enable_if<!traits::HasMinGradientNorm<OptimizerType,
+    traits::ToleranceForm>::value, double*>::type
+InnerTolerance(OptimizerType& /* optimizer */)
+{
+  return NULL;
+}
+
+template<typename InnerOptimizerType>
+inline AugLagrangianType<InnerOptimizerType>::AugLagrangianType(
+    const size_t maxIterations,
+    const double penaltyThresholdFactor,
+    const double sigmaUpdateFactor,
+    const InnerOptimizerType& innerOptimizer,
+    const bool warmStart,
+    const bool parallelConstraints,
+    const bool adaptive) :
     maxIterations(maxIterations),
     penaltyThresholdFactor(penaltyThresholdFactor),
     sigmaUpdateFactor(sigmaUpdateFactor),
-    lbfgs(lbfgs)
+    innerOptimizer(innerOptimizer),
+    warmStart(warmStart),
+    parallelConstraints(parallelConstraints),
+    adaptive(adaptive),
+    innerToleranceFactor(1.0),
+    constraintTolerance(1e-7)
 {
 }
 
+template<typename InnerOptimizerType>
 template<typename LagrangianFunctionType>
-bool AugLagrangian::Optimize(LagrangianFunctionType& function,
-                             arma::mat& coordinates,
-                             const arma::vec& initLambda,
-                             const double initSigma)
+bool AugLagrangianType<InnerOptimizerType>::Optimize(
+    LagrangianFunctionType& function,
+    arma::mat& coordinates,
+    const arma::vec& initLambda,
+    const double initSigma)
 {
   lambda = initLambda;
   sigma = initSigma;
@@ -45,9 +109,11 @@ bool AugLagrangian::Optimize(LagrangianFunctionType& function,
   return Optimize(augfunc, coordinates);
 }
 
+template<typename InnerOptimizerType>
 template<typename LagrangianFunctionType>
-bool AugLagrangian::Optimize(LagrangianFunctionType& function,
-                             arma::mat& coordinates)
+bool AugLagrangianType<InnerOptimizerType>::Optimize(
+    LagrangianFunctionType& function,
+    arma::mat& coordinates)
 {
   // If the user did not specify the right size for sigma and lambda, we will
   // use defaults.
@@ -63,14 +129,30 @@ bool AugLagrangian::Optimize(LagrangianFunctionType& function,
   }
 }
 
+template<typename InnerOptimizerType>
 template<typename LagrangianFunctionType>
-bool AugLagrangian::Optimize(
+bool AugLagrangianType<InnerOptimizerType>::Optimize(
     AugLagrangianFunction<LagrangianFunctionType>& augfunc,
     arma::mat& coordinates)
 {
   traits::CheckConstrainedFunctionTypeAPI<LagrangianFunctionType>();
 
   LagrangianFunctionType& function = augfunc.Function();
+  augfunc.ParallelConstraints() = parallelConstraints;
+
+  // To warm-start, the inner optimizer resets its state only for the first
+  // subproblem and after sigma changes; the user's setting is restored at the
+  // end.
+  bool* resetFlag = warmStart ? InnerResetFlag(innerOptimizer) : NULL;
+  const bool userReset = resetFlag ? *resetFlag : true;
+  if (resetFlag)
+    *resetFlag = true;
+
+  // With adaptive tolerances, the configured tolerance of the inner optimizer
+  // is the accuracy of the last subproblems; it is restored at the end.
+  double* innerTolerance = adaptive ? InnerTolerance(innerOptimizer) : NULL;
+  const double userTolerance = innerTolerance ? *innerTolerance : 0.0;
+  double subproblemTolerance = DBL_MAX;
 
   // Ensure that we update lambda immediately.
   double penaltyThreshold = DBL_MAX;
@@ -92,30 +174,30 @@ bool AugLagrangian::Optimize(
   for (it = 0; it != (maxIterations - 1); it++)
   {
     Info << "AugLagrangian on iteration " << it
-        << ", starting with objective "  << lastObjective << "." << std::endl;
+        << ", starting with objective "  << lastObjective << ".\n";
 
-    if (!lbfgs.Optimize(augfunc, coordinates))
-      Info << "L-BFGS reported an error during optimization."
-          << std::endl;
-
-    // Check if we are done with the entire optimization (the threshold we are
-    // comparing with is arbitrary).
-    if (std::abs(lastObjective - function.Evaluate(coordinates)) < 1e-10 &&
-        augfunc.Sigma() > 500000)
+    if (innerTolerance)
     {
-      lambda = std::move(augfunc.Lambda());
-      sigma = augfunc.Sigma();
-      return true;
+      subproblemTolerance = std::max(userTolerance, std::min(
+          subproblemTolerance, innerToleranceFactor * std::sqrt(penalty)));
+      *innerTolerance = subproblemTolerance;
+      Info << "Subproblem tolerance is " << subproblemTolerance << "."
+          << std::endl;
     }
 
-    lastObjective = function.Evaluate(coordinates);
+    if (!innerOptimizer.Optimize(augfunc, coordinates))
+      Info << "The inner optimizer reported an error during optimization."
+          << std::endl;
+
+    if (resetFlag)
+      *resetFlag = false;
 
     // Assuming that the optimization has converged to a new set of coordinates,
     // we now update either lambda or sigma.  We update sigma if the penalty
     // term is too high, and we update lambda otherwise.
 
     // First, calculate the current penalty.
-    double penalty = 0;
+    penalty = 0;
     for (size_t i = 0; i < function.NumConstraints(); i++)
     {
       penalty += std::pow(function.EvaluateConstraint(i, coordinates), 2);
@@ -124,6 +206,27 @@ bool AugLagrangian::Optimize(
     Info << "Penalty is " << penalty << " (threshold "
         << penaltyThreshold << ")." << std::endl;
 
+    // Check if we are done with the entire optimization (the threshold we are
+    // comparing with is arbitrary).  With adaptive tolerances, we are done when
+    // a subproblem solved to full accuracy is feasible.
+    const bool converged = adaptive ?
+        (std::sqrt(penalty) <= constraintTolerance &&
+        (!innerTolerance || subproblemTolerance <= userTolerance)) :
+        (std::abs(lastObjective - function.Evaluate(coordinates)) < 1e-10 &&
+        augfunc.Sigma() > 500000);
+    if (converged)
+    {
+      lambda = std::move(augfunc.Lambda());
+      sigma = augfunc.Sigma();
+      if (resetFlag)
+        *resetFlag = userReset;
+      if (innerTolerance)
+        *innerTolerance = userTolerance;
+      return true;
+    }
+
+    lastObjective = function.Evaluate(coordinates);
+
     if (penalty < penaltyThreshold) // We update lambda.
     {
       // We use the update: lambda_{k + 1} = lambda_k - sigma * c(coordinates),
@@ -142,9 +245,18 @@ bool AugLagrangian::Optimize(
       // We multiply sigma by a constant value.
       augfunc.Sigma() *= sigmaUpdateFactor;
       Info << "Updated sigma to " << augfunc.Sigma() << "." << std::endl;
+
+      // The curvature of the penalty term scales with sigma, so the state of
+      // the inner optimizer is stale now.
+      if (resetFlag)
+        *resetFlag = true;
     }
   }
 
+  if (resetFlag)
+    *resetFlag = userReset;
+  if (innerTolerance)
+    *innerTolerance = userTolerance;
   return false;
 }
 
@@ -0,0 +1,111 @@
+/**
+ * @file batched_gradient_descent.hpp
+ *
+ * Gradient descent on many small independent problems at once.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_BATCHED_BATCHED_GRADIENT_DESCENT_HPP
+#define ENSMALLEN_BATCHED_BATCHED_GRADIENT_DESCENT_HPP
+
+#include "batched_problems.hpp"
+
+namespace ens {
+
+/**
+ * BatchedGradientDescent runs gradient descent with a fixed step size on many
+ * independent problems of the same dimension at once.  The problems are stored
+ * in the columns of one matrix (a struct-of-arrays layout), and the function
+ * evaluates all of them in one call:
+ *
+ *   void EvaluateWithGradient(const arma::mat& coordinates,
+ *                             const arma::uvec& problems,
+ *                             arma::rowvec& objectives,
+ *                             arma::mat& gradients);
+ *
+ * where column k of coordinates is the point of problem problems(k) (that is,
+ * of column problems(k) of the coordinates given to Optimize()), objectives(k)
+ * must be set to its objective and gradients.col(k) to its gradient.  The
+ * updates are then whole-matrix operations, and no memory is allocated per
+ * problem.
+ *
+ * Each problem stops on its own when its objective changes by less than
+ * tolerance in an iteration (as in GradientDescent), or becomes NaN or
+ * infinite.  Stopped problems are removed from the working set, so the
+ * function is only evaluated on the problems that are still running.
+ */
+class BatchedGradientDescent
+{
+ public:
+  /**
+   * Construct the batched gradient descent optimizer with the given
+   * parameters.
+   *
+   * @param stepSize Step size for each iteration.
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *     limit).
+   * @param tolerance Maximum absolute tolerance to terminate each problem.
+   */
+  BatchedGradientDescent(const double stepSize = 0.01,
+                         const size_t maxIterations = 100000,
+                         const double tolerance = 1e-5);
+
+  /**
+   * Optimize all the problems, one per column of coordinates.  The final
+   * points are stored in coordinates, and their objectives are available
+   * through Objectives().
+   *
+   * @tparam FunctionType Type of the batched function to optimize.
+   * @param function Batched function to optimize.
+   * @param coordinates Starting points, one per column (will be modified).
+   * @return Sum of the final objectives.
+   */
+  template<typename FunctionType>
+  double Optimize(FunctionType& function, arma::mat& coordinates);
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get the final objectives of the last optimization.
+  const arma::rowvec& Objectives() const { return objectives; }
+
+  //! Get the number of problems that converged in the last optimization.
+  size_t NumConverged() const { return numConverged; }
+
+ private:
+  //! The step size for each example.
+  double stepSize;
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Final objectives of the last optimization.
+  arma::rowvec objectives;
+
+  //! Number of problems that converged in the last optimization.
+  size_t numConverged;
+};
+
+} // namespace ens
+
+#include "batched_gradient_descent_impl.hpp"
+
+#endif
@@ -0,0 +1,76 @@
+/**
+ * @file batched_gradient_descent_impl.hpp
+ *
+ * Implementation of batched gradient descent.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_BATCHED_BATCHED_GRADIENT_DESCENT_IMPL_HPP
+#define ENSMALLEN_BATCHED_BATCHED_GRADIENT_DESCENT_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "batched_gradient_descent.hpp"
+
+namespace ens {
+
+inline BatchedGradientDescent::BatchedGradientDescent(
+    const double stepSize,
+    const size_t maxIterations,
+    const double tolerance) :
+    stepSize(stepSize),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    numConverged(0)
+{ /* Nothing to do. */ }
+
+template<typename FunctionType>
+double BatchedGradientDescent::Optimize(FunctionType& function,
+                                        arma::mat& coordinates)
+{
+  BatchedProblems problems(coordinates, objectives);
+  numConverged = 0;
+
+  arma::rowvec current, next;
+  arma::mat gradients;
+  if (problems.Size() > 0)
+    function.EvaluateWithGradient(problems.Points(), problems.Indices(),
+        current, gradients);
+
+  for (size_t i = 1; i != maxIterations && problems.Size() > 0; ++i)
+  {
+    problems.Points() -= stepSize * gradients;
+    function.EvaluateWithGradient(problems.Points(), problems.Indices(), next,
+        gradients);
+
+    // Problems whose objective did not change enough, or is not finite, stop.
+    arma::urowvec stop = (arma::abs(next - current) < tolerance);
+    stop.elem(arma::find_nonfinite(next)).ones();
+    const arma::uvec finished = arma::find(stop);
+    current.swap(next);
+
+    if (finished.n_elem > 0)
+    {
+      numConverged += finished.n_elem;
+      const arma::uvec keep = problems.Finish(finished, current);
+      current = current.cols(keep);
+      gradients = gradients.cols(keep);
+    }
+  }
+
+  if (problems.Size() > 0)
+  {
+    Warn << "Batched Gradient Descent: maximum iterations (" << maxIterations
+        << ") reached for " << problems.Size() << " problems; terminating "
+        << "optimization." << std::endl;
+    problems.FinishAll(current);
+  }
+
+  return arma::accu(objectives);
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,136 @@
+/**
+ * @file batched_lbfgs.hpp
+ *
+ * L-BFGS on many small independent problems at once.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_BATCHED_BATCHED_LBFGS_HPP
+#define ENSMALLEN_BATCHED_BATCHED_LBFGS_HPP
+
+#include "batched_problems.hpp"
+
+namespace ens {
+
+/**
+ * BatchedL_BFGS runs L-BFGS on many independent problems of the same dimension
+ * at once, in lockstep.  As for BatchedGradientDescent, the problems are the
+ * columns of one matrix and the function evaluates all of them in one call:
+ *
+ *   void EvaluateWithGradient(const arma::mat& coordinates,
+ *                             const arma::uvec& problems,
+ *                             arma::rowvec& objectives,
+ *                             arma::mat& gradients);
+ *
+ * The curvature pairs of all problems are stored together (slice k of the s
+ * and y cubes holds pair k of every problem, one per column), so the two-loop
+ * recursion is made of column-wise dot products and whole-matrix updates, and
+ * the memory is allocated once for the whole batch.  A pair with nonpositive
+ * curvature is stored with a zero weight, so it does not change the direction
+ * of its problem.
+ *
+ * The step size of each problem is found by backtracking from 1 until the
+ * Armijo condition holds, halving it at each trial; only the problems whose
+ * trial failed are evaluated again.  Each problem stops on its own when the
+ * norm of its gradient is below minGradientNorm, when its relative
+ * improvement is at most factr, or when its line search fails; stopped
+ * problems are removed from the working set, so the function is only
+ * evaluated on the problems that are still running.
+ */
+class BatchedL_BFGS
+{
+ public:
+  /**
+   * Construct the batched L-BFGS optimizer with the given parameters.
+   *
+   * @param numBasis Number of memory points to be stored for each problem.
+   * @param maxIterations Maximum number of iterations (0 means no limit).
+   * @param armijoConstant Controls the accuracy of the line search.
+   * @param minGradientNorm Minimum gradient norm of each problem.
+   * @param factr Minimum relative function value decrease of each problem.
+   * @param maxLineSearchTrials Maximum number of trials of each line search.
+   */
+  BatchedL_BFGS(const size_t numBasis = 10,
+                const size_t maxIterations = 10000,
+                const double armijoConstant = 1e-4,
+                const double minGradientNorm = 1e-6,
+                const double factr = 1e-15,
+                const size_t maxLineSearchTrials = 50);
+
+  /**
+   * Optimize all the problems, one per column of coordinates.  The final
+   * points are stored in coordinates, and their objectives are available
+   * through Objectives().
+   *
+   * @tparam FunctionType Type of the batched function to optimize.
+   * @param function Batched function to optimize.
+   * @param coordinates Starting points, one per column (will be modified).
+   * @return Sum of the final objectives.
+   */
+  template<typename FunctionType>
+  double Optimize(FunctionType& function, arma::mat& coordinates);
+
+  //! Get the memory size.
+  size_t NumBasis() const { return numBasis; }
+  //! Modify the memory size.
+  size_t& NumBasis() { return numBasis; }
+
+  //! Get the maximum number of iterations.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the Armijo condition constant.
+  double ArmijoConstant() const { return armijoConstant; }
+  //! Modify the Armijo condition constant.
+  double& ArmijoConstant() { return armijoConstant; }
+
+  //! Get the gradient norm required for convergence.
+  double MinGradientNorm() const { return minGradientNorm; }
+  //! Modify the gradient norm required for convergence.
+  double& MinGradientNorm() { return minGradientNorm; }
+
+  //! Get the minimum relative function value decrease.
+  double Factr() const { return factr; }
+  //! Modify the minimum relative function value decrease.
+  double& Factr() { return factr; }
+
+  //! Get the maximum number of trials of each line search.
+  size_t MaxLineSearchTrials() const { return maxLineSearchTrials; }
+  //! Modify the maximum number of trials of each line search.
+  size_t& MaxLineSearchTrials() { return maxLineSearchTrials; }
+
+  //! Get the final objectives of the last optimization.
+  const arma::rowvec& Objectives() const { return objectives; }
+
+  //! Get the number of problems that converged in the last optimization.
+  size_t NumConverged() const { return numConverged; }
+
+ private:
+  //! Size of the memory.
+  size_t numBasis;
+  //! Maximum number of iterations.
+  size_t maxIterations;
+  //! Parameter for determining the Armijo condition.
+  double armijoConstant;
+  //! Minimum gradient norm required to continue the optimization.
+  double minGradientNorm;
+  //! Minimum relative function value decrease to continue the optimization.
+  double factr;
+  //! Maximum number of trials of each line search.
+  size_t maxLineSearchTrials;
+
+  //! Final objectives of the last optimization.
+  arma::rowvec objectives;
+  //! Number of problems that converged in the last optimization.
+  size_t numConverged;
+};
+
+} // namespace ens
+
+#include "batched_lbfgs_impl.hpp"
+
+#endif
@@ -0,0 +1,202 @@
+/**
+ * @file batched_lbfgs_impl.hpp
+ *
+ * Implementation of batched L-BFGS.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_BATCHED_BATCHED_LBFGS_IMPL_HPP
+#define ENSMALLEN_BATCHED_BATCHED_LBFGS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "batched_lbfgs.hpp"
+
+namespace ens {
+
+inline BatchedL_BFGS::BatchedL_BFGS(const size_t numBasis,
+                                    const size_t maxIterations,
+                                    const double armijoConstant,
+                                    const double minGradientNorm,
+                                    const double factr,
+                                    const size_t maxLineSearchTrials) :
+    numBasis(numBasis),
+    maxIterations(maxIterations),
+    armijoConstant(armijoConstant),
+    minGradientNorm(minGradientNorm),
+    factr(factr),
+    maxLineSearchTrials(maxLineSearchTrials),
+    numConverged(0)
+{
+  // Nothing to do.
+}
+
+template<typename FunctionType>
+double BatchedL_BFGS::Optimize(FunctionType& function, arma::mat& coordinates)
+{
+  if (numBasis == 0)
+  {
+    throw std::invalid_argument("BatchedL_BFGS::Optimize(): numBasis must be "
+        "positive!");
+  }
+
+  BatchedProblems problems(coordinates, objectives);
+  numConverged = 0;
+  if (problems.Size() == 0)
+    return 0.0;
+
+  // The curvature pairs: slice k holds pair k of every problem.
+  const size_t n = coordinates.n_rows;
+  arma::cube s(n, problems.Size(), numBasis);
+  arma::cube y(n, problems.Size(), numBasis);
+  arma::mat rho(numBasis, problems.Size(), arma::fill::zeros);
+  arma::mat alpha(numBasis, problems.Size());
+  size_t numPairs = 0;
+
+  arma::rowvec current, trial;
+  arma::mat gradients, trialGradients;
+  arma::mat newPoints, newGradients, direction;
+  function.EvaluateWithGradient(problems.Points(), problems.Indices(), current,
+      gradients);
+
+  for (size_t i = 0; i != maxIterations && problems.Size() > 0; ++i)
+  {
+    const arma::mat& points = problems.Points();
+    const size_t stored = std::min(numPairs, numBasis);
+
+    // The two-loop recursion, for all problems at once.
+    direction = gradients;
+    for (size_t t = 0; t < stored; ++t)
+    {
+      const size_t k = (numPairs - 1 - t) % numBasis;
+      alpha.row(k) = rho.row(k) % arma::sum(s.slice(k) % direction, 0);
+      direction -= y.slice(k).each_row() % alpha.row(k);
+    }
+
+    if (stored > 0)
+    {
+      // Scale by s^T y / y^T y of the newest pair, if its curvature is valid.
+      const size_t k = (numPairs - 1) % numBasis;
+      arma::rowvec gamma = arma::sum(s.slice(k) % y.slice(k), 0) /
+          arma::sum(arma::square(y.slice(k)), 0);
+      gamma.cols(arma::find(rho.row(k) == 0)).ones();
+      direction.each_row() %= gamma;
+    }
+
+    for (size_t t = stored; t > 0; --t)
+    {
+      const size_t k = (numPairs - t) % numBasis;
+      const arma::rowvec beta = rho.row(k) %
+          arma::sum(y.slice(k) % direction, 0);
+      direction += s.slice(k).each_row() % (alpha.row(k) - beta);
+    }
+    direction *= -1.0;
+
+    // Fall back to steepest descent where the direction does not descend.
+    arma::rowvec slope = arma::sum(direction % gradients, 0);
+    const arma::uvec ascent = arma::find(slope >= 0);
+    if (ascent.n_elem > 0)
+    {
+      direction.cols(ascent) = -gradients.cols(ascent);
+      slope.cols(ascent) = -arma::sum(arma::square(gradients.cols(ascent)), 0);
+    }
+
+    // Backtracking line search; the first step of a problem without history
+    // has unit length.
+    arma::rowvec step(problems.Size(), arma::fill::ones);
+    if (stored == 0)
+    {
+      step = 1.0 / arma::clamp(arma::sqrt(arma::sum(arma::square(direction),
+          0)), 1.0, DBL_MAX);
+    }
+
+    newPoints = points + direction.each_row() % step;
+    function.EvaluateWithGradient(newPoints, problems.Indices(), trial,
+        newGradients);
+    arma::uvec pending = arma::find((trial > current + armijoConstant *
+        step % slope) + (trial != trial));
+    for (size_t t = 1; t < maxLineSearchTrials && pending.n_elem > 0; ++t)
+    {
+      step.cols(pending) *= 0.5;
+      const arma::mat pendingPoints = points.cols(pending) +
+          direction.cols(pending).each_row() % step.cols(pending);
+      arma::rowvec pendingTrial;
+      function.EvaluateWithGradient(pendingPoints,
+          arma::uvec(problems.Indices().elem(pending)), pendingTrial,
+          trialGradients);
+
+      newPoints.cols(pending) = pendingPoints;
+      trial.cols(pending) = pendingTrial;
+      newGradients.cols(pending) = trialGradients;
+      pending = pending.elem(arma::find((pendingTrial >
+          current.cols(pending) + armijoConstant * step.cols(pending) %
+          slope.cols(pending)) + (pendingTrial != pendingTrial)));
+    }
+
+    // Problems whose line search failed keep their point and stop.
+    if (pending.n_elem > 0)
+    {
+      newPoints.cols(pending) = points.cols(pending);
+      trial.cols(pending) = current.cols(pending);
+      newGradients.cols(pending) = gradients.cols(pending);
+    }
+
+    // Store the new curvature pair; it is ignored where the curvature is not
+    // positive.
+    const size_t k = numPairs % numBasis;
+    s.slice(k) = newPoints - points;
+    y.slice(k) = newGradients - gradients;
+    const arma::rowvec sy = arma::sum(s.slice(k) % y.slice(k), 0);
+    rho.row(k).zeros();
+    const arma::uvec valid = arma::find(sy > 0);
+    rho.row(k).cols(valid) = 1.0 / sy.cols(valid);
+    ++numPairs;
+
+    // A problem stops when its gradient is small enough, or when it does not
+    // improve enough (which includes a failed line search).
+    const arma::rowvec improvement = (current - trial) / arma::clamp(
+        arma::max(arma::abs(current), arma::abs(trial)), 1.0, DBL_MAX);
+    const arma::uvec finished = arma::find((arma::sqrt(arma::sum(
+        arma::square(newGradients), 0)) < minGradientNorm) +
+        (improvement <= factr));
+
+    problems.Points().swap(newPoints);
+    gradients.swap(newGradients);
+    current.swap(trial);
+
+    if (finished.n_elem > 0)
+    {
+      numConverged += finished.n_elem;
+      const arma::uvec keep = problems.Finish(finished, current);
+      current = current.cols(keep);
+      gradients = gradients.cols(keep);
+      rho = rho.cols(keep);
+      alpha.set_size(numBasis, keep.n_elem);
+      arma::cube keptS(n, keep.n_elem, numBasis), keptY(n, keep.n_elem,
+          numBasis);
+      for (size_t b = 0; b < std::min(numPairs, numBasis); ++b)
+      {
+        keptS.slice(b) = s.slice(b).cols(keep);
+        keptY.slice(b) = y.slice(b).cols(keep);
+      }
+      s.swap(keptS);
+      y.swap(keptY);
+    }
+  }
+
+  if (problems.Size() > 0)
+  {
+    Warn << "Batched L-BFGS: maximum iterations (" << maxIterations << ") "
+        << "reached for " << problems.Size() << " problems; terminating "
+        << "optimization." << std::endl;
+    problems.FinishAll(current);
+  }
+
+  return arma::accu(objectives);
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ * @file batched_problems.hpp
+ *
+ * Working set of the batched optimizers: the problems that have not converged
+ * yet, stored one per column.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_BATCHED_BATCHED_PROBLEMS_HPP
+#define ENSMALLEN_BATCHED_BATCHED_PROBLEMS_HPP
+
+namespace ens {
+
+/**
+ * BatchedProblems holds the points of the problems of a batched optimization
+ * that are still running, one per column, together with their columns in the
+ * user's coordinates.  When problems finish, their points and objectives are
+ * written back and their columns are removed, so that the batched function is
+ * only evaluated on the problems that are still running (Indices() tells it
+ * which ones).
+ */
+class BatchedProblems
+{
+ public:
+  /**
+   * Start with all the columns of the given coordinates.
+   *
+   * @param coordinates Starting points, one per column; the final points are
+   *     written back into it.
+   * @param objectives Row vector to store the final objectives into.
+   */
+  BatchedProblems(arma::mat& coordinates, arma::rowvec& objectives) :
+      coordinates(coordinates),
+      objectives(objectives),
+      points(coordinates),
+      columns(coordinates.n_cols)
+  {
+    for (size_t j = 0; j < columns.n_elem; ++j)
+      columns(j) = j;
+    objectives.set_size(coordinates.n_cols);
+  }
+
+  /**
+   * Write the points and objectives of the given running problems back,
+   * and remove them from the working set.
+   *
+   * @param finished Positions of the finished problems in the working set.
+   * @param runningObjectives Objectives of the running problems.
+   * @return Positions of the remaining problems in the old working set, to
+   *     compact any other per-problem state with.
+   */
+  arma::uvec Finish(const arma::uvec& finished,
+                    const arma::rowvec& runningObjectives)
+  {
+    std::vector<bool> done(points.n_cols, false);
+    for (size_t k = 0; k < finished.n_elem; ++k)
+    {
+      done[finished(k)] = true;
+      coordinates.col(columns(finished(k))) = points.col(finished(k));
+      objectives(columns(finished(k))) = runningObjectives(finished(k));
+    }
+
+    arma::uvec keep(points.n_cols - finished.n_elem);
+    for (size_t j = 0, k = 0; j < points.n_cols; ++j)
+    {
+      if (!done[j])
+        keep(k++) = j;
+    }
+
+    points = points.cols(keep);
+    columns = columns.elem(keep);
+    return keep;
+  }
+
+  /**
+   * Write all the running problems back.
+   *
+   * @param runningObjectives Objectives of the running problems.
+   */
+  void FinishAll(const arma::rowvec& runningObjectives)
+  {
+    for (size_t j = 0; j < points.n_cols; ++j)
+    {
+      coordinates.col(columns(j)) = points.col(j);
+      objectives(columns(j)) = runningObjectives(j);
+    }
+  }
+
+  //! Get the points of the running problems.
+  const arma::mat& Points() const { return points; }
+  //! Modify the points of the running problems.
+  arma::mat& Points() { return points; }
+
+  //! Get the indices (columns in the user's coordinates) of the running
+  //! problems.
+  const arma::uvec& Indices() const { return columns; }
+
+  //! Get the number of running problems.
+  size_t Size() const { return points.n_cols; }
+
+ private:
+  //! The user's coordinates.
+  arma::mat& coordinates;
+  //! The final objectives.
+  arma::rowvec& objectives;
+  //! Points of the running problems.
+  arma::mat points;
+  //! Columns of the running problems in the user's coordinates.
+  arma::uvec columns;
+};
+
+} // namespace ens
+
+#endif
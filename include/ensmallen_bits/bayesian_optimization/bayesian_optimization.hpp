@@ -0,0 +1,208 @@
+/**
+ * @file bayesian_optimization.hpp
+ *
+ * Batch Bayesian optimization with a Gaussian process model and the constant
+ * liar heuristic, for expensive functions of continuous and categorical
+ * parameters.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_BAYESIAN_OPTIMIZATION_BAYESIAN_OPTIMIZATION_HPP
+#define ENSMALLEN_BAYESIAN_OPTIMIZATION_BAYESIAN_OPTIMIZATION_HPP
+
+#include "gaussian_process.hpp"
+
+namespace ens {
+
+/**
+ * BayesianOptimization minimizes an expensive function of continuous and
+ * categorical parameters (for instance, the validation error of a model as a
+ * function of its hyperparameters) with few evaluations.  The continuous
+ * dimensions take values between lowerBound and upperBound, and the
+ * categorical dimensions take the categories 0, ..., numCategories(i) - 1, as
+ * with GridSearch.
+ *
+ * After numInitialPoints random points, the evaluated points are modeled by a
+ * Gaussian process (see GaussianProcess; the length scale of its kernel is
+ * picked by maximum likelihood), and each round proposes pointsPerRound new
+ * points with the constant liar heuristic: the point with the largest expected
+ * improvement over the best objective is picked among numCandidates random
+ * candidates (half of them uniform, half of them perturbations of the best
+ * points), it is added to the model with the best objective as a fake
+ * ("liar") response, so that the model no longer expects an improvement near
+ * it, and the next point is picked in the same way.  The points of a round are
+ * then evaluated together: in parallel, if parallelEvaluation is true (the
+ * function's Evaluate() must then be safe to call from several threads), or
+ * with all the evaluations in flight at once, if the function has an
+ * EvaluateAsync() method.  Non-finite objectives are modeled as the worst
+ * finite one.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @incollection{Ginsbourger2010,
+ *   author    = {Ginsbourger, David and Le Riche, Rodolphe and Carraro,
+ *                Laurent},
+ *   title     = {Kriging Is Well-Suited to Parallelize Optimization},
+ *   booktitle = {Computational Intelligence in Expensive Optimization
+ *                Problems},
+ *   publisher = {Springer},
+ *   year      = {2010},
+ *   pages     = {131--162}
+ * }
+ * @endcode
+ *
+ * BayesianOptimization can optimize categorical functions, whose dimensions
+ * may also be continuous.  For more details, see the documentation on function
+ * types included with this distribution or on the ensmallen website.
+ */
+class BayesianOptimization
+{
+ public:
+  /**
+   * Construct the BayesianOptimization optimizer with the given parameters.
+   *
+   * @param maxEvaluations Maximum number of evaluations of the function.
+   * @param pointsPerRound Number of points evaluated together in each round.
+   * @param numInitialPoints Number of random points evaluated before the
+   *     model is used.
+   * @param lowerBound Lower bound of the continuous dimensions.
+   * @param upperBound Upper bound of the continuous dimensions.
+   * @param numCandidates Number of candidates the expected improvement is
+   *     maximized over, for each proposed point.
+   * @param parallelEvaluation Whether to evaluate the points of each round in
+   *     parallel (requires a thread-safe Evaluate()).
+   */
+  BayesianOptimization(const size_t maxEvaluations = 100,
+                       const size_t pointsPerRound = 4,
+                       const size_t numInitialPoints = 10,
+                       const double lowerBound = 0.0,
+                       const double upperBound = 1.0,
+                       const size_t numCandidates = 1000,
+                       const bool parallelEvaluation = false);
+
+  /**
+   * Optimize (minimize) the given function, and store the best point found
+   * in bestParameters.
+   *
+   * @param function Function to optimize.
+   * @param bestParameters Variable for storing the best point found.
+   * @param categoricalDimensions Set of dimension types.  If a value is true,
+   *     then that dimension is a categorical dimension; otherwise it is
+   *     continuous.
+   * @param numCategories Number of categories in each categorical dimension
+   *     (ignored for the continuous dimensions).
+   * @return The objective of the best point found.
+   */
+  template<typename FunctionType>
+  double Optimize(FunctionType& function,
+                  arma::mat& bestParameters,
+                  const std::vector<bool>& categoricalDimensions,
+                  const arma::Row<size_t>& numCategories);
+
+  //! Get the maximum number of evaluations.
+  size_t MaxEvaluations() const { return maxEvaluations; }
+  //! Modify the maximum number of evaluations.
+  size_t& MaxEvaluations() { return maxEvaluations; }
+
+  //! Get the number of points evaluated in each round.
+  size_t PointsPerRound() const { return pointsPerRound; }
+  //! Modify the number of points evaluated in each round.
+  size_t& PointsPerRound() { return pointsPerRound; }
+
+  //! Get the number of initial random points.
+  size_t NumInitialPoints() const { return numInitialPoints; }
+  //! Modify the number of initial random points.
+  size_t& NumInitialPoints() { return numInitialPoints; }
+
+  //! Get the lower bound of the continuous dimensions.
+  double LowerBound() const { return lowerBound; }
+  //! Modify the lower bound of the continuous dimensions.
+  double& LowerBound() { return lowerBound; }
+
+  //! Get the upper bound of the continuous dimensions.
+  double UpperBound() const { return upperBound; }
+  //! Modify the upper bound of the continuous dimensions.
+  double& UpperBound() { return upperBound; }
+
+  //! Get the number of candidates for each proposed point.
+  size_t NumCandidates() const { return numCandidates; }
+  //! Modify the number of candidates for each proposed point.
+  size_t& NumCandidates() { return numCandidates; }
+
+  //! Get whether the points of each round are evaluated in parallel.
+  bool ParallelEvaluation() const { return parallelEvaluation; }
+  //! Modify whether the points of each round are evaluated in parallel.
+  bool& ParallelEvaluation() { return parallelEvaluation; }
+
+  //! Get the number of evaluations made by the last optimization.
+  size_t NumEvaluations() const { return numEvaluations; }
+
+  /**
+   * Compute the expected improvement of a normal objective with the given mean
+   * and variance over the given (best) objective.
+   *
+   * @param mean The mean of the objective.
+   * @param variance The variance of the objective.
+   * @param best The objective to improve on.
+   */
+  static double ExpectedImprovement(const double mean,
+                                    const double variance,
+                                    const double best);
+
+ private:
+  /**
+   * Evaluate the function at the given points (in the coordinates of the
+   * model, one per column), and append them and their objectives to the
+   * evaluated points.
+   */
+  template<typename FunctionType>
+  void Evaluate(FunctionType& function,
+                const arma::mat& batch,
+                const std::vector<bool>& categoricalDimensions,
+                arma::mat& points,
+                arma::vec& objectives);
+
+  /**
+   * Draw a point uniformly, in the coordinates of the model: the continuous
+   * dimensions are scaled to [0, 1], and the categorical dimensions hold the
+   * category.
+   */
+  static void RandomPoint(std::mt19937& generator,
+                          const std::vector<bool>& categoricalDimensions,
+                          const arma::Row<size_t>& numCategories,
+                          arma::vec& point);
+
+  //! Compute the parameters of the function from a point in the coordinates
+  //! of the model.
+  void Parameters(const arma::vec& point,
+                  const std::vector<bool>& categoricalDimensions,
+                  arma::vec& parameters) const;
+
+  //! The maximum number of evaluations.
+  size_t maxEvaluations;
+  //! The number of points evaluated in each round.
+  size_t pointsPerRound;
+  //! The number of initial random points.
+  size_t numInitialPoints;
+  //! The lower bound of the continuous dimensions.
+  double lowerBound;
+  //! The upper bound of the continuous dimensions.
+  double upperBound;
+  //! The number of candidates for each proposed point.
+  size_t numCandidates;
+  //! Whether to evaluate the points of each round in parallel.
+  bool parallelEvaluation;
+
+  //! The number of evaluations made by the last optimization.
+  size_t numEvaluations;
+};
+
+} // namespace ens
+
+#include "bayesian_optimization_impl.hpp"
+
+#endif
@@ -0,0 +1,340 @@
+/**
+ * @file bayesian_optimization_impl.hpp
+ *
+ * Implementation of batch Bayesian optimization.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_BAYESIAN_OPTIMIZATION_BAYESIAN_OPTIMIZATION_IMPL_HPP
+#define ENSMALLEN_BAYESIAN_OPTIMIZATION_BAYESIAN_OPTIMIZATION_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "bayesian_optimization.hpp"
+
+#include <limits>
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+inline BayesianOptimization::BayesianOptimization(
+    const size_t maxEvaluations,
+    const size_t pointsPerRound,
+    const size_t numInitialPoints,
+    const double lowerBound,
+    const double upperBound,
+    const size_t numCandidates,
+    const bool parallelEvaluation) :
+    maxEvaluations(maxEvaluations),
+    pointsPerRound(pointsPerRound),
+    numInitialPoints(numInitialPoints),
+    lowerBound(lowerBound),
+    upperBound(upperBound),
+    numCandidates(numCandidates),
+    parallelEvaluation(parallelEvaluation),
+    numEvaluations(0)
+{
+  // Nothing to do.
+}
+
+template<typename FunctionType>
+double BayesianOptimization::Optimize(
+    FunctionType& function,
+    arma::mat& bestParameters,
+    const std::vector<bool>& categoricalDimensions,
+    const arma::Row<size_t>& numCategories)
+{
+  // Make sure we have the methods that we need.
+  traits::CheckNonDifferentiableFunctionTypeAPI<FunctionType>();
+
+  const size_t numDimensions = categoricalDimensions.size();
+  if (numCategories.n_elem != numDimensions)
+  {
+    std::ostringstream oss;
+    oss << "BayesianOptimization::Optimize(): given " << numDimensions
+        << " dimensions, but " << numCategories.n_elem << " numbers of "
+        << "categories!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  for (size_t i = 0; i < numDimensions; ++i)
+  {
+    if (categoricalDimensions[i] && numCategories(i) == 0)
+    {
+      std::ostringstream oss;
+      oss << "BayesianOptimization::Optimize(): the categorical dimension "
+          << i << " has no categories" << std::endl;
+      throw std::invalid_argument(oss.str());
+    }
+  }
+
+  if (maxEvaluations == 0 || pointsPerRound == 0 || numCandidates == 0 ||
+      !(upperBound > lowerBound))
+  {
+    throw std::invalid_argument("BayesianOptimization::Optimize(): "
+        "maxEvaluations, pointsPerRound and numCandidates must be positive, "
+        "and upperBound must be greater than lowerBound!");
+  }
+
+  // The points are drawn with a generator seeded from Armadillo's.
+  std::mt19937 generator(arma::randi<arma::ivec>(1,
+      arma::distr_param(0, std::numeric_limits<int>::max()))(0));
+
+  // The evaluated points, in the coordinates of the model, and their
+  // objectives.
+  numEvaluations = 0;
+  arma::mat points(numDimensions, 0);
+  arma::vec objectives;
+
+  // Start with random points.
+  arma::mat batch(numDimensions, std::min(maxEvaluations,
+      std::max((size_t) 1, numInitialPoints)));
+  arma::vec point(numDimensions);
+  for (size_t j = 0; j < batch.n_cols; ++j)
+  {
+    RandomPoint(generator, categoricalDimensions, numCategories, point);
+    batch.col(j) = point;
+  }
+  Evaluate(function, batch, categoricalDimensions, points, objectives);
+
+  // The length scales tried for the model, relative to the diameter of the
+  // unit cube.
+  const arma::vec lengthScales = arma::vec({ 0.05, 0.1, 0.2, 0.4, 0.8, 1.6 }) *
+      std::sqrt((double) std::max((size_t) 1, numDimensions));
+
+  std::normal_distribution<double> perturbation(0.0, 0.1);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  while (numEvaluations < maxEvaluations)
+  {
+    // Non-finite objectives are modeled as the worst finite one.
+    const arma::vec finite = objectives.elem(arma::find_finite(objectives));
+    double worst = 0.0;
+    if (!finite.is_empty())
+      worst = finite.max();
+    arma::vec responses = objectives;
+    responses.elem(arma::find_nonfinite(responses)).fill(worst);
+    const double best = responses.min();
+
+    // Pick the length scale of the model by maximum likelihood.
+    GaussianProcess model(categoricalDimensions);
+    double bestLikelihood = -std::numeric_limits<double>::infinity();
+    double bestLengthScale = 0.0;
+    for (size_t l = 0; l < lengthScales.n_elem; ++l)
+    {
+      model.LengthScale() = lengthScales(l);
+      if (model.Train(points, responses) &&
+          model.LogLikelihood() > bestLikelihood)
+      {
+        bestLikelihood = model.LogLikelihood();
+        bestLengthScale = lengthScales(l);
+      }
+    }
+
+    model.LengthScale() = bestLengthScale;
+    if (bestLengthScale == 0.0 || !model.Train(points, responses))
+    {
+      Warn << "BayesianOptimization: the model could not be trained; "
+          << "terminating optimization." << std::endl;
+      break;
+    }
+
+    // The candidates perturb the best points.
+    const arma::uvec order = arma::sort_index(responses);
+    const size_t numBest = std::min((size_t) 5, (size_t) order.n_elem);
+    std::uniform_int_distribution<size_t> pickBest(0, numBest - 1);
+
+    // Propose the points of the round with the constant liar heuristic.
+    const size_t roundPoints = std::min(pointsPerRound,
+        maxEvaluations - numEvaluations);
+    arma::mat modelPoints = points;
+    arma::vec modelResponses = responses;
+    arma::mat proposals(numDimensions, 0);
+    arma::mat candidates(numDimensions, numCandidates);
+    arma::vec means, variances;
+    for (size_t k = 0; k < roundPoints; ++k)
+    {
+      for (size_t c = 0; c < numCandidates; ++c)
+      {
+        if (c % 2 == 0)
+        {
+          RandomPoint(generator, categoricalDimensions, numCategories, point);
+        }
+        else
+        {
+          point = points.col(order(pickBest(generator)));
+          for (size_t d = 0; d < numDimensions; ++d)
+          {
+            if (!categoricalDimensions[d])
+            {
+              point(d) = std::min(1.0, std::max(0.0,
+                  point(d) + perturbation(generator)));
+            }
+            else if (uniform(generator) * numDimensions < 1.0)
+            {
+              point(d) = std::uniform_int_distribution<size_t>(0,
+                  numCategories(d) - 1)(generator);
+            }
+          }
+        }
+        candidates.col(c) = point;
+      }
+
+      // Pick the candidate with the largest expected improvement that is not
+      // evaluated yet (or proposed in this round).
+      model.Predict(candidates, means, variances);
+      double bestImprovement = -1.0;
+      size_t bestCandidate = numCandidates;
+      for (size_t c = 0; c < numCandidates; ++c)
+      {
+        const double improvement = ExpectedImprovement(means(c),
+            variances(c), best);
+        if (improvement <= bestImprovement)
+          continue;
+
+        bool known = false;
+        for (size_t j = 0; j < modelPoints.n_cols && !known; ++j)
+          known = arma::all(modelPoints.col(j) == candidates.col(c));
+
+        if (!known)
+        {
+          bestImprovement = improvement;
+          bestCandidate = c;
+        }
+      }
+
+      if (bestCandidate == numCandidates)
+        break;
+
+      proposals = arma::join_rows(proposals, candidates.col(bestCandidate));
+
+      // The proposed point gets the best objective as its response.
+      if (k + 1 < roundPoints)
+      {
+        modelPoints = arma::join_rows(modelPoints,
+            candidates.col(bestCandidate));
+        modelResponses.resize(modelResponses.n_elem + 1);
+        modelResponses(modelResponses.n_elem - 1) = best;
+        if (!model.Train(modelPoints, modelResponses))
+          break;
+      }
+    }
+
+    if (proposals.n_cols == 0)
+    {
+      Info << "BayesianOptimization: no unevaluated candidates left; "
+          << "terminating optimization." << std::endl;
+      break;
+    }
+
+    Evaluate(function, proposals, categoricalDimensions, points, objectives);
+
+    Info << "BayesianOptimization: " << numEvaluations << " evaluations, "
+        << "best objective " << objectives.min() << "." << std::endl;
+  }
+
+  // Ties are resolved in favour of the first point evaluated.
+  double bestObjective = std::numeric_limits<double>::max();
+  size_t bestPoint = points.n_cols;
+  for (size_t j = 0; j < points.n_cols; ++j)
+  {
+    if (objectives(j) < bestObjective)
+    {
+      bestObjective = objectives(j);
+      bestPoint = j;
+    }
+  }
+
+  arma::vec parameters(numDimensions, arma::fill::zeros);
+  if (bestPoint < points.n_cols)
+    Parameters(points.col(bestPoint), categoricalDimensions, parameters);
+  bestParameters = parameters;
+
+  return bestObjective;
+}
+
+inline double BayesianOptimization::ExpectedImprovement(const double mean,
+                                                        const double variance,
+                                                        const double best)
+{
+  const double deviation = std::sqrt(variance);
+  if (!(deviation > 0.0))
+    return std::max(best - mean, 0.0);
+
+  const double z = (best - mean) / deviation;
+  const double cdf = 0.5 * std::erfc(-z / std::sqrt(2.0));
+  const double pdf = std::exp(-0.5 * z * z) / std::sqrt(2.0 *
+      arma::datum::pi);
+  return deviation * (z * cdf + pdf);
+}
+
+template<typename FunctionType>
+void BayesianOptimization::Evaluate(
+    FunctionType& function,
+    const arma::mat& batch,
+    const std::vector<bool>& categoricalDimensions,
+    arma::mat& points,
+    arma::vec& objectives)
+{
+  std::vector<arma::vec> parameters(batch.n_cols);
+  for (size_t j = 0; j < batch.n_cols; ++j)
+    Parameters(batch.col(j), categoricalDimensions, parameters[j]);
+
+  // A function with EvaluateAsync() gets all the evaluations of the batch
+  // started at once; otherwise, functions that are known to be thread-safe
+  // are always evaluated in parallel.
+  arma::vec batchObjectives(batch.n_cols);
+  const bool evaluated = TryEvaluateInFlight(function, batch.n_cols,
+      [&](const size_t j) -> const arma::mat& { return parameters[j]; },
+      [&](const size_t j, const double objective)
+      {
+        batchObjectives(j) = objective;
+      });
+
+  if (!evaluated)
+  {
+    ParallelFor(batch.n_cols, [&](const size_t j)
+    {
+      batchObjectives(j) = function.Evaluate(parameters[j]);
+    }, parallelEvaluation ||
+        traits::IsThreadSafeFunction<FunctionType>::value);
+  }
+
+  points = arma::join_rows(points, batch);
+  objectives = arma::join_cols(objectives, batchObjectives);
+  numEvaluations += batch.n_cols;
+}
+
+inline void BayesianOptimization::RandomPoint(
+    std::mt19937& generator,
+    const std::vector<bool>& categoricalDimensions,
+    const arma::Row<size_t>& numCategories,
+    arma::vec& point)
+{
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  point.set_size(categoricalDimensions.size());
+  for (size_t d = 0; d < point.n_elem; ++d)
+  {
+    point(d) = categoricalDimensions[d] ?
+        (double) std::uniform_int_distribution<size_t>(0,
+        numCategories(d) - 1)(generator) : uniform(generator);
+  }
+}
+
+inline void BayesianOptimization::Parameters(
+    const arma::vec& point,
+    const std::vector<bool>& categoricalDimensions,
+    arma::vec& parameters) const
+{
+  parameters.set_size(point.n_elem);
+  for (size_t d = 0; d < point.n_elem; ++d)
+  {
+    parameters(d) = categoricalDimensions[d] ? point(d) :
+        lowerBound + point(d) * (upperBound - lowerBound);
+  }
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,192 @@
+/**
+ * @file gaussian_process.hpp
+ *
+ * A Gaussian process regression model with a Matern 5/2 kernel over mixed
+ * continuous and categorical dimensions, used by BayesianOptimization.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_BAYESIAN_OPTIMIZATION_GAUSSIAN_PROCESS_HPP
+#define ENSMALLEN_BAYESIAN_OPTIMIZATION_GAUSSIAN_PROCESS_HPP
+
+namespace ens {
+
+/**
+ * GaussianProcess models an objective as a Gaussian process with constant
+ * mean and a Matern 5/2 kernel,
+ *
+ *   k(x, y) = (1 + sqrt(5) r + 5 r^2 / 3) exp(-sqrt(5) r),   r = d(x, y) / l,
+ *
+ * where d(x, y)^2 sums the squared differences of the continuous dimensions
+ * and, for each categorical dimension, 1 if the categories differ (as in the
+ * Hamming distance).  The responses are standardized before the model is
+ * trained, and a small noise variance (relative to the variance of the
+ * responses) keeps the kernel matrix positive definite; if its Cholesky
+ * factorization still fails, the noise is increased.
+ */
+class GaussianProcess
+{
+ public:
+  /**
+   * Create a Gaussian process over points with the given dimensions.
+   *
+   * @param categoricalDimensions Whether each dimension is categorical.
+   * @param lengthScale The length scale l of the kernel.
+   * @param noise The noise variance, relative to that of the responses.
+   */
+  GaussianProcess(const std::vector<bool>& categoricalDimensions =
+                      std::vector<bool>(),
+                  const double lengthScale = 0.5,
+                  const double noise = 1e-6) :
+      categoricalDimensions(categoricalDimensions),
+      lengthScale(lengthScale),
+      noise(noise),
+      mean(0.0),
+      scale(1.0),
+      logLikelihood(-std::numeric_limits<double>::infinity())
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * Train the model on the given points (one per column) and their responses.
+   * Returns false if the kernel matrix cannot be factorized; the model must
+   * then not be used.
+   *
+   * @param points The points to train on.
+   * @param responses The response of each point.
+   */
+  bool Train(const arma::mat& points, const arma::vec& responses)
+  {
+    this->points = points;
+    mean = arma::mean(responses);
+    scale = (responses.n_elem > 1) ? std::sqrt(arma::accu(arma::square(
+        responses - mean)) / (responses.n_elem - 1)) : 0.0;
+    if (!(scale > 0.0))
+      scale = 1.0;
+    const arma::vec y = (responses - mean) / scale;
+
+    arma::mat k;
+    Kernel(points, points, k);
+
+    bool factorized = false;
+    for (double jitter = noise; !factorized && jitter < 1.0; jitter *= 10.0)
+    {
+      factorized = arma::chol(lower, k + jitter * arma::eye(k.n_rows,
+          k.n_cols), "lower");
+    }
+    if (!factorized)
+      return false;
+
+    alpha = arma::solve(arma::trimatu(lower.t()),
+        arma::solve(arma::trimatl(lower), y));
+    logLikelihood = -0.5 * arma::dot(y, alpha) -
+        arma::accu(arma::log(lower.diag())) -
+        0.5 * y.n_elem * std::log(2.0 * arma::datum::pi);
+    return true;
+  }
+
+  /**
+   * Predict the mean and the variance of the objective at the given points
+   * (one per column).
+   *
+   * @param queries The points to predict the objective at.
+   * @param means Vector to store the predicted mean of each point in.
+   * @param variances Vector to store the predicted variance of each point in.
+   */
+  void Predict(const arma::mat& queries,
+               arma::vec& means,
+               arma::vec& variances) const
+  {
+    arma::mat k;
+    Kernel(points, queries, k);
+    means = mean + scale * (k.t() * alpha);
+
+    const arma::mat v = arma::solve(arma::trimatl(lower), k);
+    variances = arma::clamp(1.0 - arma::sum(arma::square(v), 0).t(), 0.0,
+        1.0) * (scale * scale);
+  }
+
+  /**
+   * Compute the kernel between each point of a (the rows) and each point of b
+   * (the columns).
+   *
+   * @param a The first points (one per column).
+   * @param b The second points (one per column).
+   * @param k Matrix to store the kernel in.
+   */
+  void Kernel(const arma::mat& a, const arma::mat& b, arma::mat& k) const
+  {
+    const double sqrt5 = std::sqrt(5.0);
+    k.set_size(a.n_cols, b.n_cols);
+    for (size_t j = 0; j < b.n_cols; ++j)
+    {
+      for (size_t i = 0; i < a.n_cols; ++i)
+      {
+        double distance = 0.0;
+        for (size_t d = 0; d < a.n_rows; ++d)
+        {
+          const double diff = a(d, i) - b(d, j);
+          distance += Categorical(d) ? (diff != 0.0 ? 1.0 : 0.0) : diff * diff;
+        }
+
+        const double r = std::sqrt(distance) / lengthScale;
+        k(i, j) = (1.0 + sqrt5 * r + 5.0 * r * r / 3.0) * std::exp(-sqrt5 * r);
+      }
+    }
+  }
+
+  //! Get the log marginal likelihood of the standardized responses.
+  double LogLikelihood() const { return logLikelihood; }
+
+  //! Get the length scale of the kernel.
+  double LengthScale() const { return lengthScale; }
+  //! Modify the length scale of the kernel.
+  double& LengthScale() { return lengthScale; }
+
+  //! Get the relative noise variance.
+  double Noise() const { return noise; }
+  //! Modify the relative noise variance.
+  double& Noise() { return noise; }
+
+ private:
+  //! Get whether dimension d is categorical.
+  bool Categorical(const size_t d) const
+  {
+    return d < categoricalDimensions.size() && categoricalDimensions[d];
+  }
+
+  //! Whether each dimension is categorical.
+  std::vector<bool> categoricalDimensions;
+
+  //! The length scale of the kernel.
+  double lengthScale;
+
+  //! The noise variance, relative to that of the responses.
+  double noise;
+
+  //! The training points.
+  arma::mat points;
+
+  //! The Cholesky factor of the kernel matrix of the training points.
+  arma::mat lower;
+
+  //! The weights of the training points in the predicted mean.
+  arma::vec alpha;
+
+  //! The mean of the responses.
+  double mean;
+
+  //! The standard deviation of the responses.
+  double scale;
+
+  //! The log marginal likelihood of the standardized responses.
+  double logLikelihood;
+};
+
+} // namespace ens
+
+#endif
@@ -65,6 +65,15 @@ namespace ens {
  * }
  * @endcode
  *
+ * The batch size grows when the sample variance of the gradients of the batch
+ * is large with respect to the norm of their mean.  The variance is computed
+ * from the gradient of the batch and the sum of the squared norms of the
+ * gradients of its functions; if the function implements GradientStatistics(),
+ * both are computed in one call for the whole batch, and otherwise Gradient()
+ * is called for each function of the batch.  With parallelBatch, each batch is
+ * split into one part per OpenMP thread, and the statistics of the parts are
+ * added up.
+ *
  * Big-batch SGD can optimize differentiable separable functions.  For more
  * details, see the documentation on function types included with this
  * distribution or on the ensmallen website.
@@ -91,13 +100,17 @@ class BigBatchSGD
    * @param tolerance Maximum absolute tolerance to terminate algorithm.
    * @param shuffle If true, the batch order is shuffled; otherwise, each
    *        batch is visited in linear order.
+   * @param parallelBatch If true, split the gradient statistics of each batch
+   *        across OpenMP threads; the function's GradientStatistics() or
+   *        separable Gradient() must be safe to call concurrently.
    */
   BigBatchSGD(const size_t batchSize = 1000,
               const double stepSize = 0.01,
               const double batchDelta = 0.1,
               const size_t maxIterations = 100000,
               const double tolerance = 1e-5,
-              const bool shuffle = true);
+              const bool shuffle = true,
+              const bool parallelBatch = false);
   /**
    * Optimize the given function using big-batch SGD.  The given starting point
    * will be modified to store the finishing point of the algorithm, and the
@@ -142,12 +155,49 @@ class BigBatchSGD
   //! Modify whether or not the individual functions are shuffled.
   bool& Shuffle() { return shuffle; }
 
+  //! Get whether the gradient statistics of each batch are computed in
+  //! parallel.
+  bool ParallelBatch() const { return parallelBatch; }
+  //! Modify whether the gradient statistics of each batch are computed in
+  //! parallel.
+  bool& ParallelBatch() { return parallelBatch; }
+
   //! Get the update policy.
   UpdatePolicyType UpdatePolicy() const { return updatePolicy; }
   //! Modify the update policy.
   UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
 
+  //! Get the workspace the temporaries are taken from (NULL if none).
+  ens::Workspace* Workspace() const { return workspace; }
+  //! Modify the workspace the temporaries are taken from (NULL if none).
+  ens::Workspace*& Workspace() { return workspace; }
+
+  //! Get how the final objective is computed.
+  const ens::ObjectiveEstimate& ObjectiveEstimate() const
+  { return objectiveEstimate; }
+  //! Modify how the final objective is computed.
+  ens::ObjectiveEstimate& ObjectiveEstimate() { return objectiveEstimate; }
+
  private:
+  /**
+   * Compute the sum of the squared deviations of the gradients of a batch from
+   * their mean, given their sum and the sum of their squared norms.
+   *
+   * @param gradient Sum of the gradients of the batch.
+   * @param sumSquaredNorms Sum of the squared norms of the gradients.
+   * @param batchSize Number of gradients in the batch.
+   */
+  static double SumSquaredDeviations(const arma::mat& gradient,
+                                     const double sumSquaredNorms,
+                                     const size_t batchSize)
+  {
+    const double deviations = sumSquaredNorms -
+        arma::dot(gradient, gradient) / batchSize;
+
+    // Rounding may make the difference slightly negative.
+    return std::max(0.0, deviations);
+  }
+
   //! The size of the current batch.
   size_t batchSize;
 
@@ -167,8 +217,17 @@ class BigBatchSGD
   //! iterating.
   bool shuffle;
 
+  //! Whether the gradient statistics of each batch are computed in parallel.
+  bool parallelBatch;
+
   //! The update policy used to update the parameters in each iteration.
   UpdatePolicyType updatePolicy;
+
+  //! The workspace the temporaries are taken from (NULL if none).
+  ens::Workspace* workspace;
+
+  //! How the final objective is computed.
+  ens::ObjectiveEstimate objectiveEstimate;
 };
 
 using BBS_Armijo = BigBatchSGD<BacktrackingLineSearch>;
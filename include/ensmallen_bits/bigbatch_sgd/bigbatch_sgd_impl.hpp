@@ -26,14 +26,17 @@ BigBatchSGD<UpdatePolicyType>::BigBatchSGD(
     const double batchDelta,
     const size_t maxIterations,
     const double tolerance,
-    const bool shuffle) :
+    const bool shuffle,
+    const bool parallelBatch) :
     batchSize(batchSize),
     stepSize(stepSize),
     batchDelta(batchDelta),
     maxIterations(maxIterations),
     tolerance(tolerance),
     shuffle(shuffle),
-    updatePolicy(UpdatePolicyType())
+    parallelBatch(parallelBatch),
+    updatePolicy(UpdatePolicyType()),
+    workspace(NULL)
 { /* Nothing to do. */ }
 
 //! Optimize the function (minimize).
@@ -56,11 +59,17 @@ double BigBatchSGD<UpdatePolicyType>::Optimize(
   double overallObjective = 0;
   double lastObjective = DBL_MAX;
   bool reset = false;
-  arma::mat delta0, delta1;
+
+  // The temporaries are taken from the given workspace, or else from a local
+  // one.
+  ens::Workspace localWorkspace;
+  ens::Workspace& ws = (workspace != NULL) ? *workspace : localWorkspace;
 
   // Now iterate!
-  arma::mat gradient(iterate.n_rows, iterate.n_cols);
-  arma::mat functionGradient(iterate.n_rows, iterate.n_cols);
+  arma::mat& gradient = ws.Get<arma::mat>(0);
+  arma::mat& functionGradient = ws.Get<arma::mat>(1);
+  gradient.set_size(iterate.n_rows, iterate.n_cols);
+  functionGradient.set_size(iterate.n_rows, iterate.n_cols);
   const size_t actualMaxIterations = (maxIterations == 0) ?
       std::numeric_limits<size_t>::max() : maxIterations;
   for (size_t i = 0; i < actualMaxIterations; /* incrementing done manually */)
@@ -70,7 +79,7 @@ double BigBatchSGD<UpdatePolicyType>::Optimize(
     {
       // Output current objective function.
       Info << "Big-batch SGD: iteration " << i << ", objective "
-          << overallObjective << "." << std::endl;
+          << overallObjective << ".\n";
 
       if (std::isnan(overallObjective) || std::isinf(overallObjective))
       {
@@ -106,25 +115,14 @@ double BigBatchSGD<UpdatePolicyType>::Optimize(
         std::min(batchSize, actualMaxIterations - i),
         numFunctions - currentFunction);
 
-    size_t k = 1;
-    double vB = 0;
-
-    // Compute the stochastic gradient estimation.
-    f.Gradient(iterate, currentFunction, gradient, 1);
-
-    delta1 = gradient;
-    for (size_t j = 1; j < effectiveBatchSize; ++j, ++k)
-    {
-      f.Gradient(iterate, currentFunction + j, functionGradient, 1);
-      delta0 = delta1 + (functionGradient - delta1) / k;
-
-      // Compute sample variance.
-      vB += arma::norm(functionGradient - delta1, 2.0) *
-          arma::norm(functionGradient - delta0, 2.0);
+    // Compute the stochastic gradient estimation, and the sum of the squared
+    // norms of the gradients of the batch for its sample variance.
+    double sumSquaredNorms;
+    BatchGradientStatistics(f, iterate, currentFunction, gradient,
+        sumSquaredNorms, effectiveBatchSize, parallelBatch);
 
-      delta1 = delta0;
-      gradient += functionGradient;
-    }
+    double vB = SumSquaredDeviations(gradient, sumSquaredNorms,
+        effectiveBatchSize);
     double gB = std::pow(arma::norm(gradient / effectiveBatchSize, 2), 2.0);
 
     // Reset the batch size update process counter.
@@ -147,18 +145,15 @@ double BigBatchSGD<UpdatePolicyType>::Optimize(
         // Update the stochastic gradient estimation.
         const size_t batchStart = (currentFunction + batchSize + batchOffset
             - 1) < numFunctions ? currentFunction + batchSize - 1 : 0;
-        for (size_t j = 0; j < batchOffset; ++j, ++k)
-        {
-          f.Gradient(iterate, batchStart + j, functionGradient, 1);
-          delta0 = delta1 + (functionGradient - delta1) / (k + 1);
-
-          // Compute sample variance.
-          vB += arma::norm(functionGradient - delta1, 2.0) *
-              arma::norm(functionGradient - delta0, 2.0);
-
-          delta1 = delta0;
-          gradient += functionGradient;
-        }
+        double offsetSquaredNorms;
+        BatchGradientStatistics(f, iterate, batchStart, functionGradient,
+            offsetSquaredNorms, batchOffset, parallelBatch);
+        gradient += functionGradient;
+        sumSquaredNorms += offsetSquaredNorms;
+
+        // Compute sample variance.
+        vB = SumSquaredDeviations(gradient, sumSquaredNorms,
+            batchSize + batchOffset);
         gB = std::pow(arma::norm(gradient / (batchSize + batchOffset), 2), 2.0);
 
         // Update the batchSize.
@@ -186,13 +181,13 @@ double BigBatchSGD<UpdatePolicyType>::Optimize(
   Info << "Big-batch SGD: maximum iterations (" << maxIterations << ") "
       << "reached; terminating optimization." << std::endl;
 
-  // Calculate final objective.
-  overallObjective = 0;
-  for (size_t i = 0; i < numFunctions; i += batchSize)
-  {
-    const size_t effectiveBatchSize = std::min(batchSize, numFunctions - i);
-    overallObjective += f.Evaluate(iterate, i, effectiveBatchSize);
-  }
+  // Calculate final objective.  When reusing the batch objectives of the last
+  // pass, scale them up to all the functions if the pass is not complete.
+  if (!objectiveEstimate.IsReuse())
+    overallObjective = objectiveEstimate.Evaluate(f, iterate, batchSize);
+  else if (currentFunction > 0 && currentFunction < numFunctions)
+    overallObjective *= (double) numFunctions / currentFunction;
+
   return overallObjective;
 }
 
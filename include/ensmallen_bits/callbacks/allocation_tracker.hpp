@@ -0,0 +1,201 @@
+/**
+ * @file allocation_tracker.hpp
+ *
+ * Callback that records the number of allocations made during each step of an
+ * optimization, and the memory the optimization used.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_ALLOCATION_TRACKER_HPP
+#define ENSMALLEN_CALLBACKS_ALLOCATION_TRACKER_HPP
+
+#include <algorithm>
+#include <vector>
+
+namespace ens {
+
+/**
+ * Record the number of allocations counted by AllocationCount() during each
+ * step of the optimization, which is only meaningful when ensmallen is
+ * compiled with ENS_COUNT_ALLOCATIONS.  A step is everything between two
+ * StepTaken() events (the first step also includes the setup of the
+ * optimizer); the work at the epoch boundaries, between the end of an epoch and
+ * the beginning of the next one, is not attributed to any step.
+ *
+ * The counts of the first maxSteps steps are kept, in memory reserved by the
+ * constructor, so that recording them does not allocate.
+ *
+ * The tracker also reports the peak of the bytes allocated by Armadillo since
+ * it was constructed (or since the last call to ResetBytes()) until the end of
+ * the optimization, beyond those already live then: the state of the optimizer
+ * (like the moments of Adam or the history of L_BFGS, which some optimizers
+ * allocate before BeginOptimization()) and the temporaries of the function.
+ * It also reports the bytes still allocated when the optimization ended (like
+ * the history L_BFGS keeps for the next call).  The peak is global, so it
+ * includes the allocations of other threads, and only one optimization should
+ * be tracked at a time.  The EstimateMemory() methods of the optimizers give
+ * the state part of the figure before the optimization starts.
+ *
+ * @code
+ * AllocationTracker tracker;
+ * optimizer.Optimize(f, coordinates, tracker);
+ * // All the steps but the first should be free of allocations.
+ * const size_t allocations = tracker.MaxAllocations(1);
+ * const size_t bytes = tracker.PeakBytes();
+ * @endcode
+ */
+class AllocationTracker
+{
+ public:
+  /**
+   * Set up the callback, for at most the given number of recorded steps.
+   *
+   * @param maxSteps Maximum number of steps to record.
+   */
+  AllocationTracker(const size_t maxSteps = 10000) :
+      maxSteps(maxSteps),
+      last(0),
+      startBytes(0),
+      peakBytes(0),
+      retainedBytes(0)
+  {
+    allocations.reserve(maxSteps);
+    ResetBytes();
+  }
+
+  /**
+   * Start measuring the bytes from the current point, for instance before
+   * tracking another optimization with the same tracker.
+   */
+  void ResetBytes()
+  {
+    startBytes = AllocatedBytes().load();
+    ResetPeakAllocatedBytes();
+  }
+
+  /**
+   * Callback function called at the beginning of the optimization.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Starting point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void BeginOptimization(OptimizerType& /* optimizer */,
+                         FunctionType& /* function */,
+                         MatType& /* coordinates */)
+  {
+    allocations.clear();
+    last = AllocationCount().load();
+  }
+
+  /**
+   * Callback function called at the end of the optimization; the peak and the
+   * retained bytes are recorded.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The final point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndOptimization(OptimizerType& /* optimizer */,
+                       FunctionType& /* function */,
+                       MatType& /* coordinates */)
+  {
+    const size_t peak = PeakAllocatedBytes().load();
+    const size_t live = AllocatedBytes().load();
+    peakBytes = (peak > startBytes) ? peak - startBytes : 0;
+    retainedBytes = (live > startBytes) ? live - startBytes : 0;
+  }
+
+  /**
+   * Callback function called at the beginning of an epoch; the count starts
+   * again from there.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param epoch The index of the epoch.
+   * @param objective Objective value of the last epoch.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool BeginEpoch(OptimizerType& /* optimizer */,
+                  FunctionType& /* function */,
+                  const MatType& /* coordinates */,
+                  const size_t /* epoch */,
+                  const double /* objective */)
+  {
+    last = AllocationCount().load();
+    return false;
+  }
+
+  /**
+   * Callback function called after the optimizer has taken a step.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The updated point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool StepTaken(OptimizerType& /* optimizer */,
+                 FunctionType& /* function */,
+                 MatType& /* coordinates */)
+  {
+    const size_t count = AllocationCount().load();
+    if (allocations.size() < maxSteps)
+      allocations.push_back(count - last);
+    last = count;
+    return false;
+  }
+
+  //! Get the peak of the bytes allocated until the end of the last
+  //! optimization, beyond those live when the measurement started.
+  size_t PeakBytes() const { return peakBytes; }
+
+  //! Get the bytes allocated during the last optimization that were still
+  //! allocated when it ended.
+  size_t RetainedBytes() const { return retainedBytes; }
+
+  //! Get the number of allocations of each recorded step.
+  const std::vector<size_t>& Allocations() const { return allocations; }
+
+  /**
+   * Get the largest number of allocations of a recorded step, after the given
+   * number of warm-up steps.
+   *
+   * @param warmup Number of first steps to ignore.
+   */
+  size_t MaxAllocations(const size_t warmup = 0) const
+  {
+    size_t result = 0;
+    for (size_t i = warmup; i < allocations.size(); ++i)
+      result = std::max(result, allocations[i]);
+    return result;
+  }
+
+ private:
+  //! The maximum number of recorded steps.
+  size_t maxSteps;
+
+  //! The allocation count at the end of the last step.
+  size_t last;
+
+  //! The number of allocations of each recorded step.
+  std::vector<size_t> allocations;
+
+  //! The live bytes when the measurement started.
+  size_t startBytes;
+
+  //! The peak of the bytes of the last optimization.
+  size_t peakBytes;
+
+  //! The bytes still allocated at the end of the last optimization.
+  size_t retainedBytes;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,412 @@
+/**
+ * @file async_checkpoint.hpp
+ *
+ * Implementation of the asynchronous checkpoint callback, which saves the
+ * iterate and the state of the optimizer at the end of the epochs from a
+ * background thread.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_ASYNC_CHECKPOINT_HPP
+#define ENSMALLEN_CALLBACKS_ASYNC_CHECKPOINT_HPP
+
+#include <cstdio>
+#include <exception>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+#ifdef ENS_USE_MMAP
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
+namespace ens {
+
+/**
+ * Save a checkpoint of the optimization (the coordinates and, if the optimizer
+ * has a Serialize() method, the state of the optimizer, as written by
+ * SaveState()) every given number of epochs, without waiting for the disk.
+ * At the end of an epoch, the checkpoint is serialized into one of two staging
+ * buffers in memory, and a background thread writes it into the file while the
+ * optimization goes on; the next checkpoint is serialized into the other
+ * buffer, and only then waits for the previous write, if it has not finished
+ * yet.  So the optimization only stalls for the copy into memory, as long as
+ * writing a checkpoint takes less time than the epochs between two of them.
+ * The two buffers are kept between the checkpoints, so after the first two,
+ * no memory is allocated; they hold twice the size of a checkpoint.
+ *
+ * A checkpoint is first written into the file with the ".tmp" suffix, which is
+ * then renamed to the given file name, so that the file always holds a whole
+ * checkpoint.  If mapped is true (and mmap() is available), the file is
+ * written through a shared memory mapping instead of a stream, which avoids a
+ * copy through the buffers of the stream.  Errors of the background thread are
+ * thrown (as std::runtime_error) by the next checkpoint or at the end of the
+ * optimization, when the last write is waited for.
+ *
+ * The state of the optimizer is saved with its Serialize() method with the
+ * default matrix types (such as SGD::Serialize<arma::mat>()).  A checkpoint is
+ * loaded with Load(), after which the optimization can be resumed as after
+ * LoadState().
+ *
+ * @code
+ * AsyncCheckpoint checkpoint("adam.ckpt");
+ * Adam optimizer(0.001, 32, 100 * f.NumFunctions());
+ * optimizer.ResetPolicy() = false;
+ * optimizer.Optimize(f, coordinates, checkpoint);
+ *
+ * // Later, resume from the last checkpoint.
+ * AsyncCheckpoint::Load("adam.ckpt", coordinates, optimizer);
+ * optimizer.Optimize(f, coordinates);
+ * @endcode
+ */
+class AsyncCheckpoint
+{
+ public:
+  /**
+   * Set up the asynchronous checkpoint callback.
+   *
+   * @param filename Name of the file to save the checkpoints into.
+   * @param period Number of epochs between two checkpoints.
+   * @param mapped Whether to write the file through a memory mapping.
+   */
+  AsyncCheckpoint(const std::string& filename,
+                  const size_t period = 1,
+                  const bool mapped = false) :
+      filename(filename),
+      period(period),
+      mapped(mapped),
+      next(0),
+      checkpoints(0)
+  {
+    if (period == 0)
+    {
+      throw std::invalid_argument("AsyncCheckpoint: the period must be "
+          "positive!");
+    }
+  }
+
+  //! The background thread uses the buffers of the object, so it can't be
+  //! copied.
+  AsyncCheckpoint(const AsyncCheckpoint& other) = delete;
+  //! The background thread uses the buffers of the object, so it can't be
+  //! copied.
+  AsyncCheckpoint& operator=(const AsyncCheckpoint& other) = delete;
+
+  //! Wait for the last write to finish; its errors are ignored.
+  ~AsyncCheckpoint()
+  {
+    if (writer.joinable())
+      writer.join();
+  }
+
+  /**
+   * Callback function called at the end of a pass over the data; a checkpoint
+   * is started at the end of every period epochs.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the current epoch.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType,
+           typename ElemType>
+  void EndEpoch(OptimizerType& optimizer,
+                FunctionType& /* function */,
+                const MatType& coordinates,
+                const size_t epoch,
+                const ElemType /* objective */)
+  {
+    if ((epoch + 1) % period == 0)
+      Checkpoint(optimizer, coordinates);
+  }
+
+  /**
+   * Callback function called at the end of the optimization; it waits for the
+   * last checkpoint to be written.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The final point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndOptimization(OptimizerType& /* optimizer */,
+                       FunctionType& /* function */,
+                       MatType& /* coordinates */)
+  {
+    Wait();
+  }
+
+  /**
+   * Serialize a checkpoint of the given optimizer and coordinates into the
+   * staging buffer that is not being written, and start writing it once the
+   * previous checkpoint is written.
+   *
+   * @param optimizer The optimizer to save the state of.
+   * @param coordinates The coordinates to save.
+   */
+  template<typename OptimizerType, typename MatType>
+  void Checkpoint(OptimizerType& optimizer, const MatType& coordinates)
+  {
+    std::vector<char>& staging = buffers[next];
+    staging.clear();
+    {
+      StagingBuffer buffer(staging);
+      std::ostream stream(&buffer);
+      BinaryArchive ar(stream);
+      size_t magic = stateArchiveMagic;
+      ar.Size(magic);
+      ar(const_cast<MatType&>(coordinates));
+      SerializeOptimizer(ar, optimizer);
+    }
+
+    Wait();
+    writer = std::thread(&AsyncCheckpoint::Write, this, next);
+    next = 1 - next;
+    ++checkpoints;
+  }
+
+  //! Wait for the last checkpoint to be written, and throw its error, if any.
+  void Wait()
+  {
+    if (writer.joinable())
+      writer.join();
+
+    if (error)
+    {
+      std::exception_ptr e = error;
+      error = nullptr;
+      std::rethrow_exception(e);
+    }
+  }
+
+  /**
+   * Load the coordinates and the state of the optimizer from the given
+   * checkpoint.  A std::runtime_error is thrown if the file is not a
+   * checkpoint, or does not hold the state of an optimizer.
+   *
+   * @param filename Name of the checkpoint file.
+   * @param coordinates The coordinates to load into.
+   * @param optimizer The optimizer to load the state of.
+   */
+  template<typename MatType, typename OptimizerType>
+  static void Load(const std::string& filename,
+                   MatType& coordinates,
+                   OptimizerType& optimizer)
+  {
+    std::ifstream stream(filename.c_str(), std::ios::binary);
+    BinaryArchive ar(Open(stream, filename));
+    ar(coordinates);
+    bool hasState;
+    ar(hasState);
+    if (!hasState)
+    {
+      throw std::runtime_error("AsyncCheckpoint::Load(): the checkpoint '" +
+          filename + "' does not hold the state of an optimizer!");
+    }
+
+    ar(optimizer);
+  }
+
+  /**
+   * Load the coordinates from the given checkpoint.  A std::runtime_error is
+   * thrown if the file is not a checkpoint.
+   *
+   * @param filename Name of the checkpoint file.
+   * @param coordinates The coordinates to load into.
+   */
+  template<typename MatType>
+  static void Load(const std::string& filename, MatType& coordinates)
+  {
+    std::ifstream stream(filename.c_str(), std::ios::binary);
+    BinaryArchive ar(Open(stream, filename));
+    ar(coordinates);
+  }
+
+  //! Get the name of the checkpoint file.
+  const std::string& Filename() const { return filename; }
+
+  //! Get the number of epochs between two checkpoints.
+  size_t Period() const { return period; }
+
+  //! Get whether the file is written through a memory mapping.
+  bool Mapped() const { return mapped; }
+
+  //! Get the number of checkpoints started so far.
+  size_t Checkpoints() const { return checkpoints; }
+
+ private:
+  //! A stream buffer that appends to a vector, reusing its memory.
+  class StagingBuffer : public std::streambuf
+  {
+   public:
+    StagingBuffer(std::vector<char>& data) : data(data) { }
+
+   protected:
+    int_type overflow(int_type c)
+    {
+      if (c != traits_type::eof())
+        data.push_back(traits_type::to_char_type(c));
+      return c;
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n)
+    {
+      data.insert(data.end(), s, s + n);
+      return n;
+    }
+
+   private:
+    std::vector<char>& data;
+  };
+
+  //! Save the state of an optimizer with a Serialize() method.
+  template<typename OptimizerType>
+  static typename std::enable_if<
+      traits::HasSerialize<OptimizerType>::value>::type
+  SerializeOptimizer(BinaryArchive& ar, OptimizerType& optimizer)
+  {
+    bool hasState = true;
+    ar(hasState);
+    ar(optimizer);
+  }
+
+  //! Optimizers without a Serialize() method only save the coordinates.
+  template<typename OptimizerType>
+  static typename std::enable_if<
+      !traits::HasSerialize<OptimizerType>::value>::type
+  SerializeOptimizer(BinaryArchive& ar, OptimizerType& /* optimizer */)
+  {
+    bool hasState = false;
+    ar(hasState);
+  }
+
+  //! Check that the given stream is open and holds a checkpoint.
+  static std::istream& Open(std::ifstream& stream, const std::string& filename)
+  {
+    if (!stream.is_open())
+    {
+      throw std::runtime_error("AsyncCheckpoint::Load(): cannot open file '" +
+          filename + "'!");
+    }
+
+    BinaryArchive ar(stream);
+    size_t magic;
+    ar.Size(magic);
+    if (magic != stateArchiveMagic)
+    {
+      throw std::runtime_error("AsyncCheckpoint::Load(): the file '" +
+          filename + "' is not a checkpoint!");
+    }
+
+    return stream;
+  }
+
+  //! Write the given staging buffer into the file (on the background thread).
+  void Write(const size_t index)
+  {
+    try
+    {
+      const std::vector<char>& data = buffers[index];
+      const std::string tmpFilename = filename + ".tmp";
+      #ifdef ENS_USE_MMAP
+      if (mapped)
+        WriteMapped(tmpFilename, data);
+      else
+        WriteStream(tmpFilename, data);
+      #else
+      WriteStream(tmpFilename, data);
+      #endif
+
+      if (std::rename(tmpFilename.c_str(), filename.c_str()) != 0)
+        Fail(filename, "cannot be replaced");
+    }
+    catch (...)
+    {
+      error = std::current_exception();
+    }
+  }
+
+  //! Write the given bytes into the given file with a stream.
+  static void WriteStream(const std::string& name,
+                          const std::vector<char>& data)
+  {
+    std::ofstream stream(name.c_str(), std::ios::binary);
+    if (!stream.is_open())
+      Fail(name, "cannot be opened");
+
+    stream.write(data.data(), data.size());
+    stream.close();
+    if (!stream)
+      Fail(name, "cannot be written");
+  }
+
+  #ifdef ENS_USE_MMAP
+  //! Write the given bytes into the given file through a memory mapping.
+  static void WriteMapped(const std::string& name,
+                          const std::vector<char>& data)
+  {
+    const int fd = open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      Fail(name, "cannot be opened");
+
+    if (ftruncate(fd, data.size()) != 0)
+    {
+      close(fd);
+      Fail(name, "cannot be resized");
+    }
+
+    void* address = mmap(NULL, data.size(), PROT_WRITE, MAP_SHARED, fd, 0);
+    // The mapping stays valid after the file is closed.
+    close(fd);
+    if (address == MAP_FAILED)
+      Fail(name, "cannot be mapped");
+
+    std::copy(data.begin(), data.end(), static_cast<char*>(address));
+    const bool synced = (msync(address, data.size(), MS_SYNC) == 0);
+    munmap(address, data.size());
+    if (!synced)
+      Fail(name, "cannot be written");
+  }
+  #endif
+
+  //! Throw an error about the given file.
+  static void Fail(const std::string& name, const std::string& reason)
+  {
+    throw std::runtime_error("AsyncCheckpoint: file '" + name + "' " + reason +
+        "!");
+  }
+
+  //! The name of the checkpoint file.
+  std::string filename;
+
+  //! The number of epochs between two checkpoints.
+  size_t period;
+
+  //! Whether the file is written through a memory mapping.
+  bool mapped;
+
+  //! The two staging buffers.
+  std::vector<char> buffers[2];
+
+  //! The staging buffer the next checkpoint is serialized into.
+  size_t next;
+
+  //! The number of checkpoints started so far.
+  size_t checkpoints;
+
+  //! The thread writing the last checkpoint.
+  std::thread writer;
+
+  //! The error of the last write, if any.
+  std::exception_ptr error;
+};
+
+} // namespace ens
+
+#endif
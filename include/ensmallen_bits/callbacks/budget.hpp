@@ -0,0 +1,241 @@
+/**
+ * @file budget.hpp
+ *
+ * Implementation of the budget callback function, which stops the optimization
+ * once a wall-clock time or evaluation budget is used up.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_BUDGET_HPP
+#define ENSMALLEN_CALLBACKS_BUDGET_HPP
+
+namespace ens {
+
+/**
+ * Stop the optimization once any of the given budgets is used up: a maximum
+ * wall-clock time, a maximum number of objective evaluations, or a maximum
+ * number of gradient evaluations (a limit of 0 means no limit).
+ *
+ * The evaluations are counted from the callback events of the optimizer: each
+ * Evaluate() event counts one objective evaluation, each Gradient() event one
+ * gradient evaluation, and each EvaluateWithGradient() event one of each.  (So
+ * for separable functions, an evaluation is one batch.)  The time is checked
+ * at every event, so the optimization stops at the first event after the
+ * deadline; the time between two events (for instance, a line search of
+ * L_BFGS, or one generation of CMAES or CNE) is not interrupted.
+ *
+ * The counters are reset at the beginning of each optimization.
+ *
+ * @code
+ * // Stop after 50 milliseconds or 1000 evaluations, whichever comes first.
+ * Budget budget(0.05, 1000);
+ * optimizer.Optimize(f, coordinates, budget);
+ * if (budget.Exhausted())
+ *   std::cout << "Stopped early." << std::endl;
+ * @endcode
+ */
+class Budget
+{
+ public:
+  /**
+   * Set up the budget callback with the given limits.
+   *
+   * @param maxTime Maximum wall-clock time in seconds (0 means no limit).
+   * @param maxEvaluations Maximum number of objective evaluations (0 means no
+   *     limit).
+   * @param maxGradients Maximum number of gradient evaluations (0 means no
+   *     limit).
+   */
+  Budget(const double maxTime = 0,
+         const size_t maxEvaluations = 0,
+         const size_t maxGradients = 0) :
+      maxTime(maxTime),
+      maxEvaluations(maxEvaluations),
+      maxGradients(maxGradients),
+      evaluations(0),
+      gradients(0),
+      exhausted(false)
+  { /* Nothing to do here. */ }
+
+  /**
+   * Callback function called at the beginning of the optimization.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Starting point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void BeginOptimization(OptimizerType& /* optimizer */,
+                         FunctionType& /* function */,
+                         MatType& /* coordinates */)
+  {
+    evaluations = 0;
+    gradients = 0;
+    exhausted = false;
+    timer.tic();
+  }
+
+  /**
+   * Callback function called after the objective is evaluated.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param objective Objective value at the current point.
+   * @return true if the budget is used up.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType,
+           typename ElemType>
+  bool Evaluate(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const ElemType /* objective */)
+  {
+    ++evaluations;
+    return Check();
+  }
+
+  /**
+   * Callback function called after the gradient is evaluated.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param gradient Gradient at the current point.
+   * @return true if the budget is used up.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType,
+           typename GradType>
+  bool Gradient(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const GradType& /* gradient */)
+  {
+    ++gradients;
+    return Check();
+  }
+
+  /**
+   * Callback function called after the objective and the gradient are
+   * evaluated together.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param objective Objective value at the current point.
+   * @param gradient Gradient at the current point.
+   * @return true if the budget is used up.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType,
+           typename ElemType, typename GradType>
+  bool EvaluateWithGradient(OptimizerType& /* optimizer */,
+                            FunctionType& /* function */,
+                            const MatType& /* coordinates */,
+                            const ElemType /* objective */,
+                            const GradType& /* gradient */)
+  {
+    ++evaluations;
+    ++gradients;
+    return Check();
+  }
+
+  /**
+   * Callback function called at the end of a pass over the data.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the current epoch.
+   * @return true if the budget is used up.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType,
+           typename ElemType>
+  bool EndEpoch(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const size_t /* epoch */,
+                const ElemType /* objective */)
+  {
+    return Check();
+  }
+
+  /**
+   * Callback function called after the optimizer has taken a step.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The updated point.
+   * @return true if the budget is used up.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool StepTaken(OptimizerType& /* optimizer */,
+                 FunctionType& /* function */,
+                 MatType& /* coordinates */)
+  {
+    return Check();
+  }
+
+  //! Get the maximum wall-clock time in seconds (0 means no limit).
+  double MaxTime() const { return maxTime; }
+  //! Modify the maximum wall-clock time in seconds (0 means no limit).
+  double& MaxTime() { return maxTime; }
+
+  //! Get the maximum number of objective evaluations (0 means no limit).
+  size_t MaxEvaluations() const { return maxEvaluations; }
+  //! Modify the maximum number of objective evaluations (0 means no limit).
+  size_t& MaxEvaluations() { return maxEvaluations; }
+
+  //! Get the maximum number of gradient evaluations (0 means no limit).
+  size_t MaxGradients() const { return maxGradients; }
+  //! Modify the maximum number of gradient evaluations (0 means no limit).
+  size_t& MaxGradients() { return maxGradients; }
+
+  //! Get the number of objective evaluations of the last optimization.
+  size_t Evaluations() const { return evaluations; }
+
+  //! Get the number of gradient evaluations of the last optimization.
+  size_t Gradients() const { return gradients; }
+
+  //! Get whether the last optimization was stopped because a budget was used
+  //! up.
+  bool Exhausted() const { return exhausted; }
+
+ private:
+  //! Check whether a budget is used up.
+  bool Check()
+  {
+    if ((maxEvaluations > 0 && evaluations >= maxEvaluations) ||
+        (maxGradients > 0 && gradients >= maxGradients) ||
+        (maxTime > 0 && timer.toc() >= maxTime))
+    {
+      exhausted = true;
+    }
+
+    return exhausted;
+  }
+
+  //! The maximum wall-clock time in seconds.
+  double maxTime;
+  //! The maximum number of objective evaluations.
+  size_t maxEvaluations;
+  //! The maximum number of gradient evaluations.
+  size_t maxGradients;
+
+  //! The number of objective evaluations so far.
+  size_t evaluations;
+  //! The number of gradient evaluations so far.
+  size_t gradients;
+  //! Whether a budget is used up.
+  bool exhausted;
+
+  //! Locally-stored timer object.
+  arma::wall_clock timer;
+};
+
+} // namespace ens
+
+#endif
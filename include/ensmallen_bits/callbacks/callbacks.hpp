@@ -0,0 +1,313 @@
+/**
+ * @file callbacks.hpp
+ *
+ * Dispatch of optimizer events to user-supplied callbacks.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_CALLBACKS_HPP
+#define ENSMALLEN_CALLBACKS_CALLBACKS_HPP
+
+#include "traits.hpp"
+
+namespace ens {
+
+/**
+ * Callback forwards the events of an optimization to any number of callback
+ * objects.  A callback object may implement any subset of the functions
+ * below (with void or bool return type); the others are skipped at compile
+ * time, so passing no callbacks costs nothing.  If any callback returns true,
+ * the optimizer terminates as soon as possible.
+ *
+ *  - BeginOptimization(optimizer, function, coordinates)
+ *  - EndOptimization(optimizer, function, coordinates)
+ *  - Evaluate(optimizer, function, coordinates, objective)
+ *  - Gradient(optimizer, function, coordinates, gradient)
+ *  - EvaluateWithGradient(optimizer, function, coordinates, objective,
+ *                         gradient)
+ *  - BeginEpoch(optimizer, function, coordinates, epoch, objective)
+ *  - EndEpoch(optimizer, function, coordinates, epoch, objective)
+ *  - StepTaken(optimizer, function, coordinates)
+ *  - TerminationRequested(optimizer, function, coordinates)
+ *
+ * Every callback is always notified, even if an earlier one already asked for
+ * termination.  When callbacks ask for termination at any event but
+ * EndOptimization(), TerminationRequested() is then called on all of them.
+ */
+class Callback
+{
+ public:
+  /**
+   * Called at the beginning of the optimization.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Starting point.
+   * @param callbacks The callback functions.
+   * @return true if the optimization should be terminated.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static bool BeginOptimization(OptimizerType& optimizer,
+                                FunctionType& function,
+                                MatType& coordinates,
+                                CallbackTypes&... callbacks)
+  {
+    bool result = false;
+    const bool dummy[] = { false, (result |= callbacks::traits::
+        InvokeBeginOptimization(callbacks, optimizer, function,
+        coordinates))... };
+    (void) dummy;
+    if (result)
+      TerminationRequested(optimizer, function, coordinates, callbacks...);
+    return result;
+  }
+
+  /**
+   * Called at the end of the optimization.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Final point.
+   * @param callbacks The callback functions.
+   * @return true if the optimization should be terminated.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static bool EndOptimization(OptimizerType& optimizer,
+                              FunctionType& function,
+                              MatType& coordinates,
+                              CallbackTypes&... callbacks)
+  {
+    bool result = false;
+    const bool dummy[] = { false, (result |= callbacks::traits::
+        InvokeEndOptimization(callbacks, optimizer, function,
+        coordinates))... };
+    (void) dummy;
+    return result;
+  }
+
+  /**
+   * Called after the objective is evaluated.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param objective Objective value at the current point.
+   * @param callbacks The callback functions.
+   * @return true if the optimization should be terminated.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename ElemType,
+           typename... CallbackTypes>
+  static bool Evaluate(OptimizerType& optimizer,
+                       FunctionType& function,
+                       const MatType& coordinates,
+                       const ElemType objective,
+                       CallbackTypes&... callbacks)
+  {
+    bool result = false;
+    const bool dummy[] = { false, (result |= callbacks::traits::
+        InvokeEvaluate(callbacks, optimizer, function, coordinates,
+        objective))... };
+    (void) dummy;
+    if (result)
+      TerminationRequested(optimizer, function, coordinates, callbacks...);
+    return result;
+  }
+
+  /**
+   * Called after the gradient is evaluated.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param gradient Gradient at the current point.
+   * @param callbacks The callback functions.
+   * @return true if the optimization should be terminated.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  static bool Gradient(OptimizerType& optimizer,
+                       FunctionType& function,
+                       const MatType& coordinates,
+                       const GradType& gradient,
+                       CallbackTypes&... callbacks)
+  {
+    bool result = false;
+    const bool dummy[] = { false, (result |= callbacks::traits::
+        InvokeGradient(callbacks, optimizer, function, coordinates,
+        gradient))... };
+    (void) dummy;
+    if (result)
+      TerminationRequested(optimizer, function, coordinates, callbacks...);
+    return result;
+  }
+
+  /**
+   * Called after the objective and the gradient are evaluated together.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param objective Objective value at the current point.
+   * @param gradient Gradient at the current point.
+   * @param callbacks The callback functions.
+   * @return true if the optimization should be terminated.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename ElemType,
+           typename GradType,
+           typename... CallbackTypes>
+  static bool EvaluateWithGradient(OptimizerType& optimizer,
+                                   FunctionType& function,
+                                   const MatType& coordinates,
+                                   const ElemType objective,
+                                   const GradType& gradient,
+                                   CallbackTypes&... callbacks)
+  {
+    bool result = false;
+    const bool dummy[] = { false, (result |= callbacks::traits::
+        InvokeEvaluateWithGradient(callbacks, optimizer, function,
+        coordinates, objective, gradient))... };
+    (void) dummy;
+    if (result)
+      TerminationRequested(optimizer, function, coordinates, callbacks...);
+    return result;
+  }
+
+  /**
+   * Called at the beginning of a pass over the data.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the previous epoch.
+   * @param callbacks The callback functions.
+   * @return true if the optimization should be terminated.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename ElemType,
+           typename... CallbackTypes>
+  static bool BeginEpoch(OptimizerType& optimizer,
+                         FunctionType& function,
+                         const MatType& coordinates,
+                         const size_t epoch,
+                         const ElemType objective,
+                         CallbackTypes&... callbacks)
+  {
+    bool result = false;
+    const bool dummy[] = { false, (result |= callbacks::traits::
+        InvokeBeginEpoch(callbacks, optimizer, function, coordinates, epoch,
+        objective))... };
+    (void) dummy;
+    if (result)
+      TerminationRequested(optimizer, function, coordinates, callbacks...);
+    return result;
+  }
+
+  /**
+   * Called at the end of a pass over the data.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the current epoch.
+   * @param callbacks The callback functions.
+   * @return true if the optimization should be terminated.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename ElemType,
+           typename... CallbackTypes>
+  static bool EndEpoch(OptimizerType& optimizer,
+                       FunctionType& function,
+                       const MatType& coordinates,
+                       const size_t epoch,
+                       const ElemType objective,
+                       CallbackTypes&... callbacks)
+  {
+    bool result = false;
+    const bool dummy[] = { false, (result |= callbacks::traits::
+        InvokeEndEpoch(callbacks, optimizer, function, coordinates, epoch,
+        objective))... };
+    (void) dummy;
+    if (result)
+      TerminationRequested(optimizer, function, coordinates, callbacks...);
+    return result;
+  }
+
+  /**
+   * Called after the optimizer has taken a step.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The updated point.
+   * @param callbacks The callback functions.
+   * @return true if the optimization should be terminated.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static bool StepTaken(OptimizerType& optimizer,
+                        FunctionType& function,
+                        MatType& coordinates,
+                        CallbackTypes&... callbacks)
+  {
+    bool result = false;
+    const bool dummy[] = { false, (result |= callbacks::traits::
+        InvokeStepTaken(callbacks, optimizer, function, coordinates))... };
+    (void) dummy;
+    if (result)
+      TerminationRequested(optimizer, function, coordinates, callbacks...);
+    return result;
+  }
+
+ private:
+  /**
+   * Tell the callbacks that a callback asked for termination.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param callbacks The callback functions.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static void TerminationRequested(OptimizerType& optimizer,
+                                   FunctionType& function,
+                                   const MatType& coordinates,
+                                   CallbackTypes&... callbacks)
+  {
+    const bool dummy[] = { false, callbacks::traits::
+        InvokeTerminationRequested(callbacks, optimizer, function,
+        coordinates)... };
+    (void) dummy;
+  }
+};
+
+} // namespace ens
+
+#endif
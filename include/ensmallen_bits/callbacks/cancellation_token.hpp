@@ -0,0 +1,268 @@
+/**
+ * @file cancellation_token.hpp
+ *
+ * Implementation of the cancellation token callback, which stops the
+ * optimization once it is cancelled from another thread.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_CANCELLATION_TOKEN_HPP
+#define ENSMALLEN_CALLBACKS_CANCELLATION_TOKEN_HPP
+
+#include <atomic>
+#include <memory>
+
+namespace ens {
+
+/**
+ * Stop the optimization once Cancel() is called, possibly from another thread
+ * (for instance, when the request that started the optimization times out).
+ * Copies of a token share the same flag, so a copy can be kept by the thread
+ * that cancels while the optimizer is given another one.
+ *
+ * The flag is checked with a relaxed atomic load at every callback event of
+ * the optimizer (every batch of SGD-like optimizers, every iteration of L_BFGS
+ * and the other full-batch optimizers, every generation of CMAES and CNE), so
+ * the check costs next to nothing and the optimization stops at the first
+ * event after the cancellation; the work between two events (for instance,
+ * one line search of L_BFGS) is not interrupted.  If the token is cancelled
+ * before Optimize() is called, the optimizer returns right after it starts.
+ *
+ * When restoreBest is true, the coordinates at the end of the epoch with the
+ * lowest objective are kept (as with StoreBestCoordinates), and if the
+ * optimization is cancelled, they are written back into the coordinates, so
+ * that Optimize() returns the best iterate seen so far instead of the one it
+ * was at when it was cancelled.  If no epoch was finished, the current
+ * coordinates are returned.
+ *
+ * Optimizers that do not take callbacks (like BigBatchSGD and ParallelSGD) do
+ * not check the token.
+ *
+ * @code
+ * CancellationToken<> token;
+ * std::thread worker([&]() { optimizer.Optimize(f, coordinates, token); });
+ * // ... later, from the thread that owns the request:
+ * token.Cancel();
+ * worker.join();
+ * @endcode
+ *
+ * @tparam ModelMatType Type of the stored best coordinates.
+ */
+template<typename ModelMatType = arma::mat>
+class CancellationToken
+{
+ public:
+  /**
+   * Set up the cancellation token, which is not cancelled.
+   *
+   * @param restoreBest Whether to return the coordinates with the lowest epoch
+   *     objective when the optimization is cancelled.
+   */
+  CancellationToken(const bool restoreBest = true) :
+      cancelled(std::make_shared<std::atomic<bool>>(false)),
+      restoreBest(restoreBest),
+      bestObjective(DBL_MAX),
+      stopped(false)
+  { /* Nothing to do here. */ }
+
+  //! Cancel the optimization; this can be called from any thread.
+  void Cancel() { cancelled->store(true, std::memory_order_relaxed); }
+
+  //! Clear the cancellation, so that the token can be used again.
+  void Reset() { cancelled->store(false, std::memory_order_relaxed); }
+
+  //! Get whether the token is cancelled.
+  bool Cancelled() const
+  {
+    return cancelled->load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Callback function called at the beginning of the optimization.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Starting point.
+   * @return true if the token is already cancelled.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool BeginOptimization(OptimizerType& /* optimizer */,
+                         FunctionType& /* function */,
+                         MatType& /* coordinates */)
+  {
+    bestObjective = DBL_MAX;
+    bestCoordinates.reset();
+    stopped = false;
+    return Check();
+  }
+
+  /**
+   * Callback function called at the end of the optimization; if the
+   * optimization was cancelled, the best coordinates are restored.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The final point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndOptimization(OptimizerType& /* optimizer */,
+                       FunctionType& /* function */,
+                       MatType& coordinates)
+  {
+    if (!stopped && !Check())
+      return;
+
+    if (restoreBest && bestObjective != DBL_MAX)
+      coordinates = bestCoordinates;
+  }
+
+  /**
+   * Callback function called after the objective is evaluated.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param objective Objective value at the current point.
+   * @return true if the token is cancelled.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType,
+           typename ElemType>
+  bool Evaluate(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const ElemType /* objective */)
+  {
+    return Check();
+  }
+
+  /**
+   * Callback function called after the gradient is evaluated.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param gradient Gradient at the current point.
+   * @return true if the token is cancelled.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType,
+           typename GradType>
+  bool Gradient(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const GradType& /* gradient */)
+  {
+    return Check();
+  }
+
+  /**
+   * Callback function called after the objective and the gradient are
+   * evaluated together.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param objective Objective value at the current point.
+   * @param gradient Gradient at the current point.
+   * @return true if the token is cancelled.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType,
+           typename ElemType, typename GradType>
+  bool EvaluateWithGradient(OptimizerType& /* optimizer */,
+                            FunctionType& /* function */,
+                            const MatType& /* coordinates */,
+                            const ElemType /* objective */,
+                            const GradType& /* gradient */)
+  {
+    return Check();
+  }
+
+  /**
+   * Callback function called at the end of a pass over the data; the
+   * coordinates are kept if their objective is the lowest so far.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the current epoch.
+   * @return true if the token is cancelled.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType,
+           typename ElemType>
+  bool EndEpoch(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& coordinates,
+                const size_t /* epoch */,
+                const ElemType objective)
+  {
+    if (restoreBest && objective < bestObjective)
+    {
+      bestObjective = objective;
+      bestCoordinates = coordinates;
+    }
+
+    return Check();
+  }
+
+  /**
+   * Callback function called after the optimizer has taken a step.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The updated point.
+   * @return true if the token is cancelled.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool StepTaken(OptimizerType& /* optimizer */,
+                 FunctionType& /* function */,
+                 MatType& /* coordinates */)
+  {
+    return Check();
+  }
+
+  //! Get whether the best coordinates are restored on cancellation.
+  bool RestoreBest() const { return restoreBest; }
+  //! Modify whether the best coordinates are restored on cancellation.
+  bool& RestoreBest() { return restoreBest; }
+
+  //! Get whether the last optimization was stopped by the token.
+  bool Stopped() const { return stopped; }
+
+  //! Get the lowest epoch objective of the last optimization.
+  double BestObjective() const { return bestObjective; }
+
+  //! Get the coordinates with the lowest epoch objective.
+  const ModelMatType& BestCoordinates() const { return bestCoordinates; }
+
+ private:
+  //! Check whether the token is cancelled.
+  bool Check()
+  {
+    if (Cancelled())
+      stopped = true;
+
+    return stopped;
+  }
+
+  //! The flag, shared by all copies of the token.
+  std::shared_ptr<std::atomic<bool>> cancelled;
+
+  //! Whether the best coordinates are restored on cancellation.
+  bool restoreBest;
+
+  //! The lowest epoch objective seen so far.
+  double bestObjective;
+
+  //! The coordinates belonging to the lowest epoch objective.
+  ModelMatType bestCoordinates;
+
+  //! Whether the last optimization was stopped by the token.
+  bool stopped;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,78 @@
+/**
+ * @file early_stop_at_min_loss.hpp
+ *
+ * Implementation of the early stopping callback function.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_EARLY_STOP_AT_MIN_LOSS_HPP
+#define ENSMALLEN_CALLBACKS_EARLY_STOP_AT_MIN_LOSS_HPP
+
+namespace ens {
+
+/**
+ * Stop the optimization once the epoch objective has not improved for a given
+ * number of epochs.
+ */
+class EarlyStopAtMinLoss
+{
+ public:
+  /**
+   * Set up the early stop at min loss callback class with the given number of
+   * epochs to wait without improvement.
+   *
+   * @param patience Number of epochs to wait after the last improvement.
+   */
+  EarlyStopAtMinLoss(const size_t patience = 10) :
+      patience(patience),
+      bestObjective(DBL_MAX),
+      steps(0)
+  { /* Nothing to do here. */ }
+
+  /**
+   * Callback function called at the end of a pass over the data.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the current epoch.
+   * @return true if the optimization should be terminated.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool EndEpoch(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const size_t /* epoch */,
+                const double objective)
+  {
+    if (objective < bestObjective)
+    {
+      steps = 0;
+      bestObjective = objective;
+      return false;
+    }
+
+    return ++steps >= patience;
+  }
+
+  //! Get the best objective seen so far.
+  double BestObjective() const { return bestObjective; }
+
+ private:
+  //! The number of epochs to wait without improvement.
+  size_t patience;
+
+  //! The best objective seen so far.
+  double bestObjective;
+
+  //! The number of epochs since the last improvement.
+  size_t steps;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,396 @@
+/**
+ * @file record_result.hpp
+ *
+ * Implementation of the RecordResult callback function, which summarizes an
+ * optimization (evaluation counts, iterations, timings and the reason it
+ * stopped) in an OptimizationResult.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_RECORD_RESULT_HPP
+#define ENSMALLEN_CALLBACKS_RECORD_RESULT_HPP
+
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+namespace ens {
+
+/**
+ * The summary of an optimization, filled in by the RecordResult callback.
+ * Values that are not known (for instance, the gradient norm for an optimizer
+ * that does not use gradients) are NaN.
+ */
+struct OptimizationResult
+{
+  //! The reason an optimization stopped.
+  enum Reason
+  {
+    //! No optimization has been recorded.
+    None,
+    //! The optimizer stopped before its iteration limit (for instance, because
+    //! the objective or the gradient met a tolerance).
+    Converged,
+    //! The optimizer reached its iteration limit.
+    MaxIterations,
+    //! The optimizer stopped by itself, but it is not known whether it
+    //! converged or reached its iteration limit (see RecordResult).
+    Stopped,
+    //! A callback asked the optimizer to terminate.
+    Callback,
+    //! The last objective reported by the optimizer is not finite.
+    NonFinite
+  };
+
+  OptimizationResult() { Reset(); }
+
+  //! Clear the result.
+  void Reset()
+  {
+    reason = None;
+    evaluations = 0;
+    gradients = 0;
+    iterations = 0;
+    epochs = 0;
+    objective = std::numeric_limits<double>::quiet_NaN();
+    gradientNorm = std::numeric_limits<double>::quiet_NaN();
+    setupTime = 0.0;
+    iterationTime = 0.0;
+    finalizationTime = 0.0;
+    totalTime = 0.0;
+  }
+
+  //! Get the reason as a string.
+  const char* ReasonString() const
+  {
+    switch (reason)
+    {
+      case Converged: return "converged";
+      case MaxIterations: return "max_iterations";
+      case Stopped: return "stopped";
+      case Callback: return "callback";
+      case NonFinite: return "non_finite";
+      default: return "none";
+    }
+  }
+
+  //! The reason the optimization stopped.
+  Reason reason;
+  //! The number of objective evaluations.
+  size_t evaluations;
+  //! The number of gradient evaluations.
+  size_t gradients;
+  //! The number of steps taken.
+  size_t iterations;
+  //! The number of passes over the data.
+  size_t epochs;
+  //! The last objective reported by the optimizer.
+  double objective;
+  //! The norm of the last gradient reported by the optimizer.
+  double gradientNorm;
+  //! The time from the beginning of the optimization to the first step, in
+  //! seconds (this includes the first evaluations).
+  double setupTime;
+  //! The time from the first to the last step, in seconds.
+  double iterationTime;
+  //! The time from the last step to the end of the optimization, in seconds.
+  double finalizationTime;
+  //! The total time of the optimization, in seconds.
+  double totalTime;
+};
+
+namespace callbacks {
+namespace traits {
+
+//! Detect a MaxIterations() method returning a number.
+template<typename OptimizerType>
+struct HasMaxIterations
+{
+  template<typename O>
+  static auto Check(int) -> std::is_arithmetic<typename std::decay<
+      decltype(std::declval<O&>().MaxIterations())>::type>;
+
+  template<typename O>
+  static std::false_type Check(...);
+
+  static const bool value = decltype(Check<OptimizerType>(0))::value;
+};
+
+//! Detect a BatchSize() method returning a number.
+template<typename OptimizerType>
+struct HasBatchSize
+{
+  template<typename O>
+  static auto Check(int) -> std::is_arithmetic<typename std::decay<
+      decltype(std::declval<O&>().BatchSize())>::type>;
+
+  template<typename O>
+  static std::false_type Check(...);
+
+  static const bool value = decltype(Check<OptimizerType>(0))::value;
+};
+
+} // namespace traits
+} // namespace callbacks
+
+/**
+ * Summarize the optimization in the given OptimizationResult: the number of
+ * objective and gradient evaluations, steps and epochs, the last objective and
+ * gradient norm, the wall-clock time of the setup, the iterations and the
+ * finalization, and the reason the optimization stopped.  The result is reset
+ * at the beginning of each optimization.
+ *
+ * The evaluations are counted as by the Budget callback: each Evaluate() event
+ * counts one objective evaluation, each Gradient() event one gradient
+ * evaluation, and each EvaluateWithGradient() event one of each (so for
+ * separable functions, an evaluation is one batch).  Each event only costs a
+ * counter increment, a clock read for the steps, and the norm of the gradient
+ * for the gradient events.
+ *
+ * The reason is Callback if any callback asked the optimizer to terminate, and
+ * NonFinite if the last objective is not finite.  Otherwise the optimizer
+ * stopped by itself: for optimizers whose MaxIterations() counts steps, the
+ * reason is MaxIterations if that many steps were taken and Converged if not.
+ * Optimizers with a BatchSize() count their iterations in other units (points
+ * or generations), so for them the reason is only Stopped.
+ *
+ * @code
+ * OptimizationResult result;
+ * optimizer.Optimize(f, coordinates, RecordResult(result));
+ * std::cout << result.evaluations << " evaluations, stopped: "
+ *     << result.ReasonString() << std::endl;
+ * @endcode
+ */
+class RecordResult
+{
+ public:
+  /**
+   * Set up the callback to fill in the given result.
+   *
+   * @param result The result to fill in.
+   */
+  RecordResult(OptimizationResult& result) :
+      result(result),
+      requested(false),
+      firstStep(0.0),
+      lastStep(0.0)
+  { /* Nothing to do here. */ }
+
+  /**
+   * Callback function called at the beginning of the optimization.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Starting point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void BeginOptimization(OptimizerType& /* optimizer */,
+                         FunctionType& /* function */,
+                         MatType& /* coordinates */)
+  {
+    result.Reset();
+    requested = false;
+    firstStep = 0.0;
+    lastStep = 0.0;
+    timer.tic();
+  }
+
+  /**
+   * Callback function called at the end of the optimization.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Final point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndOptimization(OptimizerType& optimizer,
+                       FunctionType& /* function */,
+                       MatType& /* coordinates */)
+  {
+    result.totalTime = timer.toc();
+    if (result.iterations == 0)
+    {
+      result.setupTime = result.totalTime;
+    }
+    else
+    {
+      result.setupTime = firstStep;
+      result.iterationTime = lastStep - firstStep;
+      result.finalizationTime = result.totalTime - lastStep;
+    }
+
+    if (requested)
+      result.reason = OptimizationResult::Callback;
+    else if (result.evaluations + result.epochs > 0 &&
+        !std::isfinite(result.objective))
+      result.reason = OptimizationResult::NonFinite;
+    else
+      result.reason = StopReason(optimizer);
+  }
+
+  /**
+   * Callback function called after the objective is evaluated.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param objective Objective value at the current point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType,
+           typename ElemType>
+  void Evaluate(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const ElemType objective)
+  {
+    ++result.evaluations;
+    result.objective = objective;
+  }
+
+  /**
+   * Callback function called after the gradient is evaluated.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param gradient Gradient at the current point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType,
+           typename GradType>
+  void Gradient(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const GradType& gradient)
+  {
+    ++result.gradients;
+    result.gradientNorm = arma::norm(gradient);
+  }
+
+  /**
+   * Callback function called after the objective and the gradient are
+   * evaluated together.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param objective Objective value at the current point.
+   * @param gradient Gradient at the current point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType,
+           typename ElemType, typename GradType>
+  void EvaluateWithGradient(OptimizerType& /* optimizer */,
+                            FunctionType& /* function */,
+                            const MatType& /* coordinates */,
+                            const ElemType objective,
+                            const GradType& gradient)
+  {
+    ++result.evaluations;
+    ++result.gradients;
+    result.objective = objective;
+    result.gradientNorm = arma::norm(gradient);
+  }
+
+  /**
+   * Callback function called at the end of a pass over the data.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the current epoch.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType,
+           typename ElemType>
+  void EndEpoch(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const size_t /* epoch */,
+                const ElemType objective)
+  {
+    ++result.epochs;
+    result.objective = objective;
+  }
+
+  /**
+   * Callback function called after the optimizer has taken a step.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The updated point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void StepTaken(OptimizerType& /* optimizer */,
+                 FunctionType& /* function */,
+                 MatType& /* coordinates */)
+  {
+    lastStep = timer.toc();
+    if (result.iterations++ == 0)
+      firstStep = lastStep;
+  }
+
+  /**
+   * Callback function called when a callback asked the optimizer to terminate.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void TerminationRequested(OptimizerType& /* optimizer */,
+                            FunctionType& /* function */,
+                            const MatType& /* coordinates */)
+  {
+    requested = true;
+  }
+
+  //! Get the result.
+  const OptimizationResult& Result() const { return result; }
+
+ private:
+  //! Tell whether an optimizer whose MaxIterations() counts steps converged.
+  template<typename OptimizerType>
+  typename std::enable_if<
+      callbacks::traits::HasMaxIterations<OptimizerType>::value &&
+      !callbacks::traits::HasBatchSize<OptimizerType>::value,
+      OptimizationResult::Reason>::type
+  StopReason(OptimizerType& optimizer) const
+  {
+    const size_t maxIterations = (size_t) optimizer.MaxIterations();
+    return (maxIterations > 0 && result.iterations >= maxIterations) ?
+        OptimizationResult::MaxIterations : OptimizationResult::Converged;
+  }
+
+  //! The iteration limit of other optimizers can't be compared with the
+  //! number of steps.
+  template<typename OptimizerType>
+  typename std::enable_if<
+      !callbacks::traits::HasMaxIterations<OptimizerType>::value ||
+      callbacks::traits::HasBatchSize<OptimizerType>::value,
+      OptimizationResult::Reason>::type
+  StopReason(OptimizerType& /* optimizer */) const
+  {
+    return OptimizationResult::Stopped;
+  }
+
+  //! The result to fill in.
+  OptimizationResult& result;
+
+  //! Whether a callback asked the optimizer to terminate.
+  bool requested;
+
+  //! The time of the first step.
+  double firstStep;
+
+  //! The time of the last step.
+  double lastStep;
+
+  //! Locally-stored timer object.
+  arma::wall_clock timer;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,71 @@
+/**
+ * @file store_best_coordinates.hpp
+ *
+ * Implementation of the store best coordinates callback function.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_STORE_BEST_COORDINATES_HPP
+#define ENSMALLEN_CALLBACKS_STORE_BEST_COORDINATES_HPP
+
+namespace ens {
+
+/**
+ * Store the coordinates with the lowest objective seen during the
+ * optimization.
+ *
+ * @tparam ModelMatType Type of the stored coordinates.
+ */
+template<typename ModelMatType = arma::mat>
+class StoreBestCoordinates
+{
+ public:
+  /**
+   * Set up the store best coordinates callback class.
+   */
+  StoreBestCoordinates() : bestObjective(DBL_MAX)
+  { /* Nothing to do here. */ }
+
+  /**
+   * Callback function called at the end of a pass over the data.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the current epoch.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndEpoch(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& coordinates,
+                const size_t /* epoch */,
+                const double objective)
+  {
+    if (objective < bestObjective)
+    {
+      bestObjective = objective;
+      bestCoordinates = coordinates;
+    }
+  }
+
+  //! Get the best coordinates.
+  const ModelMatType& BestCoordinates() const { return bestCoordinates; }
+
+  //! Get the best objective.
+  double BestObjective() const { return bestObjective; }
+
+ private:
+  //! The best objective seen so far.
+  double bestObjective;
+
+  //! The coordinates belonging to the best objective.
+  ModelMatType bestCoordinates;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,377 @@
+/**
+ * @file telemetry.hpp
+ *
+ * Implementation of the telemetry callback function, which records the
+ * progress of the optimization into a fixed-size ring buffer of records that
+ * can be exported as JSON or in the Prometheus text format.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_TELEMETRY_HPP
+#define ENSMALLEN_CALLBACKS_TELEMETRY_HPP
+
+#include <cmath>
+#include <limits>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+namespace ens {
+
+/**
+ * One record of the progress of an optimization.  Values that are not known
+ * (for instance, the step size of an optimizer without a StepSize() method)
+ * are NaN.
+ */
+struct TelemetryRecord
+{
+  //! The number of steps taken so far.
+  size_t iteration;
+  //! The last objective reported by the optimizer.
+  double objective;
+  //! The step size of the optimizer.
+  double stepSize;
+  //! The norm of the last gradient reported by the optimizer.
+  double gradientNorm;
+  //! The time since the beginning of the optimization, in seconds.
+  double timestamp;
+};
+
+namespace callbacks {
+namespace traits {
+
+//! Detect a StepSize() method returning a number.
+template<typename OptimizerType>
+struct HasStepSize
+{
+  template<typename O>
+  static auto Check(int) -> std::is_arithmetic<typename std::decay<
+      decltype(std::declval<O&>().StepSize())>::type>;
+
+  template<typename O>
+  static std::false_type Check(...);
+
+  static const bool value = decltype(Check<OptimizerType>(0))::value;
+};
+
+} // namespace traits
+} // namespace callbacks
+
+/**
+ * Record the progress of the optimization, every given number of steps, into
+ * a ring buffer with a fixed number of records.  Each record holds the number
+ * of steps taken, the last objective and gradient norm reported by the
+ * optimizer, the optimizer's step size (if it has a StepSize() method), and
+ * the time since the beginning of the optimization.  Once the buffer is full,
+ * each new record overwrites the oldest one.
+ *
+ * Records are written in place, without locks, allocations or formatting, so
+ * that telemetry can stay enabled in production; the text is only produced by
+ * WriteJSON() and WritePrometheus().  The records are written by the thread
+ * running the optimizer, so they should be read when the optimizer is not
+ * running, or from that thread (for instance, from another callback).
+ *
+ * The gradient norm is only computed for the steps that are recorded.  The
+ * buffer is cleared at the beginning of each optimization.
+ *
+ * @code
+ * // Record every 10th step, keeping the last 1000 records.
+ * Telemetry telemetry(1000, 10);
+ * optimizer.Optimize(f, coordinates, telemetry);
+ * telemetry.WriteJSON(std::cout);
+ * @endcode
+ */
+class Telemetry
+{
+ public:
+  /**
+   * Set up the telemetry callback with the given buffer size.
+   *
+   * @param capacity Maximum number of records kept.
+   * @param interval Record every interval-th step.
+   */
+  Telemetry(const size_t capacity = 1024, const size_t interval = 1) :
+      records(std::max(capacity, size_t(1))),
+      interval(std::max(interval, size_t(1))),
+      written(0),
+      steps(0),
+      objective(std::numeric_limits<double>::quiet_NaN()),
+      gradientNorm(std::numeric_limits<double>::quiet_NaN())
+  { /* Nothing to do here. */ }
+
+  /**
+   * Callback function called at the beginning of the optimization.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Starting point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void BeginOptimization(OptimizerType& /* optimizer */,
+                         FunctionType& /* function */,
+                         MatType& /* coordinates */)
+  {
+    Clear();
+    timer.tic();
+  }
+
+  /**
+   * Callback function called after the objective is evaluated.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param objective Objective value at the current point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType,
+           typename ElemType>
+  void Evaluate(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const ElemType objective)
+  {
+    this->objective = objective;
+  }
+
+  /**
+   * Callback function called after the gradient is evaluated.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param gradient Gradient at the current point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType,
+           typename GradType>
+  void Gradient(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const GradType& gradient)
+  {
+    if ((steps + 1) % interval == 0)
+      gradientNorm = arma::norm(gradient);
+  }
+
+  /**
+   * Callback function called after the objective and the gradient are
+   * evaluated together.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param objective Objective value at the current point.
+   * @param gradient Gradient at the current point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType,
+           typename ElemType, typename GradType>
+  void EvaluateWithGradient(OptimizerType& /* optimizer */,
+                            FunctionType& /* function */,
+                            const MatType& /* coordinates */,
+                            const ElemType objective,
+                            const GradType& gradient)
+  {
+    this->objective = objective;
+    if ((steps + 1) % interval == 0)
+      gradientNorm = arma::norm(gradient);
+  }
+
+  /**
+   * Callback function called at the end of a pass over the data.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current point.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the current epoch.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType,
+           typename ElemType>
+  void EndEpoch(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const size_t /* epoch */,
+                const ElemType objective)
+  {
+    this->objective = objective;
+  }
+
+  /**
+   * Callback function called after the optimizer has taken a step.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The updated point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void StepTaken(OptimizerType& optimizer,
+                 FunctionType& /* function */,
+                 MatType& /* coordinates */)
+  {
+    if (++steps % interval != 0)
+      return;
+
+    TelemetryRecord& record = records[written % records.size()];
+    record.iteration = steps;
+    record.objective = objective;
+    record.stepSize = StepSize(optimizer);
+    record.gradientNorm = gradientNorm;
+    record.timestamp = timer.toc();
+    ++written;
+  }
+
+  //! Get the maximum number of records kept.
+  size_t Capacity() const { return records.size(); }
+
+  //! Get the number of records kept.
+  size_t Size() const { return std::min(written, records.size()); }
+
+  //! Get the number of records that were overwritten.
+  size_t Dropped() const { return written - Size(); }
+
+  //! Get the i-th record kept, from the oldest (0) to the newest (Size() - 1).
+  const TelemetryRecord& Record(const size_t i) const
+  {
+    return records[(Dropped() + i) % records.size()];
+  }
+
+  //! Get a copy of the records kept, from the oldest to the newest.
+  std::vector<TelemetryRecord> Records() const
+  {
+    std::vector<TelemetryRecord> result;
+    result.reserve(Size());
+    for (size_t i = 0; i < Size(); ++i)
+      result.push_back(Record(i));
+
+    return result;
+  }
+
+  //! Forget all the records.
+  void Clear()
+  {
+    written = 0;
+    steps = 0;
+    objective = std::numeric_limits<double>::quiet_NaN();
+    gradientNorm = std::numeric_limits<double>::quiet_NaN();
+  }
+
+  /**
+   * Write the records kept as a JSON object, with the number of dropped
+   * records and the array of records from the oldest to the newest.  Unknown
+   * values are written as null.
+   *
+   * @param output Stream to write to.
+   */
+  void WriteJSON(std::ostream& output) const
+  {
+    output << "{\"dropped\":" << Dropped() << ",\"records\":[";
+    for (size_t i = 0; i < Size(); ++i)
+    {
+      const TelemetryRecord& record = Record(i);
+      output << (i == 0 ? "" : ",") << "{\"iteration\":" << record.iteration
+          << ",\"objective\":";
+      WriteJSONValue(output, record.objective);
+      output << ",\"step_size\":";
+      WriteJSONValue(output, record.stepSize);
+      output << ",\"gradient_norm\":";
+      WriteJSONValue(output, record.gradientNorm);
+      output << ",\"timestamp\":";
+      WriteJSONValue(output, record.timestamp);
+      output << "}";
+    }
+    output << "]}\n";
+  }
+
+  /**
+   * Write the newest record as gauges in the Prometheus text exposition
+   * format (prefix_iteration, prefix_objective, prefix_step_size,
+   * prefix_gradient_norm and prefix_elapsed_seconds), with the counter
+   * prefix_records_total.  The gauges are not written if there is no record.
+   *
+   * @param output Stream to write to.
+   * @param prefix Prefix of the metric names.
+   */
+  void WritePrometheus(std::ostream& output,
+                       const std::string& prefix = "ensmallen") const
+  {
+    output << "# TYPE " << prefix << "_records_total counter\n"
+        << prefix << "_records_total " << written << "\n";
+    if (Size() == 0)
+      return;
+
+    const TelemetryRecord& record = Record(Size() - 1);
+    WritePrometheusGauge(output, prefix + "_iteration",
+        (double) record.iteration);
+    WritePrometheusGauge(output, prefix + "_objective", record.objective);
+    WritePrometheusGauge(output, prefix + "_step_size", record.stepSize);
+    WritePrometheusGauge(output, prefix + "_gradient_norm",
+        record.gradientNorm);
+    WritePrometheusGauge(output, prefix + "_elapsed_seconds",
+        record.timestamp);
+  }
+
+ private:
+  //! Get the step size of an optimizer with a StepSize() method.
+  template<typename OptimizerType>
+  static typename std::enable_if<
+      callbacks::traits::HasStepSize<OptimizerType>::value, double>::type
+  StepSize(OptimizerType& optimizer)
+  {
+    return (double) optimizer.StepSize();
+  }
+
+  //! The step size of an optimizer without a StepSize() method is unknown.
+  template<typename OptimizerType>
+  static typename std::enable_if<
+      !callbacks::traits::HasStepSize<OptimizerType>::value, double>::type
+  StepSize(OptimizerType& /* optimizer */)
+  {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+
+  //! Write a number as a JSON value (null if it is not finite).
+  static void WriteJSONValue(std::ostream& output, const double value)
+  {
+    if (std::isfinite(value))
+      output << value;
+    else
+      output << "null";
+  }
+
+  //! Write a gauge in the Prometheus text exposition format.
+  static void WritePrometheusGauge(std::ostream& output,
+                                   const std::string& name,
+                                   const double value)
+  {
+    output << "# TYPE " << name << " gauge\n" << name << " ";
+    if (std::isnan(value))
+      output << "NaN";
+    else if (std::isinf(value))
+      output << (value > 0 ? "+Inf" : "-Inf");
+    else
+      output << value;
+    output << "\n";
+  }
+
+  //! The ring buffer of records.
+  std::vector<TelemetryRecord> records;
+  //! Record every interval-th step.
+  size_t interval;
+  //! The number of records written since the buffer was cleared.
+  size_t written;
+  //! The number of steps taken so far.
+  size_t steps;
+  //! The last objective reported.
+  double objective;
+  //! The norm of the last recorded gradient.
+  double gradientNorm;
+
+  //! Locally-stored timer object.
+  arma::wall_clock timer;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,300 @@
+/**
+ * @file throughput_tuner.hpp
+ *
+ * Implementation of the throughput tuner callback, which picks the batch size
+ * and the number of threads with the best throughput before the optimization.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_THROUGHPUT_TUNER_HPP
+#define ENSMALLEN_CALLBACKS_THROUGHPUT_TUNER_HPP
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+/**
+ * Time short trial windows of gradient evaluations of a separable function for
+ * several batch sizes and numbers of OpenMP threads, and set the batch size of
+ * the optimizer (and the number of OpenMP threads) to the configuration with
+ * the most functions (samples) per second.
+ *
+ * The candidate batch sizes are the powers of two between the given minimum
+ * and maximum, and both of them; the candidate numbers of threads are
+ * the powers of two up to the maximum, and the maximum itself.  Each trial
+ * evaluates the gradient of consecutive batches, each followed by a vanilla
+ * step on a copy of the coordinates (the cost of a cheap update), for the
+ * given time.  The coordinates of the optimization are not changed.
+ *
+ * By default, the batches of a trial are evaluated one after the other, and
+ * the threads are available to the function (for instance, to a multithreaded
+ * BLAS or the OpenMP loops of the function), as in SGD or BigBatchSGD.  For
+ * optimizers that evaluate one batch on each thread, like ParallelSGD, set
+ * concurrentBatches so that each thread of a trial evaluates its own batches.
+ *
+ * As a callback, the tuner runs at the beginning of the optimization, and
+ * changes the BatchSize() of the optimizer before the first step (for
+ * instance, `sgd.Optimize(f, coordinates, ThroughputTuner(16, 1024))`).  For
+ * optimizers that do not take callbacks (like BigBatchSGD and ParallelSGD),
+ * call Tune() before Optimize().  The number of threads is set with
+ * omp_set_num_threads(), so it applies to everything that runs after the
+ * tuning; without OpenMP, only the batch size is tuned.
+ *
+ * @code
+ * ThroughputTuner tuner(16, 1024);
+ * tuner.Tune(optimizer, f, coordinates);
+ * optimizer.Optimize(f, coordinates);
+ * @endcode
+ */
+class ThroughputTuner
+{
+ public:
+  /**
+   * Set up the throughput tuner with the given candidates.
+   *
+   * @param minBatchSize Smallest candidate batch size.
+   * @param maxBatchSize Largest candidate batch size (it is also limited by the
+   *     number of functions).
+   * @param maxThreads Largest candidate number of threads (0 means the maximum
+   *     number of OpenMP threads).
+   * @param trialTime Duration of each trial window in seconds.
+   * @param concurrentBatches If true, each thread of a trial evaluates its own
+   *     batches.
+   */
+  ThroughputTuner(const size_t minBatchSize = 1,
+                  const size_t maxBatchSize = 1024,
+                  const size_t maxThreads = 0,
+                  const double trialTime = 0.05,
+                  const bool concurrentBatches = false) :
+      minBatchSize(minBatchSize),
+      maxBatchSize(maxBatchSize),
+      maxThreads(maxThreads),
+      trialTime(trialTime),
+      concurrentBatches(concurrentBatches),
+      batchSize(0),
+      threads(0)
+  { /* Nothing to do here. */ }
+
+  /**
+   * Callback function called at the beginning of the optimization; the batch
+   * size of the optimizer is tuned.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Starting point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void BeginOptimization(OptimizerType& optimizer,
+                         FunctionType& function,
+                         MatType& coordinates)
+  {
+    Tune(optimizer, function, coordinates);
+  }
+
+  /**
+   * Run the trials on the given separable function, and set the batch size of
+   * the optimizer and the number of OpenMP threads to the best configuration.
+   *
+   * @param optimizer Optimizer with a BatchSize() method.
+   * @param function Separable function to optimize.
+   * @param coordinates Coordinates to evaluate the gradients at.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void Tune(OptimizerType& optimizer,
+            FunctionType& function,
+            const MatType& coordinates)
+  {
+    typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+    typedef Function<FunctionType, BaseMatType, BaseMatType> FullFunctionType;
+    FullFunctionType& f(static_cast<FullFunctionType&>(function));
+    const BaseMatType& iterate = static_cast<const BaseMatType&>(coordinates);
+
+    const size_t numFunctions = f.NumFunctions();
+    if (minBatchSize == 0 || minBatchSize > maxBatchSize || numFunctions == 0)
+    {
+      throw std::invalid_argument("ThroughputTuner::Tune(): the batch sizes "
+          "must be in [1, maxBatchSize], and there must be functions!");
+    }
+
+    #ifdef ENS_USE_OPENMP
+      const size_t threadLimit = (maxThreads == 0) ?
+          (size_t) omp_get_max_threads() : maxThreads;
+    #else
+      const size_t threadLimit = 1;
+    #endif
+
+    std::vector<size_t> batchSizes = Candidates(std::min(minBatchSize,
+        numFunctions), std::min(maxBatchSize, numFunctions));
+    std::vector<size_t> threadCounts = Candidates(1, threadLimit);
+
+    trials.set_size(3, batchSizes.size() * threadCounts.size());
+    double best = -1.0;
+    size_t t = 0;
+    for (size_t i = 0; i < threadCounts.size(); ++i)
+    {
+      for (size_t j = 0; j < batchSizes.size(); ++j, ++t)
+      {
+        const double throughput = Trial(f, iterate, batchSizes[j],
+            threadCounts[i]);
+        trials(0, t) = batchSizes[j];
+        trials(1, t) = threadCounts[i];
+        trials(2, t) = throughput;
+        if (throughput > best)
+        {
+          best = throughput;
+          batchSize = batchSizes[j];
+          threads = threadCounts[i];
+        }
+      }
+    }
+
+    optimizer.BatchSize() = batchSize;
+    #ifdef ENS_USE_OPENMP
+      omp_set_num_threads((int) threads);
+    #endif
+
+    Info << "ThroughputTuner: batch size " << batchSize << " with " << threads
+        << " threads processes " << best << " functions per second."
+        << std::endl;
+  }
+
+  //! Get the chosen batch size (0 before the tuning).
+  size_t BatchSize() const { return batchSize; }
+
+  //! Get the chosen number of threads (0 before the tuning).
+  size_t Threads() const { return threads; }
+
+  //! Get the trials: each column holds a batch size, a number of threads and
+  //! the functions per second.
+  const arma::mat& Trials() const { return trials; }
+
+  //! Get the smallest candidate batch size.
+  size_t MinBatchSize() const { return minBatchSize; }
+  //! Modify the smallest candidate batch size.
+  size_t& MinBatchSize() { return minBatchSize; }
+
+  //! Get the largest candidate batch size.
+  size_t MaxBatchSize() const { return maxBatchSize; }
+  //! Modify the largest candidate batch size.
+  size_t& MaxBatchSize() { return maxBatchSize; }
+
+  //! Get the largest candidate number of threads (0 means the maximum).
+  size_t MaxThreads() const { return maxThreads; }
+  //! Modify the largest candidate number of threads (0 means the maximum).
+  size_t& MaxThreads() { return maxThreads; }
+
+  //! Get the duration of each trial in seconds.
+  double TrialTime() const { return trialTime; }
+  //! Modify the duration of each trial in seconds.
+  double& TrialTime() { return trialTime; }
+
+  //! Get whether each thread evaluates its own batches.
+  bool ConcurrentBatches() const { return concurrentBatches; }
+  //! Modify whether each thread evaluates its own batches.
+  bool& ConcurrentBatches() { return concurrentBatches; }
+
+ private:
+  //! Get the powers of two in [first, last], and last.
+  static std::vector<size_t> Candidates(const size_t first, const size_t last)
+  {
+    std::vector<size_t> candidates;
+    size_t c = 1;
+    while (c < first)
+      c *= 2;
+    for (; c < last; c *= 2)
+      candidates.push_back(c);
+    if (candidates.empty() || candidates.back() != last)
+      candidates.push_back(last);
+    if (candidates.front() > first)
+      candidates.insert(candidates.begin(), first);
+    return candidates;
+  }
+
+  //! Time one trial, and return the number of functions per second.
+  template<typename FunctionType, typename MatType>
+  double Trial(FunctionType& function,
+               const MatType& iterate,
+               const size_t trialBatchSize,
+               const size_t trialThreads)
+  {
+    typedef typename MatType::elem_type ElemType;
+
+    #ifdef ENS_USE_OPENMP
+      omp_set_num_threads((int) trialThreads);
+    #endif
+    const size_t workers = concurrentBatches ? trialThreads : 1;
+    const size_t numFunctions = function.NumFunctions();
+
+    // One batch of each worker is evaluated before the timing, to warm the
+    // caches and the allocations up.
+    size_t next = 0;
+    size_t evaluated = 0;
+    arma::wall_clock timer;
+    bool warm = false;
+    while (true)
+    {
+      #ifdef ENS_USE_OPENMP
+        #pragma omp parallel for num_threads(workers) if (workers > 1)
+      #endif
+      for (size_t w = 0; w < workers; ++w)
+      {
+        const size_t begin = (next + w * trialBatchSize) % numFunctions;
+        const size_t size = std::min(trialBatchSize, numFunctions - begin);
+        MatType gradient;
+        MatType step(iterate);
+        function.EvaluateWithGradient(iterate, begin, gradient, size);
+        step -= ElemType(1e-3) * gradient;
+      }
+
+      for (size_t w = 0; w < workers; ++w)
+      {
+        const size_t begin = (next + w * trialBatchSize) % numFunctions;
+        if (warm)
+          evaluated += std::min(trialBatchSize, numFunctions - begin);
+      }
+      next = (next + workers * trialBatchSize) % numFunctions;
+
+      if (!warm)
+      {
+        warm = true;
+        timer.tic();
+        continue;
+      }
+
+      const double elapsed = timer.toc();
+      if (elapsed >= trialTime)
+        return (elapsed > 0.0) ? evaluated / elapsed : 0.0;
+    }
+  }
+
+  //! The smallest candidate batch size.
+  size_t minBatchSize;
+
+  //! The largest candidate batch size.
+  size_t maxBatchSize;
+
+  //! The largest candidate number of threads.
+  size_t maxThreads;
+
+  //! The duration of each trial.
+  double trialTime;
+
+  //! Whether each thread evaluates its own batches.
+  bool concurrentBatches;
+
+  //! The chosen batch size.
+  size_t batchSize;
+
+  //! The chosen number of threads.
+  size_t threads;
+
+  //! The batch size, number of threads and throughput of each trial.
+  arma::mat trials;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,98 @@
+/**
+ * @file traits.hpp
+ *
+ * Compile-time detection of the events a callback handles.  Each callback
+ * function is optional, and may return either void or bool; a return value of
+ * true asks the optimizer to terminate.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_TRAITS_HPP
+#define ENSMALLEN_CALLBACKS_TRAITS_HPP
+
+#include <type_traits>
+#include <utility>
+
+namespace ens {
+namespace callbacks {
+namespace traits {
+
+/**
+ * Define a type function Has##NAME<CallbackType, Args...> whose value is true
+ * if CallbackType::NAME() can be called with arguments of the given types, and
+ * a function Invoke##NAME(callback, args...) that calls CallbackType::NAME()
+ * if it exists and returns whether the callback asked for termination.
+ *
+ * @param NAME Name of the callback function.
+ */
+#define ENS_CALLBACK_EVENT(NAME)                                               \
+template<typename CallbackType, typename... Args>                              \
+struct Has##NAME                                                               \
+{                                                                              \
+  template<typename C>                                                         \
+  static auto Check(int) -> decltype(                                          \
+      std::declval<C&>().NAME(std::declval<Args&>()...), std::true_type());    \
+                                                                               \
+  template<typename C>                                                         \
+  static std::false_type Check(...);                                           \
+                                                                               \
+  static const bool value = decltype(Check<CallbackType>(0))::value;           \
+};                                                                             \
+                                                                               \
+template<typename CallbackType, typename... Args>                              \
+struct Returns##NAME                                                           \
+{                                                                              \
+  template<typename C>                                                         \
+  static auto Check(int) -> std::is_same<bool, decltype(                       \
+      std::declval<C&>().NAME(std::declval<Args&>()...))>;                     \
+                                                                               \
+  template<typename C>                                                         \
+  static std::false_type Check(...);                                           \
+                                                                               \
+  static const bool value = decltype(Check<CallbackType>(0))::value;           \
+};                                                                             \
+                                                                               \
+template<typename CallbackType, typename... Args>                              \
+typename std::enable_if<!Has##NAME<CallbackType, Args...>::value, bool>::type  \
+Invoke##NAME(CallbackType& /* callback */, Args&... /* args */)                \
+{                                                                              \
+  return false;                                                                \
+}                                                                              \
+                                                                               \
+template<typename CallbackType, typename... Args>                              \
+typename std::enable_if<Returns##NAME<CallbackType, Args...>::value,           \
+    bool>::type                                                                \
+Invoke##NAME(CallbackType& callback, Args&... args)                            \
+{                                                                              \
+  return callback.NAME(args...);                                               \
+}                                                                              \
+                                                                               \
+template<typename CallbackType, typename... Args>                              \
+typename std::enable_if<Has##NAME<CallbackType, Args...>::value &&             \
+    !Returns##NAME<CallbackType, Args...>::value, bool>::type                  \
+Invoke##NAME(CallbackType& callback, Args&... args)                            \
+{                                                                              \
+  callback.NAME(args...);                                                      \
+  return false;                                                                \
+}
+
+ENS_CALLBACK_EVENT(BeginOptimization)
+ENS_CALLBACK_EVENT(EndOptimization)
+ENS_CALLBACK_EVENT(Evaluate)
+ENS_CALLBACK_EVENT(Gradient)
+ENS_CALLBACK_EVENT(EvaluateWithGradient)
+ENS_CALLBACK_EVENT(BeginEpoch)
+ENS_CALLBACK_EVENT(EndEpoch)
+ENS_CALLBACK_EVENT(StepTaken)
+ENS_CALLBACK_EVENT(TerminationRequested)
+
+#undef ENS_CALLBACK_EVENT
+
+} // namespace traits
+} // namespace callbacks
+} // namespace ens
+
+#endif
@@ -0,0 +1,198 @@
+/**
+ * @file bipop_cmaes.hpp
+ *
+ * Definition of BIPOP-CMA-ES, which restarts CMA-ES in two regimes, one with
+ * an increasing population size and one with small populations and step
+ * sizes, as proposed by N. Hansen in "Benchmarking a BI-Population CMA-ES on
+ * the BBOB-2009 Function Testbed".
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CMAES_BIPOP_CMAES_HPP
+#define ENSMALLEN_CMAES_BIPOP_CMAES_HPP
+
+#include "ipop_cmaes.hpp"
+
+namespace ens {
+
+/**
+ * BIPOP-CMA-ES runs CMA-ES with the default population size, and then
+ * restarts it in one of two regimes, until maxRestarts restarts were run or
+ * maxFunctionEvaluations evaluations were used:
+ *
+ *  - the large population regime, where the population size is the default
+ *    one multiplied by populationFactor once more at every restart in that
+ *    regime, as in IPOP-CMA-ES;
+ *
+ *  - the small population regime, where the population size is
+ *    floor(lambda_default * (lambda_large / (2 lambda_default))^(u^2)) and the
+ *    initial step size is sigma_default * 10^(-2u), for u drawn uniformly in
+ *    [0, 1), and lambda_large the population size of the last large run.
+ *
+ * A restart is in the small regime when the small regime used fewer
+ * evaluations so far than the large one (which counts the first run), so the
+ * budget is shared equally by the regimes.  The best point of all the runs is
+ * returned.
+ *
+ * For more information, please refer to:
+ *
+ * @code
+ * @inproceedings{Hansen2009,
+ *   author    = {Hansen, Nikolaus},
+ *   title     = {Benchmarking a BI-Population CMA-ES on the BBOB-2009
+ *                Function Testbed},
+ *   booktitle = {Proceedings of the 11th Annual Genetic and Evolutionary
+ *                Computation Conference},
+ *   year      = {2009},
+ *   pages     = {2389--2396}
+ * }
+ * @endcode
+ *
+ * If parallelRegimes is true, the restarts after the first run are made in
+ * rounds: each round runs the next large restart and, at the same time (on
+ * another thread, if OpenMP is enabled), small restarts until the small
+ * regime has used as many evaluations as the large regime before the round.
+ * The remaining evaluation budget is split equally between the two regimes
+ * of a round.  The random numbers of each regime are seeded at the beginning
+ * of the round, so the result does not depend on whether the regimes actually
+ * run in parallel; Armadillo must then use a thread-local random number
+ * generator (the default), and the function must be safe to call from two
+ * threads at once.
+ *
+ * @tparam CMAESType Type of the CMA-ES optimizer to restart.
+ */
+template<typename CMAESType = CMAES<>>
+class BIPOP_CMAES
+{
+ public:
+  /**
+   * Construct the BIPOP-CMA-ES optimizer with the given CMA-ES optimizer and
+   * parameters.  The default population size and step size are the ones of
+   * the given optimizer (or their defaults, if they are 0).
+   *
+   * @param cmaes CMA-ES optimizer to restart.
+   * @param populationFactor Factor the population size of the large regime is
+   *     multiplied by at every large restart.
+   * @param maxRestarts Maximum number of restarts.
+   * @param maxFunctionEvaluations Maximum number of evaluations of all runs (0
+   *     means no limit).
+   * @param parallelRegimes Whether to run the two regimes concurrently.
+   */
+  BIPOP_CMAES(const CMAESType& cmaes = CMAESType(),
+              const double populationFactor = 2,
+              const size_t maxRestarts = 9,
+              const size_t maxFunctionEvaluations = 1000000000,
+              const bool parallelRegimes = false);
+
+  /**
+   * Optimize the given function with restarts of CMA-ES.  The given point is
+   * modified to store the best point found, and its objective is returned.
+   *
+   * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @return Objective value of the final point.
+   */
+  template<typename DecomposableFunctionType>
+  double Optimize(DecomposableFunctionType& function, arma::mat& iterate);
+
+  //! Get the CMA-ES optimizer that is restarted.
+  const CMAESType& Optimizer() const { return cmaes; }
+  //! Modify the CMA-ES optimizer that is restarted.
+  CMAESType& Optimizer() { return cmaes; }
+
+  //! Get the factor the population size of the large regime is multiplied by.
+  double PopulationFactor() const { return populationFactor; }
+  //! Modify the factor the population size of the large regime is multiplied
+  //! by.
+  double& PopulationFactor() { return populationFactor; }
+
+  //! Get the maximum number of restarts.
+  size_t MaxRestarts() const { return maxRestarts; }
+  //! Modify the maximum number of restarts.
+  size_t& MaxRestarts() { return maxRestarts; }
+
+  //! Get the maximum number of evaluations of all runs (0 means no limit).
+  size_t MaxFunctionEvaluations() const { return maxFunctionEvaluations; }
+  //! Modify the maximum number of evaluations of all runs (0 means no limit).
+  size_t& MaxFunctionEvaluations() { return maxFunctionEvaluations; }
+
+  //! Get whether the two regimes are run concurrently.
+  bool ParallelRegimes() const { return parallelRegimes; }
+  //! Modify whether the two regimes are run concurrently.
+  bool& ParallelRegimes() { return parallelRegimes; }
+
+  //! Get the number of restarts run by the last optimization.
+  size_t Restarts() const { return restarts; }
+
+  //! Get the number of restarts in the small population regime run by the
+  //! last optimization.
+  size_t SmallRestarts() const { return smallRestarts; }
+
+  //! Get the number of evaluations used by the last optimization.
+  size_t FunctionEvaluations() const { return functionEvaluations; }
+
+ private:
+  /**
+   * Run restarts in the small population regime until the given number of
+   * restarts or evaluations is used, or the small regime has used as many
+   * evaluations as the large regime.  The best final point is kept.
+   *
+   * @param function Function to optimize.
+   * @param start Starting point.
+   * @param rng Random number generator of the regime.
+   * @param maxRuns Maximum number of restarts.
+   * @param maxEvaluations Maximum number of evaluations (0 means no limit).
+   * @param largeBudget Number of evaluations used by the large regime.
+   * @param smallBudget Number of evaluations used by the small regime (will
+   *     be increased).
+   * @param best Best final point of the restarts (will be modified).
+   * @param bestObjective Objective of best (will be modified).
+   * @return The number of restarts that were run.
+   */
+  template<typename DecomposableFunctionType>
+  size_t SmallRegime(DecomposableFunctionType& function,
+                     const arma::mat& start,
+                     RNG& rng,
+                     const size_t maxRuns,
+                     const size_t maxEvaluations,
+                     const size_t largeBudget,
+                     size_t& smallBudget,
+                     arma::mat& best,
+                     double& bestObjective);
+
+  //! The CMA-ES optimizer that is restarted.
+  CMAESType cmaes;
+  //! The factor the population size of the large regime is multiplied by.
+  double populationFactor;
+  //! The maximum number of restarts.
+  size_t maxRestarts;
+  //! The maximum number of evaluations of all runs.
+  size_t maxFunctionEvaluations;
+  //! Whether the two regimes are run concurrently.
+  bool parallelRegimes;
+
+  //! The default population size of the current optimization.
+  size_t lambdaDefault;
+  //! The default step size of the current optimization.
+  double sigmaDefault;
+  //! The population size of the last run in the large regime.
+  size_t lambdaLarge;
+
+  //! The number of restarts run by the last optimization.
+  size_t restarts;
+  //! The number of small regime restarts run by the last optimization.
+  size_t smallRestarts;
+  //! The number of evaluations used by the last optimization.
+  size_t functionEvaluations;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "bipop_cmaes_impl.hpp"
+
+#endif
@@ -0,0 +1,214 @@
+/**
+ * @file bipop_cmaes_impl.hpp
+ *
+ * Implementation of BIPOP-CMA-ES, which restarts CMA-ES in a large and a small
+ * population regime.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CMAES_BIPOP_CMAES_IMPL_HPP
+#define ENSMALLEN_CMAES_BIPOP_CMAES_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "bipop_cmaes.hpp"
+
+namespace ens {
+
+template<typename CMAESType>
+BIPOP_CMAES<CMAESType>::BIPOP_CMAES(const CMAESType& cmaes,
+                                    const double populationFactor,
+                                    const size_t maxRestarts,
+                                    const size_t maxFunctionEvaluations,
+                                    const bool parallelRegimes) :
+    cmaes(cmaes),
+    populationFactor(populationFactor),
+    maxRestarts(maxRestarts),
+    maxFunctionEvaluations(maxFunctionEvaluations),
+    parallelRegimes(parallelRegimes),
+    lambdaDefault(0),
+    sigmaDefault(0.0),
+    lambdaLarge(0),
+    restarts(0),
+    smallRestarts(0),
+    functionEvaluations(0)
+{ /* Nothing to do. */ }
+
+//! Optimize the function (minimize).
+template<typename CMAESType>
+template<typename DecomposableFunctionType>
+double BIPOP_CMAES<CMAESType>::Optimize(DecomposableFunctionType& function,
+                                        arma::mat& iterate)
+{
+  if (populationFactor <= 1.0)
+  {
+    throw std::invalid_argument("BIPOP_CMAES::Optimize(): populationFactor "
+        "must be greater than 1!");
+  }
+
+  lambdaDefault = (cmaes.PopulationSize() == 0) ?
+      CMAESType::DefaultPopulationSize(iterate.n_elem) :
+      cmaes.PopulationSize();
+  sigmaDefault = (cmaes.InitialStepSize() > 0.0) ? cmaes.InitialStepSize() :
+      0.3 * (cmaes.UpperBound() - cmaes.LowerBound());
+  lambdaLarge = lambdaDefault;
+
+  restarts = 0;
+  smallRestarts = 0;
+  functionEvaluations = 0;
+
+  // The first run, with the default parameters, counts for the large regime.
+  const arma::mat start = iterate;
+  double bestObjective = RunCMAESRestart(cmaes, lambdaDefault,
+      cmaes.InitialStepSize(), function, iterate, maxFunctionEvaluations,
+      functionEvaluations);
+  size_t largeBudget = functionEvaluations;
+  size_t smallBudget = 0;
+  size_t largeRuns = 0;
+
+  Info << "BIPOP-CMA-ES: first run with population size " << lambdaDefault
+      << ", objective " << bestObjective << ".\n";
+
+  RNG rng(RNG::ArmaSeed());
+  while (restarts < maxRestarts && (maxFunctionEvaluations == 0 ||
+      functionEvaluations < maxFunctionEvaluations))
+  {
+    // Each round runs small restarts until the small regime has caught up
+    // with the large one, and one large restart.  One restart is kept for
+    // the large regime.
+    const size_t remaining = (maxFunctionEvaluations == 0) ? 0 :
+        maxFunctionEvaluations - functionEvaluations;
+    const size_t smallLimit = parallelRegimes ? remaining / 2 : remaining;
+    const size_t smallMaxRuns = (maxFunctionEvaluations != 0 &&
+        smallLimit == 0) ? 0 : maxRestarts - restarts - 1;
+    const size_t largeLambda = (size_t) std::round(lambdaDefault *
+        std::pow(populationFactor, (double) (largeRuns + 1)));
+
+    RNG smallRng(rng());
+    const uint64_t smallSeed = rng();
+    const uint64_t largeSeed = rng();
+
+    arma::mat smallBest, largeBest = start;
+    double smallObjective = DBL_MAX, largeObjective = DBL_MAX;
+    size_t smallBudgetRound = smallBudget, smallRuns = 0, largeEvaluations = 0;
+    bool largeRun = false;
+
+    #ifdef ENS_USE_OPENMP
+      #pragma omp parallel sections if(parallelRegimes)
+    #endif
+    {
+      #ifdef ENS_USE_OPENMP
+        #pragma omp section
+      #endif
+      {
+        if (parallelRegimes)
+          arma::arma_rng::set_seed(smallSeed);
+
+        smallRuns = SmallRegime(function, start, smallRng, smallMaxRuns,
+            smallLimit, largeBudget, smallBudgetRound, smallBest,
+            smallObjective);
+      }
+
+      #ifdef ENS_USE_OPENMP
+        #pragma omp section
+      #endif
+      {
+        if (parallelRegimes)
+          arma::arma_rng::set_seed(largeSeed);
+
+        // Run serially, the large restart gets what the small ones left.
+        const size_t used = smallBudgetRound - smallBudget;
+        const size_t largeLimit = (maxFunctionEvaluations == 0) ? 0 :
+            (parallelRegimes ? remaining - smallLimit : remaining - used);
+        if (maxFunctionEvaluations == 0 || largeLimit > 0)
+        {
+          largeObjective = RunCMAESRestart(cmaes, largeLambda,
+              cmaes.InitialStepSize(), function, largeBest, largeLimit,
+              largeEvaluations);
+          largeRun = true;
+        }
+      }
+    }
+
+    // Account for the round, and keep the best point (the small regime first,
+    // as in the serial order).
+    functionEvaluations += (smallBudgetRound - smallBudget) + largeEvaluations;
+    smallBudget = smallBudgetRound;
+    restarts += smallRuns;
+    smallRestarts += smallRuns;
+    if (smallRuns > 0)
+    {
+      Info << "BIPOP-CMA-ES: " << smallRuns << " small restarts, best "
+          << "objective " << smallObjective << ".\n";
+    }
+
+    if (smallRuns > 0 && smallObjective < bestObjective)
+    {
+      bestObjective = smallObjective;
+      iterate = smallBest;
+    }
+
+    if (!largeRun)
+      break;
+
+    ++restarts;
+    ++largeRuns;
+    largeBudget += largeEvaluations;
+    lambdaLarge = largeLambda;
+    Info << "BIPOP-CMA-ES: large restart with population size " << largeLambda
+        << ", objective " << largeObjective << ".\n";
+    if (largeObjective < bestObjective)
+    {
+      bestObjective = largeObjective;
+      iterate = largeBest;
+    }
+  }
+
+  return bestObjective;
+}
+
+//! Run the restarts of the small population regime.
+template<typename CMAESType>
+template<typename DecomposableFunctionType>
+size_t BIPOP_CMAES<CMAESType>::SmallRegime(DecomposableFunctionType& function,
+                                           const arma::mat& start,
+                                           RNG& rng,
+                                           const size_t maxRuns,
+                                           const size_t maxEvaluations,
+                                           const size_t largeBudget,
+                                           size_t& smallBudget,
+                                           arma::mat& best,
+                                           double& bestObjective)
+{
+  size_t runs = 0, evaluations = 0;
+  while (runs < maxRuns && smallBudget < largeBudget &&
+      (maxEvaluations == 0 || evaluations < maxEvaluations))
+  {
+    const double u = rng.Randu();
+    const size_t lambda = std::max((size_t) 4, (size_t) std::floor(
+        lambdaDefault * std::pow(0.5 * lambdaLarge / lambdaDefault, u * u)));
+    const double sigma = sigmaDefault * std::pow(10.0, -2.0 * u);
+
+    arma::mat candidate = start;
+    const size_t before = evaluations;
+    const double objective = RunCMAESRestart(cmaes, lambda, sigma, function,
+        candidate, (maxEvaluations == 0) ? 0 : maxEvaluations - evaluations,
+        evaluations);
+    smallBudget += evaluations - before;
+    ++runs;
+
+    if (runs == 1 || objective < bestObjective)
+    {
+      bestObjective = objective;
+      best = std::move(candidate);
+    }
+  }
+
+  return runs;
+}
+
+} // namespace ens
+
+#endif
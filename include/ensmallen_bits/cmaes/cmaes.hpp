@@ -17,6 +17,9 @@
 
 #include "full_selection.hpp"
 #include "random_selection.hpp"
+#include "full_covariance.hpp"
+#include "diagonal_covariance.hpp"
+#include "quadratic_surrogate.hpp"
 
 namespace ens {
 
@@ -45,9 +48,24 @@ namespace ens {
  * documentation on function types included with this distribution or on the
  * ensmallen website.
  *
+ * When Surrogate() is set, CMA-ES runs as lq-CMA-ES: a linear-quadratic model
+ * of the objective (see QuadraticSurrogate) is fitted to the points evaluated
+ * so far, and pre-screens the offspring of each generation.  The offspring are
+ * evaluated with the objective in the order of their predicted objectives, a
+ * fraction of the population at a time, until the ranking of the model agrees
+ * with that of the evaluated offspring (their Kendall rank correlation reaches
+ * SurrogateTau()); the whole population is then ranked by the model, refitted
+ * to the new evaluations.  The sampling, the recombination and the update of
+ * the search distribution are unchanged, so on functions that the model fits
+ * well, such as smooth functions near their optimum, most of the offspring are
+ * never evaluated.  Evaluations() counts the evaluations of the objective.
+ *
  * @tparam SelectionPolicy The selection strategy used for the evaluation step.
+ * @tparam CovariancePolicyType The model of the covariance matrix of the search
+ *     distribution (FullCovariance or DiagonalCovariance).
  */
-template<typename SelectionPolicyType = FullSelection>
+template<typename SelectionPolicyType = FullSelection,
+         typename CovariancePolicyType = FullCovariance>
 class CMAES
 {
  public:
@@ -68,6 +86,10 @@ class CMAES
    * @param tolerance Maximum absolute tolerance to terminate algorithm.
    * @param selectionPolicy Instantiated selection policy used to calculate the
    *     objective.
+   * @param parallelEvaluation If true, the offspring of each generation are
+   *     evaluated in parallel with OpenMP.
+   * @param covariancePolicy Instantiated covariance policy used to adapt the
+   *     search distribution.
    */
   CMAES(const size_t lambda = 0,
         const double lowerBound = -10,
@@ -75,7 +97,9 @@ class CMAES
         const size_t batchSize = 32,
         const size_t maxIterations = 1000,
         const double tolerance = 1e-5,
-        const SelectionPolicyType& selectionPolicy = SelectionPolicyType());
+        const SelectionPolicyType& selectionPolicy = SelectionPolicyType(),
+        const bool parallelEvaluation = false,
+        const CovariancePolicyType& covariancePolicy = CovariancePolicyType());
 
   /**
    * Optimize the given function using CMA-ES. The given starting point will be
@@ -83,12 +107,46 @@ class CMAES
    * objective value is returned.
    *
    * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to optimize.
    * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
    * @return Objective value of the final point.
    */
-  template<typename DecomposableFunctionType>
-  double Optimize(DecomposableFunctionType& function, arma::mat& iterate);
+  template<typename DecomposableFunctionType, typename... CallbackTypes>
+  double Optimize(DecomposableFunctionType& function,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
+
+  /**
+   * Estimate the number of bytes Optimize() allocates for an iterate of the
+   * given size: the steps and positions of the population (two n x lambda
+   * cubes), the mean positions and evolution paths, and the state of the
+   * covariance policy (the n x n covariance matrix and its decomposition for
+   * FullCovariance).  The memory of the iterate and of the function is not
+   * included.
+   *
+   * @param rows Number of rows of the iterate.
+   * @param cols Number of columns of the iterate.
+   */
+  size_t EstimateMemory(const size_t rows, const size_t cols = 1) const
+  {
+    const size_t n = rows * cols;
+    const size_t populationSize = (lambda == 0) ?
+        DefaultPopulationSize(n) : lambda;
+
+    // The population cubes, the three mean positions, the step, the two
+    // evolution paths (two slices each), and the objectives, recombination
+    // weights and visitation order of the population.
+    // The archive of the surrogate holds its points and their objectives.
+    const size_t archiveBytes = surrogate ? std::max(populationSize,
+        QuadraticSurrogate::DefaultCapacity(n)) * (n + 1) * sizeof(double) : 0;
+
+    return (2 * populationSize * n + 8 * n + 2 * populationSize +
+        populationSize / 2) * sizeof(double) + populationSize *
+        sizeof(arma::uword) + CovariancePolicyType::EstimateStateBytes(rows,
+        cols, populationSize) + archiveBytes;
+  }
 
   //! Get the step size.
   size_t PopulationSize() const { return lambda; }
@@ -125,7 +183,134 @@ class CMAES
   //! Modify the selection policy.
   SelectionPolicyType& SelectionPolicy() { return selectionPolicy; }
 
+  //! Get whether the offspring are evaluated in parallel.
+  bool ParallelEvaluation() const { return parallelEvaluation; }
+  //! Modify whether the offspring are evaluated in parallel.
+  bool& ParallelEvaluation() { return parallelEvaluation; }
+
+  //! Get the covariance policy.
+  const CovariancePolicyType& CovariancePolicy() const
+  { return covariancePolicy; }
+  //! Modify the covariance policy.
+  CovariancePolicyType& CovariancePolicy() { return covariancePolicy; }
+
+  //! Get the initial step size (0 means 0.3 * (upperBound - lowerBound)).
+  double InitialStepSize() const { return initialStepSize; }
+  //! Modify the initial step size (0 means 0.3 * (upperBound - lowerBound)).
+  double& InitialStepSize() { return initialStepSize; }
+
+  //! Get whether the offspring are pre-screened by a surrogate (lq-CMA-ES).
+  bool Surrogate() const { return surrogate; }
+  //! Modify whether the offspring are pre-screened by a surrogate (lq-CMA-ES).
+  bool& Surrogate() { return surrogate; }
+
+  //! Get the rank correlation at which the surrogate is trusted.
+  double SurrogateTau() const { return surrogateTau; }
+  //! Modify the rank correlation at which the surrogate is trusted.
+  double& SurrogateTau() { return surrogateTau; }
+
+  //! Get the fraction of the population first evaluated with a surrogate.
+  double SurrogateFraction() const { return surrogateFraction; }
+  //! Modify the fraction of the population first evaluated with a surrogate.
+  double& SurrogateFraction() { return surrogateFraction; }
+
+  //! Get the number of evaluations of the objective in the last optimization.
+  size_t Evaluations() const { return evaluations; }
+
+  /**
+   * Get the population size that is used when PopulationSize() is 0, for an
+   * iterate with the given number of elements.
+   *
+   * @param elements Number of elements of the iterate.
+   */
+  static size_t DefaultPopulationSize(const size_t elements)
+  {
+    return (4 + std::round(3 * std::log(elements))) * 10;
+  }
+
  private:
+  /**
+   * Evaluate the objective of every offspring in the given population (in
+   * parallel, if parallelEvaluation is set).  Each offspring gets its own
+   * stream of random numbers, created from the global generator before any
+   * evaluation starts, so the result does not depend on whether the evaluation
+   * is parallel, on the number of threads or on the scheduling.
+   *
+   * @param function Function to evaluate.
+   * @param population Offspring to evaluate (one per slice).
+   * @param objectives Vector to store the objective of each offspring in.
+   */
+  template<typename DecomposableFunctionType>
+  void EvaluatePopulation(DecomposableFunctionType& function,
+                          const arma::cube& population,
+                          arma::vec& objectives);
+
+  /**
+   * Evaluate the most promising offspring of the given population, as picked
+   * by the surrogate, until the surrogate ranks the evaluated offspring like
+   * the objective; then the objective of every offspring is set to its
+   * prediction by the surrogate, refitted to the new evaluations.  If the
+   * surrogate cannot be fitted, the whole population is evaluated.  The
+   * evaluations are added to the archive of the surrogate.  Returns true if a
+   * callback asked to terminate.
+   *
+   * @param function Function to evaluate.
+   * @param population Offspring to evaluate (one per slice).
+   * @param objectives Vector to store the objective of each offspring in.
+   * @param model The surrogate.
+   * @param center The mean of the search distribution.
+   * @param scale The step size of the search distribution.
+   * @param callbacks Callback functions.
+   */
+  template<typename DecomposableFunctionType, typename... CallbackTypes>
+  bool ScreenPopulation(DecomposableFunctionType& function,
+                        const arma::cube& population,
+                        arma::vec& objectives,
+                        QuadraticSurrogate& model,
+                        const arma::mat& center,
+                        const double scale,
+                        CallbackTypes&... callbacks);
+
+  //! Let the selection policy prepare the evaluation of a generation, if it
+  //! has a BeginPopulation() method.
+  template<typename DecomposableFunctionType,
+           typename PolicyType = SelectionPolicyType>
+  auto BeginPopulation(DecomposableFunctionType& function, int /* preferred */)
+      -> decltype(std::declval<PolicyType&>().BeginPopulation(function,
+          std::declval<size_t>()))
+  {
+    return selectionPolicy.BeginPopulation(function, batchSize);
+  }
+
+  //! Selection policies without BeginPopulation() need no preparation.
+  template<typename DecomposableFunctionType>
+  void BeginPopulation(DecomposableFunctionType& /* function */,
+                       long /* fallback */) { }
+
+  //! Evaluate the given point with the selection policy, passing the given
+  //! random number generator if the policy accepts one.
+  template<typename DecomposableFunctionType, typename GeneratorType>
+  auto Select(DecomposableFunctionType& function,
+              const arma::mat& iterate,
+              GeneratorType& generator,
+              int /* preferred */)
+      -> decltype(std::declval<SelectionPolicyType&>().Select(function,
+          std::declval<size_t>(), iterate, generator))
+  {
+    return selectionPolicy.Select(function, batchSize, iterate, generator);
+  }
+
+  //! Evaluate the given point with a selection policy that does not accept a
+  //! random number generator.
+  template<typename DecomposableFunctionType, typename GeneratorType>
+  double Select(DecomposableFunctionType& function,
+                const arma::mat& iterate,
+                GeneratorType& /* generator */,
+                long /* fallback */)
+  {
+    return selectionPolicy.Select(function, batchSize, iterate);
+  }
+
   //! Population size.
   size_t lambda;
 
@@ -146,6 +331,27 @@ class CMAES
 
   //! The selection policy used to calculate the objective.
   SelectionPolicyType selectionPolicy;
+
+  //! Whether the offspring are evaluated in parallel.
+  bool parallelEvaluation;
+
+  //! The covariance policy used to adapt the search distribution.
+  CovariancePolicyType covariancePolicy;
+
+  //! The initial step size (0 means 0.3 * (upperBound - lowerBound)).
+  double initialStepSize;
+
+  //! Whether the offspring are pre-screened by a surrogate.
+  bool surrogate;
+
+  //! The rank correlation at which the surrogate is trusted.
+  double surrogateTau;
+
+  //! The fraction of the population first evaluated with a surrogate.
+  double surrogateFraction;
+
+  //! The number of evaluations of the objective in the last optimization.
+  size_t evaluations;
 };
 
 /**
@@ -154,6 +360,13 @@ class CMAES
 template<typename SelectionPolicyType = RandomSelection>
 using ApproxCMAES = CMAES<SelectionPolicyType>;
 
+/**
+ * Convenient typedef for sep-CMA-ES, which only adapts the diagonal of the
+ * covariance matrix.
+ */
+template<typename SelectionPolicyType = FullSelection>
+using SepCMAES = CMAES<SelectionPolicyType, DiagonalCovariance>;
+
 } // namespace ens
 
 // Include implementation.
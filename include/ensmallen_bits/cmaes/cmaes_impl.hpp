@@ -22,28 +22,40 @@
 
 namespace ens {
 
-template<typename SelectionPolicyType>
-CMAES<SelectionPolicyType>::CMAES(const size_t lambda,
-                                  const double lowerBound,
-                                  const double upperBound,
-                                  const size_t batchSize,
-                                  const size_t maxIterations,
-                                  const double tolerance,
-                                  const SelectionPolicyType& selectionPolicy) :
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+CMAES<SelectionPolicyType, CovariancePolicyType>::CMAES(
+    const size_t lambda,
+    const double lowerBound,
+    const double upperBound,
+    const size_t batchSize,
+    const size_t maxIterations,
+    const double tolerance,
+    const SelectionPolicyType& selectionPolicy,
+    const bool parallelEvaluation,
+    const CovariancePolicyType& covariancePolicy) :
     lambda(lambda),
     lowerBound(lowerBound),
     upperBound(upperBound),
     batchSize(batchSize),
     maxIterations(maxIterations),
     tolerance(tolerance),
-    selectionPolicy(selectionPolicy)
+    selectionPolicy(selectionPolicy),
+    parallelEvaluation(parallelEvaluation),
+    covariancePolicy(covariancePolicy),
+    initialStepSize(0.0),
+    surrogate(false),
+    surrogateTau(0.85),
+    surrogateFraction(0.1),
+    evaluations(0)
 { /* Nothing to do. */ }
 
 //! Optimize the function (minimize).
-template<typename SelectionPolicyType>
-template<typename DecomposableFunctionType>
-double CMAES<SelectionPolicyType>::Optimize(
-    DecomposableFunctionType& function, arma::mat& iterate)
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+template<typename DecomposableFunctionType, typename... CallbackTypes>
+double CMAES<SelectionPolicyType, CovariancePolicyType>::Optimize(
+    DecomposableFunctionType& function,
+    arma::mat& iterate,
+    CallbackTypes&&... callbacks)
 {
   // Make sure that we have the methods that we need.  Long name...
   traits::CheckNonDifferentiableDecomposableFunctionTypeAPI<
@@ -54,7 +66,7 @@ double CMAES<SelectionPolicyType>::Optimize(
 
   // Population size.
   if (lambda == 0)
-    lambda = (4 + std::round(3 * std::log(iterate.n_elem))) * 10;
+    lambda = DefaultPopulationSize(iterate.n_elem);
 
   // Parent weights.
   const size_t mu = std::round(lambda / 2);
@@ -67,7 +79,8 @@ double CMAES<SelectionPolicyType>::Optimize(
 
   // Step size control parameters.
   arma::vec sigma(3);
-  sigma(0) = 0.3 * (upperBound - lowerBound);
+  sigma(0) = (initialStepSize > 0.0) ? initialStepSize :
+      0.3 * (upperBound - lowerBound);
   const double cs = (muEffective + 2) / (iterate.n_elem + muEffective + 5);
   const double ds = 1 + cs + 2 * std::max(std::sqrt((muEffective - 1) /
       (iterate.n_elem + 1)) - 1, 0.0);
@@ -103,70 +116,97 @@ double CMAES<SelectionPolicyType>::Optimize(
 
   double overallObjective = currentObjective;
   double lastObjective = DBL_MAX;
+  evaluations = 1;
+
+  // The surrogate (only given an archive if it is used) starts from the
+  // evaluated points.
+  QuadraticSurrogate model(surrogate ? iterate.n_elem : 0, surrogate ?
+      std::max(lambda, QuadraticSurrogate::DefaultCapacity(iterate.n_elem)) :
+      0);
+  model.Add(mPosition.slice(0), currentObjective);
 
   // Population parameters.
   arma::cube pStep(iterate.n_rows, iterate.n_cols, lambda);
   arma::cube pPosition(iterate.n_rows, iterate.n_cols, lambda);
   arma::vec pObjective(lambda);
+  arma::mat pStepMatrix(pStep.memptr(), iterate.n_elem, lambda, false, true);
+  arma::mat pPositionMatrix(pPosition.memptr(), iterate.n_elem, lambda, false,
+      true);
+  arma::vec wPopulation(lambda);
   arma::cube ps = arma::zeros(iterate.n_rows, iterate.n_cols, 2);
   arma::cube pc = ps;
-  arma::cube C(iterate.n_elem, iterate.n_elem, 2);
-  C.slice(0).eye();
 
-  // Covariance matrix parameters.
-  arma::vec eigval;
-  arma::mat eigvec;
-  arma::vec eigvalZero = arma::zeros(iterate.n_elem);
+  // Start with the identity covariance matrix.
+  covariancePolicy.Initialize(iterate.n_rows, iterate.n_cols, lambda);
 
   // The current visitation order (sorted by population objectives).
   arma::uvec idx = arma::linspace<arma::uvec>(0, lambda - 1, lambda);
 
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+  terminate |= Callback::BeginOptimization(*this, function, iterate,
+      callbacks...);
+
   // Now iterate!
-  for (size_t i = 1; i < maxIterations; ++i)
+  for (size_t i = 1; i < maxIterations && !terminate; ++i)
   {
     // To keep track of where we are.
     const size_t idx0 = (i - 1) % 2;
     const size_t idx1 = i % 2;
 
-    // Perform Cholesky decomposition. If the matrix is not positive definite,
-    // add a small value and try again
-    arma::mat covLower;
-    while (!arma::chol(covLower, C.slice(idx0), "lower"))
-      C.slice(idx0).diag() += 1e-16;
-
-    for (size_t j = 0; j < lambda; ++j)
+    // Factorize the covariance matrix for sampling, if needed.
+    covariancePolicy.Decompose();
+
+    // Sample the steps of all offspring at once.  The slices of the cubes are
+    // the columns of n x lambda matrices, so the offspring are formed with
+    // whole-matrix operations.
+    covariancePolicy.Sample(pStep);
+    pPositionMatrix = sigma(idx0) * pStepMatrix;
+    pPositionMatrix.each_col() += arma::vectorise(mPosition.slice(idx0));
+
+    // Calculate the objective function of all offspring (or, with a
+    // surrogate, of the most promising ones, and rank them all by the model).
+    // The evaluations are reported afterwards, so that callbacks are never
+    // called from several threads.
+    if (surrogate)
     {
-      if (iterate.n_rows > iterate.n_cols)
-      {
-        pStep.slice(idx(j)) = covLower *
-            arma::randn(iterate.n_rows, iterate.n_cols);
-      }
-      else
+      terminate |= ScreenPopulation(function, pPosition, pObjective, model,
+          mPosition.slice(idx0), sigma(idx0), callbacks...);
+    }
+    else
+    {
+      EvaluatePopulation(function, pPosition, pObjective);
+      evaluations += lambda;
+      for (size_t j = 0; j < lambda; ++j)
       {
-        pStep.slice(idx(j)) = arma::randn(iterate.n_rows, iterate.n_cols) *
-            covLower;
+        terminate |= Callback::Evaluate(*this, function, pPosition.slice(j),
+            pObjective(j), callbacks...);
       }
-
-      pPosition.slice(idx(j)) = mPosition.slice(idx0) + sigma(idx0) *
-          pStep.slice(idx(j));
-
-      // Calculate the objective function.
-      pObjective(idx(j)) = selectionPolicy.Select(function, batchSize,
-          pPosition.slice(idx(j)));
     }
 
-    // Sort population.
-    idx = sort_index(pObjective);
+    // Find the mu best offspring, in order; the others are not sorted, since
+    // only the first mu are recombined.  idx stays a permutation of the
+    // offspring, so it is reused as the sampling order of the next iteration.
+    PartialSortIndex(pObjective, mu, idx);
 
-    step = w(0) * pStep.slice(idx(0));
-    for (size_t j = 1; j < mu; ++j)
-      step += w(j) * pStep.slice(idx(j));
+    // The weighted recombination of the mu best steps is a single
+    // matrix-vector product, with zero weights for the other offspring.
+    wPopulation.zeros();
+    for (size_t j = 0; j < mu; ++j)
+      wPopulation(idx(j)) = w(j);
+    arma::mat stepVec(step.memptr(), step.n_elem, 1, false, true);
+    stepVec = pStepMatrix * wPopulation;
 
     mPosition.slice(idx1) = mPosition.slice(idx0) + sigma(idx0) * step;
 
     // Calculate the objective function.
     currentObjective = selectionPolicy.Select(function, batchSize,
           mPosition.slice(idx1));
+    ++evaluations;
+    model.Add(mPosition.slice(idx1), currentObjective);
+
+    terminate |= Callback::Evaluate(*this, function, mPosition.slice(idx1),
+        currentObjective, callbacks...);
 
     // Update best parameters.
     if (currentObjective < overallObjective)
@@ -175,98 +215,42 @@ double CMAES<SelectionPolicyType>::Optimize(
       iterate = mPosition.slice(idx1);
     }
 
+    terminate |= Callback::StepTaken(*this, function, iterate, callbacks...);
+
     // Update Step Size.
-    if (iterate.n_rows > iterate.n_cols)
-    {
-      ps.slice(idx1) = (1 - cs) * ps.slice(idx0) + std::sqrt(
-          cs * (2 - cs) * muEffective) * covLower.t() * step;
-    }
-    else
-    {
-      ps.slice(idx1) = (1 - cs) * ps.slice(idx0) + std::sqrt(
-          cs * (2 - cs) * muEffective) * step * covLower.t();
-    }
+    ps.slice(idx1) = (1 - cs) * ps.slice(idx0) + std::sqrt(
+        cs * (2 - cs) * muEffective) * covariancePolicy.TransformStep(step);
 
     const double psNorm = arma::norm(ps.slice(idx1));
     sigma(idx1) = sigma(idx0) * std::pow(
         std::exp(cs / ds * psNorm / enn - 1), 0.3);
 
     // Update covariance matrix.
-    if ((psNorm / sqrt(1 - std::pow(1 - cs, 2 * i))) < h)
+    const bool hsig = (psNorm / sqrt(1 - std::pow(1 - cs, 2 * i))) < h;
+    if (hsig)
     {
       pc.slice(idx1) = (1 - cc) * pc.slice(idx0) + std::sqrt(cc * (2 - cc) *
         muEffective) * step;
-
-
-      if (iterate.n_rows > iterate.n_cols)
-      {
-        C.slice(idx1) = (1 - c1 - cmu) * C.slice(idx0) + c1 *
-          (pc.slice(idx1) * pc.slice(idx1).t());
-      }
-      else
-      {
-        C.slice(idx1) = (1 - c1 - cmu) * C.slice(idx0) + c1 *
-          (pc.slice(idx1).t() * pc.slice(idx1));
-      }
     }
     else
     {
       pc.slice(idx1) = (1 - cc) * pc.slice(idx0);
-
-      if (iterate.n_rows > iterate.n_cols)
-      {
-        C.slice(idx1) = (1 - c1 - cmu) * C.slice(idx0) + c1 * (pc.slice(idx1) *
-            pc.slice(idx1).t() + (cc * (2 - cc)) * C.slice(idx0));
-      }
-      else
-      {
-        C.slice(idx1) = (1 - c1 - cmu) * C.slice(idx0) + c1 *
-            (pc.slice(idx1).t() * pc.slice(idx1) + (cc * (2 - cc)) *
-            C.slice(idx0));
-      }
-    }
-
-    if (iterate.n_rows > iterate.n_cols)
-    {
-      for (size_t j = 0; j < mu; ++j)
-      {
-        C.slice(idx1) = C.slice(idx1) + cmu * w(j) *
-            pStep.slice(idx(j)) * pStep.slice(idx(j)).t();
-      }
-    }
-    else
-    {
-      for (size_t j = 0; j < mu; ++j)
-      {
-        C.slice(idx1) = C.slice(idx1) + cmu * w(j) *
-            pStep.slice(idx(j)).t() * pStep.slice(idx(j));
-      }
     }
 
-    arma::eig_sym(eigval, eigvec, C.slice(idx1));
-    const arma::uvec negativeEigval = find(eigval < 0, 1);
-    if (!negativeEigval.is_empty())
-    {
-      if (negativeEigval(0) == 0)
-      {
-        C.slice(idx1).zeros();
-      }
-      else
-      {
-        C.slice(idx1) = eigvec.cols(0, negativeEigval(0) - 1) *
-            arma::diagmat(eigval.subvec(0, negativeEigval(0) - 1)) *
-            eigvec.cols(0, negativeEigval(0) - 1).t();
-      }
-    }
+    covariancePolicy.Update(pc.slice(idx1), hsig, c1, cmu, cc, pStep, w, idx);
 
     // Output current objective function.
     Info << "CMA-ES: iteration " << i << ", objective " << overallObjective
-        << "." << std::endl;
+        << ".\n";
+
+    terminate |= Callback::EndEpoch(*this, function, iterate, i - 1,
+        overallObjective, callbacks...);
 
     if (std::isnan(overallObjective) || std::isinf(overallObjective))
     {
       Warn << "CMA-ES: converged to " << overallObjective << "; "
           << "terminating with failure.  Try a smaller step size?" << std::endl;
+      Callback::EndOptimization(*this, function, iterate, callbacks...);
       return overallObjective;
     }
 
@@ -274,15 +258,155 @@ double CMAES<SelectionPolicyType>::Optimize(
     {
       Info << "CMA-ES: minimized within tolerance " << tolerance << "; "
           << "terminating optimization." << std::endl;
+      Callback::EndOptimization(*this, function, iterate, callbacks...);
       return overallObjective;
     }
 
     lastObjective = overallObjective;
   }
 
+  Callback::EndOptimization(*this, function, iterate, callbacks...);
   return overallObjective;
 }
 
+//! Pre-screen the offspring with the surrogate.
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+template<typename DecomposableFunctionType, typename... CallbackTypes>
+bool CMAES<SelectionPolicyType, CovariancePolicyType>::ScreenPopulation(
+    DecomposableFunctionType& function,
+    const arma::cube& population,
+    arma::vec& objectives,
+    QuadraticSurrogate& model,
+    const arma::mat& center,
+    const double scale,
+    CallbackTypes&... callbacks)
+{
+  const size_t n = population.n_slices;
+  bool terminate = false;
+
+  // The prediction of each offspring when it was picked for evaluation, and
+  // the order in which the offspring are evaluated.  Until the archive is
+  // large enough for a model, the whole population is evaluated at once.
+  arma::vec predicted(n, arma::fill::zeros);
+  arma::uvec order = arma::linspace<arma::uvec>(0, n - 1, n);
+  size_t batch = n;
+  if (model.Fit(center, scale))
+  {
+    for (size_t j = 0; j < n; ++j)
+      predicted(j) = model.Predict(population.slice(j));
+    order = arma::sort_index(predicted);
+    batch = std::min(n, std::max((size_t) 1,
+        (size_t) std::ceil(surrogateFraction * n)));
+  }
+
+  size_t numEvaluated = 0;
+  while (true)
+  {
+    // Evaluate the next most promising offspring.
+    const size_t count = std::min(batch, n - numEvaluated);
+    arma::cube batchPopulation(population.n_rows, population.n_cols, count);
+    for (size_t k = 0; k < count; ++k)
+      batchPopulation.slice(k) = population.slice(order(numEvaluated + k));
+
+    arma::vec batchObjectives(count);
+    EvaluatePopulation(function, batchPopulation, batchObjectives);
+    for (size_t k = 0; k < count; ++k)
+    {
+      const size_t j = order(numEvaluated + k);
+      objectives(j) = batchObjectives(k);
+      model.Add(population.slice(j), objectives(j));
+      terminate |= Callback::Evaluate(*this, function, population.slice(j),
+          objectives(j), callbacks...);
+    }
+    numEvaluated += count;
+    evaluations += count;
+
+    // Once every offspring is evaluated, the objectives rank the population.
+    if (numEvaluated == n)
+      return terminate;
+
+    // Stop when the model ranked the evaluated offspring (before it saw them)
+    // like the objective does.
+    const arma::uvec evaluated = order.head(numEvaluated);
+    if (QuadraticSurrogate::KendallTau(predicted.elem(evaluated),
+        objectives.elem(evaluated)) >= surrogateTau)
+    {
+      break;
+    }
+
+    // Otherwise, refit the model to the new evaluations, rank the remaining
+    // offspring again, and evaluate as many as have been evaluated so far.
+    if (model.Fit(center, scale))
+    {
+      const arma::uvec remaining = order.tail(n - numEvaluated);
+      for (size_t k = 0; k < remaining.n_elem; ++k)
+        predicted(remaining(k)) = model.Predict(population.slice(remaining(k)));
+
+      const arma::vec remainingPredicted = predicted.elem(remaining);
+      order.tail(n - numEvaluated) =
+          remaining.elem(arma::sort_index(remainingPredicted));
+      batch = numEvaluated;
+    }
+    else
+    {
+      batch = n;
+    }
+  }
+
+  // Rank the whole population by the model, refitted to all the evaluations
+  // (or by the last predictions, if it cannot be refitted).
+  if (model.Fit(center, scale))
+  {
+    for (size_t j = 0; j < n; ++j)
+      objectives(j) = model.Predict(population.slice(j));
+  }
+  else
+  {
+    objectives = predicted;
+  }
+
+  return terminate;
+}
+
+//! Evaluate the offspring.
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+template<typename DecomposableFunctionType>
+void CMAES<SelectionPolicyType, CovariancePolicyType>::EvaluatePopulation(
+    DecomposableFunctionType& function,
+    const arma::cube& population,
+    arma::vec& objectives)
+{
+  // With a shared selection, the batches of the generation are drawn here.
+  BeginPopulation(function, 0);
+
+  // When the whole objective is used, a function with EvaluateAsync() gets all
+  // the evaluations started at once.
+  if (std::is_same<SelectionPolicyType, FullSelection>::value &&
+      TryEvaluateInFlight(function, population.n_slices,
+      [&](const size_t j) -> const arma::mat& { return population.slice(j); },
+      [&](const size_t j, const double objective)
+      {
+        objectives(j) = objective;
+      }))
+  {
+    return;
+  }
+
+  // Create a stream for each offspring before the evaluation starts, so that
+  // each one uses the same random numbers no matter which thread evaluates it.
+  std::vector<RNG> generators =
+      RNG(RNG::ArmaSeed()).Streams(population.n_slices);
+
+  // Evaluations may take very different amounts of time, so hand them out
+  // one at a time.  Functions that are known to be thread-safe are always
+  // evaluated in parallel.
+  ParallelFor(population.n_slices, [&](const size_t j)
+  {
+    objectives(j) = Select(function, population.slice(j), generators[j], 0);
+  }, parallelEvaluation ||
+      traits::IsThreadSafeFunction<DecomposableFunctionType>::value);
+}
+
 } // namespace ens
 
 #endif
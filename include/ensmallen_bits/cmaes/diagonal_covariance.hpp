@@ -0,0 +1,153 @@
+/**
+ * @file diagonal_covariance.hpp
+ *
+ * Diagonal covariance matrix adaptation for CMA-ES, as used by sep-CMA-ES.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CMAES_DIAGONAL_COVARIANCE_HPP
+#define ENSMALLEN_CMAES_DIAGONAL_COVARIANCE_HPP
+
+namespace ens {
+
+/**
+ * Adapt only the diagonal of the covariance matrix of the search distribution
+ * (sep-CMA-ES).  Each generation then takes O(n) memory and time (per
+ * offspring), where n is the number of elements of the coordinates, so this
+ * can be used for problems with many thousands of dimensions.  Since fewer
+ * parameters have to be learned, the learning rates of the covariance update
+ * are increased by (n + 2) / 3.  For more information, see the following
+ * paper:
+ *
+ * @code
+ * @inproceedings{Ros2008,
+ *   author    = {Ros, Raymond and Hansen, Nikolaus},
+ *   title     = {A Simple Modification in CMA-ES Achieving Linear Time and
+ *                Space Complexity},
+ *   booktitle = {Parallel Problem Solving from Nature -- PPSN X},
+ *   year      = {2008},
+ *   pages     = {296--305},
+ *   publisher = {Springer}
+ * }
+ * @endcode
+ */
+class DiagonalCovariance
+{
+ public:
+  /**
+   * Reset the variances to one for coordinates of the given size.
+   *
+   * @param rows Number of rows of the coordinates.
+   * @param cols Number of columns of the coordinates.
+   * @param lambda Population size (unused).
+   */
+  void Initialize(const size_t rows,
+                  const size_t cols,
+                  const size_t /* lambda */)
+  {
+    variance.ones(rows, cols);
+  }
+
+  //! Compute the standard deviations for use by Sample() and TransformStep().
+  void Decompose() { deviation = arma::sqrt(variance); }
+
+  /**
+   * Draw the steps of the whole population from the zero-mean search
+   * distribution.
+   *
+   * @param steps Cube to store the steps in, one per slice.
+   */
+  void Sample(arma::cube& steps) const
+  {
+    arma::mat stepMatrix(steps.memptr(), variance.n_elem, steps.n_slices,
+        false, true);
+    stepMatrix.randn();
+    stepMatrix.each_col() %= arma::vectorise(deviation);
+  }
+
+  /**
+   * Map the given (weighted mean) step to the space of the step size evolution
+   * path.
+   *
+   * @param step Step to transform.
+   */
+  arma::mat TransformStep(const arma::mat& step) const
+  {
+    return step / deviation;
+  }
+
+  /**
+   * Update the variances with the rank-one update from the evolution path and
+   * the rank-mu update from the selected steps.
+   *
+   * @param pc Evolution path of the covariance matrix.
+   * @param hsig Whether the evolution path was updated in this generation.
+   * @param c1 Learning rate of the rank-one update for the full covariance.
+   * @param cmu Learning rate of the rank-mu update for the full covariance.
+   * @param cc Cumulation constant of the evolution path.
+   * @param steps Steps of the population.
+   * @param weights Recombination weights of the best steps.
+   * @param idx Population indices, sorted by objective.
+   */
+  void Update(const arma::mat& pc,
+              const bool hsig,
+              const double c1,
+              const double cmu,
+              const double cc,
+              const arma::cube& steps,
+              const arma::vec& weights,
+              const arma::uvec& idx)
+  {
+    const double scale = (variance.n_elem + 2.0) / 3.0;
+    const double c1Sep = std::min(1.0, c1 * scale);
+    const double cmuSep = std::min(1.0 - c1Sep, cmu * scale);
+
+    if (hsig)
+    {
+      variance = (1 - c1Sep - cmuSep) * variance + c1Sep * (pc % pc);
+    }
+    else
+    {
+      variance = (1 - c1Sep - cmuSep) * variance + c1Sep * (pc % pc +
+          (cc * (2 - cc)) * variance);
+    }
+
+    for (size_t j = 0; j < weights.n_elem; ++j)
+    {
+      variance += cmuSep * weights(j) * (steps.slice(idx(j)) %
+          steps.slice(idx(j)));
+    }
+  }
+
+  //! Get the variances (the diagonal of the covariance matrix).
+  const arma::mat& Variance() const { return variance; }
+
+  /**
+   * Get the number of bytes the policy allocates for coordinates of the given
+   * size: the variances, the standard deviations and one temporary of the
+   * update, so the memory grows linearly with the coordinates.
+   *
+   * @param rows Number of rows of the coordinates.
+   * @param cols Number of columns of the coordinates.
+   * @param lambda Population size (unused).
+   */
+  static size_t EstimateStateBytes(const size_t rows,
+                                   const size_t cols,
+                                   const size_t /* lambda */)
+  {
+    return 3 * rows * cols * sizeof(double);
+  }
+
+ private:
+  //! The variances, in the shape of the coordinates.
+  arma::mat variance;
+  //! The standard deviations, in the shape of the coordinates.
+  arma::mat deviation;
+};
+
+} // namespace ens
+
+#endif
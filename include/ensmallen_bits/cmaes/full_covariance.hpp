@@ -0,0 +1,225 @@
+/**
+ * @file full_covariance.hpp
+ *
+ * Full covariance matrix adaptation for CMA-ES.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CMAES_FULL_COVARIANCE_HPP
+#define ENSMALLEN_CMAES_FULL_COVARIANCE_HPP
+
+namespace ens {
+
+/**
+ * Adapt the full covariance matrix of the search distribution.  This is the
+ * original CMA-ES; it needs O(n^2) memory, where n is the number of elements of
+ * the coordinates, and an O(n^3) eigendecomposition of the covariance matrix.
+ *
+ * Since the covariance matrix changes only slowly, the eigendecomposition is
+ * updated lazily: by default, it is recomputed only every n / (10 * lambda)
+ * generations (and at least every generation for small problems), and the
+ * previous factorization is used for sampling in between.
+ */
+class FullCovariance
+{
+ public:
+  /**
+   * Construct the policy with the given decomposition schedule.
+   *
+   * @param decompositionInterval Number of generations between two
+   *     eigendecompositions of the covariance matrix (0 chooses
+   *     n / (10 * lambda) automatically).
+   */
+  FullCovariance(const size_t decompositionInterval = 0) :
+      decompositionInterval(decompositionInterval),
+      rows(0),
+      cols(0),
+      interval(1),
+      generation(0)
+  { /* Nothing to do. */ }
+
+  /**
+   * Reset the covariance matrix to the identity for coordinates of the given
+   * size.
+   *
+   * @param rows Number of rows of the coordinates.
+   * @param cols Number of columns of the coordinates.
+   * @param lambda Population size.
+   */
+  void Initialize(const size_t rows, const size_t cols, const size_t lambda)
+  {
+    this->rows = rows;
+    this->cols = cols;
+    covariance.eye(rows * cols, rows * cols);
+
+    interval = (decompositionInterval != 0) ? decompositionInterval :
+        std::max((size_t) 1, (rows * cols) / (10 * lambda));
+    generation = 0;
+  }
+
+  /**
+   * Factorize the current covariance matrix for use by Sample() and
+   * TransformStep(), if the factorization is due in this generation;
+   * otherwise, the previous factorization is kept.  Negative eigenvalues,
+   * which may appear due to numerical errors, are clamped to a small positive
+   * value.
+   */
+  void Decompose()
+  {
+    if ((generation++ % interval) != 0)
+      return;
+
+    // Make sure the matrix is exactly symmetric before decomposing it.
+    covariance = arma::symmatu(covariance);
+
+    arma::vec eigval;
+    arma::mat eigvec;
+    arma::eig_sym(eigval, eigvec, covariance);
+
+    const arma::uvec negativeEigval = arma::find(eigval < 1e-16);
+    if (!negativeEigval.is_empty())
+    {
+      eigval.elem(negativeEigval).fill(1e-16);
+      covariance = eigvec * arma::diagmat(eigval) * eigvec.t();
+    }
+
+    // Sampling uses B * D, and the step size path uses C^(-1/2) =
+    // B * D^(-1) * B^T, where D holds the square roots of the eigenvalues.
+    const arma::vec deviation = arma::sqrt(eigval);
+    factor = eigvec * arma::diagmat(deviation);
+    invSqrt = eigvec * arma::diagmat(1.0 / deviation) * eigvec.t();
+  }
+
+  /**
+   * Draw the steps of the whole population from the zero-mean search
+   * distribution.  The slices of the cube are the columns of an
+   * n x lambda matrix, so all the standard normal vectors are transformed with
+   * a single matrix-matrix product.
+   *
+   * @param steps Cube to store the steps in, one per slice.
+   */
+  void Sample(arma::cube& steps) const
+  {
+    arma::mat stepMatrix(steps.memptr(), rows * cols, steps.n_slices, false,
+        true);
+    stepMatrix = factor * arma::randn(rows * cols, steps.n_slices);
+  }
+
+  /**
+   * Map the given (weighted mean) step to the space of the step size evolution
+   * path, by multiplying it with C^(-1/2).
+   *
+   * @param step Step to transform.
+   */
+  arma::mat TransformStep(const arma::mat& step) const
+  {
+    if (rows > cols)
+      return invSqrt * step;
+    else
+      return step * invSqrt;
+  }
+
+  /**
+   * Update the covariance matrix with the rank-one update from the evolution
+   * path and the rank-mu update from the selected steps.
+   *
+   * @param pc Evolution path of the covariance matrix.
+   * @param hsig Whether the evolution path was updated in this generation.
+   * @param c1 Learning rate of the rank-one update.
+   * @param cmu Learning rate of the rank-mu update.
+   * @param cc Cumulation constant of the evolution path.
+   * @param steps Steps of the population.
+   * @param weights Recombination weights of the best steps.
+   * @param idx Population indices, sorted by objective.
+   */
+  void Update(const arma::mat& pc,
+              const bool hsig,
+              const double c1,
+              const double cmu,
+              const double cc,
+              const arma::cube& steps,
+              const arma::vec& weights,
+              const arma::uvec& idx)
+  {
+    if (hsig)
+    {
+      covariance = (1 - c1 - cmu) * covariance + c1 * Outer(pc);
+    }
+    else
+    {
+      covariance = (1 - c1 - cmu) * covariance + c1 * (Outer(pc) +
+          (cc * (2 - cc)) * covariance);
+    }
+
+    // The rank-mu update is sum_j w_j s_j s_j^T = S S^T, where the columns of
+    // S are the selected steps scaled by the square roots of their (positive)
+    // weights; this is a single matrix-matrix product.
+    const arma::mat stepMatrix(const_cast<double*>(steps.memptr()),
+        rows * cols, steps.n_slices, false, true);
+    arma::mat selected = stepMatrix.cols(idx.head(weights.n_elem));
+    selected.each_row() %= arma::sqrt(weights).t();
+    covariance += cmu * (selected * selected.t());
+  }
+
+  //! Get the number of generations between two decompositions (0 means
+  //! automatic).
+  size_t DecompositionInterval() const { return decompositionInterval; }
+  //! Modify the number of generations between two decompositions (0 means
+  //! automatic).
+  size_t& DecompositionInterval() { return decompositionInterval; }
+
+  //! Get the covariance matrix.
+  const arma::mat& Covariance() const { return covariance; }
+
+  /**
+   * Get the number of bytes the policy allocates for coordinates of the given
+   * size: the covariance matrix, its factor and its inverse square root, up to
+   * two n x n temporaries of the decomposition and the update, and the
+   * standard normal samples of the population.
+   *
+   * @param rows Number of rows of the coordinates.
+   * @param cols Number of columns of the coordinates.
+   * @param lambda Population size.
+   */
+  static size_t EstimateStateBytes(const size_t rows,
+                                   const size_t cols,
+                                   const size_t lambda)
+  {
+    const size_t n = rows * cols;
+    return (5 * n * n + lambda * n) * sizeof(double);
+  }
+
+ private:
+  //! Return the outer product of the given (vector-shaped) matrix.
+  arma::mat Outer(const arma::mat& v) const
+  {
+    if (rows > cols)
+      return v * v.t();
+    else
+      return v.t() * v;
+  }
+
+  //! The requested number of generations between two decompositions.
+  size_t decompositionInterval;
+  //! Number of rows of the coordinates.
+  size_t rows;
+  //! Number of columns of the coordinates.
+  size_t cols;
+  //! The number of generations between two decompositions in this run.
+  size_t interval;
+  //! The number of generations since the optimization started.
+  size_t generation;
+  //! The covariance matrix.
+  arma::mat covariance;
+  //! The sampling factor B * D of the covariance matrix.
+  arma::mat factor;
+  //! The inverse square root of the covariance matrix.
+  arma::mat invSqrt;
+};
+
+} // namespace ens
+
+#endif
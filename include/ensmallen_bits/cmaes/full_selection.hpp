@@ -20,6 +20,23 @@ namespace ens {
 class FullSelection
 {
  public:
+  /**
+   * Constructor for the full selection strategy.
+   *
+   * @param parallel Whether the batches of each evaluation are summed in
+   *     parallel (the separable Evaluate() must then be safe to call
+   *     concurrently).
+   */
+  FullSelection(const bool parallel = false) : parallel(parallel)
+  {
+    // Nothing to do here.
+  }
+
+  //! Get whether the batches are summed in parallel.
+  bool Parallel() const { return parallel; }
+  //! Modify whether the batches are summed in parallel.
+  bool& Parallel() { return parallel; }
+
   /**
    * Select the full dataset to calculate the objective function.
    *
@@ -33,18 +50,14 @@ class FullSelection
                       const size_t batchSize,
                       const arma::mat& iterate)
   {
-    // Find the number of functions to use.
-    const size_t numFunctions = function.NumFunctions();
-
-    double objective = 0;
-    for (size_t f = 0; f < numFunctions; f += batchSize)
-    {
-      const size_t effectiveBatchSize = std::min(batchSize, numFunctions - f);
-      objective += function.Evaluate(iterate, f, effectiveBatchSize);
-    }
-
-    return objective;
+    // When the offspring are already evaluated in parallel, the sums of the
+    // batches run serially in each thread.
+    return FullPassEvaluate(function, iterate, batchSize, parallel);
   }
+
+ private:
+  //! Whether the batches are summed in parallel.
+  bool parallel;
 };
 
 } // namespace ens
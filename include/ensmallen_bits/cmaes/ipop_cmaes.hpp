@@ -0,0 +1,129 @@
+/**
+ * @file ipop_cmaes.hpp
+ *
+ * Definition of IPOP-CMA-ES, which restarts CMA-ES with an increasing
+ * population size, as proposed by A. Auger and N. Hansen in "A Restart CMA
+ * Evolution Strategy With Increasing Population Size".
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CMAES_IPOP_CMAES_HPP
+#define ENSMALLEN_CMAES_IPOP_CMAES_HPP
+
+#include "cmaes.hpp"
+
+namespace ens {
+
+/**
+ * IPOP-CMA-ES runs CMA-ES, and restarts it with a population multiplied by
+ * populationFactor every time it terminates, until maxRestarts restarts were
+ * run or maxFunctionEvaluations evaluations were used.  Larger populations
+ * explore the function more globally, so the restarts find the global minimum
+ * of multimodal functions much more often than a single run.  The best point
+ * of all the runs is returned.
+ *
+ * For more information, please refer to:
+ *
+ * @code
+ * @inproceedings{Auger2005,
+ *   author    = {Auger, Anne and Hansen, Nikolaus},
+ *   title     = {A Restart CMA Evolution Strategy With Increasing Population
+ *                Size},
+ *   booktitle = {IEEE Congress on Evolutionary Computation},
+ *   year      = {2005},
+ *   pages     = {1769--1776}
+ * }
+ * @endcode
+ *
+ * The evaluations are counted as the Evaluate() events of CMA-ES (one per
+ * offspring and one for the mean of each generation), so with a selection
+ * policy that evaluates batches, each one counts as one evaluation.  Each run
+ * starts from a random point in [lowerBound, upperBound] of the wrapped CMAES
+ * object.
+ *
+ * @tparam CMAESType Type of the CMA-ES optimizer to restart.
+ */
+template<typename CMAESType = CMAES<>>
+class IPOP_CMAES
+{
+ public:
+  /**
+   * Construct the IPOP-CMA-ES optimizer with the given CMA-ES optimizer and
+   * parameters.  The population size of the first run is the one of the given
+   * optimizer (or its default, if it is 0).
+   *
+   * @param cmaes CMA-ES optimizer to restart.
+   * @param populationFactor Factor the population size is multiplied by at
+   *     every restart.
+   * @param maxRestarts Maximum number of restarts.
+   * @param maxFunctionEvaluations Maximum number of evaluations of all runs (0
+   *     means no limit).
+   */
+  IPOP_CMAES(const CMAESType& cmaes = CMAESType(),
+             const double populationFactor = 2,
+             const size_t maxRestarts = 9,
+             const size_t maxFunctionEvaluations = 1000000000);
+
+  /**
+   * Optimize the given function with restarts of CMA-ES.  The given point is
+   * modified to store the best point found, and its objective is returned.
+   *
+   * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @return Objective value of the final point.
+   */
+  template<typename DecomposableFunctionType>
+  double Optimize(DecomposableFunctionType& function, arma::mat& iterate);
+
+  //! Get the CMA-ES optimizer that is restarted.
+  const CMAESType& Optimizer() const { return cmaes; }
+  //! Modify the CMA-ES optimizer that is restarted.
+  CMAESType& Optimizer() { return cmaes; }
+
+  //! Get the factor the population size is multiplied by at every restart.
+  double PopulationFactor() const { return populationFactor; }
+  //! Modify the factor the population size is multiplied by at every restart.
+  double& PopulationFactor() { return populationFactor; }
+
+  //! Get the maximum number of restarts.
+  size_t MaxRestarts() const { return maxRestarts; }
+  //! Modify the maximum number of restarts.
+  size_t& MaxRestarts() { return maxRestarts; }
+
+  //! Get the maximum number of evaluations of all runs (0 means no limit).
+  size_t MaxFunctionEvaluations() const { return maxFunctionEvaluations; }
+  //! Modify the maximum number of evaluations of all runs (0 means no limit).
+  size_t& MaxFunctionEvaluations() { return maxFunctionEvaluations; }
+
+  //! Get the number of restarts run by the last optimization.
+  size_t Restarts() const { return restarts; }
+
+  //! Get the number of evaluations used by the last optimization.
+  size_t FunctionEvaluations() const { return functionEvaluations; }
+
+ private:
+  //! The CMA-ES optimizer that is restarted.
+  CMAESType cmaes;
+  //! The factor the population size is multiplied by at every restart.
+  double populationFactor;
+  //! The maximum number of restarts.
+  size_t maxRestarts;
+  //! The maximum number of evaluations of all runs.
+  size_t maxFunctionEvaluations;
+
+  //! The number of restarts run by the last optimization.
+  size_t restarts;
+  //! The number of evaluations used by the last optimization.
+  size_t functionEvaluations;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "ipop_cmaes_impl.hpp"
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * @file ipop_cmaes_impl.hpp
+ *
+ * Implementation of IPOP-CMA-ES, which restarts CMA-ES with an increasing
+ * population size.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CMAES_IPOP_CMAES_IMPL_HPP
+#define ENSMALLEN_CMAES_IPOP_CMAES_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "ipop_cmaes.hpp"
+
+#include <ensmallen_bits/callbacks/budget.hpp>
+
+namespace ens {
+
+/**
+ * Run one restart of a copy of the given CMA-ES optimizer with the given
+ * population size and initial step size, using at most maxEvaluations
+ * evaluations.  This is shared by IPOP_CMAES and BIPOP_CMAES.
+ *
+ * @param cmaes CMA-ES optimizer to copy.
+ * @param lambda Population size of the restart.
+ * @param stepSize Initial step size of the restart (0 for the default).
+ * @param function Function to optimize.
+ * @param iterate Point to store the final point of the restart in.
+ * @param maxEvaluations Maximum number of evaluations of the restart (0
+ *     means no limit).
+ * @param evaluations Counter that the evaluations of the restart are added
+ *     to.
+ * @return Objective value of the final point, over all the functions.
+ */
+template<typename CMAESType, typename DecomposableFunctionType>
+double RunCMAESRestart(const CMAESType& cmaes,
+                       const size_t lambda,
+                       const double stepSize,
+                       DecomposableFunctionType& function,
+                       arma::mat& iterate,
+                       const size_t maxEvaluations,
+                       size_t& evaluations)
+{
+  CMAESType restart(cmaes);
+  restart.PopulationSize() = lambda;
+  restart.InitialStepSize() = stepSize;
+
+  Budget budget(0, maxEvaluations);
+  restart.Optimize(function, iterate, budget);
+  evaluations += budget.Evaluations();
+
+  // The objective returned by CMA-ES may be estimated from a subset of the
+  // functions, so compute the exact one to compare restarts.
+  return FullPassEvaluate(function, iterate, restart.BatchSize());
+}
+
+template<typename CMAESType>
+IPOP_CMAES<CMAESType>::IPOP_CMAES(const CMAESType& cmaes,
+                                  const double populationFactor,
+                                  const size_t maxRestarts,
+                                  const size_t maxFunctionEvaluations) :
+    cmaes(cmaes),
+    populationFactor(populationFactor),
+    maxRestarts(maxRestarts),
+    maxFunctionEvaluations(maxFunctionEvaluations),
+    restarts(0),
+    functionEvaluations(0)
+{ /* Nothing to do. */ }
+
+//! Optimize the function (minimize).
+template<typename CMAESType>
+template<typename DecomposableFunctionType>
+double IPOP_CMAES<CMAESType>::Optimize(DecomposableFunctionType& function,
+                                       arma::mat& iterate)
+{
+  if (populationFactor <= 1.0)
+  {
+    throw std::invalid_argument("IPOP_CMAES::Optimize(): populationFactor "
+        "must be greater than 1!");
+  }
+
+  size_t lambda = (cmaes.PopulationSize() == 0) ?
+      CMAESType::DefaultPopulationSize(iterate.n_elem) :
+      cmaes.PopulationSize();
+
+  const arma::mat start = iterate;
+  double bestObjective = DBL_MAX;
+  restarts = 0;
+  functionEvaluations = 0;
+
+  // The first run is not a restart.
+  for (size_t run = 0; run <= maxRestarts && (maxFunctionEvaluations == 0 ||
+      functionEvaluations < maxFunctionEvaluations); ++run)
+  {
+    arma::mat candidate = start;
+    const size_t remaining = (maxFunctionEvaluations == 0) ? 0 :
+        maxFunctionEvaluations - functionEvaluations;
+    const double objective = RunCMAESRestart(cmaes, lambda,
+        cmaes.InitialStepSize(), function, candidate, remaining,
+        functionEvaluations);
+    if (run > 0)
+      ++restarts;
+
+    Info << "IPOP-CMA-ES: run " << run << " with population size " << lambda
+        << ", objective " << objective << ".\n";
+
+    if (run == 0 || objective < bestObjective)
+    {
+      bestObjective = objective;
+      iterate = candidate;
+    }
+
+    lambda = (size_t) std::round(lambda * populationFactor);
+  }
+
+  return bestObjective;
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,230 @@
+/**
+ * @file quadratic_surrogate.hpp
+ *
+ * A linear-quadratic surrogate of the objective, fitted by least squares to
+ * the most recent points evaluated by CMA-ES, as in lq-CMA-ES.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CMAES_QUADRATIC_SURROGATE_HPP
+#define ENSMALLEN_CMAES_QUADRATIC_SURROGATE_HPP
+
+namespace ens {
+
+/**
+ * QuadraticSurrogate keeps an archive of the most recent points evaluated by
+ * the objective (up to the given capacity), and fits to them the richest of
+ * three models that the archive determines: a full quadratic, a quadratic
+ * without the cross terms, or a linear model.  A model is only used once the
+ * archive holds more points than the model has coefficients.  The points are
+ * expressed relative to the given center and scale (the mean and the step size
+ * of the search distribution), which keeps the least squares problem well
+ * conditioned as the search converges.
+ *
+ * For more information, see the following:
+ *
+ * @code
+ * @inproceedings{Hansen2019,
+ *   author    = {Hansen, Nikolaus},
+ *   title     = {A Global Surrogate Assisted {CMA-ES}},
+ *   booktitle = {Proceedings of the Genetic and Evolutionary Computation
+ *                Conference},
+ *   year      = {2019},
+ *   pages     = {664--672}
+ * }
+ * @endcode
+ */
+class QuadraticSurrogate
+{
+ public:
+  /**
+   * Create an empty surrogate for points with the given number of elements.
+   *
+   * @param dimension Number of elements of each point.
+   * @param capacity Maximum number of points kept in the archive.
+   */
+  QuadraticSurrogate(const size_t dimension = 0, const size_t capacity = 0) :
+      points(dimension, capacity),
+      objectives(capacity),
+      next(0),
+      count(0),
+      model(Linear),
+      scale(1.0)
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * Get the number of points kept in the archive that the full quadratic model
+   * of points with the given number of elements needs: twice its number of
+   * coefficients.
+   *
+   * @param dimension Number of elements of each point.
+   */
+  static size_t DefaultCapacity(const size_t dimension)
+  {
+    return (dimension + 1) * (dimension + 2);
+  }
+
+  /**
+   * Add an evaluated point to the archive; once the archive is full, the
+   * oldest point is replaced.
+   *
+   * @param point The evaluated point.
+   * @param objective The objective of the point.
+   */
+  void Add(const arma::mat& point, const double objective)
+  {
+    if (objectives.n_elem == 0 || !std::isfinite(objective))
+      return;
+
+    points.col(next) = arma::vectorise(point);
+    objectives(next) = objective;
+    next = (next + 1) % objectives.n_elem;
+    count = std::min(count + 1, (size_t) objectives.n_elem);
+  }
+
+  /**
+   * Fit the model to the archive, relative to the given center and scale.
+   * Returns false (and the model must not be used) if the archive has too few
+   * points for any model, or if the least squares problem cannot be solved.
+   *
+   * @param center The point the model is centered on.
+   * @param scale The scale of the coordinates of the model.
+   */
+  bool Fit(const arma::mat& center, const double scale)
+  {
+    const size_t n = points.n_rows;
+    if (count <= Coefficients(n, Linear) || scale <= 0.0)
+      return false;
+
+    if (count > Coefficients(n, Full))
+      model = Full;
+    else if (count > Coefficients(n, Diagonal))
+      model = Diagonal;
+    else
+      model = Linear;
+
+    this->center = arma::vectorise(center);
+    this->scale = scale;
+
+    arma::mat features(count, Coefficients(n, model));
+    arma::rowvec row;
+    for (size_t i = 0; i < count; ++i)
+    {
+      Features(points.col(i), row);
+      features.row(i) = row;
+    }
+
+    return arma::solve(coefficients, features, objectives.head(count)) &&
+        coefficients.is_finite();
+  }
+
+  /**
+   * Predict the objective of the given point with the last fitted model.
+   *
+   * @param point The point to predict the objective of.
+   */
+  double Predict(const arma::mat& point) const
+  {
+    arma::rowvec row;
+    Features(arma::vectorise(point), row);
+    return arma::dot(row, coefficients);
+  }
+
+  /**
+   * Compute the Kendall rank correlation (tau-a) of the given values: 1 if
+   * they are in the same order, -1 if they are in reverse order.
+   *
+   * @param a The first values.
+   * @param b The second values, one for each of the first ones.
+   */
+  static double KendallTau(const arma::vec& a, const arma::vec& b)
+  {
+    if (a.n_elem < 2)
+      return 1.0;
+
+    double concordance = 0.0;
+    for (size_t i = 0; i < a.n_elem; ++i)
+    {
+      for (size_t j = i + 1; j < a.n_elem; ++j)
+      {
+        const double product = (a(i) - a(j)) * (b(i) - b(j));
+        concordance += (product > 0.0) ? 1.0 : ((product < 0.0) ? -1.0 : 0.0);
+      }
+    }
+
+    return 2.0 * concordance / (a.n_elem * (a.n_elem - 1.0));
+  }
+
+  //! Get the number of points in the archive.
+  size_t Size() const { return count; }
+
+  //! Get the capacity of the archive.
+  size_t Capacity() const { return objectives.n_elem; }
+
+ private:
+  //! The kinds of model.
+  enum ModelType { Linear, Diagonal, Full };
+
+  //! Get the number of coefficients of the given model for points with n
+  //! elements.
+  static size_t Coefficients(const size_t n, const ModelType model)
+  {
+    return (model == Linear) ? n + 1 : ((model == Diagonal) ? 2 * n + 1 :
+        (n + 1) * (n + 2) / 2);
+  }
+
+  //! Compute the features of the given point for the current model.
+  void Features(const arma::vec& point, arma::rowvec& row) const
+  {
+    const size_t n = point.n_elem;
+    const arma::vec d = (point - center) / scale;
+
+    row.set_size(Coefficients(n, model));
+    row(0) = 1.0;
+    row.subvec(1, n) = d.t();
+    if (model == Diagonal)
+    {
+      row.subvec(n + 1, 2 * n) = arma::square(d).t();
+    }
+    else if (model == Full)
+    {
+      size_t k = n + 1;
+      for (size_t i = 0; i < n; ++i)
+        for (size_t j = i; j < n; ++j)
+          row(k++) = d(i) * d(j);
+    }
+  }
+
+  //! The archive of points (one per column).
+  arma::mat points;
+
+  //! The objectives of the points in the archive.
+  arma::vec objectives;
+
+  //! The column the next point is stored in.
+  size_t next;
+
+  //! The number of points in the archive.
+  size_t count;
+
+  //! The kind of the fitted model.
+  ModelType model;
+
+  //! The center of the fitted model.
+  arma::vec center;
+
+  //! The scale of the fitted model.
+  double scale;
+
+  //! The coefficients of the fitted model.
+  arma::vec coefficients;
+};
+
+} // namespace ens
+
+#endif
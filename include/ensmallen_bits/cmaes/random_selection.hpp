@@ -24,8 +24,19 @@ class RandomSelection
    * Constructor for the random selection strategy.
    *
    * @param fraction The dataset fraction used for the selection (Default 0.3).
+   * @param sharedSelection Whether all the offspring of a generation (and the
+   *     mean) are evaluated on the same selected batches, so that their
+   *     objectives are compared without the noise of different selections.
+   * @param parallel Whether the selected batches of each evaluation are
+   *     summed in parallel (the separable Evaluate() must then be safe to call
+   *     concurrently).
    */
-  RandomSelection(const double fraction = 0.3) : fraction(fraction)
+  RandomSelection(const double fraction = 0.3,
+                  const bool sharedSelection = false,
+                  const bool parallel = false) :
+      fraction(fraction),
+      sharedSelection(sharedSelection),
+      parallel(parallel)
   {
     // Nothing to do here.
   }
@@ -35,6 +46,40 @@ class RandomSelection
   //! Modify the dataset fraction.
   double& Fraction() { return fraction; }
 
+  //! Get whether the offspring of a generation share the selection.
+  bool SharedSelection() const { return sharedSelection; }
+  //! Modify whether the offspring of a generation share the selection.
+  bool& SharedSelection() { return sharedSelection; }
+
+  //! Get whether the selected batches are summed in parallel.
+  bool Parallel() const { return parallel; }
+  //! Modify whether the selected batches are summed in parallel.
+  bool& Parallel() { return parallel; }
+
+  /**
+   * Called by CMAES before the offspring of a generation are evaluated.  With
+   * a shared selection, the batches of the generation are drawn here, and used
+   * by every following Select() until the next generation; otherwise, this
+   * does nothing.
+   *
+   * @tparam DecomposableFunctionType Type of the function to be evaluated.
+   * @param function Function to optimize.
+   * @param batchSize Batch size to use for each step.
+   */
+  template<typename DecomposableFunctionType>
+  void BeginPopulation(DecomposableFunctionType& function,
+                       const size_t batchSize)
+  {
+    if (!sharedSelection)
+      return;
+
+    RNG generator(RNG::ArmaSeed());
+    const size_t numFunctions = function.NumFunctions();
+    selections.resize(NumSelections(numFunctions, batchSize));
+    for (size_t i = 0; i < selections.size(); ++i)
+      selections[i] = generator.Randi(0, numFunctions - 1);
+  }
+
   /**
    * Randomly select dataset points to calculate the objective function.
    *
@@ -47,27 +92,102 @@ class RandomSelection
   double Select(DecomposableFunctionType& function,
                       const size_t batchSize,
                       const arma::mat& iterate)
+  {
+    return Evaluate(function, batchSize, iterate, [](const size_t n)
+    {
+      return (size_t) arma::as_scalar(arma::randi<arma::uvec>(1,
+          arma::distr_param(0, n - 1)));
+    });
+  }
+
+  /**
+   * Randomly select dataset points to calculate the objective function, using
+   * the given random number generator.  This is used when the population is
+   * evaluated in parallel, so that each evaluation has its own random stream.
+   *
+   * @tparam DecomposableFunctionType Type of the function to be evaluated.
+   * @tparam GeneratorType Type of the random number generator.
+   * @param function Function to optimize.
+   * @param batchSize Batch size to use for each step.
+   * @param iterate starting point.
+   * @param generator Random number generator used for the selection.
+   */
+  template<typename DecomposableFunctionType, typename GeneratorType>
+  double Select(DecomposableFunctionType& function,
+                const size_t batchSize,
+                const arma::mat& iterate,
+                GeneratorType& generator)
+  {
+    return Evaluate(function, batchSize, iterate, [&](const size_t n)
+    {
+      std::uniform_int_distribution<size_t> selectionDistribution(0, n - 1);
+      return selectionDistribution(generator);
+    });
+  }
+
+ private:
+  //! Get the number of batches selected from the given number of functions.
+  size_t NumSelections(const size_t numFunctions, const size_t batchSize) const
+  {
+    const size_t selected = (size_t) std::floor(numFunctions * fraction);
+    return (selected + batchSize - 1) / batchSize;
+  }
+
+  /**
+   * Sum the objectives of the selected batches: the shared selection of the
+   * generation, if there is one, or else batches whose first functions are
+   * drawn with draw(numFunctions).  The batches are drawn before any of them
+   * is evaluated, so the random numbers used do not depend on whether the sum
+   * is parallel, and the sum is added up in order.
+   */
+  template<typename DecomposableFunctionType, typename DrawFunctionType>
+  double Evaluate(DecomposableFunctionType& function,
+                  const size_t batchSize,
+                  const arma::mat& iterate,
+                  DrawFunctionType&& draw) const
   {
     // Find the number of functions to use.
     const size_t numFunctions = function.NumFunctions();
 
-    double objective = 0;
-    for (size_t f = 0; f < std::floor(numFunctions * fraction); f += batchSize)
+    std::vector<size_t> localSelections;
+    if (!sharedSelection || selections.empty())
+    {
+      localSelections.resize(NumSelections(numFunctions, batchSize));
+      for (size_t i = 0; i < localSelections.size(); ++i)
+        localSelections[i] = draw(numFunctions);
+    }
+    const std::vector<size_t>& batches = localSelections.empty() ?
+        selections : localSelections;
+
+    auto term = [&](const size_t i)
     {
-      const size_t selection = arma::as_scalar(arma::randi<arma::uvec>(
-          1, arma::distr_param(0, numFunctions - 1)));
+      const size_t selection = batches[i];
       const size_t effectiveBatchSize = std::min(batchSize,
           numFunctions - selection);
+      return function.Evaluate(iterate, selection, effectiveBatchSize);
+    };
 
-      objective += function.Evaluate(iterate, selection, effectiveBatchSize);
-    }
+    if (parallel)
+      return DefaultExecutor().ParallelSum<double>(batches.size(), term);
+
+    double objective = 0;
+    for (size_t i = 0; i < batches.size(); ++i)
+      objective += term(i);
 
     return objective;
   }
 
- private:
   //! Dataset fraction parameter.
   double fraction;
+
+  //! Whether the offspring of a generation share the selection.
+  bool sharedSelection;
+
+  //! Whether the selected batches are summed in parallel.
+  bool parallel;
+
+  //! The first functions of the batches shared by the current generation.
+  std::vector<size_t> selections;
 };
 
 } // namespace ens
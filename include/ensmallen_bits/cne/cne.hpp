@@ -87,13 +87,21 @@ class CNE
    *     the next generation.
    * @param tolerance The final value of the objective function for termination.
    *     If set to negative value, tolerance is not considered.
+   * @param parallelEvaluation If true, the fitness of the candidates is
+   *     evaluated in parallel with OpenMP.
+   * @param steadyStateWorkers If nonzero, the generations are replaced by a
+   *     steady state: this many children are evaluated at once on worker
+   *     threads, and each one replaces the worst candidate as soon as its
+   *     evaluation completes (see SteadyStateWorkers()).
    */
   CNE(const size_t populationSize = 500,
       const size_t maxGenerations = 5000,
       const double mutationProb = 0.1,
       const double mutationSize = 0.02,
       const double selectPercent = 0.2,
-      const double tolerance = 1e-5);
+      const double tolerance = 1e-5,
+      const bool parallelEvaluation = false,
+      const size_t steadyStateWorkers = 0);
 
   /**
    * Optimize the given function using CNE. The given
@@ -101,12 +109,16 @@ class CNE
    * algorithm, and the final objective value is returned.
    *
    * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to optimize.
    * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
    * @return Objective value of the final point.
    */
-  template<typename DecomposableFunctionType>
-  double Optimize(DecomposableFunctionType& function, arma::mat& iterate);
+  template<typename DecomposableFunctionType, typename... CallbackTypes>
+  double Optimize(DecomposableFunctionType& function,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
 
   //! Get the population size.
   size_t PopulationSize() const { return populationSize; }
@@ -138,7 +150,38 @@ class CNE
   //! Modify the tolerance.
   double& Tolerance() { return tolerance; }
 
+  //! Get whether the fitness of the candidates is evaluated in parallel.
+  bool ParallelEvaluation() const { return parallelEvaluation; }
+  //! Modify whether the fitness of the candidates is evaluated in parallel.
+  bool& ParallelEvaluation() { return parallelEvaluation; }
+
+  /**
+   * Get the number of children evaluated at once in the steady state (0 for
+   * generations).  In the steady state, a new child of two random elite
+   * candidates is started as soon as an evaluation completes, so that the
+   * workers do not wait for the slowest evaluation of a generation; the result
+   * then depends on the order in which the evaluations complete.  The children
+   * are evaluated with Evaluate() on std::threads, so it must be thread-safe,
+   * or with EvaluateAsync() if the function has it.  maxGenerations *
+   * populationSize children are evaluated at most, and the tolerance is
+   * checked after every populationSize of them.
+   */
+  size_t SteadyStateWorkers() const { return steadyStateWorkers; }
+  //! Modify the number of children evaluated at once in the steady state.
+  size_t& SteadyStateWorkers() { return steadyStateWorkers; }
+
  private:
+  /**
+   * Compute the fitness of the candidates that changed since their fitness
+   * was last computed (all of them in the first generation), and store the
+   * indices of those candidates in pending.
+   *
+   * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @param function Function to optimize.
+   */
+  template<typename DecomposableFunctionType>
+  void EvaluatePopulation(DecomposableFunctionType& function);
+
   //! Reproduce candidates to create the next generation.
   void Reproduce();
 
@@ -162,6 +205,22 @@ class CNE
                  const size_t dropout1,
                  const size_t dropout2);
 
+  /**
+   * Evaluate the population and evolve it in the steady state, with
+   * steadyStateWorkers evaluations in flight.
+   *
+   * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Matrix to store the best candidate in.
+   * @param callbacks Callback functions.
+   * @return Objective value of the best candidate.
+   */
+  template<typename DecomposableFunctionType, typename... CallbackTypes>
+  double SteadyStateEvolution(DecomposableFunctionType& function,
+                              arma::mat& iterate,
+                              CallbackTypes&&... callbacks);
+
   //! Population matrix. Each column is a candidate.
   arma::cube population;
 
@@ -171,6 +230,19 @@ class CNE
   //! Index of sorted fitness values.
   arma::uvec index;
 
+  //! Whether each candidate has changed since its fitness was computed.  The
+  //! fitness of the others (such as the best candidate, which Reproduce()
+  //! keeps) is reused in the next generation.
+  std::vector<bool> changed;
+
+  //! The candidates whose fitness is computed in the current generation.
+  arma::uvec pending;
+
+  //! Buffers for the candidates whose fitness is computed in the current
+  //! generation and their fitness, if the function evaluates them together.
+  arma::cube pendingPopulation;
+  arma::vec pendingFitness;
+
   //! The number of candidates in the population.
   size_t populationSize;
 
@@ -194,6 +266,22 @@ class CNE
 
   //! Store the number of elements in a cube slice or a matrix column.
   size_t elements;
+
+  //! Whether the fitness of the candidates is evaluated in parallel.
+  bool parallelEvaluation;
+
+  //! The number of children evaluated at once in the steady state.
+  size_t steadyStateWorkers;
+
+  //! Buffer of uniform random numbers, reused by Crossover() and Mutate().
+  arma::mat uniformBuffer;
+
+  //! Buffer of normal random numbers, reused by Mutate().
+  arma::mat normalBuffer;
+
+  //! The random number generator, seeded from Armadillo's generator at the
+  //! start of every optimization.
+  RNG rng;
 };
 
 } // namespace ens
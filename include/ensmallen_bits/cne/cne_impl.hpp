@@ -18,6 +18,8 @@
 
 #include "cne.hpp"
 
+#include <ensmallen_bits/function.hpp>
+
 namespace ens {
 
 inline CNE::CNE(const size_t populationSize,
@@ -25,7 +27,9 @@ inline CNE::CNE(const size_t populationSize,
                 const double mutationProb,
                 const double mutationSize,
                 const double selectPercent,
-                const double tolerance) :
+                const double tolerance,
+                const bool parallelEvaluation,
+                const size_t steadyStateWorkers) :
     populationSize(populationSize),
     maxGenerations(maxGenerations),
     mutationProb(mutationProb),
@@ -33,13 +37,21 @@ inline CNE::CNE(const size_t populationSize,
     selectPercent(selectPercent),
     tolerance(tolerance),
     numElite(0),
-    elements(0)
+    elements(0),
+    parallelEvaluation(parallelEvaluation),
+    steadyStateWorkers(steadyStateWorkers)
 { /* Nothing to do here. */ }
 
 //! Optimize the function.
-template<typename DecomposableFunctionType>
-double CNE::Optimize(DecomposableFunctionType& function, arma::mat& iterate)
+template<typename DecomposableFunctionType, typename... CallbackTypes>
+double CNE::Optimize(DecomposableFunctionType& function,
+                     arma::mat& iterate,
+                     CallbackTypes&&... callbacks)
 {
+  // The Function wrapper provides a batch Evaluate() for the population.
+  typedef Function<DecomposableFunctionType> FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
   // Make sure for evolution to work at least four candidates are present.
   if (populationSize < 4)
   {
@@ -70,7 +82,9 @@ double CNE::Optimize(DecomposableFunctionType& function, arma::mat& iterate)
 
   // Generate the population based on a Gaussian distribution around the given
   // starting point.
-  population = arma::randn(iterate.n_rows, iterate.n_cols, populationSize);
+  rng.Seed(RNG::ArmaSeed());
+  population.set_size(iterate.n_rows, iterate.n_cols, populationSize);
+  rng.Randn(population);
   population.each_slice() += iterate;
 
   // Store the number of elements in a cube slice or a matrix column.
@@ -78,24 +92,46 @@ double CNE::Optimize(DecomposableFunctionType& function, arma::mat& iterate)
 
   // initializing helper variables.
   fitnessValues.set_size(populationSize);
+  changed.assign(populationSize, true);
+  uniformBuffer.set_size(population.n_rows, population.n_cols);
+  normalBuffer.set_size(population.n_rows, population.n_cols);
+  index.reset();
 
   Info << "CNE initialized successfully. Optimization started."
       << std::endl;
 
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+  terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
+
+  if (steadyStateWorkers > 0)
+  {
+    // Replace the candidates one at a time, as the evaluations complete,
+    // instead of generation by generation.
+    const double objective = terminate ? function.Evaluate(iterate) :
+        SteadyStateEvolution(function, iterate, callbacks...);
+    Callback::EndOptimization(*this, f, iterate, callbacks...);
+    return objective;
+  }
+
   // Find the fitness before optimization using given iterate parameters.
   size_t lastBestFitness = function.Evaluate(iterate);
+  terminate |= Callback::Evaluate(*this, f, iterate, lastBestFitness,
+      callbacks...);
 
   // Iterate until maximum number of generations is obtained.
-  for (size_t gen = 1; gen <= maxGenerations; gen++)
+  for (size_t gen = 1; gen <= maxGenerations && !terminate; gen++)
   {
-    // Calculating fitness values of all candidates.
-    for (size_t i = 0; i < populationSize; i++)
-    {
-       // Select a candidate and insert the parameters in the function.
-       iterate = population.slice(i);
+    // Calculating fitness values of the candidates that changed since their
+    // fitness was last computed; the others keep their fitness.
+    EvaluatePopulation(function);
 
-       // Find fitness of candidate.
-       fitnessValues[i] = function.Evaluate(iterate);
+    // The evaluations are reported afterwards, so that callbacks are never
+    // called from several threads.
+    for (size_t i = 0; i < pending.n_elem; i++)
+    {
+      terminate |= Callback::Evaluate(*this, f, population.slice(pending[i]),
+          fitnessValues[pending[i]], callbacks...);
     }
 
     Info << "Generation number: " << gen << " best fitness = "
@@ -104,6 +140,12 @@ double CNE::Optimize(DecomposableFunctionType& function, arma::mat& iterate)
     // Create next generation of species.
     Reproduce();
 
+    // The best candidate is not changed by the reproduction.
+    terminate |= Callback::StepTaken(*this, f, population.slice(index(0)),
+        callbacks...);
+    terminate |= Callback::EndEpoch(*this, f, population.slice(index(0)),
+        gen - 1, fitnessValues.min(), callbacks...);
+
     // Check for termination criteria.
     if (std::abs(lastBestFitness - fitnessValues.min()) < tolerance)
     {
@@ -116,17 +158,196 @@ double CNE::Optimize(DecomposableFunctionType& function, arma::mat& iterate)
     lastBestFitness = fitnessValues.min();
   }
 
-  // Set the best candidate into the network parameters.
-  iterate = population.slice(index(0));
+  // Set the best candidate into the network parameters.  (If the
+  // optimization was terminated before the first generation, the starting
+  // point is kept.)
+  if (index.n_elem == populationSize)
+    iterate = population.slice(index(0));
 
-  return function.Evaluate(iterate);
+  const double objective = function.Evaluate(iterate);
+  Callback::Evaluate(*this, f, iterate, objective, callbacks...);
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+  return objective;
+}
+
+//! Compute the fitness of the candidates that changed.
+template<typename DecomposableFunctionType>
+inline void CNE::EvaluatePopulation(DecomposableFunctionType& function)
+{
+  typedef Function<DecomposableFunctionType> FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  size_t numPending = 0;
+  for (size_t i = 0; i < populationSize; i++)
+    numPending += changed[i] ? 1 : 0;
+
+  pending.set_size(numPending);
+  for (size_t i = 0, k = 0; i < populationSize; i++)
+  {
+    if (changed[i])
+      pending[k++] = i;
+    changed[i] = false;
+  }
+
+  // If the function can evaluate many candidates at once, or start all the
+  // evaluations asynchronously, let it do that (on a copy of the changed
+  // candidates, unless they all changed).  Otherwise the evaluations are
+  // independent, so they may be done in parallel (as they are for functions
+  // that are known to be thread-safe; see traits::IsThreadSafeFunction),
+  // directly on the slices.
+  if (traits::HasBatchEvaluate<DecomposableFunctionType, arma::mat>::value ||
+      traits::HasAsyncEvaluate<DecomposableFunctionType, arma::mat>::value)
+  {
+    if (numPending == populationSize)
+    {
+      f.Evaluate(population, fitnessValues);
+    }
+    else if (numPending > 0)
+    {
+      pendingPopulation.set_size(population.n_rows, population.n_cols,
+          numPending);
+      for (size_t i = 0; i < numPending; i++)
+        pendingPopulation.slice(i) = population.slice(pending[i]);
+
+      f.Evaluate(pendingPopulation, pendingFitness);
+      for (size_t i = 0; i < numPending; i++)
+        fitnessValues[pending[i]] = pendingFitness[i];
+    }
+  }
+  else if (parallelEvaluation ||
+      traits::IsThreadSafeFunction<DecomposableFunctionType>::value)
+  {
+    ParallelFor(numPending, [&](const size_t i)
+    {
+      fitnessValues[pending[i]] = function.Evaluate(
+          population.slice(pending[i]));
+    });
+  }
+  else
+  {
+    for (size_t i = 0; i < numPending; i++)
+    {
+      fitnessValues[pending[i]] = function.Evaluate(
+          population.slice(pending[i]));
+    }
+  }
+}
+
+//! Evolve the population in the steady state.
+template<typename DecomposableFunctionType, typename... CallbackTypes>
+inline double CNE::SteadyStateEvolution(DecomposableFunctionType& function,
+                                        arma::mat& iterate,
+                                        CallbackTypes&&... callbacks)
+{
+  // The callbacks are given the Function wrapper, as in Optimize().
+  typedef Function<DecomposableFunctionType> FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  // Evaluate the whole population first; the callbacks may not stop this,
+  // since every candidate needs a fitness.
+  bool terminate = false;
+  size_t next = 0;
+  EvaluateAsCompleted(function, populationSize, steadyStateWorkers,
+      [&](arma::mat& point)
+      {
+        point = population.slice(next);
+        return next++;
+      },
+      [&](const size_t candidate, const arma::mat& point, const double value)
+      {
+        fitnessValues[candidate] = value;
+        terminate |= Callback::Evaluate(*this, f, point, value,
+            callbacks...);
+        return false;
+      });
+
+  double lastBestFitness = fitnessValues.min();
+  size_t completed = 0;
+  size_t epoch = 0;
+  if (!terminate)
+  {
+    EvaluateAsCompleted(function, maxGenerations * populationSize,
+        steadyStateWorkers,
+        [&](arma::mat& child)
+        {
+          // Select 2 different parents from the current elite randomly.
+          PartialSortIndex(fitnessValues, numElite, index);
+          const size_t mom = rng.Randi(0, numElite - 1);
+          size_t dad = rng.Randi(0, numElite - 1);
+          if (mom == dad)
+            dad = (dad != numElite - 1) ? dad + 1 : dad - 1;
+
+          // Mix the genome weights of the parents, and mutate them with small
+          // noise values.
+          const arma::mat& momWeights = population.slice(index[mom]);
+          const arma::mat& dadWeights = population.slice(index[dad]);
+          child.set_size(population.n_rows, population.n_cols);
+          rng.Randu(uniformBuffer);
+          for (size_t i = 0; i < elements; i++)
+            child(i) = (uniformBuffer(i) > 0.5) ? momWeights(i) : dadWeights(i);
+
+          rng.Randu(uniformBuffer);
+          rng.Randn(normalBuffer);
+          for (size_t i = 0; i < elements; i++)
+          {
+            if (uniformBuffer(i) < mutationProb)
+              child(i) += mutationSize * normalBuffer(i);
+          }
+
+          return (size_t) 0;
+        },
+        [&](const size_t /* tag */, const arma::mat& child, const double value)
+        {
+          terminate |= Callback::Evaluate(*this, f, child, value,
+              callbacks...);
+
+          // Replace the worst candidate if the child is better.
+          const size_t worst = fitnessValues.index_max();
+          if (value < fitnessValues[worst])
+          {
+            population.slice(worst) = child;
+            fitnessValues[worst] = value;
+          }
+
+          // Check for termination after as many evaluations as a generation
+          // has.
+          if (++completed % populationSize == 0)
+          {
+            const size_t best = fitnessValues.index_min();
+            Info << "Generation number: " << epoch + 1 << " best fitness = "
+                << fitnessValues[best] << std::endl;
+
+            if (std::abs(lastBestFitness - fitnessValues[best]) < tolerance)
+            {
+              Info << "CNE: minimized within tolerance " << tolerance << "; "
+                  << "terminating optimization." << std::endl;
+              return true;
+            }
+
+            lastBestFitness = fitnessValues[best];
+            terminate |= Callback::StepTaken(*this, f,
+                population.slice(best), callbacks...);
+            terminate |= Callback::EndEpoch(*this, f,
+                population.slice(best), epoch++, fitnessValues[best],
+                callbacks...);
+          }
+
+          return terminate;
+        });
+  }
+
+  const size_t best = fitnessValues.index_min();
+  iterate = population.slice(best);
+  return fitnessValues[best];
 }
 
 //! Reproduce candidates to create the next generation.
 inline void CNE::Reproduce()
 {
-  // Sort fitness values. Smaller fitness value means better performance.
-  index = arma::sort_index(fitnessValues);
+  // Find the elite; smaller fitness value means better performance.  Only the
+  // elite need to be in order (the best one first), so the rest of the
+  // population is not sorted, and the index buffer is reused.
+  PartialSortIndex(fitnessValues, numElite, index);
 
   // First parent.
   size_t mom;
@@ -137,11 +358,8 @@ inline void CNE::Reproduce()
   for (size_t i = numElite; i < populationSize - 1; i++)
   {
     // Select 2 different parents from elite group randomly [0, numElite).
-    mom = arma::as_scalar(arma::randi<arma::uvec>(
-          1, arma::distr_param(0, numElite - 1)));
-
-    dad = arma::as_scalar(arma::randi<arma::uvec>(
-          1, arma::distr_param(0, numElite - 1)));
+    mom = rng.Randi(0, numElite - 1);
+    dad = rng.Randi(0, numElite - 1);
 
     // Making sure both parents are not the same.
     if (mom == dad)
@@ -175,15 +393,18 @@ inline void CNE::Crossover(const size_t mom,
   // Replace the candidates with parents at their place.
   population.slice(child1) = population.slice(mom);
   population.slice(child2) = population.slice(dad);
+  changed[child1] = true;
+  changed[child2] = true;
 
-  // Preallocate random selection vector (values between 0 and 1).
-  arma::vec selection = arma::randu(elements);
+  // Draw the random selection (values between 0 and 1) into the preallocated
+  // buffer.
+  rng.Randu(uniformBuffer);
 
   // Randomly alter mom and dad genome weights to get two different children.
   for (size_t i = 0; i < elements; i++)
   {
     // Using it to alter the weights of the children.
-    if (selection(i) > 0.5)
+    if (uniformBuffer(i) > 0.5)
     {
       population.slice(child1)(i) = population.slice(mom)(i);
       population.slice(child2)(i) = population.slice(dad)(i);
@@ -200,12 +421,28 @@ inline void CNE::Crossover(const size_t mom,
 inline void CNE::Mutate()
 {
   // Mutate the whole matrix with the given rate and probability.
-  // The best candidate is not altered.
+  // The best candidate is not altered.  The random numbers are drawn into the
+  // preallocated buffers and the noise is added directly to the candidate, so
+  // that no temporaries are allocated.
   for (size_t i = 1; i < populationSize; i++)
   {
-    population.slice(index(i)) += (arma::randu(
-        population.n_rows, population.n_cols) < mutationProb) %
-        (mutationSize * arma::randn(population.n_rows, population.n_cols));
+    arma::mat& candidate = population.slice(index(i));
+
+    rng.Randu(uniformBuffer);
+    rng.Randn(normalBuffer);
+    bool mutated = false;
+    for (size_t j = 0; j < elements; j++)
+    {
+      if (uniformBuffer(j) < mutationProb)
+      {
+        candidate(j) += mutationSize * normalBuffer(j);
+        mutated = true;
+      }
+    }
+
+    // An elite candidate that is not mutated keeps its fitness.
+    if (mutated)
+      changed[index(i)] = true;
   }
 }
 
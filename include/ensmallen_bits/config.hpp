@@ -18,6 +18,10 @@
   // #define ENS_PRINT_WARN
 #endif
 
+#if !defined(ENS_PROFILE)
+  // #define ENS_PROFILE
+#endif
+
 #if defined(ARMA_USE_OPENMP)
   #undef  ENS_USE_OPENMP
   #define ENS_USE_OPENMP
@@ -35,10 +39,25 @@
   #undef ENS_PRINT_WARN
 #endif
 
+#if defined(ENS_DONT_PROFILE)
+  #undef ENS_PROFILE
+#endif
+
 #if defined(ENS_DONT_USE_OPENMP)
   #undef ENS_USE_OPENMP
 #endif
 
+// Bandicoot (GPU) matrices are supported when Bandicoot is included before
+// ensmallen (or with ENS_USE_COOT, which makes ensmallen include it).
+#if defined(COOT_VERSION_MAJOR) && !defined(ENS_DONT_USE_COOT)
+  #define ENS_HAVE_COOT
+#endif
+
+// MappedMatrix uses mmap() where it is available.
+#if !defined(ENS_DONT_USE_MMAP) && (defined(__unix__) || defined(__APPLE__))
+  #define ENS_USE_MMAP
+#endif
+
 
 //
 
@@ -46,7 +65,26 @@
 #if defined(ENS_USE_OPENMP)
   #define ENS_PRAGMA_OMP_PARALLEL _Pragma("omp parallel")
   #define ENS_PRAGMA_OMP_ATOMIC   _Pragma("omp atomic")
+  #define ENS_PRAGMA_OMP_BARRIER  _Pragma("omp barrier")
 #else
   #define ENS_PRAGMA_OMP_PARALLEL
   #define ENS_PRAGMA_OMP_ATOMIC
+  #define ENS_PRAGMA_OMP_BARRIER
+#endif
+
+// Binding the threads to places ("proc_bind") needs OpenMP 4.0; without it,
+// the threads are left unbound.
+#if defined(ENS_USE_OPENMP) && defined(_OPENMP) && (_OPENMP >= 201307)
+  #define ENS_PRAGMA_OMP_PARALLEL_CLOSE _Pragma("omp parallel proc_bind(close)")
+#elif defined(ENS_USE_OPENMP)
+  #define ENS_PRAGMA_OMP_PARALLEL_CLOSE _Pragma("omp parallel")
+#else
+  #define ENS_PRAGMA_OMP_PARALLEL_CLOSE
+#endif
+
+// "omp simd" needs OpenMP 4.0.
+#if defined(ENS_USE_OPENMP) && defined(_OPENMP) && (_OPENMP >= 201307)
+  #define ENS_PRAGMA_OMP_SIMD _Pragma("omp simd")
+#else
+  #define ENS_PRAGMA_OMP_SIMD
 #endif
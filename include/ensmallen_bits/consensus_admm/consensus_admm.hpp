@@ -0,0 +1,225 @@
+/**
+ * @file consensus_admm.hpp
+ *
+ * Consensus ADMM: the functions of a separable objective are split into
+ * shards, whose local subproblems are solved in parallel and tied together by
+ * a global averaging step and dual updates.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CONSENSUS_ADMM_CONSENSUS_ADMM_HPP
+#define ENSMALLEN_CONSENSUS_ADMM_CONSENSUS_ADMM_HPP
+
+#include <ensmallen_bits/lbfgs/lbfgs.hpp>
+#include <ensmallen_bits/distributed_sgd/communicators/local_communicator.hpp>
+#include <ensmallen_bits/distributed_sgd/communicators/mpi_communicator.hpp>
+#include "consensus_admm_function.hpp"
+
+namespace ens {
+
+/**
+ * Consensus ADMM (the alternating direction method of multipliers applied to
+ * the global consensus problem) minimizes a separable function
+ * f(x) = sum_i f_i(x) by giving each shard i of the functions its own copy x_i
+ * of the coordinates, constrained to equal a consensus variable z.  Each round
+ * takes the scaled-form steps
+ *
+ *   x_i <- argmin_x f_i(x) + (rho / 2) || x - z + u_i ||^2,
+ *   z   <- mean_i (x_i + u_i),
+ *   u_i <- u_i + x_i - z.
+ *
+ * The local subproblems are solved independently, from the previous x_i, by
+ * copies of the inner optimizer; so one round needs a single communication of
+ * the shards, where distributed SGD needs one per step.  The optimization
+ * stops when the primal residual sqrt(sum_i ||x_i - z||^2) and the dual
+ * residual rho sqrt(N) ||z - z_old|| (with N shards in total) are below the
+ * tolerances of Section 3.3 of the reference
+ *
+ *   eps_pri  = sqrt(N n) absTol + relTol max(sqrt(sum_i ||x_i||^2),
+ *                                            sqrt(N) ||z||),
+ *   eps_dual = sqrt(N n) absTol + relTol rho sqrt(sum_i ||u_i||^2),
+ *
+ * for coordinates with n elements.  With adaptivePenalty, rho is doubled
+ * when the primal residual is ten times the dual one, and halved in the
+ * opposite case (residual balancing, Section 3.4.1), and the scaled dual
+ * variables are rescaled to match.
+ *
+ * The shards of a process are solved by OpenMP threads (or one after the
+ * other, when OpenMP is not used), so the function must allow concurrent calls
+ * to EvaluateWithGradient() with different iterates on different ranges of
+ * functions, and the copies of the inner optimizer must not share state (for
+ * L_BFGS, no Workspace may be set).  The shards of several processes can be
+ * combined with a communicator (see ens::MPICommunicator); then each process
+ * holds its own part of the data, as with DistributedSGD, and z is the average
+ * over the shards of all the processes.
+ *
+ * Callbacks see the consensus variable: StepTaken() is called after each
+ * round.  The consensus variable is the result of the optimization.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @article{boyd2011distributed,
+ *   title   = {Distributed Optimization and Statistical Learning via the
+ *              Alternating Direction Method of Multipliers},
+ *   author  = {Boyd, Stephen and Parikh, Neal and Chu, Eric and Peleato, Borja
+ *              and Eckstein, Jonathan},
+ *   journal = {Foundations and Trends in Machine Learning},
+ *   volume  = {3},
+ *   number  = {1},
+ *   pages   = {1--122},
+ *   year    = {2011}
+ * }
+ * @endcode
+ *
+ * ConsensusADMM can optimize differentiable separable functions.
+ *
+ * @tparam InnerOptimizerType Optimizer of the local subproblems, which must
+ *     be able to optimize differentiable functions (see ens::L_BFGS).
+ * @tparam CommunicatorType Communicator used to combine the shards of several
+ *     processes (see ens::LocalCommunicator for the interface).
+ */
+template<typename InnerOptimizerType = L_BFGS,
+         typename CommunicatorType = LocalCommunicator>
+class ConsensusADMM
+{
+ public:
+  /**
+   * Construct the ConsensusADMM optimizer with the given parameters.
+   *
+   * @param rho Initial penalty parameter.
+   * @param shards Number of shards in each process (0 means the maximum number
+   *     of OpenMP threads).
+   * @param maxIterations Maximum number of rounds (0 means no limit).
+   * @param absoluteTolerance Absolute tolerance of the residuals.
+   * @param relativeTolerance Relative tolerance of the residuals.
+   * @param adaptivePenalty If true, rho is adapted to balance the primal and
+   *     dual residuals.
+   * @param innerOptimizer Optimizer of the local subproblems; it is copied for
+   *     each shard.
+   * @param communicator Communicator between the processes.
+   */
+  ConsensusADMM(const double rho = 1.0,
+                const size_t shards = 0,
+                const size_t maxIterations = 100,
+                const double absoluteTolerance = 1e-6,
+                const double relativeTolerance = 1e-4,
+                const bool adaptivePenalty = true,
+                const InnerOptimizerType& innerOptimizer = InnerOptimizerType(),
+                const CommunicatorType& communicator = CommunicatorType());
+
+  /**
+   * Optimize the given function.  The given starting point will be modified to
+   * store the finishing point of the algorithm (the consensus variable), and
+   * the final objective value is returned.  With several processes, the
+   * starting point of the first one is used, and the objective is summed over
+   * all the processes.
+   *
+   * @tparam SeparableFunctionType Type of the function to optimize.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(SeparableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks);
+
+  //! Get the penalty parameter.
+  double Rho() const { return rho; }
+  //! Modify the penalty parameter.
+  double& Rho() { return rho; }
+
+  //! Get the number of shards (0 means the maximum number of threads).
+  size_t Shards() const { return shards; }
+  //! Modify the number of shards (0 means the maximum number of threads).
+  size_t& Shards() { return shards; }
+
+  //! Get the maximum number of rounds (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of rounds (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the absolute tolerance of the residuals.
+  double AbsoluteTolerance() const { return absoluteTolerance; }
+  //! Modify the absolute tolerance of the residuals.
+  double& AbsoluteTolerance() { return absoluteTolerance; }
+
+  //! Get the relative tolerance of the residuals.
+  double RelativeTolerance() const { return relativeTolerance; }
+  //! Modify the relative tolerance of the residuals.
+  double& RelativeTolerance() { return relativeTolerance; }
+
+  //! Get whether the penalty parameter is adapted.
+  bool AdaptivePenalty() const { return adaptivePenalty; }
+  //! Modify whether the penalty parameter is adapted.
+  bool& AdaptivePenalty() { return adaptivePenalty; }
+
+  //! Get the inner optimizer.
+  const InnerOptimizerType& InnerOptimizer() const { return innerOptimizer; }
+  //! Modify the inner optimizer.
+  InnerOptimizerType& InnerOptimizer() { return innerOptimizer; }
+
+  //! Get the communicator.
+  const CommunicatorType& Communicator() const { return communicator; }
+  //! Modify the communicator.
+  CommunicatorType& Communicator() { return communicator; }
+
+  //! Get the penalty parameter at the end of the last optimization.
+  double FinalRho() const { return finalRho; }
+  //! Get the primal residual at the end of the last optimization.
+  double PrimalResidual() const { return primalResidual; }
+  //! Get the dual residual at the end of the last optimization.
+  double DualResidual() const { return dualResidual; }
+
+ private:
+  //! The initial penalty parameter.
+  double rho;
+
+  //! The number of shards in each process.
+  size_t shards;
+
+  //! The maximum number of rounds.
+  size_t maxIterations;
+
+  //! The absolute tolerance of the residuals.
+  double absoluteTolerance;
+
+  //! The relative tolerance of the residuals.
+  double relativeTolerance;
+
+  //! Whether the penalty parameter is adapted.
+  bool adaptivePenalty;
+
+  //! The optimizer of the local subproblems.
+  InnerOptimizerType innerOptimizer;
+
+  //! The communicator between the processes.
+  CommunicatorType communicator;
+
+  //! The penalty parameter at the end of the last optimization.
+  double finalRho;
+
+  //! The primal residual at the end of the last optimization.
+  double primalResidual;
+
+  //! The dual residual at the end of the last optimization.
+  double dualResidual;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "consensus_admm_impl.hpp"
+
+#endif
@@ -0,0 +1,121 @@
+/**
+ * @file consensus_admm_function.hpp
+ *
+ * The local subproblem of one shard of consensus ADMM.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CONSENSUS_ADMM_CONSENSUS_ADMM_FUNCTION_HPP
+#define ENSMALLEN_CONSENSUS_ADMM_CONSENSUS_ADMM_FUNCTION_HPP
+
+namespace ens {
+
+/**
+ * This is a utility class used by ConsensusADMM, meant to wrap a contiguous
+ * range of the functions of a separable function into the local subproblem of
+ * one shard,
+ *
+ *   f_i(x) + (rho / 2) || x - z + u_i ||^2,
+ *
+ * where f_i is the sum of the functions of the shard, z is the consensus
+ * variable and u_i the scaled dual variable of the shard.  It provides
+ * Evaluate(), Gradient() and EvaluateWithGradient(), so that it can be
+ * minimized by an optimizer for differentiable functions like L-BFGS.
+ *
+ * @tparam FunctionType Type of the separable function (with the methods of a
+ *     differentiable separable function, as given by the Function<> wrapper).
+ * @tparam MatType Type of the coordinates.
+ * @tparam GradType Type of the gradient.
+ */
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType>
+class ConsensusADMMFunction
+{
+ public:
+  //! The element type of the coordinates.
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Wrap the given range of functions.  The center of the penalty (z - u_i)
+   * and the penalty parameter are held by reference, so that they can be
+   * updated between the subproblems.
+   *
+   * @param function Separable function.
+   * @param begin Index of the first function of the shard.
+   * @param numFunctions Number of functions of the shard.
+   * @param center Center of the penalty term, z - u_i.
+   * @param rho Penalty parameter.
+   */
+  ConsensusADMMFunction(FunctionType& function,
+                        const size_t begin,
+                        const size_t numFunctions,
+                        const MatType& center,
+                        const double& rho) :
+      function(function),
+      begin(begin),
+      numFunctions(numFunctions),
+      center(center),
+      rho(rho)
+  { /* Nothing to do. */ }
+
+  //! Evaluate the local subproblem at the given coordinates.
+  ElemType Evaluate(const MatType& coordinates) const
+  {
+    return Objective(coordinates) + Penalty(coordinates);
+  }
+
+  //! Evaluate the gradient of the local subproblem at the given coordinates.
+  void Gradient(const MatType& coordinates, GradType& gradient) const
+  {
+    function.Gradient(coordinates, begin, gradient, numFunctions);
+    gradient += ElemType(rho) * (coordinates - center);
+  }
+
+  //! Evaluate the local subproblem and its gradient at the given coordinates.
+  ElemType EvaluateWithGradient(const MatType& coordinates,
+                                GradType& gradient) const
+  {
+    const ElemType objective = function.EvaluateWithGradient(coordinates,
+        begin, gradient, numFunctions);
+    gradient += ElemType(rho) * (coordinates - center);
+    return objective + Penalty(coordinates);
+  }
+
+  //! Evaluate the functions of the shard, without the penalty term.
+  ElemType Objective(const MatType& coordinates) const
+  {
+    return function.Evaluate(coordinates, begin, numFunctions);
+  }
+
+  //! Get the index of the first function of the shard.
+  size_t Begin() const { return begin; }
+  //! Get the number of functions of the shard.
+  size_t NumFunctions() const { return numFunctions; }
+
+ private:
+  //! Evaluate the penalty term.
+  ElemType Penalty(const MatType& coordinates) const
+  {
+    return ElemType(0.5 * rho) * ElemType(std::pow(arma::norm(
+        arma::vectorise(coordinates - center)), 2));
+  }
+
+  //! The separable function.
+  FunctionType& function;
+  //! The index of the first function of the shard.
+  size_t begin;
+  //! The number of functions of the shard.
+  size_t numFunctions;
+  //! The center of the penalty term.
+  const MatType& center;
+  //! The penalty parameter.
+  const double& rho;
+};
+
+} // namespace ens
+
+#endif
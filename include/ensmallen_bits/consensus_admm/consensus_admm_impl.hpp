@@ -0,0 +1,263 @@
+/**
+ * @file consensus_admm_impl.hpp
+ *
+ * Implementation of consensus ADMM.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CONSENSUS_ADMM_CONSENSUS_ADMM_IMPL_HPP
+#define ENSMALLEN_CONSENSUS_ADMM_CONSENSUS_ADMM_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "consensus_admm.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+template<typename InnerOptimizerType, typename CommunicatorType>
+ConsensusADMM<InnerOptimizerType, CommunicatorType>::ConsensusADMM(
+    const double rho,
+    const size_t shards,
+    const size_t maxIterations,
+    const double absoluteTolerance,
+    const double relativeTolerance,
+    const bool adaptivePenalty,
+    const InnerOptimizerType& innerOptimizer,
+    const CommunicatorType& communicator) :
+    rho(rho),
+    shards(shards),
+    maxIterations(maxIterations),
+    absoluteTolerance(absoluteTolerance),
+    relativeTolerance(relativeTolerance),
+    adaptivePenalty(adaptivePenalty),
+    innerOptimizer(innerOptimizer),
+    communicator(communicator),
+    finalRho(rho),
+    primalResidual(0.0),
+    dualResidual(0.0)
+{ /* Nothing to do. */ }
+
+//! Optimize the function (minimize).
+template<typename InnerOptimizerType, typename CommunicatorType>
+template<typename SeparableFunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename MatType::elem_type
+ConsensusADMM<InnerOptimizerType, CommunicatorType>::Optimize(
+    SeparableFunctionType& function,
+    MatType& iterateIn,
+    CallbackTypes&&... callbacks)
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+
+  typedef Function<SeparableFunctionType, BaseMatType, BaseGradType>
+      FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  // Make sure we have all the methods that we need.
+  traits::CheckDecomposableFunctionTypeAPI<FullFunctionType, BaseMatType,
+      BaseGradType>();
+
+  // Vectors are optimized as matrices.  The iterate is the consensus variable.
+  BaseMatType& iterate = static_cast<BaseMatType&>(iterateIn);
+
+  if (rho <= 0.0)
+  {
+    throw std::invalid_argument("ConsensusADMM::Optimize(): rho must be "
+        "positive!");
+  }
+
+  // Only the first process reports progress.
+  const bool root = (communicator.Rank() == 0);
+
+  const size_t numFunctions = f.NumFunctions();
+  size_t numShards = shards;
+  if (numShards == 0)
+  {
+    numShards = 1;
+    #ifdef ENS_USE_OPENMP
+      numShards = omp_get_max_threads();
+    #endif
+  }
+  // Every shard has at least one function (so a process without functions
+  // has no shards).
+  numShards = std::min(numShards, numFunctions);
+
+  // Count the shards of all the processes.
+  arma::vec counts(1);
+  counts[0] = double(numShards);
+  communicator.AllReduce(counts.memptr(), counts.n_elem);
+  const double totalShards = counts[0];
+  if (totalShards == 0.0)
+  {
+    throw std::invalid_argument("ConsensusADMM::Optimize(): there are no "
+        "functions to optimize!");
+  }
+
+  // All the processes start from the same point.
+  communicator.Broadcast(iterate.memptr(), iterate.n_elem, 0);
+
+  // Each shard is a contiguous range of the functions, with its own copy of
+  // the coordinates, scaled dual variable, penalty center z - u_i and inner
+  // optimizer.
+  double penalty = rho;
+  std::vector<BaseMatType> locals(numShards, iterate);
+  std::vector<BaseMatType> duals(numShards,
+      BaseMatType(iterate.n_rows, iterate.n_cols, arma::fill::zeros));
+  std::vector<BaseMatType> centers(numShards, iterate);
+  std::vector<InnerOptimizerType> optimizers(numShards, innerOptimizer);
+  std::vector<ConsensusADMMFunction<FullFunctionType, BaseMatType,
+      BaseGradType>> subproblems;
+  for (size_t s = 0; s < numShards; ++s)
+  {
+    const size_t begin = s * numFunctions / numShards;
+    const size_t end = (s + 1) * numFunctions / numShards;
+    subproblems.push_back(ConsensusADMMFunction<FullFunctionType, BaseMatType,
+        BaseGradType>(f, begin, end - begin, centers[s], penalty));
+  }
+
+  // The sums of x_i and x_i + u_i are sent with the sums of their squared
+  // norms and the termination requests.
+  const size_t n = iterate.n_elem;
+  arma::Col<ElemType> message(2 * n + 3);
+  BaseMatType lastIterate;
+
+  bool terminate = false;
+  bool requested = false;
+  requested |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
+
+  primalResidual = dualResidual = std::numeric_limits<double>::infinity();
+  const double scale = std::sqrt(totalShards * n);
+  size_t it;
+  for (it = 0; (maxIterations == 0 || it < maxIterations) && !terminate; ++it)
+  {
+    // Solve the local subproblems, from their previous solutions.
+    #ifdef ENS_USE_OPENMP
+      #pragma omp parallel for schedule(dynamic, 1) \
+          num_threads(std::max<size_t>(1, numShards))
+    #endif
+    for (size_t s = 0; s < numShards; ++s)
+    {
+      centers[s] = iterate - duals[s];
+      optimizers[s].Optimize(subproblems[s], locals[s]);
+    }
+
+    // Average x_i + u_i over the shards of all the processes.
+    message.zeros();
+    for (size_t s = 0; s < numShards; ++s)
+    {
+      const BaseMatType shifted = locals[s] + duals[s];
+      message.subvec(0, n - 1) += arma::vectorise(locals[s]);
+      message.subvec(n, 2 * n - 1) += arma::vectorise(shifted);
+      message[2 * n] += arma::accu(arma::square(locals[s]));
+      message[2 * n + 1] += arma::accu(arma::square(shifted));
+    }
+    message[2 * n + 2] = requested ? 1 : 0;
+    communicator.AllReduce(message.memptr(), message.n_elem);
+    terminate = (message[2 * n + 2] > 0);
+
+    lastIterate = iterate;
+    for (size_t i = 0; i < n; ++i)
+      iterate[i] = message[n + i] / ElemType(totalShards);
+
+    for (size_t s = 0; s < numShards; ++s)
+      duals[s] += locals[s] - iterate;
+
+    // The residuals and the norms follow from the sums:
+    // sum_i ||x_i - z||^2 = sum_i ||x_i||^2 - 2 z' sum_i x_i + N ||z||^2, and
+    // sum_i ||u_i||^2 = sum_i ||x_i + u_i - z||^2 = sum_i ||x_i + u_i||^2 -
+    // N ||z||^2, since z is the mean of x_i + u_i.
+    const arma::Col<ElemType> z = arma::vectorise(iterate);
+    const arma::Col<ElemType> localsSum = message.subvec(0, n - 1);
+    const double zz = arma::dot(z, z);
+    const double zLocals = arma::dot(z, localsSum);
+    const double localsNorm = std::sqrt(double(message[2 * n]));
+    const double dualsNorm = std::sqrt(std::max(0.0,
+        double(message[2 * n + 1]) - totalShards * zz));
+    primalResidual = std::sqrt(std::max(0.0, double(message[2 * n]) -
+        2.0 * zLocals + totalShards * zz));
+    dualResidual = penalty * std::sqrt(totalShards) *
+        arma::norm(arma::vectorise(iterate - lastIterate));
+
+    if (root)
+    {
+      Info << "ConsensusADMM: round " << it << ", primal residual "
+          << primalResidual << ", dual residual " << dualResidual << ", rho "
+          << penalty << "." << std::endl;
+    }
+
+    requested |= Callback::StepTaken(*this, f, iterate, callbacks...);
+
+    const double primalTolerance = scale * absoluteTolerance +
+        relativeTolerance * std::max(localsNorm, std::sqrt(totalShards * zz));
+    const double dualTolerance = scale * absoluteTolerance +
+        relativeTolerance * penalty * dualsNorm;
+    if (primalResidual <= primalTolerance && dualResidual <= dualTolerance)
+    {
+      if (root)
+      {
+        Info << "ConsensusADMM: residuals within tolerance; terminating "
+            << "optimization." << std::endl;
+      }
+      ++it;
+      break;
+    }
+
+    // Balance the residuals.  The scaled dual variables are y_i / rho, so they
+    // are rescaled with rho.
+    if (adaptivePenalty && primalResidual > 10.0 * dualResidual)
+    {
+      penalty *= 2.0;
+      for (size_t s = 0; s < numShards; ++s)
+        duals[s] /= ElemType(2);
+    }
+    else if (adaptivePenalty && dualResidual > 10.0 * primalResidual)
+    {
+      penalty /= 2.0;
+      for (size_t s = 0; s < numShards; ++s)
+        duals[s] *= ElemType(2);
+    }
+  }
+
+  if (root && terminate)
+  {
+    Info << "ConsensusADMM: callback requested termination." << std::endl;
+  }
+  else if (root && maxIterations != 0 && it == maxIterations)
+  {
+    Info << "ConsensusADMM: maximum iterations (" << maxIterations << ") "
+        << "reached; terminating optimization." << std::endl;
+  }
+  finalRho = penalty;
+
+  // Calculate final objective at the consensus variable, over all the
+  // processes.
+  std::vector<ElemType> objectives(numShards);
+  #ifdef ENS_USE_OPENMP
+    #pragma omp parallel for schedule(dynamic, 1) \
+          num_threads(std::max<size_t>(1, numShards))
+  #endif
+  for (size_t s = 0; s < numShards; ++s)
+  {
+    objectives[s] = subproblems[s].Objective(iterate);
+  }
+  ElemType overallObjective = 0;
+  for (size_t s = 0; s < numShards; ++s)
+    overallObjective += objectives[s];
+  communicator.AllReduce(&overallObjective, 1);
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+  return overallObjective;
+}
+
+} // namespace ens
+
+#endif
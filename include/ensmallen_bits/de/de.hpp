@@ -71,12 +71,21 @@ class DE
    * @param differentialWeight A parameter used in the mutation of candidate
    *     solutions controls amplification factor of the differentiation.
    * @param tolerance The final value of the objective function for termination.
+   * @param batchGeneration If true, all mutants of a generation are built at
+   *     once and evaluated in parallel with OpenMP before any member is
+   *     replaced.
+   * @param steadyStateWorkers If nonzero, the generations are replaced by a
+   *     steady state: this many mutants are evaluated at once on worker
+   *     threads, and each one replaces its member as soon as its evaluation
+   *     completes (see SteadyStateWorkers()).
    */
   DE(const size_t populationSize = 100,
      const size_t maxGenerations = 2000,
      const double crossoverRate = 0.6,
      const double differentialWeight = 0.8,
-     const double tolerance = 1e-5);
+     const double tolerance = 1e-5,
+     const bool batchGeneration = false,
+     const size_t steadyStateWorkers = 0);
 
   /**
    * Optimize the given function using DE. The given
@@ -84,12 +93,16 @@ class DE
    * algorithm, and the final objective value is returned.
    *
    * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to optimize.
    * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
    * @return Objective value of the final point.
    */
-  template<typename DecomposableFunctionType>
-  double Optimize(DecomposableFunctionType& function, arma::mat& iterate);
+  template<typename DecomposableFunctionType, typename... CallbackTypes>
+  double Optimize(DecomposableFunctionType& function,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
 
   //! Get the population size.
   size_t PopulationSize() const { return populationSize; }
@@ -116,10 +129,93 @@ class DE
   //! Modify the tolerance.
   double& Tolerance() { return tolerance; }
 
+  //! Get whether whole generations are built and evaluated at once.
+  bool BatchGeneration() const { return batchGeneration; }
+  //! Modify whether whole generations are built and evaluated at once.
+  bool& BatchGeneration() { return batchGeneration; }
+
+  /**
+   * Get the number of mutants evaluated at once in the steady state (0 for
+   * generations).  In the steady state, a new mutant of the next member (with
+   * the best member so far and two random ones) is started as soon as an
+   * evaluation completes, so that the workers do not wait for the slowest
+   * evaluation of a generation; the result then depends on the order in which
+   * the evaluations complete.  The mutants are evaluated with Evaluate() on
+   * std::threads, so it must be thread-safe, or with EvaluateAsync() if the
+   * function has it.  maxGenerations * populationSize mutants are evaluated at
+   * most, and the tolerance is checked after every populationSize of them.
+   */
+  size_t SteadyStateWorkers() const { return steadyStateWorkers; }
+  //! Modify the number of mutants evaluated at once in the steady state.
+  size_t& SteadyStateWorkers() { return steadyStateWorkers; }
+
  private:
+  /**
+   * Create the next generation at once: draw the random numbers for all
+   * members, build and evaluate all mutants (in parallel), and then replace
+   * every member whose mutant is better.
+   *
+   * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @param function Function to optimize.
+   * @param bestElement The best member of the current generation.
+   */
+  template<typename DecomposableFunctionType>
+  void BatchGeneration(DecomposableFunctionType& function,
+                       const arma::mat& bestElement);
+
+  /**
+   * Evaluate the population and evolve it in the steady state, with
+   * steadyStateWorkers evaluations in flight.
+   *
+   * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param bestElement Matrix to store the best member in.
+   * @param terminate Whether a callback requested termination before the
+   *     evaluation of the population.
+   * @param callbacks Callback functions.
+   * @return Objective value of the best member.
+   */
+  template<typename DecomposableFunctionType, typename... CallbackTypes>
+  double SteadyStateEvolution(DecomposableFunctionType& function,
+                              arma::mat& bestElement,
+                              bool terminate,
+                              CallbackTypes&&... callbacks);
+
+  /**
+   * Evaluate every slice of the given cube, with the batch Evaluate() of the
+   * function if it has one, or else one point at a time (in parallel, if
+   * requested).
+   *
+   * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @param function Function to optimize.
+   * @param points Points to evaluate (one per slice).
+   * @param objectives Vector to store the objective of each point in.
+   * @param parallel Whether to evaluate single points in parallel.
+   */
+  template<typename DecomposableFunctionType>
+  void EvaluatePopulation(DecomposableFunctionType& function,
+                          const arma::cube& points,
+                          arma::vec& objectives,
+                          const bool parallel);
+
   //! Population matrix. Each column is a candidate.
   arma::cube population;
 
+  //! The mutants of the current generation (used by BatchGeneration()).
+  arma::cube mutants;
+
+  //! Random numbers for the crossover of the current generation (used by
+  //! BatchGeneration()).
+  arma::cube crossoverDraws;
+
+  //! Fitness values of the mutants (used by BatchGeneration()).
+  arma::vec mutantFitnessValues;
+
+  //! The random number generator, seeded from Armadillo's generator at the
+  //! start of every optimization.
+  RNG rng;
+
   //! Vector of fitness values corresponding to each candidate.
   arma::vec fitnessValues;
 
@@ -137,6 +233,12 @@ class DE
 
   //! The tolerance for termination.
   double tolerance;
+
+  //! Whether whole generations are built and evaluated at once.
+  bool batchGeneration;
+
+  //! The number of mutants evaluated at once in the steady state.
+  size_t steadyStateWorkers;
 };
 
 } // namespace ens
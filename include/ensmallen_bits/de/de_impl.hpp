@@ -15,24 +15,31 @@
 
 #include "de.hpp"
 
+#include <ensmallen_bits/function.hpp>
+
 namespace ens {
 
 inline DE::DE(const size_t populationSize ,
               const size_t maxGenerations,
               const double crossoverRate,
               const double differentialWeight,
-              const double tolerance):
+              const double tolerance,
+              const bool batchGeneration,
+              const size_t steadyStateWorkers):
     populationSize(populationSize),
     maxGenerations(maxGenerations),
     crossoverRate(crossoverRate),
     differentialWeight(differentialWeight),
-    tolerance(tolerance)
+    tolerance(tolerance),
+    batchGeneration(batchGeneration),
+    steadyStateWorkers(steadyStateWorkers)
 { /* Nothing to do here. */ }
 
 //!Optimize the function
-template<typename DecomposableFunctionType>
+template<typename DecomposableFunctionType, typename... CallbackTypes>
 inline double DE::Optimize(DecomposableFunctionType& function,
-                           arma::mat& iterate)
+                           arma::mat& iterate,
+                           CallbackTypes&&... callbacks)
 {
   // Population Size must be atleast 3 for DE to work.
   if (populationSize < 3)
@@ -48,11 +55,33 @@ inline double DE::Optimize(DecomposableFunctionType& function,
 
   // Generate a population based on a Gaussian distribution around the given
   // starting point. Also finds the best element of the population.
-  population = arma::randn(iterate.n_rows, iterate.n_cols, populationSize);
+  rng.Seed(RNG::ArmaSeed());
+  population.set_size(iterate.n_rows, iterate.n_cols, populationSize);
+  rng.Randn(population);
+  population.each_slice() += iterate;
+
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+  terminate |= Callback::BeginOptimization(*this, function, iterate,
+      callbacks...);
+
+  if (steadyStateWorkers > 0)
+  {
+    // Replace the members one at a time, as the evaluations complete, instead
+    // of generation by generation.
+    lastBestFitness = SteadyStateEvolution(function, bestElement, terminate,
+        callbacks...);
+    iterate = bestElement;
+    Callback::EndOptimization(*this, function, iterate, callbacks...);
+    return lastBestFitness;
+  }
+
+  EvaluatePopulation(function, population, fitnessValues, batchGeneration);
+
   for (size_t i = 0; i < populationSize; i++)
   {
-    population.slice(i) = population.slice(i) + iterate;
-    fitnessValues[i] = function.Evaluate(population.slice(i));
+    terminate |= Callback::Evaluate(*this, function, population.slice(i),
+        fitnessValues[i], callbacks...);
     if(fitnessValues[i] < lastBestFitness)
     {
       lastBestFitness = fitnessValues[i];
@@ -60,56 +89,82 @@ inline double DE::Optimize(DecomposableFunctionType& function,
     }
   }
 
+  if (batchGeneration)
+  {
+    mutants.set_size(iterate.n_rows, iterate.n_cols, populationSize);
+    crossoverDraws.set_size(iterate.n_rows, iterate.n_cols, populationSize);
+    mutantFitnessValues.set_size(populationSize);
+  }
+
   // Iterate until maximum number of generations are completed.
-  for (size_t gen = 0; gen < maxGenerations; gen++)
+  for (size_t gen = 0; gen < maxGenerations && !terminate; gen++)
   {
-    // Generate new population based on /best/1/bin strategy.
-    for (size_t member = 0; member < populationSize; member++)
+    if (batchGeneration)
     {
-      iterate = population.slice(member);
-
-      // Generate two different random numbers to choose two random members.
-      size_t l = 0, m = 0;
-      do
+      // Build and evaluate the whole generation at once.  The evaluations are
+      // reported afterwards, so that callbacks are never called from several
+      // threads.
+      BatchGeneration(function, bestElement);
+      for (size_t member = 0; member < populationSize; member++)
       {
-        l = arma::as_scalar(arma::randi<arma::uvec>(
-            1, arma::distr_param(0, populationSize - 1)));
+        terminate |= Callback::Evaluate(*this, function,
+            mutants.slice(member), mutantFitnessValues[member],
+            callbacks...);
       }
-      while(l == member);
-
-      do
+    }
+    else
+    {
+      // Generate new population based on /best/1/bin strategy.
+      for (size_t member = 0; member < populationSize && !terminate; member++)
       {
-        m = arma::as_scalar(arma::randi<arma::uvec>(
-            1, arma::distr_param(0, populationSize - 1)));
-      }
-      while(m == member && m == l);
+        iterate = population.slice(member);
 
-      // Generate new "mutant" from two randomly chosen members.
-      arma::mat mutant = bestElement + differentialWeight *
-          (population.slice(l) - population.slice(m));
+        // Generate two different random numbers to choose two random members.
+        size_t l = 0, m = 0;
+        do
+        {
+          l = rng.Randi(0, populationSize - 1);
+        }
+        while(l == member);
 
-      // Perform crossover.
-      const arma::mat cr = arma::randu(iterate.n_rows);
-      for (size_t it = 0; it < iterate.n_rows; it++)
-      {
-        if (cr[it] >= crossoverRate)
+        do
         {
-          mutant[it] = iterate[it];
+          m = rng.Randi(0, populationSize - 1);
         }
-      }
+        while(m == member && m == l);
 
-      double iterateValue = function.Evaluate(iterate);
-      const double mutantValue = function.Evaluate(mutant);
+        // Generate new "mutant" from two randomly chosen members.
+        arma::mat mutant = bestElement + differentialWeight *
+            (population.slice(l) - population.slice(m));
 
-      // Replace the current member if mutant is better.
-      if (mutantValue < iterateValue)
-      {
-        iterate = mutant;
-        iterateValue = mutantValue;
-      }
+        // Perform crossover.
+        arma::vec cr(iterate.n_rows);
+        rng.Randu(cr);
+        for (size_t it = 0; it < iterate.n_rows; it++)
+        {
+          if (cr[it] >= crossoverRate)
+          {
+            mutant[it] = iterate[it];
+          }
+        }
+
+        double iterateValue = function.Evaluate(iterate);
+        terminate |= Callback::Evaluate(*this, function, iterate,
+            iterateValue, callbacks...);
+        const double mutantValue = function.Evaluate(mutant);
+        terminate |= Callback::Evaluate(*this, function, mutant, mutantValue,
+            callbacks...);
+
+        // Replace the current member if mutant is better.
+        if (mutantValue < iterateValue)
+        {
+          iterate = mutant;
+          iterateValue = mutantValue;
+        }
 
-      fitnessValues[member] = iterateValue;
-      population.slice(member) = iterate;
+        fitnessValues[member] = iterateValue;
+        population.slice(member) = iterate;
+      }
     }
 
     // Check for termination criteria.
@@ -130,12 +185,215 @@ inline double DE::Optimize(DecomposableFunctionType& function,
         break;
       }
     }
+
+    terminate |= Callback::StepTaken(*this, function, bestElement,
+        callbacks...);
+    terminate |= Callback::EndEpoch(*this, function, bestElement, gen,
+        lastBestFitness, callbacks...);
   }
 
   iterate = bestElement;
+  Callback::EndOptimization(*this, function, iterate, callbacks...);
   return lastBestFitness;
 }
 
+//! Create the next generation at once.
+template<typename DecomposableFunctionType>
+inline void DE::BatchGeneration(DecomposableFunctionType& function,
+                                const arma::mat& bestElement)
+{
+  // Draw all random numbers of the generation up front, so that the mutants
+  // can be built and evaluated in any order.
+  arma::umat partners(2, populationSize);
+  rng.Randi(partners, 0, populationSize - 1);
+  for (size_t member = 0; member < populationSize; member++)
+  {
+    // The two partners must be different from each other and from the member.
+    while (partners(0, member) == member)
+    {
+      partners(0, member) = rng.Randi(0, populationSize - 1);
+    }
+
+    while (partners(1, member) == member ||
+        partners(1, member) == partners(0, member))
+    {
+      partners(1, member) = rng.Randi(0, populationSize - 1);
+    }
+  }
+  rng.Randu(crossoverDraws);
+
+  // Build the mutants; each one only depends on the current population, so
+  // this can be done in parallel.
+  ParallelFor(populationSize, [&](const size_t member)
+  {
+    arma::mat& mutant = mutants.slice(member);
+    mutant = bestElement + differentialWeight *
+        (population.slice(partners(0, member)) -
+        population.slice(partners(1, member)));
+
+    // Perform crossover.
+    const arma::mat& current = population.slice(member);
+    const arma::mat& cr = crossoverDraws.slice(member);
+    for (size_t it = 0; it < mutant.n_elem; it++)
+    {
+      if (cr[it] >= crossoverRate)
+        mutant[it] = current[it];
+    }
+  });
+
+  EvaluatePopulation(function, mutants, mutantFitnessValues, true);
+
+  // Replace the members whose mutant is better.
+  for (size_t member = 0; member < populationSize; member++)
+  {
+    if (mutantFitnessValues[member] < fitnessValues[member])
+    {
+      population.slice(member) = mutants.slice(member);
+      fitnessValues[member] = mutantFitnessValues[member];
+    }
+  }
+}
+
+//! Evolve the population in the steady state.
+template<typename DecomposableFunctionType, typename... CallbackTypes>
+inline double DE::SteadyStateEvolution(DecomposableFunctionType& function,
+                                       arma::mat& bestElement,
+                                       bool terminate,
+                                       CallbackTypes&&... callbacks)
+{
+  // Evaluate the whole population first; the callbacks may not stop this,
+  // since every member needs a fitness.
+  size_t next = 0;
+  EvaluateAsCompleted(function, populationSize, steadyStateWorkers,
+      [&](arma::mat& point)
+      {
+        point = population.slice(next);
+        return next++;
+      },
+      [&](const size_t member, const arma::mat& point, const double value)
+      {
+        fitnessValues[member] = value;
+        terminate |= Callback::Evaluate(*this, function, point, value,
+            callbacks...);
+        return false;
+      });
+
+  size_t bestMember = fitnessValues.index_min();
+  double bestFitness = fitnessValues[bestMember];
+  double lastBestFitness = bestFitness;
+  size_t target = 0;
+  size_t completed = 0;
+  size_t epoch = 0;
+  arma::mat cr(population.n_rows, population.n_cols);
+  if (!terminate)
+  {
+    EvaluateAsCompleted(function, maxGenerations * populationSize,
+        steadyStateWorkers,
+        [&](arma::mat& mutant)
+        {
+          // Build a /best/1/bin mutant of the next member, from the current
+          // population.
+          const size_t member = target;
+          target = (target + 1) % populationSize;
+
+          size_t l = 0, m = 0;
+          do
+          {
+            l = rng.Randi(0, populationSize - 1);
+          }
+          while (l == member);
+
+          do
+          {
+            m = rng.Randi(0, populationSize - 1);
+          }
+          while (m == member || m == l);
+
+          mutant = population.slice(bestMember) + differentialWeight *
+              (population.slice(l) - population.slice(m));
+
+          // Perform crossover.
+          rng.Randu(cr);
+          const arma::mat& current = population.slice(member);
+          for (size_t it = 0; it < mutant.n_elem; it++)
+          {
+            if (cr[it] >= crossoverRate)
+              mutant[it] = current[it];
+          }
+
+          return member;
+        },
+        [&](const size_t member, const arma::mat& mutant, const double value)
+        {
+          terminate |= Callback::Evaluate(*this, function, mutant, value,
+              callbacks...);
+
+          // Replace the member if the mutant is better than it is now (it may
+          // have been replaced since the mutant was built).
+          if (value < fitnessValues[member])
+          {
+            population.slice(member) = mutant;
+            fitnessValues[member] = value;
+            if (value < bestFitness)
+            {
+              bestFitness = value;
+              bestMember = member;
+            }
+          }
+
+          // Check for termination after as many evaluations as a generation
+          // has.
+          if (++completed % populationSize == 0)
+          {
+            if (std::abs(lastBestFitness - bestFitness) < tolerance)
+            {
+              Info << "DE: minimized within tolerance " << tolerance << "; "
+                  << "terminating optimization." << std::endl;
+              return true;
+            }
+
+            lastBestFitness = bestFitness;
+            terminate |= Callback::StepTaken(*this, function,
+                population.slice(bestMember), callbacks...);
+            terminate |= Callback::EndEpoch(*this, function,
+                population.slice(bestMember), epoch++, bestFitness,
+                callbacks...);
+          }
+
+          return terminate;
+        });
+  }
+
+  bestElement = population.slice(bestMember);
+  return bestFitness;
+}
+
+//! Evaluate every member of the given population.
+template<typename DecomposableFunctionType>
+inline void DE::EvaluatePopulation(DecomposableFunctionType& function,
+                                   const arma::cube& points,
+                                   arma::vec& objectives,
+                                   const bool parallel)
+{
+  // If the function can evaluate the whole population at once, or start all
+  // the evaluations asynchronously, let it do that; otherwise the evaluations
+  // are independent, so they may be done in parallel.
+  if (parallel && !traits::HasBatchEvaluate<DecomposableFunctionType,
+      arma::mat>::value && !traits::HasAsyncEvaluate<DecomposableFunctionType,
+      arma::mat>::value)
+  {
+    ParallelFor(points.n_slices, [&](const size_t i)
+    {
+      objectives[i] = function.Evaluate(points.slice(i));
+    });
+  }
+  else
+  {
+    typedef Function<DecomposableFunctionType> FullFunctionType;
+    static_cast<FullFunctionType&>(function).Evaluate(points, objectives);
+  }
+}
+
 } // namespace ens
 
 #endif
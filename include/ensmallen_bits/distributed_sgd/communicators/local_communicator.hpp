@@ -0,0 +1,87 @@
+/**
+ * @file local_communicator.hpp
+ *
+ * A communicator for a single process, to run DistributedSGD without MPI.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_DISTRIBUTED_SGD_COMMUNICATORS_LOCAL_COMMUNICATOR_HPP
+#define ENSMALLEN_DISTRIBUTED_SGD_COMMUNICATORS_LOCAL_COMMUNICATOR_HPP
+
+namespace ens {
+
+/**
+ * The communicator of a job with a single rank, so every collective operation
+ * is a no-op.  With this communicator, DistributedSGD gives the same results
+ * as SGD (without shuffling).
+ *
+ * A communicator type used by DistributedSGD must implement
+ *
+ * @code
+ * // Get the index of this rank and the number of ranks.
+ * size_t Rank() const;
+ * size_t Size() const;
+ *
+ * // Replace the values with their elementwise sum over all ranks.
+ * void AllReduce(float* values, const size_t n) const;
+ * void AllReduce(double* values, const size_t n) const;
+ *
+ * // Replace the values with the values of the given rank.
+ * void Broadcast(float* values, const size_t n, const size_t root) const;
+ * void Broadcast(double* values, const size_t n, const size_t root) const;
+ *
+ * // Gather the given bytes of every rank, in the order of the ranks, into
+ * // receive (which holds Size() * bytes bytes).
+ * void AllGather(const char* send, const size_t bytes, char* receive) const;
+ * @endcode
+ *
+ * ShardedSGD also needs
+ *
+ * @code
+ * // Send send[r] to rank r, and receive in receive[r] the bytes that rank r
+ * // sent to this rank (receive is resized to Size() messages).
+ * void AllToAll(const std::vector<std::vector<char>>& send,
+ *               std::vector<std::vector<char>>& receive) const;
+ * @endcode
+ *
+ * All the ranks must call the collective operations in the same order, and
+ * the reduced values must be the same on every rank.
+ */
+class LocalCommunicator
+{
+ public:
+  //! Get the index of this rank.
+  size_t Rank() const { return 0; }
+  //! Get the number of ranks.
+  size_t Size() const { return 1; }
+
+  //! Sum the values over all ranks (nothing to do).
+  template<typename ElemType>
+  void AllReduce(ElemType* /* values */, const size_t /* n */) const { }
+
+  //! Broadcast the values of the given rank (nothing to do).
+  template<typename ElemType>
+  void Broadcast(ElemType* /* values */,
+                 const size_t /* n */,
+                 const size_t /* root */) const { }
+
+  //! Gather the bytes of all ranks (there is only this one).
+  void AllGather(const char* send, const size_t bytes, char* receive) const
+  {
+    std::memcpy(receive, send, bytes);
+  }
+
+  //! Exchange the messages of all ranks (this one sends to itself).
+  void AllToAll(const std::vector<std::vector<char>>& send,
+                std::vector<std::vector<char>>& receive) const
+  {
+    receive = send;
+  }
+};
+
+} // namespace ens
+
+#endif
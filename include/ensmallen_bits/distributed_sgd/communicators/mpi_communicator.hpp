@@ -0,0 +1,156 @@
+/**
+ * @file mpi_communicator.hpp
+ *
+ * A communicator that runs the collective operations of DistributedSGD with
+ * MPI.  This is only available if ENS_USE_MPI is defined.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_DISTRIBUTED_SGD_COMMUNICATORS_MPI_COMMUNICATOR_HPP
+#define ENSMALLEN_DISTRIBUTED_SGD_COMMUNICATORS_MPI_COMMUNICATOR_HPP
+
+#ifdef ENS_USE_MPI
+
+#include <mpi.h>
+
+namespace ens {
+
+/**
+ * The communicator of a job whose ranks are the processes of an MPI
+ * communicator.  The sums are computed with MPI_Allreduce(), which lets the
+ * MPI implementation pick the reduction algorithm (ring, tree or hierarchical)
+ * for the message size and the network; MPI guarantees that every rank gets
+ * the same result.
+ *
+ * MPI must be initialized (with MPI_Init()) before the communicator is used,
+ * and finalized by the user.  Each collective operation can send at most
+ * INT_MAX values.
+ */
+class MPICommunicator
+{
+ public:
+  /**
+   * Construct the communicator over the processes of the given MPI
+   * communicator.
+   *
+   * @param communicator MPI communicator to use.
+   */
+  MPICommunicator(const MPI_Comm communicator = MPI_COMM_WORLD) :
+      communicator(communicator)
+  { /* Nothing to do. */ }
+
+  //! Get the index of this rank.
+  size_t Rank() const
+  {
+    int rank;
+    Check(MPI_Comm_rank(communicator, &rank), "MPI_Comm_rank");
+    return size_t(rank);
+  }
+
+  //! Get the number of ranks.
+  size_t Size() const
+  {
+    int size;
+    Check(MPI_Comm_size(communicator, &size), "MPI_Comm_size");
+    return size_t(size);
+  }
+
+  //! Sum the values over all ranks.
+  void AllReduce(float* values, const size_t n) const
+  {
+    Check(MPI_Allreduce(MPI_IN_PLACE, values, int(n), MPI_FLOAT, MPI_SUM,
+        communicator), "MPI_Allreduce");
+  }
+
+  //! Sum the values over all ranks.
+  void AllReduce(double* values, const size_t n) const
+  {
+    Check(MPI_Allreduce(MPI_IN_PLACE, values, int(n), MPI_DOUBLE, MPI_SUM,
+        communicator), "MPI_Allreduce");
+  }
+
+  //! Broadcast the values of the given rank.
+  void Broadcast(float* values, const size_t n, const size_t root) const
+  {
+    Check(MPI_Bcast(values, int(n), MPI_FLOAT, int(root), communicator),
+        "MPI_Bcast");
+  }
+
+  //! Broadcast the values of the given rank.
+  void Broadcast(double* values, const size_t n, const size_t root) const
+  {
+    Check(MPI_Bcast(values, int(n), MPI_DOUBLE, int(root), communicator),
+        "MPI_Bcast");
+  }
+
+  //! Gather the bytes of all ranks.
+  void AllGather(const char* send, const size_t bytes, char* receive) const
+  {
+    Check(MPI_Allgather(send, int(bytes), MPI_BYTE, receive, int(bytes),
+        MPI_BYTE, communicator), "MPI_Allgather");
+  }
+
+  //! Exchange the messages of all ranks: the sizes are exchanged first, and
+  //! then the messages, with MPI_Alltoallv().
+  void AllToAll(const std::vector<std::vector<char>>& send,
+                std::vector<std::vector<char>>& receive) const
+  {
+    const size_t size = send.size();
+    std::vector<int> sendCounts(size), receiveCounts(size);
+    for (size_t r = 0; r < size; ++r)
+      sendCounts[r] = int(send[r].size());
+    Check(MPI_Alltoall(sendCounts.data(), 1, MPI_INT, receiveCounts.data(), 1,
+        MPI_INT, communicator), "MPI_Alltoall");
+
+    std::vector<int> sendOffsets(size, 0), receiveOffsets(size, 0);
+    for (size_t r = 1; r < size; ++r)
+    {
+      sendOffsets[r] = sendOffsets[r - 1] + sendCounts[r - 1];
+      receiveOffsets[r] = receiveOffsets[r - 1] + receiveCounts[r - 1];
+    }
+
+    std::vector<char> sent, received(size_t(receiveOffsets[size - 1] +
+        receiveCounts[size - 1]));
+    for (size_t r = 0; r < size; ++r)
+      sent.insert(sent.end(), send[r].begin(), send[r].end());
+    Check(MPI_Alltoallv(sent.data(), sendCounts.data(), sendOffsets.data(),
+        MPI_BYTE, received.data(), receiveCounts.data(),
+        receiveOffsets.data(), MPI_BYTE, communicator), "MPI_Alltoallv");
+
+    receive.resize(size);
+    for (size_t r = 0; r < size; ++r)
+    {
+      receive[r].assign(received.begin() + receiveOffsets[r],
+          received.begin() + receiveOffsets[r] + receiveCounts[r]);
+    }
+  }
+
+  //! Get the MPI communicator.
+  MPI_Comm Communicator() const { return communicator; }
+
+ private:
+  //! Throw an error if an MPI call failed.  (The default MPI error handler
+  //! aborts the job before this happens.)
+  static void Check(const int status, const char* call)
+  {
+    if (status != MPI_SUCCESS)
+    {
+      std::ostringstream oss;
+      oss << "MPICommunicator: " << call << "() failed with error " << status
+          << "!";
+      throw std::runtime_error(oss.str());
+    }
+  }
+
+  //! The MPI communicator.
+  MPI_Comm communicator;
+};
+
+} // namespace ens
+
+#endif // ENS_USE_MPI
+
+#endif
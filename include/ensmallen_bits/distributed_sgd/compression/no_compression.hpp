@@ -0,0 +1,73 @@
+/**
+ * @file no_compression.hpp
+ *
+ * The default gradient compression of DistributedSGD, which sends the full
+ * gradients.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_DISTRIBUTED_SGD_COMPRESSION_NO_COMPRESSION_HPP
+#define ENSMALLEN_DISTRIBUTED_SGD_COMPRESSION_NO_COMPRESSION_HPP
+
+namespace ens {
+
+/**
+ * No compression: DistributedSGD sums the full gradients with one allreduce.
+ *
+ * A compression type used by DistributedSGD must implement
+ *
+ * @code
+ * // Return the size in bytes of the message for a matrix of n elements; it
+ * // may only depend on n.
+ * template<typename ElemType>
+ * size_t MessageSize(const size_t n) const;
+ *
+ * // Encode the given values into the message.
+ * template<typename MatType>
+ * void Encode(const MatType& values, char* message);
+ *
+ * // Add the values encoded in the message to the given values.
+ * template<typename MatType>
+ * void Decode(const char* message, MatType& values) const;
+ * @endcode
+ *
+ * The messages of all the ranks are gathered by every rank, so each rank
+ * sends and receives MessageSize() bytes per rank at each step.  NoCompression
+ * implements these methods too (as a raw copy of the values), but they are not
+ * used; the gradients are summed with an allreduce instead.
+ */
+class NoCompression
+{
+ public:
+  //! Return the size of the message for a matrix of n elements.
+  template<typename ElemType>
+  size_t MessageSize(const size_t n) const { return n * sizeof(ElemType); }
+
+  //! Copy the values into the message.
+  template<typename MatType>
+  void Encode(const MatType& values, char* message)
+  {
+    std::memcpy(message, values.memptr(),
+        values.n_elem * sizeof(typename MatType::elem_type));
+  }
+
+  //! Add the values of the message to the given values.
+  template<typename MatType>
+  void Decode(const char* message, MatType& values) const
+  {
+    typedef typename MatType::elem_type ElemType;
+    for (size_t i = 0; i < values.n_elem; ++i)
+    {
+      ElemType value;
+      std::memcpy(&value, message + i * sizeof(ElemType), sizeof(ElemType));
+      values[i] += value;
+    }
+  }
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,171 @@
+/**
+ * @file quantized_compression.hpp
+ *
+ * Low-precision quantization of the gradients of DistributedSGD.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_DISTRIBUTED_SGD_COMPRESSION_QUANTIZED_COMPRESSION_HPP
+#define ENSMALLEN_DISTRIBUTED_SGD_COMPRESSION_QUANTIZED_COMPRESSION_HPP
+
+namespace ens {
+
+/**
+ * Quantization sends each entry of the gradients with the given number of bits
+ * (between 1 and 8), and one scale per gradient.
+ *
+ * With one bit, only the sign of each entry is sent, and each entry is
+ * decoded as plus or minus the mean magnitude of the entries, as in 1-bit SGD
+ * (Seide et al., 2014) and signSGD with error feedback (Karimireddy et al.,
+ * 2019).  With b > 1 bits, each entry is rounded to the nearest of the
+ * 2^(b - 1) - 1 levels on each side of zero that evenly divide the range of
+ * magnitudes; for instance, 8 bits give 127 levels of each sign.  With error
+ * feedback (see DistributedSGD), the rounding errors are kept and added to the
+ * next gradient.
+ *
+ * @code
+ * @inproceedings{seide20141,
+ *   title     = {1-Bit Stochastic Gradient Descent and its Application to
+ *                Data-Parallel Distributed Training of Speech {DNN}s},
+ *   author    = {Seide, Frank and Fu, Hao and Droppo, Jasha and Li, Gang and
+ *                Yu, Dong},
+ *   booktitle = {Fifteenth Annual Conference of the International Speech
+ *                Communication Association},
+ *   year      = {2014}
+ * }
+ *
+ * @inproceedings{karimireddy2019error,
+ *   title     = {Error Feedback Fixes {SignSGD} and other Gradient
+ *                Compression Schemes},
+ *   author    = {Karimireddy, Sai Praneeth and Rebjock, Quentin and
+ *                Stich, Sebastian and Jaggi, Martin},
+ *   booktitle = {International Conference on Machine Learning},
+ *   pages     = {3252--3261},
+ *   year      = {2019}
+ * }
+ * @endcode
+ */
+class QuantizedCompression
+{
+ public:
+  /**
+   * Construct the quantization with the given number of bits per entry.
+   *
+   * @param bits Number of bits per entry (between 1 and 8).
+   */
+  QuantizedCompression(const size_t bits = 8) : bits(bits)
+  {
+    if (bits < 1 || bits > 8)
+    {
+      std::ostringstream oss;
+      oss << "QuantizedCompression::QuantizedCompression(): bits must be "
+          << "between 1 and 8 (given " << bits << ")!";
+      throw std::invalid_argument(oss.str());
+    }
+  }
+
+  //! Return the size of the message for a matrix of n elements.
+  template<typename ElemType>
+  size_t MessageSize(const size_t n) const
+  {
+    return sizeof(ElemType) + (n * bits + 7) / 8;
+  }
+
+  //! Encode the quantized values into the message.
+  template<typename MatType>
+  void Encode(const MatType& values, char* message)
+  {
+    typedef typename MatType::elem_type ElemType;
+
+    // The scale is the mean magnitude for one bit, and the largest magnitude
+    // otherwise.
+    ElemType scale = 0;
+    if (values.n_elem > 0)
+    {
+      scale = (bits == 1) ? ElemType(arma::accu(arma::abs(values)) /
+          values.n_elem) : ElemType(arma::max(arma::abs(arma::vectorise(
+          values))));
+    }
+    std::memcpy(message, &scale, sizeof(ElemType));
+
+    unsigned char* codes = reinterpret_cast<unsigned char*>(message +
+        sizeof(ElemType));
+    std::memset(codes, 0, (values.n_elem * bits + 7) / 8);
+    const ElemType levels = ElemType(Levels());
+    for (size_t i = 0; i < values.n_elem; ++i)
+    {
+      size_t code;
+      if (bits == 1)
+        code = (values[i] >= 0) ? 1 : 0;
+      else if (scale == 0)
+        code = Levels();
+      else
+        code = size_t(std::round(values[i] / scale * levels) + levels);
+
+      Write(codes, i, code);
+    }
+  }
+
+  //! Add the quantized values of the message to the given values.
+  template<typename MatType>
+  void Decode(const char* message, MatType& values) const
+  {
+    typedef typename MatType::elem_type ElemType;
+    ElemType scale;
+    std::memcpy(&scale, message, sizeof(ElemType));
+
+    const unsigned char* codes = reinterpret_cast<const unsigned char*>(
+        message + sizeof(ElemType));
+    const ElemType levels = ElemType(Levels());
+    for (size_t i = 0; i < values.n_elem; ++i)
+    {
+      const size_t code = Read(codes, i);
+      if (bits == 1)
+        values[i] += (code == 1) ? scale : -scale;
+      else
+        values[i] += (ElemType(code) - levels) * scale / levels;
+    }
+  }
+
+  //! Get the number of bits per entry.
+  size_t Bits() const { return bits; }
+  //! Modify the number of bits per entry.
+  size_t& Bits() { return bits; }
+
+ private:
+  //! Return the number of levels on each side of zero (for b > 1 bits).
+  size_t Levels() const { return (size_t(1) << (bits - 1)) - 1; }
+
+  //! Write the code of the given entry.
+  void Write(unsigned char* codes, const size_t i, const size_t code) const
+  {
+    for (size_t b = 0; b < bits; ++b)
+    {
+      const size_t position = i * bits + b;
+      if ((code >> b) & 1)
+        codes[position / 8] |= (unsigned char) (1 << (position % 8));
+    }
+  }
+
+  //! Read the code of the given entry.
+  size_t Read(const unsigned char* codes, const size_t i) const
+  {
+    size_t code = 0;
+    for (size_t b = 0; b < bits; ++b)
+    {
+      const size_t position = i * bits + b;
+      code |= size_t((codes[position / 8] >> (position % 8)) & 1) << b;
+    }
+    return code;
+  }
+
+  //! The number of bits per entry.
+  size_t bits;
+};
+
+} // namespace ens
+
+#endif
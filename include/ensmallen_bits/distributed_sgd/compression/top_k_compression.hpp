@@ -0,0 +1,136 @@
+/**
+ * @file top_k_compression.hpp
+ *
+ * Top-k sparsification of the gradients of DistributedSGD.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_DISTRIBUTED_SGD_COMPRESSION_TOP_K_COMPRESSION_HPP
+#define ENSMALLEN_DISTRIBUTED_SGD_COMPRESSION_TOP_K_COMPRESSION_HPP
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace ens {
+
+/**
+ * Top-k sparsification sends only the given fraction of the entries of each
+ * gradient with the largest magnitude, as (index, value) pairs; the other
+ * entries are sent as zero.  With error feedback (see DistributedSGD), the
+ * entries that are not sent are kept and added to the next gradient, so every
+ * entry is eventually applied.  For more information, see the following.
+ *
+ * @code
+ * @inproceedings{stich2018sparsified,
+ *   title     = {Sparsified {SGD} with Memory},
+ *   author    = {Stich, Sebastian U. and Cordonnier, Jean-Baptiste and
+ *                Jaggi, Martin},
+ *   booktitle = {Advances in Neural Information Processing Systems},
+ *   pages     = {4447--4458},
+ *   year      = {2018}
+ * }
+ * @endcode
+ */
+class TopKCompression
+{
+ public:
+  /**
+   * Construct the top-k compression with the given fraction of entries to
+   * send.  At least one entry is always sent.
+   *
+   * @param ratio Fraction of the entries of each gradient to send.
+   */
+  TopKCompression(const double ratio = 0.01) : ratio(ratio)
+  {
+    if (ratio <= 0.0 || ratio > 1.0)
+    {
+      std::ostringstream oss;
+      oss << "TopKCompression::TopKCompression(): ratio must be in (0, 1] "
+          << "(given " << ratio << ")!";
+      throw std::invalid_argument(oss.str());
+    }
+  }
+
+  //! Return the size of the message for a matrix of n elements.
+  template<typename ElemType>
+  size_t MessageSize(const size_t n) const
+  {
+    return Entries(n) * (sizeof(arma::uword) + sizeof(ElemType));
+  }
+
+  //! Encode the entries of the given values with the largest magnitude.
+  template<typename MatType>
+  void Encode(const MatType& values, char* message)
+  {
+    typedef typename MatType::elem_type ElemType;
+    const size_t k = Entries(values.n_elem);
+    if (k == 0)
+      return;
+
+    // Find the k largest entries, in linear time.
+    order.resize(values.n_elem);
+    std::iota(order.begin(), order.end(), arma::uword(0));
+    std::nth_element(order.begin(), order.begin() + (k - 1), order.end(),
+        [&values](const arma::uword a, const arma::uword b)
+        {
+          return std::abs(values[a]) > std::abs(values[b]);
+        });
+
+    // The message has the k indices, then the k values.
+    char* indices = message;
+    char* entries = message + k * sizeof(arma::uword);
+    for (size_t j = 0; j < k; ++j)
+    {
+      const ElemType value = values[order[j]];
+      std::memcpy(indices + j * sizeof(arma::uword), &order[j],
+          sizeof(arma::uword));
+      std::memcpy(entries + j * sizeof(ElemType), &value, sizeof(ElemType));
+    }
+  }
+
+  //! Add the entries of the message to the given values.
+  template<typename MatType>
+  void Decode(const char* message, MatType& values) const
+  {
+    typedef typename MatType::elem_type ElemType;
+    const size_t k = Entries(values.n_elem);
+    const char* indices = message;
+    const char* entries = message + k * sizeof(arma::uword);
+    for (size_t j = 0; j < k; ++j)
+    {
+      arma::uword index;
+      ElemType value;
+      std::memcpy(&index, indices + j * sizeof(arma::uword),
+          sizeof(arma::uword));
+      std::memcpy(&value, entries + j * sizeof(ElemType), sizeof(ElemType));
+      values[index] += value;
+    }
+  }
+
+  //! Get the fraction of entries to send.
+  double Ratio() const { return ratio; }
+  //! Modify the fraction of entries to send.
+  double& Ratio() { return ratio; }
+
+ private:
+  //! Return the number of entries sent for a matrix of n elements.
+  size_t Entries(const size_t n) const
+  {
+    const size_t k = size_t(std::ceil(ratio * n));
+    return std::min(n, std::max(k, size_t(1)));
+  }
+
+  //! The fraction of entries to send.
+  double ratio;
+
+  //! The indices of the entries, ordered by Encode().
+  std::vector<arma::uword> order;
+};
+
+} // namespace ens
+
+#endif
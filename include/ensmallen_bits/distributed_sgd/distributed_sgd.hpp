@@ -0,0 +1,270 @@
+/**
+ * @file distributed_sgd.hpp
+ *
+ * Synchronous data-parallel stochastic gradient descent over several
+ * processes, each of which holds a shard of the data.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_DISTRIBUTED_SGD_DISTRIBUTED_SGD_HPP
+#define ENSMALLEN_DISTRIBUTED_SGD_DISTRIBUTED_SGD_HPP
+
+#include <ensmallen_bits/sgd/sgd.hpp>
+#include "communicators/local_communicator.hpp"
+#include "communicators/mpi_communicator.hpp"
+#include "compression/no_compression.hpp"
+#include "compression/quantized_compression.hpp"
+#include "compression/top_k_compression.hpp"
+
+namespace ens {
+
+/**
+ * DistributedSGD runs synchronous data-parallel SGD over the ranks of a
+ * communicator (for instance the processes of an MPI job, see
+ * ens::MPICommunicator).  Every rank runs Optimize() at the same time, with a
+ * function over its own shard of the data and the same starting point.  At
+ * each step, every rank computes the gradient of its next batch, the gradients
+ * are summed over all the ranks with one allreduce, and every rank takes the
+ * same step with the summed gradient.  So one step is the step that SGD would
+ * take on a batch of batchSize * Size() points, the iterates stay identical on
+ * all the ranks, and so does the state of the update and decay policies,
+ * without ever being communicated.
+ *
+ * To remove any drift of the iterates (say, from a reduction that differs in
+ * the last bits across ranks), the iterate of rank 0 is also broadcast at the
+ * start of the optimization and at the end of each epoch.
+ *
+ * An epoch lasts as many steps as the largest shard needs; ranks whose shard
+ * is exhausted (or empty) contribute a zero gradient until the epoch ends.
+ * Each rank shuffles its own shard.  The objectives used for the convergence
+ * check and returned by Optimize() are summed over all the ranks, so they are
+ * the same everywhere and match the objective over the full dataset.  (If
+ * the objective has a regularization term that is spread over the separable
+ * functions, as in ens::test::LogisticRegressionFunction, the function of each
+ * shard must carry only its share of it.)
+ *
+ * The gradients can be compressed before they are sent, to reduce the traffic
+ * between the ranks (see ens::TopKCompression and ens::QuantizedCompression).
+ * Then the compressed gradients of all the ranks are gathered by every rank
+ * (a sparse or quantized gradient can't be summed on the way) and summed
+ * locally, and the scalars of the step are summed with a small allreduce.
+ * With error feedback, the part of its gradient that a rank could not send
+ * (the difference between the gradient and its compressed version) is added
+ * to its next gradient, which keeps compressed SGD convergent.
+ *
+ * A callback on any rank may stop the optimization; the request is sent with
+ * the next step, so all the ranks stop together after that step.
+ *
+ * For more information on synchronous data-parallel SGD, see the following.
+ *
+ * @code
+ * @article{goyal2017accurate,
+ *   title   = {Accurate, Large Minibatch {SGD}: Training {ImageNet} in 1
+ *              Hour},
+ *   author  = {Goyal, Priya and Doll{\'a}r, Piotr and Girshick, Ross and
+ *              Noordhuis, Pieter and Wesolowski, Lukasz and Kyrola, Aapo and
+ *              Tulloch, Andrew and Jia, Yangqing and He, Kaiming},
+ *   journal = {arXiv preprint arXiv:1706.02677},
+ *   year    = {2017}
+ * }
+ * @endcode
+ *
+ * DistributedSGD can optimize differentiable separable functions; the
+ * gradient type must be a dense matrix.
+ *
+ * @tparam UpdatePolicyType Update policy used during the iterative update
+ *     process (see ens::VanillaUpdate).
+ * @tparam DecayPolicyType Decay policy used to adjust the step size (see
+ *     ens::NoDecay).
+ * @tparam CommunicatorType Communicator used to combine the gradients of the
+ *     ranks (see ens::LocalCommunicator for the interface).
+ * @tparam CompressionType Compression of the gradients sent between the ranks
+ *     (see ens::NoCompression for the interface).
+ */
+template<typename UpdatePolicyType = VanillaUpdate,
+         typename DecayPolicyType = NoDecay,
+         typename CommunicatorType = LocalCommunicator,
+         typename CompressionType = NoCompression>
+class DistributedSGD
+{
+ public:
+  /**
+   * Construct the DistributedSGD optimizer with the given parameters.  The
+   * maximum number of iterations refers to the number of functions visited
+   * over all the ranks; it is shared evenly between the ranks, so it may be
+   * exceeded by less than the number of ranks.  All the ranks must use the
+   * same parameters.
+   *
+   * @param stepSize Step size for each iteration.
+   * @param batchSize Number of functions of each rank in each step.
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *     limit).
+   * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param shuffle If true, each rank shuffles its functions at each epoch.
+   * @param updatePolicy Instantiated update policy used to adjust the given
+   *     parameters.
+   * @param decayPolicy Instantiated decay policy used to adjust the step size.
+   * @param resetPolicy Flag that determines whether update policy parameters
+   *     are reset before every Optimize call.
+   * @param communicator Communicator between the ranks.
+   * @param compression Instantiated compression of the gradients.
+   * @param errorFeedback If true, the compression error of each gradient is
+   *     added to the next gradient of the rank (this has no effect without
+   *     compression).
+   */
+  DistributedSGD(const double stepSize = 0.01,
+                 const size_t batchSize = 32,
+                 const size_t maxIterations = 100000,
+                 const double tolerance = 1e-5,
+                 const bool shuffle = true,
+                 const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
+                 const DecayPolicyType& decayPolicy = DecayPolicyType(),
+                 const bool resetPolicy = true,
+                 const CommunicatorType& communicator = CommunicatorType(),
+                 const CompressionType& compression = CompressionType(),
+                 const bool errorFeedback = true);
+
+  /**
+   * Optimize the given function, which holds the shard of this rank.  Every
+   * rank must call Optimize() with a starting point of the same size; the
+   * starting point of rank 0 is used, and the given starting point will be
+   * modified to store the finishing point of the algorithm, which is the same
+   * on all the ranks.  The final objective value, summed over all the ranks,
+   * is returned.
+   *
+   * @tparam DecomposableFunctionType Type of the function to optimize.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize, over the shard of this rank.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename DecomposableFunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(DecomposableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks);
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the batch size of each rank.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size of each rank.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the individual functions are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the individual functions are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+  //! Get whether or not the update policy parameters
+  //! are reset before Optimize call.
+  bool ResetPolicy() const { return resetPolicy; }
+  //! Modify whether or not the update policy parameters
+  //! are reset before Optimize call.
+  bool& ResetPolicy() { return resetPolicy; }
+
+  //! Get the update policy.
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  //! Modify the update policy.
+  UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
+
+  //! Get the step size decay policy.
+  const DecayPolicyType& DecayPolicy() const { return decayPolicy; }
+  //! Modify the step size decay policy.
+  DecayPolicyType& DecayPolicy() { return decayPolicy; }
+
+  //! Get the communicator.
+  const CommunicatorType& Communicator() const { return communicator; }
+  //! Modify the communicator.
+  CommunicatorType& Communicator() { return communicator; }
+
+  //! Get the gradient compression.
+  const CompressionType& Compression() const { return compression; }
+  //! Modify the gradient compression.
+  CompressionType& Compression() { return compression; }
+
+  //! Get whether or not the compression error is fed back.
+  bool ErrorFeedback() const { return errorFeedback; }
+  //! Modify whether or not the compression error is fed back.
+  bool& ErrorFeedback() { return errorFeedback; }
+
+ private:
+  /**
+   * Compress the given gradient (with the residual of the previous gradients,
+   * if errorFeedback is true), gather the compressed gradients of all the
+   * ranks, and store their sum in the gradient.
+   */
+  template<typename GradType>
+  void GatherCompressed(GradType& gradient,
+                        GradType& residual,
+                        GradType& decoded,
+                        std::vector<char>& sent,
+                        std::vector<char>& received);
+
+  //! The step size for each example.
+  double stepSize;
+
+  //! The batch size of each rank.
+  size_t batchSize;
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the individual functions are shuffled when
+  //! iterating.
+  bool shuffle;
+
+  //! The update policy used to update the parameters in each iteration.
+  UpdatePolicyType updatePolicy;
+
+  //! The decay policy used to update the step size.
+  DecayPolicyType decayPolicy;
+
+  //! Flag indicating whether update policy
+  //! should be reset before running optimization.
+  bool resetPolicy;
+
+  //! The communicator between the ranks.
+  CommunicatorType communicator;
+
+  //! The compression of the gradients.
+  CompressionType compression;
+
+  //! Whether the compression error is added to the next gradient.
+  bool errorFeedback;
+
+  //! The initialized update policy.  Its type depends on the matrix type
+  //! given to Optimize(), so it is held in an Any object.
+  Any instUpdatePolicy;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "distributed_sgd_impl.hpp"
+
+#endif
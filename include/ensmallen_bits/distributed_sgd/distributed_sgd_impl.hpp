@@ -0,0 +1,336 @@
+/**
+ * @file distributed_sgd_impl.hpp
+ *
+ * Implementation of synchronous data-parallel stochastic gradient descent.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_DISTRIBUTED_SGD_DISTRIBUTED_SGD_IMPL_HPP
+#define ENSMALLEN_DISTRIBUTED_SGD_DISTRIBUTED_SGD_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "distributed_sgd.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+template<typename UpdatePolicyType,
+         typename DecayPolicyType,
+         typename CommunicatorType,
+         typename CompressionType>
+DistributedSGD<UpdatePolicyType, DecayPolicyType, CommunicatorType,
+    CompressionType>::DistributedSGD(const double stepSize,
+               const size_t batchSize,
+               const size_t maxIterations,
+               const double tolerance,
+               const bool shuffle,
+               const UpdatePolicyType& updatePolicy,
+               const DecayPolicyType& decayPolicy,
+               const bool resetPolicy,
+               const CommunicatorType& communicator,
+               const CompressionType& compression,
+               const bool errorFeedback) :
+    stepSize(stepSize),
+    batchSize(batchSize),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    shuffle(shuffle),
+    updatePolicy(updatePolicy),
+    decayPolicy(decayPolicy),
+    resetPolicy(resetPolicy),
+    communicator(communicator),
+    compression(compression),
+    errorFeedback(errorFeedback)
+{ /* Nothing to do. */ }
+
+//! Optimize the function (minimize).
+template<typename UpdatePolicyType,
+         typename DecayPolicyType,
+         typename CommunicatorType,
+         typename CompressionType>
+template<typename DecomposableFunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename MatType::elem_type
+DistributedSGD<UpdatePolicyType, DecayPolicyType, CommunicatorType,
+    CompressionType>::Optimize(
+    DecomposableFunctionType& function,
+    MatType& iterateIn,
+    CallbackTypes&&... callbacks)
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+  typedef typename UpdatePolicyType::template Policy<BaseMatType, BaseGradType>
+      InstUpdatePolicyType;
+
+  typedef Function<DecomposableFunctionType, BaseMatType, BaseGradType>
+      FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  // Make sure we have all the methods that we need.
+  traits::CheckDecomposableFunctionTypeAPI<FullFunctionType, BaseMatType,
+      BaseGradType>();
+
+  // The gradients are sent as contiguous arrays of values.
+  static_assert(std::is_same<BaseGradType,
+      arma::Mat<typename BaseGradType::elem_type>>::value,
+      "DistributedSGD: the gradient type must be a dense matrix.");
+
+  // Vectors are optimized as matrices.
+  BaseMatType& iterate = static_cast<BaseMatType&>(iterateIn);
+
+  // Only the first rank reports progress.
+  const size_t ranks = communicator.Size();
+  const bool root = (communicator.Rank() == 0);
+
+  // Find the number of functions of this rank, the total number of functions,
+  // and the number of steps in an epoch (the number of batches of the largest
+  // shard).  The number of steps of each rank is summed in its own slot, so
+  // the maximum can be taken after the sum.
+  const size_t numFunctions = f.NumFunctions();
+  arma::vec counts(ranks + 1, arma::fill::zeros);
+  counts[communicator.Rank()] = (numFunctions + batchSize - 1) / batchSize;
+  counts[ranks] = numFunctions;
+  communicator.AllReduce(counts.memptr(), counts.n_elem);
+  const size_t stepsPerEpoch = size_t(arma::max(counts.head(ranks)));
+  if (stepsPerEpoch == 0)
+  {
+    throw std::invalid_argument("DistributedSGD::Optimize(): there are no "
+        "functions on any rank!");
+  }
+
+  // All the ranks start from the same point.
+  communicator.Broadcast(iterate.memptr(), iterate.n_elem, 0);
+
+  // To keep track of where we are and how things are going.
+  size_t currentFunction = 0;
+  size_t epochStep = 0;
+  ElemType overallObjective = 0;
+  ElemType lastObjective = std::numeric_limits<ElemType>::max();
+
+  // Initialize the update policy.  If the previous call used a different
+  // matrix type, the policy has to be reinitialized anyway.
+  if (resetPolicy || !instUpdatePolicy.Has<InstUpdatePolicyType>())
+  {
+    instUpdatePolicy.Set(new InstUpdatePolicyType(updatePolicy,
+        iterate.n_rows, iterate.n_cols));
+  }
+  InstUpdatePolicyType& instPolicy =
+      instUpdatePolicy.As<InstUpdatePolicyType>();
+
+  // Track the current epoch and whether a callback asked us to stop.  A
+  // request of a callback on this rank is only acted on once all the ranks
+  // know about it, after the next allreduce.
+  size_t epoch = 0;
+  bool terminate = false;
+  bool requested = false;
+  requested |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
+
+  // Without compression, the gradient of each step is sent with its
+  // objective, the number of functions in the batch, and the termination
+  // requests in one message.  With compression, the scalars are sent on their
+  // own and the compressed gradients are gathered.
+  const bool compressed = !std::is_same<CompressionType, NoCompression>::value;
+  BaseGradType gradient(iterate.n_rows, iterate.n_cols);
+  const size_t n = gradient.n_elem;
+  arma::Col<ElemType> message(compressed ? 3 : n + 3);
+  const size_t messageSize = compressed ?
+      compression.template MessageSize<ElemType>(n) : 0;
+  std::vector<char> sent(messageSize);
+  std::vector<char> received(messageSize * ranks);
+  BaseGradType residual, decoded;
+  if (compressed && errorFeedback)
+  {
+    residual.zeros(iterate.n_rows, iterate.n_cols);
+    decoded.set_size(iterate.n_rows, iterate.n_cols);
+  }
+
+  // Now iterate!
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+  for (size_t i = 0; i < actualMaxIterations && !terminate;
+      /* incrementing done manually */)
+  {
+    // Is this iteration the start of a sequence?
+    if (epochStep == stepsPerEpoch)
+    {
+      // Output current objective function.
+      if (root)
+      {
+        Info << "DistributedSGD: iteration " << i << ", objective "
+            << overallObjective << ".\n";
+      }
+
+      requested |= Callback::EndEpoch(*this, f, iterate, epoch++,
+          overallObjective, callbacks...);
+
+      // The objective is the same on all the ranks, so they all stop here.
+      if (std::isnan(overallObjective) || std::isinf(overallObjective))
+      {
+        if (root)
+        {
+          Warn << "DistributedSGD: converged to " << overallObjective << "; "
+              << "terminating with failure.  Try a smaller step size?"
+              << std::endl;
+        }
+        Callback::EndOptimization(*this, f, iterate, callbacks...);
+        return overallObjective;
+      }
+
+      if (std::abs(lastObjective - overallObjective) < tolerance)
+      {
+        if (root)
+        {
+          Info << "DistributedSGD: minimized within tolerance " << tolerance
+              << "; terminating optimization." << std::endl;
+        }
+        Callback::EndOptimization(*this, f, iterate, callbacks...);
+        return overallObjective;
+      }
+
+      // Reset the counter variables.
+      lastObjective = overallObjective;
+      overallObjective = 0;
+      currentFunction = 0;
+      epochStep = 0;
+
+      // Remove any drift between the iterates of the ranks.
+      communicator.Broadcast(iterate.memptr(), iterate.n_elem, 0);
+
+      if (shuffle) // Determine order of visitation.
+        f.Shuffle();
+
+      requested |= Callback::BeginEpoch(*this, f, iterate, epoch,
+          lastObjective, callbacks...);
+    }
+
+    // Find the batch size of this rank; it can't be larger than the
+    // user-specified batch size, than this rank's share of the iterations left
+    // before actualMaxIterations is hit, or than the number of functions left
+    // in the shard.
+    const size_t iterationsLeft = actualMaxIterations - i;
+    const size_t share = iterationsLeft / ranks +
+        ((iterationsLeft % ranks == 0) ? 0 : 1);
+    const size_t effectiveBatchSize = std::min(std::min(batchSize, share),
+        numFunctions - currentFunction);
+
+    // Technically we are computing the objective before we take the step, but
+    // for many FunctionTypes it may be much quicker to do it like this.  A
+    // rank without any functions left only takes part in the sum.
+    ElemType objective = 0;
+    if (effectiveBatchSize > 0)
+    {
+      objective = f.EvaluateWithGradient(iterate, currentFunction, gradient,
+          effectiveBatchSize);
+    }
+    else
+    {
+      gradient.zeros();
+    }
+
+    // Sum the gradients, objectives and batch sizes over all the ranks.
+    const size_t m = message.n_elem - 3;
+    if (!compressed)
+      std::copy(gradient.begin(), gradient.end(), message.begin());
+    message[m] = objective;
+    message[m + 1] = ElemType(effectiveBatchSize);
+    message[m + 2] = requested ? 1 : 0;
+    communicator.AllReduce(message.memptr(), message.n_elem);
+    if (compressed)
+      GatherCompressed(gradient, residual, decoded, sent, received);
+    else
+      std::copy(message.begin(), message.begin() + n, gradient.begin());
+    objective = message[m];
+    const size_t globalBatchSize = size_t(message[m + 1] + 0.5);
+    terminate = (message[m + 2] > 0);
+
+    overallObjective += objective;
+
+    requested |= Callback::EvaluateWithGradient(*this, f, iterate, objective,
+        gradient, callbacks...);
+
+    // Use the update policy to take a step; this is the same step on all the
+    // ranks.
+    instPolicy.Update(iterate, stepSize, gradient);
+
+    requested |= Callback::StepTaken(*this, f, iterate, callbacks...);
+
+    // Now update the learning rate if requested by the user.
+    decayPolicy.Update(iterate, stepSize, gradient);
+
+    i += globalBatchSize;
+    currentFunction += effectiveBatchSize;
+    ++epochStep;
+  }
+
+  if (root)
+  {
+    if (terminate)
+    {
+      Info << "DistributedSGD: callback requested termination." << std::endl;
+    }
+    else
+    {
+      Info << "DistributedSGD: maximum iterations (" << maxIterations << ") "
+          << "reached; terminating optimization." << std::endl;
+    }
+  }
+
+  // Calculate final objective, over all the ranks.
+  overallObjective = 0;
+  for (size_t i = 0; i < numFunctions; i += batchSize)
+  {
+    const size_t effectiveBatchSize = std::min(batchSize, numFunctions - i);
+    overallObjective += f.Evaluate(iterate, i, effectiveBatchSize);
+  }
+  communicator.AllReduce(&overallObjective, 1);
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+  return overallObjective;
+}
+
+template<typename UpdatePolicyType,
+         typename DecayPolicyType,
+         typename CommunicatorType,
+         typename CompressionType>
+template<typename GradType>
+void DistributedSGD<UpdatePolicyType, DecayPolicyType, CommunicatorType,
+    CompressionType>::GatherCompressed(GradType& gradient,
+                                       GradType& residual,
+                                       GradType& decoded,
+                                       std::vector<char>& sent,
+                                       std::vector<char>& received)
+{
+  // With error feedback, the residual holds what was not sent of the previous
+  // gradients; send it along with this gradient, and keep what is left.
+  if (errorFeedback)
+  {
+    residual += gradient;
+    compression.Encode(residual, sent.data());
+    decoded.zeros();
+    compression.Decode(sent.data(), decoded);
+    residual -= decoded;
+  }
+  else
+  {
+    compression.Encode(gradient, sent.data());
+  }
+
+  // The messages of the ranks are summed in the same order everywhere, so the
+  // gradient is the same on all the ranks.
+  communicator.AllGather(sent.data(), sent.size(), received.data());
+  gradient.zeros();
+  for (size_t r = 0; r < communicator.Size(); ++r)
+    compression.Decode(received.data() + r * sent.size(), gradient);
+}
+
+} // namespace ens
+
+#endif
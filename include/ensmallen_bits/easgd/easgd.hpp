@@ -0,0 +1,251 @@
+/**
+ * @file easgd.hpp
+ *
+ * Elastic averaging SGD: several workers run SGD on their own models, which
+ * are elastically pulled toward a shared center variable.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_EASGD_EASGD_HPP
+#define ENSMALLEN_EASGD_EASGD_HPP
+
+#include <ensmallen_bits/sgd/sgd.hpp>
+#include <ensmallen_bits/distributed_sgd/communicators/local_communicator.hpp>
+#include <ensmallen_bits/distributed_sgd/communicators/mpi_communicator.hpp>
+
+namespace ens {
+
+/**
+ * Elastic averaging SGD (EASGD) splits the functions into one contiguous
+ * range per worker.  Each worker runs SGD on its own model, with its own
+ * instance of the update and decay policies, and every communicationPeriod
+ * steps (tau in the paper) the models and a shared center variable are pulled
+ * toward each other: with p workers in total and alpha = movingRate / p, each
+ * worker model x_i and the center c take the synchronous elastic step
+ *
+ *   x_i <- x_i - alpha (x_i - c),    c <- c + alpha sum_i (x_i - c).
+ *
+ * Unlike LocalSGD, the workers keep their own models between communications,
+ * so they may explore further from the center, and only the center is shared.
+ * Unlike ParallelSGD, no coordinate of any model is ever shared between
+ * threads, so EASGD is suited to dense models where Hogwild!-style sharing
+ * conflicts on every coordinate of every step.
+ *
+ * The workers of a process are OpenMP threads (or run one after the other,
+ * when OpenMP is not used), so the function must allow concurrent calls to
+ * EvaluateWithGradient() with different iterates.  The workers of several
+ * processes can be combined with a communicator (see ens::MPICommunicator);
+ * then each process holds a shard of the data, as with DistributedSGD, and the
+ * elastic differences of all the workers of all the processes are summed.
+ *
+ * An epoch lasts as many steps as the largest range of functions needs, and
+ * the workers always communicate at the end of an epoch.  The objective of an
+ * epoch is the sum of the batch objectives of all the workers.  Callbacks see
+ * the center variable: StepTaken() is called after each communication.  The
+ * center is the result of the optimization.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{zhang2015deep,
+ *   title     = {Deep Learning with Elastic Averaging {SGD}},
+ *   author    = {Zhang, Sixin and Choromanska, Anna E. and LeCun, Yann},
+ *   booktitle = {Advances in Neural Information Processing Systems},
+ *   pages     = {685--693},
+ *   year      = {2015}
+ * }
+ * @endcode
+ *
+ * EASGD can optimize differentiable separable functions.
+ *
+ * @tparam UpdatePolicyType Update policy used by each worker (see
+ *     ens::VanillaUpdate).
+ * @tparam DecayPolicyType Decay policy used by each worker to adjust its step
+ *     size (see ens::NoDecay).
+ * @tparam CommunicatorType Communicator used to combine the workers of several
+ *     processes (see ens::LocalCommunicator for the interface).
+ */
+template<typename UpdatePolicyType = VanillaUpdate,
+         typename DecayPolicyType = NoDecay,
+         typename CommunicatorType = LocalCommunicator>
+class EASGD
+{
+ public:
+  /**
+   * Construct the EASGD optimizer with the given parameters.  The maximum
+   * number of iterations refers to the number of functions visited by all the
+   * workers; it is shared evenly between the workers, so it may be exceeded by
+   * less than the number of workers.
+   *
+   * @param stepSize Step size for each iteration.
+   * @param batchSize Batch size of each worker.
+   * @param communicationPeriod Number of steps of each worker between two
+   *     elastic steps.
+   * @param movingRate Moving rate of the center variable (beta in the paper):
+   *     the elastic coefficient of each worker is movingRate divided by the
+   *     total number of workers.  It must be in (0, 1].
+   * @param workers Number of workers in each process (0 means the maximum
+   *     number of OpenMP threads).
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *     limit).
+   * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param shuffle If true, the functions are shuffled at each epoch.
+   * @param updatePolicy Instantiated update policy used to adjust the given
+   *     parameters.
+   * @param decayPolicy Instantiated decay policy used to adjust the step size.
+   * @param resetPolicy Flag that determines whether update policy parameters
+   *     are reset before every Optimize call.
+   * @param communicator Communicator between the processes.
+   */
+  EASGD(const double stepSize = 0.01,
+        const size_t batchSize = 32,
+        const size_t communicationPeriod = 10,
+        const double movingRate = 0.9,
+        const size_t workers = 0,
+        const size_t maxIterations = 100000,
+        const double tolerance = 1e-5,
+        const bool shuffle = true,
+        const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
+        const DecayPolicyType& decayPolicy = DecayPolicyType(),
+        const bool resetPolicy = true,
+        const CommunicatorType& communicator = CommunicatorType());
+
+  /**
+   * Optimize the given function.  The given starting point will be modified to
+   * store the finishing point of the algorithm (the center variable), and the
+   * final objective value is returned.  With several processes, the starting
+   * point of the first one is used, and the objective is summed over all the
+   * processes.
+   *
+   * @tparam DecomposableFunctionType Type of the function to optimize.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename DecomposableFunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(DecomposableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks);
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the batch size of each worker.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size of each worker.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the number of steps between two elastic steps.
+  size_t CommunicationPeriod() const { return communicationPeriod; }
+  //! Modify the number of steps between two elastic steps.
+  size_t& CommunicationPeriod() { return communicationPeriod; }
+
+  //! Get the moving rate of the center variable.
+  double MovingRate() const { return movingRate; }
+  //! Modify the moving rate of the center variable.
+  double& MovingRate() { return movingRate; }
+
+  //! Get the number of workers (0 means the maximum number of threads).
+  size_t Workers() const { return workers; }
+  //! Modify the number of workers (0 means the maximum number of threads).
+  size_t& Workers() { return workers; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the individual functions are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the individual functions are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+  //! Get whether or not the update policy parameters
+  //! are reset before Optimize call.
+  bool ResetPolicy() const { return resetPolicy; }
+  //! Modify whether or not the update policy parameters
+  //! are reset before Optimize call.
+  bool& ResetPolicy() { return resetPolicy; }
+
+  //! Get the update policy.
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  //! Modify the update policy.
+  UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
+
+  //! Get the step size decay policy.
+  const DecayPolicyType& DecayPolicy() const { return decayPolicy; }
+  //! Modify the step size decay policy.
+  DecayPolicyType& DecayPolicy() { return decayPolicy; }
+
+  //! Get the communicator.
+  const CommunicatorType& Communicator() const { return communicator; }
+  //! Modify the communicator.
+  CommunicatorType& Communicator() { return communicator; }
+
+ private:
+  //! The step size for each example.
+  double stepSize;
+
+  //! The batch size of each worker.
+  size_t batchSize;
+
+  //! The number of steps between two elastic steps.
+  size_t communicationPeriod;
+
+  //! The moving rate of the center variable.
+  double movingRate;
+
+  //! The number of workers in each process.
+  size_t workers;
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the individual functions are shuffled when
+  //! iterating.
+  bool shuffle;
+
+  //! The update policy used to update the parameters in each iteration.
+  UpdatePolicyType updatePolicy;
+
+  //! The decay policy used to update the step size.
+  DecayPolicyType decayPolicy;
+
+  //! Flag indicating whether update policy
+  //! should be reset before running optimization.
+  bool resetPolicy;
+
+  //! The communicator between the processes.
+  CommunicatorType communicator;
+
+  //! The initialized update policies of the workers.  Their type depends on
+  //! the matrix type given to Optimize(), so they are held in an Any object.
+  Any instUpdatePolicies;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "easgd_impl.hpp"
+
+#endif
@@ -0,0 +1,320 @@
+/**
+ * @file easgd_impl.hpp
+ *
+ * Implementation of elastic averaging SGD.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_EASGD_EASGD_IMPL_HPP
+#define ENSMALLEN_EASGD_EASGD_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "easgd.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+template<typename UpdatePolicyType,
+         typename DecayPolicyType,
+         typename CommunicatorType>
+EASGD<UpdatePolicyType, DecayPolicyType, CommunicatorType>::EASGD(
+    const double stepSize,
+    const size_t batchSize,
+    const size_t communicationPeriod,
+    const double movingRate,
+    const size_t workers,
+    const size_t maxIterations,
+    const double tolerance,
+    const bool shuffle,
+    const UpdatePolicyType& updatePolicy,
+    const DecayPolicyType& decayPolicy,
+    const bool resetPolicy,
+    const CommunicatorType& communicator) :
+    stepSize(stepSize),
+    batchSize(batchSize),
+    communicationPeriod(communicationPeriod),
+    movingRate(movingRate),
+    workers(workers),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    shuffle(shuffle),
+    updatePolicy(updatePolicy),
+    decayPolicy(decayPolicy),
+    resetPolicy(resetPolicy),
+    communicator(communicator)
+{ /* Nothing to do. */ }
+
+//! Optimize the function (minimize).
+template<typename UpdatePolicyType,
+         typename DecayPolicyType,
+         typename CommunicatorType>
+template<typename DecomposableFunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename MatType::elem_type
+EASGD<UpdatePolicyType, DecayPolicyType, CommunicatorType>::Optimize(
+    DecomposableFunctionType& function,
+    MatType& iterateIn,
+    CallbackTypes&&... callbacks)
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+  typedef typename UpdatePolicyType::template Policy<BaseMatType, BaseGradType>
+      InstUpdatePolicyType;
+
+  typedef Function<DecomposableFunctionType, BaseMatType, BaseGradType>
+      FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  // Make sure we have all the methods that we need.
+  traits::CheckDecomposableFunctionTypeAPI<FullFunctionType, BaseMatType,
+      BaseGradType>();
+
+  // Vectors are optimized as matrices.  The iterate is the center variable.
+  BaseMatType& iterate = static_cast<BaseMatType&>(iterateIn);
+
+  if (communicationPeriod == 0)
+  {
+    throw std::invalid_argument("EASGD::Optimize(): communicationPeriod must "
+        "be positive!");
+  }
+
+  if (!(movingRate > 0.0 && movingRate <= 1.0))
+  {
+    throw std::invalid_argument("EASGD::Optimize(): movingRate must be in "
+        "(0, 1]!");
+  }
+
+  // Only the first process reports progress.
+  const size_t ranks = communicator.Size();
+  const bool root = (communicator.Rank() == 0);
+
+  size_t numWorkers = workers;
+  if (numWorkers == 0)
+  {
+    numWorkers = 1;
+    #ifdef ENS_USE_OPENMP
+      numWorkers = omp_get_max_threads();
+    #endif
+  }
+
+  // Each worker visits a contiguous range of the functions.
+  const size_t numFunctions = f.NumFunctions();
+  std::vector<size_t> bounds(numWorkers + 1);
+  for (size_t w = 0; w <= numWorkers; ++w)
+    bounds[w] = w * numFunctions / numWorkers;
+
+  // The number of steps in an epoch is the number of batches of the largest
+  // range over all the processes, and the maximum is taken after the sum as in
+  // DistributedSGD.  The last entry counts the workers of all the processes,
+  // which sets the elastic coefficient.
+  const size_t largestRange = (numFunctions + numWorkers - 1) / numWorkers;
+  arma::vec counts(ranks + 1, arma::fill::zeros);
+  counts[communicator.Rank()] = (largestRange + batchSize - 1) / batchSize;
+  counts[ranks] = numWorkers;
+  communicator.AllReduce(counts.memptr(), counts.n_elem);
+  const size_t stepsPerEpoch = size_t(arma::max(counts.head(ranks)));
+  const ElemType alpha = ElemType(movingRate / counts[ranks]);
+  if (stepsPerEpoch == 0)
+  {
+    throw std::invalid_argument("EASGD::Optimize(): there are no functions "
+        "to optimize!");
+  }
+
+  // All the processes start from the same point.
+  communicator.Broadcast(iterate.memptr(), iterate.n_elem, 0);
+
+  // Initialize the update policies of the workers.  If the previous call used
+  // a different matrix type or number of workers, the policies have to be
+  // reinitialized anyway.
+  typedef std::vector<InstUpdatePolicyType> InstUpdatePoliciesType;
+  if (resetPolicy || !instUpdatePolicies.Has<InstUpdatePoliciesType>() ||
+      instUpdatePolicies.As<InstUpdatePoliciesType>().size() != numWorkers)
+  {
+    instUpdatePolicies.Set(new InstUpdatePoliciesType(numWorkers,
+        InstUpdatePolicyType(updatePolicy, iterate.n_rows, iterate.n_cols)));
+  }
+  InstUpdatePoliciesType& instPolicies =
+      instUpdatePolicies.As<InstUpdatePoliciesType>();
+
+  // Each worker has its own model, which starts at the center and persists
+  // between communications, its own elastic difference with the center, and
+  // its own gradient, step size and decay policy.
+  std::vector<BaseMatType> models(numWorkers, iterate);
+  std::vector<BaseMatType> differences(numWorkers);
+  std::vector<BaseGradType> gradients(numWorkers,
+      BaseGradType(iterate.n_rows, iterate.n_cols));
+  std::vector<double> stepSizes(numWorkers, stepSize);
+  std::vector<DecayPolicyType> decayPolicies(numWorkers, decayPolicy);
+  std::vector<size_t> positions(bounds.begin(), bounds.end() - 1);
+  std::vector<ElemType> objectives(numWorkers);
+  std::vector<size_t> visited(numWorkers);
+
+  // To keep track of where we are and how things are going.
+  size_t epochStep = 0;
+  ElemType overallObjective = 0;
+  ElemType lastObjective = std::numeric_limits<ElemType>::max();
+
+  // Track the current epoch and whether a callback asked us to stop.  As in
+  // DistributedSGD, a request is only acted on once all the processes know
+  // about it.
+  size_t epoch = 0;
+  bool terminate = false;
+  bool requested = false;
+  requested |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
+
+  // The sum of the elastic differences is sent with the objective, the number
+  // of functions visited and the termination requests.
+  const size_t n = iterate.n_elem;
+  arma::Col<ElemType> message(n + 3);
+
+  // Now iterate!
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+  for (size_t i = 0; i < actualMaxIterations && !terminate;
+      /* incrementing done manually */)
+  {
+    // Is this round the start of a sequence?
+    if (epochStep == stepsPerEpoch)
+    {
+      // Output current objective function.
+      if (root)
+      {
+        Info << "EASGD: iteration " << i << ", objective "
+            << overallObjective << ".\n";
+      }
+
+      requested |= Callback::EndEpoch(*this, f, iterate, epoch++,
+          overallObjective, callbacks...);
+
+      if (std::isnan(overallObjective) || std::isinf(overallObjective))
+      {
+        if (root)
+        {
+          Warn << "EASGD: converged to " << overallObjective << "; "
+              << "terminating with failure.  Try a smaller step size?"
+              << std::endl;
+        }
+        Callback::EndOptimization(*this, f, iterate, callbacks...);
+        return overallObjective;
+      }
+
+      if (std::abs(lastObjective - overallObjective) < tolerance)
+      {
+        if (root)
+        {
+          Info << "EASGD: minimized within tolerance " << tolerance
+              << "; terminating optimization." << std::endl;
+        }
+        Callback::EndOptimization(*this, f, iterate, callbacks...);
+        return overallObjective;
+      }
+
+      // Reset the counter variables.
+      lastObjective = overallObjective;
+      overallObjective = 0;
+      epochStep = 0;
+      std::copy(bounds.begin(), bounds.end() - 1, positions.begin());
+
+      if (shuffle) // Determine order of visitation.
+        f.Shuffle();
+
+      requested |= Callback::BeginEpoch(*this, f, iterate, epoch,
+          lastObjective, callbacks...);
+    }
+
+    // The round ends at the end of the epoch, and each worker may visit at
+    // most its share of the iterations left before actualMaxIterations is
+    // hit.
+    const size_t roundSteps = std::min(communicationPeriod,
+        stepsPerEpoch - epochStep);
+    const size_t iterationsLeft = actualMaxIterations - i;
+    const size_t share = iterationsLeft / (numWorkers * ranks) +
+        ((iterationsLeft % (numWorkers * ranks) == 0) ? 0 : 1);
+
+    // Let every worker take its steps from its own model, and then compute
+    // its elastic difference with the center.
+    #ifdef ENS_USE_OPENMP
+      #pragma omp parallel for schedule(static, 1) num_threads(numWorkers)
+    #endif
+    for (size_t w = 0; w < numWorkers; ++w)
+    {
+      objectives[w] = 0;
+      visited[w] = 0;
+      for (size_t s = 0; s < roundSteps; ++s)
+      {
+        const size_t effectiveBatchSize = std::min(std::min(batchSize,
+            share - visited[w]), bounds[w + 1] - positions[w]);
+        if (effectiveBatchSize == 0)
+          break;
+
+        objectives[w] += f.EvaluateWithGradient(models[w], positions[w],
+            gradients[w], effectiveBatchSize);
+        instPolicies[w].Update(models[w], stepSizes[w], gradients[w]);
+        decayPolicies[w].Update(models[w], stepSizes[w], gradients[w]);
+
+        positions[w] += effectiveBatchSize;
+        visited[w] += effectiveBatchSize;
+      }
+
+      differences[w] = alpha * (models[w] - iterate);
+      models[w] -= differences[w];
+    }
+
+    // Move the center by the sum of the elastic differences of all the
+    // workers of all the processes.
+    message.zeros();
+    for (size_t w = 0; w < numWorkers; ++w)
+    {
+      message.head(n) += arma::vectorise(differences[w]);
+      message[n] += objectives[w];
+      message[n + 1] += ElemType(visited[w]);
+    }
+    message[n + 2] = requested ? 1 : 0;
+    communicator.AllReduce(message.memptr(), message.n_elem);
+    iterate += arma::reshape(message.head(n), iterate.n_rows, iterate.n_cols);
+    terminate = (message[n + 2] > 0);
+
+    overallObjective += message[n];
+    i += size_t(message[n + 1] + 0.5);
+    epochStep += roundSteps;
+
+    requested |= Callback::StepTaken(*this, f, iterate, callbacks...);
+  }
+
+  if (root)
+  {
+    if (terminate)
+    {
+      Info << "EASGD: callback requested termination." << std::endl;
+    }
+    else
+    {
+      Info << "EASGD: maximum iterations (" << maxIterations << ") "
+          << "reached; terminating optimization." << std::endl;
+    }
+  }
+
+  // Calculate final objective at the center, over all the processes.
+  overallObjective = 0;
+  for (size_t i = 0; i < numFunctions; i += batchSize)
+  {
+    const size_t effectiveBatchSize = std::min(batchSize, numFunctions - i);
+    overallObjective += f.Evaluate(iterate, i, effectiveBatchSize);
+  }
+  communicator.AllReduce(&overallObjective, 1);
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+  return overallObjective;
+}
+
+} // namespace ens
+
+#endif
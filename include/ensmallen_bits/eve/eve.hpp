@@ -147,6 +147,12 @@ class Eve
   //! Modify whether or not the individual functions are shuffled.
   bool& Shuffle() { return shuffle; }
 
+  //! Get how the final objective is computed.
+  const ens::ObjectiveEstimate& ObjectiveEstimate() const
+  { return objectiveEstimate; }
+  //! Modify how the final objective is computed.
+  ens::ObjectiveEstimate& ObjectiveEstimate() { return objectiveEstimate; }
+
  private:
   //! The step size for each example.
   double stepSize;
@@ -178,6 +184,9 @@ class Eve
   //! Controls whether or not the individual functions are shuffled when
   //! iterating.
   bool shuffle;
+
+  //! How the final objective is computed.
+  ens::ObjectiveEstimate objectiveEstimate;
 };
 
 } // namespace ens
@@ -83,7 +83,7 @@ double Eve::Optimize(
     {
       // Output current objective function.
       Info << "Eve: iteration " << i << ", objective " << overallObjective
-          << "." << std::endl;
+          << ".\n";
 
       if (std::isnan(overallObjective) || std::isinf(overallObjective))
       {
@@ -154,13 +154,13 @@ double Eve::Optimize(
   Info << "Eve: maximum iterations (" << maxIterations << ") reached; "
       << "terminating optimization." << std::endl;
 
-  // Calculate final objective.
-  overallObjective = 0;
-  for (size_t i = 0; i < numFunctions; i += batchSize)
-  {
-    const size_t effectiveBatchSize = std::min(batchSize, numFunctions - i);
-    overallObjective += f.Evaluate(iterate, i, effectiveBatchSize);
-  }
+  // Calculate final objective.  When reusing the batch objectives of the last
+  // pass, scale them up to all the functions if the pass is not complete.
+  if (!objectiveEstimate.IsReuse())
+    overallObjective = objectiveEstimate.Evaluate(f, iterate, batchSize);
+  else if (currentFunction > 0 && currentFunction < numFunctions)
+    overallObjective *= (double) numFunctions / currentFunction;
+
   return overallObjective;
 }
 
@@ -0,0 +1,60 @@
+/**
+ * @file extern_templates.hpp
+ *
+ * Explicit instantiations of the most common optimizer and update policy
+ * classes.  When ENS_USE_EXTERN_TEMPLATES is defined, they are declared extern,
+ * so that a program linked with the compiled ensmallen library (the optional
+ * `ensmallen` CMake target) does not instantiate them again in every
+ * translation unit.  The library itself is built with
+ * ENS_INSTANTIATE_TEMPLATES, which turns the declarations into definitions.
+ *
+ * Only the optimizer classes can be instantiated ahead of time: Optimize()
+ * depends on the type of the function, so it is still instantiated where it is
+ * called.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_EXTERN_TEMPLATES_HPP
+#define ENSMALLEN_EXTERN_TEMPLATES_HPP
+
+#if defined(ENS_INSTANTIATE_TEMPLATES)
+  #define ENS_EXTERN_TEMPLATE template
+#else
+  #define ENS_EXTERN_TEMPLATE extern template
+#endif
+
+// The update policies of the SGD-based optimizers, for the given matrix type.
+#define ENS_EXTERN_POLICIES(MatType) \
+  ENS_EXTERN_TEMPLATE class ens::VanillaUpdate::Policy<MatType, MatType>; \
+  ENS_EXTERN_TEMPLATE class ens::MomentumUpdate::Policy<MatType, MatType>; \
+  ENS_EXTERN_TEMPLATE class \
+      ens::NesterovMomentumUpdate::Policy<MatType, MatType>; \
+  ENS_EXTERN_TEMPLATE class ens::AdamUpdate::Policy<MatType, MatType>; \
+  ENS_EXTERN_TEMPLATE class ens::AdaMaxUpdate::Policy<MatType, MatType>; \
+  ENS_EXTERN_TEMPLATE class ens::AMSGradUpdate::Policy<MatType, MatType>; \
+  ENS_EXTERN_TEMPLATE class ens::NadamUpdate::Policy<MatType, MatType>;
+
+ENS_EXTERN_POLICIES(arma::mat)
+ENS_EXTERN_POLICIES(arma::fmat)
+
+#undef ENS_EXTERN_POLICIES
+
+// The optimizers themselves do not depend on the matrix type.
+ENS_EXTERN_TEMPLATE class ens::SGD<ens::VanillaUpdate>;
+ENS_EXTERN_TEMPLATE class ens::SGD<ens::MomentumUpdate>;
+ENS_EXTERN_TEMPLATE class ens::SGD<ens::NesterovMomentumUpdate>;
+ENS_EXTERN_TEMPLATE class ens::SGD<ens::AdamUpdate>;
+ENS_EXTERN_TEMPLATE class ens::SGD<ens::AdaMaxUpdate>;
+ENS_EXTERN_TEMPLATE class ens::SGD<ens::AMSGradUpdate>;
+ENS_EXTERN_TEMPLATE class ens::SGD<ens::NadamUpdate>;
+ENS_EXTERN_TEMPLATE class ens::AdamType<ens::AdamUpdate>;
+ENS_EXTERN_TEMPLATE class ens::AdamType<ens::AdaMaxUpdate>;
+ENS_EXTERN_TEMPLATE class ens::AdamType<ens::AMSGradUpdate>;
+ENS_EXTERN_TEMPLATE class ens::AdamType<ens::NadamUpdate>;
+
+#undef ENS_EXTERN_TEMPLATE
+
+#endif
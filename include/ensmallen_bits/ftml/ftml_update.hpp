@@ -51,55 +51,9 @@ class FTMLUpdate
              const double beta2 = 0.999) :
       epsilon(epsilon),
       beta1(beta1),
-      beta2(beta2),
-      iteration(0)
+      beta2(beta2)
   { /* Do nothing. */ }
 
-  /**
-   * The Initialize method is called by SGD::Optimize method with UpdatePolicy
-   * FTMLUpdate before the start of the iteration update process.
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
-   */
-  void Initialize(const size_t rows, const size_t cols)
-  {
-    v = arma::zeros<arma::mat>(rows, cols);
-    z = arma::zeros<arma::mat>(rows, cols);
-    d = arma::zeros<arma::mat>(rows, cols);
-  }
-
-  /**
-   * Update step for FTML.
-   *
-   * @param iterate Parameter that minimizes the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
-   */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
-  {
-    // Increment the iteration counter variable.
-    ++iteration;
-
-    // And update the iterate.
-    v *= beta2;
-    v += (1 - beta2) * (gradient % gradient);
-
-    const double biasCorrection1 = 1.0 - std::pow(beta1, iteration);
-    const double biasCorrection2 = 1.0 - std::pow(beta2, iteration);
-
-    arma::mat sigma = -beta1 * d;
-    d = biasCorrection1 / stepSize *
-      (arma::sqrt(v / biasCorrection2) + epsilon);
-    sigma += d;
-
-    z *= beta1;
-    z += (1 - beta1) * gradient - sigma % iterate;
-    iterate = -z / d;
-  }
-
   //! Get the value used to initialise the squared gradient parameter.
   double Epsilon() const { return epsilon; }
   //! Modify the value used to initialise the squared gradient parameter.
@@ -115,6 +69,140 @@ class FTMLUpdate
   //! Modify the second moment coefficient.
   double& Beta2() { return beta2; }
 
+  //! Get the number of bytes of the state (v, z and d) for an iterate of the
+  //! given size.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
+  {
+    return 3 * rows * cols * elemSize;
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by SGD::Optimize() with UpdatePolicy FTMLUpdate before the
+     * start of the iteration update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const FTMLUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        v(arma::zeros<MatType>(rows, cols)),
+        z(arma::zeros<MatType>(rows, cols)),
+        d(arma::zeros<MatType>(rows, cols)),
+        iteration(0)
+    {
+      // Nothing to do.
+    }
+
+    /**
+     * Update step for FTML.
+     *
+     * @param iterate Parameter that minimizes the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      // Increment the iteration counter variable.
+      ++iteration;
+
+      const double biasCorrection1 = 1.0 - std::pow(parent.beta1, iteration);
+      const double biasCorrection2 = 1.0 - std::pow(parent.beta2, iteration);
+
+      // And update the iterate.
+      Step(iterate, stepSize, gradient, biasCorrection1, biasCorrection2,
+          IsFusableUpdate<MatType, GradType>());
+    }
+
+   private:
+    //! Update the averages and the iterate in a single loop.
+    void Step(MatType& iterate,
+              const double stepSize,
+              const GradType& gradient,
+              const double biasCorrection1,
+              const double biasCorrection2,
+              std::true_type /* fusable */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType beta1 = parent.beta1;
+      const ElemType beta2 = parent.beta2;
+      const ElemType epsilon = parent.epsilon;
+      const ElemType scale = biasCorrection1 / stepSize;
+      const ElemType vBias = biasCorrection2;
+
+      ElemType* x = iterate.memptr();
+      ElemType* vPtr = v.memptr();
+      ElemType* zPtr = z.memptr();
+      ElemType* dPtr = d.memptr();
+      const ElemType* g = gradient.memptr();
+
+      const size_t n = iterate.n_elem;
+      ENS_PRAGMA_OMP_SIMD
+      for (size_t i = 0; i < n; ++i)
+      {
+        vPtr[i] = beta2 * vPtr[i] + (1 - beta2) * (g[i] * g[i]);
+
+        const ElemType dNew = scale * (std::sqrt(vPtr[i] / vBias) + epsilon);
+        const ElemType sigma = dNew - beta1 * dPtr[i];
+        dPtr[i] = dNew;
+
+        zPtr[i] = beta1 * zPtr[i] + (1 - beta1) * g[i] - sigma * x[i];
+        x[i] = -zPtr[i] / dNew;
+      }
+    }
+
+    //! Update the averages and the iterate with Armadillo expressions.
+    void Step(MatType& iterate,
+              const double stepSize,
+              const GradType& gradient,
+              const double biasCorrection1,
+              const double biasCorrection2,
+              std::false_type /* fusable */)
+    {
+      v *= parent.beta2;
+      v += (1 - parent.beta2) * (gradient % gradient);
+
+      MatType sigma = -parent.beta1 * d;
+      d = biasCorrection1 / stepSize *
+        (arma::sqrt(v / biasCorrection2) + parent.epsilon);
+      sigma += d;
+
+      z *= parent.beta1;
+      z += (1 - parent.beta1) * gradient - sigma % iterate;
+      iterate = -z / d;
+    }
+
+    // Instantiated parent object.
+    const FTMLUpdate& parent;
+
+    // The exponential moving average of gradient values.
+    MatType v;
+
+    // The exponential moving average of squared gradient values.
+    MatType z;
+
+    // Parmeter update term.
+    MatType d;
+
+    // The number of iterations.
+    double iteration;
+  };
+
  private:
   // The epsilon value used to initialise the squared gradient parameter.
   double epsilon;
@@ -124,18 +212,6 @@ class FTMLUpdate
 
   // The second moment coefficient.
   double beta2;
-
-  // The exponential moving average of gradient values.
-  arma::mat v;
-
-  // The exponential moving average of squared gradient values.
-  arma::mat z;
-
-  // Parmeter update term.
-  arma::mat d;
-
-  // The number of iterations.
-  double iteration;
 };
 
 } // namespace ens
@@ -0,0 +1,139 @@
+/**
+ * @file add_batch_evaluate.hpp
+ *
+ * This file defines a mixin for the Function class that will ensure that a
+ * batch Evaluate(), which evaluates many points at once, is available.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_ADD_BATCH_EVALUATE_HPP
+#define ENSMALLEN_FUNCTION_ADD_BATCH_EVALUATE_HPP
+
+#include "traits.hpp"
+#include "evaluate_async.hpp"
+
+namespace ens {
+
+/**
+ * The AddBatchEvaluate mixin class will provide a batch Evaluate() method,
+ * which evaluates every slice of a cube of points.  If the given FunctionType has a
+ * batch Evaluate() (for instance because it can evaluate a whole population
+ * with a single matrix multiplication), it is used.  Otherwise, if it has an
+ * EvaluateAsync() method, all the evaluations are started before they are
+ * collected (see EvaluateInFlight()); if not, the points are evaluated one at
+ * a time with Evaluate().
+ */
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         bool HasBatchEvaluate =
+             traits::HasEvaluate<FunctionType,
+                 traits::TypedForms<MatType, GradType>::template
+                     BatchEvaluateForm>::value,
+         bool HasBatchEvaluateConst =
+             traits::HasEvaluate<FunctionType,
+                 traits::TypedForms<MatType, GradType>::template
+                     BatchEvaluateConstForm>::value,
+         bool HasBatchEvaluateStatic =
+             traits::HasEvaluate<FunctionType,
+                 traits::TypedForms<MatType, GradType>::template
+                     BatchEvaluateStaticForm>::value>
+class AddBatchEvaluate
+{
+ public:
+  /**
+   * Evaluate the objective function at every slice of the given cube.
+   *
+   * @param points Points to evaluate the function at (one per slice).
+   * @param objectives Vector to store the objective of each point in.
+   */
+  void Evaluate(const arma::Cube<typename MatType::elem_type>& points,
+                arma::Col<typename MatType::elem_type>& objectives)
+  {
+    objectives.set_size(points.n_slices);
+    FunctionType& function = static_cast<FunctionType&>(
+        *static_cast<Function<FunctionType, MatType, GradType>*>(this));
+    const bool evaluated = TryEvaluateInFlight(function, points.n_slices,
+        [&](const size_t i) -> const arma::Mat<typename MatType::elem_type>&
+        {
+          return points.slice(i);
+        },
+        [&](const size_t i, const typename MatType::elem_type objective)
+        {
+          objectives[i] = objective;
+        });
+    if (evaluated)
+      return;
+
+    for (size_t i = 0; i < points.n_slices; ++i)
+    {
+      objectives[i] = static_cast<Function<FunctionType, MatType, GradType>*>(
+          this)->Evaluate(points.slice(i));
+    }
+  }
+};
+
+/**
+ * Reflect the existing batch Evaluate().
+ */
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         bool HasBatchEvaluateConst,
+         bool HasBatchEvaluateStatic>
+class AddBatchEvaluate<FunctionType, MatType, GradType, true,
+    HasBatchEvaluateConst, HasBatchEvaluateStatic>
+{
+ public:
+  // Reflect the existing batch Evaluate().
+  void Evaluate(const arma::Cube<typename MatType::elem_type>& points,
+                arma::Col<typename MatType::elem_type>& objectives)
+  {
+    static_cast<FunctionType*>(
+        static_cast<Function<FunctionType, MatType, GradType>*>(this))->
+        Evaluate(points, objectives);
+  }
+};
+
+/**
+ * Reflect the existing const batch Evaluate().
+ */
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         bool HasBatchEvaluateStatic>
+class AddBatchEvaluate<FunctionType, MatType, GradType, false, true,
+    HasBatchEvaluateStatic>
+{
+ public:
+  // Reflect the existing const batch Evaluate().
+  void Evaluate(const arma::Cube<typename MatType::elem_type>& points,
+                arma::Col<typename MatType::elem_type>& objectives)
+  {
+    static_cast<const FunctionType*>(
+        static_cast<Function<FunctionType, MatType, GradType>*>(this))->
+        Evaluate(points, objectives);
+  }
+};
+
+/**
+ * Reflect the existing static batch Evaluate().
+ */
+template<typename FunctionType, typename MatType, typename GradType>
+class AddBatchEvaluate<FunctionType, MatType, GradType, false, false, true>
+{
+ public:
+  // Reflect the existing static batch Evaluate().
+  void Evaluate(const arma::Cube<typename MatType::elem_type>& points,
+                arma::Col<typename MatType::elem_type>& objectives)
+  {
+    FunctionType::Evaluate(points, objectives);
+  }
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,77 @@
+/**
+ * @file block_partial_gradient.hpp
+ *
+ * Utility that computes the dense partial gradient of a partially
+ * differentiable function with respect to a block of consecutive features.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_BLOCK_PARTIAL_GRADIENT_HPP
+#define ENSMALLEN_FUNCTION_BLOCK_PARTIAL_GRADIENT_HPP
+
+#include <type_traits>
+
+namespace ens {
+
+/**
+ * Compute the partial gradient of the function with respect to the features
+ * begin, ..., begin + blockSize - 1 (the columns of the coordinates) into a
+ * dense matrix with blockSize columns.  This version is used when the function
+ * implements
+ *
+ * @code
+ * void PartialGradient(const arma::mat& coordinates,
+ *                      const size_t begin,
+ *                      arma::mat& gradient,
+ *                      const size_t blockSize);
+ * @endcode
+ *
+ * (possibly const), which can share the work between the features of the
+ * block.
+ *
+ * @param function Partially differentiable function.
+ * @param coordinates The point at which to compute the gradient.
+ * @param begin The first feature of the block.
+ * @param gradient Matrix to store the gradient of the block into.
+ * @param blockSize The number of features in the block.
+ */
+template<typename FunctionType>
+typename std::enable_if<traits::HasBlockPartialGradient<FunctionType>::value>::
+    type
+BlockPartialGradient(FunctionType& function,
+                     const arma::mat& coordinates,
+                     const size_t begin,
+                     arma::mat& gradient,
+                     const size_t blockSize)
+{
+  function.PartialGradient(coordinates, begin, gradient, blockSize);
+}
+
+//! Without a block PartialGradient() method, the partial gradient of each
+//! feature of the block is computed on its own (from PartialDerivative(), if
+//! the function has it).
+template<typename FunctionType>
+typename std::enable_if<!traits::HasBlockPartialGradient<FunctionType>::value>::
+    type
+BlockPartialGradient(FunctionType& function,
+                     const arma::mat& coordinates,
+                     const size_t begin,
+                     arma::mat& gradient,
+                     const size_t blockSize)
+{
+  gradient.set_size(coordinates.n_rows, blockSize);
+  arma::vec featureGradient;
+  arma::sp_mat buffer;
+  for (size_t k = 0; k < blockSize; ++k)
+  {
+    FeatureGradient(function, coordinates, begin + k, featureGradient, buffer);
+    gradient.col(k) = featureGradient;
+  }
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,246 @@
+/**
+ * @file cached_function.hpp
+ *
+ * Adapter for differentiable functions that remembers the objective and the
+ * gradient at the last point, so that repeated queries at the same point are
+ * not recomputed.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_CACHED_FUNCTION_HPP
+#define ENSMALLEN_FUNCTION_CACHED_FUNCTION_HPP
+
+#include <algorithm>
+
+namespace ens {
+
+/**
+ * CachedFunction wraps a differentiable function and memoizes the last
+ * (point, objective, gradient) triple.  Optimizers often ask for the objective
+ * and the gradient at the same point in separate calls (a line search that
+ * calls Evaluate() and then Gradient() at the accepted point, or an optimizer
+ * that checks the objective at the point it has just computed the gradient
+ * of); with the wrapper, the second call is served from the cache.  Missing
+ * methods of the wrapped function are filled in by the Function<> wrapper, so
+ * if only EvaluateWithGradient() is implemented, Evaluate() followed by
+ * Gradient() costs one call to it.
+ *
+ * @code
+ * RosenbrockFunction f;
+ * CachedFunction<RosenbrockFunction> cachedF(f, true);
+ *
+ * L_BFGS lbfgs;
+ * arma::mat coordinates = f.GetInitialPoint();
+ * lbfgs.Optimize(cachedF, coordinates);
+ * @endcode
+ *
+ * A cached value is used only when the point is exactly (elementwise) equal to
+ * the cached point; comparing the points costs one pass over the coordinates.
+ * If gradientOnEvaluate is true, an Evaluate() call at a new point computes the
+ * gradient as well (with EvaluateWithGradient()), which is worthwhile when the
+ * gradient is usually requested next and EvaluateWithGradient() costs about as
+ * much as Evaluate().
+ *
+ * The wrapped function must not change between calls (if it does, for
+ * instance because a parameter of the problem was modified, call Reset()).
+ * The wrapper is not safe to use from several threads at once.
+ *
+ * @tparam FunctionType Type of the differentiable function to wrap.
+ * @tparam MatType Type of the coordinates.
+ * @tparam GradType Type of the gradient.
+ */
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType>
+class CachedFunction
+{
+ public:
+  //! The type of the objective.
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Wrap the given function.  The function is held by reference, so it must
+   * outlive the wrapper.
+   *
+   * @param function Differentiable function to wrap.
+   * @param gradientOnEvaluate Whether Evaluate() at a new point also computes
+   *     the gradient.
+   */
+  CachedFunction(FunctionType& function,
+                 const bool gradientOnEvaluate = false) :
+      function(function),
+      gradientOnEvaluate(gradientOnEvaluate),
+      objective(0),
+      hasObjective(false),
+      hasGradient(false),
+      hits(0),
+      misses(0)
+  { /* Nothing to do. */ }
+
+  /**
+   * Return the objective at the given coordinates.
+   *
+   * @param coordinates The point to evaluate the objective at.
+   */
+  ElemType Evaluate(const MatType& coordinates)
+  {
+    const bool matches = Matches(coordinates);
+    if (matches && hasObjective)
+    {
+      ++hits;
+      return objective;
+    }
+
+    ++misses;
+    if (gradientOnEvaluate && !(matches && hasGradient))
+    {
+      Store(coordinates);
+      objective = Full().EvaluateWithGradient(coordinates, gradient);
+      hasGradient = true;
+    }
+    else
+    {
+      // Keep the gradient if it is for the same point.
+      hasGradient = matches && hasGradient;
+      Store(coordinates);
+      objective = Full().Evaluate(coordinates);
+    }
+
+    hasObjective = true;
+    return objective;
+  }
+
+  /**
+   * Compute the gradient at the given coordinates.
+   *
+   * @param coordinates The point to compute the gradient at.
+   * @param gradientOut Matrix to store the gradient in.
+   */
+  void Gradient(const MatType& coordinates, GradType& gradientOut)
+  {
+    if (hasGradient && Matches(coordinates))
+    {
+      ++hits;
+      gradientOut = gradient;
+      return;
+    }
+
+    ++misses;
+    if (!hasObjective || !Matches(coordinates))
+    {
+      Store(coordinates);
+      hasObjective = false;
+    }
+
+    Full().Gradient(coordinates, gradient);
+    hasGradient = true;
+    gradientOut = gradient;
+  }
+
+  /**
+   * Return the objective and compute the gradient at the given coordinates.
+   *
+   * @param coordinates The point to evaluate at.
+   * @param gradientOut Matrix to store the gradient in.
+   */
+  ElemType EvaluateWithGradient(const MatType& coordinates,
+                                GradType& gradientOut)
+  {
+    const bool matches = Matches(coordinates);
+    if (matches && hasObjective && hasGradient)
+    {
+      ++hits;
+      gradientOut = gradient;
+      return objective;
+    }
+
+    ++misses;
+    if (matches && hasObjective)
+    {
+      // Only the gradient is missing.
+      Full().Gradient(coordinates, gradient);
+    }
+    else if (matches && hasGradient)
+    {
+      // Only the objective is missing.
+      objective = Full().Evaluate(coordinates);
+    }
+    else
+    {
+      Store(coordinates);
+      objective = Full().EvaluateWithGradient(coordinates, gradient);
+    }
+
+    hasObjective = true;
+    hasGradient = true;
+    gradientOut = gradient;
+    return objective;
+  }
+
+  //! Forget the cached point.
+  void Reset()
+  {
+    hasObjective = false;
+    hasGradient = false;
+    point.reset();
+  }
+
+  //! Get the number of queries that were served from the cache.
+  size_t Hits() const { return hits; }
+  //! Get the number of queries that called the wrapped function.
+  size_t Misses() const { return misses; }
+
+  //! Get whether Evaluate() at a new point also computes the gradient.
+  bool GradientOnEvaluate() const { return gradientOnEvaluate; }
+  //! Modify whether Evaluate() at a new point also computes the gradient.
+  bool& GradientOnEvaluate() { return gradientOnEvaluate; }
+
+  //! Get the wrapped function.
+  FunctionType& WrappedFunction() { return function; }
+
+ private:
+  //! Get the wrapped function with its missing methods filled in.
+  Function<FunctionType, MatType, GradType>& Full()
+  {
+    return static_cast<Function<FunctionType, MatType, GradType>&>(function);
+  }
+
+  //! Return whether the given coordinates are the cached point.
+  bool Matches(const MatType& coordinates) const
+  {
+    return coordinates.n_rows == point.n_rows &&
+        coordinates.n_cols == point.n_cols &&
+        std::equal(coordinates.begin(), coordinates.end(), point.begin());
+  }
+
+  //! Make the given coordinates the cached point.
+  void Store(const MatType& coordinates) { point = coordinates; }
+
+  //! The wrapped function.
+  FunctionType& function;
+  //! Whether Evaluate() at a new point also computes the gradient.
+  bool gradientOnEvaluate;
+
+  //! The cached point.
+  MatType point;
+  //! The objective at the cached point (if hasObjective).
+  ElemType objective;
+  //! The gradient at the cached point (if hasGradient).
+  GradType gradient;
+  //! Whether the objective at the cached point is known.
+  bool hasObjective;
+  //! Whether the gradient at the cached point is known.
+  bool hasGradient;
+
+  //! The number of queries served from the cache.
+  size_t hits;
+  //! The number of queries that called the wrapped function.
+  size_t misses;
+};
+
+} // namespace ens
+
+#endif
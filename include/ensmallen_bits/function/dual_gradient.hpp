@@ -0,0 +1,79 @@
+/**
+ * @file dual_gradient.hpp
+ *
+ * Utility that computes the gradients of one batch of a separable function at
+ * two points, as needed by the inner loops of the variance-reduced optimizers
+ * (SVRG, SARAH, Katyusha).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_DUAL_GRADIENT_HPP
+#define ENSMALLEN_FUNCTION_DUAL_GRADIENT_HPP
+
+#include <type_traits>
+
+namespace ens {
+
+/**
+ * Compute the gradients of the functions in the given batch at two points.
+ * This version is used when the function implements
+ *
+ * @code
+ * void DualGradient(const MatType& coordinates,
+ *                   const MatType& coordinates2,
+ *                   const size_t begin,
+ *                   GradType& gradient,
+ *                   GradType& gradient2,
+ *                   const size_t batchSize);
+ * @endcode
+ *
+ * (possibly const), which can compute both gradients in a single pass over the
+ * data of the batch.  Otherwise, the separable Gradient() is called once for
+ * each point.
+ *
+ * @param function Separable function to differentiate.
+ * @param coordinates The first point.
+ * @param coordinates2 The second point.
+ * @param begin The first function in the batch.
+ * @param gradient Matrix to store the gradient at the first point in.
+ * @param gradient2 Matrix to store the gradient at the second point in.
+ * @param batchSize The number of functions in the batch.
+ */
+template<typename FunctionType, typename MatType, typename GradType>
+typename std::enable_if<
+    traits::HasDualBatchGradient<FunctionType, MatType, GradType>::value>::type
+DualBatchGradient(FunctionType& function,
+                  const MatType& coordinates,
+                  const MatType& coordinates2,
+                  const size_t begin,
+                  GradType& gradient,
+                  GradType& gradient2,
+                  const size_t batchSize)
+{
+  function.DualGradient(coordinates, coordinates2, begin, gradient, gradient2,
+      batchSize);
+}
+
+//! Compute the gradients of the functions in the given batch at two points,
+//! with one call to the separable Gradient() for each point.
+template<typename FunctionType, typename MatType, typename GradType>
+typename std::enable_if<
+    !traits::HasDualBatchGradient<FunctionType, MatType, GradType>::value>::type
+DualBatchGradient(FunctionType& function,
+                  const MatType& coordinates,
+                  const MatType& coordinates2,
+                  const size_t begin,
+                  GradType& gradient,
+                  GradType& gradient2,
+                  const size_t batchSize)
+{
+  function.Gradient(coordinates, begin, gradient, batchSize);
+  function.Gradient(coordinates2, begin, gradient2, batchSize);
+}
+
+} // namespace ens
+
+#endif
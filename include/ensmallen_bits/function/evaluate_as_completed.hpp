@@ -0,0 +1,272 @@
+/**
+ * @file evaluate_as_completed.hpp
+ *
+ * Evaluation of a stream of proposed points of a function on worker threads,
+ * handing back each objective as soon as its evaluation completes.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_EVALUATE_AS_COMPLETED_HPP
+#define ENSMALLEN_FUNCTION_EVALUATE_AS_COMPLETED_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "traits.hpp"
+
+namespace ens {
+
+/**
+ * The pool of worker threads behind EvaluateAsCompleted().  Each evaluation in
+ * flight has a slot holding its point; the calling thread fills the slots and
+ * the workers compute their objectives, with Evaluate(), or by waiting for the
+ * future returned by EvaluateAsync() if the function has it.
+ */
+template<typename FunctionType>
+class AsCompletedEvaluator
+{
+ public:
+  /**
+   * Start the given number of worker threads.
+   *
+   * @param function Function to evaluate.
+   * @param numWorkers Number of worker threads, which is the maximum number of
+   *     evaluations in flight.
+   */
+  AsCompletedEvaluator(FunctionType& function, const size_t numWorkers) :
+      function(function),
+      slots(numWorkers),
+      shutdown(false)
+  {
+    workers.reserve(numWorkers);
+    for (size_t i = 0; i < numWorkers; ++i)
+      workers.emplace_back([this]() { Work(); });
+  }
+
+  //! Stop the worker threads, once their current evaluations are done.
+  ~AsCompletedEvaluator()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      shutdown = true;
+    }
+    pendingCondition.notify_all();
+    for (std::thread& worker : workers)
+      worker.join();
+  }
+
+  /**
+   * Evaluate numEvaluations proposed points; see EvaluateAsCompleted().
+   */
+  template<typename ProposeFunctionType, typename CompleteFunctionType>
+  void Run(const size_t numEvaluations,
+           ProposeFunctionType&& propose,
+           CompleteFunctionType&& complete)
+  {
+    std::vector<size_t> freeSlots;
+    for (size_t i = slots.size(); i > 0; --i)
+      freeSlots.push_back(i - 1);
+
+    size_t started = 0;
+    size_t inFlight = 0;
+    bool stop = false;
+    std::exception_ptr error;
+    while (true)
+    {
+      // Keep every worker busy.
+      while (!stop && started < numEvaluations && !freeSlots.empty())
+      {
+        Slot& slot = slots[freeSlots.back()];
+        slot.tag = propose(slot.point);
+        slot.error = nullptr;
+        Start(slot);
+
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          pending.push_back(freeSlots.back());
+        }
+        pendingCondition.notify_one();
+        freeSlots.pop_back();
+        ++started;
+        ++inFlight;
+      }
+
+      if (inFlight == 0)
+        break;
+
+      // Take the next completed evaluation.
+      size_t s;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        doneCondition.wait(lock, [this]() { return !done.empty(); });
+        s = done.front();
+        done.pop_front();
+      }
+      --inFlight;
+      freeSlots.push_back(s);
+
+      Slot& slot = slots[s];
+      if (slot.error)
+      {
+        // Stop, and rethrow once the other evaluations are done.
+        if (!error)
+          error = slot.error;
+        stop = true;
+      }
+      else if (!error)
+      {
+        stop |= complete(slot.tag, slot.point, slot.objective);
+      }
+    }
+
+    if (error)
+      std::rethrow_exception(error);
+  }
+
+ private:
+  //! The point of an evaluation in flight, and its result.
+  struct Slot
+  {
+    arma::mat point;
+    size_t tag;
+    std::future<double> future;
+    double objective;
+    std::exception_ptr error;
+  };
+
+  //! Start an asynchronous evaluation (in the calling thread, since the point
+  //! only has to be valid during EvaluateAsync()).
+  template<typename F = FunctionType>
+  typename std::enable_if<traits::HasAsyncEvaluate<F, arma::mat>::value>::type
+  Start(Slot& slot) { slot.future = function.EvaluateAsync(slot.point); }
+
+  //! Nothing to start for a synchronous evaluation.
+  template<typename F = FunctionType>
+  typename std::enable_if<!traits::HasAsyncEvaluate<F, arma::mat>::value>::type
+  Start(Slot& /* slot */) { }
+
+  //! Wait for the result of an asynchronous evaluation.
+  template<typename F = FunctionType>
+  typename std::enable_if<traits::HasAsyncEvaluate<F, arma::mat>::value,
+      double>::type
+  Finish(Slot& slot) { return slot.future.get(); }
+
+  //! Evaluate the point synchronously.
+  template<typename F = FunctionType>
+  typename std::enable_if<!traits::HasAsyncEvaluate<F, arma::mat>::value,
+      double>::type
+  Finish(Slot& slot) { return function.Evaluate(slot.point); }
+
+  //! The loop of a worker thread.
+  void Work()
+  {
+    while (true)
+    {
+      size_t s;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        pendingCondition.wait(lock,
+            [this]() { return shutdown || !pending.empty(); });
+        if (pending.empty())
+          return;
+        s = pending.front();
+        pending.pop_front();
+      }
+
+      try
+      {
+        slots[s].objective = Finish(slots[s]);
+      }
+      catch (...)
+      {
+        slots[s].error = std::current_exception();
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        done.push_back(s);
+      }
+      doneCondition.notify_one();
+    }
+  }
+
+  //! The function to evaluate.
+  FunctionType& function;
+  //! The slots of the evaluations in flight.
+  std::vector<Slot> slots;
+  //! The slots waiting for a worker.
+  std::deque<size_t> pending;
+  //! The slots whose evaluation is done, in completion order.
+  std::deque<size_t> done;
+  //! Whether the workers should exit.
+  bool shutdown;
+  //! The lock of pending, done and shutdown.
+  std::mutex mutex;
+  //! Signaled when a slot is pending or the workers should exit.
+  std::condition_variable pendingCondition;
+  //! Signaled when the evaluation of a slot is done.
+  std::condition_variable doneCondition;
+  //! The worker threads.
+  std::vector<std::thread> workers;
+};
+
+/**
+ * Evaluate numEvaluations points of the function, with up to numWorkers
+ * evaluations in flight at once, without ever waiting for a whole batch: the
+ * next point is proposed as soon as an evaluation completes, so that it can
+ * depend on all the results so far.  This keeps the workers busy when the
+ * evaluation times vary a lot from point to point.
+ *
+ * The points are proposed and the results handed back in the calling thread,
+ * in the order in which the evaluations complete:
+ *
+ * @code
+ * // Fill the given point and return a tag for it.
+ * size_t propose(arma::mat& point);
+ * // Use the objective of a point; return true to stop proposing points.
+ * bool complete(size_t tag, const arma::mat& point, double objective);
+ * @endcode
+ *
+ * The evaluations are run on std::threads, with Evaluate() (which is then
+ * called concurrently, so it must be thread-safe), or by waiting for the future
+ * returned by EvaluateAsync() if the function has it.  Once complete() returns
+ * true, the evaluations in flight are still completed and handed back.  An
+ * exception thrown by an evaluation is rethrown after the evaluations in
+ * flight are done.
+ *
+ * @param function Function to evaluate.
+ * @param numEvaluations Maximum number of points to evaluate.
+ * @param numWorkers Maximum number of evaluations in flight (0 means the
+ *     number of hardware threads).
+ * @param propose Function that fills the next point to evaluate.
+ * @param complete Function called with each completed evaluation.
+ */
+template<typename FunctionType,
+         typename ProposeFunctionType,
+         typename CompleteFunctionType>
+inline void EvaluateAsCompleted(FunctionType& function,
+                                const size_t numEvaluations,
+                                size_t numWorkers,
+                                ProposeFunctionType&& propose,
+                                CompleteFunctionType&& complete)
+{
+  if (numWorkers == 0)
+    numWorkers = std::max((size_t) std::thread::hardware_concurrency(),
+        (size_t) 1);
+
+  AsCompletedEvaluator<FunctionType> evaluator(function,
+      std::min(numWorkers, std::max(numEvaluations, (size_t) 1)));
+  evaluator.Run(numEvaluations, propose, complete);
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,123 @@
+/**
+ * @file evaluate_async.hpp
+ *
+ * Evaluation of many points of a function that provides EvaluateAsync(), with
+ * several evaluations in flight at once.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_EVALUATE_ASYNC_HPP
+#define ENSMALLEN_FUNCTION_EVALUATE_ASYNC_HPP
+
+#include <deque>
+#include <future>
+
+#include "traits.hpp"
+
+namespace ens {
+
+/**
+ * Evaluate the function at points 0, ..., n - 1 with its EvaluateAsync()
+ * method, which starts an evaluation and returns a std::future of the
+ * objective:
+ *
+ * @code
+ * std::future<double> EvaluateAsync(const arma::mat& coordinates);
+ * @endcode
+ *
+ * The evaluations are started before any objective is waited for, so that
+ * expensive remote evaluations overlap; with maxInFlight set, at most that
+ * many evaluations are started and not collected yet, and the next one is
+ * started whenever the oldest one is collected.  The objectives are collected
+ * in order, so the result does not depend on the order in which the
+ * evaluations complete.  An exception stored in a future is rethrown, after
+ * the other evaluations in flight have completed.
+ *
+ * The point given to EvaluateAsync() is only guaranteed to be valid until
+ * EvaluateAsync() returns, so the function has to copy it if the evaluation
+ * needs it later.
+ *
+ * @param function Function to evaluate.
+ * @param n Number of points.
+ * @param point Function returning the point of the given index.
+ * @param store Function called with the index of each point and its
+ *     objective.
+ * @param maxInFlight Maximum number of evaluations in flight (0 means no
+ *     limit).
+ */
+template<typename FunctionType,
+         typename PointFunctionType,
+         typename StoreFunctionType>
+inline void EvaluateInFlight(FunctionType& function,
+                             const size_t n,
+                             PointFunctionType&& point,
+                             StoreFunctionType&& store,
+                             const size_t maxInFlight = 0)
+{
+  typedef decltype(function.EvaluateAsync(point(0))) FutureType;
+
+  const size_t window = (maxInFlight == 0) ? n : maxInFlight;
+  std::deque<FutureType> inFlight;
+  size_t started = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    while (started < n && started < i + window)
+      inFlight.push_back(function.EvaluateAsync(point(started++)));
+
+    FutureType objective = std::move(inFlight.front());
+    inFlight.pop_front();
+    try
+    {
+      store(i, objective.get());
+    }
+    catch (...)
+    {
+      // Do not leave evaluations running on points that may go away.
+      for (FutureType& future : inFlight)
+        future.wait();
+      throw;
+    }
+  }
+}
+
+/**
+ * Evaluate the function at points 0, ..., n - 1 with EvaluateInFlight() if it
+ * has an EvaluateAsync() method for arma::mat, and return true; otherwise, do
+ * nothing and return false, so that the caller evaluates the points itself.
+ */
+template<typename FunctionType,
+         typename PointFunctionType,
+         typename StoreFunctionType>
+inline typename std::enable_if<
+    traits::HasAsyncEvaluate<FunctionType, arma::mat>::value, bool>::type
+TryEvaluateInFlight(FunctionType& function,
+                    const size_t n,
+                    PointFunctionType&& point,
+                    StoreFunctionType&& store,
+                    const size_t maxInFlight = 0)
+{
+  EvaluateInFlight(function, n, point, store, maxInFlight);
+  return true;
+}
+
+//! Do nothing and return false, for a function without EvaluateAsync().
+template<typename FunctionType,
+         typename PointFunctionType,
+         typename StoreFunctionType>
+inline typename std::enable_if<
+    !traits::HasAsyncEvaluate<FunctionType, arma::mat>::value, bool>::type
+TryEvaluateInFlight(FunctionType& /* function */,
+                    const size_t /* n */,
+                    PointFunctionType&& /* point */,
+                    StoreFunctionType&& /* store */,
+                    const size_t /* maxInFlight */ = 0)
+{
+  return false;
+}
+
+} // namespace ens
+
+#endif
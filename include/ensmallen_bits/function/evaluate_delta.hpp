@@ -0,0 +1,132 @@
+/**
+ * @file evaluate_delta.hpp
+ *
+ * Utility that lets Monte Carlo optimizers evaluate a move of one coordinate
+ * incrementally, if the function supports it.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_EVALUATE_DELTA_HPP
+#define ENSMALLEN_FUNCTION_EVALUATE_DELTA_HPP
+
+#include <algorithm>
+#include <type_traits>
+
+namespace ens {
+
+/**
+ * Return the objective after element index of the coordinates is changed to
+ * newValue, given the objective at the coordinates.  The coordinates are not
+ * modified.  This version is used when the function implements
+ *
+ * @code
+ * // Return f(x') - f(x), where x' is the coordinates with element index set
+ * // to newValue.
+ * double EvaluateDelta(const arma::mat& coordinates,
+ *                      const size_t index,
+ *                      const double newValue);
+ * @endcode
+ *
+ * (EvaluateDelta() may be const), which for separable or sparse objectives
+ * costs O(1) instead of the O(n) of Evaluate().  Since the objective is then
+ * accumulated from the changes, it may drift from Evaluate() by rounding.
+ *
+ * @param function Function to evaluate.
+ * @param coordinates The current coordinates.
+ * @param index The element to change.
+ * @param newValue The new value of the element.
+ * @param objective The objective at the current coordinates.
+ */
+template<typename FunctionType>
+typename std::enable_if<traits::HasEvaluateDeltaMethod<FunctionType>::value,
+    double>::type
+EvaluateMove(FunctionType& function,
+             arma::mat& coordinates,
+             const size_t index,
+             const double newValue,
+             const double objective)
+{
+  return objective + function.EvaluateDelta(coordinates, index, newValue);
+}
+
+//! Functions without EvaluateDelta() are evaluated at the moved point.
+template<typename FunctionType>
+typename std::enable_if<!traits::HasEvaluateDeltaMethod<FunctionType>::value,
+    double>::type
+EvaluateMove(FunctionType& function,
+             arma::mat& coordinates,
+             const size_t index,
+             const double newValue,
+             const double /* objective */)
+{
+  const double oldValue = coordinates(index);
+  coordinates(index) = newValue;
+  const double newObjective = function.Evaluate(coordinates);
+  coordinates(index) = oldValue;
+  return newObjective;
+}
+
+/**
+ * Return the objective after the count elements of the coordinates starting at
+ * index begin are changed to the given new values, given the objective at the
+ * coordinates.  The new values are swapped into the coordinates and back, so
+ * neither is modified on return.  For functions with EvaluateDelta(), the
+ * changes are evaluated one after another, each from the coordinates with the
+ * previous changes applied, so a block costs O(count) instead of the O(n) of
+ * Evaluate().
+ *
+ * @param function Function to evaluate.
+ * @param coordinates The current coordinates.
+ * @param begin The first element to change.
+ * @param count The number of consecutive elements to change.
+ * @param newValues The new values of the elements.
+ * @param objective The objective at the current coordinates.
+ */
+template<typename FunctionType>
+typename std::enable_if<traits::HasEvaluateDeltaMethod<FunctionType>::value,
+    double>::type
+EvaluateBlockMove(FunctionType& function,
+                  arma::mat& coordinates,
+                  const size_t begin,
+                  const size_t count,
+                  double* newValues,
+                  const double objective)
+{
+  double* values = coordinates.memptr() + begin;
+  double newObjective = objective;
+  for (size_t j = 0; j < count; ++j)
+  {
+    newObjective += function.EvaluateDelta(coordinates, begin + j,
+        newValues[j]);
+    std::swap(values[j], newValues[j]);
+  }
+
+  // Swap the old values back in.
+  std::swap_ranges(values, values + count, newValues);
+  return newObjective;
+}
+
+//! Functions without EvaluateDelta() are evaluated once at the moved point.
+template<typename FunctionType>
+typename std::enable_if<!traits::HasEvaluateDeltaMethod<FunctionType>::value,
+    double>::type
+EvaluateBlockMove(FunctionType& function,
+                  arma::mat& coordinates,
+                  const size_t begin,
+                  const size_t count,
+                  double* newValues,
+                  const double /* objective */)
+{
+  double* values = coordinates.memptr() + begin;
+  std::swap_ranges(values, values + count, newValues);
+  const double newObjective = function.Evaluate(coordinates);
+  std::swap_ranges(values, values + count, newValues);
+  return newObjective;
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,306 @@
+/**
+ * @file evaluation_cache.hpp
+ *
+ * Adapter for arbitrary functions that remembers the objective at the points
+ * that were evaluated, so that black-box optimizers which revisit a point do
+ * not evaluate it again.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_EVALUATION_CACHE_HPP
+#define ENSMALLEN_FUNCTION_EVALUATION_CACHE_HPP
+
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace ens {
+
+/**
+ * EvaluationCache wraps an arbitrary function and memoizes its objective at
+ * the most recently used points, up to the given capacity (with least
+ * recently used eviction).  It is meant for expensive objectives (such as
+ * simulations) optimized with black-box optimizers like GridSearch, SA, DE or
+ * CNE, which can revisit identical points, for instance with categorical
+ * dimensions or parameters rounded to integers.
+ *
+ * @code
+ * SimulationFunction f;
+ * EvaluationCache<SimulationFunction> cachedF(f, 10000, 1e-6);
+ *
+ * CNE cne;
+ * arma::mat coordinates = f.GetInitialPoint();
+ * cne.Optimize(cachedF, coordinates);
+ * @endcode
+ *
+ * If resolution is zero, the points are compared exactly (elementwise).
+ * Otherwise the coordinates are rounded to multiples of the resolution, and
+ * points that round to the same multiples share an objective (the one of the
+ * first point of them that was evaluated).
+ *
+ * The cache is safe to use from several threads at once (for instance with
+ * CNE's parallelEvaluation); the wrapped function is called without holding
+ * the lock, so several evaluations may run at the same time, but a point that
+ * is being evaluated is not evaluated again by another thread, which waits for
+ * the result instead.  If the wrapped function throws, the point is not
+ * cached.
+ *
+ * The wrapped function must not change between calls (if it does, call
+ * Reset()).
+ *
+ * @tparam FunctionType Type of the function to wrap.
+ * @tparam MatType Type of the coordinates.
+ */
+template<typename FunctionType, typename MatType = arma::mat>
+class EvaluationCache
+{
+ public:
+  //! The type of the objective.
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Wrap the given function.  The function is held by reference, so it must
+   * outlive the wrapper.
+   *
+   * @param function Function to wrap.
+   * @param capacity Maximum number of cached points (0 means no limit).
+   * @param resolution Resolution the coordinates are rounded to before they
+   *     are compared (0 means they are compared exactly).
+   */
+  EvaluationCache(FunctionType& function,
+                  const size_t capacity = 1024,
+                  const double resolution = 0.0) :
+      function(function),
+      capacity(capacity),
+      resolution(resolution),
+      hits(0),
+      misses(0)
+  { /* Nothing to do. */ }
+
+  /**
+   * Return the objective at the given coordinates, from the cache if the
+   * point (or, with a nonzero resolution, a point that rounds to the same
+   * coordinates) was evaluated before.
+   *
+   * @param coordinates The point to evaluate the objective at.
+   */
+  ElemType Evaluate(const MatType& coordinates)
+  {
+    Key key;
+    MakeKey(coordinates, key);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+      typename Lookup::iterator it = lookup.find(key);
+      if (it == lookup.end())
+        break;
+
+      if (it->second->ready)
+      {
+        ++hits;
+        entries.splice(entries.begin(), entries, it->second);
+        return it->second->objective;
+      }
+
+      // Another thread is evaluating the point; if that evaluation fails, the
+      // entry is removed, and the point is evaluated here.
+      completed.wait(lock);
+    }
+
+    ++misses;
+    entries.push_front(Entry(key));
+    const typename std::list<Entry>::iterator entry = entries.begin();
+    lookup[key] = entry;
+    lock.unlock();
+
+    ElemType objective;
+    try
+    {
+      objective = function.Evaluate(coordinates);
+    }
+    catch (...)
+    {
+      lock.lock();
+      lookup.erase(entry->key);
+      entries.erase(entry);
+      completed.notify_all();
+      throw;
+    }
+
+    lock.lock();
+    entry->objective = objective;
+    entry->ready = true;
+    Evict();
+    completed.notify_all();
+    return objective;
+  }
+
+  //! Forget the cached points (except the ones being evaluated).
+  void Reset()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    typename std::list<Entry>::iterator it = entries.begin();
+    while (it != entries.end())
+    {
+      if (it->ready)
+      {
+        lookup.erase(it->key);
+        it = entries.erase(it);
+      }
+      else
+      {
+        ++it;
+      }
+    }
+  }
+
+  //! Get the number of evaluations that were served from the cache.
+  size_t Hits() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+  }
+
+  //! Get the number of evaluations that called the wrapped function.
+  size_t Misses() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+  }
+
+  //! Get the number of cached points.
+  size_t Size() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lookup.size();
+  }
+
+  //! Get the maximum number of cached points (0 means no limit).
+  size_t Capacity() const { return capacity; }
+
+  //! Get the resolution the coordinates are rounded to.
+  double Resolution() const { return resolution; }
+
+  //! Get the wrapped function.
+  const FunctionType& WrappedFunction() const { return function; }
+  //! Get the wrapped function.
+  FunctionType& WrappedFunction() { return function; }
+
+ private:
+  //! The key of a point: its size and its (rounded) coordinates.
+  typedef std::vector<long long> Key;
+
+  //! Hash a key.
+  struct KeyHash
+  {
+    size_t operator()(const Key& key) const
+    {
+      unsigned long long hash = 14695981039346656037ULL;
+      for (size_t i = 0; i < key.size(); ++i)
+      {
+        hash ^= (unsigned long long) key[i];
+        hash *= 1099511628211ULL;
+      }
+
+      return (size_t) hash;
+    }
+  };
+
+  //! A cached point.
+  struct Entry
+  {
+    Entry(const Key& key) : key(key), objective(0), ready(false) { }
+
+    //! The key of the point.
+    Key key;
+    //! The objective at the point (if ready).
+    ElemType objective;
+    //! Whether the evaluation of the point has completed.
+    bool ready;
+  };
+
+  //! The map from keys to cached points.
+  typedef std::unordered_map<Key, typename std::list<Entry>::iterator,
+      KeyHash> Lookup;
+
+  //! Compute the key of the given coordinates.
+  void MakeKey(const MatType& coordinates, Key& key) const
+  {
+    key.resize(coordinates.n_elem + 2);
+    key[0] = (long long) coordinates.n_rows;
+    key[1] = (long long) coordinates.n_cols;
+    for (size_t i = 0; i < coordinates.n_elem; ++i)
+    {
+      const double value = (double) coordinates[i];
+      if (resolution > 0.0)
+      {
+        key[i + 2] = (long long) std::llround(value / resolution);
+      }
+      else
+      {
+        // Compare the values bitwise, with both zeros the same.
+        const double normalized = (value == 0.0) ? 0.0 : value;
+        long long bits;
+        std::memcpy(&bits, &normalized, sizeof(bits));
+        key[i + 2] = bits;
+      }
+    }
+  }
+
+  //! Remove the least recently used points until the capacity is respected.
+  //! Points that are being evaluated are not removed.
+  void Evict()
+  {
+    while (capacity > 0 && lookup.size() > capacity)
+    {
+      typename std::list<Entry>::iterator it = entries.end();
+      bool evicted = false;
+      while (it != entries.begin())
+      {
+        --it;
+        if (it->ready)
+        {
+          lookup.erase(it->key);
+          entries.erase(it);
+          evicted = true;
+          break;
+        }
+      }
+
+      if (!evicted)
+        break;
+    }
+  }
+
+  //! The wrapped function.
+  FunctionType& function;
+  //! The maximum number of cached points.
+  size_t capacity;
+  //! The resolution the coordinates are rounded to.
+  double resolution;
+
+  //! The cached points, the most recently used first.
+  std::list<Entry> entries;
+  //! The map from keys to cached points.
+  Lookup lookup;
+
+  //! The number of evaluations served from the cache.
+  size_t hits;
+  //! The number of evaluations that called the wrapped function.
+  size_t misses;
+
+  //! The lock of the cache.
+  mutable std::mutex mutex;
+  //! Signalled when an evaluation completes.
+  std::condition_variable completed;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,57 @@
+/**
+ * @file feature_screening.hpp
+ *
+ * Call the safe screening rule of a function, for coordinate descent, if it
+ * has one.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_FEATURE_SCREENING_HPP
+#define ENSMALLEN_FUNCTION_FEATURE_SCREENING_HPP
+
+#include <type_traits>
+#include <vector>
+
+namespace ens {
+
+/**
+ * Screen the features of the function at the given coordinates.  This version
+ * is used when the function implements
+ *
+ * @code
+ * // Set active[j] to false for every feature j that is provably zero at the
+ * // optimum, given the current coordinates (for instance, with a gap safe
+ * // rule).  Features that are already inactive must stay inactive.
+ * void ScreenFeatures(const arma::mat& coordinates,
+ *                     std::vector<bool>& active);
+ * @endcode
+ *
+ * (possibly const).  Otherwise, nothing is screened.
+ *
+ * @param function Function to screen the features of.
+ * @param coordinates The current coordinates.
+ * @param active Whether each feature is still active (will be modified).
+ */
+template<typename FunctionType>
+typename std::enable_if<traits::HasFeatureScreening<FunctionType>::value>::type
+ScreenFeatures(FunctionType& function,
+               const arma::mat& coordinates,
+               std::vector<bool>& active)
+{
+  function.ScreenFeatures(coordinates, active);
+}
+
+//! Functions without a screening rule keep all their features.
+template<typename FunctionType>
+typename std::enable_if<!traits::HasFeatureScreening<FunctionType>::value>::type
+ScreenFeatures(FunctionType& /* function */,
+               const arma::mat& /* coordinates */,
+               std::vector<bool>& /* active */)
+{ }
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,348 @@
+/**
+ * @file full_pass.hpp
+ *
+ * Utilities that compute the objective or the gradient of a separable function
+ * over all of its functions, one batch at a time, optionally splitting the
+ * batches across OpenMP threads.  These are the full passes taken by the
+ * variance-reduced optimizers (SVRG, SARAH, Katyusha) once per epoch.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_FULL_PASS_HPP
+#define ENSMALLEN_FUNCTION_FULL_PASS_HPP
+
+#include <vector>
+
+namespace ens {
+
+/**
+ * Compute the sum of the objectives of all the functions of the given
+ * separable function in the deterministic reduction mode: the batches are
+ * grouped into a fixed number of chunks of consecutive batches (see
+ * DeterministicChunkCount()), each chunk is summed in order by any thread, and
+ * the sums of the chunks are added with TreeReduce().  So the result does not
+ * depend on the number of threads.
+ *
+ * @param function Separable function to evaluate.
+ * @param coordinates The coordinates to evaluate at.
+ * @param batchSize Number of functions to evaluate per call.
+ * @return The sum of the objectives of all functions.
+ */
+template<typename FunctionType, typename MatType>
+typename MatType::elem_type DeterministicFullPassEvaluate(
+    FunctionType& function,
+    const MatType& coordinates,
+    const size_t batchSize)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const size_t numFunctions = function.NumFunctions();
+  const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+  const size_t chunks = DeterministicChunkCount(numBatches);
+
+  std::vector<ElemType> objectives(chunks, ElemType(0));
+  ParallelFor(chunks, [&](const size_t c)
+  {
+    for (size_t b = (c * numBatches) / chunks;
+         b < ((c + 1) * numBatches) / chunks; ++b)
+    {
+      const size_t begin = b * batchSize;
+      objectives[c] += function.Evaluate(coordinates, begin,
+          std::min(batchSize, numFunctions - begin));
+    }
+  });
+
+  TreeReduce(chunks, [&](const size_t c) -> ElemType&
+      { return objectives[c]; });
+  return objectives[0];
+}
+
+/**
+ * Compute the sum of the gradients of all the functions of the given separable
+ * function (and the sum of their objectives) in the deterministic reduction
+ * mode, with the same chunks as DeterministicFullPassEvaluate().  The batches
+ * are computed with batch(begin, batchSize, gradient), which returns the
+ * objective of the batch (or 0).
+ *
+ * @param numFunctions Number of functions of the separable function.
+ * @param batchSize Number of functions to compute per call.
+ * @param gradient Matrix to store the sum of the gradients in.
+ * @param batch Function that computes the gradient of one batch.
+ * @return The sum of the objectives returned for all batches.
+ */
+template<typename ElemType, typename GradType, typename BatchFunctionType>
+ElemType DeterministicFullPassGradient(const size_t numFunctions,
+                                       const size_t batchSize,
+                                       GradType& gradient,
+                                       BatchFunctionType&& batch)
+{
+  const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+  const size_t chunks = DeterministicChunkCount(numBatches);
+
+  // The first chunk accumulates into the output directly.
+  std::vector<ElemType> objectives(chunks, ElemType(0));
+  std::vector<GradType> gradients(chunks);
+  ParallelFor(chunks, [&](const size_t c)
+  {
+    const size_t first = (c * numBatches) / chunks;
+    const size_t last = ((c + 1) * numBatches) / chunks;
+    GradType& chunkGradient = (c == 0) ? gradient : gradients[c];
+
+    GradType batchGradient;
+    for (size_t b = first; b < last; ++b)
+    {
+      const size_t begin = b * batchSize;
+      const size_t size = std::min(batchSize, numFunctions - begin);
+      if (b == first)
+      {
+        objectives[c] += batch(begin, size, chunkGradient);
+      }
+      else
+      {
+        objectives[c] += batch(begin, size, batchGradient);
+        chunkGradient += batchGradient;
+      }
+    }
+  });
+
+  TreeReduce(chunks, [&](const size_t c) -> GradType&
+      { return (c == 0) ? gradient : gradients[c]; }, true);
+  TreeReduce(chunks, [&](const size_t c) -> ElemType&
+      { return objectives[c]; });
+  return objectives[0];
+}
+
+/**
+ * Compute the sum of the objectives of all the functions of the given
+ * separable function, evaluating batchSize functions at a time.  If parallel
+ * is true (and OpenMP is enabled), the batches are split statically across
+ * threads and the per-thread sums are reduced; the function's separable
+ * Evaluate() must then be safe to call concurrently on disjoint batches.  In
+ * the deterministic reduction mode, the parallel sum is computed with
+ * DeterministicFullPassEvaluate() instead, so it does not depend on the number
+ * of threads.
+ *
+ * @param function Separable function to evaluate.
+ * @param coordinates The coordinates to evaluate at.
+ * @param batchSize Number of functions to evaluate per call.
+ * @param parallel Whether to evaluate the batches in parallel.
+ * @return The sum of the objectives of all functions.
+ */
+template<typename FunctionType, typename MatType>
+typename MatType::elem_type FullPassEvaluate(FunctionType& function,
+                                             const MatType& coordinates,
+                                             const size_t batchSize,
+                                             const bool parallel = false)
+{
+  if (parallel && DeterministicReductions())
+  {
+    return DeterministicFullPassEvaluate(function, coordinates, batchSize);
+  }
+
+  const size_t numFunctions = function.NumFunctions();
+  const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+
+  typename MatType::elem_type objective = 0;
+  #ifdef ENS_USE_OPENMP
+    #pragma omp parallel for schedule(static) reduction(+:objective) \
+        if(parallel)
+  #else
+    (void) parallel;
+  #endif
+  for (size_t b = 0; b < numBatches; ++b)
+  {
+    const size_t begin = b * batchSize;
+    objective += function.Evaluate(coordinates, begin,
+        std::min(batchSize, numFunctions - begin));
+  }
+
+  return objective;
+}
+
+/**
+ * Compute the sum of the gradients of all the functions of the given separable
+ * function, batchSize functions at a time.  If parallel is true (and OpenMP is
+ * enabled), the batches are split statically across threads, each thread sums
+ * its batches into its own gradient, and the per-thread gradients are added in
+ * thread order, so the result only depends on the number of threads (in the
+ * deterministic reduction mode, it does not depend on it either; see
+ * DeterministicFullPassGradient()).  The function's separable Gradient() must
+ * then be safe to call concurrently on disjoint batches.
+ *
+ * @param function Separable function to differentiate.
+ * @param coordinates The coordinates to compute the gradient at.
+ * @param batchSize Number of functions to differentiate per call.
+ * @param gradient Matrix to store the sum of the gradients in.
+ * @param parallel Whether to compute the batches in parallel.
+ */
+template<typename FunctionType, typename MatType, typename GradType>
+void FullPassGradient(FunctionType& function,
+                      const MatType& coordinates,
+                      const size_t batchSize,
+                      GradType& gradient,
+                      const bool parallel = false)
+{
+  if (parallel && DeterministicReductions())
+  {
+    typedef typename MatType::elem_type ElemType;
+    DeterministicFullPassGradient<ElemType>(function.NumFunctions(), batchSize,
+        gradient, [&](const size_t begin, const size_t size, GradType& g)
+            -> ElemType
+        {
+          function.Gradient(coordinates, begin, g, size);
+          return ElemType(0);
+        });
+    return;
+  }
+
+  const size_t numFunctions = function.NumFunctions();
+
+  #ifdef ENS_USE_OPENMP
+    if (parallel && !omp_in_parallel() && omp_get_max_threads() > 1)
+    {
+      const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+      std::vector<GradType> partialGradients(omp_get_max_threads());
+      for (size_t t = 0; t < partialGradients.size(); ++t)
+        partialGradients[t].zeros(coordinates.n_rows, coordinates.n_cols);
+
+      #pragma omp parallel
+      {
+        GradType& partialGradient = partialGradients[omp_get_thread_num()];
+        GradType batchGradient(coordinates.n_rows, coordinates.n_cols);
+
+        #pragma omp for schedule(static)
+        for (size_t b = 0; b < numBatches; ++b)
+        {
+          const size_t begin = b * batchSize;
+          function.Gradient(coordinates, begin, batchGradient,
+              std::min(batchSize, numFunctions - begin));
+          partialGradient += batchGradient;
+        }
+      }
+
+      gradient = partialGradients[0];
+      for (size_t t = 1; t < partialGradients.size(); ++t)
+        gradient += partialGradients[t];
+
+      return;
+    }
+  #else
+    (void) parallel;
+  #endif
+
+  size_t effectiveBatchSize = std::min(batchSize, numFunctions);
+  function.Gradient(coordinates, 0, gradient, effectiveBatchSize);
+
+  GradType batchGradient(coordinates.n_rows, coordinates.n_cols);
+  for (size_t f = effectiveBatchSize; f < numFunctions;
+      /* incrementing done manually */)
+  {
+    // Find the effective batch size (the last batch may be smaller).
+    effectiveBatchSize = std::min(batchSize, numFunctions - f);
+
+    function.Gradient(coordinates, f, batchGradient, effectiveBatchSize);
+    gradient += batchGradient;
+
+    f += effectiveBatchSize;
+  }
+}
+
+/**
+ * Compute the sum of the objectives and the sum of the gradients of all the
+ * functions of the given separable function at once, batchSize functions at a
+ * time, with the function's separable EvaluateWithGradient().  This takes one
+ * pass over the data instead of the two of FullPassEvaluate() and
+ * FullPassGradient().  If parallel is true (and OpenMP is enabled), the batches
+ * are split as in FullPassGradient(), and the function's separable
+ * EvaluateWithGradient() must be safe to call concurrently on disjoint
+ * batches.
+ *
+ * @param function Separable function to evaluate and differentiate.
+ * @param coordinates The coordinates to evaluate at.
+ * @param batchSize Number of functions to evaluate per call.
+ * @param gradient Matrix to store the sum of the gradients in.
+ * @param parallel Whether to compute the batches in parallel.
+ * @return The sum of the objectives of all functions.
+ */
+template<typename FunctionType, typename MatType, typename GradType>
+typename MatType::elem_type FullPassEvaluateWithGradient(
+    FunctionType& function,
+    const MatType& coordinates,
+    const size_t batchSize,
+    GradType& gradient,
+    const bool parallel = false)
+{
+  if (parallel && DeterministicReductions())
+  {
+    typedef typename MatType::elem_type ElemType;
+    return DeterministicFullPassGradient<ElemType>(function.NumFunctions(),
+        batchSize, gradient, [&](const size_t begin, const size_t size,
+        GradType& g) -> ElemType
+        {
+          return function.EvaluateWithGradient(coordinates, begin, g, size);
+        });
+  }
+
+  const size_t numFunctions = function.NumFunctions();
+  typename MatType::elem_type objective = 0;
+
+  #ifdef ENS_USE_OPENMP
+    if (parallel && !omp_in_parallel() && omp_get_max_threads() > 1)
+    {
+      const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+      std::vector<GradType> partialGradients(omp_get_max_threads());
+      for (size_t t = 0; t < partialGradients.size(); ++t)
+        partialGradients[t].zeros(coordinates.n_rows, coordinates.n_cols);
+
+      #pragma omp parallel reduction(+:objective)
+      {
+        GradType& partialGradient = partialGradients[omp_get_thread_num()];
+        GradType batchGradient(coordinates.n_rows, coordinates.n_cols);
+
+        #pragma omp for schedule(static)
+        for (size_t b = 0; b < numBatches; ++b)
+        {
+          const size_t begin = b * batchSize;
+          objective += function.EvaluateWithGradient(coordinates, begin,
+              batchGradient, std::min(batchSize, numFunctions - begin));
+          partialGradient += batchGradient;
+        }
+      }
+
+      gradient = partialGradients[0];
+      for (size_t t = 1; t < partialGradients.size(); ++t)
+        gradient += partialGradients[t];
+
+      return objective;
+    }
+  #else
+    (void) parallel;
+  #endif
+
+  size_t effectiveBatchSize = std::min(batchSize, numFunctions);
+  objective = function.EvaluateWithGradient(coordinates, 0, gradient,
+      effectiveBatchSize);
+
+  GradType batchGradient(coordinates.n_rows, coordinates.n_cols);
+  for (size_t f = effectiveBatchSize; f < numFunctions;
+      /* incrementing done manually */)
+  {
+    // Find the effective batch size (the last batch may be smaller).
+    effectiveBatchSize = std::min(batchSize, numFunctions - f);
+
+    objective += function.EvaluateWithGradient(coordinates, f, batchGradient,
+        effectiveBatchSize);
+    gradient += batchGradient;
+
+    f += effectiveBatchSize;
+  }
+
+  return objective;
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,179 @@
+/**
+ * @file gradient_statistics.hpp
+ *
+ * Utility that computes the gradient of one batch of a separable function
+ * together with the sum of the squared norms of the gradients of the functions
+ * in the batch, as needed by the variance estimate of big-batch SGD.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_GRADIENT_STATISTICS_HPP
+#define ENSMALLEN_FUNCTION_GRADIENT_STATISTICS_HPP
+
+#include <type_traits>
+#include <vector>
+
+namespace ens {
+
+/**
+ * Compute the gradient of the functions in the given batch (their sum), and
+ * the sum of the squared norms of their individual gradients.  From these, the
+ * sample variance of the gradients of the batch is
+ *
+ *   (sumSquaredNorms - ||gradient||^2 / batchSize) / (batchSize - 1).
+ *
+ * This version is used when the function implements
+ *
+ * @code
+ * void GradientStatistics(const MatType& coordinates,
+ *                         const size_t begin,
+ *                         GradType& gradient,
+ *                         double& sumSquaredNorms,
+ *                         const size_t batchSize);
+ * @endcode
+ *
+ * (possibly const), which can compute both in a single vectorized pass over
+ * the data of the batch.  Otherwise, the separable Gradient() is called once
+ * for each function in the batch.
+ *
+ * @param function Separable function to differentiate.
+ * @param coordinates The point to compute the gradients at.
+ * @param begin The first function in the batch.
+ * @param gradient Matrix to store the gradient of the batch in.
+ * @param sumSquaredNorms Sum of the squared norms of the gradients of the
+ *     functions in the batch.
+ * @param batchSize The number of functions in the batch.
+ */
+template<typename FunctionType, typename MatType, typename GradType>
+typename std::enable_if<traits::HasBatchGradientStatistics<FunctionType,
+    MatType, GradType>::value>::type
+BatchGradientStatistics(FunctionType& function,
+                        const MatType& coordinates,
+                        const size_t begin,
+                        GradType& gradient,
+                        double& sumSquaredNorms,
+                        const size_t batchSize)
+{
+  function.GradientStatistics(coordinates, begin, gradient, sumSquaredNorms,
+      batchSize);
+}
+
+//! Compute the gradient of the functions in the given batch and the sum of the
+//! squared norms of their gradients, with one call to the separable Gradient()
+//! for each function.
+template<typename FunctionType, typename MatType, typename GradType>
+typename std::enable_if<!traits::HasBatchGradientStatistics<FunctionType,
+    MatType, GradType>::value>::type
+BatchGradientStatistics(FunctionType& function,
+                        const MatType& coordinates,
+                        const size_t begin,
+                        GradType& gradient,
+                        double& sumSquaredNorms,
+                        const size_t batchSize)
+{
+  function.Gradient(coordinates, begin, gradient, 1);
+  sumSquaredNorms = arma::accu(arma::square(gradient));
+
+  GradType functionGradient;
+  for (size_t j = 1; j < batchSize; ++j)
+  {
+    function.Gradient(coordinates, begin + j, functionGradient, 1);
+    sumSquaredNorms += arma::accu(arma::square(functionGradient));
+    gradient += functionGradient;
+  }
+}
+
+/**
+ * Compute the gradient of the functions in the given batch and the sum of the
+ * squared norms of their gradients, as above.  If parallel is true (and OpenMP
+ * is enabled), the batch is split into one contiguous part per thread, each
+ * thread computes the statistics of its part, and the per-thread statistics
+ * are added in thread order (both are sums, so merging them is exact), so the
+ * result only depends on the number of threads.  In the deterministic
+ * reduction mode, the batch is split into a fixed number of parts instead (see
+ * DeterministicChunkCount()), which are added with TreeReduce(), so the result
+ * does not depend on the number of threads.  The function's
+ * GradientStatistics() or separable Gradient() must then be safe to call
+ * concurrently on disjoint batches.
+ *
+ * @param function Separable function to differentiate.
+ * @param coordinates The point to compute the gradients at.
+ * @param begin The first function in the batch.
+ * @param gradient Matrix to store the gradient of the batch in.
+ * @param sumSquaredNorms Sum of the squared norms of the gradients of the
+ *     functions in the batch.
+ * @param batchSize The number of functions in the batch.
+ * @param parallel Whether to split the batch across threads.
+ */
+template<typename FunctionType, typename MatType, typename GradType>
+void BatchGradientStatistics(FunctionType& function,
+                             const MatType& coordinates,
+                             const size_t begin,
+                             GradType& gradient,
+                             double& sumSquaredNorms,
+                             const size_t batchSize,
+                             const bool parallel)
+{
+  const size_t deterministicParts = DeterministicChunkCount(batchSize);
+  if (parallel && DeterministicReductions() && deterministicParts > 1)
+  {
+    std::vector<GradType> partialGradients(deterministicParts);
+    std::vector<double> partialSquaredNorms(deterministicParts);
+    ParallelFor(deterministicParts, [&](const size_t t)
+    {
+      const size_t partBegin = t * batchSize / deterministicParts;
+      const size_t partEnd = (t + 1) * batchSize / deterministicParts;
+      BatchGradientStatistics(function, coordinates, begin + partBegin,
+          partialGradients[t], partialSquaredNorms[t], partEnd - partBegin);
+    });
+
+    TreeReduce(deterministicParts, [&](const size_t t) -> GradType&
+        { return partialGradients[t]; }, true);
+    TreeReduce(deterministicParts, [&](const size_t t) -> double&
+        { return partialSquaredNorms[t]; });
+    gradient = std::move(partialGradients[0]);
+    sumSquaredNorms = partialSquaredNorms[0];
+    return;
+  }
+
+  #ifdef ENS_USE_OPENMP
+    const size_t numParts = std::min((size_t) omp_get_max_threads(),
+        batchSize);
+    if (parallel && !omp_in_parallel() && numParts > 1)
+    {
+      std::vector<GradType> partialGradients(numParts);
+      std::vector<double> partialSquaredNorms(numParts);
+
+      #pragma omp parallel for schedule(static)
+      for (size_t t = 0; t < numParts; ++t)
+      {
+        const size_t partBegin = t * batchSize / numParts;
+        const size_t partEnd = (t + 1) * batchSize / numParts;
+        BatchGradientStatistics(function, coordinates, begin + partBegin,
+            partialGradients[t], partialSquaredNorms[t], partEnd - partBegin);
+      }
+
+      gradient = partialGradients[0];
+      sumSquaredNorms = partialSquaredNorms[0];
+      for (size_t t = 1; t < numParts; ++t)
+      {
+        gradient += partialGradients[t];
+        sumSquaredNorms += partialSquaredNorms[t];
+      }
+
+      return;
+    }
+  #else
+    (void) parallel;
+  #endif
+
+  BatchGradientStatistics(function, coordinates, begin, gradient,
+      sumSquaredNorms, batchSize);
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,101 @@
+/**
+ * @file hessian_vector_product.hpp
+ *
+ * Utility that computes the product of the Hessian of a differentiable
+ * function with a direction, either with the function's own
+ * HessianVectorProduct() method or with a finite difference of its gradient.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_HESSIAN_VECTOR_PRODUCT_HPP
+#define ENSMALLEN_FUNCTION_HESSIAN_VECTOR_PRODUCT_HPP
+
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+namespace ens {
+
+/**
+ * Compute the product of the Hessian of the given function at the given
+ * coordinates with the given direction.  This version is used when the
+ * function implements
+ *
+ * @code
+ * void HessianVectorProduct(const MatType& coordinates,
+ *                           const MatType& direction,
+ *                           GradType& product);
+ * @endcode
+ *
+ * (possibly const), which is exact and usually costs about as much as one
+ * gradient evaluation.
+ *
+ * @param function Differentiable function.
+ * @param coordinates The point the Hessian is taken at.
+ * @param gradient The gradient at the coordinates (unused by this version).
+ * @param direction The direction to multiply the Hessian with.
+ * @param product Matrix to store the product in.
+ */
+template<typename FunctionType, typename MatType, typename GradType>
+typename std::enable_if<traits::HasHessianVectorProductForm<FunctionType,
+    MatType, GradType>::value>::type
+HessianVectorProduct(FunctionType& function,
+                     const MatType& coordinates,
+                     const GradType& /* gradient */,
+                     const MatType& direction,
+                     GradType& product)
+{
+  function.HessianVectorProduct(coordinates, direction, product);
+}
+
+/**
+ * Compute the product of the Hessian of the given function at the given
+ * coordinates with the given direction, with the forward difference
+ *
+ * \f[
+ * H v \approx \frac{\nabla f(x + h v) - \nabla f(x)}{h},
+ * \f]
+ *
+ * where \f$ h = \sqrt{\epsilon} (1 + \|x\|) / \|v\| \f$.  This takes one
+ * gradient evaluation (the gradient at the coordinates is given), and is
+ * accurate to about the square root of the machine precision.
+ *
+ * @param function Differentiable function.
+ * @param coordinates The point the Hessian is taken at.
+ * @param gradient The gradient at the coordinates.
+ * @param direction The direction to multiply the Hessian with.
+ * @param product Matrix to store the product in.
+ */
+template<typename FunctionType, typename MatType, typename GradType>
+typename std::enable_if<!traits::HasHessianVectorProductForm<FunctionType,
+    MatType, GradType>::value>::type
+HessianVectorProduct(FunctionType& function,
+                     const MatType& coordinates,
+                     const GradType& gradient,
+                     const MatType& direction,
+                     GradType& product)
+{
+  typedef typename MatType::elem_type ElemType;
+  typedef Function<FunctionType, MatType, GradType> FullFunctionType;
+
+  const ElemType directionNorm = norm(direction);
+  if (directionNorm == 0)
+  {
+    product.zeros(coordinates.n_rows, coordinates.n_cols);
+    return;
+  }
+
+  const ElemType h = std::sqrt(std::numeric_limits<ElemType>::epsilon()) *
+      (1 + norm(coordinates)) / directionNorm;
+  const MatType perturbed = coordinates + h * direction;
+  static_cast<FullFunctionType&>(function).Gradient(perturbed, product);
+  product -= gradient;
+  product /= h;
+}
+
+} // namespace ens
+
+#endif
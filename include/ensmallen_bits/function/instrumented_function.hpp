@@ -0,0 +1,393 @@
+/**
+ * @file instrumented_function.hpp
+ *
+ * Adapter that counts the calls an optimizer makes to a function, and records
+ * a latency histogram for each kind of call.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_INSTRUMENTED_FUNCTION_HPP
+#define ENSMALLEN_FUNCTION_INSTRUMENTED_FUNCTION_HPP
+
+#include <atomic>
+#include <chrono>
+#include <type_traits>
+#include <utility>
+
+namespace ens {
+
+/**
+ * A histogram of the durations of a kind of call, with buckets on a
+ * logarithmic scale: bucket i holds the calls that took between 2^i and
+ * 2^(i + 1) nanoseconds (bucket 0 also holds the calls under 1 nanosecond,
+ * and the last bucket all the calls over 2^(NumBuckets - 1) nanoseconds, about
+ * 2 seconds).  The counters are atomic, so calls may be added from several
+ * threads.
+ */
+class LatencyHistogram
+{
+ public:
+  //! The number of buckets.
+  static const size_t NumBuckets = 32;
+
+  //! Create an empty histogram.
+  LatencyHistogram() { Reset(); }
+
+  //! Add a call that took the given time, in nanoseconds.
+  void Add(const uint64_t elapsed)
+  {
+    calls.fetch_add(1, std::memory_order_relaxed);
+    nanoseconds.fetch_add(elapsed, std::memory_order_relaxed);
+
+    // The bucket is the position of the highest set bit.
+    size_t bucket = 0;
+    for (uint64_t t = elapsed >> 1; t != 0 && bucket < NumBuckets - 1; t >>= 1)
+      ++bucket;
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  //! Count a call that was not timed.
+  void Count() { calls.fetch_add(1, std::memory_order_relaxed); }
+
+  //! Get the number of calls.
+  size_t Calls() const { return calls.load(std::memory_order_relaxed); }
+
+  //! Get the total time of the timed calls, in seconds.
+  double Seconds() const
+  {
+    return 1e-9 * nanoseconds.load(std::memory_order_relaxed);
+  }
+
+  //! Get the number of timed calls in the given bucket.
+  size_t Bucket(const size_t i) const
+  {
+    return buckets[i].load(std::memory_order_relaxed);
+  }
+
+  //! Get the smallest duration of the given bucket, in seconds.
+  static double BucketSeconds(const size_t i)
+  {
+    return (i == 0) ? 0.0 : 1e-9 * double(uint64_t(1) << i);
+  }
+
+  /**
+   * Get an upper bound on the given quantile of the durations of the timed
+   * calls, in seconds: the upper end of the bucket that holds it (at most a
+   * factor of 2 above the true quantile).  This is 0 if no call was timed.
+   *
+   * @param q Quantile, between 0 and 1 (for instance, 0.5 for the median).
+   */
+  double Quantile(const double q) const
+  {
+    size_t total = 0;
+    for (size_t i = 0; i < NumBuckets; ++i)
+      total += Bucket(i);
+    if (total == 0)
+      return 0.0;
+
+    const double target = q * total;
+    size_t seen = 0;
+    for (size_t i = 0; i < NumBuckets - 1; ++i)
+    {
+      seen += Bucket(i);
+      if (seen > 0 && seen >= target)
+        return BucketSeconds(i + 1);
+    }
+
+    return BucketSeconds(NumBuckets - 1);
+  }
+
+  //! Zero the counters.
+  void Reset()
+  {
+    calls.store(0, std::memory_order_relaxed);
+    nanoseconds.store(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < NumBuckets; ++i)
+      buckets[i].store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  //! The number of calls.
+  std::atomic<uint64_t> calls;
+  //! The total time of the timed calls, in nanoseconds.
+  std::atomic<uint64_t> nanoseconds;
+  //! The number of timed calls in each bucket.
+  std::atomic<uint64_t> buckets[NumBuckets];
+};
+
+/**
+ * InstrumentedFunction wraps any function and counts the Evaluate(),
+ * Gradient() and EvaluateWithGradient() calls made to it, with a latency
+ * histogram for each (see LatencyHistogram).  Comparing the time spent in the
+ * function with the run time of the optimization tells whether an optimizer is
+ * bound by the evaluations or by its own overhead.
+ *
+ * @code
+ * RosenbrockFunction f;
+ * InstrumentedFunction<RosenbrockFunction> instrumentedF(f);
+ *
+ * L_BFGS lbfgs;
+ * arma::mat coordinates = f.GetInitialPoint();
+ * lbfgs.Optimize(instrumentedF, coordinates);
+ * std::cout << instrumentedF.EvaluateWithGradientCalls().Calls() << " calls, "
+ *     << instrumentedF.Seconds() << "s in the function." << std::endl;
+ * @endcode
+ *
+ * The wrapper is transparent: it has exactly the methods of the wrapped
+ * function among the decomposable and non-decomposable Evaluate(), Gradient()
+ * and EvaluateWithGradient(), NumFunctions() and Shuffle(), so the Function<>
+ * wrapper of the optimizers detects the same methods and fills in the missing
+ * ones the same way, and the counts are of the calls made to the methods the
+ * wrapped function actually implements.  (For instance, if the function only
+ * has EvaluateWithGradient(), an Evaluate() call by the optimizer is counted
+ * as an EvaluateWithGradient() call.)  A call on a batch of a separable
+ * function counts once.  The methods of the wrapper are const (only the atomic
+ * counters change), and ThreadSafe is true if the wrapped function is safe to
+ * evaluate concurrently (see traits::IsThreadSafeFunction), so population
+ * optimizers evaluate the wrapper in parallel exactly when they would evaluate
+ * the wrapped function in parallel.
+ *
+ * Each call costs a few relaxed atomic additions, and two reads of the steady
+ * clock if timing is enabled; the counters may be updated from several
+ * threads.  (The methods of the wrapped function must then be safe to call
+ * concurrently.)
+ *
+ * @tparam FunctionType Type of the function to wrap.
+ */
+template<typename FunctionType>
+class InstrumentedFunction
+{
+ public:
+  //! The wrapper may be evaluated concurrently if the wrapped function may.
+  typedef std::integral_constant<bool,
+      traits::IsThreadSafeFunction<FunctionType>::value> ThreadSafe;
+
+  /**
+   * Wrap the given function.  The function is held by reference, so it must
+   * outlive the wrapper.
+   *
+   * @param function Function to wrap.
+   * @param timed Whether to time the calls (otherwise they are only counted).
+   */
+  InstrumentedFunction(FunctionType& function, const bool timed = true) :
+      function(function),
+      timed(timed)
+  { /* Nothing to do. */ }
+
+  /**
+   * Return the objective at the given coordinates.
+   *
+   * @param coordinates The point to evaluate the objective at.
+   */
+  template<typename MatType, typename F = FunctionType>
+  auto Evaluate(const MatType& coordinates) const
+      -> decltype(std::declval<F&>().Evaluate(coordinates))
+  {
+    const Clock::time_point start = Start();
+    auto objective = function.Evaluate(coordinates);
+    Stop(evaluateCalls, start);
+    return objective;
+  }
+
+  /**
+   * Compute the gradient at the given coordinates.
+   *
+   * @param coordinates The point to compute the gradient at.
+   * @param gradient Matrix to store the gradient in.
+   */
+  template<typename MatType, typename GradType, typename F = FunctionType>
+  auto Gradient(const MatType& coordinates, GradType& gradient) const
+      -> decltype(std::declval<F&>().Gradient(coordinates,
+          gradient))
+  {
+    const Clock::time_point start = Start();
+    function.Gradient(coordinates, gradient);
+    Stop(gradientCalls, start);
+  }
+
+  /**
+   * Return the objective and compute the gradient at the given coordinates.
+   *
+   * @param coordinates The point to evaluate at.
+   * @param gradient Matrix to store the gradient in.
+   */
+  template<typename MatType, typename GradType, typename F = FunctionType>
+  auto EvaluateWithGradient(const MatType& coordinates,
+                            GradType& gradient) const
+      -> decltype(std::declval<F&>().EvaluateWithGradient(
+          coordinates, gradient))
+  {
+    const Clock::time_point start = Start();
+    auto objective = function.EvaluateWithGradient(coordinates, gradient);
+    Stop(evaluateWithGradientCalls, start);
+    return objective;
+  }
+
+  /**
+   * Return the objective of the functions in the given batch.
+   *
+   * @param coordinates The point to evaluate the objective at.
+   * @param begin The first function in the batch.
+   * @param batchSize The number of functions in the batch.
+   */
+  template<typename MatType, typename F = FunctionType>
+  auto Evaluate(const MatType& coordinates,
+                const size_t begin,
+                const size_t batchSize) const
+      -> decltype(std::declval<F&>().Evaluate(coordinates, begin,
+          batchSize))
+  {
+    const Clock::time_point start = Start();
+    auto objective = function.Evaluate(coordinates, begin, batchSize);
+    Stop(evaluateCalls, start);
+    return objective;
+  }
+
+  /**
+   * Compute the gradient of the functions in the given batch.
+   *
+   * @param coordinates The point to compute the gradient at.
+   * @param begin The first function in the batch.
+   * @param gradient Matrix to store the gradient in.
+   * @param batchSize The number of functions in the batch.
+   */
+  template<typename MatType, typename GradType, typename F = FunctionType>
+  auto Gradient(const MatType& coordinates,
+                const size_t begin,
+                GradType& gradient,
+                const size_t batchSize) const
+      -> decltype(std::declval<F&>().Gradient(coordinates, begin,
+          gradient, batchSize))
+  {
+    const Clock::time_point start = Start();
+    function.Gradient(coordinates, begin, gradient, batchSize);
+    Stop(gradientCalls, start);
+  }
+
+  /**
+   * Return the objective and compute the gradient of the functions in the
+   * given batch.
+   *
+   * @param coordinates The point to evaluate at.
+   * @param begin The first function in the batch.
+   * @param gradient Matrix to store the gradient in.
+   * @param batchSize The number of functions in the batch.
+   */
+  template<typename MatType, typename GradType, typename F = FunctionType>
+  auto EvaluateWithGradient(const MatType& coordinates,
+                            const size_t begin,
+                            GradType& gradient,
+                            const size_t batchSize) const
+      -> decltype(std::declval<F&>().EvaluateWithGradient(
+          coordinates, begin, gradient, batchSize))
+  {
+    const Clock::time_point start = Start();
+    auto objective = function.EvaluateWithGradient(coordinates, begin,
+        gradient, batchSize);
+    Stop(evaluateWithGradientCalls, start);
+    return objective;
+  }
+
+  //! Return the number of separable functions of the wrapped function.
+  template<typename F = FunctionType>
+  auto NumFunctions() const -> decltype(std::declval<F&>().NumFunctions())
+  {
+    return function.NumFunctions();
+  }
+
+  //! Shuffle the order of function visitation of the wrapped function.
+  template<typename F = FunctionType>
+  auto Shuffle() -> decltype(std::declval<F&>().Shuffle())
+  {
+    function.Shuffle();
+  }
+
+  //! Get the histogram of the Evaluate() calls.
+  const LatencyHistogram& EvaluateCalls() const { return evaluateCalls; }
+
+  //! Get the histogram of the Gradient() calls.
+  const LatencyHistogram& GradientCalls() const { return gradientCalls; }
+
+  //! Get the histogram of the EvaluateWithGradient() calls.
+  const LatencyHistogram& EvaluateWithGradientCalls() const
+  {
+    return evaluateWithGradientCalls;
+  }
+
+  //! Get the total number of calls.
+  size_t Calls() const
+  {
+    return evaluateCalls.Calls() + gradientCalls.Calls() +
+        evaluateWithGradientCalls.Calls();
+  }
+
+  //! Get the total time spent in the wrapped function, in seconds.
+  double Seconds() const
+  {
+    return evaluateCalls.Seconds() + gradientCalls.Seconds() +
+        evaluateWithGradientCalls.Seconds();
+  }
+
+  //! Zero the counters.
+  void Reset()
+  {
+    evaluateCalls.Reset();
+    gradientCalls.Reset();
+    evaluateWithGradientCalls.Reset();
+  }
+
+  //! Get whether the calls are timed.
+  bool Timed() const { return timed; }
+  //! Modify whether the calls are timed.
+  bool& Timed() { return timed; }
+
+  //! Get the wrapped function.
+  const FunctionType& WrappedFunction() const { return function; }
+  //! Modify the wrapped function.
+  FunctionType& WrappedFunction() { return function; }
+
+ private:
+  //! The clock used to time the calls.
+  typedef std::chrono::steady_clock Clock;
+
+  //! Get the start time of a call, if calls are timed.
+  Clock::time_point Start() const
+  {
+    return timed ? Clock::now() : Clock::time_point();
+  }
+
+  //! Record a call that started at the given time.
+  void Stop(LatencyHistogram& histogram,
+            const Clock::time_point start) const
+  {
+    if (timed)
+    {
+      histogram.Add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          Clock::now() - start).count());
+    }
+    else
+    {
+      histogram.Count();
+    }
+  }
+
+  //! The wrapped function.
+  FunctionType& function;
+
+  //! Whether the calls are timed.
+  bool timed;
+
+  //! The histogram of the Evaluate() calls.
+  mutable LatencyHistogram evaluateCalls;
+  //! The histogram of the Gradient() calls.
+  mutable LatencyHistogram gradientCalls;
+  //! The histogram of the EvaluateWithGradient() calls.
+  mutable LatencyHistogram evaluateWithGradientCalls;
+};
+
+} // namespace ens
+
+#endif
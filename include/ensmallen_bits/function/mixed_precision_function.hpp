@@ -0,0 +1,327 @@
+/**
+ * @file mixed_precision_function.hpp
+ *
+ * Adapter for separable functions that evaluates each batch in a lower
+ * precision than the iterate of the optimizer, with optional dynamic loss
+ * scaling.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_MIXED_PRECISION_FUNCTION_HPP
+#define ENSMALLEN_FUNCTION_MIXED_PRECISION_FUNCTION_HPP
+
+namespace ens {
+
+/**
+ * MixedPrecisionFunction wraps a separable function that is evaluated in a
+ * lower precision (by default, on arma::fmat), so that it can be optimized
+ * with a double-precision iterate.  The optimizer, the update policy and its
+ * state (the moments of Adam, the velocity of momentum, ...) all work on the
+ * double-precision "master" iterate, so that the accumulation of many small
+ * updates does not lose precision; for each batch, the iterate is rounded
+ * into a low-precision copy, the wrapped function computes the objective and
+ * the gradient on it, and the gradient is converted back to double.  For
+ * instance:
+ *
+ * @code
+ * // A function with EvaluateWithGradient(const arma::fmat&, const size_t,
+ * // arma::fmat&, const size_t).
+ * MyFloatFunction f;
+ * MixedPrecisionFunction<MyFloatFunction> mixedF(f);
+ *
+ * Adam adam(0.001, 32);
+ * arma::mat coordinates = arma::conv_to<arma::mat>::from(f.GetInitialPoint());
+ * adam.Optimize(mixedF, coordinates);
+ * @endcode
+ *
+ * With dynamic loss scaling, a function that implements
+ *
+ * @code
+ * double& LossScale();
+ * @endcode
+ *
+ * is given a scale S before each batch, and must return its objective and
+ * gradient multiplied by S (for instance, by scaling its loss before the
+ * backward pass), so that small gradient components do not underflow in low
+ * precision; the adapter divides them by S in double precision.  If the
+ * low-precision gradient of a batch is not finite, the scale was too large:
+ * the batch is skipped (its gradient is zero, and its objective is estimated
+ * from the last finite batch), and the scale is multiplied by backoffFactor.
+ * After growthInterval batches in a row with finite gradients, the scale is
+ * multiplied by growthFactor.  For functions without LossScale(), the scale is
+ * always 1, but batches with non-finite gradients are still skipped.
+ *
+ * The separable methods of the wrapped function must accept the low-precision
+ * matrix type, and the iterate must be a dense Armadillo matrix.  The adapter
+ * holds the low-precision copies of the iterate and of the gradient, which are
+ * reused between batches, so it must not be evaluated from several threads at
+ * once.
+ *
+ * @tparam FunctionType Type of the separable function to wrap.
+ * @tparam LowMatType Matrix type the wrapped function is evaluated on.
+ */
+template<typename FunctionType, typename LowMatType = arma::fmat>
+class MixedPrecisionFunction
+{
+ public:
+  /**
+   * Wrap the given function.  The function is held by reference, so it must
+   * outlive the wrapper.
+   *
+   * @param function Separable function to wrap.
+   * @param dynamicLossScaling Whether to adapt the loss scale to the gradients.
+   * @param initialScale Initial loss scale (only used with dynamic loss
+   *     scaling, for functions with a LossScale() method).
+   * @param growthInterval Number of batches in a row with finite gradients
+   *     after which the loss scale grows.
+   * @param growthFactor Factor the loss scale grows by.
+   * @param backoffFactor Factor the loss scale shrinks by when a gradient is
+   *     not finite.
+   */
+  MixedPrecisionFunction(FunctionType& function,
+                         const bool dynamicLossScaling = false,
+                         const double initialScale = 65536.0,
+                         const size_t growthInterval = 2000,
+                         const double growthFactor = 2.0,
+                         const double backoffFactor = 0.5) :
+      function(function),
+      dynamicLossScaling(dynamicLossScaling),
+      lossScale(dynamicLossScaling ? initialScale : 1.0),
+      growthInterval(growthInterval),
+      growthFactor(growthFactor),
+      backoffFactor(backoffFactor),
+      finiteBatches(0),
+      skippedBatches(0),
+      lastObjective(0.0)
+  {
+    if (dynamicLossScaling && (initialScale <= 0.0 || growthFactor < 1.0 ||
+        backoffFactor <= 0.0 || backoffFactor >= 1.0))
+    {
+      throw std::invalid_argument("MixedPrecisionFunction: the initial scale "
+          "must be positive, the growth factor at least 1 and the backoff "
+          "factor in (0, 1)!");
+    }
+  }
+
+  //! Return the number of separable functions of the wrapped function.
+  size_t NumFunctions() const { return function.NumFunctions(); }
+
+  //! Shuffle the order of function visitation of the wrapped function.
+  void Shuffle() { function.Shuffle(); }
+
+  /**
+   * Evaluate the objective of the functions in the given batch, on the
+   * low-precision copy of the coordinates.
+   *
+   * @param coordinates The coordinates to evaluate at.
+   * @param begin The first function in the batch.
+   * @param batchSize The number of functions in the batch.
+   */
+  template<typename MatType>
+  typename MatType::elem_type Evaluate(const MatType& coordinates,
+                                       const size_t begin,
+                                       const size_t batchSize)
+  {
+    typedef Function<FunctionType, LowMatType, LowMatType> FullFunctionType;
+    FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+    Convert(coordinates, lowCoordinates);
+    const double scale = ApplyLossScale();
+    return f.Evaluate(lowCoordinates, begin, batchSize) / scale;
+  }
+
+  /**
+   * Compute the gradient of the functions in the given batch on the
+   * low-precision copy of the coordinates, and convert it to the gradient
+   * type of the optimizer.
+   *
+   * @param coordinates The coordinates to evaluate at.
+   * @param begin The first function in the batch.
+   * @param gradient Matrix to store the gradient in.
+   * @param batchSize The number of functions in the batch.
+   */
+  template<typename MatType, typename GradType>
+  void Gradient(const MatType& coordinates,
+                const size_t begin,
+                GradType& gradient,
+                const size_t batchSize)
+  {
+    typedef Function<FunctionType, LowMatType, LowMatType> FullFunctionType;
+    FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+    Convert(coordinates, lowCoordinates);
+    const double scale = ApplyLossScale();
+    f.Gradient(lowCoordinates, begin, lowGradient, batchSize);
+    ConvertGradient(gradient, scale);
+  }
+
+  /**
+   * Compute the objective and the gradient of the functions in the given batch
+   * on the low-precision copy of the coordinates, and convert the gradient to
+   * the gradient type of the optimizer.
+   *
+   * @param coordinates The coordinates to evaluate at.
+   * @param begin The first function in the batch.
+   * @param gradient Matrix to store the gradient in.
+   * @param batchSize The number of functions in the batch.
+   */
+  template<typename MatType, typename GradType>
+  typename MatType::elem_type EvaluateWithGradient(const MatType& coordinates,
+                                                   const size_t begin,
+                                                   GradType& gradient,
+                                                   const size_t batchSize)
+  {
+    typedef Function<FunctionType, LowMatType, LowMatType> FullFunctionType;
+    FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+    Convert(coordinates, lowCoordinates);
+    const double scale = ApplyLossScale();
+    const double objective = f.EvaluateWithGradient(lowCoordinates, begin,
+        lowGradient, batchSize) / scale;
+
+    if (!ConvertGradient(gradient, scale))
+      return lastObjective * batchSize;
+
+    lastObjective = objective / std::max(batchSize, (size_t) 1);
+    return objective;
+  }
+
+  //! Get the wrapped function.
+  const FunctionType& WrappedFunction() const { return function; }
+  //! Modify the wrapped function.
+  FunctionType& WrappedFunction() { return function; }
+
+  //! Get whether the loss scale adapts to the gradients.
+  bool DynamicLossScaling() const { return dynamicLossScaling; }
+  //! Modify whether the loss scale adapts to the gradients.
+  bool& DynamicLossScaling() { return dynamicLossScaling; }
+
+  //! Get the current loss scale.
+  double LossScale() const { return lossScale; }
+  //! Modify the current loss scale.
+  double& LossScale() { return lossScale; }
+
+  //! Get the number of finite batches after which the loss scale grows.
+  size_t GrowthInterval() const { return growthInterval; }
+  //! Modify the number of finite batches after which the loss scale grows.
+  size_t& GrowthInterval() { return growthInterval; }
+
+  //! Get the factor the loss scale grows by.
+  double GrowthFactor() const { return growthFactor; }
+  //! Modify the factor the loss scale grows by.
+  double& GrowthFactor() { return growthFactor; }
+
+  //! Get the factor the loss scale shrinks by.
+  double BackoffFactor() const { return backoffFactor; }
+  //! Modify the factor the loss scale shrinks by.
+  double& BackoffFactor() { return backoffFactor; }
+
+  //! Get the number of batches skipped because their gradient was not finite.
+  size_t SkippedBatches() const { return skippedBatches; }
+
+ private:
+  //! Copy a dense matrix into a matrix of another element type, reusing its
+  //! memory.
+  template<typename FromType, typename ToType>
+  static void Convert(const FromType& from, ToType& to)
+  {
+    to.set_size(from.n_rows, from.n_cols);
+    std::copy(from.memptr(), from.memptr() + from.n_elem, to.memptr());
+  }
+
+  //! Give the loss scale to the wrapped function, and return it.
+  template<typename F = FunctionType>
+  typename std::enable_if<traits::HasLossScale<F,
+      traits::LossScaleForm>::value, double>::type
+  ApplyLossScale()
+  {
+    function.LossScale() = lossScale;
+    return lossScale;
+  }
+
+  //! Functions without a LossScale() method are not scaled.
+  template<typename F = FunctionType>
+  typename std::enable_if<!traits::HasLossScale<F,
+      traits::LossScaleForm>::value, double>::type
+  ApplyLossScale()
+  {
+    return 1.0;
+  }
+
+  /**
+   * Convert the low-precision gradient into the given gradient and undo the
+   * loss scale.  If the gradient is not finite, the gradient is zeroed and
+   * false is returned.  With dynamic loss scaling, the scale is updated.
+   */
+  template<typename GradType>
+  bool ConvertGradient(GradType& gradient, const double scale)
+  {
+    typedef typename GradType::elem_type ElemType;
+
+    if (!lowGradient.is_finite())
+    {
+      gradient.zeros(lowGradient.n_rows, lowGradient.n_cols);
+      ++skippedBatches;
+      finiteBatches = 0;
+      if (dynamicLossScaling)
+        lossScale *= backoffFactor;
+
+      Warn << "MixedPrecisionFunction: skipped a batch with a non-finite "
+          << "gradient; the loss scale is now " << lossScale << "."
+          << std::endl;
+      return false;
+    }
+
+    Convert(lowGradient, gradient);
+    if (scale != 1.0)
+      gradient /= ElemType(scale);
+
+    if (dynamicLossScaling && ++finiteBatches >= growthInterval)
+    {
+      lossScale *= growthFactor;
+      finiteBatches = 0;
+    }
+
+    return true;
+  }
+
+  //! The wrapped function.
+  FunctionType& function;
+
+  //! Whether the loss scale adapts to the gradients.
+  bool dynamicLossScaling;
+
+  //! The current loss scale.
+  double lossScale;
+
+  //! The number of finite batches after which the loss scale grows.
+  size_t growthInterval;
+
+  //! The factor the loss scale grows by.
+  double growthFactor;
+
+  //! The factor the loss scale shrinks by.
+  double backoffFactor;
+
+  //! The number of batches in a row with finite gradients.
+  size_t finiteBatches;
+
+  //! The number of skipped batches.
+  size_t skippedBatches;
+
+  //! The objective per function of the last finite batch.
+  double lastObjective;
+
+  //! The low-precision copy of the coordinates.
+  LowMatType lowCoordinates;
+
+  //! The low-precision gradient.
+  LowMatType lowGradient;
+};
+
+} // namespace ens
+
+#endif
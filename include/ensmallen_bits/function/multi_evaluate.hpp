@@ -0,0 +1,88 @@
+/**
+ * @file multi_evaluate.hpp
+ *
+ * Utility that computes the objectives and the gradients of one batch of a
+ * separable function at several points, as needed to train several models in
+ * lockstep (MultiSGD).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_MULTI_EVALUATE_HPP
+#define ENSMALLEN_FUNCTION_MULTI_EVALUATE_HPP
+
+#include <type_traits>
+
+namespace ens {
+
+/**
+ * Compute the objectives and the gradients of the functions in the given
+ * batch at every slice of the given cube of points.  This version is used when
+ * the function implements
+ *
+ * @code
+ * void MultiEvaluateWithGradient(const arma::Cube<ElemType>& coordinates,
+ *                                const size_t begin,
+ *                                arma::Cube<ElemType>& gradients,
+ *                                arma::Col<ElemType>& objectives,
+ *                                const size_t batchSize);
+ * @endcode
+ *
+ * (possibly const), which can compute all of them in a single pass over the
+ * data of the batch (for instance, with one matrix product of the batch with
+ * all the points).  Otherwise, the separable EvaluateWithGradient() is called
+ * once for each point, one after the other, so the data of the batch is
+ * still in cache for all but the first point.
+ *
+ * @param function Separable function to differentiate.
+ * @param coordinates The points (one per slice).
+ * @param begin The first function in the batch.
+ * @param gradients Cube to store the gradient at each point in (it must have
+ *     the size of the coordinates).
+ * @param objectives Vector to store the objective at each point in.
+ * @param batchSize The number of functions in the batch.
+ */
+template<typename FunctionType, typename ElemType>
+typename std::enable_if<traits::HasMultiBatchEvaluateWithGradient<
+    FunctionType, arma::Mat<ElemType>>::value>::type
+MultiBatchEvaluateWithGradient(FunctionType& function,
+                               const arma::Cube<ElemType>& coordinates,
+                               const size_t begin,
+                               arma::Cube<ElemType>& gradients,
+                               arma::Col<ElemType>& objectives,
+                               const size_t batchSize)
+{
+  function.MultiEvaluateWithGradient(coordinates, begin, gradients, objectives,
+      batchSize);
+}
+
+//! Compute the objectives and the gradients of the functions in the given
+//! batch at every point, with one call to the separable EvaluateWithGradient()
+//! for each point.
+template<typename FunctionType, typename ElemType>
+typename std::enable_if<!traits::HasMultiBatchEvaluateWithGradient<
+    FunctionType, arma::Mat<ElemType>>::value>::type
+MultiBatchEvaluateWithGradient(FunctionType& function,
+                               const arma::Cube<ElemType>& coordinates,
+                               const size_t begin,
+                               arma::Cube<ElemType>& gradients,
+                               arma::Col<ElemType>& objectives,
+                               const size_t batchSize)
+{
+  typedef Function<FunctionType, arma::Mat<ElemType>, arma::Mat<ElemType>>
+      FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  objectives.set_size(coordinates.n_slices);
+  for (size_t k = 0; k < coordinates.n_slices; ++k)
+  {
+    objectives[k] = f.EvaluateWithGradient(coordinates.slice(k), begin,
+        gradients.slice(k), batchSize);
+  }
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,111 @@
+/**
+ * @file objective_cache.hpp
+ *
+ * Utilities that let a partially differentiable function track its objective
+ * incrementally while coordinate descent changes one feature at a time.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_OBJECTIVE_CACHE_HPP
+#define ENSMALLEN_FUNCTION_OBJECTIVE_CACHE_HPP
+
+#include <type_traits>
+
+namespace ens {
+
+/**
+ * Set up the objective cache of the function for the given coordinates.  This
+ * version is used when the function implements
+ *
+ * @code
+ * // Compute the cached quantities (for instance, the residual or the margin
+ * // of each point) at the given coordinates.
+ * void ResetCache(const arma::mat& coordinates);
+ *
+ * // Update the cached quantities after feature j (column j of the
+ * // coordinates) changed by delta; coordinates holds the new values.
+ * void UpdateCache(const arma::mat& coordinates,
+ *                  const size_t j,
+ *                  const arma::mat& delta);
+ *
+ * // Return the objective at the cached coordinates.
+ * double CachedEvaluate();
+ * @endcode
+ *
+ * (CachedEvaluate() may be const).  Otherwise, nothing is done.
+ *
+ * @param function Function to set up the cache of.
+ * @param coordinates The current coordinates.
+ */
+template<typename FunctionType>
+typename std::enable_if<traits::HasObjectiveCache<FunctionType>::value>::type
+ResetObjectiveCache(FunctionType& function, const arma::mat& coordinates)
+{
+  function.ResetCache(coordinates);
+}
+
+//! Functions without an objective cache have nothing to set up.
+template<typename FunctionType>
+typename std::enable_if<!traits::HasObjectiveCache<FunctionType>::value>::type
+ResetObjectiveCache(FunctionType& /* function */,
+                    const arma::mat& /* coordinates */)
+{ }
+
+/**
+ * Update the objective cache of the function after feature j changed by delta,
+ * if the function has one.
+ *
+ * @param function Function to update the cache of.
+ * @param coordinates The new coordinates.
+ * @param j The feature that changed.
+ * @param delta The change of column j of the coordinates.
+ */
+template<typename FunctionType>
+typename std::enable_if<traits::HasObjectiveCache<FunctionType>::value>::type
+UpdateObjectiveCache(FunctionType& function,
+                     const arma::mat& coordinates,
+                     const size_t j,
+                     const arma::mat& delta)
+{
+  function.UpdateCache(coordinates, j, delta);
+}
+
+//! Functions without an objective cache have nothing to update.
+template<typename FunctionType>
+typename std::enable_if<!traits::HasObjectiveCache<FunctionType>::value>::type
+UpdateObjectiveCache(FunctionType& /* function */,
+                     const arma::mat& /* coordinates */,
+                     const size_t /* j */,
+                     const arma::mat& /* delta */)
+{ }
+
+/**
+ * Return the objective at the given coordinates, from the objective cache of
+ * the function if it has one.
+ *
+ * @param function Function to evaluate.
+ * @param coordinates The current coordinates.
+ */
+template<typename FunctionType>
+typename std::enable_if<traits::HasObjectiveCache<FunctionType>::value,
+    double>::type
+CachedObjective(FunctionType& function, const arma::mat& /* coordinates */)
+{
+  return function.CachedEvaluate();
+}
+
+//! Functions without an objective cache are evaluated from scratch.
+template<typename FunctionType>
+typename std::enable_if<!traits::HasObjectiveCache<FunctionType>::value,
+    double>::type
+CachedObjective(FunctionType& function, const arma::mat& coordinates)
+{
+  return function.Evaluate(coordinates);
+}
+
+} // namespace ens
+
+#endif
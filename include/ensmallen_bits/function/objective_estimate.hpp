@@ -0,0 +1,167 @@
+/**
+ * @file objective_estimate.hpp
+ *
+ * A choice of how stochastic optimizers compute the objective they report and
+ * return: exactly with a pass over the data, from a random subsample, or by
+ * reusing the objectives they already computed.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_OBJECTIVE_ESTIMATE_HPP
+#define ENSMALLEN_FUNCTION_OBJECTIVE_ESTIMATE_HPP
+
+#include "full_pass.hpp"
+
+namespace ens {
+
+/**
+ * ObjectiveEstimate tells an optimizer over a separable function how to
+ * compute the objective that it returns at the end of the optimization (and,
+ * for SVRG and Katyusha, the objective that is computed before every outer
+ * iteration for the convergence check).  There are three choices:
+ *
+ *  - Exact() (the default): evaluate every function, which takes a full pass
+ *    over the data;
+ *
+ *  - Subsample(size): evaluate the functions of randomly chosen batches,
+ *    about size functions in total, and scale their sum up to the number of
+ *    functions, which estimates the objective at a fraction of the cost;
+ *
+ *  - Reuse(): take no extra evaluations, and reuse the objectives that the
+ *    optimizer already computed during the optimization.  For SGD-like
+ *    optimizers, this is the sum of the batch objectives over the last pass
+ *    over the data (each one computed before its step, and scaled up if the
+ *    pass is not complete); for SVRG and Katyusha, each objective is computed
+ *    together with the full gradient, in one pass instead of two, and the
+ *    objective returned is the one of the last outer iteration.
+ *
+ * @code
+ * // Skip the final pass over the data.
+ * StandardSGD sgd;
+ * sgd.ObjectiveEstimate() = ObjectiveEstimate::Reuse();
+ * @endcode
+ */
+class ObjectiveEstimate
+{
+ public:
+  //! Compute the objective exactly (the default).
+  ObjectiveEstimate() : reuse(false), subsampleSize(0) { }
+
+  //! Compute the objective exactly, with a pass over all the functions.
+  static ObjectiveEstimate Exact() { return ObjectiveEstimate(); }
+
+  /**
+   * Estimate the objective from randomly chosen batches holding about the
+   * given number of functions.
+   *
+   * @param size Number of functions to evaluate (0 means all of them).
+   */
+  static ObjectiveEstimate Subsample(const size_t size)
+  {
+    ObjectiveEstimate estimate;
+    estimate.subsampleSize = size;
+    return estimate;
+  }
+
+  //! Reuse the objectives computed during the optimization.
+  static ObjectiveEstimate Reuse()
+  {
+    ObjectiveEstimate estimate;
+    estimate.reuse = true;
+    return estimate;
+  }
+
+  //! Get whether the objectives computed during the optimization are reused.
+  bool IsReuse() const { return reuse; }
+
+  //! Get the number of functions of the subsample (0 for all the functions).
+  size_t SubsampleSize() const { return subsampleSize; }
+
+  /**
+   * Compute the objective of the given separable function, exactly or from a
+   * subsample (this is not used with Reuse()).  The batches of the subsample
+   * are the batches of batchSize functions of a pass over the data, chosen at
+   * random without replacement.
+   *
+   * @param function Separable function to evaluate.
+   * @param coordinates The coordinates to evaluate at.
+   * @param batchSize Number of functions to evaluate per call.
+   * @param parallel Whether to evaluate the batches in parallel (see
+   *     FullPassEvaluate()).
+   * @return The objective, or its estimate.
+   */
+  template<typename FunctionType, typename MatType>
+  typename MatType::elem_type Evaluate(FunctionType& function,
+                                       const MatType& coordinates,
+                                       const size_t batchSize,
+                                       const bool parallel = false) const
+  {
+    const size_t numFunctions = function.NumFunctions();
+    if (subsampleSize == 0 || subsampleSize >= numFunctions)
+      return FullPassEvaluate(function, coordinates, batchSize, parallel);
+
+    const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+    const size_t sampledBatches = std::min(numBatches,
+        (subsampleSize + batchSize - 1) / batchSize);
+    const arma::uvec batches = arma::randperm(numBatches);
+
+    size_t evaluated = 0;
+    for (size_t b = 0; b < sampledBatches; ++b)
+    {
+      const size_t begin = batches[b] * batchSize;
+      evaluated += std::min(batchSize, numFunctions - begin);
+    }
+
+    typename MatType::elem_type objective = 0;
+    if (parallel && DeterministicReductions())
+    {
+      // Sum fixed chunks of the sampled batches, so that the estimate does
+      // not depend on the number of threads.
+      typedef typename MatType::elem_type ElemType;
+      const size_t chunks = DeterministicChunkCount(sampledBatches);
+      std::vector<ElemType> objectives(chunks, ElemType(0));
+      ParallelFor(chunks, [&](const size_t c)
+      {
+        for (size_t b = (c * sampledBatches) / chunks;
+             b < ((c + 1) * sampledBatches) / chunks; ++b)
+        {
+          const size_t begin = batches[b] * batchSize;
+          objectives[c] += function.Evaluate(coordinates, begin,
+              std::min(batchSize, numFunctions - begin));
+        }
+      });
+
+      TreeReduce(chunks, [&](const size_t c) -> ElemType&
+          { return objectives[c]; });
+      objective = objectives[0];
+    }
+    else
+    {
+      #ifdef ENS_USE_OPENMP
+        #pragma omp parallel for schedule(static) reduction(+:objective) \
+            if(parallel)
+      #endif
+      for (size_t b = 0; b < sampledBatches; ++b)
+      {
+        const size_t begin = batches[b] * batchSize;
+        objective += function.Evaluate(coordinates, begin,
+            std::min(batchSize, numFunctions - begin));
+      }
+    }
+
+    return objective * ((double) numFunctions / evaluated);
+  }
+
+ private:
+  //! Whether the objectives computed during the optimization are reused.
+  bool reuse;
+  //! The number of functions of the subsample (0 for all the functions).
+  size_t subsampleSize;
+};
+
+} // namespace ens
+
+#endif
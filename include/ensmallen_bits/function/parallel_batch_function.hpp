@@ -0,0 +1,449 @@
+/**
+ * @file parallel_batch_function.hpp
+ *
+ * Adapter for separable functions that splits the evaluation of each batch
+ * across OpenMP threads.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_PARALLEL_BATCH_FUNCTION_HPP
+#define ENSMALLEN_FUNCTION_PARALLEL_BATCH_FUNCTION_HPP
+
+#include <vector>
+
+namespace ens {
+
+/**
+ * ParallelBatchFunction wraps a separable function and evaluates each batch in
+ * a data-parallel way: the batch [begin, begin + batchSize) is split into one
+ * contiguous sub-batch per OpenMP thread, each thread computes the objective
+ * and gradient of its sub-batch into its own gradient accumulator, and the
+ * accumulators are then summed with a tree reduction.  Since the separable
+ * objective and gradient are sums over the functions in the batch, the result
+ * is the same as the serial evaluation (up to floating-point reordering).
+ *
+ * Any optimizer that uses the separable function interface can be given the
+ * wrapped function, so this gives multicore batch evaluation to SGD and every
+ * optimizer built on it (Adam, RMSProp, AdaDelta, SWATS, ...) without changing
+ * the function itself.  For instance:
+ *
+ * @code
+ * LogisticRegression<> lr(data, responses);
+ * ParallelBatchFunction<LogisticRegression<>> parallelLr(lr);
+ *
+ * Adam adam(0.001, 256);
+ * arma::mat coordinates = lr.GetInitialPoint();
+ * adam.Optimize(parallelLr, coordinates);
+ * @endcode
+ *
+ * The separable Evaluate(), Gradient() and EvaluateWithGradient() of the
+ * wrapped function will be called concurrently on disjoint ranges of
+ * functions, so they must be safe to call from multiple threads (for instance,
+ * they must not write to member variables).  Shuffle() is only ever called
+ * from a single thread.
+ *
+ * The accumulators are held by the wrapper and reused between batches, so each
+ * thread writes only to its own gradient matrix and no memory is allocated
+ * once the optimization is running.  Batches smaller than minThreadBatchSize
+ * functions per thread are split across fewer threads; if OpenMP is not
+ * enabled, or if the wrapper is used inside another parallel region, the
+ * wrapped function is simply called on the whole batch.
+ *
+ * In the deterministic reduction mode (see SetDeterministicReductions()), each
+ * batch is split into a fixed number of sub-batches instead of one per
+ * thread, which the threads evaluate in any order, and the results are added
+ * with a tree of fixed shape; then the gradients do not depend on the number
+ * of threads.
+ *
+ * @tparam FunctionType Type of the separable function to wrap.
+ */
+template<typename FunctionType>
+class ParallelBatchFunction
+{
+ public:
+  /**
+   * Wrap the given function.  The function is held by reference, so it must
+   * outlive the wrapper.
+   *
+   * @param function Separable function to wrap.
+   * @param minThreadBatchSize Minimum number of functions each thread should
+   *     evaluate; smaller batches are split across fewer threads.
+   */
+  ParallelBatchFunction(FunctionType& function,
+                        const size_t minThreadBatchSize = 1) :
+      function(function),
+      minThreadBatchSize(minThreadBatchSize)
+  { /* Nothing to do. */ }
+
+  //! Return the number of separable functions of the wrapped function.
+  size_t NumFunctions() const { return function.NumFunctions(); }
+
+  //! Shuffle the order of function visitation of the wrapped function.
+  void Shuffle() { function.Shuffle(); }
+
+  /**
+   * Evaluate the objective of the functions in the given batch, splitting the
+   * batch across threads.
+   *
+   * @param coordinates The coordinates to evaluate at.
+   * @param begin The first function in the batch.
+   * @param batchSize The number of functions in the batch.
+   */
+  template<typename MatType>
+  typename MatType::elem_type Evaluate(const MatType& coordinates,
+                                       const size_t begin,
+                                       const size_t batchSize);
+
+  /**
+   * Compute the gradient of the functions in the given batch, splitting the
+   * batch across threads and summing the per-thread gradients.
+   *
+   * @param coordinates The coordinates to evaluate at.
+   * @param begin The first function in the batch.
+   * @param gradient Matrix to store the gradient in.
+   * @param batchSize The number of functions in the batch.
+   */
+  template<typename MatType, typename GradType>
+  void Gradient(const MatType& coordinates,
+                const size_t begin,
+                GradType& gradient,
+                const size_t batchSize);
+
+  /**
+   * Compute the objective and gradient of the functions in the given batch,
+   * splitting the batch across threads and summing the per-thread results.
+   *
+   * @param coordinates The coordinates to evaluate at.
+   * @param begin The first function in the batch.
+   * @param gradient Matrix to store the gradient in.
+   * @param batchSize The number of functions in the batch.
+   */
+  template<typename MatType, typename GradType>
+  typename MatType::elem_type EvaluateWithGradient(const MatType& coordinates,
+                                                   const size_t begin,
+                                                   GradType& gradient,
+                                                   const size_t batchSize);
+
+  //! Get the wrapped function.
+  const FunctionType& WrappedFunction() const { return function; }
+  //! Modify the wrapped function.
+  FunctionType& WrappedFunction() { return function; }
+
+  //! Get the minimum number of functions per thread.
+  size_t MinThreadBatchSize() const { return minThreadBatchSize; }
+  //! Modify the minimum number of functions per thread.
+  size_t& MinThreadBatchSize() { return minThreadBatchSize; }
+
+ private:
+  //! Get the number of threads to split a batch of the given size across.
+  size_t NumThreads(const size_t batchSize) const
+  {
+    #ifdef ENS_USE_OPENMP
+      const size_t maxThreads = omp_get_max_threads();
+    #else
+      const size_t maxThreads = 1;
+    #endif
+
+    const size_t usefulThreads = batchSize /
+        std::max(minThreadBatchSize, (size_t) 1);
+    return std::max(std::min(maxThreads, usefulThreads), (size_t) 1);
+  }
+
+  //! Get at least the given number of gradient accumulators of the given type.
+  template<typename GradType>
+  std::vector<GradType>& Accumulators(const size_t numThreads)
+  {
+    return Buffers<GradType>(accumulators, numThreads);
+  }
+
+  //! Get at least the given number of elements of the vector of the given
+  //! type held by the given Any object.
+  template<typename T>
+  static std::vector<T>& Buffers(Any& holder, const size_t n)
+  {
+    if (!holder.Has<std::vector<T>>())
+      holder.Set(new std::vector<T>());
+
+    std::vector<T>& result = holder.As<std::vector<T>>();
+    if (result.size() < n)
+      result.resize(n);
+
+    return result;
+  }
+
+  //! Evaluate the objective of the given batch in the deterministic reduction
+  //! mode.
+  template<typename FullFunctionType, typename MatType>
+  typename MatType::elem_type DeterministicEvaluate(
+      FullFunctionType& f,
+      const MatType& coordinates,
+      const size_t begin,
+      const size_t batchSize);
+
+  //! Compute the gradient (and, if evaluate is true, the objective) of the
+  //! given batch in the deterministic reduction mode.
+  template<typename FullFunctionType, typename MatType, typename GradType>
+  typename MatType::elem_type DeterministicEvaluateWithGradient(
+      FullFunctionType& f,
+      const MatType& coordinates,
+      const size_t begin,
+      GradType& gradient,
+      const size_t batchSize,
+      const bool evaluate);
+
+  //! The wrapped function.
+  FunctionType& function;
+
+  //! The minimum number of functions each thread should evaluate.
+  size_t minThreadBatchSize;
+
+  //! The per-thread gradient accumulators.  Their type depends on the
+  //! gradient type given by the optimizer, so they are held in an Any object.
+  Any accumulators;
+
+  //! The objectives of the sub-batches in the deterministic reduction mode.
+  Any objectives;
+};
+
+template<typename FunctionType>
+template<typename MatType>
+typename MatType::elem_type ParallelBatchFunction<FunctionType>::Evaluate(
+    const MatType& coordinates,
+    const size_t begin,
+    const size_t batchSize)
+{
+  typedef typename MatType::elem_type ElemType;
+  typedef Function<FunctionType, MatType, MatType> FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  if (DeterministicReductions())
+    return DeterministicEvaluate(f, coordinates, begin, batchSize);
+
+  const size_t numThreads = NumThreads(batchSize);
+  if (numThreads == 1)
+    return f.Evaluate(coordinates, begin, batchSize);
+
+  ElemType objective = 0;
+  #ifdef ENS_USE_OPENMP
+    #pragma omp parallel num_threads(numThreads) reduction(+:objective)
+    {
+      const size_t threadId = omp_get_thread_num();
+      const size_t teamSize = omp_get_num_threads();
+      const size_t threadBegin = begin + (threadId * batchSize) / teamSize;
+      const size_t threadEnd = begin + ((threadId + 1) * batchSize) / teamSize;
+
+      objective += f.Evaluate(coordinates, threadBegin,
+          threadEnd - threadBegin);
+    }
+  #endif
+
+  return objective;
+}
+
+template<typename FunctionType>
+template<typename MatType, typename GradType>
+void ParallelBatchFunction<FunctionType>::Gradient(
+    const MatType& coordinates,
+    const size_t begin,
+    GradType& gradient,
+    const size_t batchSize)
+{
+  typedef Function<FunctionType, MatType, GradType> FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  if (DeterministicReductions())
+  {
+    DeterministicEvaluateWithGradient(f, coordinates, begin, gradient,
+        batchSize, false);
+    return;
+  }
+
+  const size_t numThreads = NumThreads(batchSize);
+  if (numThreads == 1)
+  {
+    f.Gradient(coordinates, begin, gradient, batchSize);
+    return;
+  }
+
+  #ifdef ENS_USE_OPENMP
+    std::vector<GradType>& gradients = Accumulators<GradType>(numThreads);
+
+    #pragma omp parallel num_threads(numThreads)
+    {
+      const size_t threadId = omp_get_thread_num();
+      const size_t teamSize = omp_get_num_threads();
+      const size_t threadBegin = begin + (threadId * batchSize) / teamSize;
+      const size_t threadEnd = begin + ((threadId + 1) * batchSize) / teamSize;
+
+      // The first thread works directly on the output.
+      GradType& threadGradient = (threadId == 0) ? gradient :
+          gradients[threadId];
+      f.Gradient(coordinates, threadBegin, threadGradient,
+          threadEnd - threadBegin);
+
+      // Tree reduction: in each round, every thread whose index is a multiple
+      // of 2 * stride adds in the partial sum held by thread (id + stride).
+      for (size_t stride = 1; stride < teamSize; stride *= 2)
+      {
+        #pragma omp barrier
+        if ((threadId % (2 * stride)) == 0 && threadId + stride < teamSize)
+          threadGradient += gradients[threadId + stride];
+      }
+    }
+  #endif
+}
+
+template<typename FunctionType>
+template<typename MatType, typename GradType>
+typename MatType::elem_type
+ParallelBatchFunction<FunctionType>::EvaluateWithGradient(
+    const MatType& coordinates,
+    const size_t begin,
+    GradType& gradient,
+    const size_t batchSize)
+{
+  typedef typename MatType::elem_type ElemType;
+  typedef Function<FunctionType, MatType, GradType> FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  if (DeterministicReductions())
+  {
+    return DeterministicEvaluateWithGradient(f, coordinates, begin, gradient,
+        batchSize, true);
+  }
+
+  const size_t numThreads = NumThreads(batchSize);
+  if (numThreads == 1)
+    return f.EvaluateWithGradient(coordinates, begin, gradient, batchSize);
+
+  ElemType objective = 0;
+  #ifdef ENS_USE_OPENMP
+    std::vector<GradType>& gradients = Accumulators<GradType>(numThreads);
+
+    #pragma omp parallel num_threads(numThreads) reduction(+:objective)
+    {
+      const size_t threadId = omp_get_thread_num();
+      const size_t teamSize = omp_get_num_threads();
+      const size_t threadBegin = begin + (threadId * batchSize) / teamSize;
+      const size_t threadEnd = begin + ((threadId + 1) * batchSize) / teamSize;
+
+      // The first thread works directly on the output.
+      GradType& threadGradient = (threadId == 0) ? gradient :
+          gradients[threadId];
+      objective += f.EvaluateWithGradient(coordinates, threadBegin,
+          threadGradient, threadEnd - threadBegin);
+
+      // Tree reduction: in each round, every thread whose index is a multiple
+      // of 2 * stride adds in the partial sum held by thread (id + stride).
+      for (size_t stride = 1; stride < teamSize; stride *= 2)
+      {
+        #pragma omp barrier
+        if ((threadId % (2 * stride)) == 0 && threadId + stride < teamSize)
+          threadGradient += gradients[threadId + stride];
+      }
+    }
+  #endif
+
+  return objective;
+}
+
+template<typename FunctionType>
+template<typename FullFunctionType, typename MatType>
+typename MatType::elem_type
+ParallelBatchFunction<FunctionType>::DeterministicEvaluate(
+    FullFunctionType& f,
+    const MatType& coordinates,
+    const size_t begin,
+    const size_t batchSize)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const size_t chunks = DeterministicChunkCount(batchSize, minThreadBatchSize);
+  if (chunks == 1)
+    return f.Evaluate(coordinates, begin, batchSize);
+
+  std::vector<ElemType>& chunkObjectives = Buffers<ElemType>(objectives,
+      chunks);
+  const size_t numThreads = std::min(NumThreads(batchSize), chunks);
+  #ifdef ENS_USE_OPENMP
+    #pragma omp parallel for schedule(static) num_threads(numThreads) \
+        if (numThreads > 1)
+  #else
+    (void) numThreads;
+  #endif
+  for (size_t c = 0; c < chunks; ++c)
+  {
+    const size_t chunkBegin = begin + (c * batchSize) / chunks;
+    const size_t chunkEnd = begin + ((c + 1) * batchSize) / chunks;
+    chunkObjectives[c] = f.Evaluate(coordinates, chunkBegin,
+        chunkEnd - chunkBegin);
+  }
+
+  TreeReduce(chunks, [&](const size_t c) -> ElemType&
+      { return chunkObjectives[c]; });
+  return chunkObjectives[0];
+}
+
+template<typename FunctionType>
+template<typename FullFunctionType, typename MatType, typename GradType>
+typename MatType::elem_type
+ParallelBatchFunction<FunctionType>::DeterministicEvaluateWithGradient(
+    FullFunctionType& f,
+    const MatType& coordinates,
+    const size_t begin,
+    GradType& gradient,
+    const size_t batchSize,
+    const bool evaluate)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const size_t chunks = DeterministicChunkCount(batchSize, minThreadBatchSize);
+  if (chunks == 1 && evaluate)
+    return f.EvaluateWithGradient(coordinates, begin, gradient, batchSize);
+  else if (chunks == 1)
+  {
+    f.Gradient(coordinates, begin, gradient, batchSize);
+    return 0;
+  }
+
+  std::vector<GradType>& gradients = Accumulators<GradType>(chunks);
+  std::vector<ElemType>& chunkObjectives = Buffers<ElemType>(objectives,
+      chunks);
+  const size_t numThreads = std::min(NumThreads(batchSize), chunks);
+  #ifdef ENS_USE_OPENMP
+    #pragma omp parallel for schedule(static) num_threads(numThreads) \
+        if (numThreads > 1)
+  #endif
+  for (size_t c = 0; c < chunks; ++c)
+  {
+    const size_t chunkBegin = begin + (c * batchSize) / chunks;
+    const size_t chunkEnd = begin + ((c + 1) * batchSize) / chunks;
+
+    // The first sub-batch works directly on the output.
+    GradType& chunkGradient = (c == 0) ? gradient : gradients[c];
+    if (evaluate)
+    {
+      chunkObjectives[c] = f.EvaluateWithGradient(coordinates, chunkBegin,
+          chunkGradient, chunkEnd - chunkBegin);
+    }
+    else
+    {
+      f.Gradient(coordinates, chunkBegin, chunkGradient,
+          chunkEnd - chunkBegin);
+      chunkObjectives[c] = 0;
+    }
+  }
+
+  TreeReduce(chunks, [&](const size_t c) -> GradType&
+      { return (c == 0) ? gradient : gradients[c]; }, numThreads > 1);
+  TreeReduce(chunks, [&](const size_t c) -> ElemType&
+      { return chunkObjectives[c]; });
+  return chunkObjectives[0];
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,111 @@
+/**
+ * @file partial_derivative.hpp
+ *
+ * Utilities that let coordinate descent compute the gradient of one feature as
+ * scalars, and pick the step size of each feature from its Lipschitz constant,
+ * if the function supports it.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_PARTIAL_DERIVATIVE_HPP
+#define ENSMALLEN_FUNCTION_PARTIAL_DERIVATIVE_HPP
+
+#include <type_traits>
+
+namespace ens {
+
+/**
+ * Compute the gradient of the function with respect to feature j (column j of
+ * the coordinates) into a dense vector with one element per row.  This version
+ * is used when the function implements
+ *
+ * @code
+ * // Return the derivative with respect to coordinates(row, j).
+ * double PartialDerivative(const arma::mat& coordinates,
+ *                          const size_t j,
+ *                          const size_t row);
+ * @endcode
+ *
+ * (possibly const), which avoids building a sparse matrix to hold what is
+ * usually a single nonzero.
+ *
+ * @param function Partially differentiable function.
+ * @param coordinates The point at which to compute the gradient.
+ * @param j The feature to compute the gradient of.
+ * @param gradient Vector to store the gradient of the feature into.
+ * @param buffer Sparse gradient storage (unused here).
+ */
+template<typename FunctionType>
+typename std::enable_if<traits::HasScalarPartialDerivative<FunctionType>::
+    value>::type
+FeatureGradient(FunctionType& function,
+                const arma::mat& coordinates,
+                const size_t j,
+                arma::vec& gradient,
+                arma::sp_mat& /* buffer */)
+{
+  gradient.set_size(coordinates.n_rows);
+  for (size_t row = 0; row < coordinates.n_rows; ++row)
+    gradient[row] = function.PartialDerivative(coordinates, j, row);
+}
+
+//! Without PartialDerivative(), the sparse PartialGradient() of the feature is
+//! computed into the given buffer.
+template<typename FunctionType>
+typename std::enable_if<!traits::HasScalarPartialDerivative<FunctionType>::
+    value>::type
+FeatureGradient(FunctionType& function,
+                const arma::mat& coordinates,
+                const size_t j,
+                arma::vec& gradient,
+                arma::sp_mat& buffer)
+{
+  function.PartialGradient(coordinates, j, buffer);
+  gradient = arma::vec(buffer.col(j));
+}
+
+/**
+ * Return the step size for feature j: one over the Lipschitz constant of its
+ * partial derivatives, which minimizes a quadratic along the feature exactly.
+ * This version is used when the function implements
+ *
+ * @code
+ * // Return the Lipschitz constant of the partial derivatives of feature j.
+ * double CoordinateLipschitz(const size_t j);
+ * @endcode
+ *
+ * (possibly const).  If the constant is not positive, the given step size is
+ * used instead.
+ *
+ * @param function Partially differentiable function.
+ * @param j The feature to take a step on.
+ * @param stepSize The step size to use without a Lipschitz constant.
+ */
+template<typename FunctionType>
+typename std::enable_if<traits::HasCoordinateLipschitzConstant<FunctionType>::
+    value, double>::type
+CoordinateStepSize(FunctionType& function,
+                   const size_t j,
+                   const double stepSize)
+{
+  const double lipschitz = function.CoordinateLipschitz(j);
+  return (lipschitz > 0.0) ? 1.0 / lipschitz : stepSize;
+}
+
+//! Without CoordinateLipschitz(), every feature uses the given step size.
+template<typename FunctionType>
+typename std::enable_if<!traits::HasCoordinateLipschitzConstant<FunctionType>::
+    value, double>::type
+CoordinateStepSize(FunctionType& /* function */,
+                   const size_t /* j */,
+                   const double stepSize)
+{
+  return stepSize;
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,54 @@
+/**
+ * @file prefetch_batch.hpp
+ *
+ * Utility that lets a separable function prepare the data of its next batch
+ * (for instance, gather it into a contiguous staging buffer) ahead of time.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_PREFETCH_BATCH_HPP
+#define ENSMALLEN_FUNCTION_PREFETCH_BATCH_HPP
+
+#include <type_traits>
+
+namespace ens {
+
+/**
+ * Tell the function which batch will be evaluated next.  This version is used
+ * when the function implements
+ *
+ * @code
+ * void PrefetchBatch(const size_t begin, const size_t batchSize);
+ * @endcode
+ *
+ * (possibly const).  The call may run on another thread while the optimizer
+ * updates the iterate, but never while another method of the function runs.
+ * Otherwise, nothing is done.
+ *
+ * @param function Separable function to prefetch the batch of.
+ * @param begin The first function in the batch.
+ * @param batchSize The number of functions in the batch.
+ */
+template<typename FunctionType>
+typename std::enable_if<traits::HasBatchPrefetch<FunctionType>::value>::type
+PrefetchBatch(FunctionType& function,
+              const size_t begin,
+              const size_t batchSize)
+{
+  function.PrefetchBatch(begin, batchSize);
+}
+
+//! Functions without a PrefetchBatch() method have nothing to prefetch.
+template<typename FunctionType>
+typename std::enable_if<!traits::HasBatchPrefetch<FunctionType>::value>::type
+PrefetchBatch(FunctionType& /* function */,
+              const size_t /* begin */,
+              const size_t /* batchSize */)
+{ }
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,143 @@
+/**
+ * @file sample_kernel.hpp
+ *
+ * The decomposable EvaluateWithGradient() that the Function<> wrapper
+ * synthesizes for separable functions without one: from a per-function kernel
+ * in a single, parallel pass if the function has one, and from its Evaluate()
+ * and Gradient() otherwise.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_SAMPLE_KERNEL_HPP
+#define ENSMALLEN_FUNCTION_SAMPLE_KERNEL_HPP
+
+#include "traits.hpp"
+
+#include <vector>
+
+namespace ens {
+
+/**
+ * The minimum number of separable functions that each thread handles in the
+ * fused EvaluateWithGradient() built from a per-function kernel; smaller
+ * batches are evaluated in the calling thread.
+ */
+#ifndef ENS_SAMPLE_KERNEL_CHUNK_SIZE
+  #define ENS_SAMPLE_KERNEL_CHUNK_SIZE 32
+#endif
+
+/**
+ * Return the objective of the given batch of a separable function and store
+ * its gradient, with the function's per-function kernel
+ *
+ * @code
+ * double AccumulateEvaluateWithGradient(const arma::mat& coordinates,
+ *                                       const size_t i,
+ *                                       arma::mat& gradient) const;
+ * @endcode
+ *
+ * which returns the objective of separable function i and adds its gradient
+ * to the given matrix.  The batch is visited once (instead of once by
+ * Evaluate() and once by Gradient()), and it is split into contiguous parts
+ * that are handled by the threads of the default executor, each accumulating
+ * into its own gradient; the parts are added up in order, so the result only
+ * depends on the number of threads.  The kernel is called from several
+ * threads at once, so it must be thread-safe.
+ *
+ * @param function Function to evaluate (the Function<> wrapper).
+ * @param coordinates Coordinates to evaluate the function at.
+ * @param begin Index of the first separable function of the batch.
+ * @param gradient Matrix to store the gradient into.
+ * @param batchSize Number of separable functions in the batch.
+ */
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         typename WrapperType>
+typename std::enable_if<traits::HasSampleKernel<FunctionType, MatType,
+    GradType>::value, typename MatType::elem_type>::type
+SynthesizedEvaluateWithGradient(WrapperType& function,
+                                const MatType& coordinates,
+                                const size_t begin,
+                                GradType& gradient,
+                                const size_t batchSize)
+{
+  typedef typename MatType::elem_type ElemType;
+  const FunctionType& f = static_cast<const FunctionType&>(function);
+
+  gradient.zeros(coordinates.n_rows, coordinates.n_cols);
+  const size_t chunks = ParallelChunkCount(batchSize,
+      ENS_SAMPLE_KERNEL_CHUNK_SIZE);
+  if (chunks == 1)
+  {
+    ElemType objective = 0;
+    for (size_t i = begin; i < begin + batchSize; ++i)
+      objective += f.AccumulateEvaluateWithGradient(coordinates, i, gradient);
+    return objective;
+  }
+
+  // The first part accumulates into the output directly.
+  std::vector<GradType> gradients(chunks - 1);
+  std::vector<ElemType> objectives(chunks, ElemType(0));
+  DefaultExecutor().ParallelFor(chunks, [&](const size_t c)
+  {
+    GradType& partGradient = (c == 0) ? gradient : gradients[c - 1];
+    if (c > 0)
+      partGradient.zeros(coordinates.n_rows, coordinates.n_cols);
+
+    const size_t first = begin + (c * batchSize) / chunks;
+    const size_t last = begin + ((c + 1) * batchSize) / chunks;
+    ElemType objective = 0;
+    for (size_t i = first; i < last; ++i)
+    {
+      objective += f.AccumulateEvaluateWithGradient(coordinates, i,
+          partGradient);
+    }
+    objectives[c] = objective;
+  });
+
+  ElemType objective = objectives[0];
+  for (size_t c = 1; c < chunks; ++c)
+  {
+    objective += objectives[c];
+    gradient += gradients[c - 1];
+  }
+
+  return objective;
+}
+
+/**
+ * Return the objective of the given batch of a separable function and store
+ * its gradient, with separate calls to the Evaluate() and Gradient() of the
+ * function.  This is used for functions without a per-function kernel.
+ *
+ * @param function Function to evaluate (the Function<> wrapper).
+ * @param coordinates Coordinates to evaluate the function at.
+ * @param begin Index of the first separable function of the batch.
+ * @param gradient Matrix to store the gradient into.
+ * @param batchSize Number of separable functions in the batch.
+ */
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         typename WrapperType>
+typename std::enable_if<!traits::HasSampleKernel<FunctionType, MatType,
+    GradType>::value, typename MatType::elem_type>::type
+SynthesizedEvaluateWithGradient(WrapperType& function,
+                                const MatType& coordinates,
+                                const size_t begin,
+                                GradType& gradient,
+                                const size_t batchSize)
+{
+  const typename MatType::elem_type objective = function.Evaluate(coordinates,
+      begin, batchSize);
+  function.Gradient(coordinates, begin, gradient, batchSize);
+  return objective;
+}
+
+} // namespace ens
+
+#endif
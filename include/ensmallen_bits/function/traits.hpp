@@ -13,6 +13,8 @@
 #ifndef ENSMALLEN_FUNCTION_TRAITS_HPP
 #define ENSMALLEN_FUNCTION_TRAITS_HPP
 
+#include <future>
+
 #include "sfinae_utility.hpp"
 
 namespace ens {
@@ -38,6 +40,48 @@ ENS_HAS_EXACT_METHOD_FORM(GradientConstraint, HasGradientConstraint)
 ENS_HAS_EXACT_METHOD_FORM(NumFeatures, HasNumFeatures)
 //! Detect a PartialGradient() method.
 ENS_HAS_EXACT_METHOD_FORM(PartialGradient, HasPartialGradient)
+//! Detect a PartialDerivative() method.
+ENS_HAS_EXACT_METHOD_FORM(PartialDerivative, HasPartialDerivative)
+//! Detect a CoordinateLipschitz() method.
+ENS_HAS_EXACT_METHOD_FORM(CoordinateLipschitz, HasCoordinateLipschitz)
+//! Detect a DualGradient() method.
+ENS_HAS_EXACT_METHOD_FORM(DualGradient, HasDualGradient)
+//! Detect a MultiEvaluateWithGradient() method.
+ENS_HAS_EXACT_METHOD_FORM(MultiEvaluateWithGradient,
+    HasMultiEvaluateWithGradient)
+//! Detect a GradientStatistics() method.
+ENS_HAS_EXACT_METHOD_FORM(GradientStatistics, HasGradientStatistics)
+//! Detect a PrefetchBatch() method.
+ENS_HAS_EXACT_METHOD_FORM(PrefetchBatch, HasPrefetchBatch)
+//! Detect a NextBatch() method.
+ENS_HAS_EXACT_METHOD_FORM(NextBatch, HasNextBatch)
+//! Detect a ResetCache() method.
+ENS_HAS_EXACT_METHOD_FORM(ResetCache, HasResetCache)
+//! Detect an UpdateCache() method.
+ENS_HAS_EXACT_METHOD_FORM(UpdateCache, HasUpdateCache)
+//! Detect a CachedEvaluate() method.
+ENS_HAS_EXACT_METHOD_FORM(CachedEvaluate, HasCachedEvaluate)
+//! Detect an EvaluateDelta() method.
+ENS_HAS_EXACT_METHOD_FORM(EvaluateDelta, HasEvaluateDelta)
+//! Detect a ResetHistory() method.
+ENS_HAS_EXACT_METHOD_FORM(ResetHistory, HasResetHistory)
+//! Detect an ObserveObjective() method.
+ENS_HAS_EXACT_METHOD_FORM(ObserveObjective, HasObserveObjective)
+//! Detect a ResetPolicy() method.
+ENS_HAS_EXACT_METHOD_FORM(ResetPolicy, HasResetPolicy)
+//! Detect a MinGradientNorm() method.
+ENS_HAS_EXACT_METHOD_FORM(MinGradientNorm, HasMinGradientNorm)
+//! Detect a HessianVectorProduct() method.
+ENS_HAS_EXACT_METHOD_FORM(HessianVectorProduct, HasHessianVectorProduct)
+//! Detect a ScreenFeatures() method.
+ENS_HAS_EXACT_METHOD_FORM(ScreenFeatures, HasScreenFeatures)
+//! Detect an EvaluateAsync() method.
+ENS_HAS_EXACT_METHOD_FORM(EvaluateAsync, HasEvaluateAsync)
+//! Detect an AccumulateEvaluateWithGradient() method.
+ENS_HAS_EXACT_METHOD_FORM(AccumulateEvaluateWithGradient,
+    HasAccumulateEvaluateWithGradient)
+//! Detect a LossScale() method.
+ENS_HAS_EXACT_METHOD_FORM(LossScale, HasLossScale)
 
 //! This is the form of a non-const Evaluate() method.
 template<typename FunctionType>
@@ -104,6 +148,105 @@ using ShuffleConstForm = void(FunctionType::*)() const;
 template<typename FunctionType>
 using ShuffleStaticForm = void(*)();
 
+//! This is the form of a non-const PrefetchBatch() method.
+template<typename FunctionType>
+using PrefetchBatchForm = void(FunctionType::*)(const size_t, const size_t);
+
+//! This is the form of a const PrefetchBatch() method.
+template<typename FunctionType>
+using PrefetchBatchConstForm =
+    void(FunctionType::*)(const size_t, const size_t) const;
+
+//! This is the form of a non-const PartialGradient() method for a block of
+//! features.
+template<typename FunctionType>
+using BlockPartialGradientForm = void(FunctionType::*)(
+    const arma::mat&, const size_t, arma::mat&, const size_t);
+
+//! This is the form of a const PartialGradient() method for a block of
+//! features.
+template<typename FunctionType>
+using BlockPartialGradientConstForm = void(FunctionType::*)(
+    const arma::mat&, const size_t, arma::mat&, const size_t) const;
+
+//! This is the form of a non-const PartialDerivative() method.
+template<typename FunctionType>
+using PartialDerivativeForm = double(FunctionType::*)(const arma::mat&,
+    const size_t, const size_t);
+
+//! This is the form of a const PartialDerivative() method.
+template<typename FunctionType>
+using PartialDerivativeConstForm = double(FunctionType::*)(const arma::mat&,
+    const size_t, const size_t) const;
+
+//! This is the form of a non-const CoordinateLipschitz() method.
+template<typename FunctionType>
+using CoordinateLipschitzForm = double(FunctionType::*)(const size_t);
+
+//! This is the form of a const CoordinateLipschitz() method.
+template<typename FunctionType>
+using CoordinateLipschitzConstForm = double(FunctionType::*)(const size_t)
+    const;
+
+//! This is the form of a ResetCache() method.
+template<typename FunctionType>
+using ResetCacheForm = void(FunctionType::*)(const arma::mat&);
+
+//! This is the form of an UpdateCache() method.
+template<typename FunctionType>
+using UpdateCacheForm = void(FunctionType::*)(const arma::mat&, const size_t,
+    const arma::mat&);
+
+//! This is the form of a non-const CachedEvaluate() method.
+template<typename FunctionType>
+using CachedEvaluateForm = double(FunctionType::*)();
+
+//! This is the form of a const CachedEvaluate() method.
+template<typename FunctionType>
+using CachedEvaluateConstForm = double(FunctionType::*)() const;
+
+//! This is the form of a non-const ScreenFeatures() method.
+template<typename FunctionType>
+using ScreenFeaturesForm = void(FunctionType::*)(const arma::mat&,
+    std::vector<bool>&);
+
+//! This is the form of a const ScreenFeatures() method.
+template<typename FunctionType>
+using ScreenFeaturesConstForm = void(FunctionType::*)(const arma::mat&,
+    std::vector<bool>&) const;
+
+//! This is the form of a non-const EvaluateDelta() method.
+template<typename FunctionType>
+using EvaluateDeltaForm = double(FunctionType::*)(const arma::mat&,
+    const size_t, const double);
+
+//! This is the form of a const EvaluateDelta() method.
+template<typename FunctionType>
+using EvaluateDeltaConstForm = double(FunctionType::*)(const arma::mat&,
+    const size_t, const double) const;
+
+//! This is the form of a modifier of an optimizer flag, such as ResetPolicy().
+template<typename OptimizerType>
+using ResetFlagForm = bool&(OptimizerType::*)();
+
+//! This is the form of a modifier of an optimizer tolerance, such as
+//! MinGradientNorm().
+template<typename OptimizerType>
+using ToleranceForm = double&(OptimizerType::*)();
+
+//! This is the form of the ObserveObjective() method of a decay policy.
+template<typename PolicyType>
+using ObserveObjectiveForm = void(PolicyType::*)(const double, const size_t);
+
+//! This is the form of the LossScale() modifier of a function that scales its
+//! objective and gradient.
+template<typename FunctionType>
+using LossScaleForm = double&(FunctionType::*)();
+
+//! This is the form of a NextBatch() method.
+template<typename FunctionType>
+using NextBatchForm = size_t(FunctionType::*)(const size_t);
+
 //! This is the form of a decomposable Evaluate() method.
 template<typename FunctionType>
 using DecomposableEvaluateForm = double(FunctionType::*)(
@@ -232,6 +375,476 @@ template<typename FunctionType>
 using PartialGradientStaticForm = void(*)(
     const arma::mat&, const size_t, arma::sp_mat&);
 
+/**
+ * TypedForms holds the forms of each of the methods above, but for an arbitrary
+ * matrix type and gradient type, instead of only arma::mat.  Use it as
+ *
+ * @code
+ * traits::TypedForms<MatType, GradType>::template EvaluateForm
+ * @endcode
+ *
+ * when a method form for a specific matrix type is needed.  The objective type
+ * is given by the element type of the matrix type (i.e., a FunctionType that
+ * operates on arma::fmat should return a float from Evaluate()).
+ *
+ * @tparam MatType Type of the coordinates matrix.
+ * @tparam GradType Type of the gradient matrix.
+ */
+template<typename MatType, typename GradType>
+struct TypedForms
+{
+  //! The type of the objective.
+  typedef typename MatType::elem_type ElemType;
+
+  //! This is the form of a non-const Evaluate() method.
+  template<typename FunctionType>
+  using EvaluateForm = ElemType(FunctionType::*)(const MatType&);
+
+  //! This is the form of a const Evaluate() method.
+  template<typename FunctionType>
+  using EvaluateConstForm = ElemType(FunctionType::*)(const MatType&) const;
+
+  //! This is the form of a static Evaluate() method.
+  template<typename FunctionType>
+  using EvaluateStaticForm = ElemType(*)(const MatType&);
+
+  //! This is the form of a non-const Gradient() method.
+  template<typename FunctionType>
+  using GradientForm = void(FunctionType::*)(const MatType&, GradType&);
+
+  //! This is the form of a const Gradient() method.
+  template<typename FunctionType>
+  using GradientConstForm =
+      void(FunctionType::*)(const MatType&, GradType&) const;
+
+  //! This is the form of a static Gradient() method.
+  template<typename FunctionType>
+  using GradientStaticForm = void(*)(const MatType&, GradType&);
+
+  //! This is the form of a non-const EvaluateWithGradient() method.
+  template<typename FunctionType>
+  using EvaluateWithGradientForm =
+      ElemType(FunctionType::*)(const MatType&, GradType&);
+
+  //! This is the form of a const EvaluateWithGradient() method.
+  template<typename FunctionType>
+  using EvaluateWithGradientConstForm =
+      ElemType(FunctionType::*)(const MatType&, GradType&) const;
+
+  //! This is the form of a static EvaluateWithGradient() method.
+  template<typename FunctionType>
+  using EvaluateWithGradientStaticForm =
+      ElemType(*)(const MatType&, GradType&);
+
+  //! This is the form of a decomposable Evaluate() method.
+  template<typename FunctionType>
+  using DecomposableEvaluateForm = ElemType(FunctionType::*)(
+      const MatType&, const size_t, const size_t);
+
+  //! This is the form of a decomposable const Evaluate() method.
+  template<typename FunctionType>
+  using DecomposableEvaluateConstForm = ElemType(FunctionType::*)(
+      const MatType&, const size_t, const size_t) const;
+
+  //! This is the form of a decomposable static Evaluate() method.
+  template<typename FunctionType>
+  using DecomposableEvaluateStaticForm = ElemType(*)(
+      const MatType&, const size_t, const size_t);
+
+  //! This is the form of a decomposable non-const Gradient() method.
+  template<typename FunctionType>
+  using DecomposableGradientForm = void(FunctionType::*)(
+      const MatType&, const size_t, GradType&, const size_t);
+
+  //! This the form of a decomposable const Gradient() method.
+  template<typename FunctionType>
+  using DecomposableGradientConstForm = void(FunctionType::*)(
+      const MatType&, const size_t, GradType&, const size_t) const;
+
+  //! This is the form of a decomposable static Gradient() method.
+  template<typename FunctionType>
+  using DecomposableGradientStaticForm = void(*)(
+      const MatType&, const size_t, GradType&, const size_t);
+
+  //! This is the form of a decomposable non-const EvaluateWithGradient()
+  //! method.
+  template<typename FunctionType>
+  using DecomposableEvaluateWithGradientForm = ElemType(FunctionType::*)(
+      const MatType&, const size_t, GradType&, const size_t);
+
+  //! This is the form of a decomposable const EvaluateWithGradient() method.
+  template<typename FunctionType>
+  using DecomposableEvaluateWithGradientConstForm = ElemType(FunctionType::*)(
+      const MatType&, const size_t, GradType&, const size_t) const;
+
+  //! This is the form of a decomposable static EvaluateWithGradient() method.
+  template<typename FunctionType>
+  using DecomposableEvaluateWithGradientStaticForm = ElemType(*)(
+      const MatType&, const size_t, GradType&, const size_t);
+
+  //! This is the form of a non-const EvaluateAsync() method, which starts an
+  //! evaluation and returns a future of its objective.
+  template<typename FunctionType>
+  using EvaluateAsyncForm =
+      std::future<ElemType>(FunctionType::*)(const MatType&);
+
+  //! This is the form of a const EvaluateAsync() method.
+  template<typename FunctionType>
+  using EvaluateAsyncConstForm =
+      std::future<ElemType>(FunctionType::*)(const MatType&) const;
+
+  //! This is the form of a non-const batch Evaluate() method, which evaluates
+  //! every slice of a cube of points.
+  template<typename FunctionType>
+  using BatchEvaluateForm = void(FunctionType::*)(
+      const arma::Cube<ElemType>&, arma::Col<ElemType>&);
+
+  //! This is the form of a const batch Evaluate() method.
+  template<typename FunctionType>
+  using BatchEvaluateConstForm = void(FunctionType::*)(
+      const arma::Cube<ElemType>&, arma::Col<ElemType>&) const;
+
+  //! This is the form of a static batch Evaluate() method.
+  template<typename FunctionType>
+  using BatchEvaluateStaticForm = void(*)(
+      const arma::Cube<ElemType>&, arma::Col<ElemType>&);
+
+  //! This is the form of a non-const DualGradient() method, which computes
+  //! the decomposable gradients of the same batch at two points.
+  template<typename FunctionType>
+  using DualGradientForm = void(FunctionType::*)(const MatType&,
+      const MatType&, const size_t, GradType&, GradType&, const size_t);
+
+  //! This is the form of a const DualGradient() method.
+  template<typename FunctionType>
+  using DualGradientConstForm = void(FunctionType::*)(const MatType&,
+      const MatType&, const size_t, GradType&, GradType&, const size_t) const;
+
+  //! This is the form of a non-const MultiEvaluateWithGradient() method,
+  //! which computes the decomposable objectives and gradients of the same
+  //! batch at every slice of a cube of points.
+  template<typename FunctionType>
+  using MultiEvaluateWithGradientForm = void(FunctionType::*)(
+      const arma::Cube<ElemType>&, const size_t, arma::Cube<ElemType>&,
+      arma::Col<ElemType>&, const size_t);
+
+  //! This is the form of a const MultiEvaluateWithGradient() method.
+  template<typename FunctionType>
+  using MultiEvaluateWithGradientConstForm = void(FunctionType::*)(
+      const arma::Cube<ElemType>&, const size_t, arma::Cube<ElemType>&,
+      arma::Col<ElemType>&, const size_t) const;
+
+  //! This is the form of a non-const GradientStatistics() method, which
+  //! computes the gradient of a batch and the sum of the squared norms of the
+  //! gradients of its functions.
+  template<typename FunctionType>
+  using GradientStatisticsForm = void(FunctionType::*)(const MatType&,
+      const size_t, GradType&, double&, const size_t);
+
+  //! This is the form of a const GradientStatistics() method.
+  template<typename FunctionType>
+  using GradientStatisticsConstForm = void(FunctionType::*)(const MatType&,
+      const size_t, GradType&, double&, const size_t) const;
+
+  //! This is the form of a non-const HessianVectorProduct() method, which
+  //! computes the product of the Hessian at the coordinates with a direction.
+  template<typename FunctionType>
+  using HessianVectorProductForm = void(FunctionType::*)(const MatType&,
+      const MatType&, GradType&);
+
+  //! This is the form of a const HessianVectorProduct() method.
+  template<typename FunctionType>
+  using HessianVectorProductConstForm = void(FunctionType::*)(const MatType&,
+      const MatType&, GradType&) const;
+
+  //! This is the form of a const AccumulateEvaluateWithGradient() method,
+  //! which returns the objective of one separable function and adds its
+  //! gradient to the given matrix.
+  template<typename FunctionType>
+  using AccumulateEvaluateWithGradientConstForm = ElemType(FunctionType::*)(
+      const MatType&, const size_t, GradType&) const;
+};
+
+/**
+ * Check whether the given FunctionType implements a batch Evaluate() method
+ * (in any of its non-const, const or static forms) for the element type of
+ * the given matrix type.
+ */
+template<typename FunctionType, typename MatType>
+struct HasBatchEvaluate
+{
+  const static bool value =
+      HasEvaluate<FunctionType, TypedForms<MatType, MatType>::template
+          BatchEvaluateForm>::value ||
+      HasEvaluate<FunctionType, TypedForms<MatType, MatType>::template
+          BatchEvaluateConstForm>::value ||
+      HasEvaluate<FunctionType, TypedForms<MatType, MatType>::template
+          BatchEvaluateStaticForm>::value;
+};
+
+//! Map any type to void; used to detect nested types.
+template<typename T>
+struct VoidType
+{
+  typedef void type;
+};
+
+/**
+ * Check whether the given FunctionType opts in to being called from several
+ * threads at once with a public nested type
+ *
+ * @code
+ * typedef std::true_type ThreadSafe;
+ * @endcode
+ *
+ * (std::false_type, or no such type, opts out).
+ */
+template<typename FunctionType, typename = void>
+struct HasThreadSafeTag
+{
+  const static bool value = false;
+};
+
+//! The FunctionType has a ThreadSafe type; use its value.
+template<typename FunctionType>
+struct HasThreadSafeTag<FunctionType,
+    typename VoidType<typename FunctionType::ThreadSafe>::type>
+{
+  const static bool value = FunctionType::ThreadSafe::value;
+};
+
+/**
+ * Check whether the objective of the given FunctionType may be evaluated from
+ * several threads at once: the function must opt in with the ThreadSafe tag
+ * (see HasThreadSafeTag), and its Evaluate() (or its separable Evaluate()) must
+ * be const or static, so that it does not modify the function.  Population
+ * optimizers then evaluate concurrently even if they were not asked to.
+ */
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType>
+struct IsThreadSafeFunction
+{
+  const static bool value = HasThreadSafeTag<FunctionType>::value && (
+      HasEvaluate<FunctionType, TypedForms<MatType, GradType>::template
+          EvaluateConstForm>::value ||
+      HasEvaluate<FunctionType, TypedForms<MatType, GradType>::template
+          EvaluateStaticForm>::value ||
+      HasEvaluate<FunctionType, TypedForms<MatType, GradType>::template
+          DecomposableEvaluateConstForm>::value ||
+      HasEvaluate<FunctionType, TypedForms<MatType, GradType>::template
+          DecomposableEvaluateStaticForm>::value);
+};
+
+/**
+ * Check whether the given FunctionType has a ScatterGradient() method that can
+ * be called with the given callback type, of the form
+ *
+ * @code
+ * template<typename ScatterType>
+ * void ScatterGradient(const MatType& coordinates,
+ *                      const size_t begin,
+ *                      ScatterType& scatter,
+ *                      const size_t batchSize);
+ * @endcode
+ *
+ * (which may also be const or static).  If ScatterType is void, the value is
+ * false.
+ */
+template<typename FunctionType,
+         typename MatType,
+         typename ScatterType,
+         typename = void>
+struct HasScatterGradient
+{
+  const static bool value = false;
+};
+
+//! The FunctionType can emit its gradient into a ScatterType.
+template<typename FunctionType, typename MatType, typename ScatterType>
+struct HasScatterGradient<FunctionType, MatType, ScatterType,
+    typename VoidType<decltype(std::declval<FunctionType&>().ScatterGradient(
+        std::declval<const MatType&>(), size_t(0),
+        std::declval<ScatterType&>(), size_t(0)))>::type>
+{
+  const static bool value = true;
+};
+
+/**
+ * Check whether the given FunctionType implements an EvaluateAsync() method (in
+ * its non-const or const form) for the given matrix type.
+ */
+template<typename FunctionType, typename MatType>
+struct HasAsyncEvaluate
+{
+  const static bool value =
+      HasEvaluateAsync<FunctionType, TypedForms<MatType, MatType>::template
+          EvaluateAsyncForm>::value ||
+      HasEvaluateAsync<FunctionType, TypedForms<MatType, MatType>::template
+          EvaluateAsyncConstForm>::value;
+};
+
+/**
+ * Check whether the given FunctionType implements a DualGradient() method (in
+ * its non-const or const form) for the given matrix types.
+ */
+template<typename FunctionType, typename MatType, typename GradType>
+struct HasDualBatchGradient
+{
+  const static bool value =
+      HasDualGradient<FunctionType, TypedForms<MatType, GradType>::template
+          DualGradientForm>::value ||
+      HasDualGradient<FunctionType, TypedForms<MatType, GradType>::template
+          DualGradientConstForm>::value;
+};
+
+/**
+ * Check whether the given FunctionType implements a
+ * MultiEvaluateWithGradient() method (in its non-const or const form) for the
+ * element type of the given matrix type.
+ */
+template<typename FunctionType, typename MatType>
+struct HasMultiBatchEvaluateWithGradient
+{
+  const static bool value =
+      HasMultiEvaluateWithGradient<FunctionType, TypedForms<MatType,
+          MatType>::template MultiEvaluateWithGradientForm>::value ||
+      HasMultiEvaluateWithGradient<FunctionType, TypedForms<MatType,
+          MatType>::template MultiEvaluateWithGradientConstForm>::value;
+};
+
+/**
+ * Check whether the given FunctionType implements a HessianVectorProduct()
+ * method (in its non-const or const form) for the given matrix types.
+ */
+template<typename FunctionType, typename MatType, typename GradType>
+struct HasHessianVectorProductForm
+{
+  const static bool value =
+      HasHessianVectorProduct<FunctionType, TypedForms<MatType, GradType>::
+          template HessianVectorProductForm>::value ||
+      HasHessianVectorProduct<FunctionType, TypedForms<MatType, GradType>::
+          template HessianVectorProductConstForm>::value;
+};
+
+/**
+ * Check whether the given FunctionType implements a const
+ * AccumulateEvaluateWithGradient() method, the per-function kernel that a
+ * fused, parallel EvaluateWithGradient() can be built from, for the given
+ * matrix types.
+ */
+template<typename FunctionType, typename MatType, typename GradType>
+struct HasSampleKernel
+{
+  const static bool value =
+      HasAccumulateEvaluateWithGradient<FunctionType, TypedForms<MatType,
+          GradType>::template AccumulateEvaluateWithGradientConstForm>::value;
+};
+
+/**
+ * Check whether the given FunctionType implements a GradientStatistics() method
+ * (in its non-const or const form) for the given matrix types.
+ */
+template<typename FunctionType, typename MatType, typename GradType>
+struct HasBatchGradientStatistics
+{
+  const static bool value =
+      HasGradientStatistics<FunctionType,
+          TypedForms<MatType, GradType>::template GradientStatisticsForm>::value ||
+      HasGradientStatistics<FunctionType,
+          TypedForms<MatType, GradType>::template GradientStatisticsConstForm>::value;
+};
+
+/**
+ * Check whether the given FunctionType implements a PrefetchBatch() method (in
+ * its non-const or const form).
+ */
+template<typename FunctionType>
+struct HasBatchPrefetch
+{
+  const static bool value =
+      HasPrefetchBatch<FunctionType, PrefetchBatchForm>::value ||
+      HasPrefetchBatch<FunctionType, PrefetchBatchConstForm>::value;
+};
+
+/**
+ * Check whether the given FunctionType implements a PartialGradient() method
+ * for a block of features (in its non-const or const form).
+ */
+template<typename FunctionType>
+struct HasBlockPartialGradient
+{
+  const static bool value =
+      HasPartialGradient<FunctionType, BlockPartialGradientForm>::value ||
+      HasPartialGradient<FunctionType, BlockPartialGradientConstForm>::value;
+};
+
+/**
+ * Check whether the given FunctionType implements PartialDerivative() (which
+ * may be const), the scalar partial derivative with respect to one element of
+ * the coordinates.
+ */
+template<typename FunctionType>
+struct HasScalarPartialDerivative
+{
+  const static bool value =
+      HasPartialDerivative<FunctionType, PartialDerivativeForm>::value ||
+      HasPartialDerivative<FunctionType, PartialDerivativeConstForm>::value;
+};
+
+/**
+ * Check whether the given FunctionType implements CoordinateLipschitz() (which
+ * may be const), the Lipschitz constant of the partial derivatives of each
+ * feature.
+ */
+template<typename FunctionType>
+struct HasCoordinateLipschitzConstant
+{
+  const static bool value =
+      HasCoordinateLipschitz<FunctionType, CoordinateLipschitzForm>::value ||
+      HasCoordinateLipschitz<FunctionType,
+          CoordinateLipschitzConstForm>::value;
+};
+
+/**
+ * Check whether the given FunctionType implements the objective cache used by
+ * coordinate descent: ResetCache(), UpdateCache() and CachedEvaluate() (which
+ * may be const).
+ */
+template<typename FunctionType>
+struct HasObjectiveCache
+{
+  const static bool value =
+      HasResetCache<FunctionType, ResetCacheForm>::value &&
+      HasUpdateCache<FunctionType, UpdateCacheForm>::value &&
+      (HasCachedEvaluate<FunctionType, CachedEvaluateForm>::value ||
+       HasCachedEvaluate<FunctionType, CachedEvaluateConstForm>::value);
+};
+
+/**
+ * Check whether the given FunctionType implements ScreenFeatures() (which may
+ * be const), a safe screening rule for coordinate descent.
+ */
+template<typename FunctionType>
+struct HasFeatureScreening
+{
+  const static bool value =
+      HasScreenFeatures<FunctionType, ScreenFeaturesForm>::value ||
+      HasScreenFeatures<FunctionType, ScreenFeaturesConstForm>::value;
+};
+
+/**
+ * Check whether the given FunctionType implements EvaluateDelta() (which may be
+ * const), the change of the objective when one coordinate is modified.
+ */
+template<typename FunctionType>
+struct HasEvaluateDeltaMethod
+{
+  const static bool value =
+      HasEvaluateDelta<FunctionType, EvaluateDeltaForm>::value ||
+      HasEvaluateDelta<FunctionType, EvaluateDeltaConstForm>::value;
+};
+
 //! This is a utility struct that will match any non-const form.
 template<typename FunctionType, typename... Ts>
 using OtherForm = double(FunctionType::*)(Ts...);
@@ -13,17 +13,22 @@
 
 #include "proximal/proximal.hpp"
 #include "func_sq.hpp"
+#include "line_search/line_search.hpp"
 
 namespace ens {
 
 /**
  * Class to hold the information and operations of current atoms in the
- * soluton space.
+ * soluton space.  The atoms are stored as the columns of a sparse matrix: the
+ * atoms returned by the linear constrained solvers are usually very sparse
+ * (the atoms of an l1 ball have one nonzero, and the atoms of a structured
+ * group ball are nonzero only on one group), so k atoms of dimension n take
+ * memory proportional to their nonzeros instead of n * k.
  */
 class Atoms
 {
  public:
-  Atoms(){ /* Nothing to do. */ }
+  Atoms() : factorValid(false) { /* Nothing to do. */ }
 
   /**
    * Add atom into the solution space.
@@ -33,27 +38,74 @@ class Atoms
    */
   void AddAtom(const arma::vec& v, FuncSq& function, const double c = 0)
   {
+    const arma::vec projectedAtom = function.MatrixA() * v;
+    const double sqTerm = arma::dot(projectedAtom, projectedAtom);
+
     if (currentAtoms.is_empty())
     {
-      CurrentAtoms() = v;
+      currentAtoms = arma::sp_mat(v);
       CurrentCoeffs().set_size(1);
       CurrentCoeffs().fill(c);
       atomSqTerm.set_size(1);
-      atomSqTerm(0) = std::pow(norm(function.MatrixA() * v, 2), 2);
+      atomSqTerm(0) = sqTerm;
+
+      projectedAtoms = projectedAtom;
+      gramFactor.set_size(1, 1);
+      gramFactor(0, 0) = std::sqrt(sqTerm);
+      factorValid = (sqTerm > 0.0);
     }
     else
     {
-      currentAtoms.insert_cols(0, v);
+      if (projectedAtoms.n_cols == currentAtoms.n_cols)
+      {
+        if (factorValid)
+          AppendToFactor(projectedAtom, sqTerm);
+        projectedAtoms.insert_cols(0, projectedAtom);
+      }
+      else
+      {
+        // CurrentAtoms() was modified directly; A * atoms and the factor are
+        // recomputed when they are needed.
+        factorValid = false;
+      }
+
+      currentAtoms = arma::join_horiz(arma::sp_mat(v), currentAtoms);
       arma::vec cVec(1);
       cVec(0) = c;
       currentCoeffs.insert_rows(0, cVec);
-      double tmp = std::pow(norm(function.MatrixA() * v, 2), 2);
       arma::vec tmpVec(1);
-      tmpVec(0) = tmp;
+      tmpVec(0) = sqTerm;
       atomSqTerm.insert_rows(0, tmpVec);
     }
   }
 
+  /**
+   * Reoptimize the coefficients of the current atoms in their span, that is,
+   * solve the least squares problem min_c ||A * atoms * c - b||.  This uses the
+   * Cholesky factorization of the Gram matrix of A * atoms that is updated
+   * when an atom is added or pruned, so it costs O(m k + k^2) for k atoms
+   * instead of a full solve.  If the atoms are linearly dependent after A, the
+   * factorization is not available and the problem is solved from scratch;
+   * if CurrentAtoms() was modified directly, the factorization is recomputed.
+   *
+   * @param function function to be optimized.
+   */
+  void OptimizeInSpan(FuncSq& function)
+  {
+    if (projectedAtoms.n_cols != currentAtoms.n_cols)
+      Refactor(function);
+
+    if (factorValid)
+    {
+      currentCoeffs = SpanCoefficients(gramFactor, projectedAtoms,
+          function.Vectorb());
+    }
+    else
+    {
+      currentCoeffs = solve(arma::mat(function.MatrixA() * currentAtoms),
+          function.Vectorb());
+    }
+  }
 
   //! Recover the solution coordinate from the coefficients of current atoms.
   void RecoverVector(arma::mat& x)
@@ -82,6 +134,9 @@ class Atoms
    */
   void PruneSupport(const double F, FuncSq& function)
   {
+    if (projectedAtoms.n_cols != currentAtoms.n_cols)
+      Refactor(function);
+
     arma::vec sqTerm = 0.5 * atomSqTerm % square(currentCoeffs);
 
     while (currentAtoms.n_cols > 1)
@@ -98,25 +153,36 @@ class Atoms
       arma::uword ind;
       gap.min(ind);
 
-      // Try deleting the atom.
-      arma::mat newAtoms(currentAtoms.n_rows, currentAtoms.n_cols - 1);
-      if (ind > 0)
-        newAtoms.cols(0, ind - 1) = currentAtoms.cols(0, ind - 1);
-      if (ind < (currentAtoms.n_cols - 1))
+      // Try deleting the atom, and reoptimize the coefficients in the span of
+      // the other atoms, as in the UpdateSpan class.  Alternatively, if you
+      // want to add an atom norm constraint, you could use projected gradient
+      // method, see the implementaton of ProjectedGradientEnhancement().
+      arma::vec newCoeffs;
+      double Fnew;
+      arma::mat newFactor, newProjectedAtoms;
+      if (factorValid)
       {
-        newAtoms.cols(ind, newAtoms.n_cols - 1) =
-            currentAtoms.cols(ind + 1, currentAtoms.n_cols - 1);
-      }
-
-      // Reoptimize the coefficients, we brute-forcely reoptimize in the span,
-      // which would be used in UpdateSpan class. Alternatively, if you want to
-      // add an atom norm constraint, you could use projected gradient method,
-      // see the implementaton of ProjectedGradientEnhancement().
-      arma::vec newCoeffs =
-          solve(function.MatrixA() * newAtoms, function.Vectorb());
+        // Downdate the factorization instead of solving from scratch; the
+        // objective can be computed from A * atoms.
+        newFactor = gramFactor;
+        DeleteFromFactor(newFactor, currentAtoms.n_cols - 1 - ind);
+        newProjectedAtoms = projectedAtoms;
+        newProjectedAtoms.shed_col(ind);
 
-      // Evaluate the function again.
-      double Fnew = function.Evaluate(newAtoms * newCoeffs);
+        newCoeffs = SpanCoefficients(newFactor, newProjectedAtoms,
+            function.Vectorb());
+        const arma::vec residual = newProjectedAtoms * newCoeffs -
+            function.Vectorb();
+        Fnew = 0.5 * arma::dot(residual, residual);
+      }
+      else
+      {
+        arma::sp_mat newAtoms = currentAtoms;
+        newAtoms.shed_col(ind);
+        newCoeffs = solve(arma::mat(function.MatrixA() * newAtoms),
+            function.Vectorb());
+        Fnew = function.Evaluate(arma::mat(newAtoms * newCoeffs));
+      }
 
       if (Fnew > F)
         // Should not delete the atom.
@@ -124,10 +190,13 @@ class Atoms
       else
       {
         // Delete the atom from current atoms.
-        currentAtoms = newAtoms;
+        currentAtoms.shed_col(ind);
         currentCoeffs = newCoeffs;
         atomSqTerm.shed_row(ind);
         sqTerm.shed_row(ind);
+        projectedAtoms.shed_col(ind);
+        if (factorValid)
+          gramFactor = std::move(newFactor);
       } // else
     } // while
   }
@@ -192,26 +261,329 @@ class Atoms
   }
 
 
+  /**
+   * Add an atom to the solution space without any information about the
+   * function, for the update rules that keep the solution as a convex
+   * combination of the atoms (UpdateAwayStep and UpdateFullyCorrective).  The
+   * atom is appended after the current atoms.
+   *
+   * @param v new atom to be added.
+   * @param c coefficient of the new atom.
+   * @return Index of the new atom.
+   */
+  arma::uword AddAtom(const arma::vec& v, const double c)
+  {
+    if (currentAtoms.is_empty())
+      currentAtoms = arma::sp_mat(v);
+    else
+      currentAtoms = arma::join_horiz(currentAtoms, arma::sp_mat(v));
+    currentCoeffs.resize(currentAtoms.n_cols);
+    currentCoeffs(currentAtoms.n_cols - 1) = c;
+    Invalidate();
+
+    return currentAtoms.n_cols - 1;
+  }
+
+  /**
+   * Return the index of the given atom, or the number of current atoms if it
+   * is not one of them.  The atoms returned by the linear constrained solvers
+   * (for instance, the vertices of an l1 ball) repeat exactly, so they are
+   * compared exactly.  Only the nonzeros of the atoms are visited.
+   *
+   * @param v atom to look for.
+   */
+  arma::uword FindAtom(const arma::vec& v) const
+  {
+    const arma::uword nonzeros = arma::accu(v != 0.0);
+    for (arma::uword i = 0; i < currentAtoms.n_cols; ++i)
+    {
+      arma::uword matched = 0;
+      arma::sp_mat::const_iterator it = currentAtoms.begin_col(i);
+      for (; it != currentAtoms.end_col(i); ++it, ++matched)
+      {
+        if (v(it.row()) != (*it))
+          break;
+      }
+
+      if (it == currentAtoms.end_col(i) && matched == nonzeros)
+        return i;
+    }
+
+    return currentAtoms.n_cols;
+  }
+
+  /**
+   * Return the index of the away atom for the given gradient: the atom with a
+   * positive coefficient whose inner product with the gradient is largest,
+   * that is, the atom that it is best to move away from.  There must be an
+   * atom with a positive coefficient.
+   *
+   * @param gradient gradient of the function at the current solution.
+   */
+  arma::uword AwayAtom(const arma::mat& gradient) const
+  {
+    const arma::vec scores = currentAtoms.t() * arma::vectorise(gradient);
+    const arma::uvec active = arma::find(currentCoeffs > 0.0);
+    arma::uword ind;
+    arma::vec(scores.elem(active)).max(ind);
+    return active(ind);
+  }
+
+  /**
+   * Frank-Wolfe step towards an atom, for a solution that is a convex
+   * combination of the current atoms: x_new = (1 - gamma) x + gamma atom, where
+   * gamma in [0, 1] is found with line search.
+   *
+   * @param function function to be optimized.
+   * @param toward index of the atom to move towards.
+   * @param lineSearch line search solver.
+   * @param x current solution, overwritten with the new solution.
+   */
+  template<typename FunctionType>
+  void FrankWolfeStep(FunctionType& function,
+                      const arma::uword toward,
+                      LineSearch& lineSearch,
+                      arma::mat& x)
+  {
+    arma::vec delta = -currentCoeffs;
+    delta(toward) += 1.0;
+    ConvexStep(function, delta, lineSearch, x);
+  }
+
+  /**
+   * Away step from an atom, for a solution that is a convex combination of the
+   * current atoms: x_new = (1 + gamma) x - gamma atom, where gamma is found
+   * with line search and is at most the largest step that keeps the
+   * coefficient of the atom nonnegative.  If the full step is taken, the atom
+   * is dropped.
+   *
+   * @param function function to be optimized.
+   * @param away index of the atom to move away from.
+   * @param lineSearch line search solver.
+   * @param x current solution, overwritten with the new solution.
+   */
+  template<typename FunctionType>
+  void AwayStep(FunctionType& function,
+                const arma::uword away,
+                LineSearch& lineSearch,
+                arma::mat& x)
+  {
+    arma::vec delta = currentCoeffs;
+    delta(away) -= 1.0;
+    ConvexStep(function, delta, lineSearch, x);
+  }
+
+  /**
+   * Pairwise step, for a solution that is a convex combination of the current
+   * atoms: move the coefficient gamma from one atom to another, where gamma is
+   * found with line search and is at most the coefficient of the atom it is
+   * taken from.  If the full step is taken, that atom is dropped.
+   *
+   * @param function function to be optimized.
+   * @param toward index of the atom to move the coefficient to.
+   * @param away index of the atom to take the coefficient from.
+   * @param lineSearch line search solver.
+   * @param x current solution, overwritten with the new solution.
+   */
+  template<typename FunctionType>
+  void PairwiseStep(FunctionType& function,
+                    const arma::uword toward,
+                    const arma::uword away,
+                    LineSearch& lineSearch,
+                    arma::mat& x)
+  {
+    arma::vec delta = arma::zeros<arma::vec>(currentCoeffs.n_elem);
+    delta(toward) += 1.0;
+    delta(away) -= 1.0;
+    ConvexStep(function, delta, lineSearch, x);
+  }
+
   //! Get the current atom coefficients.
   const arma::vec& CurrentCoeffs() const { return currentCoeffs; }
   //! Modify the current atom coefficients.
   arma::vec& CurrentCoeffs() { return currentCoeffs; }
 
-  //! Get the current atoms.
-  const arma::mat& CurrentAtoms() const { return currentAtoms; }
-  //! Modify the current atoms.
-  arma::mat& CurrentAtoms() { return currentAtoms; }
+  //! Get the current atoms (one per column).
+  const arma::sp_mat& CurrentAtoms() const { return currentAtoms; }
+  //! Modify the current atoms (one per column).
+  arma::sp_mat& CurrentAtoms() { return currentAtoms; }
 
  private:
+  /**
+   * Move the coefficients in the direction delta (which sums to zero, so the
+   * coefficients still sum to one) with the step in [0, maxStep] that line
+   * search finds, where maxStep is the largest step that keeps the
+   * coefficients nonnegative.  Atoms whose coefficients reach zero are
+   * dropped.
+   */
+  template<typename FunctionType>
+  void ConvexStep(FunctionType& function,
+                  const arma::vec& delta,
+                  LineSearch& lineSearch,
+                  arma::mat& x)
+  {
+    double maxStep = std::numeric_limits<double>::infinity();
+    arma::uword blocking = 0;
+    for (arma::uword i = 0; i < delta.n_elem; ++i)
+    {
+      if (delta(i) < 0.0 && currentCoeffs(i) / -delta(i) < maxStep)
+      {
+        maxStep = currentCoeffs(i) / -delta(i);
+        blocking = i;
+      }
+    }
+
+    arma::mat direction = currentAtoms * delta;
+    direction.reshape(x.n_rows, x.n_cols);
+    const double squaredLength = arma::dot(direction, direction);
+    if (maxStep == std::numeric_limits<double>::infinity() ||
+        squaredLength == 0.0)
+      return;
+
+    // The line search reports the new point, which gives the step.
+    arma::mat end = x + maxStep * direction;
+    lineSearch.Optimize(function, x, end);
+    double gamma = arma::dot(end - x, direction) / (maxStep * squaredLength);
+    if (gamma <= 0.0)
+      return;
+    if (gamma > 1.0 - 1e-12)
+      gamma = 1.0;
+
+    currentCoeffs += (gamma * maxStep) * delta;
+    if (gamma == 1.0)
+      currentCoeffs(blocking) = 0.0;
+
+    // Drop the atoms that are no longer used.
+    const arma::uvec unused = arma::find(currentCoeffs <= 0.0);
+    for (arma::uword i = unused.n_elem; i > 0; --i)
+    {
+      currentAtoms.shed_col(unused(i - 1));
+      currentCoeffs.shed_row(unused(i - 1));
+    }
+    Invalidate();
+
+    RecoverVector(x);
+    x.reshape(direction.n_rows, direction.n_cols);
+  }
+
+  //! Forget A * atoms and its factorization after the atoms were changed
+  //! without the function; they are recomputed when they are needed.
+  void Invalidate()
+  {
+    projectedAtoms.reset();
+    atomSqTerm.reset();
+    factorValid = false;
+  }
+
+  //! Compute A * atoms and the factorization of its Gram matrix from scratch.
+  //! This is needed if CurrentAtoms() was modified directly.
+  void Refactor(FuncSq& function)
+  {
+    factorValid = false;
+    if (currentAtoms.is_empty())
+    {
+      projectedAtoms.reset();
+      return;
+    }
+
+    projectedAtoms = function.MatrixA() * currentAtoms;
+    atomSqTerm = trans(sum(square(projectedAtoms), 0));
+
+    // The factor holds the atoms in reverse order.
+    const arma::mat reversed = arma::fliplr(projectedAtoms);
+    factorValid = arma::chol(gramFactor, reversed.t() * reversed);
+  }
+
+  /**
+   * Add an atom (first in the current order, so last in the order of the
+   * factor) to the Cholesky factor of the Gram matrix.  If the atom is
+   * (numerically) in the span of the others, the factorization is marked as
+   * invalid.
+   *
+   * @param projectedAtom A times the new atom.
+   * @param sqTerm Squared norm of projectedAtom.
+   */
+  void AppendToFactor(const arma::vec& projectedAtom, const double sqTerm)
+  {
+    const size_t k = gramFactor.n_cols;
+    const arma::vec cross = arma::flipud(projectedAtoms.t() * projectedAtom);
+    const arma::vec r = arma::solve(arma::trimatl(gramFactor.t()), cross);
+    const double pivot = sqTerm - arma::dot(r, r);
+    if (!(pivot > 1e-12 * sqTerm))
+    {
+      factorValid = false;
+      return;
+    }
+
+    gramFactor.resize(k + 1, k + 1);
+    gramFactor(arma::span(0, k - 1), k) = r;
+    gramFactor(k, arma::span(0, k - 1)).zeros();
+    gramFactor(k, k) = std::sqrt(pivot);
+  }
+
+  /**
+   * Remove the atom with the given index (in the order of the factor) from the
+   * upper triangular Cholesky factor R of a Gram matrix.  Removing the column
+   * leaves an upper Hessenberg block, which Givens rotations make triangular
+   * again.
+   *
+   * @param factor Cholesky factor to modify.
+   * @param index Index of the atom to remove.
+   */
+  static void DeleteFromFactor(arma::mat& factor, const size_t index)
+  {
+    factor.shed_col(index);
+    for (size_t i = index; i < factor.n_cols; ++i)
+    {
+      const double a = factor(i, i);
+      const double b = factor(i + 1, i);
+      const double r = std::hypot(a, b);
+      const double c = a / r;
+      const double s = b / r;
+      for (size_t j = i; j < factor.n_cols; ++j)
+      {
+        const double upper = factor(i, j);
+        const double lower = factor(i + 1, j);
+        factor(i, j) = c * upper + s * lower;
+        factor(i + 1, j) = c * lower - s * upper;
+      }
+    }
+    factor.shed_row(factor.n_rows - 1);
+  }
+
+  /**
+   * Solve the least squares problem for the given projected atoms with the
+   * Cholesky factor of their Gram matrix (in reverse order).
+   */
+  static arma::vec SpanCoefficients(const arma::mat& factor,
+                                    const arma::mat& projected,
+                                    const arma::vec& b)
+  {
+    const arma::vec y = arma::solve(arma::trimatl(factor.t()),
+        arma::flipud(projected.t() * b));
+    return arma::flipud(arma::solve(arma::trimatu(factor), y));
+  }
+
   //! Coefficients of current atoms.
   arma::vec currentCoeffs;
 
-  //! Current atoms in the solution space.
-  arma::mat currentAtoms;
+  //! Current atoms in the solution space, one per column.
+  arma::sp_mat currentAtoms;
 
   //! Atom square term: ||A * atom||^2, used in PruneSupport(). It is computed
   //! when an atom is added.
   arma::vec atomSqTerm;
+
+  //! A times each of the current atoms.
+  arma::mat projectedAtoms;
+
+  //! Upper triangular Cholesky factor of the Gram matrix of projectedAtoms.
+  //! The atoms are in reverse order, so that adding an atom (which is inserted
+  //! first) appends a row and a column.
+  arma::mat gramFactor;
+
+  //! Whether gramFactor is a valid factorization.
+  bool factorValid;
 }; // class Atoms
 
 }  // namespace ens
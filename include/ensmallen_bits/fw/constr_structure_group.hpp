@@ -71,9 +71,15 @@ class ConstrStructGroupSolver
    *
    * @param groupExtractor Class used to project to a group, recovery from a
    *                       group, and compute norm in each group.
+   * @param parallel If true, the dual norms of the groups are computed in
+   *     parallel with OpenMP (if it is enabled).  ProjectToGroup() and
+   *     DualNorm() of the group extractor must then be safe to call from
+   *     several threads at once, as they are for GroupLpBall.
    */
-  ConstrStructGroupSolver(GroupType& groupExtractor) :
-    groupExtractor(groupExtractor)
+  ConstrStructGroupSolver(GroupType& groupExtractor,
+                          const bool parallel = false) :
+    groupExtractor(groupExtractor),
+    parallel(parallel)
   { /* Nothing to do */ }
 
   /**
@@ -84,31 +90,62 @@ class ConstrStructGroupSolver
    */
   void Optimize(const arma::mat& v, arma::mat& s)
   {
-    size_t nGroups = groupExtractor.NumGroups();
+    const size_t nGroups = groupExtractor.NumGroups();
     double dualNorm = 0;
     size_t optimalGroup = 1;
 
-    // Find the optimal group.
-    for (size_t i = 1; i <= nGroups; ++i)
+    // Find the group with largest dual norm.  Each thread finds the best group
+    // of its share of the groups, and the best of those is kept; ties go to
+    // the group with the smallest ID, as in a serial scan.
+    #ifdef ENS_USE_OPENMP
+      #pragma omp parallel if (parallel && nGroups > 1)
+    #endif
     {
+      double localNorm = 0;
+      size_t localGroup = 1;
       arma::vec y;
-      groupExtractor.ProjectToGroup(v, i, y);
-      double newNorm = groupExtractor.DualNorm(y, i);
 
-      // Find the group with largest dual norm.
-      if (newNorm > dualNorm)
+      #ifdef ENS_USE_OPENMP
+        #pragma omp for schedule(static) nowait
+      #endif
+      for (size_t i = 1; i <= nGroups; ++i)
       {
-        optimalGroup = i;
-        dualNorm = newNorm;
+        groupExtractor.ProjectToGroup(v, i, y);
+        const double newNorm = groupExtractor.DualNorm(y, i);
+        if (newNorm > localNorm)
+        {
+          localGroup = i;
+          localNorm = newNorm;
+        }
+      }
+
+      #ifdef ENS_USE_OPENMP
+        #pragma omp critical
+      #endif
+      {
+        if (localNorm > dualNorm ||
+            (localNorm == dualNorm && localGroup < optimalGroup))
+        {
+          optimalGroup = localGroup;
+          dualNorm = localNorm;
+        }
       }
     }
 
     groupExtractor.OptimalFromGroup(v, optimalGroup, s);
   }
 
+  //! Get whether the dual norms are computed in parallel.
+  bool Parallel() const { return parallel; }
+  //! Modify whether the dual norms are computed in parallel.
+  bool& Parallel() { return parallel; }
+
  private:
   //! Information and methods for groups.
   GroupType& groupExtractor;
+
+  //! Whether the dual norms are computed in parallel.
+  bool parallel;
 };
 
 /**
@@ -144,7 +181,7 @@ class GroupLpBall
    */
   void ProjectToGroup(const arma::mat& v, const size_t groupId, arma::vec& y)
   {
-    arma::uvec& indList = groupIndicesList[groupId - 1];
+    const arma::uvec& indList = groupIndicesList[groupId - 1];
     size_t dim = indList.n_elem;
     y.set_size(dim);
 
@@ -210,7 +247,7 @@ class GroupLpBall
     }
     else
     {
-      Log::Fatal << "Wrong norm p!" << std::endl;
+      Warn << "Wrong norm p!" << std::endl;
       return 0.0;
     }
   }
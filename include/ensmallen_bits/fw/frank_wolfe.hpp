@@ -12,11 +12,15 @@
 #ifndef ENSMALLEN_FW_FRANK_WOLFE_HPP
 #define ENSMALLEN_FW_FRANK_WOLFE_HPP
 
+#include "update_away_step.hpp"
 #include "update_full_correction.hpp"
+#include "update_fully_corrective.hpp"
 #include "update_linesearch.hpp"
 #include "update_classic.hpp"
 #include "update_span.hpp"
 #include "constr_lpball.hpp"
+#include "constr_structure_group.hpp"
+#include "lazy_atom_cache.hpp"
 
 namespace ens {
 
@@ -56,6 +60,14 @@ namespace ens {
  * The parameter \f$ \epsilon \f$ is specified by the tolerance parameter to the
  * constructor.
  *
+ * With lazyAtoms > 0, Frank-Wolfe is lazy: the last atoms returned by the
+ * linear constrained solver are cached (see LazyAtomCache), and an iteration
+ * reuses a cached atom instead of calling the solver if its gap is at least
+ * lazyFactor times the gap of the last atom returned by the solver.  The
+ * duality gap is only known (and the tolerance only checked) in the
+ * iterations that call the solver.  This is useful when the linear
+ * constrained problem is expensive to solve.
+ *
  * FrankWolfe can optimize differentiable functions.  For more details, see the
  * documentation on function types included with this distribution or on the
  * ensmallen website.
@@ -97,11 +109,17 @@ class FrankWolfe
    * @param maxIterations Maximum number of iterations allowed (0 means no
    *     limit).
    * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param lazyAtoms Number of atoms of the solver to cache for lazy steps (0
+   *     disables lazy steps).
+   * @param lazyFactor Fraction of the last gap of the solver that a cached
+   *     atom must reach to be used.
    */
   FrankWolfe(const LinearConstrSolverType linearConstrSolver,
              const UpdateRuleType updateRule,
              const size_t maxIterations = 100000,
-             const double tolerance = 1e-10);
+             const double tolerance = 1e-10,
+             const size_t lazyAtoms = 0,
+             const double lazyFactor = 0.5);
 
   /**
    * Optimize the given function using FrankWolfe.  The given starting
@@ -114,13 +132,18 @@ class FrankWolfe
    *   void Gradient(const arma::mat& coordinates,
    *                 arma::mat& gradient);
    *
+   * @tparam FunctionType Type of function to optimize.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to be optimized.
    * @param iterate Input with starting point, and will be modified to save
    *                the output optimial solution coordinates.
+   * @param callbacks Callback functions.
    * @return Objective value at the final solution.
    */
-  template<typename FunctionType>
-  double Optimize(FunctionType& function, arma::mat& iterate);
+  template<typename FunctionType, typename... CallbackTypes>
+  double Optimize(FunctionType& function,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
 
   //! Get the linear constrained solver.
   const LinearConstrSolverType& LinearConstrSolver()
@@ -143,6 +166,20 @@ class FrankWolfe
   //! Modify the tolerance for termination.
   double& Tolerance() { return tolerance; }
 
+  //! Get the number of cached atoms for lazy steps (0 if not lazy).
+  size_t LazyAtoms() const { return atomCache.Capacity(); }
+  //! Modify the number of cached atoms for lazy steps (0 if not lazy).
+  size_t& LazyAtoms() { return atomCache.Capacity(); }
+
+  //! Get the fraction of the last gap a cached atom must reach.
+  double LazyFactor() const { return atomCache.Factor(); }
+  //! Modify the fraction of the last gap a cached atom must reach.
+  double& LazyFactor() { return atomCache.Factor(); }
+
+  //! Get the number of calls to the linear constrained solver in the last
+  //! call to Optimize().
+  size_t LinearConstrSolverCalls() const { return linearConstrSolverCalls; }
+
  private:
   //! The solver for constrained linear problem in first step.
   LinearConstrSolverType linearConstrSolver;
@@ -155,6 +192,12 @@ class FrankWolfe
 
   //! The tolerance for termination.
   double tolerance;
+
+  //! The cache of the atoms of the solver, for lazy steps.
+  LazyAtomCache atomCache;
+
+  //! The number of calls to the solver in the last call to Optimize().
+  size_t linearConstrSolverCalls;
 };
 
 /**
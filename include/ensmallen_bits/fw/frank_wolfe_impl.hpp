@@ -27,11 +27,15 @@ FrankWolfe<LinearConstrSolverType, UpdateRuleType>::
 FrankWolfe(const LinearConstrSolverType linearConstrSolver,
            const UpdateRuleType updateRule,
            const size_t maxIterations,
-           const double tolerance) :
+           const double tolerance,
+           const size_t lazyAtoms,
+           const double lazyFactor) :
     linearConstrSolver(linearConstrSolver),
     updateRule(updateRule),
     maxIterations(maxIterations),
-    tolerance(tolerance)
+    tolerance(tolerance),
+    atomCache(lazyAtoms, lazyFactor),
+    linearConstrSolverCalls(0)
 { /* Nothing to do*/ }
 
 
@@ -39,9 +43,11 @@ FrankWolfe(const LinearConstrSolverType linearConstrSolver,
 template<
     typename LinearConstrSolverType,
     typename UpdateRuleType>
-template<typename FunctionType>
+template<typename FunctionType, typename... CallbackTypes>
 double FrankWolfe<LinearConstrSolverType, UpdateRuleType>::
-Optimize(FunctionType& function, arma::mat& iterate)
+Optimize(FunctionType& function,
+         arma::mat& iterate,
+         CallbackTypes&&... callbacks)
 {
   typedef Function<FunctionType> FullFunctionType;
   FullFunctionType& f = static_cast<FullFunctionType&>(function);
@@ -57,35 +63,59 @@ Optimize(FunctionType& function, arma::mat& iterate)
   arma::mat iterateNew(iterate.n_rows, iterate.n_cols);
   double gap = 0;
 
-  for (size_t i = 1; i != maxIterations; ++i)
+  // The atoms of earlier calls are not reused.
+  atomCache.Reset();
+  linearConstrSolverCalls = 0;
+
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+  terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
+
+  for (size_t i = 1; i != maxIterations && !terminate; ++i)
   {
     currentObjective = f.EvaluateWithGradient(iterate, gradient);
+    terminate |= Callback::EvaluateWithGradient(*this, f, iterate,
+        currentObjective, gradient, callbacks...);
 
     // Output current objective function.
     Info << "FrankWolfe::Optimize(): iteration " << i << ", objective "
-        << currentObjective << "." << std::endl;
+        << currentObjective << ".\n";
 
-    // Solve linear constrained problem, solution saved in s.
-    linearConstrSolver.Optimize(gradient, s);
-
-    // Check duality gap for return condition.
-    gap = std::fabs(dot(iterate - s, gradient));
-    if (gap < tolerance)
+    // For a lazy step, reuse a cached atom that makes enough progress;
+    // otherwise solve the linear constrained problem, solution saved in s.
+    if (!atomCache.Find(iterate, gradient, s))
     {
-      Info << "FrankWolfe::Optimize(): minimized within tolerance "
-          << tolerance << "; " << "terminating optimization." << std::endl;
-      return currentObjective;
+      linearConstrSolver.Optimize(gradient, s);
+      ++linearConstrSolverCalls;
+
+      // Check duality gap for return condition.
+      gap = std::fabs(dot(iterate - s, gradient));
+      if (gap < tolerance)
+      {
+        Info << "FrankWolfe::Optimize(): minimized within tolerance "
+            << tolerance << "; " << "terminating optimization." << std::endl;
+        Callback::EndOptimization(*this, f, iterate, callbacks...);
+        return currentObjective;
+      }
+
+      atomCache.Add(s, gap);
     }
 
-
     // Update solution, save in iterateNew.
     updateRule.Update(f, iterate, s, iterateNew, i);
 
-    iterate = std::move(iterateNew);
+    // Copy the new solution, so that the iterate keeps its memory.
+    iterate = iterateNew;
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+  }
+
+  if (!terminate)
+  {
+    Info << "FrankWolfe::Optimize(): maximum iterations (" << maxIterations
+        << ") reached; " << "terminating optimization." << std::endl;
   }
 
-  Info << "FrankWolfe::Optimize(): maximum iterations (" << maxIterations
-      << ") reached; " << "terminating optimization." << std::endl;
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
   return currentObjective;
 } // Optimize()
 
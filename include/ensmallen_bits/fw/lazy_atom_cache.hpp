@@ -0,0 +1,163 @@
+/**
+ * @file lazy_atom_cache.hpp
+ *
+ * Cache of the atoms returned by the linear constrained solver, for lazy
+ * Frank-Wolfe.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FW_LAZY_ATOM_CACHE_HPP
+#define ENSMALLEN_FW_LAZY_ATOM_CACHE_HPP
+
+#include <vector>
+
+namespace ens {
+
+/**
+ * LazyAtomCache keeps the last atoms returned by the linear constrained solver
+ * of Frank-Wolfe, so that an iteration can reuse one of them instead of
+ * solving the linear problem again.  A cached atom s is used if its gap
+ * \f$ <x - s, \nabla f(x)> \f$ is at least the given fraction of the gap of
+ * the last atom that was returned by the solver; otherwise the solver is
+ * called.  Since the gap of the solver's atom is the Frank-Wolfe duality gap,
+ * each reused atom still makes a guaranteed fraction of the progress of a full
+ * step.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{Braun2017,
+ *   author    = {Braun, G{\'a}bor and Pokutta, Sebastian and Zink, Daniel},
+ *   title     = {Lazifying Conditional Gradient Algorithms},
+ *   booktitle = {Proceedings of the 34th International Conference on Machine
+ *                Learning},
+ *   pages     = {566--575},
+ *   year      = {2017}
+ * }
+ * @endcode
+ */
+class LazyAtomCache
+{
+ public:
+  /**
+   * Construct the cache.
+   *
+   * @param capacity Maximum number of cached atoms (0 disables the cache).
+   * @param factor Fraction of the last gap of the solver that a cached atom
+   *     must reach to be used.
+   */
+  LazyAtomCache(const size_t capacity = 0, const double factor = 0.5) :
+      capacity(capacity),
+      factor(factor),
+      next(0),
+      lastGap(-1.0)
+  { /* Nothing to do. */ }
+
+  //! Forget the cached atoms.
+  void Reset()
+  {
+    atoms.clear();
+    next = 0;
+    lastGap = -1.0;
+  }
+
+  /**
+   * Look for a cached atom that makes enough progress from the given iterate
+   * along the given gradient.
+   *
+   * @param iterate The current iterate.
+   * @param gradient The gradient (or gradient estimate) at the iterate.
+   * @param s Set to the cached atom, if one was found.
+   * @return Whether a cached atom was found.
+   */
+  bool Find(const arma::mat& iterate,
+            const arma::mat& gradient,
+            arma::mat& s) const
+  {
+    if (atoms.empty() || lastGap <= 0.0)
+      return false;
+
+    // The atom with the largest gap is the one with the smallest inner
+    // product with the gradient.
+    size_t best = 0;
+    double bestProduct = arma::dot(atoms[0], gradient);
+    for (size_t j = 1; j < atoms.size(); ++j)
+    {
+      const double product = arma::dot(atoms[j], gradient);
+      if (product < bestProduct)
+      {
+        best = j;
+        bestProduct = product;
+      }
+    }
+
+    if (arma::dot(iterate, gradient) - bestProduct < factor * lastGap)
+      return false;
+
+    s = atoms[best];
+    return true;
+  }
+
+  /**
+   * Record the atom returned by the linear constrained solver, and its gap.
+   * When the cache is full, the oldest atom is replaced.
+   *
+   * @param s The atom returned by the solver.
+   * @param gap The gap of the atom.
+   */
+  void Add(const arma::mat& s, const double gap)
+  {
+    if (capacity == 0)
+      return;
+
+    lastGap = gap;
+    for (size_t j = 0; j < atoms.size(); ++j)
+    {
+      if (arma::size(atoms[j]) == arma::size(s) &&
+          arma::accu(atoms[j] != s) == 0)
+        return;
+    }
+
+    if (atoms.size() < capacity)
+    {
+      atoms.push_back(s);
+    }
+    else
+    {
+      atoms[next] = s;
+      next = (next + 1) % capacity;
+    }
+  }
+
+  //! Get the maximum number of cached atoms (0 if the cache is disabled).
+  size_t Capacity() const { return capacity; }
+  //! Modify the maximum number of cached atoms (0 disables the cache).
+  size_t& Capacity() { return capacity; }
+
+  //! Get the fraction of the last gap a cached atom must reach.
+  double Factor() const { return factor; }
+  //! Modify the fraction of the last gap a cached atom must reach.
+  double& Factor() { return factor; }
+
+  //! Get the number of cached atoms.
+  size_t Size() const { return atoms.size(); }
+
+ private:
+  //! The maximum number of cached atoms.
+  size_t capacity;
+  //! The fraction of the last gap a cached atom must reach.
+  double factor;
+  //! The cached atoms.
+  std::vector<arma::mat> atoms;
+  //! The index of the atom to replace next, once the cache is full.
+  size_t next;
+  //! The gap of the last atom returned by the solver (negative if none).
+  double lastGap;
+};
+
+} // namespace ens
+
+#endif
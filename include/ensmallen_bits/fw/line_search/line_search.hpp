@@ -65,20 +65,21 @@ class LineSearch
   double tolerance;
 
   /**
-   * Derivative of the function along the search line.
+   * Derivative of the function along the search line, at a point of the line.
    *
    * @param function original function.
-   * @param x0 starting point.
+   * @param point point on the search line, x0 + gamma * deltaX.
    * @param deltaX distance between two end points.
-   * @param gamma position of the point in the search line, take in [0, 1].
+   * @param gradient buffer to compute the gradient at the point in; it is
+   *     reused between calls, so no memory is allocated.
    *
    * @return Derivative of function(x0 + gamma * deltaX) with respect to gamma.
    */
   template<typename FunctionType>
   double Derivative(FunctionType& function,
-                    const arma::mat& x0,
+                    const arma::mat& point,
                     const arma::mat& deltaX,
-                    const double gamma);
+                    arma::mat& gradient);
 };  // class LineSearch
 } // namespace ens
 
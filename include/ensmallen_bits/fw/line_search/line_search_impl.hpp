@@ -31,11 +31,14 @@ double LineSearch::Optimize(FunctionType& function,
   traits::CheckFunctionTypeAPI<FullFunctionType>();
 
   // Set up the search line, that is,
-  // find the zero of der(gamma) = Derivative(gamma).
+  // find the zero of der(gamma) = Derivative(gamma).  The points on the line
+  // and their gradients are formed in the same buffers at every step.
   arma::mat deltaX = x2 - x1;
+  arma::mat point(x1.n_rows, x1.n_cols);
+  arma::mat gradient(x1.n_rows, x1.n_cols);
   double gamma = 0;
-  double derivative = Derivative(f, x1, deltaX, 0);
-  double derivativeNew = Derivative(f, x1, deltaX, 1);
+  double derivative = Derivative(f, x1, deltaX, gradient);
+  double derivativeNew = Derivative(f, x2, deltaX, gradient);
   double secant = derivativeNew - derivative;
 
   if (derivative >= 0.0) // Optimal solution at left endpoint.
@@ -70,7 +73,8 @@ double LineSearch::Optimize(FunctionType& function,
     gammaNew = std::min(gammaNew, 1.0);
 
     // Update secant, gamma and derivative
-    derivativeNew = Derivative(function, x1, deltaX, gammaNew);
+    point = x1 + gammaNew * deltaX;
+    derivativeNew = Derivative(f, point, deltaX, gradient);
     secant = (derivativeNew - derivative) / (gammaNew - gamma);
     gamma = gammaNew;
     derivative = derivativeNew;
@@ -79,7 +83,7 @@ double LineSearch::Optimize(FunctionType& function,
     {
       Info << "LineSearchSecant: minimized within tolerance "
           << tolerance << "; " << "terminating optimization." << std::endl;
-      x2 = (1 - gamma) * x1 + gamma * x2;
+      x2 = point;
       return f.Evaluate(x2);
     }
   }
@@ -95,12 +99,11 @@ double LineSearch::Optimize(FunctionType& function,
 //! Derivative of the function along the search line.
 template<typename FunctionType>
 double LineSearch::Derivative(FunctionType& function,
-                              const arma::mat& x0,
+                              const arma::mat& point,
                               const arma::mat& deltaX,
-                              const double gamma)
+                              arma::mat& gradient)
 {
-  arma::mat gradient(x0.n_rows, x0.n_cols);
-  function.Gradient(x0 + gamma * deltaX, gradient);
+  function.Gradient(point, gradient);
   return arma::dot(gradient, deltaX);
 }
 
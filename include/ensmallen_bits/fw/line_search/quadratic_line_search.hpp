@@ -0,0 +1,84 @@
+/**
+ * @file quadratic_line_search.hpp
+ *
+ * Exact line search for quadratic functions, in closed form.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LINE_SEARCH_QUADRATIC_LINE_SEARCH_HPP
+#define ENSMALLEN_LINE_SEARCH_QUADRATIC_LINE_SEARCH_HPP
+
+namespace ens {
+
+/**
+ * Find the minimum of a quadratic function (such as FuncSq) along the line
+ * between two points, in closed form.  Along the line, a quadratic function is
+ * a parabola in gamma, so its derivative
+ *
+ * \f[
+ * d(\gamma) = \nabla f(x_1 + \gamma \Delta x)^T \Delta x
+ * \f]
+ *
+ * is affine, and the minimizer on [0, 1] is \f$ \gamma = d(0) / (d(0) - d(1))
+ * \f$ (clamped to the interval).  This takes two gradient evaluations, at the
+ * two end points, and one function evaluation, instead of the iterations of
+ * the secant method in LineSearch.
+ *
+ * For functions that are not quadratic, the step is a single secant step, which
+ * is only an approximation of the minimum; use LineSearch for those.
+ */
+class QuadraticLineSearch
+{
+ public:
+  /**
+   * Construct the line search.  The constructor takes the same parameters as
+   * LineSearch, so that the two can be used interchangeably; maxIterations is
+   * not used, since the step is computed without iterations.
+   *
+   * @param maxIterations Not used.
+   * @param tolerance Below this directional curvature, the function is taken
+   *     to be flat along the line and the left end point is returned.
+   */
+  QuadraticLineSearch(const size_t maxIterations = 100000,
+                      const double tolerance = 1e-5) :
+      maxIterations(maxIterations), tolerance(tolerance)
+  {/* Do nothing */ }
+
+  /**
+   * Line search to minimize a quadratic function between two points.
+   *
+   * @param function function to be minimized.
+   * @param x1 Input one end point.
+   * @param x2 Input the other end point, also used as output, to store the
+   *           coordinate of the optimal solution.
+   * @return Minimum solution function value.
+   */
+  template<typename FunctionType>
+  double Optimize(FunctionType& function, const arma::mat& x1, arma::mat& x2);
+
+  //! Get the maximum number of iterations (not used).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (not used).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for flatness.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for flatness.
+  double& Tolerance() { return tolerance; }
+
+ private:
+  //! Max number of iterations (not used).
+  size_t maxIterations;
+
+  //! Tolerance for flatness.
+  double tolerance;
+};  // class QuadraticLineSearch
+
+} // namespace ens
+
+#include "quadratic_line_search_impl.hpp"
+
+#endif
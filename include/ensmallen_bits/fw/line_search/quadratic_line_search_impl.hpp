@@ -0,0 +1,66 @@
+/**
+ * @file quadratic_line_search_impl.hpp
+ *
+ * Implementation of the closed-form line search for quadratic functions.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LINE_SEARCH_QUADRATIC_LINE_SEARCH_IMPL_HPP
+#define ENSMALLEN_LINE_SEARCH_QUADRATIC_LINE_SEARCH_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "quadratic_line_search.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+template<typename FunctionType>
+double QuadraticLineSearch::Optimize(FunctionType& function,
+                                     const arma::mat& x1,
+                                     arma::mat& x2)
+{
+  typedef Function<FunctionType> FullFunctionType;
+  FullFunctionType& f = static_cast<FullFunctionType&>(function);
+
+  // Check that we have all the functions we will need.
+  traits::CheckFunctionTypeAPI<FullFunctionType>();
+
+  // The derivatives along the line at the end points share one gradient
+  // buffer.
+  const arma::mat deltaX = x2 - x1;
+  arma::mat gradient(x1.n_rows, x1.n_cols);
+  f.Gradient(x1, gradient);
+  const double derivative = arma::dot(gradient, deltaX);
+  f.Gradient(x2, gradient);
+  const double derivativeNew = arma::dot(gradient, deltaX);
+  const double curvature = derivativeNew - derivative;
+
+  if (derivative >= 0.0) // Optimal solution at left endpoint.
+  {
+    x2 = x1;
+    return f.Evaluate(x1);
+  }
+  else if (derivativeNew <= 0.0) // Optimal solution at right endpoint.
+  {
+    return f.Evaluate(x2);
+  }
+  else if (curvature < tolerance) // function too flat, just take left endpoint.
+  {
+    x2 = x1;
+    return f.Evaluate(x1);
+  }
+
+  // The zero of the affine derivative; it is in (0, 1), since the derivative
+  // changes sign.
+  const double gamma = -derivative / curvature;
+  x2 = x1 + gamma * deltaX;
+  return f.Evaluate(x2);
+}
+
+} // namespace ens
+
+#endif
@@ -12,11 +12,28 @@
 
 #include "proximal.hpp"
 
+#include <algorithm>
+#include <vector>
+
 namespace ens {
 
 /**
- * Projection of the vector v onto l1 ball with norm tau.
- * See the paper:
+ * Projection of the vector v onto l1 ball with norm tau.  This is a soft
+ * thresholding of v; the threshold is the one of the projection of |v| onto the
+ * simplex of radius tau, which is found in expected linear time (and without
+ * sorting) with the algorithm of Condat:
+ * @code
+ * @article{Condat2016,
+ *    author  = {Condat, Laurent},
+ *    title   = {Fast projection onto the simplex and the l1 ball},
+ *    journal = {Mathematical Programming},
+ *    volume  = {158},
+ *    number  = {1},
+ *    pages   = {575--585},
+ *    year    = {2016}}
+ * @endcode
+ *
+ * See also the paper:
  * @code
  * @inproceedings{DucShaSin2008Efficient,
  *    author       = {Duchi, John and Shalev-Shwartz, Shai and Singer,
@@ -29,33 +46,80 @@ namespace ens {
  *                    high dimensions},
  *    year         = {2008}}
  * @endcode
- *
- * This is just a soft thresholding.
  */
 inline void Proximal::ProjectToL1Ball(arma::vec& v, double tau)
 {
-  arma::vec simplexSol = arma::abs(v);
-
   // Already with L1 norm <= tau.
-  if (arma::accu(simplexSol) <= tau)
+  if (arma::norm(v, 1) <= tau)
     return;
 
-  simplexSol = arma::sort(simplexSol, "descend");
-  arma::vec simplexSum = arma::cumsum(simplexSol);
+  if (tau <= 0.0)
+  {
+    v.zeros();
+    return;
+  }
+
+  // Find the threshold theta, the mean of the active values minus tau divided
+  // by their number.  The active candidates are kept in active; candidates that
+  // were dropped but may still be active are kept in waiting.
+  std::vector<double> active, waiting;
+  active.reserve(v.n_elem);
+  active.push_back(std::abs(v(0)));
+  double theta = active[0] - tau;
+  for (arma::uword j = 1; j < v.n_elem; ++j)
+  {
+    const double y = std::abs(v(j));
+    if (y <= theta)
+      continue;
+
+    theta += (y - theta) / (active.size() + 1);
+    if (theta > y - tau)
+    {
+      active.push_back(y);
+    }
+    else
+    {
+      waiting.insert(waiting.end(), active.begin(), active.end());
+      active.assign(1, y);
+      theta = y - tau;
+    }
+  }
+
+  for (size_t j = 0; j < waiting.size(); ++j)
+  {
+    if (waiting[j] > theta)
+    {
+      active.push_back(waiting[j]);
+      theta += (waiting[j] - theta) / active.size();
+    }
+  }
 
-  double nu = 0;
-  size_t rho;
-  for (size_t j = 1; j <= simplexSol.n_rows; j++)
+  // Remove the candidates that are not above the threshold, until none are
+  // left.
+  bool removed = true;
+  while (removed)
   {
-    rho = simplexSol.n_rows - j;
-    nu = simplexSol(rho) - (simplexSum(rho) - tau)/(rho + 1);
-    if (nu > 0)
-      break;
+    removed = false;
+    size_t activeSize = active.size();
+    size_t kept = 0;
+    for (size_t j = 0; j < active.size(); ++j)
+    {
+      if (active[j] <= theta && activeSize > 1)
+      {
+        --activeSize;
+        theta += (theta - active[j]) / activeSize;
+        removed = true;
+      }
+      else
+      {
+        active[kept++] = active[j];
+      }
+    }
+    active.resize(kept);
   }
-  double theta = (simplexSum(rho) - tau)/rho;
 
   // Threshold on absolute value of v with theta.
-  for (arma::uword j = 0; j< simplexSol.n_rows; j++)
+  for (arma::uword j = 0; j < v.n_elem; j++)
   {
     if (v(j) >= 0.0)
       v(j) = std::max(v(j) - theta, 0.0);
@@ -66,15 +130,34 @@ inline void Proximal::ProjectToL1Ball(arma::vec& v, double tau)
 
 /**
  * Approximate the vector v with a tau-sparse vector.
- * This is a hard-thresholding.
+ * This is a hard-thresholding: the tau entries with the largest magnitude are
+ * found with a partial selection (std::nth_element) in expected linear time,
+ * and the other entries are set to zero.
  */
 inline void Proximal::ProjectToL0Ball(arma::vec& v, int tau)
 {
-  arma::uvec indices = arma::sort_index(arma::abs(v));
-  arma::uword numberToKill = v.n_elem - tau;
+  if (tau <= 0)
+  {
+    v.zeros();
+    return;
+  }
+
+  if (arma::uword(tau) >= v.n_elem)
+    return;
+
+  // Put the indices of the tau largest magnitudes first.
+  std::vector<arma::uword> indices(v.n_elem);
+  for (arma::uword i = 0; i < v.n_elem; ++i)
+    indices[i] = i;
+
+  std::nth_element(indices.begin(), indices.begin() + tau, indices.end(),
+      [&v](const arma::uword a, const arma::uword b)
+      {
+        return std::abs(v(a)) > std::abs(v(b));
+      });
 
-  for (arma::uword i = 0; i < numberToKill; i++)
-    v(indices(i)) = 0.0;
+  for (size_t i = tau; i < indices.size(); i++)
+    v(indices[i]) = 0.0;
 }
 
 } // namespace ens
@@ -0,0 +1,157 @@
+/**
+ * @file stochastic_frank_wolfe.hpp
+ *
+ * Stochastic Frank-Wolfe with averaged mini-batch gradients.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FW_STOCHASTIC_FRANK_WOLFE_HPP
+#define ENSMALLEN_FW_STOCHASTIC_FRANK_WOLFE_HPP
+
+#include "frank_wolfe.hpp"
+
+namespace ens {
+
+/**
+ * Stochastic Frank-Wolfe minimizes a separable function
+ * \f$ f(x) = \sum_i f_i(x) \f$ over a compact convex set \f$ D \f$ without
+ * computing its full gradient.  In each iteration \f$ k \f$ (starting from
+ * 0), the gradient of a mini-batch is scaled to an unbiased estimate
+ * \f$ \hat{g}_k \f$ of the full gradient and averaged with the earlier ones,
+ *
+ * \f[
+ * d_k := (1 - \rho_k) d_{k-1} + \rho_k \hat{g}_k, \quad
+ * \rho_k = \frac{4}{(k + 8)^{2/3}},
+ * \f]
+ *
+ * and the linear constrained problem is solved for the averaged gradient:
+ *
+ * \f[
+ * s_k := arg\min_{s\in D} <s, d_k>, \quad
+ * x_{k+1} := (1 - \gamma_k) x_k + \gamma_k s_k, \quad
+ * \gamma_k = \frac{2}{k + 8}.
+ * \f]
+ *
+ * The averaging reduces the variance of the direction, so that (unlike with
+ * the plain mini-batch gradient) the batch size does not have to grow with
+ * the number of iterations.
+ *
+ * As for SGD, the functions are visited in order (shuffled after each epoch
+ * if shuffle is true), and the optimization terminates when the sum of the
+ * objectives of the batches of an epoch changes by less than the tolerance.
+ * The returned objective is computed with a full pass over the functions.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{Mokhtari2018,
+ *   author    = {Mokhtari, Aryan and Hassani, Hamed and Karbasi, Amin},
+ *   title     = {Conditional Gradient Method for Stochastic Submodular
+ *                Maximization: Closing the Gap},
+ *   booktitle = {Proceedings of the 21st International Conference on
+ *                Artificial Intelligence and Statistics},
+ *   pages     = {1886--1895},
+ *   year      = {2018}
+ * }
+ * @endcode
+ *
+ * StochasticFrankWolfe can optimize differentiable separable functions.  For
+ * more details, see the documentation on function types included with this
+ * distribution or on the ensmallen website.
+ *
+ * @tparam LinearConstrSolverType Solver for the linear constrained problem
+ *     (see FrankWolfe).
+ */
+template<typename LinearConstrSolverType>
+class StochasticFrankWolfe
+{
+ public:
+  /**
+   * Construct the stochastic Frank-Wolfe optimizer with the given solver for
+   * the linear constrained problem, which defines the constraint set.
+   *
+   * @param linearConstrSolver Solver for linear constrained problem.
+   * @param batchSize Number of functions in each mini-batch.
+   * @param maxIterations Maximum number of functions to visit (0 means no
+   *     limit).
+   * @param tolerance Maximum absolute change of the objective of an epoch to
+   *     terminate the algorithm.
+   * @param shuffle If true, the function order is shuffled after each epoch;
+   *     otherwise, the functions are visited in linear order.
+   */
+  StochasticFrankWolfe(const LinearConstrSolverType linearConstrSolver,
+                       const size_t batchSize = 32,
+                       const size_t maxIterations = 100000,
+                       const double tolerance = 1e-5,
+                       const bool shuffle = true);
+
+  /**
+   * Optimize the given function using stochastic Frank-Wolfe.  The given
+   * starting point will be modified to store the finishing point of the
+   * algorithm, and the final objective value is returned.
+   *
+   * @tparam SeparableFunctionType Type of function to optimize.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to be optimized.
+   * @param iterate Input with starting point, and will be modified to save
+   *     the output solution coordinates.
+   * @param callbacks Callback functions.
+   * @return Objective value at the final solution.
+   */
+  template<typename SeparableFunctionType, typename... CallbackTypes>
+  double Optimize(SeparableFunctionType& function,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
+
+  //! Get the linear constrained solver.
+  const LinearConstrSolverType& LinearConstrSolver()
+      const { return linearConstrSolver; }
+  //! Modify the linear constrained solver.
+  LinearConstrSolverType& LinearConstrSolver() { return linearConstrSolver; }
+
+  //! Get the batch size.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the individual functions are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the individual functions are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+ private:
+  //! Solver for linear constrained problem.
+  LinearConstrSolverType linearConstrSolver;
+
+  //! The number of functions in each mini-batch.
+  size_t batchSize;
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the individual functions are shuffled.
+  bool shuffle;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "stochastic_frank_wolfe_impl.hpp"
+
+#endif
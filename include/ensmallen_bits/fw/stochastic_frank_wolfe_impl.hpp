@@ -0,0 +1,178 @@
+/**
+ * @file stochastic_frank_wolfe_impl.hpp
+ *
+ * Implementation of stochastic Frank-Wolfe.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FW_STOCHASTIC_FRANK_WOLFE_IMPL_HPP
+#define ENSMALLEN_FW_STOCHASTIC_FRANK_WOLFE_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "stochastic_frank_wolfe.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+template<typename LinearConstrSolverType>
+StochasticFrankWolfe<LinearConstrSolverType>::StochasticFrankWolfe(
+    const LinearConstrSolverType linearConstrSolver,
+    const size_t batchSize,
+    const size_t maxIterations,
+    const double tolerance,
+    const bool shuffle) :
+    linearConstrSolver(linearConstrSolver),
+    batchSize(batchSize),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    shuffle(shuffle)
+{ /* Nothing to do. */ }
+
+template<typename LinearConstrSolverType>
+template<typename SeparableFunctionType, typename... CallbackTypes>
+double StochasticFrankWolfe<LinearConstrSolverType>::Optimize(
+    SeparableFunctionType& function,
+    arma::mat& iterate,
+    CallbackTypes&&... callbacks)
+{
+  typedef Function<SeparableFunctionType, arma::mat, arma::mat>
+      FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+  ENS_PROFILE_OPTIMIZE("StochasticFrankWolfe");
+
+  // Make sure we have all the methods that we need.
+  traits::CheckDecomposableFunctionTypeAPI<FullFunctionType, arma::mat,
+      arma::mat>();
+
+  if (batchSize == 0)
+  {
+    throw std::invalid_argument("StochasticFrankWolfe::Optimize(): the batch "
+        "size must be positive!");
+  }
+
+  const size_t numFunctions = f.NumFunctions();
+
+  // To keep track of where we are and how things are going.
+  size_t currentFunction = 0;
+  double overallObjective = 0;
+  double lastObjective = DBL_MAX;
+
+  arma::mat gradient(iterate.n_rows, iterate.n_cols);
+  arma::mat direction(iterate.n_rows, iterate.n_cols, arma::fill::zeros);
+  arma::mat s(iterate.n_rows, iterate.n_cols);
+
+  // Track the current epoch and whether a callback asked us to stop.
+  size_t epoch = 0;
+  bool terminate = false;
+  bool minimized = false;
+  terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
+
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+  size_t k = 0;
+  for (size_t i = 0; i < actualMaxIterations && !terminate; ++k)
+  {
+    // Is this iteration the start of a sequence?
+    if ((currentFunction % numFunctions) == 0 && i > 0)
+    {
+      // Output current objective function.
+      Info << "StochasticFrankWolfe::Optimize(): iteration " << i
+          << ", objective " << overallObjective << ".\n";
+
+      terminate |= Callback::EndEpoch(*this, f, iterate, epoch++,
+          overallObjective, callbacks...);
+
+      if (std::isnan(overallObjective) || std::isinf(overallObjective))
+      {
+        Warn << "StochasticFrankWolfe::Optimize(): converged to "
+            << overallObjective << "; terminating with failure." << std::endl;
+        Callback::EndOptimization(*this, f, iterate, callbacks...);
+        return overallObjective;
+      }
+
+      if (std::abs(lastObjective - overallObjective) < tolerance)
+      {
+        Info << "StochasticFrankWolfe::Optimize(): minimized within tolerance "
+            << tolerance << "; terminating optimization." << std::endl;
+        minimized = true;
+        break;
+      }
+
+      if (terminate)
+      {
+        Info << "StochasticFrankWolfe::Optimize(): callback requested "
+            << "termination." << std::endl;
+        break;
+      }
+
+      // Reset the counter variables.
+      lastObjective = overallObjective;
+      overallObjective = 0;
+      currentFunction = 0;
+
+      if (shuffle) // Determine order of visitation.
+      {
+        ENS_PROFILE_SCOPE("Shuffle");
+        f.Shuffle();
+      }
+
+      terminate |= Callback::BeginEpoch(*this, f, iterate, epoch,
+          lastObjective, callbacks...);
+    }
+
+    const size_t effectiveBatchSize = std::min(
+        std::min(batchSize, actualMaxIterations - i),
+        numFunctions - currentFunction);
+
+    double objective;
+    {
+      ENS_PROFILE_SCOPE("EvaluateWithGradient");
+      objective = f.EvaluateWithGradient(iterate, currentFunction, gradient,
+          effectiveBatchSize);
+    }
+    overallObjective += objective;
+
+    terminate |= Callback::EvaluateWithGradient(*this, f, iterate, objective,
+        gradient, callbacks...);
+
+    // Scale the gradient of the batch to an estimate of the full gradient, and
+    // average it into the direction.
+    const double rho = 4.0 / std::pow((double) k + 8.0, 2.0 / 3.0);
+    direction *= (1.0 - rho);
+    direction += (rho * numFunctions / effectiveBatchSize) * gradient;
+
+    {
+      ENS_PROFILE_SCOPE("LinearConstrSolver");
+      linearConstrSolver.Optimize(direction, s);
+    }
+
+    const double gamma = 2.0 / ((double) k + 8.0);
+    iterate *= (1.0 - gamma);
+    iterate += gamma * s;
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+
+    i += effectiveBatchSize;
+    currentFunction += effectiveBatchSize;
+  }
+
+  if (!terminate && !minimized)
+  {
+    Info << "StochasticFrankWolfe::Optimize(): maximum iterations ("
+        << maxIterations << ") reached; terminating optimization."
+        << std::endl;
+  }
+
+  // Calculate the final objective with a full pass.
+  overallObjective = FullPassEvaluate(f, iterate, batchSize);
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+  return overallObjective;
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,162 @@
+/**
+ * @file update_away_step.hpp
+ *
+ * Away-step and pairwise update rules for the FrankWolfe algorithm, which keep
+ * the solution as a convex combination of the atoms returned by the linear
+ * constrained solver.  Used as UpdateRuleType.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FW_UPDATE_AWAY_STEP_HPP
+#define ENSMALLEN_FW_UPDATE_AWAY_STEP_HPP
+
+#include "atoms.hpp"
+#include "line_search/line_search.hpp"
+
+namespace ens {
+
+/**
+ * Away-step Frank-Wolfe update rule.  The solution is kept as a convex
+ * combination of the starting point and of the atoms s returned by the linear
+ * constrained solver (the active set).  In each iteration, either a Frank-Wolfe
+ * step towards s or an away step from the active atom v that has the largest
+ * inner product with the gradient is taken, whichever direction has the larger
+ * inner product with the negative gradient:
+ * \f[
+ * x_{k+1} = (1-\gamma) x_k + \gamma s \quad \textrm{or} \quad
+ * x_{k+1} = (1+\gamma) x_k - \gamma v.
+ * \f]
+ *
+ * With the pairwise variant, the step instead moves the coefficient gamma from
+ * v to s:
+ * \f[
+ * x_{k+1} = x_k + \gamma (s - v).
+ * \f]
+ *
+ * In both cases gamma is found with line search, and it is at most the step
+ * that drops v from the active set.  Unlike the classic rules, these converge
+ * linearly for strongly convex functions when the constraint domain is a
+ * polytope (such as an l1 or l-inf ball).  Any differentiable function can be
+ * used.  Each update computes the gradient at the previous solution once more,
+ * to choose the away atom.
+ *
+ * For more information, see the following paper:
+ *
+ * @code
+ * @inproceedings{Lacoste-Julien2015,
+ *   author    = {Lacoste-Julien, Simon and Jaggi, Martin},
+ *   title     = {On the Global Linear Convergence of {Frank-Wolfe}
+ *                Optimization Variants},
+ *   booktitle = {Advances in Neural Information Processing Systems 28},
+ *   pages     = {496--504},
+ *   year      = {2015}
+ * }
+ * @endcode
+ */
+class UpdateAwayStep
+{
+ public:
+  /**
+   * Construct the away-step update rule.
+   *
+   * @param pairwise Whether to take pairwise steps instead of choosing between
+   *     Frank-Wolfe and away steps.
+   * @param maxIterations Max number of iterations in line search.
+   * @param tolerance Tolerance for termination of line search.
+   */
+  UpdateAwayStep(const bool pairwise = false,
+                 const size_t maxIterations = 100000,
+                 const double tolerance = 1e-5) :
+      pairwise(pairwise), maxIterations(maxIterations), tolerance(tolerance)
+  { /* Do nothing. */ }
+
+  /**
+   * Update rule for FrankWolfe, take an away step, a Frank-Wolfe step or a
+   * pairwise step.  At the first iteration, the active set is reset to the
+   * starting point.
+   *
+   * @param function function to be optimized.
+   * @param oldCoords previous solution coords.
+   * @param s current linear_constr_solution result.
+   * @param newCoords output new solution coords.
+   * @param numIter current iteration number.
+   */
+  template<typename FunctionType>
+  void Update(FunctionType& function,
+              const arma::mat& oldCoords,
+              const arma::mat& s,
+              arma::mat& newCoords,
+              const size_t numIter)
+  {
+    if (numIter == 1 || atoms.CurrentAtoms().is_empty())
+    {
+      atoms = Atoms();
+      atoms.AddAtom(arma::vectorise(oldCoords), 1.0);
+    }
+
+    arma::uword toward = atoms.FindAtom(arma::vectorise(s));
+    if (toward == atoms.CurrentAtoms().n_cols)
+      toward = atoms.AddAtom(arma::vectorise(s), 0.0);
+
+    arma::mat gradient;
+    function.Gradient(oldCoords, gradient);
+    const arma::uword away = atoms.AwayAtom(gradient);
+
+    LineSearch lineSearch(maxIterations, tolerance);
+    newCoords = oldCoords;
+    if (pairwise)
+    {
+      atoms.PairwiseStep(function, toward, away, lineSearch, newCoords);
+      return;
+    }
+
+    // Compare the Frank-Wolfe gap with the away gap.
+    const arma::vec g = arma::vectorise(gradient);
+    const double fwGap = arma::dot(g, arma::vectorise(oldCoords - s));
+    const double awayGap = arma::as_scalar(
+        atoms.CurrentAtoms().col(away).t() * g) -
+        arma::dot(g, arma::vectorise(oldCoords));
+    if (fwGap >= awayGap)
+      atoms.FrankWolfeStep(function, toward, lineSearch, newCoords);
+    else
+      atoms.AwayStep(function, away, lineSearch, newCoords);
+  }
+
+  //! Get whether pairwise steps are taken.
+  bool Pairwise() const { return pairwise; }
+  //! Modify whether pairwise steps are taken.
+  bool& Pairwise() { return pairwise; }
+
+  //! Get the maximum number of iterations in line search.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations in line search.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination of line search.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination of line search.
+  double& Tolerance() { return tolerance; }
+
+  //! Get the active set.
+  const Atoms& ActiveSet() const { return atoms; }
+
+ private:
+  //! Whether pairwise steps are taken.
+  bool pairwise;
+
+  //! Max number of iterations in line search.
+  size_t maxIterations;
+
+  //! Tolerance for termination of line search.
+  double tolerance;
+
+  //! The active set: the atoms and their convex coefficients.
+  Atoms atoms;
+}; // class UpdateAwayStep
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,150 @@
+/**
+ * @file update_fully_corrective.hpp
+ *
+ * Fully-corrective update rule for the FrankWolfe algorithm, which reoptimizes
+ * any differentiable function over the convex hull of the atoms returned by
+ * the linear constrained solver.  Used as UpdateRuleType.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FW_UPDATE_FULLY_CORRECTIVE_HPP
+#define ENSMALLEN_FW_UPDATE_FULLY_CORRECTIVE_HPP
+
+#include "atoms.hpp"
+#include "line_search/line_search.hpp"
+
+namespace ens {
+
+/**
+ * Fully-corrective Frank-Wolfe update rule.  The atom s returned by the linear
+ * constrained solver is added to the active set (which starts with the
+ * starting point), and the function is then minimized over the convex hull of
+ * the active set:
+ * \f[
+ * x_{k+1} := arg\min_{x\in conv(x_0, s_0, \cdots, s_k)} f(x).
+ * \f]
+ *
+ * The inner problem is solved approximately, with pairwise steps between the
+ * atoms of the active set (each with line search), until the gap between the
+ * best and the worst active atom is below innerTolerance or innerIterations
+ * steps were taken.  Atoms whose coefficients reach zero are dropped, so the
+ * active set stays small.
+ *
+ * Unlike UpdateFullCorrection, which is specific to FuncSq and an atom norm
+ * constraint, any differentiable function can be used.
+ */
+class UpdateFullyCorrective
+{
+ public:
+  /**
+   * Construct the fully-corrective update rule.
+   *
+   * @param innerIterations Max number of steps to minimize over the convex
+   *     hull of the active set.
+   * @param innerTolerance Tolerance on the gap of the active set for
+   *     termination of the inner minimization.
+   * @param maxIterations Max number of iterations in line search.
+   * @param tolerance Tolerance for termination of line search.
+   */
+  UpdateFullyCorrective(const size_t innerIterations = 100,
+                        const double innerTolerance = 1e-10,
+                        const size_t maxIterations = 100000,
+                        const double tolerance = 1e-5) :
+      innerIterations(innerIterations),
+      innerTolerance(innerTolerance),
+      maxIterations(maxIterations),
+      tolerance(tolerance)
+  { /* Do nothing. */ }
+
+  /**
+   * Update rule for FrankWolfe, add s to the active set and reoptimize over
+   * its convex hull.  At the first iteration, the active set is reset to the
+   * starting point.
+   *
+   * @param function function to be optimized.
+   * @param oldCoords previous solution coords.
+   * @param s current linear_constr_solution result.
+   * @param newCoords output new solution coords.
+   * @param numIter current iteration number.
+   */
+  template<typename FunctionType>
+  void Update(FunctionType& function,
+              const arma::mat& oldCoords,
+              const arma::mat& s,
+              arma::mat& newCoords,
+              const size_t numIter)
+  {
+    if (numIter == 1 || atoms.CurrentAtoms().is_empty())
+    {
+      atoms = Atoms();
+      atoms.AddAtom(arma::vectorise(oldCoords), 1.0);
+    }
+
+    if (atoms.FindAtom(arma::vectorise(s)) == atoms.CurrentAtoms().n_cols)
+      atoms.AddAtom(arma::vectorise(s), 0.0);
+
+    LineSearch lineSearch(maxIterations, tolerance);
+    newCoords = oldCoords;
+    arma::mat gradient;
+    for (size_t i = 0; i < innerIterations; ++i)
+    {
+      function.Gradient(newCoords, gradient);
+      const arma::vec scores = atoms.CurrentAtoms().t() *
+          arma::vectorise(gradient);
+
+      arma::uword toward;
+      scores.min(toward);
+      const arma::uword away = atoms.AwayAtom(gradient);
+      if (scores(away) - scores(toward) < innerTolerance)
+        break;
+
+      atoms.PairwiseStep(function, toward, away, lineSearch, newCoords);
+    }
+  }
+
+  //! Get the maximum number of inner steps.
+  size_t InnerIterations() const { return innerIterations; }
+  //! Modify the maximum number of inner steps.
+  size_t& InnerIterations() { return innerIterations; }
+
+  //! Get the tolerance for termination of the inner minimization.
+  double InnerTolerance() const { return innerTolerance; }
+  //! Modify the tolerance for termination of the inner minimization.
+  double& InnerTolerance() { return innerTolerance; }
+
+  //! Get the maximum number of iterations in line search.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations in line search.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination of line search.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination of line search.
+  double& Tolerance() { return tolerance; }
+
+  //! Get the active set.
+  const Atoms& ActiveSet() const { return atoms; }
+
+ private:
+  //! Max number of inner steps.
+  size_t innerIterations;
+
+  //! Tolerance for termination of the inner minimization.
+  double innerTolerance;
+
+  //! Max number of iterations in line search.
+  size_t maxIterations;
+
+  //! Tolerance for termination of line search.
+  double tolerance;
+
+  //! The active set: the atoms and their convex coefficients.
+  Atoms atoms;
+}; // class UpdateFullyCorrective
+
+} // namespace ens
+
+#endif
@@ -2,7 +2,8 @@
  * @file update_linesearch.hpp
  * @author Chenzhe Diao
  *
- * Minimize convex function with line search, using secant method.
+ * Minimize convex function with line search, using secant method (or, for
+ * quadratic functions, the exact step in closed form).
  * In FrankWolfe algorithm, used as UpdateRuleType.
  *
  * ensmallen is free software; you may redistribute it and/or modify it under
@@ -14,6 +15,7 @@
 #define ENSMALLEN_FW_UPDATE_LINESEARCH_HPP
 
 #include "line_search/line_search.hpp"
+#include "line_search/quadratic_line_search.hpp"
 
 namespace ens {
 
@@ -25,8 +27,16 @@ namespace ens {
  * x_{k+1} = (1-\gamma) x_k + \gamma s
  * \f]
  *
+ * The line search is done with LineSearchType, which is LineSearch (the secant
+ * method) for UpdateLineSearch, and QuadraticLineSearch (in closed form, for
+ * quadratic functions such as FuncSq) for UpdateQuadraticLineSearch.
+ *
+ * @tparam LineSearchType Line search to use; it must have a constructor taking
+ *     the maximum number of iterations and the tolerance, and an Optimize()
+ *     method with the signature of LineSearch::Optimize().
  */
-class UpdateLineSearch
+template<typename LineSearchType = LineSearch>
+class UpdateLineSearchType
 {
  public:
   /**
@@ -35,14 +45,14 @@ class UpdateLineSearch
    * @param maxIter Max number of iterations in line search.
    * @param tolerance Tolerance for termination of line search.
    */
-  UpdateLineSearch(const size_t maxIterations = 100000,
-                   const double tolerance = 1e-5) :
+  UpdateLineSearchType(const size_t maxIterations = 100000,
+                       const double tolerance = 1e-5) :
       tolerance(tolerance), maxIterations(maxIterations)
   {/* Do nothing */}
 
 
   /**
-   * Update rule for FrankWolfe, optimize with line search using secant method.
+   * Update rule for FrankWolfe, optimize with line search.
    *
    * FunctionType template parameters are required.
    * This class must implement the following functions:
@@ -72,7 +82,7 @@ class UpdateLineSearch
               const size_t /* numIter */)
 
   {
-    LineSearch solver(maxIterations, tolerance);
+    LineSearchType solver(maxIterations, tolerance);
 
     newCoords = s;
     solver.Optimize(function, oldCoords, newCoords);
@@ -94,7 +104,13 @@ class UpdateLineSearch
 
   //! Max number of iterations.
   size_t maxIterations;
-};  // class UpdateLineSearch
+};  // class UpdateLineSearchType
+
+//! Update with line search using the secant method.
+typedef UpdateLineSearchType<LineSearch> UpdateLineSearch;
+
+//! Update with the exact line search for quadratic functions.
+typedef UpdateLineSearchType<QuadraticLineSearch> UpdateQuadraticLineSearch;
 
 } // namespace ens
 
@@ -55,8 +55,7 @@ class UpdateSpan
     atoms.AddAtom(s, function);
 
     // Reoptimize the solution in the current space.
-    arma::vec b = function.Vectorb();
-    atoms.CurrentCoeffs() = solve(function.MatrixA() * atoms.CurrentAtoms(), b);
+    atoms.OptimizeInSpan(function);
 
     // x has coords of only the current atoms, recover the solution
     // to the original size.
@@ -13,6 +13,22 @@
 #define ENSMALLEN_GRADIENT_DESCENT_GRADIENT_DESCENT_HPP
 
 namespace ens {
+namespace traits {
+
+/**
+ * Detect whether the trailing arguments given to GradientDescent::Optimize()
+ * are the categorical dimension information of the hyper-parameter tuning
+ * overload instead of callbacks.
+ */
+template<typename... Ts>
+struct IsCategoricalInfo : std::false_type { };
+
+template<typename T, typename U>
+struct IsCategoricalInfo<T, U> : std::is_same<std::vector<bool>,
+    typename std::remove_cv<typename std::remove_reference<T>::type>::type>
+{ };
+
+} // namespace traits
 
 /**
  * Gradient Descent is a technique to minimize a function. To find a local
@@ -36,6 +52,51 @@ namespace ens {
  * The parameter \f$\epsilon\f$ is specified by the tolerance parameter to the
  * constructor.
  *
+ * Instead of the fixed step size, two other step modes are available.  With
+ * acceleration, Nesterov's momentum is used: the gradient is evaluated at an
+ * extrapolated point
+ *
+ * \f[
+ * y_j = x_j + \frac{t_{j - 1} - 1}{t_j} (x_j - x_{j - 1}), \qquad
+ * x_{j + 1} = y_j - \alpha \nabla F(y_j),
+ * \f]
+ *
+ * with \f$ t_j = (1 + \sqrt{1 + 4 t_{j - 1}^2}) / 2 \f$, and the momentum is
+ * restarted whenever the gradient points against the last step (adaptive
+ * restart).  With Barzilai-Borwein steps, the step size of each iteration is
+ * \f$ s^T s / s^T y \f$, where \f$ s \f$ and \f$ y \f$ are the last
+ * differences of the iterate and of the gradient.  Barzilai-Borwein steps
+ * (and fixed steps) can be safeguarded with a nonmonotone line search: a step
+ * is accepted if the objective is sufficiently below the largest of the last
+ * few accepted objectives, and halved otherwise.  On smooth full-batch
+ * problems, both modes usually need far fewer gradient evaluations than the
+ * fixed step.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @article{ODonoghue2015,
+ *   author  = {O'Donoghue, Brendan and Cand{\`e}s, Emmanuel},
+ *   title   = {Adaptive Restart for Accelerated Gradient Schemes},
+ *   journal = {Foundations of Computational Mathematics},
+ *   volume  = {15},
+ *   number  = {3},
+ *   pages   = {715--732},
+ *   year    = {2015}
+ * }
+ *
+ * @article{Raydan1997,
+ *   author  = {Raydan, Marcos},
+ *   title   = {The {Barzilai} and {Borwein} Gradient Method for the Large
+ *              Scale Unconstrained Minimization Problem},
+ *   journal = {SIAM Journal on Optimization},
+ *   volume  = {7},
+ *   number  = {1},
+ *   pages   = {26--33},
+ *   year    = {1997}
+ * }
+ * @endcode
+ *
  * GradientDescent can optimize differentiable functions.  For more details, see
  * the documentation on function types included with this distribution or on the
  * ensmallen website.
@@ -54,10 +115,21 @@ class GradientDescent
    * @param maxIterations Maximum number of iterations allowed (0 means no
    *     limit).
    * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param accelerated If true, Nesterov-accelerated steps (with adaptive
+   *     restart) are taken.
+   * @param barzilaiBorwein If true, the step size of each iteration is the
+   *     Barzilai-Borwein step size (stepSize is only used for the first step).
+   *     Can't be combined with accelerated.
+   * @param nonmonotoneMemory Number of past objectives the nonmonotone line
+   *     search compares each step with (0 disables the line search).  Not used
+   *     with accelerated steps.
    */
   GradientDescent(const double stepSize = 0.01,
                   const size_t maxIterations = 100000,
-                  const double tolerance = 1e-5);
+                  const double tolerance = 1e-5,
+                  const bool accelerated = false,
+                  const bool barzilaiBorwein = false,
+                  const size_t nonmonotoneMemory = 0);
 
   /**
    * Optimize the given function using gradient descent.  The given starting
@@ -65,12 +137,23 @@ class GradientDescent
    * the final objective value is returned.
    *
    * @tparam FunctionType Type of the function to optimize.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to optimize.
    * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
    * @return Objective value of the final point.
    */
-  template<typename FunctionType>
-  double Optimize(FunctionType& function, arma::mat& iterate);
+  template<typename FunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename std::enable_if<!traits::IsCategoricalInfo<CallbackTypes...>::value,
+      typename MatType::elem_type>::type
+  Optimize(FunctionType& function,
+           MatType& iterate,
+           CallbackTypes&&... callbacks);
 
   /**
    * Assert all dimensions are numeric and optimize the given function using
@@ -111,6 +194,26 @@ class GradientDescent
   //! Modify the tolerance for termination.
   double& Tolerance() { return tolerance; }
 
+  //! Get whether Nesterov-accelerated steps are taken.
+  bool Accelerated() const { return accelerated; }
+  //! Modify whether Nesterov-accelerated steps are taken.
+  bool& Accelerated() { return accelerated; }
+
+  //! Get whether Barzilai-Borwein step sizes are used.
+  bool BarzilaiBorwein() const { return barzilaiBorwein; }
+  //! Modify whether Barzilai-Borwein step sizes are used.
+  bool& BarzilaiBorwein() { return barzilaiBorwein; }
+
+  //! Get the memory of the nonmonotone line search (0 if disabled).
+  size_t NonmonotoneMemory() const { return nonmonotoneMemory; }
+  //! Modify the memory of the nonmonotone line search (0 if disabled).
+  size_t& NonmonotoneMemory() { return nonmonotoneMemory; }
+
+  //! Get the workspace the temporaries are taken from (NULL if none).
+  ens::Workspace* Workspace() const { return workspace; }
+  //! Modify the workspace the temporaries are taken from (NULL if none).
+  ens::Workspace*& Workspace() { return workspace; }
+
  private:
   //! The step size for each example.
   double stepSize;
@@ -120,6 +223,18 @@ class GradientDescent
 
   //! The tolerance for termination.
   double tolerance;
+
+  //! Whether Nesterov-accelerated steps are taken.
+  bool accelerated;
+
+  //! Whether Barzilai-Borwein step sizes are used.
+  bool barzilaiBorwein;
+
+  //! The memory of the nonmonotone line search.
+  size_t nonmonotoneMemory;
+
+  //! The workspace the temporaries are taken from (NULL if none).
+  ens::Workspace* workspace;
 };
 
 } // namespace ens
@@ -17,49 +17,140 @@
 
 #include <ensmallen_bits/function.hpp>
 
+#include <deque>
+
 namespace ens {
 
 //! Constructor.
 inline GradientDescent::GradientDescent(
     const double stepSize,
     const size_t maxIterations,
-    const double tolerance) :
+    const double tolerance,
+    const bool accelerated,
+    const bool barzilaiBorwein,
+    const size_t nonmonotoneMemory) :
     stepSize(stepSize),
     maxIterations(maxIterations),
-    tolerance(tolerance)
+    tolerance(tolerance),
+    accelerated(accelerated),
+    barzilaiBorwein(barzilaiBorwein),
+    nonmonotoneMemory(nonmonotoneMemory),
+    workspace(NULL)
 { /* Nothing to do. */ }
 
 //! Optimize the function (minimize).
-template<typename FunctionType>
-double GradientDescent::Optimize(
-    FunctionType& function, arma::mat& iterate)
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename std::enable_if<!traits::IsCategoricalInfo<CallbackTypes...>::value,
+    typename MatType::elem_type>::type
+GradientDescent::Optimize(FunctionType& function,
+                          MatType& iterateIn,
+                          CallbackTypes&&... callbacks)
 {
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+
   // Use the Function<> wrapper type to provide additional functionality.
-  typedef Function<FunctionType> FullFunctionType;
+  typedef Function<FunctionType, BaseMatType, BaseGradType> FullFunctionType;
   FullFunctionType& f(static_cast<FullFunctionType&>(function));
+  ENS_PROFILE_OPTIMIZE("GradientDescent");
 
   // Make sure we have the methods that we need.
-  traits::CheckFunctionTypeAPI<FullFunctionType>();
+  traits::CheckFunctionTypeAPI<FullFunctionType, BaseMatType, BaseGradType>();
+
+  if (accelerated && barzilaiBorwein)
+  {
+    throw std::invalid_argument("GradientDescent::Optimize(): accelerated "
+        "steps can't be combined with Barzilai-Borwein step sizes");
+  }
+
+  if (accelerated && nonmonotoneMemory > 0)
+  {
+    Warn << "GradientDescent::Optimize(): the nonmonotone line search is not "
+        << "used with accelerated steps." << std::endl;
+  }
+
+  // Vectors are optimized as matrices.
+  BaseMatType& iterate = static_cast<BaseMatType&>(iterateIn);
 
   // To keep track of where we are and how things are going.
-  double overallObjective = std::numeric_limits<double>::max();
-  double lastObjective = std::numeric_limits<double>::max();
+  ElemType overallObjective = std::numeric_limits<ElemType>::max();
+  ElemType lastObjective = std::numeric_limits<ElemType>::max();
+
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+  terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
+
+  // The temporaries are taken from the given workspace, or else from a local
+  // one.
+  ens::Workspace localWorkspace;
+  ens::Workspace& ws = (workspace != NULL) ? *workspace : localWorkspace;
+
+  // With acceleration, the iterate is the extrapolated point the gradient is
+  // evaluated at, and lastIterate is the point of the last gradient step.
+  // Otherwise, lastIterate and lastGradient are the iterate and gradient of
+  // the last accepted step, which the Barzilai-Borwein step size and the line
+  // search need.
+  const bool lineSearch = !accelerated && nonmonotoneMemory > 0;
+  const bool keepLast = accelerated || barzilaiBorwein || lineSearch;
+  BaseGradType& gradient = ws.Get<BaseGradType>(0);
+  BaseMatType& lastIterate = ws.Get<BaseMatType>(1);
+  BaseGradType& lastGradient = ws.Get<BaseGradType>(2);
+  BaseMatType& step = ws.Get<BaseMatType>(3);
+  gradient.set_size(iterate.n_rows, iterate.n_cols);
+  if (accelerated)
+    lastIterate = iterate;
+
+  std::deque<ElemType> pastObjectives;
+  double currentStepSize = stepSize;
+  double lastGradientNormSq = 0.0;
+  double momentum = 1.0;
+  bool hasLast = false;
 
   // Now iterate!
-  arma::mat gradient(iterate.n_rows, iterate.n_cols);
-  for (size_t i = 1; i != maxIterations; ++i)
+  for (size_t i = 1; i != maxIterations && !terminate; ++i)
   {
-    overallObjective = f.EvaluateWithGradient(iterate, gradient);
+    {
+      ENS_PROFILE_SCOPE("EvaluateWithGradient");
+      overallObjective = f.EvaluateWithGradient(iterate, gradient);
+    }
+    terminate |= Callback::EvaluateWithGradient(*this, f, iterate,
+        overallObjective, gradient, callbacks...);
 
     // Output current objective function.
     Info << "Gradient Descent: iteration " << i << ", objective "
-        << overallObjective << "." << std::endl;
+        << overallObjective << ".\n";
+
+    const bool failed = std::isnan(overallObjective) ||
+        std::isinf(overallObjective);
+
+    // The nonmonotone line search rejects steps that don't decrease the
+    // objective sufficiently below the largest of the last accepted
+    // objectives, and retries them with half the step size.
+    if (lineSearch && hasLast)
+    {
+      const ElemType reference = *std::max_element(pastObjectives.begin(),
+          pastObjectives.end());
+      if (failed || overallObjective > reference - 1e-4 * currentStepSize *
+          lastGradientNormSq)
+      {
+        currentStepSize *= 0.5;
+        iterate = lastIterate - currentStepSize * lastGradient;
+        terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+        continue;
+      }
+    }
 
-    if (std::isnan(overallObjective) || std::isinf(overallObjective))
+    if (failed)
     {
       Warn << "Gradient Descent: converged to " << overallObjective
           << "; terminating" << " with failure.  Try a smaller step size?"
           << std::endl;
+      Callback::EndOptimization(*this, f, iterate, callbacks...);
       return overallObjective;
     }
 
@@ -67,6 +158,7 @@ double GradientDescent::Optimize(
     {
       Info << "Gradient Descent: minimized within tolerance "
           << tolerance << "; " << "terminating optimization." << std::endl;
+      Callback::EndOptimization(*this, f, iterate, callbacks...);
       return overallObjective;
     }
 
@@ -74,11 +166,63 @@ double GradientDescent::Optimize(
     lastObjective = overallObjective;
 
     // And update the iterate.
-    iterate -= stepSize * gradient;
+    {
+      ENS_PROFILE_SCOPE("Update");
+      if (accelerated)
+      {
+        // Take the gradient step from the extrapolated point, and restart the
+        // momentum if the gradient points against the last step.
+        step = iterate - stepSize * gradient;
+        step -= lastIterate;
+        if (hasLast && arma::dot(gradient, step) > 0)
+          momentum = 1.0;
+
+        const double nextMomentum = (1.0 + std::sqrt(1.0 + 4.0 * momentum *
+            momentum)) / 2.0;
+        lastIterate += step;
+        iterate = lastIterate + ((momentum - 1.0) / nextMomentum) * step;
+        momentum = nextMomentum;
+      }
+      else
+      {
+        if (lineSearch)
+        {
+          pastObjectives.push_back(overallObjective);
+          if (pastObjectives.size() > nonmonotoneMemory)
+            pastObjectives.pop_front();
+        }
+
+        currentStepSize = stepSize;
+        if (barzilaiBorwein && hasLast)
+        {
+          step = iterate - lastIterate;
+          const double sy = arma::dot(step, gradient - lastGradient);
+          const double bbStepSize = arma::dot(step, step) / sy;
+          if (sy > 0 && std::isfinite(bbStepSize))
+            currentStepSize = bbStepSize;
+        }
+
+        if (keepLast)
+        {
+          lastIterate = iterate;
+          lastGradient = gradient;
+          lastGradientNormSq = arma::dot(gradient, gradient);
+        }
+
+        iterate -= currentStepSize * gradient;
+      }
+      hasLast = keepLast;
+    }
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+  }
+
+  if (!terminate)
+  {
+    Info << "Gradient Descent: maximum iterations (" << maxIterations
+        << ") reached; " << "terminating optimization." << std::endl;
   }
 
-  Info << "Gradient Descent: maximum iterations (" << maxIterations
-      << ") reached; " << "terminating optimization." << std::endl;
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
   return overallObjective;
 }
 
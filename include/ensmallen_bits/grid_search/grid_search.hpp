@@ -18,6 +18,19 @@ namespace ens {
  * An optimizer that finds the minimum of a given function by iterating through
  * points on a multidimensional grid.
  *
+ * The grid points are enumerated with a flat index, as a mixed-radix number
+ * whose digits are the categories of the dimensions (the last dimension
+ * varies fastest).  If parallelEvaluation is true (and OpenMP is enabled), the
+ * points are distributed between threads, each keeping its own best point; the
+ * function's Evaluate() must then be safe to call from multiple threads at
+ * once.  In both cases, ties are resolved in favour of the first point in the
+ * enumeration, so the result does not depend on the number of threads.
+ *
+ * If the function has an EvaluateAsync() method (see EvaluateInFlight()),
+ * up to maxInFlight evaluations are started before the first one is waited
+ * for, which hides the latency of remote evaluations; parallelEvaluation is
+ * then not used.
+ *
  * GridSearch can optimize categorical functions.  For more details, see the
  * documentation on function types included with this distribution or on the
  * ensmallen website.
@@ -25,6 +38,20 @@ namespace ens {
 class GridSearch
 {
  public:
+  /**
+   * Construct the GridSearch optimizer.
+   *
+   * @param parallelEvaluation Whether to evaluate the grid points in parallel
+   *     (requires OpenMP and a thread-safe Evaluate()).
+   * @param maxInFlight Maximum number of asynchronous evaluations in flight,
+   *     for a function with EvaluateAsync() (0 means no limit).
+   */
+  GridSearch(const bool parallelEvaluation = false,
+             const size_t maxInFlight = 64) :
+      parallelEvaluation(parallelEvaluation),
+      maxInFlight(maxInFlight)
+  { /* Nothing to do. */ }
+
   /**
    * Optimize (minimize) the given function by iterating through the all
    * possible combinations of values for the parameters specified in
@@ -44,23 +71,34 @@ class GridSearch
       const std::vector<bool>& categoricalDimensions,
       const arma::Row<size_t>& numCategories);
 
- private:
   /**
-   * Iterate through the last (parameterValueCollections.size() - i) dimensions
-   * of the grid and change the arguments bestObjective and bestParameters if
-   * there is something better. The values for the first i dimensions
-   * (parameters) are specified in the first i rows of the currentParameters
-   * argument.
+   * Compute the parameters of the grid point with the given flat index (the
+   * last dimension varies fastest).
+   *
+   * @param point Flat index of the grid point.
+   * @param numCategories Number of categories in each dimension.
+   * @param parameters Vector to store the parameters of the point into (its
+   *     size is the number of dimensions).
    */
-  template<typename FunctionType>
-  void Optimize(
-      FunctionType& function,
-      double& bestObjective,
-      arma::mat& bestParameters,
-      arma::vec& currentParameters,
-      const std::vector<bool>& categoricalDimensions,
-      const arma::Row<size_t>& numCategories,
-      size_t i);
+  static void GridPoint(size_t point,
+                        const arma::Row<size_t>& numCategories,
+                        arma::vec& parameters);
+
+  //! Get whether the grid points are evaluated in parallel.
+  bool ParallelEvaluation() const { return parallelEvaluation; }
+  //! Modify whether the grid points are evaluated in parallel.
+  bool& ParallelEvaluation() { return parallelEvaluation; }
+
+  //! Get the maximum number of asynchronous evaluations in flight.
+  size_t MaxInFlight() const { return maxInFlight; }
+  //! Modify the maximum number of asynchronous evaluations in flight.
+  size_t& MaxInFlight() { return maxInFlight; }
+
+ private:
+  //! Whether to evaluate the grid points in parallel.
+  bool parallelEvaluation;
+  //! The maximum number of asynchronous evaluations in flight.
+  size_t maxInFlight;
 };
 
 } // namespace ens
@@ -35,53 +35,114 @@ double GridSearch::Optimize(
     }
   }
 
-  double bestObjective = std::numeric_limits<double>::max();
-  bestParameters = arma::mat(categoricalDimensions.size(), 1);
-  arma::vec currentParameters = arma::vec(categoricalDimensions.size());
-
-  /* Initialize best parameters for the case (very unlikely though) when no set
-   * of parameters gives an objective value better than
-   * std::numeric_limits<double>::max() */
-  for (size_t i = 0; i < categoricalDimensions.size(); ++i)
-    bestParameters(i, 0) = 0;
-
-  Optimize(function, bestObjective, bestParameters, currentParameters,
-      categoricalDimensions, numCategories, 0);
-
-  return bestObjective;
-}
-
-template<typename FunctionType>
-void GridSearch::Optimize(
-    FunctionType& function,
-    double& bestObjective,
-    arma::mat& bestParameters,
-    arma::vec& currentParameters,
-    const std::vector<bool>& categoricalDimensions,
-    const arma::Row<size_t>& numCategories,
-    size_t i)
-{
   // Make sure we have the methods that we need.
   traits::CheckNonDifferentiableFunctionTypeAPI<FunctionType>();
 
-  if (i < categoricalDimensions.size())
+  // The number of grid points.
+  const size_t numDimensions = categoricalDimensions.size();
+  size_t numPoints = 1;
+  for (size_t i = 0; i < numDimensions; ++i)
   {
-    for (size_t j = 0; j < numCategories(i); ++j)
+    if (numCategories(i) != 0 &&
+        numPoints > std::numeric_limits<size_t>::max() / numCategories(i))
     {
-      currentParameters(i) = j;
-      Optimize(function, bestObjective, bestParameters, currentParameters,
-          categoricalDimensions, numCategories, i + 1);
+      throw std::invalid_argument("GridSearch::Optimize(): the grid has too "
+          "many points");
     }
+    numPoints *= numCategories(i);
   }
-  else
+
+  // The best objective and the flat index of its point (numPoints if no point
+  // gives an objective better than std::numeric_limits<double>::max()).
+  double bestObjective = std::numeric_limits<double>::max();
+  size_t bestPoint = numPoints;
+
+  // A function with EvaluateAsync() keeps up to maxInFlight evaluations in
+  // flight.  They are collected in order, so the first best point is kept.
+  const size_t window = (maxInFlight == 0 || maxInFlight > numPoints) ?
+      numPoints : maxInFlight;
+  std::vector<arma::vec> inFlightPoints(
+      traits::HasAsyncEvaluate<FunctionType, arma::mat>::value ? window : 0,
+      arma::vec(numDimensions));
+  const bool evaluated = TryEvaluateInFlight(function, numPoints,
+      [&](const size_t point) -> const arma::mat&
+      {
+        arma::vec& parameters = inFlightPoints[point % window];
+        GridPoint(point, numCategories, parameters);
+        return parameters;
+      },
+      [&](const size_t point, const double objective)
+      {
+        if (objective < bestObjective)
+        {
+          bestObjective = objective;
+          bestPoint = point;
+        }
+      }, window);
+
+  if (!evaluated)
   {
-    double objective = function.Evaluate(currentParameters);
-    if (objective < bestObjective)
+    // Functions that are known to be thread-safe are always evaluated in
+    // parallel.
+    const bool parallel = parallelEvaluation ||
+        traits::IsThreadSafeFunction<FunctionType>::value;
+    (void) parallel;
+    #ifdef ENS_USE_OPENMP
+      #pragma omp parallel if(parallel)
+    #endif
     {
-      bestObjective = objective;
-      bestParameters = currentParameters;
+      double localObjective = std::numeric_limits<double>::max();
+      size_t localPoint = numPoints;
+      arma::vec parameters(numDimensions);
+
+      // Each thread visits its points in increasing order, so the strict
+      // comparison keeps its first best point.
+      #ifdef ENS_USE_OPENMP
+        #pragma omp for schedule(dynamic) nowait
+      #endif
+      for (size_t point = 0; point < numPoints; ++point)
+      {
+        GridPoint(point, numCategories, parameters);
+        const double objective = function.Evaluate(parameters);
+        if (objective < localObjective)
+        {
+          localObjective = objective;
+          localPoint = point;
+        }
+      }
+
+      #ifdef ENS_USE_OPENMP
+        #pragma omp critical
+      #endif
+      {
+        if (localObjective < bestObjective ||
+            (localObjective == bestObjective && localPoint < bestPoint))
+        {
+          bestObjective = localObjective;
+          bestPoint = localPoint;
+        }
+      }
     }
   }
+
+  arma::vec parameters(numDimensions, arma::fill::zeros);
+  if (bestPoint < numPoints)
+    GridPoint(bestPoint, numCategories, parameters);
+  bestParameters = parameters;
+
+  return bestObjective;
+}
+
+inline void GridSearch::GridPoint(size_t point,
+                                  const arma::Row<size_t>& numCategories,
+                                  arma::vec& parameters)
+{
+  // The last dimension is the least significant digit.
+  for (size_t i = parameters.n_elem; i > 0; --i)
+  {
+    parameters(i - 1) = point % numCategories(i - 1);
+    point /= numCategories(i - 1);
+  }
 }
 
 } // namespace ens
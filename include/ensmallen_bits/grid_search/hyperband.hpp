@@ -0,0 +1,145 @@
+/**
+ * @file hyperband.hpp
+ *
+ * Hyperband, a bandit-based meta-optimizer that runs successive halving on the
+ * points of a categorical grid with increasing budgets.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_GRID_SEARCH_HYPERBAND_HPP
+#define ENSMALLEN_GRID_SEARCH_HYPERBAND_HPP
+
+#include "grid_search.hpp"
+
+namespace ens {
+
+/**
+ * Hyperband searches the same grids as GridSearch, but evaluates the points
+ * with a budget (for instance, the number of iterations of an inner optimizer
+ * used to train a model with the given hyperparameters), and stops evaluating
+ * poor points early.  The function to optimize must implement
+ *
+ *   double Evaluate(const arma::mat& x, const size_t budget);
+ *
+ * where x holds the categories of the point, and budget is between 1 and
+ * maxBudget.
+ *
+ * Hyperband runs successive halving in brackets.  In bracket s, n grid points
+ * are sampled uniformly without replacement (or every point is used, if the
+ * grid has no more than n points), and evaluated with budget
+ * maxBudget / eta^s; the best 1 / eta of them are then evaluated with a budget
+ * eta times larger, and so on, until the remaining points are evaluated with
+ * maxBudget.  The brackets go from the most aggressive one (many points, small
+ * initial budget) to plain GridSearch-like evaluation of a few points with
+ * maxBudget, and each bracket uses roughly the same total budget.  With
+ * numBrackets = 1, only the most aggressive bracket is run, which is successive
+ * halving.
+ *
+ * The point with the best objective evaluated with maxBudget is returned.  If
+ * parallelEvaluation is true (and OpenMP is enabled), the points of each round
+ * are evaluated in parallel; the function's Evaluate() must then be safe to
+ * call from multiple threads at once.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @article{Li2018,
+ *   author  = {Li, Lisha and Jamieson, Kevin and DeSalvo, Giulia and
+ *              Rostamizadeh, Afshin and Talwalkar, Ameet},
+ *   title   = {Hyperband: A Novel Bandit-Based Approach to Hyperparameter
+ *              Optimization},
+ *   journal = {Journal of Machine Learning Research},
+ *   volume  = {18},
+ *   number  = {185},
+ *   pages   = {1--52},
+ *   year    = {2018}
+ * }
+ * @endcode
+ */
+class Hyperband
+{
+ public:
+  /**
+   * Construct the Hyperband optimizer with the given parameters.
+   *
+   * @param maxBudget Budget of the final evaluations of each bracket.
+   * @param eta Factor by which the number of points is reduced (and the budget
+   *     increased) in each round of successive halving.
+   * @param numBrackets Number of brackets to run, starting from the most
+   *     aggressive one (0 runs all of them).
+   * @param parallelEvaluation Whether to evaluate the points of each round in
+   *     parallel (requires OpenMP and a thread-safe Evaluate()).
+   */
+  Hyperband(const size_t maxBudget = 81,
+            const size_t eta = 3,
+            const size_t numBrackets = 0,
+            const bool parallelEvaluation = false);
+
+  /**
+   * Optimize (minimize) the given function over the grid of categories, and
+   * store the best point in bestParameters.  Only categorical dimensions are
+   * supported.
+   *
+   * @param function Function to optimize; it must take a budget.
+   * @param bestParameters Variable for storing the best point found.
+   * @param categoricalDimensions Set of dimension types.  If a value is true,
+   *     then that dimension is a categorical dimension.
+   * @param numCategories Number of categories in each categorical dimension.
+   * @return The objective of the best point, evaluated with maxBudget.
+   */
+  template<typename FunctionType>
+  double Optimize(FunctionType& function,
+                  arma::mat& bestParameters,
+                  const std::vector<bool>& categoricalDimensions,
+                  const arma::Row<size_t>& numCategories);
+
+  //! Get the budget of the final evaluations.
+  size_t MaxBudget() const { return maxBudget; }
+  //! Modify the budget of the final evaluations.
+  size_t& MaxBudget() { return maxBudget; }
+
+  //! Get the reduction factor.
+  size_t Eta() const { return eta; }
+  //! Modify the reduction factor.
+  size_t& Eta() { return eta; }
+
+  //! Get the number of brackets to run (0 for all).
+  size_t NumBrackets() const { return numBrackets; }
+  //! Modify the number of brackets to run (0 for all).
+  size_t& NumBrackets() { return numBrackets; }
+
+  //! Get whether the points are evaluated in parallel.
+  bool ParallelEvaluation() const { return parallelEvaluation; }
+  //! Modify whether the points are evaluated in parallel.
+  bool& ParallelEvaluation() { return parallelEvaluation; }
+
+  //! Get the total budget used by the last optimization.
+  size_t TotalBudget() const { return totalBudget; }
+
+  //! Get the number of evaluations made by the last optimization.
+  size_t NumEvaluations() const { return numEvaluations; }
+
+ private:
+  //! Budget of the final evaluations.
+  size_t maxBudget;
+  //! Reduction factor.
+  size_t eta;
+  //! Number of brackets to run.
+  size_t numBrackets;
+  //! Whether to evaluate the points in parallel.
+  bool parallelEvaluation;
+
+  //! Total budget used by the last optimization.
+  size_t totalBudget;
+  //! Number of evaluations made by the last optimization.
+  size_t numEvaluations;
+};
+
+} // namespace ens
+
+#include "hyperband_impl.hpp"
+
+#endif
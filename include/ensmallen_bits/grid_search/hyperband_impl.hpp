@@ -0,0 +1,176 @@
+/**
+ * @file hyperband_impl.hpp
+ *
+ * Implementation of the Hyperband meta-optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_GRID_SEARCH_HYPERBAND_IMPL_HPP
+#define ENSMALLEN_GRID_SEARCH_HYPERBAND_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "hyperband.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <set>
+
+namespace ens {
+
+inline Hyperband::Hyperband(const size_t maxBudget,
+                            const size_t eta,
+                            const size_t numBrackets,
+                            const bool parallelEvaluation) :
+    maxBudget(maxBudget),
+    eta(eta),
+    numBrackets(numBrackets),
+    parallelEvaluation(parallelEvaluation),
+    totalBudget(0),
+    numEvaluations(0)
+{
+  // Nothing to do.
+}
+
+template<typename FunctionType>
+double Hyperband::Optimize(FunctionType& function,
+                           arma::mat& bestParameters,
+                           const std::vector<bool>& categoricalDimensions,
+                           const arma::Row<size_t>& numCategories)
+{
+  for (size_t i = 0; i < categoricalDimensions.size(); ++i)
+  {
+    if (!categoricalDimensions[i])
+    {
+      std::ostringstream oss;
+      oss << "Hyperband::Optimize(): the dimension " << i
+          << " is not categorical" << std::endl;
+      throw std::invalid_argument(oss.str());
+    }
+  }
+
+  if (maxBudget == 0 || eta < 2)
+  {
+    throw std::invalid_argument("Hyperband::Optimize(): maxBudget must be "
+        "positive and eta must be at least 2!");
+  }
+
+  // The number of grid points.
+  const size_t numDimensions = categoricalDimensions.size();
+  size_t numPoints = 1;
+  for (size_t i = 0; i < numDimensions; ++i)
+  {
+    if (numCategories(i) != 0 &&
+        numPoints > std::numeric_limits<size_t>::max() / numCategories(i))
+    {
+      throw std::invalid_argument("Hyperband::Optimize(): the grid has too "
+          "many points");
+    }
+    numPoints *= numCategories(i);
+  }
+
+  // The most aggressive bracket starts with budget maxBudget / eta^sMax >= 1.
+  size_t sMax = 0;
+  for (size_t power = 1; power <= maxBudget / eta; power *= eta)
+    ++sMax;
+  const size_t brackets = (numBrackets == 0 || numBrackets > sMax + 1) ?
+      sMax + 1 : numBrackets;
+
+  // The points are sampled with a generator seeded from Armadillo's.
+  std::mt19937 generator(arma::randi<arma::ivec>(1,
+      arma::distr_param(0, std::numeric_limits<int>::max()))(0));
+
+  totalBudget = 0;
+  numEvaluations = 0;
+  double bestObjective = std::numeric_limits<double>::max();
+  size_t bestPoint = numPoints;
+  for (size_t b = 0; b < brackets && numPoints > 0; ++b)
+  {
+    const size_t s = sMax - b;
+    size_t etaS = 1;
+    for (size_t i = 0; i < s; ++i)
+      etaS *= eta;
+
+    // The number of points, so that every bracket uses about the same total
+    // budget.
+    const size_t n = ((sMax + 1) * etaS + s) / (s + 1);
+    std::vector<size_t> points;
+    if (numPoints <= n)
+    {
+      for (size_t p = 0; p < numPoints; ++p)
+        points.push_back(p);
+    }
+    else
+    {
+      std::uniform_int_distribution<size_t> uniform(0, numPoints - 1);
+      std::set<size_t> sampled;
+      while (sampled.size() < n)
+        sampled.insert(uniform(generator));
+      points.assign(sampled.begin(), sampled.end());
+    }
+
+    // Successive halving; round i uses budget maxBudget / eta^(s - i).
+    size_t divisor = etaS;
+    for (size_t i = 0; i <= s; ++i, divisor /= eta)
+    {
+      const size_t budget = maxBudget / divisor;
+      std::vector<double> objectives(points.size());
+
+      ParallelFor(points.size(), [&](const size_t k)
+      {
+        arma::vec parameters(numDimensions);
+        GridSearch::GridPoint(points[k], numCategories, parameters);
+        const double objective = function.Evaluate(parameters, budget);
+        objectives[k] = std::isnan(objective) ?
+            std::numeric_limits<double>::infinity() : objective;
+      }, parallelEvaluation);
+
+      totalBudget += budget * points.size();
+      numEvaluations += points.size();
+
+      if (i == s)
+      {
+        // The final round is evaluated with maxBudget.
+        for (size_t k = 0; k < points.size(); ++k)
+        {
+          if (objectives[k] < bestObjective)
+          {
+            bestObjective = objectives[k];
+            bestPoint = points[k];
+          }
+        }
+        break;
+      }
+
+      // Keep the best 1 / eta of the points (at least one).
+      std::vector<size_t> order(points.size());
+      for (size_t k = 0; k < order.size(); ++k)
+        order[k] = k;
+      std::stable_sort(order.begin(), order.end(),
+          [&objectives](const size_t lhs, const size_t rhs)
+          { return objectives[lhs] < objectives[rhs]; });
+
+      const size_t keep = std::max(size_t(1), points.size() / eta);
+      std::vector<size_t> kept(keep);
+      for (size_t k = 0; k < keep; ++k)
+        kept[k] = points[order[k]];
+      points.swap(kept);
+    }
+  }
+
+  Info << "Hyperband: evaluated " << numEvaluations << " points with a total "
+      << "budget of " << totalBudget << "." << std::endl;
+
+  arma::vec parameters(numDimensions, arma::fill::zeros);
+  if (bestPoint < numPoints)
+    GridSearch::GridPoint(bestPoint, numCategories, parameters);
+  bestParameters = parameters;
+
+  return bestObjective;
+}
+
+} // namespace ens
+
+#endif
@@ -43,6 +43,16 @@ namespace ens {
  * point.  Then, IQN considers the gradient of the objective function operating
  * on an individual point in its update of \f$ A \f$.
  *
+ * The original method keeps a dense n x n Hessian approximation for every
+ * batch, which needs O(numBatches * n^2) memory.  Each step changes them by a
+ * rank-two update, so the inverse of their aggregate is maintained with
+ * Sherman-Morrison updates, in O(n^2) time per step.  If numBasis is nonzero, a
+ * limited-memory variant is used instead: the per-batch Hessian approximations
+ * are replaced by one shared L-BFGS operator built from the numBasis most
+ * recent curvature pairs, so only the last iterate and gradient of each batch
+ * and the pairs themselves are stored, i.e. O((numBatches + numBasis) * n)
+ * memory.
+ *
  * IQN can optimize differentiable separable functions.  For more details, see
  * the documentation on function types included with this distribution or on the
  * ensmallen website.
@@ -63,11 +73,15 @@ class IQN
    * @param maxIterations Maximum number of iterations allowed (0 means no
    *     limit).
    * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param numBasis Number of curvature pairs of the limited-memory variant
+   *     (0 means the original method with one dense Hessian approximation
+   *     per batch).
    */
   IQN(const double stepSize = 0.01,
       const size_t batchSize = 10,
       const size_t maxIterations = 100000,
-      const double tolerance = 1e-5);
+      const double tolerance = 1e-5,
+      const size_t numBasis = 0);
 
   /**
    * Optimize the given function using IQN. The given starting point will be
@@ -82,6 +96,22 @@ class IQN
   template<typename DecomposableFunctionType>
   double Optimize(DecomposableFunctionType& function, arma::mat& iterate);
 
+  /**
+   * Estimate the number of bytes Optimize() allocates for an iterate of the
+   * given size and a function with the given number of separable functions:
+   * the stored iterate and gradient of each batch, and either the dense
+   * Hessian approximation of each batch (numBatches n x n matrices, which
+   * dominate for large iterates) or the numBasis curvature pairs.  The memory
+   * of the iterate and of the function is not included.
+   *
+   * @param numFunctions Number of separable functions.
+   * @param rows Number of rows of the iterate.
+   * @param cols Number of columns of the iterate.
+   */
+  size_t EstimateMemory(const size_t numFunctions,
+                        const size_t rows,
+                        const size_t cols = 1) const;
+
   //! Get the step size.
   double StepSize() const { return stepSize; }
   //! Modify the step size.
@@ -102,7 +132,61 @@ class IQN
   //! Modify the tolerance for termination.
   double& Tolerance() { return tolerance; }
 
+  //! Get the number of curvature pairs (0 means dense Hessians).
+  size_t NumBasis() const { return numBasis; }
+  //! Modify the number of curvature pairs (0 means dense Hessians).
+  size_t& NumBasis() { return numBasis; }
+
  private:
+  /**
+   * Add scale * v * v^T to the given matrix in place, one column at a time,
+   * without forming the outer product.
+   *
+   * @param matrix Matrix to update.
+   * @param scale Scale of the update.
+   * @param v Vector of the update.
+   */
+  static void RankOneUpdate(arma::mat& matrix,
+                            const double scale,
+                            const arma::mat& v);
+
+  /**
+   * Update the given inverse of a matrix A to the inverse of
+   * A + scale * v * v^T with the Sherman-Morrison formula, in O(n^2) time.
+   *
+   * @param inverse Inverse of A, replaced by the updated inverse.
+   * @param scale Scale of the update.
+   * @param v Vector of the update.
+   * @param workspace Workspace for the product of the inverse with v.
+   * @return false if the updated matrix is (numerically) singular, in which
+   *     case the inverse is not modified.
+   */
+  static bool ShermanMorrisonUpdate(arma::mat& inverse,
+                                    const double scale,
+                                    const arma::mat& v,
+                                    arma::mat& workspace);
+
+  /**
+   * Apply the inverse of the limited-memory Hessian approximation to the given
+   * vector with the two-loop recursion.  The pairs are stored in the columns
+   * of s and y as a ring buffer, with the newest at position newest.
+   *
+   * @param v Vector to multiply.
+   * @param s Differences between the iterates of the stored pairs.
+   * @param y Differences between the gradients of the stored pairs.
+   * @param numPairs Number of stored pairs.
+   * @param newest Position of the newest pair.
+   * @param alpha Workspace of numBasis elements.
+   * @param direction Vector to store the product in.
+   */
+  void InverseHessianProduct(const arma::mat& v,
+                             const arma::mat& s,
+                             const arma::mat& y,
+                             const size_t numPairs,
+                             const size_t newest,
+                             arma::vec& alpha,
+                             arma::mat& direction) const;
+
   //! The step size for each example.
   double stepSize;
 
@@ -114,6 +198,9 @@ class IQN
 
   //! The tolerance for termination.
   double tolerance;
+
+  //! The number of curvature pairs of the limited-memory variant.
+  size_t numBasis;
 };
 
 } // namespace ens
@@ -24,13 +24,96 @@ namespace ens {
 inline IQN::IQN(const double stepSize,
                 const size_t batchSize,
                 const size_t maxIterations,
-                const double tolerance) :
+                const double tolerance,
+                const size_t numBasis) :
     stepSize(stepSize),
     batchSize(batchSize),
     maxIterations(maxIterations),
-    tolerance(tolerance)
+    tolerance(tolerance),
+    numBasis(numBasis)
 { /* Nothing to do. */ }
 
+inline size_t IQN::EstimateMemory(const size_t numFunctions,
+                                  const size_t rows,
+                                  const size_t cols) const
+{
+  const size_t n = rows * cols;
+  const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+
+  // The iterate and the gradient of each batch, the initial iterate, the
+  // aggregate gradient, the batch gradient, u and the pair of a step.
+  size_t elements = (2 * numBatches + 6) * n;
+  if (numBasis == 0)
+  {
+    // Q for each batch, B, its inverse, Q s and the direction.
+    elements += (numBatches + 2) * n * n + 2 * n;
+  }
+  else
+  {
+    // The curvature pairs, alpha and the direction.
+    elements += 2 * numBasis * n + numBasis + n;
+  }
+
+  return elements * sizeof(double);
+}
+
+inline void IQN::RankOneUpdate(arma::mat& matrix,
+                               const double scale,
+                               const arma::mat& v)
+{
+  for (size_t j = 0; j < matrix.n_cols; ++j)
+    matrix.col(j) += (scale * v[j]) * v;
+}
+
+inline bool IQN::ShermanMorrisonUpdate(arma::mat& inverse,
+                                       const double scale,
+                                       const arma::mat& v,
+                                       arma::mat& workspace)
+{
+  workspace = inverse * v;
+  const double denominator = 1.0 + scale * arma::dot(v, workspace);
+  if (!std::isfinite(denominator) || std::abs(denominator) < 1e-12)
+    return false;
+
+  RankOneUpdate(inverse, -scale / denominator, workspace);
+  return true;
+}
+
+inline void IQN::InverseHessianProduct(const arma::mat& v,
+                                       const arma::mat& s,
+                                       const arma::mat& y,
+                                       const size_t numPairs,
+                                       const size_t newest,
+                                       arma::vec& alpha,
+                                       arma::mat& direction) const
+{
+  direction = v;
+  if (numPairs == 0)
+    return;
+
+  // Newest to oldest.
+  for (size_t k = 0; k < numPairs; ++k)
+  {
+    const size_t pos = (newest + numBasis - k) % numBasis;
+    alpha[pos] = arma::dot(s.col(pos), direction) /
+        arma::dot(y.col(pos), s.col(pos));
+    direction -= alpha[pos] * y.col(pos);
+  }
+
+  // Scale with the newest pair, as L-BFGS does.
+  direction *= arma::dot(s.col(newest), y.col(newest)) /
+      arma::dot(y.col(newest), y.col(newest));
+
+  // Oldest to newest.
+  for (size_t k = numPairs; k > 0; --k)
+  {
+    const size_t pos = (newest + numBasis - (k - 1)) % numBasis;
+    const double beta = arma::dot(y.col(pos), direction) /
+        arma::dot(y.col(pos), s.col(pos));
+    direction += (alpha[pos] - beta) * s.col(pos);
+  }
+}
+
 //! Optimize the function (minimize).
 template<typename DecomposableFunctionType>
 double IQN::Optimize(DecomposableFunctionType& function, arma::mat& iterate)
@@ -48,9 +131,30 @@ double IQN::Optimize(DecomposableFunctionType& function, arma::mat& iterate)
 
   arma::cube y(iterate.n_rows, iterate.n_cols, numBatches);
   arma::cube t(iterate.n_elem, 1, numBatches);
-  arma::cube Q(iterate.n_elem, iterate.n_elem, numBatches);
-  arma::mat initialIterate = arma::randn(iterate.n_rows, iterate.n_cols);
-  arma::mat B = arma::eye(iterate.n_elem, iterate.n_elem);
+  arma::mat initialIterate(iterate.n_rows, iterate.n_cols);
+  RNG(RNG::ArmaSeed()).Randn(initialIterate);
+
+  // The per-batch Hessian approximations and their aggregate, or, for the
+  // limited-memory variant, the curvature pairs of the shared operator.
+  arma::cube Q;
+  arma::mat B, BInv, hs;
+  arma::mat sHistory, yHistory, direction;
+  arma::vec alpha;
+  size_t numPairs = 0, newestPair = 0;
+  if (numBasis == 0)
+  {
+    Q.set_size(iterate.n_elem, iterate.n_elem, numBatches);
+    B.eye(iterate.n_elem, iterate.n_elem);
+    BInv.eye(iterate.n_elem, iterate.n_elem);
+    hs.set_size(iterate.n_elem, 1);
+    direction.set_size(iterate.n_elem, 1);
+  }
+  else
+  {
+    sHistory.set_size(iterate.n_elem, numBasis);
+    yHistory.set_size(iterate.n_elem, numBasis);
+    alpha.set_size(numBasis);
+  }
 
   arma::mat g = arma::zeros(iterate.n_rows, iterate.n_cols);
   for (size_t i = 0, f = 0; i < numFunctions; f++)
@@ -62,7 +166,8 @@ double IQN::Optimize(DecomposableFunctionType& function, arma::mat& iterate)
         1, false, false);
     function.Gradient(initialIterate, i, y.slice(f), effectiveBatchSize);
 
-    Q.slice(f).eye();
+    if (numBasis == 0)
+      Q.slice(f).eye();
     g += y.slice(f);
     y.slice(f) /= (double) effectiveBatchSize;
 
@@ -98,27 +203,72 @@ double IQN::Optimize(DecomposableFunctionType& function, arma::mat& iterate)
         const arma::mat s = iterateVec - t.slice(it);
         const arma::mat yy = arma::vectorise(gradient - y.slice(it));
 
-        const arma::mat stochasticHessian = Q.slice(it) + yy * yy.t() /
-            arma::as_scalar(yy.t() * s) - Q.slice(it) * s * s.t() *
-            Q.slice(it) / arma::as_scalar(s.t() * Q.slice(it) * s);
-
-        // Update aggregate Hessian approximation.
-        B += (1.0 / numBatches) * (stochasticHessian - Q.slice(it));
-
-        // Update aggregate Hessian-variable product.
-        u += (1.0 / numBatches) * (stochasticHessian * iterateVec -
-            Q.slice(it) * t.slice(it));
-
-        // Update aggregate gradient.
-        g += (1.0 / numBatches) * (gradient - y.slice(it));
-
-        // Update the function information tables.
-        Q.slice(it) = stochasticHessian;
-        y.slice(it) = gradient;
-        t.slice(it) = iterateVec;
-
-        iterateVec = stepSize * B.i() * (u - gVec) + (1 - stepSize) *
-            iterateVec;
+        if (numBasis > 0)
+        {
+          // Store the pair only if it has positive curvature, so that the
+          // shared operator stays positive definite.
+          if (arma::dot(s, yy) > 0)
+          {
+            newestPair = (numPairs == 0) ? 0 : (newestPair + 1) % numBasis;
+            numPairs = std::min(numPairs + 1, numBasis);
+            sHistory.col(newestPair) = s;
+            yHistory.col(newestPair) = yy;
+          }
+
+          // With the same Hessian approximation for every batch, the
+          // aggregate Hessian-variable product is B times the mean of the
+          // stored iterates; keep that mean in u.
+          u += (1.0 / numBatches) * s;
+          g += (1.0 / numBatches) * (gradient - y.slice(it));
+
+          y.slice(it) = gradient;
+          t.slice(it) = iterateVec;
+
+          InverseHessianProduct(gVec, sHistory, yHistory, numPairs,
+              newestPair, alpha, direction);
+          iterateVec = stepSize * (u - direction) + (1 - stepSize) *
+              iterateVec;
+        }
+        else
+        {
+          // The BFGS update of the batch's Hessian approximation Q is
+          // Q + yy yy^T / (yy^T s) - (Q s) (Q s)^T / (s^T Q s).
+          hs = Q.slice(it) * s;
+          const double ys = arma::dot(yy, s);
+          const double shs = arma::dot(s, hs);
+
+          // Update aggregate Hessian-variable product; with the update above,
+          // Q' x - Q t = Q s + yy (yy^T x) / (yy^T s) - Q s (s^T Q x) /
+          // (s^T Q s), since s = x - t.
+          u += (1.0 / numBatches) * (hs + (arma::dot(yy, iterateVec) / ys) *
+              yy - (arma::dot(hs, iterateVec) / shs) * hs);
+
+          // Update aggregate gradient.
+          g += (1.0 / numBatches) * (gradient - y.slice(it));
+
+          // Update the batch's and the aggregate Hessian approximation, and
+          // the inverse of the aggregate, by the same rank-two update.  If
+          // the update of the inverse breaks down, it is recomputed.
+          RankOneUpdate(Q.slice(it), 1.0 / ys, yy);
+          RankOneUpdate(Q.slice(it), -1.0 / shs, hs);
+          RankOneUpdate(B, 1.0 / (numBatches * ys), yy);
+          RankOneUpdate(B, -1.0 / (numBatches * shs), hs);
+          if (!ShermanMorrisonUpdate(BInv, 1.0 / (numBatches * ys), yy,
+                  direction) ||
+              !ShermanMorrisonUpdate(BInv, -1.0 / (numBatches * shs), hs,
+                  direction))
+          {
+            BInv = B.i();
+          }
+
+          // Update the function information tables.
+          y.slice(it) = gradient;
+          t.slice(it) = iterateVec;
+
+          direction = BInv * (u - gVec);
+          iterateVec = stepSize * direction + (1 - stepSize) *
+              iterateVec;
+        }
       }
 
       f += effectiveBatchSize;
@@ -134,7 +284,7 @@ double IQN::Optimize(DecomposableFunctionType& function, arma::mat& iterate)
 
     // Output current objective function.
     Info << "IQN: iteration " << i << ", objective " << overallObjective
-        << "." << std::endl;
+        << ".\n";
 
     if (std::isnan(overallObjective) || std::isinf(overallObjective))
     {
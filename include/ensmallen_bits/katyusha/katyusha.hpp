@@ -63,6 +63,10 @@ class KatyushaType
    * @param tolerance Maximum absolute tolerance to terminate algorithm.
    * @param shuffle If true, the function order is shuffled; otherwise, each
    *    function is visited in linear order.
+   * @param parallelFullPass If true, split the full gradient and objective
+   *     passes over all functions across OpenMP threads; the separable
+   *     Evaluate() and Gradient() of the function must then be safe to call
+   *     concurrently on disjoint batches.
    */
   KatyushaType(const double convexity = 1.0,
                const double lipschitz = 10.0,
@@ -70,7 +74,8 @@ class KatyushaType
                const size_t maxIterations = 1000,
                const size_t innerIterations = 0,
                const double tolerance = 1e-5,
-               const bool shuffle = true);
+               const bool shuffle = true,
+               const bool parallelFullPass = false);
 
   /**
    * Optimize the given function using Katyusha. The given starting point will
@@ -120,7 +125,84 @@ class KatyushaType
   //! Modify whether or not the individual functions are shuffled.
   bool& Shuffle() { return shuffle; }
 
+  //! Get whether the full passes are computed in parallel.
+  bool ParallelFullPass() const { return parallelFullPass; }
+  //! Modify whether the full passes are computed in parallel.
+  bool& ParallelFullPass() { return parallelFullPass; }
+
+  //! Get the workspace the temporaries are taken from (NULL if none).
+  ens::Workspace* Workspace() const { return workspace; }
+  //! Modify the workspace the temporaries are taken from (NULL if none).
+  ens::Workspace*& Workspace() { return workspace; }
+
+  //! Get how the objective of each outer iteration and the final objective
+  //! are computed.
+  const ens::ObjectiveEstimate& ObjectiveEstimate() const
+  { return objectiveEstimate; }
+  //! Modify how the objective of each outer iteration and the final objective
+  //! are computed.
+  ens::ObjectiveEstimate& ObjectiveEstimate() { return objectiveEstimate; }
+
+  //! Get whether the full gradient is applied lazily, for sparse gradients.
+  bool LazyUpdates() const { return lazyUpdates; }
+  //! Modify whether the full gradient is applied lazily, for sparse
+  //! gradients.
+  bool& LazyUpdates() { return lazyUpdates; }
+
  private:
+  /**
+   * Run the inner iterations of an epoch with sparse gradients, applying the
+   * full gradient lazily.  Between two steps that touch it, a coordinate of
+   * y and z follows a linear recurrence driven by its (constant) full
+   * gradient, so the steps it missed are applied in closed form, from
+   * precomputed powers of the recurrence, when it is next touched or at the
+   * end of the epoch; each step costs O(nnz) instead of O(d).  Only the
+   * non-proximal update (Option I) takes this form.
+   *
+   * @param function Function to optimize.
+   * @param iterate Iterate; it holds the last x of the epoch on return.
+   * @param iterate0 Snapshot of the epoch.
+   * @param fullGradient Full gradient at the snapshot.
+   * @param y The y sequence.
+   * @param z The z sequence.
+   * @param w Storage for the weighted sum of the x of the epoch.
+   * @param ws Workspace to take the temporaries from.
+   * @param tau1 Momentum weight of z.
+   * @param tau2 Momentum weight of the snapshot.
+   * @param alpha Step size of z.
+   * @param r Growth of the weights of the sum.
+   */
+  template<typename DecomposableFunctionType>
+  void LazyEpoch(DecomposableFunctionType& function,
+                 arma::mat& iterate,
+                 const arma::mat& iterate0,
+                 const arma::mat& fullGradient,
+                 arma::mat& y,
+                 arma::mat& z,
+                 arma::mat& w,
+                 ens::Workspace& ws,
+                 const double tau1,
+                 const double tau2,
+                 const double alpha,
+                 const double r,
+                 std::true_type /* supported */);
+
+  //! Lazy updates are not supported for this function or update.
+  template<typename DecomposableFunctionType>
+  void LazyEpoch(DecomposableFunctionType& /* function */,
+                 arma::mat& /* iterate */,
+                 const arma::mat& /* iterate0 */,
+                 const arma::mat& /* fullGradient */,
+                 arma::mat& /* y */,
+                 arma::mat& /* z */,
+                 arma::mat& /* w */,
+                 ens::Workspace& /* ws */,
+                 const double /* tau1 */,
+                 const double /* tau2 */,
+                 const double /* alpha */,
+                 const double /* r */,
+                 std::false_type /* supported */) { }
+
   //! The convexity regularization term.
   double convexity;
 
@@ -142,6 +224,19 @@ class KatyushaType
   //! Controls whether or not the individual functions are shuffled when
   //! iterating.
   bool shuffle;
+
+  //! Whether the full gradient and objective passes are computed in parallel.
+  bool parallelFullPass;
+
+  //! The workspace the temporaries are taken from (NULL if none).
+  ens::Workspace* workspace;
+
+  //! How the objective of each outer iteration and the final objective are
+  //! computed.
+  ens::ObjectiveEstimate objectiveEstimate;
+
+  //! Whether the full gradient is applied lazily, for sparse gradients.
+  bool lazyUpdates;
 };
 
 // Convenience typedefs.
@@ -27,14 +27,18 @@ KatyushaType<Proximal>::KatyushaType(
     const size_t maxIterations,
     const size_t innerIterations,
     const double tolerance,
-    const bool shuffle) :
+    const bool shuffle,
+    const bool parallelFullPass) :
     convexity(convexity),
     lipschitz(lipschitz),
     batchSize(batchSize),
     maxIterations(maxIterations),
     innerIterations(innerIterations),
     tolerance(tolerance),
-    shuffle(shuffle)
+    shuffle(shuffle),
+    parallelFullPass(parallelFullPass),
+    workspace(NULL),
+    lazyUpdates(false)
 { /* Nothing to do. */ }
 
 //! Optimize the function (minimize).
@@ -46,6 +50,11 @@ double KatyushaType<Proximal>::Optimize(
 {
   traits::CheckDecomposableFunctionTypeAPI<DecomposableFunctionType>();
 
+  // The Function wrapper provides the separable EvaluateWithGradient() used
+  // to compute the objective together with the full gradient.
+  typedef Function<DecomposableFunctionType> FullFunctionType;
+  FullFunctionType& fullFunction(static_cast<FullFunctionType&>(function));
+
   // Find the number of functions to use.
   const size_t numFunctions = function.NumFunctions();
 
@@ -77,26 +86,56 @@ double KatyushaType<Proximal>::Optimize(
   double overallObjective = 0;
   double lastObjective = DBL_MAX;
 
-  // Now iterate!
-  arma::mat gradient(iterate.n_rows, iterate.n_cols);
-  arma::mat fullGradient(iterate.n_rows, iterate.n_cols);
-  arma::mat gradient0(iterate.n_rows, iterate.n_cols);
+  // Lazy updates need sparse gradients and the non-proximal update.
+  typedef std::integral_constant<bool, !Proximal &&
+      traits::CheckSparseGradient<DecomposableFunctionType>::value>
+      LazySupported;
+  const bool lazy = lazyUpdates && LazySupported::value;
+  if (lazyUpdates && !LazySupported::value)
+  {
+    Warn << "Katyusha: lazy updates need a sparse Gradient() and the "
+        << "non-proximal update; using dense updates." << std::endl;
+  }
 
-  arma::mat iterate0 = iterate;
-  arma::mat y = iterate;
-  arma::mat z = iterate;
-  arma::mat w = arma::zeros<arma::mat>(iterate.n_rows, iterate.n_cols);
+  // The temporaries are taken from the given workspace, or else from a local
+  // one.
+  ens::Workspace localWorkspace;
+  ens::Workspace& ws = (workspace != NULL) ? *workspace : localWorkspace;
+
+  // Now iterate!
+  arma::mat& gradient = ws.Get<arma::mat>(0);
+  arma::mat& fullGradient = ws.Get<arma::mat>(1);
+  arma::mat& gradient0 = ws.Get<arma::mat>(2);
+  gradient.set_size(iterate.n_rows, iterate.n_cols);
+  fullGradient.set_size(iterate.n_rows, iterate.n_cols);
+  gradient0.set_size(iterate.n_rows, iterate.n_cols);
+
+  arma::mat& iterate0 = ws.Get<arma::mat>(3);
+  arma::mat& y = ws.Get<arma::mat>(4);
+  arma::mat& z = ws.Get<arma::mat>(5);
+  arma::mat& w = ws.Get<arma::mat>(6);
+  arma::mat& zNew = ws.Get<arma::mat>(7);
+  iterate0 = iterate;
+  y = iterate;
+  z = iterate;
+  w.zeros(iterate.n_rows, iterate.n_cols);
+  zNew.set_size(iterate.n_rows, iterate.n_cols);
 
   const size_t actualMaxIterations = (maxIterations == 0) ?
       std::numeric_limits<size_t>::max() : maxIterations;
   for (size_t i = 0; i < actualMaxIterations; ++i)
   {
-    // Calculate the objective function.
-    overallObjective = 0;
-    for (size_t f = 0; f < numFunctions; f += batchSize)
+    // Calculate the objective function; when reusing the objectives, it is
+    // computed in the same pass as the full gradient.
+    if (objectiveEstimate.IsReuse())
     {
-      const size_t effectiveBatchSize = std::min(batchSize, numFunctions - f);
-      overallObjective += function.Evaluate(iterate0, f, effectiveBatchSize);
+      overallObjective = FullPassEvaluateWithGradient(fullFunction,
+          iterate0, batchSize, fullGradient, parallelFullPass);
+    }
+    else
+    {
+      overallObjective = objectiveEstimate.Evaluate(function, iterate0,
+          batchSize, parallelFullPass);
     }
 
     if (std::isnan(overallObjective) || std::isinf(overallObjective))
@@ -116,19 +155,11 @@ double KatyushaType<Proximal>::Optimize(
 
     lastObjective = overallObjective;
 
-    // Compute the full gradient.
-    size_t effectiveBatchSize = std::min(batchSize, numFunctions);
-    function.Gradient(iterate, 0, fullGradient, effectiveBatchSize);
-    for (size_t f = effectiveBatchSize; f < numFunctions;
-        /* incrementing done manually */)
+    // Compute the full gradient at the snapshot.
+    if (!objectiveEstimate.IsReuse())
     {
-      // Find the effective batch size (the last batch may be smaller).
-      effectiveBatchSize = std::min(batchSize, numFunctions - f);
-
-      function.Gradient(iterate0, f, gradient, effectiveBatchSize);
-      fullGradient += gradient;
-
-      f += effectiveBatchSize;
+      FullPassGradient(function, iterate0, batchSize, fullGradient,
+          parallelFullPass);
     }
     fullGradient /= (double) numFunctions;
 
@@ -136,7 +167,13 @@ double KatyushaType<Proximal>::Optimize(
     double cw = 1;
     w.zeros();
 
-    for (size_t f = 0, currentFunction = 0; f < innerIterations;
+    if (lazy)
+    {
+      LazyEpoch(function, iterate, iterate0, fullGradient, y, z, w, ws, tau1,
+          tau2, alpha, r, LazySupported());
+    }
+
+    for (size_t f = 0, currentFunction = 0; f < innerIterations && !lazy;
         /* incrementing done manually */)
     {
       // Is this iteration the start of a sequence?
@@ -150,18 +187,19 @@ double KatyushaType<Proximal>::Optimize(
       }
 
       // Find the effective batch size (the last batch may be smaller).
-      effectiveBatchSize = std::min(batchSize, numFunctions - currentFunction);
+      const size_t effectiveBatchSize = std::min(batchSize,
+          numFunctions - currentFunction);
+      // All the expressions of the inner loop are evaluated into buffers of
+      // the right size, so no memory is allocated.
       iterate = tau1 * z + tau2 * iterate0 + (1 - tau1 - tau2) * y;
 
       // Calculate variance reduced gradient.
-      function.Gradient(iterate, currentFunction, gradient,
-          effectiveBatchSize);
-      function.Gradient(iterate0, currentFunction, gradient0,
-          effectiveBatchSize);
+      DualBatchGradient(function, iterate, iterate0, currentFunction,
+          gradient, gradient0, effectiveBatchSize);
 
       // By the minimality definition of z_{k + 1}, we have that:
       // z_{k+1} − z_k + \alpha * \sigma_{k+1} + \alpha g = 0.
-      arma::mat zNew = z - alpha * (fullGradient + (gradient - gradient0) /
+      zNew = z - alpha * (fullGradient + (gradient - gradient0) /
           (double) batchSize);
 
       // Proximal update, choose between Option I and Option II. Shift relative
@@ -182,7 +220,7 @@ double KatyushaType<Proximal>::Optimize(
         y = iterate + tau1 * (zNew - z);
       }
 
-      z = std::move(zNew);
+      z.swap(zNew);
 
       // sum_{j=0}^{m-1} 1 + std::min(alpha * convexity, 1 / (4 * m)^j * ys).
       w += cw * iterate;
@@ -197,16 +235,198 @@ double KatyushaType<Proximal>::Optimize(
   Info << "Katyusha: maximum iterations (" << maxIterations << ") reached"
       << "; terminating optimization." << std::endl;
 
-  // Calculate final objective.
-  overallObjective = 0;
-  for (size_t i = 0; i < numFunctions; i += batchSize)
+  // Calculate final objective (or keep the one of the last outer
+  // iteration).
+  if (!objectiveEstimate.IsReuse())
   {
-    const size_t effectiveBatchSize = std::min(batchSize, numFunctions - i);
-    overallObjective += function.Evaluate(iterate, i, effectiveBatchSize);
+    overallObjective = objectiveEstimate.Evaluate(function, iterate, batchSize,
+        parallelFullPass);
   }
   return overallObjective;
 }
 
+template<bool Proximal>
+template<typename DecomposableFunctionType>
+void KatyushaType<Proximal>::LazyEpoch(
+    DecomposableFunctionType& function,
+    arma::mat& iterate,
+    const arma::mat& iterate0,
+    const arma::mat& fullGradient,
+    arma::mat& y,
+    arma::mat& z,
+    arma::mat& w,
+    ens::Workspace& ws,
+    const double tau1,
+    const double tau2,
+    const double alpha,
+    const double r,
+    std::true_type /* supported */)
+{
+  const size_t numFunctions = function.NumFunctions();
+
+  // Count the steps of the epoch.
+  size_t numSteps = 0;
+  for (size_t f = 0, currentFunction = 0; f < innerIterations; ++numSteps)
+  {
+    if ((currentFunction % numFunctions) == 0)
+      currentFunction = 0;
+    const size_t effectiveBatchSize = std::min(batchSize,
+        numFunctions - currentFunction);
+    currentFunction += effectiveBatchSize;
+    f += effectiveBatchSize;
+  }
+
+  // With the full gradient g as the gradient, a coordinate of s = (y, z)
+  // evolves as s' = A s + b, with A = [a tau1; 0 1], a = 1 - tau1 - tau2, and
+  // b = (tau2 x0 - tau1 alpha g, -alpha g); the x of a step is c' s + tau2 x0
+  // with c = (a, tau1), and it is added to w with weight r^k.  For m = 0, ...,
+  // numSteps, the columns of the tables hold A^m, S_m = sum_{t < m} A^t (both
+  // in column-major order), P_m = sum_{t < m} r^t c' A^t,
+  // Q_m = sum_{t < m} r^t c' S_t, R_m = sum_{t < m} r^t, and r^m.
+  const double a = 1.0 - tau1 - tau2;
+  arma::mat& powers = ws.Get<arma::mat>(8);
+  arma::mat& sums = ws.Get<arma::mat>(9);
+  arma::mat& weightedPowers = ws.Get<arma::mat>(10);
+  arma::mat& weightedSums = ws.Get<arma::mat>(11);
+  arma::mat& weights = ws.Get<arma::mat>(12);
+  powers.set_size(4, numSteps + 1);
+  sums.set_size(4, numSteps + 1);
+  weightedPowers.set_size(2, numSteps + 1);
+  weightedSums.set_size(2, numSteps + 1);
+  weights.set_size(2, numSteps + 1);
+  powers.col(0) = arma::vec("1 0 0 1");
+  sums.col(0).zeros();
+  weightedPowers.col(0).zeros();
+  weightedSums.col(0).zeros();
+  weights(0, 0) = 0.0;
+  weights(1, 0) = 1.0;
+  for (size_t m = 0; m < numSteps; ++m)
+  {
+    const double* p = powers.colptr(m);
+    const double* s = sums.colptr(m);
+    const double rt = weights(1, m);
+
+    // c' A^t and c' S_t.
+    weightedPowers(0, m + 1) = weightedPowers(0, m) + rt * (a * p[0]);
+    weightedPowers(1, m + 1) = weightedPowers(1, m) + rt * (a * p[2] +
+        tau1 * p[3]);
+    weightedSums(0, m + 1) = weightedSums(0, m) + rt * (a * s[0]);
+    weightedSums(1, m + 1) = weightedSums(1, m) + rt * (a * s[2] +
+        tau1 * s[3]);
+    weights(0, m + 1) = weights(0, m) + rt;
+    weights(1, m + 1) = rt * r;
+
+    // A^{m + 1} = A A^m; the lower row of A^m stays (0, 1).
+    double* next = powers.colptr(m + 1);
+    next[0] = a * p[0];
+    next[1] = 0.0;
+    next[2] = a * p[2] + tau1 * p[3];
+    next[3] = 1.0;
+    for (size_t e = 0; e < 4; ++e)
+      sums(e, m + 1) = s[e] + p[e];
+  }
+
+  // Bring coordinate j up to date with the first `target` steps; afterwards
+  // the iterate holds the x of the last of them.
+  std::vector<size_t>& lastStep = ws.Get<std::vector<size_t>>(13);
+  lastStep.assign(iterate.n_elem, 0);
+  auto catchUp = [&](const size_t j, const size_t target)
+  {
+    const size_t last = lastStep[j];
+    if (last >= target)
+      return;
+
+    const double anchor = tau2 * iterate0[j];
+    const double b0 = anchor - tau1 * alpha * fullGradient[j];
+    const double b1 = -alpha * fullGradient[j];
+    double sy = y[j];
+    double sz = z[j];
+
+    // Jump over all but the last missed step.
+    const size_t m = target - 1 - last;
+    if (m > 0)
+    {
+      const double* p = powers.colptr(m);
+      const double* s = sums.colptr(m);
+      w[j] += weights(1, last) * (weightedPowers(0, m) * sy +
+          weightedPowers(1, m) * sz + weightedSums(0, m) * b0 +
+          weightedSums(1, m) * b1 + weights(0, m) * anchor);
+      const double newY = p[0] * sy + p[2] * sz + s[0] * b0 + s[2] * b1;
+      sz = p[1] * sy + p[3] * sz + s[1] * b0 + s[3] * b1;
+      sy = newY;
+    }
+
+    // The last step, explicitly.
+    const double x = a * sy + tau1 * sz + anchor;
+    w[j] += weights(1, target - 1) * x;
+    iterate[j] = x;
+    y[j] = x - tau1 * alpha * fullGradient[j];
+    z[j] = sz - alpha * fullGradient[j];
+    lastStep[j] = target;
+  };
+
+  arma::sp_mat& gradient = ws.Get<arma::sp_mat>(14);
+  arma::sp_mat& gradient0 = ws.Get<arma::sp_mat>(15);
+  size_t step = 0;
+  for (size_t f = 0, currentFunction = 0; f < innerIterations; ++step)
+  {
+    if ((currentFunction % numFunctions) == 0)
+    {
+      currentFunction = 0;
+      if (shuffle)
+        function.Shuffle();
+    }
+
+    const size_t effectiveBatchSize = std::min(batchSize,
+        numFunctions - currentFunction);
+
+    // The gradient at the snapshot gives the coordinates the batch depends
+    // on; bring their x up to date (before this step).
+    function.Gradient(iterate0, currentFunction, gradient0,
+        effectiveBatchSize);
+    for (arma::sp_mat::const_iterator it = gradient0.begin();
+        it != gradient0.end(); ++it)
+    {
+      const size_t j = it.row() + it.col() * iterate.n_rows;
+      catchUp(j, step);
+      iterate[j] = a * y[j] + tau1 * z[j] + tau2 * iterate0[j];
+    }
+
+    function.Gradient(iterate, currentFunction, gradient,
+        effectiveBatchSize);
+
+    // Take this step on the touched coordinates with the full gradient, and
+    // correct y and z for the difference of the two gradients (which does not
+    // change the x of this step).
+    for (arma::sp_mat::const_iterator it = gradient.begin();
+        it != gradient.end(); ++it)
+    {
+      const size_t j = it.row() + it.col() * iterate.n_rows;
+      catchUp(j, step + 1);
+      const double delta = alpha * (*it) / (double) batchSize;
+      z[j] -= delta;
+      y[j] -= tau1 * delta;
+    }
+
+    for (arma::sp_mat::const_iterator it = gradient0.begin();
+        it != gradient0.end(); ++it)
+    {
+      const size_t j = it.row() + it.col() * iterate.n_rows;
+      catchUp(j, step + 1);
+      const double delta = alpha * (*it) / (double) batchSize;
+      z[j] += delta;
+      y[j] += tau1 * delta;
+    }
+
+    currentFunction += effectiveBatchSize;
+    f += effectiveBatchSize;
+  }
+
+  // Apply the steps that the coordinates missed.
+  for (size_t j = 0; j < iterate.n_elem; ++j)
+    catchUp(j, numSteps);
+}
+
 } // namespace ens
 
 #endif
@@ -13,7 +13,10 @@
 #ifndef ENSMALLEN_LBFGS_LBFGS_HPP
 #define ENSMALLEN_LBFGS_LBFGS_HPP
 
+#include <vector>
+
 #include <ensmallen_bits/function.hpp>
+#include "reduced_precision_pairs.hpp"
 
 namespace ens {
 
@@ -26,10 +29,77 @@ namespace ens {
  * L_BFGS can optimize differentiable functions.  For more details, see the
  * documentation on function types included with this distribution or on the
  * ensmallen website.
+ *
+ * By default the search direction is computed with the two-loop recursion of
+ * Nocedal (1980).  Alternately, the compact representation of Byrd, Nocedal
+ * and Schnabel (1994) can be used: the stored pairs are kept as the columns of
+ * one matrix, so the search direction takes two matrix-vector products with
+ * the whole history (plus some small dense algebra) and each new pair takes one
+ * matrix-matrix product, instead of many vector operations.  This is
+ * preferable when the number of parameters is large, since BLAS can then use
+ * multiple threads and the history is streamed through memory fewer times.
+ *
+ * The line search normally tries one step size at a time.  If
+ * numLineSearchCandidates is greater than one, each round of the line search
+ * instead evaluates that many step sizes concurrently with OpenMP, and the
+ * interval known to contain a step satisfying the Wolfe conditions is narrowed
+ * from all of them at once.  In that case the function's EvaluateWithGradient()
+ * will be called from multiple threads at the same time, so it must be safe to
+ * do so.
+ *
+ * The stored pairs are kept after Optimize() returns.  Normally every call to
+ * Optimize() still starts with an empty history, but if resetHistory is false,
+ * it continues from the pairs of the last call (as long as the shape of the
+ * iterate and the memory size did not change), so that a sequence of closely
+ * related problems, such as the subproblems of AugLagrangian, is warm-started
+ * with the curvature information of the last solve.
+ *
+ * If a Workspace is given with Workspace(), the temporaries of Optimize()
+ * (iterates, gradients, search direction and the pairs) are taken from it, so
+ * that repeated calls with iterates of the same size do not allocate them.
+ *
+ * The initial inverse Hessian approximation of the two-loop recursion is
+ * normally gamma I, with gamma = s^T y / y^T y for the latest pair.  When the
+ * parameters have very different scales, a diagonal initial approximation
+ * works much better.  If DiagonalScaling() is true, element i of the diagonal
+ * is sum_j s_ij y_ij / sum_j y_ij^2 over the stored pairs (an estimate of the
+ * inverse curvature along parameter i), and the diagonal is then rescaled so
+ * that it satisfies the secant equation of the latest pair along y.  The sums
+ * are updated in one pass as each pair is stored.  A fixed diagonal
+ * preconditioner, with the shape of the iterate, may also be given with
+ * Preconditioner(); it is then scaled by s^T y / y^T P y, and with
+ * DiagonalScaling() it is used for the elements whose sums give no positive
+ * estimate.  Neither is available with the compact representation.
+ *
+ * The pairs of the two-loop recursion are normally stored with the element
+ * type of the iterate.  If HistoryPrecision() is Float32Precision or
+ * BFloat16Precision, they are stored as floats or as bfloat16s instead (see
+ * ReducedPrecisionPairs), which halves or quarters the memory of the history
+ * of double-precision iterates, while the dot products and updates of the
+ * recursion are still computed in double precision.  The reduced precision
+ * history is not available with the compact representation or with the
+ * diagonal initial approximation, and it is not saved by Serialize().
+ *
+ * When ensmallen is compiled with OpenMP, the dot products and vector updates
+ * of the two-loop recursion, the basis update and the line search are split
+ * over the threads for dense iterates with at least MinChunkSize() elements
+ * per thread, since for very large iterates these passes over memory dominate
+ * the cost of an iteration.
  */
 class L_BFGS
 {
  public:
+  //! The precisions that the pairs of the two-loop recursion can be stored in.
+  enum HistoryPrecisionType
+  {
+    //! The element type of the iterate.
+    FullPrecision,
+    //! 32-bit floats.
+    Float32Precision,
+    //! bfloat16s (the upper 16 bits of a float).
+    BFloat16Precision
+  };
+
   /**
    * Initialize the L-BFGS object.  There are many parameters that can be set
    * for the optimization, but default values are given for each of them.
@@ -48,6 +118,13 @@ class L_BFGS
    *     (before giving up).
    * @param minStep The minimum step of the line search.
    * @param maxStep The maximum step of the line search.
+   * @param compactRepresentation If true, compute the search direction with
+   *     the compact representation instead of the two-loop recursion.
+   * @param numLineSearchCandidates Number of step sizes to evaluate
+   *     concurrently in each round of the line search (1 means the serial
+   *     line search).
+   * @param resetHistory If true, the stored pairs are discarded at the start
+   *     of every call to Optimize().
    */
   L_BFGS(const size_t numBasis = 10, /* same default as scipy */
          const size_t maxIterations = 10000, /* many but not infinite */
@@ -57,7 +134,10 @@ class L_BFGS
          const double factr = 1e-15,
          const size_t maxLineSearchTrials = 50,
          const double minStep = 1e-20,
-         const double maxStep = 1e20);
+         const double maxStep = 1e20,
+         const bool compactRepresentation = false,
+         const size_t numLineSearchCandidates = 1,
+         const bool resetHistory = true);
 
   /**
    * Return the point where the lowest function value has been found.
@@ -76,12 +156,37 @@ class L_BFGS
    * algorithm, and the final objective value is returned.
    *
    * @tparam FunctionType Type of the function to be optimized.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to optimize; must have Evaluate() and Gradient().
    * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
    * @return Objective value of the final point.
    */
-  template<typename FunctionType>
-  double Optimize(FunctionType& function, arma::mat& iterate);
+  template<typename FunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(FunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks);
+
+  /**
+   * Estimate the number of bytes Optimize() allocates for an iterate of the
+   * given size: the iterates and gradients of a step, the numBasis pairs of
+   * the history (s and y, or their compact form and products), the candidates
+   * of the parallel line search, and, when the history is not reset, the
+   * double-precision copy of the pairs kept after Optimize().  The memory of
+   * the iterate and of the function is not included.
+   *
+   * @param rows Number of rows of the iterate.
+   * @param cols Number of columns of the iterate.
+   * @param elemSize Size of an element of the iterate.
+   */
+  size_t EstimateMemory(const size_t rows,
+                        const size_t cols = 1,
+                        const size_t elemSize = sizeof(double)) const;
 
   //! Get the memory size.
   size_t NumBasis() const { return numBasis; }
@@ -128,6 +233,65 @@ class L_BFGS
   //! Modify the maximum line search step size.
   double& MaxStep() { return maxStep; }
 
+  //! Get whether the compact representation is used.
+  bool CompactRepresentation() const { return compactRepresentation; }
+  //! Modify whether the compact representation is used.
+  bool& CompactRepresentation() { return compactRepresentation; }
+
+  //! Get the number of step sizes evaluated concurrently by the line search.
+  size_t NumLineSearchCandidates() const { return numLineSearchCandidates; }
+  //! Modify the number of step sizes evaluated concurrently by the line
+  //! search.
+  size_t& NumLineSearchCandidates() { return numLineSearchCandidates; }
+
+  //! Get whether the stored pairs are discarded at the start of Optimize().
+  bool ResetHistory() const { return resetHistory; }
+  //! Modify whether the stored pairs are discarded at the start of Optimize().
+  bool& ResetHistory() { return resetHistory; }
+
+  //! Get whether the initial inverse Hessian approximation is diagonal.
+  bool DiagonalScaling() const { return diagonalScaling; }
+  //! Modify whether the initial inverse Hessian approximation is diagonal.
+  bool& DiagonalScaling() { return diagonalScaling; }
+
+  //! Get the diagonal preconditioner of the initial inverse Hessian
+  //! approximation (empty if none).
+  const arma::mat& Preconditioner() const { return preconditioner; }
+  //! Modify the diagonal preconditioner of the initial inverse Hessian
+  //! approximation (empty if none).
+  arma::mat& Preconditioner() { return preconditioner; }
+
+  //! Get the precision the pairs of the two-loop recursion are stored in.
+  HistoryPrecisionType HistoryPrecision() const { return historyPrecision; }
+  //! Modify the precision the pairs of the two-loop recursion are stored in.
+  HistoryPrecisionType& HistoryPrecision() { return historyPrecision; }
+
+  //! Discard the pairs kept from the last call to Optimize().
+  void ClearHistory();
+
+  /**
+   * Save or load the pairs kept from the last call to Optimize(), so that an
+   * optimization can be resumed later (with ResetHistory() set to false).
+   *
+   * @param ar Archive to save into or load from.
+   */
+  void Serialize(BinaryArchive& ar);
+
+  //! Get the number of pairs kept from the last call to Optimize().
+  size_t HistorySize() const { return historySize; }
+
+  //! Get the minimum number of elements per thread of the parallel dot
+  //! products and vector updates (0 means always serial).
+  size_t MinChunkSize() const { return minChunkSize; }
+  //! Modify the minimum number of elements per thread of the parallel dot
+  //! products and vector updates (0 means always serial).
+  size_t& MinChunkSize() { return minChunkSize; }
+
+  //! Get the workspace the temporaries are taken from (NULL if none).
+  ens::Workspace* Workspace() const { return workspace; }
+  //! Modify the workspace the temporaries are taken from (NULL if none).
+  ens::Workspace*& Workspace() { return workspace; }
+
  private:
   //! Size of memory for this L-BFGS optimizer.
   size_t numBasis;
@@ -147,6 +311,39 @@ class L_BFGS
   double minStep;
   //! Maximum step of the line search.
   double maxStep;
+  //! Whether to use the compact representation for the search direction.
+  bool compactRepresentation;
+  //! Number of step sizes evaluated concurrently by the line search.
+  size_t numLineSearchCandidates;
+  //! Whether the stored pairs are discarded at the start of Optimize().
+  bool resetHistory;
+  //! Minimum number of elements per thread of the parallel kernels.
+  size_t minChunkSize;
+  //! Whether the initial inverse Hessian approximation is diagonal.
+  bool diagonalScaling;
+  //! The diagonal preconditioner of the initial inverse Hessian approximation
+  //! (empty if none).
+  arma::mat preconditioner;
+  //! The precision the pairs of the two-loop recursion are stored in.
+  HistoryPrecisionType historyPrecision;
+
+  //! The pairs of the two-loop recursion kept from the last call to
+  //! Optimize().
+  arma::cube historyS, historyY;
+  //! The inverse curvature of each kept pair.
+  arma::vec historyRho;
+  //! The pairs of the compact representation kept from the last call.
+  arma::cube historyPairs;
+  //! The inner products of the kept compact pairs.
+  arma::mat historyProducts;
+  //! The pairs of the two-loop recursion in reduced precision, which are
+  //! kept in place after Optimize().
+  ReducedPrecisionPairs reducedPairs;
+  //! The number of pairs stored by the last call (counting overwritten ones).
+  size_t historySize;
+
+  //! The workspace the temporaries are taken from (NULL if none).
+  ens::Workspace* workspace;
 
   /**
    * Calculate the scaling factor, gamma, which is used to scale the Hessian
@@ -155,13 +352,81 @@ class L_BFGS
    *
    * @return The calculated scaling factor.
    * @param gradient The gradient at the initial point.
-   * @param s Differences between the iterate and old iterate matrix.
    * @param y Differences between the gradient and the old gradient matrix.
+   * @param rho Inverse curvature 1 / (y_i^T s_i) of each stored pair.
    */
+  template<typename GradType, typename CubeType, typename VecType>
   double ChooseScalingFactor(const size_t iterationNum,
-                             const arma::mat& gradient,
-                             const arma::cube& s,
-                             const arma::cube& y);
+                             const GradType& gradient,
+                             const CubeType& y,
+                             const VecType& rho);
+
+  /**
+   * Calculate the diagonal initial inverse Hessian approximation used instead
+   * of the scaling factor when DiagonalScaling() is true or a preconditioner
+   * is given (see the documentation of the class).
+   *
+   * @param iterationNum The iteration number.
+   * @param gradient The gradient at the initial point.
+   * @param y Differences between the gradient and the old gradient matrix.
+   * @param rho Inverse curvature 1 / (y_i^T s_i) of each stored pair.
+   * @param base The preconditioner, or ones if none was given.
+   * @param sy Sum of s_i % y_i over the stored pairs.
+   * @param yy Sum of y_i % y_i over the stored pairs.
+   * @param diagonal Matrix to store the diagonal in.
+   */
+  template<typename MatType, typename GradType, typename CubeType,
+           typename VecType>
+  typename std::enable_if<!IsCootType<MatType>::value>::type
+  ChooseDiagonalScaling(const size_t iterationNum,
+                        const GradType& gradient,
+                        const CubeType& y,
+                        const VecType& rho,
+                        const MatType& base,
+                        const MatType& sy,
+                        const MatType& yy,
+                        MatType& diagonal);
+
+  //! The diagonal scaling is not available for Bandicoot matrices
+  //! (Optimize() checks this before the optimization).
+  template<typename MatType, typename GradType, typename CubeType,
+           typename VecType>
+  typename std::enable_if<IsCootType<MatType>::value>::type
+  ChooseDiagonalScaling(const size_t /* iterationNum */,
+                        const GradType& /* gradient */,
+                        const CubeType& /* y */,
+                        const VecType& /* rho */,
+                        const MatType& /* base */,
+                        const MatType& /* sy */,
+                        const MatType& /* yy */,
+                        MatType& /* diagonal */)
+  {
+    throw std::logic_error("L_BFGS::ChooseDiagonalScaling(): not available "
+        "for Bandicoot matrices!");
+  }
+
+  /**
+   * Update the sums of s_i % y_i and y_i % y_i over the stored pairs for the
+   * pair that UpdateBasisSet() stores next (before it is stored, so that the
+   * pair it replaces is subtracted) or has just stored (after, so that it is
+   * added).  Once per numBasis pairs, the sums are recomputed from the stored
+   * pairs instead, so that the round-off of the subtractions does not
+   * accumulate.
+   *
+   * @param iterationNum Iteration number of the pair.
+   * @param stored Whether the pair has been stored already.
+   * @param s Differences between the iterate and old iterate matrix.
+   * @param y Differences between the gradient and the old gradient matrix.
+   * @param sy Sum of s_i % y_i over the stored pairs.
+   * @param yy Sum of y_i % y_i over the stored pairs.
+   */
+  template<typename MatType, typename CubeType>
+  void UpdateCurvatureSums(const size_t iterationNum,
+                           const bool stored,
+                           const CubeType& s,
+                           const CubeType& y,
+                           MatType& sy,
+                           MatType& yy);
 
   /**
    * Perform a back-tracking line search along the search direction to
@@ -177,13 +442,50 @@ class L_BFGS
    *
    * @return false if no step size is suitable, true otherwise.
    */
-  template<typename FunctionType>
+  template<typename FunctionType,
+           typename ElemType,
+           typename MatType,
+           typename GradType>
   bool LineSearch(FunctionType& function,
-                  double& functionValue,
-                  arma::mat& iterate,
-                  arma::mat& gradient,
-                  arma::mat& newIterateTmp,
-                  const arma::mat& searchDirection);
+                  ElemType& functionValue,
+                  MatType& iterate,
+                  GradType& gradient,
+                  MatType& newIterateTmp,
+                  const MatType& searchDirection);
+
+  /**
+   * Perform a line search that evaluates several step sizes concurrently in
+   * each round, narrowing the interval known to contain a step satisfying the
+   * Wolfe conditions.  The parameter iterate will be modified if the method is
+   * successful, and functionValue and gradient will hold the objective and
+   * gradient at the new iterate.
+   *
+   * @param function Function to optimize.
+   * @param functionValue Value of the function at the initial point.
+   * @param iterate The initial point to begin the line search from.
+   * @param gradient The gradient at the initial point.
+   * @param trialIterates One point to evaluate per candidate step size.
+   * @param trialGradients One gradient per candidate step size.
+   * @param trialSteps Candidate step sizes (one per trial point).
+   * @param trialObjectives Objective of each trial point.
+   * @param searchDirection A vector specifying the search direction.
+   *
+   * @return false if the search direction is not a descent direction, true
+   *     otherwise.
+   */
+  template<typename FunctionType,
+           typename ElemType,
+           typename MatType,
+           typename GradType>
+  bool ParallelLineSearch(FunctionType& function,
+                          ElemType& functionValue,
+                          MatType& iterate,
+                          GradType& gradient,
+                          std::vector<MatType>& trialIterates,
+                          std::vector<GradType>& trialGradients,
+                          arma::vec& trialSteps,
+                          arma::Col<ElemType>& trialObjectives,
+                          const MatType& searchDirection);
 
   /**
    * Find the L-BFGS search direction.
@@ -191,16 +493,26 @@ class L_BFGS
    * @param gradient The gradient at the current point.
    * @param iterationNum The iteration number.
    * @param scalingFactor Scaling factor to use (see ChooseScalingFactor_()).
+   * @param diagonal Diagonal initial inverse Hessian approximation to use
+   *     instead of the scaling factor (see ChooseDiagonalScaling()), or an
+   *     empty matrix.
    * @param s Differences between the iterate and old iterate matrix.
    * @param y Differences between the gradient and the old gradient matrix.
+   * @param rho Inverse curvature 1 / (y_i^T s_i) of each stored pair.
+   * @param alpha Workspace of numBasis elements for the first recursion.
    * @param searchDirection Vector to store search direction in.
    */
-  void SearchDirection(const arma::mat& gradient,
+  template<typename MatType, typename GradType, typename CubeType,
+           typename VecType>
+  void SearchDirection(const GradType& gradient,
                        const size_t iterationNum,
                        const double scalingFactor,
-                       const arma::cube& s,
-                       const arma::cube& y,
-                       arma::mat& searchDirection);
+                       const MatType& diagonal,
+                       const CubeType& s,
+                       const CubeType& y,
+                       const VecType& rho,
+                       VecType& alpha,
+                       MatType& searchDirection);
 
   /**
    * Update the y and s matrices, which store the differences
@@ -214,14 +526,185 @@ class L_BFGS
    * @param oldGradient Gradient at last iteration point (oldIterate).
    * @param s Differences between the iterate and old iterate matrix.
    * @param y Differences between the gradient and the old gradient matrix.
+   * @param rho Inverse curvature 1 / (y_i^T s_i) of each stored pair.
    */
+  template<typename MatType, typename GradType, typename CubeType,
+           typename VecType>
   void UpdateBasisSet(const size_t iterationNum,
-                      const arma::mat& iterate,
-                      const arma::mat& oldIterate,
-                      const arma::mat& gradient,
-                      const arma::mat& oldGradient,
-                      arma::cube& s,
-                      arma::cube& y);
+                      const MatType& iterate,
+                      const MatType& oldIterate,
+                      const GradType& gradient,
+                      const GradType& oldGradient,
+                      CubeType& s,
+                      CubeType& y,
+                      VecType& rho);
+
+  /**
+   * Find the L-BFGS search direction with the pairs stored in reduced
+   * precision, choosing the scaling factor as in ChooseScalingFactor().
+   *
+   * @param gradient The gradient at the current point.
+   * @param iterationNum The iteration number.
+   * @param rho Inverse curvature 1 / (y_i^T s_i) of each stored pair.
+   * @param alpha Workspace of numBasis elements for the first recursion.
+   * @param searchDirection Vector to store search direction in.
+   */
+  template<typename MatType, typename GradType, typename VecType>
+  void ReducedSearchDirection(const GradType& gradient,
+                              const size_t iterationNum,
+                              const VecType& rho,
+                              VecType& alpha,
+                              MatType& searchDirection);
+
+  /**
+   * Store a new pair in reduced precision.  The inverse curvature is computed
+   * from the stored (rounded) vectors, so that it matches the pair used by the
+   * recursion.
+   *
+   * @param iterationNum Iteration number.
+   * @param iterate Current point.
+   * @param oldIterate Point at last iteration.
+   * @param gradient Gradient at current point (iterate).
+   * @param oldGradient Gradient at last iteration point (oldIterate).
+   * @param rho Inverse curvature 1 / (y_i^T s_i) of each stored pair.
+   */
+  template<typename MatType, typename GradType, typename VecType>
+  void UpdateReducedBasisSet(const size_t iterationNum,
+                             const MatType& iterate,
+                             const MatType& oldIterate,
+                             const GradType& gradient,
+                             const GradType& oldGradient,
+                             VecType& rho);
+
+  /**
+   * Keep a part of the history after Optimize(), converting it to double.
+   *
+   * @param kept Where the history is kept.
+   * @param history The part of the history (not used afterwards).
+   */
+  template<typename KeptType, typename HistoryType>
+  static typename std::enable_if<!IsCootType<HistoryType>::value>::type
+  KeepHistory(KeptType& kept, HistoryType& history)
+  {
+    kept = arma::conv_to<KeptType>::from(history);
+  }
+
+  //! The history of Bandicoot matrices stays on the device, so it is not
+  //! kept for the next call.
+  template<typename KeptType, typename HistoryType>
+  static typename std::enable_if<IsCootType<HistoryType>::value>::type
+  KeepHistory(KeptType& kept, HistoryType& /* history */)
+  {
+    kept.reset();
+  }
+
+  /**
+   * Restore a part of the history kept by the last call to Optimize(),
+   * converting it to the element type of the optimization.
+   *
+   * @param history The part of the history to restore.
+   * @param kept Where the history is kept.
+   */
+  template<typename HistoryType, typename KeptType>
+  static typename std::enable_if<!IsCootType<HistoryType>::value>::type
+  RestoreHistory(HistoryType& history, const KeptType& kept)
+  {
+    history = arma::conv_to<HistoryType>::from(kept);
+  }
+
+  //! No history of Bandicoot matrices is kept (see KeepHistory()).
+  template<typename HistoryType, typename KeptType>
+  static typename std::enable_if<IsCootType<HistoryType>::value>::type
+  RestoreHistory(HistoryType& /* history */, const KeptType& /* kept */) { }
+
+  //! Keep a part of the history that is already double, without a copy.
+  //! (The old kept history is given back, so that a workspace holding the
+  //! history can reuse its memory.)
+  template<typename KeptType>
+  static void KeepHistory(KeptType& kept, KeptType& history)
+  {
+    kept.swap(history);
+  }
+
+  /**
+   * Find the L-BFGS search direction with the compact representation of the
+   * inverse Hessian approximation (Byrd, Nocedal and Schnabel, 1994):
+   *
+   *   H = gamma I + [S  gamma Y] M [S  gamma Y]^T,
+   *
+   *   M = [ R^-T (D + gamma Y^T Y) R^-1   -R^-T ]
+   *       [ -R^-1                           0   ]
+   *
+   * where R is the upper triangle of S^T Y and D is its diagonal.  The scaling
+   * factor gamma is chosen as in ChooseScalingFactor().
+   *
+   * @param gradient The gradient at the current point.
+   * @param iterationNum The iteration number.
+   * @param pairs Stored pairs: s_i in slice 2i and y_i in slice 2i + 1.
+   * @param products Inner products of all the slices of pairs.
+   * @param searchDirection Vector to store search direction in.
+   */
+  template<typename MatType, typename GradType, typename CubeType>
+  typename std::enable_if<!IsCootType<MatType>::value>::type
+  CompactSearchDirection(const GradType& gradient,
+                         const size_t iterationNum,
+                         CubeType& pairs,
+                         const arma::Mat<typename CubeType::elem_type>&
+                             products,
+                         MatType& searchDirection);
+
+  //! The compact representation is not available for Bandicoot matrices
+  //! (Optimize() checks this before the optimization).
+  template<typename MatType, typename GradType, typename CubeType>
+  typename std::enable_if<IsCootType<MatType>::value>::type
+  CompactSearchDirection(const GradType& /* gradient */,
+                         const size_t /* iterationNum */,
+                         CubeType& /* pairs */,
+                         const arma::Mat<typename CubeType::elem_type>&
+                             /* products */,
+                         MatType& /* searchDirection */)
+  {
+    throw std::logic_error("L_BFGS::CompactSearchDirection(): not available "
+        "for Bandicoot matrices!");
+  }
+
+  /**
+   * Store a new pair for the compact representation, and update the inner
+   * products of the stored pairs with one matrix-matrix product.
+   *
+   * @param iterationNum Iteration number.
+   * @param iterate Current point.
+   * @param oldIterate Point at last iteration.
+   * @param gradient Gradient at current point (iterate).
+   * @param oldGradient Gradient at last iteration point (oldIterate).
+   * @param pairs Stored pairs: s_i in slice 2i and y_i in slice 2i + 1.
+   * @param products Inner products of all the slices of pairs.
+   */
+  template<typename MatType, typename GradType, typename CubeType>
+  typename std::enable_if<!IsCootType<MatType>::value>::type
+  UpdateCompactBasisSet(const size_t iterationNum,
+                        const MatType& iterate,
+                        const MatType& oldIterate,
+                        const GradType& gradient,
+                        const GradType& oldGradient,
+                        CubeType& pairs,
+                        arma::Mat<typename CubeType::elem_type>& products);
+
+  //! The compact representation is not available for Bandicoot matrices
+  //! (Optimize() checks this before the optimization).
+  template<typename MatType, typename GradType, typename CubeType>
+  typename std::enable_if<IsCootType<MatType>::value>::type
+  UpdateCompactBasisSet(const size_t /* iterationNum */,
+                        const MatType& /* iterate */,
+                        const MatType& /* oldIterate */,
+                        const GradType& /* gradient */,
+                        const GradType& /* oldGradient */,
+                        CubeType& /* pairs */,
+                        arma::Mat<typename CubeType::elem_type>& /* products */)
+  {
+    throw std::logic_error("L_BFGS::UpdateCompactBasisSet(): not available "
+        "for Bandicoot matrices!");
+  }
 };
 
 } // namespace ens
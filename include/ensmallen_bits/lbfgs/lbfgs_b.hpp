@@ -0,0 +1,310 @@
+/**
+ * @file lbfgs_b.hpp
+ *
+ * Definition of L-BFGS-B, the limited-memory quasi-Newton method for
+ * bound-constrained problems.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LBFGS_LBFGS_B_HPP
+#define ENSMALLEN_LBFGS_LBFGS_B_HPP
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+/**
+ * L-BFGS-B minimizes a differentiable function subject to bounds on each of
+ * the coordinates,
+ *
+ * \f[
+ * \min_x f(x) \quad \textrm{subject to} \quad l \le x \le u.
+ * \f]
+ *
+ * Each iteration finds the generalized Cauchy point, the first local minimizer
+ * of the quadratic model along the projected steepest descent path, which
+ * fixes the coordinates that hit their bounds; the model is then minimized
+ * over the remaining free coordinates (subspace minimization), and a
+ * backtracking line search is done from the current point towards the result,
+ * which never leaves the box.  The quadratic model uses the compact
+ * representation of the limited-memory BFGS matrix
+ *
+ * \f[
+ * B = \theta I - W M W^T, \quad W = [Y \;\; \theta S],
+ * \f]
+ *
+ * built from the same stored pairs and inner products as the compact
+ * representation of L_BFGS (s_i in slice 2i and y_i in slice 2i + 1 of a
+ * cube, with a matrix of all their inner products updated with one
+ * matrix-matrix product per iteration).  Pairs whose curvature
+ * \f$ s^T y \f$ is not sufficiently positive are skipped.
+ *
+ * The bounds may be given as matrices of the same size as the iterate, or as
+ * 1x1 matrices (or numbers) that apply to all the coordinates; infinite
+ * bounds are allowed.  The starting point is projected onto the box.  The
+ * optimization stops once the infinity norm of the projected gradient is
+ * below minGradientNorm, or the relative decrease of the objective is below
+ * factr.
+ *
+ * For more information, see the following:
+ *
+ * @code
+ * @article{byrd1995limited,
+ *   title   = {A Limited Memory Algorithm for Bound Constrained
+ *              Optimization},
+ *   author  = {Byrd, Richard H. and Lu, Peihuang and Nocedal, Jorge and
+ *              Zhu, Ciyou},
+ *   journal = {SIAM Journal on Scientific Computing},
+ *   volume  = {16},
+ *   number  = {5},
+ *   pages   = {1190--1208},
+ *   year    = {1995}
+ * }
+ * @endcode
+ *
+ * L_BFGS_B can optimize differentiable functions.  For more details, see the
+ * documentation on function types included with this distribution or on the
+ * ensmallen website.
+ */
+class L_BFGS_B
+{
+ public:
+  /**
+   * Initialize the L-BFGS-B optimizer with the same bounds for all the
+   * coordinates.
+   *
+   * @param lowerBound Lower bound of all the coordinates.
+   * @param upperBound Upper bound of all the coordinates.
+   * @param numBasis Number of memory points to be stored.
+   * @param maxIterations Maximum number of iterations for the optimization
+   *     (0 means no limit and may run indefinitely).
+   * @param armijoConstant Controls the accuracy of the line search routine for
+   *     determining the Armijo condition.
+   * @param minGradientNorm Minimum infinity norm of the projected gradient
+   *     required to continue the optimization.
+   * @param factr Minimum relative function value decrease to continue the
+   *     optimization.
+   * @param maxLineSearchTrials The maximum number of trials for the line
+   *     search (before giving up).
+   */
+  L_BFGS_B(const double lowerBound = -std::numeric_limits<double>::infinity(),
+           const double upperBound = std::numeric_limits<double>::infinity(),
+           const size_t numBasis = 10,
+           const size_t maxIterations = 10000,
+           const double armijoConstant = 1e-4,
+           const double minGradientNorm = 1e-6,
+           const double factr = 1e-15,
+           const size_t maxLineSearchTrials = 50);
+
+  /**
+   * Initialize the L-BFGS-B optimizer with the given bounds for each
+   * coordinate.
+   *
+   * @param lowerBound Lower bounds of the coordinates (same size as the
+   *     iterate, or 1x1 for all the coordinates).
+   * @param upperBound Upper bounds of the coordinates (same size as the
+   *     iterate, or 1x1 for all the coordinates).
+   * @param numBasis Number of memory points to be stored.
+   * @param maxIterations Maximum number of iterations for the optimization
+   *     (0 means no limit and may run indefinitely).
+   * @param armijoConstant Controls the accuracy of the line search routine for
+   *     determining the Armijo condition.
+   * @param minGradientNorm Minimum infinity norm of the projected gradient
+   *     required to continue the optimization.
+   * @param factr Minimum relative function value decrease to continue the
+   *     optimization.
+   * @param maxLineSearchTrials The maximum number of trials for the line
+   *     search (before giving up).
+   */
+  L_BFGS_B(const arma::mat& lowerBound,
+           const arma::mat& upperBound,
+           const size_t numBasis = 10,
+           const size_t maxIterations = 10000,
+           const double armijoConstant = 1e-4,
+           const double minGradientNorm = 1e-6,
+           const double factr = 1e-15,
+           const size_t maxLineSearchTrials = 50);
+
+  /**
+   * Use L-BFGS-B to optimize the given function within the bounds, starting
+   * at the given iterate point.  The given starting point will be modified to
+   * store the finishing point of the algorithm, and the final objective value
+   * is returned.
+   *
+   * @tparam FunctionType Type of the function to be optimized.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize; must have Evaluate() and Gradient().
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename FunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(FunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks);
+
+  //! Get the lower bounds.
+  const arma::mat& LowerBound() const { return lowerBound; }
+  //! Modify the lower bounds.
+  arma::mat& LowerBound() { return lowerBound; }
+
+  //! Get the upper bounds.
+  const arma::mat& UpperBound() const { return upperBound; }
+  //! Modify the upper bounds.
+  arma::mat& UpperBound() { return upperBound; }
+
+  //! Get the memory size.
+  size_t NumBasis() const { return numBasis; }
+  //! Modify the memory size.
+  size_t& NumBasis() { return numBasis; }
+
+  //! Get the maximum number of iterations.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the Armijo condition constant.
+  double ArmijoConstant() const { return armijoConstant; }
+  //! Modify the Armijo condition constant.
+  double& ArmijoConstant() { return armijoConstant; }
+
+  //! Get the minimum projected gradient norm.
+  double MinGradientNorm() const { return minGradientNorm; }
+  //! Modify the minimum projected gradient norm.
+  double& MinGradientNorm() { return minGradientNorm; }
+
+  //! Get the factr value.
+  double Factr() const { return factr; }
+  //! Modify the factr value.
+  double& Factr() { return factr; }
+
+  //! Get the maximum number of line search trials.
+  size_t MaxLineSearchTrials() const { return maxLineSearchTrials; }
+  //! Modify the maximum number of line search trials.
+  size_t& MaxLineSearchTrials() { return maxLineSearchTrials; }
+
+  //! Get the workspace the temporaries are taken from (NULL if none).
+  ens::Workspace* Workspace() const { return workspace; }
+  //! Modify the workspace the temporaries are taken from (NULL if none).
+  ens::Workspace*& Workspace() { return workspace; }
+
+ private:
+  /**
+   * Build the matrices W = [Y theta S] and M of the compact representation
+   * of the BFGS matrix from the stored pairs, in chronological order.
+   *
+   * @param numPairs Number of pairs stored so far (counting overwritten ones).
+   * @param pairs Stored pairs: s_i in slice 2i and y_i in slice 2i + 1.
+   * @param products Inner products of all the slices of pairs.
+   * @param theta Scaling of the BFGS matrix (set here).
+   * @param w Matrix to store W in.
+   * @param m Matrix to store M in.
+   * @return false if M is singular.
+   */
+  template<typename CubeType, typename ElemType>
+  bool CompactMatrices(const size_t numPairs,
+                       const CubeType& pairs,
+                       const arma::Mat<ElemType>& products,
+                       ElemType& theta,
+                       arma::Mat<ElemType>& w,
+                       arma::Mat<ElemType>& m) const;
+
+  /**
+   * Find the generalized Cauchy point: the first local minimizer of the
+   * quadratic model along the projected steepest descent path.
+   *
+   * @param x The current point.
+   * @param g The gradient at the current point.
+   * @param lower The lower bounds.
+   * @param upper The upper bounds.
+   * @param theta Scaling of the BFGS matrix.
+   * @param w The matrix W of the compact representation.
+   * @param m The matrix M of the compact representation.
+   * @param cauchy Vector to store the Cauchy point in.
+   * @param c Vector to store W^T (cauchy - x) in.
+   */
+  template<typename ElemType>
+  void CauchyPoint(const arma::Col<ElemType>& x,
+                   const arma::Col<ElemType>& g,
+                   const arma::Col<ElemType>& lower,
+                   const arma::Col<ElemType>& upper,
+                   const ElemType theta,
+                   const arma::Mat<ElemType>& w,
+                   const arma::Mat<ElemType>& m,
+                   arma::Col<ElemType>& cauchy,
+                   arma::Col<ElemType>& c) const;
+
+  /**
+   * Minimize the quadratic model over the coordinates that are not at a bound
+   * at the Cauchy point (with the other coordinates fixed), and truncate the
+   * result to the box.
+   *
+   * @param x The current point.
+   * @param g The gradient at the current point.
+   * @param lower The lower bounds.
+   * @param upper The upper bounds.
+   * @param theta Scaling of the BFGS matrix.
+   * @param w The matrix W of the compact representation.
+   * @param m The matrix M of the compact representation.
+   * @param cauchy The Cauchy point.
+   * @param c W^T (cauchy - x).
+   * @param result Vector to store the minimizer in.
+   */
+  template<typename ElemType>
+  void SubspaceMinimization(const arma::Col<ElemType>& x,
+                            const arma::Col<ElemType>& g,
+                            const arma::Col<ElemType>& lower,
+                            const arma::Col<ElemType>& upper,
+                            const ElemType theta,
+                            const arma::Mat<ElemType>& w,
+                            const arma::Mat<ElemType>& m,
+                            const arma::Col<ElemType>& cauchy,
+                            const arma::Col<ElemType>& c,
+                            arma::Col<ElemType>& result) const;
+
+  /**
+   * Expand the given bounds to one per coordinate.
+   *
+   * @param bound Bounds (one per coordinate, or 1x1).
+   * @param n Number of coordinates.
+   * @param expanded Vector to store the bounds in.
+   */
+  template<typename ElemType>
+  static void ExpandBound(const arma::mat& bound,
+                          const size_t n,
+                          arma::Col<ElemType>& expanded);
+
+  //! Lower bounds of the coordinates.
+  arma::mat lowerBound;
+  //! Upper bounds of the coordinates.
+  arma::mat upperBound;
+  //! Size of memory for this optimizer.
+  size_t numBasis;
+  //! Maximum number of iterations.
+  size_t maxIterations;
+  //! Parameter for determining the Armijo condition.
+  double armijoConstant;
+  //! Minimum projected gradient norm required to continue the optimization.
+  double minGradientNorm;
+  //! Minimum relative function value decrease to continue the optimization.
+  double factr;
+  //! Maximum number of trials for the line search.
+  size_t maxLineSearchTrials;
+
+  //! The workspace the temporaries are taken from (NULL if none).
+  ens::Workspace* workspace;
+};
+
+} // namespace ens
+
+#include "lbfgs_b_impl.hpp"
+
+#endif
@@ -0,0 +1,538 @@
+/**
+ * @file lbfgs_b_impl.hpp
+ *
+ * Implementation of L-BFGS-B.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LBFGS_LBFGS_B_IMPL_HPP
+#define ENSMALLEN_LBFGS_LBFGS_B_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "lbfgs_b.hpp"
+
+namespace ens {
+
+inline L_BFGS_B::L_BFGS_B(const double lowerBound,
+                          const double upperBound,
+                          const size_t numBasis,
+                          const size_t maxIterations,
+                          const double armijoConstant,
+                          const double minGradientNorm,
+                          const double factr,
+                          const size_t maxLineSearchTrials) :
+    lowerBound(1, 1),
+    upperBound(1, 1),
+    numBasis(numBasis),
+    maxIterations(maxIterations),
+    armijoConstant(armijoConstant),
+    minGradientNorm(minGradientNorm),
+    factr(factr),
+    maxLineSearchTrials(maxLineSearchTrials),
+    workspace(NULL)
+{
+  this->lowerBound(0, 0) = lowerBound;
+  this->upperBound(0, 0) = upperBound;
+}
+
+inline L_BFGS_B::L_BFGS_B(const arma::mat& lowerBound,
+                          const arma::mat& upperBound,
+                          const size_t numBasis,
+                          const size_t maxIterations,
+                          const double armijoConstant,
+                          const double minGradientNorm,
+                          const double factr,
+                          const size_t maxLineSearchTrials) :
+    lowerBound(lowerBound),
+    upperBound(upperBound),
+    numBasis(numBasis),
+    maxIterations(maxIterations),
+    armijoConstant(armijoConstant),
+    minGradientNorm(minGradientNorm),
+    factr(factr),
+    maxLineSearchTrials(maxLineSearchTrials),
+    workspace(NULL)
+{ /* Nothing to do. */ }
+
+template<typename ElemType>
+inline void L_BFGS_B::ExpandBound(const arma::mat& bound,
+                                  const size_t n,
+                                  arma::Col<ElemType>& expanded)
+{
+  if (bound.n_elem == 1)
+  {
+    expanded.set_size(n);
+    expanded.fill((ElemType) bound[0]);
+  }
+  else if (bound.n_elem == n)
+  {
+    expanded = arma::conv_to<arma::Col<ElemType>>::from(arma::vectorise(bound));
+  }
+  else
+  {
+    std::ostringstream oss;
+    oss << "L_BFGS_B::Optimize(): the bounds have " << bound.n_elem
+        << " elements, but the iterate has " << n << "!";
+    throw std::invalid_argument(oss.str());
+  }
+}
+
+template<typename CubeType, typename ElemType>
+inline bool L_BFGS_B::CompactMatrices(const size_t numPairs,
+                                      const CubeType& pairs,
+                                      const arma::Mat<ElemType>& products,
+                                      ElemType& theta,
+                                      arma::Mat<ElemType>& w,
+                                      arma::Mat<ElemType>& m) const
+{
+  // The number of pairs, and the position in the ring buffer of the oldest
+  // and of the newest.
+  const size_t k = std::min(numPairs, numBasis);
+  const size_t first = numPairs - k;
+  const size_t last = (numPairs - 1) % numBasis;
+  theta = products(2 * last + 1, 2 * last + 1) /
+      products(2 * last, 2 * last + 1);
+
+  // W = [Y theta S]; the pairs are the columns of one matrix (see L_BFGS).
+  const size_t n = pairs.n_rows * pairs.n_cols;
+  const arma::Mat<ElemType> pairMatrix(const_cast<ElemType*>(pairs.memptr()),
+      n, pairs.n_slices, false, true);
+  w.set_size(n, 2 * k);
+
+  // M is the inverse of
+  //
+  //   [ -D   L^T           ]
+  //   [  L   theta S^T S   ]
+  //
+  // where D is the diagonal of S^T Y and L is its strictly lower triangle.
+  arma::Mat<ElemType> middle(2 * k, 2 * k, arma::fill::zeros);
+  for (size_t i = 0; i < k; ++i)
+  {
+    const size_t posI = (first + i) % numBasis;
+    w.col(i) = pairMatrix.col(2 * posI + 1);
+    w.col(k + i) = theta * pairMatrix.col(2 * posI);
+
+    middle(i, i) = -products(2 * posI, 2 * posI + 1);
+    for (size_t j = 0; j < k; ++j)
+    {
+      const size_t posJ = (first + j) % numBasis;
+      if (i > j)
+      {
+        middle(k + i, j) = products(2 * posI, 2 * posJ + 1);
+        middle(j, k + i) = middle(k + i, j);
+      }
+      middle(k + i, k + j) = theta * products(2 * posI, 2 * posJ);
+    }
+  }
+
+  return arma::inv(m, middle);
+}
+
+template<typename ElemType>
+inline void L_BFGS_B::CauchyPoint(const arma::Col<ElemType>& x,
+                                  const arma::Col<ElemType>& g,
+                                  const arma::Col<ElemType>& lower,
+                                  const arma::Col<ElemType>& upper,
+                                  const ElemType theta,
+                                  const arma::Mat<ElemType>& w,
+                                  const arma::Mat<ElemType>& m,
+                                  arma::Col<ElemType>& cauchy,
+                                  arma::Col<ElemType>& c) const
+{
+  const size_t n = x.n_elem;
+  const ElemType infinity = std::numeric_limits<ElemType>::infinity();
+
+  // The breakpoint of each coordinate, where the projected steepest descent
+  // path reaches its bound, and the direction of the path.
+  arma::Col<ElemType> breakpoints(n);
+  arma::Col<ElemType> d(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (g[i] < 0)
+      breakpoints[i] = (upper[i] == infinity) ? infinity : (x[i] - upper[i]) /
+          g[i];
+    else if (g[i] > 0)
+      breakpoints[i] = (lower[i] == -infinity) ? infinity :
+          (x[i] - lower[i]) / g[i];
+    else
+      breakpoints[i] = 0;
+
+    d[i] = (breakpoints[i] == 0) ? 0 : -g[i];
+  }
+
+  cauchy = x;
+  c.zeros(w.n_cols);
+
+  // The first and second derivatives of the model along the path.
+  arma::Col<ElemType> p = w.t() * d;
+  ElemType fp = -dot(d, d);
+  if (fp == 0)
+    return;
+
+  ElemType fpp = -theta * fp - dot(p, m * p);
+  const ElemType fppMin = std::numeric_limits<ElemType>::epsilon() * fpp;
+  ElemType dtMin = -fp / fpp;
+  ElemType tOld = 0;
+
+  // Visit the breakpoints in order, fixing each coordinate at its bound,
+  // until the minimizer of the model on the current segment is found.
+  const arma::uvec order = arma::sort_index(breakpoints);
+  for (size_t j = 0; j < n; ++j)
+  {
+    const size_t b = order[j];
+    if (breakpoints[b] == 0)
+      continue;
+    if (breakpoints[b] == infinity)
+      break;
+
+    const ElemType dt = breakpoints[b] - tOld;
+    if (dtMin < dt)
+      break;
+
+    cauchy[b] = (d[b] > 0) ? upper[b] : lower[b];
+    const ElemType z = cauchy[b] - x[b];
+    c += dt * p;
+
+    const arma::Col<ElemType> wb = w.row(b).t();
+    const arma::Col<ElemType> mw = m * wb;
+    const ElemType gb = g[b];
+    fp += dt * fpp + gb * gb + theta * gb * z - gb * dot(mw, c);
+    fpp += -theta * gb * gb - 2 * gb * dot(mw, p) - gb * gb * dot(wb, mw);
+    fpp = std::max(fppMin, fpp);
+    p += gb * wb;
+    d[b] = 0;
+
+    dtMin = -fp / fpp;
+    tOld = breakpoints[b];
+  }
+
+  // Move the coordinates that are still free to the minimizer.
+  dtMin = std::max(dtMin, ElemType(0));
+  tOld += dtMin;
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (d[i] != 0)
+      cauchy[i] = x[i] + tOld * d[i];
+  }
+  c += dtMin * p;
+}
+
+template<typename ElemType>
+inline void L_BFGS_B::SubspaceMinimization(const arma::Col<ElemType>& x,
+                                           const arma::Col<ElemType>& g,
+                                           const arma::Col<ElemType>& lower,
+                                           const arma::Col<ElemType>& upper,
+                                           const ElemType theta,
+                                           const arma::Mat<ElemType>& w,
+                                           const arma::Mat<ElemType>& m,
+                                           const arma::Col<ElemType>& cauchy,
+                                           const arma::Col<ElemType>& c,
+                                           arma::Col<ElemType>& result) const
+{
+  result = cauchy;
+
+  // The coordinates that are not at a bound.
+  const arma::uvec free = arma::find((cauchy > lower) % (cauchy < upper));
+  if (free.n_elem == 0)
+    return;
+
+  // The reduced gradient of the model at the Cauchy point.
+  arma::Col<ElemType> r = g + theta * (cauchy - x);
+  if (w.n_cols > 0)
+    r -= w * (m * c);
+  const arma::Col<ElemType> rFree = r.elem(free);
+
+  // Solve the reduced Newton system with the Sherman-Morrison-Woodbury
+  // formula, which only needs 2k x 2k systems.
+  arma::Col<ElemType> dFree = -rFree / theta;
+  if (w.n_cols > 0)
+  {
+    const arma::Mat<ElemType> wFree = w.rows(free);
+    const arma::Col<ElemType> v = m * (wFree.t() * rFree);
+    const arma::Mat<ElemType> nMat = arma::eye<arma::Mat<ElemType>>(w.n_cols,
+        w.n_cols) - (m * (wFree.t() * wFree)) / theta;
+    arma::Col<ElemType> u;
+    if (arma::solve(u, nMat, v))
+      dFree -= (wFree * u) / (theta * theta);
+  }
+
+  // Truncate the step so that it stays in the box.
+  ElemType alpha = 1;
+  for (size_t j = 0; j < free.n_elem; ++j)
+  {
+    const size_t i = free[j];
+    if (dFree[j] > 0)
+      alpha = std::min(alpha, (upper[i] - cauchy[i]) / dFree[j]);
+    else if (dFree[j] < 0)
+      alpha = std::min(alpha, (lower[i] - cauchy[i]) / dFree[j]);
+  }
+
+  for (size_t j = 0; j < free.n_elem; ++j)
+    result[free[j]] += alpha * dFree[j];
+}
+
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename MatType::elem_type
+L_BFGS_B::Optimize(FunctionType& function,
+                   MatType& iterateIn,
+                   CallbackTypes&&... callbacks)
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+  typedef typename CubeTypeTraits<BaseMatType>::CubeType CubeType;
+  typedef arma::Col<ElemType> VecType;
+
+  // Use the Function<> wrapper to ensure the function has all of the functions
+  // that we need.
+  typedef Function<FunctionType, BaseMatType, BaseGradType> FullFunctionType;
+  FullFunctionType& f = static_cast<FullFunctionType&>(function);
+  ENS_PROFILE_OPTIMIZE("L_BFGS_B");
+
+  // Check that we have all the functions we will need.
+  traits::CheckFunctionTypeAPI<FullFunctionType, BaseMatType, BaseGradType>();
+
+  // Vectors are optimized as matrices.
+  BaseMatType& iterate = static_cast<BaseMatType&>(iterateIn);
+
+  // The Cauchy point and the subspace minimization work on the coordinates in
+  // host memory.
+  static_assert(!IsCootType<BaseMatType>::value, "L_BFGS_B::Optimize(): "
+      "Bandicoot matrices are not supported.");
+
+  if (numBasis == 0)
+  {
+    throw std::invalid_argument("L_BFGS_B::Optimize(): the number of memory "
+        "points must be greater than zero!");
+  }
+
+  const size_t rows = iterate.n_rows;
+  const size_t cols = iterate.n_cols;
+  const size_t n = iterate.n_elem;
+
+  // The temporaries are taken from the given workspace, or else from a local
+  // one.
+  ens::Workspace localWorkspace;
+  ens::Workspace& ws = (workspace != NULL) ? *workspace : localWorkspace;
+
+  VecType& lower = ws.Get<VecType>(0);
+  VecType& upper = ws.Get<VecType>(1);
+  ExpandBound(lowerBound, n, lower);
+  ExpandBound(upperBound, n, upper);
+  if (arma::any(lower > upper))
+  {
+    throw std::invalid_argument("L_BFGS_B::Optimize(): a lower bound is "
+        "greater than its upper bound!");
+  }
+
+  // The stored pairs and their inner products, laid out as in the compact
+  // representation of L_BFGS.
+  CubeType& pairs = ws.Get<CubeType>(2);
+  arma::Mat<ElemType>& products = ws.Get<arma::Mat<ElemType>>(3);
+  pairs.zeros(rows, cols, 2 * numBasis);
+  products.zeros(2 * numBasis, 2 * numBasis);
+
+  BaseGradType& gradient = ws.Get<BaseGradType>(4);
+  BaseMatType& newIterate = ws.Get<BaseMatType>(5);
+  BaseGradType& newGradient = ws.Get<BaseGradType>(6);
+  gradient.set_size(rows, cols);
+  newIterate.set_size(rows, cols);
+  newGradient.set_size(rows, cols);
+
+  VecType& cauchy = ws.Get<VecType>(7);
+  VecType& c = ws.Get<VecType>(8);
+  VecType& target = ws.Get<VecType>(9);
+  VecType& direction = ws.Get<VecType>(10);
+  VecType& s = ws.Get<VecType>(11);
+  VecType& y = ws.Get<VecType>(12);
+  arma::Mat<ElemType>& w = ws.Get<arma::Mat<ElemType>>(13);
+  arma::Mat<ElemType>& m = ws.Get<arma::Mat<ElemType>>(14);
+
+  // Views of the iterates and gradients as columns.
+  VecType x(iterate.memptr(), n, false, true);
+  VecType g(gradient.memptr(), n, false, true);
+  VecType newX(newIterate.memptr(), n, false, true);
+  VecType newG(newGradient.memptr(), n, false, true);
+
+  // Start from the projection of the starting point onto the box.
+  x = arma::min(arma::max(x, lower), upper);
+
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+  terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
+
+  // The initial function value and gradient.
+  ElemType functionValue;
+  {
+    ENS_PROFILE_SCOPE("EvaluateWithGradient");
+    functionValue = f.EvaluateWithGradient(iterate, gradient);
+  }
+  terminate |= Callback::EvaluateWithGradient(*this, f, iterate, functionValue,
+      gradient, callbacks...);
+
+  size_t numPairs = 0;
+  for (size_t itNum = 0; (maxIterations == 0 || itNum != maxIterations) &&
+      !terminate; ++itNum)
+  {
+    // Break when the projected gradient becomes too small.
+    const ElemType projectedGradientNorm = arma::abs(
+        arma::min(arma::max(x - g, lower), upper) - x).max();
+    if (projectedGradientNorm < minGradientNorm)
+    {
+      Info << "L-BFGS-B projected gradient norm too small (terminating "
+          << "successfully)." << std::endl;
+      break;
+    }
+
+    // Break if the objective is not a number.
+    if (std::isnan(functionValue))
+    {
+      Warn << "L-BFGS-B terminated with objective " << functionValue << "; "
+          << "are the objective and gradient functions implemented correctly?"
+          << std::endl;
+      break;
+    }
+
+    // Find the Cauchy point and minimize the model over the free coordinates.
+    ElemType theta = 1;
+    {
+      ENS_PROFILE_SCOPE("SearchDirection");
+      if (numPairs > 0 && !CompactMatrices(numPairs, pairs, products, theta,
+          w, m))
+      {
+        numPairs = 0;
+        theta = 1;
+      }
+
+      if (numPairs == 0)
+      {
+        w.set_size(n, 0);
+        m.set_size(0, 0);
+      }
+
+      CauchyPoint(x, g, lower, upper, theta, w, m, cauchy, c);
+      SubspaceMinimization(x, g, lower, upper, theta, w, m, cauchy, c, target);
+      direction = target - x;
+    }
+
+    const ElemType slope = dot(g, direction);
+    if (!(slope < 0))
+    {
+      if (numPairs > 0)
+      {
+        // The approximation has gone bad; start again from steepest descent.
+        numPairs = 0;
+        continue;
+      }
+
+      Info << "L-BFGS-B found no descent direction (terminating successfully)."
+          << std::endl;
+      break;
+    }
+
+    // Backtrack from the minimizer of the model towards the current point;
+    // every step in (0, 1] stays in the box.  Without curvature information,
+    // the first step has unit length.
+    const ElemType directionNorm = norm(direction);
+    ElemType step = (numPairs == 0) ?
+        std::min(ElemType(1), 1 / directionNorm) : ElemType(1);
+    ElemType newFunctionValue = functionValue;
+    bool accepted = false;
+    {
+      ENS_PROFILE_SCOPE("LineSearch");
+      for (size_t t = 0; t < maxLineSearchTrials; ++t)
+      {
+        newX = arma::min(arma::max(x + step * direction, lower), upper);
+        {
+          ENS_PROFILE_SCOPE("EvaluateWithGradient");
+          newFunctionValue = f.EvaluateWithGradient(newIterate, newGradient);
+        }
+
+        if (newFunctionValue <= functionValue + armijoConstant * step * slope)
+        {
+          accepted = true;
+          break;
+        }
+
+        // Take the minimizer of the quadratic interpolation, safeguarded to
+        // [0.1, 0.5] times the last step.
+        const ElemType denominator = 2 * (newFunctionValue - functionValue -
+            slope * step);
+        const ElemType interpolated = (denominator > 0) ?
+            -slope * step * step / denominator : ElemType(0.5) * step;
+        step = std::min(ElemType(0.5) * step,
+            std::max(ElemType(0.1) * step, interpolated));
+      }
+    }
+
+    if (!accepted)
+    {
+      if (numPairs > 0)
+      {
+        numPairs = 0;
+        continue;
+      }
+
+      Warn << "L-BFGS-B line search failed.  Stopping optimization."
+          << std::endl;
+      break;
+    }
+
+    // Store the new pair, if its curvature is sufficiently positive.  The
+    // inner products of every stored vector with the new s and y are
+    // W^T [s y], a single matrix-matrix product (as in L_BFGS).
+    s = newX - x;
+    y = newG - g;
+    const ElemType sy = dot(s, y);
+    if (sy > std::numeric_limits<ElemType>::epsilon() * dot(y, y))
+    {
+      const size_t pos = numPairs % numBasis;
+      VecType(pairs.slice_memptr(2 * pos), n, false, true) = s;
+      VecType(pairs.slice_memptr(2 * pos + 1), n, false, true) = y;
+
+      const arma::Mat<ElemType> pairMatrix(pairs.memptr(), n, pairs.n_slices,
+          false, true);
+      const arma::Mat<ElemType> newPair(pairs.slice_memptr(2 * pos), n, 2,
+          false, true);
+      const arma::Mat<ElemType> newProducts = pairMatrix.t() * newPair;
+      products.cols(2 * pos, 2 * pos + 1) = newProducts;
+      products.rows(2 * pos, 2 * pos + 1) = newProducts.t();
+      ++numPairs;
+    }
+
+    const ElemType prevFunctionValue = functionValue;
+    x = newX;
+    g = newG;
+    functionValue = newFunctionValue;
+
+    terminate |= Callback::EvaluateWithGradient(*this, f, iterate,
+        functionValue, gradient, callbacks...);
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+
+    // If we can't make progress on the gradient, then we'll also accept
+    // a stable function value.
+    const ElemType denom = std::max(
+        std::max(std::abs(prevFunctionValue), std::abs(functionValue)),
+        (ElemType) 1.0);
+    if ((prevFunctionValue - functionValue) / denom <= factr)
+    {
+      Info << "L-BFGS-B function value stable (terminating successfully)."
+          << std::endl;
+      break;
+    }
+  }
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+  return functionValue;
+}
+
+} // namespace ens
+
+#endif
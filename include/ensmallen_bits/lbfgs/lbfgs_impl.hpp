@@ -37,6 +37,12 @@ namespace ens {
  *     (before giving up).
  * @param minStep The minimum step of the line search.
  * @param maxStep The maximum step of the line search.
+ * @param compactRepresentation If true, compute the search direction with the
+ *     compact representation instead of the two-loop recursion.
+ * @param numLineSearchCandidates Number of step sizes to evaluate concurrently
+ *     in each round of the line search (1 means the serial line search).
+ * @param resetHistory If true, the stored pairs are discarded at the start of
+ *     every call to Optimize().
  */
 inline L_BFGS::L_BFGS(const size_t numBasis,
                       const size_t maxIterations,
@@ -46,7 +52,10 @@ inline L_BFGS::L_BFGS(const size_t numBasis,
                       const double factr,
                       const size_t maxLineSearchTrials,
                       const double minStep,
-                      const double maxStep) :
+                      const double maxStep,
+                      const bool compactRepresentation,
+                      const size_t numLineSearchCandidates,
+                      const bool resetHistory) :
     numBasis(numBasis),
     maxIterations(maxIterations),
     armijoConstant(armijoConstant),
@@ -55,11 +64,92 @@ inline L_BFGS::L_BFGS(const size_t numBasis,
     factr(factr),
     maxLineSearchTrials(maxLineSearchTrials),
     minStep(minStep),
-    maxStep(maxStep)
+    maxStep(maxStep),
+    compactRepresentation(compactRepresentation),
+    numLineSearchCandidates(numLineSearchCandidates),
+    resetHistory(resetHistory),
+    minChunkSize(65536),
+    diagonalScaling(false),
+    historyPrecision(FullPrecision),
+    historySize(0),
+    workspace(NULL)
 {
   // Nothing to do.
 }
 
+//! Discard the pairs kept from the last call to Optimize().
+inline void L_BFGS::ClearHistory()
+{
+  historyS.reset();
+  historyY.reset();
+  historyRho.reset();
+  historyPairs.reset();
+  historyProducts.reset();
+  reducedPairs.Clear();
+  historySize = 0;
+}
+
+inline size_t L_BFGS::EstimateMemory(const size_t rows,
+                                     const size_t cols,
+                                     const size_t elemSize) const
+{
+  const size_t n = rows * cols;
+
+  // The new, old and trial iterate, the two gradients and the search
+  // direction.
+  size_t bytes = 5 * n * elemSize;
+
+  // The history: [S Y] and its products, or S, Y, rho and alpha (with S and Y
+  // perhaps in reduced precision).
+  const bool reduced = (historyPrecision != FullPrecision) &&
+      !compactRepresentation;
+  if (compactRepresentation)
+    bytes += (2 * numBasis * n + 4 * numBasis * numBasis) * elemSize;
+  else if (reduced)
+    bytes += ReducedPrecisionPairs::BytesFor(numBasis, n,
+        historyPrecision == BFloat16Precision) + 2 * numBasis * elemSize;
+  else
+    bytes += (2 * numBasis * n + 2 * numBasis) * elemSize;
+
+  // The diagonal and the preconditioner, and the sums of the diagonal scaling.
+  if (diagonalScaling || !preconditioner.is_empty())
+    bytes += 2 * n * elemSize;
+  if (diagonalScaling)
+    bytes += 2 * n * elemSize;
+
+  // The points, gradients, steps and objectives of the parallel line search.
+  if (numLineSearchCandidates > 1)
+  {
+    bytes += numLineSearchCandidates * (2 * n * elemSize + sizeof(double) +
+        elemSize);
+  }
+
+  // The pairs kept for the next call are always stored as doubles, except for
+  // reduced precision pairs, which are kept in place.
+  if (!resetHistory && reduced)
+  {
+    bytes += numBasis * sizeof(double);
+  }
+  else if (!resetHistory)
+  {
+    bytes += (compactRepresentation ?
+        2 * numBasis * n + 4 * numBasis * numBasis :
+        2 * numBasis * n + numBasis) * sizeof(double);
+  }
+
+  return bytes;
+}
+
+inline void L_BFGS::Serialize(BinaryArchive& ar)
+{
+  ar(historyS);
+  ar(historyY);
+  ar(historyRho);
+  ar(historyPairs);
+  ar(historyProducts);
+  ar.Size(historySize);
+}
+
 /**
  * Calculate the scaling factor, gamma, which is used to scale the Hessian
  * approximation matrix.  See method M3 in Section 4 of Liu and Nocedal
@@ -67,88 +157,206 @@ inline L_BFGS::L_BFGS(const size_t numBasis,
  *
  * @return The calculated scaling factor.
  * @param gradient The gradient at the initial point.
- * @param s Differences between the iterate and old iterate matrix.
  * @param y Differences between the gradient and the old gradient matrix.
+ * @param rho Inverse curvature 1 / (y_i^T s_i) of each stored pair.
  */
+template<typename GradType, typename CubeType, typename VecType>
 inline double L_BFGS::ChooseScalingFactor(const size_t iterationNum,
-                                          const arma::mat& gradient,
-                                          const arma::cube& s,
-                                          const arma::cube& y)
+                                          const GradType& gradient,
+                                          const CubeType& y,
+                                          const VecType& rho)
 {
   double scalingFactor = 1.0;
   if (iterationNum > 0)
   {
-    int previousPos = (iterationNum - 1) % numBasis;
-    // Get s and y matrices once instead of multiple times.
-    const arma::mat& sMat = s.slice(previousPos);
-    const arma::mat& yMat = y.slice(previousPos);
-    scalingFactor = dot(sMat, yMat) / dot(yMat, yMat);
+    // dot(s, y) / dot(y, y), with dot(s, y) already known from rho.
+    const size_t previousPos = (iterationNum - 1) % numBasis;
+    const double yDotY = ParallelDot(y.slice(previousPos),
+        y.slice(previousPos), minChunkSize);
+    scalingFactor = 1.0 / (rho[previousPos] * yDotY);
   }
   else
   {
-    scalingFactor = 1.0 / sqrt(dot(gradient, gradient));
+    scalingFactor = 1.0 / sqrt(ParallelDot(gradient, gradient, minChunkSize));
   }
 
   return scalingFactor;
 }
 
+/**
+ * Calculate the diagonal initial inverse Hessian approximation used instead of
+ * the scaling factor.
+ *
+ * @param iterationNum The iteration number.
+ * @param gradient The gradient at the initial point.
+ * @param y Differences between the gradient and the old gradient matrix.
+ * @param rho Inverse curvature 1 / (y_i^T s_i) of each stored pair.
+ * @param base The preconditioner, or ones if none was given.
+ * @param sy Sum of s_i % y_i over the stored pairs.
+ * @param yy Sum of y_i % y_i over the stored pairs.
+ * @param diagonal Matrix to store the diagonal in.
+ */
+template<typename MatType, typename GradType, typename CubeType,
+         typename VecType>
+inline typename std::enable_if<!IsCootType<MatType>::value>::type
+L_BFGS::ChooseDiagonalScaling(const size_t iterationNum,
+                              const GradType& gradient,
+                              const CubeType& y,
+                              const VecType& rho,
+                              const MatType& base,
+                              const MatType& sy,
+                              const MatType& yy,
+                              MatType& diagonal)
+{
+  diagonal = base;
+  if (iterationNum == 0)
+  {
+    // As for the scaling factor, the first step has unit length (in the norm
+    // given by the preconditioner).
+    diagonal *= 1.0 / std::sqrt(arma::dot(gradient, base % gradient));
+    return;
+  }
+
+  // Scale the preconditioner by s^T y / y^T P y, as gamma is for the identity.
+  const size_t lastPos = (iterationNum - 1) % numBasis;
+  const MatType& lastY = y.slice(lastPos);
+  const double sDotY = 1.0 / rho[lastPos];
+  diagonal *= sDotY / arma::dot(lastY, base % lastY);
+
+  if (!diagonalScaling)
+    return;
+
+  // Estimate the inverse curvature along each parameter from the stored pairs,
+  // where they give a positive estimate.
+  for (size_t i = 0; i < diagonal.n_elem; ++i)
+  {
+    if (sy[i] > 0 && yy[i] > 0)
+      diagonal[i] = sy[i] / yy[i];
+  }
+
+  // The estimates only give the relative scale of the parameters; rescale them
+  // to satisfy the secant equation of the last pair along y.
+  const double yDotDy = arma::dot(lastY, diagonal % lastY);
+  if (yDotDy > 0 && sDotY > 0)
+    diagonal *= sDotY / yDotDy;
+}
+
+/**
+ * Update the sums of the diagonal scaling for the pair stored by
+ * UpdateBasisSet() at the given iteration.
+ *
+ * @param iterationNum Iteration number of the pair.
+ * @param stored Whether the pair has been stored already.
+ * @param s Differences between the iterate and old iterate matrix.
+ * @param y Differences between the gradient and the old gradient matrix.
+ * @param sy Sum of s_i % y_i over the stored pairs.
+ * @param yy Sum of y_i % y_i over the stored pairs.
+ */
+template<typename MatType, typename CubeType>
+inline void L_BFGS::UpdateCurvatureSums(const size_t iterationNum,
+                                        const bool stored,
+                                        const CubeType& s,
+                                        const CubeType& y,
+                                        MatType& sy,
+                                        MatType& yy)
+{
+  const size_t pos = iterationNum % numBasis;
+
+  // The sums are recomputed when the last position of the ring buffer is
+  // filled, so the pair replaced there need not be subtracted.
+  if (pos == numBasis - 1)
+  {
+    if (stored)
+    {
+      sy = s.slice(0) % y.slice(0);
+      yy = square(y.slice(0));
+      for (size_t i = 1; i < numBasis; ++i)
+      {
+        sy += s.slice(i) % y.slice(i);
+        yy += square(y.slice(i));
+      }
+    }
+  }
+  else if (stored)
+  {
+    sy += s.slice(pos) % y.slice(pos);
+    yy += square(y.slice(pos));
+  }
+  else if (iterationNum >= numBasis)
+  {
+    sy -= s.slice(pos) % y.slice(pos);
+    yy -= square(y.slice(pos));
+  }
+}
+
 /**
  * Find the L_BFGS search direction.
  *
  * @param gradient The gradient at the current point.
  * @param iterationNum The iteration number.
  * @param scalingFactor Scaling factor to use (see ChooseScalingFactor_()).
+ * @param diagonal Diagonal initial inverse Hessian approximation to use instead
+ *     of the scaling factor (see ChooseDiagonalScaling()), or an empty matrix.
  * @param s Differences between the iterate and old iterate matrix.
  * @param y Differences between the gradient and the old gradient matrix.
+ * @param rho Inverse curvature 1 / (y_i^T s_i) of each stored pair.
+ * @param alpha Workspace of numBasis elements for the first recursion.
  * @param searchDirection Vector to store search direction in.
  */
-inline void L_BFGS::SearchDirection(const arma::mat& gradient,
+template<typename MatType, typename GradType, typename CubeType,
+         typename VecType>
+inline void L_BFGS::SearchDirection(const GradType& gradient,
                                     const size_t iterationNum,
                                     const double scalingFactor,
-                                    const arma::cube& s,
-                                    const arma::cube& y,
-                                    arma::mat& searchDirection)
+                                    const MatType& diagonal,
+                                    const CubeType& s,
+                                    const CubeType& y,
+                                    const VecType& rho,
+                                    VecType& alpha,
+                                    MatType& searchDirection)
 {
   // Start from this point.
   searchDirection = gradient;
 
   // See "A Recursive Formula to Compute H * g" in "Updating quasi-Newton
-  // matrices with limited storage" (Nocedal, 1980).
-
-  // Temporary variables.
-  arma::vec rho(numBasis);
-  arma::vec alpha(numBasis);
-
-  size_t limit = (numBasis > iterationNum) ? 0 : (iterationNum - numBasis);
+  // matrices with limited storage" (Nocedal, 1980).  The pair from iteration
+  // k is stored at position k % numBasis of the ring buffer, and alpha is
+  // indexed the same way, so no temporaries are needed.  Each dot product and
+  // update is a pass over memory, split over the threads for large iterates.
+  const size_t limit = (numBasis > iterationNum) ? 0 :
+      (iterationNum - numBasis);
   for (size_t i = iterationNum; i != limit; i--)
   {
-    int translatedPosition = (i + (numBasis - 1)) % numBasis;
-    rho[iterationNum - i] = 1.0 / arma::dot(y.slice(translatedPosition),
-                                            s.slice(translatedPosition));
-    alpha[iterationNum - i] = rho[iterationNum - i] *
-        arma::dot(s.slice(translatedPosition), searchDirection);
-    searchDirection -= alpha[iterationNum - i] * y.slice(translatedPosition);
+    const size_t pos = (i - 1) % numBasis;
+    alpha[pos] = rho[pos] * ParallelDot(s.slice(pos), searchDirection,
+        minChunkSize);
+    ParallelAxpy(-alpha[pos], y.slice(pos), searchDirection, minChunkSize);
   }
 
-  searchDirection *= scalingFactor;
+  if (diagonal.is_empty())
+    ParallelScale(scalingFactor, searchDirection, minChunkSize);
+  else
+    searchDirection %= diagonal;
 
   for (size_t i = limit; i < iterationNum; i++)
   {
-    int translatedPosition = i % numBasis;
-    double beta = rho[iterationNum - i - 1] *
-        arma::dot(y.slice(translatedPosition), searchDirection);
-    searchDirection += (alpha[iterationNum - i - 1] - beta) *
-        s.slice(translatedPosition);
+    const size_t pos = i % numBasis;
+    const double beta = rho[pos] * ParallelDot(y.slice(pos), searchDirection,
+        minChunkSize);
+    ParallelAxpy(alpha[pos] - beta, s.slice(pos), searchDirection,
+        minChunkSize);
   }
 
   // Negate the search direction so that it is a descent direction.
-  searchDirection *= -1;
+  ParallelScale(-1.0, searchDirection, minChunkSize);
 }
 
 /**
  * Update the y and s matrices, which store the differences between
  * the iterate and old iterate and the differences between the gradient and the
- * old gradient, respectively.
+ * old gradient, respectively.  The inverse curvature of the new pair is stored
+ * in rho, so that it is computed once instead of in every later search
+ * direction.
  *
  * @param iterationNum Iteration number.
  * @param iterate Current point.
@@ -157,20 +365,248 @@ inline void L_BFGS::SearchDirection(const arma::mat& gradient,
  * @param oldGradient Gradient at last iteration point (oldIterate).
  * @param s Differences between the iterate and old iterate matrix.
  * @param y Differences between the gradient and the old gradient matrix.
+ * @param rho Inverse curvature 1 / (y_i^T s_i) of each stored pair.
  */
+template<typename MatType, typename GradType, typename CubeType,
+         typename VecType>
 inline void L_BFGS::UpdateBasisSet(const size_t iterationNum,
-                                   const arma::mat& iterate,
-                                   const arma::mat& oldIterate,
-                                   const arma::mat& gradient,
-                                   const arma::mat& oldGradient,
-                                   arma::cube& s,
-                                   arma::cube& y)
+                                   const MatType& iterate,
+                                   const MatType& oldIterate,
+                                   const GradType& gradient,
+                                   const GradType& oldGradient,
+                                   CubeType& s,
+                                   CubeType& y,
+                                   VecType& rho)
 {
   // Overwrite a certain position instead of pushing everything in the vector
   // back one position.
-  int overwritePos = iterationNum % numBasis;
-  s.slice(overwritePos) = iterate - oldIterate;
-  y.slice(overwritePos) = gradient - oldGradient;
+  const size_t overwritePos = iterationNum % numBasis;
+  ParallelDifference(iterate, oldIterate, s.slice(overwritePos), minChunkSize);
+  ParallelDifference(gradient, oldGradient, y.slice(overwritePos),
+      minChunkSize);
+  rho[overwritePos] = 1.0 / ParallelDot(y.slice(overwritePos),
+      s.slice(overwritePos), minChunkSize);
+}
+
+/**
+ * Find the L_BFGS search direction with the pairs stored in reduced precision.
+ *
+ * @param gradient The gradient at the current point.
+ * @param iterationNum The iteration number.
+ * @param rho Inverse curvature 1 / (y_i^T s_i) of each stored pair.
+ * @param alpha Workspace of numBasis elements for the first recursion.
+ * @param searchDirection Vector to store search direction in.
+ */
+template<typename MatType, typename GradType, typename VecType>
+inline void L_BFGS::ReducedSearchDirection(const GradType& gradient,
+                                           const size_t iterationNum,
+                                           const VecType& rho,
+                                           VecType& alpha,
+                                           MatType& searchDirection)
+{
+  searchDirection = gradient;
+
+  // The same recursion as SearchDirection(), with s_i the vector 2i of the
+  // stored pairs and y_i the vector 2i + 1.
+  const size_t limit = (numBasis > iterationNum) ? 0 :
+      (iterationNum - numBasis);
+  for (size_t i = iterationNum; i != limit; i--)
+  {
+    const size_t pos = (i - 1) % numBasis;
+    alpha[pos] = rho[pos] * reducedPairs.Dot(2 * pos, searchDirection,
+        minChunkSize);
+    reducedPairs.Axpy(-alpha[pos], 2 * pos + 1, searchDirection, minChunkSize);
+  }
+
+  // Choose the scaling factor as in ChooseScalingFactor().
+  double scalingFactor;
+  if (iterationNum > 0)
+  {
+    const size_t previousPos = (iterationNum - 1) % numBasis;
+    scalingFactor = 1.0 / (rho[previousPos] * reducedPairs.Dot(
+        2 * previousPos + 1, 2 * previousPos + 1, minChunkSize));
+  }
+  else
+  {
+    scalingFactor = 1.0 / sqrt(ParallelDot(gradient, gradient, minChunkSize));
+  }
+  ParallelScale(scalingFactor, searchDirection, minChunkSize);
+
+  for (size_t i = limit; i < iterationNum; i++)
+  {
+    const size_t pos = i % numBasis;
+    const double beta = rho[pos] * reducedPairs.Dot(2 * pos + 1,
+        searchDirection, minChunkSize);
+    reducedPairs.Axpy(alpha[pos] - beta, 2 * pos, searchDirection,
+        minChunkSize);
+  }
+
+  // Negate the search direction so that it is a descent direction.
+  ParallelScale(-1.0, searchDirection, minChunkSize);
+}
+
+/**
+ * Store a new pair in reduced precision.
+ *
+ * @param iterationNum Iteration number.
+ * @param iterate Current point.
+ * @param oldIterate Point at last iteration.
+ * @param gradient Gradient at current point (iterate).
+ * @param oldGradient Gradient at last iteration point (oldIterate).
+ * @param rho Inverse curvature 1 / (y_i^T s_i) of each stored pair.
+ */
+template<typename MatType, typename GradType, typename VecType>
+inline void L_BFGS::UpdateReducedBasisSet(const size_t iterationNum,
+                                          const MatType& iterate,
+                                          const MatType& oldIterate,
+                                          const GradType& gradient,
+                                          const GradType& oldGradient,
+                                          VecType& rho)
+{
+  const size_t overwritePos = iterationNum % numBasis;
+  reducedPairs.Store(2 * overwritePos, iterate, oldIterate, minChunkSize);
+  reducedPairs.Store(2 * overwritePos + 1, gradient, oldGradient,
+      minChunkSize);
+  rho[overwritePos] = 1.0 / reducedPairs.Dot(2 * overwritePos,
+      2 * overwritePos + 1, minChunkSize);
+}
+
+/**
+ * Find the L_BFGS search direction with the compact representation of the
+ * inverse Hessian approximation.
+ *
+ * @param gradient The gradient at the current point.
+ * @param iterationNum The iteration number.
+ * @param pairs Stored pairs: s_i in slice 2i and y_i in slice 2i + 1.
+ * @param products Inner products of all the slices of pairs.
+ * @param searchDirection Vector to store search direction in.
+ */
+template<typename MatType, typename GradType, typename CubeType>
+inline typename std::enable_if<!IsCootType<MatType>::value>::type
+L_BFGS::CompactSearchDirection(
+    const GradType& gradient,
+    const size_t iterationNum,
+    CubeType& pairs,
+    const arma::Mat<typename CubeType::elem_type>& products,
+    MatType& searchDirection)
+{
+  typedef typename CubeType::elem_type ElemType;
+
+  if (iterationNum == 0)
+  {
+    searchDirection = gradient;
+    searchDirection *= -1.0 / std::sqrt(arma::dot(gradient, gradient));
+    return;
+  }
+
+  // The slices of the cube are stored one after another, so all the pairs
+  // form the columns of one matrix W = [s_0 y_0 s_1 y_1 ...], and the gradient
+  // and the search direction are columns of length n; none of these are
+  // copied.
+  const size_t n = pairs.n_rows * pairs.n_cols;
+  const arma::Mat<ElemType> w(pairs.memptr(), n, pairs.n_slices, false, true);
+  const arma::Col<ElemType> g(const_cast<ElemType*>(gradient.memptr()), n,
+      false, true);
+  arma::Col<ElemType> direction(searchDirection.memptr(), n, false, true);
+
+  // The number of pairs, and the position in the ring buffer of the oldest.
+  const size_t k = std::min(iterationNum, numBasis);
+  const size_t first = iterationNum - k;
+
+  // Choose the scaling factor as in ChooseScalingFactor().
+  const size_t lastPos = (iterationNum - 1) % numBasis;
+  const ElemType gamma = products(2 * lastPos, 2 * lastPos + 1) /
+      products(2 * lastPos + 1, 2 * lastPos + 1);
+
+  // [S^T g; Y^T g], with a single pass over the history.
+  const arma::Col<ElemType> wg = w.t() * g;
+
+  // Gather the small matrices in chronological order.
+  arma::Mat<ElemType> r(k, k, arma::fill::zeros);
+  arma::Mat<ElemType> yTy(k, k);
+  arma::Col<ElemType> sg(k), yg(k);
+  for (size_t j = 0; j < k; ++j)
+  {
+    const size_t posJ = (first + j) % numBasis;
+    sg[j] = wg[2 * posJ];
+    yg[j] = wg[2 * posJ + 1];
+    for (size_t i = 0; i < k; ++i)
+    {
+      const size_t posI = (first + i) % numBasis;
+      if (i <= j)
+        r(i, j) = products(2 * posI, 2 * posJ + 1);
+      yTy(i, j) = products(2 * posI + 1, 2 * posJ + 1);
+    }
+  }
+
+  // u = R^-1 S^T g, and the coefficients of S are
+  // R^-T ((D + gamma Y^T Y) u - gamma Y^T g).
+  arma::Col<ElemType> u, sCoefficients;
+  if (!arma::solve(u, arma::trimatu(r), sg) ||
+      !arma::solve(sCoefficients, arma::trimatl(r.t()),
+          (arma::diagmat(r.diag()) + gamma * yTy) * u - gamma * yg))
+  {
+    // R is singular, so a curvature pair is degenerate; fall back to a scaled
+    // steepest descent step.
+    direction = -gamma * g;
+    return;
+  }
+
+  // Scatter the coefficients into the ring buffer order of W.
+  arma::Col<ElemType> coefficients(pairs.n_slices, arma::fill::zeros);
+  for (size_t j = 0; j < k; ++j)
+  {
+    const size_t posJ = (first + j) % numBasis;
+    coefficients[2 * posJ] = sCoefficients[j];
+    coefficients[2 * posJ + 1] = -gamma * u[j];
+  }
+
+  // H g = gamma g + W c, with a single pass over the history; negate it so
+  // that it is a descent direction.
+  direction = w * coefficients;
+  direction += gamma * g;
+  direction *= -1;
+}
+
+/**
+ * Store a new pair for the compact representation, and update the inner
+ * products of the stored pairs.
+ *
+ * @param iterationNum Iteration number.
+ * @param iterate Current point.
+ * @param oldIterate Point at last iteration.
+ * @param gradient Gradient at current point (iterate).
+ * @param oldGradient Gradient at last iteration point (oldIterate).
+ * @param pairs Stored pairs: s_i in slice 2i and y_i in slice 2i + 1.
+ * @param products Inner products of all the slices of pairs.
+ */
+template<typename MatType, typename GradType, typename CubeType>
+inline typename std::enable_if<!IsCootType<MatType>::value>::type
+L_BFGS::UpdateCompactBasisSet(
+    const size_t iterationNum,
+    const MatType& iterate,
+    const MatType& oldIterate,
+    const GradType& gradient,
+    const GradType& oldGradient,
+    CubeType& pairs,
+    arma::Mat<typename CubeType::elem_type>& products)
+{
+  typedef typename CubeType::elem_type ElemType;
+
+  const size_t overwritePos = iterationNum % numBasis;
+  pairs.slice(2 * overwritePos) = iterate - oldIterate;
+  pairs.slice(2 * overwritePos + 1) = gradient - oldGradient;
+
+  // The inner products of every stored vector with the new s and y are
+  // W^T [s y], a single matrix-matrix product.
+  const size_t n = pairs.n_rows * pairs.n_cols;
+  const arma::Mat<ElemType> w(pairs.memptr(), n, pairs.n_slices, false, true);
+  const arma::Mat<ElemType> newPair(pairs.slice_memptr(2 * overwritePos), n, 2,
+      false, true);
+  const arma::Mat<ElemType> newProducts = w.t() * newPair;
+
+  products.cols(2 * overwritePos, 2 * overwritePos + 1) = newProducts;
+  products.rows(2 * overwritePos, 2 * overwritePos + 1) = newProducts.t();
 }
 
 /**
@@ -186,13 +622,16 @@ inline void L_BFGS::UpdateBasisSet(const size_t iterationNum,
  *
  * @return false if no step size is suitable, true otherwise.
  */
-template<typename FunctionType>
+template<typename FunctionType,
+         typename ElemType,
+         typename MatType,
+         typename GradType>
 bool L_BFGS::LineSearch(FunctionType& function,
-                        double& functionValue,
-                        arma::mat& iterate,
-                        arma::mat& gradient,
-                        arma::mat& newIterateTmp,
-                        const arma::mat& searchDirection)
+                        ElemType& functionValue,
+                        MatType& iterate,
+                        GradType& gradient,
+                        MatType& newIterateTmp,
+                        const MatType& searchDirection)
 {
   // Default first step size of 1.0.
   double stepSize = 1.0;
@@ -200,7 +639,7 @@ bool L_BFGS::LineSearch(FunctionType& function,
   // The initial linear term approximation in the direction of the
   // search direction.
   double initialSearchDirectionDotGradient =
-      arma::dot(gradient, searchDirection);
+      ParallelDot(gradient, searchDirection, minChunkSize);
 
   // If it is not a descent direction, just report failure.
   if (initialSearchDirectionDotGradient > 0.0)
@@ -211,7 +650,7 @@ bool L_BFGS::LineSearch(FunctionType& function,
   }
 
   // Save the initial function value.
-  double initialFunctionValue = functionValue;
+  ElemType initialFunctionValue = functionValue;
 
   // Unit linear approximation to the decrease in function value.
   double linearApproxFunctionValueDecrease = armijoConstant *
@@ -225,15 +664,18 @@ bool L_BFGS::LineSearch(FunctionType& function,
   const double dec = 0.5;
   double width = 0;
   double bestStepSize = 1.0;
-  double bestObjective = std::numeric_limits<double>::max();
+  ElemType bestObjective = std::numeric_limits<ElemType>::max();
 
   while (true)
   {
     // Perform a step and evaluate the gradient and the function values at that
     // point.
     newIterateTmp = iterate;
-    newIterateTmp += stepSize * searchDirection;
-    functionValue = function.EvaluateWithGradient(newIterateTmp, gradient);
+    ParallelAxpy(stepSize, searchDirection, newIterateTmp, minChunkSize);
+    {
+      ENS_PROFILE_SCOPE("EvaluateWithGradient");
+      functionValue = function.EvaluateWithGradient(newIterateTmp, gradient);
+    }
     if (functionValue < bestObjective)
     {
       bestStepSize = stepSize;
@@ -249,7 +691,8 @@ bool L_BFGS::LineSearch(FunctionType& function,
     else
     {
       // Check Wolfe's condition.
-      double searchDirectionDotGradient = arma::dot(gradient, searchDirection);
+      double searchDirectionDotGradient = ParallelDot(gradient,
+          searchDirection, minChunkSize);
 
       if (searchDirectionDotGradient < wolfe *
           initialSearchDirectionDotGradient)
@@ -287,6 +730,178 @@ bool L_BFGS::LineSearch(FunctionType& function,
   return true;
 }
 
+/**
+ * Perform a line search that evaluates several step sizes concurrently in each
+ * round, narrowing the interval known to contain a step satisfying the Wolfe
+ * conditions.
+ *
+ * @param function Function to optimize.
+ * @param functionValue Value of the function at the initial point.
+ * @param iterate The initial point to begin the line search from.
+ * @param gradient The gradient at the initial point.
+ * @param trialIterates One point to evaluate per candidate step size.
+ * @param trialGradients One gradient per candidate step size.
+ * @param trialSteps Candidate step sizes (one per trial point).
+ * @param trialObjectives Objective of each trial point.
+ * @param searchDirection A vector specifying the search direction.
+ *
+ * @return false if the search direction is not a descent direction, true
+ *     otherwise.
+ */
+template<typename FunctionType,
+         typename ElemType,
+         typename MatType,
+         typename GradType>
+bool L_BFGS::ParallelLineSearch(FunctionType& function,
+                                ElemType& functionValue,
+                                MatType& iterate,
+                                GradType& gradient,
+                                std::vector<MatType>& trialIterates,
+                                std::vector<GradType>& trialGradients,
+                                arma::vec& trialSteps,
+                                arma::Col<ElemType>& trialObjectives,
+                                const MatType& searchDirection)
+{
+  // The initial linear term approximation in the direction of the
+  // search direction.
+  const double initialSearchDirectionDotGradient =
+      dot(gradient, searchDirection);
+
+  // If it is not a descent direction, just report failure.
+  if (initialSearchDirectionDotGradient > 0.0)
+  {
+    Warn << "L-BFGS line search direction is not a descent direction "
+        << "(terminating)!" << std::endl;
+    return false;
+  }
+
+  // Save the initial function value.
+  const ElemType initialFunctionValue = functionValue;
+
+  // Unit linear approximation to the decrease in function value.
+  const double linearApproxFunctionValueDecrease = armijoConstant *
+      initialSearchDirectionDotGradient;
+
+  // Step size scaling factors for increase and decrease, as in LineSearch().
+  const double inc = 2.1;
+  const double dec = 0.5;
+
+  // The largest step known to be too short and the smallest step known to be
+  // too long (0 if not known yet).
+  double shortStep = 0.0;
+  double longStep = 0.0;
+
+  double bestStepSize = 1.0;
+  ElemType bestObjective = std::numeric_limits<ElemType>::max();
+
+  const size_t numCandidates = trialIterates.size();
+  size_t numIterations = 0;
+  while (true)
+  {
+    // Choose the candidates: inside the bracket if there is one, otherwise
+    // further along the direction the bracket has to be found in.  The first
+    // round starts at the unit step and backtracks.
+    for (size_t j = 0; j < numCandidates; ++j)
+    {
+      if (shortStep > 0.0 && longStep > 0.0)
+      {
+        trialSteps[j] = shortStep * std::pow(longStep / shortStep,
+            (j + 1.0) / (numCandidates + 1.0));
+      }
+      else if (longStep > 0.0)
+      {
+        trialSteps[j] = longStep * std::pow(dec, j + 1.0);
+      }
+      else if (shortStep > 0.0)
+      {
+        trialSteps[j] = shortStep * std::pow(inc, j + 1.0);
+      }
+      else
+      {
+        trialSteps[j] = std::pow(dec, (double) j);
+      }
+    }
+
+    // Evaluate all the candidates at once.
+    ParallelFor(numCandidates, [&](const size_t j)
+    {
+      trialIterates[j] = iterate;
+      trialIterates[j] += trialSteps[j] * searchDirection;
+      trialObjectives[j] = function.EvaluateWithGradient(trialIterates[j],
+          trialGradients[j]);
+    });
+    numIterations += numCandidates;
+
+    // Check the conditions for each candidate, and narrow the bracket.
+    size_t accepted = numCandidates;
+    for (size_t j = 0; j < numCandidates; ++j)
+    {
+      if (trialObjectives[j] < bestObjective)
+      {
+        bestStepSize = trialSteps[j];
+        bestObjective = trialObjectives[j];
+        gradient = trialGradients[j];
+      }
+
+      if (trialObjectives[j] > initialFunctionValue + trialSteps[j] *
+          linearApproxFunctionValueDecrease)
+      {
+        longStep = (longStep > 0.0) ? std::min(longStep, trialSteps[j]) :
+            trialSteps[j];
+        continue;
+      }
+
+      // Check Wolfe's condition.
+      const double searchDirectionDotGradient =
+          dot(trialGradients[j], searchDirection);
+
+      if (searchDirectionDotGradient < wolfe *
+          initialSearchDirectionDotGradient)
+      {
+        shortStep = std::max(shortStep, trialSteps[j]);
+      }
+      else if (searchDirectionDotGradient > -wolfe *
+          initialSearchDirectionDotGradient)
+      {
+        longStep = (longStep > 0.0) ? std::min(longStep, trialSteps[j]) :
+            trialSteps[j];
+      }
+      else if (accepted == numCandidates ||
+          trialObjectives[j] < trialObjectives[accepted])
+      {
+        accepted = j;
+      }
+    }
+
+    // Take the best candidate that satisfies the Wolfe conditions.
+    if (accepted < numCandidates)
+    {
+      functionValue = trialObjectives[accepted];
+      gradient = trialGradients[accepted];
+      iterate += trialSteps[accepted] * searchDirection;
+      return true;
+    }
+
+    // On a nonconvex function a too short step may lie beyond a too long one;
+    // then keep searching below the too long step.
+    if (shortStep >= longStep && longStep > 0.0)
+      shortStep = 0.0;
+
+    // Terminate when the step size gets too small or too big or it
+    // exceeds the max number of iterations.
+    const bool cond1 = (trialSteps.min() < minStep);
+    const bool cond2 = (trialSteps.max() > maxStep);
+    const bool cond3 = (numIterations >= maxLineSearchTrials);
+    if (cond1 || cond2 || cond3)
+      break;
+  }
+
+  // Move to the best point that was found; its gradient is already stored.
+  functionValue = bestObjective;
+  iterate += bestStepSize * searchDirection;
+  return true;
+}
+
 /**
  * Use L_BFGS to optimize the given function, starting at the given iterate
  * point and performing no more than the specified number of maximum iterations.
@@ -296,47 +911,249 @@ bool L_BFGS::LineSearch(FunctionType& function,
  * @param numIterations Maximum number of iterations to perform
  * @param iterate Starting point (will be modified)
  */
-template<typename FunctionType>
-double L_BFGS::Optimize(FunctionType& function, arma::mat& iterate)
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename MatType::elem_type
+L_BFGS::Optimize(FunctionType& function,
+                 MatType& iterateIn,
+                 CallbackTypes&&... callbacks)
 {
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+  typedef typename CubeTypeTraits<BaseMatType>::CubeType CubeType;
+
   // Use the Function<> wrapper to ensure the function has all of the functions
   // that we need.
-  typedef Function<FunctionType> FullFunctionType;
+  typedef Function<FunctionType, BaseMatType, BaseGradType> FullFunctionType;
   FullFunctionType& f = static_cast<FullFunctionType&>(function);
+  ENS_PROFILE_OPTIMIZE("L_BFGS");
 
   // Check that we have all the functions we will need.
-  traits::CheckFunctionTypeAPI<FullFunctionType>();
+  traits::CheckFunctionTypeAPI<FullFunctionType, BaseMatType, BaseGradType>();
+
+  // Vectors are optimized as matrices.
+  BaseMatType& iterate = static_cast<BaseMatType&>(iterateIn);
+
+  // The compact representation views the stored pairs as one matrix in host
+  // memory.
+  if (compactRepresentation && IsCootType<BaseMatType>::value)
+  {
+    throw std::invalid_argument("L_BFGS::Optimize(): the compact "
+        "representation is not available for Bandicoot matrices!");
+  }
 
   // Ensure that the cubes holding past iterations' information are the right
   // size.  Also set the current best point value to the maximum.
   const size_t rows = iterate.n_rows;
   const size_t cols = iterate.n_cols;
 
-  arma::mat newIterateTmp(rows, cols);
-  arma::cube s(rows, cols, numBasis);
-  arma::cube y(rows, cols, numBasis);
+  // The diagonal initial inverse Hessian approximation is only used by the
+  // two-loop recursion, with Armadillo matrices.
+  const bool useDiagonal = diagonalScaling || !preconditioner.is_empty();
+  if (useDiagonal && (compactRepresentation || IsCootType<BaseMatType>::value))
+  {
+    throw std::invalid_argument("L_BFGS::Optimize(): the diagonal scaling and "
+        "the preconditioner are not available with the compact representation "
+        "or with Bandicoot matrices!");
+  }
+
+  // The reduced precision pairs are only used by the two-loop recursion with
+  // the scalar initial approximation, with Armadillo matrices.
+  const bool reduced = (historyPrecision != FullPrecision);
+  if (reduced && (compactRepresentation || useDiagonal ||
+      IsCootType<BaseMatType>::value))
+  {
+    throw std::invalid_argument("L_BFGS::Optimize(): the reduced precision "
+        "history is not available with the compact representation, the "
+        "diagonal scaling or the preconditioner, or with Bandicoot matrices!");
+  }
+
+  if (!preconditioner.is_empty())
+  {
+    if (preconditioner.n_rows != rows || preconditioner.n_cols != cols)
+    {
+      std::ostringstream oss;
+      oss << "L_BFGS::Optimize(): the preconditioner has size "
+          << preconditioner.n_rows << "x" << preconditioner.n_cols
+          << ", but the iterate has size " << rows << "x" << cols << "!";
+      throw std::invalid_argument(oss.str());
+    }
+
+    for (size_t i = 0; i < preconditioner.n_elem; ++i)
+    {
+      if (!(preconditioner[i] > 0))
+      {
+        throw std::invalid_argument("L_BFGS::Optimize(): the elements of the "
+            "preconditioner must be positive!");
+      }
+    }
+  }
+
+  // The temporaries are taken from the given workspace, or else from a local
+  // one.
+  ens::Workspace localWorkspace;
+  ens::Workspace& ws = (workspace != NULL) ? *workspace : localWorkspace;
+
+  BaseMatType& newIterateTmp = ws.Get<BaseMatType>(0);
+  newIterateTmp.set_size(rows, cols);
+
+  // For the two-loop recursion, the differences of the iterates and of the
+  // gradients, the inverse curvature of each stored pair, and the workspace of
+  // the recursion.  All are indexed by iteration % numBasis, and are allocated
+  // once here so that the iterations do not allocate.
+  CubeType& s = ws.Get<CubeType>(1);
+  CubeType& y = ws.Get<CubeType>(2);
+  arma::Col<ElemType>& rho = ws.Get<arma::Col<ElemType>>(3);
+  arma::Col<ElemType>& alpha = ws.Get<arma::Col<ElemType>>(4);
+
+  // For the compact representation, both differences of each pair stored in
+  // one cube (s_i in slice 2i, y_i in slice 2i + 1) and their inner products.
+  CubeType& pairs = ws.Get<CubeType>(5);
+  arma::Mat<ElemType>& products = ws.Get<arma::Mat<ElemType>>(6);
+
+  if (compactRepresentation)
+  {
+    pairs.zeros(rows, cols, 2 * numBasis);
+    products.zeros(2 * numBasis, 2 * numBasis);
+  }
+  else if (reduced)
+  {
+    rho.set_size(numBasis);
+    alpha.set_size(numBasis);
+  }
+  else
+  {
+    s.set_size(rows, cols, numBasis);
+    y.set_size(rows, cols, numBasis);
+    rho.set_size(numBasis);
+    alpha.set_size(numBasis);
+  }
+
+  // The number of pairs stored so far (the position of the next one is
+  // numPairs % numBasis).  When warm-starting, continue from the pairs kept
+  // by the last call, if they fit this iterate.
+  size_t numPairs = 0;
+  if (!resetHistory && historySize > 0)
+  {
+    if (compactRepresentation && historyPairs.n_rows == rows &&
+        historyPairs.n_cols == cols && historyPairs.n_slices == 2 * numBasis)
+    {
+      RestoreHistory(pairs, historyPairs);
+      products = arma::conv_to<arma::Mat<ElemType>>::from(historyProducts);
+      numPairs = historySize;
+    }
+    else if (reduced && reducedPairs.Rows() == rows &&
+        reducedPairs.Cols() == cols && reducedPairs.NumPairs() == numBasis &&
+        reducedPairs.BFloat16() == (historyPrecision == BFloat16Precision))
+    {
+      rho = arma::conv_to<arma::Col<ElemType>>::from(historyRho);
+      numPairs = historySize;
+    }
+    else if (!compactRepresentation && !reduced && historyS.n_rows == rows &&
+        historyS.n_cols == cols && historyS.n_slices == numBasis)
+    {
+      RestoreHistory(s, historyS);
+      RestoreHistory(y, historyY);
+      rho = arma::conv_to<arma::Col<ElemType>>::from(historyRho);
+      numPairs = historySize;
+    }
+  }
+
+  // Unless they are continued, the reduced precision pairs start from zero;
+  // the memory of the kept pairs is reused.
+  if (reduced && numPairs == 0)
+  {
+    reducedPairs.Reset(numBasis, rows, cols,
+        historyPrecision == BFloat16Precision);
+  }
+
+  // For the diagonal initial inverse Hessian approximation, the diagonal, the
+  // preconditioner (or ones) and the sums of s_i % y_i and y_i % y_i over the
+  // stored pairs.
+  BaseMatType& diagonal = ws.Get<BaseMatType>(15);
+  BaseMatType& base = ws.Get<BaseMatType>(16);
+  BaseMatType& sy = ws.Get<BaseMatType>(17);
+  BaseMatType& yy = ws.Get<BaseMatType>(18);
+  diagonal.reset();
+  if (useDiagonal)
+  {
+    if (preconditioner.is_empty())
+      base.ones(rows, cols);
+    else
+      RestoreHistory(base, preconditioner);
+  }
+
+  if (diagonalScaling)
+  {
+    sy.zeros(rows, cols);
+    yy.zeros(rows, cols);
+    for (size_t i = 0; i < std::min(numPairs, numBasis); ++i)
+    {
+      sy += s.slice(i) % y.slice(i);
+      yy += square(y.slice(i));
+    }
+  }
+
+  // The points, gradients, step sizes and objectives used by the parallel line
+  // search.
+  std::vector<BaseMatType>& trialIterates =
+      ws.Get<std::vector<BaseMatType>>(7);
+  std::vector<BaseGradType>& trialGradients =
+      ws.Get<std::vector<BaseGradType>>(8);
+  arma::vec& trialSteps = ws.Get<arma::vec>(9);
+  arma::Col<ElemType>& trialObjectives = ws.Get<arma::Col<ElemType>>(10);
+  if (numLineSearchCandidates > 1)
+  {
+    trialIterates.resize(numLineSearchCandidates);
+    trialGradients.resize(numLineSearchCandidates);
+    for (size_t i = 0; i < numLineSearchCandidates; ++i)
+    {
+      trialIterates[i].set_size(rows, cols);
+      trialGradients[i].set_size(rows, cols);
+    }
+    trialSteps.set_size(numLineSearchCandidates);
+    trialObjectives.set_size(numLineSearchCandidates);
+  }
 
   // The old iterate to be saved.
-  arma::mat oldIterate;
+  BaseMatType& oldIterate = ws.Get<BaseMatType>(11);
   oldIterate.zeros(iterate.n_rows, iterate.n_cols);
 
   // Whether to optimize until convergence.
   bool optimizeUntilConvergence = (maxIterations == 0);
 
   // The gradient: the current and the old.
-  arma::mat gradient(iterate.n_rows, iterate.n_cols, arma::fill::zeros);
-  arma::mat oldGradient(iterate.n_rows, iterate.n_cols, arma::fill::zeros);
+  BaseGradType& gradient = ws.Get<BaseGradType>(12);
+  BaseGradType& oldGradient = ws.Get<BaseGradType>(13);
+  gradient.zeros(iterate.n_rows, iterate.n_cols);
+  oldGradient.zeros(iterate.n_rows, iterate.n_cols);
 
   // The search direction.
-  arma::mat searchDirection(iterate.n_rows, iterate.n_cols, arma::fill::zeros);
+  BaseMatType& searchDirection = ws.Get<BaseMatType>(14);
+  searchDirection.zeros(iterate.n_rows, iterate.n_cols);
+
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+  terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
 
   // The initial function value and gradient.
-  double functionValue = f.EvaluateWithGradient(iterate, gradient);
-  double prevFunctionValue = functionValue;
+  ElemType functionValue;
+  {
+    ENS_PROFILE_SCOPE("EvaluateWithGradient");
+    functionValue = f.EvaluateWithGradient(iterate, gradient);
+  }
+  ElemType prevFunctionValue = functionValue;
+
+  terminate |= Callback::EvaluateWithGradient(*this, f, iterate, functionValue,
+      gradient, callbacks...);
 
   // The main optimization loop.
-  for (size_t itNum = 0; optimizeUntilConvergence || (itNum != maxIterations);
-       ++itNum)
+  for (size_t itNum = 0; (optimizeUntilConvergence ||
+      (itNum != maxIterations)) && !terminate; ++itNum)
   {
     prevFunctionValue = functionValue;
 
@@ -344,7 +1161,7 @@ double L_BFGS::Optimize(FunctionType& function, arma::mat& iterate)
     //
     // But don't do this on the first iteration to ensure we always take at
     // least one descent step.
-    if (itNum > 0 && (arma::norm(gradient, 2) < minGradientNorm))
+    if (itNum > 0 && (norm(gradient, 2) < minGradientNorm))
     {
       Warn << "L-BFGS gradient norm too small (terminating successfully)."
           << std::endl;
@@ -360,27 +1177,98 @@ double L_BFGS::Optimize(FunctionType& function, arma::mat& iterate)
       break;
     }
 
-    // Choose the scaling factor.
-    double scalingFactor = ChooseScalingFactor(itNum, gradient, s, y);
-
     // Build an approximation to the Hessian and choose the search
     // direction for the current iteration.
-    SearchDirection(gradient, itNum, scalingFactor, s, y, searchDirection);
+    if (compactRepresentation)
+    {
+      ENS_PROFILE_SCOPE("SearchDirection");
+      CompactSearchDirection(gradient, numPairs, pairs, products,
+          searchDirection);
+    }
+    else if (reduced)
+    {
+      ENS_PROFILE_SCOPE("SearchDirection");
+      ReducedSearchDirection(gradient, numPairs, rho, alpha, searchDirection);
+    }
+    else
+    {
+      ENS_PROFILE_SCOPE("SearchDirection");
+
+      // Choose the scaling factor, or the diagonal.
+      double scalingFactor = 1.0;
+      if (useDiagonal)
+      {
+        ChooseDiagonalScaling(numPairs, gradient, y, rho, base, sy, yy,
+            diagonal);
+      }
+      else
+      {
+        scalingFactor = ChooseScalingFactor(numPairs, gradient, y, rho);
+      }
+
+      SearchDirection(gradient, numPairs, scalingFactor, diagonal, s, y, rho,
+          alpha, searchDirection);
+    }
 
     // Save the old iterate and the gradient before stepping.
     oldIterate = iterate;
     oldGradient = gradient;
 
-    if (!LineSearch(f, functionValue, iterate, gradient, newIterateTmp,
-        searchDirection))
+    bool lineSearchSucceeded;
+    {
+      ENS_PROFILE_SCOPE("LineSearch");
+      lineSearchSucceeded = (numLineSearchCandidates > 1) ?
+          ParallelLineSearch(f, functionValue, iterate, gradient,
+              trialIterates, trialGradients, trialSteps, trialObjectives,
+              searchDirection) :
+          LineSearch(f, functionValue, iterate, gradient, newIterateTmp,
+              searchDirection);
+    }
+    if (!lineSearchSucceeded)
     {
       Warn << "Line search failed.  Stopping optimization." << std::endl;
       break; // The line search failed; nothing else to try.
     }
 
+    terminate |= Callback::EvaluateWithGradient(*this, f, iterate,
+        functionValue, gradient, callbacks...);
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+
+    // Overwrite an old basis set.  If we terminate below, the new pair is
+    // simply never used.
+    const size_t pos = numPairs % numBasis;
+    if (compactRepresentation)
+    {
+      UpdateCompactBasisSet(numPairs, iterate, oldIterate, gradient,
+          oldGradient, pairs, products);
+    }
+    else if (reduced)
+    {
+      UpdateReducedBasisSet(numPairs, iterate, oldIterate, gradient,
+          oldGradient, rho);
+    }
+    else
+    {
+      if (diagonalScaling)
+        UpdateCurvatureSums(numPairs, false, s, y, sy, yy);
+      UpdateBasisSet(numPairs, iterate, oldIterate, gradient, oldGradient, s,
+          y, rho);
+      if (diagonalScaling)
+        UpdateCurvatureSums(numPairs, true, s, y, sy, yy);
+    }
+    ++numPairs;
+
     // It is possible that the difference between the two coordinates is zero.
-    // In this case we terminate successfully.
-    if (accu(iterate != oldIterate) == 0)
+    // In this case we terminate successfully.  (Summing the absolute step
+    // avoids the temporary that a comparison of the iterates would need.)
+    ElemType stepSum;
+    if (compactRepresentation)
+      stepSum = accu(abs(pairs.slice(2 * pos)));
+    else if (reduced)
+      stepSum = reducedPairs.AbsSum(2 * pos, minChunkSize);
+    else
+      stepSum = accu(abs(s.slice(pos)));
+    if (stepSum == 0)
     {
       Info << "L-BFGS step size of 0 (terminating successfully)."
           << std::endl;
@@ -389,19 +1277,47 @@ double L_BFGS::Optimize(FunctionType& function, arma::mat& iterate)
 
     // If we can't make progress on the gradient, then we'll also accept
     // a stable function value.
-    const double denom = std::max(
-        std::max(fabs(prevFunctionValue), fabs(functionValue)), 1.0);
+    const ElemType denom = std::max(
+        std::max(std::abs(prevFunctionValue), std::abs(functionValue)),
+        (ElemType) 1.0);
     if ((prevFunctionValue - functionValue) / denom <= factr)
     {
       Info << "L-BFGS function value stable (terminating successfully)."
           << std::endl;
       break;
     }
-
-    // Overwrite an old basis set.
-    UpdateBasisSet(itNum, iterate, oldIterate, gradient, oldGradient, s, y);
   } // End of the optimization loop.
 
+  // Keep the pairs, in case the next call is warm-started.
+  if (compactRepresentation)
+  {
+    historyS.reset();
+    historyY.reset();
+    historyRho.reset();
+    reducedPairs.Clear();
+    KeepHistory(historyPairs, pairs);
+    KeepHistory(historyProducts, products);
+  }
+  else if (reduced)
+  {
+    historyS.reset();
+    historyY.reset();
+    historyPairs.reset();
+    historyProducts.reset();
+    KeepHistory(historyRho, rho);
+  }
+  else
+  {
+    historyPairs.reset();
+    historyProducts.reset();
+    reducedPairs.Clear();
+    KeepHistory(historyS, s);
+    KeepHistory(historyY, y);
+    KeepHistory(historyRho, rho);
+  }
+  historySize = numPairs;
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
   return functionValue;
 }
 
@@ -0,0 +1,379 @@
+/**
+ * @file reduced_precision_pairs.hpp
+ *
+ * Storage of the pairs of the L-BFGS two-loop recursion in reduced precision,
+ * with the dot products and vector updates of the recursion computed in double
+ * precision.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LBFGS_REDUCED_PRECISION_PAIRS_HPP
+#define ENSMALLEN_LBFGS_REDUCED_PRECISION_PAIRS_HPP
+
+#include <vector>
+
+#include <ensmallen_bits/utility/reduced_precision_state.hpp>
+
+namespace ens {
+
+/**
+ * ReducedPrecisionPairs stores the s and y vectors of the pairs of L_BFGS as
+ * floats or as bfloat16s (see Float32State and BFloat16State): vector 2i holds
+ * s_i and vector 2i + 1 holds y_i.  For double-precision iterates, this halves
+ * or quarters the memory of the history, and the passes of the two-loop
+ * recursion over it read that much less memory.
+ *
+ * The kernels decode one block of a stored vector at a time and compute in
+ * double precision, so only the rounding of the stored vectors affects the
+ * search direction.  Like the kernels of parallel_kernels.hpp, they split large
+ * vectors over the threads of the default executor, in chunks of whole blocks.
+ * They are only available for dense Armadillo matrices.
+ */
+class ReducedPrecisionPairs
+{
+ public:
+  //! Create an empty history.
+  ReducedPrecisionPairs() : bfloat16(false), numPairs(0), rows(0), cols(0)
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * Allocate the given number of pairs of vectors with the given shape, all
+   * zero.
+   *
+   * @param numPairs Number of pairs to store.
+   * @param rows Number of rows of each vector.
+   * @param cols Number of columns of each vector.
+   * @param bfloat16 Whether to store bfloat16s (otherwise, floats).
+   */
+  void Reset(const size_t numPairs,
+             const size_t rows,
+             const size_t cols,
+             const bool bfloat16)
+  {
+    this->bfloat16 = bfloat16;
+    this->numPairs = numPairs;
+    this->rows = rows;
+    this->cols = cols;
+
+    // Only the states of the chosen precision hold memory.
+    floatStates.resize(bfloat16 ? 0 : 2 * numPairs);
+    bfloat16States.resize(bfloat16 ? 2 * numPairs : 0);
+    for (size_t i = 0; i < floatStates.size(); ++i)
+      floatStates[i].Zeros(rows * cols);
+    for (size_t i = 0; i < bfloat16States.size(); ++i)
+      bfloat16States[i].Zeros(rows * cols);
+  }
+
+  //! Free the stored pairs.
+  void Clear()
+  {
+    std::vector<Float32State>().swap(floatStates);
+    std::vector<BFloat16State>().swap(bfloat16States);
+    numPairs = 0;
+    rows = 0;
+    cols = 0;
+  }
+
+  //! Get whether the vectors are stored as bfloat16s.
+  bool BFloat16() const { return bfloat16; }
+  //! Get the number of pairs.
+  size_t NumPairs() const { return numPairs; }
+  //! Get the number of rows of each vector.
+  size_t Rows() const { return rows; }
+  //! Get the number of columns of each vector.
+  size_t Cols() const { return cols; }
+
+  //! Get the number of bytes used by the stored pairs.
+  size_t Bytes() const { return BytesFor(numPairs, rows * cols, bfloat16); }
+
+  //! Get the number of bytes that the given number of pairs of vectors with n
+  //! elements use.
+  static size_t BytesFor(const size_t numPairs,
+                         const size_t n,
+                         const bool bfloat16)
+  {
+    return 2 * numPairs * (bfloat16 ? BFloat16State::BytesFor(n) :
+        Float32State::BytesFor(n));
+  }
+
+  /**
+   * Store a - b as the given vector.
+   *
+   * @param vector Index of the vector (2i for s_i, 2i + 1 for y_i).
+   * @param a First matrix.
+   * @param b Matrix to subtract, with as many elements as a.
+   * @param minChunkSize Minimum number of elements in a chunk (see
+   *     ParallelChunkCount()).
+   */
+  template<typename eT>
+  void Store(const size_t vector,
+             const arma::Mat<eT>& a,
+             const arma::Mat<eT>& b,
+             const size_t minChunkSize)
+  {
+    if (bfloat16)
+      StoreDifference(bfloat16States[vector], a.memptr(), b.memptr(),
+          minChunkSize);
+    else
+      StoreDifference(floatStates[vector], a.memptr(), b.memptr(),
+          minChunkSize);
+  }
+
+  //! Reduced precision pairs are only available for dense Armadillo matrices.
+  template<typename MatType>
+  void Store(const size_t /* vector */,
+             const MatType& /* a */,
+             const MatType& /* b */,
+             const size_t /* minChunkSize */)
+  {
+    throw std::logic_error("ReducedPrecisionPairs::Store(): only available "
+        "for dense Armadillo matrices!");
+  }
+
+  /**
+   * Compute the dot product of the given vector and a matrix, in double
+   * precision.
+   *
+   * @param vector Index of the vector (2i for s_i, 2i + 1 for y_i).
+   * @param x Matrix with as many elements as the vector.
+   * @param minChunkSize Minimum number of elements in a chunk.
+   */
+  template<typename eT>
+  double Dot(const size_t vector,
+             const arma::Mat<eT>& x,
+             const size_t minChunkSize) const
+  {
+    return bfloat16 ?
+        DotProduct(bfloat16States[vector], x.memptr(), minChunkSize) :
+        DotProduct(floatStates[vector], x.memptr(), minChunkSize);
+  }
+
+  //! Reduced precision pairs are only available for dense Armadillo matrices.
+  template<typename MatType>
+  double Dot(const size_t /* vector */,
+             const MatType& /* x */,
+             const size_t /* minChunkSize */) const
+  {
+    throw std::logic_error("ReducedPrecisionPairs::Dot(): only available for "
+        "dense Armadillo matrices!");
+  }
+
+  /**
+   * Compute the dot product of two of the stored vectors, in double precision.
+   *
+   * @param a Index of the first vector.
+   * @param b Index of the second vector.
+   * @param minChunkSize Minimum number of elements in a chunk.
+   */
+  double Dot(const size_t a, const size_t b, const size_t minChunkSize) const
+  {
+    return bfloat16 ?
+        DotProduct(bfloat16States[a], bfloat16States[b], minChunkSize) :
+        DotProduct(floatStates[a], floatStates[b], minChunkSize);
+  }
+
+  /**
+   * Add alpha times the given vector to a matrix.
+   *
+   * @param alpha Scalar to multiply the vector by.
+   * @param vector Index of the vector (2i for s_i, 2i + 1 for y_i).
+   * @param x Matrix to update, with as many elements as the vector.
+   * @param minChunkSize Minimum number of elements in a chunk.
+   */
+  template<typename eT>
+  void Axpy(const double alpha,
+            const size_t vector,
+            arma::Mat<eT>& x,
+            const size_t minChunkSize) const
+  {
+    if (bfloat16)
+      AddScaled(alpha, bfloat16States[vector], x.memptr(), minChunkSize);
+    else
+      AddScaled(alpha, floatStates[vector], x.memptr(), minChunkSize);
+  }
+
+  //! Reduced precision pairs are only available for dense Armadillo matrices.
+  template<typename MatType>
+  void Axpy(const double /* alpha */,
+            const size_t /* vector */,
+            MatType& /* x */,
+            const size_t /* minChunkSize */) const
+  {
+    throw std::logic_error("ReducedPrecisionPairs::Axpy(): only available for "
+        "dense Armadillo matrices!");
+  }
+
+  /**
+   * Compute the sum of the absolute values of the given vector.
+   *
+   * @param vector Index of the vector (2i for s_i, 2i + 1 for y_i).
+   * @param minChunkSize Minimum number of elements in a chunk.
+   */
+  double AbsSum(const size_t vector, const size_t minChunkSize) const
+  {
+    return bfloat16 ? AbsoluteSum(bfloat16States[vector], minChunkSize) :
+        AbsoluteSum(floatStates[vector], minChunkSize);
+  }
+
+ private:
+  /**
+   * Call task(begin, end) for each chunk of whole blocks of the vectors, on the
+   * threads of the default executor if there is more than one chunk, and
+   * return the sum of the results.
+   */
+  template<typename StateType, typename TaskType>
+  double ForEachChunk(const size_t minChunkSize, TaskType&& task) const
+  {
+    const size_t n = rows * cols;
+    const size_t blockSize = StateType::BlockSize();
+    const size_t blocks = (n + blockSize - 1) / blockSize;
+    const size_t chunks = std::min(ParallelChunkCount(n, minChunkSize),
+        std::max(blocks, (size_t) 1));
+
+    auto chunkTask = [&](const size_t c) -> double
+    {
+      const size_t begin = ((c * blocks) / chunks) * blockSize;
+      const size_t end = std::min(n, (((c + 1) * blocks) / chunks) *
+          blockSize);
+      return task(begin, end);
+    };
+
+    if (chunks == 1)
+      return chunkTask(0);
+
+    return DefaultExecutor().ParallelSum<double>(chunks, chunkTask);
+  }
+
+  //! Store a - b in the given state.
+  template<typename StateType, typename eT>
+  void StoreDifference(StateType& state,
+                       const eT* a,
+                       const eT* b,
+                       const size_t minChunkSize)
+  {
+    ForEachChunk<StateType>(minChunkSize,
+        [&](const size_t begin, const size_t end) -> double
+    {
+      std::vector<float> values(StateType::BlockSize());
+      for (size_t i = begin; i < end; i += values.size())
+      {
+        const size_t count = std::min(values.size(), end - i);
+        for (size_t j = 0; j < count; ++j)
+          values[j] = float(a[i + j] - b[i + j]);
+        state.Encode(i, count, values.data());
+      }
+      return 0.0;
+    });
+  }
+
+  //! Compute the dot product of the given state and memory.
+  template<typename StateType, typename eT>
+  double DotProduct(const StateType& state,
+                    const eT* x,
+                    const size_t minChunkSize) const
+  {
+    return ForEachChunk<StateType>(minChunkSize,
+        [&](const size_t begin, const size_t end) -> double
+    {
+      std::vector<float> values(StateType::BlockSize());
+      double sum = 0.0;
+      for (size_t i = begin; i < end; i += values.size())
+      {
+        const size_t count = std::min(values.size(), end - i);
+        state.Decode(i, count, values.data());
+        for (size_t j = 0; j < count; ++j)
+          sum += double(values[j]) * double(x[i + j]);
+      }
+      return sum;
+    });
+  }
+
+  //! Compute the dot product of two states.
+  template<typename StateType>
+  double DotProduct(const StateType& a,
+                    const StateType& b,
+                    const size_t minChunkSize) const
+  {
+    return ForEachChunk<StateType>(minChunkSize,
+        [&](const size_t begin, const size_t end) -> double
+    {
+      std::vector<float> aValues(StateType::BlockSize());
+      std::vector<float> bValues(StateType::BlockSize());
+      double sum = 0.0;
+      for (size_t i = begin; i < end; i += aValues.size())
+      {
+        const size_t count = std::min(aValues.size(), end - i);
+        a.Decode(i, count, aValues.data());
+        b.Decode(i, count, bValues.data());
+        for (size_t j = 0; j < count; ++j)
+          sum += double(aValues[j]) * double(bValues[j]);
+      }
+      return sum;
+    });
+  }
+
+  //! Add alpha times the given state to memory.
+  template<typename StateType, typename eT>
+  void AddScaled(const double alpha,
+                 const StateType& state,
+                 eT* x,
+                 const size_t minChunkSize) const
+  {
+    ForEachChunk<StateType>(minChunkSize,
+        [&](const size_t begin, const size_t end) -> double
+    {
+      std::vector<float> values(StateType::BlockSize());
+      for (size_t i = begin; i < end; i += values.size())
+      {
+        const size_t count = std::min(values.size(), end - i);
+        state.Decode(i, count, values.data());
+        for (size_t j = 0; j < count; ++j)
+          x[i + j] = eT(double(x[i + j]) + alpha * double(values[j]));
+      }
+      return 0.0;
+    });
+  }
+
+  //! Compute the sum of the absolute values of the given state.
+  template<typename StateType>
+  double AbsoluteSum(const StateType& state, const size_t minChunkSize) const
+  {
+    return ForEachChunk<StateType>(minChunkSize,
+        [&](const size_t begin, const size_t end) -> double
+    {
+      std::vector<float> values(StateType::BlockSize());
+      double sum = 0.0;
+      for (size_t i = begin; i < end; i += values.size())
+      {
+        const size_t count = std::min(values.size(), end - i);
+        state.Decode(i, count, values.data());
+        for (size_t j = 0; j < count; ++j)
+          sum += std::abs(double(values[j]));
+      }
+      return sum;
+    });
+  }
+
+  //! Whether the vectors are stored as bfloat16s.
+  bool bfloat16;
+  //! The number of pairs.
+  size_t numPairs;
+  //! The number of rows of each vector.
+  size_t rows;
+  //! The number of columns of each vector.
+  size_t cols;
+
+  //! The vectors, if they are stored as floats.
+  std::vector<Float32State> floatStates;
+  //! The vectors, if they are stored as bfloat16s.
+  std::vector<BFloat16State> bfloat16States;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,230 @@
+/**
+ * @file local_sgd.hpp
+ *
+ * Local SGD: several workers run SGD independently, and their models are
+ * averaged periodically.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LOCAL_SGD_LOCAL_SGD_HPP
+#define ENSMALLEN_LOCAL_SGD_LOCAL_SGD_HPP
+
+#include <ensmallen_bits/sgd/sgd.hpp>
+#include <ensmallen_bits/distributed_sgd/communicators/local_communicator.hpp>
+#include <ensmallen_bits/distributed_sgd/communicators/mpi_communicator.hpp>
+
+namespace ens {
+
+/**
+ * Local SGD (also known as periodic model averaging) splits the functions
+ * into one contiguous range per worker.  Each worker runs SGD on its own copy
+ * of the model, with its own instance of the update and decay policies, for
+ * averagingInterval steps; then the models of all the workers are averaged,
+ * and every worker continues from the average.  So the workers only
+ * synchronize once every averagingInterval steps, instead of at every step
+ * (as DistributedSGD does) or at every coordinate (as ParallelSGD does).
+ *
+ * The workers of a process are OpenMP threads (or run one after the other,
+ * when OpenMP is not used), so the function must allow concurrent calls to
+ * EvaluateWithGradient() with different iterates.  The workers of several
+ * processes can be combined with a communicator (see ens::MPICommunicator);
+ * then each process holds a shard of the data, as with DistributedSGD, and
+ * all the models of all the processes are averaged.
+ *
+ * An epoch lasts as many steps as the largest range of functions needs, and the
+ * models are always averaged at the end of an epoch.  The objective of an
+ * epoch is the sum of the batch objectives of all the workers.  Callbacks see
+ * the averaged model: StepTaken() is called after each averaging.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{stich2019local,
+ *   title     = {Local {SGD} Converges Fast and Communicates Little},
+ *   author    = {Stich, Sebastian U.},
+ *   booktitle = {International Conference on Learning Representations},
+ *   year      = {2019}
+ * }
+ * @endcode
+ *
+ * LocalSGD can optimize differentiable separable functions.
+ *
+ * @tparam UpdatePolicyType Update policy used by each worker (see
+ *     ens::VanillaUpdate).
+ * @tparam DecayPolicyType Decay policy used by each worker to adjust its step
+ *     size (see ens::NoDecay).
+ * @tparam CommunicatorType Communicator used to average the models of several
+ *     processes (see ens::LocalCommunicator for the interface).
+ */
+template<typename UpdatePolicyType = VanillaUpdate,
+         typename DecayPolicyType = NoDecay,
+         typename CommunicatorType = LocalCommunicator>
+class LocalSGD
+{
+ public:
+  /**
+   * Construct the LocalSGD optimizer with the given parameters.  The maximum
+   * number of iterations refers to the number of functions visited by all the
+   * workers; it is shared evenly between the workers, so it may be exceeded by
+   * less than the number of workers.
+   *
+   * @param stepSize Step size for each iteration.
+   * @param batchSize Batch size of each worker.
+   * @param averagingInterval Number of steps of each worker between two
+   *     averagings of the models.
+   * @param workers Number of workers in each process (0 means the maximum
+   *     number of OpenMP threads).
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *     limit).
+   * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param shuffle If true, the functions are shuffled at each epoch.
+   * @param updatePolicy Instantiated update policy used to adjust the given
+   *     parameters.
+   * @param decayPolicy Instantiated decay policy used to adjust the step size.
+   * @param resetPolicy Flag that determines whether update policy parameters
+   *     are reset before every Optimize call.
+   * @param communicator Communicator between the processes.
+   */
+  LocalSGD(const double stepSize = 0.01,
+           const size_t batchSize = 32,
+           const size_t averagingInterval = 16,
+           const size_t workers = 0,
+           const size_t maxIterations = 100000,
+           const double tolerance = 1e-5,
+           const bool shuffle = true,
+           const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
+           const DecayPolicyType& decayPolicy = DecayPolicyType(),
+           const bool resetPolicy = true,
+           const CommunicatorType& communicator = CommunicatorType());
+
+  /**
+   * Optimize the given function.  The given starting point will be modified to
+   * store the finishing point of the algorithm (the average of the models),
+   * and the final objective value is returned.  With several processes, the
+   * starting point of the first one is used, and the objective is summed over
+   * all the processes.
+   *
+   * @tparam DecomposableFunctionType Type of the function to optimize.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename DecomposableFunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(DecomposableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks);
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the batch size of each worker.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size of each worker.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the number of steps between two averagings.
+  size_t AveragingInterval() const { return averagingInterval; }
+  //! Modify the number of steps between two averagings.
+  size_t& AveragingInterval() { return averagingInterval; }
+
+  //! Get the number of workers (0 means the maximum number of threads).
+  size_t Workers() const { return workers; }
+  //! Modify the number of workers (0 means the maximum number of threads).
+  size_t& Workers() { return workers; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the individual functions are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the individual functions are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+  //! Get whether or not the update policy parameters
+  //! are reset before Optimize call.
+  bool ResetPolicy() const { return resetPolicy; }
+  //! Modify whether or not the update policy parameters
+  //! are reset before Optimize call.
+  bool& ResetPolicy() { return resetPolicy; }
+
+  //! Get the update policy.
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  //! Modify the update policy.
+  UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
+
+  //! Get the step size decay policy.
+  const DecayPolicyType& DecayPolicy() const { return decayPolicy; }
+  //! Modify the step size decay policy.
+  DecayPolicyType& DecayPolicy() { return decayPolicy; }
+
+  //! Get the communicator.
+  const CommunicatorType& Communicator() const { return communicator; }
+  //! Modify the communicator.
+  CommunicatorType& Communicator() { return communicator; }
+
+ private:
+  //! The step size for each example.
+  double stepSize;
+
+  //! The batch size of each worker.
+  size_t batchSize;
+
+  //! The number of steps between two averagings.
+  size_t averagingInterval;
+
+  //! The number of workers in each process.
+  size_t workers;
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the individual functions are shuffled when
+  //! iterating.
+  bool shuffle;
+
+  //! The update policy used to update the parameters in each iteration.
+  UpdatePolicyType updatePolicy;
+
+  //! The decay policy used to update the step size.
+  DecayPolicyType decayPolicy;
+
+  //! Flag indicating whether update policy
+  //! should be reset before running optimization.
+  bool resetPolicy;
+
+  //! The communicator between the processes.
+  CommunicatorType communicator;
+
+  //! The initialized update policies of the workers.  Their type depends on
+  //! the matrix type given to Optimize(), so they are held in an Any object.
+  Any instUpdatePolicies;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "local_sgd_impl.hpp"
+
+#endif
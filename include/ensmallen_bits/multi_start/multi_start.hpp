@@ -0,0 +1,205 @@
+/**
+ * @file multi_start.hpp
+ *
+ * A wrapper that runs independent copies of an optimizer from several random
+ * starting points and returns the best result.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_MULTI_START_MULTI_START_HPP
+#define ENSMALLEN_MULTI_START_MULTI_START_HPP
+
+namespace ens {
+
+/**
+ * MultiStart runs numStarts copies of the given optimizer on the same
+ * function.  The first one starts from the given point, and the others from
+ * points sampled uniformly in [lowerBound, upperBound] for every coordinate.
+ * The best final point is returned, and the distinct final points (those
+ * farther than minimaTolerance, in Frobenius norm, from every better one) are
+ * available through Minima() and MinimaObjectives(), sorted by objective.
+ *
+ * If parallelStarts is true (and OpenMP is enabled), the starts are run in
+ * parallel, each with its own copy of the optimizer; the function's
+ * Evaluate() (and whatever else the optimizer calls) must then be safe to call
+ * from multiple threads at once.  The starting points are sampled up front,
+ * so the set of starts does not depend on the number of threads.
+ *
+ * As soon as a start reaches an objective of at most targetObjective, the
+ * starts that are not running yet are skipped, and the running ones are asked
+ * to stop through a callback, if the optimizer accepts callbacks.
+ *
+ * @tparam OptimizerType Type of the optimizer to run from every start.
+ */
+template<typename OptimizerType>
+class MultiStart
+{
+ public:
+  /**
+   * Construct the MultiStart wrapper with the given optimizer and parameters.
+   *
+   * @param optimizer Optimizer to copy for every start.
+   * @param numStarts Number of starts (including the given starting point).
+   * @param lowerBound Lower bound of the random starting points.
+   * @param upperBound Upper bound of the random starting points.
+   * @param targetObjective Objective at which to stop starting new runs
+   *     (-DBL_MAX to run every start).
+   * @param minimaTolerance Distance below which two final points are
+   *     considered the same minimum.
+   * @param parallelStarts Whether to run the starts in parallel (requires
+   *     OpenMP and a thread-safe function).
+   */
+  MultiStart(const OptimizerType& optimizer = OptimizerType(),
+             const size_t numStarts = 10,
+             const double lowerBound = -1.0,
+             const double upperBound = 1.0,
+             const double targetObjective = -DBL_MAX,
+             const double minimaTolerance = 1e-3,
+             const bool parallelStarts = false);
+
+  /**
+   * Optimize the given function from every start, and store the best final
+   * point in iterate.
+   *
+   * @tparam FunctionType Type of the function to optimize.
+   * @tparam MatType Type of matrix to optimize with.
+   * @param function Function to optimize.
+   * @param iterate Starting point of the first start (will be modified).
+   * @return Objective value of the best final point.
+   */
+  template<typename FunctionType, typename MatType>
+  typename MatType::elem_type Optimize(FunctionType& function,
+                                       MatType& iterate);
+
+  //! Get the optimizer that is copied for every start.
+  const OptimizerType& Optimizer() const { return optimizer; }
+  //! Modify the optimizer that is copied for every start.
+  OptimizerType& Optimizer() { return optimizer; }
+
+  //! Get the number of starts.
+  size_t NumStarts() const { return numStarts; }
+  //! Modify the number of starts.
+  size_t& NumStarts() { return numStarts; }
+
+  //! Get the lower bound of the random starting points.
+  double LowerBound() const { return lowerBound; }
+  //! Modify the lower bound of the random starting points.
+  double& LowerBound() { return lowerBound; }
+
+  //! Get the upper bound of the random starting points.
+  double UpperBound() const { return upperBound; }
+  //! Modify the upper bound of the random starting points.
+  double& UpperBound() { return upperBound; }
+
+  //! Get the target objective.
+  double TargetObjective() const { return targetObjective; }
+  //! Modify the target objective.
+  double& TargetObjective() { return targetObjective; }
+
+  //! Get the distance below which two minima are the same.
+  double MinimaTolerance() const { return minimaTolerance; }
+  //! Modify the distance below which two minima are the same.
+  double& MinimaTolerance() { return minimaTolerance; }
+
+  //! Get whether the starts are run in parallel.
+  bool ParallelStarts() const { return parallelStarts; }
+  //! Modify whether the starts are run in parallel.
+  bool& ParallelStarts() { return parallelStarts; }
+
+  //! Get the distinct minima found by the last optimization, best first (one
+  //! slice per minimum).
+  const arma::cube& Minima() const { return minima; }
+
+  //! Get the objectives of the distinct minima.
+  const arma::vec& MinimaObjectives() const { return minimaObjectives; }
+
+  //! Get the number of starts that were run by the last optimization.
+  size_t StartsRun() const { return startsRun; }
+
+ private:
+  /**
+   * Callback that asks the optimizer to terminate once the target objective
+   * was reached by another start.
+   */
+  class CancelCallback
+  {
+   public:
+    //! Create the callback from the flag to watch.
+    CancelCallback(const std::atomic<bool>& cancelled) : cancelled(cancelled)
+    { /* Nothing to do. */ }
+
+    //! Terminate after a step, if cancelled.
+    template<typename... Ts>
+    bool StepTaken(Ts&... /* args */) { return cancelled; }
+
+    //! Terminate after an evaluation, if cancelled.
+    template<typename... Ts>
+    bool Evaluate(Ts&... /* args */) { return cancelled; }
+
+    //! Terminate after an evaluation, if cancelled.
+    template<typename... Ts>
+    bool EvaluateWithGradient(Ts&... /* args */) { return cancelled; }
+
+    //! Terminate after an epoch, if cancelled.
+    template<typename... Ts>
+    bool EndEpoch(Ts&... /* args */) { return cancelled; }
+
+   private:
+    //! Whether the target objective was reached.
+    const std::atomic<bool>& cancelled;
+  };
+
+  //! Run the optimizer with the cancel callback, if it accepts callbacks.
+  template<typename FunctionType, typename MatType>
+  static auto RunStart(OptimizerType& optimizer,
+                       FunctionType& function,
+                       MatType& iterate,
+                       CancelCallback& callback,
+                       int) ->
+      decltype(optimizer.Optimize(function, iterate, callback), void())
+  {
+    optimizer.Optimize(function, iterate, callback);
+  }
+
+  //! Run the optimizer without callbacks.
+  template<typename FunctionType, typename MatType>
+  static void RunStart(OptimizerType& optimizer,
+                       FunctionType& function,
+                       MatType& iterate,
+                       CancelCallback& /* callback */,
+                       long)
+  {
+    optimizer.Optimize(function, iterate);
+  }
+
+  //! The optimizer that is copied for every start.
+  OptimizerType optimizer;
+  //! Number of starts.
+  size_t numStarts;
+  //! Lower bound of the random starting points.
+  double lowerBound;
+  //! Upper bound of the random starting points.
+  double upperBound;
+  //! Objective at which to stop.
+  double targetObjective;
+  //! Distance below which two minima are the same.
+  double minimaTolerance;
+  //! Whether to run the starts in parallel.
+  bool parallelStarts;
+
+  //! The distinct minima found by the last optimization.
+  arma::cube minima;
+  //! The objectives of the distinct minima.
+  arma::vec minimaObjectives;
+  //! The number of starts run by the last optimization.
+  size_t startsRun;
+};
+
+} // namespace ens
+
+#include "multi_start_impl.hpp"
+
+#endif
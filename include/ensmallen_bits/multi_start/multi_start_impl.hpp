@@ -0,0 +1,129 @@
+/**
+ * @file multi_start_impl.hpp
+ *
+ * Implementation of the MultiStart wrapper.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_MULTI_START_MULTI_START_IMPL_HPP
+#define ENSMALLEN_MULTI_START_MULTI_START_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "multi_start.hpp"
+
+namespace ens {
+
+template<typename OptimizerType>
+MultiStart<OptimizerType>::MultiStart(const OptimizerType& optimizer,
+                                      const size_t numStarts,
+                                      const double lowerBound,
+                                      const double upperBound,
+                                      const double targetObjective,
+                                      const double minimaTolerance,
+                                      const bool parallelStarts) :
+    optimizer(optimizer),
+    numStarts(numStarts),
+    lowerBound(lowerBound),
+    upperBound(upperBound),
+    targetObjective(targetObjective),
+    minimaTolerance(minimaTolerance),
+    parallelStarts(parallelStarts),
+    startsRun(0)
+{
+  // Nothing to do.
+}
+
+template<typename OptimizerType>
+template<typename FunctionType, typename MatType>
+typename MatType::elem_type MultiStart<OptimizerType>::Optimize(
+    FunctionType& function,
+    MatType& iterate)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  if (numStarts == 0)
+  {
+    throw std::invalid_argument("MultiStart::Optimize(): numStarts must be "
+        "positive!");
+  }
+
+  // Sample all the starting points before running anything.
+  std::vector<MatType> points(numStarts, iterate);
+  for (size_t k = 1; k < numStarts; ++k)
+  {
+    points[k] = arma::conv_to<MatType>::from(lowerBound +
+        (upperBound - lowerBound) * arma::randu<arma::mat>(iterate.n_rows,
+        iterate.n_cols));
+  }
+
+  std::vector<double> objectives(numStarts);
+  std::vector<char> run(numStarts, 0);
+  std::atomic<bool> cancelled(false);
+
+  ParallelFor(numStarts, [&](const size_t k)
+  {
+    if (cancelled)
+      return;
+
+    OptimizerType startOptimizer(optimizer);
+    CancelCallback callback(cancelled);
+    RunStart(startOptimizer, function, points[k], callback, 0);
+
+    objectives[k] = function.Evaluate(points[k]);
+    run[k] = 1;
+    if (objectives[k] <= targetObjective)
+      cancelled = true;
+  }, parallelStarts);
+
+  // Sort the final points of the starts that were run by objective, and keep
+  // the ones that are not close to a better one.
+  std::vector<size_t> order;
+  for (size_t k = 0; k < numStarts; ++k)
+  {
+    if (run[k])
+      order.push_back(k);
+  }
+  std::stable_sort(order.begin(), order.end(),
+      [&objectives](const size_t lhs, const size_t rhs)
+      { return objectives[lhs] < objectives[rhs]; });
+  startsRun = order.size();
+
+  std::vector<size_t> distinct;
+  for (size_t k : order)
+  {
+    bool isNew = true;
+    for (size_t d : distinct)
+    {
+      if (arma::norm(arma::conv_to<arma::mat>::from(points[k] - points[d]),
+          "fro") <= minimaTolerance)
+      {
+        isNew = false;
+        break;
+      }
+    }
+
+    if (isNew)
+      distinct.push_back(k);
+  }
+
+  minima.set_size(iterate.n_rows, iterate.n_cols, distinct.size());
+  minimaObjectives.set_size(distinct.size());
+  for (size_t d = 0; d < distinct.size(); ++d)
+  {
+    minima.slice(d) = arma::conv_to<arma::mat>::from(points[distinct[d]]);
+    minimaObjectives(d) = objectives[distinct[d]];
+  }
+
+  Info << "MultiStart: ran " << startsRun << " of " << numStarts << " starts "
+      << "and found " << distinct.size() << " distinct minima." << std::endl;
+
+  iterate = points[order[0]];
+  return ElemType(objectives[order[0]]);
+}
+
+} // namespace ens
+
+#endif
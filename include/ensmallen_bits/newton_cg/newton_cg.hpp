@@ -0,0 +1,156 @@
+/**
+ * @file newton_cg.hpp
+ *
+ * Definition of the truncated Newton method (Newton-CG), which takes Newton
+ * steps computed inexactly with the conjugate gradient method from
+ * Hessian-vector products.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_NEWTON_CG_NEWTON_CG_HPP
+#define ENSMALLEN_NEWTON_CG_NEWTON_CG_HPP
+
+namespace ens {
+
+/**
+ * Newton-CG (the line search truncated Newton method) minimizes a twice
+ * differentiable function by approximately solving the Newton system
+ *
+ * \f[
+ * \nabla^2 f(x_k) p_k = -\nabla f(x_k)
+ * \f]
+ *
+ * at each iteration with the conjugate gradient method, and then searching
+ * along \f$ p_k \f$ with a backtracking (Armijo) line search.  The conjugate
+ * gradient iterations only need products of the Hessian with a direction, so
+ * the Hessian is never formed; the iterations stop once the residual is below
+ * \f$ \min(0.5, \sqrt{\|\nabla f(x_k)\|}) \|\nabla f(x_k)\| \f$ (which gives
+ * superlinear convergence close to the minimum), or as soon as a direction of
+ * negative curvature is found (in which case the current estimate, or the
+ * steepest descent direction on the first iteration, is used).
+ *
+ * The Hessian-vector products come from the function's HessianVectorProduct()
+ * method if it has one, and otherwise from a finite difference of two
+ * gradients (see HessianVectorProduct()).  For more information, see the
+ * following:
+ *
+ * @code
+ * @book{nocedal2006numerical,
+ *   title     = {Numerical Optimization},
+ *   author    = {Nocedal, Jorge and Wright, Stephen J.},
+ *   edition   = {2},
+ *   chapter   = {7.1},
+ *   publisher = {Springer},
+ *   year      = {2006}
+ * }
+ * @endcode
+ *
+ * NewtonCG can optimize differentiable functions.  For more details, see the
+ * documentation on function types included with this distribution or on the
+ * ensmallen website.
+ */
+class NewtonCG
+{
+ public:
+  /**
+   * Construct the Newton-CG optimizer with the given parameters.
+   *
+   * @param maxIterations Maximum number of Newton iterations allowed (0 means
+   *     no limit).
+   * @param maxCGIterations Maximum number of conjugate gradient iterations per
+   *     Newton iteration (0 means the number of coordinates).
+   * @param minGradientNorm Minimum gradient norm required to continue the
+   *     optimization.
+   * @param armijoConstant Controls the accuracy of the line search routine for
+   *     determining the Armijo condition.
+   * @param maxLineSearchTrials The maximum number of trials for the line
+   *     search.
+   */
+  NewtonCG(const size_t maxIterations = 1000,
+           const size_t maxCGIterations = 0,
+           const double minGradientNorm = 1e-6,
+           const double armijoConstant = 1e-4,
+           const size_t maxLineSearchTrials = 50);
+
+  /**
+   * Optimize the given function using Newton-CG.  The given starting point
+   * will be modified to store the finishing point of the algorithm, and the
+   * final objective value is returned.
+   *
+   * @tparam FunctionType Type of the function to optimize.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename FunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(FunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks);
+
+  //! Get the maximum number of Newton iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of Newton iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the maximum number of conjugate gradient iterations per Newton
+  //! iteration (0 means the number of coordinates).
+  size_t MaxCGIterations() const { return maxCGIterations; }
+  //! Modify the maximum number of conjugate gradient iterations per Newton
+  //! iteration (0 means the number of coordinates).
+  size_t& MaxCGIterations() { return maxCGIterations; }
+
+  //! Get the minimum gradient norm.
+  double MinGradientNorm() const { return minGradientNorm; }
+  //! Modify the minimum gradient norm.
+  double& MinGradientNorm() { return minGradientNorm; }
+
+  //! Get the Armijo condition constant.
+  double ArmijoConstant() const { return armijoConstant; }
+  //! Modify the Armijo condition constant.
+  double& ArmijoConstant() { return armijoConstant; }
+
+  //! Get the maximum number of line search trials.
+  size_t MaxLineSearchTrials() const { return maxLineSearchTrials; }
+  //! Modify the maximum number of line search trials.
+  size_t& MaxLineSearchTrials() { return maxLineSearchTrials; }
+
+  //! Get the workspace the temporaries are taken from (NULL if none).
+  ens::Workspace* Workspace() const { return workspace; }
+  //! Modify the workspace the temporaries are taken from (NULL if none).
+  ens::Workspace*& Workspace() { return workspace; }
+
+ private:
+  //! The maximum number of Newton iterations.
+  size_t maxIterations;
+
+  //! The maximum number of conjugate gradient iterations per Newton iteration.
+  size_t maxCGIterations;
+
+  //! The minimum gradient norm required to continue the optimization.
+  double minGradientNorm;
+
+  //! The Armijo condition constant.
+  double armijoConstant;
+
+  //! The maximum number of line search trials.
+  size_t maxLineSearchTrials;
+
+  //! The workspace the temporaries are taken from (NULL if none).
+  ens::Workspace* workspace;
+};
+
+} // namespace ens
+
+#include "newton_cg_impl.hpp"
+
+#endif
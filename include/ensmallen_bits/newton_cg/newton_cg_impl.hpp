@@ -0,0 +1,204 @@
+/**
+ * @file newton_cg_impl.hpp
+ *
+ * Implementation of the truncated Newton method (Newton-CG).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_NEWTON_CG_NEWTON_CG_IMPL_HPP
+#define ENSMALLEN_NEWTON_CG_NEWTON_CG_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "newton_cg.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+inline NewtonCG::NewtonCG(const size_t maxIterations,
+                          const size_t maxCGIterations,
+                          const double minGradientNorm,
+                          const double armijoConstant,
+                          const size_t maxLineSearchTrials) :
+    maxIterations(maxIterations),
+    maxCGIterations(maxCGIterations),
+    minGradientNorm(minGradientNorm),
+    armijoConstant(armijoConstant),
+    maxLineSearchTrials(maxLineSearchTrials),
+    workspace(NULL)
+{ /* Nothing to do. */ }
+
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename MatType::elem_type NewtonCG::Optimize(FunctionType& function,
+                                               MatType& iterateIn,
+                                               CallbackTypes&&... callbacks)
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+
+  // Use the Function<> wrapper type to provide additional functionality.
+  typedef Function<FunctionType, BaseMatType, BaseGradType> FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+  ENS_PROFILE_OPTIMIZE("NewtonCG");
+
+  // Make sure we have the methods that we need.
+  traits::CheckFunctionTypeAPI<FullFunctionType, BaseMatType, BaseGradType>();
+
+  // Vectors are optimized as matrices.
+  BaseMatType& iterate = static_cast<BaseMatType&>(iterateIn);
+
+  const size_t cgIterations = (maxCGIterations == 0) ? iterate.n_elem :
+      maxCGIterations;
+
+  // The temporaries are taken from the given workspace, or else from a local
+  // one.
+  ens::Workspace localWorkspace;
+  ens::Workspace& ws = (workspace != NULL) ? *workspace : localWorkspace;
+  BaseGradType& gradient = ws.Get<BaseGradType>(0);
+  BaseGradType& residual = ws.Get<BaseGradType>(1);
+  BaseGradType& product = ws.Get<BaseGradType>(2);
+  BaseMatType& step = ws.Get<BaseMatType>(3);
+  BaseMatType& direction = ws.Get<BaseMatType>(4);
+  BaseMatType& newIterate = ws.Get<BaseMatType>(5);
+  gradient.set_size(iterate.n_rows, iterate.n_cols);
+
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+  terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
+
+  ElemType objective = std::numeric_limits<ElemType>::max();
+  for (size_t i = 1; (maxIterations == 0 || i <= maxIterations) && !terminate;
+       ++i)
+  {
+    {
+      ENS_PROFILE_SCOPE("EvaluateWithGradient");
+      objective = f.EvaluateWithGradient(iterate, gradient);
+    }
+    terminate |= Callback::EvaluateWithGradient(*this, f, iterate, objective,
+        gradient, callbacks...);
+    if (terminate)
+      break;
+
+    Info << "Newton-CG: iteration " << i << ", objective " << objective
+        << ".\n";
+
+    if (std::isnan(objective) || std::isinf(objective))
+    {
+      Warn << "Newton-CG: objective diverged to " << objective << "; "
+          << "terminating with failure." << std::endl;
+      break;
+    }
+
+    const ElemType gradientNorm = norm(gradient);
+    if (gradientNorm < minGradientNorm)
+    {
+      Info << "Newton-CG: gradient norm (" << gradientNorm << ") is below the "
+          << "minimum (" << minGradientNorm << "); terminating optimization."
+          << std::endl;
+      break;
+    }
+
+    // Solve the Newton system approximately with the conjugate gradient
+    // method, starting from zero.
+    {
+      ENS_PROFILE_SCOPE("ConjugateGradient");
+      const ElemType forcing = std::min(ElemType(0.5),
+          ElemType(std::sqrt(gradientNorm))) * gradientNorm;
+      step.zeros(iterate.n_rows, iterate.n_cols);
+      residual = gradient;
+      direction = -residual;
+      ElemType residualSquared = gradientNorm * gradientNorm;
+      for (size_t j = 0; j < cgIterations; ++j)
+      {
+        HessianVectorProduct(function, iterate, gradient, direction, product);
+        const ElemType curvature = dot(direction, product);
+        if (curvature <= 0)
+        {
+          // The Hessian is not positive definite along this direction; fall
+          // back to steepest descent if no progress has been made yet.
+          if (j == 0)
+            step = -gradient;
+          break;
+        }
+
+        const ElemType alpha = residualSquared / curvature;
+        step += alpha * direction;
+        residual += alpha * product;
+        const ElemType newResidualSquared = dot(residual, residual);
+        if (std::sqrt(newResidualSquared) <= forcing)
+          break;
+
+        direction = (newResidualSquared / residualSquared) * direction -
+            residual;
+        residualSquared = newResidualSquared;
+      }
+    }
+
+    // The step is a descent direction unless the Hessian-vector products are
+    // too inaccurate; in that case, use steepest descent.
+    ElemType slope = dot(gradient, step);
+    if (!(slope < 0))
+    {
+      step = -gradient;
+      slope = -gradientNorm * gradientNorm;
+    }
+
+    // Backtrack from the full Newton step until the Armijo condition holds.
+    bool accepted = false;
+    ElemType newObjective = objective;
+    {
+      ENS_PROFILE_SCOPE("LineSearch");
+      ElemType stepLength = 1;
+      for (size_t t = 0; t < maxLineSearchTrials && !terminate; ++t)
+      {
+        newIterate = iterate + stepLength * step;
+        newObjective = f.Evaluate(newIterate);
+        terminate |= Callback::Evaluate(*this, f, newIterate, newObjective,
+            callbacks...);
+
+        if (newObjective <= objective + armijoConstant * stepLength * slope)
+        {
+          accepted = true;
+          break;
+        }
+
+        stepLength *= 0.5;
+      }
+    }
+
+    if (!accepted)
+    {
+      if (!terminate)
+      {
+        Warn << "Newton-CG: line search failed; terminating optimization."
+            << std::endl;
+      }
+      break;
+    }
+
+    iterate = newIterate;
+    objective = newObjective;
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+
+    if (i == maxIterations)
+    {
+      Info << "Newton-CG: maximum iterations (" << maxIterations << ") "
+          << "reached; terminating optimization." << std::endl;
+    }
+  }
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+  return objective;
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,235 @@
+/**
+ * @file olbfgs.hpp
+ *
+ * Definition of online L-BFGS (oLBFGS), a stochastic limited-memory
+ * quasi-Newton method for separable functions.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_OLBFGS_OLBFGS_HPP
+#define ENSMALLEN_OLBFGS_OLBFGS_HPP
+
+#include <ensmallen_bits/function/objective_estimate.hpp>
+
+namespace ens {
+
+/**
+ * Online L-BFGS (oLBFGS) minimizes a function which can be expressed as a sum
+ * of other functions,
+ *
+ * \f[
+ * f(A) = \sum_{i = 0}^{n} f_i(A),
+ * \f]
+ *
+ * with the mini-batches that SGD uses, but steps along the L-BFGS search
+ * direction instead of the gradient.  Each step takes the gradient of a batch
+ * at the current point, applies the limited-memory inverse Hessian
+ * approximation with the two-loop recursion, and takes a step of (decaying)
+ * size \f$ \eta_t = \eta_0 \tau / (\tau + t) \f$ along it.  The curvature pair
+ * of the step is then computed on the same batch: the gradient of the batch is
+ * evaluated again at the new point, so that
+ *
+ * \f[
+ * y_t = \nabla f_{B_t}(A_{t + 1}) - \nabla f_{B_t}(A_t) + \lambda s_t
+ * \f]
+ *
+ * only measures the curvature of the objective and not the noise between two
+ * batches.  Pairs with non-positive curvature are skipped, and the two-loop
+ * recursion is scaled by the mean of \f$ s^T y / y^T y \f$ over the stored
+ * pairs; before the first pair is stored, steps along the normalized gradient
+ * are taken.  Each step thus costs two batch gradients and
+ * O(numBasis * n) operations, which brings quasi-Newton convergence at close to
+ * the per-step cost of SGD.
+ *
+ * For more information, see the following:
+ *
+ * @code
+ * @inproceedings{schraudolph2007stochastic,
+ *   title     = {A Stochastic Quasi-Newton Method for Online Convex
+ *                Optimization},
+ *   author    = {Schraudolph, Nicol N. and Yu, Jin and G{\"u}nter, Simon},
+ *   booktitle = {Proceedings of the Eleventh International Conference on
+ *                Artificial Intelligence and Statistics (AISTATS)},
+ *   pages     = {436--443},
+ *   year      = {2007}
+ * }
+ * @endcode
+ *
+ * OLBFGS can optimize differentiable separable functions.  For more details,
+ * see the documentation on function types included with this distribution or
+ * on the ensmallen website.
+ */
+class OLBFGS
+{
+ public:
+  /**
+   * Construct the oLBFGS optimizer with the given parameters.  The defaults
+   * here are not necessarily good for the given problem, so it is suggested
+   * that the values used be tailored to the task at hand.  The maximum number
+   * of iterations refers to the maximum number of points that are processed
+   * (i.e., one iteration equals one point; one iteration does not equal one
+   * pass over the dataset).
+   *
+   * @param stepSize Initial step size.
+   * @param batchSize Batch size to use for each step.
+   * @param numBasis Number of curvature pairs to store.
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *     limit).
+   * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param tau Decay constant of the step size, which is stepSize * tau /
+   *     (tau + t) at step t (0 means a constant step size).
+   * @param lambda Damping added to the gradient differences, as lambda times
+   *     the step.
+   * @param shuffle If true, the function order is shuffled; otherwise, each
+   *     function is visited in linear order.
+   */
+  OLBFGS(const double stepSize = 0.1,
+         const size_t batchSize = 32,
+         const size_t numBasis = 10,
+         const size_t maxIterations = 100000,
+         const double tolerance = 1e-5,
+         const double tau = 1e4,
+         const double lambda = 0.0,
+         const bool shuffle = true);
+
+  /**
+   * Optimize the given function using oLBFGS.  The given starting point will
+   * be modified to store the finishing point of the algorithm, and the final
+   * objective value is returned.
+   *
+   * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename DecomposableFunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(DecomposableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks);
+
+  //! Get the initial step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the initial step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the batch size.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the number of curvature pairs to store.
+  size_t NumBasis() const { return numBasis; }
+  //! Modify the number of curvature pairs to store.
+  size_t& NumBasis() { return numBasis; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get the decay constant of the step size (0 means no decay).
+  double Tau() const { return tau; }
+  //! Modify the decay constant of the step size (0 means no decay).
+  double& Tau() { return tau; }
+
+  //! Get the damping of the gradient differences.
+  double Lambda() const { return lambda; }
+  //! Modify the damping of the gradient differences.
+  double& Lambda() { return lambda; }
+
+  //! Get whether or not the individual functions are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the individual functions are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+  //! Get how the final objective is computed.
+  const ens::ObjectiveEstimate& ObjectiveEstimate() const
+  { return objectiveEstimate; }
+  //! Modify how the final objective is computed.
+  ens::ObjectiveEstimate& ObjectiveEstimate() { return objectiveEstimate; }
+
+  //! Get the workspace the temporaries are taken from (NULL if none).
+  ens::Workspace* Workspace() const { return workspace; }
+  //! Modify the workspace the temporaries are taken from (NULL if none).
+  ens::Workspace*& Workspace() { return workspace; }
+
+ private:
+  /**
+   * Compute the search direction -H g of the given gradient with the
+   * two-loop recursion over the stored pairs.  The pairs are stored in a ring
+   * buffer, with the newest one at position newest.
+   *
+   * @param gradient The gradient of the current batch.
+   * @param s Differences between the iterates of the stored pairs.
+   * @param y Differences between the gradients of the stored pairs.
+   * @param rho Inverse curvatures 1 / (s^T y) of the stored pairs.
+   * @param numPairs Number of stored pairs.
+   * @param newest Position of the newest pair.
+   * @param scaling Scaling of the initial inverse Hessian approximation.
+   * @param alpha Workspace of numBasis elements.
+   * @param direction Matrix to store the search direction in.
+   */
+  template<typename MatType, typename GradType, typename CubeType,
+           typename VecType>
+  void SearchDirection(const GradType& gradient,
+                       const CubeType& s,
+                       const CubeType& y,
+                       const VecType& rho,
+                       const size_t numPairs,
+                       const size_t newest,
+                       const double scaling,
+                       VecType& alpha,
+                       MatType& direction) const;
+
+  //! The initial step size.
+  double stepSize;
+
+  //! The batch size.
+  size_t batchSize;
+
+  //! The number of curvature pairs to store.
+  size_t numBasis;
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! The decay constant of the step size.
+  double tau;
+
+  //! The damping of the gradient differences.
+  double lambda;
+
+  //! Controls whether or not the individual functions are shuffled.
+  bool shuffle;
+
+  //! How the final objective is computed.
+  ens::ObjectiveEstimate objectiveEstimate;
+
+  //! The workspace the temporaries are taken from (NULL if none).
+  ens::Workspace* workspace;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "olbfgs_impl.hpp"
+
+#endif
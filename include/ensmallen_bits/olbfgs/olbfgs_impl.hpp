@@ -0,0 +1,299 @@
+/**
+ * @file olbfgs_impl.hpp
+ *
+ * Implementation of online L-BFGS (oLBFGS).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_OLBFGS_OLBFGS_IMPL_HPP
+#define ENSMALLEN_OLBFGS_OLBFGS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "olbfgs.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+inline OLBFGS::OLBFGS(const double stepSize,
+                      const size_t batchSize,
+                      const size_t numBasis,
+                      const size_t maxIterations,
+                      const double tolerance,
+                      const double tau,
+                      const double lambda,
+                      const bool shuffle) :
+    stepSize(stepSize),
+    batchSize(batchSize),
+    numBasis(numBasis),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    tau(tau),
+    lambda(lambda),
+    shuffle(shuffle),
+    workspace(NULL)
+{ /* Nothing to do. */ }
+
+template<typename MatType, typename GradType, typename CubeType,
+         typename VecType>
+inline void OLBFGS::SearchDirection(const GradType& gradient,
+                                    const CubeType& s,
+                                    const CubeType& y,
+                                    const VecType& rho,
+                                    const size_t numPairs,
+                                    const size_t newest,
+                                    const double scaling,
+                                    VecType& alpha,
+                                    MatType& direction) const
+{
+  direction = gradient;
+
+  // Newest to oldest.
+  for (size_t k = 0; k < numPairs; ++k)
+  {
+    const size_t pos = (newest + numBasis - k) % numBasis;
+    alpha[pos] = rho[pos] * dot(s.slice(pos), direction);
+    direction -= alpha[pos] * y.slice(pos);
+  }
+
+  direction *= scaling;
+
+  // Oldest to newest.
+  for (size_t k = numPairs; k > 0; --k)
+  {
+    const size_t pos = (newest + numBasis - (k - 1)) % numBasis;
+    const double beta = rho[pos] * dot(y.slice(pos), direction);
+    direction += (alpha[pos] - beta) * s.slice(pos);
+  }
+
+  // Negate the direction so that it is a descent direction.
+  direction *= -1;
+}
+
+//! Optimize the function (minimize).
+template<typename DecomposableFunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename MatType::elem_type OLBFGS::Optimize(
+    DecomposableFunctionType& function,
+    MatType& iterateIn,
+    CallbackTypes&&... callbacks)
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+  typedef typename CubeTypeTraits<BaseMatType>::CubeType CubeType;
+
+  typedef Function<DecomposableFunctionType, BaseMatType, BaseGradType>
+      FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+  ENS_PROFILE_OPTIMIZE("OLBFGS");
+
+  // Make sure we have all the methods that we need.
+  traits::CheckDecomposableFunctionTypeAPI<FullFunctionType, BaseMatType,
+      BaseGradType>();
+
+  if (numBasis == 0)
+  {
+    throw std::invalid_argument("OLBFGS::Optimize(): the number of curvature "
+        "pairs must be greater than zero!");
+  }
+
+  // Vectors are optimized as matrices.
+  BaseMatType& iterate = static_cast<BaseMatType&>(iterateIn);
+
+  // Find the number of functions to use.
+  const size_t numFunctions = f.NumFunctions();
+
+  // The temporaries are taken from the given workspace, or else from a local
+  // one.
+  ens::Workspace localWorkspace;
+  ens::Workspace& ws = (workspace != NULL) ? *workspace : localWorkspace;
+  BaseGradType& gradient = ws.Get<BaseGradType>(0);
+  BaseGradType& newGradient = ws.Get<BaseGradType>(1);
+  BaseMatType& step = ws.Get<BaseMatType>(2);
+  CubeType& s = ws.Get<CubeType>(3);
+  CubeType& y = ws.Get<CubeType>(4);
+  arma::Col<ElemType>& rho = ws.Get<arma::Col<ElemType>>(5);
+  arma::Col<ElemType>& ratio = ws.Get<arma::Col<ElemType>>(6);
+  arma::Col<ElemType>& alpha = ws.Get<arma::Col<ElemType>>(7);
+  gradient.set_size(iterate.n_rows, iterate.n_cols);
+  newGradient.set_size(iterate.n_rows, iterate.n_cols);
+  s.set_size(iterate.n_rows, iterate.n_cols, numBasis);
+  y.set_size(iterate.n_rows, iterate.n_cols, numBasis);
+  rho.set_size(numBasis);
+  ratio.set_size(numBasis);
+  alpha.set_size(numBasis);
+
+  // The stored pairs, and the sum of their ratios s^T y / y^T y.
+  size_t numPairs = 0, newest = 0;
+  double ratioSum = 0;
+
+  // To keep track of where we are and how things are going.
+  size_t currentFunction = 0;
+  size_t steps = 0;
+  ElemType overallObjective = 0;
+  ElemType lastObjective = std::numeric_limits<ElemType>::max();
+
+  // Track the current epoch and whether a callback asked us to stop.
+  size_t epoch = 0;
+  bool terminate = false;
+  terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
+
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+  for (size_t i = 0; i < actualMaxIterations && !terminate;
+      /* incrementing done manually */)
+  {
+    // Is this iteration the start of a sequence?
+    if ((currentFunction % numFunctions) == 0 && i > 0)
+    {
+      // Output current objective function.
+      Info << "OLBFGS: iteration " << i << ", objective " << overallObjective
+          << ".\n";
+
+      terminate |= Callback::EndEpoch(*this, f, iterate, epoch++,
+          overallObjective, callbacks...);
+
+      if (std::isnan(overallObjective) || std::isinf(overallObjective))
+      {
+        Warn << "OLBFGS: converged to " << overallObjective << "; "
+            << "terminating with failure.  Try a smaller step size?"
+            << std::endl;
+        Callback::EndOptimization(*this, f, iterate, callbacks...);
+        return overallObjective;
+      }
+
+      if (std::abs(lastObjective - overallObjective) < tolerance)
+      {
+        Info << "OLBFGS: minimized within tolerance " << tolerance << "; "
+            << "terminating optimization." << std::endl;
+        Callback::EndOptimization(*this, f, iterate, callbacks...);
+        return overallObjective;
+      }
+
+      if (terminate)
+      {
+        Info << "OLBFGS: callback requested termination." << std::endl;
+        break;
+      }
+
+      // Reset the counter variables.
+      lastObjective = overallObjective;
+      overallObjective = 0;
+      currentFunction = 0;
+
+      if (shuffle) // Determine order of visitation.
+      {
+        ENS_PROFILE_SCOPE("Shuffle");
+        f.Shuffle();
+      }
+
+      terminate |= Callback::BeginEpoch(*this, f, iterate, epoch,
+          lastObjective, callbacks...);
+    }
+
+    // Find the effective batch size (see SGD).
+    const size_t effectiveBatchSize = std::min(
+        std::min(batchSize, actualMaxIterations - i),
+        numFunctions - currentFunction);
+
+    ElemType objective;
+    {
+      ENS_PROFILE_SCOPE("EvaluateWithGradient");
+      objective = f.EvaluateWithGradient(iterate, currentFunction, gradient,
+          effectiveBatchSize);
+    }
+    overallObjective += objective;
+
+    terminate |= Callback::EvaluateWithGradient(*this, f, iterate, objective,
+        gradient, callbacks...);
+
+    // Step along the quasi-Newton direction, or along the normalized gradient
+    // until a pair is stored.
+    {
+      ENS_PROFILE_SCOPE("SearchDirection");
+      if (numPairs == 0)
+      {
+        const ElemType gradientNorm = norm(gradient);
+        step = gradient;
+        step *= -((gradientNorm > 0) ? 1 / gradientNorm : ElemType(0));
+      }
+      else
+      {
+        SearchDirection(gradient, s, y, rho, numPairs, newest,
+            ratioSum / numPairs, alpha, step);
+      }
+    }
+
+    const double currentStepSize = (tau > 0) ?
+        stepSize * tau / (tau + steps) : stepSize;
+    step *= currentStepSize;
+    iterate += step;
+    ++steps;
+
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+
+    // Compute the curvature pair on the same batch.
+    {
+      ENS_PROFILE_SCOPE("Gradient");
+      f.Gradient(iterate, currentFunction, newGradient, effectiveBatchSize);
+    }
+    terminate |= Callback::Gradient(*this, f, iterate, newGradient,
+        callbacks...);
+
+    {
+      ENS_PROFILE_SCOPE("UpdateBasisSet");
+      newGradient -= gradient;
+      if (lambda != 0)
+        newGradient += lambda * step;
+
+      const double sy = dot(step, newGradient);
+      const double yy = dot(newGradient, newGradient);
+      if (sy > 0 && yy > 0)
+      {
+        newest = (numPairs == 0) ? 0 : (newest + 1) % numBasis;
+        if (numPairs == numBasis)
+          ratioSum -= ratio[newest];
+        else
+          ++numPairs;
+
+        s.slice(newest) = step;
+        y.slice(newest) = newGradient;
+        rho[newest] = 1 / sy;
+        ratio[newest] = sy / yy;
+        ratioSum += ratio[newest];
+      }
+    }
+
+    i += effectiveBatchSize;
+    currentFunction += effectiveBatchSize;
+  }
+
+  if (!terminate)
+  {
+    Info << "OLBFGS: maximum iterations (" << maxIterations << ") reached; "
+        << "terminating optimization." << std::endl;
+  }
+
+  // Calculate final objective (see SGD).
+  if (!objectiveEstimate.IsReuse())
+  {
+    ENS_PROFILE_SCOPE("Evaluate");
+    overallObjective = objectiveEstimate.Evaluate(f, iterate, batchSize);
+  }
+  else if (currentFunction > 0 && currentFunction < numFunctions)
+    overallObjective *= (ElemType) numFunctions / currentFunction;
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+  return overallObjective;
+}
+
+} // namespace ens
+
+#endif
@@ -50,57 +50,11 @@ class PadamUpdate
       epsilon(epsilon),
       beta1(beta1),
       beta2(beta2),
-      partial(partial),
-      iteration(0)
+      partial(partial)
   {
     // Nothing to do.
   }
 
-  /**
-   * The Initialize method is called by SGD Optimizer method before the start of
-   * the iteration update process.
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
-   */
-  void Initialize(const size_t rows, const size_t cols)
-  {
-    m = arma::zeros<arma::mat>(rows, cols);
-    v = arma::zeros<arma::mat>(rows, cols);
-    vImproved = arma::zeros<arma::mat>(rows, cols);
-  }
-
-  /**
-   * Update step for Padam.
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
-   */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
-  {
-    // Increment the iteration counter variable.
-    ++iteration;
-
-    // And update the iterate.
-    m *= beta1;
-    m += (1 - beta1) * gradient;
-
-    v *= beta2;
-    v += (1 - beta2) * (gradient % gradient);
-
-    const double biasCorrection1 = 1.0 - std::pow(beta1, iteration);
-    const double biasCorrection2 = 1.0 - std::pow(beta2, iteration);
-
-    // Element wise maximum of past and present squared gradients.
-    vImproved = arma::max(vImproved, v);
-
-    iterate -= (stepSize * std::sqrt(biasCorrection2) / biasCorrection1) *
-        m / arma::pow(vImproved + epsilon, partial);
-  }
-
   //! Get the value used to initialise the squared gradient parameter.
   double Epsilon() const { return epsilon; }
   //! Modify the value used to initialise the squared gradient parameter.
@@ -121,6 +75,135 @@ class PadamUpdate
   //! Modify the partial adaptive parameter.
   double& Partial() { return partial; }
 
+  //! Get the number of bytes of the state (the two moments and the maximum
+  //! of the second moment) for an iterate of the given size.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
+  {
+    return 3 * rows * cols * elemSize;
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const PadamUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        m(arma::zeros<MatType>(rows, cols)),
+        v(arma::zeros<MatType>(rows, cols)),
+        vImproved(arma::zeros<MatType>(rows, cols)),
+        iteration(0)
+    {
+      // Nothing to do.
+    }
+
+    /**
+     * Update step for Padam.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      // Increment the iteration counter variable.
+      ++iteration;
+
+      const double biasCorrection1 = 1.0 - std::pow(parent.beta1, iteration);
+      const double biasCorrection2 = 1.0 - std::pow(parent.beta2, iteration);
+
+      // And update the iterate.
+      Step(iterate, gradient, stepSize * std::sqrt(biasCorrection2) /
+          biasCorrection1, IsFusableUpdate<MatType, GradType>());
+    }
+
+   private:
+    //! Update the moments and the iterate in a single loop.
+    void Step(MatType& iterate,
+              const GradType& gradient,
+              const double scaledStepSize,
+              std::true_type /* fusable */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType beta1 = parent.beta1;
+      const ElemType beta2 = parent.beta2;
+      const ElemType epsilon = parent.epsilon;
+      const ElemType partial = parent.partial;
+      const ElemType step = scaledStepSize;
+
+      ElemType* x = iterate.memptr();
+      ElemType* mPtr = m.memptr();
+      ElemType* vPtr = v.memptr();
+      ElemType* vImprovedPtr = vImproved.memptr();
+      const ElemType* g = gradient.memptr();
+
+      const size_t n = iterate.n_elem;
+      ENS_PRAGMA_OMP_SIMD
+      for (size_t i = 0; i < n; ++i)
+      {
+        mPtr[i] = beta1 * mPtr[i] + (1 - beta1) * g[i];
+        vPtr[i] = beta2 * vPtr[i] + (1 - beta2) * (g[i] * g[i]);
+
+        // Element wise maximum of past and present squared gradients.
+        vImprovedPtr[i] = std::max(vImprovedPtr[i], vPtr[i]);
+
+        x[i] -= step * mPtr[i] / std::pow(vImprovedPtr[i] + epsilon, partial);
+      }
+    }
+
+    //! Update the moments and the iterate with Armadillo expressions.
+    void Step(MatType& iterate,
+              const GradType& gradient,
+              const double scaledStepSize,
+              std::false_type /* fusable */)
+    {
+      m *= parent.beta1;
+      m += (1 - parent.beta1) * gradient;
+
+      v *= parent.beta2;
+      v += (1 - parent.beta2) * (gradient % gradient);
+
+      // Element wise maximum of past and present squared gradients.
+      vImproved = arma::max(vImproved, v);
+
+      iterate -= scaledStepSize * m / arma::pow(vImproved + parent.epsilon,
+          parent.partial);
+    }
+
+    // Instantiated parent object.
+    const PadamUpdate& parent;
+
+    //! The exponential moving average of gradient values.
+    MatType m;
+
+    //! The exponential moving average of squared gradient values.
+    MatType v;
+
+    //! The optimal sqaured gradient value.
+    MatType vImproved;
+
+    //! The number of iterations.
+    double iteration;
+  };
+
  private:
   //! The epsilon value used to initialise the squared gradient parameter.
   double epsilon;
@@ -133,18 +216,6 @@ class PadamUpdate
 
   //! Partial adaptive parameter.
   double partial;
-
-  //! The exponential moving average of gradient values.
-  arma::mat m;
-
-  //! The exponential moving average of squared gradient values.
-  arma::mat v;
-
-  //! The optimal sqaured gradient value.
-  arma::mat vImproved;
-
-  //! The number of iterations.
-  double iteration;
 };
 
 } // namespace ens
@@ -0,0 +1,291 @@
+/**
+ * @file hashed_iterate.hpp
+ *
+ * An iterate that only stores its nonzero coordinates, in a hash table that
+ * the threads of parallel SGD can update concurrently.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PARALLEL_SGD_HASHED_ITERATE_HPP
+#define ENSMALLEN_PARALLEL_SGD_HASHED_ITERATE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+namespace ens {
+
+/**
+ * HashedIterate is a matrix of doubles, of a possibly huge logical size, that
+ * only stores the coordinates that were written to.  It can be given to
+ * ParallelSGD instead of an arma::mat when the features are hashed into a space
+ * far too large to be allocated densely (for instance 2^30 coordinates, of
+ * which a few millions are ever touched).
+ *
+ * The coordinates are kept in an open-addressing (linear probing) hash table
+ * of fixed capacity, a power of two.  A coordinate is inserted the first time
+ * it is accessed through the non-const operator() or operator[], with an
+ * atomic compare-and-swap on its key, so several threads can insert and update
+ * coordinates at the same time; the value is then updated as in a dense
+ * matrix (atomically with AtomicUpdate, without synchronization with
+ * HogwildUpdate).  Coordinates are never removed, and the const accessors
+ * return 0 for coordinates that were never written to.
+ *
+ * The capacity must be larger than the number of coordinates that will be
+ * touched (a load factor under 0.5 keeps the probes short); a
+ * std::length_error is thrown if the table is full, which terminates the
+ * program when it happens in a parallel region.
+ *
+ * @code
+ * // 2^30 logical coordinates, room for a million of them.
+ * HashedIterate coordinates(1 << 30, 1, 1 << 20);
+ * ParallelSGD<> optimizer(100, 1000);
+ * optimizer.Optimize(f, coordinates);
+ * @endcode
+ *
+ * The function to optimize takes the coordinates as a const HashedIterate&
+ * in its Evaluate() and Gradient(), and returns an arma::sp_mat gradient of
+ * size n_rows x n_cols (which requires 64-bit Armadillo indices if n_rows is
+ * at least 2^32).
+ */
+class HashedIterate
+{
+ public:
+  //! The type of the coordinates.
+  typedef double elem_type;
+
+  //! Create an empty 0x0 iterate.
+  HashedIterate() :
+      n_rows(0),
+      n_cols(0),
+      n_elem(0),
+      capacity(0),
+      size(0)
+  { /* Nothing to do. */ }
+
+  /**
+   * Create an iterate of the given logical size, with all coordinates 0.
+   *
+   * @param rows Number of rows.
+   * @param cols Number of columns.
+   * @param capacity Number of coordinates that can be stored (rounded up to a
+   *     power of two).
+   */
+  HashedIterate(const size_t rows, const size_t cols, const size_t capacity) :
+      n_rows(rows),
+      n_cols(cols),
+      n_elem(rows * cols),
+      capacity(0),
+      size(0)
+  {
+    Allocate(capacity);
+  }
+
+  //! Copy the given iterate.
+  HashedIterate(const HashedIterate& other) :
+      n_rows(0),
+      n_cols(0),
+      n_elem(0),
+      capacity(0),
+      size(0)
+  {
+    *this = other;
+  }
+
+  //! Copy the given iterate; the storage is reused if the capacity matches.
+  HashedIterate& operator=(const HashedIterate& other)
+  {
+    if (this == &other)
+      return *this;
+
+    if (capacity != other.capacity)
+      Allocate(other.capacity);
+
+    n_rows = other.n_rows;
+    n_cols = other.n_cols;
+    n_elem = other.n_elem;
+    for (size_t s = 0; s < capacity; ++s)
+    {
+      keys[s].store(other.keys[s].load(std::memory_order_relaxed),
+          std::memory_order_relaxed);
+      values[s] = other.values[s];
+    }
+    size.store(other.size.load());
+    return *this;
+  }
+
+  //! Get the coordinate with the given linear index (0 if it is not stored).
+  double operator[](const size_t i) const
+  {
+    const size_t slot = Find(i);
+    return (slot == capacity) ? 0.0 : values[slot];
+  }
+
+  //! Modify the coordinate with the given linear index (it is inserted if it
+  //! is not stored).
+  double& operator[](const size_t i) { return values[Insert(i)]; }
+
+  //! Get the coordinate at the given row and column (0 if it is not stored).
+  double operator()(const size_t row, const size_t col) const
+  {
+    return (*this)[row + col * n_rows];
+  }
+
+  //! Modify the coordinate at the given row and column (it is inserted if it
+  //! is not stored).
+  double& operator()(const size_t row, const size_t col)
+  {
+    return (*this)[row + col * n_rows];
+  }
+
+  //! Get the number of stored coordinates.
+  size_t Size() const { return size.load(); }
+
+  //! Get the number of coordinates that can be stored.
+  size_t Capacity() const { return capacity; }
+
+  //! Remove all the stored coordinates (which is not thread-safe).
+  void Clear()
+  {
+    for (size_t s = 0; s < capacity; ++s)
+    {
+      keys[s].store(Empty(), std::memory_order_relaxed);
+      values[s] = 0.0;
+    }
+    size.store(0);
+  }
+
+  //! Return the stored coordinates as a sparse matrix.
+  arma::sp_mat ToSparse() const
+  {
+    const size_t stored = Size();
+    if (stored == 0)
+      return arma::sp_mat(n_rows, n_cols);
+
+    arma::umat locations(2, stored);
+    arma::vec storedValues(stored);
+    size_t k = 0;
+    for (size_t s = 0; s < capacity && k < stored; ++s)
+    {
+      const uint64_t key = keys[s].load(std::memory_order_relaxed);
+      if (key == Empty())
+        continue;
+
+      locations(0, k) = key % n_rows;
+      locations(1, k) = key / n_rows;
+      storedValues[k] = values[s];
+      ++k;
+    }
+
+    return arma::sp_mat(locations.cols(0, k - 1),
+        storedValues.subvec(0, k - 1), n_rows, n_cols);
+  }
+
+  //! The number of rows (read-only).
+  size_t n_rows;
+  //! The number of columns (read-only).
+  size_t n_cols;
+  //! The number of coordinates, n_rows * n_cols (read-only).
+  size_t n_elem;
+
+ private:
+  //! The key of the empty slots.
+  static uint64_t Empty() { return UINT64_MAX; }
+
+  //! Allocate an empty table of at least the given capacity.
+  void Allocate(const size_t minCapacity)
+  {
+    capacity = 0;
+    keys.reset();
+    values.reset();
+    if (minCapacity == 0)
+      return;
+
+    size_t newCapacity = 1;
+    while (newCapacity < minCapacity)
+      newCapacity <<= 1;
+
+    keys.reset(new std::atomic<uint64_t>[newCapacity]);
+    values.reset(new double[newCapacity]);
+    capacity = newCapacity;
+    Clear();
+  }
+
+  //! Get the first slot to probe for the given key (the splitmix64 finalizer,
+  //! so that consecutive indices are spread over the table).
+  size_t Hash(uint64_t key) const
+  {
+    key = (key ^ (key >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    key = (key ^ (key >> 27)) * UINT64_C(0x94d049bb133111eb);
+    return (size_t) (key ^ (key >> 31)) & (capacity - 1);
+  }
+
+  //! Get the slot of the given key, or the capacity if it is not stored.
+  size_t Find(const uint64_t key) const
+  {
+    if (capacity == 0)
+      return capacity;
+
+    size_t slot = Hash(key);
+    for (size_t probes = 0; probes < capacity; ++probes)
+    {
+      const uint64_t stored = keys[slot].load(std::memory_order_acquire);
+      if (stored == key)
+        return slot;
+      else if (stored == Empty())
+        return capacity;
+
+      slot = (slot + 1) & (capacity - 1);
+    }
+
+    return capacity;
+  }
+
+  //! Get the slot of the given key, claiming an empty slot for it if it is not
+  //! stored yet.
+  size_t Insert(const uint64_t key)
+  {
+    size_t slot = (capacity == 0) ? 0 : Hash(key);
+    for (size_t probes = 0; probes < capacity; ++probes)
+    {
+      uint64_t stored = keys[slot].load(std::memory_order_acquire);
+      if (stored == key)
+        return slot;
+
+      // Another thread may claim the slot first; it may even be for the same
+      // key.
+      if (stored == Empty() && keys[slot].compare_exchange_strong(stored, key,
+          std::memory_order_acq_rel))
+      {
+        ++size;
+        return slot;
+      }
+      else if (stored == key)
+      {
+        return slot;
+      }
+
+      slot = (slot + 1) & (capacity - 1);
+    }
+
+    throw std::length_error("HashedIterate::operator(): the capacity of the "
+        "table is exhausted; construct it with a larger capacity!");
+  }
+
+  //! The number of slots (a power of two).
+  size_t capacity;
+  //! The key of each slot (Empty() if it is free).
+  std::unique_ptr<std::atomic<uint64_t>[]> keys;
+  //! The value of each slot.
+  std::unique_ptr<double[]> values;
+  //! The number of stored coordinates.
+  std::atomic<size_t> size;
+};
+
+} // namespace ens
+
+#endif
@@ -12,14 +12,35 @@
 #ifndef ENSMALLEN_PARALLEL_SGD_HPP
 #define ENSMALLEN_PARALLEL_SGD_HPP
 
+#include <ensmallen_bits/function/objective_estimate.hpp>
+
 #include "decay_policies/constant_step.hpp"
 #include "decay_policies/exponential_backoff.hpp"
+#include "hashed_iterate.hpp"
+#include "update_policies/atomic_update.hpp"
+#include "update_policies/delta_buffer_update.hpp"
+#include "update_policies/hogwild_update.hpp"
+#include "update_policies/sparse_ada_grad_update.hpp"
 
 namespace ens {
 
 /**
  * An implementation of parallel stochastic gradient descent using the lock-free
- * HOGWILD! approach.
+ * HOGWILD! approach.  How the threads write their sparse updates to the shared
+ * iterate is controlled by the update policy: with AtomicUpdate (the default)
+ * every coordinate update is atomic, with HogwildUpdate the updates are not
+ * synchronized at all (as in the paper), with DeltaBufferUpdate each thread
+ * combines its updates in a private buffer before applying them, and with
+ * SparseAdaGradUpdate every coordinate gets its own AdaGrad step size.
+ *
+ * On machines with several NUMA nodes (sockets), a single shared iterate makes
+ * the threads of the different sockets fight over the same cache lines across
+ * the interconnect.  With several replicas, the threads are bound to the
+ * cores (with OpenMP proc_bind(close), so that consecutive threads share a
+ * socket) and split into as many groups; each group updates its own replica,
+ * which is allocated by one of its threads so that its pages are local to its
+ * socket.  Every reconcileInterval batches, the updates of all the replicas
+ * are added to the iterate, and the replicas start again from the sum.
  *
  * For more information, see the following.
  * @misc{1106.5730,
@@ -31,39 +52,68 @@ namespace ens {
  *   Eprint = {arXiv:1106.5730},
  * }
  *
+ * Before each iteration, the objective is computed to check for convergence.
+ * By default this is a full pass over the data, split across the threads (so
+ * the separable Evaluate() must be safe to call concurrently, unless
+ * ParallelEvaluation() is false); ObjectiveEstimate() can make it a random
+ * subsample instead, and EvaluationInterval() can make the checks happen only
+ * every few iterations, so that the serial parts do not limit the speedup.
+ *
+ * The iterate is usually an arma::mat, but it can also be a HashedIterate,
+ * which only stores the coordinates that are touched by the gradients, for
+ * hashed feature spaces too large to be stored densely.  The function must
+ * then accept a const HashedIterate& wherever it takes the coordinates, and
+ * the update policy must be AtomicUpdate or HogwildUpdate (DeltaBufferUpdate
+ * keeps a dense buffer per thread, and SparseAdaGradUpdate a dense
+ * accumulator).
+ *
  * ParallelSGD can optimize sparse differentiable separable functions.  For more
  * details, see the documentation on function types included with this
  * distribution or on the ensmallen website.
  *
  * @tparam DecayPolicyType Step size update policy used by parallel SGD
  *     to update the stepsize after each iteration.
+ * @tparam UpdatePolicyType Policy used by the threads to apply their sparse
+ *     updates to the shared iterate.
  */
-template <typename DecayPolicyType = ConstantStep>
+template <typename DecayPolicyType = ConstantStep,
+          typename UpdatePolicyType = AtomicUpdate>
 class ParallelSGD
 {
  public:
   /**
    * Construct the parallel SGD optimizer to optimize the given function with
-   * the given parameters. One iteration means one batch of datapoints processed
-   * by each thread.
+   * the given parameters. One iteration means one pass over all datapoints;
+   * the threads repeatedly claim the next threadShareSize datapoints until
+   * none are left, which balances datapoints of varying cost.
    *
    * The defaults here are not necessarily good for the given problem, so it is
    * suggested that the values used be tailored to the task at hand.
    *
    * @param maxIterations Maximum number of iterations allowed (0 means no
    *     limit).
-   * @param threadShareSize Number of datapoints to be processed in one
-   *     iteration by each thread.
+   * @param threadShareSize Number of datapoints a thread claims at once.
    * @param tolerance Maximum absolute tolerance to terminate the algorithm.
    * @param shuffle If true, the function order is shuffled; otherwise, each
    *     function is visited in linear order.
    * @param decayPolicy The step size update policy to use.
+   * @param updatePolicy The policy used to apply the sparse updates.
+   * @param batchSize Number of consecutive datapoints whose gradient is
+   *     computed (and applied) at once by a thread.
+   * @param replicas Number of replicas of the iterate; 1 means that all the
+   *     threads share the iterate, and 0 means one replica per NUMA node.
+   * @param reconcileInterval Number of batches between two reconciliations of
+   *     the replicas (0 means once per iteration).
   */
   ParallelSGD(const size_t maxIterations,
               const size_t threadShareSize,
               const double tolerance = 1e-5,
               const bool shuffle = true,
-              const DecayPolicyType& decayPolicy = DecayPolicyType());
+              const DecayPolicyType& decayPolicy = DecayPolicyType(),
+              const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
+              const size_t batchSize = 1,
+              const size_t replicas = 1,
+              const size_t reconcileInterval = 0);
 
   /**
    * Optimize the given function using the parallel SGD algorithm. The given
@@ -72,25 +122,41 @@ class ParallelSGD
    * returned.
    *
    * @tparam SparseFunctionType Type of function to be optimized.
+   * @tparam MatType Type of the iterate (arma::mat or HashedIterate).
    * @param function Function to be optimized(minimized).
    * @param iterate Starting point(will be modified).
    * @return Objective value at the final point.
    */
-  template <typename SparseFunctionType>
-  double Optimize(SparseFunctionType& function, arma::mat& iterate);
+  template <typename SparseFunctionType, typename MatType>
+  double Optimize(SparseFunctionType& function, MatType& iterate);
 
   //! Get the maximum number of iterations (0 indicates no limits).
   size_t MaxIterations() const { return maxIterations; }
   //! Modify the maximum number of iterations (0 indicates no limits).
   size_t& MaxIterations() { return maxIterations; }
 
-  //! Get the number of datapoints to be processed in one iteration by each
-  //! thread.
+  //! Get the number of datapoints a thread claims at once.
   size_t ThreadShareSize() const { return threadShareSize; }
-  //! Modify the number of datapoints to be processed in one iteration by each
-  //! thread.
+  //! Modify the number of datapoints a thread claims at once.
   size_t& ThreadShareSize() { return threadShareSize; }
 
+  //! Get the number of datapoints in each gradient computation.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the number of datapoints in each gradient computation.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the number of replicas of the iterate (0 means one per NUMA node).
+  size_t Replicas() const { return replicas; }
+  //! Modify the number of replicas of the iterate (0 means one per NUMA
+  //! node).
+  size_t& Replicas() { return replicas; }
+
+  //! Get the number of batches between two reconciliations of the replicas.
+  size_t ReconcileInterval() const { return reconcileInterval; }
+  //! Modify the number of batches between two reconciliations of the
+  //! replicas.
+  size_t& ReconcileInterval() { return reconcileInterval; }
+
   //! Get the tolerance for termination.
   double Tolerance() const { return tolerance; }
   //! Modify the tolerance for termination.
@@ -106,13 +172,119 @@ class ParallelSGD
   //! Modify the step size decay policy.
   DecayPolicyType& DecayPolicy() { return decayPolicy; }
 
+  //! Get the update policy.
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  //! Modify the update policy.
+  UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
+
+  //! Get how the objective of the convergence checks is computed.
+  const ens::ObjectiveEstimate& ObjectiveEstimate() const
+  { return objectiveEstimate; }
+  //! Modify how the objective of the convergence checks is computed.
+  ens::ObjectiveEstimate& ObjectiveEstimate() { return objectiveEstimate; }
+
+  //! Get the number of iterations between two convergence checks.
+  size_t EvaluationInterval() const { return evaluationInterval; }
+  //! Modify the number of iterations between two convergence checks.
+  size_t& EvaluationInterval() { return evaluationInterval; }
+
+  //! Get whether the objective is evaluated by all the threads.
+  bool ParallelEvaluation() const { return parallelEvaluation; }
+  //! Modify whether the objective is evaluated by all the threads.
+  bool& ParallelEvaluation() { return parallelEvaluation; }
+
  private:
+  //! Check the API of the function, for a dense iterate.
+  template <typename SparseFunctionType, bool UseScatter>
+  static void CheckFunctionAPI(const arma::mat& /* iterate */)
+  { traits::CheckSparseFunctionTypeAPI<SparseFunctionType, UseScatter>(); }
+
+  //! The API checks are written for dense iterates, so other iterates are not
+  //! checked.
+  template <typename SparseFunctionType, bool UseScatter, typename MatType>
+  static void CheckFunctionAPI(const MatType& /* iterate */) { }
+
+  //! The type of the scatter callback of the given instantiated update
+  //! policy, or void if it has none.
+  template <typename PolicyType, typename = void>
+  struct ScatterTypeOf
+  {
+    typedef void type;
+  };
+
+  //! The instantiated update policy has a scatter callback.
+  template <typename PolicyType>
+  struct ScatterTypeOf<PolicyType, typename traits::VoidType<
+      typename PolicyType::Scatter>::type>
+  {
+    typedef typename PolicyType::Scatter type;
+  };
+
+  /**
+   * Compute the sparse gradient of the given batch into the given matrix, and
+   * apply it to the iterate with the update policy.
+   */
+  template <typename SparseFunctionType, typename MatType, typename PolicyType>
+  static void UpdateBatch(SparseFunctionType& function,
+                          MatType& iterate,
+                          const size_t begin,
+                          const size_t batchSize,
+                          const double stepSize,
+                          arma::sp_mat& gradient,
+                          PolicyType& policy,
+                          const size_t threadId,
+                          std::false_type /* useScatter */);
+
+  /**
+   * Let the function emit the components of the gradient of the given batch
+   * into the scatter callback of the update policy, which applies them
+   * directly; no sparse matrix is built.
+   */
+  template <typename SparseFunctionType, typename MatType, typename PolicyType>
+  static void UpdateBatch(SparseFunctionType& function,
+                          MatType& iterate,
+                          const size_t begin,
+                          const size_t batchSize,
+                          const double stepSize,
+                          arma::sp_mat& gradient,
+                          PolicyType& policy,
+                          const size_t threadId,
+                          std::true_type /* useScatter */);
+
+  /**
+   * Add the updates of the given replicas (since they were copied from the
+   * iterate) to the iterate.
+   *
+   * @param iterate The iterate the replicas were copied from.
+   * @param replicaIterates The replicas.
+   * @param activeReplicas The number of replicas that were used.
+   */
+  template <typename MatType>
+  static void Reconcile(MatType& iterate,
+                        const std::vector<MatType>& replicaIterates,
+                        const size_t activeReplicas);
+
+  //! Add the updates of the given hashed replicas to the iterate; only the
+  //! stored coordinates of each replica are visited.
+  static void Reconcile(HashedIterate& iterate,
+                        const std::vector<HashedIterate>& replicaIterates,
+                        const size_t activeReplicas);
+
   //! The maximum number of allowed iterations.
   size_t maxIterations;
 
-  //! The number of datapoints to be processed in one iteration by each thread.
+  //! The number of datapoints a thread claims at once.
   size_t threadShareSize;
 
+  //! The number of datapoints in each gradient computation.
+  size_t batchSize;
+
+  //! The number of replicas of the iterate.
+  size_t replicas;
+
+  //! The number of batches between two reconciliations of the replicas.
+  size_t reconcileInterval;
+
   //! The tolerance for termination.
   double tolerance;
 
@@ -122,6 +294,18 @@ class ParallelSGD
 
   //! The step size decay policy.
   DecayPolicyType decayPolicy;
+
+  //! The policy used to apply the sparse updates.
+  UpdatePolicyType updatePolicy;
+
+  //! How the objective of the convergence checks is computed.
+  ens::ObjectiveEstimate objectiveEstimate;
+
+  //! The number of iterations between two convergence checks.
+  size_t evaluationInterval;
+
+  //! Whether the objective is evaluated by all the threads.
+  bool parallelEvaluation;
 };
 
 } // namespace ens
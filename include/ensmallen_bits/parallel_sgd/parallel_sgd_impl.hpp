@@ -19,63 +19,128 @@
 
 namespace ens {
 
-template <typename DecayPolicyType>
-ParallelSGD<DecayPolicyType>::ParallelSGD(
+template <typename DecayPolicyType, typename UpdatePolicyType>
+ParallelSGD<DecayPolicyType, UpdatePolicyType>::ParallelSGD(
     const size_t maxIterations,
     const size_t threadShareSize,
     const double tolerance,
     const bool shuffle,
-    const DecayPolicyType& decayPolicy) :
+    const DecayPolicyType& decayPolicy,
+    const UpdatePolicyType& updatePolicy,
+    const size_t batchSize,
+    const size_t replicas,
+    const size_t reconcileInterval) :
     maxIterations(maxIterations),
     threadShareSize(threadShareSize),
+    batchSize(batchSize),
+    replicas(replicas),
+    reconcileInterval(reconcileInterval),
     tolerance(tolerance),
     shuffle(shuffle),
-    decayPolicy(decayPolicy)
+    decayPolicy(decayPolicy),
+    updatePolicy(updatePolicy),
+    evaluationInterval(1),
+    parallelEvaluation(true)
 { /* Nothing to do. */ }
 
-template <typename DecayPolicyType>
-template <typename SparseFunctionType>
-double ParallelSGD<DecayPolicyType>::Optimize(
+template <typename DecayPolicyType, typename UpdatePolicyType>
+template <typename SparseFunctionType, typename MatType>
+double ParallelSGD<DecayPolicyType, UpdatePolicyType>::Optimize(
     SparseFunctionType& function,
-    arma::mat& iterate)
+    MatType& iterate)
 {
+  // Instantiate the update policy for all threads.
+  size_t numThreads = 1;
+  #ifdef ENS_USE_OPENMP
+    numThreads = omp_get_max_threads();
+  #endif
+  typedef typename UpdatePolicyType::template Policy<MatType, arma::sp_mat>
+      InstUpdatePolicyType;
+  InstUpdatePolicyType instPolicy(updatePolicy, iterate.n_rows, iterate.n_cols,
+      numThreads);
+
+  // If the function can emit the components of its gradient into the scatter
+  // callback of the update policy, no sparse gradient is built.
+  typedef std::integral_constant<bool, traits::HasScatterGradient<
+      SparseFunctionType, MatType, typename ScatterTypeOf<
+      InstUpdatePolicyType>::type>::value> UseScatter;
+
   // Check that we have all the functions that we need.
-  traits::CheckSparseFunctionTypeAPI<SparseFunctionType>();
+  CheckFunctionAPI<SparseFunctionType, UseScatter::value>(iterate);
+
+  static_assert(!std::is_same<MatType, HashedIterate>::value ||
+      !std::is_same<UpdatePolicyType, DeltaBufferUpdate>::value,
+      "DeltaBufferUpdate keeps a dense buffer per thread, so it can't be used "
+      "with a HashedIterate; use AtomicUpdate or HogwildUpdate instead.");
+  static_assert(!std::is_same<MatType, HashedIterate>::value ||
+      !std::is_same<UpdatePolicyType, SparseAdaGradUpdate>::value,
+      "SparseAdaGradUpdate keeps a dense accumulator, so it can't be used with "
+      "a HashedIterate; use AtomicUpdate or HogwildUpdate instead.");
 
   double overallObjective = DBL_MAX;
   double lastObjective;
 
-  // The order in which the functions will be visited.
+  // The functions are visited in batches of batchSize consecutive functions;
+  // this is the order in which the batches will be visited.
+  const size_t numFunctions = function.NumFunctions();
+  const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
   arma::Col<size_t> visitationOrder = arma::linspace<arma::Col<size_t>>(0,
-      (function.NumFunctions() - 1), function.NumFunctions());
+      (numBatches - 1), numBatches);
+
+  // The number of batches a thread claims at once.
+  const size_t threadShareBatches = std::max<size_t>(1,
+      (threadShareSize + batchSize - 1) / batchSize);
+
+  // Each instance affects only some components of the decision variable, so
+  // the gradient is sparse.  Every thread reuses its own gradient storage for
+  // the whole optimization (unless the gradients are scattered).
+  std::vector<arma::sp_mat> gradients(numThreads);
+
+  // With several replicas, each group of threads updates its own replica of
+  // the iterate, and the replicas are reconciled every reconcileInterval
+  // batches.  There can't be more replicas than threads.
+  const size_t numReplicas = std::min((replicas == 0) ? NumaNodes() : replicas,
+      numThreads);
+  const size_t chunkBatches = (numReplicas == 1 || reconcileInterval == 0) ?
+      std::max<size_t>(numBatches, 1) : reconcileInterval;
+  std::vector<MatType> replicaIterates(numReplicas);
 
   // Iterate till the objective is within tolerance or the maximum number of
   // allowed iterations is reached. If maxIterations is 0, this will iterate
   // till convergence.
+  const size_t checkInterval = std::max(evaluationInterval, (size_t) 1);
   for (size_t i = 1; i != maxIterations; ++i)
   {
-    // Calculate the overall objective.
-    lastObjective = overallObjective;
+    // Calculate the overall objective, every checkInterval iterations.  The
+    // batches are evaluated by all the threads (there are no batch
+    // objectives to reuse, so Reuse() also takes a full pass).
+    if ((i - 1) % checkInterval == 0)
+    {
+      lastObjective = overallObjective;
 
-    overallObjective = function.Evaluate(iterate);
+      overallObjective = objectiveEstimate.IsReuse() ?
+          FullPassEvaluate(function, iterate, batchSize, parallelEvaluation) :
+          objectiveEstimate.Evaluate(function, iterate, batchSize,
+          parallelEvaluation);
 
-    // Output current objective function.
-    Info << "Parallel SGD: iteration " << i << ", objective "
-      << overallObjective << "." << std::endl;
+      // Output current objective function.
+      Info << "Parallel SGD: iteration " << i << ", objective "
+        << overallObjective << ".\n";
 
-    if (std::isnan(overallObjective) || std::isinf(overallObjective))
-    {
-      Warn << "Parallel SGD: converged to " << overallObjective
-        << "; terminating with failure. Try a smaller step size?"
-        << std::endl;
-      return overallObjective;
-    }
+      if (std::isnan(overallObjective) || std::isinf(overallObjective))
+      {
+        Warn << "Parallel SGD: converged to " << overallObjective
+          << "; terminating with failure. Try a smaller step size?"
+          << std::endl;
+        return overallObjective;
+      }
 
-    if (std::abs(lastObjective - overallObjective) < tolerance)
-    {
-      Info << "SGD: minimized within tolerance " << tolerance << "; "
-        << "terminating optimization." << std::endl;
-      return overallObjective;
+      if (std::abs(lastObjective - overallObjective) < tolerance)
+      {
+        Info << "SGD: minimized within tolerance " << tolerance << "; "
+          << "terminating optimization." << std::endl;
+        return overallObjective;
+      }
     }
 
     // Get the stepsize for this iteration
@@ -88,38 +153,89 @@ double ParallelSGD<DecayPolicyType>::Optimize(
       visitationOrder = arma::shuffle(visitationOrder);
     }
 
-    ENS_PRAGMA_OMP_PARALLEL
+    // The batches are visited in chunks of chunkBatches batches, after each
+    // of which the replicas are reconciled.  All batches are visited once per
+    // iteration.
+    for (size_t chunk = 0; chunk < numBatches; chunk += chunkBatches)
     {
-      // Each processor gets a subset of the instances.
-      // Each subset is of size threadShareSize
-      size_t threadId = 0;
-      #ifdef ENS_USE_OPENMP
-        threadId = omp_get_thread_num();
-      #endif
-
-      for (size_t j = threadId * threadShareSize;
-          j < (threadId + 1) * threadShareSize && j < visitationOrder.n_elem;
-          ++j)
+      const size_t chunkEnd = std::min(chunk + chunkBatches, numBatches);
+
+      // The next position in visitationOrder that has not been claimed by any
+      // thread.
+      std::atomic<size_t> nextBatch(chunk);
+
+      // The number of replicas used by the team of threads (which may have
+      // fewer threads than requested).
+      size_t activeReplicas = 1;
+
+      auto work = [&]()
       {
-        // Each instance affects only some components of the decision variable.
-        // So the gradient is sparse.
-        arma::sp_mat gradient;
+        // Each processor repeatedly claims the next threadShareSize
+        // instances, so that threads that get cheap instances simply claim
+        // more of them.
+        size_t threadId = 0;
+        size_t teamSize = 1;
+        #ifdef ENS_USE_OPENMP
+          threadId = omp_get_thread_num();
+          teamSize = omp_get_num_threads();
+        #endif
+        arma::sp_mat& gradient = gradients[threadId];
 
-        // Evaluate the sparse gradient.
-        function.Gradient(iterate, visitationOrder[j], gradient, 1);
+        // The threads are bound close to each other, so consecutive threads
+        // share a node; the first thread of each group copies the iterate into
+        // the replica of the group (allocating it, the first time, on its
+        // node).
+        const size_t teamReplicas = std::min(numReplicas, teamSize);
+        const size_t replica = threadId * teamReplicas / teamSize;
+        MatType& target = (numReplicas == 1) ? iterate :
+            replicaIterates[replica];
+        if (numReplicas > 1)
+        {
+          if (threadId == 0)
+            activeReplicas = teamReplicas;
+          if (threadId == 0 || (threadId - 1) * teamReplicas / teamSize !=
+              replica)
+          {
+            target = iterate;
+          }
+          ENS_PRAGMA_OMP_BARRIER
+        }
 
-        // Update the decision variable with non-zero components of the
-        // gradient.
-        for (size_t i = 0; i < gradient.n_cols; ++i)
+        for (size_t share = nextBatch.fetch_add(threadShareBatches);
+            share < chunkEnd; share = nextBatch.fetch_add(threadShareBatches))
         {
-          // Iterate over the non-zero elements.
-          for (arma::sp_mat::iterator cur = gradient.begin_col(i);
-              cur != gradient.end_col(i); ++cur)
+          const size_t shareEnd = std::min(share + threadShareBatches,
+              chunkEnd);
+          for (size_t j = share; j < shareEnd; ++j)
           {
-            ENS_PRAGMA_OMP_ATOMIC
-            iterate(cur.row(), i) -= stepSize * (*cur);
+            // The last batch may be smaller.
+            const size_t begin = visitationOrder[j] * batchSize;
+            const size_t effectiveBatchSize = std::min(batchSize,
+                numFunctions - begin);
+
+            // Update the decision variable with the non-zero components of
+            // the gradient of the whole batch.
+            UpdateBatch(function, target, begin, effectiveBatchSize, stepSize,
+                gradient, instPolicy, threadId, UseScatter());
           }
         }
+
+        // Make the remaining updates of this thread visible.
+        instPolicy.Flush(target, threadId);
+      };
+
+      if (numReplicas > 1)
+      {
+        ENS_PRAGMA_OMP_PARALLEL_CLOSE
+        work();
+
+        // Add the updates of all the replicas to the iterate.
+        Reconcile(iterate, replicaIterates, activeReplicas);
+      }
+      else
+      {
+        ENS_PRAGMA_OMP_PARALLEL
+        work();
       }
     }
   }
@@ -129,6 +245,74 @@ double ParallelSGD<DecayPolicyType>::Optimize(
   return overallObjective;
 }
 
+template <typename DecayPolicyType, typename UpdatePolicyType>
+template <typename SparseFunctionType, typename MatType, typename PolicyType>
+void ParallelSGD<DecayPolicyType, UpdatePolicyType>::UpdateBatch(
+    SparseFunctionType& function,
+    MatType& iterate,
+    const size_t begin,
+    const size_t batchSize,
+    const double stepSize,
+    arma::sp_mat& gradient,
+    PolicyType& policy,
+    const size_t threadId,
+    std::false_type /* useScatter */)
+{
+  function.Gradient(iterate, begin, gradient, batchSize);
+  policy.Update(iterate, stepSize, gradient, threadId);
+}
+
+template <typename DecayPolicyType, typename UpdatePolicyType>
+template <typename SparseFunctionType, typename MatType, typename PolicyType>
+void ParallelSGD<DecayPolicyType, UpdatePolicyType>::UpdateBatch(
+    SparseFunctionType& function,
+    MatType& iterate,
+    const size_t begin,
+    const size_t batchSize,
+    const double stepSize,
+    arma::sp_mat& /* gradient */,
+    PolicyType& policy,
+    const size_t threadId,
+    std::true_type /* useScatter */)
+{
+  typename PolicyType::Scatter scatter = policy.GetScatter(iterate, stepSize,
+      threadId);
+  function.ScatterGradient(iterate, begin, scatter, batchSize);
+  policy.Scattered(iterate, threadId);
+}
+
+template <typename DecayPolicyType, typename UpdatePolicyType>
+template <typename MatType>
+void ParallelSGD<DecayPolicyType, UpdatePolicyType>::Reconcile(
+    MatType& iterate,
+    const std::vector<MatType>& replicaIterates,
+    const size_t activeReplicas)
+{
+  MatType sum = replicaIterates[0];
+  for (size_t r = 1; r < activeReplicas; ++r)
+    sum += replicaIterates[r];
+  iterate = sum - (activeReplicas - 1.0) * iterate;
+}
+
+template <typename DecayPolicyType, typename UpdatePolicyType>
+void ParallelSGD<DecayPolicyType, UpdatePolicyType>::Reconcile(
+    HashedIterate& iterate,
+    const std::vector<HashedIterate>& replicaIterates,
+    const size_t activeReplicas)
+{
+  // The replicas only differ from the iterate in the coordinates they store.
+  const arma::sp_mat base = iterate.ToSparse();
+  for (size_t r = 0; r < activeReplicas; ++r)
+  {
+    const arma::sp_mat delta = replicaIterates[r].ToSparse() - base;
+    for (arma::sp_mat::const_iterator it = delta.begin(); it != delta.end();
+        ++it)
+    {
+      iterate(it.row(), it.col()) += (*it);
+    }
+  }
+}
+
 } // namespace ens
 
 #endif
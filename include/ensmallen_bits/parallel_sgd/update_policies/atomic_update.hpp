@@ -0,0 +1,122 @@
+/**
+ * @file atomic_update.hpp
+ *
+ * Atomic update policy for parallel Stochastic Gradient Descent.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PARALLEL_SGD_ATOMIC_UPDATE_HPP
+#define ENSMALLEN_PARALLEL_SGD_ATOMIC_UPDATE_HPP
+
+namespace ens {
+
+/**
+ * The AtomicUpdate policy applies every non-zero component of the sparse
+ * gradient to the shared iterate with an atomic operation.  No update is ever
+ * lost, but threads that touch the same (hot) coordinates serialize on them.
+ */
+class AtomicUpdate
+{
+ public:
+  /**
+   * The Policy class is instantiated by ParallelSGD for the given matrix and
+   * gradient types; it is shared by all threads.
+   *
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of the (sparse) gradient.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * Create the policy for an iterate of the given size.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the iterate.
+     * @param cols Number of columns in the iterate.
+     * @param numThreads Number of threads that will call Update().
+     */
+    Policy(const AtomicUpdate& /* parent */,
+           const size_t /* rows */,
+           const size_t /* cols */,
+           const size_t /* numThreads */)
+    { /* Nothing to do. */ }
+
+    /**
+     * Apply the given gradient to the shared iterate.
+     *
+     * @param iterate Shared parameters to update.
+     * @param stepSize Step size to use.
+     * @param gradient Sparse gradient to apply.
+     * @param threadId Index of the calling thread.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                const size_t /* threadId */)
+    {
+      for (size_t i = 0; i < gradient.n_cols; ++i)
+      {
+        for (typename GradType::const_iterator cur = gradient.begin_col(i);
+            cur != gradient.end_col(i); ++cur)
+        {
+          ENS_PRAGMA_OMP_ATOMIC
+          iterate(cur.row(), i) -= stepSize * (*cur);
+        }
+      }
+    }
+
+    /**
+     * Called by each thread once its share of an iteration is done; nothing is
+     * buffered by this policy.
+     */
+    void Flush(MatType& /* iterate */, const size_t /* threadId */) { }
+
+    /**
+     * The callback given to the ScatterGradient() method of a function, which
+     * applies each emitted component of the gradient to the shared iterate
+     * atomically.
+     */
+    class Scatter
+    {
+     public:
+      //! Apply the components to the given iterate with the given step size.
+      Scatter(MatType& iterate, const double stepSize) :
+          iterate(iterate), stepSize(stepSize) { }
+
+      //! Apply the given component of the gradient.
+      void operator()(const size_t row, const size_t col, const double value)
+      {
+        ENS_PRAGMA_OMP_ATOMIC
+        iterate(row, col) -= stepSize * value;
+      }
+
+     private:
+      //! The shared iterate.
+      MatType& iterate;
+      //! The step size.
+      double stepSize;
+    };
+
+    //! Get the callback that applies the components emitted by a function
+    //! for the calling thread.
+    Scatter GetScatter(MatType& iterate,
+                       const double stepSize,
+                       const size_t /* threadId */)
+    {
+      return Scatter(iterate, stepSize);
+    }
+
+    //! Called after the gradient of a batch has been scattered; nothing is
+    //! buffered by this policy.
+    void Scattered(MatType& /* iterate */, const size_t /* threadId */) { }
+  };
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,212 @@
+/**
+ * @file delta_buffer_update.hpp
+ *
+ * Per-thread delta buffer update policy for parallel Stochastic Gradient
+ * Descent.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PARALLEL_SGD_DELTA_BUFFER_UPDATE_HPP
+#define ENSMALLEN_PARALLEL_SGD_DELTA_BUFFER_UPDATE_HPP
+
+namespace ens {
+
+/**
+ * The DeltaBufferUpdate policy accumulates the updates of each thread in a
+ * private buffer, and applies the buffer to the shared iterate (atomically)
+ * after every flushInterval gradients and at the end of each iteration.
+ * Repeated updates of hot coordinates by one thread are therefore combined
+ * into a single atomic operation, at the cost of the updates of a thread
+ * becoming visible to the other threads only when the buffer is flushed.
+ *
+ * Each thread holds a dense buffer of the size of the iterate.
+ */
+class DeltaBufferUpdate
+{
+ public:
+  /**
+   * Construct the delta buffer update policy.
+   *
+   * @param flushInterval Number of gradients a thread accumulates before its
+   *     buffer is applied to the shared iterate.
+   */
+  DeltaBufferUpdate(const size_t flushInterval = 64) :
+      flushInterval(flushInterval)
+  { /* Nothing to do. */ }
+
+  //! Get the number of gradients accumulated before a flush.
+  size_t FlushInterval() const { return flushInterval; }
+  //! Modify the number of gradients accumulated before a flush.
+  size_t& FlushInterval() { return flushInterval; }
+
+  /**
+   * The Policy class is instantiated by ParallelSGD for the given matrix and
+   * gradient types; it is shared by all threads, each of which only touches
+   * its own buffer.
+   *
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of the (sparse) gradient.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * Create the per-thread buffers for an iterate of the given size.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the iterate.
+     * @param cols Number of columns in the iterate.
+     * @param numThreads Number of threads that will call Update().
+     */
+    Policy(const DeltaBufferUpdate& parent,
+           const size_t rows,
+           const size_t cols,
+           const size_t numThreads) :
+        parent(parent),
+        buffers(numThreads)
+    {
+      for (size_t i = 0; i < numThreads; ++i)
+        buffers[i].delta.zeros(rows, cols);
+    }
+
+    /**
+     * Accumulate the given gradient in the buffer of the calling thread, and
+     * flush the buffer if enough gradients have been accumulated.
+     *
+     * @param iterate Shared parameters to update.
+     * @param stepSize Step size to use.
+     * @param gradient Sparse gradient to apply.
+     * @param threadId Index of the calling thread.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                const size_t threadId)
+    {
+      Buffer& buffer = buffers[threadId];
+      for (size_t i = 0; i < gradient.n_cols; ++i)
+      {
+        for (typename GradType::const_iterator cur = gradient.begin_col(i);
+            cur != gradient.end_col(i); ++cur)
+        {
+          const size_t index = cur.row() + i * buffer.delta.n_rows;
+          if (buffer.delta[index] == 0)
+            buffer.indices.push_back(index);
+          buffer.delta[index] -= stepSize * (*cur);
+        }
+      }
+
+      if (++buffer.pending >= parent.FlushInterval())
+        Flush(iterate, threadId);
+    }
+
+    /**
+     * Apply the buffer of the calling thread to the shared iterate.
+     *
+     * @param iterate Shared parameters to update.
+     * @param threadId Index of the calling thread.
+     */
+    void Flush(MatType& iterate, const size_t threadId)
+    {
+      Buffer& buffer = buffers[threadId];
+      for (size_t i = 0; i < buffer.indices.size(); ++i)
+      {
+        const size_t index = buffer.indices[i];
+        ENS_PRAGMA_OMP_ATOMIC
+        iterate[index] += buffer.delta[index];
+        buffer.delta[index] = 0;
+      }
+
+      buffer.indices.clear();
+      buffer.pending = 0;
+    }
+
+    /**
+     * The callback given to the ScatterGradient() method of a function, which
+     * accumulates each emitted component of the gradient in the buffer of a
+     * thread.
+     */
+    class Scatter
+    {
+     public:
+      //! Accumulate the components in the given buffer with the given step
+      //! size.
+      Scatter(MatType& delta,
+              std::vector<size_t>& indices,
+              const double stepSize) :
+          delta(delta), indices(indices), stepSize(stepSize) { }
+
+      //! Accumulate the given component of the gradient.
+      void operator()(const size_t row, const size_t col, const double value)
+      {
+        const size_t index = row + col * delta.n_rows;
+        if (delta[index] == 0)
+          indices.push_back(index);
+        delta[index] -= stepSize * value;
+      }
+
+     private:
+      //! The accumulated update of the thread.
+      MatType& delta;
+      //! The indices with a non-zero accumulated update.
+      std::vector<size_t>& indices;
+      //! The step size.
+      double stepSize;
+    };
+
+    //! Get the callback that accumulates the components emitted by a function
+    //! in the buffer of the calling thread.
+    Scatter GetScatter(MatType& /* iterate */,
+                       const double stepSize,
+                       const size_t threadId)
+    {
+      Buffer& buffer = buffers[threadId];
+      return Scatter(buffer.delta, buffer.indices, stepSize);
+    }
+
+    /**
+     * Called after the gradient of a batch has been scattered; the buffer of
+     * the calling thread is flushed if enough gradients have been accumulated.
+     *
+     * @param iterate Shared parameters to update.
+     * @param threadId Index of the calling thread.
+     */
+    void Scattered(MatType& iterate, const size_t threadId)
+    {
+      if (++buffers[threadId].pending >= parent.FlushInterval())
+        Flush(iterate, threadId);
+    }
+
+   private:
+    //! Instantiated parent class.
+    const DeltaBufferUpdate& parent;
+
+    //! The private state of a single thread.
+    struct Buffer
+    {
+      Buffer() : pending(0) { }
+
+      //! The accumulated update.
+      MatType delta;
+      //! The indices with a non-zero accumulated update.
+      std::vector<size_t> indices;
+      //! The number of gradients accumulated since the last flush.
+      size_t pending;
+    };
+
+    //! The buffer of each thread.
+    std::vector<Buffer> buffers;
+  };
+
+ private:
+  //! The number of gradients accumulated before a flush.
+  size_t flushInterval;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,216 @@
+/**
+ * @file sparse_ada_grad_update.hpp
+ *
+ * Lock-free AdaGrad update policy for parallel Stochastic Gradient Descent.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PARALLEL_SGD_SPARSE_ADA_GRAD_UPDATE_HPP
+#define ENSMALLEN_PARALLEL_SGD_SPARSE_ADA_GRAD_UPDATE_HPP
+
+namespace ens {
+
+/**
+ * The SparseAdaGradUpdate policy gives every coordinate its own step size, as
+ * AdaGrad does: each thread adds the square of every non-zero component of its
+ * gradient to a shared accumulator, and updates the coordinate with the step
+ * size divided by the square root of the accumulator,
+ *
+ *   G_i += g_i^2
+ *   x_i -= stepSize * g_i / (sqrt(G_i) + epsilon).
+ *
+ * Only the non-zero coordinates of each gradient are visited, so rarely seen
+ * features keep large steps while frequent ones are damped.  As with
+ * HogwildUpdate, the accumulator and the iterate are written without
+ * synchronization; colliding updates are rare for sparse gradients, and at
+ * worst one of them loses a squared gradient or a step.  The step size of the
+ * decay policy is the global AdaGrad step size.
+ *
+ * The accumulator is a dense matrix of the size of the iterate, so this policy
+ * can't be used with a HashedIterate.
+ *
+ * For more information, see the following.
+ *
+ * @article{duchi2011adaptive,
+ *   author  = {Duchi, John and Hazan, Elad and Singer, Yoram},
+ *   title   = {Adaptive Subgradient Methods for Online Learning and Stochastic
+ *              Optimization},
+ *   journal = {Journal of Machine Learning Research},
+ *   volume  = {12},
+ *   number  = {Jul},
+ *   pages   = {2121--2159},
+ *   year    = {2011}
+ * }
+ */
+class SparseAdaGradUpdate
+{
+ public:
+  /**
+   * Construct the sparse AdaGrad update policy.
+   *
+   * @param epsilon Value added to the square root of the accumulator, to
+   *     avoid a division by zero.
+   * @param initialAccumulator Initial value of the accumulator of every
+   *     coordinate.
+   */
+  SparseAdaGradUpdate(const double epsilon = 1e-8,
+                      const double initialAccumulator = 0.0) :
+      epsilon(epsilon),
+      initialAccumulator(initialAccumulator)
+  { /* Nothing to do. */ }
+
+  //! Get the value used to avoid a division by zero.
+  double Epsilon() const { return epsilon; }
+  //! Modify the value used to avoid a division by zero.
+  double& Epsilon() { return epsilon; }
+
+  //! Get the initial value of the accumulator.
+  double InitialAccumulator() const { return initialAccumulator; }
+  //! Modify the initial value of the accumulator.
+  double& InitialAccumulator() { return initialAccumulator; }
+
+  /**
+   * The Policy class is instantiated by ParallelSGD for the given matrix and
+   * gradient types; it is shared by all threads, which share its accumulator.
+   *
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of the (sparse) gradient.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * Create the accumulator for an iterate of the given size.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the iterate.
+     * @param cols Number of columns in the iterate.
+     * @param numThreads Number of threads that will call Update().
+     */
+    Policy(const SparseAdaGradUpdate& parent,
+           const size_t rows,
+           const size_t cols,
+           const size_t /* numThreads */) :
+        epsilon(parent.Epsilon())
+    {
+      accumulator.set_size(rows, cols);
+      accumulator.fill(parent.InitialAccumulator());
+    }
+
+    /**
+     * Apply the given gradient to the shared iterate, coordinate by
+     * coordinate.
+     *
+     * @param iterate Shared parameters to update.
+     * @param stepSize Step size to use.
+     * @param gradient Sparse gradient to apply.
+     * @param threadId Index of the calling thread.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                const size_t /* threadId */)
+    {
+      for (size_t i = 0; i < gradient.n_cols; ++i)
+      {
+        for (typename GradType::const_iterator cur = gradient.begin_col(i);
+            cur != gradient.end_col(i); ++cur)
+        {
+          Apply(iterate, accumulator, epsilon, stepSize, cur.row(), i, *cur);
+        }
+      }
+    }
+
+    /**
+     * Called by each thread once its share of an iteration is done; nothing is
+     * buffered by this policy.
+     */
+    void Flush(MatType& /* iterate */, const size_t /* threadId */) { }
+
+    /**
+     * The callback given to the ScatterGradient() method of a function, which
+     * applies each emitted component of the gradient with its own step size.
+     */
+    class Scatter
+    {
+     public:
+      //! Apply the components to the given iterate with the given step size.
+      Scatter(MatType& iterate,
+              arma::mat& accumulator,
+              const double epsilon,
+              const double stepSize) :
+          iterate(iterate),
+          accumulator(accumulator),
+          epsilon(epsilon),
+          stepSize(stepSize)
+      { }
+
+      //! Apply the given component of the gradient.
+      void operator()(const size_t row, const size_t col, const double value)
+      {
+        Apply(iterate, accumulator, epsilon, stepSize, row, col, value);
+      }
+
+     private:
+      //! The shared iterate.
+      MatType& iterate;
+      //! The shared accumulator.
+      arma::mat& accumulator;
+      //! The value used to avoid a division by zero.
+      double epsilon;
+      //! The step size.
+      double stepSize;
+    };
+
+    //! Get the callback that applies the components emitted by a function
+    //! for the calling thread.
+    Scatter GetScatter(MatType& iterate,
+                       const double stepSize,
+                       const size_t /* threadId */)
+    {
+      return Scatter(iterate, accumulator, epsilon, stepSize);
+    }
+
+    //! Called after the gradient of a batch has been scattered; nothing is
+    //! buffered by this policy.
+    void Scattered(MatType& /* iterate */, const size_t /* threadId */) { }
+
+    //! Get the accumulated squared gradients.
+    const arma::mat& Accumulator() const { return accumulator; }
+
+   private:
+    //! Apply one component of the gradient to the iterate.
+    static void Apply(MatType& iterate,
+                      arma::mat& accumulator,
+                      const double epsilon,
+                      const double stepSize,
+                      const size_t row,
+                      const size_t col,
+                      const double value)
+    {
+      double& squaredGradient = accumulator(row, col);
+      squaredGradient += value * value;
+      iterate(row, col) -= stepSize * value /
+          (std::sqrt(squaredGradient) + epsilon);
+    }
+
+    //! The value used to avoid a division by zero.
+    double epsilon;
+    //! The sum of the squared gradients of each coordinate.
+    arma::mat accumulator;
+  };
+
+ private:
+  //! The value used to avoid a division by zero.
+  double epsilon;
+  //! The initial value of the accumulator.
+  double initialAccumulator;
+};
+
+} // namespace ens
+
+#endif
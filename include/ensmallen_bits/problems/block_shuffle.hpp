@@ -0,0 +1,54 @@
+/**
+ * @file block_shuffle.hpp
+ *
+ * Shuffle the visitation order of a dataset in blocks of consecutive points.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_BLOCK_SHUFFLE_HPP
+#define ENSMALLEN_PROBLEMS_BLOCK_SHUFFLE_HPP
+
+namespace ens {
+namespace test {
+
+/**
+ * Return a random visitation order of n points, in which the blocks of
+ * blockSize consecutive points are shuffled but the points within each block
+ * stay together and in order (the last block may be shorter).  A block size of
+ * 1 gives a uniformly random permutation; larger blocks keep reading batches
+ * from contiguous memory.
+ *
+ * @param n Number of points.
+ * @param blockSize Number of consecutive points in each block.
+ * @return Shuffled indices of the points.
+ */
+inline arma::uvec BlockShuffle(const size_t n, const size_t blockSize = 1)
+{
+  const size_t size = std::max(blockSize, size_t(1));
+  const size_t numBlocks = (n + size - 1) / size;
+  if (numBlocks == 0)
+    return arma::uvec();
+
+  const arma::uvec blockOrder = arma::shuffle(arma::linspace<arma::uvec>(0,
+      numBlocks - 1, numBlocks));
+
+  arma::uvec ordering(n);
+  size_t j = 0;
+  for (size_t b = 0; b < numBlocks; ++b)
+  {
+    const size_t first = blockOrder[b] * size;
+    const size_t last = std::min(first + size, n);
+    for (size_t i = first; i < last; ++i)
+      ordering[j++] = i;
+  }
+
+  return ordering;
+}
+
+} // namespace test
+} // namespace ens
+
+#endif
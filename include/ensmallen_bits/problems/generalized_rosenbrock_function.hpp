@@ -27,7 +27,10 @@ namespace test {
  * This function can also be used for stochastic gradient descent (SGD) as a
  * decomposable function (DecomposableFunctionType), so there are other
  * overloads of Evaluate() and Gradient() implemented, as well as
- * NumFunctions().
+ * NumFunctions().  Until Shuffle() is called, the terms of a batch are
+ * contiguous, and are computed by branch-free loops over the coordinates
+ * that the compiler can vectorize; after it, the coordinates of each term are
+ * gathered through the visitation order.
  *
  * For more information, please refer to:
  *
@@ -116,13 +119,26 @@ class GeneralizedRosenbrockFunction
   void Gradient(const arma::mat& coordinates, arma::mat& gradient) const;
 
  private:
+  //! Evaluate the terms first, ..., first + count - 1.
+  double ContiguousEvaluate(const arma::mat& coordinates,
+                            const size_t first,
+                            const size_t count) const;
+
+  //! Store the gradient of the terms first, ..., first + count - 1 in the
+  //! coordinates first, ..., first + count, which are overwritten (the other
+  //! coordinates are not touched).
+  void ContiguousGradient(const arma::mat& coordinates,
+                          const size_t first,
+                          const size_t count,
+                          double* gradient) const;
+
   //! Locally-stored Initial point.
   arma::mat initialPoint;
 
   //! //! Number of dimensions for the function.
   size_t n;
 
-  //! For shuffling.
+  //! For shuffling (empty if the terms are visited in order).
   arma::Row<size_t> visitationOrder;
 };
 
@@ -21,9 +21,7 @@ namespace test {
 
 inline GeneralizedRosenbrockFunction::GeneralizedRosenbrockFunction(
     const size_t n) :
-    n(n),
-    visitationOrder(arma::linspace<arma::Row<size_t> >(0, n - 1, n))
-
+    n(n)
 {
   initialPoint.set_size(n, 1);
   for (size_t i = 0; i < n; i++) // Set to [-1.2 1 -1.2 1 ...].
@@ -45,17 +43,62 @@ inline void GeneralizedRosenbrockFunction::Shuffle()
       n - 1));
 }
 
+inline double GeneralizedRosenbrockFunction::ContiguousEvaluate(
+    const arma::mat& coordinates,
+    const size_t first,
+    const size_t count) const
+{
+  const double* x = coordinates.memptr() + first;
+  double objective = 0.0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    const double d = x[i] * x[i] - x[i + 1];
+    const double e = 1.0 - x[i];
+    objective += 100.0 * d * d + e * e;
+  }
+
+  return objective;
+}
+
+inline void GeneralizedRosenbrockFunction::ContiguousGradient(
+    const arma::mat& coordinates,
+    const size_t first,
+    const size_t count,
+    double* gradient) const
+{
+  if (count == 0)
+    return;
+
+  // Coordinate i gets the first part of the gradient of term i and the second
+  // part of the gradient of term i - 1, so that every iteration writes its own
+  // coordinate only and the loop has no dependency between iterations.
+  const double* x = coordinates.memptr() + first;
+  double* g = gradient + first;
+
+  g[0] = 400.0 * x[0] * (x[0] * x[0] - x[1]) + 2.0 * (x[0] - 1.0);
+  for (size_t i = 1; i < count; ++i)
+  {
+    g[i] = 400.0 * x[i] * (x[i] * x[i] - x[i + 1]) + 2.0 * (x[i] - 1.0) +
+        200.0 * (x[i] - x[i - 1] * x[i - 1]);
+  }
+  g[count] = 200.0 * (x[count] - x[count - 1] * x[count - 1]);
+}
+
 inline double GeneralizedRosenbrockFunction::Evaluate(
     const arma::mat& coordinates,
     const size_t begin,
     const size_t batchSize) const
 {
+  if (visitationOrder.is_empty())
+    return ContiguousEvaluate(coordinates, begin, batchSize);
+
   double objective = 0.0;
   for (size_t j = begin; j < begin + batchSize; ++j)
   {
     const size_t p = visitationOrder[j];
-    objective += 100 * std::pow((std::pow(coordinates[p], 2)
-        - coordinates[p + 1]), 2) + std::pow(1 - coordinates[p], 2);
+    const double d = coordinates[p] * coordinates[p] - coordinates[p + 1];
+    const double e = 1.0 - coordinates[p];
+    objective += 100.0 * d * d + e * e;
   }
 
   return objective;
@@ -64,14 +107,7 @@ inline double GeneralizedRosenbrockFunction::Evaluate(
 inline double GeneralizedRosenbrockFunction::Evaluate(
     const arma::mat& coordinates) const
 {
-  double fval = 0;
-  for (size_t i = 0; i < (n - 1); i++)
-  {
-    fval += 100 * std::pow(std::pow(coordinates[i], 2) -
-        coordinates[i + 1], 2) + std::pow(1 - coordinates[i], 2);
-  }
-
-  return fval;
+  return ContiguousEvaluate(coordinates, 0, n - 1);
 }
 
 inline void GeneralizedRosenbrockFunction::Gradient(
@@ -81,12 +117,19 @@ inline void GeneralizedRosenbrockFunction::Gradient(
     const size_t batchSize) const
 {
   gradient.zeros(n);
+  if (visitationOrder.is_empty())
+  {
+    ContiguousGradient(coordinates, begin, batchSize, gradient.memptr());
+    return;
+  }
+
+  // Neighbouring terms share a coordinate, so their gradients are added.
   for (size_t j = begin; j < begin + batchSize; ++j)
   {
     const size_t p = visitationOrder[j];
-    gradient[p] = 400 * (std::pow(coordinates[p], 3) - coordinates[p] *
-        coordinates[p + 1]) + 2 * (coordinates[p] - 1);
-    gradient[p + 1] = 200 * (coordinates[p + 1] - std::pow(coordinates[p], 2));
+    const double d = coordinates[p] * coordinates[p] - coordinates[p + 1];
+    gradient[p] += 400.0 * coordinates[p] * d + 2.0 * (coordinates[p] - 1.0);
+    gradient[p + 1] -= 200.0 * d;
   }
 }
 
@@ -95,17 +138,7 @@ inline void GeneralizedRosenbrockFunction::Gradient(
     arma::mat& gradient) const
 {
   gradient.set_size(n);
-  for (size_t i = 0; i < (n - 1); i++)
-  {
-    gradient[i] = 400 * (std::pow(coordinates[i], 3) - coordinates[i] *
-        coordinates[i + 1]) + 2 * (coordinates[i] - 1);
-
-    if (i > 0)
-      gradient[i] += 200 * (coordinates[i] - std::pow(coordinates[i - 1], 2));
-  }
-
-  gradient[n - 1] = 200 * (coordinates[n - 1] -
-      std::pow(coordinates[n - 2], 2));
+  ContiguousGradient(coordinates, 0, n - 1, gradient.memptr());
 }
 
 inline void GeneralizedRosenbrockFunction::Gradient(
@@ -114,16 +147,24 @@ inline void GeneralizedRosenbrockFunction::Gradient(
     arma::sp_mat& gradient,
     const size_t batchSize) const
 {
-  gradient.set_size(n);
-
-  for (size_t j = begin; j < begin + batchSize; ++j)
+  // Each term has two nonzeros; the batch constructor adds those of
+  // neighbouring terms that share a coordinate.
+  arma::umat locations(2, 2 * batchSize, arma::fill::zeros);
+  arma::vec values(2 * batchSize);
+  for (size_t j = 0; j < batchSize; ++j)
   {
-    const size_t p = visitationOrder[j];
-
-    gradient[p] = 400 * (std::pow(coordinates[p], 3) - coordinates[p] *
-        coordinates[p + 1]) + 2 * (coordinates[p] - 1);
-    gradient[p + 1] = 200 * (coordinates[p + 1] - std::pow(coordinates[p], 2));
+    const size_t p = visitationOrder.is_empty() ? begin + j :
+        visitationOrder[begin + j];
+    const double d = coordinates[p] * coordinates[p] - coordinates[p + 1];
+
+    locations(0, 2 * j) = p;
+    values[2 * j] = 400.0 * coordinates[p] * d + 2.0 * (coordinates[p] - 1.0);
+    locations(0, 2 * j + 1) = p + 1;
+    values[2 * j + 1] = -200.0 * d;
   }
+
+  // The gradient may be reused between calls, so it is rebuilt entirely.
+  gradient = arma::sp_mat(true, locations, values, n, 1);
 }
 
 } // namespace test
@@ -0,0 +1,136 @@
+/**
+ * @file lasso_function.hpp
+ *
+ * The lasso objective, with a gap safe screening rule for coordinate descent.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_LASSO_FUNCTION_HPP
+#define ENSMALLEN_PROBLEMS_LASSO_FUNCTION_HPP
+
+#include <vector>
+
+namespace ens {
+namespace test {
+
+/**
+ * The lasso objective
+ *
+ * \f[
+ * f(w) = \frac{1}{2} \| y - w X \|^2 + \lambda \| w \|_1
+ * \f]
+ *
+ * for a row vector of weights w of one weight per feature, where each column
+ * of X is a point and y holds the response of each point.  The partial
+ * gradient of a feature is the subgradient of the smallest magnitude, so
+ * weights at zero stay there when that is optimal.
+ *
+ * The function implements the gap safe screening rule of Fercoq et al.
+ * ("Mind the Duality Gap: Safer Rules for the Lasso", 2015): from the residual
+ * r = y - w X, the dual point theta = r / max(lambda, ||X r^T||_inf) gives the
+ * duality gap G, and a feature j is zero at the optimum if
+ * |x_j theta^T| + sqrt(2 G) / lambda ||x_j|| < 1.  The rule is used by SCD,
+ * and removes more features the closer w is to the optimum.
+ */
+class LassoFunction
+{
+ public:
+  /**
+   * Create the lasso objective of the given data.
+   *
+   * @param predictors The points, one per column.
+   * @param responses The response of each point.
+   * @param lambda The L1 regularization parameter.
+   */
+  LassoFunction(const arma::mat& predictors,
+                const arma::rowvec& responses,
+                const double lambda);
+
+  //! Return the number of features.
+  size_t NumFeatures() const { return predictors.n_rows; }
+
+  //! Get the starting point (all weights zero).
+  arma::mat GetInitialPoint() const
+  {
+    return arma::zeros<arma::mat>(1, predictors.n_rows);
+  }
+
+  //! Evaluate the objective at the given weights.
+  double Evaluate(const arma::mat& coordinates) const;
+
+  /**
+   * Compute the subgradient of the smallest magnitude with respect to weight
+   * j.
+   *
+   * @param coordinates The weights.
+   * @param j The feature to compute the partial gradient of.
+   * @param gradient Sparse matrix to output the gradient into.
+   */
+  void PartialGradient(const arma::mat& coordinates,
+                       const size_t j,
+                       arma::sp_mat& gradient) const;
+
+  /**
+   * Compute the subgradient of the smallest magnitude with respect to weight
+   * j, as a scalar.
+   *
+   * @param coordinates The weights.
+   * @param j The feature to compute the derivative of.
+   * @param row Row of the weight (must be 0).
+   */
+  double PartialDerivative(const arma::mat& coordinates,
+                           const size_t j,
+                           const size_t row) const;
+
+  /**
+   * Compute the duality gap of the given weights, which bounds how far their
+   * objective is from the optimum.
+   *
+   * @param coordinates The weights.
+   */
+  double DualityGap(const arma::mat& coordinates) const;
+
+  /**
+   * Mark the features that the gap safe rule proves to be zero at the optimum
+   * as inactive.  This takes one pass over the data.
+   *
+   * @param coordinates The weights.
+   * @param active Whether each feature is active (will be modified).
+   */
+  void ScreenFeatures(const arma::mat& coordinates,
+                      std::vector<bool>& active) const;
+
+  //! Get the L1 regularization parameter.
+  double Lambda() const { return lambda; }
+  //! Modify the L1 regularization parameter.
+  double& Lambda() { return lambda; }
+
+ private:
+  /**
+   * Compute the duality gap, the correlations of the features with the
+   * residual, and the scaling of the residual that gives the dual point.
+   */
+  double Gap(const arma::mat& coordinates,
+             arma::vec& correlations,
+             double& scale) const;
+
+  //! The points, one per column.
+  arma::mat predictors;
+  //! The response of each point.
+  arma::rowvec responses;
+  //! The L1 regularization parameter.
+  double lambda;
+  //! The norm of each feature.
+  arma::vec featureNorms;
+};
+
+} // namespace test
+} // namespace ens
+
+// Include implementation.
+#include "lasso_function_impl.hpp"
+
+#endif
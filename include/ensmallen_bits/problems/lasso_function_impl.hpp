@@ -0,0 +1,120 @@
+/**
+ * @file lasso_function_impl.hpp
+ *
+ * Implementation of the lasso objective and its gap safe screening rule.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_LASSO_FUNCTION_IMPL_HPP
+#define ENSMALLEN_PROBLEMS_LASSO_FUNCTION_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "lasso_function.hpp"
+
+namespace ens {
+namespace test {
+
+inline LassoFunction::LassoFunction(const arma::mat& predictors,
+                                    const arma::rowvec& responses,
+                                    const double lambda) :
+    predictors(predictors),
+    responses(responses),
+    lambda(lambda)
+{
+  if (responses.n_elem != predictors.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "LassoFunction::LassoFunction(): predictors matrix has "
+        << predictors.n_cols << " points, but responses vector has "
+        << responses.n_elem << " elements (should be " << predictors.n_cols
+        << ")!";
+    throw std::logic_error(oss.str());
+  }
+
+  featureNorms = arma::sqrt(arma::sum(arma::square(predictors), 1));
+}
+
+inline double LassoFunction::Evaluate(const arma::mat& coordinates) const
+{
+  const arma::rowvec residual = responses - coordinates * predictors;
+  return 0.5 * arma::accu(arma::square(residual)) +
+      lambda * arma::accu(arma::abs(coordinates));
+}
+
+inline void LassoFunction::PartialGradient(const arma::mat& coordinates,
+                                           const size_t j,
+                                           arma::sp_mat& gradient) const
+{
+  const double derivative = PartialDerivative(coordinates, j, 0);
+
+  gradient.zeros(arma::size(coordinates));
+  if (derivative != 0)
+    gradient[j] = derivative;
+}
+
+inline double LassoFunction::PartialDerivative(const arma::mat& coordinates,
+                                               const size_t j,
+                                               const size_t /* row */) const
+{
+  const arma::rowvec residual = responses - coordinates * predictors;
+  const double smooth = -arma::accu(predictors.row(j) % residual);
+
+  if (coordinates[j] != 0)
+    return smooth + ((coordinates[j] > 0) ? lambda : -lambda);
+
+  // Zero is not optimal; take the subgradient closest to zero.
+  if (std::abs(smooth) > lambda)
+    return smooth - ((smooth > 0) ? lambda : -lambda);
+
+  return 0.0;
+}
+
+inline double LassoFunction::Gap(const arma::mat& coordinates,
+                                 arma::vec& correlations,
+                                 double& scale) const
+{
+  const arma::rowvec residual = responses - coordinates * predictors;
+  correlations = predictors * residual.t();
+  const double largest = arma::abs(correlations).max();
+  scale = std::max(lambda, largest);
+
+  // The dual objective at theta = residual / scale.
+  const double primal = 0.5 * arma::accu(arma::square(residual)) +
+      lambda * arma::accu(arma::abs(coordinates));
+  const double dual = 0.5 * arma::accu(arma::square(responses)) -
+      0.5 * arma::accu(arma::square(responses - (lambda / scale) * residual));
+
+  return std::max(primal - dual, 0.0);
+}
+
+inline double LassoFunction::DualityGap(const arma::mat& coordinates) const
+{
+  arma::vec correlations;
+  double scale;
+  return Gap(coordinates, correlations, scale);
+}
+
+inline void LassoFunction::ScreenFeatures(const arma::mat& coordinates,
+                                          std::vector<bool>& active) const
+{
+  arma::vec correlations;
+  double scale;
+  const double gap = Gap(coordinates, correlations, scale);
+
+  // The optimal dual point is within this distance of theta.
+  const double radius = std::sqrt(2.0 * gap) / lambda;
+  for (size_t j = 0; j < active.size(); ++j)
+  {
+    if (active[j] && std::abs(correlations[j]) / scale +
+        radius * featureNorms[j] < 1.0)
+      active[j] = false;
+  }
+}
+
+} // namespace test
+} // namespace ens
+
+#endif
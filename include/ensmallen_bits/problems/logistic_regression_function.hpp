@@ -14,6 +14,8 @@
 #ifndef ENSMALLEN_PROBLEMS_LOGISTIC_REGRESSION_FUNCTION_HPP
 #define ENSMALLEN_PROBLEMS_LOGISTIC_REGRESSION_FUNCTION_HPP
 
+#include "block_shuffle.hpp"
+
 namespace ens {
 namespace test {
 
@@ -26,10 +28,30 @@ template<typename MatType = arma::mat>
 class LogisticRegressionFunction
 {
  public:
+  /**
+   * Construct the logistic regression function on the given data.  The
+   * predictors and responses are aliased, not copied, so they must outlive the
+   * function; a matrix from ens::MappedMatrix can be given, to use a dataset
+   * that is memory-mapped from disk.  The first call to Shuffle() makes an
+   * owned, shuffled copy of the data.
+   *
+   * @param predictors Matrix of data points (one per column).
+   * @param responses Labels of the data points (0 or 1).
+   * @param lambda L2-regularization constant.
+   */
   LogisticRegressionFunction(const MatType& predictors,
                              const arma::Row<size_t>& responses,
                              const double lambda = 0);
 
+  /**
+   * Construct the logistic regression function on the given data, with the
+   * given initial point.  As above, the data is aliased, not copied.
+   *
+   * @param predictors Matrix of data points (one per column).
+   * @param responses Labels of the data points (0 or 1).
+   * @param initialPoint Initial point for the optimization.
+   * @param lambda L2-regularization constant.
+   */
   LogisticRegressionFunction(const MatType& predictors,
                              const arma::Row<size_t>& responses,
                              const arma::vec& initialPoint,
@@ -50,8 +72,24 @@ class LogisticRegressionFunction
   //! Return the vector of responses.
   const arma::Row<size_t>& Responses() const { return responses; }
 
+  //! Get whether Shuffle() permutes the visitation order instead of the data.
+  bool IndexShuffle() const { return indexShuffle; }
+  //! Modify whether Shuffle() permutes the visitation order instead of the
+  //! data.
+  bool& IndexShuffle() { return indexShuffle; }
+
+  //! Get the number of consecutive points kept together by an index shuffle.
+  size_t ShuffleBlockSize() const { return shuffleBlockSize; }
+  //! Modify the number of consecutive points kept together by an index
+  //! shuffle.
+  size_t& ShuffleBlockSize() { return shuffleBlockSize; }
+
   /**
   * Shuffle the order of function visitation.  This may be called by the optimizer.
+  * By default the predictors and responses are reordered, which copies the
+  * data.  If IndexShuffle() is true, only a vector of indices is shuffled (in
+  * blocks of ShuffleBlockSize() consecutive points; see BlockShuffle()), and
+  * each batch is gathered through it.
   */
   void Shuffle();
 
@@ -132,6 +170,165 @@ class LogisticRegressionFunction
                        const size_t j,
                        arma::sp_mat& gradient) const;
 
+  /**
+   * Evaluate the derivative of the logistic regression log-likelihood function
+   * with respect to parameter j, as a scalar.  This is used by SCD instead of
+   * PartialGradient(), to avoid building a sparse matrix for each step.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param j Index of the feature with respect to which the derivative is to
+   *    be computed.
+   * @param row Row of the parameter (must be 0).
+   */
+  double PartialDerivative(const arma::mat& parameters,
+                           const size_t j,
+                           const size_t row) const;
+
+  /**
+   * Return the Lipschitz constant of the derivative with respect to parameter
+   * j: the number of points over four for the intercept, and the squared norm
+   * of the feature over four plus lambda for the other parameters.  SCD uses
+   * one over it as the step size of the feature.
+   *
+   * @param j Index of the feature.
+   */
+  double CoordinateLipschitz(const size_t j) const;
+
+  /**
+   * Evaluate the gradient of the logistic regression log-likelihood function
+   * with the given parameters, with respect to the block of features begin,
+   * ..., begin + blockSize - 1.  The predictions are only computed once for
+   * the whole block.  This is used by SCD in block coordinate descent mode.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param begin Index of the first feature of the block.
+   * @param gradient Dense matrix to output the gradient of the block into.
+   * @param blockSize Number of features in the block.
+   */
+  void PartialGradient(const arma::mat& parameters,
+                       const size_t begin,
+                       arma::mat& gradient,
+                       const size_t blockSize) const;
+
+  /**
+   * Cache the decision value (margin) of every point at the given parameters,
+   * so that the objective can be tracked incrementally by coordinate descent.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   */
+  void ResetCache(const arma::mat& parameters);
+
+  /**
+   * Update the cached margins after parameter j changed by delta; this takes
+   * one pass over feature j of the data.
+   *
+   * @param parameters New vector of logistic regression parameters.
+   * @param j Index of the parameter that changed.
+   * @param delta Change of the parameter (a 1x1 matrix).
+   */
+  void UpdateCache(const arma::mat& parameters,
+                   const size_t j,
+                   const arma::mat& delta);
+
+  /**
+   * Evaluate the objective at the cached parameters from the cached margins,
+   * without a pass over the predictors.
+   */
+  double CachedEvaluate() const;
+
+  /**
+   * Evaluate the gradient of the logistic regression log-likelihood function
+   * for the given batch at two sets of parameters at once.  Both gradients are
+   * computed with one pass over the points of the batch, which saves memory
+   * traffic for the variance-reduced optimizers (SVRG, SARAH, Katyusha) that
+   * need the gradient of each batch at the current and at a reference point.
+   *
+   * @param parameters First vector of logistic regression parameters.
+   * @param parameters2 Second vector of logistic regression parameters.
+   * @param begin Index of the starting point to use for objective function
+   *     gradient evaluation.
+   * @param gradient Vector to output the gradient at parameters into.
+   * @param gradient2 Vector to output the gradient at parameters2 into.
+   * @param batchSize Number of points to be processed as a batch for objective
+   *     function gradient evaluation.
+   */
+  template<typename GradType>
+  void DualGradient(const arma::mat& parameters,
+                    const arma::mat& parameters2,
+                    const size_t begin,
+                    GradType& gradient,
+                    GradType& gradient2,
+                    const size_t batchSize = 1) const;
+
+  /**
+   * Evaluate the gradient of the logistic regression log-likelihood function
+   * for the given batch, together with the sum of the squared norms of the
+   * gradients of its points (each with its share of the regularization term).
+   * Both are computed with one pass over the points of the batch, without
+   * forming the gradient of each point; big-batch SGD uses them to estimate
+   * the variance of the gradients of the batch.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param begin Index of the starting point to use for objective function
+   *     gradient evaluation.
+   * @param gradient Vector to output the gradient of the batch into.
+   * @param sumSquaredNorms Sum of the squared norms of the gradients of the
+   *     points in the batch.
+   * @param batchSize Number of points to be processed as a batch for objective
+   *     function gradient evaluation.
+   */
+  template<typename GradType>
+  void GradientStatistics(const arma::mat& parameters,
+                          const size_t begin,
+                          GradType& gradient,
+                          double& sumSquaredNorms,
+                          const size_t batchSize = 1) const;
+
+  /**
+   * Compute the derivative of the loss of each point in the given batch with
+   * respect to its linear predictor; the gradient of the loss of point i is
+   * this coefficient times the point (with a leading 1 for the intercept).
+   * This is used by optimizers that store one scalar per point instead of one
+   * gradient per point, such as SAGA with LinearGradientMemory.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param begin Index of the first point in the batch.
+   * @param coefficients Row vector to store the coefficients in.
+   * @param batchSize Number of points in the batch.
+   */
+  void GradientCoefficients(const arma::mat& parameters,
+                            const size_t begin,
+                            arma::rowvec& coefficients,
+                            const size_t batchSize = 1) const;
+
+  /**
+   * Compute the sum of the points in the given batch weighted by the given
+   * coefficients, i.e. the gradient of the loss of the batch (without
+   * regularization) if the coefficients are the ones given by
+   * GradientCoefficients().
+   *
+   * @param parameters Vector of logistic regression parameters (only used for
+   *     the shape of the gradient).
+   * @param begin Index of the first point in the batch.
+   * @param coefficients Coefficient of each point in the batch.
+   * @param gradient Matrix to output the weighted sum into.
+   * @param batchSize Number of points in the batch.
+   */
+  void CoefficientGradient(const arma::mat& parameters,
+                           const size_t begin,
+                           const arma::rowvec& coefficients,
+                           arma::mat& gradient,
+                           const size_t batchSize = 1) const;
+
+  /**
+   * Compute the gradient of the regularization of the whole objective.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param gradient Matrix to output the gradient into.
+   */
+  void RegularizationGradient(const arma::mat& parameters,
+                              arma::mat& gradient) const;
+
   /**
    * Evaluate the objective function and gradient of the logistic regression
    * log-likelihood function simultaneously with the given parameters.
@@ -193,6 +390,19 @@ class LogisticRegressionFunction
                 const double decisionBoundary = 0.5) const;
 
  private:
+  //! Get the predictors of the given batch: an alias of the data, or a copy of
+  //! the gathered points if the visitation order is shuffled.
+  MatType BatchPredictors(const size_t begin, const size_t batchSize) const;
+
+  //! Get the responses of the given batch: an alias of the data, or a copy of
+  //! the gathered responses if the visitation order is shuffled.
+  arma::Row<size_t> BatchResponses(const size_t begin,
+                                   const size_t batchSize) const;
+
+  //! Compute the objective (without the regularization) from the margins of
+  //! all the points.
+  double MarginObjective(const arma::rowvec& margins) const;
+
   //! The initial point, from which to start the optimization.
   arma::mat initialPoint;
   //! The matrix of data points (predictors).  This is an alias until shuffling
@@ -203,6 +413,16 @@ class LogisticRegressionFunction
   arma::Row<size_t> responses;
   //! The regularization parameter for L2-regularization.
   double lambda;
+  //! Whether Shuffle() permutes the visitation order instead of the data.
+  bool indexShuffle;
+  //! The number of consecutive points kept together by an index shuffle.
+  size_t shuffleBlockSize;
+  //! The visitation order of the points (empty if it is not shuffled).
+  arma::uvec visitationOrder;
+  //! The cached margin of each point (see ResetCache()).
+  arma::rowvec cachedMargins;
+  //! The cached squared norm of the parameters, without the intercept.
+  double cachedSquaredNorm;
 };
 
 // Convenience typedefs.
@@ -215,4 +435,7 @@ using LogisticRegression = LogisticRegressionFunction<MatType>;
 // Include implementation.
 #include "logistic_regression_function_impl.hpp"
 
+// Include the specialization for sparse predictors.
+#include "sparse_logistic_regression_function.hpp"
+
 #endif // ENSMALLEN_PROBLEMS_LOGISTIC_REGRESSION_FUNCTION_HPP
@@ -29,7 +29,10 @@ LogisticRegressionFunction<MatType>::LogisticRegressionFunction(
     responses(arma::Row<size_t>(
         const_cast<arma::Row<size_t>&>(responses).memptr(),
         responses.n_elem, false, false)),
-    lambda(lambda)
+    lambda(lambda),
+    indexShuffle(false),
+    shuffleBlockSize(1),
+    cachedSquaredNorm(0)
 {
   initialPoint = arma::rowvec(predictors.n_rows + 1, arma::fill::zeros);
 
@@ -57,7 +60,10 @@ LogisticRegressionFunction<MatType>::LogisticRegressionFunction(
     responses(arma::Row<size_t>(
         const_cast<arma::Row<size_t>&>(responses).memptr(),
         responses.n_elem, false, false)),
-    lambda(lambda)
+    lambda(lambda),
+    indexShuffle(false),
+    shuffleBlockSize(1),
+    cachedSquaredNorm(0)
 {
   // To check if initialPoint is compatible with predictors.
   if (initialPoint.n_rows != (predictors.n_rows + 1) ||
@@ -71,6 +77,12 @@ LogisticRegressionFunction<MatType>::LogisticRegressionFunction(
 template<typename MatType>
 void LogisticRegressionFunction<MatType>::Shuffle()
 {
+  if (indexShuffle)
+  {
+    visitationOrder = BlockShuffle(predictors.n_cols, shuffleBlockSize);
+    return;
+  }
+
   MatType newPredictors;
   arma::Row<size_t> newResponses;
 
@@ -80,6 +92,10 @@ void LogisticRegressionFunction<MatType>::Shuffle()
   newPredictors = predictors.cols(ordering);
   newResponses = responses.cols(ordering);
 
+  // Keep the cached margins in the order of the points.
+  if (!cachedMargins.is_empty())
+    cachedMargins = cachedMargins.cols(ordering);
+
   // If we are an alias, make sure we don't write to the original data.
   if (predictors.mem_state >= 1)
     predictors.reset();
@@ -90,6 +106,39 @@ void LogisticRegressionFunction<MatType>::Shuffle()
   // Take ownership of the new data.
   predictors = std::move(newPredictors);
   responses = std::move(newResponses);
+  visitationOrder.reset();
+}
+
+template<typename MatType>
+MatType LogisticRegressionFunction<MatType>::BatchPredictors(
+    const size_t begin,
+    const size_t batchSize) const
+{
+  if (!visitationOrder.is_empty())
+  {
+    return MatType(predictors.cols(visitationOrder.subvec(begin,
+        begin + batchSize - 1)));
+  }
+
+  // We promise to be well-behaved... the elements won't be modified.
+  return MatType(const_cast<MatType&>(predictors).colptr(begin),
+      predictors.n_rows, batchSize, false, true);
+}
+
+template<typename MatType>
+arma::Row<size_t> LogisticRegressionFunction<MatType>::BatchResponses(
+    const size_t begin,
+    const size_t batchSize) const
+{
+  if (!visitationOrder.is_empty())
+  {
+    return arma::Row<size_t>(responses.cols(visitationOrder.subvec(begin,
+        begin + batchSize - 1)));
+  }
+
+  // We promise to be well-behaved... the elements won't be modified.
+  return arma::Row<size_t>(const_cast<arma::Row<size_t>&>(responses).memptr() +
+      begin, batchSize, false, true);
 }
 
 /**
@@ -113,10 +162,18 @@ double LogisticRegressionFunction<MatType>::Evaluate(
       arma::dot(parameters.tail_cols(parameters.n_elem - 1),
       parameters.tail_cols(parameters.n_elem - 1));
 
-  // Calculate vectors of sigmoids.  The intercept term is parameters(0, 0) and
-  // does not need to be multiplied by any of the predictors.
-  const arma::rowvec sigmoid = 1.0 / (1.0 + arma::exp(-(parameters(0, 0) +
-      parameters.tail_cols(parameters.n_elem - 1) * predictors)));
+  // The intercept term is parameters(0, 0) and does not need to be multiplied
+  // by any of the predictors.
+  return regularization + MarginObjective(parameters(0, 0) +
+      parameters.tail_cols(parameters.n_elem - 1) * predictors);
+}
+
+template<typename MatType>
+double LogisticRegressionFunction<MatType>::MarginObjective(
+    const arma::rowvec& margins) const
+{
+  // Calculate vectors of sigmoids.
+  const arma::rowvec sigmoid = 1.0 / (1.0 + arma::exp(-margins));
 
   // Assemble full objective function.  Often the objective function and the
   // regularization as given are divided by the number of features, but this
@@ -129,7 +186,7 @@ double LogisticRegressionFunction<MatType>::Evaluate(
       (2 * arma::conv_to<arma::rowvec>::from(responses) - 1.0)));
 
   // Invert the result, because it's a minimization.
-  return regularization - result;
+  return -result;
 }
 
 /**
@@ -142,6 +199,10 @@ double LogisticRegressionFunction<MatType>::Evaluate(
                   const size_t begin,
                   const size_t batchSize) const
 {
+  // The points of the batch.
+  const MatType batchPredictors = BatchPredictors(begin, batchSize);
+  const arma::Row<size_t> batchResponses = BatchResponses(begin, batchSize);
+
   // Calculate the regularization term.
   const double regularization = lambda *
       (batchSize / (2.0 * predictors.n_cols)) *
@@ -150,12 +211,10 @@ double LogisticRegressionFunction<MatType>::Evaluate(
 
   // Calculate the sigmoid function values.
   const arma::rowvec sigmoid = 1.0 / (1.0 + arma::exp(-(parameters(0, 0) +
-      parameters.tail_cols(parameters.n_elem - 1) *
-      predictors.cols(begin, begin + batchSize - 1))));
+      parameters.tail_cols(parameters.n_elem - 1) * batchPredictors)));
 
   // Compute the objective for the given batch size from a given point.
-  arma::rowvec respD = arma::conv_to<arma::rowvec>::from(responses.subvec(begin,
-      begin + batchSize - 1));
+  arma::rowvec respD = arma::conv_to<arma::rowvec>::from(batchResponses);
   const double result = arma::accu(arma::log(1.0 - respD + sigmoid %
       (2 * respD - 1.0)));
 
@@ -192,23 +251,24 @@ void LogisticRegressionFunction<MatType>::Gradient(
                 GradType& gradient,
                 const size_t batchSize) const
 {
+  // The points of the batch.
+  const MatType batchPredictors = BatchPredictors(begin, batchSize);
+  const arma::Row<size_t> batchResponses = BatchResponses(begin, batchSize);
+
   // Regularization term.
   arma::mat regularization;
   regularization = lambda * parameters.tail_cols(parameters.n_elem - 1)
       / predictors.n_cols * batchSize;
 
   const arma::rowvec exponents = parameters(0, 0) +
-      parameters.tail_cols(parameters.n_elem - 1) *
-      predictors.cols(begin, begin + batchSize - 1);
+      parameters.tail_cols(parameters.n_elem - 1) * batchPredictors;
   // Calculating the sigmoid function values.
   const arma::rowvec sigmoids = 1.0 / (1.0 + arma::exp(-exponents));
 
   gradient.set_size(parameters.n_rows, parameters.n_cols);
-  gradient[0] = -arma::accu(responses.subvec(begin, begin + batchSize - 1) -
-      sigmoids);
-  gradient.tail_cols(parameters.n_elem - 1) = (sigmoids -
-      responses.subvec(begin, begin + batchSize - 1)) *
-      predictors.cols(begin, begin + batchSize - 1).t() + regularization;
+  gradient[0] = -arma::accu(batchResponses - sigmoids);
+  gradient.tail_cols(parameters.n_elem - 1) = (sigmoids - batchResponses) *
+      batchPredictors.t() + regularization;
 }
 
 /**
@@ -237,6 +297,231 @@ void LogisticRegressionFunction<MatType>::PartialGradient(
   }
 }
 
+template <typename MatType>
+double LogisticRegressionFunction<MatType>::PartialDerivative(
+    const arma::mat& parameters,
+    const size_t j,
+    const size_t /* row */) const
+{
+  const arma::rowvec diffs = responses - (1 / (1 + arma::exp(-parameters(0, 0)
+      - parameters.tail_cols(parameters.n_elem - 1) * predictors)));
+
+  if (j == 0)
+    return -arma::accu(diffs);
+
+  return arma::dot(-predictors.row(j - 1), diffs) + lambda * parameters(0, j);
+}
+
+template <typename MatType>
+double LogisticRegressionFunction<MatType>::CoordinateLipschitz(
+    const size_t j) const
+{
+  // The second derivative of the log-likelihood of a point is at most 1 / 4.
+  if (j == 0)
+    return 0.25 * predictors.n_cols;
+
+  return 0.25 * arma::accu(arma::square(predictors.row(j - 1))) + lambda;
+}
+
+/**
+ * Evaluate the partial gradient of the logistic regression objective
+ * function with respect to a block of features in the parameter.
+ */
+template <typename MatType>
+void LogisticRegressionFunction<MatType>::PartialGradient(
+    const arma::mat& parameters,
+    const size_t begin,
+    arma::mat& gradient,
+    const size_t blockSize) const
+{
+  const arma::rowvec diffs = responses - (1 / (1 + arma::exp(-parameters(0, 0)
+      - parameters.tail_cols(parameters.n_elem - 1) * predictors)));
+
+  gradient.set_size(1, blockSize);
+
+  // The intercept is the first feature.
+  size_t first = 0;
+  if (begin == 0 && blockSize > 0)
+  {
+    gradient[0] = -arma::accu(diffs);
+    first = 1;
+  }
+
+  if (first < blockSize)
+  {
+    const size_t lastFeature = begin + blockSize - 1;
+    gradient.cols(first, blockSize - 1) = -diffs * predictors.rows(
+        begin + first - 1, lastFeature - 1).t() + lambda *
+        parameters.cols(begin + first, lastFeature);
+  }
+}
+
+template<typename MatType>
+void LogisticRegressionFunction<MatType>::ResetCache(
+    const arma::mat& parameters)
+{
+  cachedMargins = parameters(0, 0) +
+      parameters.tail_cols(parameters.n_elem - 1) * predictors;
+  cachedSquaredNorm = arma::dot(parameters.tail_cols(parameters.n_elem - 1),
+      parameters.tail_cols(parameters.n_elem - 1));
+}
+
+template<typename MatType>
+void LogisticRegressionFunction<MatType>::UpdateCache(
+    const arma::mat& parameters,
+    const size_t j,
+    const arma::mat& delta)
+{
+  const double change = delta[0];
+  if (j == 0)
+  {
+    // The intercept moves the margin of every point.
+    cachedMargins += change;
+  }
+  else
+  {
+    cachedMargins += change * predictors.row(j - 1);
+
+    const double oldValue = parameters(0, j) - change;
+    cachedSquaredNorm += parameters(0, j) * parameters(0, j) -
+        oldValue * oldValue;
+  }
+}
+
+template<typename MatType>
+double LogisticRegressionFunction<MatType>::CachedEvaluate() const
+{
+  return 0.5 * lambda * cachedSquaredNorm + MarginObjective(cachedMargins);
+}
+
+template<typename MatType>
+template<typename GradType>
+void LogisticRegressionFunction<MatType>::DualGradient(
+    const arma::mat& parameters,
+    const arma::mat& parameters2,
+    const size_t begin,
+    GradType& gradient,
+    GradType& gradient2,
+    const size_t batchSize) const
+{
+  // The points of the batch.
+  const MatType batchPredictors = BatchPredictors(begin, batchSize);
+
+  const size_t n = parameters.n_elem - 1;
+
+  // Stack both sets of weights, so that each product streams the predictors
+  // of the batch only once.
+  arma::mat weights(2, n);
+  weights.row(0) = parameters.tail_cols(n);
+  weights.row(1) = parameters2.tail_cols(n);
+
+  arma::mat sigmoids = weights * batchPredictors;
+  sigmoids.row(0) += parameters(0, 0);
+  sigmoids.row(1) += parameters2(0, 0);
+  sigmoids = 1.0 / (1.0 + arma::exp(-sigmoids));
+
+  const arma::rowvec batchResponses = arma::conv_to<arma::rowvec>::from(
+      BatchResponses(begin, batchSize));
+  sigmoids.each_row() -= batchResponses;
+
+  const arma::mat products = sigmoids * batchPredictors.t();
+
+  // Regularization term.
+  const double scale = lambda / predictors.n_cols * batchSize;
+
+  gradient.set_size(parameters.n_rows, parameters.n_cols);
+  gradient[0] = arma::accu(sigmoids.row(0));
+  gradient.tail_cols(n) = products.row(0) + scale * parameters.tail_cols(n);
+
+  gradient2.set_size(parameters2.n_rows, parameters2.n_cols);
+  gradient2[0] = arma::accu(sigmoids.row(1));
+  gradient2.tail_cols(n) = products.row(1) + scale * parameters2.tail_cols(n);
+}
+
+template<typename MatType>
+template<typename GradType>
+void LogisticRegressionFunction<MatType>::GradientStatistics(
+    const arma::mat& parameters,
+    const size_t begin,
+    GradType& gradient,
+    double& sumSquaredNorms,
+    const size_t batchSize) const
+{
+  // The points of the batch.
+  const MatType batchPredictors = BatchPredictors(begin, batchSize);
+
+  const size_t n = parameters.n_elem - 1;
+
+  // The gradient of the loss of point i is d_i * [1, x_i], where d_i is the
+  // difference between its sigmoid and its response.
+  const arma::rowvec diffs = 1.0 / (1.0 + arma::exp(-(parameters(0, 0) +
+      parameters.tail_cols(n) * batchPredictors))) -
+      arma::conv_to<arma::rowvec>::from(BatchResponses(begin, batchSize));
+
+  // The share of the regularization term of each point.
+  const arma::rowvec regularization = lambda / predictors.n_cols *
+      parameters.tail_cols(n);
+
+  gradient.set_size(parameters.n_rows, parameters.n_cols);
+  gradient[0] = arma::accu(diffs);
+  gradient.tail_cols(n) = diffs * batchPredictors.t() + batchSize *
+      regularization;
+
+  // ||d_i * [1, x_i] + [0, r]||^2 = d_i^2 (1 + ||x_i||^2) + 2 d_i x_i^T r +
+  // ||r||^2.
+  const arma::rowvec pointNorms(arma::sum(arma::square(batchPredictors), 0));
+  sumSquaredNorms = arma::dot(arma::square(diffs), 1.0 + pointNorms) +
+      2.0 * arma::dot(diffs, regularization * batchPredictors) +
+      batchSize * arma::dot(regularization, regularization);
+}
+
+template<typename MatType>
+void LogisticRegressionFunction<MatType>::GradientCoefficients(
+    const arma::mat& parameters,
+    const size_t begin,
+    arma::rowvec& coefficients,
+    const size_t batchSize) const
+{
+  // The points of the batch.
+  const MatType batchPredictors = BatchPredictors(begin, batchSize);
+  const arma::Row<size_t> batchResponses = BatchResponses(begin, batchSize);
+
+  const arma::rowvec exponents = parameters(0, 0) +
+      parameters.tail_cols(parameters.n_elem - 1) * batchPredictors;
+
+  coefficients = 1.0 / (1.0 + arma::exp(-exponents)) -
+      arma::conv_to<arma::rowvec>::from(batchResponses);
+}
+
+template<typename MatType>
+void LogisticRegressionFunction<MatType>::CoefficientGradient(
+    const arma::mat& parameters,
+    const size_t begin,
+    const arma::rowvec& coefficients,
+    arma::mat& gradient,
+    const size_t batchSize) const
+{
+  // The points of the batch.
+  const MatType batchPredictors = BatchPredictors(begin, batchSize);
+
+  gradient.set_size(parameters.n_rows, parameters.n_cols);
+  gradient[0] = arma::accu(coefficients);
+  gradient.tail_cols(parameters.n_elem - 1) = coefficients *
+      batchPredictors.t();
+}
+
+template<typename MatType>
+void LogisticRegressionFunction<MatType>::RegularizationGradient(
+    const arma::mat& parameters,
+    arma::mat& gradient) const
+{
+  // The intercept term is not regularized.
+  gradient.set_size(parameters.n_rows, parameters.n_cols);
+  gradient[0] = 0;
+  gradient.tail_cols(parameters.n_elem - 1) = lambda *
+      parameters.tail_cols(parameters.n_elem - 1);
+}
+
 template<typename MatType>
 template<typename GradType>
 double LogisticRegressionFunction<MatType>::EvaluateWithGradient(
@@ -277,6 +562,10 @@ double LogisticRegressionFunction<MatType>::EvaluateWithGradient(
     GradType& gradient,
     const size_t batchSize) const
 {
+  // The points of the batch.
+  const MatType batchPredictors = BatchPredictors(begin, batchSize);
+  const arma::Row<size_t> batchResponses = BatchResponses(begin, batchSize);
+
   // Regularization term.
   arma::mat regularization =
       lambda * parameters.tail_cols(parameters.n_elem - 1) / predictors.n_cols *
@@ -289,19 +578,15 @@ double LogisticRegressionFunction<MatType>::EvaluateWithGradient(
 
   // Calculate the sigmoid function values.
   const arma::rowvec sigmoids = 1.0 / (1.0 + arma::exp(-(parameters(0, 0) +
-      parameters.tail_cols(parameters.n_elem - 1) *
-      predictors.cols(begin, begin + batchSize - 1))));
+      parameters.tail_cols(parameters.n_elem - 1) * batchPredictors)));
 
   gradient.set_size(parameters.n_rows, parameters.n_cols);
-  gradient[0] = -arma::accu(responses.subvec(begin, begin + batchSize - 1) -
-      sigmoids);
-  gradient.tail_cols(parameters.n_elem - 1) = (sigmoids -
-      responses.subvec(begin, begin + batchSize - 1)) *
-      predictors.cols(begin, begin + batchSize - 1).t() + regularization;
+  gradient[0] = -arma::accu(batchResponses - sigmoids);
+  gradient.tail_cols(parameters.n_elem - 1) = (sigmoids - batchResponses) *
+      batchPredictors.t() + regularization;
 
   // Now compute the objective function using the sigmoids.
-  arma::rowvec respD = arma::conv_to<arma::rowvec>::from(responses.subvec(begin,
-      begin + batchSize - 1));
+  arma::rowvec respD = arma::conv_to<arma::rowvec>::from(batchResponses);
   const double result = arma::accu(arma::log(1.0 - respD + sigmoids %
       (2 * respD - 1.0)));
 
@@ -0,0 +1,193 @@
+/**
+ * @file matrix_factorization_function.hpp
+ *
+ * The objective of low-rank matrix factorization (or completion) on a set of
+ * observed entries.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_MATRIX_FACTORIZATION_FUNCTION_HPP
+#define ENSMALLEN_PROBLEMS_MATRIX_FACTORIZATION_FUNCTION_HPP
+
+namespace ens {
+namespace test {
+
+/**
+ * The matrix factorization objective fits a rank-r product U^T V, with U of
+ * size r x numRows and V of size r x numCols, to the observed entries M_ij of
+ * a matrix:
+ *
+ *  f(U, V) = sum_{(i, j) observed} (u_i^T v_j - M_ij)^2 +
+ *      lambda * (||u_i||^2 + ||v_j||^2)
+ *
+ * where u_i and v_j are columns of U and V.  The parameters are the r x
+ * (numRows + numCols) matrix [U V].  Each observed entry is one separable
+ * function, whose gradient has only the 2r nonzeros of u_i and v_j, so it can
+ * be returned as an arma::sp_mat (as ParallelSGD needs it) as well as an
+ * arma::mat.  As in Hogwild! (Niu et al., 2011), the regularization is split
+ * across the entries, so factors with more observed entries are regularized
+ * more.
+ *
+ * Large random instances with a given rank, density and conditioning can be
+ * generated with GenerateMatrixFactorization().
+ */
+class MatrixFactorizationFunction
+{
+ public:
+  /**
+   * Construct the matrix factorization objective on the given observed
+   * entries.  The initial point is drawn from a normal distribution with a
+   * standard deviation of 0.1.
+   *
+   * @param locations Row (first row) and column (second row) of each observed
+   *     entry.
+   * @param values Value of each observed entry.
+   * @param numRows Number of rows of the matrix.
+   * @param numCols Number of columns of the matrix.
+   * @param rank Rank of the factorization.
+   * @param lambda L2-regularization constant.
+   */
+  MatrixFactorizationFunction(const arma::umat& locations,
+                              const arma::vec& values,
+                              const size_t numRows,
+                              const size_t numCols,
+                              const size_t rank,
+                              const double lambda = 0.0);
+
+  //! Shuffle the order in which the observed entries are visited.
+  void Shuffle();
+
+  //! Return the number of separable functions (the number of observed
+  //! entries).
+  size_t NumFunctions() const { return values.n_elem; }
+
+  //! Get the starting point.
+  const arma::mat& GetInitialPoint() const { return initialPoint; }
+
+  //! Get the number of rows of the matrix.
+  size_t NumRows() const { return numRows; }
+  //! Get the number of columns of the matrix.
+  size_t NumCols() const { return numCols; }
+  //! Get the rank of the factorization.
+  size_t Rank() const { return rank; }
+
+  //! Get the regularization parameter.
+  double Lambda() const { return lambda; }
+  //! Modify the regularization parameter.
+  double& Lambda() { return lambda; }
+
+  /**
+   * Evaluate the objective on all the observed entries.
+   *
+   * @param parameters The factors [U V].
+   */
+  double Evaluate(const arma::mat& parameters) const;
+
+  /**
+   * Evaluate the objective on the given batch of observed entries.
+   *
+   * @param parameters The factors [U V].
+   * @param begin The first entry of the batch.
+   * @param batchSize Number of entries in the batch.
+   */
+  double Evaluate(const arma::mat& parameters,
+                  const size_t begin,
+                  const size_t batchSize = 1) const;
+
+  /**
+   * Evaluate the gradient of the objective on all the observed entries.
+   *
+   * @param parameters The factors [U V].
+   * @param gradient Matrix to store the gradient into.
+   */
+  void Gradient(const arma::mat& parameters, arma::mat& gradient) const;
+
+  /**
+   * Evaluate the gradient of the objective on the given batch of observed
+   * entries.
+   *
+   * @param parameters The factors [U V].
+   * @param begin The first entry of the batch.
+   * @param gradient Matrix to store the gradient into.
+   * @param batchSize Number of entries in the batch.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t begin,
+                arma::mat& gradient,
+                const size_t batchSize = 1) const;
+
+  /**
+   * Evaluate the sparse gradient of the objective on the given batch of
+   * observed entries.
+   *
+   * @param parameters The factors [U V].
+   * @param begin The first entry of the batch.
+   * @param gradient Sparse matrix to store the gradient into.
+   * @param batchSize Number of entries in the batch.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t begin,
+                arma::sp_mat& gradient,
+                const size_t batchSize = 1) const;
+
+  /**
+   * Evaluate the objective and its gradient on all the observed entries.
+   *
+   * @param parameters The factors [U V].
+   * @param gradient Matrix to store the gradient into.
+   */
+  double EvaluateWithGradient(const arma::mat& parameters,
+                              arma::mat& gradient) const;
+
+  /**
+   * Evaluate the objective and its gradient on the given batch of observed
+   * entries.
+   *
+   * @param parameters The factors [U V].
+   * @param begin The first entry of the batch.
+   * @param gradient Matrix to store the gradient into.
+   * @param batchSize Number of entries in the batch.
+   */
+  double EvaluateWithGradient(const arma::mat& parameters,
+                              const size_t begin,
+                              arma::mat& gradient,
+                              const size_t batchSize = 1) const;
+
+ private:
+  //! Get the index of the k'th visited entry.
+  size_t Entry(const size_t k) const
+  {
+    return visitationOrder.is_empty() ? k : visitationOrder[k];
+  }
+
+  //! Get the residual u_i^T v_j - M_ij of the given entry.
+  double Residual(const arma::mat& parameters, const size_t entry) const;
+
+  //! Row (first row) and column (second row) of each observed entry.
+  arma::umat locations;
+  //! Value of each observed entry.
+  arma::vec values;
+  //! Number of rows of the matrix.
+  size_t numRows;
+  //! Number of columns of the matrix.
+  size_t numCols;
+  //! Rank of the factorization.
+  size_t rank;
+  //! L2-regularization constant.
+  double lambda;
+  //! The visitation order of the entries (empty if it is not shuffled).
+  arma::uvec visitationOrder;
+  //! Initial point.
+  arma::mat initialPoint;
+};
+
+} // namespace test
+} // namespace ens
+
+// Include implementation.
+#include "matrix_factorization_function_impl.hpp"
+
+#endif
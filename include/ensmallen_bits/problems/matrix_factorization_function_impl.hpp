@@ -0,0 +1,172 @@
+/**
+ * @file matrix_factorization_function_impl.hpp
+ *
+ * Implementation of the matrix factorization objective.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_MATRIX_FACTORIZATION_FUNCTION_IMPL_HPP
+#define ENSMALLEN_PROBLEMS_MATRIX_FACTORIZATION_FUNCTION_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "matrix_factorization_function.hpp"
+
+namespace ens {
+namespace test {
+
+inline MatrixFactorizationFunction::MatrixFactorizationFunction(
+    const arma::umat& locations,
+    const arma::vec& values,
+    const size_t numRows,
+    const size_t numCols,
+    const size_t rank,
+    const double lambda) :
+    locations(locations),
+    values(values),
+    numRows(numRows),
+    numCols(numCols),
+    rank(rank),
+    lambda(lambda)
+{
+  initialPoint.randn(rank, numRows + numCols);
+  initialPoint *= 0.1;
+}
+
+inline void MatrixFactorizationFunction::Shuffle()
+{
+  visitationOrder = arma::shuffle(arma::linspace<arma::uvec>(0,
+      values.n_elem - 1, values.n_elem));
+}
+
+inline double MatrixFactorizationFunction::Residual(
+    const arma::mat& parameters,
+    const size_t entry) const
+{
+  const double* u = parameters.colptr(locations(0, entry));
+  const double* v = parameters.colptr(numRows + locations(1, entry));
+
+  double prediction = 0.0;
+  for (size_t k = 0; k < rank; ++k)
+    prediction += u[k] * v[k];
+
+  return prediction - values[entry];
+}
+
+inline double MatrixFactorizationFunction::Evaluate(
+    const arma::mat& parameters) const
+{
+  // The sum over all the entries does not depend on their order.
+  return Evaluate(parameters, 0, values.n_elem);
+}
+
+inline double MatrixFactorizationFunction::Evaluate(
+    const arma::mat& parameters,
+    const size_t begin,
+    const size_t batchSize) const
+{
+  double objective = 0.0;
+  for (size_t k = begin; k < begin + batchSize; ++k)
+  {
+    const size_t e = Entry(k);
+    const double residual = Residual(parameters, e);
+    objective += residual * residual + lambda *
+        (arma::dot(parameters.col(locations(0, e)),
+                   parameters.col(locations(0, e))) +
+         arma::dot(parameters.col(numRows + locations(1, e)),
+                   parameters.col(numRows + locations(1, e))));
+  }
+
+  return objective;
+}
+
+inline void MatrixFactorizationFunction::Gradient(
+    const arma::mat& parameters,
+    arma::mat& gradient) const
+{
+  EvaluateWithGradient(parameters, gradient);
+}
+
+inline void MatrixFactorizationFunction::Gradient(
+    const arma::mat& parameters,
+    const size_t begin,
+    arma::mat& gradient,
+    const size_t batchSize) const
+{
+  EvaluateWithGradient(parameters, begin, gradient, batchSize);
+}
+
+inline void MatrixFactorizationFunction::Gradient(
+    const arma::mat& parameters,
+    const size_t begin,
+    arma::sp_mat& gradient,
+    const size_t batchSize) const
+{
+  // Each entry contributes to the 2r coordinates of its two factors; the batch
+  // constructor adds the contributions of entries that share a factor.
+  arma::umat gradientLocations(2, 2 * rank * batchSize);
+  arma::vec gradientValues(2 * rank * batchSize);
+  size_t n = 0;
+  for (size_t k = begin; k < begin + batchSize; ++k)
+  {
+    const size_t e = Entry(k);
+    const size_t i = locations(0, e);
+    const size_t j = numRows + locations(1, e);
+    const double residual = Residual(parameters, e);
+    for (size_t r = 0; r < rank; ++r, n += 2)
+    {
+      gradientLocations(0, n) = r;
+      gradientLocations(1, n) = i;
+      gradientValues[n] = 2.0 * (residual * parameters(r, j) +
+          lambda * parameters(r, i));
+      gradientLocations(0, n + 1) = r;
+      gradientLocations(1, n + 1) = j;
+      gradientValues[n + 1] = 2.0 * (residual * parameters(r, i) +
+          lambda * parameters(r, j));
+    }
+  }
+
+  gradient = arma::sp_mat(true, gradientLocations, gradientValues, rank,
+      numRows + numCols);
+}
+
+inline double MatrixFactorizationFunction::EvaluateWithGradient(
+    const arma::mat& parameters,
+    arma::mat& gradient) const
+{
+  return EvaluateWithGradient(parameters, 0, gradient, values.n_elem);
+}
+
+inline double MatrixFactorizationFunction::EvaluateWithGradient(
+    const arma::mat& parameters,
+    const size_t begin,
+    arma::mat& gradient,
+    const size_t batchSize) const
+{
+  gradient.zeros(rank, numRows + numCols);
+  double objective = 0.0;
+  for (size_t k = begin; k < begin + batchSize; ++k)
+  {
+    const size_t e = Entry(k);
+    const size_t i = locations(0, e);
+    const size_t j = numRows + locations(1, e);
+    const double residual = Residual(parameters, e);
+    objective += residual * residual + lambda *
+        (arma::dot(parameters.col(i), parameters.col(i)) +
+         arma::dot(parameters.col(j), parameters.col(j)));
+
+    gradient.col(i) += 2.0 * (residual * parameters.col(j) +
+        lambda * parameters.col(i));
+    gradient.col(j) += 2.0 * (residual * parameters.col(i) +
+        lambda * parameters.col(j));
+  }
+
+  return objective;
+}
+
+} // namespace test
+} // namespace ens
+
+#endif
@@ -0,0 +1,232 @@
+/**
+ * @file problem_generators.hpp
+ *
+ * Generators of large random instances of sparse logistic regression, matrix
+ * factorization and max-cut SDPs, with a controllable size, sparsity and
+ * conditioning, for benchmarking the optimizers at scale.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_PROBLEM_GENERATORS_HPP
+#define ENSMALLEN_PROBLEMS_PROBLEM_GENERATORS_HPP
+
+#include <ensmallen_bits/utility/rng.hpp>
+#include <ensmallen_bits/sdp/sdp.hpp>
+
+namespace ens {
+namespace test {
+
+/**
+ * Generate a sparse logistic regression dataset, to use with
+ * LogisticRegressionFunction<arma::sp_mat>.  Each point has
+ * max(1, density * numFeatures) nonzero features drawn uniformly at random,
+ * whose values are standard normal and scaled per feature so that the
+ * variances of the features range from 1 to 1 / conditionNumber: the Hessian
+ * of the objective then has a condition number of about conditionNumber.
+ * The labels are drawn from the logistic model with random parameters, which
+ * are returned too.
+ *
+ * @param numPoints Number of points (columns of the predictors).
+ * @param numFeatures Number of features (rows of the predictors).
+ * @param density Fraction of the features that each point has.
+ * @param conditionNumber Ratio of the largest to the smallest feature
+ *     variance.
+ * @param predictors Matrix to store the points into.
+ * @param responses Row to store the labels (0 or 1) into.
+ * @param parameters Row to store the parameters of the logistic model into
+ *     (the intercept first, as LogisticRegressionFunction takes them).
+ * @param seed Seed of the random numbers, so that an instance can be
+ *     regenerated.
+ */
+inline void GenerateSparseLogisticRegression(const size_t numPoints,
+                                             const size_t numFeatures,
+                                             const double density,
+                                             const double conditionNumber,
+                                             arma::sp_mat& predictors,
+                                             arma::Row<size_t>& responses,
+                                             arma::rowvec& parameters,
+                                             const uint64_t seed = 1)
+{
+  RNG rng(seed);
+
+  // Geometrically decreasing feature scales.
+  arma::vec scales(numFeatures);
+  for (size_t f = 0; f < numFeatures; ++f)
+  {
+    scales[f] = (numFeatures == 1) ? 1.0 : std::pow(conditionNumber,
+        -0.5 * f / double(numFeatures - 1));
+  }
+
+  // The parameters are scaled so that the margins have a standard deviation
+  // of about 2, which keeps the labels informative.
+  const size_t nnzPerPoint = std::max(size_t(density * numFeatures + 0.5),
+      size_t(1));
+  parameters.set_size(numFeatures + 1);
+  parameters[0] = 0.0;
+  for (size_t f = 0; f < numFeatures; ++f)
+  {
+    parameters[f + 1] = 2.0 * rng.Randn() / (scales[f] *
+        std::sqrt(double(nnzPerPoint)));
+  }
+
+  arma::umat locations(2, nnzPerPoint * numPoints);
+  arma::vec values(nnzPerPoint * numPoints);
+  responses.set_size(numPoints);
+  size_t n = 0;
+  for (size_t i = 0; i < numPoints; ++i)
+  {
+    double margin = parameters[0];
+    for (size_t k = 0; k < nnzPerPoint; ++k, ++n)
+    {
+      const size_t f = rng.Randi(0, numFeatures - 1);
+      locations(0, n) = f;
+      locations(1, n) = i;
+      values[n] = scales[f] * rng.Randn();
+      margin += parameters[f + 1] * values[n];
+    }
+
+    responses[i] = (rng.Randu() < 1.0 / (1.0 + std::exp(-margin))) ? 1 : 0;
+  }
+
+  // A feature drawn twice for the same point is added.
+  predictors = arma::sp_mat(true, locations, values, numFeatures, numPoints);
+}
+
+/**
+ * Generate the observed entries of a random low-rank matrix, to use with
+ * MatrixFactorizationFunction.  The matrix is U diag(s) V^T, where U and V
+ * have standard normal entries and the singular values s decrease
+ * geometrically from 1 to 1 / conditionNumber (normalized so that the
+ * entries have unit variance); when the matrix is much larger than the rank,
+ * its condition number is about conditionNumber.  Each entry is observed with
+ * probability about density, and Gaussian noise of the given standard
+ * deviation is added to the observations.
+ *
+ * @param numRows Number of rows of the matrix.
+ * @param numCols Number of columns of the matrix.
+ * @param rank Rank of the matrix.
+ * @param density Fraction of the entries that are observed.
+ * @param conditionNumber Ratio of the largest to the smallest singular value.
+ * @param noise Standard deviation of the noise of the observations.
+ * @param locations Matrix to store the row (first row) and column (second
+ *     row) of each observed entry into, sorted by column.
+ * @param values Vector to store the value of each observed entry into.
+ * @param seed Seed of the random numbers, so that an instance can be
+ *     regenerated.
+ */
+inline void GenerateMatrixFactorization(const size_t numRows,
+                                        const size_t numCols,
+                                        const size_t rank,
+                                        const double density,
+                                        const double conditionNumber,
+                                        const double noise,
+                                        arma::umat& locations,
+                                        arma::vec& values,
+                                        const uint64_t seed = 1)
+{
+  RNG rng(seed);
+
+  arma::vec s(rank);
+  for (size_t k = 0; k < rank; ++k)
+  {
+    s[k] = (rank == 1) ? 1.0 : std::pow(conditionNumber,
+        -double(k) / double(rank - 1));
+  }
+  s /= arma::norm(s);
+
+  arma::mat u(rank, numRows), v(rank, numCols);
+  rng.Randn(u);
+  rng.Randn(v);
+  u.each_col() %= s;
+
+  // Draw the observed entries with replacement, and drop the duplicates.
+  const size_t numDraws = std::max(size_t(density * numRows * numCols + 0.5),
+      size_t(1));
+  arma::uvec entries(numDraws);
+  for (size_t k = 0; k < numDraws; ++k)
+    entries[k] = rng.Randi(0, numRows * numCols - 1);
+  entries = arma::unique(entries);
+
+  locations.set_size(2, entries.n_elem);
+  values.set_size(entries.n_elem);
+  for (size_t k = 0; k < entries.n_elem; ++k)
+  {
+    const size_t i = entries[k] % numRows;
+    const size_t j = entries[k] / numRows;
+    locations(0, k) = i;
+    locations(1, k) = j;
+    values[k] = arma::dot(u.col(i), v.col(j)) + noise * rng.Randn();
+  }
+}
+
+/**
+ * Generate the max-cut SDP relaxation of a random weighted graph, in the form
+ * that PrimalDualSolver and LRSDP take:
+ *
+ *  min  dot(-L, X)   s.t.  X_ii = 1, X >= 0
+ *
+ * where L is the Laplacian of the graph.  The graph has about
+ * numVertices * averageDegree / 2 edges between uniformly random pairs of
+ * vertices, whose weights are uniform in [1 / conditionNumber, 1].
+ *
+ * @param numVertices Number of vertices of the graph (size of X).
+ * @param averageDegree Average number of edges of a vertex.
+ * @param conditionNumber Ratio of the largest to the smallest edge weight.
+ * @param seed Seed of the random numbers, so that an instance can be
+ *     regenerated.
+ */
+inline SDP<arma::sp_mat> GenerateMaxCutSDP(const size_t numVertices,
+                                           const double averageDegree,
+                                           const double conditionNumber = 1.0,
+                                           const uint64_t seed = 1)
+{
+  RNG rng(seed);
+
+  const size_t numEdges = size_t(numVertices * averageDegree / 2.0 + 0.5);
+  const double minWeight = 1.0 / conditionNumber;
+
+  // Each edge adds its weight to the diagonal of both vertices and subtracts
+  // it from the two off-diagonal entries; repeated edges are added.
+  arma::umat locations(2, 4 * numEdges);
+  arma::vec values(4 * numEdges);
+  for (size_t e = 0; e < numEdges; ++e)
+  {
+    const size_t i = rng.Randi(0, numVertices - 1);
+    size_t j = rng.Randi(0, numVertices - 2);
+    if (j >= i)
+      ++j;
+    const double w = minWeight + (1.0 - minWeight) * rng.Randu();
+
+    locations(0, 4 * e) = i;
+    locations(1, 4 * e) = i;
+    values[4 * e] = -w;
+    locations(0, 4 * e + 1) = j;
+    locations(1, 4 * e + 1) = j;
+    values[4 * e + 1] = -w;
+    locations(0, 4 * e + 2) = i;
+    locations(1, 4 * e + 2) = j;
+    values[4 * e + 2] = w;
+    locations(0, 4 * e + 3) = j;
+    locations(1, 4 * e + 3) = i;
+    values[4 * e + 3] = w;
+  }
+
+  SDP<arma::sp_mat> sdp(numVertices, numVertices, 0);
+  sdp.C() = arma::sp_mat(true, locations, values, numVertices, numVertices);
+  for (size_t i = 0; i < numVertices; ++i)
+  {
+    sdp.SparseA()[i].zeros(numVertices, numVertices);
+    sdp.SparseA()[i](i, i) = 1.0;
+  }
+  sdp.SparseB().ones();
+
+  return sdp;
+}
+
+} // namespace test
+} // namespace ens
+
+#endif
@@ -8,6 +8,7 @@
 #define ENSMALLEN_PROBLEMS_PROBLEMS_HPP
 
 #include "aug_lagrangian_test_functions.hpp"
+#include "block_shuffle.hpp"
 #include "booth_function.hpp"
 #include "bukin_function.hpp"
 #include "colville_function.hpp"
@@ -17,9 +18,12 @@
 #include "fw_test_function.hpp"
 #include "generalized_rosenbrock_function.hpp"
 #include "gradient_descent_test_function.hpp"
+#include "lasso_function.hpp"
 #include "logistic_regression_function.hpp"
+#include "matrix_factorization_function.hpp"
 #include "matyas_function.hpp"
 #include "mc_cormick_function.hpp"
+#include "problem_generators.hpp"
 #include "rastrigin_function.hpp"
 #include "rosenbrock_function.hpp"
 #include "rosenbrock_wood_function.hpp"
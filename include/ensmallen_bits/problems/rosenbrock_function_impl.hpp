@@ -23,41 +23,52 @@ inline RosenbrockFunction::RosenbrockFunction() { /* Nothing to do here */ }
 
 inline void RosenbrockFunction::Shuffle() { /* Nothing to do here */ }
 
-inline double RosenbrockFunction::Evaluate(const arma::mat& coordinates,
-                                           const size_t /* begin */,
-                                           const size_t /* batchSize */) const
+template<typename MatType>
+typename MatType::elem_type RosenbrockFunction::Evaluate(
+    const MatType& coordinates,
+    const size_t /* begin */,
+    const size_t /* batchSize */) const
 {
+  typedef typename MatType::elem_type ElemType;
+
   // For convenience; we assume these temporaries will be optimized out.
-  const double x1 = coordinates(0);
-  const double x2 = coordinates(1);
+  const ElemType x1 = coordinates(0);
+  const ElemType x2 = coordinates(1);
 
-  const double objective = /* f1(x) */ 100 * std::pow(x2 - std::pow(x1, 2), 2) +
-                           /* f2(x) */ std::pow(1 - x1, 2);
+  const ElemType objective =
+      /* f1(x) */ 100 * std::pow(x2 - std::pow(x1, 2), 2) +
+      /* f2(x) */ std::pow(1 - x1, 2);
 
   return objective;
 }
 
-inline double RosenbrockFunction::Evaluate(const arma::mat& coordinates) const
+template<typename MatType>
+typename MatType::elem_type RosenbrockFunction::Evaluate(
+    const MatType& coordinates) const
 {
   return Evaluate(coordinates, 0, NumFunctions());
 }
 
-inline void RosenbrockFunction::Gradient(const arma::mat& coordinates,
-                                         const size_t /* begin */,
-                                         arma::mat& gradient,
-                                         const size_t /* batchSize */) const
+template<typename MatType, typename GradType>
+void RosenbrockFunction::Gradient(const MatType& coordinates,
+                                  const size_t /* begin */,
+                                  GradType& gradient,
+                                  const size_t /* batchSize */) const
 {
+  typedef typename MatType::elem_type ElemType;
+
   // For convenience; we assume these temporaries will be optimized out.
-  const double x1 = coordinates(0);
-  const double x2 = coordinates(1);
+  const ElemType x1 = coordinates(0);
+  const ElemType x2 = coordinates(1);
 
   gradient.set_size(2, 1);
   gradient(0) = -2 * (1 - x1) + 400 * (std::pow(x1, 3) - x2 * x1);
   gradient(1) = 200 * (x2 - std::pow(x1, 2));
 }
 
-inline void RosenbrockFunction::Gradient(const arma::mat& coordinates,
-                                         arma::mat& gradient) const
+template<typename MatType, typename GradType>
+void RosenbrockFunction::Gradient(const MatType& coordinates,
+                                  GradType& gradient) const
 {
   Gradient(coordinates, 0, gradient, 1);
 }
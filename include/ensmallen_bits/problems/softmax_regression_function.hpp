@@ -13,6 +13,8 @@
 #ifndef ENSMALLEN_PROBLEMS_SOFTMAX_REGRESSION_FUNCTION_HPP
 #define ENSMALLEN_PROBLEMS_SOFTMAX_REGRESSION_FUNCTION_HPP
 
+#include "block_shuffle.hpp"
+
 namespace ens {
 namespace test {
 
@@ -21,7 +23,10 @@ class SoftmaxRegressionFunction
  public:
   /**
    * Construct the Softmax Regression objective function with the given
-   * parameters.
+   * parameters.  The data is aliased, not copied, so it must outlive the
+   * function; a matrix from ens::MappedMatrix can be given, to use a dataset
+   * that is memory-mapped from disk.  Shuffle() only permutes the visitation
+   * order by default, so the data is never copied (see IndexShuffle()).
    *
    * @param data Input training data, each column associate with one sample
    * @param labels Labels associated with the feature data.
@@ -40,7 +45,10 @@ class SoftmaxRegressionFunction
   const arma::mat InitializeWeights();
 
   /**
-   * Shuffle the dataset.
+   * Shuffle the dataset.  By default only a vector of indices is shuffled (in
+   * blocks of ShuffleBlockSize() consecutive points; see BlockShuffle()), and
+   * each batch is gathered through it.  If IndexShuffle() is false, the data
+   * and the labels are reordered instead, which copies the data.
    */
   void Shuffle();
 
@@ -96,6 +104,18 @@ class SoftmaxRegressionFunction
                               const size_t start,
                               const size_t batchSize) const;
 
+  /**
+   * Evaluate the probabilities matrix with the passed parameters, for the
+   * given points.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param points Points to calculate probabilities for.
+   * @param probabilities Pointer to arma::mat which stores the probabilities.
+   */
+  void GetProbabilitiesMatrix(const arma::mat& parameters,
+                              const arma::mat& points,
+                              arma::mat& probabilities) const;
+
   /**
    * Evaluates the objective function of the softmax regression model using the
    * given parameters. The cost function has terms for the log likelihood error
@@ -149,6 +169,37 @@ class SoftmaxRegressionFunction
                 arma::mat& gradient,
                 const size_t batchSize = 1) const;
 
+  /**
+   * Evaluate the objective function and its gradient simultaneously, given
+   * the current set of parameters.  Unlike calling Evaluate() and Gradient(),
+   * the probabilities matrix of the whole dataset is never formed: the points
+   * are processed in blocks of EvaluationBlockSize() columns, whose scores
+   * are turned in place into a numerically stable log-sum-exp and then into
+   * the gradient contribution of the block.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param gradient Matrix where gradient values will be stored.
+   * @return The objective function at the given parameters.
+   */
+  double EvaluateWithGradient(const arma::mat& parameters,
+                              arma::mat& gradient) const;
+
+  /**
+   * Evaluate the objective function and its gradient simultaneously, on a
+   * subset of the data.  This gives the same results as Evaluate() and
+   * Gradient() with the same batch, computed block by block as above.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param start First index of the data points to use.
+   * @param gradient Matrix to store gradient into.
+   * @param batchSize Number of data points to evaluate for.
+   * @return The objective function on the batch.
+   */
+  double EvaluateWithGradient(const arma::mat& parameters,
+                              const size_t start,
+                              arma::mat& gradient,
+                              const size_t batchSize = 1) const;
+
   /**
    * Evaluates the gradient values of the objective function given the current
    * set of parameters for a single feature indexed by j.
@@ -168,6 +219,9 @@ class SoftmaxRegressionFunction
   //! Gets the number of classes.
   size_t NumClasses() const { return numClasses; }
 
+  //! Return the number of separable functions (the number of data points).
+  size_t NumFunctions() const { return data.n_cols; }
+
   //! Gets the features size of the training data.
   size_t NumFeatures() const
   {
@@ -182,11 +236,49 @@ class SoftmaxRegressionFunction
   //! Gets the intercept flag.
   bool FitIntercept() const { return fitIntercept; }
 
+  //! Get whether Shuffle() permutes the visitation order instead of the data.
+  bool IndexShuffle() const { return indexShuffle; }
+  //! Modify whether Shuffle() permutes the visitation order instead of the
+  //! data.
+  bool& IndexShuffle() { return indexShuffle; }
+
+  //! Get the number of consecutive points kept together by an index shuffle.
+  size_t ShuffleBlockSize() const { return shuffleBlockSize; }
+  //! Modify the number of consecutive points kept together by an index
+  //! shuffle.
+  size_t& ShuffleBlockSize() { return shuffleBlockSize; }
+
+  //! Get the number of points EvaluateWithGradient() processes at once (0
+  //! picks a block whose points and scores fit in the L2 cache).
+  size_t EvaluationBlockSize() const { return evaluationBlockSize; }
+  //! Modify the number of points EvaluateWithGradient() processes at once.
+  size_t& EvaluationBlockSize() { return evaluationBlockSize; }
+
  private:
+  /**
+   * Accumulate the unnormalized negative log-likelihood of the given points
+   * into the return value, and its unregularized gradient into the given
+   * gradient (which must already be zeroed).
+   */
+  double AccumulateBlocks(const arma::mat& parameters,
+                          const size_t start,
+                          const size_t numPoints,
+                          arma::mat& gradient) const;
+
+  //! Get the points of the given batch: an alias of the data, or a copy of the
+  //! gathered points if the visitation order is shuffled.
+  arma::mat BatchData(const size_t start, const size_t batchSize) const;
+
+  //! Get the ground truth of the given batch.
+  arma::sp_mat BatchGroundTruth(const size_t start,
+                                const size_t batchSize) const;
+
   //! Training data matrix.  This is an alias until the data is shuffled.
   arma::mat data;
   //! Label matrix for the provided data.
   arma::sp_mat groundTruth;
+  //! Labels of the provided data, in the same order as the data.
+  arma::Row<size_t> labels;
   //! Initial parameter point.
   arma::mat initialPoint;
   //! Number of classes.
@@ -195,6 +287,14 @@ class SoftmaxRegressionFunction
   double lambda;
   //! Intercept term flag.
   bool fitIntercept;
+  //! Whether Shuffle() permutes the visitation order instead of the data.
+  bool indexShuffle;
+  //! The number of consecutive points kept together by an index shuffle.
+  size_t shuffleBlockSize;
+  //! The visitation order of the points (empty if it is not shuffled).
+  arma::uvec visitationOrder;
+  //! The number of points EvaluateWithGradient() processes at once.
+  size_t evaluationBlockSize;
 };
 
 } // namespace test
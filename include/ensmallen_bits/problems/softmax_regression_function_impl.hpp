@@ -26,9 +26,13 @@ inline SoftmaxRegressionFunction::SoftmaxRegressionFunction(
     const bool fitIntercept) :
     data(arma::mat(const_cast<arma::mat&>(data).memptr(), data.n_rows,
       data.n_cols, false, false)),
+    labels(labels),
     numClasses(numClasses),
     lambda(lambda),
-    fitIntercept(fitIntercept)
+    fitIntercept(fitIntercept),
+    indexShuffle(true),
+    shuffleBlockSize(1),
+    evaluationBlockSize(0)
 {
   // Initialize the parameters to suitable values.
   initialPoint = InitializeWeights();
@@ -42,6 +46,12 @@ inline SoftmaxRegressionFunction::SoftmaxRegressionFunction(
  */
 inline void SoftmaxRegressionFunction::Shuffle()
 {
+  if (indexShuffle)
+  {
+    visitationOrder = BlockShuffle(data.n_cols, shuffleBlockSize);
+    return;
+  }
+
   // Determine new ordering.
   arma::uvec ordering = arma::shuffle(arma::linspace<arma::uvec>(0,
       data.n_cols - 1, data.n_cols));
@@ -51,6 +61,7 @@ inline void SoftmaxRegressionFunction::Shuffle()
   if (data.mem_state >= 1)
     data.reset();
   data = std::move(newData);
+  labels = arma::Row<size_t>(labels.cols(ordering));
 
   // Assemble data for batch constructor.  We need reverse orderings though...
   arma::uvec reverseOrdering(ordering.n_elem);
@@ -73,6 +84,41 @@ inline void SoftmaxRegressionFunction::Shuffle()
 
   groundTruth = arma::sp_mat(newLocations, values, groundTruth.n_rows,
       groundTruth.n_cols);
+  visitationOrder.reset();
+}
+
+inline arma::mat SoftmaxRegressionFunction::BatchData(
+    const size_t start,
+    const size_t batchSize) const
+{
+  if (!visitationOrder.is_empty())
+  {
+    return arma::mat(data.cols(visitationOrder.subvec(start,
+        start + batchSize - 1)));
+  }
+
+  // We promise to be well-behaved... the elements won't be modified.
+  return arma::mat(const_cast<arma::mat&>(data).colptr(start), data.n_rows,
+      batchSize, false, true);
+}
+
+inline arma::sp_mat SoftmaxRegressionFunction::BatchGroundTruth(
+    const size_t start,
+    const size_t batchSize) const
+{
+  if (visitationOrder.is_empty())
+    return arma::sp_mat(groundTruth.cols(start, start + batchSize - 1));
+
+  // Each column of the ground truth holds a single 1, in the row of the label.
+  arma::umat locations(2, batchSize);
+  for (size_t i = 0; i < batchSize; ++i)
+  {
+    locations(0, i) = groundTruth.begin_col(visitationOrder[start + i]).row();
+    locations(1, i) = i;
+  }
+
+  return arma::sp_mat(locations, arma::ones<arma::vec>(batchSize),
+      groundTruth.n_rows, batchSize);
 }
 
 /**
@@ -154,6 +200,15 @@ inline void SoftmaxRegressionFunction::GetProbabilitiesMatrix(
     arma::mat& probabilities,
     const size_t start,
     const size_t batchSize) const
+{
+  GetProbabilitiesMatrix(parameters, BatchData(start, batchSize),
+      probabilities);
+}
+
+inline void SoftmaxRegressionFunction::GetProbabilitiesMatrix(
+    const arma::mat& parameters,
+    const arma::mat& points,
+    arma::mat& probabilities) const
 {
   arma::mat hypothesis;
 
@@ -166,14 +221,12 @@ inline void SoftmaxRegressionFunction::GetProbabilitiesMatrix(
     // Since the cost of join may be high due to the copy of original data,
     // split the hypothesis computation to two components.
     hypothesis = arma::exp(
-        arma::repmat(parameters.col(0), 1, batchSize) +
-        parameters.cols(1, parameters.n_cols - 1) *
-        data.cols(start, start + batchSize - 1));
+        arma::repmat(parameters.col(0), 1, points.n_cols) +
+        parameters.cols(1, parameters.n_cols - 1) * points);
   }
   else
   {
-    hypothesis = arma::exp(parameters *
-        data.cols(start, start + batchSize - 1));
+    hypothesis = arma::exp(parameters * points);
   }
 
   probabilities = hypothesis / arma::repmat(arma::sum(hypothesis, 0),
@@ -203,7 +256,7 @@ inline double SoftmaxRegressionFunction::Evaluate(
   // x_i is the input vector for a particular training example.
   // theta_j is the parameter vector associated with a particular class.
   arma::mat probabilities;
-  GetProbabilitiesMatrix(parameters, probabilities, 0, data.n_cols);
+  GetProbabilitiesMatrix(parameters, data, probabilities);
 
   // Calculate the log likelihood and regularization terms.
   double logLikelihood, weightDecay, cost;
@@ -233,9 +286,9 @@ inline double SoftmaxRegressionFunction::Evaluate(
   // Calculate the log likelihood and regularization terms.
   double logLikelihood, weightDecay;
 
-  logLikelihood = arma::accu(groundTruth.cols(start, start + batchSize - 1) %
+  logLikelihood = arma::accu(BatchGroundTruth(start, batchSize) %
       arma::log(probabilities)) / batchSize;
-  weightDecay = 0.5 * lambda * arma::accu(parameters * parameters);
+  weightDecay = 0.5 * lambda * arma::accu(parameters % parameters);
 
   return -logLikelihood + weightDecay;
 }
@@ -253,7 +306,7 @@ inline void SoftmaxRegressionFunction::Gradient(
   // x_i is the input vector for a particular training example.
   // theta_j is the parameter vector associated with a particular class.
   arma::mat probabilities;
-  GetProbabilitiesMatrix(parameters, probabilities, 0, data.n_cols);
+  GetProbabilitiesMatrix(parameters, data, probabilities);
 
   // Calculate the parameter gradients.
   gradient.set_size(parameters.n_rows, parameters.n_cols);
@@ -282,30 +335,137 @@ inline void SoftmaxRegressionFunction::Gradient(
     arma::mat& gradient,
     const size_t batchSize) const
 {
+  // The points of the batch.
+  const arma::mat batchData = BatchData(start, batchSize);
+
   arma::mat probabilities;
-  GetProbabilitiesMatrix(parameters, probabilities, start, batchSize);
+  GetProbabilitiesMatrix(parameters, batchData, probabilities);
 
   // Calculate the parameter gradients.
   gradient.set_size(parameters.n_rows, parameters.n_cols);
   if (fitIntercept)
   {
-    arma::mat inner = probabilities - groundTruth.cols(start, start +
-        batchSize - 1);
+    arma::mat inner = probabilities - BatchGroundTruth(start, batchSize);
     gradient.col(0) =
         inner * arma::ones<arma::mat>(batchSize, 1) / batchSize +
         lambda * parameters.col(0);
     gradient.cols(1, parameters.n_cols - 1) =
-        inner * data.cols(start, start + batchSize - 1).t() / batchSize +
+        inner * batchData.t() / batchSize +
         lambda * parameters.cols(1, parameters.n_cols - 1);
   }
   else
   {
-    gradient = (probabilities - groundTruth.cols(start, start + batchSize - 1))
-        * data.cols(start, start + batchSize - 1).t() / batchSize
+    gradient = (probabilities - BatchGroundTruth(start, batchSize))
+        * batchData.t() / batchSize
         + lambda * parameters;
   }
 }
 
+inline double SoftmaxRegressionFunction::AccumulateBlocks(
+    const arma::mat& parameters,
+    const size_t start,
+    const size_t numPoints,
+    arma::mat& gradient) const
+{
+  // By default, take as many points as fit in 256kB together with their
+  // scores.
+  const size_t blockSize = (evaluationBlockSize > 0) ? evaluationBlockSize :
+      std::max(size_t(32768 / (data.n_rows + numClasses)), size_t(1));
+
+  // The sum over all the points does not depend on their order, so the data
+  // can be read in place even if the visitation order is shuffled.
+  const bool ordered = !visitationOrder.is_empty() &&
+      !(start == 0 && numPoints == data.n_cols);
+
+  // Aliases of the weights (without the intercept) and of their gradient.
+  const size_t firstWeight = fitIntercept ? 1 : 0;
+  const arma::mat weights(const_cast<arma::mat&>(parameters).colptr(
+      firstWeight), parameters.n_rows, data.n_rows, false, true);
+  arma::mat weightsGradient(gradient.colptr(firstWeight), gradient.n_rows,
+      data.n_rows, false, true);
+
+  arma::mat gathered, scores;
+  double loss = 0.0;
+  for (size_t b = start; b < start + numPoints; b += blockSize)
+  {
+    const size_t n = std::min(blockSize, start + numPoints - b);
+
+    // The points of the block are gathered into a reused buffer only if they
+    // are not contiguous.
+    const arma::mat contiguous(const_cast<arma::mat&>(data).colptr(ordered ?
+        0 : b), data.n_rows, ordered ? 0 : n, false, true);
+    if (ordered)
+    {
+      gathered.set_size(data.n_rows, n);
+      for (size_t i = 0; i < n; ++i)
+        gathered.col(i) = data.col(visitationOrder[b + i]);
+    }
+    const arma::mat& points = ordered ? gathered : contiguous;
+
+    scores = weights * points;
+    if (fitIntercept)
+      scores.each_col() += parameters.col(0);
+
+    // Turn each column of scores into the gradient of the negative
+    // log-likelihood of its point, log(sum(exp(s))) - s[label], which is
+    // softmax(s) - 1{label}.  The largest score is subtracted before
+    // exponentiating, so that exp() can neither overflow nor underflow to a
+    // zero sum.
+    for (size_t i = 0; i < n; ++i)
+    {
+      double* s = scores.colptr(i);
+      const size_t label = labels[ordered ? visitationOrder[b + i] : b + i];
+
+      double maxScore = s[0];
+      for (size_t k = 1; k < numClasses; ++k)
+        maxScore = std::max(maxScore, s[k]);
+
+      const double labelScore = s[label];
+      double sum = 0.0;
+      for (size_t k = 0; k < numClasses; ++k)
+      {
+        s[k] = std::exp(s[k] - maxScore);
+        sum += s[k];
+      }
+      loss += maxScore + std::log(sum) - labelScore;
+
+      for (size_t k = 0; k < numClasses; ++k)
+        s[k] /= sum;
+      s[label] -= 1.0;
+    }
+
+    weightsGradient += scores * points.t();
+    if (fitIntercept)
+      gradient.col(0) += arma::sum(scores, 1);
+  }
+
+  return loss;
+}
+
+inline double SoftmaxRegressionFunction::EvaluateWithGradient(
+    const arma::mat& parameters,
+    arma::mat& gradient) const
+{
+  return EvaluateWithGradient(parameters, 0, gradient, data.n_cols);
+}
+
+inline double SoftmaxRegressionFunction::EvaluateWithGradient(
+    const arma::mat& parameters,
+    const size_t start,
+    arma::mat& gradient,
+    const size_t batchSize) const
+{
+  gradient.zeros(parameters.n_rows, parameters.n_cols);
+  const double loss = AccumulateBlocks(parameters, start, batchSize,
+      gradient);
+
+  // Like Evaluate() and Gradient(), every batch takes the whole
+  // regularization.
+  gradient /= batchSize;
+  gradient += lambda * parameters;
+  return loss / batchSize + 0.5 * lambda * arma::accu(parameters % parameters);
+}
+
 inline void SoftmaxRegressionFunction::PartialGradient(
     const arma::mat& parameters,
     const size_t j,
@@ -314,7 +474,7 @@ inline void SoftmaxRegressionFunction::PartialGradient(
   gradient.zeros(arma::size(parameters));
 
   arma::mat probabilities;
-  GetProbabilitiesMatrix(parameters, probabilities, 0, data.n_cols);
+  GetProbabilitiesMatrix(parameters, data, probabilities);
 
   // Calculate the required part of the gradient.
   arma::mat inner = probabilities - groundTruth;
@@ -0,0 +1,274 @@
+/**
+ * @file sparse_logistic_regression_function.hpp
+ *
+ * Specialization of the logistic regression function for sparse predictors,
+ * as are given for instance by bag-of-words text features.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_SPARSE_LOGISTIC_REGRESSION_FUNCTION_HPP
+#define ENSMALLEN_PROBLEMS_SPARSE_LOGISTIC_REGRESSION_FUNCTION_HPP
+
+// In case it hasn't been included yet.
+#include "logistic_regression_function.hpp"
+
+namespace ens {
+namespace test {
+
+/**
+ * The logistic regression objective on sparse predictors.  Each batch is
+ * evaluated with one pass over the nonzeros of its columns, and only the
+ * features that appear in the batch get a nonzero gradient, so the gradient
+ * can be returned as an arma::sp_mat (as ParallelSGD needs it) as well as an
+ * arma::mat.
+ *
+ * To keep the batch gradients sparse, the L2-regularization is split across
+ * the points as in Hogwild! (Niu et al., 2011): the objective of point i has
+ * the term lambda / 2 * sum_j w_j^2 / d_j over the features j of the point,
+ * where d_j is the number of points that have feature j.  Summed over all the
+ * points, this is the usual lambda / 2 * ||w||^2 restricted to the features
+ * that appear in the data; the separable Evaluate(), Gradient() and
+ * EvaluateWithGradient() use this split, and the non-separable ones use the
+ * usual regularization.
+ */
+template<>
+class LogisticRegressionFunction<arma::sp_mat>
+{
+ public:
+  /**
+   * Construct the logistic regression function on the given data.  Sparse
+   * matrices can't be aliased, so the predictors and responses are copied.
+   *
+   * @param predictors Matrix of data points (one per column).
+   * @param responses Labels of the data points (0 or 1).
+   * @param lambda L2-regularization constant.
+   */
+  LogisticRegressionFunction(const arma::sp_mat& predictors,
+                             const arma::Row<size_t>& responses,
+                             const double lambda = 0);
+
+  /**
+   * Construct the logistic regression function on the given data, with the
+   * given initial point.
+   *
+   * @param predictors Matrix of data points (one per column).
+   * @param responses Labels of the data points (0 or 1).
+   * @param initialPoint Initial point for the optimization.
+   * @param lambda L2-regularization constant.
+   */
+  LogisticRegressionFunction(const arma::sp_mat& predictors,
+                             const arma::Row<size_t>& responses,
+                             const arma::vec& initialPoint,
+                             const double lambda = 0);
+
+  //! Return the initial point for the optimization.
+  const arma::mat& InitialPoint() const { return initialPoint; }
+  //! Modify the initial point for the optimization.
+  arma::mat& InitialPoint() { return initialPoint; }
+
+  //! Return the regularization parameter (lambda).
+  const double& Lambda() const { return lambda; }
+  //! Modify the regularization parameter (lambda).
+  double& Lambda() { return lambda; }
+
+  //! Return the matrix of predictors.
+  const arma::sp_mat& Predictors() const { return predictors; }
+  //! Return the vector of responses.
+  const arma::Row<size_t>& Responses() const { return responses; }
+
+  //! Get whether Shuffle() permutes the visitation order instead of the data.
+  bool IndexShuffle() const { return indexShuffle; }
+  //! Modify whether Shuffle() permutes the visitation order instead of the
+  //! data.
+  bool& IndexShuffle() { return indexShuffle; }
+
+  //! Get the number of consecutive points kept together by an index shuffle.
+  size_t ShuffleBlockSize() const { return shuffleBlockSize; }
+  //! Modify the number of consecutive points kept together by an index
+  //! shuffle.
+  size_t& ShuffleBlockSize() { return shuffleBlockSize; }
+
+  /**
+   * Shuffle the order of function visitation.  This may be called by the
+   * optimizer.  As for dense predictors, the data is reordered unless
+   * IndexShuffle() is true.
+   */
+  void Shuffle();
+
+  /**
+   * Evaluate the logistic regression log-likelihood function with the given
+   * parameters.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   */
+  double Evaluate(const arma::mat& parameters) const;
+
+  /**
+   * Evaluate the logistic regression log-likelihood function with the given
+   * parameters on the given batch of points.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param begin Index of the first point in the batch.
+   * @param batchSize Number of points in the batch.
+   */
+  double Evaluate(const arma::mat& parameters,
+                  const size_t begin,
+                  const size_t batchSize = 1) const;
+
+  /**
+   * Evaluate the gradient of the logistic regression log-likelihood function
+   * with the given parameters.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param gradient Vector to output gradient into.
+   */
+  void Gradient(const arma::mat& parameters, arma::mat& gradient) const;
+
+  /**
+   * Evaluate the gradient of the logistic regression log-likelihood function
+   * with the given parameters on the given batch of points.  GradType may be
+   * arma::mat or arma::sp_mat.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param begin Index of the first point in the batch.
+   * @param gradient Vector to output gradient into.
+   * @param batchSize Number of points in the batch.
+   */
+  template<typename GradType>
+  void Gradient(const arma::mat& parameters,
+                const size_t begin,
+                GradType& gradient,
+                const size_t batchSize = 1) const;
+
+  /**
+   * Evaluate the gradient of the logistic regression log-likelihood function
+   * with the given parameters, with respect to only one feature.  This is
+   * used by SCD.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param j Index of the feature with respect to which the gradient is to
+   *    be computed.
+   * @param gradient Sparse matrix to output gradient into.
+   */
+  void PartialGradient(const arma::mat& parameters,
+                       const size_t j,
+                       arma::sp_mat& gradient) const;
+
+  /**
+   * Evaluate the objective function and gradient of the logistic regression
+   * log-likelihood function simultaneously with the given parameters.
+   */
+  double EvaluateWithGradient(const arma::mat& parameters,
+                              arma::mat& gradient) const;
+
+  /**
+   * Evaluate the objective function and gradient of the logistic regression
+   * log-likelihood function simultaneously on the given batch of points.
+   * GradType may be arma::mat or arma::sp_mat.
+   */
+  template<typename GradType>
+  double EvaluateWithGradient(const arma::mat& parameters,
+                              const size_t begin,
+                              GradType& gradient,
+                              const size_t batchSize = 1) const;
+
+  //! Return the initial point for the optimization.
+  const arma::mat& GetInitialPoint() const { return initialPoint; }
+
+  //! Return the number of separable functions (the number of predictor points).
+  size_t NumFunctions() const { return predictors.n_cols; }
+
+  //! Return the number of features(add 1 for the intercept term).
+  size_t NumFeatures() const { return predictors.n_rows + 1; }
+
+  /**
+   * Compute the accuracy of the model on the given predictors and responses,
+   * using the given decision boundary; see the dense version.
+   *
+   * @param predictors Input predictors.
+   * @param responses Vector of responses.
+   * @param parameters Vector of logistic regression parameters.
+   * @param decisionBoundary Decision boundary (default 0.5).
+   * @return Percentage of responses that are predicted correctly.
+   */
+  double ComputeAccuracy(const arma::sp_mat& predictors,
+                         const arma::Row<size_t>& responses,
+                         const arma::mat& parameters,
+                         const double decisionBoundary = 0.5) const;
+
+  /**
+   * Classify the given points, using the given decision boundary; see the
+   * dense version.
+   *
+   * @param dataset Set of points to classify.
+   * @param labels Predicted labels for each point.
+   * @param parameters Vector of logistic regression parameters.
+   * @param decisionBoundary Decision boundary (default 0.5).
+   */
+  void Classify(const arma::sp_mat& dataset,
+                arma::Row<size_t>& labels,
+                const arma::mat& parameters,
+                const double decisionBoundary = 0.5) const;
+
+ private:
+  //! Count the number of points that have each feature.
+  void CountFeatures();
+
+  //! Get the index of the point visited at the given position.
+  size_t Point(const size_t i) const
+  {
+    return visitationOrder.is_empty() ? i : size_t(visitationOrder[i]);
+  }
+
+  /**
+   * Compute the objective of the given batch.  If locations and values are
+   * given, they are filled with the nonzero entries of the gradient of the
+   * batch: first the intercept, then one entry for each nonzero of the batch
+   * (entries for the same feature must be added up).
+   */
+  double BatchObjective(const arma::mat& parameters,
+                        const size_t begin,
+                        const size_t batchSize,
+                        arma::umat* locations = NULL,
+                        arma::vec* values = NULL) const;
+
+  //! Build a dense gradient from its nonzero entries.
+  static void FillGradient(arma::mat& gradient,
+                           const arma::umat& locations,
+                           const arma::vec& values,
+                           const size_t n);
+
+  //! Build a sparse gradient from its nonzero entries.
+  static void FillGradient(arma::sp_mat& gradient,
+                           const arma::umat& locations,
+                           const arma::vec& values,
+                           const size_t n);
+
+  //! The initial point, from which to start the optimization.
+  arma::mat initialPoint;
+  //! The matrix of data points (predictors).
+  arma::sp_mat predictors;
+  //! The vector of responses to the input data points.
+  arma::Row<size_t> responses;
+  //! The number of points that have each feature.
+  arma::vec featureCounts;
+  //! The regularization parameter for L2-regularization.
+  double lambda;
+  //! Whether Shuffle() permutes the visitation order instead of the data.
+  bool indexShuffle;
+  //! The number of consecutive points kept together by an index shuffle.
+  size_t shuffleBlockSize;
+  //! The visitation order of the points (empty if it is not shuffled).
+  arma::uvec visitationOrder;
+};
+
+} // namespace test
+} // namespace ens
+
+// Include implementation.
+#include "sparse_logistic_regression_function_impl.hpp"
+
+#endif
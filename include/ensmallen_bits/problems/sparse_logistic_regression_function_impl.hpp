@@ -0,0 +1,340 @@
+/**
+ * @file sparse_logistic_regression_function_impl.hpp
+ *
+ * Implementation of the logistic regression function for sparse predictors.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_SPARSE_LOGISTIC_REGRESSION_FUNCTION_IMPL_HPP
+#define ENSMALLEN_PROBLEMS_SPARSE_LOGISTIC_REGRESSION_FUNCTION_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "sparse_logistic_regression_function.hpp"
+
+namespace ens {
+namespace test {
+
+inline LogisticRegressionFunction<arma::sp_mat>::LogisticRegressionFunction(
+    const arma::sp_mat& predictors,
+    const arma::Row<size_t>& responses,
+    const double lambda) :
+    predictors(predictors),
+    responses(responses),
+    lambda(lambda),
+    indexShuffle(false),
+    shuffleBlockSize(1)
+{
+  initialPoint = arma::rowvec(predictors.n_rows + 1, arma::fill::zeros);
+
+  // Sanity check.
+  if (responses.n_elem != predictors.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "LogisticRegressionFunction::LogisticRegressionFunction(): "
+        << "predictors matrix has " << predictors.n_cols << " points, but "
+        << "responses vector has " << responses.n_elem << " elements (should be"
+        << " " << predictors.n_cols << ")!" << std::endl;
+    throw std::logic_error(oss.str());
+  }
+
+  CountFeatures();
+}
+
+inline LogisticRegressionFunction<arma::sp_mat>::LogisticRegressionFunction(
+    const arma::sp_mat& predictors,
+    const arma::Row<size_t>& responses,
+    const arma::vec& initialPoint,
+    const double lambda) :
+    initialPoint(initialPoint),
+    predictors(predictors),
+    responses(responses),
+    lambda(lambda),
+    indexShuffle(false),
+    shuffleBlockSize(1)
+{
+  // To check if initialPoint is compatible with predictors.
+  if (initialPoint.n_rows != (predictors.n_rows + 1) ||
+      initialPoint.n_cols != 1)
+    this->initialPoint = arma::rowvec(predictors.n_rows + 1, arma::fill::zeros);
+
+  CountFeatures();
+}
+
+inline void LogisticRegressionFunction<arma::sp_mat>::CountFeatures()
+{
+  // Iterate through a const reference, so that the iterators are const.
+  const arma::sp_mat& data = predictors;
+  featureCounts.zeros(data.n_rows);
+  for (arma::sp_mat::const_iterator it = data.begin(); it != data.end(); ++it)
+  {
+    featureCounts[it.row()] += 1;
+  }
+}
+
+inline void LogisticRegressionFunction<arma::sp_mat>::Shuffle()
+{
+  if (indexShuffle)
+  {
+    visitationOrder = BlockShuffle(predictors.n_cols, shuffleBlockSize);
+    return;
+  }
+
+  arma::uvec ordering = arma::shuffle(arma::linspace<arma::uvec>(0,
+      predictors.n_cols - 1, predictors.n_cols));
+
+  // Rebuild the predictors with their columns in the new order.
+  const arma::sp_mat& data = predictors;
+  arma::umat locations(2, data.n_nonzero);
+  arma::vec values(data.n_nonzero);
+  size_t k = 0;
+  for (size_t i = 0; i < ordering.n_elem; ++i)
+  {
+    for (arma::sp_mat::const_iterator it = data.begin_col(ordering[i]);
+        it != data.end_col(ordering[i]); ++it, ++k)
+    {
+      locations(0, k) = it.row();
+      locations(1, k) = i;
+      values[k] = (*it);
+    }
+  }
+
+  arma::sp_mat newPredictors(locations, values, data.n_rows, data.n_cols);
+  arma::Row<size_t> newResponses;
+  newResponses = responses.cols(ordering);
+
+  predictors = std::move(newPredictors);
+  responses = std::move(newResponses);
+  visitationOrder.reset();
+}
+
+inline double LogisticRegressionFunction<arma::sp_mat>::Evaluate(
+    const arma::mat& parameters) const
+{
+  // The regularization ignores the intercept term.
+  const double regularization = 0.5 * lambda *
+      arma::dot(parameters.tail_cols(parameters.n_elem - 1),
+      parameters.tail_cols(parameters.n_elem - 1));
+
+  // A dense row times a sparse matrix is a single pass over the nonzeros.
+  const arma::rowvec sigmoid = 1.0 / (1.0 + arma::exp(-(parameters(0, 0) +
+      parameters.tail_cols(parameters.n_elem - 1) * predictors)));
+
+  const arma::rowvec y = arma::conv_to<arma::rowvec>::from(responses);
+  const double result = arma::accu(arma::log(1.0 - y + sigmoid %
+      (2 * y - 1.0)));
+
+  // Invert the result, because it's a minimization.
+  return regularization - result;
+}
+
+inline double LogisticRegressionFunction<arma::sp_mat>::Evaluate(
+    const arma::mat& parameters,
+    const size_t begin,
+    const size_t batchSize) const
+{
+  return BatchObjective(parameters, begin, batchSize);
+}
+
+inline void LogisticRegressionFunction<arma::sp_mat>::Gradient(
+    const arma::mat& parameters,
+    arma::mat& gradient) const
+{
+  EvaluateWithGradient(parameters, gradient);
+}
+
+template<typename GradType>
+inline void LogisticRegressionFunction<arma::sp_mat>::Gradient(
+    const arma::mat& parameters,
+    const size_t begin,
+    GradType& gradient,
+    const size_t batchSize) const
+{
+  EvaluateWithGradient(parameters, begin, gradient, batchSize);
+}
+
+inline void LogisticRegressionFunction<arma::sp_mat>::PartialGradient(
+    const arma::mat& parameters,
+    const size_t j,
+    arma::sp_mat& gradient) const
+{
+  const arma::rowvec diffs = arma::conv_to<arma::rowvec>::from(responses) -
+      (1.0 / (1.0 + arma::exp(-parameters(0, 0) -
+      parameters.tail_cols(parameters.n_elem - 1) * predictors)));
+
+  gradient.zeros(arma::size(parameters));
+
+  if (j == 0)
+  {
+    gradient[j] = -arma::accu(diffs);
+  }
+  else
+  {
+    gradient[j] = -arma::as_scalar(predictors.row(j - 1) * diffs.t()) +
+        lambda * parameters(0, j);
+  }
+}
+
+inline double LogisticRegressionFunction<arma::sp_mat>::EvaluateWithGradient(
+    const arma::mat& parameters,
+    arma::mat& gradient) const
+{
+  const double objectiveRegularization = lambda / 2.0 *
+      arma::dot(parameters.tail_cols(parameters.n_elem - 1),
+                parameters.tail_cols(parameters.n_elem - 1));
+
+  const arma::rowvec sigmoids = 1.0 / (1.0 + arma::exp(-(parameters(0, 0) +
+      parameters.tail_cols(parameters.n_elem - 1) * predictors)));
+  const arma::rowvec y = arma::conv_to<arma::rowvec>::from(responses);
+
+  // A sparse matrix times a dense vector is a single pass over the nonzeros,
+  // while multiplying by the transpose would build the transpose first.
+  gradient.set_size(arma::size(parameters));
+  gradient[0] = arma::accu(sigmoids - y);
+  gradient.tail_cols(parameters.n_elem - 1) =
+      (predictors * (sigmoids - y).t()).t() +
+      lambda * parameters.tail_cols(parameters.n_elem - 1);
+
+  const double result = arma::accu(arma::log(1.0 - y + sigmoids %
+      (2 * y - 1.0)));
+
+  // Invert the result, because it's a minimization.
+  return objectiveRegularization - result;
+}
+
+template<typename GradType>
+inline double LogisticRegressionFunction<arma::sp_mat>::EvaluateWithGradient(
+    const arma::mat& parameters,
+    const size_t begin,
+    GradType& gradient,
+    const size_t batchSize) const
+{
+  arma::umat locations;
+  arma::vec values;
+  const double objective = BatchObjective(parameters, begin, batchSize,
+      &locations, &values);
+
+  FillGradient(gradient, locations, values, parameters.n_elem);
+  return objective;
+}
+
+inline double LogisticRegressionFunction<arma::sp_mat>::BatchObjective(
+    const arma::mat& parameters,
+    const size_t begin,
+    const size_t batchSize,
+    arma::umat* locations,
+    arma::vec* values) const
+{
+  double objective = 0.0;
+  size_t entries = 1;
+  arma::vec diffs(batchSize);
+  for (size_t i = 0; i < batchSize; ++i)
+  {
+    const size_t point = Point(begin + i);
+
+    // Compute the linear predictor and the regularization of the point.
+    double z = parameters(0, 0);
+    for (arma::sp_mat::const_iterator it = predictors.begin_col(point);
+        it != predictors.end_col(point); ++it, ++entries)
+    {
+      const double w = parameters(0, it.row() + 1);
+      z += w * (*it);
+      objective += 0.5 * lambda * w * w / featureCounts[it.row()];
+    }
+
+    const double sigmoid = 1.0 / (1.0 + std::exp(-z));
+    const double y = responses[point];
+    objective -= std::log(1.0 - y + sigmoid * (2 * y - 1.0));
+    diffs[i] = sigmoid - y;
+  }
+
+  if (locations == NULL || values == NULL)
+    return objective;
+
+  // The intercept comes first, then one entry for each nonzero of the batch.
+  locations->set_size(2, entries);
+  values->set_size(entries);
+  (*locations)(0, 0) = 0;
+  (*locations)(1, 0) = 0;
+  (*values)[0] = arma::accu(diffs);
+
+  size_t k = 1;
+  for (size_t i = 0; i < batchSize; ++i)
+  {
+    const size_t point = Point(begin + i);
+    for (arma::sp_mat::const_iterator it = predictors.begin_col(point);
+        it != predictors.end_col(point); ++it, ++k)
+    {
+      const size_t feature = it.row();
+      (*locations)(0, k) = 0;
+      (*locations)(1, k) = feature + 1;
+      (*values)[k] = diffs[i] * (*it) + lambda * parameters(0, feature + 1) /
+          featureCounts[feature];
+    }
+  }
+
+  return objective;
+}
+
+inline void LogisticRegressionFunction<arma::sp_mat>::FillGradient(
+    arma::mat& gradient,
+    const arma::umat& locations,
+    const arma::vec& values,
+    const size_t n)
+{
+  gradient.zeros(1, n);
+  for (size_t k = 0; k < values.n_elem; ++k)
+    gradient[locations(1, k)] += values[k];
+}
+
+inline void LogisticRegressionFunction<arma::sp_mat>::FillGradient(
+    arma::sp_mat& gradient,
+    const arma::umat& locations,
+    const arma::vec& values,
+    const size_t n)
+{
+  // Entries for the same feature are added up.
+  gradient = arma::sp_mat(true, locations, values, 1, n);
+}
+
+inline void LogisticRegressionFunction<arma::sp_mat>::Classify(
+    const arma::sp_mat& dataset,
+    arma::Row<size_t>& labels,
+    const arma::mat& parameters,
+    const double decisionBoundary) const
+{
+  // Calculate sigmoid function for each point.  The (1.0 - decisionBoundary)
+  // term correctly sets an offset so that floor() returns 0 or 1 correctly.
+  labels = arma::conv_to<arma::Row<size_t>>::from((1.0 /
+      (1.0 + arma::exp(-parameters(0) -
+      parameters.tail_cols(parameters.n_elem - 1) * dataset))) +
+      (1.0 - decisionBoundary));
+}
+
+inline double LogisticRegressionFunction<arma::sp_mat>::ComputeAccuracy(
+    const arma::sp_mat& predictors,
+    const arma::Row<size_t>& responses,
+    const arma::mat& parameters,
+    const double decisionBoundary) const
+{
+  // Predict responses using the current model.
+  arma::Row<size_t> tempResponses;
+  Classify(predictors, tempResponses, parameters, decisionBoundary);
+
+  // Count the number of responses that were correct.
+  size_t count = 0;
+  for (size_t i = 0; i < responses.n_elem; i++)
+  {
+    if (responses(i) == tempResponses(i))
+      count++;
+  }
+
+  return (double) (count * 100) / responses.n_elem;
+}
+
+} // namespace test
+} // namespace ens
+
+#endif
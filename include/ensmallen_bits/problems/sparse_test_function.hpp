@@ -32,6 +32,10 @@ class SparseTestFunction
   //! Return 4 (the number of features).
   size_t NumFeatures() const { return 4; }
 
+  //! Shuffle the order of function visitation.  Each function only depends on
+  //! its own coordinate, so the order does not matter and nothing is done.
+  void Shuffle() { }
+
   //! Get the starting point.
   arma::mat GetInitialPoint() const { return arma::mat("0 0 0 0;"); }
 
@@ -0,0 +1,188 @@
+/**
+ * @file proximal_gradient.hpp
+ *
+ * Proximal gradient descent (ISTA) and its accelerated variant (FISTA) for
+ * objectives with a nonsmooth regularizer or a constraint.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROXIMAL_GRADIENT_PROXIMAL_GRADIENT_HPP
+#define ENSMALLEN_PROXIMAL_GRADIENT_PROXIMAL_GRADIENT_HPP
+
+#include "proximal_operators/l1_penalty.hpp"
+#include "proximal_operators/l1_ball_constraint.hpp"
+#include "proximal_operators/l0_ball_constraint.hpp"
+#include "proximal_operators/group_lasso_penalty.hpp"
+
+namespace ens {
+
+/**
+ * Proximal gradient descent minimizes \f$ f(x) + g(x) \f$, where \f$ f \f$ is
+ * a differentiable function and \f$ g \f$ is a regularizer (or the indicator
+ * of a constraint) with a cheap proximal operator.  Each iteration takes a
+ * gradient step on \f$ f \f$ and then the proximal step of \f$ g \f$,
+ *
+ * \f[
+ * x_{j + 1} = \textrm{prox}_{\alpha g}(y_j - \alpha \nabla f(y_j)),
+ * \f]
+ *
+ * where \f$ y_j = x_j \f$ for ISTA, and \f$ y_j \f$ is extrapolated along the
+ * last step for FISTA (Nesterov's acceleration).  With backtracking, the step
+ * size \f$ \alpha \f$ is halved until the quadratic upper bound of \f$ f \f$
+ * holds at the new point, so it need not be tuned to the Lipschitz constant of
+ * the gradient.  The iterates are always in the range of the proximal
+ * operator, so with the L1 or group lasso penalties they are exactly sparse.
+ *
+ * The proximal operator (ProximalType) must have the methods
+ *
+ * @code
+ * // Return g(x).
+ * template<typename MatType>
+ * typename MatType::elem_type Evaluate(const MatType& x) const;
+ *
+ * // Replace x with argmin_z g(z) + ||z - x||^2 / (2 * stepSize).
+ * template<typename MatType>
+ * void ProximalStep(MatType& x, const double stepSize) const;
+ * @endcode
+ *
+ * L1Penalty, L1BallConstraint, L0BallConstraint and GroupLassoPenalty are
+ * available.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @article{Beck2009,
+ *   author  = {Beck, Amir and Teboulle, Marc},
+ *   title   = {A Fast Iterative Shrinkage-Thresholding Algorithm for Linear
+ *              Inverse Problems},
+ *   journal = {SIAM Journal on Imaging Sciences},
+ *   volume  = {2},
+ *   number  = {1},
+ *   pages   = {183--202},
+ *   year    = {2009}
+ * }
+ * @endcode
+ *
+ * ProximalGradient can optimize differentiable functions.  For more details,
+ * see the documentation on function types included with this distribution or
+ * on the ensmallen website.
+ *
+ * @tparam ProximalType Type of the proximal operator of the regularizer.
+ */
+template<typename ProximalType = L1Penalty>
+class ProximalGradientType
+{
+ public:
+  /**
+   * Construct the proximal gradient optimizer with the given proximal
+   * operator and parameters.
+   *
+   * @param proximalOperator The proximal operator of the regularizer.
+   * @param stepSize Step size of each iteration (the initial step size with
+   *     backtracking).
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *     limit).
+   * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param accelerated If true, FISTA is used; otherwise, ISTA.
+   * @param backtracking If true, the step size is halved until the quadratic
+   *     upper bound of the differentiable part holds.
+   */
+  ProximalGradientType(const ProximalType& proximalOperator = ProximalType(),
+                       const double stepSize = 1.0,
+                       const size_t maxIterations = 10000,
+                       const double tolerance = 1e-10,
+                       const bool accelerated = true,
+                       const bool backtracking = true);
+
+  /**
+   * Optimize the given function, regularized by the proximal operator.  The
+   * given starting point will be modified to store the finishing point of the
+   * algorithm, and the final objective value (of the function plus the
+   * regularizer) is returned.
+   *
+   * @tparam FunctionType Type of the function to optimize.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename FunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(FunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks);
+
+  //! Get the proximal operator.
+  const ProximalType& ProximalOperator() const { return proximalOperator; }
+  //! Modify the proximal operator.
+  ProximalType& ProximalOperator() { return proximalOperator; }
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether FISTA (instead of ISTA) is used.
+  bool Accelerated() const { return accelerated; }
+  //! Modify whether FISTA (instead of ISTA) is used.
+  bool& Accelerated() { return accelerated; }
+
+  //! Get whether the step size is found by backtracking.
+  bool Backtracking() const { return backtracking; }
+  //! Modify whether the step size is found by backtracking.
+  bool& Backtracking() { return backtracking; }
+
+  //! Get the workspace the temporaries are taken from (NULL if none).
+  ens::Workspace* Workspace() const { return workspace; }
+  //! Modify the workspace the temporaries are taken from (NULL if none).
+  ens::Workspace*& Workspace() { return workspace; }
+
+ private:
+  //! The proximal operator of the regularizer.
+  ProximalType proximalOperator;
+
+  //! The step size for each iteration.
+  double stepSize;
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Whether FISTA is used.
+  bool accelerated;
+
+  //! Whether the step size is found by backtracking.
+  bool backtracking;
+
+  //! The workspace the temporaries are taken from (NULL if none).
+  ens::Workspace* workspace;
+};
+
+//! Proximal gradient with the L1 penalty (lasso).
+using ProximalGradient = ProximalGradientType<L1Penalty>;
+
+} // namespace ens
+
+#include "proximal_gradient_impl.hpp"
+
+#endif
@@ -0,0 +1,187 @@
+/**
+ * @file proximal_gradient_impl.hpp
+ *
+ * Implementation of proximal gradient descent (ISTA and FISTA).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROXIMAL_GRADIENT_PROXIMAL_GRADIENT_IMPL_HPP
+#define ENSMALLEN_PROXIMAL_GRADIENT_PROXIMAL_GRADIENT_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "proximal_gradient.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+template<typename ProximalType>
+ProximalGradientType<ProximalType>::ProximalGradientType(
+    const ProximalType& proximalOperator,
+    const double stepSize,
+    const size_t maxIterations,
+    const double tolerance,
+    const bool accelerated,
+    const bool backtracking) :
+    proximalOperator(proximalOperator),
+    stepSize(stepSize),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    accelerated(accelerated),
+    backtracking(backtracking),
+    workspace(NULL)
+{ /* Nothing to do. */ }
+
+//! Optimize the function (minimize).
+template<typename ProximalType>
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename MatType::elem_type ProximalGradientType<ProximalType>::Optimize(
+    FunctionType& function,
+    MatType& iterateIn,
+    CallbackTypes&&... callbacks)
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+
+  // Use the Function<> wrapper type to provide additional functionality.
+  typedef Function<FunctionType, BaseMatType, BaseGradType> FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+  ENS_PROFILE_OPTIMIZE("ProximalGradient");
+
+  // Make sure we have the methods that we need.
+  traits::CheckFunctionTypeAPI<FullFunctionType, BaseMatType, BaseGradType>();
+
+  // Vectors are optimized as matrices.
+  BaseMatType& iterate = static_cast<BaseMatType&>(iterateIn);
+
+  // To keep track of where we are and how things are going.
+  ElemType overallObjective = std::numeric_limits<ElemType>::max();
+  ElemType lastObjective = std::numeric_limits<ElemType>::max();
+
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+  terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
+
+  // The temporaries are taken from the given workspace, or else from a local
+  // one.
+  ens::Workspace localWorkspace;
+  ens::Workspace& ws = (workspace != NULL) ? *workspace : localWorkspace;
+
+  // Start from a point in the range of the proximal operator (for a
+  // constraint, a feasible point).
+  proximalOperator.ProximalStep(iterate, 0.0);
+
+  // The gradient is evaluated at the (extrapolated) point y.
+  BaseGradType& gradient = ws.Get<BaseGradType>(0);
+  BaseMatType& y = ws.Get<BaseMatType>(1);
+  BaseMatType& candidate = ws.Get<BaseMatType>(2);
+  BaseMatType& difference = ws.Get<BaseMatType>(3);
+  gradient.set_size(iterate.n_rows, iterate.n_cols);
+  y = iterate;
+
+  double currentStepSize = stepSize;
+  double momentum = 1.0;
+  for (size_t i = 1; i != maxIterations && !terminate; ++i)
+  {
+    ElemType smoothObjective;
+    {
+      ENS_PROFILE_SCOPE("EvaluateWithGradient");
+      smoothObjective = f.EvaluateWithGradient(y, gradient);
+    }
+    terminate |= Callback::EvaluateWithGradient(*this, f, y, smoothObjective,
+        gradient, callbacks...);
+
+    // Take the gradient and proximal steps; with backtracking, halve the step
+    // size until the quadratic upper bound of the smooth part holds (at most
+    // 50 times, to stop on objectives that are not finite).
+    ElemType candidateObjective = 0;
+    for (size_t trial = 0; trial < 50; ++trial)
+    {
+      {
+        ENS_PROFILE_SCOPE("Update");
+        candidate = y - currentStepSize * gradient;
+        proximalOperator.ProximalStep(candidate, currentStepSize);
+      }
+      {
+        ENS_PROFILE_SCOPE("Evaluate");
+        candidateObjective = f.Evaluate(candidate);
+      }
+      terminate |= Callback::Evaluate(*this, f, candidate, candidateObjective,
+          callbacks...);
+
+      if (!backtracking)
+        break;
+
+      difference = candidate - y;
+      const double bound = smoothObjective + arma::dot(gradient, difference) +
+          arma::dot(difference, difference) / (2.0 * currentStepSize);
+      if (candidateObjective <= bound)
+        break;
+
+      currentStepSize *= 0.5;
+    }
+
+    overallObjective = candidateObjective +
+        proximalOperator.Evaluate(candidate);
+
+    // Output current objective function.
+    Info << "Proximal Gradient: iteration " << i << ", objective "
+        << overallObjective << ", step size " << currentStepSize << ".\n";
+
+    if (std::isnan(overallObjective) || std::isinf(overallObjective))
+    {
+      Warn << "Proximal Gradient: converged to " << overallObjective
+          << "; terminating with failure.  Try a smaller step size?"
+          << std::endl;
+      Callback::EndOptimization(*this, f, iterate, callbacks...);
+      return overallObjective;
+    }
+
+    // Extrapolate along the step for FISTA.
+    if (accelerated)
+    {
+      const double nextMomentum = (1.0 + std::sqrt(1.0 + 4.0 * momentum *
+          momentum)) / 2.0;
+      y = candidate + ((momentum - 1.0) / nextMomentum) * (candidate - iterate);
+      momentum = nextMomentum;
+    }
+    else
+    {
+      y = candidate;
+    }
+
+    iterate = candidate;
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+
+    if (std::abs(lastObjective - overallObjective) < tolerance)
+    {
+      Info << "Proximal Gradient: minimized within tolerance " << tolerance
+          << "; terminating optimization." << std::endl;
+      Callback::EndOptimization(*this, f, iterate, callbacks...);
+      return overallObjective;
+    }
+
+    lastObjective = overallObjective;
+  }
+
+  if (!terminate)
+  {
+    Info << "Proximal Gradient: maximum iterations (" << maxIterations
+        << ") reached; terminating optimization." << std::endl;
+  }
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+  return overallObjective;
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,161 @@
+/**
+ * @file group_lasso_penalty.hpp
+ *
+ * Group lasso penalty (block soft-thresholding) proximal operator for proximal
+ * gradient methods.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROXIMAL_GRADIENT_GROUP_LASSO_PENALTY_HPP
+#define ENSMALLEN_PROXIMAL_GRADIENT_GROUP_LASSO_PENALTY_HPP
+
+#include <vector>
+
+namespace ens {
+
+/**
+ * The group lasso penalty \f$ g(x) = \lambda \sum_g ||x_g||_2 \f$, where the
+ * coordinates are partitioned into groups \f$ x_g \f$.  Its proximal step
+ * shrinks the norm of every group, and sets the whole group exactly to zero if
+ * its norm is below \f$ \alpha \lambda \f$:
+ *
+ * \f[
+ * x_g \leftarrow \max(1 - \alpha \lambda / ||x_g||_2, 0) x_g.
+ * \f]
+ *
+ * The groups are given as one label per element of the coordinates (in
+ * column-major order), with labels from 0 to the number of groups minus one.
+ * If no labels are given, every row of the coordinates is a group, which
+ * selects features when each column holds the weights of one output.
+ */
+class GroupLassoPenalty
+{
+ public:
+  /**
+   * Construct the group lasso penalty.
+   *
+   * @param lambda Weight of the sum of the group norms.
+   * @param groups Group of every element of the coordinates (if empty, each
+   *     row is a group).
+   */
+  GroupLassoPenalty(const double lambda,
+                    const arma::uvec& groups = arma::uvec()) :
+      lambda(lambda),
+      groups(groups)
+  { /* Nothing to do. */ }
+
+  /**
+   * Return the penalty at the given coordinates.
+   *
+   * @param coordinates Coordinates to evaluate the penalty at.
+   */
+  template<typename MatType>
+  typename MatType::elem_type Evaluate(const MatType& coordinates) const
+  {
+    std::vector<double> norms;
+    GroupNorms(coordinates, norms);
+
+    double penalty = 0.0;
+    for (size_t g = 0; g < norms.size(); ++g)
+      penalty += norms[g];
+
+    return (typename MatType::elem_type) (lambda * penalty);
+  }
+
+  /**
+   * Apply the proximal operator of the penalty, scaled by the given step
+   * size, to the given coordinates.
+   *
+   * @param coordinates Coordinates to apply the operator to (will be
+   *     modified).
+   * @param stepSize Step size of the proximal step.
+   */
+  template<typename MatType>
+  void ProximalStep(MatType& coordinates, const double stepSize) const
+  {
+    typedef typename MatType::elem_type ElemType;
+
+    std::vector<double> scales;
+    GroupNorms(coordinates, scales);
+    const double threshold = stepSize * lambda;
+    for (size_t g = 0; g < scales.size(); ++g)
+    {
+      scales[g] = (scales[g] > threshold) ?
+          (1.0 - threshold / scales[g]) : 0.0;
+    }
+
+    if (groups.is_empty())
+    {
+      for (size_t j = 0; j < coordinates.n_cols; ++j)
+        for (size_t i = 0; i < coordinates.n_rows; ++i)
+          coordinates(i, j) *= (ElemType) scales[i];
+    }
+    else
+    {
+      for (size_t i = 0; i < coordinates.n_elem; ++i)
+        coordinates[i] *= (ElemType) scales[groups[i]];
+    }
+  }
+
+  //! Get the weight of the sum of the group norms.
+  double Lambda() const { return lambda; }
+  //! Modify the weight of the sum of the group norms.
+  double& Lambda() { return lambda; }
+
+  //! Get the group of every element (empty if each row is a group).
+  const arma::uvec& Groups() const { return groups; }
+  //! Modify the group of every element (empty if each row is a group).
+  arma::uvec& Groups() { return groups; }
+
+ private:
+  //! Compute the norm of every group of the given coordinates.
+  template<typename MatType>
+  void GroupNorms(const MatType& coordinates, std::vector<double>& norms) const
+  {
+    if (groups.is_empty())
+    {
+      norms.assign(coordinates.n_rows, 0.0);
+      for (size_t j = 0; j < coordinates.n_cols; ++j)
+      {
+        for (size_t i = 0; i < coordinates.n_rows; ++i)
+        {
+          const double value = (double) coordinates(i, j);
+          norms[i] += value * value;
+        }
+      }
+    }
+    else
+    {
+      if (groups.n_elem != coordinates.n_elem)
+      {
+        std::ostringstream oss;
+        oss << "GroupLassoPenalty: there are " << groups.n_elem
+            << " group labels, but the coordinates have " << coordinates.n_elem
+            << " elements!";
+        throw std::invalid_argument(oss.str());
+      }
+
+      norms.assign(groups.max() + 1, 0.0);
+      for (size_t i = 0; i < coordinates.n_elem; ++i)
+      {
+        const double value = (double) coordinates[i];
+        norms[groups[i]] += value * value;
+      }
+    }
+
+    for (size_t g = 0; g < norms.size(); ++g)
+      norms[g] = std::sqrt(norms[g]);
+  }
+
+  //! The weight of the sum of the group norms.
+  double lambda;
+  //! The group of every element.
+  arma::uvec groups;
+};
+
+} // namespace ens
+
+#endif
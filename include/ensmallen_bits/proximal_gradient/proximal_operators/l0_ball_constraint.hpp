@@ -0,0 +1,73 @@
+/**
+ * @file l0_ball_constraint.hpp
+ *
+ * L0 ball (sparsity) constraint proximal operator for proximal gradient
+ * methods.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROXIMAL_GRADIENT_L0_BALL_CONSTRAINT_HPP
+#define ENSMALLEN_PROXIMAL_GRADIENT_L0_BALL_CONSTRAINT_HPP
+
+#include <ensmallen_bits/fw/proximal/proximal.hpp>
+
+namespace ens {
+
+/**
+ * The constraint that at most k coordinates are nonzero, \f$ ||x||_0 \leq k
+ * \f$.  Its proximal step keeps the k coordinates of largest magnitude
+ * (Proximal::ProjectToL0Ball()); with it, the proximal gradient method is
+ * iterative hard thresholding.  The constraint is not convex, so only a local
+ * solution can be expected.  The penalty of feasible points is zero.
+ */
+class L0BallConstraint
+{
+ public:
+  /**
+   * Construct the L0 ball constraint with the given number of nonzeros.
+   *
+   * @param k Maximum number of nonzero coordinates.
+   */
+  L0BallConstraint(const size_t k) : k(k)
+  { /* Nothing to do. */ }
+
+  /**
+   * Return the penalty at the given (feasible) coordinates, which is zero.
+   */
+  template<typename MatType>
+  typename MatType::elem_type Evaluate(const MatType& /* coordinates */) const
+  {
+    return 0;
+  }
+
+  /**
+   * Keep the k coordinates of largest magnitude, and set the others to zero.
+   *
+   * @param coordinates Coordinates to project (will be modified).
+   * @param stepSize Step size of the proximal step (ignored).
+   */
+  template<typename MatType>
+  void ProximalStep(MatType& coordinates, const double /* stepSize */) const
+  {
+    arma::vec v = arma::conv_to<arma::vec>::from(arma::vectorise(coordinates));
+    Proximal::ProjectToL0Ball(v, (int) k);
+    coordinates = arma::reshape(arma::conv_to<MatType>::from(v),
+        coordinates.n_rows, coordinates.n_cols);
+  }
+
+  //! Get the maximum number of nonzero coordinates.
+  size_t K() const { return k; }
+  //! Modify the maximum number of nonzero coordinates.
+  size_t& K() { return k; }
+
+ private:
+  //! The maximum number of nonzero coordinates.
+  size_t k;
+};
+
+} // namespace ens
+
+#endif
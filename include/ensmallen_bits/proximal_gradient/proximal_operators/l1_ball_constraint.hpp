@@ -0,0 +1,71 @@
+/**
+ * @file l1_ball_constraint.hpp
+ *
+ * L1 ball constraint proximal operator for proximal gradient methods.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROXIMAL_GRADIENT_L1_BALL_CONSTRAINT_HPP
+#define ENSMALLEN_PROXIMAL_GRADIENT_L1_BALL_CONSTRAINT_HPP
+
+#include <ensmallen_bits/fw/proximal/proximal.hpp>
+
+namespace ens {
+
+/**
+ * The constraint \f$ ||x||_1 \leq \tau \f$.  Its proximal step is the
+ * Euclidean projection onto the L1 ball (Proximal::ProjectToL1Ball()), which
+ * does not depend on the step size; with it, the proximal gradient method is
+ * the projected gradient method.  The penalty of feasible points is zero.
+ */
+class L1BallConstraint
+{
+ public:
+  /**
+   * Construct the L1 ball constraint with the given radius.
+   *
+   * @param tau Radius of the L1 ball.
+   */
+  L1BallConstraint(const double tau) : tau(tau)
+  { /* Nothing to do. */ }
+
+  /**
+   * Return the penalty at the given (feasible) coordinates, which is zero.
+   */
+  template<typename MatType>
+  typename MatType::elem_type Evaluate(const MatType& /* coordinates */) const
+  {
+    return 0;
+  }
+
+  /**
+   * Project the given coordinates onto the L1 ball.
+   *
+   * @param coordinates Coordinates to project (will be modified).
+   * @param stepSize Step size of the proximal step (ignored).
+   */
+  template<typename MatType>
+  void ProximalStep(MatType& coordinates, const double /* stepSize */) const
+  {
+    arma::vec v = arma::conv_to<arma::vec>::from(arma::vectorise(coordinates));
+    Proximal::ProjectToL1Ball(v, tau);
+    coordinates = arma::reshape(arma::conv_to<MatType>::from(v),
+        coordinates.n_rows, coordinates.n_cols);
+  }
+
+  //! Get the radius of the L1 ball.
+  double Tau() const { return tau; }
+  //! Modify the radius of the L1 ball.
+  double& Tau() { return tau; }
+
+ private:
+  //! The radius of the L1 ball.
+  double tau;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,87 @@
+/**
+ * @file l1_penalty.hpp
+ *
+ * L1 penalty (soft-thresholding) proximal operator for proximal gradient
+ * methods.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROXIMAL_GRADIENT_L1_PENALTY_HPP
+#define ENSMALLEN_PROXIMAL_GRADIENT_L1_PENALTY_HPP
+
+namespace ens {
+
+/**
+ * The L1 penalty \f$ g(x) = \lambda ||x||_1 \f$ (lasso).  Its proximal step is
+ * the soft-thresholding of every coordinate,
+ *
+ * \f[
+ * x_i \leftarrow \textrm{sign}(x_i) \max(|x_i| - \alpha \lambda, 0),
+ * \f]
+ *
+ * which sets the small coordinates exactly to zero.
+ */
+class L1Penalty
+{
+ public:
+  /**
+   * Construct the L1 penalty with the given regularization parameter.
+   *
+   * @param lambda Weight of the L1 norm.
+   */
+  L1Penalty(const double lambda = 0.0) : lambda(lambda)
+  { /* Nothing to do. */ }
+
+  /**
+   * Return the penalty at the given coordinates.
+   *
+   * @param coordinates Coordinates to evaluate the penalty at.
+   */
+  template<typename MatType>
+  typename MatType::elem_type Evaluate(const MatType& coordinates) const
+  {
+    return (typename MatType::elem_type) lambda *
+        arma::accu(arma::abs(coordinates));
+  }
+
+  /**
+   * Apply the proximal operator of the penalty, scaled by the given step
+   * size, to the given coordinates.
+   *
+   * @param coordinates Coordinates to apply the operator to (will be
+   *     modified).
+   * @param stepSize Step size of the proximal step.
+   */
+  template<typename MatType>
+  void ProximalStep(MatType& coordinates, const double stepSize) const
+  {
+    typedef typename MatType::elem_type ElemType;
+    const ElemType threshold = (ElemType) (stepSize * lambda);
+    for (size_t i = 0; i < coordinates.n_elem; ++i)
+    {
+      const ElemType value = coordinates[i];
+      if (value > threshold)
+        coordinates[i] = value - threshold;
+      else if (value < -threshold)
+        coordinates[i] = value + threshold;
+      else
+        coordinates[i] = 0;
+    }
+  }
+
+  //! Get the weight of the L1 norm.
+  double Lambda() const { return lambda; }
+  //! Modify the weight of the L1 norm.
+  double& Lambda() { return lambda; }
+
+ private:
+  //! The weight of the L1 norm.
+  double lambda;
+};
+
+} // namespace ens
+
+#endif
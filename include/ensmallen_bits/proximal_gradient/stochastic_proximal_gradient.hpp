@@ -0,0 +1,151 @@
+/**
+ * @file stochastic_proximal_gradient.hpp
+ *
+ * Mini-batch stochastic proximal gradient descent for separable objectives
+ * with a nonsmooth regularizer or a constraint.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROXIMAL_GRADIENT_STOCHASTIC_PROXIMAL_GRADIENT_HPP
+#define ENSMALLEN_PROXIMAL_GRADIENT_STOCHASTIC_PROXIMAL_GRADIENT_HPP
+
+#include "proximal_gradient.hpp"
+
+namespace ens {
+
+/**
+ * Stochastic proximal gradient descent minimizes
+ * \f$ \sum_{i = 1}^n f_i(x) + g(x) \f$, the same objective as
+ * ProximalGradient, for separable differentiable functions.  At each step the
+ * gradient of a mini-batch b is computed, and
+ *
+ * \f[
+ * x \leftarrow \textrm{prox}_{(\alpha / n) g}(x - \frac{\alpha}{|b|}
+ *     \sum_{i \in b} \nabla f_i(x)),
+ * \f]
+ *
+ * so the step size applies to the mean gradient of the batch (as in SAGA),
+ * and the regularizer is applied with the matching weight.  The iterates are
+ * in the range of the proximal operator after every step, so with the L1 or
+ * group lasso penalties they are exactly sparse.  The objective of each epoch
+ * is the sum of the objectives of its batches (as in SGD) plus the regularizer
+ * at the end of the epoch.
+ *
+ * The proximal operators are the same as those of ProximalGradientType.
+ *
+ * StochasticProximalGradient can optimize separable differentiable functions.
+ * For more details, see the documentation on function types included with
+ * this distribution or on the ensmallen website.
+ *
+ * @tparam ProximalType Type of the proximal operator of the regularizer.
+ */
+template<typename ProximalType = L1Penalty>
+class StochasticProximalGradientType
+{
+ public:
+  /**
+   * Construct the stochastic proximal gradient optimizer with the given
+   * proximal operator and parameters.
+   *
+   * @param proximalOperator The proximal operator of the regularizer.
+   * @param stepSize Step size for the mean gradient of each batch.
+   * @param batchSize Batch size to use for each step.
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *     limit).
+   * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param shuffle If true, the function order is shuffled; otherwise, each
+   *     function is visited in linear order.
+   */
+  StochasticProximalGradientType(
+      const ProximalType& proximalOperator = ProximalType(),
+      const double stepSize = 0.01,
+      const size_t batchSize = 32,
+      const size_t maxIterations = 100000,
+      const double tolerance = 1e-5,
+      const bool shuffle = true);
+
+  /**
+   * Optimize the given function, regularized by the proximal operator.  The
+   * given starting point will be modified to store the finishing point of the
+   * algorithm, and the final objective value (of the function plus the
+   * regularizer) is returned.
+   *
+   * @tparam SeparableFunctionType Type of the function to optimize.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(SeparableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks);
+
+  //! Get the proximal operator.
+  const ProximalType& ProximalOperator() const { return proximalOperator; }
+  //! Modify the proximal operator.
+  ProximalType& ProximalOperator() { return proximalOperator; }
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the batch size.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the individual functions are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the individual functions are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+ private:
+  //! The proximal operator of the regularizer.
+  ProximalType proximalOperator;
+
+  //! The step size for each example.
+  double stepSize;
+
+  //! The batch size for processing.
+  size_t batchSize;
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the individual functions are shuffled when
+  //! iterating.
+  bool shuffle;
+};
+
+//! Stochastic proximal gradient with the L1 penalty (lasso).
+using StochasticProximalGradient = StochasticProximalGradientType<L1Penalty>;
+
+} // namespace ens
+
+#include "stochastic_proximal_gradient_impl.hpp"
+
+#endif
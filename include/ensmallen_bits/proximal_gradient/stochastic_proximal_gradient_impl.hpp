@@ -0,0 +1,172 @@
+/**
+ * @file stochastic_proximal_gradient_impl.hpp
+ *
+ * Implementation of mini-batch stochastic proximal gradient descent.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROXIMAL_GRADIENT_STOCHASTIC_PROXIMAL_GRADIENT_IMPL_HPP
+#define ENSMALLEN_PROXIMAL_GRADIENT_STOCHASTIC_PROXIMAL_GRADIENT_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "stochastic_proximal_gradient.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+template<typename ProximalType>
+StochasticProximalGradientType<ProximalType>::StochasticProximalGradientType(
+    const ProximalType& proximalOperator,
+    const double stepSize,
+    const size_t batchSize,
+    const size_t maxIterations,
+    const double tolerance,
+    const bool shuffle) :
+    proximalOperator(proximalOperator),
+    stepSize(stepSize),
+    batchSize(batchSize),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    shuffle(shuffle)
+{ /* Nothing to do. */ }
+
+//! Optimize the function (minimize).
+template<typename ProximalType>
+template<typename SeparableFunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename MatType::elem_type
+StochasticProximalGradientType<ProximalType>::Optimize(
+    SeparableFunctionType& function,
+    MatType& iterateIn,
+    CallbackTypes&&... callbacks)
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+
+  typedef Function<SeparableFunctionType, BaseMatType, BaseGradType>
+      FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+  ENS_PROFILE_OPTIMIZE("StochasticProximalGradient");
+
+  // Make sure we have all the methods that we need.
+  traits::CheckDecomposableFunctionTypeAPI<FullFunctionType, BaseMatType,
+      BaseGradType>();
+
+  // Vectors are optimized as matrices.
+  BaseMatType& iterate = static_cast<BaseMatType&>(iterateIn);
+
+  // Find the number of functions to use.
+  const size_t numFunctions = f.NumFunctions();
+
+  // Each step is a step on the mean objective, (1 / n) sum_i f_i(x) + g(x) / n,
+  // so the proximal step is scaled by 1 / n.
+  const double proximalStepSize = stepSize / (double) numFunctions;
+
+  // To keep track of where we are and how things are going.
+  size_t currentFunction = 0;
+  ElemType overallObjective = 0;
+  ElemType lastObjective = std::numeric_limits<ElemType>::max();
+
+  // Track the current epoch and whether a callback asked us to stop.
+  size_t epoch = 0;
+  bool terminate = false;
+  terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
+
+  // Start from a point in the range of the proximal operator (for a
+  // constraint, a feasible point).
+  proximalOperator.ProximalStep(iterate, 0.0);
+
+  BaseGradType gradient(iterate.n_rows, iterate.n_cols);
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+  for (size_t i = 0; i < actualMaxIterations && !terminate;
+      /* incrementing done manually */)
+  {
+    // Is this iteration the start of a sequence?
+    if ((currentFunction % numFunctions) == 0 && i > 0)
+    {
+      overallObjective += proximalOperator.Evaluate(iterate);
+
+      // Output current objective function.
+      Info << "Stochastic Proximal Gradient: iteration " << i << ", objective "
+          << overallObjective << ".\n";
+
+      terminate |= Callback::EndEpoch(*this, f, iterate, epoch++,
+          overallObjective, callbacks...);
+
+      if (std::isnan(overallObjective) || std::isinf(overallObjective))
+      {
+        Warn << "Stochastic Proximal Gradient: converged to "
+            << overallObjective << "; terminating with failure.  Try a "
+            << "smaller step size?" << std::endl;
+        Callback::EndOptimization(*this, f, iterate, callbacks...);
+        return overallObjective;
+      }
+
+      if (std::abs(lastObjective - overallObjective) < tolerance)
+      {
+        Info << "Stochastic Proximal Gradient: minimized within tolerance "
+            << tolerance << "; terminating optimization." << std::endl;
+        Callback::EndOptimization(*this, f, iterate, callbacks...);
+        return overallObjective;
+      }
+
+      // Reset the counter variables.
+      lastObjective = overallObjective;
+      overallObjective = 0;
+      currentFunction = 0;
+
+      if (shuffle) // Determine order of visitation.
+        f.Shuffle();
+
+      terminate |= Callback::BeginEpoch(*this, f, iterate, epoch,
+          lastObjective, callbacks...);
+    }
+
+    // Find the effective batch size (we have to take the minimum of the batch
+    // size, the number of iterations left and the number of functions left).
+    const size_t effectiveBatchSize = std::min(
+        std::min(batchSize, actualMaxIterations - i),
+        numFunctions - currentFunction);
+
+    const ElemType objective = f.EvaluateWithGradient(iterate,
+        currentFunction, gradient, effectiveBatchSize);
+    overallObjective += objective;
+    terminate |= Callback::EvaluateWithGradient(*this, f, iterate, objective,
+        gradient, callbacks...);
+
+    // Take the gradient step of the batch and the proximal step.
+    iterate -= (stepSize / (double) effectiveBatchSize) * gradient;
+    proximalOperator.ProximalStep(iterate, proximalStepSize);
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+
+    i += effectiveBatchSize;
+    currentFunction += effectiveBatchSize;
+  }
+
+  if (!terminate)
+  {
+    Info << "Stochastic Proximal Gradient: maximum iterations ("
+        << maxIterations << ") reached; terminating optimization."
+        << std::endl;
+  }
+
+  // Calculate final objective.
+  overallObjective = FullPassEvaluate(f, iterate, batchSize) +
+      proximalOperator.Evaluate(iterate);
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+  return overallObjective;
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,190 @@
+/**
+ * @file reduced_precision_rmsprop_update.hpp
+ *
+ * RMSProp update that stores its mean squared gradient in reduced precision
+ * (float, bfloat16, half or 8-bit), to cut the memory used by the optimizer
+ * state.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_RMSPROP_REDUCED_PRECISION_RMSPROP_UPDATE_HPP
+#define ENSMALLEN_RMSPROP_REDUCED_PRECISION_RMSPROP_UPDATE_HPP
+
+#include <ensmallen_bits/utility/reduced_precision_state.hpp>
+
+namespace ens {
+
+/**
+ * The RMSProp update with the leaky mean of squared gradients stored as the
+ * given StateType (Float32State, BFloat16State, Float16State or
+ * BlockQuantized8State).  The state is decoded to float one block at a time,
+ * updated in float, and encoded again.  As in ReducedPrecisionAdamUpdate, the
+ * square root of the mean is stored instead of the mean itself, so that the
+ * stored values have the magnitude of the gradient.
+ *
+ * Only dense iterates are supported; sparse gradients are converted to dense
+ * matrices.
+ *
+ * @tparam StateType The type used to store the mean squared gradient.
+ */
+template<typename StateType = BFloat16State>
+class ReducedPrecisionRMSPropUpdate
+{
+ public:
+  /**
+   * Construct the reduced precision RMSProp update policy with the given
+   * parameters.
+   *
+   * @param epsilon The epsilon value used to initialise the squared gradient
+   *        parameter.
+   * @param alpha The smoothing parameter.
+   */
+  ReducedPrecisionRMSPropUpdate(const double epsilon = 1e-8,
+                                const double alpha = 0.99) :
+    epsilon(epsilon),
+    alpha(alpha)
+  {
+    // Nothing to do.
+  }
+
+  //! Get the value used to initialise the squared gradient parameter.
+  double Epsilon() const { return epsilon; }
+  //! Modify the value used to initialise the squared gradient parameter.
+  double& Epsilon() { return epsilon; }
+
+  //! Get the smoothing parameter.
+  double Alpha() const { return alpha; }
+  //! Modify the smoothing parameter.
+  double& Alpha() { return alpha; }
+
+  //! Get the number of bytes of the state (the encoded mean squared gradient
+  //! and its decoding buffer) for an iterate of the given size; the element
+  //! size of the iterate does not matter.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t /* elemSize */ = sizeof(double)) const
+  {
+    return StateType::BytesFor(rows * cols) +
+        StateType::BlockSize() * sizeof(float);
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const ReducedPrecisionRMSPropUpdate& parent,
+           const size_t rows,
+           const size_t cols) :
+        parent(parent),
+        rmsBlock(StateType::BlockSize())
+    {
+      rms.Zeros(rows * cols);
+    }
+
+    /**
+     * Update step for RMSProp.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      Step(iterate, gradient, stepSize, IsFusableUpdate<MatType, GradType>());
+    }
+
+    //! Get the number of bytes used by the mean squared gradient.
+    size_t StateBytes() const { return rms.Bytes(); }
+
+   private:
+    //! Update with a dense gradient of the same type as the iterate.
+    void Step(MatType& iterate,
+              const GradType& gradient,
+              const double stepSize,
+              std::true_type /* fusable */)
+    {
+      Step(iterate, gradient.memptr(), stepSize);
+    }
+
+    //! Update with any other gradient, converted to a dense matrix.
+    void Step(MatType& iterate,
+              const GradType& gradient,
+              const double stepSize,
+              std::false_type /* fusable */)
+    {
+      const arma::Mat<typename MatType::elem_type> denseGradient(gradient);
+      Step(iterate, denseGradient.memptr(), stepSize);
+    }
+
+    //! Update the mean squared gradient and the iterate, a block at a time.
+    void Step(MatType& iterate,
+              const typename MatType::elem_type* g,
+              const double stepSize)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const float alpha = parent.alpha;
+      const float epsilon = parent.epsilon;
+      const ElemType step = stepSize;
+
+      ElemType* x = iterate.memptr();
+      float* rb = rmsBlock.data();
+
+      const size_t n = iterate.n_elem;
+      const size_t blockSize = StateType::BlockSize();
+      for (size_t begin = 0; begin < n; begin += blockSize)
+      {
+        const size_t count = std::min(blockSize, n - begin);
+        rms.Decode(begin, count, rb);
+
+        for (size_t j = 0; j < count; ++j)
+        {
+          const float gj = g[begin + j];
+          rb[j] = std::sqrt(alpha * (rb[j] * rb[j]) + (1 - alpha) * (gj * gj));
+          x[begin + j] -= step * ElemType(gj / (rb[j] + epsilon));
+        }
+
+        rms.Encode(begin, count, rb);
+      }
+    }
+
+    // Instantiated parent object.
+    const ReducedPrecisionRMSPropUpdate& parent;
+
+    // The square root of the leaky mean of squared gradients.
+    StateType rms;
+
+    // The decoded block of rms.
+    std::vector<float> rmsBlock;
+  };
+
+ private:
+  // The epsilon value used to initialise the squared gradient parameter.
+  double epsilon;
+
+  // The smoothing parameter.
+  double alpha;
+};
+
+} // namespace ens
+
+#endif
@@ -56,45 +56,209 @@ class RMSPropUpdate
     // Nothing to do.
   }
 
+  //! Get the value used to initialise the squared gradient parameter.
+  double Epsilon() const { return epsilon; }
+  //! Modify the value used to initialise the squared gradient parameter.
+  double& Epsilon() { return epsilon; }
+
+  //! Get the smoothing parameter.
+  double Alpha() const { return alpha; }
+  //! Modify the smoothing parameter.
+  double& Alpha() { return alpha; }
+
+  //! Get the number of bytes of the state (the mean squared gradient) for
+  //! an iterate of the given size and dense gradients; sparse gradients also
+  //! keep the last iteration of each coordinate.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
+  {
+    return rows * cols * elemSize;
+  }
+
   /**
-   * The Initialize method is called by SGD Optimizer method before the start of
-   * the iteration update process.
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
    */
-  void Initialize(const size_t rows, const size_t cols)
+  template<typename MatType, typename GradType>
+  class Policy
   {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const RMSPropUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        meanSquaredGradient(arma::zeros<MatType>(rows, cols))
+    {
+      // Nothing to do.
+    }
+
+    /**
+     * Update step for RMSProp.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      Step(iterate, stepSize, gradient, IsFusableUpdate<MatType, GradType>());
+    }
+
+    /**
+     * Save or load the state of the policy, to resume an optimization.
+     *
+     * @param ar Archive to save into or load from.
+     */
+    void Serialize(BinaryArchive& ar)
+    {
+      ar(meanSquaredGradient);
+    }
+
+   private:
+    //! Update the leaky sum of squares and the iterate in a single loop.
+    void Step(MatType& iterate,
+              const double stepSize,
+              const GradType& gradient,
+              std::true_type /* fusable */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType alpha = parent.alpha;
+      const ElemType epsilon = parent.epsilon;
+      const ElemType step = stepSize;
+
+      ElemType* x = iterate.memptr();
+      ElemType* msg = meanSquaredGradient.memptr();
+      const ElemType* g = gradient.memptr();
+
+      const size_t n = iterate.n_elem;
+      ENS_PRAGMA_OMP_SIMD
+      for (size_t i = 0; i < n; ++i)
+      {
+        msg[i] = alpha * msg[i] + (1 - alpha) * (g[i] * g[i]);
+        x[i] -= step * g[i] / (std::sqrt(msg[i]) + epsilon);
+      }
+    }
+
+    //! Update the leaky sum of squares and the iterate with Armadillo
+    //! expressions.
+    void Step(MatType& iterate,
+              const double stepSize,
+              const GradType& gradient,
+              std::false_type /* fusable */)
+    {
+      meanSquaredGradient *= parent.alpha;
+      meanSquaredGradient += (1 - parent.alpha) * (gradient % gradient);
+      iterate -= stepSize * gradient / (arma::sqrt(meanSquaredGradient) +
+          parent.epsilon);
+    }
+
+    // Instantiated parent object.
+    const RMSPropUpdate& parent;
+
     // Leaky sum of squares of parameter gradient.
-    meanSquaredGradient = arma::zeros<arma::mat>(rows, cols);
-  }
+    MatType meanSquaredGradient;
+  };
 
   /**
-   * Update step for RMSProp.
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
+   * The RMSProp policy for sparse gradients.  A coordinate with a zero
+   * gradient is not moved by the dense update; only its mean squared gradient
+   * decays.  So the decay is deferred: each coordinate remembers the last
+   * iteration in which it was updated, and when its gradient is next nonzero
+   * the missed decay steps are applied at once before the update.  Each step
+   * then costs time proportional to the number of nonzeros of the gradient
+   * instead of the number of parameters, and the iterates are the same as with
+   * a dense gradient.
    */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
+  template<typename MatType, typename eT>
+  class Policy<MatType, arma::SpMat<eT>>
   {
-    meanSquaredGradient *= alpha;
-    meanSquaredGradient += (1 - alpha) * (gradient % gradient);
-    iterate -= stepSize * gradient / (arma::sqrt(meanSquaredGradient) +
-        epsilon);
-  }
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const RMSPropUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        meanSquaredGradient(arma::zeros<MatType>(rows, cols)),
+        lastIteration(arma::zeros<arma::umat>(rows, cols)),
+        iteration(0)
+    {
+      // Nothing to do.
+    }
 
-  //! Get the value used to initialise the squared gradient parameter.
-  double Epsilon() const { return epsilon; }
-  //! Modify the value used to initialise the squared gradient parameter.
-  double& Epsilon() { return epsilon; }
+    /**
+     * Update step for RMSProp, visiting only the nonzero elements of the
+     * gradient.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The sparse gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const arma::SpMat<eT>& gradient)
+    {
+      ++iteration;
 
-  //! Get the smoothing parameter.
-  double Alpha() const { return alpha; }
-  //! Modify the smoothing parameter.
-  double& Alpha() { return alpha; }
+      typename arma::SpMat<eT>::const_iterator it = gradient.begin();
+      for ( ; it != gradient.end(); ++it)
+      {
+        const size_t row = it.row();
+        const size_t col = it.col();
+
+        // Catch up on the decay of the iterations this coordinate missed.
+        meanSquaredGradient(row, col) *= std::pow(parent.alpha,
+            (double) (iteration - lastIteration(row, col)));
+        meanSquaredGradient(row, col) += (1 - parent.alpha) * (*it) * (*it);
+        lastIteration(row, col) = iteration;
+
+        iterate(row, col) -= stepSize * (*it) /
+            (std::sqrt(meanSquaredGradient(row, col)) + parent.epsilon);
+      }
+    }
+
+    /**
+     * Save or load the state of the policy, to resume an optimization.
+     *
+     * @param ar Archive to save into or load from.
+     */
+    void Serialize(BinaryArchive& ar)
+    {
+      ar(meanSquaredGradient);
+      ar(lastIteration);
+      ar(iteration);
+    }
+
+   private:
+    // Instantiated parent object.
+    const RMSPropUpdate& parent;
+
+    // Leaky sum of squares of parameter gradient, as of the last iteration in
+    // which each coordinate was updated.
+    MatType meanSquaredGradient;
+
+    // The last iteration in which each coordinate was updated.
+    arma::umat lastIteration;
+
+    // The number of iterations.
+    size_t iteration;
+  };
 
  private:
   // The epsilon value used to initialise the squared gradient parameter.
@@ -102,9 +266,6 @@ class RMSPropUpdate
 
   // The smoothing parameter.
   double alpha;
-
-  // Leaky sum of squares of parameter gradient.
-  arma::mat meanSquaredGradient;
 };
 
 } // namespace ens
@@ -0,0 +1,241 @@
+/**
+ * @file parallel_tempering.hpp
+ *
+ * Parallel tempering (replica exchange Monte Carlo), a multi-chain variant of
+ * simulated annealing.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SA_PARALLEL_TEMPERING_HPP
+#define ENSMALLEN_SA_PARALLEL_TEMPERING_HPP
+
+namespace ens {
+
+/**
+ * Parallel tempering runs numChains Metropolis chains on copies of the state,
+ * each at a fixed temperature of a geometric ladder between minTemperature and
+ * maxTemperature.  Every chain makes moves like SA: one parameter at a time,
+ * with a Laplace distributed step whose size is adapted by feedback move
+ * control (per chain, towards an acceptance ratio of 0.44).  After every
+ * swapSweeps sweeps, the states of neighbouring chains are exchanged with
+ * probability
+ *
+ *   min{1, exp((1 / T_i - 1 / T_j) (E_i - E_j))},
+ *
+ * alternately for the even and the odd pairs of the ladder.  The hot chains
+ * explore the whole space, and good states found by them travel down to the
+ * cold chains, which refine them; unlike SA, there is no cooling schedule to
+ * tune.
+ *
+ * The chains are independent between two exchanges, so if parallelChains is
+ * true (and OpenMP is enabled), they are run on separate threads; the
+ * function's Evaluate() must then be safe to call from multiple threads at
+ * once.  Each chain has its own random number generator, seeded from
+ * Armadillo's, so the result does not depend on the number of threads.
+ *
+ * The optimization stops after maxIterations moves per chain, or when the
+ * energy of the coldest chain has changed by less than tolerance over
+ * maxToleranceSweep * moveCtrlSweep sweeps.  The best state seen at any
+ * exchange is returned.
+ *
+ * Parallel tempering can optimize arbitrary functions.  For more details, see
+ * the documentation on function types included with this distribution or on
+ * the ensmallen website.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @article{Earl2005,
+ *   author  = {Earl, David J. and Deem, Michael W.},
+ *   title   = {Parallel Tempering: Theory, Applications, and New
+ *              Perspectives},
+ *   journal = {Physical Chemistry Chemical Physics},
+ *   volume  = {7},
+ *   number  = {23},
+ *   pages   = {3910--3916},
+ *   year    = {2005}
+ * }
+ * @endcode
+ */
+class ParallelTempering
+{
+ public:
+  /**
+   * Construct the parallel tempering optimizer with the given parameters.
+   *
+   * @param numChains Number of chains (temperatures).
+   * @param minTemperature Temperature of the coldest chain.
+   * @param maxTemperature Temperature of the hottest chain.
+   * @param maxIterations Maximum number of moves of each chain (0 indicates no
+   *     limit).
+   * @param swapSweeps Sweeps of each chain between two exchanges.
+   * @param moveCtrlSweep Sweeps per feedback move control.
+   * @param tolerance Tolerance to consider the coldest chain frozen.
+   * @param maxToleranceSweep Maximum number of moveCtrlSweep sweeps below
+   *     tolerance to consider the coldest chain frozen.
+   * @param maxMoveCoef Maximum move size.
+   * @param initMoveCoef Initial move size.
+   * @param gain Proportional control in feedback move control.
+   * @param parallelChains Whether to run the chains in parallel (requires
+   *     OpenMP and a thread-safe Evaluate()).
+   */
+  ParallelTempering(const size_t numChains = 8,
+                    const double minTemperature = 0.01,
+                    const double maxTemperature = 100.0,
+                    const size_t maxIterations = 1000000,
+                    const size_t swapSweeps = 1,
+                    const size_t moveCtrlSweep = 100,
+                    const double tolerance = 1e-5,
+                    const size_t maxToleranceSweep = 3,
+                    const double maxMoveCoef = 20,
+                    const double initMoveCoef = 0.3,
+                    const double gain = 0.3,
+                    const bool parallelChains = false);
+
+  /**
+   * Optimize the given function using parallel tempering.  The given starting
+   * point is the initial state of every chain, and will be modified to store
+   * the best state found; the objective value of that state is returned.
+   *
+   * @tparam FunctionType Type of function to optimize.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @return Objective value of the final point.
+   */
+  template<typename FunctionType>
+  double Optimize(FunctionType& function, arma::mat& iterate);
+
+  //! Get the number of chains.
+  size_t NumChains() const { return numChains; }
+  //! Modify the number of chains.
+  size_t& NumChains() { return numChains; }
+
+  //! Get the temperature of the coldest chain.
+  double MinTemperature() const { return minTemperature; }
+  //! Modify the temperature of the coldest chain.
+  double& MinTemperature() { return minTemperature; }
+
+  //! Get the temperature of the hottest chain.
+  double MaxTemperature() const { return maxTemperature; }
+  //! Modify the temperature of the hottest chain.
+  double& MaxTemperature() { return maxTemperature; }
+
+  //! Get the maximum number of moves of each chain.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of moves of each chain.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the number of sweeps between exchanges.
+  size_t SwapSweeps() const { return swapSweeps; }
+  //! Modify the number of sweeps between exchanges.
+  size_t& SwapSweeps() { return swapSweeps; }
+
+  //! Get sweeps per move control.
+  size_t MoveCtrlSweep() const { return moveCtrlSweep; }
+  //! Modify sweeps per move control.
+  size_t& MoveCtrlSweep() { return moveCtrlSweep; }
+
+  //! Get the tolerance.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance.
+  double& Tolerance() { return tolerance; }
+
+  //! Get the maxToleranceSweep.
+  size_t MaxToleranceSweep() const { return maxToleranceSweep; }
+  //! Modify the maxToleranceSweep.
+  size_t& MaxToleranceSweep() { return maxToleranceSweep; }
+
+  //! Get the maximum move size.
+  double MaxMoveCoef() const { return maxMoveCoef; }
+  //! Modify the maximum move size.
+  double& MaxMoveCoef() { return maxMoveCoef; }
+
+  //! Get the initial move size.
+  double InitMoveCoef() const { return initMoveCoef; }
+  //! Modify the initial move size.
+  double& InitMoveCoef() { return initMoveCoef; }
+
+  //! Get the gain.
+  double Gain() const { return gain; }
+  //! Modify the gain.
+  double& Gain() { return gain; }
+
+  //! Get whether the chains are run in parallel.
+  bool ParallelChains() const { return parallelChains; }
+  //! Modify whether the chains are run in parallel.
+  bool& ParallelChains() { return parallelChains; }
+
+  //! Get the temperatures of the chains (set by Optimize()).
+  const arma::vec& Temperatures() const { return temperatures; }
+
+  //! Get the fraction of accepted exchanges of each pair of neighbouring
+  //! chains during the last optimization.
+  const arma::vec& SwapAcceptance() const { return swapAcceptance; }
+
+ private:
+  /**
+   * Make the given number of sweeps of Metropolis moves on one chain, at its
+   * temperature, with feedback move control every moveCtrlSweep sweeps.
+   *
+   * @param function Function to optimize.
+   * @param temperature Temperature of the chain.
+   * @param sweeps Number of sweeps to make.
+   * @param state State of the chain (will be modified).
+   * @param energy Energy of the state (will be modified).
+   * @param accept Accepted moves of each parameter since the last move
+   *     control.
+   * @param moveSize Move size of each parameter.
+   * @param sweepCounter Sweeps since the last move control.
+   * @param generator Random number generator of the chain.
+   */
+  template<typename FunctionType>
+  void Sweep(FunctionType& function,
+             const double temperature,
+             const size_t sweeps,
+             arma::mat& state,
+             double& energy,
+             arma::mat& accept,
+             arma::mat& moveSize,
+             size_t& sweepCounter,
+             RNG& generator) const;
+
+  //! Number of chains.
+  size_t numChains;
+  //! Temperature of the coldest chain.
+  double minTemperature;
+  //! Temperature of the hottest chain.
+  double maxTemperature;
+  //! Maximum number of moves of each chain.
+  size_t maxIterations;
+  //! Sweeps between exchanges.
+  size_t swapSweeps;
+  //! Sweeps per move control.
+  size_t moveCtrlSweep;
+  //! Tolerance for convergence.
+  double tolerance;
+  //! Number of move control periods in tolerance before the coldest chain is
+  //! considered frozen.
+  size_t maxToleranceSweep;
+  //! Maximum move.
+  double maxMoveCoef;
+  //! Initial move size.
+  double initMoveCoef;
+  //! Proportional control in feedback move control.
+  double gain;
+  //! Whether to run the chains in parallel.
+  bool parallelChains;
+
+  //! Temperatures of the chains.
+  arma::vec temperatures;
+  //! Fraction of accepted exchanges of each neighbouring pair.
+  arma::vec swapAcceptance;
+};
+
+} // namespace ens
+
+#include "parallel_tempering_impl.hpp"
+
+#endif
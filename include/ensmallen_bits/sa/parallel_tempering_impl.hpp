@@ -0,0 +1,227 @@
+/**
+ * @file parallel_tempering_impl.hpp
+ *
+ * Implementation of parallel tempering.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SA_PARALLEL_TEMPERING_IMPL_HPP
+#define ENSMALLEN_SA_PARALLEL_TEMPERING_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "parallel_tempering.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+inline ParallelTempering::ParallelTempering(const size_t numChains,
+                                            const double minTemperature,
+                                            const double maxTemperature,
+                                            const size_t maxIterations,
+                                            const size_t swapSweeps,
+                                            const size_t moveCtrlSweep,
+                                            const double tolerance,
+                                            const size_t maxToleranceSweep,
+                                            const double maxMoveCoef,
+                                            const double initMoveCoef,
+                                            const double gain,
+                                            const bool parallelChains) :
+    numChains(numChains),
+    minTemperature(minTemperature),
+    maxTemperature(maxTemperature),
+    maxIterations(maxIterations),
+    swapSweeps(swapSweeps),
+    moveCtrlSweep(moveCtrlSweep),
+    tolerance(tolerance),
+    maxToleranceSweep(maxToleranceSweep),
+    maxMoveCoef(maxMoveCoef),
+    initMoveCoef(initMoveCoef),
+    gain(gain),
+    parallelChains(parallelChains)
+{
+  // Nothing to do.
+}
+
+//! Optimize the function (minimize).
+template<typename FunctionType>
+double ParallelTempering::Optimize(FunctionType& function, arma::mat& iterate)
+{
+  // Make sure we have the methods that we need.
+  traits::CheckNonDifferentiableFunctionTypeAPI<FunctionType>();
+
+  if (numChains == 0 || swapSweeps == 0)
+  {
+    throw std::invalid_argument("ParallelTempering::Optimize(): numChains "
+        "and swapSweeps must be positive!");
+  }
+
+  // The geometric temperature ladder; chain 0 is the coldest.
+  temperatures.set_size(numChains);
+  for (size_t k = 0; k < numChains; ++k)
+  {
+    temperatures(k) = (numChains == 1) ? minTemperature : minTemperature *
+        std::pow(maxTemperature / minTemperature,
+        (double) k / (double) (numChains - 1));
+  }
+
+  // Every chain starts at the given point.  The move control state belongs to
+  // the temperature, so it is not exchanged with the states.
+  std::vector<arma::mat> states(numChains, iterate);
+  arma::vec energies(numChains);
+  energies.fill(function.Evaluate(iterate));
+  std::vector<arma::mat> accepts(numChains,
+      arma::mat(iterate.n_rows, iterate.n_cols, arma::fill::zeros));
+  std::vector<arma::mat> moveSizes(numChains,
+      arma::mat(iterate.n_rows, iterate.n_cols));
+  for (size_t k = 0; k < numChains; ++k)
+    moveSizes[k].fill(initMoveCoef);
+  std::vector<size_t> sweepCounters(numChains, 0);
+
+  // One stream for each chain and one for the exchanges, created up front so
+  // that the result does not depend on the number of threads.
+  std::vector<RNG> generators =
+      RNG(RNG::ArmaSeed()).Streams(numChains + 1);
+  RNG swapGenerator = generators.back();
+  generators.pop_back();
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+  arma::vec swapAttempts(numChains - 1, arma::fill::zeros);
+  arma::vec swapAccepts(numChains - 1, arma::fill::zeros);
+
+  arma::mat best = iterate;
+  double bestEnergy = energies(0);
+
+  size_t moves = 0;
+  size_t frozenSweeps = 0;
+  bool frozen = false;
+  for (size_t round = 0; maxIterations == 0 || moves < maxIterations; ++round)
+  {
+    const double oldColdEnergy = energies(0);
+
+    // The chains are independent until the next exchange.  They always run in
+    // parallel for functions that are known to be thread-safe.
+    ParallelFor(numChains, [&](const size_t k)
+    {
+      Sweep(function, temperatures(k), swapSweeps, states[k], energies(k),
+          accepts[k], moveSizes[k], sweepCounters[k], generators[k]);
+    }, parallelChains || traits::IsThreadSafeFunction<FunctionType>::value);
+    moves += swapSweeps * iterate.n_elem;
+
+    arma::uword bestChain;
+    if (energies.min(bestChain) < bestEnergy)
+    {
+      bestEnergy = energies(bestChain);
+      best = states[bestChain];
+    }
+
+    // Exchange the states of the even pairs in even rounds and of the odd
+    // pairs in odd rounds.
+    for (size_t k = round % 2; k + 1 < numChains; k += 2)
+    {
+      const double exponent = (1.0 / temperatures(k) -
+          1.0 / temperatures(k + 1)) * (energies(k) - energies(k + 1));
+      ++swapAttempts(k);
+      if (exponent >= 0.0 || uniform(swapGenerator) < std::exp(exponent))
+      {
+        states[k].swap(states[k + 1]);
+        std::swap(energies(k), energies(k + 1));
+        ++swapAccepts(k);
+      }
+    }
+
+    // Determine if the coldest chain has entered (or continues to be in) a
+    // frozen state.
+    if (std::abs(energies(0) - oldColdEnergy) < tolerance)
+      frozenSweeps += swapSweeps;
+    else
+      frozenSweeps = 0;
+
+    if (frozenSweeps >= maxToleranceSweep * moveCtrlSweep)
+    {
+      Info << "ParallelTempering: minimized within tolerance " << tolerance
+          << " for " << frozenSweeps << " sweeps after " << moves << " moves "
+          << "per chain; terminating optimization." << std::endl;
+      frozen = true;
+      break;
+    }
+  }
+
+  if (!frozen)
+  {
+    Warn << "ParallelTempering: maximum iterations (" << maxIterations
+        << ") reached; terminating optimization." << std::endl;
+  }
+
+  swapAcceptance = swapAccepts / arma::clamp(swapAttempts, 1.0, DBL_MAX);
+
+  iterate = best;
+  return bestEnergy;
+}
+
+//! Make the given number of sweeps on one chain.
+template<typename FunctionType>
+void ParallelTempering::Sweep(FunctionType& function,
+                              const double temperature,
+                              const size_t sweeps,
+                              arma::mat& state,
+                              double& energy,
+                              arma::mat& accept,
+                              arma::mat& moveSize,
+                              size_t& sweepCounter,
+                              RNG& generator) const
+{
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::exponential_distribution<double> exponential(1.0);
+
+  for (size_t s = 0; s < sweeps; ++s)
+  {
+    for (size_t idx = 0; idx < state.n_elem; ++idx)
+    {
+      const double prevEnergy = energy;
+      const double prevValue = state(idx);
+
+      // Sample from a Laplace distribution with scale parameter moveSize(idx),
+      // as SA does.
+      const double move = moveSize(idx) * exponential(generator);
+      const double newValue = prevValue +
+          ((uniform(generator) < 0.5) ? move : -move);
+      energy = EvaluateMove(function, state, idx, newValue, prevEnergy);
+
+      // According to the Metropolis criterion, accept the move with
+      // probability min{1, exp(-(E_new - E_old) / T)}.
+      const double delta = energy - prevEnergy;
+      if (delta <= 0. || uniform(generator) < std::exp(-delta / temperature))
+      {
+        accept(idx) += 1.;
+        state(idx) = newValue;
+      }
+      else // Reject the move; keep the previous state.
+      {
+        energy = prevEnergy;
+      }
+    }
+
+    // Feedback move control, towards an acceptance ratio of 0.44 (see
+    // SA::MoveControl()).
+    if (++sweepCounter == moveCtrlSweep)
+    {
+      for (size_t i = 0; i < moveSize.n_elem; ++i)
+      {
+        moveSize(i) *= std::exp(gain * (accept(i) / (double) moveCtrlSweep -
+            0.44));
+        moveSize(i) = (moveSize(i) > maxMoveCoef) ? maxMoveCoef : moveSize(i);
+      }
+
+      accept.zeros();
+      sweepCounter = 0;
+    }
+  }
+}
+
+} // namespace ens
+
+#endif
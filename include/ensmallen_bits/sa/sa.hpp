@@ -35,6 +35,14 @@ namespace ens {
  * size depending on the responsiveness of each parameter. Parameter gain
  * controls the proportion of the feedback control.
  *
+ * With a block size larger than 1, each step instead perturbs blockSize
+ * consecutive parameters at once: the moves of the block are drawn together,
+ * evaluated with a single function evaluation (or one EvaluateDelta() call per
+ * parameter), and accepted or rejected together.  This makes the overhead per
+ * parameter much smaller for high-dimensional problems, at the price of a
+ * lower acceptance rate for a given move size (which the move control then
+ * compensates for); a sweep takes ceil(n / blockSize) steps.
+ *
  * The system is considered "frozen" when its score fails to change more then
  * tolerance for maxToleranceSweep consecutive sweeps.
  *
@@ -72,6 +80,7 @@ class SA
    * @param maxMoveCoef Maximum move size.
    * @param initMoveCoef Initial move size.
    * @param gain Proportional control in feedback move control.
+   * @param blockSize Number of consecutive parameters perturbed by each move.
    */
   SA(CoolingScheduleType& coolingSchedule,
      const size_t maxIterations = 1000000,
@@ -82,7 +91,8 @@ class SA
      const size_t maxToleranceSweep = 3,
      const double maxMoveCoef = 20,
      const double initMoveCoef = 0.3,
-     const double gain = 0.3);
+     const double gain = 0.3,
+     const size_t blockSize = 1);
 
   /**
    * Optimize the given function using simulated annealing. The given starting
@@ -90,12 +100,16 @@ class SA
    * the final objective value is returned.
    *
    * @tparam FunctionType Type of function to optimize.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to optimize.
    * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
    * @return Objective value of the final point.
    */
-  template<typename FunctionType>
-  double Optimize(FunctionType& function, arma::mat& iterate);
+  template<typename FunctionType, typename... CallbackTypes>
+  double Optimize(FunctionType& function,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
 
   //! Get the temperature.
   double Temperature() const { return temperature; }
@@ -132,6 +146,11 @@ class SA
   //! Modify the maximum number of iterations.
   size_t& MaxIterations() { return maxIterations; }
 
+  //! Get the number of parameters perturbed by each move.
+  size_t BlockSize() const { return blockSize; }
+  //! Modify the number of parameters perturbed by each move.
+  size_t& BlockSize() { return blockSize; }
+
  private:
   //! The cooling schedule being used.
   CoolingScheduleType& coolingSchedule;
@@ -153,6 +172,11 @@ class SA
   double initMoveCoef;
   //! Proportional control in feedback move control.
   double gain;
+  //! Number of parameters perturbed by each move.
+  size_t blockSize;
+  //! The random number generator, seeded from Armadillo's generator at the
+  //! start of every optimization.
+  RNG rng;
 
   /**
    * GenerateMove proposes a move on element iterate(idx), and determines if
@@ -179,6 +203,31 @@ class SA
                     size_t& idx,
                     size_t& sweepCounter);
 
+  /**
+   * GenerateBlockMove() proposes moves on the elements idx, ..., idx +
+   * blockSize - 1 of the iterate (fewer at the end of a sweep), and accepts or
+   * rejects all of them together according to the Metropolis criterion.  The
+   * indices and the move control are then advanced as in GenerateMove().
+   *
+   * @param iterate Current optimization position.
+   * @param accept Matrix representing which parameters have had accepted moves.
+   * @param moveSize Strides for a move.
+   * @param proposal Storage for the proposed values of the block.
+   * @param energy Current energy of the system.
+   * @param idx First parameter of the block to modify.
+   * @param sweepCounter Current counter representing how many sweeps have been
+   *      completed.
+   */
+  template<typename FunctionType>
+  void GenerateBlockMove(FunctionType& function,
+                         arma::mat& iterate,
+                         arma::mat& accept,
+                         arma::mat& moveSize,
+                         arma::vec& proposal,
+                         double& energy,
+                         size_t& idx,
+                         size_t& sweepCounter);
+
   /**
    * MoveControl() uses a proportional feedback control to determine the size
    * parameter to pass to the move generation distribution. The target of such
@@ -27,7 +27,8 @@ SA<CoolingScheduleType>::SA(
     const size_t maxToleranceSweep,
     const double maxMoveCoef,
     const double initMoveCoef,
-    const double gain) :
+    const double gain,
+    const size_t blockSize) :
     coolingSchedule(coolingSchedule),
     maxIterations(maxIterations),
     temperature(initT),
@@ -37,26 +38,40 @@ SA<CoolingScheduleType>::SA(
     maxToleranceSweep(maxToleranceSweep),
     maxMoveCoef(maxMoveCoef),
     initMoveCoef(initMoveCoef),
-    gain(gain)
+    gain(gain),
+    blockSize(blockSize)
 {
   // Nothing to do.
 }
 
 //! Optimize the function (minimize).
 template<typename CoolingScheduleType>
-template<typename FunctionType>
+template<typename FunctionType, typename... CallbackTypes>
 double SA<CoolingScheduleType>::Optimize(FunctionType& function,
-                                         arma::mat& iterate)
+                                         arma::mat& iterate,
+                                         CallbackTypes&&... callbacks)
 {
   // Make sure we have the methods that we need.
   traits::CheckNonDifferentiableFunctionTypeAPI<FunctionType>();
 
+  if (blockSize == 0)
+    throw std::invalid_argument("SA::Optimize(): the block size must be "
+        "positive!");
+
   const size_t rows = iterate.n_rows;
   const size_t cols = iterate.n_cols;
+  rng.Seed(RNG::ArmaSeed());
+
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+  terminate |= Callback::BeginOptimization(*this, function, iterate,
+      callbacks...);
 
   size_t frozenCount = 0;
   double energy = function.Evaluate(iterate);
   double oldEnergy = energy;
+  terminate |= Callback::Evaluate(*this, function, iterate, energy,
+      callbacks...);
 
   size_t idx = 0;
   size_t sweepCounter = 0;
@@ -65,19 +80,46 @@ double SA<CoolingScheduleType>::Optimize(FunctionType& function,
   arma::mat moveSize(rows, cols);
   moveSize.fill(initMoveCoef);
 
-  // Initial moves to get rid of dependency of initial states.
-  for (size_t i = 0; i < initMoves; ++i)
-    GenerateMove(function, iterate, accept, moveSize, energy, idx,
-        sweepCounter);
+  // Each step moves a block of parameters, so a sweep takes movesPerSweep
+  // steps.
+  const size_t block = std::min(blockSize, (size_t) iterate.n_elem);
+  const size_t movesPerSweep = (iterate.n_elem + block - 1) / block;
+  arma::vec proposal(block);
+  auto move = [&]()
+  {
+    if (block == 1)
+    {
+      GenerateMove(function, iterate, accept, moveSize, energy, idx,
+          sweepCounter);
+    }
+    else
+    {
+      GenerateBlockMove(function, iterate, accept, moveSize, proposal, energy,
+          idx, sweepCounter);
+    }
+  };
+
+  // Initial moves to get rid of dependency of initial states.  Each move
+  // takes one evaluation, which is reported with the energy of the state
+  // after the move.
+  for (size_t i = 0; i < initMoves && !terminate; ++i)
+  {
+    move();
+    terminate |= Callback::Evaluate(*this, function, iterate, energy,
+        callbacks...);
+  }
 
   // Iterating and cooling.
-  for (size_t i = 0; i != maxIterations; ++i)
+  for (size_t i = 0; i != maxIterations && !terminate; ++i)
   {
     oldEnergy = energy;
-    GenerateMove(function, iterate, accept, moveSize, energy, idx,
-        sweepCounter);
+    move();
     temperature = coolingSchedule.NextTemperature(temperature, energy);
 
+    terminate |= Callback::Evaluate(*this, function, iterate, energy,
+        callbacks...);
+    terminate |= Callback::StepTaken(*this, function, iterate, callbacks...);
+
     // Determine if the optimization has entered (or continues to be in) a
     // frozen state.
     if (std::abs(energy - oldEnergy) < tolerance)
@@ -86,17 +128,23 @@ double SA<CoolingScheduleType>::Optimize(FunctionType& function,
       frozenCount = 0;
 
     // Terminate, if possible.
-    if (frozenCount >= maxToleranceSweep * moveCtrlSweep * iterate.n_elem)
+    if (frozenCount >= maxToleranceSweep * moveCtrlSweep * movesPerSweep)
     {
       Info << "SA: minimized within tolerance " << tolerance << " for "
           << maxToleranceSweep << " sweeps after " << i << " iterations; "
           << "terminating optimization." << std::endl;
+      Callback::EndOptimization(*this, function, iterate, callbacks...);
       return energy;
     }
   }
 
-  Warn << "SA: maximum iterations (" << maxIterations << ") reached; "
-      << "terminating optimization." << std::endl;
+  if (!terminate)
+  {
+    Warn << "SA: maximum iterations (" << maxIterations << ") reached; "
+        << "terminating optimization." << std::endl;
+  }
+
+  Callback::EndOptimization(*this, function, iterate, callbacks...);
   return energy;
 }
 
@@ -127,24 +175,25 @@ void SA<CoolingScheduleType>::GenerateMove(
   // MoveControl() is derived for the Laplace distribution.
 
   // Sample from a Laplace distribution with scale parameter moveSize(idx).
-  const double unif = 2.0 * arma::randu() - 1.0;
+  const double unif = 2.0 * rng.Randu() - 1.0;
   const double move = (unif < 0) ? (moveSize(idx) * std::log(1 + unif)) :
       (-moveSize(idx) * std::log(1 - unif));
 
-  iterate(idx) += move;
-  energy = function.Evaluate(iterate);
+  // Functions with EvaluateDelta() evaluate the move without a full
+  // evaluation.
+  energy = EvaluateMove(function, iterate, idx, prevValue + move, prevEnergy);
   // According to the Metropolis criterion, accept the move with probability
   // min{1, exp(-(E_new - E_old) / T)}.
-  const double xi = arma::randu();
+  const double xi = rng.Randu();
   const double delta = energy - prevEnergy;
   const double criterion = std::exp(-delta / temperature);
   if (delta <= 0. || criterion > xi)
   {
     accept(idx) += 1.;
+    iterate(idx) = prevValue + move;
   }
-  else // Reject the move; restore previous state.
+  else // Reject the move; keep the previous state.
   {
-    iterate(idx) = prevValue;
     energy = prevEnergy;
   }
 
@@ -162,6 +211,66 @@ void SA<CoolingScheduleType>::GenerateMove(
   }
 }
 
+template<typename CoolingScheduleType>
+template<typename FunctionType>
+void SA<CoolingScheduleType>::GenerateBlockMove(
+    FunctionType& function,
+    arma::mat& iterate,
+    arma::mat& accept,
+    arma::mat& moveSize,
+    arma::vec& proposal,
+    double& energy,
+    size_t& idx,
+    size_t& sweepCounter)
+{
+  const double prevEnergy = energy;
+  const size_t count = std::min((size_t) proposal.n_elem,
+      (size_t) iterate.n_elem - idx);
+  const double* values = iterate.memptr() + idx;
+  const double* sizes = moveSize.memptr() + idx;
+  double* newValues = proposal.memptr();
+
+  // Sample the moves of the whole block from Laplace distributions with scale
+  // parameters moveSize(idx), ..., as in GenerateMove().
+  for (size_t j = 0; j < count; ++j)
+  {
+    const double unif = 2.0 * rng.Randu() - 1.0;
+    newValues[j] = values[j] + ((unif < 0) ? (sizes[j] * std::log(1 + unif)) :
+        (-sizes[j] * std::log(1 - unif)));
+  }
+
+  energy = EvaluateBlockMove(function, iterate, idx, count, newValues,
+      prevEnergy);
+
+  // The block is accepted or rejected as a whole.
+  const double xi = rng.Randu();
+  const double delta = energy - prevEnergy;
+  if (delta <= 0. || std::exp(-delta / temperature) > xi)
+  {
+    std::copy(newValues, newValues + count, iterate.memptr() + idx);
+    double* accepted = accept.memptr() + idx;
+    for (size_t j = 0; j < count; ++j)
+      accepted[j] += 1.;
+  }
+  else // Reject the move; keep the previous state.
+  {
+    energy = prevEnergy;
+  }
+
+  idx += count;
+  if (idx == iterate.n_elem) // Finished with a sweep.
+  {
+    idx = 0;
+    ++sweepCounter;
+  }
+
+  if (sweepCounter == moveCtrlSweep) // Do MoveControl().
+  {
+    MoveControl(moveCtrlSweep, accept, moveSize);
+    sweepCounter = 0;
+  }
+}
+
 /**
  * MoveControl() uses a proportional feedback control to determine the size
  * parameter to pass to the move generation distribution. The target of such
@@ -181,19 +290,16 @@ inline void SA<CoolingScheduleType>::MoveControl(const size_t nMoves,
                                                  arma::mat& accept,
                                                  arma::mat& moveSize)
 {
-  arma::mat target;
-  target.copy_size(accept);
-  target.fill(0.44);
-  moveSize = arma::log(moveSize);
-  moveSize += gain * (accept / (double) nMoves - target);
-  moveSize = arma::exp(moveSize);
-
-  // To avoid the use of element-wise arma::min(), which is only available in
-  // Armadillo after v3.930, we use a for loop here instead.
+  // The multiplicative update exp(gain * (ratio - 0.44)) is applied to each
+  // element in place, without temporary matrices.
+  double* sizes = moveSize.memptr();
+  double* accepted = accept.memptr();
   for (size_t i = 0; i < accept.n_elem; ++i)
-    moveSize(i) = (moveSize(i) > maxMoveCoef) ? maxMoveCoef : moveSize(i);
-
-  accept.zeros();
+  {
+    sizes[i] *= std::exp(gain * (accepted[i] / (double) nMoves - 0.44));
+    sizes[i] = (sizes[i] > maxMoveCoef) ? maxMoveCoef : sizes[i];
+    accepted[i] = 0.;
+  }
 }
 
 } // namespace ens
@@ -0,0 +1,93 @@
+/**
+ * @file full_gradient_memory.hpp
+ *
+ * Gradient memory for SAGA and SAG that stores the last gradient of every
+ * batch.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SAGA_FULL_GRADIENT_MEMORY_HPP
+#define ENSMALLEN_SAGA_FULL_GRADIENT_MEMORY_HPP
+
+namespace ens {
+
+/**
+ * The FullGradientMemory stores the gradient of every batch as it was when
+ * the batch was last visited, and the sum of all the stored gradients.  It
+ * works with any differentiable separable function, and needs memory for one
+ * gradient per batch.
+ */
+class FullGradientMemory
+{
+ public:
+  /**
+   * Reset the memory: all stored gradients start at zero.
+   *
+   * @param rows Number of rows in the gradient matrix.
+   * @param cols Number of columns in the gradient matrix.
+   * @param numFunctions Number of separable functions.
+   * @param batchSize Number of functions in each batch.
+   */
+  void Initialize(const size_t rows,
+                  const size_t cols,
+                  const size_t numFunctions,
+                  const size_t batchSize)
+  {
+    const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+    gradients.zeros(rows, cols, numBatches);
+    sum.zeros(rows, cols);
+  }
+
+  /**
+   * Compute the gradient of the given batch at the given point, and replace
+   * the stored gradient of that batch with it.
+   *
+   * @param function Function to differentiate.
+   * @param iterate Current point.
+   * @param batch Index of the batch.
+   * @param begin First function of the batch.
+   * @param batchSize Number of functions in the batch.
+   * @param difference Matrix to store the new gradient minus the stored
+   *     gradient in.
+   */
+  template<typename DecomposableFunctionType>
+  void Update(DecomposableFunctionType& function,
+              const arma::mat& iterate,
+              const size_t batch,
+              const size_t begin,
+              const size_t batchSize,
+              arma::mat& difference)
+  {
+    function.Gradient(iterate, begin, difference, batchSize);
+    difference -= gradients.slice(batch);
+    gradients.slice(batch) += difference;
+    sum += difference;
+  }
+
+  /**
+   * Get the sum of the stored gradients of all batches.
+   *
+   * @param function Function being optimized.
+   * @param iterate Current point.
+   */
+  template<typename DecomposableFunctionType>
+  const arma::mat& Sum(DecomposableFunctionType& /* function */,
+                       const arma::mat& /* iterate */) const
+  {
+    return sum;
+  }
+
+ private:
+  //! The stored gradient of every batch.
+  arma::cube gradients;
+
+  //! The sum of the stored gradients.
+  arma::mat sum;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,139 @@
+/**
+ * @file linear_gradient_memory.hpp
+ *
+ * Gradient memory for SAGA and SAG that stores one scalar per function, for
+ * linear models.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SAGA_LINEAR_GRADIENT_MEMORY_HPP
+#define ENSMALLEN_SAGA_LINEAR_GRADIENT_MEMORY_HPP
+
+namespace ens {
+
+/**
+ * The LinearGradientMemory is meant for linear models such as generalized
+ * linear models, where the gradient of the loss of point i is a scalar
+ * coefficient (the derivative of the loss with respect to the linear
+ * predictor) times point i.  Then only the coefficient of each point needs to
+ * be stored, instead of a whole gradient per batch, and the stored gradients
+ * are summed into a single matrix.
+ *
+ * The regularization of the objective is not stored: the stored gradient of a
+ * batch is its stored loss gradient plus the regularization gradient at the
+ * current point.  This assumes, as is the convention for separable functions in
+ * ensmallen, that the regularization of a batch is proportional to its size.
+ *
+ * The function must provide, in addition to the separable function API:
+ *
+ * @code
+ * // Store the derivative of the loss of each point in the batch with respect
+ * // to its linear predictor in coefficients.
+ * void GradientCoefficients(const arma::mat& coordinates,
+ *                           const size_t begin,
+ *                           arma::rowvec& coefficients,
+ *                           const size_t batchSize);
+ *
+ * // Store the sum of the points in the batch weighted by the given
+ * // coefficients (the loss gradient of the batch, without regularization) in
+ * // gradient.
+ * void CoefficientGradient(const arma::mat& coordinates,
+ *                          const size_t begin,
+ *                          const arma::rowvec& coefficients,
+ *                          arma::mat& gradient,
+ *                          const size_t batchSize);
+ *
+ * // Store the gradient of the regularization of the whole objective in
+ * // gradient.
+ * void RegularizationGradient(const arma::mat& coordinates,
+ *                             arma::mat& gradient);
+ * @endcode
+ *
+ * LogisticRegressionFunction is an example.
+ */
+class LinearGradientMemory
+{
+ public:
+  /**
+   * Reset the memory: all stored coefficients start at zero.
+   *
+   * @param rows Number of rows in the gradient matrix.
+   * @param cols Number of columns in the gradient matrix.
+   * @param numFunctions Number of separable functions.
+   * @param batchSize Number of functions in each batch.
+   */
+  void Initialize(const size_t rows,
+                  const size_t cols,
+                  const size_t numFunctions,
+                  const size_t /* batchSize */)
+  {
+    coefficients.zeros(numFunctions);
+    lossSum.zeros(rows, cols);
+  }
+
+  /**
+   * Compute the coefficients of the given batch at the given point, and
+   * replace the stored coefficients of that batch with them.
+   *
+   * @param function Function to differentiate.
+   * @param iterate Current point.
+   * @param batch Index of the batch.
+   * @param begin First function of the batch.
+   * @param batchSize Number of functions in the batch.
+   * @param difference Matrix to store the new gradient minus the stored
+   *     gradient in.
+   */
+  template<typename DecomposableFunctionType>
+  void Update(DecomposableFunctionType& function,
+              const arma::mat& iterate,
+              const size_t /* batch */,
+              const size_t begin,
+              const size_t batchSize,
+              arma::mat& difference)
+  {
+    function.GradientCoefficients(iterate, begin, delta, batchSize);
+    delta -= coefficients.subvec(begin, begin + batchSize - 1);
+    coefficients.subvec(begin, begin + batchSize - 1) += delta;
+
+    // The regularization terms cancel, so the difference is only the change
+    // in the loss gradient.
+    function.CoefficientGradient(iterate, begin, delta, difference,
+        batchSize);
+    lossSum += difference;
+  }
+
+  /**
+   * Get the sum of the stored gradients of all batches.
+   *
+   * @param function Function being optimized.
+   * @param iterate Current point.
+   */
+  template<typename DecomposableFunctionType>
+  const arma::mat& Sum(DecomposableFunctionType& function,
+                       const arma::mat& iterate)
+  {
+    function.RegularizationGradient(iterate, sum);
+    sum += lossSum;
+    return sum;
+  }
+
+ private:
+  //! The stored coefficient of every function.
+  arma::rowvec coefficients;
+
+  //! The change of the coefficients of the current batch.
+  arma::rowvec delta;
+
+  //! The sum of the stored loss gradients.
+  arma::mat lossSum;
+
+  //! The sum of the stored gradients, including the regularization.
+  arma::mat sum;
+};
+
+} // namespace ens
+
+#endif
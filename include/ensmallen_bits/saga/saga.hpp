@@ -0,0 +1,200 @@
+/**
+ * @file saga.hpp
+ *
+ * SAGA and Stochastic Average Gradient (SAG).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SAGA_SAGA_HPP
+#define ENSMALLEN_SAGA_SAGA_HPP
+
+#include "full_gradient_memory.hpp"
+#include "linear_gradient_memory.hpp"
+
+namespace ens {
+
+/**
+ * SAGA and Stochastic Average Gradient (SAG) are variance reducing stochastic
+ * gradient methods for minimizing a function which can be expressed as a sum
+ * of other functions.  Instead of taking a full gradient pass every epoch like
+ * SVRG, they keep in memory the last gradient computed for every batch, and
+ * use the average of the stored gradients as a running estimate of the full
+ * gradient.  At each step a random batch b is chosen, its gradient g_b is
+ * computed at the current point and replaces the stored gradient m_b, and
+ *
+ *   SAGA: w = w - stepSize * ((g_b - m_b) / |b| + mean(m)),
+ *   SAG:  w = w - stepSize * mean(m),
+ *
+ * where mean(m) is taken after (SAG) or before (SAGA) replacing m_b.  SAGA
+ * uses an unbiased estimate of the gradient; SAG uses a biased one with lower
+ * variance.
+ *
+ * How the gradients are stored is given by the memory policy.  The
+ * FullGradientMemory stores one gradient per batch and works with any
+ * differentiable separable function.  The LinearGradientMemory stores one
+ * scalar per function, for linear models that expose the gradient of each
+ * point as a coefficient times that point; see its documentation for the
+ * required API.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{Defazio2014,
+ *   author    = {Defazio, Aaron and Bach, Francis and Lacoste-Julien, Simon},
+ *   title     = {SAGA: A Fast Incremental Gradient Method With Support for
+ *                Non-Strongly Convex Composite Objectives},
+ *   booktitle = {Advances in Neural Information Processing Systems 27},
+ *   pages     = {1646--1654},
+ *   year      = {2014}
+ * }
+ *
+ * @article{Schmidt2017,
+ *   author  = {Schmidt, Mark and Le Roux, Nicolas and Bach, Francis},
+ *   title   = {Minimizing Finite Sums with the Stochastic Average Gradient},
+ *   journal = {Mathematical Programming},
+ *   volume  = {162},
+ *   number  = {1},
+ *   pages   = {83--112},
+ *   year    = {2017}
+ * }
+ * @endcode
+ *
+ * SAGA and SAG can optimize differentiable separable functions.  For more
+ * details, see the documentation on function types included with this
+ * distribution or on the ensmallen website.
+ *
+ * @tparam MemoryPolicyType Policy used to store the per-batch gradients.
+ * @tparam Unbiased If true, use the SAGA step; otherwise, use the SAG step.
+ */
+template<typename MemoryPolicyType = FullGradientMemory, bool Unbiased = true>
+class SAGAType
+{
+ public:
+  /**
+   * Construct the SAGA (or SAG) optimizer with the given parameters.  The
+   * defaults here are not necessarily good for the given problem, so it is
+   * suggested that the values used be tailored to the task at hand.  The
+   * maximum number of iterations refers to the maximum number of points that
+   * are processed (i.e., one iteration equals one point; one iteration does not
+   * equal one pass over the dataset).
+   *
+   * The gradient memory refers to functions by their index, so the function
+   * order is never shuffled: if shuffle is true, each step uses a batch chosen
+   * uniformly at random; otherwise, the batches are visited in linear order.
+   *
+   * @param stepSize Step size for each iteration.
+   * @param batchSize Batch size to use for each step.
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *     limit).
+   * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param shuffle If true, choose each batch at random; otherwise, visit the
+   *     batches in linear order.
+   * @param memoryPolicy Instantiated memory policy used to store the
+   *     gradients.
+   */
+  SAGAType(const double stepSize = 0.01,
+           const size_t batchSize = 32,
+           const size_t maxIterations = 100000,
+           const double tolerance = 1e-5,
+           const bool shuffle = true,
+           const MemoryPolicyType& memoryPolicy = MemoryPolicyType());
+
+  /**
+   * Optimize the given function using SAGA (or SAG).  The given starting point
+   * will be modified to store the finishing point of the algorithm, and the
+   * final objective value is returned.
+   *
+   * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename DecomposableFunctionType, typename... CallbackTypes>
+  double Optimize(DecomposableFunctionType& function,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the batch size.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the batches are chosen at random.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the batches are chosen at random.
+  bool& Shuffle() { return shuffle; }
+
+  //! Get the memory policy.
+  const MemoryPolicyType& MemoryPolicy() const { return memoryPolicy; }
+  //! Modify the memory policy.
+  MemoryPolicyType& MemoryPolicy() { return memoryPolicy; }
+
+ private:
+  //! The step size for each example.
+  double stepSize;
+
+  //! The batch size for processing.
+  size_t batchSize;
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the batches are chosen at random.
+  bool shuffle;
+
+  //! The memory policy used to store the gradients.
+  MemoryPolicyType memoryPolicy;
+};
+
+// Convenience typedefs.
+
+/**
+ * SAGA, storing the gradient of every batch.
+ */
+using SAGA = SAGAType<FullGradientMemory, true>;
+
+/**
+ * Stochastic Average Gradient, storing the gradient of every batch.
+ */
+using SAG = SAGAType<FullGradientMemory, false>;
+
+/**
+ * SAGA for linear models, storing one scalar per function.
+ */
+using LinearSAGA = SAGAType<LinearGradientMemory, true>;
+
+/**
+ * Stochastic Average Gradient for linear models, storing one scalar per
+ * function.
+ */
+using LinearSAG = SAGAType<LinearGradientMemory, false>;
+
+} // namespace ens
+
+// Include implementation.
+#include "saga_impl.hpp"
+
+#endif
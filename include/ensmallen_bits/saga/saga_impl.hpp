@@ -0,0 +1,158 @@
+/**
+ * @file saga_impl.hpp
+ *
+ * Implementation of SAGA and Stochastic Average Gradient (SAG).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SAGA_SAGA_IMPL_HPP
+#define ENSMALLEN_SAGA_SAGA_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "saga.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+template<typename MemoryPolicyType, bool Unbiased>
+SAGAType<MemoryPolicyType, Unbiased>::SAGAType(
+    const double stepSize,
+    const size_t batchSize,
+    const size_t maxIterations,
+    const double tolerance,
+    const bool shuffle,
+    const MemoryPolicyType& memoryPolicy) :
+    stepSize(stepSize),
+    batchSize(batchSize),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    shuffle(shuffle),
+    memoryPolicy(memoryPolicy)
+{ /* Nothing to do. */ }
+
+//! Optimize the function (minimize).
+template<typename MemoryPolicyType, bool Unbiased>
+template<typename DecomposableFunctionType, typename... CallbackTypes>
+double SAGAType<MemoryPolicyType, Unbiased>::Optimize(
+    DecomposableFunctionType& function,
+    arma::mat& iterate,
+    CallbackTypes&&... callbacks)
+{
+  // Make sure that we have the methods that we need.
+  traits::CheckDecomposableFunctionTypeAPI<DecomposableFunctionType>();
+
+  // Find the number of functions to use.
+  const size_t numFunctions = function.NumFunctions();
+
+  // Find the number of batches.
+  const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+
+  // All the stored gradients start at zero, so no full pass is needed.
+  memoryPolicy.Initialize(iterate.n_rows, iterate.n_cols, numFunctions,
+      batchSize);
+
+  // To keep track of where we are and how things are going.
+  double overallObjective = 0;
+  double lastObjective = DBL_MAX;
+
+  // The change of the stored gradient of the current batch.
+  arma::mat difference(iterate.n_rows, iterate.n_cols);
+
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+  terminate |= Callback::BeginOptimization(*this, function, iterate,
+      callbacks...);
+
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+  size_t epoch = 0;
+  for (size_t i = 0, epochPoints = 0, currentBatch = 0;
+      i < actualMaxIterations && !terminate;
+      /* incrementing done manually */)
+  {
+    // Choose the batch to visit.
+    const size_t batch = shuffle ?
+        (size_t) arma::randi<arma::uvec>(1,
+            arma::distr_param(0, (int) numBatches - 1))(0) : currentBatch;
+    currentBatch = (currentBatch + 1) % numBatches;
+
+    // Find the effective batch size (the last batch may be smaller).
+    const size_t begin = batch * batchSize;
+    const size_t effectiveBatchSize = std::min(batchSize,
+        numFunctions - begin);
+
+    // Replace the stored gradient of the batch; this also updates the sum of
+    // the stored gradients.
+    memoryPolicy.Update(function, iterate, batch, begin, effectiveBatchSize,
+        difference);
+    const arma::mat& sum = memoryPolicy.Sum(function, iterate);
+
+    if (Unbiased)
+    {
+      // The mean of the stored gradients before the update, corrected by the
+      // change of the current batch.
+      iterate -= stepSize * (difference / (double) effectiveBatchSize +
+          (sum - difference) / (double) numFunctions);
+    }
+    else
+    {
+      iterate -= stepSize * sum / (double) numFunctions;
+    }
+
+    terminate |= Callback::StepTaken(*this, function, iterate, callbacks...);
+
+    i += effectiveBatchSize;
+    epochPoints += effectiveBatchSize;
+
+    // Check the objective once for every pass over the data.
+    if (epochPoints >= numFunctions || i >= actualMaxIterations)
+    {
+      epochPoints = 0;
+      overallObjective = FullPassEvaluate(function, iterate, batchSize);
+
+      terminate |= Callback::Evaluate(*this, function, iterate,
+          overallObjective, callbacks...);
+      terminate |= Callback::EndEpoch(*this, function, iterate, epoch++,
+          overallObjective, callbacks...);
+
+      if (std::isnan(overallObjective) || std::isinf(overallObjective))
+      {
+        Warn << "SAGA: converged to " << overallObjective
+            << "; terminating with failure.  Try a smaller step size?"
+            << std::endl;
+        Callback::EndOptimization(*this, function, iterate, callbacks...);
+        return overallObjective;
+      }
+
+      if (std::abs(lastObjective - overallObjective) < tolerance)
+      {
+        Info << "SAGA: minimized within tolerance " << tolerance
+            << "; terminating optimization." << std::endl;
+        Callback::EndOptimization(*this, function, iterate, callbacks...);
+        return overallObjective;
+      }
+
+      lastObjective = overallObjective;
+    }
+  }
+
+  if (!terminate)
+  {
+    Info << "SAGA: maximum iterations (" << maxIterations << ") reached; "
+        << "terminating optimization." << std::endl;
+  }
+
+  // Calculate final objective.
+  overallObjective = FullPassEvaluate(function, iterate, batchSize);
+
+  Callback::EndOptimization(*this, function, iterate, callbacks...);
+  return overallObjective;
+}
+
+} // namespace ens
+
+#endif
@@ -67,6 +67,10 @@ class SARAHType
    *     function is visited in linear order.
    * @param updatePolicy Instantiated update policy used to adjust the given
    *     parameters.
+   * @param parallelFullPass If true, split the full gradient and objective
+   *     passes over all functions across OpenMP threads; the separable
+   *     Evaluate() and Gradient() of the function must then be safe to call
+   *     concurrently on disjoint batches.
    */
   SARAHType(const double stepSize = 0.01,
             const size_t batchSize = 32,
@@ -74,7 +78,8 @@ class SARAHType
             const size_t innerIterations = 0,
             const double tolerance = 1e-5,
             const bool shuffle = true,
-            const UpdatePolicyType& updatePolicy = UpdatePolicyType());
+            const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
+            const bool parallelFullPass = false);
 
   /**
    * Optimize the given function using SARAH. The given starting point will be
@@ -124,6 +129,11 @@ class SARAHType
   //! Modify the update policy.
   UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
 
+  //! Get whether the full passes are computed in parallel.
+  bool ParallelFullPass() const { return parallelFullPass; }
+  //! Modify whether the full passes are computed in parallel.
+  bool& ParallelFullPass() { return parallelFullPass; }
+
  private:
   //! The step size for each example.
   double stepSize;
@@ -146,6 +156,9 @@ class SARAHType
 
   //! The update policy used to update the parameters in each iteration.
   UpdatePolicyType updatePolicy;
+
+  //! Whether the full gradient and objective passes are computed in parallel.
+  bool parallelFullPass;
 };
 
 // Convenience typedefs.
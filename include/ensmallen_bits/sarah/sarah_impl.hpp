@@ -27,14 +27,16 @@ SARAHType<UpdatePolicyType>::SARAHType(
     const size_t innerIterations,
     const double tolerance,
     const bool shuffle,
-    const UpdatePolicyType& updatePolicy) :
+    const UpdatePolicyType& updatePolicy,
+    const bool parallelFullPass) :
     stepSize(stepSize),
     batchSize(batchSize),
     maxIterations(maxIterations),
     innerIterations(innerIterations),
     tolerance(tolerance),
     shuffle(shuffle),
-    updatePolicy(updatePolicy)
+    updatePolicy(updatePolicy),
+    parallelFullPass(parallelFullPass)
 { /* Nothing to do. */ }
 
 //! Optimize the function (minimize).
@@ -72,12 +74,8 @@ double SARAHType<UpdatePolicyType>::Optimize(
   for (size_t i = 0; i < actualMaxIterations; ++i)
   {
     // Calculate the objective function.
-    overallObjective = 0;
-    for (size_t f = 0; f < numFunctions; f += batchSize)
-    {
-      const size_t effectiveBatchSize = std::min(batchSize, numFunctions - f);
-      overallObjective += function.Evaluate(iterate, f, effectiveBatchSize);
-    }
+    overallObjective = FullPassEvaluate(function, iterate, batchSize,
+        parallelFullPass);
 
     if (std::isnan(overallObjective) || std::isinf(overallObjective))
     {
@@ -97,19 +95,7 @@ double SARAHType<UpdatePolicyType>::Optimize(
     lastObjective = overallObjective;
 
     // Compute the full gradient.
-    size_t effectiveBatchSize = std::min(batchSize, numFunctions);
-    function.Gradient(iterate, 0, v, effectiveBatchSize);
-    for (size_t f = effectiveBatchSize; f < numFunctions;
-        /* incrementing done manually */)
-    {
-      // Find the effective batch size (the last batch may be smaller).
-      effectiveBatchSize = std::min(batchSize, numFunctions - f);
-
-      function.Gradient(iterate, f, gradient, effectiveBatchSize);
-      v += gradient;
-
-      f += effectiveBatchSize;
-    }
+    FullPassGradient(function, iterate, batchSize, v, parallelFullPass);
     v /= (double) numFunctions;
 
     // Update iterate with full gradient (v).
@@ -131,17 +117,15 @@ double SARAHType<UpdatePolicyType>::Optimize(
       }
 
       // Find the effective batch size (the last batch may be smaller).
-      effectiveBatchSize = std::min(batchSize, numFunctions - currentFunction);
-
-      // Calculate variance reduced gradient.
-      function.Gradient(iterate, currentFunction, gradient,
-          effectiveBatchSize);
+      const size_t effectiveBatchSize = std::min(batchSize,
+          numFunctions - currentFunction);
 
       // Avoid an unnecessary copy on the first iteration.
       if (f > 0)
       {
-        function.Gradient(iterate0, currentFunction, gradient0,
-            effectiveBatchSize);
+        // Calculate variance reduced gradient.
+        DualBatchGradient(function, iterate, iterate0, currentFunction,
+            gradient, gradient0, effectiveBatchSize);
 
         // Store current parameter for the calculation of the variance reduced
         // gradient.
@@ -156,6 +140,9 @@ double SARAHType<UpdatePolicyType>::Optimize(
       }
       else
       {
+        function.Gradient(iterate, currentFunction, gradient,
+            effectiveBatchSize);
+
         // Store current parameter for the calculation of the variance reduced
         // gradient.
         iterate0 = iterate;
@@ -177,12 +164,8 @@ double SARAHType<UpdatePolicyType>::Optimize(
       << "terminating optimization." << std::endl;
 
   // Calculate final objective.
-  overallObjective = 0;
-  for (size_t i = 0; i < numFunctions; i += batchSize)
-  {
-    const size_t effectiveBatchSize = std::min(batchSize, numFunctions - i);
-    overallObjective += function.Evaluate(iterate, i, effectiveBatchSize);
-  }
+  overallObjective = FullPassEvaluate(function, iterate, batchSize,
+      parallelFullPass);
   return overallObjective;
 }
 
@@ -0,0 +1,111 @@
+/**
+ * @file block_coordinate_function.hpp
+ *
+ * Adapter that presents the blocks of features of a partially differentiable
+ * function as single features, for the SCD descent policies.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SCD_BLOCK_COORDINATE_FUNCTION_HPP
+#define ENSMALLEN_SCD_BLOCK_COORDINATE_FUNCTION_HPP
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+/**
+ * BlockCoordinateFunction wraps a partially differentiable function so that
+ * each block of blockSize consecutive features (the last block may be smaller)
+ * looks like one feature.  It is used by SCD in block coordinate descent mode,
+ * so that the descent policies pick blocks instead of features without having
+ * to know about them.  The partial gradient of a block is the gradient with
+ * respect to all the features of the block.
+ *
+ * @tparam ResolvableFunctionType Type of the wrapped function.
+ */
+template<typename ResolvableFunctionType>
+class BlockCoordinateFunction
+{
+ public:
+  /**
+   * Wrap the given function.  The function must outlive this object.
+   *
+   * @param function The function to wrap.
+   * @param blockSize The number of features in each block.
+   */
+  BlockCoordinateFunction(ResolvableFunctionType& function,
+                          const size_t blockSize) :
+      function(function),
+      blockSize(blockSize)
+  { /* Nothing to do. */ }
+
+  //! Return the number of blocks.
+  size_t NumFeatures() const
+  {
+    return (function.NumFeatures() + blockSize - 1) / blockSize;
+  }
+
+  //! Return the first feature of the given block.
+  size_t BlockBegin(const size_t block) const { return block * blockSize; }
+
+  //! Return the number of features in the given block.
+  size_t BlockLength(const size_t block) const
+  {
+    return std::min(blockSize, function.NumFeatures() - block * blockSize);
+  }
+
+  //! Evaluate the wrapped function.
+  double Evaluate(const arma::mat& coordinates) const
+  {
+    return function.Evaluate(coordinates);
+  }
+
+  /**
+   * Compute the dense partial gradient of the given block.
+   *
+   * @param coordinates The point at which to compute the gradient.
+   * @param block The index of the block.
+   * @param gradient Matrix to store the gradient of the block into (one
+   *    column for each feature of the block).
+   */
+  void BlockGradient(const arma::mat& coordinates,
+                     const size_t block,
+                     arma::mat& gradient) const
+  {
+    BlockPartialGradient(function, coordinates, BlockBegin(block), gradient,
+        BlockLength(block));
+  }
+
+  /**
+   * Compute the partial gradient of the given block, as a sparse matrix of the
+   * size of the coordinates.  This is what the descent policies use.
+   *
+   * @param coordinates The point at which to compute the gradient.
+   * @param block The index of the block.
+   * @param gradient Sparse matrix to output the gradient into.
+   */
+  void PartialGradient(const arma::mat& coordinates,
+                       const size_t block,
+                       arma::sp_mat& gradient) const
+  {
+    arma::mat blockGradient;
+    BlockGradient(coordinates, block, blockGradient);
+
+    gradient.zeros(arma::size(coordinates));
+    gradient.cols(BlockBegin(block), BlockBegin(block) + BlockLength(block) -
+        1) = blockGradient;
+  }
+
+ private:
+  //! The wrapped function.
+  ResolvableFunctionType& function;
+  //! The number of features in each block.
+  size_t blockSize;
+};
+
+} // namespace ens
+
+#endif
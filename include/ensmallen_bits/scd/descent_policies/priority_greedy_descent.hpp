@@ -0,0 +1,208 @@
+/**
+ * @file priority_greedy_descent.hpp
+ *
+ * Greedy descent policy for Stochastic Coordinate Descent (SCD) that keeps the
+ * partial gradient magnitudes in an indexed max-heap.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SCD_DESCENT_POLICIES_PRIORITY_GREEDY_HPP
+#define ENSMALLEN_SCD_DESCENT_POLICIES_PRIORITY_GREEDY_HPP
+
+namespace ens {
+
+/**
+ * Greedy descent policy for Stochastic Co-ordinate Descent(SCD) that picks the
+ * coordinate with the largest partial gradient magnitude (the Gauss-Southwell
+ * rule), like GreedyDescent, but without computing every partial gradient in
+ * each iteration.  The magnitudes are kept in an indexed max-heap, which is
+ * built with one pass over the features at the start of the optimization (and
+ * every refreshInterval iterations, if it is nonzero).
+ *
+ * After that, the heap is updated incrementally: the magnitude of the
+ * coordinate that was just descended on is recomputed and moved to its new
+ * place, and then the magnitude of the top coordinate is recomputed at the
+ * current point until the top coordinate has been recomputed in the current
+ * iteration.  Each iteration then costs a few partial gradients and
+ * O(log features) heap operations.  The choice is exact when each partial
+ * gradient only depends on its own coordinate; otherwise the magnitudes of the
+ * other coordinates may be stale, and refreshInterval bounds how stale they can
+ * get.
+ *
+ * For more information, refer to the following.
+ * @code
+ * @misc{Nutini2015,
+ *   author = {Julie Nutini and Mark Schmidt and Issam H.
+ *             Laradji and Michael Friedlander and Hoyt Koepke},
+ *   title  = {Coordinate Descent Converges Faster with the Gauss-Southwell Rule
+ *             Than Random Selection},
+ *   year   = {2015},
+ *   eprint = {arXiv:1506.00552}
+ * }
+ * @endcode
+ */
+class PriorityGreedyDescent
+{
+ public:
+  /**
+   * Construct the policy.
+   *
+   * @param refreshInterval Number of iterations after which all the partial
+   *    gradient magnitudes are recomputed (0 means only at the start of the
+   *    optimization).
+   */
+  PriorityGreedyDescent(const size_t refreshInterval = 0) :
+      refreshInterval(refreshInterval),
+      lastFeature(0)
+  { /* Nothing to do. */ }
+
+  /**
+   * The DescentFeature method is used to get the descent coordinate for the
+   * current iteration.  The heap is rebuilt when the iteration number is 0 or
+   * 1 (SCD starts counting at 1), so the policy can be reused for several
+   * optimizations.
+   *
+   * @tparam ResolvableFunctionType The type of the function to be optimized.
+   * @param iteration The iteration number for which the feature is to be
+   *    obtained.
+   * @param iterate The current value of the decision variable.
+   * @param function The function to be optimized.
+   * @return The index of the coordinate to be descended.
+   */
+  template <typename ResolvableFunctionType>
+  size_t DescentFeature(const size_t iteration,
+                        const arma::mat& iterate,
+                        const ResolvableFunctionType& function)
+  {
+    if (iteration <= 1 || heap.size() != function.NumFeatures() ||
+        (refreshInterval != 0 && iteration % refreshInterval == 0))
+    {
+      Build(iteration, iterate, function);
+    }
+    else if (computedAt[lastFeature] != iteration)
+    {
+      // The last coordinate that was picked has probably been descended on.
+      Update(lastFeature, Priority(iterate, lastFeature, function), iteration);
+    }
+
+    // Make sure that the top of the heap is up to date.
+    while (!heap.empty() && computedAt[heap[0]] != iteration)
+      Update(heap[0], Priority(iterate, heap[0], function), iteration);
+
+    lastFeature = heap.empty() ? 0 : heap[0];
+    return lastFeature;
+  }
+
+  //! Get the refresh interval.
+  size_t RefreshInterval() const { return refreshInterval; }
+  //! Modify the refresh interval.
+  size_t& RefreshInterval() { return refreshInterval; }
+
+ private:
+  //! Compute the partial gradient magnitude of the given feature.
+  template <typename ResolvableFunctionType>
+  static double Priority(const arma::mat& iterate,
+                         const size_t feature,
+                         const ResolvableFunctionType& function)
+  {
+    arma::sp_mat fGrad;
+    function.PartialGradient(iterate, feature, fGrad);
+    return arma::norm(fGrad, "fro");
+  }
+
+  //! Compute all the magnitudes and build the heap.
+  template <typename ResolvableFunctionType>
+  void Build(const size_t iteration,
+             const arma::mat& iterate,
+             const ResolvableFunctionType& function)
+  {
+    const size_t features = function.NumFeatures();
+    heap.resize(features);
+    positions.resize(features);
+    priorities.resize(features);
+    computedAt.assign(features, iteration);
+    for (size_t i = 0; i < features; ++i)
+    {
+      heap[i] = i;
+      positions[i] = i;
+      priorities[i] = Priority(iterate, i, function);
+    }
+
+    for (size_t i = features / 2; i > 0; --i)
+      SiftDown(i - 1);
+  }
+
+  //! Set the magnitude of the given feature, and restore the heap order.
+  void Update(const size_t feature,
+              const double priority,
+              const size_t iteration)
+  {
+    const double oldPriority = priorities[feature];
+    priorities[feature] = priority;
+    computedAt[feature] = iteration;
+    if (priority > oldPriority)
+      SiftUp(positions[feature]);
+    else
+      SiftDown(positions[feature]);
+  }
+
+  //! Move the entry at the given heap position up to its place.
+  void SiftUp(size_t i)
+  {
+    while (i > 0)
+    {
+      const size_t parent = (i - 1) / 2;
+      if (priorities[heap[parent]] >= priorities[heap[i]])
+        return;
+
+      std::swap(heap[i], heap[parent]);
+      positions[heap[i]] = i;
+      positions[heap[parent]] = parent;
+      i = parent;
+    }
+  }
+
+  //! Move the entry at the given heap position down to its place.
+  void SiftDown(size_t i)
+  {
+    while (true)
+    {
+      const size_t left = 2 * i + 1;
+      const size_t right = left + 1;
+      size_t largest = i;
+      if (left < heap.size() &&
+          priorities[heap[left]] > priorities[heap[largest]])
+        largest = left;
+      if (right < heap.size() &&
+          priorities[heap[right]] > priorities[heap[largest]])
+        largest = right;
+      if (largest == i)
+        return;
+
+      std::swap(heap[i], heap[largest]);
+      positions[heap[i]] = i;
+      positions[heap[largest]] = largest;
+      i = largest;
+    }
+  }
+
+  //! The number of iterations after which the heap is rebuilt.
+  size_t refreshInterval;
+  //! The features, ordered as a max-heap on their magnitudes.
+  std::vector<size_t> heap;
+  //! The position of each feature in the heap.
+  std::vector<size_t> positions;
+  //! The last computed partial gradient magnitude of each feature.
+  std::vector<double> priorities;
+  //! The iteration in which the magnitude of each feature was computed.
+  std::vector<size_t> computedAt;
+  //! The feature returned by the last call.
+  size_t lastFeature;
+};
+
+} // namespace ens
+
+#endif
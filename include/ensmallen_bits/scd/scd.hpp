@@ -15,6 +15,9 @@
 #include "descent_policies/cyclic_descent.hpp"
 #include "descent_policies/random_descent.hpp"
 #include "descent_policies/greedy_descent.hpp"
+#include "descent_policies/priority_greedy_descent.hpp"
+#include "block_coordinate_function.hpp"
+#include "screened_coordinate_function.hpp"
 
 namespace ens {
 
@@ -42,6 +45,115 @@ namespace ens {
  * }
  * @endcode
  *
+ * SCD can also update several coordinates at once, as in Shotgun (Bradley et
+ * al., 2011): when parallelUpdates is larger than one, each round takes that
+ * many coordinates from the descent policy, computes their partial gradients in
+ * parallel at the same point (with OpenMP, if it is enabled), and then updates
+ * all of them.  A coordinate that the policy picks twice in one round is only
+ * updated once, so GreedyDescent, which always picks the same coordinate at a
+ * given point, gains nothing from this mode.  Shotgun converges as long as the
+ * number of parallel updates is small compared to the number of features
+ * divided by the spectral radius of the Hessian; for problems with many weakly
+ * correlated features, such as sparse L1-regularized problems, the speedup is
+ * close to linear.  PartialGradient() has to be safe to call from several
+ * threads at once.
+ *
+ * @code
+ * @inproceedings{Bradley2011,
+ *   author    = {Bradley, Joseph K. and Kyrola, Aapo and Bickson, Danny and
+ *                Guestrin, Carlos},
+ *   title     = {Parallel Coordinate Descent for L1-Regularized Loss
+ *                Minimization},
+ *   booktitle = {Proceedings of the 28th International Conference on Machine
+ *                Learning},
+ *   series    = {ICML '11},
+ *   year      = {2011}
+ * }
+ * @endcode
+ *
+ * With a blockSize larger than one, SCD does block coordinate descent: the
+ * descent policy picks blocks of blockSize consecutive features instead of
+ * single features, and the whole block is updated with a dense partial
+ * gradient.  A function can compute the gradient of a block at once, which
+ * saves the per-feature overhead when the features are cheap, by implementing
+ *
+ * @code
+ * void PartialGradient(const arma::mat& coordinates,
+ *                      const size_t begin,
+ *                      arma::mat& gradient,
+ *                      const size_t blockSize);
+ * @endcode
+ *
+ * (possibly const), which sets gradient to the gradient with respect to the
+ * features begin, ..., begin + blockSize - 1, one column per feature;
+ * otherwise the partial gradient of each feature of the block is computed
+ * separately.  The policy sees each block as a feature, so GreedyDescent picks
+ * the block with the largest gradient.
+ *
+ * The objective is checked for convergence every updateInterval iterations.
+ * Instead of a pass over the data for each check, a function can keep cached
+ * quantities such as residuals or margins up to date after each coordinate
+ * step, and compute the objective from them, by implementing
+ *
+ * @code
+ * void ResetCache(const arma::mat& coordinates);
+ * void UpdateCache(const arma::mat& coordinates,
+ *                  const size_t j,
+ *                  const arma::mat& delta);
+ * double CachedEvaluate();
+ * @endcode
+ *
+ * where UpdateCache() is called after column j of the coordinates changed by
+ * delta.  Rounding errors can accumulate in the cache over long runs, so the
+ * function may want to recompute it from scratch now and then.
+ *
+ * For problems such as the lasso, many coordinates are provably zero at the
+ * optimum, and a safe screening rule (for instance the gap safe rules of
+ * Fercoq et al., 2015) can tell which ones from the current point.  A function
+ * can provide such a rule by implementing
+ *
+ * @code
+ * void ScreenFeatures(const arma::mat& coordinates,
+ *                     std::vector<bool>& active);
+ * @endcode
+ *
+ * (possibly const), which sets active[j] to false for the features j that are
+ * zero at the optimum.  SCD then calls it at the start and at every
+ * convergence check, sets the screened coordinates to zero, and has the
+ * descent policy choose only from the remaining active features, so each
+ * iteration spends its time on the features that matter.  Screening is not
+ * used in block mode, or if Screening() is false.
+ *
+ * @code
+ * @inproceedings{Fercoq2015,
+ *   author    = {Fercoq, Olivier and Gramfort, Alexandre and Salmon, Joseph},
+ *   title     = {Mind the Duality Gap: Safer Rules for the Lasso},
+ *   booktitle = {Proceedings of the 32nd International Conference on Machine
+ *                Learning},
+ *   series    = {ICML '15},
+ *   year      = {2015}
+ * }
+ * @endcode
+ *
+ * For cheap coordinates, building a sparse matrix for the partial gradient of
+ * each step can cost more than the derivative itself.  A function can compute
+ * the derivatives of a feature as scalars instead, and give the Lipschitz
+ * constant L_j of the partial derivatives of each feature, by implementing
+ *
+ * @code
+ * double PartialDerivative(const arma::mat& coordinates,
+ *                          const size_t j,
+ *                          const size_t row);
+ * double CoordinateLipschitz(const size_t j);
+ * @endcode
+ *
+ * (both possibly const, and each optional), where PartialDerivative() returns
+ * the derivative with respect to coordinates(row, j).  With
+ * CoordinateLipschitz(), feature j takes steps of size 1 / L_j instead of the
+ * given step size (unless LipschitzSteps() is false), which minimizes a
+ * quadratic along the feature exactly; block mode always uses the given step
+ * size.
+ *
  * SCD can optimize partially differentiable functions.  For more details, see
  * the documentation on function types included with this distribution or on the
  * ensmallen website.
@@ -59,7 +171,9 @@ class SCD
    * suggested that the values used are tailored for the task at hand. The
    * maximum number of iterations refers to the maximum number of "descents"
    * the algorithm does (in one iteration, the algorithm updates the
-   * decision variable numFeatures times).
+   * decision variable numFeatures times).  With parallel updates, each
+   * coordinate that is updated counts as one iteration, and in block mode
+   * each block counts as one iteration.
    *
    * @param stepSize Step size for each iteration.
    * @param maxIterations Maximum number of iterations allowed (0 means to
@@ -69,12 +183,18 @@ class SCD
    *    reported and checked for convergence.
    * @param descentPolicy The policy to use for picking up the coordinate to
    *    descend on.
+   * @param parallelUpdates The number of coordinates to update at once (1
+   *    means the usual sequential coordinate descent).
+   * @param blockSize The number of consecutive features to update together (1
+   *    means the usual coordinate descent on single features).
    */
   SCD(const double stepSize = 0.01,
       const size_t maxIterations = 100000,
       const double tolerance = 1e-5,
       const size_t updateInterval = 1e3,
-      const DescentPolicyType descentPolicy = DescentPolicyType());
+      const DescentPolicyType descentPolicy = DescentPolicyType(),
+      const size_t parallelUpdates = 1,
+      const size_t blockSize = 1);
 
   /**
    * Optimize the given function using stochastic coordinate descent. The
@@ -114,7 +234,49 @@ class SCD
   //! Modify the descent policy.
   DescentPolicyType& DescentPolicy() { return descentPolicy; }
 
+  //! Get the number of coordinates updated at once.
+  size_t ParallelUpdates() const { return parallelUpdates; }
+  //! Modify the number of coordinates updated at once.
+  size_t& ParallelUpdates() { return parallelUpdates; }
+
+  //! Get the number of features updated together in block mode.
+  size_t BlockSize() const { return blockSize; }
+  //! Modify the number of features updated together in block mode.
+  size_t& BlockSize() { return blockSize; }
+
+  //! Get whether the screening rule of the function is used, if it has one.
+  bool Screening() const { return screening; }
+  //! Modify whether the screening rule of the function is used, if it has
+  //! one.
+  bool& Screening() { return screening; }
+
+  //! Get whether the Lipschitz constants of the function give the step size
+  //! of each feature, if it has them.
+  bool LipschitzSteps() const { return lipschitzSteps; }
+  //! Modify whether the Lipschitz constants of the function give the step
+  //! size of each feature, if it has them.
+  bool& LipschitzSteps() { return lipschitzSteps; }
+
+  //! Get the number of features screened out by the last optimization.
+  size_t ScreenedFeatures() const { return screenedFeatures; }
+
  private:
+  /**
+   * Screen the active features of the function at the given point, set the
+   * newly screened coordinates to zero, and update the list of active
+   * features.
+   *
+   * @param function Function to screen the features of.
+   * @param iterate The current point (will be modified).
+   * @param active Whether each feature is active (will be modified).
+   * @param activeFeatures The active features (will be modified).
+   */
+  template <typename ResolvableFunctionType>
+  void Screen(ResolvableFunctionType& function,
+              arma::mat& iterate,
+              std::vector<bool>& active,
+              std::vector<size_t>& activeFeatures);
+
   //! The step size for each example.
   double stepSize;
 
@@ -129,6 +291,21 @@ class SCD
 
   //! The descent policy used to pick the coordinates for the update.
   DescentPolicyType descentPolicy;
+
+  //! The number of coordinates updated at once.
+  size_t parallelUpdates;
+
+  //! The number of features updated together in block mode.
+  size_t blockSize;
+
+  //! Whether the screening rule of the function is used.
+  bool screening;
+
+  //! Whether the Lipschitz constants of the function give the step sizes.
+  bool lipschitzSteps;
+
+  //! The number of features screened out by the last optimization.
+  size_t screenedFeatures;
 };
 
 } // namespace ens
@@ -25,12 +25,19 @@ SCD<DescentPolicyType>::SCD(
     const size_t maxIterations,
     const double tolerance,
     const size_t updateInterval,
-    const DescentPolicyType descentPolicy) :
+    const DescentPolicyType descentPolicy,
+    const size_t parallelUpdates,
+    const size_t blockSize) :
     stepSize(stepSize),
     maxIterations(maxIterations),
     tolerance(tolerance),
     updateInterval(updateInterval),
-    descentPolicy(descentPolicy)
+    descentPolicy(descentPolicy),
+    parallelUpdates(parallelUpdates),
+    blockSize(blockSize),
+    screening(true),
+    lipschitzSteps(true),
+    screenedFeatures(0)
 { /* Nothing to do */ }
 
 //! Optimize the function (minimize).
@@ -45,28 +52,136 @@ double SCD<DescentPolicyType>::Optimize(ResolvableFunctionType& function,
   double overallObjective = 0;
   double lastObjective = DBL_MAX;
 
-  arma::sp_mat gradient;
+  // The coordinates to update in each round, and their partial gradients.
+  const size_t roundSize = std::max(parallelUpdates, (size_t) 1);
+  std::vector<size_t> features;
+  features.reserve(roundSize);
+  std::vector<arma::vec> gradients(roundSize);
+  std::vector<arma::sp_mat> buffers(roundSize);
+  arma::mat delta;
+
+  // In block mode, the descent policy picks blocks of features, and the
+  // partial gradients of the blocks are dense.
+  const bool blocks = (blockSize > 1);
+  BlockCoordinateFunction<ResolvableFunctionType> blockFunction(function,
+      std::max(blockSize, (size_t) 1));
+  std::vector<arma::mat> blockGradients(blocks ? roundSize : 0);
+
+  // If the function can track its objective incrementally, the convergence
+  // checks don't need a pass over the data.
+  const bool cache = traits::HasObjectiveCache<ResolvableFunctionType>::value;
+  ResetObjectiveCache(function, iterate);
+
+  // If the function has a screening rule, the descent policy only chooses
+  // from the features that are not known to be zero at the optimum.
+  const bool screen = screening && !blocks &&
+      traits::HasFeatureScreening<ResolvableFunctionType>::value;
+  std::vector<bool> active;
+  std::vector<size_t> activeFeatures;
+  ScreenedCoordinateFunction<ResolvableFunctionType> screenedFunction(function,
+      activeFeatures);
+  screenedFeatures = 0;
+  if (screen)
+  {
+    active.assign(function.NumFeatures(), true);
+    Screen(function, iterate, active, activeFeatures);
+  }
 
   // Start iterating.
-  for (size_t i = 1; i != maxIterations; ++i)
+  for (size_t i = 1; i != maxIterations; /* incrementing done manually */)
   {
-    // Get the coordinate to descend on.
-    size_t featureIdx = descentPolicy.DescentFeature(i, iterate, function);
+    // With every feature screened out, the optimum is known.
+    if (screen && activeFeatures.empty())
+    {
+      Info << "SCD: all features screened out; terminating optimization."
+          << std::endl;
+      return function.Evaluate(iterate);
+    }
+
+    // Don't take more iterations than are left.
+    const size_t round = (maxIterations == 0) ? roundSize :
+        std::min(roundSize, maxIterations - i);
+
+    // Get the coordinates (or blocks) to descend on.  A coordinate that is
+    // picked twice is only updated once.
+    features.clear();
+    for (size_t j = 0; j < round; ++j)
+    {
+      size_t featureIdx;
+      if (blocks)
+      {
+        featureIdx = descentPolicy.DescentFeature(i + j, iterate,
+            blockFunction);
+      }
+      else if (screen)
+      {
+        featureIdx = screenedFunction.Feature(descentPolicy.DescentFeature(
+            i + j, iterate, screenedFunction));
+      }
+      else
+      {
+        featureIdx = descentPolicy.DescentFeature(i + j, iterate, function);
+      }
+
+      if (std::find(features.begin(), features.end(), featureIdx) ==
+          features.end())
+        features.push_back(featureIdx);
+    }
 
-    // Get the partial gradient with respect to this feature.
-    function.PartialGradient(iterate, featureIdx, gradient);
+    // Get the partial gradients with respect to these features, all at the
+    // current point.
+    #ifdef ENS_USE_OPENMP
+    #pragma omp parallel for if (features.size() > 1)
+    #endif
+    for (size_t j = 0; j < features.size(); ++j)
+    {
+      if (blocks)
+        blockFunction.BlockGradient(iterate, features[j], blockGradients[j]);
+      else
+        FeatureGradient(function, iterate, features[j], gradients[j],
+            buffers[j]);
+    }
+
+    // Update the decision variable with the partial gradients.
+    for (size_t j = 0; j < features.size(); ++j)
+    {
+      if (blocks)
+      {
+        const size_t begin = blockFunction.BlockBegin(features[j]);
+        iterate.cols(begin, begin + blockGradients[j].n_cols - 1) -=
+            stepSize * blockGradients[j];
+
+        for (size_t k = 0; cache && k < blockGradients[j].n_cols; ++k)
+        {
+          UpdateObjectiveCache(function, iterate, begin + k,
+              -stepSize * blockGradients[j].col(k));
+        }
+      }
+      else
+      {
+        const double step = lipschitzSteps ?
+            CoordinateStepSize(function, features[j], stepSize) : stepSize;
+        iterate.col(features[j]) -= step * gradients[j];
+
+        if (cache)
+        {
+          delta = -step * gradients[j];
+          UpdateObjectiveCache(function, iterate, features[j], delta);
+        }
+      }
+    }
 
-    // Update the decision variable with the partial gradient.
-    iterate.col(featureIdx) -= stepSize * gradient.col(featureIdx);
+    const size_t last = i + round - 1;
+    i += round;
 
     // Check for convergence.
-    if (i % updateInterval == 0)
+    if (last / updateInterval != (last - round) / updateInterval)
     {
-      overallObjective = function.Evaluate(iterate);
+      overallObjective = CachedObjective(function, iterate);
 
       // Output current objective function.
-      Info << "SCD: iteration " << i << ", objective " << overallObjective
-          << "." << std::endl;
+      Info << "SCD: iteration " << last << ", objective " << overallObjective
+          << ".\n";
 
       if (std::isnan(overallObjective) || std::isinf(overallObjective))
       {
@@ -83,6 +198,9 @@ double SCD<DescentPolicyType>::Optimize(ResolvableFunctionType& function,
       }
 
       lastObjective = overallObjective;
+
+      if (screen)
+        Screen(function, iterate, active, activeFeatures);
     }
   }
 
@@ -93,6 +211,42 @@ double SCD<DescentPolicyType>::Optimize(ResolvableFunctionType& function,
   return function.Evaluate(iterate);
 }
 
+//! Screen the active features.
+template <typename DescentPolicyType>
+template <typename ResolvableFunctionType>
+void SCD<DescentPolicyType>::Screen(ResolvableFunctionType& function,
+                                    arma::mat& iterate,
+                                    std::vector<bool>& active,
+                                    std::vector<size_t>& activeFeatures)
+{
+  ScreenFeatures(function, iterate, active);
+
+  // The screened coordinates are zero at the optimum.
+  const bool cache = traits::HasObjectiveCache<ResolvableFunctionType>::value;
+  activeFeatures.clear();
+  for (size_t j = 0; j < active.size(); ++j)
+  {
+    if (active[j])
+    {
+      activeFeatures.push_back(j);
+    }
+    else if (arma::any(arma::vectorise(iterate.col(j)) != 0))
+    {
+      const arma::mat delta = -iterate.col(j);
+      iterate.col(j).zeros();
+      if (cache)
+        UpdateObjectiveCache(function, iterate, j, delta);
+    }
+  }
+
+  if (active.size() - activeFeatures.size() != screenedFeatures)
+  {
+    screenedFeatures = active.size() - activeFeatures.size();
+    Info << "SCD: " << screenedFeatures << " of " << active.size()
+        << " features screened out.\n";
+  }
+}
+
 } // namespace ens
 
 #endif
@@ -0,0 +1,83 @@
+/**
+ * @file screened_coordinate_function.hpp
+ *
+ * Adapter that presents only the active features of a partially
+ * differentiable function to the SCD descent policies, once the others have
+ * been screened out.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SCD_SCREENED_COORDINATE_FUNCTION_HPP
+#define ENSMALLEN_SCD_SCREENED_COORDINATE_FUNCTION_HPP
+
+#include <vector>
+
+namespace ens {
+
+/**
+ * ScreenedCoordinateFunction wraps a partially differentiable function so that
+ * its active features look like features 0, ..., k - 1.  It is used by SCD
+ * after a screening rule removed features, so that the descent policies only
+ * choose from the features that are not known to be zero at the optimum,
+ * without having to know about screening.  The partial gradient of an active
+ * feature is the one of the wrapped function (so its nonzero column is the
+ * original feature).
+ *
+ * @tparam ResolvableFunctionType Type of the wrapped function.
+ */
+template<typename ResolvableFunctionType>
+class ScreenedCoordinateFunction
+{
+ public:
+  /**
+   * Wrap the given function.  The function and the list of active features
+   * must outlive this object.
+   *
+   * @param function The function to wrap.
+   * @param active The original indices of the active features.
+   */
+  ScreenedCoordinateFunction(ResolvableFunctionType& function,
+                             const std::vector<size_t>& active) :
+      function(function),
+      active(active)
+  { /* Nothing to do. */ }
+
+  //! Return the number of active features.
+  size_t NumFeatures() const { return active.size(); }
+
+  //! Return the original index of the given active feature.
+  size_t Feature(const size_t j) const { return active[j]; }
+
+  //! Evaluate the wrapped function.
+  double Evaluate(const arma::mat& coordinates) const
+  {
+    return function.Evaluate(coordinates);
+  }
+
+  /**
+   * Compute the partial gradient of the given active feature.
+   *
+   * @param coordinates The point at which to compute the gradient.
+   * @param j The index of the active feature.
+   * @param gradient Sparse matrix to output the gradient into.
+   */
+  void PartialGradient(const arma::mat& coordinates,
+                       const size_t j,
+                       arma::sp_mat& gradient) const
+  {
+    function.PartialGradient(coordinates, active[j], gradient);
+  }
+
+ private:
+  //! The wrapped function.
+  ResolvableFunctionType& function;
+  //! The original indices of the active features.
+  const std::vector<size_t>& active;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,409 @@
+/**
+ * @file chordal_decomposition.hpp
+ *
+ * Chordal extension of a sparsity pattern, its maximal cliques and clique
+ * tree, and the positive definite completion of a matrix given on the cliques.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SDP_CHORDAL_DECOMPOSITION_HPP
+#define ENSMALLEN_SDP_CHORDAL_DECOMPOSITION_HPP
+
+#include <algorithm>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace ens {
+
+/**
+ * ChordalDecomposition computes a chordal extension of the sparsity pattern
+ * of a symmetric n x n matrix, with a greedy minimum degree elimination
+ * ordering, and the maximal cliques of the extension, organized in a clique
+ * tree (a forest if the pattern is disconnected).  Each clique overlaps its
+ * parent in the separator of the clique, and every entry (i, j) of the
+ * pattern belongs to at least one clique, given by Clique(i, j).
+ *
+ * By Grone's theorem, a matrix that is given only on the cliques of a chordal
+ * pattern, with positive (semi)definite clique blocks that agree on their
+ * overlaps, has a positive (semi)definite completion.  Complete() computes
+ * the maximum determinant completion, clique by clique from the root of the
+ * clique tree: for a clique with separator S and new vertices R, the entries
+ * between R and the vertices U that were already completed are
+ *
+ *   X(R, U) = X(R, S) X(S, S)^(-1) X(S, U).
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @article{Vandenberghe2015,
+ *   author  = {Vandenberghe, Lieven and Andersen, Martin S.},
+ *   title   = {Chordal Graphs and Semidefinite Optimization},
+ *   journal = {Foundations and Trends in Optimization},
+ *   volume  = {1},
+ *   number  = {4},
+ *   pages   = {241--433},
+ *   year    = {2015}
+ * }
+ * @endcode
+ */
+class ChordalDecomposition
+{
+ public:
+  //! Create an empty decomposition.
+  ChordalDecomposition() : n(0) { }
+
+  /**
+   * Compute the decomposition of the sparsity pattern of an n x n symmetric
+   * matrix with the given off-diagonal entries; entries (i, j) and (j, i) are
+   * the same, and diagonal entries are ignored.
+   *
+   * @param n Size of the matrix.
+   * @param rows Row indices of the entries.
+   * @param cols Column indices of the entries.
+   */
+  ChordalDecomposition(const size_t n,
+                       const std::vector<size_t>& rows,
+                       const std::vector<size_t>& cols)
+  {
+    Compute(n, rows, cols);
+  }
+
+  /**
+   * Compute the decomposition of the sparsity pattern of the given symmetric
+   * matrix.
+   *
+   * @param pattern Matrix whose nonzero entries give the pattern.
+   */
+  ChordalDecomposition(const arma::sp_mat& pattern)
+  {
+    std::vector<size_t> rows, cols;
+    for (arma::sp_mat::const_iterator it = pattern.begin();
+        it != pattern.end(); ++it)
+    {
+      rows.push_back(it.row());
+      cols.push_back(it.col());
+    }
+
+    Compute(pattern.n_rows, rows, cols);
+  }
+
+  /**
+   * Compute the decomposition of the sparsity pattern with the given
+   * off-diagonal entries, replacing the current one.
+   *
+   * @param n Size of the matrix.
+   * @param rows Row indices of the entries.
+   * @param cols Column indices of the entries.
+   */
+  void Compute(const size_t n,
+               const std::vector<size_t>& rows,
+               const std::vector<size_t>& cols)
+  {
+    this->n = n;
+
+    std::vector<std::set<size_t>> adjacency(n);
+    for (size_t e = 0; e < rows.size(); ++e)
+    {
+      if (rows[e] == cols[e])
+        continue;
+
+      adjacency[rows[e]].insert(cols[e]);
+      adjacency[cols[e]].insert(rows[e]);
+    }
+
+    // Eliminate the vertex of minimum degree first, and connect its neighbors
+    // (which adds the fill-in of the chordal extension).  The neighbors of a
+    // vertex when it is eliminated are its higher neighbors in the extension.
+    position.assign(n, 0);
+    std::vector<std::vector<size_t>> higher(n);
+    std::set<std::pair<size_t, size_t>> queue;
+    for (size_t v = 0; v < n; ++v)
+      queue.insert(std::make_pair(adjacency[v].size(), v));
+
+    std::vector<size_t> order;
+    order.reserve(n);
+    while (!queue.empty())
+    {
+      const size_t v = queue.begin()->second;
+      queue.erase(queue.begin());
+      position[v] = order.size();
+      order.push_back(v);
+
+      higher[v].assign(adjacency[v].begin(), adjacency[v].end());
+      for (size_t a = 0; a < higher[v].size(); ++a)
+      {
+        const size_t u = higher[v][a];
+        queue.erase(std::make_pair(adjacency[u].size(), u));
+        adjacency[u].erase(v);
+      }
+
+      for (size_t a = 0; a < higher[v].size(); ++a)
+        for (size_t b = a + 1; b < higher[v].size(); ++b)
+          if (adjacency[higher[v][a]].insert(higher[v][b]).second)
+            adjacency[higher[v][b]].insert(higher[v][a]);
+
+      for (size_t a = 0; a < higher[v].size(); ++a)
+      {
+        const size_t u = higher[v][a];
+        queue.insert(std::make_pair(adjacency[u].size(), u));
+      }
+
+      adjacency[v].clear();
+    }
+
+    // The parent of a vertex in the elimination tree is its first eliminated
+    // higher neighbor.
+    std::vector<size_t> parent(n, n);
+    std::vector<std::vector<size_t>> children(n);
+    for (size_t v = 0; v < n; ++v)
+    {
+      for (size_t a = 0; a < higher[v].size(); ++a)
+      {
+        if (parent[v] == n || position[higher[v][a]] < position[parent[v]])
+          parent[v] = higher[v][a];
+      }
+
+      if (parent[v] != n)
+        children[parent[v]].push_back(v);
+    }
+
+    // The clique {v} + higher(v) is not maximal if and only if it is contained
+    // in the clique of a child with one more higher neighbor; then v belongs
+    // to the same maximal clique as that child.
+    representative.assign(n, n);
+    std::vector<size_t> top(n, n);
+    for (size_t t = 0; t < n; ++t)
+    {
+      const size_t v = order[t];
+      representative[v] = v;
+      for (size_t c = 0; c < children[v].size(); ++c)
+      {
+        const size_t u = children[v][c];
+        if (higher[u].size() == higher[v].size() + 1)
+        {
+          representative[v] = representative[u];
+          break;
+        }
+      }
+
+      top[representative[v]] = v;
+    }
+
+    cliques.clear();
+    separators.clear();
+    cliqueIndex.assign(n, n);
+    for (size_t t = 0; t < n; ++t)
+    {
+      const size_t v = order[t];
+      if (representative[v] != v)
+        continue;
+
+      cliqueIndex[v] = cliques.size();
+      arma::uvec clique(higher[v].size() + 1);
+      clique[0] = v;
+      for (size_t a = 0; a < higher[v].size(); ++a)
+        clique[a + 1] = higher[v][a];
+      cliques.push_back(arma::sort(clique));
+
+      // The separator with the parent clique is the set of higher neighbors
+      // of the last vertex of the clique.
+      const std::vector<size_t>& separator = higher[top[v]];
+      arma::uvec s(separator.size());
+      for (size_t a = 0; a < separator.size(); ++a)
+        s[a] = separator[a];
+      separators.push_back(arma::sort(s));
+    }
+
+    cliqueParents.assign(cliques.size(), cliques.size());
+    for (size_t t = 0; t < n; ++t)
+    {
+      const size_t v = order[t];
+      if (representative[v] != v || parent[top[v]] == n)
+        continue;
+
+      cliqueParents[cliqueIndex[v]] =
+          cliqueIndex[representative[parent[top[v]]]];
+    }
+
+    // Order the cliques from the roots to the leaves.
+    std::vector<std::vector<size_t>> cliqueChildren(cliques.size());
+    topDownOrder.clear();
+    for (size_t k = 0; k < cliques.size(); ++k)
+    {
+      if (cliqueParents[k] == cliques.size())
+        topDownOrder.push_back(k);
+      else
+        cliqueChildren[cliqueParents[k]].push_back(k);
+    }
+    for (size_t t = 0; t < topDownOrder.size(); ++t)
+    {
+      const size_t k = topDownOrder[t];
+      topDownOrder.insert(topDownOrder.end(), cliqueChildren[k].begin(),
+          cliqueChildren[k].end());
+    }
+  }
+
+  //! Get the size of the matrix.
+  size_t N() const { return n; }
+
+  //! Get the number of maximal cliques.
+  size_t NumCliques() const { return cliques.size(); }
+
+  //! Get the (sorted) vertices of the given clique.
+  const arma::uvec& Clique(const size_t k) const { return cliques[k]; }
+
+  //! Get the (sorted) vertices that the given clique shares with its parent.
+  const arma::uvec& Separator(const size_t k) const { return separators[k]; }
+
+  //! Get the parent of the given clique in the clique tree (NumCliques() for
+  //! a root).
+  size_t Parent(const size_t k) const { return cliqueParents[k]; }
+
+  //! Get the cliques, ordered so that each parent comes before its children.
+  const std::vector<size_t>& TopDownOrder() const { return topDownOrder; }
+
+  //! Get a clique that contains the entry (i, j) of the pattern (or of its
+  //! chordal extension).
+  size_t Clique(const size_t i, const size_t j) const
+  {
+    const size_t v = (position[i] <= position[j]) ? i : j;
+    return cliqueIndex[representative[v]];
+  }
+
+  //! Get the index of vertex i in the given clique, which must contain it.
+  size_t LocalIndex(const size_t k, const size_t i) const
+  {
+    const arma::uvec& clique = cliques[k];
+    return std::lower_bound(clique.begin(), clique.end(), i) - clique.begin();
+  }
+
+  //! Get the total number of vertices of the cliques (counted once for each
+  //! clique they belong to).
+  size_t CliqueSizeSum() const
+  {
+    size_t sum = 0;
+    for (size_t k = 0; k < cliques.size(); ++k)
+      sum += cliques[k].n_elem;
+    return sum;
+  }
+
+  /**
+   * Assemble the sparse matrix that is given by the clique blocks on the
+   * chordal extension of the pattern.  Each entry is taken from the clique
+   * given by Clique(i, j).
+   *
+   * @param blocks Blocks of the cliques.
+   * @param X Sparse matrix to store the entries in.
+   */
+  void Assemble(const std::vector<arma::mat>& blocks, arma::sp_mat& X) const
+  {
+    std::vector<arma::uword> rows, cols;
+    std::vector<double> values;
+    for (size_t k = 0; k < cliques.size(); ++k)
+    {
+      const arma::uvec& clique = cliques[k];
+      for (size_t b = 0; b < clique.n_elem; ++b)
+      {
+        for (size_t a = 0; a < clique.n_elem; ++a)
+        {
+          if (Clique(clique[a], clique[b]) != k)
+            continue;
+
+          rows.push_back(clique[a]);
+          cols.push_back(clique[b]);
+          values.push_back(blocks[k](a, b));
+        }
+      }
+    }
+
+    arma::umat locations(2, values.size());
+    for (size_t e = 0; e < values.size(); ++e)
+    {
+      locations(0, e) = rows[e];
+      locations(1, e) = cols[e];
+    }
+
+    X = arma::sp_mat(locations, arma::vec(values), n, n);
+  }
+
+  /**
+   * Compute the maximum determinant completion of the matrix given by the
+   * clique blocks.  The blocks must be positive definite (on the separators)
+   * and agree on their overlaps.
+   *
+   * @param blocks Blocks of the cliques.
+   * @param X Dense matrix to store the completion in.
+   */
+  void Complete(const std::vector<arma::mat>& blocks, arma::mat& X) const
+  {
+    X.zeros(n, n);
+    std::vector<bool> completed(n, false);
+    std::vector<arma::uword> done;
+    for (size_t t = 0; t < topDownOrder.size(); ++t)
+    {
+      const size_t k = topDownOrder[t];
+      const arma::uvec& clique = cliques[k];
+      const arma::uvec& separator = separators[k];
+
+      for (size_t b = 0; b < clique.n_elem; ++b)
+        for (size_t a = 0; a < clique.n_elem; ++a)
+          X(clique[a], clique[b]) = blocks[k](a, b);
+
+      // The new vertices, and the completed vertices outside of the clique.
+      std::vector<arma::uword> residual, others;
+      for (size_t a = 0; a < clique.n_elem; ++a)
+        if (!completed[clique[a]])
+          residual.push_back(clique[a]);
+      for (size_t a = 0; a < done.size(); ++a)
+        if (!std::binary_search(clique.begin(), clique.end(), done[a]))
+          others.push_back(done[a]);
+
+      if (separator.n_elem > 0 && residual.size() > 0 && others.size() > 0)
+      {
+        const arma::uvec r(residual), u(others);
+        arma::mat coefficients;
+        const arma::mat xss = X.submat(separator, separator);
+        const arma::mat xsr = X.submat(separator, r);
+        if (!arma::solve(coefficients, xss, xsr))
+          coefficients = arma::pinv(xss) * xsr;
+
+        const arma::mat xru = coefficients.t() * X.submat(separator, u);
+        X.submat(r, u) = xru;
+        X.submat(u, r) = xru.t();
+      }
+
+      for (size_t a = 0; a < residual.size(); ++a)
+      {
+        completed[residual[a]] = true;
+        done.push_back(residual[a]);
+      }
+    }
+  }
+
+ private:
+  //! The size of the matrix.
+  size_t n;
+  //! The position of each vertex in the elimination ordering.
+  std::vector<size_t> position;
+  //! For each vertex, the vertex whose clique is the maximal clique that
+  //! contains the clique of the vertex.
+  std::vector<size_t> representative;
+  //! The index of the clique of each representative vertex.
+  std::vector<size_t> cliqueIndex;
+  //! The (sorted) vertices of each maximal clique.
+  std::vector<arma::uvec> cliques;
+  //! The (sorted) vertices each clique shares with its parent.
+  std::vector<arma::uvec> separators;
+  //! The parent of each clique in the clique tree.
+  std::vector<size_t> cliqueParents;
+  //! The cliques, ordered from the roots to the leaves.
+  std::vector<size_t> topDownOrder;
+};
+
+} // namespace ens
+
+#endif
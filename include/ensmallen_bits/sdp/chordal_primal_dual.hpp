@@ -0,0 +1,247 @@
+/**
+ * @file chordal_primal_dual.hpp
+ *
+ * Primal-dual interior point solver for semidefinite programs with a sparse
+ * aggregate sparsity pattern, which only works on the cliques of a chordal
+ * extension of the pattern.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SDP_CHORDAL_PRIMAL_DUAL_HPP
+#define ENSMALLEN_SDP_CHORDAL_PRIMAL_DUAL_HPP
+
+#include "primal_dual.hpp"
+#include "chordal_decomposition.hpp"
+
+namespace ens {
+
+/**
+ * ChordalPrimalDualSolver solves a semidefinite program whose aggregate
+ * sparsity pattern (the union of the patterns of C and of the constraint
+ * matrices A_i) is sparse, without ever forming the dense n x n primal and
+ * dual variables.  The objective and the constraints only depend on the
+ * entries of X on the pattern, and by Grone's theorem, a matrix given on a
+ * chordal pattern has a positive semidefinite completion if and only if all
+ * of its blocks on the maximal cliques are positive semidefinite.  So the SDP
+ * is converted (domain-space conversion) into an SDP on the clique blocks
+ * X_k, with the constraints
+ *
+ *   sum_k <A_i^k, X_k> = b_i,
+ *   X_k(a, b) = X_p(a, b) for the entries on the separator of each clique k
+ *       with its parent p,
+ *   X_k psd,
+ *
+ * where A_i^k holds the entries of A_i assigned to clique k, using the cliques
+ * of a chordal extension of the pattern (see ChordalDecomposition).  The
+ * converted SDP is solved with the same XZ+ZX primal-dual interior point
+ * method as PrimalDualSolver, whose Cholesky and eigen decompositions, and
+ * Lyapunov solves, are then done clique by clique; memory and time per
+ * iteration scale with the sizes of the cliques instead of with n.  The
+ * solution is returned as its clique blocks, or as a sparse matrix on the
+ * chordal extension; ChordalDecomposition::Complete() gives its maximum
+ * determinant (dense) completion.
+ *
+ * The Schur complement system is over the original and the overlap
+ * constraints; as for PrimalDualSolver, it is either formed and factorized,
+ * or solved iteratively without forming it (see IterativeSchur()).
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @article{Fukuda2001,
+ *   author  = {Fukuda, Mituhiro and Kojima, Masakazu and Murota, Kazuo and
+ *              Nakata, Kazuhide},
+ *   title   = {Exploiting Sparsity in Semidefinite Programming via Matrix
+ *              Completion I: General Framework},
+ *   journal = {SIAM Journal on Optimization},
+ *   volume  = {11},
+ *   number  = {3},
+ *   pages   = {647--674},
+ *   year    = {2001}
+ * }
+ * @endcode
+ *
+ * @tparam SDPType Type of SDP to solve.
+ */
+template<typename SDPType>
+class ChordalPrimalDualSolver
+{
+ public:
+  /**
+   * Construct a new solver instance for the given SDP, computing the chordal
+   * decomposition of its aggregate sparsity pattern and the converted SDP.
+   * The interior point method starts from identity clique blocks.
+   *
+   * @param sdp Initialized SDP to be solved.
+   */
+  ChordalPrimalDualSolver(const SDPType& sdp);
+
+  /**
+   * Invoke the optimization procedure, returning the clique blocks of the
+   * primal and dual variables of the converted SDP.  The first
+   * SDP().NumConstraints() elements of y are the multipliers of the
+   * constraints of the SDP; the others are the multipliers of the overlap
+   * constraints.  The sum of the dual blocks, placed on their cliques, is
+   * C - sum_i y_i A_i.
+   *
+   * @param X Clique blocks of the primal variable.
+   * @param y Multipliers of the constraints.
+   * @param Z Clique blocks of the dual variable.
+   * @return The objective <C, X>.
+   */
+  double Optimize(std::vector<arma::mat>& X,
+                  arma::vec& y,
+                  std::vector<arma::mat>& Z);
+
+  /**
+   * Invoke the optimization procedure, and only return the primal variable,
+   * on the chordal extension of the aggregate sparsity pattern.
+   *
+   * @param X Primal variable on the chordal extension.
+   * @return The objective <C, X>.
+   */
+  double Optimize(arma::sp_mat& X)
+  {
+    std::vector<arma::mat> blocks, dualBlocks;
+    arma::vec y;
+    const double objective = Optimize(blocks, y, dualBlocks);
+    decomposition.Assemble(blocks, X);
+    return objective;
+  }
+
+  //! Return the underlying SDP instance.
+  const SDPType& SDP() const { return sdp; }
+
+  //! Return the chordal decomposition of the aggregate sparsity pattern.
+  const ChordalDecomposition& Decomposition() const { return decomposition; }
+
+  //! Get the number of constraints of the converted SDP (the constraints of
+  //! the SDP and the overlap constraints).
+  size_t NumConvertedConstraints() const { return b.n_elem; }
+
+  //! Modify tau. Typical values are 0.99.
+  double& Tau() { return tau; }
+
+  //! Modify the XZ tolerance.
+  double& NormXzTol() { return normXzTol; }
+
+  //! Modify the primal infeasibility tolerance.
+  double& PrimalInfeasTol() { return primalInfeasTol; }
+
+  //! Modify the dual infeasibility tolerance.
+  double& DualInfeasTol() { return dualInfeasTol; }
+
+  //! Modify the maximum number of iterations to run before converging.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Modify whether the Schur complement system is solved iteratively,
+  //! without forming the Schur complement.
+  bool& IterativeSchur() { return iterativeSchur; }
+
+  //! Modify the relative residual tolerance of the iterative Schur complement
+  //! solve.
+  double& SchurTolerance() { return schurTolerance; }
+
+  //! Modify the maximum number of iterations of each iterative Schur
+  //! complement solve (0 means the number of constraints).
+  size_t& MaxSchurIterations() { return maxSchurIterations; }
+
+  //! Get the total number of iterations of the iterative Schur complement
+  //! solves in the last call to Optimize().
+  size_t SchurIterations() const { return schurIterations; }
+
+ private:
+  //! An entry (row, col), with row <= col, of a constraint matrix restricted
+  //! to a clique block.
+  struct BlockEntry
+  {
+    //! The constraint of the converted SDP.
+    size_t constraint;
+    //! The clique.
+    size_t block;
+    //! The row in the clique block.
+    size_t row;
+    //! The column in the clique block.
+    size_t col;
+    //! The value of the entry (and of the symmetric entry).
+    double value;
+  };
+
+  //! Add the entry (i, j) (i <= j) of the given constraint to the clique that
+  //! the decomposition assigns it to.
+  void AddEntry(const size_t constraint,
+                const size_t i,
+                const size_t j,
+                const double value);
+
+  //! Compute A(X): the value of each constraint for the given blocks.
+  void ApplyConstraints(const std::vector<arma::mat>& X, arma::vec& out) const;
+
+  //! Compute A^T(y) = sum_j y_j A_j, on the clique blocks.
+  void ApplyAdjoint(const arma::vec& y, std::vector<arma::mat>& out) const;
+
+  //! Compute the block of A_j on the given clique, from the entries of A_j
+  //! in [begin, end), which are all in that clique.
+  void ConstraintBlock(const size_t begin,
+                       const size_t end,
+                       const size_t j,
+                       arma::mat& out) const;
+
+  //! The SDP problem instance to optimize.
+  SDPType sdp;
+
+  //! The chordal decomposition of the aggregate sparsity pattern.
+  ChordalDecomposition decomposition;
+
+  //! The blocks of the objective on the cliques.
+  std::vector<arma::mat> cBlocks;
+
+  //! The entries of each converted constraint, grouped by clique.
+  std::vector<std::vector<BlockEntry>> constraintEntries;
+
+  //! The entries of the converted constraints on each clique.
+  std::vector<std::vector<BlockEntry>> blockEntries;
+
+  //! The right hand side of the converted constraints.
+  arma::vec b;
+
+  //! The step size modulating factor. Needs to be a scalar in (0, 1).
+  double tau;
+
+  //! The tolerance on the norm of XZ required before terminating.
+  double normXzTol;
+
+  //! The tolerance required on the primal constraints required before
+  //! terminating.
+  double primalInfeasTol;
+
+  //! The tolerance required on the dual constraint required before terminating.
+  double dualInfeasTol;
+
+  //! Maximum number of iterations to run. Set to 0 for no limit.
+  size_t maxIterations;
+
+  //! Whether the Schur complement system is solved iteratively.
+  bool iterativeSchur;
+
+  //! The relative residual tolerance of the iterative Schur complement solve.
+  double schurTolerance;
+
+  //! The maximum number of iterations of each iterative Schur complement
+  //! solve (0 means the number of constraints).
+  size_t maxSchurIterations;
+
+  //! The total number of iterations of the iterative Schur complement solves
+  //! in the last call to Optimize().
+  size_t schurIterations;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "chordal_primal_dual_impl.hpp"
+
+#endif
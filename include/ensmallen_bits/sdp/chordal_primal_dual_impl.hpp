@@ -0,0 +1,546 @@
+/**
+ * @file chordal_primal_dual_impl.hpp
+ *
+ * Implementation of the primal-dual interior point method on the cliques of
+ * the chordal extension of the aggregate sparsity pattern of an SDP.  The
+ * steps are those of PrimalDualSolver::Optimize() (see primal_dual_impl.hpp
+ * and [AHO98] there), with every matrix operation done clique by clique.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SDP_CHORDAL_PRIMAL_DUAL_IMPL_HPP
+#define ENSMALLEN_SDP_CHORDAL_PRIMAL_DUAL_IMPL_HPP
+
+#include "chordal_primal_dual.hpp"
+
+namespace ens {
+
+namespace private_ {
+
+//! Collect the nonzero entries (i, j), i <= j, of the upper triangle of a
+//! symmetric sparse matrix.
+inline void UpperEntries(const arma::sp_mat& A,
+                         std::vector<size_t>& rows,
+                         std::vector<size_t>& cols,
+                         std::vector<double>& values)
+{
+  for (arma::sp_mat::const_iterator it = A.begin(); it != A.end(); ++it)
+  {
+    if (it.row() > it.col())
+      continue;
+
+    rows.push_back(it.row());
+    cols.push_back(it.col());
+    values.push_back(*it);
+  }
+}
+
+//! Collect the nonzero entries (i, j), i <= j, of the upper triangle of a
+//! symmetric dense matrix.
+inline void UpperEntries(const arma::mat& A,
+                         std::vector<size_t>& rows,
+                         std::vector<size_t>& cols,
+                         std::vector<double>& values)
+{
+  for (size_t j = 0; j < A.n_cols; ++j)
+  {
+    for (size_t i = 0; i <= j; ++i)
+    {
+      if (A(i, j) == 0.)
+        continue;
+
+      rows.push_back(i);
+      cols.push_back(j);
+      values.push_back(A(i, j));
+    }
+  }
+}
+
+} // namespace private_
+
+template<typename SDPType>
+ChordalPrimalDualSolver<SDPType>::ChordalPrimalDualSolver(const SDPType& sdp)
+  : sdp(sdp),
+    tau(0.99),
+    normXzTol(1e-7),
+    primalInfeasTol(1e-7),
+    dualInfeasTol(1e-7),
+    maxIterations(1000),
+    iterativeSchur(false),
+    schurTolerance(1e-10),
+    maxSchurIterations(0),
+    schurIterations(0)
+{
+  // Collect the upper triangles of C and of the constraint matrices; their
+  // union is the aggregate sparsity pattern.
+  const size_t numConstraints = sdp.NumConstraints();
+  std::vector<std::vector<size_t>> rows(numConstraints + 1),
+      cols(numConstraints + 1);
+  std::vector<std::vector<double>> values(numConstraints + 1);
+  for (size_t j = 0; j < sdp.NumSparseConstraints(); ++j)
+    private_::UpperEntries(sdp.SparseA()[j], rows[j], cols[j], values[j]);
+  const size_t numLinear = sdp.NumSparseConstraints() +
+      sdp.NumDenseConstraints();
+  for (size_t j = sdp.NumSparseConstraints(); j < numLinear; ++j)
+  {
+    private_::UpperEntries(sdp.DenseA()[j - sdp.NumSparseConstraints()],
+        rows[j], cols[j], values[j]);
+  }
+  for (size_t j = numLinear; j < numConstraints; ++j)
+  {
+    const arma::mat& V = sdp.LowRankA()[j - numLinear];
+    private_::UpperEntries(arma::mat(V * V.t()), rows[j], cols[j], values[j]);
+  }
+  private_::UpperEntries(sdp.C(), rows[numConstraints], cols[numConstraints],
+      values[numConstraints]);
+
+  std::vector<size_t> patternRows, patternCols;
+  for (size_t j = 0; j <= numConstraints; ++j)
+  {
+    patternRows.insert(patternRows.end(), rows[j].begin(), rows[j].end());
+    patternCols.insert(patternCols.end(), cols[j].begin(), cols[j].end());
+  }
+  decomposition.Compute(sdp.N(), patternRows, patternCols);
+
+  const size_t numCliques = decomposition.NumCliques();
+  cBlocks.resize(numCliques);
+  for (size_t k = 0; k < numCliques; ++k)
+  {
+    const size_t size = decomposition.Clique(k).n_elem;
+    cBlocks[k].zeros(size, size);
+  }
+  for (size_t e = 0; e < values[numConstraints].size(); ++e)
+  {
+    const size_t i = rows[numConstraints][e];
+    const size_t j = cols[numConstraints][e];
+    const size_t k = decomposition.Clique(i, j);
+    const size_t r = decomposition.LocalIndex(k, i);
+    const size_t c = decomposition.LocalIndex(k, j);
+    cBlocks[k](r, c) = values[numConstraints][e];
+    cBlocks[k](c, r) = values[numConstraints][e];
+  }
+
+  // Each entry of a constraint matrix goes to a single clique.
+  constraintEntries.resize(numConstraints);
+  for (size_t j = 0; j < numConstraints; ++j)
+    for (size_t e = 0; e < values[j].size(); ++e)
+      AddEntry(j, rows[j][e], cols[j][e], values[j][e]);
+
+  // The overlap constraints X_k(a, b) - X_p(a, b) = 0 for each clique k with
+  // parent p, and each entry (a, b) of the separator.  The off-diagonal
+  // entries are halved, since they count twice in the inner product.
+  for (size_t k = 0; k < numCliques; ++k)
+  {
+    const size_t p = decomposition.Parent(k);
+    if (p == numCliques)
+      continue;
+
+    const arma::uvec& separator = decomposition.Separator(k);
+    for (size_t t = 0; t < separator.n_elem; ++t)
+    {
+      for (size_t s = 0; s <= t; ++s)
+      {
+        const double value = (s == t) ? 1. : 0.5;
+        const size_t j = constraintEntries.size();
+        constraintEntries.push_back(std::vector<BlockEntry>());
+        for (size_t side = 0; side < 2; ++side)
+        {
+          BlockEntry entry;
+          entry.constraint = j;
+          entry.block = (side == 0) ? k : p;
+          entry.row = decomposition.LocalIndex(entry.block, separator[s]);
+          entry.col = decomposition.LocalIndex(entry.block, separator[t]);
+          entry.value = (side == 0) ? value : -value;
+          constraintEntries[j].push_back(entry);
+        }
+      }
+    }
+  }
+
+  b.zeros(constraintEntries.size());
+  if (sdp.NumSparseConstraints())
+    b.subvec(0, sdp.NumSparseConstraints() - 1) = sdp.SparseB();
+  if (sdp.NumDenseConstraints())
+    b.subvec(sdp.NumSparseConstraints(), numLinear - 1) = sdp.DenseB();
+  if (sdp.NumLowRankConstraints())
+    b.subvec(numLinear, numConstraints - 1) = sdp.LowRankB();
+
+  // Group the entries of each constraint by clique, and index them by clique.
+  blockEntries.resize(numCliques);
+  for (size_t j = 0; j < constraintEntries.size(); ++j)
+  {
+    std::stable_sort(constraintEntries[j].begin(), constraintEntries[j].end(),
+        [](const BlockEntry& x, const BlockEntry& y)
+        { return x.block < y.block; });
+    for (size_t e = 0; e < constraintEntries[j].size(); ++e)
+    {
+      const BlockEntry& entry = constraintEntries[j][e];
+      blockEntries[entry.block].push_back(entry);
+    }
+  }
+}
+
+template<typename SDPType>
+void ChordalPrimalDualSolver<SDPType>::AddEntry(const size_t constraint,
+                                                const size_t i,
+                                                const size_t j,
+                                                const double value)
+{
+  BlockEntry entry;
+  entry.constraint = constraint;
+  entry.block = decomposition.Clique(i, j);
+  entry.row = decomposition.LocalIndex(entry.block, i);
+  entry.col = decomposition.LocalIndex(entry.block, j);
+  entry.value = value;
+  constraintEntries[constraint].push_back(entry);
+}
+
+template<typename SDPType>
+void ChordalPrimalDualSolver<SDPType>::ApplyConstraints(
+    const std::vector<arma::mat>& X,
+    arma::vec& out) const
+{
+  out.zeros(b.n_elem);
+  for (size_t k = 0; k < blockEntries.size(); ++k)
+  {
+    for (size_t e = 0; e < blockEntries[k].size(); ++e)
+    {
+      const BlockEntry& entry = blockEntries[k][e];
+      const double weight = (entry.row == entry.col) ? 1. : 2.;
+      out(entry.constraint) += weight * entry.value *
+          X[k](entry.row, entry.col);
+    }
+  }
+}
+
+template<typename SDPType>
+void ChordalPrimalDualSolver<SDPType>::ApplyAdjoint(
+    const arma::vec& y,
+    std::vector<arma::mat>& out) const
+{
+  out.resize(blockEntries.size());
+  for (size_t k = 0; k < blockEntries.size(); ++k)
+  {
+    const size_t size = decomposition.Clique(k).n_elem;
+    out[k].zeros(size, size);
+    for (size_t e = 0; e < blockEntries[k].size(); ++e)
+    {
+      const BlockEntry& entry = blockEntries[k][e];
+      out[k](entry.row, entry.col) += y(entry.constraint) * entry.value;
+      if (entry.row != entry.col)
+        out[k](entry.col, entry.row) += y(entry.constraint) * entry.value;
+    }
+  }
+}
+
+template<typename SDPType>
+void ChordalPrimalDualSolver<SDPType>::ConstraintBlock(const size_t begin,
+                                                       const size_t end,
+                                                       const size_t j,
+                                                       arma::mat& out) const
+{
+  const size_t k = constraintEntries[j][begin].block;
+  const size_t size = decomposition.Clique(k).n_elem;
+  out.zeros(size, size);
+  for (size_t e = begin; e < end; ++e)
+  {
+    const BlockEntry& entry = constraintEntries[j][e];
+    out(entry.row, entry.col) = entry.value;
+    out(entry.col, entry.row) = entry.value;
+  }
+}
+
+template<typename SDPType>
+double ChordalPrimalDualSolver<SDPType>::Optimize(std::vector<arma::mat>& X,
+                                                  arma::vec& y,
+                                                  std::vector<arma::mat>& Z)
+{
+  const size_t numCliques = decomposition.NumCliques();
+  const size_t numConstraints = b.n_elem;
+
+  // The multipliers of the overlap constraints start at zero, so that the
+  // initial point is that of PrimalDualSolver.
+  X.resize(numCliques);
+  Z.resize(numCliques);
+  for (size_t k = 0; k < numCliques; ++k)
+  {
+    X[k].eye(cBlocks[k].n_rows, cBlocks[k].n_rows);
+    Z[k].eye(cBlocks[k].n_rows, cBlocks[k].n_rows);
+  }
+  y.zeros(numConstraints);
+  if (sdp.NumConstraints())
+    y.subvec(0, sdp.NumConstraints() - 1).ones();
+
+  std::vector<arma::mat> Rd(numCliques), Rc(numCliques), dX(numCliques),
+      dZ(numCliques), XLinv(numCliques), ZLinv(numCliques), Zvec(numCliques),
+      ZinvLambdaSum(numCliques), XZ(numCliques), ATy, ATdy, G;
+  arma::vec rp, AX, dy, Zval, precond;
+  arma::mat M, ML, MU, MP;
+
+  schurIterations = 0;
+  const size_t actualMaxSchurIterations = (maxSchurIterations == 0) ?
+      std::max(numConstraints, (size_t) 1) : maxSchurIterations;
+
+  // The product of the Schur complement with a vector, clique by clique (see
+  // ApplySchurComplement()).
+  auto applySchur = [&](const arma::vec& v, arma::vec& out)
+  {
+    std::vector<arma::mat> W, Gv(numCliques);
+    ApplyAdjoint(v, W);
+    for (size_t k = 0; k < numCliques; ++k)
+    {
+      const arma::mat XW = X[k] * W[k];
+      SolveLyapunov(Gv[k], Zvec[k], ZinvLambdaSum[k], XW + XW.t());
+    }
+    ApplyConstraints(Gv, out);
+  };
+
+  // Form the Schur complement one column at a time, and factorize it with LU
+  // as in PrimalDualSolver::Optimize().  Column j only needs the Lyapunov
+  // solves on the cliques that A_j touches, and only the constraints that
+  // touch those cliques get nonzero entries.
+  bool schurFactorized = false;
+  auto factorizeSchur = [&]()
+  {
+    M.zeros(numConstraints, numConstraints);
+    #ifdef ENS_USE_OPENMP
+      #pragma omp parallel for schedule(dynamic)
+    #endif
+    for (size_t j = 0; j < numConstraints; ++j)
+    {
+      size_t begin = 0;
+      while (begin < constraintEntries[j].size())
+      {
+        const size_t k = constraintEntries[j][begin].block;
+        size_t end = begin + 1;
+        while (end < constraintEntries[j].size() &&
+            constraintEntries[j][end].block == k)
+          ++end;
+
+        arma::mat Ajk, Gk;
+        ConstraintBlock(begin, end, j, Ajk);
+        const arma::mat XAjk = X[k] * Ajk;
+        SolveLyapunov(Gk, Zvec[k], ZinvLambdaSum[k], XAjk + XAjk.t());
+        for (size_t e = 0; e < blockEntries[k].size(); ++e)
+        {
+          const BlockEntry& entry = blockEntries[k][e];
+          const double weight = (entry.row == entry.col) ? 1. : 2.;
+          M(entry.constraint, j) += weight * entry.value *
+              Gk(entry.row, entry.col);
+        }
+        begin = end;
+      }
+    }
+
+    if (!arma::lu(ML, MU, MP, M))
+    {
+      throw std::logic_error("ChordalPrimalDualSolver::Optimize(): Could "
+          "not factorize the Schur complement.");
+    }
+    schurFactorized = true;
+  };
+
+  // Solve the system with the Schur complement, as in
+  // PrimalDualSolver::Optimize().  The overlap constraints can make the
+  // Schur complement badly conditioned near the solution, so if the iterative
+  // solve does not converge, the Schur complement is formed and factorized
+  // for the rest of the iteration.
+  auto solveSchur = [&](const arma::vec& rhs, arma::vec& out) -> bool
+  {
+    if (iterativeSchur && !schurFactorized)
+    {
+      bool converged;
+      schurIterations += SolveSchurIterative(applySchur, precond, rhs,
+          schurTolerance, actualMaxSchurIterations, out, converged);
+      if (converged)
+        return out.is_finite();
+
+      Info << "ChordalPrimalDualSolver::Optimize(): the iterative Schur "
+          << "complement solve did not reach the tolerance " << schurTolerance
+          << " in " << actualMaxSchurIterations << " iterations; using the "
+          << "direct solve." << std::endl;
+      factorizeSchur();
+    }
+
+    arma::vec z;
+    return arma::solve(z, arma::trimatl(ML), MP * rhs) &&
+        arma::solve(out, arma::trimatu(MU), z);
+  };
+
+  // Solve the KKT system for the given Rc, clique by clique (see
+  // SolveKKTSystem()).
+  auto solveKKT = [&]()
+  {
+    std::vector<arma::mat> G0(numCliques);
+    for (size_t k = 0; k < numCliques; ++k)
+    {
+      SolveLyapunov(G0[k], Zvec[k], ZinvLambdaSum[k],
+          X[k] * Rd[k] + Rd[k] * X[k] - 2. * Rc[k]);
+    }
+
+    arma::vec rhs;
+    ApplyConstraints(G0, rhs);
+    rhs += rp;
+    if (!solveSchur(rhs, dy))
+    {
+      throw std::logic_error("ChordalPrimalDualSolver::Optimize(): Could not "
+          "solve KKT system.");
+    }
+
+    ApplyAdjoint(dy, ATdy);
+    for (size_t k = 0; k < numCliques; ++k)
+    {
+      dZ[k] = Rd[k] - ATdy[k];
+      SolveLyapunov(dX[k], Zvec[k], ZinvLambdaSum[k],
+          X[k] * dZ[k] + dZ[k] * X[k] - 2. * Rc[k]);
+      dX[k] = -dX[k];
+    }
+  };
+
+  // The step lengths are the smallest ones over the cliques.
+  auto stepLengths = [&](double& alpha, double& beta)
+  {
+    alpha = beta = 1.;
+    for (size_t k = 0; k < numCliques; ++k)
+    {
+      double alphak, betak;
+      Alpha(XLinv[k], dX[k], tau, alphak);
+      Alpha(ZLinv[k], dZ[k], tau, betak);
+      alpha = std::min(alpha, alphak);
+      beta = std::min(beta, betak);
+    }
+  };
+
+  const double n = (double) decomposition.CliqueSizeSum();
+  double primalObj = 0., alpha, beta;
+  for (size_t iteration = 1; iteration != maxIterations; iteration++)
+  {
+    ApplyConstraints(X, AX);
+    rp = b - AX;
+
+    ApplyAdjoint(y, ATy);
+    for (size_t k = 0; k < numCliques; ++k)
+      Rd[k] = cBlocks[k] - Z[k] - ATy[k];
+
+    for (size_t k = 0; k < numCliques; ++k)
+    {
+      if (!InverseCholeskyFactor(X[k], XLinv[k]))
+      {
+        Warn << "ChordalPrimalDualSolver::Optimize(): cholesky decomposition "
+            << "of X failed!  Terminating optimization.";
+        return primalObj;
+      }
+
+      if (!LyapunovFactor(Z[k], Zvec[k], Zval, ZinvLambdaSum[k]))
+      {
+        Warn << "ChordalPrimalDualSolver::Optimize(): eigendecomposition of "
+            << "Z failed!  Terminating optimization.";
+        return primalObj;
+      }
+      ZLinv[k] = arma::diagmat(1. / arma::sqrt(Zval)) * Zvec[k].t();
+    }
+
+    schurFactorized = false;
+    if (iterativeSchur)
+    {
+      // The Jacobi preconditioner tr(A_j X A_j Z^(-1)), summed over the
+      // cliques that A_j touches (see SchurPreconditioner()).
+      precond.zeros(numConstraints);
+      for (size_t j = 0; j < numConstraints; ++j)
+      {
+        size_t begin = 0;
+        while (begin < constraintEntries[j].size())
+        {
+          const size_t k = constraintEntries[j][begin].block;
+          size_t end = begin + 1;
+          while (end < constraintEntries[j].size() &&
+              constraintEntries[j][end].block == k)
+            ++end;
+
+          arma::mat Ajk;
+          ConstraintBlock(begin, end, j, Ajk);
+          const arma::mat Zinv = ZLinv[k].t() * ZLinv[k];
+          precond(j) += arma::accu((X[k] * Ajk) % (Zinv * Ajk).t());
+          begin = end;
+        }
+
+        if (!(precond(j) > 0.) || !std::isfinite(precond(j)))
+          precond(j) = 1.;
+      }
+    }
+    else
+      factorizeSchur();
+
+    double sxdotsz = 0.;
+    for (size_t k = 0; k < numCliques; ++k)
+    {
+      sxdotsz += arma::accu(X[k] % Z[k]);
+      XZ[k] = X[k] * Z[k];
+    }
+
+    // The predictor step.
+    for (size_t k = 0; k < numCliques; ++k)
+      Rc[k] = -0.5 * (XZ[k] + XZ[k].t());
+    solveKKT();
+    stepLengths(alpha, beta);
+
+    double predictedGap = 0.;
+    for (size_t k = 0; k < numCliques; ++k)
+    {
+      predictedGap += arma::accu((X[k] + alpha * dX[k]) %
+          (Z[k] + beta * dZ[k]));
+    }
+    const double sigma = std::pow(predictedGap / sxdotsz, 3);
+    const double mu = sigma * sxdotsz / n;
+
+    // The corrector step.
+    for (size_t k = 0; k < numCliques; ++k)
+    {
+      const arma::mat dXdZ = dX[k] * dZ[k];
+      Rc[k] = mu * arma::eye<arma::mat>(X[k].n_rows, X[k].n_rows) -
+          0.5 * (XZ[k] + XZ[k].t() + dXdZ + dXdZ.t());
+    }
+    solveKKT();
+    stepLengths(alpha, beta);
+
+    for (size_t k = 0; k < numCliques; ++k)
+    {
+      X[k] += alpha * dX[k];
+      Z[k] += beta * dZ[k];
+    }
+    y += beta * dy;
+
+    // Check the KKT conditions of the converted SDP.
+    double normXZ = 0., dualInfeas = 0.;
+    primalObj = 0.;
+    ApplyAdjoint(y, ATy);
+    for (size_t k = 0; k < numCliques; ++k)
+    {
+      const double normXZk = arma::norm(X[k] * Z[k], "fro");
+      const double dualInfeask = arma::norm(Z[k] - cBlocks[k] + ATy[k], "fro");
+      normXZ += normXZk * normXZk;
+      dualInfeas += dualInfeask * dualInfeask;
+      primalObj += arma::accu(cBlocks[k] % X[k]);
+    }
+    normXZ = std::sqrt(normXZ);
+    dualInfeas = std::sqrt(dualInfeas);
+
+    ApplyConstraints(X, AX);
+    const double primalInfeas = arma::norm(b - AX, 2);
+
+    if (normXZ <= normXzTol && primalInfeas <= primalInfeasTol &&
+        dualInfeas <= dualInfeasTol)
+      return primalObj;
+  }
+
+  Warn << "ChordalPrimalDualSolver::Optimize(): Did not converge after "
+      << maxIterations << " iterations!" << std::endl;
+  return primalObj;
+}
+
+} // namespace ens
+
+#endif
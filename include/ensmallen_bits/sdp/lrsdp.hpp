@@ -27,6 +27,31 @@ namespace ens {
  * LRSDP can optimize semidefinite programs.  For more details, see the
  * documentation on function types included with this distribution or on the
  * ensmallen website.
+ *
+ * By default the rank of the solution is the number of columns of the given
+ * coordinates.  In the rank-adaptive mode (see AdaptiveRank()), the given
+ * coordinates are only the starting point at a small rank: after each solve,
+ * the second-order certificate of optimality is checked, which holds when the
+ * dual slack S = C - sum_i y_i A_i (with the multiplier estimates y of the
+ * augmented Lagrangian) is positive semidefinite.  If the smallest eigenvalue
+ * of S is below -CertificateTolerance(), the rank is insufficient, and the
+ * factor is grown by one column in the direction of the corresponding
+ * eigenvector (a direction of negative curvature), and the solve is
+ * warm-started from the previous solution and multipliers.  This is the
+ * approach of
+ *
+ * @code
+ * @article{Journee2010,
+ *   title   = {Low-rank optimization on the cone of positive semidefinite
+ *              matrices},
+ *   author  = {Journee, M. and Bach, F. and Absil, P.-A. and Sepulchre, R.},
+ *   journal = {SIAM Journal on Optimization},
+ *   volume  = {20},
+ *   number  = {5},
+ *   pages   = {2327--2351},
+ *   year    = {2010}
+ * }
+ * @endcode
  */
 template <typename SDPType>
 class LRSDP
@@ -72,6 +97,22 @@ class LRSDP
    */
   double Optimize(arma::mat& coordinates);
 
+  /**
+   * Compute the estimates of the dual variables at the given coordinates (the
+   * solution of Optimize()),
+   *
+   *   y_i = lambda_i - sigma * (Tr(A_i R R^T) - b_i),
+   *
+   * from the Lagrange multipliers and the penalty of the augmented Lagrangian
+   * (zero multipliers if it has none).  The constraints are numbered as in
+   * the SDP.  Together with the coordinates, these can warm-start a
+   * PrimalDualSolver (see PrimalDualSolver::WarmStart()).
+   *
+   * @param coordinates Coordinates R of the solution.
+   * @param y Vector to store the dual estimates into.
+   */
+  void DualVariables(const arma::mat& coordinates, arma::vec& y) const;
+
   //! Return the SDP that will be solved.
   const SDPType& SDP() const { return function.SDP(); }
   //! Modify the SDP that will be solved.
@@ -92,13 +133,54 @@ class LRSDP
   //! Modify the maximum number of iterations.
   size_t& MaxIterations() { return maxIterations; }
 
+  //! Get whether the rank is adapted to the problem.
+  bool AdaptiveRank() const { return adaptiveRank; }
+  //! Modify whether the rank is adapted to the problem.
+  bool& AdaptiveRank() { return adaptiveRank; }
+
+  //! Get the largest rank of the rank-adaptive mode (0 means the smallest
+  //! rank p with p (p + 1) / 2 > m, above which there are no spurious local
+  //! minima, capped at n).
+  size_t MaxRank() const { return maxRank; }
+  //! Modify the largest rank of the rank-adaptive mode (0 means the smallest
+  //! rank p with p (p + 1) / 2 > m, above which there are no spurious local
+  //! minima, capped at n).
+  size_t& MaxRank() { return maxRank; }
+
+  //! Get the tolerance on the smallest eigenvalue of the dual slack below
+  //! which the rank is grown.
+  double CertificateTolerance() const { return certificateTolerance; }
+  //! Modify the tolerance on the smallest eigenvalue of the dual slack below
+  //! which the rank is grown.
+  double& CertificateTolerance() { return certificateTolerance; }
+
  private:
+  /**
+   * Compute the smallest eigenvalue and its eigenvector of the dual slack
+   * S = C - sum_i y_i A_i at the given coordinates, with the multiplier
+   * estimates y_i = lambda_i - sigma * (Tr(A_i R R^T) - b_i).  S is assembled
+   * as a sparse matrix when the objective and the constraints are sparse.
+   */
+  double SmallestDualEigenpair(const arma::mat& coordinates,
+                               const arma::vec& lambda,
+                               const double sigma,
+                               arma::vec& eigenvector) const;
+
   //! Augmented lagrangian optimizer.
   AugLagrangian augLag;
   //! Function to optimize, which the AugLagrangian object holds.
   LRSDPFunction<SDPType> function;
   //! The maximum number of iterations for optimization.
   size_t maxIterations;
+
+  //! Whether the rank is adapted to the problem.
+  bool adaptiveRank;
+
+  //! The largest rank of the rank-adaptive mode (0 for the default bound).
+  size_t maxRank;
+
+  //! The tolerance on the smallest eigenvalue of the dual slack.
+  double certificateTolerance;
 };
 
 } // namespace ens
@@ -21,14 +21,12 @@ namespace ens {
 /**
  * The objective function that LRSDP is trying to optimize.
  *
- * Note: LRSDPfunction is designed and implemented to specifically work
- * with a combination of AugLagrangian and L-BFGS optimizer. Implemenation
- * of LRSDPFunction includes caching R * R^T matrix in order to avoid redundant
- * computations(Specifically with above two optimizers) of R * R^T matrix
- * through AugLagrangian optimizer call, as only L-BFGS takes part in updating
- * R(coordinates) matrix. So, be careful while using LRSDP with some other
- * optimizer. You may need to modify caching process of R * R^T matrix.
- * See EvaluateImpl() in lrsdp_function_impl.hpp for more details.
+ * The n x n matrix R * R^T is never formed: Tr(A_i * (R * R^T)) is computed
+ * from the dot products of the rows of R at the nonzeros of A_i for sparse
+ * constraints, from R^T * A_i for dense constraints, and from R^T * V_i for
+ * low-rank constraints A_i = V_i * V_i^T, so the memory used is proportional
+ * to the size of R and of the constraints.  See EvaluateImpl() in
+ * lrsdp_function_impl.hpp for more details.
  */
 template <typename SDPType>
 class LRSDPFunction
@@ -95,21 +93,12 @@ class LRSDPFunction
   //! Modify the SDP object representing the problem.
   SDPType& SDP() { return sdp; }
 
-  //! Get R*R^T matrix.
-  const arma::mat& RRT() const { return rrt; }
-
-  //! Modify R*R^T matrix.
-  arma::mat& RRT()  { return rrt; }
-
  private:
   //! SDP object representing the problem
   SDPType sdp;
 
   //! Initial point.
   arma::mat initialPoint;
-
-  //! Cache R*R^T matrix.
-  arma::mat rrt;
 };
 
 // Declare specializations in lrsdp_function.cpp.
@@ -131,6 +120,18 @@ inline void AugLagrangianFunction<LRSDPFunction<SDP<arma::mat>>>::Gradient(
     const arma::mat& coordinates,
     arma::mat& gradient) const;
 
+template <>
+inline double
+AugLagrangianFunction<LRSDPFunction<SDP<arma::sp_mat>>>::EvaluateWithGradient(
+    const arma::mat& coordinates,
+    arma::mat& gradient) const;
+
+template <>
+inline double
+AugLagrangianFunction<LRSDPFunction<SDP<arma::mat>>>::EvaluateWithGradient(
+    const arma::mat& coordinates,
+    arma::mat& gradient) const;
+
 } // namespace ens
 
 // Include implementation
@@ -30,9 +30,6 @@ LRSDPFunction<SDPType>::LRSDPFunction(const SDPType& sdp,
         << "more columns than rows.  It may be more efficient to find the "
         << "transposed solution." << std::endl;
   }
-
-  // Initialize R*R^T matrix.
-  rrt = initialPoint * trans(initialPoint);
 }
 
 template <typename SDPType>
@@ -48,19 +45,40 @@ LRSDPFunction<SDPType>::LRSDPFunction(const size_t numSparseConstraints,
         << "more columns than rows.  It may be more efficient to find the "
         << "transposed solution." << std::endl;
   }
+}
+
+//! Compute Tr(A * (R R^T)) for a sparse A, given R^T.  Entry (k, l) of R R^T
+//! is the dot product of rows k and l of R, so only the entries at the
+//! nonzeros of A are computed, and R R^T is never formed.
+static inline double
+TraceRRT(const arma::sp_mat& a, const arma::mat& rt)
+{
+  double trace = 0.0;
+  for (arma::sp_mat::const_iterator it = a.begin(); it != a.end(); ++it)
+    trace += (*it) * arma::dot(rt.col(it.row()), rt.col(it.col()));
+  return trace;
+}
+
+//! Compute Tr(A * (R R^T)) = accu(R^T % (R^T A^T)) for a dense A, given R^T.
+static inline double
+TraceRRT(const arma::mat& a, const arma::mat& rt)
+{
+  return arma::accu(rt % (rt * a));
+}
 
-  // Initialize R*R^T matrix.
-  rrt = initialPoint * trans(initialPoint);
+//! Compute Tr(V V^T * (R R^T)) = ||R^T V||_F^2 for the factor V of a low-rank
+//! constraint, given R^T; this takes O(nkr) time for an n x k factor.
+static inline double
+TraceLowRankRRT(const arma::mat& v, const arma::mat& rt)
+{
+  const arma::mat rtv = rt * v;
+  return arma::accu(rtv % rtv);
 }
 
 template <typename SDPType>
-double LRSDPFunction<SDPType>::Evaluate(const arma::mat& /* coordinates */)
-                                        const
+double LRSDPFunction<SDPType>::Evaluate(const arma::mat& coordinates) const
 {
-  // Note: We don't require to update the R*R^T matrix here as the current
-  // function is only used by AugLagrangian, which do not update the coordinates
-  // matrix.
-  return accu(SDP().C() % rrt);
+  return TraceRRT(SDP().C(), arma::mat(trans(coordinates)));
 }
 
 template <typename SDPType>
@@ -76,18 +94,25 @@ double LRSDPFunction<SDPType>::EvaluateConstraint(
     const size_t index,
     const arma::mat& coordinates) const
 {
-  // Note: We don't require to update the R*R^T matrix here as the current
-  // function is only used by AugLagrangian, which do not update the coordinates
-  // matrix.
-
-  // Using cached R*R^T gives better optimization for sparse matrices.
+  // For sparse matrices, only the entries of R*R^T at the nonzeros are needed.
   if (index < SDP().NumSparseConstraints())
-    return accu(SDP().SparseA()[index] % rrt) - SDP().SparseB()[index];
+  {
+    return TraceRRT(SDP().SparseA()[index], arma::mat(trans(coordinates))) -
+        SDP().SparseB()[index];
+  }
   const size_t index1 = index - SDP().NumSparseConstraints();
 
   // For computation optimization we will be taking R^T * A first.
-  return trace((trans(coordinates) * SDP().DenseA()[index1]) * coordinates)
-                 - SDP().DenseB()[index1];
+  if (index1 < SDP().NumDenseConstraints())
+  {
+    return trace((trans(coordinates) * SDP().DenseA()[index1]) * coordinates)
+                   - SDP().DenseB()[index1];
+  }
+  const size_t index2 = index1 - SDP().NumDenseConstraints();
+
+  // For low-rank matrices, only R^T * V_i is needed.
+  return TraceLowRankRRT(SDP().LowRankA()[index2],
+      arma::mat(trans(coordinates))) - SDP().LowRankB()[index2];
 }
 
 template <typename SDPType>
@@ -100,67 +125,61 @@ void LRSDPFunction<SDPType>::GradientConstraint(
          "for arbitrary optimizers!");
 }
 
-//! Utility function for updating R*R^T matrix.
-//! Note: Caching R*R^T provide significant computation optimization
-//! by reducing redundant R*R^T calculations in case of functions are not used
-//! updating coordinates matrix, hence leaving R*R^T unchanged.
-template <typename SDPType>
-void UpdateRRT(LRSDPFunction<SDPType>& function,
-               const arma::mat& newrrt)
+//! Compute the values Tr(A_i * (R R^T)) - b_i of the given constraints, given
+//! R^T.  The constraints are independent, so they are computed in parallel;
+//! each value is written to its own element, so the result does not depend on
+//! the number of threads.
+template <typename MatrixType>
+static inline void
+ConstraintValues(const arma::mat& rt,
+                 const std::vector<MatrixType>& ais,
+                 const arma::vec& bis,
+                 arma::vec& values)
+{
+  values.set_size(ais.size());
+  #ifdef ENS_USE_OPENMP
+    #pragma omp parallel for schedule(dynamic) if (ais.size() > 1)
+  #endif
+  for (size_t i = 0; i < ais.size(); ++i)
+    values[i] = TraceRRT(ais[i], rt) - bis[i];
+}
+
+//! Compute the values ||R^T V_i||_F^2 - b_i of the low-rank constraints, in
+//! parallel (see ConstraintValues()).
+static inline void
+LowRankConstraintValues(const arma::mat& rt,
+                        const std::vector<arma::mat>& vs,
+                        const arma::vec& bis,
+                        arma::vec& values)
 {
-  function.RRT() = newrrt;
+  values.set_size(vs.size());
+  #ifdef ENS_USE_OPENMP
+    #pragma omp parallel for schedule(dynamic) if (vs.size() > 1)
+  #endif
+  for (size_t i = 0; i < vs.size(); ++i)
+    values[i] = TraceLowRankRRT(vs[i], rt) - bis[i];
 }
 
 //! Utility function for calculating part of the objective when AugLagrangian is
-//! used with an LRSDPFunction.
-template <typename MatrixType>
+//! used with an LRSDPFunction.  The constraint values are computed in parallel,
+//! and summed in order.
 static inline void
 UpdateObjective(double& objective,
-                const arma::mat& rrt,
-                const std::vector<MatrixType>& ais,
-                const arma::vec& bis,
+                const arma::vec& constraints,
                 const arma::vec& lambda,
                 const size_t lambdaOffset,
                 const double sigma)
 {
-  for (size_t i = 0; i < ais.size(); ++i)
-  {
-    // Take the trace subtracted by the b_i.
-    // Here taking R^T * A first is not recommended as we are already
-    // using pre-computed R * R^T. Taking R^T * A first will result in increase
-    // in number of computations.
-    const double constraint = accu(ais[i] % rrt) - bis[i];
-    objective -= (lambda[lambdaOffset + i] * constraint);
-    objective += (sigma / 2.) * constraint * constraint;
-  }
-}
-
-//! Utility function for calculating part of the gradient when AugLagrangian is
-//! used with an LRSDPFunction.
-template <typename MatrixType>
-static inline void
-UpdateGradient(arma::mat& s,
-               const arma::mat& rrt,
-               const std::vector<MatrixType>& ais,
-               const arma::vec& bis,
-               const arma::vec& lambda,
-               const size_t lambdaOffset,
-               const double sigma)
-{
-  for (size_t i = 0; i < ais.size(); ++i)
+  for (size_t i = 0; i < constraints.n_elem; ++i)
   {
-    // Here taking R^T * A first is not recommended as we are already
-    // using pre-computed R * R^T. Taking R^T * A first will result in increase
-    // in number of computations.
-    const double constraint = accu(ais[i] % rrt) - bis[i];
-    const double y = lambda[lambdaOffset + i] - sigma * constraint;
-    s -= y * ais[i];
+    objective -= (lambda[lambdaOffset + i] * constraints[i]);
+    objective += (sigma / 2.) * constraints[i] * constraints[i];
   }
 }
 
 template <typename SDPType>
 static inline double
-EvaluateImpl(LRSDPFunction<SDPType>& function,
+EvaluateImpl(const LRSDPFunction<SDPType>& function,
              const arma::mat& coordinates,
              const arma::vec& lambda,
              const double sigma)
@@ -182,61 +201,155 @@ EvaluateImpl(LRSDPFunction<SDPType>& function,
   //
   // For computation optimization we will be taking R^T * C first.
   // Objective function = Tr((R^T * C) * R)
-
-  // Calculate R*R^T for updating cache.
-  const arma::mat rrt = coordinates * trans(coordinates);
-
-  // Update R*R^T matrix.
-  // Note that we can only use this optimization in case of L-BFGS optimizer
-  // or any other similar optimizer which calls Evaluate() before Gradient()
-  // with same coordinates matrix and uses only Evaluate() to update
-  // coordinates matrix.
-
-  // Note: In case optimizer also uses Gradient() for updating coordinates
-  // matrix than the same line of code can be used to update R*R^T through
-  // Gradient().
-  UpdateRRT(function, rrt);
+  //
+  // The n x n matrix R R^T is never formed: the trace with a sparse A only
+  // needs the dot products of the rows of R at the nonzeros of A, and the
+  // trace with a dense A is computed from R^T A.  The rows of R are the
+  // columns of R^T, which are contiguous.
+  const arma::mat rt = trans(coordinates);
 
   // Optimized objective function.
   double objective = trace((trans(coordinates) * function.SDP().C())
                          * coordinates);
 
   // Now each constraint.
-  UpdateObjective(objective, rrt, function.SDP().SparseA(),
-      function.SDP().SparseB(), lambda, 0, sigma);
-  UpdateObjective(objective, rrt, function.SDP().DenseA(),
-      function.SDP().DenseB(), lambda, function.SDP().NumSparseConstraints(),
+  const SDPType& sdp = function.SDP();
+  arma::vec constraints;
+  ConstraintValues(rt, sdp.SparseA(), sdp.SparseB(), constraints);
+  UpdateObjective(objective, constraints, lambda, 0, sigma);
+  ConstraintValues(rt, sdp.DenseA(), sdp.DenseB(), constraints);
+  UpdateObjective(objective, constraints, lambda, sdp.NumSparseConstraints(),
       sigma);
+  LowRankConstraintValues(rt, sdp.LowRankA(), sdp.LowRankB(), constraints);
+  UpdateObjective(objective, constraints, lambda, sdp.NumSparseConstraints() +
+      sdp.NumDenseConstraints(), sigma);
 
   return objective;
 }
 
 template <typename SDPType>
-static inline void
-GradientImpl(const LRSDPFunction<SDPType>& function,
-             const arma::mat& coordinates,
-             const arma::vec& lambda,
-             const double sigma,
-             arma::mat& gradient)
+static inline double
+EvaluateWithGradientImpl(const LRSDPFunction<SDPType>& function,
+                         const arma::mat& coordinates,
+                         const arma::vec& lambda,
+                         const double sigma,
+                         arma::mat& gradient)
 {
   // We can calculate the gradient in a smart way.
   // L'(R, y, s) = 2 * S' * R
   //   with
   // S' = C - sum_{i = 1}^{m} y'_i A_i
   // y'_i = y_i - sigma * (Trace(A_i * (R R^T)) - b_i)
+  //
+  // The constraint values Trace(A_i * (R R^T)) - b_i are needed by both the
+  // objective (see EvaluateImpl()) and y'_i, so they are computed once.  No
+  // n x n matrix is formed for C or for the dense constraints: S' * R is
+  // computed as C * R (which also gives the objective Tr(R^T * C * R)) minus
+  // the sum of y'_i A_i * R.  For the sparse constraints, sum y'_i A_i is
+  // assembled at once from their nonzeros and multiplied with R.  With
+  // OpenMP, the constraints are processed in parallel.
+  const SDPType& sdp = function.SDP();
+  const arma::mat rt = trans(coordinates);
+  const arma::mat cr = sdp.C() * coordinates;
+  double objective = arma::accu(coordinates % cr);
+  gradient = 2 * cr;
+
+  // The sparse constraint values are computed in parallel, and the nonzeros
+  // of sum y'_i A_i are written in parallel, each constraint at its own
+  // offset.
+  arma::vec constraints;
+  ConstraintValues(rt, sdp.SparseA(), sdp.SparseB(), constraints);
+  UpdateObjective(objective, constraints, lambda, 0, sigma);
+
+  std::vector<size_t> offsets(sdp.NumSparseConstraints() + 1, 0);
+  for (size_t i = 0; i < sdp.NumSparseConstraints(); ++i)
+    offsets[i + 1] = offsets[i] + sdp.SparseA()[i].n_nonzero;
+  const size_t nonzeros = offsets.back();
+
+  arma::umat locations(2, nonzeros);
+  arma::vec values(nonzeros);
+  #ifdef ENS_USE_OPENMP
+    #pragma omp parallel for schedule(dynamic) \
+        if (sdp.NumSparseConstraints() > 1)
+  #endif
+  for (size_t i = 0; i < sdp.NumSparseConstraints(); ++i)
+  {
+    const arma::sp_mat& ai = sdp.SparseA()[i];
+    const double y = lambda[i] - sigma * constraints[i];
+    size_t k = offsets[i];
+    for (arma::sp_mat::const_iterator it = ai.begin(); it != ai.end(); ++it)
+    {
+      locations(0, k) = it.row();
+      locations(1, k) = it.col();
+      values(k++) = y * (*it);
+    }
+  }
 
-  // Directly reterive R*R^T from cache.
-  const arma::mat rrt = function.RRT();
-  arma::mat s(function.SDP().C());
+  if (nonzeros)
+  {
+    const arma::sp_mat s(true, locations, values, coordinates.n_rows,
+        coordinates.n_rows);
+    gradient -= 2 * s * coordinates;
+  }
 
-  UpdateGradient(
-      s, rrt, function.SDP().SparseA(), function.SDP().SparseB(),
-      lambda, 0, sigma);
-  UpdateGradient(
-      s, rrt, function.SDP().DenseA(), function.SDP().DenseB(),
-      lambda, function.SDP().NumSparseConstraints(), sigma);
+  // The dense and low-rank constraints are split over the threads; each thread
+  // sums the terms of its constraints into its own accumulators, which are
+  // merged at the end.
+  const size_t numDense = sdp.NumDenseConstraints();
+  const size_t numLowRank = sdp.NumLowRankConstraints();
+  #ifdef ENS_USE_OPENMP
+    #pragma omp parallel if (numDense + numLowRank > 1)
+  #endif
+  {
+    double localObjective = 0;
+    arma::mat localGradient(gradient.n_rows, gradient.n_cols,
+        arma::fill::zeros);
+
+    #ifdef ENS_USE_OPENMP
+      #pragma omp for schedule(dynamic) nowait
+    #endif
+    for (size_t i = 0; i < numDense; ++i)
+    {
+      // A_i * R gives both the trace and the gradient term.
+      const arma::mat ar = sdp.DenseA()[i] * coordinates;
+      const double constraint = arma::accu(coordinates % ar) -
+          sdp.DenseB()[i];
+      const size_t index = sdp.NumSparseConstraints() + i;
+      localObjective -= (lambda[index] * constraint);
+      localObjective += (sigma / 2.) * constraint * constraint;
+
+      const double y = lambda[index] - sigma * constraint;
+      localGradient -= (2 * y) * ar;
+    }
+
+    #ifdef ENS_USE_OPENMP
+      #pragma omp for schedule(dynamic) nowait
+    #endif
+    for (size_t i = 0; i < numLowRank; ++i)
+    {
+      // V_i^T * R gives the trace ||V_i^T R||^2, and A_i * R = V_i (V_i^T R),
+      // without forming A_i.
+      const arma::mat& v = sdp.LowRankA()[i];
+      const arma::mat vtr = trans(v) * coordinates;
+      const double constraint = arma::accu(vtr % vtr) - sdp.LowRankB()[i];
+      const size_t index = sdp.NumSparseConstraints() + numDense + i;
+      localObjective -= (lambda[index] * constraint);
+      localObjective += (sigma / 2.) * constraint * constraint;
+
+      const double y = lambda[index] - sigma * constraint;
+      localGradient -= (2 * y) * (v * vtr);
+    }
+
+    #ifdef ENS_USE_OPENMP
+      #pragma omp critical
+    #endif
+    {
+      objective += localObjective;
+      gradient += localGradient;
+    }
+  }
 
-  gradient = 2 * s * coordinates;
+  return objective;
 }
 
 // Template specializations for function and gradient evaluation.
@@ -261,7 +374,7 @@ inline void AugLagrangianFunction<LRSDPFunction<SDP<arma::sp_mat>>>::Gradient(
     const arma::mat& coordinates,
     arma::mat& gradient) const
 {
-  GradientImpl(function, coordinates, lambda, sigma, gradient);
+  EvaluateWithGradientImpl(function, coordinates, lambda, sigma, gradient);
 }
 
 template <>
@@ -269,7 +382,27 @@ inline void AugLagrangianFunction<LRSDPFunction<SDP<arma::mat>>>::Gradient(
     const arma::mat& coordinates,
     arma::mat& gradient) const
 {
-  GradientImpl(function, coordinates, lambda, sigma, gradient);
+  EvaluateWithGradientImpl(function, coordinates, lambda, sigma, gradient);
+}
+
+template <>
+inline double
+AugLagrangianFunction<LRSDPFunction<SDP<arma::sp_mat>>>::EvaluateWithGradient(
+    const arma::mat& coordinates,
+    arma::mat& gradient) const
+{
+  return EvaluateWithGradientImpl(function, coordinates, lambda, sigma,
+      gradient);
+}
+
+template <>
+inline double
+AugLagrangianFunction<LRSDPFunction<SDP<arma::mat>>>::EvaluateWithGradient(
+    const arma::mat& coordinates,
+    arma::mat& gradient) const
+{
+  return EvaluateWithGradientImpl(function, coordinates, lambda, sigma,
+      gradient);
 }
 
 } // namespace ens
@@ -23,7 +23,10 @@ LRSDP<SDPType>::LRSDP(const size_t numSparseConstraints,
                       const arma::mat& initialPoint,
                       const size_t maxIterations) :
     function(numSparseConstraints, numDenseConstraints, initialPoint),
-    maxIterations(maxIterations)
+    maxIterations(maxIterations),
+    adaptiveRank(false),
+    maxRank(0),
+    certificateTolerance(1e-5)
 { }
 
 template <typename SDPType>
@@ -31,11 +34,165 @@ double LRSDP<SDPType>::Optimize(arma::mat& coordinates)
 {
   augLag.Sigma() = 10;
   augLag.MaxIterations() = maxIterations;
-  augLag.Optimize(function, coordinates);
+  if (!adaptiveRank)
+  {
+    augLag.Optimize(function, coordinates);
+
+    return function.Evaluate(coordinates);
+  }
+
+  // Above the rank p with p (p + 1) / 2 > m, the factorized problem has no
+  // spurious local minima, so the rank never needs to grow beyond it.
+  const size_t n = coordinates.n_rows;
+  const size_t m = function.NumConstraints();
+  size_t rankBound = maxRank;
+  if (rankBound == 0)
+  {
+    rankBound = 1;
+    while (rankBound * (rankBound + 1) / 2 <= m)
+      ++rankBound;
+  }
+  rankBound = std::min(rankBound, n);
+
+  // The first solve starts from the default multipliers; each later solve is
+  // warm-started from the previous solution and multipliers.
+  arma::vec lambda(m, arma::fill::zeros);
+  double sigma = 10;
+  while (true)
+  {
+    augLag.Optimize(function, coordinates, lambda, sigma);
+    lambda = augLag.Lambda();
+    sigma = augLag.Sigma();
+
+    if (coordinates.n_cols >= rankBound)
+      break;
+
+    arma::vec v;
+    const double eigenvalue = SmallestDualEigenpair(coordinates, lambda, sigma,
+        v);
+    if (eigenvalue >= -certificateTolerance)
+    {
+      Info << "LRSDP::Optimize(): second-order certificate holds at rank "
+          << coordinates.n_cols << "." << std::endl;
+      break;
+    }
+
+    // Step along the direction of negative curvature v v^T, at the scale of
+    // the current columns.
+    double scale = 1.0;
+    if (coordinates.n_cols > 0)
+    {
+      scale = 0.1 * arma::norm(coordinates, "fro") /
+          std::sqrt((double) coordinates.n_cols);
+      if (scale == 0.0)
+        scale = 1.0;
+    }
+    coordinates.insert_cols(coordinates.n_cols, scale * v);
+
+    Info << "LRSDP::Optimize(): smallest dual slack eigenvalue is "
+        << eigenvalue << "; increasing the rank to " << coordinates.n_cols
+        << "." << std::endl;
+  }
 
   return function.Evaluate(coordinates);
 }
 
+template <typename SDPType>
+void LRSDP<SDPType>::DualVariables(const arma::mat& coordinates,
+                                   arma::vec& y) const
+{
+  const size_t m = function.NumConstraints();
+  y.set_size(m);
+  for (size_t i = 0; i < m; ++i)
+  {
+    const double lambda = (augLag.Lambda().n_elem == m) ?
+        augLag.Lambda()[i] : 0.0;
+    y[i] = lambda - augLag.Sigma() *
+        function.EvaluateConstraint(i, coordinates);
+  }
+}
+
+template <typename SDPType>
+double LRSDP<SDPType>::SmallestDualEigenpair(const arma::mat& coordinates,
+                                             const arma::vec& lambda,
+                                             const double sigma,
+                                             arma::vec& eigenvector) const
+{
+  const SDPType& sdp = function.SDP();
+  const size_t n = coordinates.n_rows;
+  arma::vec y(function.NumConstraints());
+  for (size_t i = 0; i < y.n_elem; ++i)
+    y[i] = lambda[i] - sigma * function.EvaluateConstraint(i, coordinates);
+
+  // The slack is assembled as a sparse matrix only for large problems; for
+  // small ones the dense eigendecomposition is cheaper and more robust.
+  const bool sparse = std::is_same<typename SDPType::objective_matrix_type,
+      arma::sp_mat>::value && sdp.NumDenseConstraints() == 0 &&
+      sdp.NumLowRankConstraints() == 0 && n >= 100;
+  if (sparse)
+  {
+    const arma::sp_mat c(sdp.C());
+    size_t nonzeros = c.n_nonzero;
+    for (size_t i = 0; i < sdp.NumSparseConstraints(); ++i)
+      nonzeros += sdp.SparseA()[i].n_nonzero;
+
+    arma::umat locations(2, nonzeros);
+    arma::vec values(nonzeros);
+    size_t k = 0;
+    for (arma::sp_mat::const_iterator it = c.begin(); it != c.end(); ++it)
+    {
+      locations(0, k) = it.row();
+      locations(1, k) = it.col();
+      values(k++) = (*it);
+    }
+    for (size_t i = 0; i < sdp.NumSparseConstraints(); ++i)
+    {
+      const arma::sp_mat& ai = sdp.SparseA()[i];
+      for (arma::sp_mat::const_iterator it = ai.begin(); it != ai.end(); ++it)
+      {
+        locations(0, k) = it.row();
+        locations(1, k) = it.col();
+        values(k++) = -y[i] * (*it);
+      }
+    }
+
+    const arma::sp_mat s(true, locations, values, n, n);
+    arma::vec eigenvalues;
+    arma::mat eigenvectors;
+    if (arma::eigs_sym(eigenvalues, eigenvectors, s, 1, "sa"))
+    {
+      eigenvector = eigenvectors.col(0);
+      return eigenvalues[0];
+    }
+  }
+
+  // Otherwise (or if ARPACK fails), form S densely.
+  arma::mat s(sdp.C());
+  for (size_t i = 0; i < sdp.NumSparseConstraints(); ++i)
+    s -= y[i] * sdp.SparseA()[i];
+  for (size_t i = 0; i < sdp.NumDenseConstraints(); ++i)
+    s -= y[sdp.NumSparseConstraints() + i] * sdp.DenseA()[i];
+  const size_t lowRankOffset = sdp.NumSparseConstraints() +
+      sdp.NumDenseConstraints();
+  for (size_t i = 0; i < sdp.NumLowRankConstraints(); ++i)
+  {
+    const arma::mat& v = sdp.LowRankA()[i];
+    s -= y[lowRankOffset + i] * (v * v.t());
+  }
+
+  arma::vec eigenvalues;
+  arma::mat eigenvectors;
+  if (!arma::eig_sym(eigenvalues, eigenvectors, s))
+  {
+    // Without a certificate, the rank is not grown.
+    eigenvector.zeros(n);
+    return 0.0;
+  }
+
+  eigenvector = eigenvectors.col(0);
+  return eigenvalues[0];
+}
+
 } // namespace ens
 
 #endif
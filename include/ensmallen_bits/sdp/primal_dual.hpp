@@ -19,6 +19,14 @@ namespace ens {
  * PrimalDualSolver is a primal dual interior point solver for semidefinite
  * programs.
  *
+ * Each iteration solves a linear system with the m x m Schur complement of the
+ * KKT system, where m is the number of constraints.  By default the Schur
+ * complement is formed and factorized, which takes O(m^2) memory and m
+ * Lyapunov solves.  If IterativeSchur() is set, the system is instead solved
+ * with preconditioned BiCGSTAB, applying the Schur complement through the
+ * constraint matrices with one Lyapunov solve per product; this makes large
+ * constraint sets tractable, at the cost of less accurate search directions.
+ *
  * PrimalDualSolver can optimize semidefinite programs.  For more details, see the
  * documentation on function types included with this distribution or on the
  * ensmallen website.
@@ -40,7 +48,8 @@ class PrimalDualSolver
   /**
    * Construct a new solver instance from a given SDP instance.  Uses a random,
    * positive initialization point. Both initialX and initialZ need to be
-   * positive definite matrices.
+   * positive definite matrices.  The multipliers of the low-rank constraints
+   * start at one.
    *
    * @param sdp Initialized SDP to be solved.
    * @param initialX
@@ -54,6 +63,32 @@ class PrimalDualSolver
                    const arma::vec& initialYDense,
                    const arma::mat& initialZ);
 
+  /**
+   * Set the starting point from a low-accuracy low-rank solution, such as the
+   * one of LRSDP, so that the interior point method only has to polish it.
+   * Given the factor R of X ~ R R^T and the dual estimates y (numbered as the
+   * constraints of the SDP, as LRSDP::DualVariables() returns them), the dual
+   * slack S = C - sum_i y_i A_i is formed, and the eigendecomposition
+   * R R^T - S = Q diag(d) Q^T gives the starting point
+   *
+   *   X = Q diag(x) Q^T,  Z = Q diag(z) Q^T,
+   *   x_j = (d_j + sqrt(d_j^2 + 4 mu)) / 2,  z_j = mu / x_j,
+   *
+   * which is strictly positive definite and exactly centered (X Z = mu I),
+   * with X - Z = R R^T - S, so that X ~ R R^T and Z ~ S when R R^T and S are
+   * nearly complementary.  The barrier parameter is
+   * mu = (centrality * mean_j |d_j|)^2.  This replaces the starting point
+   * given to the constructor.
+   *
+   * @param coordinates Factor R of the low-rank solution (n x r).
+   * @param y Dual estimates of all the constraints.
+   * @param centrality Size of the centering, relative to the scale of the
+   *     solution.
+   */
+  void WarmStart(const arma::mat& coordinates,
+                 const arma::vec& y,
+                 const double centrality = 1e-2);
+
   /**
    * Invoke the optimization procedure, returning the converged values for the
    * primal and dual variables.
@@ -66,6 +101,28 @@ class PrimalDualSolver
   double Optimize(arma::mat& X,
                   arma::vec& ySparse,
                   arma::vec& yDense,
+                  arma::mat& Z)
+  {
+    arma::vec ylowrank;
+    return Optimize(X, ySparse, yDense, ylowrank, Z);
+  }
+
+  /**
+   * Invoke the optimization procedure, returning the converged values for the
+   * primal and dual variables, including the multipliers of the low-rank
+   * constraints.  The low-rank constraints A_i = V_i V_i^T are applied through
+   * their factors, without forming A_i.
+   *
+   * @param X
+   * @param ySparse
+   * @param yDense
+   * @param yLowRank
+   * @param Z
+   */
+  double Optimize(arma::mat& X,
+                  arma::vec& ySparse,
+                  arma::vec& yDense,
+                  arma::vec& yLowRank,
                   arma::mat& Z);
 
   /**
@@ -98,6 +155,22 @@ class PrimalDualSolver
   //! Modify the maximum number of iterations to run before converging.
   size_t& MaxIterations() { return maxIterations; }
 
+  //! Modify whether the Schur complement system is solved iteratively,
+  //! without forming the Schur complement.
+  bool& IterativeSchur() { return iterativeSchur; }
+
+  //! Modify the relative residual tolerance of the iterative Schur complement
+  //! solve.
+  double& SchurTolerance() { return schurTolerance; }
+
+  //! Modify the maximum number of iterations of each iterative Schur
+  //! complement solve (0 means the number of constraints).
+  size_t& MaxSchurIterations() { return maxSchurIterations; }
+
+  //! Get the total number of iterations of the iterative Schur complement
+  //! solves in the last call to Optimize().
+  size_t SchurIterations() const { return schurIterations; }
+
  private:
   //! The SDP problem instance to optimize.
   SDPType sdp;
@@ -111,6 +184,9 @@ class PrimalDualSolver
   //! Starting lagrange multiplier for the dense constraints.
   arma::vec initialYdense;
 
+  //! Starting lagrange multiplier for the low-rank constraints.
+  arma::vec initialYlowRank;
+
   //! Starting point for Z, the complementary slack variable. Needs to be
   //! positive definite.
   arma::mat initialZ;
@@ -130,6 +206,20 @@ class PrimalDualSolver
 
   //! Maximum number of iterations to run. Set to 0 for no limit.
   size_t maxIterations;
+
+  //! Whether the Schur complement system is solved iteratively.
+  bool iterativeSchur;
+
+  //! The relative residual tolerance of the iterative Schur complement solve.
+  double schurTolerance;
+
+  //! The maximum number of iterations of each iterative Schur complement
+  //! solve (0 means the number of constraints).
+  size_t maxSchurIterations;
+
+  //! The total number of iterations of the iterative Schur complement solves
+  //! in the last call to Optimize().
+  size_t schurIterations;
 };
 
 } // namespace ens
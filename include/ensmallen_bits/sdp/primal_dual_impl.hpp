@@ -40,12 +40,17 @@ PrimalDualSolver<SDPType>::PrimalDualSolver(const SDPType& sdp)
     initialX(arma::eye<arma::mat>(sdp.N(), sdp.N())),
     initialYsparse(arma::ones<arma::vec>(sdp.NumSparseConstraints())),
     initialYdense(arma::ones<arma::vec>(sdp.NumDenseConstraints())),
+    initialYlowRank(arma::ones<arma::vec>(sdp.NumLowRankConstraints())),
     initialZ(arma::eye<arma::mat>(sdp.N(), sdp.N())),
     tau(0.99),
     normXzTol(1e-7),
     primalInfeasTol(1e-7),
     dualInfeasTol(1e-7),
-    maxIterations(1000)
+    maxIterations(1000),
+    iterativeSchur(false),
+    schurTolerance(1e-10),
+    maxSchurIterations(0),
+    schurIterations(0)
 { /* Nothing to do. */ }
 
 template <typename SDPType>
@@ -58,12 +63,17 @@ PrimalDualSolver<SDPType>::PrimalDualSolver(const SDPType& sdp,
     initialX(initialX),
     initialYsparse(initialYsparse),
     initialYdense(initialYdense),
+    initialYlowRank(arma::ones<arma::vec>(sdp.NumLowRankConstraints())),
     initialZ(initialZ),
     tau(0.99),
     normXzTol(1e-7),
     primalInfeasTol(1e-7),
     dualInfeasTol(1e-7),
-    maxIterations(1000)
+    maxIterations(1000),
+    iterativeSchur(false),
+    schurTolerance(1e-10),
+    maxSchurIterations(0),
+    schurIterations(0)
 {
   arma::mat tmp;
 
@@ -109,6 +119,87 @@ PrimalDualSolver<SDPType>::PrimalDualSolver(const SDPType& sdp,
   }
 }
 
+template <typename SDPType>
+void PrimalDualSolver<SDPType>::WarmStart(const arma::mat& coordinates,
+                                          const arma::vec& y,
+                                          const double centrality)
+{
+  const size_t n = sdp.N();
+  if (coordinates.n_rows != n)
+  {
+    throw std::logic_error("PrimalDualSolver::WarmStart(): coordinates need "
+        "to have n rows.");
+  }
+
+  if (y.n_elem != sdp.NumConstraints())
+  {
+    throw std::logic_error("PrimalDualSolver::WarmStart(): y needs to have "
+        "the same length as the number of constraints.");
+  }
+
+  // The dual slack S = C - sum_i y_i A_i.
+  const size_t numSparse = sdp.NumSparseConstraints();
+  const size_t numDense = sdp.NumDenseConstraints();
+  arma::mat S(sdp.C());
+  for (size_t i = 0; i < numSparse; i++)
+    S -= y(i) * sdp.SparseA()[i];
+  for (size_t i = 0; i < numDense; i++)
+    S -= y(numSparse + i) * sdp.DenseA()[i];
+  for (size_t i = 0; i < sdp.NumLowRankConstraints(); i++)
+  {
+    const arma::mat& Vi = sdp.LowRankA()[i];
+    S -= y(numSparse + numDense + i) * (Vi * Vi.t());
+  }
+
+  arma::vec d;
+  arma::mat Q;
+  arma::mat D = coordinates * coordinates.t() - S;
+  D = 0.5 * (D + D.t());
+  if (!arma::eig_sym(d, Q, D))
+  {
+    throw std::logic_error("PrimalDualSolver::WarmStart(): "
+        "eigendecomposition failed.");
+  }
+
+  double mu = centrality * arma::mean(arma::abs(d));
+  mu = (mu > 0.) ? mu * mu : centrality * centrality;
+
+  // x_j is computed without cancellation for negative d_j.
+  arma::vec x(n), z(n);
+  for (size_t j = 0; j < n; j++)
+  {
+    const double root = std::sqrt(d(j) * d(j) + 4. * mu);
+    x(j) = (d(j) >= 0.) ? 0.5 * (d(j) + root) : 2. * mu / (root - d(j));
+    z(j) = mu / x(j);
+  }
+
+  initialX = Q * arma::diagmat(x) * Q.t();
+  initialX = 0.5 * (initialX + initialX.t());
+  initialZ = Q * arma::diagmat(z) * Q.t();
+  initialZ = 0.5 * (initialZ + initialZ.t());
+
+  initialYsparse = y.head(numSparse);
+  initialYdense = y.head(numSparse + numDense).tail(numDense);
+  initialYlowRank = y.tail(sdp.NumLowRankConstraints());
+}
+
+/**
+ * Compute the inverse Linv of the lower triangular Cholesky factor of the
+ * symmetric positive definite matrix A, so that Linv A Linv^T = I.  This is
+ * what Alpha() needs; it is computed once per iteration and shared by the
+ * predictor and the corrector steps.  Returns false if A is not positive
+ * definite.
+ */
+static inline bool
+InverseCholeskyFactor(const arma::mat& A, arma::mat& Linv)
+{
+  arma::mat L;
+  if (!arma::chol(L, A, "lower"))
+    return false;
+
+  return arma::inv(Linv, arma::trimatl(L));
+}
+
 /**
  * Compute
  *
@@ -118,18 +209,12 @@ PrimalDualSolver<SDPType>::PrimalDualSolver(const SDPType& sdp,
  *
  *     alphahat = sup{ alphahat : A + dA is psd }
  *
+ * given a factor Linv with Linv A Linv^T = I (see InverseCholeskyFactor()).
  * See (2.18) of [AHO98] for more details.
  */
-static inline bool
-Alpha(const arma::mat& A, const arma::mat& dA, double tau, double& alpha)
+static inline void
+Alpha(const arma::mat& Linv, const arma::mat& dA, double tau, double& alpha)
 {
-  arma::mat L;
-  if (!arma::chol(L, A, "lower"))
-    return false;
-
-  arma::mat Linv;
-  if (!arma::inv(Linv, arma::trimatl(L)))
-    return false;
   // TODO(stephentu): We only want the top eigenvalue, we should
   // be able to do better than full eigen-decomposition.
   const arma::vec evals = arma::eig_sym(-Linv * dA * Linv.t());
@@ -139,7 +224,6 @@ Alpha(const arma::mat& A, const arma::mat& dA, double tau, double& alpha)
     // dA is PSD already
     alphahat = 1.;
   alpha = std::min(1., tau * alphahat);
-  return true;
 }
 
 /**
@@ -147,17 +231,256 @@ Alpha(const arma::mat& A, const arma::mat& dA, double tau, double& alpha)
  *
  *   AX + XA = H
  *
- * where A, H are symmetric matrices.
+ * where A, H are symmetric matrices, using the eigenvalue decomposition
+ * A = Q diag(lambda) Q^T (see Lemma 7.2 of [AHO98]):
  *
- * TODO(stephentu): Note this method current uses arma's builtin arma::syl
- * method, which is overkill for this situation. See Lemma 7.2 of [AHO98] for
- * how to solve this Lyapunov equation using an eigenvalue decomposition of A.
+ *   X = Q ((Q^T H Q) ./ (lambda_i + lambda_j)) Q^T.
  *
+ * The decomposition is computed once per iteration and shared by all the
+ * equations with the same A, so each solve costs four matrix products.
+ *
+ * @param X Output solution.
+ * @param Q Eigenvectors of A.
+ * @param invLambdaSum Matrix with entries 1 / (lambda_i + lambda_j).
+ * @param H Right hand side.
  */
 static inline void
-SolveLyapunov(arma::mat& X, const arma::mat& A, const arma::mat& H)
+SolveLyapunov(arma::mat& X,
+              const arma::mat& Q,
+              const arma::mat& invLambdaSum,
+              const arma::mat& H)
 {
-  arma::syl(X, A, A, -H);
+  X = Q * ((Q.t() * H * Q) % invLambdaSum) * Q.t();
+}
+
+/**
+ * Compute the eigenvalue decomposition A = Q diag(lambda) Q^T of the symmetric
+ * positive definite matrix A that SolveLyapunov() needs.  Returns false if the
+ * decomposition fails or A is not positive definite.
+ */
+static inline bool
+LyapunovFactor(const arma::mat& A,
+               arma::mat& Q,
+               arma::vec& lambda,
+               arma::mat& invLambdaSum)
+{
+  if (!arma::eig_sym(lambda, Q, A) || lambda.min() <= 0.)
+    return false;
+
+  invLambdaSum = 1. / (arma::repmat(lambda, 1, lambda.n_elem) +
+      arma::repmat(lambda.t(), lambda.n_elem, 1));
+  return true;
+}
+
+/**
+ * Compute dot(A_i, X) = accu(V_i % (X V_i)) for the low-rank constraints
+ * A_i = V_i V_i^T, without forming A_i.
+ */
+static inline void
+LowRankProduct(const std::vector<arma::mat>& lowRankA,
+               const arma::mat& X,
+               arma::vec& out)
+{
+  out.set_size(lowRankA.size());
+  for (size_t i = 0; i < lowRankA.size(); i++)
+    out(i) = arma::accu(lowRankA[i] % (X * lowRankA[i]));
+}
+
+/**
+ * Compute sum_i y_i A_i = sum_i y_i V_i V_i^T for the low-rank constraints.
+ */
+static inline void
+LowRankAdjoint(const std::vector<arma::mat>& lowRankA,
+               const arma::vec& y,
+               const size_t n,
+               arma::mat& out)
+{
+  out.zeros(n, n);
+  for (size_t i = 0; i < lowRankA.size(); i++)
+    out += y(i) * (lowRankA[i] * lowRankA[i].t());
+}
+
+/**
+ * Compute the product out = M v of the Schur complement M = A E^(-1) F A^T of
+ * (2.15) with the vector v, without forming M: W = smat(A^T v) is formed from
+ * the constraint matrices, the Lyapunov equation Z G + G Z = X W + W X is
+ * solved, and out = A svec(G).  This costs one Lyapunov solve and one pass
+ * over the constraints, instead of one Lyapunov solve per constraint and the
+ * storage of M.
+ */
+static inline void
+ApplySchurComplement(const arma::sp_mat& Asparse,
+                     const arma::mat& Adense,
+                     const std::vector<arma::mat>& lowRankA,
+                     const arma::mat& X,
+                     const arma::mat& Zvec,
+                     const arma::mat& ZinvLambdaSum,
+                     const arma::vec& v,
+                     arma::vec& out)
+{
+  const size_t numLinear = Asparse.n_rows + Adense.n_rows;
+  const size_t numConstraints = numLinear + lowRankA.size();
+
+  arma::vec w(Asparse.n_cols, arma::fill::zeros);
+  if (Asparse.n_rows)
+    w += Asparse.t() * v(arma::span(0, Asparse.n_rows - 1));
+  if (Adense.n_rows)
+    w += Adense.t() * v(arma::span(Asparse.n_rows, numLinear - 1));
+
+  arma::mat W;
+  math::Smat(w, W);
+  if (lowRankA.size())
+  {
+    arma::mat lowRankSum;
+    const arma::vec vLowRank = v(arma::span(numLinear, numConstraints - 1));
+    LowRankAdjoint(lowRankA, vLowRank, X.n_rows, lowRankSum);
+    W += lowRankSum;
+  }
+
+  arma::mat G;
+  arma::vec g;
+  const arma::mat XW = X * W;
+  SolveLyapunov(G, Zvec, ZinvLambdaSum, XW + XW.t());
+  math::Svec(G, g);
+
+  out.set_size(numConstraints);
+  if (Asparse.n_rows)
+    out(arma::span(0, Asparse.n_rows - 1)) = Asparse * g;
+  if (Adense.n_rows)
+    out(arma::span(Asparse.n_rows, numLinear - 1)) = Adense * g;
+  if (lowRankA.size())
+  {
+    arma::vec lowRankG;
+    LowRankProduct(lowRankA, G, lowRankG);
+    out(arma::span(numLinear, numConstraints - 1)) = lowRankG;
+  }
+}
+
+/**
+ * Compute the Jacobi preconditioner of the Schur complement for the iterative
+ * solve.  On the central path (X Z = mu I), the solution of the Lyapunov
+ * equation for A_j is X A_j Z^(-1), so the diagonal of M is approximated by
+ *
+ *   M_jj ~ tr(A_j X A_j Z^(-1)),
+ *
+ * which is positive and only needs products with the constraint matrices.
+ */
+template<typename SDPType>
+static inline void
+SchurPreconditioner(const SDPType& sdp,
+                    const arma::mat& X,
+                    const arma::mat& Zinv,
+                    arma::vec& precond)
+{
+  const size_t numSparse = sdp.NumSparseConstraints();
+  const size_t numLinear = numSparse + sdp.NumDenseConstraints();
+  precond.set_size(sdp.NumConstraints());
+  for (size_t j = 0; j < sdp.NumConstraints(); j++)
+  {
+    if (j < numSparse)
+    {
+      const arma::sp_mat& Aj = sdp.SparseA()[j];
+      const arma::mat XAj = X * Aj;
+      const arma::mat ZinvAj = Zinv * Aj;
+      precond(j) = arma::accu(XAj % ZinvAj.t());
+    }
+    else if (j < numLinear)
+    {
+      const arma::mat& Aj = sdp.DenseA()[j - numSparse];
+      const arma::mat ZinvAj = Zinv * Aj;
+      precond(j) = arma::accu((X * Aj) % ZinvAj.t());
+    }
+    else
+    {
+      // tr(V V^T X V V^T Z^(-1)) = <V^T X V, V^T Z^(-1) V>.
+      const arma::mat& Vj = sdp.LowRankA()[j - numLinear];
+      precond(j) = arma::accu((Vj.t() * X * Vj) % (Vj.t() * Zinv * Vj));
+    }
+
+    if (!(precond(j) > 0.) || !std::isfinite(precond(j)))
+      precond(j) = 1.;
+  }
+}
+
+/**
+ * Solve M dy = rhs for the Schur complement M, applied as applySchur(v, out)
+ * (see ApplySchurComplement()), with the Jacobi-preconditioned biconjugate
+ * gradient stabilized method (BiCGSTAB), starting from dy = 0.  M is not
+ * symmetric for the XZ+ZX direction, so conjugate gradients can't be used.  If
+ * the method breaks down, it is restarted from the current solution.
+ *
+ * @return The number of iterations taken.  converged is set to whether the
+ *     relative residual reached the tolerance.
+ */
+template<typename ApplySchurType>
+static inline size_t
+SolveSchurIterative(ApplySchurType& applySchur,
+                    const arma::vec& precond,
+                    const arma::vec& rhs,
+                    const double tolerance,
+                    const size_t maxIterations,
+                    arma::vec& dy,
+                    bool& converged)
+{
+  dy.zeros(rhs.n_elem);
+  converged = true;
+  const double rhsNorm = arma::norm(rhs, 2);
+  if (rhsNorm == 0.)
+    return 0;
+
+  arma::vec r = rhs;
+  arma::vec rhat = rhs;
+  arma::vec p(rhs.n_elem, arma::fill::zeros);
+  arma::vec v(rhs.n_elem, arma::fill::zeros);
+  arma::vec y, s, z, t;
+  double rho = 1., alpha = 1., omega = 1.;
+  for (size_t i = 1; i <= maxIterations; i++)
+  {
+    double rhoNew = arma::dot(rhat, r);
+    if (rhoNew == 0. || omega == 0.)
+    {
+      // Breakdown; restart from the current solution.
+      rhat = r;
+      p.zeros();
+      v.zeros();
+      rho = alpha = omega = 1.;
+      rhoNew = arma::dot(r, r);
+    }
+
+    p = r + ((rhoNew / rho) * (alpha / omega)) * (p - omega * v);
+    y = p / precond;
+    applySchur(y, v);
+    rho = rhoNew;
+
+    const double rhatv = arma::dot(rhat, v);
+    if (rhatv == 0.)
+    {
+      omega = 0.;
+      continue;
+    }
+
+    alpha = rhoNew / rhatv;
+    s = r - alpha * v;
+    if (arma::norm(s, 2) <= tolerance * rhsNorm)
+    {
+      dy += alpha * y;
+      return i;
+    }
+
+    z = s / precond;
+    applySchur(z, t);
+    const double tt = arma::dot(t, t);
+    omega = 0.;
+    if (tt > 0.)
+      omega = arma::dot(t, s) / tt;
+    dy += alpha * y + omega * z;
+    r = s - omega * t;
+    if (arma::norm(r, 2) <= tolerance * rhsNorm)
+      return i;
+  }
+
+  converged = false;
+  return maxIterations;
 }
 
 /**
@@ -170,48 +493,67 @@ SolveLyapunov(arma::mat& X, const arma::mat& A, const arma::mat& H)
  *
  * where
  *
- *     A  = [ Asparse ]
- *          [ Adense  ]
- *     dy = [ dysparse  dydense ]
+ *     A  = [ Asparse  ]
+ *          [ Adense   ]
+ *          [ Alowrank ]
+ *     dy = [ dysparse  dydense  dylowrank ]
  *     E  = Z sym I
  *     F  = X sym I
  *
+ * The system (2.12) with the Schur complement A E^(-1) F A^T of (2.15) is
+ * solved by solveSchur(rhs, dy), which returns false if it fails; it either
+ * uses the LU factorization of the Schur complement, computed once per
+ * iteration and reused for the predictor and the corrector steps, or solves
+ * the system iteratively without forming it.  F is applied to a vector v as
+ * svec(0.5 * (X smat(v) + smat(v) X)), instead of being formed explicitly,
+ * and Alowrank is applied through the factors of the low-rank constraints.
  */
+template<typename SchurSolveType>
 static inline void
 SolveKKTSystem(const arma::sp_mat& Asparse,
                const arma::mat& Adense,
-               const arma::mat& Z,
-               const arma::mat& M,
-               const arma::mat& F,
+               const std::vector<arma::mat>& lowRankA,
+               const arma::mat& X,
+               const arma::mat& Zvec,
+               const arma::mat& ZinvLambdaSum,
+               SchurSolveType& solveSchur,
                const arma::vec& rp,
                const arma::vec& rd,
                const arma::vec& rc,
                arma::vec& dsx,
                arma::vec& dysparse,
                arma::vec& dydense,
+               arma::vec& dylowrank,
                arma::vec& dsz)
 {
-  arma::mat Frd_rc_Mat, Einv_Frd_rc_Mat,
-            Einv_Frd_ATdy_rc_Mat, Frd_ATdy_rc_Mat;
+  arma::mat Rd, Rc, Einv_Frd_rc_Mat, Einv_Frd_ATdy_rc_Mat;
   arma::vec Einv_Frd_rc, Einv_Frd_ATdy_rc, dy;
 
   // Note: Whenever a formula calls for E^(-1) v for some v, we solve Lyapunov
   // equations instead of forming an explicit inverse.
 
   // Compute the RHS of (2.12)
-  math::Smat(F * rd - rc, Frd_rc_Mat);
-  SolveLyapunov(Einv_Frd_rc_Mat, Z, 2. * Frd_rc_Mat);
+  math::Smat(rd, Rd);
+  math::Smat(rc, Rc);
+  SolveLyapunov(Einv_Frd_rc_Mat, Zvec, ZinvLambdaSum,
+      X * Rd + Rd * X - 2. * Rc);
   math::Svec(Einv_Frd_rc_Mat, Einv_Frd_rc);
 
   arma::vec rhs = rp;
-  const size_t numConstraints = Asparse.n_rows + Adense.n_rows;
+  const size_t numLinear = Asparse.n_rows + Adense.n_rows;
+  const size_t numConstraints = numLinear + lowRankA.size();
   if (Asparse.n_rows)
     rhs(arma::span(0, Asparse.n_rows - 1)) += Asparse * Einv_Frd_rc;
   if (Adense.n_rows)
-    rhs(arma::span(Asparse.n_rows, numConstraints - 1)) += Adense * Einv_Frd_rc;
+    rhs(arma::span(Asparse.n_rows, numLinear - 1)) += Adense * Einv_Frd_rc;
+  if (lowRankA.size())
+  {
+    arma::vec lowRankRhs;
+    LowRankProduct(lowRankA, Einv_Frd_rc_Mat, lowRankRhs);
+    rhs(arma::span(numLinear, numConstraints - 1)) += lowRankRhs;
+  }
 
-  // TODO(stephentu): use a more efficient method (e.g. LU decomposition)
-  if (!arma::solve(dy, M, rhs))
+  if (!solveSchur(rhs, dy))
   {
     throw std::logic_error("PrimalDualSolver::SolveKKTSystem(): Could not "
         "solve KKT system.");
@@ -220,17 +562,28 @@ SolveKKTSystem(const arma::sp_mat& Asparse,
   if (Asparse.n_rows)
     dysparse = dy(arma::span(0, Asparse.n_rows - 1));
   if (Adense.n_rows)
-    dydense = dy(arma::span(Asparse.n_rows, numConstraints - 1));
+    dydense = dy(arma::span(Asparse.n_rows, numLinear - 1));
+  if (lowRankA.size())
+    dylowrank = dy(arma::span(numLinear, numConstraints - 1));
+
+  // Compute dz from (2.14)
+  dsz = rd - Asparse.t() * dysparse - Adense.t() * dydense;
+  if (lowRankA.size())
+  {
+    arma::mat lowRankSum;
+    arma::vec sLowRankSum;
+    LowRankAdjoint(lowRankA, dylowrank, X.n_rows, lowRankSum);
+    math::Svec(lowRankSum, sLowRankSum);
+    dsz -= sLowRankSum;
+  }
 
   // Compute dx from (2.13)
-  math::Smat(F * (rd - Asparse.t() * dysparse - Adense.t() * dydense) - rc,
-      Frd_ATdy_rc_Mat);
-  SolveLyapunov(Einv_Frd_ATdy_rc_Mat, Z, 2. * Frd_ATdy_rc_Mat);
+  arma::mat Dsz;
+  math::Smat(dsz, Dsz);
+  SolveLyapunov(Einv_Frd_ATdy_rc_Mat, Zvec, ZinvLambdaSum,
+      X * Dsz + Dsz * X - 2. * Rc);
   math::Svec(Einv_Frd_ATdy_rc_Mat, Einv_Frd_ATdy_rc);
   dsx = -Einv_Frd_ATdy_rc;
-
-  // Compute dz from (2.14)
-  dsz = rd - Asparse.t() * dysparse - Adense.t() * dydense;
 }
 
 namespace private_ {
@@ -249,6 +602,7 @@ double
 PrimalDualSolver<SDPType>::Optimize(arma::mat& X,
                                     arma::vec& ysparse,
                                     arma::vec& ydense,
+                                    arma::vec& ylowrank,
                                     arma::mat& Z)
 {
   // TODO(stephentu): We need a method which deals with the case when the Ais
@@ -258,7 +612,11 @@ PrimalDualSolver<SDPType>::Optimize(arma::mat& X,
   const size_t n2bar = sdp.N2bar();
 
   // Form the A matrix in (2.7). Note we explicitly handle
-  // sparse and dense constraints separately.
+  // sparse and dense constraints separately.  The low-rank constraints are
+  // never formed; they are applied through their factors.
+  const std::vector<arma::mat>& lowRankA = sdp.LowRankA();
+  const size_t numLinear = sdp.NumSparseConstraints() +
+      sdp.NumDenseConstraints();
 
   arma::sp_mat Asparse(sdp.NumSparseConstraints(), n2bar);
   arma::sp_vec Aisparse;
@@ -283,24 +641,61 @@ PrimalDualSolver<SDPType>::Optimize(arma::mat& X,
   X = initialX;
   ysparse = initialYsparse;
   ydense = initialYdense;
+  ylowrank = initialYlowRank;
   Z = initialZ;
 
-  arma::vec sx, sz, dysparse, dydense, dsx, dsz;
-  arma::mat dX, dZ;
+  arma::vec sx, sz, dysparse, dydense, dylowrank, dsx, dsz, lowRankAX,
+      sLowRankSum;
+  arma::mat dX, dZ, lowRankSum;
 
   math::Svec(X, sx);
   math::Svec(Z, sz);
 
-  arma::vec rp, rd, rc, gk;
+  arma::vec rp, rd, rc;
 
-  arma::mat Rc, F, Einv_F_AsparseT, Einv_F_AdenseT, Gk,
-            M, DualCheck;
+  arma::mat Rc, M, ML, MU, MP, Zvec, ZinvLambdaSum, XLinv, ZLinv, XZ,
+            DualCheck;
+  arma::vec Zval, precond;
 
   rp.set_size(sdp.NumConstraints());
 
-  Einv_F_AsparseT.set_size(n2bar, sdp.NumSparseConstraints());
-  Einv_F_AdenseT.set_size(n2bar, sdp.NumDenseConstraints());
-  M.set_size(sdp.NumConstraints(), sdp.NumConstraints());
+  // The Schur complement is only formed for the direct solve.
+  if (!iterativeSchur)
+    M.set_size(sdp.NumConstraints(), sdp.NumConstraints());
+
+  schurIterations = 0;
+  const size_t actualMaxSchurIterations = (maxSchurIterations == 0) ?
+      std::max(sdp.NumConstraints(), (size_t) 1) : maxSchurIterations;
+
+  // Solve the system with the Schur complement, either with the LU
+  // factorization P^T L U of M or with the preconditioned iterative method.
+  auto solveSchur = [&](const arma::vec& rhs, arma::vec& dy) -> bool
+  {
+    if (!iterativeSchur)
+    {
+      arma::vec y;
+      return arma::solve(y, arma::trimatl(ML), MP * rhs) &&
+          arma::solve(dy, arma::trimatu(MU), y);
+    }
+
+    auto applySchur = [&](const arma::vec& v, arma::vec& out)
+    {
+      ApplySchurComplement(Asparse, Adense, lowRankA, X, Zvec, ZinvLambdaSum,
+          v, out);
+    };
+
+    bool converged;
+    schurIterations += SolveSchurIterative(applySchur, precond, rhs,
+        schurTolerance, actualMaxSchurIterations, dy, converged);
+    if (!converged)
+    {
+      Info << "PrimalDualSolver::Optimize(): the iterative Schur complement "
+          << "solve did not reach the tolerance " << schurTolerance << " in "
+          << actualMaxSchurIterations << " iterations." << std::endl;
+    }
+
+    return dy.is_finite();
+  };
 
   double primalObj = 0., alpha, beta;
   for (size_t iteration = 1; iteration != maxIterations; iteration++)
@@ -316,94 +711,126 @@ PrimalDualSolver<SDPType>::Optimize(arma::mat& X,
       rp(arma::span(0, sdp.NumSparseConstraints() - 1)) =
         sdp.SparseB() - Asparse * sx;
     if (sdp.NumDenseConstraints())
-      rp(arma::span(sdp.NumSparseConstraints(), sdp.NumConstraints() - 1)) =
+      rp(arma::span(sdp.NumSparseConstraints(), numLinear - 1)) =
           sdp.DenseB() - Adense * sx;
+    if (sdp.NumLowRankConstraints())
+    {
+      LowRankProduct(lowRankA, X, lowRankAX);
+      rp(arma::span(numLinear, sdp.NumConstraints() - 1)) =
+          sdp.LowRankB() - lowRankAX;
+    }
 
     // Rd = C - Z - smat A^T y
     rd = sc - sz - Asparse.t() * ysparse - Adense.t() * ydense;
+    if (sdp.NumLowRankConstraints())
+    {
+      LowRankAdjoint(lowRankA, ylowrank, n, lowRankSum);
+      math::Svec(lowRankSum, sLowRankSum);
+      rd -= sLowRankSum;
+    }
 
-    math::SymKronId(X, F);
-
-    // We compute E^(-1) F A^T by solving Lyapunov equations.
-    // See (2.16).
-    for (size_t i = 0; i < sdp.NumSparseConstraints(); i++)
+    // The factorizations of X and Z are shared by all the Lyapunov equations
+    // and by the step lengths of the predictor and the corrector steps.  The
+    // eigendecomposition Z = Q diag(lambda) Q^T also gives the factor
+    // diag(lambda)^(-1/2) Q^T for the step length in Z.
+    if (!InverseCholeskyFactor(X, XLinv))
     {
-      SolveLyapunov(Gk, Z, X * sdp.SparseA()[i] + sdp.SparseA()[i] * X);
-      math::Svec(Gk, gk);
-      Einv_F_AsparseT.col(i) = gk;
+      Warn << "PrimalDualSolver::Optimize(): cholesky decomposition of X "
+          << "failed!  Terminating optimization.";
+      return primalObj;
     }
 
-    for (size_t i = 0; i < sdp.NumDenseConstraints(); i++)
+    if (!LyapunovFactor(Z, Zvec, Zval, ZinvLambdaSum))
     {
-      SolveLyapunov(Gk, Z, X * sdp.DenseA()[i] + sdp.DenseA()[i] * X);
-      math::Svec(Gk, gk);
-      Einv_F_AdenseT.col(i) = gk;
+      Warn << "PrimalDualSolver::Optimize(): eigendecomposition of Z "
+          << "failed!  Terminating optimization.";
+      return primalObj;
     }
+    ZLinv = arma::diagmat(1. / arma::sqrt(Zval)) * Zvec.t();
 
-    // Form the M = A E^(-1) F A^T matrix (2.15)
-    //
-    // Since we split A up into its sparse and dense components,
-    // we have to handle each block separately.
-    if (sdp.NumSparseConstraints())
+    if (iterativeSchur)
     {
-      M.submat(arma::span(0, sdp.NumSparseConstraints() - 1),
-               arma::span(0, sdp.NumSparseConstraints() - 1)) =
-          Asparse * Einv_F_AsparseT;
-      if (sdp.NumDenseConstraints())
-      {
-        M.submat(arma::span(0, sdp.NumSparseConstraints() - 1),
-                 arma::span(sdp.NumSparseConstraints(),
-                            sdp.NumConstraints() - 1)) =
-            Asparse * Einv_F_AdenseT;
-      }
+      // The Schur complement is applied without forming it; only its
+      // (approximate) diagonal is needed, for the preconditioner.  Z^(-1) is
+      // ZLinv^T ZLinv.
+      SchurPreconditioner(sdp, X, ZLinv.t() * ZLinv, precond);
     }
-    if (sdp.NumDenseConstraints())
+    else
     {
-      if (sdp.NumSparseConstraints())
+      // Form the M = A E^(-1) F A^T matrix (2.15) one column at a time: column
+      // j is A svec(G_j), where G_j solves the Lyapunov equation (2.16) for
+      // constraint j.  The product with the sparse constraints only touches
+      // their nonzeros, and the sparse constraint matrices are multiplied with
+      // X directly.  The columns are independent, so they are computed in
+      // parallel.  (M is not symmetric for the XZ+ZX direction, so all of the
+      // columns are needed.)
+      const size_t numConstraints = sdp.NumConstraints();
+      #ifdef ENS_USE_OPENMP
+        #pragma omp parallel for schedule(dynamic)
+      #endif
+      for (size_t j = 0; j < numConstraints; j++)
+      {
+        arma::mat Gk;
+        arma::vec gk;
+        if (j < sdp.NumSparseConstraints())
+        {
+          const arma::sp_mat& Aj = sdp.SparseA()[j];
+          const arma::mat XAj = X * Aj;
+          SolveLyapunov(Gk, Zvec, ZinvLambdaSum, XAj + XAj.t());
+        }
+        else if (j < numLinear)
+        {
+          const arma::mat& Aj = sdp.DenseA()[j - sdp.NumSparseConstraints()];
+          SolveLyapunov(Gk, Zvec, ZinvLambdaSum, X * Aj + Aj * X);
+        }
+        else
+        {
+          // X A_j = (X V_j) V_j^T, which takes O(n^2 k) time.
+          const arma::mat& Vj = lowRankA[j - numLinear];
+          const arma::mat XAj = (X * Vj) * Vj.t();
+          SolveLyapunov(Gk, Zvec, ZinvLambdaSum, XAj + XAj.t());
+        }
+        math::Svec(Gk, gk);
+
+        if (sdp.NumSparseConstraints())
+        {
+          M.submat(arma::span(0, sdp.NumSparseConstraints() - 1),
+                   arma::span(j, j)) = Asparse * gk;
+        }
+        if (sdp.NumDenseConstraints())
+        {
+          M.submat(arma::span(sdp.NumSparseConstraints(), numLinear - 1),
+                   arma::span(j, j)) = Adense * gk;
+        }
+        for (size_t i = 0; i < sdp.NumLowRankConstraints(); i++)
+          M(numLinear + i, j) = arma::accu(lowRankA[i] % (Gk * lowRankA[i]));
+      }
+
+      // M is not symmetric for the XZ+ZX direction, so it is factorized with
+      // LU; the factorization serves both KKT solves below.
+      if (!arma::lu(ML, MU, MP, M))
       {
-        M.submat(arma::span(sdp.NumSparseConstraints(),
-                            sdp.NumConstraints() - 1),
-                 arma::span(0,
-                            sdp.NumSparseConstraints() - 1)) =
-            Adense * Einv_F_AsparseT;
+        throw std::logic_error("PrimalDualSolver::Optimize(): Could not "
+            "factorize the Schur complement.");
       }
-      M.submat(arma::span(sdp.NumSparseConstraints(),
-                          sdp.NumConstraints() - 1),
-               arma::span(sdp.NumSparseConstraints(),
-                          sdp.NumConstraints() - 1)) =
-          Adense * Einv_F_AdenseT;
     }
 
     const double sxdotsz = arma::dot(sx, sz);
 
-    // TODO(stephentu): computing these alphahats should take advantage of
-    // the cholesky decomposition of X and Z which we should have available
-    // when we use more efficient methods above.
+    // X and Z are symmetric, so ZX = (XZ)^T.
+    XZ = X * Z;
 
     // This solves step (1) of Section 7, the "predictor" step.
-    Rc = -0.5*(X*Z + Z*X);
+    Rc = -0.5*(XZ + XZ.t());
     math::Svec(Rc, rc);
-    SolveKKTSystem(Asparse, Adense, Z, M, F, rp, rd, rc, dsx, dysparse, dydense,
-        dsz);
+    SolveKKTSystem(Asparse, Adense, lowRankA, X, Zvec, ZinvLambdaSum,
+        solveSchur, rp, rd, rc, dsx, dysparse, dydense, dylowrank, dsz);
     math::Smat(dsx, dX);
     math::Smat(dsz, dZ);
 
     // Step (2), determine step size lengths (alpha, beta)
-    bool success = Alpha(X, dX, tau, alpha);
-    if (!success)
-    {
-      Warn << "PrimalDualSolver::Optimize(): cholesky decomposition of X "
-          << "failed!  Terminating optimization.";
-      return primalObj;
-    }
-
-    success = Alpha(Z, dZ, tau, beta);
-    if (!success)
-    {
-      Warn << "PrimalDualSolver::Optimize(): cholesky decomposition of Z "
-          << "failed!  Terminating optimization.";
-      return primalObj;
-    }
+    Alpha(XLinv, dX, tau, alpha);
+    Alpha(ZLinv, dZ, tau, beta);
 
     // See (7.1)
     const double sigma =
@@ -411,30 +838,22 @@ PrimalDualSolver<SDPType>::Optimize(arma::mat& X,
     const double mu = sigma * sxdotsz / n;
 
     // Step (3), the "corrector" step.
-    Rc = mu*arma::eye<arma::mat>(n, n) - 0.5*(X*Z + Z*X + dX*dZ + dZ*dX);
+    const arma::mat dXdZ = dX * dZ;
+    Rc = mu*arma::eye<arma::mat>(n, n) - 0.5*(XZ + XZ.t() + dXdZ + dXdZ.t());
     math::Svec(Rc, rc);
-    SolveKKTSystem(Asparse, Adense, Z, M, F, rp, rd, rc, dsx, dysparse, dydense,
-        dsz);
+    SolveKKTSystem(Asparse, Adense, lowRankA, X, Zvec, ZinvLambdaSum,
+        solveSchur, rp, rd, rc, dsx, dysparse, dydense, dylowrank, dsz);
     math::Smat(dsx, dX);
     math::Smat(dsz, dZ);
-    if (!Alpha(X, dX, tau, alpha))
-    {
-      Warn << "PrimalDualSolver::Optimize(): cholesky decomposition of Z "
-          << "failed!  Terminating optimization.";
-      return primalObj;
-    }
-    if (!Alpha(Z, dZ, tau, beta))
-    {
-      Warn << "PrimalDualSolver::Optimize(): cholesky decomposition of Z "
-          << "failed!  Terminating optimization.";
-      return primalObj;
-    }
+    Alpha(XLinv, dX, tau, alpha);
+    Alpha(ZLinv, dZ, tau, beta);
 
     // Iterate update
     X += alpha * dX;
     math::Svec(X, sx);
     ysparse += beta * dysparse;
     ydense += beta * dydense;
+    ylowrank += beta * dylowrank;
     Z += beta * dZ;
     math::Svec(Z, sz);
 
@@ -453,8 +872,12 @@ PrimalDualSolver<SDPType>::Optimize(arma::mat& X,
     const double sparsePrimalInfeas = arma::norm(sdp.SparseB() - Asparse * sx,
         2);
     const double densePrimalInfeas = arma::norm(sdp.DenseB() - Adense * sx, 2);
+    LowRankProduct(lowRankA, X, lowRankAX);
+    const double lowRankPrimalInfeas = arma::norm(sdp.LowRankB() - lowRankAX,
+        2);
     const double primalInfeas = sqrt(sparsePrimalInfeas * sparsePrimalInfeas +
-        densePrimalInfeas * densePrimalInfeas);
+        densePrimalInfeas * densePrimalInfeas +
+        lowRankPrimalInfeas * lowRankPrimalInfeas);
 
     primalObj = arma::dot(sdp.C(), X);
 
@@ -471,6 +894,11 @@ PrimalDualSolver<SDPType>::Optimize(arma::mat& X,
       DualCheck += ysparse(i) * sdp.SparseA()[i];
     for (size_t i = 0; i < sdp.NumDenseConstraints(); i++)
       DualCheck += ydense(i) * sdp.DenseA()[i];
+    if (sdp.NumLowRankConstraints())
+    {
+      LowRankAdjoint(lowRankA, ylowrank, n, lowRankSum);
+      DualCheck += lowRankSum;
+    }
     const double dualInfeas = arma::norm(DualCheck, "fro");
 
     if (normXZ <= normXzTol && primalInfeas <= primalInfeasTol &&
@@ -20,11 +20,17 @@ namespace ens {
  *     s.t.   dot(Ai, X) = bi, i=1,...,m, X >= 0
  *
  * This representation allows the constraint matrices Ai to be specified as
- * either dense matrices (arma::mat) or sparse matrices (arma::sp_mat).  After
- * initializing the SDP object, you will need to set the constraints yourself,
- * via the SparseA(), SparseB(), DenseA(), DenseB(), and C() functions.  Note
- * that for each matrix you add to either SparseA() or DenseA(), you must add
- * the corresponding b value to the corresponding vector SparseB() or DenseB().
+ * either dense matrices (arma::mat), sparse matrices (arma::sp_mat), or
+ * low-rank factors: a low-rank constraint is given by an n x k matrix Vi, with
+ * Ai = Vi * Vi^T, so that it needs O(nk) memory instead of O(n^2) and
+ * dot(Ai, R * R^T) = ||R^T * Vi||^2 can be computed in O(nkr) time for an
+ * n x r matrix R.  After initializing the SDP object, you will need to set the
+ * constraints yourself, via the SparseA(), SparseB(), DenseA(), DenseB(),
+ * LowRankA(), LowRankB(), and C() functions.  Note that for each matrix you
+ * add to SparseA(), DenseA() or LowRankA(), you must add the corresponding b
+ * value to the corresponding vector SparseB(), DenseB() or LowRankB().  The
+ * constraints are numbered with the sparse constraints first, then the dense
+ * constraints, then the low-rank constraints.
  *
  * The objective matrix (C) may be stored as either dense or sparse depending on
  * the ObjectiveMatrixType parameter.
@@ -57,10 +63,13 @@ class SDP
    * @param n Number of rows (and columns) in the objective matrix C.
    * @param numSparseConstraints Number of sparse constraints.
    * @param numDenseConstraints Number of dense constraints.
+   * @param numLowRankConstraints Number of low-rank constraints; their factors
+   *     are initialized as n x 0 matrices.
    */
   SDP(const size_t n,
       const size_t numSparseConstraints,
-      const size_t numDenseConstraints);
+      const size_t numDenseConstraints,
+      const size_t numLowRankConstraints = 0);
 
   //! Return number of rows and columns in the objective matrix C.
   size_t N() const { return c.n_rows; }
@@ -73,9 +82,15 @@ class SDP
   //! Return the number of dense constraints (constraints with dense Ai) in the
   //! SDP.
   size_t NumDenseConstraints() const { return denseB.n_elem; }
+  //! Return the number of low-rank constraints (constraints with Ai = Vi Vi^T)
+  //! in the SDP.
+  size_t NumLowRankConstraints() const { return lowRankB.n_elem; }
 
   //! Return the total number of constraints in the SDP.
-  size_t NumConstraints() const { return sparseB.n_elem + denseB.n_elem; }
+  size_t NumConstraints() const
+  {
+    return sparseB.n_elem + denseB.n_elem + lowRankB.n_elem;
+  }
 
   //! Modify the sparse objective function matrix (sparseC).
   ObjectiveMatrixType& C() { return c; }
@@ -108,6 +123,18 @@ class SDP
   //! Modify the vector of dense B values.
   arma::vec& DenseB() { return denseB; }
 
+  //! Return the vector of factors Vi of the low-rank constraints, with
+  //! Ai = Vi * Vi^T.
+  const std::vector<arma::mat>& LowRankA() const { return lowRankA; }
+  //! Modify the vector of factors Vi of the low-rank constraints, with
+  //! Ai = Vi * Vi^T.
+  std::vector<arma::mat>& LowRankA() { return lowRankA; }
+
+  //! Return the vector of low-rank B values.
+  const arma::vec& LowRankB() const { return lowRankB; }
+  //! Modify the vector of low-rank B values.
+  arma::vec& LowRankB() { return lowRankB; }
+
   /**
    * Check whether or not the constraint matrices are linearly independent.
    *
@@ -128,6 +155,11 @@ class SDP
   std::vector<arma::mat> denseA;
   //! b_i for each dense constraint.
   arma::vec denseB;
+
+  //! The factor V_i of A_i = V_i V_i^T for each low-rank constraint.
+  std::vector<arma::mat> lowRankA;
+  //! b_i for each low-rank constraint.
+  arma::vec lowRankB;
 };
 
 } // namespace ens
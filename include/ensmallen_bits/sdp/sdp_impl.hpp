@@ -22,23 +22,30 @@ SDP<ObjectiveMatrixType>::SDP() :
     sparseA(),
     sparseB(),
     denseA(),
-    denseB()
+    denseB(),
+    lowRankA(),
+    lowRankB()
 { /* Nothing to do. */ }
 
 template <typename ObjectiveMatrixType>
 SDP<ObjectiveMatrixType>::SDP(const size_t n,
                               const size_t numSparseConstraints,
-                              const size_t numDenseConstraints) :
+                              const size_t numDenseConstraints,
+                              const size_t numLowRankConstraints) :
     c(n, n),
     sparseA(numSparseConstraints),
     sparseB(numSparseConstraints),
     denseA(numDenseConstraints),
-    denseB(numDenseConstraints)
+    denseB(numDenseConstraints),
+    lowRankA(numLowRankConstraints),
+    lowRankB(numLowRankConstraints)
 {
   for (size_t i = 0; i < numSparseConstraints; i++)
     sparseA[i].zeros(n, n);
   for (size_t i = 0; i < numDenseConstraints; i++)
     denseA[i].zeros(n, n);
+  for (size_t i = 0; i < numLowRankConstraints; i++)
+    lowRankA[i].zeros(n, 0);
 }
 
 template <typename ObjectiveMatrixType>
@@ -63,6 +70,12 @@ bool SDP<ObjectiveMatrixType>::HasLinearlyIndependentConstraints() const
     math::Svec(DenseA()[i], sa);
     A.row(NumSparseConstraints() + i) = sa.t();
   }
+  for (size_t i = 0; i < NumLowRankConstraints(); i++)
+  {
+    arma::vec sa;
+    math::Svec(arma::mat(LowRankA()[i] * LowRankA()[i].t()), sa);
+    A.row(NumSparseConstraints() + NumDenseConstraints() + i) = sa.t();
+  }
 
   const arma::vec s = arma::svd(A);
   return s(s.n_elem - 1) > 1e-5;
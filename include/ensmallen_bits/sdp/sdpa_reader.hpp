@@ -0,0 +1,60 @@
+/**
+ * @file sdpa_reader.hpp
+ *
+ * A streaming reader of SDPs in the sparse SDPA format (.dat-s).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SDP_SDPA_READER_HPP
+#define ENSMALLEN_SDP_SDPA_READER_HPP
+
+#include "sdp.hpp"
+
+namespace ens {
+
+/**
+ * Load an SDP in the sparse SDPA format (.dat-s) from the given stream.  The
+ * format describes the dual form of the SDPA primal problem,
+ *
+ *     max    dot(F0, X)
+ *     s.t.   dot(Fi, X) = ci, i=1,...,m, X >= 0
+ *
+ * with block-diagonal matrices Fi, which is loaded as the SDP with C = -F0,
+ * Ai = Fi (as sparse constraints) and bi = ci.  The blocks are laid out one
+ * after the other along the diagonal of the matrices; diagonal blocks (with a
+ * negative size) may only have diagonal entries.
+ *
+ * The file is read in a single pass.  The entries of each matrix are collected
+ * in coordinate form and assembled into compressed sparse column form when the
+ * entries of the next matrix start, so the memory needed beyond the SDP itself
+ * is that of the entries of one matrix (if the entries are grouped by matrix,
+ * as SDPA files usually are; otherwise the parts of a matrix are added).  The
+ * upper or lower triangle of each block can be given, and duplicate entries
+ * are added.  A std::runtime_error is thrown if the stream is not a valid SDPA
+ * file.
+ *
+ * @param stream Stream to read the SDP from.
+ * @param sdp SDP to load into; its previous contents are replaced.
+ */
+template<typename ObjectiveMatrixType>
+void LoadSDPA(std::istream& stream, SDP<ObjectiveMatrixType>& sdp);
+
+/**
+ * Load an SDP in the sparse SDPA format (.dat-s) from the given file.  See
+ * LoadSDPA(std::istream&, SDP&) for details.
+ *
+ * @param filename Name of the file to read the SDP from.
+ * @param sdp SDP to load into; its previous contents are replaced.
+ */
+template<typename ObjectiveMatrixType>
+void LoadSDPA(const std::string& filename, SDP<ObjectiveMatrixType>& sdp);
+
+} // namespace ens
+
+// Include implementation.
+#include "sdpa_reader_impl.hpp"
+
+#endif
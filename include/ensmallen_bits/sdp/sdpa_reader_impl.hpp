@@ -0,0 +1,274 @@
+/**
+ * @file sdpa_reader_impl.hpp
+ *
+ * Implementation of the streaming reader of SDPs in the sparse SDPA format.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SDP_SDPA_READER_IMPL_HPP
+#define ENSMALLEN_SDP_SDPA_READER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "sdpa_reader.hpp"
+
+namespace ens {
+
+namespace private_ {
+
+//! Throw an error about the given line of an SDPA file.
+inline void SDPAError(const size_t lineNumber, const std::string& message)
+{
+  std::ostringstream oss;
+  oss << "LoadSDPA(): line " << lineNumber << ": " << message << "!";
+  throw std::runtime_error(oss.str());
+}
+
+/**
+ * Read numbers from the header of an SDPA file until count of them have been
+ * read.  Comment lines (starting with " or *) and blank lines are skipped, the
+ * separators ,{}() are ignored, and the rest of a line after its first
+ * non-numeric token (such as "= mDIM") is ignored.  If firstOnly is true, only
+ * the first number of each line is read.
+ */
+inline void ReadSDPAHeader(std::istream& stream,
+                           const size_t count,
+                           const bool firstOnly,
+                           const char* what,
+                           std::string& line,
+                           size_t& lineNumber,
+                           std::vector<double>& numbers)
+{
+  numbers.clear();
+  while (numbers.size() < count)
+  {
+    if (!std::getline(stream, line))
+    {
+      SDPAError(lineNumber, std::string("unexpected end of file while "
+          "reading ") + what);
+    }
+    ++lineNumber;
+
+    const size_t start = line.find_first_not_of(" \t\r");
+    if (start == std::string::npos || line[start] == '"' ||
+        line[start] == '*')
+      continue;
+
+    for (size_t i = 0; i < line.size(); ++i)
+    {
+      const char c = line[i];
+      if (c == ',' || c == '{' || c == '}' || c == '(' || c == ')')
+        line[i] = ' ';
+    }
+
+    const char* p = line.c_str();
+    const size_t previous = numbers.size();
+    while (numbers.size() < count)
+    {
+      char* end;
+      const double value = std::strtod(p, &end);
+      if (end == p)
+        break;
+      numbers.push_back(value);
+      p = end;
+      if (firstOnly)
+        break;
+    }
+
+    if (numbers.size() == previous)
+      SDPAError(lineNumber, std::string("expected ") + what);
+  }
+}
+
+//! Return the given header number as an integer, checking that it is one and
+//! that it is at least the given minimum.
+inline long SDPAInteger(const double value,
+                        const long minimum,
+                        const char* what,
+                        const size_t lineNumber)
+{
+  const long integer = (value >= double(minimum) &&
+      value <= double(std::numeric_limits<long>::max())) ? long(value) :
+      minimum - 1;
+  if (double(integer) != value || integer < minimum)
+  {
+    std::ostringstream oss;
+    oss << "invalid " << what << " " << value;
+    SDPAError(lineNumber, oss.str());
+  }
+
+  return integer;
+}
+
+/**
+ * Assemble the collected coordinate-form entries (whose locations are stored
+ * as interleaved row and column pairs) of an n x n matrix, add them to the
+ * given matrix, and clear them.  The buffers keep their capacity, for the
+ * entries of the next matrix.
+ */
+inline void FlushSDPAEntries(std::vector<arma::uword>& locations,
+                             std::vector<double>& values,
+                             const size_t n,
+                             arma::sp_mat& matrix)
+{
+  if (values.empty())
+    return;
+
+  // The batch constructor sorts the entries into compressed sparse column
+  // form and adds duplicates; the buffers are used without copies.
+  const arma::umat locationMatrix(locations.data(), 2, values.size(), false,
+      true);
+  const arma::vec valueVector(values.data(), values.size(), false, true);
+  arma::sp_mat part(true, locationMatrix, valueVector, n, n);
+  if (matrix.n_nonzero == 0)
+    matrix = std::move(part);
+  else
+    matrix += part;
+
+  locations.clear();
+  values.clear();
+}
+
+} // namespace private_
+
+template<typename ObjectiveMatrixType>
+void LoadSDPA(std::istream& stream, SDP<ObjectiveMatrixType>& sdp)
+{
+  std::string line;
+  size_t lineNumber = 0;
+  std::vector<double> numbers;
+
+  // The header: the number of constraints, the number of blocks, the sizes of
+  // the blocks, and the right-hand sides of the constraints.
+  private_::ReadSDPAHeader(stream, 1, true, "the number of constraints", line,
+      lineNumber, numbers);
+  const size_t m = private_::SDPAInteger(numbers[0], 0,
+      "number of constraints", lineNumber);
+  private_::ReadSDPAHeader(stream, 1, true, "the number of blocks", line,
+      lineNumber, numbers);
+  const size_t numBlocks = private_::SDPAInteger(numbers[0], 1,
+      "number of blocks", lineNumber);
+
+  private_::ReadSDPAHeader(stream, numBlocks, false, "the block sizes", line,
+      lineNumber, numbers);
+  std::vector<size_t> blockOffsets(numBlocks), blockSizes(numBlocks);
+  std::vector<bool> diagonalBlocks(numBlocks);
+  size_t n = 0;
+  for (size_t b = 0; b < numBlocks; ++b)
+  {
+    const long size = private_::SDPAInteger(numbers[b],
+        -std::numeric_limits<long>::max(), "block size", lineNumber);
+    if (size == 0)
+      private_::SDPAError(lineNumber, "invalid block size 0");
+
+    blockOffsets[b] = n;
+    blockSizes[b] = (size_t) std::labs(size);
+    diagonalBlocks[b] = (size < 0);
+    n += blockSizes[b];
+  }
+
+  private_::ReadSDPAHeader(stream, m, false, "the constraint values", line,
+      lineNumber, numbers);
+
+  sdp = SDP<ObjectiveMatrixType>(n, m, 0);
+  for (size_t i = 0; i < m; ++i)
+    sdp.SparseB()[i] = numbers[i];
+
+  // The entries, one per line: matrix, block, row, column and value (with
+  // 1-based indices, and matrix 0 being F0).
+  arma::sp_mat objective(n, n);
+  std::vector<arma::uword> locations;
+  std::vector<double> values;
+  long currentMatrix = -1;
+  while (std::getline(stream, line))
+  {
+    ++lineNumber;
+    const char* p = line.c_str();
+    char* end;
+
+    long indices[4];
+    size_t k = 0;
+    for (; k < 4; ++k, p = end)
+    {
+      indices[k] = std::strtol(p, &end, 10);
+      if (end == p)
+        break;
+    }
+
+    if (k == 0 && line.find_first_not_of(" \t\r") == std::string::npos)
+      continue;
+
+    const double value = (k == 4) ? std::strtod(p, &end) : 0.0;
+    if (k < 4 || end == p)
+      private_::SDPAError(lineNumber, "expected 'matrix block row column "
+          "value'");
+
+    const long matrix = indices[0];
+    const long block = indices[1];
+    if (matrix < 0 || matrix > (long) m)
+      private_::SDPAError(lineNumber, "invalid matrix number");
+    if (block < 1 || block > (long) numBlocks)
+      private_::SDPAError(lineNumber, "invalid block number");
+
+    const size_t b = block - 1;
+    if (indices[2] < 1 || indices[2] > (long) blockSizes[b] ||
+        indices[3] < 1 || indices[3] > (long) blockSizes[b])
+      private_::SDPAError(lineNumber, "row or column is outside the block");
+    if (diagonalBlocks[b] && indices[2] != indices[3])
+      private_::SDPAError(lineNumber, "off-diagonal entry in a diagonal block");
+
+    if (matrix != currentMatrix)
+    {
+      if (currentMatrix >= 0)
+      {
+        private_::FlushSDPAEntries(locations, values, n, (currentMatrix == 0) ?
+            objective : sdp.SparseA()[currentMatrix - 1]);
+      }
+      currentMatrix = matrix;
+    }
+
+    // The objective is negated, since the SDPA problem is a maximization.
+    const arma::uword row = blockOffsets[b] + indices[2] - 1;
+    const arma::uword col = blockOffsets[b] + indices[3] - 1;
+    const double entry = (matrix == 0) ? -value : value;
+    locations.push_back(row);
+    locations.push_back(col);
+    values.push_back(entry);
+    if (row != col)
+    {
+      locations.push_back(col);
+      locations.push_back(row);
+      values.push_back(entry);
+    }
+  }
+
+  if (stream.bad())
+    private_::SDPAError(lineNumber, "error reading the stream");
+
+  if (currentMatrix >= 0)
+  {
+    private_::FlushSDPAEntries(locations, values, n, (currentMatrix == 0) ?
+        objective : sdp.SparseA()[currentMatrix - 1]);
+  }
+
+  sdp.C() = objective;
+}
+
+template<typename ObjectiveMatrixType>
+void LoadSDPA(const std::string& filename, SDP<ObjectiveMatrixType>& sdp)
+{
+  std::ifstream stream(filename.c_str());
+  if (!stream.is_open())
+  {
+    throw std::runtime_error("LoadSDPA(): cannot open file '" + filename +
+        "'!");
+  }
+
+  LoadSDPA(stream, sdp);
+}
+
+} // namespace ens
+
+#endif
@@ -19,6 +19,15 @@ namespace ens {
 
 /**
  * Definition of the NoDecay class. Use this as a template for your own.
+ *
+ * A decay policy may also implement
+ *
+ * @code
+ * void ObserveObjective(const double objective, const size_t batchSize);
+ * @endcode
+ *
+ * which SGD calls before each Update() with the objective of the batch (see
+ * CyclicalDecay).
  */
 class NoDecay
 {
@@ -35,9 +44,10 @@ class NoDecay
   * @param stepSize Step size to be used for the given iteration.
   * @param gradient The gradient matrix.
   */
-  void Update(arma::mat& /* iterate */,
+  template<typename MatType, typename GradType>
+  void Update(MatType& /* iterate */,
               double& /* stepSize */,
-              const arma::mat& /* gradient */)
+              const GradType& /* gradient */)
   {
     // Nothing to do here.
   }
@@ -51,15 +61,23 @@ class NoDecay
    * @param fullGradient The computed full gradient.
    * @param stepSize Step size to be used for the given iteration.
    */
-  void Update(const arma::mat& /* iterate */,
-              const arma::mat& /*iterate0 */,
-              const arma::mat& /* gradient */,
-              const arma::mat& /* fullGradient */,
+  template<typename MatType, typename GradType>
+  void Update(const MatType& /* iterate */,
+              const MatType& /*iterate0 */,
+              const GradType& /* gradient */,
+              const GradType& /* fullGradient */,
               const size_t /* numBatches */,
               double& /* stepSize */)
   {
     // Nothing to do here.
   }
+
+  /**
+   * Save or load the state of the decay policy (there is none).
+   *
+   * @param ar Archive to save into or load from.
+   */
+  void Serialize(BinaryArchive& /* ar */) { }
 };
 
 } // namespace ens
@@ -0,0 +1,155 @@
+/**
+ * @file multi_sgd.hpp
+ *
+ * Stochastic gradient descent on several models in lockstep, sharing each
+ * pass over the data.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_MULTI_SGD_HPP
+#define ENSMALLEN_SGD_MULTI_SGD_HPP
+
+#include "update_policies/vanilla_update.hpp"
+
+namespace ens {
+
+/**
+ * MultiSGD trains K models of the same shape on the same separable function
+ * at once, for instance to sweep the step size or the parameters of the update
+ * policy.  Each model has its own iterate (a slice of a cube), step size and
+ * update policy (with its own state), and the models visit the same batches in
+ * the same order: for each batch, the objectives and the gradients of all the
+ * models are computed together with MultiBatchEvaluateWithGradient(), while
+ * the data of the batch is in cache, and then each model takes its step.  So
+ * the data is streamed once for all K models, instead of once per model.
+ *
+ * With shuffle = false, model k takes the same steps as
+ * SGD<UpdatePolicyType> with stepSizes[k] and updatePolicies[k] would.  Each
+ * model stops on its own at the end of an epoch, when its objective changes
+ * by less than the tolerance or is not finite; the stopped models are no
+ * longer updated (their gradients are still computed by the shared
+ * evaluations), and the optimization ends when all of them have stopped or the
+ * maximum number of iterations is reached.  No callbacks are taken.
+ *
+ * MultiSGD can optimize differentiable separable functions; they may
+ * implement MultiEvaluateWithGradient() (see the documentation on function
+ * types) to compute all the models in one pass over the batch.
+ *
+ * @tparam UpdatePolicyType Update policy of the models.
+ */
+template<typename UpdatePolicyType = VanillaUpdate>
+class MultiSGD
+{
+ public:
+  /**
+   * Construct the MultiSGD optimizer, with one model per step size.  The
+   * defaults here are not necessarily good for the given problem, so it is
+   * suggested that the values used be tailored to the task at hand.
+   *
+   * @param stepSizes Step size of each model.
+   * @param batchSize Batch size to use for each step.
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *     limit).
+   * @param tolerance Maximum absolute tolerance to terminate each model.
+   * @param shuffle If true, the function order is shuffled (the same for all
+   *     the models); otherwise, each function is visited in linear order.
+   * @param updatePolicies Update policy of each model (if empty, every model
+   *     uses a default-constructed policy).
+   */
+  MultiSGD(const arma::vec& stepSizes = arma::vec({ 0.01 }),
+           const size_t batchSize = 32,
+           const size_t maxIterations = 100000,
+           const double tolerance = 1e-5,
+           const bool shuffle = true,
+           const std::vector<UpdatePolicyType>& updatePolicies =
+               std::vector<UpdatePolicyType>());
+
+  /**
+   * Optimize the given function for every model.  Slice k of the given cube is
+   * the starting point of model k, and will be modified to store its finishing
+   * point; the final objective of each model (that of its last epoch) is
+   * returned.
+   *
+   * @tparam SeparableFunctionType Type of the function to optimize.
+   * @tparam ElemType Type of the elements of the iterates.
+   * @param function Function to optimize.
+   * @param iterates Starting points of the models (will be modified).
+   * @return Objective value of the final point of each model.
+   */
+  template<typename SeparableFunctionType, typename ElemType>
+  arma::Col<ElemType> Optimize(SeparableFunctionType& function,
+                               arma::Cube<ElemType>& iterates);
+
+  //! Get the number of models.
+  size_t NumModels() const { return stepSizes.n_elem; }
+
+  //! Get the step size of each model.
+  const arma::vec& StepSizes() const { return stepSizes; }
+  //! Modify the step size of each model.
+  arma::vec& StepSizes() { return stepSizes; }
+
+  //! Get the batch size.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the individual functions are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the individual functions are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+  //! Get the update policy of each model (empty if they use the default one).
+  const std::vector<UpdatePolicyType>& UpdatePolicies() const
+  {
+    return updatePolicies;
+  }
+  //! Modify the update policy of each model (empty if they use the default
+  //! one).
+  std::vector<UpdatePolicyType>& UpdatePolicies() { return updatePolicies; }
+
+  //! Get whether each model of the last optimization stopped within the
+  //! tolerance (rather than at the maximum number of iterations, or diverged).
+  const std::vector<bool>& Converged() const { return converged; }
+
+ private:
+  //! The step size of each model.
+  arma::vec stepSizes;
+
+  //! The batch size for processing.
+  size_t batchSize;
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the individual functions are shuffled.
+  bool shuffle;
+
+  //! The update policy of each model.
+  std::vector<UpdatePolicyType> updatePolicies;
+
+  //! Whether each model of the last optimization converged.
+  std::vector<bool> converged;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "multi_sgd_impl.hpp"
+
+#endif
@@ -0,0 +1,191 @@
+/**
+ * @file multi_sgd_impl.hpp
+ *
+ * Implementation of stochastic gradient descent on several models in
+ * lockstep.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_MULTI_SGD_IMPL_HPP
+#define ENSMALLEN_SGD_MULTI_SGD_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "multi_sgd.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+template<typename UpdatePolicyType>
+MultiSGD<UpdatePolicyType>::MultiSGD(
+    const arma::vec& stepSizes,
+    const size_t batchSize,
+    const size_t maxIterations,
+    const double tolerance,
+    const bool shuffle,
+    const std::vector<UpdatePolicyType>& updatePolicies) :
+    stepSizes(stepSizes),
+    batchSize(batchSize),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    shuffle(shuffle),
+    updatePolicies(updatePolicies)
+{ /* Nothing to do. */ }
+
+template<typename UpdatePolicyType>
+template<typename SeparableFunctionType, typename ElemType>
+arma::Col<ElemType> MultiSGD<UpdatePolicyType>::Optimize(
+    SeparableFunctionType& function,
+    arma::Cube<ElemType>& iterates)
+{
+  typedef arma::Mat<ElemType> MatType;
+  typedef Function<SeparableFunctionType, MatType, MatType> FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  // Make sure that we have the methods that we need.
+  traits::CheckDecomposableFunctionTypeAPI<FullFunctionType, MatType,
+      MatType>();
+  ENS_PROFILE_OPTIMIZE("MultiSGD");
+
+  const size_t numModels = stepSizes.n_elem;
+  if (numModels == 0 || iterates.n_slices != numModels)
+  {
+    std::ostringstream oss;
+    oss << "MultiSGD::Optimize(): given " << iterates.n_slices << " iterates, "
+        << "but " << numModels << " step sizes!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (!updatePolicies.empty() && updatePolicies.size() != numModels)
+  {
+    std::ostringstream oss;
+    oss << "MultiSGD::Optimize(): given " << updatePolicies.size()
+        << " update policies, but " << numModels << " step sizes!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // Each model has its own instantiated update policy.
+  typedef typename UpdatePolicyType::template Policy<MatType, MatType>
+      InstUpdatePolicyType;
+  const UpdatePolicyType defaultPolicy = UpdatePolicyType();
+  std::vector<InstUpdatePolicyType> policies;
+  policies.reserve(numModels);
+  for (size_t k = 0; k < numModels; ++k)
+  {
+    policies.emplace_back(updatePolicies.empty() ? defaultPolicy :
+        updatePolicies[k], iterates.n_rows, iterates.n_cols);
+  }
+
+  const size_t numFunctions = f.NumFunctions();
+  arma::Cube<ElemType> gradients(iterates.n_rows, iterates.n_cols,
+      numModels);
+  arma::Col<ElemType> objectives(numModels);
+  arma::Col<ElemType> overallObjectives(numModels, arma::fill::zeros);
+  arma::Col<ElemType> lastObjectives(numModels);
+  lastObjectives.fill(std::numeric_limits<ElemType>::max());
+  converged.assign(numModels, false);
+  std::vector<bool> active(numModels, true);
+  size_t activeModels = numModels;
+
+  // Now iterate!
+  size_t currentFunction = 0;
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+  for (size_t i = 0; i < actualMaxIterations && activeModels > 0;
+      /* incrementing done manually */)
+  {
+    // Is this iteration the start of a sequence?
+    if ((currentFunction % numFunctions) == 0 && i > 0)
+    {
+      for (size_t k = 0; k < numModels; ++k)
+      {
+        if (!active[k])
+          continue;
+
+        const ElemType objective = overallObjectives[k];
+        if (std::isnan(objective) || std::isinf(objective))
+        {
+          Warn << "MultiSGD: model " << k << " converged to " << objective
+              << "; stopping it.  Try a smaller step size?" << std::endl;
+          active[k] = false;
+        }
+        else if (std::abs(lastObjectives[k] - objective) < tolerance)
+        {
+          Info << "MultiSGD: model " << k << " minimized within tolerance "
+              << tolerance << "." << std::endl;
+          active[k] = false;
+          converged[k] = true;
+        }
+
+        if (!active[k])
+        {
+          --activeModels;
+          continue;
+        }
+
+        lastObjectives[k] = objective;
+        overallObjectives[k] = 0;
+      }
+
+      if (activeModels == 0)
+        break;
+
+      currentFunction = 0;
+      if (shuffle) // Determine order of visitation.
+      {
+        ENS_PROFILE_SCOPE("Shuffle");
+        f.Shuffle();
+      }
+    }
+
+    // Find the effective batch size (see SGD).
+    const size_t effectiveBatchSize = std::min(std::min(batchSize,
+        actualMaxIterations - i), numFunctions - currentFunction);
+
+    // All the models are evaluated on the batch at once.
+    {
+      ENS_PROFILE_SCOPE("EvaluateWithGradient");
+      MultiBatchEvaluateWithGradient(function, iterates, currentFunction,
+          gradients, objectives, effectiveBatchSize);
+    }
+
+    {
+      ENS_PROFILE_SCOPE("UpdatePolicy::Update");
+      for (size_t k = 0; k < numModels; ++k)
+      {
+        if (!active[k])
+          continue;
+
+        overallObjectives[k] += objectives[k];
+        policies[k].Update(iterates.slice(k), stepSizes[k],
+            gradients.slice(k));
+      }
+    }
+
+    i += effectiveBatchSize;
+    currentFunction += effectiveBatchSize;
+  }
+
+  if (activeModels > 0)
+  {
+    Info << "MultiSGD: maximum iterations (" << maxIterations << ") reached; "
+        << "terminating optimization." << std::endl;
+  }
+
+  // The stopped models keep the objective of their last epoch; the objective
+  // of a partial epoch is scaled up to all the functions.
+  for (size_t k = 0; k < numModels; ++k)
+  {
+    if (active[k] && currentFunction > 0 && currentFunction != numFunctions)
+      overallObjectives[k] *= (ElemType) numFunctions / currentFunction;
+  }
+
+  return overallObjectives;
+}
+
+} // namespace ens
+
+#endif
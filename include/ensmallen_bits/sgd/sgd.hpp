@@ -15,10 +15,21 @@
 #ifndef ENSMALLEN_SGD_SGD_HPP
 #define ENSMALLEN_SGD_SGD_HPP
 
+#include <ensmallen_bits/utility/alias_table.hpp>
+#include <ensmallen_bits/utility/any.hpp>
+#include <ensmallen_bits/function/objective_estimate.hpp>
+
 #include "update_policies/vanilla_update.hpp"
 #include "update_policies/momentum_update.hpp"
+#include "update_policies/lazy_momentum_update.hpp"
 #include "update_policies/decoupled_weight_decay_momentum_update.hpp"
 #include "update_policies/nesterov_momentum_update.hpp"
+#include "update_policies/lars_update.hpp"
+#include "update_policies/parallel_update.hpp"
+#include "update_policies/fused_update.hpp"
+#include "update_policies/iterate_averaging.hpp"
+#include "update_policies/lookahead_update.hpp"
+#include "update_policies/block_update.hpp"
 #include "decay_policies/no_decay.hpp"
 
 namespace ens {
@@ -52,6 +63,29 @@ namespace ens {
  * point.  Then, SGD considers the gradient of the objective function operating
  * on an individual point in its update of \f$ A \f$.
  *
+ * Instead of visiting the functions in order, SGD can also sample them with
+ * probabilities proportional to the weights given with SamplingWeights() (for
+ * instance, the Lipschitz constants of the gradients \f$ \nabla f_i \f$).  Each
+ * sampled gradient is then scaled by \f$ 1 / (n p_i) \f$, so that every step is
+ * an unbiased estimate of a step with a uniformly sampled batch, with a
+ * smaller variance when the weights follow the magnitude of the gradients.
+ * Each epoch still takes \f$ n \f$ samples.
+ *
+ * For online training, where new functions are appended to the function
+ * between calls to Optimize(), SGD can train incrementally: it remembers the
+ * number of functions of the last call (SeenFunctions()), and if
+ * Incremental() is set, the epochs of the next call only visit the new
+ * functions, together with ReplayRate() times as many old functions (drawn as
+ * random batches of old functions), so that the model is refreshed without
+ * full passes over the old data.  With ResetPolicy() false, the update policy
+ * keeps its state between the calls.
+ *
+ * With a batch size of at most 4 (as in online learning), the steps of each
+ * epoch are taken in a loop specialized for the batch size, without the
+ * bookkeeping of the generic loop between the steps, unless importance
+ * sampling, incremental training, prefetching, micro-batches or callbacks are
+ * used.  The steps are the same.
+ *
  * SGD can optimize differentiable separable functions.  For more details, see
  * the documentation on function types included with this distribution or on the
  * ensmallen website.
@@ -88,6 +122,8 @@ class SGD
    * @param decayPolicy Instantiated decay policy used to adjust the step size.
    * @param resetPolicy Flag that determines whether update policy parameters
    *                    are reset before every Optimize call.
+   * @param prefetch If true and the function has a PrefetchBatch() method, the
+   *     next batch is prefetched while the update policy takes a step.
    */
   SGD(const double stepSize = 0.01,
       const size_t batchSize = 32,
@@ -96,7 +132,8 @@ class SGD
       const bool shuffle = true,
       const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
       const DecayPolicyType& decayPolicy = DecayPolicyType(),
-      const bool resetPolicy = true);
+      const bool resetPolicy = true,
+      const bool prefetch = false);
 
   /**
    * Optimize the given function using stochastic gradient descent.  The given
@@ -104,13 +141,58 @@ class SGD
    * algorithm, and the final objective value is returned.
    *
    * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to optimize.
    * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
    * @return Objective value of the final point.
    */
-  template<typename DecomposableFunctionType>
-  double Optimize(DecomposableFunctionType& function,
-                  arma::mat& iterate);
+  template<typename DecomposableFunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(DecomposableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks);
+
+  /**
+   * Save or load the state of the optimization: the current step size, the
+   * number of functions seen by the last call (for incremental training), the
+   * state of the decay policy, and the state of the update policy (such as
+   * the moments of Adam) instantiated by the last call to Optimize() with the
+   * given matrix types.  Both policies must have a Serialize() method.  To
+   * resume from a loaded state, ResetPolicy() must be false, so that
+   * Optimize() continues with the loaded update policy.
+   *
+   * @tparam MatType Type of matrix optimized with.
+   * @tparam GradType Type of matrix used to represent function gradients.
+   * @param ar Archive to save into or load from.
+   */
+  template<typename MatType = arma::mat, typename GradType = MatType>
+  void Serialize(BinaryArchive& ar);
+
+  /**
+   * Estimate the number of bytes Optimize() allocates for an iterate of the
+   * given size: the gradient (and a second one for the micro-batches or the
+   * sampled functions) and the state of the update policy, which must have an
+   * EstimateStateBytes() method.  The memory of the iterate, of the function
+   * and of the callbacks is not included.
+   *
+   * @param rows Number of rows of the iterate.
+   * @param cols Number of columns of the iterate.
+   * @param elemSize Size of an element of the iterate.
+   */
+  size_t EstimateMemory(const size_t rows,
+                        const size_t cols = 1,
+                        const size_t elemSize = sizeof(double)) const
+  {
+    const size_t gradients = (microBatchSize > 0 ||
+        !samplingWeights.is_empty()) ? 2 : 1;
+    return gradients * rows * cols * elemSize +
+        updatePolicy.EstimateStateBytes(rows, cols, elemSize);
+  }
 
   //! Get the step size.
   double StepSize() const { return stepSize; }
@@ -144,6 +226,11 @@ class SGD
   //! are reset before Optimize call.
   bool& ResetPolicy() { return resetPolicy; }
 
+  //! Get whether or not the next batch is prefetched during each step.
+  bool Prefetch() const { return prefetch; }
+  //! Modify whether or not the next batch is prefetched during each step.
+  bool& Prefetch() { return prefetch; }
+
   //! Get the update policy.
   const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
   //! Modify the update policy.
@@ -154,7 +241,152 @@ class SGD
   //! Modify the step size decay policy.
   DecayPolicyType& DecayPolicy() { return decayPolicy; }
 
+  /**
+   * Get the weights the functions are sampled with (empty for visiting them
+   * in order, the default).
+   */
+  const arma::vec& SamplingWeights() const { return samplingWeights; }
+  /**
+   * Modify the weights the functions are sampled with.  If not empty, there
+   * must be one non-negative weight per function; each batch is then made of
+   * functions drawn with probabilities proportional to the weights, evaluated
+   * one at a time, and shuffling and prefetching are not used.
+   */
+  arma::vec& SamplingWeights() { return samplingWeights; }
+
+  //! Get the size of the micro-batches each batch is evaluated in (0 for
+  //! evaluating each batch at once, the default).
+  size_t MicroBatchSize() const { return microBatchSize; }
+  /**
+   * Modify the size of the micro-batches each batch is evaluated in.  If
+   * nonzero and smaller than the batch, each batch is evaluated with several
+   * EvaluateWithGradient() calls of at most this many functions, and their
+   * gradients are summed before the update policy takes its step.  The steps
+   * are those of the whole batch, but the function only holds the
+   * intermediates of one micro-batch at a time.
+   */
+  size_t& MicroBatchSize() { return microBatchSize; }
+
+  //! Get whether the epochs only visit the functions added since the last
+  //! call to Optimize(), with replay of the old ones.
+  bool Incremental() const { return incremental; }
+  /**
+   * Modify whether the epochs only visit the functions added since the last
+   * call to Optimize() (the functions from SeenFunctions() on), with replay of
+   * the old ones.  If there are no new functions (or on the first call), all
+   * the functions are visited as usual.  The new batches are shuffled (if
+   * Shuffle() is set) among themselves and with the replayed batches, without
+   * calling the Shuffle() method of the function, which would mix the new and
+   * the old functions; sampling weights take precedence over this mode.
+   */
+  bool& Incremental() { return incremental; }
+
+  //! Get the number of old functions replayed per new function in incremental
+  //! mode.
+  double ReplayRate() const { return replayRate; }
+  //! Modify the number of old functions replayed per new function in
+  //! incremental mode (0 for none).
+  double& ReplayRate() { return replayRate; }
+
+  //! Get the number of functions of the last call to Optimize() (0 before the
+  //! first call).
+  size_t SeenFunctions() const { return seenFunctions; }
+  //! Modify the number of functions considered old in the next call to
+  //! Optimize().
+  size_t& SeenFunctions() { return seenFunctions; }
+
+  //! Get the workspace the temporaries are taken from (NULL if none).
+  ens::Workspace* Workspace() const { return workspace; }
+  //! Modify the workspace the temporaries are taken from (NULL if none).
+  ens::Workspace*& Workspace() { return workspace; }
+
+  //! Get how the final objective is computed.
+  const ens::ObjectiveEstimate& ObjectiveEstimate() const
+  { return objectiveEstimate; }
+  //! Modify how the final objective is computed.
+  ens::ObjectiveEstimate& ObjectiveEstimate() { return objectiveEstimate; }
+
  private:
+  /**
+   * Take the given number of steps with full batches of BatchSize consecutive
+   * functions, starting at function 0, and add their objectives to the given
+   * objective.  This is the inner loop of the epochs with a small batch size,
+   * when the generic loop has nothing to do between the steps: the epoch
+   * bookkeeping is hoisted out, and a function with a per-function
+   * AccumulateEvaluateWithGradient() kernel (and no EvaluateWithGradient()) is
+   * evaluated with it directly.  The steps are those of the generic loop.
+   *
+   * @param function Function to optimize (the Function<> wrapper).
+   * @param iterate Iterate to update.
+   * @param gradient Matrix to store the gradient of each batch in.
+   * @param policy Instantiated update policy.
+   * @param steps Number of steps to take.
+   * @param objective Objective to add the objectives of the batches to.
+   */
+  template<size_t BatchSize,
+           typename FunctionType,
+           typename WrapperType,
+           typename MatType,
+           typename GradType,
+           typename PolicyType>
+  void SmallBatchSteps(WrapperType& function,
+                       MatType& iterate,
+                       GradType& gradient,
+                       PolicyType& policy,
+                       const size_t steps,
+                       typename MatType::elem_type& objective);
+
+  //! Take the steps of SmallBatchSteps() with the batch size of the optimizer
+  //! (which must be at most 4).
+  template<typename FunctionType,
+           typename WrapperType,
+           typename MatType,
+           typename GradType,
+           typename PolicyType>
+  void SmallBatchSteps(WrapperType& function,
+                       MatType& iterate,
+                       GradType& gradient,
+                       PolicyType& policy,
+                       const size_t steps,
+                       typename MatType::elem_type& objective);
+
+  //! Evaluate a small batch with the per-function kernel of the function.
+  template<size_t BatchSize, typename FunctionType, typename WrapperType,
+           typename MatType, typename GradType>
+  static typename MatType::elem_type SmallBatchEvaluateWithGradient(
+      WrapperType& function,
+      const MatType& iterate,
+      const size_t begin,
+      GradType& gradient,
+      std::true_type /* useSampleKernel */);
+
+  //! Evaluate a small batch with the EvaluateWithGradient() of the wrapper.
+  template<size_t BatchSize, typename FunctionType, typename WrapperType,
+           typename MatType, typename GradType>
+  static typename MatType::elem_type SmallBatchEvaluateWithGradient(
+      WrapperType& function,
+      const MatType& iterate,
+      const size_t begin,
+      GradType& gradient,
+      std::false_type /* useSampleKernel */);
+
+  /**
+   * Fill the plan of an epoch of incremental training with the batches (first
+   * function and size) of the new functions, and random batches of old
+   * functions with replayRate times as many functions, shuffled if shuffle is
+   * set.
+   *
+   * @param oldFunctions Number of functions seen by the last call.
+   * @param numFunctions Number of functions.
+   * @param rng Random number generator for the replay.
+   * @param plan Vector to store the batches of the epoch in.
+   * @return The number of functions visited by the epoch.
+   */
+  size_t IncrementalPlan(const size_t oldFunctions,
+                         const size_t numFunctions,
+                         RNG& rng,
+                         std::vector<std::pair<size_t, size_t>>& plan) const;
+
   //! The step size for each example.
   double stepSize;
 
@@ -181,19 +413,49 @@ class SGD
   //! should be reset before running optimization.
   bool resetPolicy;
 
-  //! Flag indicating whether the update policy
-  //! parameters have been initialized.
-  bool isInitialized;
+  //! Whether the next batch is prefetched while the update policy takes a
+  //! step.
+  bool prefetch;
+
+  //! The initialized update policy.  Its type depends on the matrix type
+  //! given to Optimize(), so it is held in an Any object.
+  Any instUpdatePolicy;
+
+  //! The weights the functions are sampled with (empty for visiting them in
+  //! order).
+  arma::vec samplingWeights;
+
+  //! The size of the micro-batches each batch is evaluated in (0 for none).
+  size_t microBatchSize;
+
+  //! Whether the epochs only visit the new functions, with replay.
+  bool incremental;
+
+  //! The number of old functions replayed per new function.
+  double replayRate;
+
+  //! The number of functions of the last call to Optimize().
+  size_t seenFunctions;
+
+  //! The workspace the temporaries are taken from (NULL if none).
+  ens::Workspace* workspace;
+
+  //! How the final objective is computed.
+  ens::ObjectiveEstimate objectiveEstimate;
 };
 
 using StandardSGD = SGD<VanillaUpdate>;
 
 using MomentumSGD = SGD<MomentumUpdate>;
 
+using LazyMomentumSGD = SGD<LazyMomentumUpdate>;
+
 using SGDW = SGD<DecoupledWeightDecayMomentumUpdate>;
 
 using NesterovMomentumSGD = SGD<NesterovMomentumUpdate>;
 
+using LARS = SGD<LARSUpdate>;
+
 } // namespace ens
 
 // Include implementation.
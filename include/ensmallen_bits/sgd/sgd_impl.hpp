@@ -21,6 +21,30 @@
 
 namespace ens {
 
+/**
+ * Give the objective of the current batch to a decay policy with an
+ * ObserveObjective() method, such as CyclicalDecay (which uses it to detect
+ * plateaus).
+ */
+template<typename DecayPolicyType>
+typename std::enable_if<traits::HasObserveObjective<DecayPolicyType,
+    traits::ObserveObjectiveForm>::value>::type
+ObserveObjective(DecayPolicyType& decayPolicy,
+                 const double objective,
+                 const size_t batchSize)
+{
+  decayPolicy.ObserveObjective(objective, batchSize);
+}
+
+//! Other decay policies do not use the objective.
+template<typename DecayPolicyType>
+typename std::enable_if<!traits::HasObserveObjective<DecayPolicyType,
+    traits::ObserveObjectiveForm>::value>::type
+ObserveObjective(DecayPolicyType& /* decayPolicy */,
+                 const double /* objective */,
+                 const size_t /* batchSize */)
+{ }
+
 template<typename UpdatePolicyType, typename DecayPolicyType>
 SGD<UpdatePolicyType, DecayPolicyType>::SGD(
     const double stepSize,
@@ -30,7 +54,8 @@ SGD<UpdatePolicyType, DecayPolicyType>::SGD(
     const bool shuffle,
     const UpdatePolicyType& updatePolicy,
     const DecayPolicyType& decayPolicy,
-    const bool resetPolicy) :
+    const bool resetPolicy,
+    const bool prefetch) :
     stepSize(stepSize),
     batchSize(batchSize),
     maxIterations(maxIterations),
@@ -39,54 +64,144 @@ SGD<UpdatePolicyType, DecayPolicyType>::SGD(
     updatePolicy(updatePolicy),
     decayPolicy(decayPolicy),
     resetPolicy(resetPolicy),
-    isInitialized(false)
+    prefetch(prefetch),
+    microBatchSize(0),
+    incremental(false),
+    replayRate(0.1),
+    seenFunctions(0),
+    workspace(NULL)
 { /* Nothing to do. */ }
 
 //! Optimize the function (minimize).
 template<typename UpdatePolicyType, typename DecayPolicyType>
-template<typename DecomposableFunctionType>
-double SGD<UpdatePolicyType, DecayPolicyType>::Optimize(
+template<typename DecomposableFunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename MatType::elem_type SGD<UpdatePolicyType, DecayPolicyType>::Optimize(
     DecomposableFunctionType& function,
-    arma::mat& iterate)
+    MatType& iterateIn,
+    CallbackTypes&&... callbacks)
 {
-  typedef Function<DecomposableFunctionType> FullFunctionType;
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+  typedef typename UpdatePolicyType::template Policy<BaseMatType, BaseGradType>
+      InstUpdatePolicyType;
+
+  typedef Function<DecomposableFunctionType, BaseMatType, BaseGradType>
+      FullFunctionType;
   FullFunctionType& f(static_cast<FullFunctionType&>(function));
+  ENS_PROFILE_OPTIMIZE("SGD");
 
   // Make sure we have all the methods that we need.
-  traits::CheckDecomposableFunctionTypeAPI<FullFunctionType>();
+  traits::CheckDecomposableFunctionTypeAPI<FullFunctionType, BaseMatType,
+      BaseGradType>();
+
+  // Vectors are optimized as matrices.
+  BaseMatType& iterate = static_cast<BaseMatType&>(iterateIn);
 
   // Find the number of functions to use.
   const size_t numFunctions = f.NumFunctions();
 
   // To keep track of where we are and how things are going.
   size_t currentFunction = 0;
-  double overallObjective = 0;
-  double lastObjective = DBL_MAX;
+  ElemType overallObjective = 0;
+  ElemType lastObjective = std::numeric_limits<ElemType>::max();
 
-  // Initialize the update policy.
-  if (resetPolicy || !isInitialized)
+  // Initialize the update policy.  If the previous call used a different
+  // matrix type, the policy has to be reinitialized anyway.
+  if (resetPolicy || !instUpdatePolicy.Has<InstUpdatePolicyType>())
   {
-    updatePolicy.Initialize(iterate.n_rows, iterate.n_cols);
-    isInitialized = true;
+    instUpdatePolicy.Set(new InstUpdatePolicyType(updatePolicy,
+        iterate.n_rows, iterate.n_cols));
   }
+  InstUpdatePolicyType& instPolicy =
+      instUpdatePolicy.As<InstUpdatePolicyType>();
+
+  // Track the current epoch and whether a callback asked us to stop.
+  size_t epoch = 0;
+  bool terminate = false;
+  terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
+
+  // The temporaries are taken from the given workspace, or else from a local
+  // one.
+  ens::Workspace localWorkspace;
+  ens::Workspace& ws = (workspace != NULL) ? *workspace : localWorkspace;
 
   // Now iterate!
-  arma::mat gradient(iterate.n_rows, iterate.n_cols);
+  BaseGradType& gradient = ws.Get<BaseGradType>(0);
+  gradient.set_size(iterate.n_rows, iterate.n_cols);
   const size_t actualMaxIterations = (maxIterations == 0) ?
       std::numeric_limits<size_t>::max() : maxIterations;
-  for (size_t i = 0; i < actualMaxIterations; /* incrementing done manually */)
+
+  // With importance sampling, the functions are drawn from the alias table of
+  // the weights instead of being visited in order.
+  const bool sampling = !samplingWeights.is_empty();
+  AliasTable samplingTable;
+  RNG rng;
+  if (sampling)
+  {
+    if (samplingWeights.n_elem != numFunctions)
+    {
+      std::ostringstream oss;
+      oss << "SGD::Optimize(): there are " << samplingWeights.n_elem
+          << " sampling weights, but " << numFunctions << " functions!";
+      throw std::invalid_argument(oss.str());
+    }
+
+    samplingTable.Reset(samplingWeights);
+    rng.Seed(RNG::ArmaSeed());
+  }
+
+  // In incremental mode, each epoch visits the batches of the functions added
+  // since the last call, and random batches of the old ones.
+  const size_t oldFunctions = seenFunctions;
+  seenFunctions = numFunctions;
+  const bool incrementalPass = incremental && !sampling && oldFunctions > 0 &&
+      oldFunctions < numFunctions;
+  std::vector<std::pair<size_t, size_t>>& plan =
+      ws.Get<std::vector<std::pair<size_t, size_t>>>(2);
+  size_t epochFunctions = numFunctions;
+  size_t planIndex = 0;
+  if (incrementalPass)
+  {
+    rng.Seed(RNG::ArmaSeed());
+    epochFunctions = IncrementalPlan(oldFunctions, numFunctions, rng, plan);
+  }
+
+  // The next batch can only be prefetched if the function knows how to.
+  const bool pipelined = prefetch && !sampling && !incrementalPass &&
+      traits::HasBatchPrefetch<DecomposableFunctionType>::value;
+  if (pipelined)
+  {
+    PrefetchBatch(function, 0, std::min(std::min(batchSize,
+        actualMaxIterations), numFunctions));
+  }
+  // Small batches are taken in a specialized loop at the start of each epoch,
+  // when nothing has to be done between the steps.
+  const bool smallBatches = (batchSize >= 1 && batchSize <= 4) && !sampling &&
+      !incrementalPass && !pipelined && (microBatchSize == 0 ||
+      microBatchSize >= batchSize) && sizeof...(CallbackTypes) == 0;
+  for (size_t i = 0; i < actualMaxIterations && !terminate;
+      /* incrementing done manually */)
   {
     // Is this iteration the start of a sequence?
-    if ((currentFunction % numFunctions) == 0 && i > 0)
+    if ((currentFunction % epochFunctions) == 0 && i > 0)
     {
       // Output current objective function.
       Info << "SGD: iteration " << i << ", objective " << overallObjective
-         << "." << std::endl;
+         << ".\n";
+
+      terminate |= Callback::EndEpoch(*this, f, iterate, epoch++,
+          overallObjective, callbacks...);
 
       if (std::isnan(overallObjective) || std::isinf(overallObjective))
       {
         Warn << "SGD: converged to " << overallObjective << "; terminating"
             << " with failure.  Try a smaller step size?" << std::endl;
+        Callback::EndOptimization(*this, f, iterate, callbacks...);
         return overallObjective;
       }
 
@@ -94,16 +209,59 @@ double SGD<UpdatePolicyType, DecayPolicyType>::Optimize(
       {
         Info << "SGD: minimized within tolerance " << tolerance << "; "
             << "terminating optimization." << std::endl;
+        Callback::EndOptimization(*this, f, iterate, callbacks...);
         return overallObjective;
       }
 
+      if (terminate)
+      {
+        Info << "SGD: callback requested termination." << std::endl;
+        break;
+      }
+
       // Reset the counter variables.
       lastObjective = overallObjective;
       overallObjective = 0;
       currentFunction = 0;
 
-      if (shuffle) // Determine order of visitation.
+      if (incrementalPass) // Draw the replayed batches of the next epoch.
+      {
+        ENS_PROFILE_SCOPE("Shuffle");
+        IncrementalPlan(oldFunctions, numFunctions, rng, plan);
+        planIndex = 0;
+      }
+      else if (shuffle && !sampling) // Determine order of visitation.
+      {
+        ENS_PROFILE_SCOPE("Shuffle");
         f.Shuffle();
+      }
+
+      // The first batch of the epoch can only be known after the shuffle.
+      if (pipelined)
+      {
+        PrefetchBatch(function, 0, std::min(std::min(batchSize,
+            actualMaxIterations - i), numFunctions));
+      }
+
+      terminate |= Callback::BeginEpoch(*this, f, iterate, epoch,
+          lastObjective, callbacks...);
+    }
+
+    // Take all the full batches of the epoch at once; the last, smaller batch
+    // (if any) is taken by the generic loop.
+    if (smallBatches && currentFunction == 0)
+    {
+      const size_t steps = std::min(numFunctions, actualMaxIterations - i) /
+          batchSize;
+      if (steps > 0)
+      {
+        ENS_PROFILE_SCOPE("SmallBatchSteps");
+        SmallBatchSteps<DecomposableFunctionType>(f, iterate, gradient,
+            instPolicy, steps, overallObjective);
+        i += steps * batchSize;
+        currentFunction += steps * batchSize;
+        continue;
+      }
     }
 
     // Find the effective batch size; we have to take the minimum of three
@@ -112,38 +270,300 @@ double SGD<UpdatePolicyType, DecayPolicyType>::Optimize(
     // - the batch size can't be larger than the number of iterations left
     //       before actualMaxIterations is hit;
     // - the batch size can't be larger than the number of functions left.
-    const size_t effectiveBatchSize = std::min(
-        std::min(batchSize, actualMaxIterations - i),
+    // In incremental mode, the batches come from the plan of the epoch.
+    const size_t begin = incrementalPass ? plan[planIndex].first :
+        currentFunction;
+    const size_t effectiveBatchSize = incrementalPass ?
+        std::min(plan[planIndex++].second, actualMaxIterations - i) :
+        std::min(std::min(batchSize, actualMaxIterations - i),
         numFunctions - currentFunction);
 
     // Technically we are computing the objective before we take the step, but
     // for many FunctionTypes it may be much quicker to do it like this.
-    overallObjective += f.EvaluateWithGradient(iterate, currentFunction,
-        gradient, effectiveBatchSize);
+    ElemType objective;
+    if (sampling)
+    {
+      // Each sampled function is weighted by 1 / (n p_i), which keeps the
+      // objective and the gradient of the batch unbiased.
+      ENS_PROFILE_SCOPE("EvaluateWithGradient");
+      BaseGradType& functionGradient = ws.Get<BaseGradType>(1);
+      objective = 0;
+      gradient.zeros();
+      for (size_t j = 0; j < effectiveBatchSize; ++j)
+      {
+        const size_t sampled = samplingTable.Sample(rng);
+        const ElemType weight = (ElemType) (1.0 / (numFunctions *
+            samplingTable.Probability(sampled)));
+        objective += weight * f.EvaluateWithGradient(iterate, sampled,
+            functionGradient, 1);
+        gradient += weight * functionGradient;
+      }
+    }
+    else if (microBatchSize > 0 && microBatchSize < effectiveBatchSize)
+    {
+      // Accumulate the gradients of the micro-batches of the batch.
+      ENS_PROFILE_SCOPE("EvaluateWithGradient");
+      BaseGradType& microGradient = ws.Get<BaseGradType>(1);
+      objective = 0;
+      gradient.zeros();
+      for (size_t j = 0; j < effectiveBatchSize; j += microBatchSize)
+      {
+        objective += f.EvaluateWithGradient(iterate, begin + j,
+            microGradient, std::min(microBatchSize, effectiveBatchSize - j));
+        gradient += microGradient;
+      }
+    }
+    else
+    {
+      ENS_PROFILE_SCOPE("EvaluateWithGradient");
+      objective = f.EvaluateWithGradient(iterate, begin, gradient,
+          effectiveBatchSize);
+    }
+    overallObjective += objective;
+
+    terminate |= Callback::EvaluateWithGradient(*this, f, iterate, objective,
+        gradient, callbacks...);
 
-    // Use the update policy to take a step.
-    updatePolicy.Update(iterate, stepSize, gradient);
+    // Use the update policy to take a step.  In pipelined mode, the next
+    // batch of this epoch is prefetched by another thread at the same time.
+    const size_t nextFunction = currentFunction + effectiveBatchSize;
+    const size_t nextBatchSize = (nextFunction < numFunctions) ?
+        std::min(std::min(batchSize, actualMaxIterations - i -
+        effectiveBatchSize), numFunctions - nextFunction) : 0;
+    if (pipelined && nextBatchSize > 0)
+    {
+      ENS_PROFILE_SCOPE("UpdatePolicy::Update");
+      #ifdef ENS_USE_OPENMP
+        #pragma omp parallel sections num_threads(2)
+      #endif
+      {
+        #ifdef ENS_USE_OPENMP
+          #pragma omp section
+        #endif
+        instPolicy.Update(iterate, stepSize, gradient);
+
+        #ifdef ENS_USE_OPENMP
+          #pragma omp section
+        #endif
+        PrefetchBatch(function, nextFunction, nextBatchSize);
+      }
+    }
+    else
+    {
+      ENS_PROFILE_SCOPE("UpdatePolicy::Update");
+      instPolicy.Update(iterate, stepSize, gradient);
+    }
+
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
 
     // Now update the learning rate if requested by the user.
-    decayPolicy.Update(iterate, stepSize, gradient);
+    {
+      ENS_PROFILE_SCOPE("DecayPolicy::Update");
+      ObserveObjective(decayPolicy, objective, effectiveBatchSize);
+      decayPolicy.Update(iterate, stepSize, gradient);
+    }
 
     i += effectiveBatchSize;
     currentFunction += effectiveBatchSize;
   }
 
-  Info << "SGD: maximum iterations (" << maxIterations << ") reached; "
-      << "terminating optimization." << std::endl;
+  if (!terminate)
+  {
+    Info << "SGD: maximum iterations (" << maxIterations << ") reached; "
+        << "terminating optimization." << std::endl;
+  }
 
-  // Calculate final objective.
-  overallObjective = 0;
-  for (size_t i = 0; i < numFunctions; i += batchSize)
+  // Calculate final objective.  When reusing the batch objectives of the last
+  // pass, scale them up to all the functions if the pass did not visit each
+  // of them once.
+  if (!objectiveEstimate.IsReuse())
   {
-    const size_t effectiveBatchSize = std::min(batchSize, numFunctions - i);
-    overallObjective += f.Evaluate(iterate, i, effectiveBatchSize);
+    ENS_PROFILE_SCOPE("Evaluate");
+    overallObjective = objectiveEstimate.Evaluate(f, iterate, batchSize);
   }
+  else if (currentFunction > 0 && currentFunction != numFunctions)
+    overallObjective *= (ElemType) numFunctions / currentFunction;
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
   return overallObjective;
 }
 
+template<typename UpdatePolicyType, typename DecayPolicyType>
+template<size_t BatchSize,
+         typename FunctionType,
+         typename WrapperType,
+         typename MatType,
+         typename GradType,
+         typename PolicyType>
+void SGD<UpdatePolicyType, DecayPolicyType>::SmallBatchSteps(
+    WrapperType& function,
+    MatType& iterate,
+    GradType& gradient,
+    PolicyType& policy,
+    const size_t steps,
+    typename MatType::elem_type& objective)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  // The kernel is only used if the function has no EvaluateWithGradient() of
+  // its own, as in the Function<> wrapper.
+  typedef std::integral_constant<bool,
+      traits::HasSampleKernel<FunctionType, MatType, GradType>::value &&
+      !traits::HasEvaluateWithGradient<FunctionType, traits::TypedForms<
+          MatType, GradType>::template
+          DecomposableEvaluateWithGradientForm>::value &&
+      !traits::HasEvaluateWithGradient<FunctionType, traits::TypedForms<
+          MatType, GradType>::template
+          DecomposableEvaluateWithGradientConstForm>::value> UseSampleKernel;
+
+  for (size_t s = 0; s < steps; ++s)
+  {
+    const ElemType batchObjective = SmallBatchEvaluateWithGradient<BatchSize,
+        FunctionType>(function, iterate, s * BatchSize, gradient,
+        UseSampleKernel());
+    objective += batchObjective;
+
+    policy.Update(iterate, stepSize, gradient);
+    ObserveObjective(decayPolicy, batchObjective, BatchSize);
+    decayPolicy.Update(iterate, stepSize, gradient);
+  }
+}
+
+template<typename UpdatePolicyType, typename DecayPolicyType>
+template<typename FunctionType,
+         typename WrapperType,
+         typename MatType,
+         typename GradType,
+         typename PolicyType>
+void SGD<UpdatePolicyType, DecayPolicyType>::SmallBatchSteps(
+    WrapperType& function,
+    MatType& iterate,
+    GradType& gradient,
+    PolicyType& policy,
+    const size_t steps,
+    typename MatType::elem_type& objective)
+{
+  switch (batchSize)
+  {
+    case 1:
+      SmallBatchSteps<1, FunctionType>(function, iterate, gradient, policy,
+          steps, objective);
+      break;
+    case 2:
+      SmallBatchSteps<2, FunctionType>(function, iterate, gradient, policy,
+          steps, objective);
+      break;
+    case 3:
+      SmallBatchSteps<3, FunctionType>(function, iterate, gradient, policy,
+          steps, objective);
+      break;
+    case 4:
+      SmallBatchSteps<4, FunctionType>(function, iterate, gradient, policy,
+          steps, objective);
+      break;
+    default:
+      throw std::logic_error("SGD::SmallBatchSteps(): the batch size must be "
+          "at most 4!");
+  }
+}
+
+template<typename UpdatePolicyType, typename DecayPolicyType>
+template<size_t BatchSize, typename FunctionType, typename WrapperType,
+         typename MatType, typename GradType>
+typename MatType::elem_type
+SGD<UpdatePolicyType, DecayPolicyType>::SmallBatchEvaluateWithGradient(
+    WrapperType& function,
+    const MatType& iterate,
+    const size_t begin,
+    GradType& gradient,
+    std::true_type /* useSampleKernel */)
+{
+  // This is the serial path of SynthesizedEvaluateWithGradient().
+  typedef typename MatType::elem_type ElemType;
+  const FunctionType& f = static_cast<const FunctionType&>(function);
+
+  gradient.zeros(iterate.n_rows, iterate.n_cols);
+  ElemType objective = 0;
+  for (size_t i = begin; i < begin + BatchSize; ++i)
+    objective += f.AccumulateEvaluateWithGradient(iterate, i, gradient);
+  return objective;
+}
+
+template<typename UpdatePolicyType, typename DecayPolicyType>
+template<size_t BatchSize, typename FunctionType, typename WrapperType,
+         typename MatType, typename GradType>
+typename MatType::elem_type
+SGD<UpdatePolicyType, DecayPolicyType>::SmallBatchEvaluateWithGradient(
+    WrapperType& function,
+    const MatType& iterate,
+    const size_t begin,
+    GradType& gradient,
+    std::false_type /* useSampleKernel */)
+{
+  return function.EvaluateWithGradient(iterate, begin, gradient, BatchSize);
+}
+
+template<typename UpdatePolicyType, typename DecayPolicyType>
+size_t SGD<UpdatePolicyType, DecayPolicyType>::IncrementalPlan(
+    const size_t oldFunctions,
+    const size_t numFunctions,
+    RNG& rng,
+    std::vector<std::pair<size_t, size_t>>& plan) const
+{
+  plan.clear();
+  for (size_t begin = oldFunctions; begin < numFunctions; begin += batchSize)
+    plan.push_back(std::make_pair(begin, std::min(batchSize,
+        numFunctions - begin)));
+
+  // The replayed functions are drawn in batches of consecutive old functions,
+  // at random positions.
+  const size_t replayed = (size_t) std::ceil(replayRate *
+      (numFunctions - oldFunctions));
+  for (size_t r = 0; r < replayed; r += batchSize)
+  {
+    const size_t size = std::min(std::min(batchSize, replayed - r),
+        oldFunctions);
+    plan.push_back(std::make_pair(rng.Randi(0, oldFunctions - size), size));
+  }
+
+  if (shuffle)
+    std::shuffle(plan.begin(), plan.end(), rng);
+
+  size_t epochFunctions = 0;
+  for (size_t b = 0; b < plan.size(); ++b)
+    epochFunctions += plan[b].second;
+  return epochFunctions;
+}
+
+template<typename UpdatePolicyType, typename DecayPolicyType>
+template<typename MatType, typename GradType>
+void SGD<UpdatePolicyType, DecayPolicyType>::Serialize(BinaryArchive& ar)
+{
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+  typedef typename UpdatePolicyType::template Policy<BaseMatType, BaseGradType>
+      InstUpdatePolicyType;
+
+  // The decay policy may have changed the step size.
+  ar(stepSize);
+  ar(seenFunctions);
+  ar(decayPolicy);
+
+  bool instantiated = instUpdatePolicy.Has<InstUpdatePolicyType>();
+  ar(instantiated);
+  if (!instantiated)
+  {
+    if (ar.Loading())
+      instUpdatePolicy.Clean();
+    return;
+  }
+
+  // The loaded state gives the sizes of the matrices of the policy.
+  if (ar.Loading())
+    instUpdatePolicy.Set(new InstUpdatePolicyType(updatePolicy, 0, 0));
+  ar(instUpdatePolicy.As<InstUpdatePolicyType>());
+}
+
 } // namespace ens
 
 #endif
@@ -0,0 +1,423 @@
+/**
+ * @file block_update.hpp
+ *
+ * Wrapper for several update policies, each of which updates its own block of
+ * rows or columns of the iterate.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_BLOCK_UPDATE_HPP
+#define ENSMALLEN_SGD_BLOCK_UPDATE_HPP
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+namespace ens {
+
+/**
+ * A block of the iterate for BlockUpdate: a range of rows or a range of
+ * columns (both ends included), with a factor applied to the step size of the
+ * block.
+ */
+class UpdateBlock
+{
+ public:
+  /**
+   * Create a block of the given columns.
+   *
+   * @param first First column of the block.
+   * @param last Last column of the block.
+   * @param stepScale Factor applied to the step size for the block.
+   */
+  static UpdateBlock Cols(const size_t first,
+                          const size_t last,
+                          const double stepScale = 1.0)
+  {
+    return UpdateBlock(false, first, last, stepScale);
+  }
+
+  /**
+   * Create a block of the given rows.
+   *
+   * @param first First row of the block.
+   * @param last Last row of the block.
+   * @param stepScale Factor applied to the step size for the block.
+   */
+  static UpdateBlock Rows(const size_t first,
+                          const size_t last,
+                          const double stepScale = 1.0)
+  {
+    return UpdateBlock(true, first, last, stepScale);
+  }
+
+  //! Get whether the block is a range of rows (rather than of columns).
+  bool ByRows() const { return byRows; }
+
+  //! Get the first row or column of the block.
+  size_t First() const { return first; }
+  //! Modify the first row or column of the block.
+  size_t& First() { return first; }
+
+  //! Get the last row or column of the block.
+  size_t Last() const { return last; }
+  //! Modify the last row or column of the block.
+  size_t& Last() { return last; }
+
+  //! Get the factor applied to the step size.
+  double StepScale() const { return stepScale; }
+  //! Modify the factor applied to the step size.
+  double& StepScale() { return stepScale; }
+
+ private:
+  //! Create the block; use Cols() or Rows().
+  UpdateBlock(const bool byRows,
+              const size_t first,
+              const size_t last,
+              const double stepScale) :
+      byRows(byRows),
+      first(first),
+      last(last),
+      stepScale(stepScale)
+  { }
+
+  //! Whether the block is a range of rows.
+  bool byRows;
+
+  //! The first row or column.
+  size_t first;
+
+  //! The last row or column.
+  size_t last;
+
+  //! The factor applied to the step size.
+  double stepScale;
+};
+
+/**
+ * The instantiated policies of the blocks of a BlockUpdate, as a recursive
+ * list: the I-th one, followed by the others.  This is an internal class.
+ */
+template<size_t I, typename MatType, typename GradType, typename... Types>
+class BlockPolicyList
+{
+ public:
+  template<typename ParentType>
+  BlockPolicyList(const ParentType& /* parent */,
+                  const std::vector<size_t>& /* rows */,
+                  const std::vector<size_t>& /* cols */)
+  { }
+
+  template<typename SubMatType, typename SubGradType>
+  void Update(const size_t /* block */,
+              SubMatType& /* iterate */,
+              const double /* stepSize */,
+              const SubGradType& /* gradient */)
+  { }
+
+  void Serialize(BinaryArchive& /* ar */) { }
+};
+
+template<size_t I,
+         typename MatType,
+         typename GradType,
+         typename FirstType,
+         typename... Types>
+class BlockPolicyList<I, MatType, GradType, FirstType, Types...>
+{
+ public:
+  //! Instantiate the policy of each block with the size of the block.
+  template<typename ParentType>
+  BlockPolicyList(const ParentType& parent,
+                  const std::vector<size_t>& rows,
+                  const std::vector<size_t>& cols) :
+      policy(std::get<I>(parent.UpdatePolicies()), rows[I], cols[I]),
+      others(parent, rows, cols)
+  { }
+
+  //! Update the given block with its policy.
+  void Update(const size_t block,
+              MatType& iterate,
+              const double stepSize,
+              const GradType& gradient)
+  {
+    if (block == I)
+      policy.Update(iterate, stepSize, gradient);
+    else
+      others.Update(block, iterate, stepSize, gradient);
+  }
+
+  //! Save or load the state of the policies.
+  void Serialize(BinaryArchive& ar)
+  {
+    ar(policy);
+    others.Serialize(ar);
+  }
+
+ private:
+  //! The policy of block I.
+  typename FirstType::template Policy<MatType, GradType> policy;
+
+  //! The policies of the next blocks.
+  BlockPolicyList<I + 1, MatType, GradType, Types...> others;
+};
+
+/**
+ * Interface for updating separate blocks of the iterate with separate update
+ * policies.  The iterate is partitioned into blocks of rows or of columns (see
+ * UpdateBlock), and the i-th block is updated by the i-th update policy, with
+ * the step size multiplied by the step scale of the block.  So, for instance,
+ * the columns that hold an embedding can take cheap sparse AdaGrad steps while
+ * Adam updates the columns of the dense layers:
+ *
+ * @code
+ * BlockUpdate<AdaGradUpdate, AdamUpdate> update(
+ *     { UpdateBlock::Cols(0, 9999), UpdateBlock::Cols(10000, 10099, 0.1) },
+ *     AdaGradUpdate(), AdamUpdate());
+ * @endcode
+ *
+ * Each policy is instantiated with the size of its block, so its state (e.g.
+ * the moments of Adam) only covers the block.  With OpenMP, the blocks are
+ * updated in parallel by different threads.  The blocks must not overlap, and
+ * they must all be blocks of rows or all blocks of columns; the elements
+ * outside of the blocks are not updated.
+ *
+ * Blocks of columns (and blocks of rows of a column vector) are contiguous in
+ * memory, so the policies update the iterate in place; blocks of rows of a
+ * matrix with several columns are copied in and out around their update.  For
+ * sparse gradients (arma::sp_mat), each policy gets the sparse gradient of its
+ * block, so it must support sparse gradients.
+ *
+ * @tparam UpdatePolicyTypes The types of the update policies of the blocks.
+ */
+template<typename... UpdatePolicyTypes>
+class BlockUpdate
+{
+ public:
+  /**
+   * Construct the BlockUpdate wrapper.
+   *
+   * @param blocks The blocks of the iterate, one for each update policy.
+   * @param updatePolicies The update policies of the blocks.
+   */
+  BlockUpdate(const std::vector<UpdateBlock>& blocks,
+              const UpdatePolicyTypes&... updatePolicies) :
+      blocks(blocks),
+      updatePolicies(updatePolicies...)
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.  The blocks are checked, and the policy of each block is
+     * instantiated with the size of the block.  (An empty iterate, as when the
+     * state of the policy is about to be loaded, is not checked.)
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const BlockUpdate& parent,
+           const size_t rows,
+           const size_t cols) :
+        parent(parent),
+        blockRows(BlockSizes(parent, rows, cols, true)),
+        blockCols(BlockSizes(parent, rows, cols, false)),
+        policies(parent, blockRows, blockCols)
+    {
+      // Nothing to do.
+    }
+
+    /**
+     * Update step.  Each block is updated by its own policy; with OpenMP, the
+     * blocks are updated in parallel.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      const size_t numBlocks = parent.blocks.size();
+
+      #ifdef ENS_USE_OPENMP
+        #pragma omp parallel for schedule(dynamic, 1) if (numBlocks > 1)
+      #endif
+      for (size_t b = 0; b < numBlocks; ++b)
+      {
+        const UpdateBlock& block = parent.blocks[b];
+        const double blockStepSize = stepSize * block.StepScale();
+
+        if (!block.ByRows() || iterate.n_cols == 1)
+        {
+          // The block is contiguous, so it can be updated in place.
+          const size_t offset = block.ByRows() ? block.First() :
+              block.First() * iterate.n_rows;
+          MatType iterateBlock(iterate.memptr() + offset, blockRows[b],
+              blockCols[b], false, true);
+          UpdateGradientBlock(b, block, iterateBlock, blockStepSize, gradient);
+        }
+        else
+        {
+          MatType iterateBlock = iterate.rows(block.First(), block.Last());
+          UpdateGradientBlock(b, block, iterateBlock, blockStepSize, gradient);
+          iterate.rows(block.First(), block.Last()) = iterateBlock;
+        }
+      }
+    }
+
+    /**
+     * Save or load the state of the policy: the states of the policies of the
+     * blocks.
+     *
+     * @param ar Archive to save into or load from.
+     */
+    void Serialize(BinaryArchive& ar)
+    {
+      policies.Serialize(ar);
+    }
+
+   private:
+    //! Update a block of a dense gradient.
+    template<typename eT>
+    void UpdateGradientBlock(const size_t b,
+                             const UpdateBlock& block,
+                             MatType& iterateBlock,
+                             const double stepSize,
+                             const arma::Mat<eT>& gradient)
+    {
+      if (!block.ByRows() || gradient.n_cols == 1)
+      {
+        const size_t offset = block.ByRows() ? block.First() :
+            block.First() * gradient.n_rows;
+        const GradType gradientBlock(const_cast<eT*>(gradient.memptr()) +
+            offset, blockRows[b], blockCols[b], false, true);
+        policies.Update(b, iterateBlock, stepSize, gradientBlock);
+      }
+      else
+      {
+        const GradType gradientBlock = gradient.rows(block.First(),
+            block.Last());
+        policies.Update(b, iterateBlock, stepSize, gradientBlock);
+      }
+    }
+
+    //! Update a block of a sparse gradient.
+    template<typename eT>
+    void UpdateGradientBlock(const size_t b,
+                             const UpdateBlock& block,
+                             MatType& iterateBlock,
+                             const double stepSize,
+                             const arma::SpMat<eT>& gradient)
+    {
+      const GradType gradientBlock = block.ByRows() ?
+          GradType(gradient.rows(block.First(), block.Last())) :
+          GradType(gradient.cols(block.First(), block.Last()));
+      policies.Update(b, iterateBlock, stepSize, gradientBlock);
+    }
+
+    //! Check the blocks, and get their numbers of rows or columns.
+    static std::vector<size_t> BlockSizes(const BlockUpdate& parent,
+                                          const size_t rows,
+                                          const size_t cols,
+                                          const bool blockRows)
+    {
+      const std::vector<UpdateBlock>& blocks = parent.blocks;
+      if (blocks.size() != sizeof...(UpdatePolicyTypes))
+      {
+        throw std::invalid_argument("BlockUpdate::Policy(): there must be one "
+            "block for each update policy!");
+      }
+
+      std::vector<size_t> sizes(blocks.size(), 0);
+      if (rows * cols == 0)
+        return sizes;
+
+      std::vector<std::pair<size_t, size_t>> ranges;
+      for (size_t b = 0; b < blocks.size(); ++b)
+      {
+        const size_t limit = blocks[b].ByRows() ? rows : cols;
+        if (blocks[b].ByRows() != blocks[0].ByRows())
+        {
+          throw std::invalid_argument("BlockUpdate::Policy(): the blocks must "
+              "all be blocks of rows or all blocks of columns!");
+        }
+        else if (blocks[b].First() > blocks[b].Last() ||
+            blocks[b].Last() >= limit)
+        {
+          throw std::invalid_argument("BlockUpdate::Policy(): a block is "
+              "empty or out of the bounds of the iterate!");
+        }
+
+        const size_t length = blocks[b].Last() - blocks[b].First() + 1;
+        if (blocks[b].ByRows())
+          sizes[b] = blockRows ? length : cols;
+        else
+          sizes[b] = blockRows ? rows : length;
+        ranges.push_back(std::make_pair(blocks[b].First(), blocks[b].Last()));
+      }
+
+      std::sort(ranges.begin(), ranges.end());
+      for (size_t b = 1; b < ranges.size(); ++b)
+      {
+        if (ranges[b].first <= ranges[b - 1].second)
+        {
+          throw std::invalid_argument("BlockUpdate::Policy(): the blocks must "
+              "not overlap!");
+        }
+      }
+
+      return sizes;
+    }
+
+    //! Instantiated parent object.
+    const BlockUpdate& parent;
+
+    //! The number of rows of each block.
+    std::vector<size_t> blockRows;
+
+    //! The number of columns of each block.
+    std::vector<size_t> blockCols;
+
+    //! The update policies instantiated for each block.
+    BlockPolicyList<0, MatType, GradType, UpdatePolicyTypes...> policies;
+  };
+
+  //! Get the blocks.
+  const std::vector<UpdateBlock>& Blocks() const { return blocks; }
+  //! Modify the blocks.
+  std::vector<UpdateBlock>& Blocks() { return blocks; }
+
+  //! Get the update policies.
+  const std::tuple<UpdatePolicyTypes...>& UpdatePolicies() const
+  { return updatePolicies; }
+  //! Modify the update policies.
+  std::tuple<UpdatePolicyTypes...>& UpdatePolicies() { return updatePolicies; }
+
+ private:
+  //! The blocks of the iterate.
+  std::vector<UpdateBlock> blocks;
+
+  //! The update policies of the blocks.
+  std::tuple<UpdatePolicyTypes...> updatePolicies;
+};
+
+} // namespace ens
+
+#endif
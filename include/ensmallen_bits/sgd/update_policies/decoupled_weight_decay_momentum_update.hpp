@@ -60,39 +60,112 @@ class DecoupledWeightDecayMomentumUpdate
     // Nothing to do
   }
 
+  //! Get the number of bytes of the state (the velocity) for an iterate of
+  //! the given size.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
+  {
+    return rows * cols * elemSize;
+  }
+
   /**
-   * Initialize the velocity matrix to zero. It is of the same shape as
-   * gradient matrix. (see ens::MomentumUpdate::Initialize for more details)
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
    */
-  void Initialize(const size_t rows, const size_t cols)
+  template<typename MatType, typename GradType>
+  class Policy
   {
-    velocity = arma::zeros<arma::mat>(rows, cols);
-  }
+   public:
+    /**
+     * Initialize the velocity matrix to zero. It is of the same shape as
+     * gradient matrix. (see ens::MomentumUpdate::Policy for more details)
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const DecoupledWeightDecayMomentumUpdate& parent,
+           const size_t rows,
+           const size_t cols) :
+        parent(parent)
+    {
+      velocity.zeros(rows, cols);
+    }
+
+    /**
+     * Update the given paramters. (see ens::MomentumUpdate::Policy::Update for
+     * more details).
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      velocity = parent.momentum * velocity + stepSize * gradient;
+      iterate -= velocity + (stepSize * parent.weightDecay) * iterate;
+    }
+
+   private:
+    // Instantiated parent object.
+    const DecoupledWeightDecayMomentumUpdate& parent;
+
+    // The velocity matrix.
+    MatType velocity;
+  };
 
   /**
-   * Update the given paramters. (see ens::MomentumUpdate::Update for more
-   * details).
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
+   * The element-wise kernel of the momentum update with weight decay, used to
+   * fuse it with other policies into one loop (see FusedUpdate).
    */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
+  template<typename ElemType>
+  class Kernel
   {
-    velocity = momentum * velocity + stepSize * gradient;
-    iterate -= velocity + stepSize * weightDecay * iterate;
-  }
+   public:
+    //! Create the kernel for an iterate with n elements, with zero velocity.
+    Kernel(const DecoupledWeightDecayMomentumUpdate& parent, const size_t n) :
+        momentum(parent.momentum),
+        weightDecay(parent.weightDecay),
+        step(0)
+    {
+      velocity.zeros(n, 1);
+    }
+
+    //! Start a step with the given step size.
+    void Begin(const double stepSize) { step = stepSize; }
+
+    //! Update element i of the iterate with element g of the gradient.
+    void Apply(const size_t i, ElemType& x, ElemType& g)
+    {
+      velocity[i] = momentum * velocity[i] + step * g;
+      x -= velocity[i] + (step * weightDecay) * x;
+    }
+
+    //! Save or load the state of the kernel.
+    void Serialize(BinaryArchive& ar) { ar(velocity); }
+
+   private:
+    //! The momentum hyperparameter.
+    ElemType momentum;
+
+    //! The weight decay parameter.
+    ElemType weightDecay;
+
+    //! The step size of the current step.
+    ElemType step;
+
+    //! The velocity of each element.
+    arma::Mat<ElemType> velocity;
+  };
 
  private:
   // The momentum hyperparameter
   double momentum;
-  // The velocity matrix
-  arma::mat velocity;
   // The weight decay (lambda) parameter
   double weightDecay;
 };
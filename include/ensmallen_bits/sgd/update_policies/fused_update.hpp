@@ -0,0 +1,288 @@
+/**
+ * @file fused_update.hpp
+ *
+ * Composition of element-wise update policies into a single loop over the
+ * iterate, the gradient and the state.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_FUSED_UPDATE_HPP
+#define ENSMALLEN_SGD_FUSED_UPDATE_HPP
+
+namespace ens {
+
+/**
+ * FusedUpdate chains the element-wise kernels of the given stages, and runs
+ * them in one loop over the elements of the iterate: for each element, the
+ * first stage gets the element of the iterate and of the gradient, may change
+ * either of them, and passes them on to the next stage.  Since the chain is
+ * built at compile time, the compiler inlines all the stages into the loop
+ * body, so the composition reads and writes the iterate, the gradient and the
+ * state of each stage once per step, instead of once per Armadillo
+ * expression of each stage.
+ *
+ * A stage is any policy with a nested element-wise kernel:
+ *
+ * @code
+ * template<typename ElemType>
+ * class Kernel
+ * {
+ *  public:
+ *   // Create the kernel (and its state) for an iterate with n elements.
+ *   Kernel(const StageType& parent, const size_t n);
+ *
+ *   // Start a step with the given step size.
+ *   void Begin(const double stepSize);
+ *
+ *   // Update element i: x is the element of the iterate and g that of the
+ *   // gradient, as left by the previous stages.
+ *   void Apply(const size_t i, ElemType& x, ElemType& g);
+ *
+ *   // Save or load the state of the kernel.
+ *   void Serialize(BinaryArchive& ar);
+ * };
+ * @endcode
+ *
+ * VanillaUpdate, MomentumUpdate, DecoupledWeightDecayMomentumUpdate,
+ * AdamUpdate and the element-wise GradientClipping (around a policy with a
+ * kernel) have kernels, and so does FusedUpdate itself.  So, for instance,
+ * FusedUpdate<GradientClipping<AdamUpdate>> clips and takes the Adam step in
+ * one pass.  The gradient of each step is only read; stages that transform
+ * the gradient only change the copy of its element given to the later stages.
+ *
+ * The loop needs a dense iterate; gradients of other types (e.g. sparse
+ * gradients) are first copied into a dense buffer.
+ *
+ * @tparam StageTypes Policies whose kernels are run, in order, on each element.
+ */
+template<typename... StageTypes>
+class FusedUpdate;
+
+//! The empty composition leaves the iterate unchanged.
+template<>
+class FusedUpdate<>
+{
+ public:
+  //! The empty composition has no state.
+  size_t EstimateStateBytes(const size_t /* rows */,
+                            const size_t /* cols */,
+                            const size_t /* elemSize */ = sizeof(double)) const
+  {
+    return 0;
+  }
+
+  //! The kernel of the empty composition does nothing.
+  template<typename ElemType>
+  class Kernel
+  {
+   public:
+    //! Create the kernel (it has no state).
+    Kernel(const FusedUpdate& /* parent */, const size_t /* n */) { }
+
+    //! Start a step.
+    void Begin(const double /* stepSize */) { }
+
+    //! Leave the elements unchanged.
+    void Apply(const size_t /* i */, ElemType& /* x */, ElemType& /* g */) { }
+
+    //! Save or load the state of the kernel (it has none).
+    void Serialize(BinaryArchive& /* ar */) { }
+  };
+};
+
+template<typename FirstStageType, typename... OtherStageTypes>
+class FusedUpdate<FirstStageType, OtherStageTypes...>
+{
+ public:
+  //! The type of the composition of the stages after the first one.
+  typedef FusedUpdate<OtherStageTypes...> NextType;
+
+  //! Construct the composition with default-constructed stages.
+  FusedUpdate() { /* Nothing to do. */ }
+
+  /**
+   * Construct the composition of the given stages.
+   *
+   * @param firstStage The stage applied first to each element.
+   * @param otherStages The stages applied after it, in order.
+   */
+  FusedUpdate(const FirstStageType& firstStage,
+              const OtherStageTypes&... otherStages) :
+      firstStage(firstStage),
+      next(otherStages...)
+  {
+    // Nothing to do.
+  }
+
+  //! Get the number of bytes of the state (that of all the stages) for an
+  //! iterate of the given size.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
+  {
+    return firstStage.EstimateStateBytes(rows, cols, elemSize) +
+        next.EstimateStateBytes(rows, cols, elemSize);
+  }
+
+  //! The kernels of all the stages, chained.
+  template<typename ElemType>
+  class Kernel
+  {
+   public:
+    /**
+     * Create the kernels of the stages for an iterate with n elements.
+     *
+     * @param parent Instantiated parent class.
+     * @param n Number of elements of the iterate.
+     */
+    Kernel(const FusedUpdate& parent, const size_t n) :
+        firstKernel(parent.firstStage, n),
+        nextKernel(parent.next, n)
+    {
+      // Nothing to do.
+    }
+
+    //! Start a step of every stage with the given step size.
+    void Begin(const double stepSize)
+    {
+      firstKernel.Begin(stepSize);
+      nextKernel.Begin(stepSize);
+    }
+
+    //! Run every stage on element i.
+    void Apply(const size_t i, ElemType& x, ElemType& g)
+    {
+      firstKernel.Apply(i, x, g);
+      nextKernel.Apply(i, x, g);
+    }
+
+    //! Save or load the state of every stage.
+    void Serialize(BinaryArchive& ar)
+    {
+      ar(firstKernel);
+      ar(nextKernel);
+    }
+
+   private:
+    //! The kernel of the first stage.
+    typename FirstStageType::template Kernel<ElemType> firstKernel;
+
+    //! The kernels of the other stages.
+    typename NextType::template Kernel<ElemType> nextKernel;
+  };
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    //! The element type of the iterate.
+    typedef typename MatType::elem_type ElemType;
+
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.  Here the kernels of the stages are created.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const FusedUpdate& parent, const size_t rows, const size_t cols) :
+        kernel(parent, rows * cols)
+    {
+      // Nothing to do.
+    }
+
+    /**
+     * Update step.  Every stage is run on each element of the iterate, in one
+     * loop.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      kernel.Begin(stepSize);
+      Step(iterate, gradient, IsFusableUpdate<MatType, GradType>());
+    }
+
+    /**
+     * Save or load the state of the policy, to resume an optimization.
+     *
+     * @param ar Archive to save into or load from.
+     */
+    void Serialize(BinaryArchive& ar)
+    {
+      ar(kernel);
+    }
+
+   private:
+    //! Run the kernels on the iterate and the gradient.
+    void Step(MatType& iterate,
+              const GradType& gradient,
+              std::true_type /* fusable */)
+    {
+      Apply(iterate.memptr(), gradient.memptr(), iterate.n_elem);
+    }
+
+    //! Copy the gradient into a dense buffer, and run the kernels on it.
+    void Step(MatType& iterate,
+              const GradType& gradient,
+              std::false_type /* fusable */)
+    {
+      buffer = gradient;
+      Apply(iterate.memptr(), buffer.memptr(), iterate.n_elem);
+    }
+
+    //! Run the kernels on every element.
+    void Apply(ElemType* x, const ElemType* g, const size_t n)
+    {
+      ENS_PRAGMA_OMP_SIMD
+      for (size_t i = 0; i < n; ++i)
+      {
+        ElemType xi = x[i];
+        ElemType gi = g[i];
+        kernel.Apply(i, xi, gi);
+        x[i] = xi;
+      }
+    }
+
+    //! The chained kernels of the stages.
+    Kernel<ElemType> kernel;
+
+    //! The dense copy of a gradient of another type.
+    arma::Mat<ElemType> buffer;
+  };
+
+  //! Get the first stage.
+  const FirstStageType& FirstStage() const { return firstStage; }
+  //! Modify the first stage.
+  FirstStageType& FirstStage() { return firstStage; }
+
+  //! Get the composition of the other stages.
+  const NextType& Next() const { return next; }
+  //! Modify the composition of the other stages.
+  NextType& Next() { return next; }
+
+ private:
+  //! The stage applied first to each element.
+  FirstStageType firstStage;
+
+  //! The composition of the other stages.
+  NextType next;
+};
+
+} // namespace ens
+
+#endif
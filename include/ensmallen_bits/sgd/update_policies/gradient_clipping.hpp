@@ -14,12 +14,48 @@
 
 namespace ens {
 
+class VanillaUpdate;
+class MomentumUpdate;
+class NesterovMomentumUpdate;
+
+/**
+ * IsStepLinearUpdate<UpdatePolicyType>::value is true when the update policy
+ * only uses the gradient through the product of the step size and the
+ * gradient, so that updating with the step size s * c and the gradient g is
+ * the same as updating with the step size s and the gradient c * g.
+ */
+template<typename UpdatePolicyType>
+struct IsStepLinearUpdate : std::false_type { };
+
+template<>
+struct IsStepLinearUpdate<VanillaUpdate> : std::true_type { };
+
+template<>
+struct IsStepLinearUpdate<MomentumUpdate> : std::true_type { };
+
+template<>
+struct IsStepLinearUpdate<NesterovMomentumUpdate> : std::true_type { };
+
 /**
  * Interface for wrapping around update policies (e.g., VanillaUpdate)
  * and feeding a clipped gradient to them instead of the normal one.
  * (Clipping here is implemented as
  * \f$ g_{\text{clipped}} = \max(g_{\text{min}}, \min(g_{\text{min}}, g))) \f$.)
  *
+ * With the norm constructor, the gradient is instead rescaled so that its L2
+ * norm is at most maxNorm,
+ * \f$ g_{\text{clipped}} = \min(1, c / \|g\|_2) g \f$, or, if blockSize is
+ * positive, so that the norm of each block of blockSize consecutive elements
+ * (in column-major order, so a multiple of the number of rows clips groups of
+ * columns) is at most maxNorm.  The norm is computed with ParallelDot(), in
+ * parallel for gradients of at least minChunkSize elements.  A gradient whose
+ * norm is small enough is given to the wrapped policy as is; otherwise, for
+ * policies with IsStepLinearUpdate (VanillaUpdate, MomentumUpdate and
+ * NesterovMomentumUpdate), the global scale is folded into the step size of
+ * the wrapped update, so that no clipped copy of the gradient is made.  For
+ * the other policies, and for per-block clipping, the clipped gradient is
+ * written into a buffer that is reused between the steps.
+ *
  * @tparam UpdatePolicy A type of UpdatePolicy that sould be wrapped around.
  */
 template<typename UpdatePolicyType>
@@ -39,41 +75,314 @@ class GradientClipping
                    UpdatePolicyType& updatePolicy) :
     minGradient(minGradient),
     maxGradient(maxGradient),
+    maxNorm(0.0),
+    blockSize(0),
+    minChunkSize(65536),
     updatePolicy(updatePolicy)
   {
     // Nothing to do here
   }
 
   /**
-   * The Initialize method is called by SGD Optimizer method before the start of
-   * the iteration update process. Here we just do whatever initialization
-   * is needed for the actual update policy.
+   * Constructor for creating a GradientClipping instance that clips the L2
+   * norm of the gradient (or of each of its blocks).
    *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
+   * @param maxNorm Maximum norm of the gradient (or of each block).
+   * @param updatePolicy An instance of the UpdatePolicyType
+   *                     used for actual optimization.
+   * @param blockSize Number of consecutive elements whose norm is clipped
+   *     separately (0 clips the norm of the whole gradient).
+   * @param minChunkSize Minimum number of elements of a gradient whose norm
+   *     is computed in parallel.
    */
-  void Initialize(const size_t rows, const size_t cols)
+  GradientClipping(const double maxNorm,
+                   UpdatePolicyType& updatePolicy,
+                   const size_t blockSize = 0,
+                   const size_t minChunkSize = 65536) :
+    minGradient(-DBL_MAX),
+    maxGradient(DBL_MAX),
+    maxNorm(maxNorm),
+    blockSize(blockSize),
+    minChunkSize(minChunkSize),
+    updatePolicy(updatePolicy)
   {
-    updatePolicy.Initialize(rows, cols);
+    if (!(maxNorm > 0.0))
+    {
+      throw std::invalid_argument("GradientClipping: the maximum norm must be "
+          "positive!");
+    }
+  }
+
+  //! Get the number of bytes of the state (that of the wrapped policy) for
+  //! an iterate of the given size.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
+  {
+    return updatePolicy.EstimateStateBytes(rows, cols, elemSize);
   }
 
   /**
-   * Update step. First, the gradient is clipped, and then the actual update
-   * policy does whatever update it needs to do.
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
    */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
+  template<typename MatType, typename GradType>
+  class Policy
   {
-    // First, clip the gradient.
-    arma::mat clippedGradient = arma::clamp(gradient, minGradient, maxGradient);
-    // And only then do the update.
-    updatePolicy.Update(iterate, stepSize, clippedGradient);
-  }
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.  Here we just do whatever initialization is needed for
+     * the actual update policy.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const GradientClipping& parent,
+           const size_t rows,
+           const size_t cols) :
+        parent(parent),
+        instUpdatePolicy(parent.updatePolicy, rows, cols)
+    {
+      // Nothing to do.
+    }
+
+    /**
+     * Update step. First, the gradient is clipped, and then the actual update
+     * policy does whatever update it needs to do.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      if (parent.maxNorm == 0.0)
+      {
+        // First, clip the gradient.
+        clipped = arma::clamp(gradient, parent.minGradient,
+            parent.maxGradient);
+        // And only then do the update.
+        instUpdatePolicy.Update(iterate, stepSize, clipped);
+      }
+      else if (parent.blockSize == 0 || parent.blockSize >= gradient.n_elem)
+      {
+        const double norm = std::sqrt((double) ParallelDot(gradient, gradient,
+            parent.minChunkSize));
+        if (norm <= parent.maxNorm)
+          instUpdatePolicy.Update(iterate, stepSize, gradient);
+        else
+          ScaledUpdate(iterate, stepSize, parent.maxNorm / norm, gradient);
+      }
+      else if (BlockScales(gradient))
+      {
+        ClipBlocks(gradient);
+        instUpdatePolicy.Update(iterate, stepSize, clipped);
+      }
+      else
+      {
+        instUpdatePolicy.Update(iterate, stepSize, gradient);
+      }
+    }
+
+   private:
+    //! Update with the gradient scaled by the given factor, folded into the
+    //! step size of a step-linear policy.
+    template<typename PolicyType = UpdatePolicyType>
+    typename std::enable_if<IsStepLinearUpdate<PolicyType>::value>::type
+    ScaledUpdate(MatType& iterate,
+                 const double stepSize,
+                 const double scale,
+                 const GradType& gradient)
+    {
+      instUpdatePolicy.Update(iterate, stepSize * scale, gradient);
+    }
+
+    //! Update with the gradient scaled by the given factor, written into the
+    //! buffer.
+    template<typename PolicyType = UpdatePolicyType>
+    typename std::enable_if<!IsStepLinearUpdate<PolicyType>::value>::type
+    ScaledUpdate(MatType& iterate,
+                 const double stepSize,
+                 const double scale,
+                 const GradType& gradient)
+    {
+      typedef typename GradType::elem_type ElemType;
+
+      clipped = ElemType(scale) * gradient;
+      instUpdatePolicy.Update(iterate, stepSize, clipped);
+    }
+
+    /**
+     * Compute the scale of each block of the dense gradient, in parallel for
+     * large gradients, and return whether any block has to be clipped.
+     */
+    template<typename DenseGradType>
+    bool BlockScales(const DenseGradType& gradient)
+    {
+      typedef typename GradType::elem_type ElemType;
+
+      const size_t n = gradient.n_elem;
+      const size_t size = parent.blockSize;
+      const ElemType* g = gradient.memptr();
+      scales.set_size((n + size - 1) / size);
+      ParallelFor(scales.n_elem, [&](const size_t b)
+      {
+        const size_t end = std::min((b + 1) * size, n);
+        double sum = 0.0;
+        for (size_t i = b * size; i < end; ++i)
+          sum += (double) g[i] * g[i];
+
+        const double norm = std::sqrt(sum);
+        scales[b] = (norm > parent.maxNorm) ? parent.maxNorm / norm : 1.0;
+      }, n >= parent.minChunkSize);
+
+      return scales.min() < 1.0;
+    }
+
+    /**
+     * Compute the scale of each block of the sparse gradient (from its
+     * nonzero elements), and return whether any block has to be clipped.
+     */
+    template<typename eT>
+    bool BlockScales(const arma::SpMat<eT>& gradient)
+    {
+      const size_t size = parent.blockSize;
+      scales.zeros((gradient.n_elem + size - 1) / size);
+      typename arma::SpMat<eT>::const_iterator it = gradient.begin();
+      for ( ; it != gradient.end(); ++it)
+      {
+        const double value = (*it);
+        scales[(it.col() * gradient.n_rows + it.row()) / size] += value * value;
+      }
+
+      for (size_t b = 0; b < scales.n_elem; ++b)
+      {
+        const double norm = std::sqrt(scales[b]);
+        scales[b] = (norm > parent.maxNorm) ? parent.maxNorm / norm : 1.0;
+      }
+
+      return scales.min() < 1.0;
+    }
+
+    //! Write the dense gradient, with each block scaled, into the buffer in a
+    //! single pass.
+    template<typename DenseGradType>
+    void ClipBlocks(const DenseGradType& gradient)
+    {
+      typedef typename GradType::elem_type ElemType;
+
+      const size_t n = gradient.n_elem;
+      const size_t size = parent.blockSize;
+      clipped.set_size(gradient.n_rows, gradient.n_cols);
+      const ElemType* g = gradient.memptr();
+      ElemType* c = clipped.memptr();
+      ParallelFor(scales.n_elem, [&](const size_t b)
+      {
+        const ElemType scale = ElemType(scales[b]);
+        const size_t end = std::min((b + 1) * size, n);
+        for (size_t i = b * size; i < end; ++i)
+          c[i] = scale * g[i];
+      }, n >= parent.minChunkSize);
+    }
+
+    //! Write the sparse gradient, with each block scaled, into the buffer.
+    template<typename eT>
+    void ClipBlocks(const arma::SpMat<eT>& gradient)
+    {
+      const size_t size = parent.blockSize;
+      arma::umat locations(2, gradient.n_nonzero);
+      arma::Col<eT> values(gradient.n_nonzero);
+      typename arma::SpMat<eT>::const_iterator it = gradient.begin();
+      for (size_t k = 0; it != gradient.end(); ++it, ++k)
+      {
+        locations(0, k) = it.row();
+        locations(1, k) = it.col();
+        values[k] = eT(scales[(it.col() * gradient.n_rows + it.row()) / size] *
+            (*it));
+      }
+
+      clipped = arma::SpMat<eT>(locations, values, gradient.n_rows,
+          gradient.n_cols);
+    }
+
+    //! Instantiated parent object.
+    const GradientClipping& parent;
+
+    //! The update policy instantiated for the given matrix types.
+    typename UpdatePolicyType::template Policy<MatType, GradType>
+        instUpdatePolicy;
+
+    //! The clipped gradient, reused between the steps.
+    GradType clipped;
+
+    //! The scale of each block of the gradient.
+    arma::vec scales;
+  };
+
+  /**
+   * The element-wise kernel of the wrapper, which clips each element of the
+   * gradient and passes it to the kernel of the wrapped policy, so that both
+   * run in one loop (see FusedUpdate).  The norm of the gradient needs a pass
+   * of its own, so norm clipping has no kernel.
+   */
+  template<typename ElemType>
+  class Kernel
+  {
+   public:
+    /**
+     * Create the kernel for an iterate with n elements.
+     *
+     * @param parent Instantiated parent class.
+     * @param n Number of elements of the iterate.
+     */
+    Kernel(const GradientClipping& parent, const size_t n) :
+        minGradient(Limit(parent.minGradient)),
+        maxGradient(Limit(parent.maxGradient)),
+        kernel(parent.updatePolicy, n)
+    {
+      if (parent.maxNorm != 0.0)
+      {
+        throw std::invalid_argument("GradientClipping: norm clipping cannot be "
+            "fused into an element-wise kernel!");
+      }
+    }
+
+    //! Start a step with the given step size.
+    void Begin(const double stepSize) { kernel.Begin(stepSize); }
+
+    //! Update element i of the iterate with element g of the gradient.
+    void Apply(const size_t i, ElemType& x, ElemType& g)
+    {
+      g = std::min(std::max(g, minGradient), maxGradient);
+      kernel.Apply(i, x, g);
+    }
+
+    //! Save or load the state of the kernel (that of the wrapped kernel).
+    void Serialize(BinaryArchive& ar) { ar(kernel); }
+
+   private:
+    //! Convert a bound to the element type, saturating at its largest value.
+    static ElemType Limit(const double bound)
+    {
+      const double largest = std::numeric_limits<ElemType>::max();
+      return ElemType(std::min(std::max(bound, -largest), largest));
+    }
+
+    //! Minimum value of a gradient element.
+    ElemType minGradient;
+
+    //! Maximum value of a gradient element.
+    ElemType maxGradient;
+
+    //! The kernel of the wrapped policy.
+    typename UpdatePolicyType::template Kernel<ElemType> kernel;
+  };
 
   //! Get the update policy.
   UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
@@ -90,6 +399,26 @@ class GradientClipping
   //! Modify the maximum gradient value.
   double& MaxGradient() { return maxGradient; }
 
+  //! Get the maximum norm of the gradient (0 indicates element-wise clipping).
+  double MaxNorm() const { return maxNorm; }
+  //! Modify the maximum norm of the gradient (0 indicates element-wise
+  //! clipping).
+  double& MaxNorm() { return maxNorm; }
+
+  //! Get the number of elements of the blocks whose norm is clipped (0
+  //! indicates the whole gradient).
+  size_t BlockSize() const { return blockSize; }
+  //! Modify the number of elements of the blocks whose norm is clipped (0
+  //! indicates the whole gradient).
+  size_t& BlockSize() { return blockSize; }
+
+  //! Get the minimum number of elements of a gradient whose norm is computed
+  //! in parallel.
+  size_t MinChunkSize() const { return minChunkSize; }
+  //! Modify the minimum number of elements of a gradient whose norm is
+  //! computed in parallel.
+  size_t& MinChunkSize() { return minChunkSize; }
+
  private:
   //! Minimum possible value of gradient element.
   double minGradient;
@@ -97,6 +426,17 @@ class GradientClipping
   //! Maximum possible value of gradient element.
   double maxGradient;
 
+  //! Maximum norm of the gradient, or 0 for element-wise clipping.
+  double maxNorm;
+
+  //! Number of elements of the blocks whose norm is clipped, or 0 for the
+  //! whole gradient.
+  size_t blockSize;
+
+  //! Minimum number of elements of a gradient whose norm is computed in
+  //! parallel.
+  size_t minChunkSize;
+
   //! An instance of the UpdatePolicy used for actual optimization.
   UpdatePolicyType updatePolicy;
 };
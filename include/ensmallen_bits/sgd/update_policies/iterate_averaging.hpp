@@ -0,0 +1,254 @@
+/**
+ * @file iterate_averaging.hpp
+ *
+ * Wrapper for update policies that keeps a running average of the iterates
+ * (Polyak-Ruppert averaging or stochastic weight averaging).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_ITERATE_AVERAGING_HPP
+#define ENSMALLEN_SGD_ITERATE_AVERAGING_HPP
+
+#include <ensmallen_bits/utility/any.hpp>
+#include "vanilla_update.hpp"
+
+namespace ens {
+
+/**
+ * Interface for wrapping around update policies (e.g., MomentumUpdate) and
+ * keeping a running average of the iterates they produce.  After each update
+ * step of the wrapped policy, once `start` steps have been taken, every
+ * `frequency`-th iterate is added to the average
+ *
+ * \f[
+ * \bar{x}_{k + 1} = \bar{x}_k + \frac{1}{k + 1} (x - \bar{x}_k).
+ * \f]
+ *
+ * With start = 0 and frequency = 1 this is Polyak-Ruppert averaging of all the
+ * iterates; with start at the end of a warm-up phase and frequency equal to the
+ * number of steps in an epoch (or in a cycle of a cyclical step size) it is
+ * stochastic weight averaging (SWA).  The average is kept in a single buffer
+ * the size of the iterate and updated in place, in one pass over the iterate;
+ * unlike SnapshotEnsembles, no snapshot is stored.
+ *
+ * The optimization itself is not changed: the optimizer still returns the
+ * last iterate.  The average of the last optimization is available through
+ * Average(), for instance with
+ *
+ * @code
+ * SGD<IterateAveraging<MomentumUpdate>> optimizer(...);
+ * optimizer.Optimize(f, coordinates);
+ * coordinates = optimizer.UpdatePolicy().Average();
+ * @endcode
+ *
+ * It is reset whenever the optimizer instantiates the policy again (at the
+ * start of each optimization when resetPolicy is true).
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @article{polyak1992acceleration,
+ *   title   = {Acceleration of Stochastic Approximation by Averaging},
+ *   author  = {Polyak, Boris T. and Juditsky, Anatoli B.},
+ *   journal = {SIAM Journal on Control and Optimization},
+ *   volume  = {30},
+ *   number  = {4},
+ *   pages   = {838--855},
+ *   year    = {1992}
+ * }
+ *
+ * @inproceedings{izmailov2018averaging,
+ *   title     = {Averaging Weights Leads to Wider Optima and Better
+ *                Generalization},
+ *   author    = {Izmailov, Pavel and Podoprikhin, Dmitrii and Garipov, Timur
+ *                and Vetrov, Dmitry and Wilson, Andrew Gordon},
+ *   booktitle = {Proceedings of the Conference on Uncertainty in Artificial
+ *                Intelligence (UAI)},
+ *   year      = {2018}
+ * }
+ * @endcode
+ *
+ * @tparam UpdatePolicyType A type of UpdatePolicy that should be wrapped.
+ */
+template<typename UpdatePolicyType = VanillaUpdate>
+class IterateAveraging
+{
+ public:
+  /**
+   * Construct the IterateAveraging wrapper.
+   *
+   * @param updatePolicy An instance of the UpdatePolicyType used for the
+   *     actual update.
+   * @param start Number of update steps taken before the averaging starts.
+   * @param frequency Number of update steps between two iterates that are
+   *     added to the average.
+   */
+  IterateAveraging(const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
+                   const size_t start = 0,
+                   const size_t frequency = 1) :
+      updatePolicy(updatePolicy),
+      start(start),
+      frequency(frequency),
+      count(0)
+  {
+    // Nothing to do.
+  }
+
+  //! Get the number of bytes of the state (the average of the iterates and
+  //! the state of the wrapped policy) for an iterate of the given size.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
+  {
+    return rows * cols * elemSize +
+        updatePolicy.EstimateStateBytes(rows, cols, elemSize);
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.  The wrapped policy is instantiated, and the average of
+     * the parent is reset.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const IterateAveraging& parent,
+           const size_t rows,
+           const size_t cols) :
+        parent(parent),
+        instUpdatePolicy(parent.updatePolicy, rows, cols),
+        steps(0)
+    {
+      if (parent.frequency == 0)
+      {
+        throw std::invalid_argument("IterateAveraging::Policy(): frequency "
+            "must be positive!");
+      }
+
+      parent.average.Set(new MatType());
+      parent.count = 0;
+    }
+
+    /**
+     * Update step.  The wrapped policy takes its step, and then the new
+     * iterate is added to the average if it is due.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      instUpdatePolicy.Update(iterate, stepSize, gradient);
+
+      ++steps;
+      if (steps <= parent.start || (steps - parent.start) % parent.frequency)
+        return;
+
+      MatType& average = parent.average.template As<MatType>();
+      if (parent.count == 0)
+        average = iterate;
+      else
+        average += (iterate - average) / ElemType(parent.count + 1);
+      ++parent.count;
+    }
+
+    /**
+     * Save or load the state of the policy: the state of the wrapped policy,
+     * the number of steps taken and the average.
+     *
+     * @param ar Archive to save into or load from.
+     */
+    void Serialize(BinaryArchive& ar)
+    {
+      ar(instUpdatePolicy);
+      ar(steps);
+      ar(parent.count);
+      ar(parent.average.template As<MatType>());
+    }
+
+   private:
+    //! Instantiated parent object.
+    const IterateAveraging& parent;
+
+    //! The update policy instantiated for the given matrix types.
+    typename UpdatePolicyType::template Policy<MatType, GradType>
+        instUpdatePolicy;
+
+    //! The number of update steps taken.
+    size_t steps;
+  };
+
+  /**
+   * Get the average of the iterates of the last optimization, which must have
+   * used the given matrix type.  If no iterate was averaged yet, the matrix is
+   * empty.
+   */
+  template<typename MatType = arma::mat>
+  const MatType& Average() const
+  {
+    if (!average.Has<MatType>())
+    {
+      throw std::logic_error("IterateAveraging::Average(): no average of the "
+          "given matrix type is held!");
+    }
+
+    return average.As<MatType>();
+  }
+
+  //! Get the number of iterates in the average.
+  size_t Count() const { return count; }
+
+  //! Get the update policy.
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  //! Modify the update policy.
+  UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
+
+  //! Get the number of steps before the averaging starts.
+  size_t Start() const { return start; }
+  //! Modify the number of steps before the averaging starts.
+  size_t& Start() { return start; }
+
+  //! Get the number of steps between two averaged iterates.
+  size_t Frequency() const { return frequency; }
+  //! Modify the number of steps between two averaged iterates.
+  size_t& Frequency() { return frequency; }
+
+ private:
+  //! An instance of the UpdatePolicy used for actual optimization.
+  UpdatePolicyType updatePolicy;
+
+  //! The number of steps before the averaging starts.
+  size_t start;
+
+  //! The number of steps between two averaged iterates.
+  size_t frequency;
+
+  //! The average of the iterates, held by the instantiated policy.
+  mutable Any average;
+
+  //! The number of iterates in the average.
+  mutable size_t count;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,205 @@
+/**
+ * @file lars_update.hpp
+ *
+ * Layer-wise adaptive rate scaling (LARS) update for Stochastic Gradient
+ * Descent.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_LARS_UPDATE_HPP
+#define ENSMALLEN_SGD_LARS_UPDATE_HPP
+
+#include <ensmallen_bits/utility/trust_ratio.hpp>
+
+namespace ens {
+
+/**
+ * LARS scales the step of each block of the iterate (for instance each layer
+ * of a network) by a trust ratio, the ratio of the norm of the block to the
+ * norm of its gradient, so that every block moves by about the same relative
+ * amount.  This keeps SGD with momentum stable with very large batches (and
+ * the correspondingly large step sizes), where a single global step size
+ * would make the blocks with small weights and large gradients diverge:
+ *
+ * \f[
+ * \lambda_b = \eta \frac{\|w_b\|}{\|\nabla f(w)_b\| + \beta \|w_b\|} \\
+ * v_b = \mu v_b + \alpha \lambda_b (\nabla f(w)_b + \beta w_b) \\
+ * w_b = w_b - v_b
+ * \f]
+ *
+ * where \f$ \eta \f$ is the trust coefficient, \f$ \beta \f$ the weight decay
+ * and \f$ \mu \f$ the momentum (\f$ \lambda_b = 1 \f$ for a block whose weights
+ * or gradient are zero).  The blocks are the blockRows x blockCols
+ * submatrices of the iterate (see ForEachBlock()); the default is one block.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @article{You2017,
+ *   title   = {Large Batch Training of Convolutional Networks},
+ *   author  = {You, Yang and Gitman, Igor and Ginsburg, Boris},
+ *   journal = {arXiv preprint arXiv:1708.03888},
+ *   year    = {2017}
+ * }
+ * @endcode
+ */
+class LARSUpdate
+{
+ public:
+  /**
+   * Construct the LARS update policy with the given parameters.
+   *
+   * @param momentum The momentum decay hyperparameter.
+   * @param trustCoefficient The trust coefficient (eta), which scales the
+   *     trust ratio of every block.
+   * @param weightDecay The weight decay (L2 regularization) rate.
+   * @param blockRows Number of rows of a block (0 for all rows).
+   * @param blockCols Number of columns of a block (0 for all columns).
+   */
+  LARSUpdate(const double momentum = 0.9,
+             const double trustCoefficient = 0.001,
+             const double weightDecay = 0.0005,
+             const size_t blockRows = 0,
+             const size_t blockCols = 0) :
+      momentum(momentum),
+      trustCoefficient(trustCoefficient),
+      weightDecay(weightDecay),
+      blockRows(blockRows),
+      blockCols(blockCols)
+  { /* Nothing to do. */ }
+
+  //! Get the momentum decay hyperparameter.
+  double Momentum() const { return momentum; }
+  //! Modify the momentum decay hyperparameter.
+  double& Momentum() { return momentum; }
+
+  //! Get the trust coefficient.
+  double TrustCoefficient() const { return trustCoefficient; }
+  //! Modify the trust coefficient.
+  double& TrustCoefficient() { return trustCoefficient; }
+
+  //! Get the weight decay rate.
+  double WeightDecay() const { return weightDecay; }
+  //! Modify the weight decay rate.
+  double& WeightDecay() { return weightDecay; }
+
+  //! Get the number of rows of a block (0 for all rows).
+  size_t BlockRows() const { return blockRows; }
+  //! Modify the number of rows of a block (0 for all rows).
+  size_t& BlockRows() { return blockRows; }
+
+  //! Get the number of columns of a block (0 for all columns).
+  size_t BlockCols() const { return blockCols; }
+  //! Modify the number of columns of a block (0 for all columns).
+  size_t& BlockCols() { return blockCols; }
+
+  //! Get the number of bytes of the state (the velocity and the update
+  //! direction) for an iterate of the given size.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
+  {
+    return 2 * rows * cols * elemSize;
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.  The velocity and the buffer of the regularized gradient
+     * have the shape of the gradient.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const LARSUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent)
+    {
+      velocity.zeros(rows, cols);
+      direction.zeros(rows, cols);
+    }
+
+    /**
+     * Update step for LARS: the momentum step of each block is scaled by its
+     * trust ratio.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      direction = gradient;
+      ForEachBlock(iterate.n_rows, iterate.n_cols, parent.blockRows,
+          parent.blockCols, [&](const size_t r0, const size_t c0,
+                                const size_t r1, const size_t c1)
+      {
+        const double weightNorm = BlockNorm(iterate, r0, c0, r1, c1);
+        const double gradientNorm = BlockNorm(direction, r0, c0, r1, c1);
+        const double ratio = TrustRatio(weightNorm, gradientNorm +
+            parent.weightDecay * weightNorm, parent.trustCoefficient);
+
+        direction.submat(r0, c0, r1, c1) += parent.weightDecay *
+            iterate.submat(r0, c0, r1, c1);
+        velocity.submat(r0, c0, r1, c1) *= parent.momentum;
+        velocity.submat(r0, c0, r1, c1) += (stepSize * ratio) *
+            direction.submat(r0, c0, r1, c1);
+        iterate.submat(r0, c0, r1, c1) -= velocity.submat(r0, c0, r1, c1);
+      });
+    }
+
+    /**
+     * Save or load the state of the policy, to resume an optimization.
+     *
+     * @param ar Archive to save into or load from.
+     */
+    void Serialize(BinaryArchive& ar)
+    {
+      ar(velocity);
+    }
+
+   private:
+    //! Instantiated parent object.
+    const LARSUpdate& parent;
+
+    //! The velocity matrix.
+    MatType velocity;
+
+    //! The regularized gradient of the current step.
+    MatType direction;
+  };
+
+ private:
+  //! The momentum decay hyperparameter.
+  double momentum;
+
+  //! The trust coefficient.
+  double trustCoefficient;
+
+  //! The weight decay rate.
+  double weightDecay;
+
+  //! The number of rows of a block.
+  size_t blockRows;
+
+  //! The number of columns of a block.
+  size_t blockCols;
+};
+
+} // namespace ens
+
+#endif
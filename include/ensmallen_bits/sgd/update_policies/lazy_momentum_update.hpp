@@ -0,0 +1,151 @@
+/**
+ * @file lazy_momentum_update.hpp
+ *
+ * Lazy momentum update for sparse gradients: only the velocity and parameters
+ * of the coordinates with a nonzero gradient are updated.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_LAZY_MOMENTUM_UPDATE_HPP
+#define ENSMALLEN_SGD_LAZY_MOMENTUM_UPDATE_HPP
+
+#include "momentum_update.hpp"
+
+namespace ens {
+
+/**
+ * LazyMomentumUpdate is a variant of the momentum update for functions with
+ * sparse gradients (arma::sp_mat).  With a dense gradient it is the same as
+ * MomentumUpdate.  With a sparse gradient, only the coordinates with a nonzero
+ * gradient are updated, so each step costs time proportional to the number of
+ * nonzeros of the gradient instead of the number of parameters.
+ *
+ * As in LazyAdamUpdate, the decay of the velocity is deferred: each coordinate
+ * remembers the last iteration in which it was updated, and when its gradient
+ * is next nonzero the missed decay steps are applied at once, so its velocity
+ * is the same as with MomentumUpdate.  Unlike MomentumUpdate, a coordinate is
+ * not moved by its velocity in the iterations in which its gradient is zero.
+ */
+class LazyMomentumUpdate : public MomentumUpdate
+{
+ public:
+  /**
+   * Construct the lazy momentum update policy with the given momentum decay
+   * parameter.
+   *
+   * @param momentum The momentum decay hyperparameter.
+   */
+  LazyMomentumUpdate(const double momentum = 0.5) : MomentumUpdate(momentum)
+  { /* Do nothing. */ }
+
+  /**
+   * The lazy momentum policy for dense gradients is the momentum policy.
+   */
+  template<typename MatType, typename GradType>
+  class Policy : public MomentumUpdate::Policy<MatType, GradType>
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const LazyMomentumUpdate& parent,
+           const size_t rows,
+           const size_t cols) :
+        MomentumUpdate::Policy<MatType, GradType>(parent, rows, cols)
+    { /* Do nothing. */ }
+  };
+
+  /**
+   * The lazy momentum policy for sparse gradients, which only visits the
+   * nonzero elements of the gradient.
+   */
+  template<typename MatType, typename eT>
+  class Policy<MatType, arma::SpMat<eT>>
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const LazyMomentumUpdate& parent,
+           const size_t rows,
+           const size_t cols) :
+        parent(parent),
+        velocity(arma::zeros<MatType>(rows, cols)),
+        lastIteration(arma::zeros<arma::umat>(rows, cols)),
+        iteration(0)
+    { /* Do nothing. */ }
+
+    /**
+     * Update step for SGD with a sparse gradient.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The sparse gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const arma::SpMat<eT>& gradient)
+    {
+      ++iteration;
+
+      const double momentum = parent.Momentum();
+      typename arma::SpMat<eT>::const_iterator it = gradient.begin();
+      for ( ; it != gradient.end(); ++it)
+      {
+        const size_t row = it.row();
+        const size_t col = it.col();
+
+        // Catch up on the decay of the iterations this coordinate missed.
+        const double missed = (double) (iteration - lastIteration(row, col));
+        lastIteration(row, col) = iteration;
+
+        velocity(row, col) = std::pow(momentum, missed) * velocity(row, col) -
+            stepSize * (*it);
+        iterate(row, col) += velocity(row, col);
+      }
+    }
+
+    /**
+     * Save or load the state of the policy, to resume an optimization.
+     *
+     * @param ar Archive to save into or load from.
+     */
+    void Serialize(BinaryArchive& ar)
+    {
+      ar(velocity);
+      ar(lastIteration);
+      ar(iteration);
+    }
+
+   private:
+    // Instantiated parent object.
+    const LazyMomentumUpdate& parent;
+
+    // The velocity, as of the last iteration in which each coordinate was
+    // updated.
+    MatType velocity;
+
+    // The last iteration in which each coordinate was updated.
+    arma::umat lastIteration;
+
+    // The number of iterations.
+    size_t iteration;
+  };
+};
+
+} // namespace ens
+
+#endif
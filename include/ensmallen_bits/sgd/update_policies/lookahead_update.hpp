@@ -0,0 +1,204 @@
+/**
+ * @file lookahead_update.hpp
+ *
+ * Lookahead wrapper for update policies.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_LOOKAHEAD_UPDATE_HPP
+#define ENSMALLEN_SGD_LOOKAHEAD_UPDATE_HPP
+
+#include "vanilla_update.hpp"
+
+namespace ens {
+
+/**
+ * Interface for wrapping around update policies (e.g., AdamUpdate or
+ * MomentumUpdate) to make them Lookahead optimizers.  The wrapped policy
+ * updates the iterate (the "fast weights") as usual, and a copy of the
+ * iterate taken every k steps (the "slow weights") follows it: after every k
+ * steps of the wrapped policy,
+ *
+ * \f[
+ * \phi_{t + 1} = \phi_t + \alpha (\theta_{t, k} - \phi_t), \qquad
+ * \theta_{t + 1, 0} = \phi_{t + 1},
+ * \f]
+ *
+ * so the fast weights restart from the interpolated slow weights.  The slow
+ * weights are the only extra buffer, and they are only touched once every k
+ * steps, in one pass over the iterate; the state of the wrapped policy (e.g.
+ * the moments of Adam) is kept across the synchronizations.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{zhang2019lookahead,
+ *   title     = {Lookahead Optimizer: k steps forward, 1 step back},
+ *   author    = {Zhang, Michael R. and Lucas, James and Hinton, Geoffrey and
+ *                Ba, Jimmy},
+ *   booktitle = {Advances in Neural Information Processing Systems},
+ *   year      = {2019}
+ * }
+ * @endcode
+ *
+ * @tparam UpdatePolicyType A type of UpdatePolicy that should be wrapped.
+ */
+template<typename UpdatePolicyType = VanillaUpdate>
+class LookaheadUpdate
+{
+ public:
+  /**
+   * Construct the LookaheadUpdate wrapper.
+   *
+   * @param updatePolicy An instance of the UpdatePolicyType used for the fast
+   *     weights.
+   * @param k Number of steps of the wrapped policy between two updates of the
+   *     slow weights.
+   * @param alpha Step size of the slow weights, in (0, 1].
+   */
+  LookaheadUpdate(const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
+                  const size_t k = 5,
+                  const double alpha = 0.5) :
+      updatePolicy(updatePolicy),
+      k(k),
+      alpha(alpha)
+  {
+    // Nothing to do.
+  }
+
+  //! Get the number of bytes of the state (the slow weights and the state of
+  //! the wrapped policy) for an iterate of the given size.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
+  {
+    return rows * cols * elemSize +
+        updatePolicy.EstimateStateBytes(rows, cols, elemSize);
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.  The wrapped policy is instantiated; the slow weights are
+     * taken from the iterate at the first update.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const LookaheadUpdate& parent,
+           const size_t rows,
+           const size_t cols) :
+        parent(parent),
+        instUpdatePolicy(parent.updatePolicy, rows, cols),
+        steps(0)
+    {
+      if (parent.k == 0)
+      {
+        throw std::invalid_argument("LookaheadUpdate::Policy(): k must be "
+            "positive!");
+      }
+
+      if (parent.alpha <= 0.0 || parent.alpha > 1.0)
+      {
+        throw std::invalid_argument("LookaheadUpdate::Policy(): alpha must be "
+            "in (0, 1]!");
+      }
+    }
+
+    /**
+     * Update step.  The wrapped policy updates the fast weights, and every k
+     * steps the slow weights are moved towards them and copied back into the
+     * iterate.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      if (steps == 0)
+        slowWeights = iterate;
+
+      instUpdatePolicy.Update(iterate, stepSize, gradient);
+
+      if (++steps % parent.k == 0)
+      {
+        slowWeights += ElemType(parent.alpha) * (iterate - slowWeights);
+        iterate = slowWeights;
+      }
+    }
+
+    /**
+     * Save or load the state of the policy: the state of the wrapped policy,
+     * the number of steps taken and the slow weights.
+     *
+     * @param ar Archive to save into or load from.
+     */
+    void Serialize(BinaryArchive& ar)
+    {
+      ar(instUpdatePolicy);
+      ar(steps);
+      ar(slowWeights);
+    }
+
+   private:
+    //! Instantiated parent object.
+    const LookaheadUpdate& parent;
+
+    //! The update policy instantiated for the given matrix types.
+    typename UpdatePolicyType::template Policy<MatType, GradType>
+        instUpdatePolicy;
+
+    //! The slow weights.
+    MatType slowWeights;
+
+    //! The number of update steps taken.
+    size_t steps;
+  };
+
+  //! Get the update policy.
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  //! Modify the update policy.
+  UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
+
+  //! Get the number of steps between two updates of the slow weights.
+  size_t K() const { return k; }
+  //! Modify the number of steps between two updates of the slow weights.
+  size_t& K() { return k; }
+
+  //! Get the step size of the slow weights.
+  double Alpha() const { return alpha; }
+  //! Modify the step size of the slow weights.
+  double& Alpha() { return alpha; }
+
+ private:
+  //! An instance of the UpdatePolicy used for the fast weights.
+  UpdatePolicyType updatePolicy;
+
+  //! The number of steps between two updates of the slow weights.
+  size_t k;
+
+  //! The step size of the slow weights.
+  double alpha;
+};
+
+} // namespace ens
+
+#endif
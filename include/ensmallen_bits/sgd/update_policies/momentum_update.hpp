@@ -69,43 +69,124 @@ class MomentumUpdate
   MomentumUpdate(const double momentum = 0.5) : momentum(momentum)
   { /* Do nothing. */ };
 
+  //! Get the value used to initialize the momentum coefficient.
+  double Momentum() const { return momentum; }
+  //! Modify the value used to initialize the momentum coefficient.
+  double& Momentum() { return momentum; }
+
+  //! Get the number of bytes of the state (the velocity) for an iterate of
+  //! the given size.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
+  {
+    return rows * cols * elemSize;
+  }
+
   /**
-   * The Initialize method is called by SGD Optimizer method before the start of
-   * the iteration update process.  In the momentum update policy the velocity
-   * matrix is initialized to the zeros matrix with the same size as the
-   * gradient matrix (see ens::SGD<>).
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
    */
-  void Initialize(const size_t rows, const size_t cols)
+  template<typename MatType, typename GradType>
+  class Policy
   {
-    // Initialize am empty velocity matrix.
-    velocity = arma::zeros<arma::mat>(rows, cols);
-  }
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.  In the momentum update policy the velocity matrix is
+     * initialized to the zeros matrix with the same size as the gradient
+     * matrix (see ens::SGD<>).
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const MomentumUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent)
+    {
+      velocity.zeros(rows, cols);
+    }
+
+    /**
+     * Update step for SGD.  The momentum term makes the convergence faster on
+     * the way as momentum term increases for dimensions pointing in the same
+     * and reduces updates for dimensions whose gradients change directions.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      velocity = parent.momentum * velocity - stepSize * gradient;
+      iterate += velocity;
+    }
+
+    /**
+     * Save or load the state of the policy, to resume an optimization.
+     *
+     * @param ar Archive to save into or load from.
+     */
+    void Serialize(BinaryArchive& ar)
+    {
+      ar(velocity);
+    }
+
+   private:
+    // Instantiated parent object.
+    const MomentumUpdate& parent;
+
+    // The velocity matrix.
+    MatType velocity;
+  };
 
   /**
-   * Update step for SGD.  The momentum term makes the convergence faster on the
-   * way as momentum term increases for dimensions pointing in the same and
-   * reduces updates for dimensions whose gradients change directions.
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
+   * The element-wise kernel of the momentum update, used to fuse it with other
+   * policies into one loop (see FusedUpdate).
    */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
+  template<typename ElemType>
+  class Kernel
   {
-    velocity = momentum * velocity - stepSize * gradient;
-    iterate += velocity;
-  }
+   public:
+    //! Create the kernel for an iterate with n elements, with zero velocity.
+    Kernel(const MomentumUpdate& parent, const size_t n) :
+        momentum(parent.momentum),
+        step(0)
+    {
+      velocity.zeros(n, 1);
+    }
+
+    //! Start a step with the given step size.
+    void Begin(const double stepSize) { step = stepSize; }
+
+    //! Update element i of the iterate with element g of the gradient.
+    void Apply(const size_t i, ElemType& x, ElemType& g)
+    {
+      velocity[i] = momentum * velocity[i] - step * g;
+      x += velocity[i];
+    }
+
+    //! Save or load the state of the kernel.
+    void Serialize(BinaryArchive& ar) { ar(velocity); }
+
+   private:
+    //! The momentum hyperparameter.
+    ElemType momentum;
+
+    //! The step size of the current step.
+    ElemType step;
+
+    //! The velocity of each element.
+    arma::Mat<ElemType> velocity;
+  };
 
  private:
   // The momentum hyperparamter
   double momentum;
-  // The velocity matrix.
-  arma::mat velocity;
 };
 
 } // namespace ens
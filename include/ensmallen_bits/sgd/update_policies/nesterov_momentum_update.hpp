@@ -44,48 +44,86 @@ class NesterovMomentumUpdate
     // Nothing to do.
   }
 
-  /**
-   * The Initialize method is called by SGD Optimizer method before the start of
-   * the iteration update process.  In the momentum update policy the velocity
-   * matrix is initialized to the zeros matrix with the same size as the
-   * gradient matrix (see ens::SGD<>).
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
-   */
-  void Initialize(const size_t rows, const size_t cols)
+  //! Get the value used to initialize the momentum coefficient.
+  double Momentum() const { return momentum; }
+  //! Modify the value used to initialize the momentum coefficient.
+  double& Momentum() { return momentum; }
+
+  //! Get the number of bytes of the state (the velocity) for an iterate of
+  //! the given size.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
   {
-    // Initialize an empty velocity matrix.
-    velocity = arma::zeros<arma::mat>(rows, cols);
+    return rows * cols * elemSize;
   }
 
   /**
-   * Update step for SGD.  The momentum term makes the convergence faster on the
-   * way as momentum term increases for dimensions pointing in the same direction
-   * and reduces updates for dimensions whose gradients change directions.
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
    */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
+  template<typename MatType, typename GradType>
+  class Policy
   {
-    velocity = momentum * velocity - stepSize * gradient;
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.  In the momentum update policy the velocity matrix is
+     * initialized to the zeros matrix with the same size as the gradient
+     * matrix (see ens::SGD<>).
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const NesterovMomentumUpdate& parent,
+           const size_t rows,
+           const size_t cols) :
+        parent(parent)
+    {
+      velocity.zeros(rows, cols);
+    }
 
-    iterate += momentum * velocity - stepSize * gradient;
-  }
+    /**
+     * Update step for SGD.  The momentum term makes the convergence faster on
+     * the way as momentum term increases for dimensions pointing in the same
+     * direction and reduces updates for dimensions whose gradients change
+     * directions.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      velocity = parent.momentum * velocity - stepSize * gradient;
 
-  //! Get the value used to initialize the momentum coefficient.
-  double Momentum() const { return momentum; }
-  //! Modify the value used to initialize the momentum coefficient.
-  double& Momentum() { return momentum; }
+      iterate += parent.momentum * velocity - stepSize * gradient;
+    }
 
- private:
-  // The velocity matrix.
-  arma::mat velocity;
+    /**
+     * Save or load the state of the policy, to resume an optimization.
+     *
+     * @param ar Archive to save into or load from.
+     */
+    void Serialize(BinaryArchive& ar)
+    {
+      ar(velocity);
+    }
+
+   private:
+    // Instantiated parent object.
+    const NesterovMomentumUpdate& parent;
 
+    // The velocity matrix.
+    MatType velocity;
+  };
+
+ private:
   // The Momentum coefficient.
   double momentum;
 };
@@ -0,0 +1,225 @@
+/**
+ * @file parallel_update.hpp
+ *
+ * Wrapper for update policies that splits the iterate into contiguous chunks
+ * and updates them in parallel with OpenMP.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_PARALLEL_UPDATE_HPP
+#define ENSMALLEN_SGD_PARALLEL_UPDATE_HPP
+
+#include <vector>
+
+namespace ens {
+
+/**
+ * Interface for wrapping around update policies (e.g., MomentumUpdate) and
+ * running their Update() on several threads at once.  The iterate is viewed
+ * as one long column and split into contiguous chunks; each chunk gets its own
+ * instance of the wrapped policy (holding only that chunk's part of the
+ * policy's state), and the chunks are updated in parallel.  For very large
+ * iterates, a single thread cannot saturate the memory bandwidth during the
+ * update, so this lets the update step scale with the number of cores.
+ *
+ * This is only correct for element-wise update policies, where each element of
+ * the iterate is updated using only the same element of the gradient and of
+ * the policy's state.  That is the case for VanillaUpdate, MomentumUpdate,
+ * NesterovMomentumUpdate, AdaDeltaUpdate, AdaGradUpdate, RMSPropUpdate,
+ * SMORMS3Update, FTMLUpdate, PadamUpdate and the Adam family, but not for
+ * policies that use a norm of the whole gradient (such as WNGradUpdate).
+ *
+ * Chunks are only split off for dense iterates and gradients of the same type;
+ * for other types (e.g. sparse gradients), and when OpenMP is not enabled, the
+ * wrapped policy is simply run on the whole iterate.
+ *
+ * @tparam UpdatePolicyType A type of UpdatePolicy that should be wrapped.
+ */
+template<typename UpdatePolicyType>
+class ParallelUpdate
+{
+ public:
+  /**
+   * Construct the ParallelUpdate wrapper.
+   *
+   * @param updatePolicy An instance of the UpdatePolicyType used for the
+   *     actual update of each chunk.
+   * @param numChunks Number of chunks to split the iterate into (0 means the
+   *     maximum number of OpenMP threads).
+   * @param minChunkSize Minimum number of elements in a chunk; smaller
+   *     iterates are split into fewer chunks.
+   */
+  ParallelUpdate(const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
+                 const size_t numChunks = 0,
+                 const size_t minChunkSize = 65536) :
+      updatePolicy(updatePolicy),
+      numChunks(numChunks),
+      minChunkSize(minChunkSize)
+  {
+    // Nothing to do.
+  }
+
+  //! Get the number of bytes of the state (that of the wrapped policy, split
+  //! into chunks) for an iterate of the given size.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
+  {
+    return updatePolicy.EstimateStateBytes(rows, cols, elemSize);
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.  Here the iterate is split into chunks, and the wrapped
+     * policy is instantiated for each of them.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const ParallelUpdate& parent,
+           const size_t rows,
+           const size_t cols)
+    {
+      const size_t chunks = IsFusableUpdate<MatType, GradType>::value ?
+          parent.ChunkCount(rows * cols) : 1;
+
+      if (chunks == 1)
+      {
+        // Use the wrapped policy on the whole iterate.
+        chunkBegin.push_back(0);
+        policies.emplace_back(parent.updatePolicy, rows, cols);
+      }
+      else
+      {
+        policies.reserve(chunks);
+        for (size_t c = 0; c < chunks; ++c)
+        {
+          const size_t begin = (c * rows * cols) / chunks;
+          const size_t end = ((c + 1) * rows * cols) / chunks;
+          chunkBegin.push_back(begin);
+          policies.emplace_back(parent.updatePolicy, end - begin, 1);
+        }
+      }
+      chunkBegin.push_back(rows * cols);
+    }
+
+    /**
+     * Update step.  Each chunk of the iterate is updated by its own instance of
+     * the wrapped policy, in parallel.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      if (policies.size() == 1)
+        policies[0].Update(iterate, stepSize, gradient);
+      else
+        UpdateChunks(iterate, stepSize, gradient,
+            IsFusableUpdate<MatType, GradType>());
+    }
+
+   private:
+    //! Update every chunk, in parallel.
+    void UpdateChunks(MatType& iterate,
+                      const double stepSize,
+                      const GradType& gradient,
+                      std::true_type /* fusable */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      #ifdef ENS_USE_OPENMP
+        #pragma omp parallel for schedule(static)
+      #endif
+      for (size_t c = 0; c < policies.size(); ++c)
+      {
+        const size_t begin = chunkBegin[c];
+        const size_t length = chunkBegin[c + 1] - begin;
+
+        // Alias the chunk of the iterate and of the gradient.
+        MatType iterateChunk(iterate.memptr() + begin, length, 1, false, true);
+        const GradType gradientChunk(const_cast<ElemType*>(
+            gradient.memptr()) + begin, length, 1, false, true);
+
+        policies[c].Update(iterateChunk, stepSize, gradientChunk);
+      }
+    }
+
+    //! Other types are never split into chunks.
+    void UpdateChunks(MatType& /* iterate */,
+                      const double /* stepSize */,
+                      const GradType& /* gradient */,
+                      std::false_type /* fusable */)
+    { }
+
+    //! The wrapped policy instantiated for each chunk.
+    std::vector<typename UpdatePolicyType::template Policy<MatType, GradType>>
+        policies;
+
+    //! The first element of each chunk, followed by the number of elements.
+    std::vector<size_t> chunkBegin;
+  };
+
+  //! Get the update policy.
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  //! Modify the update policy.
+  UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
+
+  //! Get the number of chunks (0 means the maximum number of threads).
+  size_t NumChunks() const { return numChunks; }
+  //! Modify the number of chunks (0 means the maximum number of threads).
+  size_t& NumChunks() { return numChunks; }
+
+  //! Get the minimum number of elements in a chunk.
+  size_t MinChunkSize() const { return minChunkSize; }
+  //! Modify the minimum number of elements in a chunk.
+  size_t& MinChunkSize() { return minChunkSize; }
+
+ private:
+  //! Get the number of chunks to split an iterate of the given size into.
+  size_t ChunkCount(const size_t elements) const
+  {
+    // Without OpenMP, explicitly requested chunks are updated one after the
+    // other.
+    #ifdef ENS_USE_OPENMP
+      const size_t maxChunks = (numChunks == 0) ?
+          (size_t) omp_get_max_threads() : numChunks;
+    #else
+      const size_t maxChunks = (numChunks == 0) ? 1 : numChunks;
+    #endif
+
+    const size_t usefulChunks = elements /
+        std::max(minChunkSize, (size_t) 1);
+    return std::max(std::min(maxChunks, usefulChunks), (size_t) 1);
+  }
+
+  //! An instance of the UpdatePolicy used for actual optimization.
+  UpdatePolicyType updatePolicy;
+
+  //! The number of chunks to split the iterate into.
+  size_t numChunks;
+
+  //! The minimum number of elements in a chunk.
+  size_t minChunkSize;
+};
+
+} // namespace ens
+
+#endif
@@ -28,32 +28,136 @@ namespace ens {
 class VanillaUpdate
 {
  public:
+  //! The vanilla update has no state; this returns 0 for any iterate.
+  size_t EstimateStateBytes(const size_t /* rows */,
+                            const size_t /* cols */,
+                            const size_t /* elemSize */ = sizeof(double)) const
+  {
+    return 0;
+  }
+
   /**
-   * The Initialize method is called by SGD Optimizer method before the start of
-   * the iteration update process.  The vanilla update doesn't initialize
-   * anything.
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
    */
-  void Initialize(const size_t /* rows */, const size_t /* cols */)
-  { /* Do nothing. */ }
-
- /**
-  * Update step for SGD.  The function parameters are updated in the negative
-  * direction of the gradient.
-  *
-  * @param iterate Parameters that minimize the function.
-  * @param stepSize Step size to be used for the given iteration.
-  * @param gradient The gradient matrix.
-  */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
+  template<typename MatType, typename GradType>
+  class Policy
   {
-    // Perform the vanilla SGD update.
-    iterate -= stepSize * gradient;
-  }
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.  The vanilla update doesn't initialize anything.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const VanillaUpdate& /* parent */,
+           const size_t /* rows */,
+           const size_t /* cols */)
+    { /* Do nothing. */ }
+
+    /**
+     * Update step for SGD.  The function parameters are updated in the
+     * negative direction of the gradient.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      // Perform the vanilla SGD update.
+      iterate -= stepSize * gradient;
+    }
+
+    /**
+     * Save or load the state of the policy (the vanilla update has none).
+     *
+     * @param ar Archive to save into or load from.
+     */
+    void Serialize(BinaryArchive& /* ar */) { }
+  };
+
+  /**
+   * The element-wise kernel of the vanilla update, used to fuse it with other
+   * policies into one loop (see FusedUpdate).
+   */
+  template<typename ElemType>
+  class Kernel
+  {
+   public:
+    //! Create the kernel for an iterate with n elements (it has no state).
+    Kernel(const VanillaUpdate& /* parent */, const size_t /* n */) : step(0)
+    { /* Do nothing. */ }
+
+    //! Start a step with the given step size.
+    void Begin(const double stepSize) { step = stepSize; }
+
+    //! Update element i of the iterate with element g of the gradient.
+    void Apply(const size_t /* i */, ElemType& x, ElemType& g) const
+    {
+      x -= step * g;
+    }
+
+    //! Save or load the state of the kernel (it has none).
+    void Serialize(BinaryArchive& /* ar */) { }
+
+   private:
+    //! The step size of the current step.
+    ElemType step;
+  };
+
+  /**
+   * The vanilla update for sparse gradients (arma::sp_mat), which only visits
+   * the nonzero elements of the gradient, so each step costs time
+   * proportional to the number of nonzeros instead of the number of
+   * parameters.
+   */
+  template<typename MatType, typename eT>
+  class Policy<MatType, arma::SpMat<eT>>
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.  The vanilla update doesn't initialize anything.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const VanillaUpdate& /* parent */,
+           const size_t /* rows */,
+           const size_t /* cols */)
+    { /* Do nothing. */ }
+
+    /**
+     * Update step for SGD with a sparse gradient.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The sparse gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const arma::SpMat<eT>& gradient)
+    {
+      typename arma::SpMat<eT>::const_iterator it = gradient.begin();
+      for ( ; it != gradient.end(); ++it)
+        iterate(it.row(), it.col()) -= stepSize * (*it);
+    }
+
+    /**
+     * Save or load the state of the policy (the vanilla update has none).
+     *
+     * @param ar Archive to save into or load from.
+     */
+    void Serialize(BinaryArchive& /* ar */) { }
+  };
 };
 
 } // namespace ens
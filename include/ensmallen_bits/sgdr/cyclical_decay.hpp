@@ -15,6 +15,8 @@
 #ifndef ENSMALLEN_SGDR_CYCLICAL_DECAY_HPP
 #define ENSMALLEN_SGDR_CYCLICAL_DECAY_HPP
 
+#include "plateau_detector.hpp"
+
 namespace ens {
 
 /**
@@ -23,6 +25,11 @@ namespace ens {
  * emulated by increasing the step size while the old step size value of as an
  * initial parameter.
  *
+ * Optionally, a restart is also triggered early when the running objective of
+ * the batches stops improving for plateauPatience batches (see
+ * PlateauDetector), instead of annealing through the plateau until the end of
+ * the cycle; the next cycle is still multFactor times longer.
+ *
  * For more information, please refer to:
  *
  * @code
@@ -50,11 +57,18 @@ class CyclicalDecay
    * @param numFunctions The number of separable functions (the number of
    *        predictor points).
    * @param stepSizeMin Final step size before each restart
+   * @param plateauPatience Number of batches without improvement of the
+   *        running objective that trigger an early restart (0 disables early
+   *        restarts).
+   * @param plateauTolerance Relative decrease of the running objective that
+   *        counts as an improvement.
    */
   CyclicalDecay(const size_t epochRestart = 50,
                 const double multFactor = 2,
                 const double stepSizeMax = 0.01,
-                const double stepSizeMin = 0) :
+                const double stepSizeMin = 0,
+                const size_t plateauPatience = 0,
+                const double plateauTolerance = 1e-3) :
       epochRestart(epochRestart),
       multFactor(multFactor),
       stepSizeMax(stepSizeMax),
@@ -62,9 +76,24 @@ class CyclicalDecay
       batchRestart(0),
       epochBatches(epochRestart),
       epoch(0),
-      stepSizeMin(stepSizeMin)
+      stepSizeMin(stepSizeMin),
+      plateau(plateauPatience, plateauTolerance),
+      restartRequested(false)
   { /* Nothing to do here */ }
 
+  /**
+   * This function is called by SGD before Update() with the objective of the
+   * current batch, to detect plateaus.
+   *
+   * @param objective Objective of the batch.
+   * @param batchSize Number of functions in the batch.
+   */
+  void ObserveObjective(const double objective, const size_t batchSize)
+  {
+    if (plateau.Observe(objective / batchSize))
+      restartRequested = true;
+  }
+
   /**
    * This function is called in each iteration after the policy update.
    *
@@ -72,19 +101,22 @@ class CyclicalDecay
    * @param stepSize Step size to be used for the given iteration.
    * @param gradient The gradient matrix.
    */
-  void Update(arma::mat& /* iterate */,
+  template<typename MatType, typename GradType>
+  void Update(MatType& /* iterate */,
               double& stepSize,
-              const arma::mat& /* gradient */)
+              const GradType& /* gradient */)
   {
-    if (epoch >= nextRestart)
+    if (epoch >= nextRestart || restartRequested)
     {
       batchRestart = 0;
+      restartRequested = false;
+      plateau.Reset();
 
       // Adjust the period of restarts.
       epochRestart *= multFactor;
 
       // Update the time for the next restart.
-      nextRestart += epochRestart;
+      nextRestart = epoch + epochRestart;
     }
     // Time to adjust the step size.
     if (epoch < nextRestart)
@@ -101,6 +133,21 @@ class CyclicalDecay
     epoch++;
   }
 
+  /**
+   * Save or load the position of the decay policy in its restart schedule.
+   *
+   * @param ar Archive to save into or load from.
+   */
+  void Serialize(BinaryArchive& ar)
+  {
+    ar(epochRestart);
+    ar(nextRestart);
+    ar(batchRestart);
+    ar(epoch);
+    ar(plateau);
+    ar(restartRequested);
+  }
+
   //! Get the minimum step size.
   double StepSizeMin() const { return stepSizeMin; }
   //! Modify the minimum step size.
@@ -126,6 +173,18 @@ class CyclicalDecay
   //! Modify the epoch Restart
   size_t& EpochRestart() { return epochRestart; }
 
+  //! Get the number of batches on a plateau that trigger an early restart.
+  size_t PlateauPatience() const { return plateau.Patience(); }
+  //! Modify the number of batches on a plateau that trigger an early restart.
+  size_t& PlateauPatience() { return plateau.Patience(); }
+
+  //! Get the relative decrease of the running objective that is an
+  //! improvement.
+  double PlateauTolerance() const { return plateau.Tolerance(); }
+  //! Modify the relative decrease of the running objective that is an
+  //! improvement.
+  double& PlateauTolerance() { return plateau.Tolerance(); }
+
  private:
   //! Epoch where decay is applied.
   size_t epochRestart;
@@ -150,6 +209,12 @@ class CyclicalDecay
 
   //! Locally-stored minimum step size.
   double stepSizeMin;
+
+  //! The detector of plateaus of the running objective.
+  PlateauDetector plateau;
+
+  //! Whether a plateau asked for an early restart.
+  bool restartRequested;
 };
 
 } // namespace ens
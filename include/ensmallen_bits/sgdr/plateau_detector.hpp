@@ -0,0 +1,136 @@
+/**
+ * @file plateau_detector.hpp
+ *
+ * Detection of plateaus of the running objective, used by the restart
+ * schedules to restart early.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGDR_PLATEAU_DETECTOR_HPP
+#define ENSMALLEN_SGDR_PLATEAU_DETECTOR_HPP
+
+namespace ens {
+
+/**
+ * Keep a running average of the objective of the batches, and detect when it
+ * has not improved for a given number of batches.  The running objective is
+ * an exponential moving average of the objective per function with a span of
+ * `patience` batches (a weight of 2 / (patience + 1) for each new batch), and
+ * it improves when it drops below the best value seen so far by more than
+ * `tolerance` times the magnitude of that value.  A patience of 0 disables the
+ * detection.
+ */
+class PlateauDetector
+{
+ public:
+  /**
+   * Create the plateau detector.
+   *
+   * @param patience Number of batches without improvement of the running
+   *     objective that make a plateau (0 disables the detection).
+   * @param tolerance Relative decrease of the running objective that counts as
+   *     an improvement.
+   */
+  PlateauDetector(const size_t patience = 0,
+                  const double tolerance = 1e-3) :
+      patience(patience),
+      tolerance(tolerance),
+      runningObjective(0.0),
+      bestObjective(DBL_MAX),
+      batches(0),
+      staleBatches(0)
+  { /* Nothing to do here. */ }
+
+  /**
+   * Add the objective per function of a batch to the running objective.  When
+   * a plateau is detected, true is returned and the detector is reset.
+   *
+   * @param objective Objective of the batch, divided by the batch size.
+   * @return true if the running objective is on a plateau.
+   */
+  bool Observe(const double objective)
+  {
+    if (patience == 0)
+      return false;
+
+    if (batches++ == 0)
+      runningObjective = objective;
+    else
+      runningObjective += 2.0 / (patience + 1) * (objective - runningObjective);
+
+    if (runningObjective < bestObjective - tolerance *
+        std::abs(bestObjective) || bestObjective == DBL_MAX)
+    {
+      bestObjective = runningObjective;
+      staleBatches = 0;
+      return false;
+    }
+
+    if (++staleBatches < patience)
+      return false;
+
+    Reset();
+    return true;
+  }
+
+  //! Forget the running objective, as after a restart.
+  void Reset()
+  {
+    runningObjective = 0.0;
+    bestObjective = DBL_MAX;
+    batches = 0;
+    staleBatches = 0;
+  }
+
+  /**
+   * Save or load the state of the detector.
+   *
+   * @param ar Archive to save into or load from.
+   */
+  void Serialize(BinaryArchive& ar)
+  {
+    ar(runningObjective);
+    ar(bestObjective);
+    ar(batches);
+    ar(staleBatches);
+  }
+
+  //! Get the number of batches without improvement that make a plateau.
+  size_t Patience() const { return patience; }
+  //! Modify the number of batches without improvement that make a plateau.
+  size_t& Patience() { return patience; }
+
+  //! Get the relative decrease that counts as an improvement.
+  double Tolerance() const { return tolerance; }
+  //! Modify the relative decrease that counts as an improvement.
+  double& Tolerance() { return tolerance; }
+
+  //! Get the running objective.
+  double RunningObjective() const { return runningObjective; }
+
+ private:
+  //! The number of batches without improvement that make a plateau.
+  size_t patience;
+
+  //! The relative decrease that counts as an improvement.
+  double tolerance;
+
+  //! The running objective.
+  double runningObjective;
+
+  //! The best running objective since the last reset.
+  double bestObjective;
+
+  //! The number of batches since the last reset.
+  size_t batches;
+
+  //! The number of batches since the last improvement.
+  size_t staleBatches;
+};
+
+} // namespace ens
+
+#endif
@@ -101,12 +101,21 @@ class SGDR
    * final objective value is returned.
    *
    * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to be optimized.
    * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
    * @return Objective value of the final point.
    */
-  template<typename DecomposableFunctionType>
-  double Optimize(DecomposableFunctionType& function, arma::mat& iterate);
+  template<typename DecomposableFunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(DecomposableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks);
 
   //! Get the batch size.
   size_t BatchSize() const { return optimizer.BatchSize(); }
@@ -133,6 +142,32 @@ class SGDR
   //! Modify the epoch restart
   size_t& EpochRestart() { return optimizer.DecayPolicy().EpochRestart(); }
 
+  //! Get the number of batches on a plateau of the running objective that
+  //! trigger an early restart (0 means no early restarts).
+  size_t PlateauPatience() const
+  {
+    return optimizer.DecayPolicy().PlateauPatience();
+  }
+  //! Modify the number of batches on a plateau of the running objective that
+  //! trigger an early restart (0 means no early restarts).
+  size_t& PlateauPatience()
+  {
+    return optimizer.DecayPolicy().PlateauPatience();
+  }
+
+  //! Get the relative decrease of the running objective that is an
+  //! improvement.
+  double PlateauTolerance() const
+  {
+    return optimizer.DecayPolicy().PlateauTolerance();
+  }
+  //! Modify the relative decrease of the running objective that is an
+  //! improvement.
+  double& PlateauTolerance()
+  {
+    return optimizer.DecayPolicy().PlateauTolerance();
+  }
+
   //! Get the maximum number of iterations (0 indicates no limit).
   size_t MaxIterations() const { return optimizer.MaxIterations(); }
   //! Modify the maximum number of iterations (0 indicates no limit).
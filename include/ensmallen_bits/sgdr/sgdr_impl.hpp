@@ -71,10 +71,14 @@ SGDR<UpdatePolicyType>::SGDR(
 { /* Nothing to do here */ }
 
 template<typename UpdatePolicyType>
-template<typename DecomposableFunctionType>
-double SGDR<UpdatePolicyType>::Optimize(
+template<typename DecomposableFunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename MatType::elem_type SGDR<UpdatePolicyType>::Optimize(
     DecomposableFunctionType& function,
-    arma::mat& iterate)
+    MatType& iterate,
+    CallbackTypes&&... callbacks)
 {
   // If a user changed the step size he hasn't update the step size of the
   // cyclical decay instantiation, so we have to do it here.
@@ -93,7 +97,9 @@ double SGDR<UpdatePolicyType>::Optimize(
     batchSize = optimizer.BatchSize();
   }
 
-  return optimizer.Optimize(function, iterate);
+  return optimizer.template Optimize<DecomposableFunctionType, MatType,
+      GradType, CallbackTypes...>(function, iterate,
+      std::forward<CallbackTypes>(callbacks)...);
 }
 
 } // namespace ens
@@ -14,6 +14,9 @@
 #ifndef ENSMALLEN_SGDR_SNAPSHOT_ENSEMBLES_HPP
 #define ENSMALLEN_SGDR_SNAPSHOT_ENSEMBLES_HPP
 
+#include "snapshot_store.hpp"
+#include "plateau_detector.hpp"
+
 namespace ens {
 
 /**
@@ -22,6 +25,17 @@ namespace ens {
  * emulated by increasing the step size while the old step size value of as an
  * initial parameter.
  *
+ * The snapshots are kept in a SnapshotStore, which can store them in single
+ * precision or in files instead of in memory, or keep only their running mean
+ * or the best few of them.  The objective of a snapshot is the running mean
+ * of the objectives of the batches over about the last epoch.
+ *
+ * Optionally, when the running objective of the batches stops improving for
+ * plateauPatience batches (see PlateauDetector), a snapshot is taken and the
+ * restart happens right away, instead of annealing through the plateau until
+ * the end of the cycle.  These snapshots are taken in addition to the ones of
+ * the last cycles of the schedule.
+ *
  * For more information, please refer to:
  *
  * @code
@@ -53,18 +67,33 @@ class SnapshotEnsembles
    * @param maxIterations Maximum number of iterations allowed (0 means no
    *        limit).
    * @param snapshots Maximum number of snapshots.
+   * @param store Storage for the snapshots.
+   * @param plateauPatience Number of batches without improvement of the
+   *        running objective that trigger a snapshot and an early restart (0
+   *        disables early restarts).
+   * @param plateauTolerance Relative decrease of the running objective that
+   *        counts as an improvement.
    */
   SnapshotEnsembles(const size_t epochRestart,
                     const double multFactor,
                     const double stepSize,
                     const size_t maxIterations,
-                    const size_t snapshots) :
+                    const size_t snapshots,
+                    const SnapshotStore& store = SnapshotStore(),
+                    const size_t plateauPatience = 0,
+                    const double plateauTolerance = 1e-3) :
     epochRestart(epochRestart),
     multFactor(multFactor),
     constStepSize(stepSize),
     nextRestart(epochRestart),
     batchRestart(0),
-    epoch(0)
+    epochBatches(1.0),
+    epoch(0),
+    recentObjective(0.0),
+    observedBatches(0),
+    store(store),
+    plateau(plateauPatience, plateauTolerance),
+    restartRequested(false)
   {
     snapshotEpochs = 0;
     for (size_t i = 0, er = epochRestart, nr = nextRestart;
@@ -82,6 +111,25 @@ class SnapshotEnsembles
         snapshotEpochs - snapshots + 1);
   }
 
+  /**
+   * This function is called by SGD before Update() with the objective of the
+   * current batch, to detect plateaus and to keep the running objective that
+   * ranks the snapshots.
+   *
+   * @param objective Objective of the batch.
+   * @param batchSize Number of functions in the batch.
+   */
+  void ObserveObjective(const double objective, const size_t batchSize)
+  {
+    // The weight of a batch in the running objective of the store.
+    const double weight = std::max(2.0 / (epochBatches + 1.0),
+        1.0 / ++observedBatches);
+    recentObjective += weight * (objective / batchSize - recentObjective);
+
+    if (plateau.Observe(objective / batchSize))
+      restartRequested = true;
+  }
+
   /**
    * This function is called in each iteration after the policy update.
    *
@@ -89,9 +137,10 @@ class SnapshotEnsembles
    * @param stepSize Step size to be used for the given iteration.
    * @param gradient The gradient matrix.
    */
-  void Update(arma::mat& iterate,
+  template<typename MatType, typename GradType>
+  void Update(MatType& iterate,
               double& stepSize,
-              const arma::mat& /* gradient */)
+              const GradType& /* gradient */)
   {
     // Time to adjust the step size.
     if (epoch >= epochRestart)
@@ -104,22 +153,25 @@ class SnapshotEnsembles
       batchRestart++;
     }
 
-    // Time to restart.
-    if (epoch > nextRestart)
+    // Time to restart, at the end of the cycle or on a plateau.
+    if (epoch > nextRestart || restartRequested)
     {
       batchRestart = 0;
+      plateau.Reset();
 
       // Adjust the period of restarts.
       epochRestart *= multFactor;
 
       // Create a new snapshot.
-      if (epochRestart >= snapshotEpochs)
+      if (epochRestart >= snapshotEpochs || restartRequested)
       {
-        snapshots.push_back(iterate);
+        store.Add(iterate, recentObjective);
       }
 
       // Update the time for the next restart.
-      nextRestart += epochRestart;
+      nextRestart = restartRequested ? epoch + epochRestart :
+          nextRestart + epochRestart;
+      restartRequested = false;
     }
 
     epoch++;
@@ -135,10 +187,29 @@ class SnapshotEnsembles
   //! Modify the restart fraction.
   double& EpochBatches() { return epochBatches; }
 
-  //! Get the snapshots.
-  std::vector<arma::mat> Snapshots() const { return snapshots; }
-  //! Modify the snapshots.
-  std::vector<arma::mat>& Snapshots() { return snapshots; }
+  //! Get the snapshots kept in memory in double precision (empty if the store
+  //! uses another storage).
+  const std::vector<arma::mat>& Snapshots() const { return store.Matrices(); }
+  //! Modify the snapshots kept in memory in double precision (empty if the
+  //! store uses another storage).
+  std::vector<arma::mat>& Snapshots() { return store.Matrices(); }
+
+  //! Get the storage of the snapshots.
+  const SnapshotStore& Store() const { return store; }
+  //! Modify the storage of the snapshots.
+  SnapshotStore& Store() { return store; }
+
+  //! Get the number of batches on a plateau that trigger an early restart.
+  size_t PlateauPatience() const { return plateau.Patience(); }
+  //! Modify the number of batches on a plateau that trigger an early restart.
+  size_t& PlateauPatience() { return plateau.Patience(); }
+
+  //! Get the relative decrease of the running objective that is an
+  //! improvement.
+  double PlateauTolerance() const { return plateau.Tolerance(); }
+  //! Modify the relative decrease of the running objective that is an
+  //! improvement.
+  double& PlateauTolerance() { return plateau.Tolerance(); }
 
  private:
   //! Epoch where decay is applied.
@@ -162,11 +233,23 @@ class SnapshotEnsembles
   //! Locally-stored epoch.
   size_t epoch;
 
+  //! The running objective per function of the recent batches.
+  double recentObjective;
+
+  //! The number of batches whose objective was observed.
+  size_t observedBatches;
+
   //! Epochs where a new snapshot is created.
   size_t snapshotEpochs;
 
   //! Locally-stored parameter snapshots.
-  std::vector<arma::mat> snapshots;
+  SnapshotStore store;
+
+  //! The detector of plateaus of the running objective.
+  PlateauDetector plateau;
+
+  //! Whether a plateau asked for an early restart.
+  bool restartRequested;
 };
 
 } // namespace ens
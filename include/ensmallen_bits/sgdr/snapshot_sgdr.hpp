@@ -104,12 +104,22 @@ class SnapshotSGDR
    * will be modified to store the finishing point of the algorithm, and the
    * final objective value is returned.
    *
+   * @tparam DecomposableFunctionType Type of the function to optimize.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to optimize.
    * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
    * @return Objective value of the final point.
    */
-  template<typename DecomposableFunctionType>
-  double Optimize(DecomposableFunctionType& function, arma::mat& iterate);
+  template<typename DecomposableFunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(DecomposableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks);
 
   //! Get the batch size.
   size_t BatchSize() const { return optimizer.BatchSize(); }
@@ -136,17 +146,50 @@ class SnapshotSGDR
   //! Modify whether or not the individual functions are shuffled.
   bool& Shuffle() { return optimizer.Shuffle(); }
 
-  //! Get the snapshots.
-  std::vector<arma::mat> Snapshots() const
+  //! Get the snapshots kept in memory in double precision (empty if the store
+  //! uses another storage).
+  const std::vector<arma::mat>& Snapshots() const
   {
     return optimizer.DecayPolicy().Snapshots();
   }
-  //! Modify the snapshots.
+  //! Modify the snapshots kept in memory in double precision (empty if the
+  //! store uses another storage).
   std::vector<arma::mat>& Snapshots()
   {
     return optimizer.DecayPolicy().Snapshots();
   }
 
+  //! Get the storage of the snapshots.
+  const SnapshotStore& Store() const { return optimizer.DecayPolicy().Store(); }
+  //! Modify the storage of the snapshots.
+  SnapshotStore& Store() { return optimizer.DecayPolicy().Store(); }
+
+  //! Get the number of batches on a plateau of the running objective that
+  //! trigger an early restart (0 means no early restarts).
+  size_t PlateauPatience() const
+  {
+    return optimizer.DecayPolicy().PlateauPatience();
+  }
+  //! Modify the number of batches on a plateau of the running objective that
+  //! trigger an early restart (0 means no early restarts).
+  size_t& PlateauPatience()
+  {
+    return optimizer.DecayPolicy().PlateauPatience();
+  }
+
+  //! Get the relative decrease of the running objective that is an
+  //! improvement.
+  double PlateauTolerance() const
+  {
+    return optimizer.DecayPolicy().PlateauTolerance();
+  }
+  //! Modify the relative decrease of the running objective that is an
+  //! improvement.
+  double& PlateauTolerance()
+  {
+    return optimizer.DecayPolicy().PlateauTolerance();
+  }
+
   //! Get whether or not to accumulate the snapshots.
   bool Accumulate() const { return accumulate; }
   //! Modify whether or not to accumulate the snapshots.
@@ -0,0 +1,342 @@
+/**
+ * @file snapshot_store.hpp
+ *
+ * Storage for the parameter snapshots taken by snapshot ensembles: in memory,
+ * optionally in single precision, or in files that are mapped back into
+ * memory when they are used.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGDR_SNAPSHOT_STORE_HPP
+#define ENSMALLEN_SGDR_SNAPSHOT_STORE_HPP
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <ensmallen_bits/utility/mapped_matrix.hpp>
+
+namespace ens {
+
+/**
+ * SnapshotStore holds the snapshots of the parameters taken by
+ * SnapshotEnsembles.  By default, the snapshots are kept in memory in double
+ * precision.  Two options reduce the memory they take:
+ *
+ *  - with singlePrecision, each snapshot is stored as floats, which halves the
+ *    memory (and, for the snapshots of an ensemble, loses little, since they
+ *    are only averaged);
+ *
+ *  - with a file prefix, each snapshot is written to its own file (named
+ *    filePrefix + i + ".bin", as raw values in column-major order) and only
+ *    its size is kept in memory.  When the snapshots are used, each file is
+ *    memory-mapped in turn (see MappedMatrix), so at most one snapshot is in
+ *    memory at a time.  The files are not removed by the store.
+ *
+ * The two options can be combined.  Two more options bound the number of
+ * snapshots that are kept, for models where even a few copies do not fit:
+ *
+ *  - with maxSnapshots, at most that many snapshots are kept: those with the
+ *    lowest objective (given to Add()).  When the store is full, a new
+ *    snapshot that is at least as good as the worst one replaces it, reusing
+ *    its memory (or its file); otherwise, it is dropped;
+ *
+ *  - with average, the snapshots are not kept at all: the store only holds
+ *    their running mean (in the chosen precision, in memory), which
+ *    Accumulate() adds as the sum of the snapshots, and Get(0) gives.
+ *
+ * Both keep the memory of the store constant, whatever the number of
+ * snapshots.
+ *
+ * @code
+ * // Keep the snapshots of SnapshotSGDR on disk, in single precision.
+ * SnapshotSGDR<> optimizer;
+ * optimizer.Store() = SnapshotStore(true, "/tmp/snapshot_");
+ * @endcode
+ */
+class SnapshotStore
+{
+ public:
+  /**
+   * Create an empty snapshot store.
+   *
+   * @param singlePrecision If true, the snapshots are stored as floats.
+   * @param filePrefix If not empty, the snapshots are written to files whose
+   *     names start with this prefix, instead of being kept in memory.
+   * @param maxSnapshots Maximum number of snapshots kept, those with the
+   *     lowest objective (0 means no limit).
+   * @param average If true, only the running mean of the snapshots is kept.
+   */
+  SnapshotStore(const bool singlePrecision = false,
+                const std::string& filePrefix = "",
+                const size_t maxSnapshots = 0,
+                const bool average = false) :
+      singlePrecision(singlePrecision),
+      filePrefix(filePrefix),
+      maxSnapshots(maxSnapshots),
+      average(average),
+      count(0)
+  {
+    if (average && !filePrefix.empty())
+    {
+      throw std::invalid_argument("SnapshotStore: the running average is kept "
+          "in memory, so it cannot be used with a file prefix!");
+    }
+  }
+
+  /**
+   * Store a new snapshot.  A std::runtime_error is thrown if its file cannot
+   * be written.
+   *
+   * @param snapshot Snapshot to store.
+   * @param objective Objective of the snapshot (only used with maxSnapshots).
+   */
+  template<typename MatType>
+  void Add(const MatType& snapshot, const double objective = 0.0)
+  {
+    if (average)
+    {
+      // The running mean is updated in place.
+      ++count;
+      if (singlePrecision)
+        Mean(floatSnapshots, snapshot);
+      else
+        Mean(snapshots, snapshot);
+      return;
+    }
+
+    size_t i = Size();
+    if (maxSnapshots > 0 && i >= maxSnapshots)
+    {
+      // Replace the worst snapshot, unless the new one is worse.
+      i = std::max_element(objectives.begin(), objectives.end()) -
+          objectives.begin();
+      if (objective > objectives[i])
+        return;
+    }
+
+    Put(i, snapshot);
+    if (i == objectives.size())
+      objectives.push_back(objective);
+    else
+      objectives[i] = objective;
+  }
+
+  //! Get the number of snapshots.
+  size_t Size() const
+  {
+    if (average)
+      return count;
+
+    return filePrefix.empty() ? (singlePrecision ? floatSnapshots.size() :
+        snapshots.size()) : sizes.size();
+  }
+
+  /**
+   * Get a copy of the given snapshot (with average, the only snapshot is the
+   * running mean).
+   *
+   * @param i Index of the snapshot.
+   * @param snapshot Matrix to store the snapshot into.
+   */
+  template<typename MatType>
+  void Get(const size_t i, MatType& snapshot) const
+  {
+    if (!filePrefix.empty() && singlePrecision)
+      snapshot = arma::conv_to<MatType>::from(Map<float>(i)->Matrix());
+    else if (!filePrefix.empty())
+      snapshot = arma::conv_to<MatType>::from(Map<double>(i)->Matrix());
+    else if (singlePrecision)
+      snapshot = arma::conv_to<MatType>::from(floatSnapshots[i]);
+    else
+      snapshot = arma::conv_to<MatType>::from(snapshots[i]);
+  }
+
+  /**
+   * Add every snapshot to the given matrix, one snapshot at a time (with
+   * average, the running mean times the number of snapshots).
+   *
+   * @param sum Matrix to add the snapshots to.
+   */
+  template<typename MatType>
+  void Accumulate(MatType& sum) const
+  {
+    typedef typename MatType::elem_type ElemType;
+
+    if (average)
+    {
+      const ElemType n = ElemType(count);
+      if (count > 0 && singlePrecision)
+        sum += n * arma::conv_to<MatType>::from(floatSnapshots[0]);
+      else if (count > 0)
+        sum += n * arma::conv_to<MatType>::from(snapshots[0]);
+      return;
+    }
+
+    for (size_t i = 0; i < Size(); ++i)
+    {
+      if (!filePrefix.empty() && singlePrecision)
+        sum += arma::conv_to<MatType>::from(Map<float>(i)->Matrix());
+      else if (!filePrefix.empty())
+        sum += arma::conv_to<MatType>::from(Map<double>(i)->Matrix());
+      else if (singlePrecision)
+        sum += arma::conv_to<MatType>::from(floatSnapshots[i]);
+      else
+        sum += arma::conv_to<MatType>::from(snapshots[i]);
+    }
+  }
+
+  //! Forget all the snapshots (their files, if any, are left on disk).
+  void Clear()
+  {
+    snapshots.clear();
+    floatSnapshots.clear();
+    sizes.clear();
+    objectives.clear();
+    count = 0;
+  }
+
+  //! Get the name of the file of the given snapshot.
+  std::string Filename(const size_t i) const
+  {
+    std::ostringstream oss;
+    oss << filePrefix << i << ".bin";
+    return oss.str();
+  }
+
+  //! Get the snapshots kept in memory in double precision (the default
+  //! storage; with average, the running mean).
+  const std::vector<arma::mat>& Matrices() const { return snapshots; }
+  //! Modify the snapshots kept in memory in double precision (the default
+  //! storage; with average, the running mean).
+  std::vector<arma::mat>& Matrices() { return snapshots; }
+
+  //! Get the objectives of the kept snapshots (empty with average).
+  const std::vector<double>& Objectives() const { return objectives; }
+
+  //! Get whether the snapshots are stored in single precision.
+  bool SinglePrecision() const { return singlePrecision; }
+
+  //! Get the prefix of the snapshot files (empty if they are kept in
+  //! memory).
+  const std::string& FilePrefix() const { return filePrefix; }
+
+  //! Get the maximum number of snapshots kept (0 indicates no limit).
+  size_t MaxSnapshots() const { return maxSnapshots; }
+
+  //! Get whether only the running mean of the snapshots is kept.
+  bool Average() const { return average; }
+
+ private:
+  //! Store the given snapshot at the given index (which may be the next one).
+  template<typename MatType>
+  void Put(const size_t i, const MatType& snapshot)
+  {
+    if (!filePrefix.empty())
+    {
+      const std::string filename = Filename(i);
+      bool saved;
+      if (singlePrecision)
+      {
+        saved = arma::conv_to<arma::fmat>::from(snapshot).save(filename,
+            arma::raw_binary);
+      }
+      else
+      {
+        saved = arma::conv_to<arma::mat>::from(snapshot).save(filename,
+            arma::raw_binary);
+      }
+
+      if (!saved)
+      {
+        std::ostringstream oss;
+        oss << "SnapshotStore::Add(): cannot write file '" << filename
+            << "'!";
+        throw std::runtime_error(oss.str());
+      }
+
+      const std::pair<size_t, size_t> size(snapshot.n_rows, snapshot.n_cols);
+      if (i == sizes.size())
+        sizes.push_back(size);
+      else
+        sizes[i] = size;
+    }
+    else if (singlePrecision)
+    {
+      Put(floatSnapshots, i, snapshot);
+    }
+    else
+    {
+      Put(snapshots, i, snapshot);
+    }
+  }
+
+  //! Store the given snapshot in the given vector, reusing the memory of the
+  //! snapshot it replaces.
+  template<typename eT, typename MatType>
+  static void Put(std::vector<arma::Mat<eT>>& matrices,
+                  const size_t i,
+                  const MatType& snapshot)
+  {
+    if (i == matrices.size())
+      matrices.push_back(arma::conv_to<arma::Mat<eT>>::from(snapshot));
+    else
+      matrices[i] = arma::conv_to<arma::Mat<eT>>::from(snapshot);
+  }
+
+  //! Add the given snapshot to the running mean in the given vector.
+  template<typename eT, typename MatType>
+  void Mean(std::vector<arma::Mat<eT>>& matrices, const MatType& snapshot)
+  {
+    if (matrices.empty())
+    {
+      matrices.push_back(arma::conv_to<arma::Mat<eT>>::from(snapshot));
+      return;
+    }
+
+    matrices[0] += (arma::conv_to<arma::Mat<eT>>::from(snapshot) -
+        matrices[0]) / eT(count);
+  }
+
+  //! Map the file of the given snapshot.
+  template<typename ElemType>
+  std::unique_ptr<MappedMatrix<ElemType>> Map(const size_t i) const
+  {
+    return std::unique_ptr<MappedMatrix<ElemType>>(new MappedMatrix<ElemType>(
+        Filename(i), sizes[i].first, sizes[i].second));
+  }
+
+  //! Whether the snapshots are stored in single precision.
+  bool singlePrecision;
+
+  //! The prefix of the snapshot files (empty to keep them in memory).
+  std::string filePrefix;
+
+  //! The snapshots kept in memory in double precision.
+  std::vector<arma::mat> snapshots;
+
+  //! The snapshots kept in memory in single precision.
+  std::vector<arma::fmat> floatSnapshots;
+
+  //! The sizes of the snapshots stored in files.
+  std::vector<std::pair<size_t, size_t>> sizes;
+
+  //! The maximum number of snapshots kept (0 for no limit).
+  size_t maxSnapshots;
+
+  //! Whether only the running mean of the snapshots is kept.
+  bool average;
+
+  //! The number of snapshots added to the running mean.
+  size_t count;
+
+  //! The objectives of the kept snapshots.
+  std::vector<double> objectives;
+};
+
+} // namespace ens
+
+#endif
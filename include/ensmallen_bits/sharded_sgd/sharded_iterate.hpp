@@ -0,0 +1,260 @@
+/**
+ * @file sharded_iterate.hpp
+ *
+ * An iterate whose rows are distributed over the ranks of a job, for
+ * embedding tables too large to be stored on a single node.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SHARDED_SGD_SHARDED_ITERATE_HPP
+#define ENSMALLEN_SHARDED_SGD_SHARDED_ITERATE_HPP
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace ens {
+
+/**
+ * ShardedIterate is a matrix of doubles of n_rows x n_cols whose rows are split
+ * into numShards contiguous shards, one per rank of a job: shard s holds the
+ * rows [FirstRow(s), FirstRow(s + 1)), and the shards differ by at most one
+ * row.  Each rank only allocates its own shard (Local()), so the table can be
+ * far larger than the memory of one node; ShardedSGD fetches the other rows
+ * that a batch reads from their owners and sends each component of the
+ * gradient to the owner of its row.
+ *
+ * The const accessors return the coordinates of the rows of this shard and of
+ * the rows fetched for the current batch (the cache).  Reading any other row
+ * throws a std::out_of_range, unless the iterate is recording: then the row is
+ * remembered, so that it can be fetched, and 0 is returned.  The non-const
+ * accessors only give the rows of this shard.
+ *
+ * @code
+ * // 2^33 rows of 64 dimensions on the rank of the given communicator.
+ * ShardedIterate embeddings(size_t(1) << 33, 64, communicator.Rank(),
+ *     communicator.Size());
+ * embeddings.Local().randn();
+ * @endcode
+ *
+ * The function to optimize takes the coordinates as a const ShardedIterate&
+ * in its Evaluate() and Gradient(), and returns an arma::sp_mat gradient of
+ * size n_rows x n_cols (which requires 64-bit Armadillo indices if n_rows is
+ * at least 2^32).  The accessors are not thread-safe while recording.
+ */
+class ShardedIterate
+{
+ public:
+  //! The type of the coordinates.
+  typedef double elem_type;
+
+  //! Create an empty 0x0 iterate with a single shard.
+  ShardedIterate() :
+      n_rows(0),
+      n_cols(0),
+      n_elem(0),
+      shard(0),
+      numShards(1),
+      firstRow(0),
+      recording(false)
+  { /* Nothing to do. */ }
+
+  /**
+   * Create the given shard of an iterate of the given logical size, with all
+   * the coordinates of the shard 0.
+   *
+   * @param rows Number of rows of the whole iterate.
+   * @param cols Number of columns.
+   * @param shard Index of the shard held by this rank.
+   * @param numShards Number of shards (ranks).
+   */
+  ShardedIterate(const size_t rows,
+                 const size_t cols,
+                 const size_t shard,
+                 const size_t numShards) :
+      n_rows(rows),
+      n_cols(cols),
+      n_elem(rows * cols),
+      shard(shard),
+      numShards(numShards),
+      firstRow(0),
+      recording(false)
+  {
+    if (numShards == 0 || shard >= numShards)
+    {
+      std::ostringstream oss;
+      oss << "ShardedIterate::ShardedIterate(): invalid shard " << shard
+          << " of " << numShards << " shards!";
+      throw std::invalid_argument(oss.str());
+    }
+
+    firstRow = FirstRow(shard);
+    local.zeros(FirstRow(shard + 1) - firstRow, cols);
+  }
+
+  //! Get the index of the shard held by this rank.
+  size_t Shard() const { return shard; }
+  //! Get the number of shards.
+  size_t NumShards() const { return numShards; }
+
+  //! Get the first row of this shard.
+  size_t FirstRow() const { return firstRow; }
+  //! Get the number of rows of this shard.
+  size_t LocalRows() const { return local.n_rows; }
+
+  //! Get the first row of the given shard (n_rows for numShards).
+  size_t FirstRow(const size_t s) const
+  {
+    // The first n_rows % numShards shards have one more row.
+    return s * (n_rows / numShards) + std::min(s, n_rows % numShards);
+  }
+
+  //! Get the shard that holds the given row.
+  size_t Owner(const size_t row) const
+  {
+    const size_t rowsPerShard = n_rows / numShards;
+    const size_t larger = (n_rows % numShards) * (rowsPerShard + 1);
+    return (row < larger) ? row / (rowsPerShard + 1) :
+        n_rows % numShards + (row - larger) / rowsPerShard;
+  }
+
+  //! Get whether the given row is held by this shard.
+  bool Owns(const size_t row) const
+  {
+    return row >= firstRow && row - firstRow < local.n_rows;
+  }
+
+  //! Get the rows of this shard (LocalRows() x n_cols).
+  const arma::mat& Local() const { return local; }
+  //! Modify the rows of this shard (LocalRows() x n_cols).
+  arma::mat& Local() { return local; }
+
+  //! Get the coordinate at the given row and column (see the class
+  //! documentation for the rows that can be read).
+  double operator()(const size_t row, const size_t col) const
+  {
+    if (Owns(row))
+      return local(row - firstRow, col);
+
+    std::unordered_map<size_t, size_t>::const_iterator it =
+        cacheSlots.find(row);
+    if (it != cacheSlots.end())
+      return cache(col, it->second);
+
+    if (recording)
+    {
+      missing.insert(row);
+      return 0.0;
+    }
+
+    std::ostringstream oss;
+    oss << "ShardedIterate::operator(): row " << row << " is held by shard "
+        << Owner(row) << " and was not fetched!";
+    throw std::out_of_range(oss.str());
+  }
+
+  //! Get the coordinate with the given linear index.
+  double operator[](const size_t i) const
+  {
+    return (*this)(i % n_rows, i / n_rows);
+  }
+
+  //! Modify the coordinate at the given row (of this shard) and column.
+  double& operator()(const size_t row, const size_t col)
+  {
+    if (!Owns(row))
+    {
+      std::ostringstream oss;
+      oss << "ShardedIterate::operator(): row " << row << " is held by shard "
+          << Owner(row) << ", not by shard " << shard << "!";
+      throw std::out_of_range(oss.str());
+    }
+
+    return local(row - firstRow, col);
+  }
+
+  //! Modify the coordinate with the given linear index (of a row of this
+  //! shard).
+  double& operator[](const size_t i) { return (*this)(i % n_rows, i / n_rows); }
+
+  //! Start recording the rows that are read but not available.
+  void Record() { recording = true; }
+
+  //! Get whether the rows that are read but not available are recorded.
+  bool Recording() const { return recording; }
+
+  //! Stop recording, and return the recorded rows in increasing order (they
+  //! are forgotten).
+  std::vector<size_t> TakeMissingRows()
+  {
+    recording = false;
+    std::vector<size_t> rows(missing.begin(), missing.end());
+    missing.clear();
+    std::sort(rows.begin(), rows.end());
+    return rows;
+  }
+
+  /**
+   * Add the given rows, held by other shards, to the cache.
+   *
+   * @param rows The rows to add.
+   * @param values The values of the rows (n_cols x rows.size(); one column per
+   *     row).
+   */
+  void CacheRows(const std::vector<size_t>& rows, const arma::mat& values)
+  {
+    const size_t numCached = cache.n_cols;
+    cache.resize(n_cols, numCached + rows.size());
+    for (size_t k = 0; k < rows.size(); ++k)
+    {
+      cacheSlots[rows[k]] = numCached + k;
+      cache.col(numCached + k) = values.col(k);
+    }
+  }
+
+  //! Get the number of cached rows.
+  size_t CachedRows() const { return cacheSlots.size(); }
+
+  //! Remove all the cached rows.
+  void ClearCache()
+  {
+    cacheSlots.clear();
+    cache.set_size(n_cols, 0);
+  }
+
+  //! The number of rows of the whole iterate (read-only).
+  size_t n_rows;
+  //! The number of columns (read-only).
+  size_t n_cols;
+  //! The number of coordinates of the whole iterate (read-only).
+  size_t n_elem;
+
+ private:
+  //! The index of the shard held by this rank.
+  size_t shard;
+  //! The number of shards.
+  size_t numShards;
+  //! The first row of this shard.
+  size_t firstRow;
+  //! The rows of this shard.
+  arma::mat local;
+
+  //! The slot of each cached row in the cache.
+  std::unordered_map<size_t, size_t> cacheSlots;
+  //! The cached rows (one per column).
+  arma::mat cache;
+
+  //! Whether the rows that are not available are recorded.
+  bool recording;
+  //! The recorded rows.
+  mutable std::unordered_set<size_t> missing;
+};
+
+} // namespace ens
+
+#endif
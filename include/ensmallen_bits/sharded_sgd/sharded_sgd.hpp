@@ -0,0 +1,209 @@
+/**
+ * @file sharded_sgd.hpp
+ *
+ * Model-parallel SGD: the rows of the iterate and the state of the update
+ * policy are sharded over the ranks of a job.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SHARDED_SGD_SHARDED_SGD_HPP
+#define ENSMALLEN_SHARDED_SGD_SHARDED_SGD_HPP
+
+#include <ensmallen_bits/parallel_sgd/parallel_sgd.hpp>
+#include <ensmallen_bits/distributed_sgd/communicators/local_communicator.hpp>
+#include <ensmallen_bits/distributed_sgd/communicators/mpi_communicator.hpp>
+
+#include "sharded_iterate.hpp"
+
+namespace ens {
+
+/**
+ * ShardedSGD optimizes a sparse separable function over a ShardedIterate,
+ * whose rows (for instance the rows of an embedding table with billions of
+ * entries) are distributed over the ranks of a job, so that no rank ever holds
+ * the whole iterate.  Each rank holds a shard of the data (the function) and a
+ * shard of the rows, and the ranks take synchronous steps together:
+ *
+ *  1. each rank calls Gradient() on its next batch with the iterate recording,
+ *     to find the rows of the other shards that the batch reads;
+ *  2. these rows are fetched from their owners in one all-to-all exchange;
+ *  3. each rank computes the sparse gradient of its batch, and every
+ *     non-zero component is sent to the owner of its row in a second
+ *     all-to-all exchange;
+ *  4. each rank sums the components it received for its rows (from all the
+ *     ranks) and applies them to its shard with the update policy.
+ *
+ * The update policies are those of ParallelSGD (see AtomicUpdate,
+ * HogwildUpdate, DeltaBufferUpdate and SparseAdaGradUpdate), instantiated for
+ * the rows of the local shard only, so their state is sharded along with the
+ * iterate: with SparseAdaGradUpdate, each rank holds the AdaGrad accumulators
+ * of its own rows, and only the coordinates that receive a gradient are
+ * updated.  The decay policies are also those of ParallelSGD.
+ *
+ * Because the rows are found by a first call to Gradient() in which the other
+ * rows read as 0, the function must read the same coordinates whatever their
+ * values.  This first call is made for every batch, so cheap gradients are
+ * preferable; the coordinates of a batch are fetched once per step.
+ *
+ * An iteration is one pass over the shards of all the ranks; it lasts as many
+ * steps as the largest shard has batches, and ranks whose shard is exhausted
+ * take part in the exchanges with empty batches.  Before each iteration, the
+ * objective over all the shards is computed (in batches, fetching their rows
+ * in the same way) to check for convergence.
+ *
+ * The communicator must provide the collective operations used by
+ * DistributedSGD and AllToAll() (see LocalCommunicator); with the default
+ * LocalCommunicator there is a single shard, and ShardedSGD takes the steps of
+ * a synchronous, single-threaded ParallelSGD.
+ *
+ * ShardedSGD can optimize sparse differentiable separable functions that take
+ * a const ShardedIterate& as coordinates.  For more details, see the
+ * documentation on function types included with this distribution or on the
+ * ensmallen website.
+ *
+ * @tparam DecayPolicyType Step size update policy used after each iteration.
+ * @tparam UpdatePolicyType Policy used to apply the summed sparse gradients to
+ *     the local shard.
+ * @tparam CommunicatorType Communicator between the ranks.
+ */
+template<typename DecayPolicyType = ConstantStep,
+         typename UpdatePolicyType = AtomicUpdate,
+         typename CommunicatorType = LocalCommunicator>
+class ShardedSGD
+{
+ public:
+  /**
+   * Construct the ShardedSGD optimizer with the given parameters.  The
+   * defaults here are not necessarily good for the given problem, so it is
+   * suggested that the values used be tailored to the task at hand.
+   *
+   * @param maxIterations Maximum number of iterations (passes over the shards
+   *     of all the ranks) allowed (0 means no limit).
+   * @param batchSize Number of functions of the shard in each batch of this
+   *     rank.
+   * @param tolerance Maximum absolute tolerance to terminate the algorithm.
+   * @param shuffle If true, the batches of each shard are visited in a random
+   *     order; otherwise, in linear order.
+   * @param decayPolicy The step size update policy to use.
+   * @param updatePolicy The policy used to apply the sparse updates.
+   * @param communicator The communicator between the ranks.
+   */
+  ShardedSGD(const size_t maxIterations = 1000,
+             const size_t batchSize = 32,
+             const double tolerance = 1e-5,
+             const bool shuffle = true,
+             const DecayPolicyType& decayPolicy = DecayPolicyType(),
+             const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
+             const CommunicatorType& communicator = CommunicatorType());
+
+  /**
+   * Optimize the given function, which holds the shard of the data of this
+   * rank.  Every rank must call Optimize() with its shard of the same
+   * iterate (the shard of the iterate must be the rank of the communicator);
+   * the shard of the iterate is modified to store the finishing point of the
+   * algorithm, and the objective value of the final point, summed over all
+   * the ranks, is returned.
+   *
+   * @tparam SparseFunctionType Type of function to be optimized.
+   * @param function Function to be optimized, over the data of this rank.
+   * @param iterate Starting point (its shard will be modified).
+   * @return Objective value at the final point.
+   */
+  template<typename SparseFunctionType>
+  double Optimize(SparseFunctionType& function, ShardedIterate& iterate);
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the batch size of each rank.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size of each rank.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the batches are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the batches are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+  //! Get the step size decay policy.
+  const DecayPolicyType& DecayPolicy() const { return decayPolicy; }
+  //! Modify the step size decay policy.
+  DecayPolicyType& DecayPolicy() { return decayPolicy; }
+
+  //! Get the update policy.
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  //! Modify the update policy.
+  UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
+
+  //! Get the communicator.
+  const CommunicatorType& Communicator() const { return communicator; }
+  //! Modify the communicator.
+  CommunicatorType& Communicator() { return communicator; }
+
+ private:
+  /**
+   * Compute the objective of the function over the shards of all the ranks;
+   * every rank visits the given number of batches (the batches past the end
+   * of its shard are empty).
+   */
+  template<typename SparseFunctionType>
+  double Evaluate(SparseFunctionType& function,
+                  ShardedIterate& iterate,
+                  const size_t numBatches,
+                  const size_t maxBatches);
+
+  //! Fetch the rows recorded by the iterate from their owners into its cache
+  //! (every rank must call it, even if nothing was recorded).
+  void FetchRows(ShardedIterate& iterate);
+
+  /**
+   * Send every non-zero component of the given gradient (of size n_rows x
+   * n_cols) to the owner of its row, and store the sum of the components
+   * received by this rank in the local gradient (of the size of the shard).
+   * Every rank must call it, even with an empty gradient.
+   */
+  void RouteGradient(const ShardedIterate& iterate,
+                     const arma::sp_mat& gradient,
+                     arma::sp_mat& localGradient);
+
+  //! Get the maximum of the given value over all the ranks.
+  size_t MaxOverRanks(const size_t value) const;
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The batch size of each rank.
+  size_t batchSize;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the batches are shuffled when iterating.
+  bool shuffle;
+
+  //! The step size decay policy.
+  DecayPolicyType decayPolicy;
+
+  //! The policy used to apply the sparse updates.
+  UpdatePolicyType updatePolicy;
+
+  //! The communicator between the ranks.
+  CommunicatorType communicator;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "sharded_sgd_impl.hpp"
+
+#endif
@@ -0,0 +1,360 @@
+/**
+ * @file sharded_sgd_impl.hpp
+ *
+ * Implementation of model-parallel SGD over a sharded iterate.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SHARDED_SGD_SHARDED_SGD_IMPL_HPP
+#define ENSMALLEN_SHARDED_SGD_SHARDED_SGD_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "sharded_sgd.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+namespace ens {
+
+template<typename DecayPolicyType,
+         typename UpdatePolicyType,
+         typename CommunicatorType>
+ShardedSGD<DecayPolicyType, UpdatePolicyType, CommunicatorType>::ShardedSGD(
+    const size_t maxIterations,
+    const size_t batchSize,
+    const double tolerance,
+    const bool shuffle,
+    const DecayPolicyType& decayPolicy,
+    const UpdatePolicyType& updatePolicy,
+    const CommunicatorType& communicator) :
+    maxIterations(maxIterations),
+    batchSize(batchSize),
+    tolerance(tolerance),
+    shuffle(shuffle),
+    decayPolicy(decayPolicy),
+    updatePolicy(updatePolicy),
+    communicator(communicator)
+{ /* Nothing to do. */ }
+
+template<typename DecayPolicyType,
+         typename UpdatePolicyType,
+         typename CommunicatorType>
+template<typename SparseFunctionType>
+double ShardedSGD<DecayPolicyType, UpdatePolicyType, CommunicatorType>::
+Optimize(SparseFunctionType& function, ShardedIterate& iterate)
+{
+  if (iterate.NumShards() != communicator.Size() ||
+      iterate.Shard() != communicator.Rank())
+  {
+    std::ostringstream oss;
+    oss << "ShardedSGD::Optimize(): the iterate holds shard "
+        << iterate.Shard() << " of " << iterate.NumShards() << ", but this is "
+        << "rank " << communicator.Rank() << " of " << communicator.Size()
+        << "!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (batchSize == 0)
+  {
+    throw std::invalid_argument("ShardedSGD::Optimize(): the batch size must "
+        "be positive!");
+  }
+
+  // The update policy only sees the rows of this shard, so its state is
+  // sharded with them.
+  typedef typename UpdatePolicyType::template Policy<arma::mat, arma::sp_mat>
+      InstUpdatePolicyType;
+  InstUpdatePolicyType instPolicy(updatePolicy, iterate.LocalRows(),
+      iterate.n_cols, 1);
+
+  // Only the first rank reports progress.
+  const bool root = (communicator.Rank() == 0);
+
+  // The functions of this shard are visited in batches of batchSize
+  // consecutive functions; an epoch lasts as many steps as the largest shard
+  // has batches.
+  const size_t numFunctions = function.NumFunctions();
+  const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+  const size_t maxBatches = MaxOverRanks(numBatches);
+  if (maxBatches == 0)
+  {
+    throw std::invalid_argument("ShardedSGD::Optimize(): there are no "
+        "functions on any rank!");
+  }
+
+  arma::Col<size_t> visitationOrder(numBatches);
+  for (size_t j = 0; j < numBatches; ++j)
+    visitationOrder[j] = j;
+
+  double overallObjective = DBL_MAX;
+  double lastObjective;
+
+  arma::sp_mat gradient, localGradient;
+  iterate.ClearCache();
+
+  // Iterate till the objective is within tolerance or the maximum number of
+  // allowed iterations is reached. If maxIterations is 0, this will iterate
+  // till convergence.
+  for (size_t i = 1; i != maxIterations; ++i)
+  {
+    // Calculate the overall objective over all the shards.
+    lastObjective = overallObjective;
+    overallObjective = Evaluate(function, iterate, numBatches, maxBatches);
+
+    // Output current objective function.
+    if (root)
+    {
+      Info << "Sharded SGD: iteration " << i << ", objective "
+          << overallObjective << ".\n";
+    }
+
+    if (std::isnan(overallObjective) || std::isinf(overallObjective))
+    {
+      if (root)
+      {
+        Warn << "Sharded SGD: converged to " << overallObjective
+            << "; terminating with failure. Try a smaller step size?"
+            << std::endl;
+      }
+      return overallObjective;
+    }
+
+    if (std::abs(lastObjective - overallObjective) < tolerance)
+    {
+      if (root)
+      {
+        Info << "Sharded SGD: minimized within tolerance " << tolerance
+            << "; terminating optimization." << std::endl;
+      }
+      return overallObjective;
+    }
+
+    // Get the step size for this iteration.
+    const double stepSize = decayPolicy.StepSize(i);
+
+    if (shuffle)
+      visitationOrder = arma::shuffle(visitationOrder);
+
+    for (size_t step = 0; step < maxBatches; ++step)
+    {
+      // The last batch may be smaller, and the shards with fewer batches take
+      // part with empty batches.
+      const bool active = (step < numBatches);
+      const size_t begin = active ? visitationOrder[step] * batchSize : 0;
+      const size_t effectiveBatchSize = active ?
+          std::min(batchSize, numFunctions - begin) : 0;
+
+      // Find the rows the batch reads, and fetch them.
+      if (active)
+      {
+        iterate.Record();
+        function.Gradient(iterate, begin, gradient, effectiveBatchSize);
+      }
+      FetchRows(iterate);
+
+      if (active)
+        function.Gradient(iterate, begin, gradient, effectiveBatchSize);
+      else
+        gradient.zeros(iterate.n_rows, iterate.n_cols);
+
+      // The gradients of all the ranks are computed before any shard is
+      // updated, so the fetched rows can be dropped.
+      RouteGradient(iterate, gradient, localGradient);
+      iterate.ClearCache();
+
+      instPolicy.Update(iterate.Local(), stepSize, localGradient, 0);
+      instPolicy.Flush(iterate.Local(), 0);
+    }
+  }
+
+  if (root)
+  {
+    Info << "\n Sharded SGD terminated with objective : "
+        << overallObjective << std::endl;
+  }
+  return overallObjective;
+}
+
+template<typename DecayPolicyType,
+         typename UpdatePolicyType,
+         typename CommunicatorType>
+template<typename SparseFunctionType>
+double ShardedSGD<DecayPolicyType, UpdatePolicyType, CommunicatorType>::
+Evaluate(SparseFunctionType& function,
+         ShardedIterate& iterate,
+         const size_t numBatches,
+         const size_t maxBatches)
+{
+  const size_t numFunctions = function.NumFunctions();
+  double objective = 0.0;
+  for (size_t j = 0; j < maxBatches; ++j)
+  {
+    const bool active = (j < numBatches);
+    const size_t begin = j * batchSize;
+    const size_t effectiveBatchSize = active ?
+        std::min(batchSize, numFunctions - begin) : 0;
+
+    if (active)
+    {
+      iterate.Record();
+      function.Evaluate(iterate, begin, effectiveBatchSize);
+    }
+    FetchRows(iterate);
+
+    if (active)
+      objective += function.Evaluate(iterate, begin, effectiveBatchSize);
+    iterate.ClearCache();
+  }
+
+  communicator.AllReduce(&objective, 1);
+  return objective;
+}
+
+template<typename DecayPolicyType,
+         typename UpdatePolicyType,
+         typename CommunicatorType>
+void ShardedSGD<DecayPolicyType, UpdatePolicyType, CommunicatorType>::
+FetchRows(ShardedIterate& iterate)
+{
+  const size_t ranks = communicator.Size();
+  const size_t cols = iterate.n_cols;
+
+  // Ask the owner of each missing row for it.
+  std::vector<std::vector<size_t>> requestedRows(ranks);
+  for (const size_t row : iterate.TakeMissingRows())
+    requestedRows[iterate.Owner(row)].push_back(row);
+
+  std::vector<std::vector<char>> requests(ranks), received;
+  for (size_t r = 0; r < ranks; ++r)
+  {
+    requests[r].resize(requestedRows[r].size() * sizeof(uint64_t));
+    for (size_t k = 0; k < requestedRows[r].size(); ++k)
+    {
+      const uint64_t row = requestedRows[r][k];
+      std::memcpy(requests[r].data() + k * sizeof(uint64_t), &row,
+          sizeof(uint64_t));
+    }
+  }
+  communicator.AllToAll(requests, received);
+
+  // Answer the requests of the other ranks with the values of the rows, in
+  // the order in which they were asked for.
+  std::vector<std::vector<char>> answers(ranks), values;
+  for (size_t r = 0; r < ranks; ++r)
+  {
+    const size_t numRows = received[r].size() / sizeof(uint64_t);
+    answers[r].resize(numRows * cols * sizeof(double));
+    for (size_t k = 0; k < numRows; ++k)
+    {
+      uint64_t row;
+      std::memcpy(&row, received[r].data() + k * sizeof(uint64_t),
+          sizeof(uint64_t));
+      for (size_t c = 0; c < cols; ++c)
+      {
+        const double value = iterate.Local()(row - iterate.FirstRow(), c);
+        std::memcpy(answers[r].data() + (k * cols + c) * sizeof(double),
+            &value, sizeof(double));
+      }
+    }
+  }
+  communicator.AllToAll(answers, values);
+
+  for (size_t r = 0; r < ranks; ++r)
+  {
+    if (requestedRows[r].empty())
+      continue;
+
+    arma::mat rowValues(cols, requestedRows[r].size());
+    std::memcpy(rowValues.memptr(), values[r].data(),
+        rowValues.n_elem * sizeof(double));
+    iterate.CacheRows(requestedRows[r], rowValues);
+  }
+}
+
+template<typename DecayPolicyType,
+         typename UpdatePolicyType,
+         typename CommunicatorType>
+void ShardedSGD<DecayPolicyType, UpdatePolicyType, CommunicatorType>::
+RouteGradient(const ShardedIterate& iterate,
+              const arma::sp_mat& gradient,
+              arma::sp_mat& localGradient)
+{
+  if (gradient.n_rows != iterate.n_rows || gradient.n_cols != iterate.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "ShardedSGD::Optimize(): the gradient has size " << gradient.n_rows
+        << "x" << gradient.n_cols << ", but the iterate has size "
+        << iterate.n_rows << "x" << iterate.n_cols << "!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // Each component is sent as its row, its column and its value.
+  const size_t ranks = communicator.Size();
+  const size_t componentSize = 2 * sizeof(uint64_t) + sizeof(double);
+  std::vector<std::vector<char>> components(ranks), received;
+  for (arma::sp_mat::const_iterator it = gradient.begin();
+      it != gradient.end(); ++it)
+  {
+    const uint64_t location[2] = { it.row(), it.col() };
+    const double value = (*it);
+    std::vector<char>& message = components[iterate.Owner(it.row())];
+    const size_t offset = message.size();
+    message.resize(offset + componentSize);
+    std::memcpy(message.data() + offset, location, sizeof(location));
+    std::memcpy(message.data() + offset + sizeof(location), &value,
+        sizeof(double));
+  }
+  communicator.AllToAll(components, received);
+
+  size_t numComponents = 0;
+  for (size_t r = 0; r < ranks; ++r)
+    numComponents += received[r].size() / componentSize;
+
+  if (numComponents == 0)
+  {
+    localGradient.zeros(iterate.LocalRows(), iterate.n_cols);
+    return;
+  }
+
+  // The components of the same coordinate (from different ranks) are summed.
+  arma::umat locations(2, numComponents);
+  arma::vec values(numComponents);
+  size_t k = 0;
+  for (size_t r = 0; r < ranks; ++r)
+  {
+    for (size_t offset = 0; offset < received[r].size();
+        offset += componentSize, ++k)
+    {
+      uint64_t location[2];
+      std::memcpy(location, received[r].data() + offset, sizeof(location));
+      std::memcpy(&values[k], received[r].data() + offset + sizeof(location),
+          sizeof(double));
+      locations(0, k) = location[0] - iterate.FirstRow();
+      locations(1, k) = location[1];
+    }
+  }
+
+  localGradient = arma::sp_mat(true, locations, values, iterate.LocalRows(),
+      iterate.n_cols);
+}
+
+template<typename DecayPolicyType,
+         typename UpdatePolicyType,
+         typename CommunicatorType>
+size_t ShardedSGD<DecayPolicyType, UpdatePolicyType, CommunicatorType>::
+MaxOverRanks(const size_t value) const
+{
+  // Each rank sums its value in its own slot, so the maximum can be taken
+  // after the sum.
+  arma::vec values(communicator.Size(), arma::fill::zeros);
+  values[communicator.Rank()] = double(value);
+  communicator.AllReduce(values.memptr(), values.n_elem);
+  return size_t(arma::max(values));
+}
+
+} // namespace ens
+
+#endif
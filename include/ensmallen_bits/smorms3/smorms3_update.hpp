@@ -43,62 +43,131 @@ class SMORMS3Update
   SMORMS3Update(const double epsilon = 1e-16) : epsilon(epsilon)
   { /* Do nothing. */ }
 
-  /**
-   * The Initialize method is called by SGD::Optimize method with UpdatePolicy
-   * SMORMS3Update before the start of the iteration update process.
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
-   */
-  void Initialize(const size_t rows, const size_t cols)
+  //! Get the value used to initialise the mean squared gradient parameter.
+  double Epsilon() const { return epsilon; }
+  //! Modify the value used to initialise the mean squared gradient parameter.
+  double& Epsilon() { return epsilon; }
+
+  //! Get the number of bytes of the state (the memory and the two gradient
+  //! averages) for an iterate of the given size.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
   {
-    // Initialise the parameters mem, g and g2.
-    mem = arma::ones<arma::mat>(rows, cols);
-    g = arma::zeros<arma::mat>(rows, cols);
-    g2 = arma::zeros<arma::mat>(rows, cols);
+    return 3 * rows * cols * elemSize;
   }
 
   /**
-   * Update step for SMORMS3.
-   *
-   * @param iterate Parameter that minimizes the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
    */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
+  template<typename MatType, typename GradType>
+  class Policy
   {
-    // Update the iterate.
-    arma::mat r = 1 / (mem + 1);
+   public:
+    /**
+     * This is called by SGD::Optimize() with UpdatePolicy SMORMS3Update before
+     * the start of the iteration update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const SMORMS3Update& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        mem(arma::ones<MatType>(rows, cols)),
+        g(arma::zeros<MatType>(rows, cols)),
+        g2(arma::zeros<MatType>(rows, cols))
+    {
+      // Nothing to do.
+    }
+
+    /**
+     * Update step for SMORMS3.
+     *
+     * @param iterate Parameter that minimizes the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      Step(iterate, stepSize, gradient, IsFusableUpdate<MatType, GradType>());
+    }
+
+   private:
+    //! Update the parameters and the iterate in a single loop.
+    void Step(MatType& iterate,
+              const double stepSize,
+              const GradType& gradient,
+              std::true_type /* fusable */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType epsilon = parent.epsilon;
+      const ElemType step = stepSize;
+
+      ElemType* x = iterate.memptr();
+      ElemType* memPtr = mem.memptr();
+      ElemType* gPtr = g.memptr();
+      ElemType* g2Ptr = g2.memptr();
+      const ElemType* grad = gradient.memptr();
+
+      const size_t n = iterate.n_elem;
+      ENS_PRAGMA_OMP_SIMD
+      for (size_t i = 0; i < n; ++i)
+      {
+        const ElemType r = 1 / (memPtr[i] + 1);
+        gPtr[i] = (1 - r) * gPtr[i] + r * grad[i];
+        g2Ptr[i] = (1 - r) * g2Ptr[i] + r * (grad[i] * grad[i]);
+
+        const ElemType lr = std::min((gPtr[i] * gPtr[i]) /
+            (g2Ptr[i] + epsilon), step);
+        x[i] -= grad[i] * lr / (std::sqrt(g2Ptr[i]) + epsilon);
+        memPtr[i] = memPtr[i] * (1 - lr) + 1;
+      }
+    }
+
+    //! Update the parameters and the iterate with Armadillo expressions.
+    void Step(MatType& iterate,
+              const double stepSize,
+              const GradType& gradient,
+              std::false_type /* fusable */)
+    {
+      // Update the iterate.
+      MatType r = 1 / (mem + 1);
 
-    g = (1 - r) % g;
-    g += r % gradient;
+      g = (1 - r) % g;
+      g += r % gradient;
 
-    g2 = (1 - r) % g2;
-    g2 += r % (gradient % gradient);
+      g2 = (1 - r) % g2;
+      g2 += r % (gradient % gradient);
 
-    arma::mat x = (g % g) / (g2 + epsilon);
+      MatType x = (g % g) / (g2 + parent.epsilon);
 
-    x.transform( [stepSize](double &v) { return std::min(v, stepSize); } );
+      typedef typename MatType::elem_type ElemType;
+      x.transform( [stepSize](ElemType &v)
+          { return std::min(v, (ElemType) stepSize); } );
 
-    iterate -= gradient % x / (arma::sqrt(g2) + epsilon);
+      iterate -= gradient % x / (arma::sqrt(g2) + parent.epsilon);
 
-    mem %= (1 - x);
-    mem += 1;
-  }
+      mem %= (1 - x);
+      mem += 1;
+    }
 
-  //! Get the value used to initialise the mean squared gradient parameter.
-  double Epsilon() const { return epsilon; }
-  //! Modify the value used to initialise the mean squared gradient parameter.
-  double& Epsilon() { return epsilon; }
+    // Instantiated parent object.
+    const SMORMS3Update& parent;
+
+    // The parameters mem, g and g2.
+    MatType mem, g, g2;
+  };
 
  private:
   //! The value used to initialise the mean squared gradient parameter.
   double epsilon;
-
-  // The parameters mem, g and g2.
-  arma::mat mem, g, g2;
 };
 
 } // namespace ens
@@ -88,7 +88,7 @@ double SPALeRASGD<DecayPolicyType>::Optimize(DecomposableFunctionType& function,
     {
       // Output current objective function.
       Info << "SPALeRA SGD: iteration " << i << ", objective "
-          << overallObjective << "." << std::endl;
+          << overallObjective << ".\n";
 
       if (std::isnan(overallObjective) || std::isinf(overallObjective))
       {
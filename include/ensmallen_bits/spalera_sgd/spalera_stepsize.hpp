@@ -67,8 +67,9 @@ class SPALeRAStepsize
    */
   void Initialize(const size_t rows, const size_t cols, const double lambda)
   {
-    learningRates = arma::ones(rows, cols);
-    relaxedSums = arma::zeros(rows, cols);
+    learningRates.ones(rows, cols);
+    relaxedSums.zeros(rows, cols);
+    previousIterate.zeros(rows, cols);
 
     this->lambda = lambda;
 
@@ -129,14 +130,18 @@ class SPALeRAStepsize
 
       // Dividing learning rates by 2 as proposed in:
       // Stochastic Gradient Descent: Going As Fast As Possible But Not Faster.
-      learningRates /= 2;
-
-      if (arma::any(arma::vectorise(learningRates) <= 1e-15))
+      // Stop if a learning rate gets too low.
+      double* rates = learningRates.memptr();
+      bool tooLow = false;
+      for (size_t i = 0; i < learningRates.n_elem; ++i)
       {
-        // Stop because learning rate too low.
-        return false;
+        rates[i] /= 2;
+        tooLow |= (rates[i] <= 1e-15);
       }
 
+      if (tooLow)
+        return false;
+
       // Reset evaluation and Page-Hinkley counter parameter.
       mu0 = un = mn = relaxedObjective = phCounter = eveCounter = 0;
     }
@@ -148,18 +153,30 @@ class SPALeRAStepsize
       const double paramStd = (alpha / std::sqrt(iterate.n_elem)) /
           std::sqrt(iterate.n_elem);
 
-      const double normGradient = std::sqrt(arma::accu(arma::pow(gradient, 2)));
-
-      relaxedSums *= (1 - alpha);
-      if (normGradient > epsilon)
-        relaxedSums += gradient * (alpha / normGradient);
-
-      learningRates %= arma::exp((arma::pow(relaxedSums, 2) - paramMean) *
-          (adaptRate / paramStd));
-
-      previousIterate = iterate;
+      const double normGradient = std::sqrt(arma::dot(gradient, gradient));
+
+      // Update the relaxed sums, the learning rates, the backtracking point and
+      // the iterate in a single pass, without any temporary matrix.
+      const double decay = 1 - alpha;
+      const bool addGradient = (normGradient > epsilon);
+      const double gradientScale = addGradient ? alpha / normGradient : 0.0;
+      const double rateScale = adaptRate / paramStd;
+
+      const double* g = gradient.memptr();
+      double* sums = relaxedSums.memptr();
+      double* rates = learningRates.memptr();
+      double* x = iterate.memptr();
+      double* previous = previousIterate.memptr();
+      for (size_t i = 0; i < iterate.n_elem; ++i)
+      {
+        sums[i] *= decay;
+        if (addGradient)
+          sums[i] += gradientScale * g[i];
 
-      iterate -= stepSize * (learningRates % gradient);
+        rates[i] *= std::exp((sums[i] * sums[i] - paramMean) * rateScale);
+        previous[i] = x[i];
+        x[i] -= stepSize * (rates[i] * g[i]);
+      }
 
       // Keep track of the the number of evaluations and Page-Hinkley steps.
       eveCounter++;
@@ -169,6 +186,9 @@ class SPALeRAStepsize
     return true;
   }
 
+  //! Get the parameter-wise learning rates.
+  const arma::mat& LearningRates() const { return learningRates; }
+
   //! Get the agnostic learning rate adaptation parameter.
   double Alpha() const { return alpha; }
   //! Modify the agnostic learning rate adaptation parameter.
@@ -34,6 +34,13 @@ namespace ens {
  * }
  * @endcode
  *
+ * Each iteration can average the estimates of numPerturbations independent
+ * directions, which reduces the variance of the gradient estimate (each
+ * direction costs two evaluations).  If parallelEvaluation is true (and OpenMP
+ * is enabled), the evaluations of the different directions run in parallel;
+ * the function's Evaluate() must then be safe to call from multiple threads at
+ * once.
+ *
  * SPSA can optimize arbitrary functions.  For more details,
  * see the documentation on function types included with this distribution or on
  * the ensmallen website.
@@ -56,6 +63,10 @@ class SPSA
    * @param tolerance Maximum absolute tolerance to terminate algorithm.
    * @param shuffle If true, the function order is shuffled; otherwise, each
    *     function is visited in linear order.
+   * @param numPerturbations Number of stochastic directions averaged per
+   *     iteration.
+   * @param parallelEvaluation Whether to evaluate the directions in parallel
+   *     (requires OpenMP and a thread-safe Evaluate()).
    */
   SPSA(const double alpha = 0.602,
        const double gamma = 0.101,
@@ -63,10 +74,26 @@ class SPSA
        const double evaluationStepSize = 0.3,
        const size_t maxIterations = 100000,
        const double tolerance = 1e-5,
-       const bool shuffle = true);
+       const bool shuffle = true,
+       const size_t numPerturbations = 1,
+       const bool parallelEvaluation = false);
 
-  template<typename DecomposableFunctionType>
-  double Optimize(DecomposableFunctionType& function, arma::mat& iterate);
+  /**
+   * Optimize the given function using SPSA.  The given starting point will be
+   * modified to store the finishing point of the algorithm, and the final
+   * objective value is returned.
+   *
+   * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename DecomposableFunctionType, typename... CallbackTypes>
+  double Optimize(DecomposableFunctionType& function,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
 
   //! Get the scaling exponent for the step size.
   double Alpha() const { return alpha; }
@@ -93,6 +120,16 @@ class SPSA
   //! Modify the maximum number of iterations (0 indicates no limit).
   size_t& MaxIterations() { return maxIterations; }
 
+  //! Get the number of stochastic directions averaged per iteration.
+  size_t NumPerturbations() const { return numPerturbations; }
+  //! Modify the number of stochastic directions averaged per iteration.
+  size_t& NumPerturbations() { return numPerturbations; }
+
+  //! Get whether the directions are evaluated in parallel.
+  bool ParallelEvaluation() const { return parallelEvaluation; }
+  //! Modify whether the directions are evaluated in parallel.
+  bool& ParallelEvaluation() { return parallelEvaluation; }
+
  private:
   //! Scaling exponent for the step size.
   double alpha;
@@ -118,6 +155,12 @@ class SPSA
   //! Controls whether or not the individual functions are shuffled when
   //! iterating.
   bool shuffle;
+
+  //! The number of stochastic directions averaged per iteration.
+  size_t numPerturbations;
+
+  //! Whether the directions are evaluated in parallel.
+  bool parallelEvaluation;
 };
 
 } // namespace ens
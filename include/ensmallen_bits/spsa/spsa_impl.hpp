@@ -27,7 +27,9 @@ inline SPSA::SPSA(const double alpha,
                   const double evaluationStepSize,
                   const size_t maxIterations,
                   const double tolerance,
-                  const bool shuffle) :
+                  const bool shuffle,
+                  const size_t numPerturbations,
+                  const bool parallelEvaluation) :
     alpha(alpha),
     gamma(gamma),
     stepSize(stepSize),
@@ -35,34 +37,56 @@ inline SPSA::SPSA(const double alpha,
     ak(0.001 * maxIterations),
     maxIterations(maxIterations),
     tolerance(tolerance),
-    shuffle(shuffle)
+    shuffle(shuffle),
+    numPerturbations(numPerturbations),
+    parallelEvaluation(parallelEvaluation)
 { /* Nothing to do. */ }
 
-template<typename ArbitraryFunctionType>
-inline double SPSA::Optimize(
-    ArbitraryFunctionType& function, arma::mat& iterate)
+template<typename ArbitraryFunctionType, typename... CallbackTypes>
+inline double SPSA::Optimize(ArbitraryFunctionType& function,
+                             arma::mat& iterate,
+                             CallbackTypes&&... callbacks)
 {
   // Make sure that we have the methods that we need.
   // TODO: CheckArbitraryFunctionTypeAPI isn't implemented yet.
 //  traits::CheckArbitraryFunctionTypeAPI<ArbitraryFunctionType>();
 
+  if (numPerturbations == 0)
+  {
+    throw std::invalid_argument("SPSA::Optimize(): numPerturbations must be "
+        "positive!");
+  }
+
+  // The buffers are allocated once: the directions, the two points to
+  // evaluate along each direction (in columns 2j and 2j + 1), and their
+  // objectives.
   arma::mat gradient(iterate.n_rows, iterate.n_cols);
-  arma::mat spVector(iterate.n_rows, iterate.n_cols);
+  arma::cube spVectors(iterate.n_rows, iterate.n_cols, numPerturbations);
+  RNG rng(RNG::ArmaSeed());
+  std::vector<arma::mat> points(2 * numPerturbations,
+      arma::mat(iterate.n_rows, iterate.n_cols));
+  arma::vec objectives(2 * numPerturbations);
 
   // To keep track of where we are and how things are going.
   double overallObjective = 0;
   double lastObjective = DBL_MAX;
 
-  for (size_t k = 0; k < maxIterations; ++k)
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+  terminate |= Callback::BeginOptimization(*this, function, iterate,
+      callbacks...);
+
+  for (size_t k = 0; k < maxIterations && !terminate; ++k)
   {
     // Output current objective function.
     Info << "SPSA: iteration " << k << ", objective " << overallObjective
-        << "." << std::endl;
+        << ".\n";
 
     if (std::isnan(overallObjective) || std::isinf(overallObjective))
     {
       Warn << "SPSA: converged to " << overallObjective << "; terminating"
           << " with failure.  Try a smaller step size?" << std::endl;
+      Callback::EndOptimization(*this, function, iterate, callbacks...);
       return overallObjective;
     }
 
@@ -70,6 +94,7 @@ inline double SPSA::Optimize(
     {
       Warn << "SPSA: minimized within tolerance " << tolerance << "; "
           << "terminating optimization." << std::endl;
+      Callback::EndOptimization(*this, function, iterate, callbacks...);
       return overallObjective;
     }
 
@@ -80,26 +105,73 @@ inline double SPSA::Optimize(
     const double akLocal = stepSize / std::pow(k + 1 + ak, alpha);
     const double ck = evaluationStepSize / std::pow(k + 1, gamma);
 
-    // Choose stochastic directions.
-    spVector = arma::conv_to<arma::mat>::from(
-        arma::randi(iterate.n_rows, iterate.n_cols,
-        arma::distr_param(0, 1))) * 2 - 1;
+    // Choose stochastic directions, with elements of +1 or -1 with equal
+    // probability.  They are drawn serially, so that the result does not
+    // depend on the number of threads.
+    double* spValues = spVectors.memptr();
+    for (size_t i = 0; i < spVectors.n_elem; ++i)
+      spValues[i] = (rng() >> 63) ? 1.0 : -1.0;
 
-    iterate += ck * spVector;
-    const double fPlus = function.Evaluate(iterate);
+    if (traits::HasAsyncEvaluate<ArbitraryFunctionType, arma::mat>::value)
+    {
+      // Keep all the evaluations in flight at once.
+      for (size_t j = 0; j < numPerturbations; ++j)
+      {
+        points[2 * j] = iterate + ck * spVectors.slice(j);
+        points[2 * j + 1] = iterate - ck * spVectors.slice(j);
+      }
+
+      TryEvaluateInFlight(function, points.size(),
+          [&](const size_t j) -> const arma::mat& { return points[j]; },
+          [&](const size_t j, const double objective)
+          {
+            objectives(j) = objective;
+          });
+    }
+    else
+    {
+      ParallelFor(numPerturbations, [&](const size_t j)
+      {
+        points[2 * j] = iterate + ck * spVectors.slice(j);
+        objectives(2 * j) = function.Evaluate(points[2 * j]);
+
+        points[2 * j + 1] = iterate - ck * spVectors.slice(j);
+        objectives(2 * j + 1) = function.Evaluate(points[2 * j + 1]);
+      }, parallelEvaluation ||
+          traits::IsThreadSafeFunction<ArbitraryFunctionType>::value);
+    }
+
+    // The evaluations are reported afterwards, so that callbacks are never
+    // called from several threads.
+    for (size_t j = 0; j < points.size(); ++j)
+    {
+      terminate |= Callback::Evaluate(*this, function, points[j],
+          objectives(j), callbacks...);
+    }
 
-    iterate -= 2 * ck * spVector;
-    const double fMinus = function.Evaluate(iterate);
-    iterate += ck * spVector;
+    // Average the estimates; since the elements of the directions are +1 or
+    // -1, dividing by them is the same as multiplying by them.
+    gradient.zeros();
+    for (size_t j = 0; j < numPerturbations; ++j)
+    {
+      gradient += (objectives(2 * j) - objectives(2 * j + 1)) *
+          spVectors.slice(j);
+    }
+    gradient /= 2 * ck * numPerturbations;
 
-    gradient = (fPlus - fMinus) * (1 / (2 * ck * spVector));
     iterate -= akLocal * gradient;
 
     overallObjective = function.Evaluate(iterate);
+    terminate |= Callback::Evaluate(*this, function, iterate,
+        overallObjective, callbacks...);
+    terminate |= Callback::StepTaken(*this, function, iterate, callbacks...);
   }
 
   // Calculate final objective.
-  return function.Evaluate(iterate);
+  const double objective = function.Evaluate(iterate);
+  Callback::Evaluate(*this, function, iterate, objective, callbacks...);
+  Callback::EndOptimization(*this, function, iterate, callbacks...);
+  return objective;
 }
 
 } // namespace ens
@@ -0,0 +1,176 @@
+/**
+ * @file streaming_sgd.hpp
+ *
+ * Stochastic gradient descent over a stream of batches, for datasets that do
+ * not fit in memory.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_STREAMING_SGD_STREAMING_SGD_HPP
+#define ENSMALLEN_STREAMING_SGD_STREAMING_SGD_HPP
+
+#include <ensmallen_bits/sgd/sgd.hpp>
+#include <ensmallen_bits/adam/adam_update.hpp>
+
+namespace ens {
+
+/**
+ * StreamingSGD runs stochastic gradient descent (with any of the SGD update
+ * and decay policies) on a streaming function, which reads its data one batch
+ * at a time instead of giving random access to all of its separable
+ * functions.  So the dataset never has to be held in memory, and the number of
+ * functions does not have to be known.  A streaming function must implement
+ *
+ * @code
+ * // Read the next batch of at most batchSize functions, and return the
+ * // number of functions read.  Returning 0 marks the end of an epoch; the
+ * // following call starts the next one (or returns 0 again if the stream is
+ * // exhausted).
+ * size_t NextBatch(const size_t batchSize);
+ * @endcode
+ *
+ * and the objective and gradient of the current batch, either as a
+ * non-separable EvaluateWithGradient() or as Evaluate() and Gradient() (see
+ * the documentation on function types).  Any shuffling is up to the data
+ * source.
+ *
+ * At the end of each epoch, the sum of the batch objectives of that epoch
+ * (each computed before the step on that batch) is compared with the previous
+ * epoch to check for convergence.  A stream that never signals the end of an
+ * epoch runs until maxIterations functions have been visited.
+ *
+ * @tparam UpdatePolicyType Update policy used during the iterative update
+ *     process (see ens::VanillaUpdate).
+ * @tparam DecayPolicyType Decay policy used to adjust the step size (see
+ *     ens::NoDecay).
+ */
+template<typename UpdatePolicyType = VanillaUpdate,
+         typename DecayPolicyType = NoDecay>
+class StreamingSGD
+{
+ public:
+  /**
+   * Construct the StreamingSGD optimizer with the given parameters.  The
+   * maximum number of iterations refers to the maximum number of functions
+   * that are processed (one batch counts as many iterations as it has
+   * functions).
+   *
+   * @param stepSize Step size for each iteration.
+   * @param batchSize Maximum number of functions to request per batch.
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *     limit).
+   * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param updatePolicy Instantiated update policy used to adjust the given
+   *     parameters.
+   * @param decayPolicy Instantiated decay policy used to adjust the step size.
+   * @param resetPolicy Flag that determines whether update policy parameters
+   *     are reset before every Optimize call.
+   */
+  StreamingSGD(const double stepSize = 0.01,
+               const size_t batchSize = 32,
+               const size_t maxIterations = 100000,
+               const double tolerance = 1e-5,
+               const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
+               const DecayPolicyType& decayPolicy = DecayPolicyType(),
+               const bool resetPolicy = true);
+
+  /**
+   * Optimize the given streaming function.  The given starting point will be
+   * modified to store the finishing point of the algorithm.  The returned
+   * objective is the sum of the batch objectives of the last complete epoch
+   * (or of the batches seen so far, if no epoch was completed); there is no
+   * final pass over the data.
+   *
+   * @tparam StreamingFunctionType Type of the function to be optimized.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the last epoch.
+   */
+  template<typename StreamingFunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(StreamingFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks);
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the batch size.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the update policy parameters
+  //! are reset before Optimize call.
+  bool ResetPolicy() const { return resetPolicy; }
+  //! Modify whether or not the update policy parameters
+  //! are reset before Optimize call.
+  bool& ResetPolicy() { return resetPolicy; }
+
+  //! Get the update policy.
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  //! Modify the update policy.
+  UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
+
+  //! Get the step size decay policy.
+  const DecayPolicyType& DecayPolicy() const { return decayPolicy; }
+  //! Modify the step size decay policy.
+  DecayPolicyType& DecayPolicy() { return decayPolicy; }
+
+ private:
+  //! The step size for each example.
+  double stepSize;
+
+  //! The batch size for processing.
+  size_t batchSize;
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! The update policy used to update the parameters in each iteration.
+  UpdatePolicyType updatePolicy;
+
+  //! The decay policy used to update the step size.
+  DecayPolicyType decayPolicy;
+
+  //! Flag indicating whether update policy
+  //! should be reset before running optimization.
+  bool resetPolicy;
+
+  //! The initialized update policy.  Its type depends on the matrix type
+  //! given to Optimize(), so it is held in an Any object.
+  Any instUpdatePolicy;
+};
+
+using StreamingAdam = StreamingSGD<AdamUpdate>;
+
+} // namespace ens
+
+// Include implementation.
+#include "streaming_sgd_impl.hpp"
+
+#endif
@@ -0,0 +1,187 @@
+/**
+ * @file streaming_sgd_impl.hpp
+ *
+ * Implementation of stochastic gradient descent over a stream of batches.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_STREAMING_SGD_STREAMING_SGD_IMPL_HPP
+#define ENSMALLEN_STREAMING_SGD_STREAMING_SGD_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "streaming_sgd.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+template<typename UpdatePolicyType, typename DecayPolicyType>
+StreamingSGD<UpdatePolicyType, DecayPolicyType>::StreamingSGD(
+    const double stepSize,
+    const size_t batchSize,
+    const size_t maxIterations,
+    const double tolerance,
+    const UpdatePolicyType& updatePolicy,
+    const DecayPolicyType& decayPolicy,
+    const bool resetPolicy) :
+    stepSize(stepSize),
+    batchSize(batchSize),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    updatePolicy(updatePolicy),
+    decayPolicy(decayPolicy),
+    resetPolicy(resetPolicy)
+{ /* Nothing to do. */ }
+
+//! Optimize the function (minimize).
+template<typename UpdatePolicyType, typename DecayPolicyType>
+template<typename StreamingFunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename MatType::elem_type
+StreamingSGD<UpdatePolicyType, DecayPolicyType>::Optimize(
+    StreamingFunctionType& function,
+    MatType& iterateIn,
+    CallbackTypes&&... callbacks)
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+  typedef typename UpdatePolicyType::template Policy<BaseMatType, BaseGradType>
+      InstUpdatePolicyType;
+
+  // The objective of the current batch is given by the non-separable methods;
+  // use the Function<> wrapper to fill in the missing ones.
+  typedef Function<StreamingFunctionType, BaseMatType, BaseGradType>
+      FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  // Make sure we have all the methods that we need.
+  traits::CheckStreamingFunctionTypeAPI<StreamingFunctionType,
+      FullFunctionType, BaseMatType, BaseGradType>();
+
+  // Vectors are optimized as matrices.
+  BaseMatType& iterate = static_cast<BaseMatType&>(iterateIn);
+
+  // To keep track of where we are and how things are going.
+  size_t epochFunctions = 0;
+  ElemType overallObjective = 0;
+  ElemType lastObjective = std::numeric_limits<ElemType>::max();
+
+  // Initialize the update policy.  If the previous call used a different
+  // matrix type, the policy has to be reinitialized anyway.
+  if (resetPolicy || !instUpdatePolicy.Has<InstUpdatePolicyType>())
+  {
+    instUpdatePolicy.Set(new InstUpdatePolicyType(updatePolicy,
+        iterate.n_rows, iterate.n_cols));
+  }
+  InstUpdatePolicyType& instPolicy =
+      instUpdatePolicy.As<InstUpdatePolicyType>();
+
+  // Track the current epoch and whether a callback asked us to stop.
+  size_t epoch = 0;
+  bool terminate = false;
+  terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
+
+  // Now iterate!
+  BaseGradType gradient(iterate.n_rows, iterate.n_cols);
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+  for (size_t i = 0; i < actualMaxIterations && !terminate;
+      /* incrementing done manually */)
+  {
+    // Read the next batch; it can't be larger than the number of iterations
+    // left before actualMaxIterations is hit.
+    const size_t effectiveBatchSize = f.NextBatch(std::min(batchSize,
+        actualMaxIterations - i));
+
+    if (effectiveBatchSize == 0)
+    {
+      // An epoch without any batches means that the stream is exhausted.
+      if (epochFunctions == 0)
+      {
+        Info << "StreamingSGD: no more data; terminating optimization."
+            << std::endl;
+        break;
+      }
+
+      // Output current objective function.
+      Info << "StreamingSGD: iteration " << i << ", objective "
+          << overallObjective << ".\n";
+
+      terminate |= Callback::EndEpoch(*this, f, iterate, epoch++,
+          overallObjective, callbacks...);
+
+      if (std::isnan(overallObjective) || std::isinf(overallObjective))
+      {
+        Warn << "StreamingSGD: converged to " << overallObjective << "; "
+            << "terminating with failure.  Try a smaller step size?"
+            << std::endl;
+        Callback::EndOptimization(*this, f, iterate, callbacks...);
+        return overallObjective;
+      }
+
+      if (std::abs(lastObjective - overallObjective) < tolerance)
+      {
+        Info << "StreamingSGD: minimized within tolerance " << tolerance
+            << "; terminating optimization." << std::endl;
+        Callback::EndOptimization(*this, f, iterate, callbacks...);
+        return overallObjective;
+      }
+
+      // Reset the counter variables.
+      lastObjective = overallObjective;
+      overallObjective = 0;
+      epochFunctions = 0;
+
+      if (terminate)
+      {
+        Info << "StreamingSGD: callback requested termination." << std::endl;
+        break;
+      }
+
+      terminate |= Callback::BeginEpoch(*this, f, iterate, epoch,
+          lastObjective, callbacks...);
+      continue;
+    }
+
+    // The objective is computed before the step is taken.
+    const ElemType objective = f.EvaluateWithGradient(iterate, gradient);
+    overallObjective += objective;
+
+    terminate |= Callback::EvaluateWithGradient(*this, f, iterate, objective,
+        gradient, callbacks...);
+
+    // Use the update policy to take a step.
+    instPolicy.Update(iterate, stepSize, gradient);
+
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+
+    // Now update the learning rate if requested by the user.
+    decayPolicy.Update(iterate, stepSize, gradient);
+
+    i += effectiveBatchSize;
+    epochFunctions += effectiveBatchSize;
+
+    if (i >= actualMaxIterations)
+    {
+      Info << "StreamingSGD: maximum iterations (" << maxIterations << ") "
+          << "reached; terminating optimization." << std::endl;
+    }
+  }
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+
+  // There is no final pass over the data, so return the objective of the last
+  // complete epoch, if there is one.
+  return (epoch > 0) ? lastObjective : overallObjective;
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,240 @@
+/**
+ * @file async_svrg.hpp
+ *
+ * Asynchronous, lock-free stochastic variance reduced gradient (KroMagnon).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SVRG_ASYNC_SVRG_HPP
+#define ENSMALLEN_SVRG_ASYNC_SVRG_HPP
+
+#include <ensmallen_bits/parallel_sgd/update_policies/atomic_update.hpp>
+#include <ensmallen_bits/parallel_sgd/update_policies/hogwild_update.hpp>
+
+namespace ens {
+
+/**
+ * An asynchronous variant of SVRG for sparse separable functions, in which
+ * all the threads run the inner iterations concurrently against the shared
+ * iterate, without locks (as in HOGWILD!).  Each outer iteration computes the
+ * full gradient at a snapshot of the iterate, in parallel; then the threads
+ * repeatedly claim the next batch, compute its sparse gradients at the shared
+ * iterate and at the snapshot, and apply the variance reduced step
+ *
+ * \f[
+ * v = \frac{1}{b} (\nabla f_B(x) - \nabla f_B(\tilde{x})) +
+ *     D_B \tilde{\mu}
+ * \f]
+ *
+ * to the shared iterate with the update policy (AtomicUpdate or HogwildUpdate,
+ * as for ParallelSGD).  To keep the steps sparse, the snapshot full gradient
+ * \f$ \tilde{\mu} \f$ is only applied on the coordinates the batch depends on
+ * (the support of its gradient at the snapshot), reweighted by the inverse of
+ * the fraction of the batches that depend on each coordinate (\f$ D_B \f$), so
+ * that the steps stay unbiased; dense steps would make every thread write the
+ * whole iterate.  The supports are counted in the same pass as the full
+ * gradient.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @article{Mania2017,
+ *   author  = {Horia Mania and Xinghao Pan and Dimitris Papailiopoulos and
+ *              Benjamin Recht and Kannan Ramchandran and Michael I. Jordan},
+ *   title   = {Perturbed Iterate Analysis for Asynchronous Stochastic
+ *              Optimization},
+ *   journal = {SIAM Journal on Optimization},
+ *   volume  = {27},
+ *   number  = {4},
+ *   pages   = {2202--2229},
+ *   year    = {2017}
+ * }
+ * @endcode
+ *
+ * The number of threads is the number of OpenMP threads; without OpenMP, the
+ * inner iterations run one after another.  The separable Gradient() (and
+ * Evaluate(), if parallelFullPass is true) must be safe to call concurrently,
+ * and reads the shared iterate while other threads update it.  The results are
+ * in general not reproducible with more than one thread.  Callbacks are called
+ * at the beginning and the end of the optimization, and with the objective of
+ * each outer iteration (Evaluate() and EndEpoch()); since the steps are taken
+ * by several threads at once, StepTaken() is not called.
+ *
+ * AsyncSVRG can optimize sparse differentiable separable functions.  For more
+ * details, see the documentation on function types included with this
+ * distribution or on the ensmallen website.
+ *
+ * @tparam UpdatePolicyType Policy used by the threads to apply their sparse
+ *     steps to the shared iterate.
+ */
+template<typename UpdatePolicyType = AtomicUpdate>
+class AsyncSVRGType
+{
+ public:
+  /**
+   * Construct the asynchronous SVRG optimizer with the given parameters.  The
+   * defaults here are not necessarily good for the given problem, so it is
+   * suggested that the values used be tailored to the task at hand.
+   *
+   * @param stepSize Step size for each inner iteration.
+   * @param batchSize Number of functions in each inner iteration.
+   * @param maxIterations Maximum number of outer iterations (0 means no
+   *     limit).
+   * @param innerIterations Number of functions visited by the inner
+   *     iterations of an outer iteration, across all threads (0 means the
+   *     number of functions).
+   * @param tolerance Maximum absolute tolerance to terminate the algorithm.
+   * @param shuffle If true, the batches are visited in a random order;
+   *     otherwise, they are visited in linear order.
+   * @param updatePolicy The policy used to apply the sparse steps.
+   * @param parallelFullPass Whether the full gradient and the objective are
+   *     also computed by all the threads.
+   */
+  AsyncSVRGType(const double stepSize = 0.01,
+                const size_t batchSize = 32,
+                const size_t maxIterations = 1000,
+                const size_t innerIterations = 0,
+                const double tolerance = 1e-5,
+                const bool shuffle = true,
+                const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
+                const bool parallelFullPass = true);
+
+  /**
+   * Optimize the given function using asynchronous SVRG.  The given starting
+   * point will be modified to store the finishing point of the algorithm, and
+   * the final objective value is returned.
+   *
+   * @tparam SparseFunctionType Type of the function to be optimized.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize; it must have a sparse Gradient().
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename SparseFunctionType, typename... CallbackTypes>
+  double Optimize(SparseFunctionType& function,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
+
+  /**
+   * Estimate the number of bytes Optimize() allocates for an iterate of the
+   * given size: the snapshot, its reweighted full gradient, and the partial
+   * full gradient and support counts of each thread (the sparse gradients of
+   * the threads and the buffers of the update policy are not included).
+   *
+   * @param rows Number of rows of the iterate.
+   * @param cols Number of columns of the iterate.
+   */
+  size_t EstimateMemory(const size_t rows, const size_t cols = 1) const;
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the batch size.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the maximum number of outer iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of outer iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the number of functions of the inner iterations (0 indicates the
+  //! number of functions).
+  size_t InnerIterations() const { return innerIterations; }
+  //! Modify the number of functions of the inner iterations (0 indicates the
+  //! number of functions).
+  size_t& InnerIterations() { return innerIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the batches are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the batches are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+  //! Get the update policy.
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  //! Modify the update policy.
+  UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
+
+  //! Get whether the full gradient and the objective are computed in
+  //! parallel.
+  bool ParallelFullPass() const { return parallelFullPass; }
+  //! Modify whether the full gradient and the objective are computed in
+  //! parallel.
+  bool& ParallelFullPass() { return parallelFullPass; }
+
+ private:
+  /**
+   * Compute the full gradient at the snapshot, divided by the number of
+   * functions, and the inverse of the fraction of the batches whose gradient
+   * is nonzero on each coordinate; the result is their product.
+   *
+   * @param function Function to differentiate.
+   * @param iterate0 The snapshot.
+   * @param weightedFullGradient Matrix to store the result in.
+   * @param partialGradients Partial full gradients of the threads.
+   * @param partialCounts Partial support counts of the threads.
+   * @param gradients Sparse gradients of the threads.
+   */
+  template<typename SparseFunctionType>
+  void SnapshotGradient(SparseFunctionType& function,
+                        const arma::mat& iterate0,
+                        arma::mat& weightedFullGradient,
+                        std::vector<arma::mat>& partialGradients,
+                        std::vector<arma::mat>& partialCounts,
+                        std::vector<arma::sp_mat>& gradients) const;
+
+  //! Get the number of the calling thread.
+  static size_t ThreadId();
+
+  //! Get the maximum number of threads.
+  static size_t MaxThreads();
+
+  //! The step size for each inner iteration.
+  double stepSize;
+
+  //! The number of functions in each inner iteration.
+  size_t batchSize;
+
+  //! The maximum number of outer iterations.
+  size_t maxIterations;
+
+  //! The number of functions of the inner iterations.
+  size_t innerIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Whether the batches are shuffled.
+  bool shuffle;
+
+  //! The policy used to apply the sparse steps.
+  UpdatePolicyType updatePolicy;
+
+  //! Whether the full gradient and the objective are computed in parallel.
+  bool parallelFullPass;
+};
+
+//! Asynchronous SVRG with atomic updates.
+using AsyncSVRG = AsyncSVRGType<AtomicUpdate>;
+
+//! Asynchronous SVRG with unsynchronized (HOGWILD!) updates.
+using HogwildSVRG = AsyncSVRGType<HogwildUpdate>;
+
+} // namespace ens
+
+// Include implementation.
+#include "async_svrg_impl.hpp"
+
+#endif
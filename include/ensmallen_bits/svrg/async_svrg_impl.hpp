@@ -0,0 +1,296 @@
+/**
+ * @file async_svrg_impl.hpp
+ *
+ * Implementation of asynchronous, lock-free SVRG.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SVRG_ASYNC_SVRG_IMPL_HPP
+#define ENSMALLEN_SVRG_ASYNC_SVRG_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "async_svrg.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+template<typename UpdatePolicyType>
+AsyncSVRGType<UpdatePolicyType>::AsyncSVRGType(
+    const double stepSize,
+    const size_t batchSize,
+    const size_t maxIterations,
+    const size_t innerIterations,
+    const double tolerance,
+    const bool shuffle,
+    const UpdatePolicyType& updatePolicy,
+    const bool parallelFullPass) :
+    stepSize(stepSize),
+    batchSize(batchSize),
+    maxIterations(maxIterations),
+    innerIterations(innerIterations),
+    tolerance(tolerance),
+    shuffle(shuffle),
+    updatePolicy(updatePolicy),
+    parallelFullPass(parallelFullPass)
+{ /* Nothing to do. */ }
+
+template<typename UpdatePolicyType>
+size_t AsyncSVRGType<UpdatePolicyType>::EstimateMemory(
+    const size_t rows,
+    const size_t cols) const
+{
+  const size_t n = rows * cols;
+  return (2 + 2 * MaxThreads()) * n * sizeof(double);
+}
+
+//! Optimize the function (minimize).
+template<typename UpdatePolicyType>
+template<typename SparseFunctionType, typename... CallbackTypes>
+double AsyncSVRGType<UpdatePolicyType>::Optimize(
+    SparseFunctionType& function,
+    arma::mat& iterate,
+    CallbackTypes&&... callbacks)
+{
+  // Check that we have all the functions that we need.
+  traits::CheckSparseFunctionTypeAPI<SparseFunctionType>();
+  ENS_PROFILE_OPTIMIZE("AsyncSVRG");
+
+  const size_t numThreads = MaxThreads();
+  typedef typename UpdatePolicyType::template Policy<arma::mat, arma::sp_mat>
+      InstUpdatePolicyType;
+  InstUpdatePolicyType instPolicy(updatePolicy, iterate.n_rows, iterate.n_cols,
+      numThreads);
+
+  const size_t numFunctions = function.NumFunctions();
+  const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+  const size_t innerFunctions = (innerIterations == 0) ? numFunctions :
+      innerIterations;
+  const size_t innerBatches = (innerFunctions + batchSize - 1) / batchSize;
+  arma::Col<size_t> visitationOrder = arma::linspace<arma::Col<size_t>>(0,
+      (numBatches - 1), numBatches);
+
+  // Every thread reuses its own sparse gradients and partial sums for the
+  // whole optimization.
+  std::vector<arma::sp_mat> gradients(numThreads);
+  std::vector<arma::sp_mat> gradients0(numThreads);
+  std::vector<arma::sp_mat> steps(numThreads);
+  std::vector<arma::mat> partialGradients(numThreads);
+  std::vector<arma::mat> partialCounts(numThreads);
+  arma::mat iterate0;
+  arma::mat weightedFullGradient;
+
+  double overallObjective = 0;
+  double lastObjective = DBL_MAX;
+
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+  terminate |= Callback::BeginOptimization(*this, function, iterate,
+      callbacks...);
+
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+  for (size_t i = 0; i < actualMaxIterations && !terminate; ++i)
+  {
+    {
+      ENS_PROFILE_SCOPE("Evaluate");
+      overallObjective = FullPassEvaluate(function, iterate, batchSize,
+          parallelFullPass);
+    }
+
+    terminate |= Callback::Evaluate(*this, function, iterate,
+        overallObjective, callbacks...);
+    if (i > 0)
+    {
+      terminate |= Callback::EndEpoch(*this, function, iterate, i - 1,
+          overallObjective, callbacks...);
+    }
+
+    if (std::isnan(overallObjective) || std::isinf(overallObjective))
+    {
+      Warn << "AsyncSVRG: converged to " << overallObjective
+          << "; terminating  with failure.  Try a smaller step size?"
+          << std::endl;
+      Callback::EndOptimization(*this, function, iterate, callbacks...);
+      return overallObjective;
+    }
+
+    if (std::abs(lastObjective - overallObjective) < tolerance)
+    {
+      Info << "AsyncSVRG: minimized within tolerance " << tolerance
+          << "; terminating optimization." << std::endl;
+      Callback::EndOptimization(*this, function, iterate, callbacks...);
+      return overallObjective;
+    }
+
+    if (terminate)
+    {
+      Info << "AsyncSVRG: callback requested termination." << std::endl;
+      break;
+    }
+
+    lastObjective = overallObjective;
+
+    // Take the snapshot and compute its reweighted full gradient.
+    iterate0 = iterate;
+    {
+      ENS_PROFILE_SCOPE("Gradient");
+      SnapshotGradient(function, iterate0, weightedFullGradient,
+          partialGradients, partialCounts, gradients);
+    }
+
+    if (shuffle)
+      visitationOrder = arma::shuffle(visitationOrder);
+
+    // The next inner iteration that has not been claimed by any thread.
+    std::atomic<size_t> nextBatch(0);
+
+    auto work = [&]()
+    {
+      const size_t threadId = ThreadId();
+      arma::sp_mat& gradient = gradients[threadId];
+      arma::sp_mat& gradient0 = gradients0[threadId];
+      arma::sp_mat& step = steps[threadId];
+
+      for (size_t k = nextBatch.fetch_add(1); k < innerBatches;
+          k = nextBatch.fetch_add(1))
+      {
+        // The last batch may be smaller.
+        const size_t begin = visitationOrder[k % numBatches] * batchSize;
+        const size_t effectiveBatchSize = std::min(batchSize,
+            numFunctions - begin);
+
+        // The shared iterate may be changed by the other threads while the
+        // gradient is computed.
+        function.Gradient(iterate, begin, gradient, effectiveBatchSize);
+        function.Gradient(iterate0, begin, gradient0, effectiveBatchSize);
+
+        // The full gradient is only applied on the support of the batch.
+        step = (gradient - gradient0) / (double) effectiveBatchSize +
+            arma::spones(gradient0) % weightedFullGradient;
+        instPolicy.Update(iterate, stepSize, step, threadId);
+      }
+
+      // Make the remaining updates of this thread visible.
+      instPolicy.Flush(iterate, threadId);
+    };
+
+    {
+      ENS_PROFILE_SCOPE("UpdatePolicy::Update");
+      ENS_PRAGMA_OMP_PARALLEL
+      work();
+    }
+  }
+
+  if (!terminate)
+  {
+    Info << "AsyncSVRG: maximum iterations (" << maxIterations << ") reached; "
+        << "terminating optimization." << std::endl;
+  }
+
+  // Calculate final objective.
+  {
+    ENS_PROFILE_SCOPE("Evaluate");
+    overallObjective = FullPassEvaluate(function, iterate, batchSize,
+        parallelFullPass);
+  }
+
+  Callback::EndOptimization(*this, function, iterate, callbacks...);
+  return overallObjective;
+}
+
+template<typename UpdatePolicyType>
+template<typename SparseFunctionType>
+void AsyncSVRGType<UpdatePolicyType>::SnapshotGradient(
+    SparseFunctionType& function,
+    const arma::mat& iterate0,
+    arma::mat& weightedFullGradient,
+    std::vector<arma::mat>& partialGradients,
+    std::vector<arma::mat>& partialCounts,
+    std::vector<arma::sp_mat>& gradients) const
+{
+  const size_t numFunctions = function.NumFunctions();
+  const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+  for (size_t t = 0; t < partialGradients.size(); ++t)
+  {
+    partialGradients[t].zeros(iterate0.n_rows, iterate0.n_cols);
+    partialCounts[t].zeros(iterate0.n_rows, iterate0.n_cols);
+  }
+
+  // Each thread adds the gradients of the batches it claims, and counts the
+  // batches whose gradient is nonzero on each coordinate.
+  std::atomic<size_t> nextBatch(0);
+  auto work = [&]()
+  {
+    const size_t threadId = ThreadId();
+    arma::sp_mat& gradient = gradients[threadId];
+    for (size_t b = nextBatch.fetch_add(1); b < numBatches;
+        b = nextBatch.fetch_add(1))
+    {
+      const size_t begin = b * batchSize;
+      function.Gradient(iterate0, begin, gradient,
+          std::min(batchSize, numFunctions - begin));
+
+      partialGradients[threadId] += gradient;
+      for (arma::sp_mat::const_iterator it = gradient.begin();
+          it != gradient.end(); ++it)
+      {
+        partialCounts[threadId](it.row(), it.col()) += 1.0;
+      }
+    }
+  };
+
+  if (parallelFullPass)
+  {
+    ENS_PRAGMA_OMP_PARALLEL
+    work();
+  }
+  else
+  {
+    work();
+  }
+
+  for (size_t t = 1; t < partialGradients.size(); ++t)
+  {
+    partialGradients[0] += partialGradients[t];
+    partialCounts[0] += partialCounts[t];
+  }
+
+  // A coordinate that is in the support of a fraction p of the batches gets
+  // the full gradient with weight 1 / p in each of them.  The full gradient is
+  // zero on the coordinates outside every support.
+  const arma::mat& counts = partialCounts[0];
+  weightedFullGradient = partialGradients[0] / (double) numFunctions;
+  for (size_t j = 0; j < weightedFullGradient.n_elem; ++j)
+  {
+    weightedFullGradient[j] *= (counts[j] > 0.0) ? numBatches / counts[j] :
+        0.0;
+  }
+}
+
+template<typename UpdatePolicyType>
+size_t AsyncSVRGType<UpdatePolicyType>::ThreadId()
+{
+  #ifdef ENS_USE_OPENMP
+    return omp_get_thread_num();
+  #else
+    return 0;
+  #endif
+}
+
+template<typename UpdatePolicyType>
+size_t AsyncSVRGType<UpdatePolicyType>::MaxThreads()
+{
+  #ifdef ENS_USE_OPENMP
+    return omp_get_max_threads();
+  #else
+    return 1;
+  #endif
+}
+
+} // namespace ens
+
+#endif
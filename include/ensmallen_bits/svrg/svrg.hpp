@@ -13,6 +13,7 @@
 #define ENSMALLEN_SVRG_SVRG_HPP
 
 #include <ensmallen_bits/sgd/decay_policies/no_decay.hpp>
+#include <ensmallen_bits/function/objective_estimate.hpp>
 
 #include "svrg_update.hpp"
 #include "barzilai_borwein_decay.hpp"
@@ -106,6 +107,10 @@ class SVRGType
    * @param decayPolicy Instantiated decay policy used to adjust the step size.
    * @param resetPolicy Flag that determines whether update policy parameters
    *     are reset before every Optimize call.
+   * @param parallelFullPass If true, split the full gradient and objective
+   *     passes over all functions across OpenMP threads; the separable
+   *     Evaluate() and Gradient() of the function must then be safe to call
+   *     concurrently on disjoint batches.
    */
   SVRGType(const double stepSize = 0.01,
            const size_t batchSize = 32,
@@ -115,7 +120,8 @@ class SVRGType
            const bool shuffle = true,
            const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
            const DecayPolicyType& decayPolicy = DecayPolicyType(),
-           const bool resetPolicy = true);
+           const bool resetPolicy = true,
+           const bool parallelFullPass = false);
 
   /**
    * Optimize the given function using SVRG. The given starting point will be
@@ -123,12 +129,29 @@ class SVRGType
    * objective value is returned.
    *
    * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to optimize.
    * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
    * @return Objective value of the final point.
    */
-  template<typename DecomposableFunctionType>
-  double Optimize(DecomposableFunctionType& function, arma::mat& iterate);
+  template<typename DecomposableFunctionType, typename... CallbackTypes>
+  double Optimize(DecomposableFunctionType& function,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
+
+  /**
+   * Estimate the number of bytes Optimize() allocates for an iterate of the
+   * given size: the gradients of the batch at the current and at the snapshot
+   * iterate, the snapshot iterate and the full gradient, the last full
+   * gradient kept by BarzilaiBorweinDecay, and, for lazy updates, the last step
+   * of each coordinate (the sparse gradients are not included).  The memory of
+   * the iterate and of the function is not included.
+   *
+   * @param rows Number of rows of the iterate.
+   * @param cols Number of columns of the iterate.
+   */
+  size_t EstimateMemory(const size_t rows, const size_t cols = 1) const;
 
   //! Get the step size.
   double StepSize() const { return stepSize; }
@@ -177,7 +200,86 @@ class SVRGType
   //! Modify the step size decay policy.
   DecayPolicyType& DecayPolicy() { return decayPolicy; }
 
+  //! Get whether the full passes are computed in parallel.
+  bool ParallelFullPass() const { return parallelFullPass; }
+  //! Modify whether the full passes are computed in parallel.
+  bool& ParallelFullPass() { return parallelFullPass; }
+
+  //! Get the workspace the temporaries are taken from (NULL if none).
+  ens::Workspace* Workspace() const { return workspace; }
+  //! Modify the workspace the temporaries are taken from (NULL if none).
+  ens::Workspace*& Workspace() { return workspace; }
+
+  //! Get how the objective of each outer iteration and the final objective
+  //! are computed.
+  const ens::ObjectiveEstimate& ObjectiveEstimate() const
+  { return objectiveEstimate; }
+  //! Modify how the objective of each outer iteration and the final objective
+  //! are computed.
+  ens::ObjectiveEstimate& ObjectiveEstimate() { return objectiveEstimate; }
+
+  //! Get whether the full gradient is applied lazily, for sparse gradients.
+  bool LazyUpdates() const { return lazyUpdates; }
+  //! Modify whether the full gradient is applied lazily, for sparse
+  //! gradients.
+  bool& LazyUpdates() { return lazyUpdates; }
+
  private:
+  /**
+   * Take one inner step with sparse gradients, applying the full gradient
+   * lazily: the full gradient steps that a coordinate missed are applied only
+   * when the coordinate is next touched by a gradient (or at the end of the
+   * epoch, by LazyCatchUp()), so that the step costs O(nnz) instead of O(d).
+   * The coordinates in the support of the gradient at the snapshot are
+   * brought up to date before the gradient at the iterate is computed.
+   *
+   * @param function Function to optimize.
+   * @param iterate Current iterate (only up to date on the touched
+   *     coordinates).
+   * @param iterate0 Snapshot of the epoch.
+   * @param fullGradient Full gradient at the snapshot.
+   * @param begin First function of the batch.
+   * @param batchSize Number of functions in the batch.
+   * @param step Index of the step in the epoch.
+   * @param gradient Storage for the sparse gradient at the iterate.
+   * @param gradient0 Storage for the sparse gradient at the snapshot.
+   * @param lastStep For each coordinate, the first step whose full gradient
+   *     has not been applied to it.
+   */
+  template<typename DecomposableFunctionType>
+  void LazyStep(DecomposableFunctionType& function,
+                arma::mat& iterate,
+                const arma::mat& iterate0,
+                const arma::mat& fullGradient,
+                const size_t begin,
+                const size_t batchSize,
+                const size_t step,
+                arma::sp_mat& gradient,
+                arma::sp_mat& gradient0,
+                std::vector<size_t>& lastStep,
+                std::true_type /* supported */);
+
+  //! Lazy updates are not supported for this function or update policy.
+  template<typename DecomposableFunctionType>
+  void LazyStep(DecomposableFunctionType& /* function */,
+                arma::mat& /* iterate */,
+                const arma::mat& /* iterate0 */,
+                const arma::mat& /* fullGradient */,
+                const size_t /* begin */,
+                const size_t /* batchSize */,
+                const size_t /* step */,
+                arma::sp_mat& /* gradient */,
+                arma::sp_mat& /* gradient0 */,
+                std::vector<size_t>& /* lastStep */,
+                std::false_type /* supported */) { }
+
+  //! Apply the full gradient steps before the given step that each
+  //! coordinate missed.
+  void LazyCatchUp(arma::mat& iterate,
+                   const arma::mat& fullGradient,
+                   const size_t steps,
+                   std::vector<size_t>& lastStep) const;
+
   //! The step size for each example.
   double stepSize;
 
@@ -206,6 +308,19 @@ class SVRGType
   //! Flag indicating whether update policy
   //! should be reset before running optimization.
   bool resetPolicy;
+
+  //! Whether the full gradient and objective passes are computed in parallel.
+  bool parallelFullPass;
+
+  //! The workspace the temporaries are taken from (NULL if none).
+  ens::Workspace* workspace;
+
+  //! How the objective of each outer iteration and the final objective are
+  //! computed.
+  ens::ObjectiveEstimate objectiveEstimate;
+
+  //! Whether the full gradient is applied lazily, for sparse gradients.
+  bool lazyUpdates;
 };
 
 // Convenience typedefs.
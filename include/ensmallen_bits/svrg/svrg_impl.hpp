@@ -15,6 +15,8 @@
 // In case it hasn't been included yet.
 #include "svrg.hpp"
 
+#include <ensmallen_bits/function.hpp>
+
 namespace ens {
 
 template<typename UpdatePolicyType, typename DecayPolicyType>
@@ -27,7 +29,8 @@ SVRGType<UpdatePolicyType, DecayPolicyType>::SVRGType(
     const bool shuffle,
     const UpdatePolicyType& updatePolicy,
     const DecayPolicyType& decayPolicy,
-    const bool resetPolicy) :
+    const bool resetPolicy,
+    const bool parallelFullPass) :
     stepSize(stepSize),
     batchSize(batchSize),
     maxIterations(maxIterations),
@@ -36,16 +39,41 @@ SVRGType<UpdatePolicyType, DecayPolicyType>::SVRGType(
     shuffle(shuffle),
     updatePolicy(updatePolicy),
     decayPolicy(decayPolicy),
-    resetPolicy(resetPolicy)
+    resetPolicy(resetPolicy),
+    parallelFullPass(parallelFullPass),
+    workspace(NULL),
+    lazyUpdates(false)
 { /* Nothing to do. */ }
 
+template<typename UpdatePolicyType, typename DecayPolicyType>
+size_t SVRGType<UpdatePolicyType, DecayPolicyType>::EstimateMemory(
+    const size_t rows,
+    const size_t cols) const
+{
+  const size_t n = rows * cols;
+  size_t bytes = 4 * n * sizeof(double);
+  if (std::is_same<DecayPolicyType, BarzilaiBorweinDecay>::value)
+    bytes += n * sizeof(double);
+  if (lazyUpdates)
+    bytes += n * sizeof(size_t);
+
+  return bytes;
+}
+
 //! Optimize the function (minimize).
 template<typename UpdatePolicyType, typename DecayPolicyType>
-template<typename DecomposableFunctionType>
+template<typename DecomposableFunctionType, typename... CallbackTypes>
 double SVRGType<UpdatePolicyType, DecayPolicyType>::Optimize(
     DecomposableFunctionType& function,
-    arma::mat& iterate)
+    arma::mat& iterate,
+    CallbackTypes&&... callbacks)
 {
+  // The Function wrapper provides the separable EvaluateWithGradient() used
+  // to compute the objective together with the full gradient.
+  typedef Function<DecomposableFunctionType> FullFunctionType;
+  FullFunctionType& fullFunction(static_cast<FullFunctionType&>(function));
+  ENS_PROFILE_OPTIMIZE("SVRG");
+
   // Find the number of functions to use.
   const size_t numFunctions = function.NumFunctions();
 
@@ -61,26 +89,71 @@ double SVRGType<UpdatePolicyType, DecayPolicyType>::Optimize(
   if (resetPolicy)
     updatePolicy.Initialize(iterate.n_rows, iterate.n_cols);
 
+  // The temporaries are taken from the given workspace, or else from a local
+  // one.
+  ens::Workspace localWorkspace;
+  ens::Workspace& ws = (workspace != NULL) ? *workspace : localWorkspace;
+
   // Now iterate!
-  arma::mat gradient(iterate.n_rows, iterate.n_cols);
-  arma::mat gradient0(iterate.n_rows, iterate.n_cols);
-  arma::mat iterate0;
+  arma::mat& gradient = ws.Get<arma::mat>(0);
+  arma::mat& gradient0 = ws.Get<arma::mat>(1);
+  arma::mat& iterate0 = ws.Get<arma::mat>(2);
+  arma::mat& fullGradient = ws.Get<arma::mat>(3);
+  gradient.set_size(iterate.n_rows, iterate.n_cols);
+  gradient0.set_size(iterate.n_rows, iterate.n_cols);
+  fullGradient.set_size(iterate.n_rows, iterate.n_cols);
 
   // Find the number of batches.
   size_t numBatches = numFunctions / batchSize;
   if (numFunctions % batchSize != 0)
     ++numBatches; // Capture last few.
 
+  // Lazy updates need sparse gradients, and the vanilla update (with which
+  // the missed steps of a coordinate add up to a multiple of its full
+  // gradient).
+  typedef std::integral_constant<bool,
+      traits::CheckSparseGradient<DecomposableFunctionType>::value &&
+      std::is_same<UpdatePolicyType, SVRGUpdate>::value> LazySupported;
+  const bool lazy = lazyUpdates && LazySupported::value;
+  if (lazyUpdates && !LazySupported::value)
+  {
+    Warn << "SVRG: lazy updates need a sparse Gradient() and the vanilla "
+        << "update policy; using dense updates." << std::endl;
+  }
+  arma::sp_mat& sparseGradient = ws.Get<arma::sp_mat>(4);
+  arma::sp_mat& sparseGradient0 = ws.Get<arma::sp_mat>(5);
+  std::vector<size_t>& lastStep = ws.Get<std::vector<size_t>>(6);
+
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+  terminate |= Callback::BeginOptimization(*this, function, iterate,
+      callbacks...);
+
   const size_t actualMaxIterations = (maxIterations == 0) ?
       std::numeric_limits<size_t>::max() : maxIterations;
-  for (size_t i = 0; i < actualMaxIterations; ++i)
+  for (size_t i = 0; i < actualMaxIterations && !terminate; ++i)
   {
-    // Calculate the objective function.
-    overallObjective = 0;
-    for (size_t f = 0; f < numFunctions; f += batchSize)
+    // Calculate the objective function; when reusing the objectives, it is
+    // computed in the same pass as the full gradient.
+    if (objectiveEstimate.IsReuse())
+    {
+      ENS_PROFILE_SCOPE("EvaluateWithGradient");
+      overallObjective = FullPassEvaluateWithGradient(fullFunction,
+          iterate, batchSize, fullGradient, parallelFullPass);
+    }
+    else
     {
-      const size_t effectiveBatchSize = std::min(batchSize, numFunctions - f);
-      overallObjective += function.Evaluate(iterate, f, effectiveBatchSize);
+      ENS_PROFILE_SCOPE("Evaluate");
+      overallObjective = objectiveEstimate.Evaluate(function, iterate,
+          batchSize, parallelFullPass);
+    }
+
+    terminate |= Callback::Evaluate(*this, function, iterate,
+        overallObjective, callbacks...);
+    if (i > 0)
+    {
+      terminate |= Callback::EndEpoch(*this, function, iterate, i - 1,
+          overallObjective, callbacks...);
     }
 
     if (std::isnan(overallObjective) || std::isinf(overallObjective))
@@ -88,6 +161,7 @@ double SVRGType<UpdatePolicyType, DecayPolicyType>::Optimize(
       Warn << "SVRG: converged to " << overallObjective
           << "; terminating  with failure.  Try a smaller step size?"
           << std::endl;
+      Callback::EndOptimization(*this, function, iterate, callbacks...);
       return overallObjective;
     }
 
@@ -95,34 +169,36 @@ double SVRGType<UpdatePolicyType, DecayPolicyType>::Optimize(
     {
       Info << "SVRG: minimized within tolerance " << tolerance
           << "; terminating optimization." << std::endl;
+      Callback::EndOptimization(*this, function, iterate, callbacks...);
       return overallObjective;
     }
 
+    if (terminate)
+    {
+      Info << "SVRG: callback requested termination." << std::endl;
+      break;
+    }
+
     lastObjective = overallObjective;
 
     // Compute the full gradient.
-    size_t effectiveBatchSize = std::min(batchSize, numFunctions);
-    arma::mat fullGradient(iterate.n_rows, iterate.n_cols);
-    function.Gradient(iterate, 0, fullGradient, effectiveBatchSize);
-    for (size_t f = effectiveBatchSize; f < numFunctions;
-        /* incrementing done manually */)
+    if (!objectiveEstimate.IsReuse())
     {
-      // Find the effective batch size (the last batch may be smaller).
-      effectiveBatchSize = std::min(batchSize, numFunctions - f);
-
-      function.Gradient(iterate, f, gradient, effectiveBatchSize);
-      fullGradient += gradient;
-
-      f += effectiveBatchSize;
+      ENS_PROFILE_SCOPE("Gradient");
+      FullPassGradient(function, iterate, batchSize, fullGradient,
+          parallelFullPass);
     }
     fullGradient /= (double) numFunctions;
 
     // Store current parameter for the calculation of the variance reduced
     // gradient.
     iterate0 = iterate;
+    if (lazy)
+      lastStep.assign(iterate.n_elem, 0);
 
-    for (size_t f = 0, currentFunction = 0; f < innerIterations;
-        /* incrementing done manually */)
+    size_t step = 0;
+    for (size_t f = 0, currentFunction = 0; f < innerIterations && !terminate;
+        ++step /* the rest of the incrementing is done manually */)
     {
       // Is this iteration the start of a sequence?
       if ((currentFunction % numFunctions) == 0)
@@ -131,44 +207,143 @@ double SVRGType<UpdatePolicyType, DecayPolicyType>::Optimize(
 
         // Determine order of visitation.
         if (shuffle)
+        {
+          ENS_PROFILE_SCOPE("Shuffle");
           function.Shuffle();
+        }
       }
 
       // Find the effective batch size (the last batch may be smaller).
-      effectiveBatchSize = std::min(batchSize, numFunctions - currentFunction);
+      const size_t effectiveBatchSize = std::min(batchSize,
+          numFunctions - currentFunction);
+
+      if (lazy)
+      {
+        // Only the coordinates touched by the sparse gradients are updated;
+        // the iterate seen by the callbacks is not up to date elsewhere.
+        ENS_PROFILE_SCOPE("Gradient");
+        LazyStep(function, iterate, iterate0, fullGradient, currentFunction,
+            effectiveBatchSize, step, sparseGradient, sparseGradient0,
+            lastStep, LazySupported());
+      }
+      else
+      {
+        // Calculate variance reduced gradient.
+        {
+          ENS_PROFILE_SCOPE("Gradient");
+          DualBatchGradient(function, iterate, iterate0, currentFunction,
+              gradient, gradient0, effectiveBatchSize);
+        }
 
-      // Calculate variance reduced gradient.
-      function.Gradient(iterate, currentFunction, gradient,
-          effectiveBatchSize);
-      function.Gradient(iterate0, currentFunction, gradient0,
-          effectiveBatchSize);
+        // Use the update policy to take a step.
+        {
+          ENS_PROFILE_SCOPE("UpdatePolicy::Update");
+          updatePolicy.Update(iterate, fullGradient, gradient, gradient0,
+              effectiveBatchSize, stepSize);
+        }
+      }
 
-      // Use the update policy to take a step.
-      updatePolicy.Update(iterate, fullGradient, gradient, gradient0,
-          effectiveBatchSize, stepSize);
+      terminate |= Callback::StepTaken(*this, function, iterate, callbacks...);
 
       currentFunction += effectiveBatchSize;
       f += effectiveBatchSize;
     }
 
+    // Apply the full gradient steps that the coordinates missed.
+    if (lazy)
+      LazyCatchUp(iterate, fullGradient, step, lastStep);
+
     // Update the learning rate if requested by the user.
-    decayPolicy.Update(iterate, iterate0, gradient, fullGradient, numBatches,
-        stepSize);
+    {
+      ENS_PROFILE_SCOPE("DecayPolicy::Update");
+      decayPolicy.Update(iterate, iterate0, gradient, fullGradient, numBatches,
+          stepSize);
+    }
   }
 
-  Info << "SVRG: maximum iterations (" << maxIterations << ") reached; "
-      << "terminating optimization." << std::endl;
+  if (!terminate)
+  {
+    Info << "SVRG: maximum iterations (" << maxIterations << ") reached; "
+        << "terminating optimization." << std::endl;
+  }
 
-  // Calculate final objective.
-  overallObjective = 0;
-  for (size_t i = 0; i < numFunctions; i += batchSize)
+  // Calculate final objective (or keep the one of the last outer
+  // iteration).
+  if (!objectiveEstimate.IsReuse())
   {
-    const size_t effectiveBatchSize = std::min(batchSize, numFunctions - i);
-    overallObjective += function.Evaluate(iterate, i, effectiveBatchSize);
+    ENS_PROFILE_SCOPE("Evaluate");
+    overallObjective = objectiveEstimate.Evaluate(function, iterate, batchSize,
+        parallelFullPass);
   }
+
+  Callback::EndOptimization(*this, function, iterate, callbacks...);
   return overallObjective;
 }
 
+template<typename UpdatePolicyType, typename DecayPolicyType>
+template<typename DecomposableFunctionType>
+void SVRGType<UpdatePolicyType, DecayPolicyType>::LazyStep(
+    DecomposableFunctionType& function,
+    arma::mat& iterate,
+    const arma::mat& iterate0,
+    const arma::mat& fullGradient,
+    const size_t begin,
+    const size_t batchSize,
+    const size_t step,
+    arma::sp_mat& gradient,
+    arma::sp_mat& gradient0,
+    std::vector<size_t>& lastStep,
+    std::true_type /* supported */)
+{
+  // The gradient at the snapshot gives the coordinates the batch depends on;
+  // bring them up to date (before this step).
+  function.Gradient(iterate0, begin, gradient0, batchSize);
+  for (arma::sp_mat::const_iterator it = gradient0.begin();
+      it != gradient0.end(); ++it)
+  {
+    const size_t j = it.row() + it.col() * iterate.n_rows;
+    iterate[j] -= stepSize * (step - lastStep[j]) * fullGradient[j];
+    lastStep[j] = step;
+  }
+
+  function.Gradient(iterate, begin, gradient, batchSize);
+
+  // Take this step on the touched coordinates: the full gradient (once), and
+  // the difference of the two gradients.
+  const double scale = stepSize / (double) batchSize;
+  for (arma::sp_mat::const_iterator it = gradient.begin();
+      it != gradient.end(); ++it)
+  {
+    const size_t j = it.row() + it.col() * iterate.n_rows;
+    iterate[j] -= stepSize * (step + 1 - lastStep[j]) * fullGradient[j] +
+        scale * (*it);
+    lastStep[j] = step + 1;
+  }
+
+  for (arma::sp_mat::const_iterator it = gradient0.begin();
+      it != gradient0.end(); ++it)
+  {
+    const size_t j = it.row() + it.col() * iterate.n_rows;
+    iterate[j] -= stepSize * (step + 1 - lastStep[j]) * fullGradient[j] -
+        scale * (*it);
+    lastStep[j] = step + 1;
+  }
+}
+
+template<typename UpdatePolicyType, typename DecayPolicyType>
+void SVRGType<UpdatePolicyType, DecayPolicyType>::LazyCatchUp(
+    arma::mat& iterate,
+    const arma::mat& fullGradient,
+    const size_t steps,
+    std::vector<size_t>& lastStep) const
+{
+  for (size_t j = 0; j < iterate.n_elem; ++j)
+  {
+    iterate[j] -= stepSize * (steps - lastStep[j]) * fullGradient[j];
+    lastStep[j] = steps;
+  }
+}
+
 } // namespace ens
 
 #endif
@@ -43,103 +43,264 @@ class SWATSUpdate
    *        parameter.
    * @param beta1 The smoothing parameter.
    * @param beta2 The second moment coefficient.
+   * @param interleaved If true, the two moments of each coordinate are stored
+   *        next to each other in a single matrix.
    */
   SWATSUpdate(const double epsilon = 1e-8,
               const double beta1 = 0.9,
-              const double beta2 = 0.999) :
+              const double beta2 = 0.999,
+              const bool interleaved = false) :
     epsilon(epsilon),
     beta1(beta1),
     beta2(beta2),
-    iteration(0),
-    phaseSGD(false),
-    sgdRate(0),
-    sgdLambda(0)
+    interleaved(interleaved)
   {
     // Nothing to do.
   }
 
-  /**
-   * The Initialize method is called by SGD Optimizer method before the start of
-   * the iteration update process.
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
-   */
-  void Initialize(const size_t rows, const size_t cols)
-  {
-    m = arma::zeros<arma::mat>(rows, cols);
-    v = arma::zeros<arma::mat>(rows, cols);
+  //! Get the value used to initialise the squared gradient parameter.
+  double Epsilon() const { return epsilon; }
+  //! Modify the value used to initialise the squared gradient parameter.
+  double& Epsilon() { return epsilon; }
+
+  //! Get the smoothing parameter.
+  double Beta1() const { return beta1; }
+  //! Modify the smoothing parameter.
+  double& Beta1() { return beta1; }
+
+  //! Get the second moment coefficient.
+  double Beta2() const { return beta2; }
+  //! Modify the second moment coefficient.
+  double& Beta2() { return beta2; }
 
-    sgdV = arma::zeros<arma::mat>(rows, cols);
+  //! Get whether the moments are stored interleaved.
+  bool Interleaved() const { return interleaved; }
+  //! Modify whether the moments are stored interleaved.
+  bool& Interleaved() { return interleaved; }
+
+  //! Get the number of bytes of the state (the two moments, the SGD
+  //! velocity and the last step, or the interleaved moments) for an iterate
+  //! of the given size.
+  size_t EstimateStateBytes(const size_t rows,
+                            const size_t cols,
+                            const size_t elemSize = sizeof(double)) const
+  {
+    return (interleaved ? 2 : 4) * rows * cols * elemSize;
   }
 
   /**
-   * Update step for SWATS.
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
    */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
+  template<typename MatType, typename GradType>
+  class Policy
   {
-    // Increment the iteration counter variable.
-    ++iteration;
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const SWATSUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        interleaved(parent.interleaved &&
+            IsFusableUpdate<MatType, GradType>::value),
+        iteration(0),
+        phaseSGD(false),
+        sgdRate(0),
+        sgdLambda(0)
+    {
+      if (interleaved)
+      {
+        state.zeros(2, rows * cols);
+      }
+      else
+      {
+        m.zeros(rows, cols);
+        v.zeros(rows, cols);
+        sgdV.zeros(rows, cols);
+        delta.set_size(rows, cols);
+      }
+    }
 
-    if (phaseSGD)
+    /**
+     * Update step for SWATS.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
     {
-      // Note we reuse the exponential moving average parameter here instead of
-      // introducing a new parameter (sgdV) as done in the paper.
-      v *= beta1;
-      v += gradient;
+      // Increment the iteration counter variable.
+      ++iteration;
 
-      iterate -= (1 - beta1) * sgdRate * v;
-      return;
-    }
+      if (interleaved)
+      {
+        InterleavedUpdate(iterate, stepSize, gradient,
+            IsFusableUpdate<MatType, GradType>());
+        return;
+      }
 
-    m *= beta1;
-    m += (1 - beta1) * gradient;
+      if (phaseSGD)
+      {
+        // Note we reuse the exponential moving average parameter here instead
+        // of introducing a new parameter (sgdV) as done in the paper.
+        v *= parent.beta1;
+        v += gradient;
+
+        iterate -= (1 - parent.beta1) * sgdRate * v;
+        return;
+      }
+
+      m *= parent.beta1;
+      m += (1 - parent.beta1) * gradient;
+
+      v *= parent.beta2;
+      v += (1 - parent.beta2) * (gradient % gradient);
 
-    v *= beta2;
-    v += (1 - beta2) * (gradient % gradient);
+      const double biasCorrection1 = 1.0 - std::pow(parent.beta1, iteration);
+      const double biasCorrection2 = 1.0 - std::pow(parent.beta2, iteration);
 
-    const double biasCorrection1 = 1.0 - std::pow(beta1, iteration);
-    const double biasCorrection2 = 1.0 - std::pow(beta2, iteration);
+      // The step is written into a buffer of the policy, so that no matrix is
+      // allocated in the update.
+      delta = stepSize * m / biasCorrection1 /
+          (arma::sqrt(v / biasCorrection2) + parent.epsilon);
+      iterate -= delta;
 
-    arma::mat delta = stepSize * m / biasCorrection1 /
-        (arma::sqrt(v / biasCorrection2) + epsilon);
-    iterate -= delta;
+      const double deltaGradient = arma::dot(delta, gradient);
+      UpdateSGDRate(arma::dot(delta, delta), deltaGradient, biasCorrection2);
+    }
 
-    const double deltaGradient = arma::dot(delta, gradient);
-    if (deltaGradient != 0)
+   private:
+    //! Update the interleaved state and the iterate in a single loop.
+    void InterleavedUpdate(MatType& iterate,
+                           const double stepSize,
+                           const GradType& gradient,
+                           std::true_type /* fusable */)
     {
-      const double rate = arma::dot(delta, delta) / deltaGradient;
-      sgdLambda = beta2 * sgdLambda + (1 - beta2) * rate;
-      sgdRate = sgdLambda / biasCorrection2;
+      typedef typename MatType::elem_type ElemType;
+
+      ElemType* x = iterate.memptr();
+      ElemType* s = state.memptr();
+      const ElemType* g = gradient.memptr();
+      const size_t n = iterate.n_elem;
+
+      // Column i of the state holds the two moments of coordinate i; in the
+      // SGD phase, the second one is reused as the velocity.
+      if (phaseSGD)
+      {
+        const ElemType beta1 = parent.beta1;
+        const ElemType step = (1 - parent.beta1) * sgdRate;
+
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = 0; i < n; ++i)
+        {
+          s[2 * i + 1] = beta1 * s[2 * i + 1] + g[i];
+          x[i] -= step * s[2 * i + 1];
+        }
+        return;
+      }
+
+      const double biasCorrection1 = 1.0 - std::pow(parent.beta1, iteration);
+      const double biasCorrection2 = 1.0 - std::pow(parent.beta2, iteration);
+
+      const ElemType beta1 = parent.beta1;
+      const ElemType beta2 = parent.beta2;
+      const ElemType epsilon = parent.epsilon;
+      const ElemType step = stepSize / biasCorrection1;
+      const ElemType correction2 = biasCorrection2;
 
-      if (std::abs(sgdRate - rate) < epsilon && iteration > 1)
+      double deltaDelta = 0;
+      double deltaGradient = 0;
+      for (size_t i = 0; i < n; ++i)
       {
-        phaseSGD = true;
-        v.zeros();
+        s[2 * i] = beta1 * s[2 * i] + (1 - beta1) * g[i];
+        s[2 * i + 1] = beta2 * s[2 * i + 1] + (1 - beta2) * (g[i] * g[i]);
+
+        const ElemType delta = step * s[2 * i] /
+            (std::sqrt(s[2 * i + 1] / correction2) + epsilon);
+        x[i] -= delta;
+
+        deltaDelta += delta * delta;
+        deltaGradient += delta * g[i];
       }
+
+      UpdateSGDRate(deltaDelta, deltaGradient, biasCorrection2);
     }
-  }
 
-  //! Get the value used to initialise the squared gradient parameter.
-  double Epsilon() const { return epsilon; }
-  //! Modify the value used to initialise the squared gradient parameter.
-  double& Epsilon() { return epsilon; }
+    //! Other types never use the interleaved state.
+    void InterleavedUpdate(MatType& /* iterate */,
+                           const double /* stepSize */,
+                           const GradType& /* gradient */,
+                           std::false_type /* fusable */)
+    { }
 
-  //! Get the smoothing parameter.
-  double Beta1() const { return beta1; }
-  //! Modify the smoothing parameter.
-  double& Beta1() { return beta1; }
+    /**
+     * Update the estimate of the SGD learning rate from the last Adam step, and
+     * switch to SGD if the estimate has converged.
+     */
+    void UpdateSGDRate(const double deltaDelta,
+                       const double deltaGradient,
+                       const double biasCorrection2)
+    {
+      if (deltaGradient != 0)
+      {
+        const double rate = deltaDelta / deltaGradient;
+        sgdLambda = parent.beta2 * sgdLambda + (1 - parent.beta2) * rate;
+        sgdRate = sgdLambda / biasCorrection2;
 
-  //! Get the second moment coefficient.
-  double Beta2() const { return beta2; }
-  //! Modify the second moment coefficient.
-  double& Beta2() { return beta2; }
+        if (std::abs(sgdRate - rate) < parent.epsilon && iteration > 1)
+        {
+          phaseSGD = true;
+          if (interleaved)
+            state.row(1).zeros();
+          else
+            v.zeros();
+        }
+      }
+    }
+
+    //! Instantiated parent object.
+    const SWATSUpdate& parent;
+
+    //! Whether the moments are stored interleaved in the state matrix.
+    bool interleaved;
+
+    //! The exponential moving average of gradient values.
+    MatType m;
+
+    //! The exponential moving average of squared gradient values (Adam).
+    MatType v;
+
+    //! The number of iterations.
+    double iteration;
+
+    //! Wether to use the SGD or Adam update rule.
+    bool phaseSGD;
+
+    //! The exponential moving average of squared gradient values (SGD).
+    MatType sgdV;
+
+    //! The interleaved moments (one column per coordinate), if used.
+    MatType state;
+
+    //! The last Adam step (when the moments are not interleaved).
+    MatType delta;
+
+    //! SGD scaling parameter.
+    double sgdRate;
+
+    //! SGD learning rate.
+    double sgdLambda;
+  };
 
  private:
   //! The epsilon value used to initialise the squared gradient parameter.
@@ -151,26 +312,8 @@ class SWATSUpdate
   //! The second moment coefficient.
   double beta2;
 
-  //! The exponential moving average of gradient values.
-  arma::mat m;
-
-  //! The exponential moving average of squared gradient values (Adam).
-  arma::mat v;
-
-  //! The number of iterations.
-  double iteration;
-
-  //! Wether to use the SGD or Adam update rule.
-  bool phaseSGD;
-
-  //! The exponential moving average of squared gradient values (SGD).
-  arma::mat sgdV;
-
-  //! SGD scaling parameter.
-  double sgdRate;
-
-  //! SGD learning rate.
-  double sgdLambda;
+  //! Whether the moments are stored interleaved.
+  bool interleaved;
 };
 
 } // namespace ens
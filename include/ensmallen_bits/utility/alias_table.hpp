@@ -0,0 +1,151 @@
+/**
+ * @file alias_table.hpp
+ *
+ * An alias table, which draws indices from a discrete distribution in
+ * constant time.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_ALIAS_TABLE_HPP
+#define ENSMALLEN_UTILITY_ALIAS_TABLE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "rng.hpp"
+
+namespace ens {
+
+/**
+ * AliasTable draws the index i of a discrete distribution with probability
+ * proportional to weights[i], in O(1) time per draw after an O(n) setup, with
+ * the method of Vose ("A Linear Algorithm for Generating Random Numbers with a
+ * Given Distribution", 1991).  Each of the n cells of the table holds a
+ * threshold and an alias: a draw picks a cell uniformly, and returns the cell
+ * itself if a uniform number is below its threshold, or its alias otherwise.
+ *
+ * @code
+ * AliasTable table(arma::vec({ 1.0, 2.0, 1.0 }));
+ * RNG rng(42);
+ * const size_t i = table.Sample(rng); // 1 with probability 0.5.
+ * @endcode
+ */
+class AliasTable
+{
+ public:
+  //! Create an empty table; Reset() must be called before Sample().
+  AliasTable() { }
+
+  /**
+   * Create the table of the given weights.
+   *
+   * @param weights Non-negative weights, not all zero.
+   */
+  template<typename VecType>
+  AliasTable(const VecType& weights) { Reset(weights); }
+
+  /**
+   * Rebuild the table for the given weights.  A std::invalid_argument is
+   * thrown if a weight is negative or not finite, or if they are all zero.
+   *
+   * @param weights Non-negative weights, not all zero.
+   */
+  template<typename VecType>
+  void Reset(const VecType& weights)
+  {
+    const size_t n = weights.n_elem;
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      const double weight = weights[i];
+      if (!(weight >= 0.0) || !std::isfinite(weight))
+      {
+        throw std::invalid_argument("AliasTable::Reset(): weights must be "
+            "non-negative and finite!");
+      }
+      sum += weight;
+    }
+
+    if (!(sum > 0.0))
+    {
+      throw std::invalid_argument("AliasTable::Reset(): the weights must not "
+          "all be zero!");
+    }
+
+    probabilities.resize(n);
+    thresholds.resize(n);
+    aliases.resize(n);
+
+    // Split the cells into the ones with less than the mean weight, which get
+    // an alias, and the ones with more, which give some to the others.
+    std::vector<double> scaled(n);
+    std::vector<size_t> small, large;
+    for (size_t i = 0; i < n; ++i)
+    {
+      probabilities[i] = weights[i] / sum;
+      scaled[i] = probabilities[i] * n;
+      aliases[i] = i;
+      if (scaled[i] < 1.0)
+        small.push_back(i);
+      else
+        large.push_back(i);
+    }
+
+    while (!small.empty() && !large.empty())
+    {
+      const size_t s = small.back();
+      small.pop_back();
+      const size_t l = large.back();
+
+      thresholds[s] = scaled[s];
+      aliases[s] = l;
+      scaled[l] -= (1.0 - scaled[s]);
+      if (scaled[l] < 1.0)
+      {
+        large.pop_back();
+        small.push_back(l);
+      }
+    }
+
+    // What is left is full up to the rounding errors.
+    for (size_t i = 0; i < large.size(); ++i)
+      thresholds[large[i]] = 1.0;
+    for (size_t i = 0; i < small.size(); ++i)
+      thresholds[small[i]] = 1.0;
+  }
+
+  /**
+   * Draw an index with probability proportional to its weight.
+   *
+   * @param rng Random number generator to draw with.
+   */
+  size_t Sample(RNG& rng) const
+  {
+    const double u = rng.Randu() * thresholds.size();
+    const size_t cell = std::min((size_t) u, thresholds.size() - 1);
+    return ((u - cell) < thresholds[cell]) ? cell : aliases[cell];
+  }
+
+  //! Get the probability of drawing the given index.
+  double Probability(const size_t i) const { return probabilities[i]; }
+
+  //! Get the number of indices of the distribution.
+  size_t Size() const { return thresholds.size(); }
+
+ private:
+  //! The probability of each index.
+  std::vector<double> probabilities;
+  //! The probability of keeping each cell rather than taking its alias.
+  std::vector<double> thresholds;
+  //! The alias of each cell.
+  std::vector<size_t> aliases;
+};
+
+} // namespace ens
+
+#endif
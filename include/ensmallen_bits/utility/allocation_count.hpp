@@ -0,0 +1,113 @@
+/**
+ * @file allocation_count.hpp
+ *
+ * A global count of the heap allocations of Armadillo matrices and of their
+ * bytes, used to check that the steps of the optimizers do not allocate and to
+ * measure how much memory they use.  It is enabled by defining
+ * ENS_COUNT_ALLOCATIONS, and has to be set up before Armadillo is included.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_ALLOCATION_COUNT_HPP
+#define ENSMALLEN_UTILITY_ALLOCATION_COUNT_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+
+namespace ens {
+
+/**
+ * Get the number of allocations counted so far.  When ENS_COUNT_ALLOCATIONS is
+ * defined, every memory allocation of Armadillo is counted (through the
+ * ARMA_ALIEN_MEM_ALLOC_FUNCTION hook of Armadillo); a program may also count
+ * its other allocations with CountAllocation(), for instance from a
+ * replacement of the global operator new.  Otherwise, the count stays 0.
+ */
+inline std::atomic<size_t>& AllocationCount()
+{
+  static std::atomic<size_t> count(0);
+  return count;
+}
+
+/**
+ * Get the number of bytes of the Armadillo allocations that are currently
+ * live, when ENS_COUNT_ALLOCATIONS is defined (otherwise, it stays 0).
+ */
+inline std::atomic<size_t>& AllocatedBytes()
+{
+  static std::atomic<size_t> bytes(0);
+  return bytes;
+}
+
+/**
+ * Get the largest number of live bytes of Armadillo allocations since the
+ * program started or since the last call to ResetPeakAllocatedBytes(), when
+ * ENS_COUNT_ALLOCATIONS is defined (otherwise, it stays 0).
+ */
+inline std::atomic<size_t>& PeakAllocatedBytes()
+{
+  static std::atomic<size_t> bytes(0);
+  return bytes;
+}
+
+//! Start tracking the peak of the live bytes again from the current value.
+inline void ResetPeakAllocatedBytes()
+{
+  PeakAllocatedBytes().store(AllocatedBytes().load());
+}
+
+//! Count one allocation.
+inline void CountAllocation() { ++AllocationCount(); }
+
+//! The space kept in front of each counted allocation for its size, which
+//! keeps the alignment of malloc().
+static const size_t countedHeaderSize = alignof(std::max_align_t);
+
+//! Allocate memory for Armadillo, and count the allocation and its bytes.
+inline void* CountedMalloc(const size_t bytes)
+{
+  CountAllocation();
+  char* memory = (char*) std::malloc(bytes + countedHeaderSize);
+  if (memory == NULL)
+    return NULL;
+
+  *((size_t*) memory) = bytes;
+  const size_t live = (AllocatedBytes() += bytes);
+  size_t peak = PeakAllocatedBytes().load();
+  while (live > peak &&
+      !PeakAllocatedBytes().compare_exchange_weak(peak, live)) { }
+
+  return memory + countedHeaderSize;
+}
+
+//! Free memory allocated by CountedMalloc().
+inline void CountedFree(void* memory)
+{
+  if (memory == NULL)
+    return;
+
+  char* block = ((char*) memory) - countedHeaderSize;
+  AllocatedBytes() -= *((size_t*) block);
+  std::free(block);
+}
+
+} // namespace ens
+
+#if defined(ENS_COUNT_ALLOCATIONS)
+  #if defined(ARMA_INCLUDES)
+    #error "ENS_COUNT_ALLOCATIONS: include ensmallen.hpp before armadillo"
+  #endif
+
+  #if defined(ARMA_ALIEN_MEM_ALLOC_FUNCTION)
+    #error "ENS_COUNT_ALLOCATIONS: ARMA_ALIEN_MEM_ALLOC_FUNCTION is already set"
+  #endif
+
+  #define ARMA_ALIEN_MEM_ALLOC_FUNCTION ens::CountedMalloc
+  #define ARMA_ALIEN_MEM_FREE_FUNCTION  ens::CountedFree
+#endif
+
+#endif
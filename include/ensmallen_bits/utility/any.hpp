@@ -0,0 +1,107 @@
+/**
+ * @file any.hpp
+ *
+ * A simple type-erased holder, used by the optimizers to store policy objects
+ * whose type depends on the matrix type given to Optimize().
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_ANY_HPP
+#define ENSMALLEN_UTILITY_ANY_HPP
+
+#include <cstddef>
+#include <typeinfo>
+
+namespace ens {
+
+/**
+ * Any holds a single heap-allocated object of arbitrary type.  It is a much
+ * simpler version of std::any (which is only available with C++17); the held
+ * type must be given explicitly to As() and Has().
+ *
+ * Copies of an Any object are empty: the held object is not copied.  This is
+ * used by the optimizers to hold instantiated update policies (which may hold
+ * references to their parent object), so the owner is expected to check Has()
+ * and reinitialize the object when needed.
+ */
+class Any
+{
+ public:
+  //! Create an empty Any object.
+  Any() : content(NULL), type(NULL), deleter(NULL) { }
+
+  //! Copying an Any object gives an empty object.
+  Any(const Any& /* other */) : content(NULL), type(NULL), deleter(NULL) { }
+
+  //! Copying an Any object gives an empty object.
+  Any& operator=(const Any& other)
+  {
+    if (this != &other)
+      Clean();
+
+    return *this;
+  }
+
+  //! Destroy the held object, if any.
+  ~Any() { Clean(); }
+
+  /**
+   * Take ownership of the given object; any previously held object is
+   * destroyed.
+   *
+   * @param t Object to hold; it must have been allocated with new.
+   */
+  template<typename T>
+  void Set(T* t)
+  {
+    Clean();
+    content = t;
+    type = &typeid(T);
+    deleter = &Any::Delete<T>;
+  }
+
+  //! Return true if an object of type T is held.
+  template<typename T>
+  bool Has() const
+  {
+    return (content != NULL) && (*type == typeid(T));
+  }
+
+  //! Get the held object.  The held object must have type T.
+  template<typename T>
+  T& As() { return *static_cast<T*>(content); }
+
+  //! Get the held object.  The held object must have type T.
+  template<typename T>
+  const T& As() const { return *static_cast<const T*>(content); }
+
+  //! Destroy the held object, if any.
+  void Clean()
+  {
+    if (content != NULL)
+      deleter(content);
+
+    content = NULL;
+    type = NULL;
+    deleter = NULL;
+  }
+
+ private:
+  //! Delete an object of the given type.
+  template<typename T>
+  static void Delete(void* t) { delete static_cast<T*>(t); }
+
+  //! The held object.
+  void* content;
+  //! The type of the held object.
+  const std::type_info* type;
+  //! Function used to delete the held object.
+  void (*deleter)(void*);
+};
+
+} // namespace ens
+
+#endif
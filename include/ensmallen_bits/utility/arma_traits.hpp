@@ -0,0 +1,140 @@
+/**
+ * @file arma_traits.hpp
+ *
+ * Traits for Armadillo matrix types, used to map the matrix type given to an
+ * optimizer onto the type its objective function should see.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_ARMA_TRAITS_HPP
+#define ENSMALLEN_UTILITY_ARMA_TRAITS_HPP
+
+#include <type_traits>
+
+namespace ens {
+
+/**
+ * MatTypeTraits gives the base matrix type of a given Armadillo (or Bandicoot)
+ * type.  Vector types (arma::Col<>, arma::Row<>) and fixed-size types
+ * (arma::mat::fixed<>, arma::vec::fixed<>, ...) are treated as matrices, so
+ * that a FunctionType written for arma::mat can still be optimized with such a
+ * starting point.  An optimizer then works on the memory of the given object
+ * directly, so a fixed-size starting point stays on the stack.
+ */
+template<typename MatType, typename = void>
+struct MatTypeTraits
+{
+  //! The matrix type that should be used for the objective function.
+  typedef MatType BaseMatType;
+};
+
+/**
+ * Every type derived from a dense Armadillo matrix (columns, rows, and the
+ * fixed-size types) is treated as the dense matrix.
+ */
+template<typename MatType>
+struct MatTypeTraits<MatType, typename std::enable_if<
+    std::is_base_of<arma::Mat<typename MatType::elem_type>, MatType>::value &&
+    !std::is_same<arma::Mat<typename MatType::elem_type>,
+        MatType>::value>::type>
+{
+  typedef arma::Mat<typename MatType::elem_type> BaseMatType;
+};
+
+//! Sparse columns are treated as sparse matrices.
+template<typename eT>
+struct MatTypeTraits<arma::SpCol<eT>>
+{
+  typedef arma::SpMat<eT> BaseMatType;
+};
+
+//! Sparse rows are treated as sparse matrices.
+template<typename eT>
+struct MatTypeTraits<arma::SpRow<eT>>
+{
+  typedef arma::SpMat<eT> BaseMatType;
+};
+
+#ifdef ENS_HAVE_COOT
+
+//! Bandicoot columns are treated as dense Bandicoot matrices.
+template<typename eT>
+struct MatTypeTraits<coot::Col<eT>>
+{
+  typedef coot::Mat<eT> BaseMatType;
+};
+
+//! Bandicoot rows are treated as dense Bandicoot matrices.
+template<typename eT>
+struct MatTypeTraits<coot::Row<eT>>
+{
+  typedef coot::Mat<eT> BaseMatType;
+};
+
+#endif
+
+/**
+ * IsCootType<MatType>::value is true when MatType is a Bandicoot (GPU) matrix,
+ * whose memory lives on the device and cannot be accessed element by element
+ * from the host.
+ */
+template<typename MatType>
+struct IsCootType : std::false_type { };
+
+#ifdef ENS_HAVE_COOT
+
+//! Bandicoot matrices live on the device.
+template<typename eT>
+struct IsCootType<coot::Mat<eT>> : std::true_type { };
+
+//! Bandicoot columns live on the device.
+template<typename eT>
+struct IsCootType<coot::Col<eT>> : std::true_type { };
+
+//! Bandicoot rows live on the device.
+template<typename eT>
+struct IsCootType<coot::Row<eT>> : std::true_type { };
+
+#endif
+
+/**
+ * CubeTypeTraits<MatType>::CubeType is the cube type that holds slices of the
+ * given matrix type (for instance, the history of L_BFGS), so that the slices
+ * live in the same memory as the matrices.
+ */
+template<typename MatType>
+struct CubeTypeTraits
+{
+  typedef arma::Cube<typename MatType::elem_type> CubeType;
+};
+
+#ifdef ENS_HAVE_COOT
+
+//! Slices of Bandicoot matrices are held in Bandicoot cubes.
+template<typename eT>
+struct CubeTypeTraits<coot::Mat<eT>>
+{
+  typedef coot::Cube<eT> CubeType;
+};
+
+#endif
+
+/**
+ * IsFusableUpdate<MatType, GradType>::value is true when the iterate and the
+ * gradient are dense matrices of the same type.  An update policy can then
+ * update its state and the iterate in a single loop over their contiguous
+ * memory, instead of making one pass over memory per Armadillo expression.
+ */
+template<typename MatType, typename GradType>
+struct IsFusableUpdate : std::false_type { };
+
+//! Dense matrices of the same type can be updated in a single loop.
+template<typename eT>
+struct IsFusableUpdate<arma::Mat<eT>, arma::Mat<eT>> : std::true_type { };
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,143 @@
+/**
+ * @file deterministic_reduction.hpp
+ *
+ * The deterministic reduction mode, in which the parallel sums of objectives
+ * and gradients do not depend on the number of threads, and the fixed-shape
+ * tree reduction they use.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_DETERMINISTIC_REDUCTION_HPP
+#define ENSMALLEN_UTILITY_DETERMINISTIC_REDUCTION_HPP
+
+#include "executor.hpp"
+
+// The number of chunks of the deterministic reductions when they are enabled
+// at compile time.
+#ifndef ENS_DETERMINISTIC_REDUCTION_CHUNKS
+  #define ENS_DETERMINISTIC_REDUCTION_CHUNKS 64
+#endif
+
+namespace ens {
+
+/**
+ * By default, the parallel reductions of ensmallen (the batches split across
+ * threads by ParallelBatchFunction, the parallel full passes of
+ * FullPassEvaluate() and friends, the chunks of ParallelDot() and the other
+ * parallel kernels, ...) split their work into one chunk per thread, so
+ * floating-point rounding makes their results depend on the number of threads
+ * (and, for OpenMP reductions, on the order in which the threads finish).
+ *
+ * In the deterministic mode, the work is split into a fixed number of chunks
+ * instead (or fewer, for small inputs), which does not depend on the number of
+ * threads; the chunks may be computed by any thread, in any order, and their
+ * results are added with TreeReduce(), whose shape only depends on the number
+ * of chunks.  So the results are bitwise identical for any number of threads,
+ * with or without OpenMP, and with any executor; reproducible runs can still
+ * use all the cores, as long as there are at least as many chunks as threads.
+ * The asynchronous updates of ParallelSGD, AsyncSGD and the other lock-free
+ * optimizers are not reductions, and still depend on the scheduling.
+ *
+ * The mode may be set with SetDeterministicReductions() before an
+ * optimization starts, or enabled at compile time by defining
+ * ENS_DETERMINISTIC_REDUCTIONS before including ensmallen (with
+ * ENS_DETERMINISTIC_REDUCTION_CHUNKS chunks, 64 by default).
+ *
+ * @code
+ * // Make the parallel gradients of the batches reproducible.
+ * ens::SetDeterministicReductions(true);
+ * ens::ParallelBatchFunction<LogisticRegression<>> parallelLr(lr);
+ * adam.Optimize(parallelLr, coordinates);
+ * @endcode
+ *
+ * @return The number of chunks of the reductions (0 if the deterministic mode
+ *     is disabled).
+ */
+inline size_t& DeterministicReductionChunks()
+{
+  #ifdef ENS_DETERMINISTIC_REDUCTIONS
+    static size_t chunks = ENS_DETERMINISTIC_REDUCTION_CHUNKS;
+  #else
+    static size_t chunks = 0;
+  #endif
+  return chunks;
+}
+
+//! Get whether the deterministic reduction mode is enabled.
+inline bool DeterministicReductions()
+{
+  return DeterministicReductionChunks() > 0;
+}
+
+/**
+ * Enable or disable the deterministic reduction mode (see
+ * DeterministicReductionChunks()).
+ *
+ * @param enabled Whether the reductions should be deterministic.
+ * @param chunks Number of chunks of the reductions; it should be at least the
+ *     number of threads, so that all of them are used.
+ */
+inline void SetDeterministicReductions(
+    const bool enabled,
+    const size_t chunks = ENS_DETERMINISTIC_REDUCTION_CHUNKS)
+{
+  if (enabled && chunks == 0)
+  {
+    throw std::invalid_argument("SetDeterministicReductions(): the number of "
+        "chunks must be positive!");
+  }
+
+  DeterministicReductionChunks() = enabled ? chunks : 0;
+}
+
+/**
+ * Get the number of chunks that a deterministic reduction over the given
+ * number of items should use: the number of chunks of the mode, but no more
+ * than one for every minChunkSize items, and at least one.
+ *
+ * @param items Number of items (functions, batches, elements) to reduce.
+ * @param minChunkSize Minimum number of items in a chunk.
+ */
+inline size_t DeterministicChunkCount(const size_t items,
+                                      const size_t minChunkSize = 1)
+{
+  const size_t usefulChunks = items / std::max(minChunkSize, (size_t) 1);
+  return std::max(std::min(DeterministicReductionChunks(), usefulChunks),
+      (size_t) 1);
+}
+
+/**
+ * Add up the n values value(0), ..., value(n - 1) into value(0), with a
+ * pairwise tree of fixed shape: in each round, value(i) is added to
+ * value(i - stride) for every odd multiple i of the stride, and the stride
+ * doubles.  The order of the additions only depends on n, and the additions of
+ * a round are independent, so they are run with the default executor if
+ * parallel is true.
+ *
+ * @param n Number of values.
+ * @param value Function that returns a reference to the value of the given
+ *     index.
+ * @param parallel Whether the additions of a round may run concurrently.
+ */
+template<typename ValueFunctionType>
+inline void TreeReduce(const size_t n,
+                       ValueFunctionType&& value,
+                       const bool parallel = false)
+{
+  for (size_t stride = 1; stride < n; stride *= 2)
+  {
+    const size_t pairs = (n - stride + 2 * stride - 1) / (2 * stride);
+    ParallelFor(pairs, [&](const size_t p)
+    {
+      const size_t i = 2 * stride * p;
+      value(i) += value(i + stride);
+    }, parallel);
+  }
+}
+
+} // namespace ens
+
+#endif
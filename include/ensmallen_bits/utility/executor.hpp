@@ -0,0 +1,320 @@
+/**
+ * @file executor.hpp
+ *
+ * The executor that runs the parallel loops of the optimizers: OpenMP by
+ * default, a pool of std::threads, or a thread pool provided by the program.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_EXECUTOR_HPP
+#define ENSMALLEN_UTILITY_EXECUTOR_HPP
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "thread_budget.hpp"
+
+namespace ens {
+
+/**
+ * An Executor runs the n independent tasks of a parallel loop, with some
+ * number of threads.  The optimizers do not use OpenMP directly for their
+ * parallel loops (the evaluation of a population, the chunks of a large dot
+ * product, ...), but the executor returned by DefaultExecutor(), so that a
+ * program with its own thread pool can make ensmallen share it instead of
+ * starting more threads:
+ *
+ * @code
+ * // Run the parallel loops of ensmallen in a TBB pool.
+ * ens::SetDefaultExecutor(ens::Executor(tbb::info::default_concurrency(),
+ *     [](const size_t n, const ens::Executor::TaskType& task)
+ *     {
+ *       tbb::parallel_for(size_t(0), n, task);
+ *     }));
+ * @endcode
+ *
+ * The default executor uses OpenMP when ensmallen is compiled with it, and
+ * runs the tasks in the calling thread otherwise.  A loop started from inside
+ * the task of another loop (for instance by a function evaluated in parallel
+ * that uses a parallel optimizer itself) runs serially, in the thread of that
+ * task, so that nested loops do not oversubscribe the cores.
+ *
+ * The number of threads of each loop is also limited by the outer threads of
+ * DefaultThreadBudget(), which tells the threads of BLAS how many cores each
+ * task may use (see ThreadBudget).
+ *
+ * The optimizers that run a team of threads for the whole optimization
+ * (ParallelSGD, AsyncSGD, LocalSGD, EASGD and ParallelBatchFunction)
+ * synchronize the threads with each other, which a pool of tasks can not do;
+ * they still use OpenMP.
+ */
+class Executor
+{
+ public:
+  //! The type of a task: it is given the index of the task.
+  typedef std::function<void(size_t)> TaskType;
+
+  //! The type of the function that runs the tasks 0, ..., n - 1 of a loop and
+  //! returns once they are all done.
+  typedef std::function<void(size_t, const TaskType&)> ParallelForType;
+
+  //! Create the OpenMP executor (which is serial without OpenMP).
+  Executor() : numThreads(0) { /* Nothing to do. */ }
+
+  /**
+   * Create an executor with the given function to run the tasks of a loop.
+   *
+   * @param numThreads Number of threads the function uses (the optimizers use
+   *     it to split work into chunks).
+   * @param parallelFor Function that runs tasks 0, ..., n - 1 of the given
+   *     task function, possibly concurrently, and returns when they are done.
+   */
+  Executor(const size_t numThreads, ParallelForType parallelFor) :
+      numThreads(std::max(numThreads, (size_t) 1)),
+      parallelFor(std::move(parallelFor))
+  { /* Nothing to do. */ }
+
+  //! Create an executor that runs every task in the calling thread.
+  static Executor Serial()
+  {
+    return Executor(1, [](const size_t n, const TaskType& task)
+    {
+      for (size_t i = 0; i < n; ++i)
+        task(i);
+    });
+  }
+
+  /**
+   * Create an executor that runs the tasks of each loop on the given number of
+   * threads (the calling thread and numThreads - 1 new std::threads), handing
+   * the tasks out one at a time.  An exception thrown by a task is rethrown in
+   * the calling thread once all the threads are done.
+   *
+   * @param numThreads Number of threads (0 means the number of hardware
+   *     threads).
+   */
+  static Executor Threads(size_t numThreads = 0)
+  {
+    if (numThreads == 0)
+      numThreads = std::max((size_t) std::thread::hardware_concurrency(),
+          (size_t) 1);
+
+    return Executor(numThreads, [numThreads](const size_t n,
+        const TaskType& task)
+    {
+      std::atomic<size_t> next(0);
+      std::exception_ptr error;
+      std::atomic<bool> failed(false);
+      auto work = [&]()
+      {
+        for (size_t i = next++; i < n && !failed; i = next++)
+        {
+          try
+          {
+            task(i);
+          }
+          catch (...)
+          {
+            if (!failed.exchange(true))
+              error = std::current_exception();
+          }
+        }
+      };
+
+      std::vector<std::thread> threads;
+      const size_t extraThreads = std::min(
+          DefaultThreadBudget().LimitOuterThreads(numThreads), n) - 1;
+      threads.reserve(extraThreads);
+      for (size_t t = 0; t < extraThreads; ++t)
+        threads.emplace_back(work);
+      work();
+      for (std::thread& thread : threads)
+        thread.join();
+
+      if (failed)
+        std::rethrow_exception(error);
+    });
+  }
+
+  //! Get the number of threads that the tasks of a loop are run on (1 inside a
+  //! task), within the outer threads of the default thread budget.
+  size_t NumThreads() const
+  {
+    if (InTask())
+      return 1;
+    else if (parallelFor)
+      return DefaultThreadBudget().LimitOuterThreads(numThreads);
+
+    #ifdef ENS_USE_OPENMP
+      return omp_in_parallel() ? 1 : DefaultThreadBudget().LimitOuterThreads(
+          (size_t) omp_get_max_threads());
+    #else
+      return 1;
+    #endif
+  }
+
+  /**
+   * Run task(0), ..., task(n - 1), possibly concurrently, and return when they
+   * are all done.  The tasks must be independent.
+   *
+   * @param n Number of tasks.
+   * @param task Function to call with the index of each task.
+   */
+  template<typename TaskFunctionType>
+  void ParallelFor(const size_t n, TaskFunctionType&& task) const
+  {
+    if (n == 0)
+      return;
+
+    const size_t threads = std::min(n, NumThreads());
+    if (threads == 1)
+    {
+      for (size_t i = 0; i < n; ++i)
+        task(i);
+      return;
+    }
+
+    auto markedTask = [&task](const size_t i)
+    {
+      TaskMarker marker;
+      task(i);
+    };
+
+    // The tasks share the thread budget while the loop runs.
+    BudgetScope budget(threads);
+
+    if (parallelFor)
+    {
+      parallelFor(n, TaskType(std::ref(markedTask)));
+      return;
+    }
+
+    #ifdef ENS_USE_OPENMP
+      // With a limit on the outer threads, the parallel regions inside each
+      // task get the inner threads of the budget.
+      const size_t inner = (DefaultThreadBudget().OuterThreads() == 0) ? 1 :
+          DefaultThreadBudget().InnerThreads(threads);
+      const int levels = omp_get_max_active_levels();
+      if (inner > 1 && levels < 2)
+        omp_set_max_active_levels(2);
+
+      #pragma omp parallel for schedule(dynamic) num_threads((int) threads)
+      for (size_t i = 0; i < n; ++i)
+      {
+        if (inner > 1)
+          omp_set_num_threads((int) inner);
+        markedTask(i);
+      }
+
+      if (inner > 1 && levels < 2)
+        omp_set_max_active_levels(levels);
+    #else
+      for (size_t i = 0; i < n; ++i)
+        markedTask(i);
+    #endif
+  }
+
+  /**
+   * Compute term(0) + ... + term(n - 1), where the terms may be computed
+   * concurrently.  The terms are added up in order, so that the result does
+   * not depend on the executor.
+   *
+   * @param n Number of terms.
+   * @param term Function that returns the term of the given index.
+   */
+  template<typename T, typename TermFunctionType>
+  T ParallelSum(const size_t n, TermFunctionType&& term) const
+  {
+    // Small sums (such as one term per thread) do not allocate.
+    T localTerms[64];
+    std::vector<T> terms((n > 64) ? n : 0);
+    T* values = (n > 64) ? terms.data() : localTerms;
+    ParallelFor(n, [&](const size_t i) { values[i] = term(i); });
+
+    T sum = T(0);
+    for (size_t i = 0; i < n; ++i)
+      sum += values[i];
+    return sum;
+  }
+
+ private:
+  //! Get whether the calling thread runs the task of a loop.
+  static bool& InTask()
+  {
+    static thread_local bool inTask = false;
+    return inTask;
+  }
+
+  //! Mark the calling thread as running a task, for its lifetime.
+  struct TaskMarker
+  {
+    TaskMarker() : previous(InTask()) { InTask() = true; }
+    ~TaskMarker() { InTask() = previous; }
+    bool previous;
+  };
+
+  //! Give the inner threads of the default thread budget to the tasks of a
+  //! loop with the given number of threads for its lifetime, and all the
+  //! threads back to BLAS afterwards.
+  struct BudgetScope
+  {
+    BudgetScope(const size_t threads) { DefaultThreadBudget().Apply(threads); }
+    ~BudgetScope() { DefaultThreadBudget().Apply(1); }
+  };
+
+  //! The number of threads of parallelFor.
+  size_t numThreads;
+  //! The function running the tasks of a loop (empty for OpenMP).
+  ParallelForType parallelFor;
+};
+
+/**
+ * Get the executor that the optimizers run their parallel loops with.  It may
+ * be replaced with SetDefaultExecutor(), which should be done before any
+ * optimization starts.
+ */
+inline Executor& DefaultExecutor()
+{
+  static Executor executor;
+  return executor;
+}
+
+//! Set the executor that the optimizers run their parallel loops with.
+inline void SetDefaultExecutor(const Executor& executor)
+{
+  DefaultExecutor() = executor;
+}
+
+/**
+ * Run task(0), ..., task(n - 1) with the default executor, or serially in the
+ * calling thread if parallel is false.
+ *
+ * @param n Number of tasks.
+ * @param task Function to call with the index of each task.
+ * @param parallel Whether the tasks may run concurrently.
+ */
+template<typename TaskFunctionType>
+inline void ParallelFor(const size_t n,
+                        TaskFunctionType&& task,
+                        const bool parallel = true)
+{
+  if (parallel)
+  {
+    DefaultExecutor().ParallelFor(n, task);
+  }
+  else
+  {
+    for (size_t i = 0; i < n; ++i)
+      task(i);
+  }
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,187 @@
+/**
+ * @file mapped_matrix.hpp
+ *
+ * A read-only dense matrix backed by a memory-mapped file, so that large
+ * datasets can be used without first being copied into memory.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_MAPPED_MATRIX_HPP
+#define ENSMALLEN_UTILITY_MAPPED_MATRIX_HPP
+
+#ifdef ENS_USE_MMAP
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#else
+  #include <fstream>
+  #include <vector>
+#endif
+
+namespace ens {
+
+/**
+ * MappedMatrix maps a file holding a dense matrix in column-major order (raw
+ * values of type ElemType, as written by Armadillo's save() with
+ * arma::raw_binary) into memory, and gives a read-only Armadillo matrix that
+ * aliases the mapping.  Pages are only read from disk when they are touched,
+ * so construction is immediate, and the pages are shared between all the
+ * processes that map the same file.
+ *
+ * The matrix can be given to any function that aliases its data instead of
+ * copying it, such as ens::test::LogisticRegressionFunction and
+ * ens::test::SoftmaxRegressionFunction.  The MappedMatrix must outlive every
+ * object that uses the matrix, and the matrix must not be modified.
+ *
+ * On platforms without mmap(), or if ENS_DONT_USE_MMAP is defined, the file
+ * is read into memory instead.
+ *
+ * @code
+ * arma::mat data(10, 1000000, arma::fill::randu);
+ * data.save("data.bin", arma::raw_binary);
+ *
+ * ens::MappedMatrix<double> predictors("data.bin", 10, 1000000);
+ * ens::test::LogisticRegressionFunction<> f(predictors.Matrix(), responses);
+ * @endcode
+ *
+ * @tparam ElemType Type of the elements stored in the file.
+ */
+template<typename ElemType>
+class MappedMatrix
+{
+ public:
+  /**
+   * Map the given file.  The file must hold at least rows * cols values after
+   * the given offset (in bytes); an offset can be used to skip a header.  A
+   * std::runtime_error is thrown if the file cannot be mapped.
+   *
+   * @param filename Name of the file to map.
+   * @param rows Number of rows of the matrix.
+   * @param cols Number of columns of the matrix.
+   * @param offset Number of bytes to skip at the start of the file.
+   */
+  MappedMatrix(const std::string& filename,
+               const size_t rows,
+               const size_t cols,
+               const size_t offset = 0) :
+      mapping(NULL),
+      mappingBytes(0),
+      // We promise to be well-behaved... the elements won't be modified.
+      matrix(const_cast<ElemType*>(Map(filename,
+          offset + rows * cols * sizeof(ElemType), offset)), rows, cols, false,
+          true)
+  {
+    // Nothing to do.
+  }
+
+  //! Unmap the file.
+  ~MappedMatrix()
+  {
+    #ifdef ENS_USE_MMAP
+    if (mapping != NULL)
+      munmap(mapping, mappingBytes);
+    #endif
+  }
+
+  //! The mapping can't be shared between two objects.
+  MappedMatrix(const MappedMatrix& other) = delete;
+  //! The mapping can't be shared between two objects.
+  MappedMatrix& operator=(const MappedMatrix& other) = delete;
+
+  //! Get the matrix that aliases the file.
+  const arma::Mat<ElemType>& Matrix() const { return matrix; }
+
+  //! Get the number of rows.
+  size_t Rows() const { return matrix.n_rows; }
+  //! Get the number of columns.
+  size_t Cols() const { return matrix.n_cols; }
+
+ private:
+  //! Map the first bytes of the file, and return the values after offset.
+  const ElemType* Map(const std::string& filename,
+                      const size_t bytes,
+                      const size_t offset)
+  {
+    if (offset % sizeof(ElemType) != 0)
+    {
+      std::ostringstream oss;
+      oss << "MappedMatrix::MappedMatrix(): offset (" << offset << ") is not "
+          << "a multiple of the element size (" << sizeof(ElemType) << ")!";
+      throw std::runtime_error(oss.str());
+    }
+
+    #ifdef ENS_USE_MMAP
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+      Fail(filename, "cannot be opened");
+
+    struct stat status;
+    if (fstat(fd, &status) != 0 || size_t(status.st_size) < bytes)
+    {
+      close(fd);
+      Fail(filename, "is too small");
+    }
+
+    // An empty matrix doesn't need a mapping.
+    if (bytes == 0)
+    {
+      close(fd);
+      return NULL;
+    }
+
+    void* address = mmap(NULL, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping stays valid after the file is closed.
+    close(fd);
+    if (address == MAP_FAILED)
+      Fail(filename, "cannot be mapped");
+
+    mapping = address;
+    mappingBytes = bytes;
+    return reinterpret_cast<const ElemType*>(
+        static_cast<const char*>(address) + offset);
+    #else
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if (!file.is_open())
+      Fail(filename, "cannot be opened");
+
+    buffer.resize((bytes - offset) / sizeof(ElemType));
+    file.seekg(offset);
+    file.read(reinterpret_cast<char*>(buffer.data()), bytes - offset);
+    if (size_t(file.gcount()) != bytes - offset)
+      Fail(filename, "is too small");
+
+    return buffer.data();
+    #endif
+  }
+
+  //! Throw an error about the given file.
+  static void Fail(const std::string& filename, const std::string& reason)
+  {
+    std::ostringstream oss;
+    oss << "MappedMatrix::MappedMatrix(): file '" << filename << "' " << reason
+        << "!";
+    throw std::runtime_error(oss.str());
+  }
+
+  //! The start of the mapping (if any).
+  void* mapping;
+  //! The number of bytes mapped.
+  size_t mappingBytes;
+
+  #ifndef ENS_USE_MMAP
+  //! The values read from the file.
+  std::vector<ElemType> buffer;
+  #endif
+
+  //! The matrix that aliases the values.  This must be declared after the
+  //! members that Map() sets.
+  arma::Mat<ElemType> matrix;
+};
+
+} // namespace ens
+
+#endif
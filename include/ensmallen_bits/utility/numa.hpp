@@ -0,0 +1,43 @@
+/**
+ * @file numa.hpp
+ *
+ * Detection of the number of NUMA nodes (memory domains, usually sockets) of
+ * the machine.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_NUMA_HPP
+#define ENSMALLEN_UTILITY_NUMA_HPP
+
+#include <fstream>
+
+namespace ens {
+
+/**
+ * Return the number of NUMA nodes of the machine.  On Linux, the nodes are
+ * listed in /sys/devices/system/node; elsewhere (or if the list can't be
+ * read), the machine is assumed to have a single node.
+ */
+inline size_t NumaNodes()
+{
+  size_t nodes = 0;
+  #ifdef __linux__
+  for (;; ++nodes)
+  {
+    std::ostringstream oss;
+    oss << "/sys/devices/system/node/node" << nodes << "/cpulist";
+    std::ifstream file(oss.str().c_str());
+    if (!file.is_open())
+      break;
+  }
+  #endif
+
+  return std::max(nodes, size_t(1));
+}
+
+} // namespace ens
+
+#endif
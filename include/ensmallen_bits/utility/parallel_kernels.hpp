@@ -0,0 +1,224 @@
+/**
+ * @file parallel_kernels.hpp
+ *
+ * Dot products and vector updates over the contiguous memory of dense
+ * matrices, split into chunks that are processed by the threads of the default
+ * executor.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_PARALLEL_KERNELS_HPP
+#define ENSMALLEN_UTILITY_PARALLEL_KERNELS_HPP
+
+namespace ens {
+
+/**
+ * Get the number of chunks that the kernels below split a matrix with the
+ * given number of elements into: one per thread of the default executor, as
+ * long as each chunk holds at least minChunkSize elements.  With a serial
+ * executor, or with minChunkSize set to 0, this is always 1.  In the
+ * deterministic reduction mode, the number of chunks does not depend on the
+ * number of threads (see DeterministicChunkCount()).
+ *
+ * @param elements Number of elements of the matrix.
+ * @param minChunkSize Minimum number of elements in a chunk.
+ */
+inline size_t ParallelChunkCount(const size_t elements,
+                                 const size_t minChunkSize)
+{
+  if (minChunkSize == 0)
+    return 1;
+  else if (DeterministicReductions())
+    return DeterministicChunkCount(elements, minChunkSize);
+
+  const size_t usefulChunks = elements / minChunkSize;
+  return std::max(std::min(DefaultExecutor().NumThreads(), usefulChunks),
+      (size_t) 1);
+}
+
+/**
+ * Compute the dot product of two matrices.  This is arma::dot() (or the dot()
+ * of the matrix type), except for large dense Armadillo matrices, for which
+ * each thread computes the dot product of one chunk of the elements and the
+ * partial sums are added up.
+ *
+ * @param a First matrix.
+ * @param b Second matrix, with as many elements as a.
+ * @param minChunkSize Minimum number of elements in a chunk (see
+ *     ParallelChunkCount()).
+ */
+template<typename AType, typename BType>
+inline typename AType::elem_type ParallelDot(const AType& a,
+                                             const BType& b,
+                                             const size_t /* minChunkSize */)
+{
+  return dot(a, b);
+}
+
+//! Compute the dot product of two dense matrices, in parallel if they are
+//! large.
+template<typename eT>
+inline eT ParallelDot(const arma::Mat<eT>& a,
+                      const arma::Mat<eT>& b,
+                      const size_t minChunkSize)
+{
+  const size_t chunks = ParallelChunkCount(a.n_elem, minChunkSize);
+  if (chunks == 1)
+    return arma::dot(a, b);
+
+  const size_t n = a.n_elem;
+  return DefaultExecutor().ParallelSum<eT>(chunks, [&](const size_t c)
+  {
+    const size_t begin = (c * n) / chunks;
+    const size_t length = ((c + 1) * n) / chunks - begin;
+
+    // Alias the chunks of both matrices.
+    const arma::Col<eT> aChunk(const_cast<eT*>(a.memptr()) + begin, length,
+        false, true);
+    const arma::Col<eT> bChunk(const_cast<eT*>(b.memptr()) + begin, length,
+        false, true);
+    return arma::dot(aChunk, bChunk);
+  });
+}
+
+/**
+ * Add alpha * x to y.  The chunks of large dense Armadillo matrices are
+ * updated by several threads.
+ *
+ * @param alpha Scalar to multiply x by.
+ * @param x Matrix to add.
+ * @param y Matrix to update, with as many elements as x.
+ * @param minChunkSize Minimum number of elements in a chunk (see
+ *     ParallelChunkCount()).
+ */
+template<typename XType, typename YType>
+inline void ParallelAxpy(const double alpha,
+                         const XType& x,
+                         YType& y,
+                         const size_t /* minChunkSize */)
+{
+  y += alpha * x;
+}
+
+//! Add alpha * x to y for dense matrices, in parallel if they are large.
+template<typename eT>
+inline void ParallelAxpy(const double alpha,
+                         const arma::Mat<eT>& x,
+                         arma::Mat<eT>& y,
+                         const size_t minChunkSize)
+{
+  const size_t chunks = ParallelChunkCount(y.n_elem, minChunkSize);
+  if (chunks == 1)
+  {
+    y += eT(alpha) * x;
+    return;
+  }
+
+  const size_t n = y.n_elem;
+  DefaultExecutor().ParallelFor(chunks, [&](const size_t c)
+  {
+    const size_t begin = (c * n) / chunks;
+    const size_t length = ((c + 1) * n) / chunks - begin;
+
+    const arma::Col<eT> xChunk(const_cast<eT*>(x.memptr()) + begin, length,
+        false, true);
+    arma::Col<eT> yChunk(y.memptr() + begin, length, false, true);
+    yChunk += eT(alpha) * xChunk;
+  });
+}
+
+/**
+ * Multiply y by alpha.  The chunks of large dense Armadillo matrices are
+ * scaled by several threads.
+ *
+ * @param alpha Scalar to multiply y by.
+ * @param y Matrix to scale.
+ * @param minChunkSize Minimum number of elements in a chunk (see
+ *     ParallelChunkCount()).
+ */
+template<typename YType>
+inline void ParallelScale(const double alpha,
+                          YType& y,
+                          const size_t /* minChunkSize */)
+{
+  y *= alpha;
+}
+
+//! Multiply a dense matrix by alpha, in parallel if it is large.
+template<typename eT>
+inline void ParallelScale(const double alpha,
+                          arma::Mat<eT>& y,
+                          const size_t minChunkSize)
+{
+  const size_t chunks = ParallelChunkCount(y.n_elem, minChunkSize);
+  if (chunks == 1)
+  {
+    y *= eT(alpha);
+    return;
+  }
+
+  const size_t n = y.n_elem;
+  DefaultExecutor().ParallelFor(chunks, [&](const size_t c)
+  {
+    const size_t begin = (c * n) / chunks;
+    const size_t length = ((c + 1) * n) / chunks - begin;
+
+    arma::Col<eT> yChunk(y.memptr() + begin, length, false, true);
+    yChunk *= eT(alpha);
+  });
+}
+
+/**
+ * Store a - b in out.  The chunks of large dense Armadillo matrices are
+ * computed by several threads; out must then already have the size of a.
+ *
+ * @param a First matrix.
+ * @param b Matrix to subtract, with as many elements as a.
+ * @param out Matrix to store the difference in.
+ * @param minChunkSize Minimum number of elements in a chunk (see
+ *     ParallelChunkCount()).
+ */
+template<typename AType, typename BType, typename OutType>
+inline void ParallelDifference(const AType& a,
+                               const BType& b,
+                               OutType& out,
+                               const size_t /* minChunkSize */)
+{
+  out = a - b;
+}
+
+//! Store the difference of two dense matrices, in parallel if they are large.
+template<typename eT>
+inline void ParallelDifference(const arma::Mat<eT>& a,
+                               const arma::Mat<eT>& b,
+                               arma::Mat<eT>& out,
+                               const size_t minChunkSize)
+{
+  const size_t chunks = ParallelChunkCount(a.n_elem, minChunkSize);
+  if (chunks == 1 || out.n_elem != a.n_elem)
+  {
+    out = a - b;
+    return;
+  }
+
+  const size_t n = a.n_elem;
+  DefaultExecutor().ParallelFor(chunks, [&](const size_t c)
+  {
+    const size_t begin = (c * n) / chunks;
+    const size_t length = ((c + 1) * n) / chunks - begin;
+
+    const arma::Col<eT> aChunk(const_cast<eT*>(a.memptr()) + begin, length,
+        false, true);
+    const arma::Col<eT> bChunk(const_cast<eT*>(b.memptr()) + begin, length,
+        false, true);
+    arma::Col<eT> outChunk(out.memptr() + begin, length, false, true);
+    outChunk = aChunk - bChunk;
+  });
+}
+
+} // namespace ens
+
+#endif
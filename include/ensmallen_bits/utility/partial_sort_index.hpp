@@ -0,0 +1,65 @@
+/**
+ * @file partial_sort_index.hpp
+ *
+ * Find the indices of the smallest values of a vector, without sorting all of
+ * them.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_PARTIAL_SORT_INDEX_HPP
+#define ENSMALLEN_UTILITY_PARTIAL_SORT_INDEX_HPP
+
+#include <algorithm>
+#include <cmath>
+
+namespace ens {
+
+/**
+ * Arrange the given index buffer so that its first k entries are the indices
+ * of the k smallest values, in increasing order of value; the other entries
+ * are the indices of the remaining values, in no particular order.  This takes
+ * O(n log k) time instead of the O(n log n) of arma::sort_index(), which
+ * matters for the selection of the elite of large populations.
+ *
+ * The buffer is always a permutation of 0, ..., n - 1.  If it does not have n
+ * elements it is reset to the identity; otherwise the permutation of the last
+ * call is reused as the starting point, so that no memory is allocated.  NaN
+ * values are placed after all the other values.
+ *
+ * @param values Values to select the smallest of.
+ * @param k Number of smallest values to find (clamped to the number of
+ *     values).
+ * @param index Index buffer to arrange.
+ */
+template<typename VecType>
+inline void PartialSortIndex(const VecType& values,
+                             const size_t k,
+                             arma::uvec& index)
+{
+  const size_t n = values.n_elem;
+  if (index.n_elem != n)
+  {
+    index.set_size(n);
+    for (size_t i = 0; i < n; ++i)
+      index[i] = i;
+  }
+
+  // A NaN compares greater than everything else, which keeps the ordering a
+  // strict weak ordering.
+  const auto less = [&values](const arma::uword a, const arma::uword b)
+  {
+    const double valueA = values[a];
+    const double valueB = values[b];
+    return (valueA < valueB) || (std::isnan(valueB) && !std::isnan(valueA));
+  };
+
+  arma::uword* indices = index.memptr();
+  std::partial_sort(indices, indices + std::min(k, n), indices + n, less);
+}
+
+} // namespace ens
+
+#endif
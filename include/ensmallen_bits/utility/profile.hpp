@@ -0,0 +1,295 @@
+/**
+ * @file profile.hpp
+ *
+ * Scoped timers for the hot paths of the optimizers, with a report of the
+ * time spent in each section at the end of Optimize().  The timers are
+ * compiled out unless ENS_PROFILE is defined.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_PROFILE_HPP
+#define ENSMALLEN_UTILITY_PROFILE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace ens {
+
+/**
+ * The number of calls to a section of code and the time spent in them.  The
+ * counters are atomic, so a section may be timed from several threads.
+ */
+class ProfileSection
+{
+ public:
+  //! Create an empty section with the given name.
+  ProfileSection(const std::string& name) :
+      name(name), calls(0), nanoseconds(0)
+  { }
+
+  //! Add a call that took the given time.
+  void Add(const uint64_t elapsed)
+  {
+    calls.fetch_add(1, std::memory_order_relaxed);
+    nanoseconds.fetch_add(elapsed, std::memory_order_relaxed);
+  }
+
+  //! Get the name of the section.
+  const std::string& Name() const { return name; }
+
+  //! Get the number of calls.
+  size_t Calls() const { return calls.load(std::memory_order_relaxed); }
+
+  //! Get the time spent in the section, in seconds.
+  double Seconds() const
+  {
+    return 1e-9 * nanoseconds.load(std::memory_order_relaxed);
+  }
+
+  //! Zero the counters.
+  void Reset()
+  {
+    calls.store(0, std::memory_order_relaxed);
+    nanoseconds.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  //! The name of the section.
+  std::string name;
+  //! The number of calls.
+  std::atomic<uint64_t> calls;
+  //! The time spent in the section, in nanoseconds.
+  std::atomic<uint64_t> nanoseconds;
+};
+
+/**
+ * The process-wide set of profiled sections.  When ENS_PROFILE is defined,
+ * each optimizer times its hot paths (the objective and gradient evaluations,
+ * the update and decay policies, the line search, the shuffles) with
+ * ENS_PROFILE_SCOPE(), and the outermost call to Optimize() writes a report
+ * of the sections to Output() and zeroes them when it returns.  The sections
+ * can also be read (and reset) directly.
+ *
+ * @code
+ * // Compile with -DENS_PROFILE, then:
+ * std::ostringstream report;
+ * ens::Profiler::Get().Output() = &report;
+ * optimizer.Optimize(f, coordinates);
+ * @endcode
+ */
+class Profiler
+{
+ public:
+  //! Get the profiler.
+  static Profiler& Get()
+  {
+    static Profiler profiler;
+    return profiler;
+  }
+
+  /**
+   * Get the section with the given name, creating it if needed.  The section
+   * stays valid as long as the program runs, so a call site only has to look
+   * it up once.
+   *
+   * @param name Name of the section.
+   */
+  ProfileSection& Section(const std::string& name)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::map<std::string, ProfileSection*>::iterator it = sections.find(name);
+    if (it == sections.end())
+    {
+      it = sections.insert(std::make_pair(name,
+          new ProfileSection(name))).first;
+    }
+
+    return *it->second;
+  }
+
+  //! Get the sections, in order of their names.
+  std::vector<const ProfileSection*> Sections() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<const ProfileSection*> result;
+    std::map<std::string, ProfileSection*>::const_iterator it;
+    for (it = sections.begin(); it != sections.end(); ++it)
+      result.push_back(it->second);
+
+    return result;
+  }
+
+  //! Zero all the sections.
+  void Reset()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::map<std::string, ProfileSection*>::iterator it;
+    for (it = sections.begin(); it != sections.end(); ++it)
+      it->second->Reset();
+  }
+
+  /**
+   * Write a report of the sections that were called, with the number of
+   * calls, the time spent and its share of the given total time.
+   *
+   * @param output Stream to write to.
+   * @param title Title of the report (for instance, the optimizer's name).
+   * @param seconds Total time, in seconds.
+   */
+  void Report(std::ostream& output,
+              const std::string& title,
+              const double seconds) const
+  {
+    const std::vector<const ProfileSection*> all = Sections();
+    output << title << " profile: " << seconds << "s in total.\n";
+    for (size_t i = 0; i < all.size(); ++i)
+    {
+      if (all[i]->Calls() == 0)
+        continue;
+
+      output << "  " << std::left << std::setw(24) << all[i]->Name()
+          << std::right << std::setw(10) << all[i]->Calls() << " calls "
+          << std::setw(12) << all[i]->Seconds() << "s";
+      if (seconds > 0)
+        output << " (" << (100.0 * all[i]->Seconds() / seconds) << "%)";
+      output << "\n";
+    }
+    output.flush();
+  }
+
+  //! Get the stream the reports are written to (NULL for no report).
+  std::ostream* Output() const { return output; }
+  //! Modify the stream the reports are written to (NULL for no report).
+  std::ostream*& Output() { return output; }
+
+  //! Enter a call to Optimize(); return whether it is the outermost one.
+  bool Enter() { return depth.fetch_add(1) == 0; }
+
+  //! Leave a call to Optimize(); return whether it was the outermost one.
+  bool Leave() { return depth.fetch_sub(1) == 1; }
+
+ private:
+  //! Create the profiler; reports are written to the standard output.
+  Profiler() : output(&std::cout), depth(0) { }
+
+  //! Destroy the sections.
+  ~Profiler()
+  {
+    std::map<std::string, ProfileSection*>::iterator it;
+    for (it = sections.begin(); it != sections.end(); ++it)
+      delete it->second;
+  }
+
+  //! The sections, by name.
+  std::map<std::string, ProfileSection*> sections;
+  //! The lock of the map of sections.
+  mutable std::mutex mutex;
+  //! The stream the reports are written to.
+  std::ostream* output;
+  //! The number of calls to Optimize() in progress.
+  std::atomic<int> depth;
+};
+
+/**
+ * A timer that adds the time between its construction and its destruction to
+ * the given section.
+ */
+class ProfileTimer
+{
+ public:
+  //! Start timing the given section.
+  ProfileTimer(ProfileSection& section) :
+      section(section),
+      start(std::chrono::steady_clock::now())
+  { }
+
+  //! Stop timing and add the time to the section.
+  ~ProfileTimer()
+  {
+    section.Add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+  }
+
+ private:
+  //! The timed section.
+  ProfileSection& section;
+  //! The time the timer was started.
+  std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * An object that lives for the duration of a call to Optimize(): the
+ * outermost one zeroes the sections when it is created, and writes the report
+ * when it is destroyed.
+ */
+class ProfileReport
+{
+ public:
+  //! Start profiling the optimizer with the given name.
+  ProfileReport(const std::string& title) :
+      title(title),
+      outermost(Profiler::Get().Enter()),
+      start(std::chrono::steady_clock::now())
+  {
+    if (outermost)
+      Profiler::Get().Reset();
+  }
+
+  //! Write the report, if this is the outermost call.
+  ~ProfileReport()
+  {
+    Profiler& profiler = Profiler::Get();
+    if (profiler.Leave() && profiler.Output() != NULL)
+    {
+      const double seconds = std::chrono::duration_cast<
+          std::chrono::duration<double>>(std::chrono::steady_clock::now() -
+          start).count();
+      profiler.Report(*profiler.Output(), title, seconds);
+    }
+  }
+
+ private:
+  //! The name of the optimizer.
+  std::string title;
+  //! Whether this is the outermost call to Optimize().
+  bool outermost;
+  //! The time the optimization started.
+  std::chrono::steady_clock::time_point start;
+};
+
+} // namespace ens
+
+#define ENS_PROFILE_CONCAT_IMPL(A, B) A##B
+#define ENS_PROFILE_CONCAT(A, B) ENS_PROFILE_CONCAT_IMPL(A, B)
+
+#ifdef ENS_PROFILE
+  /**
+   * Time the rest of the enclosing scope as the section with the given name.
+   */
+  #define ENS_PROFILE_SCOPE(NAME)                                              \
+      static ens::ProfileSection& ENS_PROFILE_CONCAT(ensProfileSection,        \
+          __LINE__) = ens::Profiler::Get().Section(NAME);                      \
+      ens::ProfileTimer ENS_PROFILE_CONCAT(ensProfileTimer, __LINE__)(         \
+          ENS_PROFILE_CONCAT(ensProfileSection, __LINE__))
+
+  /**
+   * Profile the rest of the enclosing call to Optimize(), and report the
+   * sections under the given name at its end.
+   */
+  #define ENS_PROFILE_OPTIMIZE(NAME)                                           \
+      ens::ProfileReport ensProfileReport(NAME)
+#else
+  #define ENS_PROFILE_SCOPE(NAME)
+  #define ENS_PROFILE_OPTIMIZE(NAME)
+#endif
+
+#endif
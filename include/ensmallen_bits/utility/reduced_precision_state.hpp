@@ -0,0 +1,316 @@
+/**
+ * @file reduced_precision_state.hpp
+ *
+ * Compact storage for the state of an update policy (such as the moment
+ * estimates of Adam).  Values are stored in fewer bits than the iterate and
+ * decoded to float for computation, one block at a time.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_REDUCED_PRECISION_STATE_HPP
+#define ENSMALLEN_UTILITY_REDUCED_PRECISION_STATE_HPP
+
+#include <vector>
+
+namespace ens {
+
+/**
+ * The reduced precision state classes all have the same interface.  A state
+ * holds a vector of values; Decode() and Encode() convert consecutive values
+ * to and from float.  Both must be called on whole blocks: begin must be a
+ * multiple of BlockSize(), and count at most BlockSize() (only the last block
+ * may be shorter).
+ *
+ * @code
+ * static size_t BlockSize();
+ * void Zeros(const size_t n);
+ * size_t Bytes() const;
+ * static size_t BytesFor(const size_t n);
+ * void Decode(const size_t begin, const size_t count, float* values) const;
+ * void Encode(const size_t begin, const size_t count, const float* values);
+ * @endcode
+ */
+
+/**
+ * Store each value as a 32-bit float; for double-precision iterates, this
+ * halves the memory used by the state.
+ */
+class Float32State
+{
+ public:
+  //! Get the number of values to decode or encode at a time.
+  static size_t BlockSize() { return 256; }
+
+  //! Resize the state to n values, all zero.
+  void Zeros(const size_t n) { data.assign(n, 0.0f); }
+
+  //! Get the number of bytes used by the state.
+  size_t Bytes() const { return data.size() * sizeof(float); }
+
+  //! Get the number of bytes a state of n values uses.
+  static size_t BytesFor(const size_t n) { return n * sizeof(float); }
+
+  //! Decode count values starting at begin.
+  void Decode(const size_t begin, const size_t count, float* values) const
+  {
+    std::copy(data.begin() + begin, data.begin() + begin + count, values);
+  }
+
+  //! Encode count values starting at begin.
+  void Encode(const size_t begin, const size_t count, const float* values)
+  {
+    std::copy(values, values + count, data.begin() + begin);
+  }
+
+ private:
+  //! The stored values.
+  std::vector<float> data;
+};
+
+/**
+ * Store each value as a bfloat16 (the upper 16 bits of a float, rounded to
+ * nearest even).  This keeps the range of a float with 8 bits of precision.
+ */
+class BFloat16State
+{
+ public:
+  //! Get the number of values to decode or encode at a time.
+  static size_t BlockSize() { return 256; }
+
+  //! Resize the state to n values, all zero.
+  void Zeros(const size_t n) { data.assign(n, 0); }
+
+  //! Get the number of bytes used by the state.
+  size_t Bytes() const { return data.size() * sizeof(uint16_t); }
+
+  //! Get the number of bytes a state of n values uses.
+  static size_t BytesFor(const size_t n) { return n * sizeof(uint16_t); }
+
+  //! Decode count values starting at begin.
+  void Decode(const size_t begin, const size_t count, float* values) const
+  {
+    for (size_t i = 0; i < count; ++i)
+    {
+      const uint32_t bits = uint32_t(data[begin + i]) << 16;
+      std::memcpy(&values[i], &bits, sizeof(float));
+    }
+  }
+
+  //! Encode count values starting at begin.
+  void Encode(const size_t begin, const size_t count, const float* values)
+  {
+    for (size_t i = 0; i < count; ++i)
+    {
+      uint32_t bits;
+      std::memcpy(&bits, &values[i], sizeof(float));
+
+      if ((bits & 0x7FFFFFFF) > 0x7F800000)
+      {
+        // Keep NaNs quiet, so that truncation can't turn them into infinity.
+        data[begin + i] = uint16_t((bits >> 16) | 0x0040);
+      }
+      else
+      {
+        bits += 0x7FFF + ((bits >> 16) & 1);
+        data[begin + i] = uint16_t(bits >> 16);
+      }
+    }
+  }
+
+ private:
+  //! The stored values.
+  std::vector<uint16_t> data;
+};
+
+/**
+ * Store each value as an IEEE 754 half-precision float, rounded to nearest
+ * even.  This gives 11 bits of precision, but magnitudes above 65504 overflow
+ * and magnitudes below about 6e-8 underflow to zero.
+ */
+class Float16State
+{
+ public:
+  //! Get the number of values to decode or encode at a time.
+  static size_t BlockSize() { return 256; }
+
+  //! Resize the state to n values, all zero.
+  void Zeros(const size_t n) { data.assign(n, 0); }
+
+  //! Get the number of bytes used by the state.
+  size_t Bytes() const { return data.size() * sizeof(uint16_t); }
+
+  //! Get the number of bytes a state of n values uses.
+  static size_t BytesFor(const size_t n) { return n * sizeof(uint16_t); }
+
+  //! Decode count values starting at begin.
+  void Decode(const size_t begin, const size_t count, float* values) const
+  {
+    for (size_t i = 0; i < count; ++i)
+      values[i] = ToFloat(data[begin + i]);
+  }
+
+  //! Encode count values starting at begin.
+  void Encode(const size_t begin, const size_t count, const float* values)
+  {
+    for (size_t i = 0; i < count; ++i)
+      data[begin + i] = FromFloat(values[i]);
+  }
+
+ private:
+  //! Convert a half-precision float to a float.
+  static float ToFloat(const uint16_t half)
+  {
+    const uint32_t sign = uint32_t(half & 0x8000) << 16;
+    const uint32_t exponent = (half >> 10) & 0x1F;
+    const uint32_t mantissa = half & 0x3FF;
+
+    uint32_t bits;
+    if (exponent == 0x1F)
+    {
+      // Infinity or NaN.
+      bits = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else if (exponent != 0)
+    {
+      bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    else
+    {
+      // Zero or subnormal: the value is mantissa * 2^-24.
+      const float value = std::ldexp(float(mantissa), -24);
+      return sign ? -value : value;
+    }
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(float));
+    return value;
+  }
+
+  //! Convert a float to a half-precision float.
+  static uint16_t FromFloat(const float value)
+  {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(float));
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const uint32_t absBits = bits & 0x7FFFFFFF;
+
+    // Infinity or NaN (kept quiet).
+    if (absBits >= 0x7F800000)
+      return uint16_t(sign | 0x7C00 | (absBits > 0x7F800000 ? 0x0200 : 0));
+
+    // Anything that rounds above the largest half (65504) overflows.
+    if (absBits >= 0x477FF000)
+      return uint16_t(sign | 0x7C00);
+
+    uint32_t half;
+    uint32_t remainder;
+    uint32_t halfway;
+    if (absBits >= 0x38800000)
+    {
+      // A normal half: rebias the exponent and drop 13 mantissa bits.
+      half = (absBits - 0x38000000) >> 13;
+      remainder = absBits & 0x1FFF;
+      halfway = 0x1000;
+    }
+    else
+    {
+      // A subnormal half (or zero), in units of 2^-24.
+      const uint32_t exponent = absBits >> 23;
+      if (exponent < 102)
+        return uint16_t(sign);
+
+      const uint32_t shift = 126 - exponent;
+      const uint32_t mantissa = (absBits & 0x7FFFFF) | 0x800000;
+      half = mantissa >> shift;
+      remainder = mantissa & ((1u << shift) - 1);
+      halfway = 1u << (shift - 1);
+    }
+
+    // Round to nearest even; a carry into the exponent is still correct.
+    if (remainder > halfway || (remainder == halfway && (half & 1)))
+      ++half;
+
+    return uint16_t(sign | half);
+  }
+
+  //! The stored values.
+  std::vector<uint16_t> data;
+};
+
+/**
+ * Store each value in 8 bits, relative to the largest magnitude in its block
+ * of 64 values (which is stored as a float).  The magnitudes are companded
+ * with a fourth root before rounding, so that values much smaller than the
+ * largest one in their block keep some relative precision instead of rounding
+ * to zero; values below about 1e-9 times the largest one still do.  This uses
+ * a little over one byte per value.
+ */
+class BlockQuantized8State
+{
+ public:
+  //! Get the number of values to decode or encode at a time.
+  static size_t BlockSize() { return 64; }
+
+  //! Resize the state to n values, all zero.
+  void Zeros(const size_t n)
+  {
+    data.assign(n, 0);
+    scales.assign((n + BlockSize() - 1) / BlockSize(), 0.0f);
+  }
+
+  //! Get the number of bytes used by the state.
+  size_t Bytes() const
+  {
+    return data.size() * sizeof(int8_t) + scales.size() * sizeof(float);
+  }
+
+  //! Get the number of bytes a state of n values uses.
+  static size_t BytesFor(const size_t n)
+  {
+    return n * sizeof(int8_t) +
+        (n + BlockSize() - 1) / BlockSize() * sizeof(float);
+  }
+
+  //! Decode count values starting at begin.
+  void Decode(const size_t begin, const size_t count, float* values) const
+  {
+    const float scale = scales[begin / BlockSize()];
+    for (size_t i = 0; i < count; ++i)
+    {
+      const float t = std::abs(float(data[begin + i])) / 127.0f;
+      const float magnitude = scale * (t * t) * (t * t);
+      values[i] = (data[begin + i] < 0) ? -magnitude : magnitude;
+    }
+  }
+
+  //! Encode count values starting at begin.
+  void Encode(const size_t begin, const size_t count, const float* values)
+  {
+    float scale = 0.0f;
+    for (size_t i = 0; i < count; ++i)
+      scale = std::max(scale, std::abs(values[i]));
+    scales[begin / BlockSize()] = scale;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+      const float t = (scale > 0.0f) ?
+          std::sqrt(std::sqrt(std::abs(values[i]) / scale)) : 0.0f;
+      const int8_t q = int8_t(std::lround(127.0f * t));
+      data[begin + i] = (values[i] < 0) ? int8_t(-q) : q;
+    }
+  }
+
+ private:
+  //! The quantized values.
+  std::vector<int8_t> data;
+
+  //! The largest magnitude in each block.
+  std::vector<float> scales;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,301 @@
+/**
+ * @file rng.hpp
+ *
+ * A small and fast random number generator (xoshiro256**) for the stochastic
+ * optimizers, with bulk generation into matrices and independent streams for
+ * parallel workers.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_RNG_HPP
+#define ENSMALLEN_UTILITY_RNG_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace ens {
+
+/**
+ * RNG is the xoshiro256** generator of Blackman and Vigna, with 256 bits of
+ * state and a period of 2^256 - 1.  Drawing a number takes a few integer
+ * operations, so it is much cheaper than drawing single values through
+ * arma::randu() or arma::randi(); matrices and cubes can also be filled in
+ * bulk with Randu(), Randn() and Randi().
+ *
+ * RNG meets the requirements of a uniform random bit generator, so it can be
+ * used with the distributions of <random> and with std::shuffle().
+ *
+ * An RNG must not be used by several threads at once.  Streams() gives
+ * generators for parallel workers: each one is 2^128 draws away from the
+ * next, so their sequences never overlap in practice.  The optimizers seed
+ * their generators with ArmaSeed(), which is drawn from Armadillo's
+ * generator, so arma::arma_rng::set_seed() still makes them reproducible.
+ *
+ * @code
+ * RNG rng(RNG::ArmaSeed());
+ * arma::mat noise(10, 10);
+ * rng.Randn(noise);
+ * const size_t member = rng.Randi(0, 9);
+ * @endcode
+ */
+class RNG
+{
+ public:
+  //! The type of the numbers drawn by operator().
+  typedef uint64_t result_type;
+
+  /**
+   * Create a generator with the given seed.
+   *
+   * @param seed Seed of the generator.
+   */
+  explicit RNG(const uint64_t seed = 0x853c49e6748fea9bULL) { Seed(seed); }
+
+  /**
+   * Reset the generator with the given seed.  The 256 bits of state are
+   * filled from the seed with SplitMix64, as recommended by the authors of
+   * xoshiro.
+   *
+   * @param seed Seed of the generator.
+   */
+  void Seed(uint64_t seed)
+  {
+    for (size_t i = 0; i < 4; ++i)
+    {
+      seed += 0x9e3779b97f4a7c15ULL;
+      uint64_t z = seed;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      state[i] = z ^ (z >> 31);
+    }
+
+    hasSpareNormal = false;
+  }
+
+  /**
+   * Draw a seed from Armadillo's random number generator, so that the seed
+   * follows arma::arma_rng::set_seed().
+   */
+  static uint64_t ArmaSeed()
+  {
+    const arma::ivec parts = arma::randi<arma::ivec>(3,
+        arma::distr_param(0, std::numeric_limits<int>::max()));
+    return (uint64_t(parts(0)) << 33) ^ (uint64_t(parts(1)) << 2) ^
+        uint64_t(parts(2));
+  }
+
+  //! Get the smallest number drawn by operator().
+  static constexpr result_type min() { return 0; }
+  //! Get the largest number drawn by operator().
+  static constexpr result_type max()
+  {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  //! Draw 64 random bits.
+  result_type operator()()
+  {
+    const uint64_t result = RotateLeft(state[1] * 5, 7) * 9;
+    const uint64_t t = state[1] << 17;
+
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = RotateLeft(state[3], 45);
+
+    return result;
+  }
+
+  /**
+   * Advance the generator by 2^128 draws.  This is used to create streams
+   * for parallel workers that do not overlap.
+   */
+  void Jump()
+  {
+    static const uint64_t jump[4] = { 0x180ec6d33cfd0abaULL,
+        0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+
+    uint64_t next[4] = { 0, 0, 0, 0 };
+    for (size_t i = 0; i < 4; ++i)
+    {
+      for (size_t b = 0; b < 64; ++b)
+      {
+        if (jump[i] & (uint64_t(1) << b))
+        {
+          for (size_t j = 0; j < 4; ++j)
+            next[j] ^= state[j];
+        }
+        (*this)();
+      }
+    }
+
+    for (size_t j = 0; j < 4; ++j)
+      state[j] = next[j];
+    hasSpareNormal = false;
+  }
+
+  /**
+   * Get the given number of generators with independent streams, for
+   * parallel workers: the first one continues this generator's sequence, and
+   * each other one starts 2^128 draws after the previous one.  This generator
+   * then continues after the last stream, so it can be used alongside them.
+   *
+   * @param count Number of streams.
+   */
+  std::vector<RNG> Streams(const size_t count)
+  {
+    std::vector<RNG> streams;
+    streams.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+      streams.push_back(*this);
+      Jump();
+    }
+
+    return streams;
+  }
+
+  //! Draw a number uniformly distributed in [0, 1), with 53 random bits.
+  double Randu()
+  {
+    return ((*this)() >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+  /**
+   * Draw a number from the standard normal distribution, with the polar
+   * method of Marsaglia; the second number of each pair is kept for the next
+   * call.
+   */
+  double Randn()
+  {
+    if (hasSpareNormal)
+    {
+      hasSpareNormal = false;
+      return spareNormal;
+    }
+
+    double u, v, s;
+    do
+    {
+      u = 2.0 * Randu() - 1.0;
+      v = 2.0 * Randu() - 1.0;
+      s = u * u + v * v;
+    }
+    while (s >= 1.0 || s == 0.0);
+
+    const double factor = std::sqrt(-2.0 * std::log(s) / s);
+    spareNormal = v * factor;
+    hasSpareNormal = true;
+    return u * factor;
+  }
+
+  /**
+   * Draw an integer uniformly distributed in [lo, hi] (both included),
+   * without the bias of a plain modulo.
+   *
+   * @param lo Smallest number to draw.
+   * @param hi Largest number to draw.
+   */
+  size_t Randi(const size_t lo, const size_t hi)
+  {
+    const uint64_t range = uint64_t(hi - lo) + 1;
+    if (range == 0)
+      return lo + size_t((*this)());
+
+    // Reject the lowest (2^64 mod range) values, so that every remainder is
+    // equally likely.
+    const uint64_t threshold = (0 - range) % range;
+    uint64_t r;
+    do
+    {
+      r = (*this)();
+    }
+    while (r < threshold);
+
+    return lo + size_t(r % range);
+  }
+
+  /**
+   * Fill a dense matrix or cube with numbers uniformly distributed in [0, 1).
+   *
+   * @param x Matrix or cube to fill.
+   */
+  template<typename MatType>
+  void Randu(MatType& x)
+  {
+    typedef typename MatType::elem_type ElemType;
+
+    ElemType* values = x.memptr();
+    for (size_t i = 0; i < x.n_elem; ++i)
+      values[i] = ElemType(Randu());
+  }
+
+  /**
+   * Fill a dense matrix or cube with numbers from the standard normal
+   * distribution.  Pairs of numbers are drawn with the Box-Muller transform.
+   *
+   * @param x Matrix or cube to fill.
+   */
+  template<typename MatType>
+  void Randn(MatType& x)
+  {
+    typedef typename MatType::elem_type ElemType;
+
+    ElemType* values = x.memptr();
+    const size_t pairs = x.n_elem / 2;
+    for (size_t i = 0; i < pairs; ++i)
+    {
+      // 1 - Randu() is in (0, 1], so the logarithm is finite.
+      const double radius = std::sqrt(-2.0 * std::log(1.0 - Randu()));
+      const double angle = 6.283185307179586 * Randu();
+      values[2 * i] = ElemType(radius * std::cos(angle));
+      values[2 * i + 1] = ElemType(radius * std::sin(angle));
+    }
+
+    if (x.n_elem % 2 == 1)
+      values[x.n_elem - 1] = ElemType(Randn());
+  }
+
+  /**
+   * Fill a dense matrix or cube with integers uniformly distributed in
+   * [lo, hi] (both included).
+   *
+   * @param x Matrix or cube to fill.
+   * @param lo Smallest number to draw.
+   * @param hi Largest number to draw.
+   */
+  template<typename MatType>
+  void Randi(MatType& x, const size_t lo, const size_t hi)
+  {
+    typedef typename MatType::elem_type ElemType;
+
+    ElemType* values = x.memptr();
+    for (size_t i = 0; i < x.n_elem; ++i)
+      values[i] = ElemType(Randi(lo, hi));
+  }
+
+ private:
+  //! Rotate the bits of x left by k positions.
+  static uint64_t RotateLeft(const uint64_t x, const int k)
+  {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  //! The state of the generator.
+  uint64_t state[4];
+  //! Whether the second number of the last pair drawn by Randn() is unused.
+  bool hasSpareNormal;
+  //! The second number of the last pair drawn by Randn().
+  double spareNormal;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,268 @@
+/**
+ * @file serialization.hpp
+ *
+ * A compact binary archive for saving the state of optimizers and their
+ * policies, so that an optimization can be checkpointed and resumed.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_SERIALIZATION_HPP
+#define ENSMALLEN_UTILITY_SERIALIZATION_HPP
+
+#include <fstream>
+#include <type_traits>
+#include <vector>
+
+namespace ens {
+
+class BinaryArchive;
+
+namespace traits {
+
+//! Detect a Serialize(BinaryArchive&) method.
+template<typename T>
+struct HasSerialize
+{
+  template<typename U>
+  static std::true_type Check(decltype(std::declval<U&>().Serialize(
+      std::declval<BinaryArchive&>()))*);
+
+  template<typename U>
+  static std::false_type Check(...);
+
+  const static bool value = decltype(Check<T>(0))::value;
+};
+
+} // namespace traits
+
+/**
+ * BinaryArchive saves or loads the state of objects in a compact binary
+ * format.  A class is made serializable by giving it a method
+ *
+ * @code
+ * void Serialize(BinaryArchive& ar)
+ * {
+ *   ar(member1);
+ *   ar(member2);
+ * }
+ * @endcode
+ *
+ * which is used both to save and to load: each call to ar() writes the given
+ * value when saving, and reads it back into the value when loading.  Numbers,
+ * Armadillo dense matrices and cubes, std::vector, and classes with a
+ * Serialize() method can be given to ar().  Values are stored in the native
+ * byte order, so an archive can only be loaded on a machine with the same
+ * endianness and type sizes; the sizes of numbers and matrix elements are
+ * checked when loading.  A std::runtime_error is thrown if the stream fails or
+ * the archive does not match what is loaded.
+ *
+ * SaveState() and LoadState() write and read a whole archive (with a header)
+ * for one object.
+ */
+class BinaryArchive
+{
+ public:
+  //! Create an archive that saves into the given stream.
+  BinaryArchive(std::ostream& stream) : output(&stream), input(NULL) { }
+
+  //! Create an archive that loads from the given stream.
+  BinaryArchive(std::istream& stream) : output(NULL), input(&stream) { }
+
+  //! Return whether the archive loads (rather than saves) the values.
+  bool Loading() const { return input != NULL; }
+
+  //! Save or load a number.
+  template<typename T>
+  typename std::enable_if<std::is_arithmetic<T>::value>::type
+  operator()(T& value)
+  {
+    CheckSize(sizeof(T));
+    Bytes(&value, sizeof(T));
+  }
+
+  //! Save or load a dense Armadillo matrix (or vector).
+  template<typename eT>
+  void operator()(arma::Mat<eT>& matrix)
+  {
+    CheckSize(sizeof(eT));
+    size_t rows = matrix.n_rows, cols = matrix.n_cols;
+    Size(rows);
+    Size(cols);
+    if (Loading())
+      matrix.set_size(rows, cols);
+
+    Bytes(matrix.memptr(), matrix.n_elem * sizeof(eT));
+  }
+
+  //! Save or load a dense Armadillo cube.
+  template<typename eT>
+  void operator()(arma::Cube<eT>& cube)
+  {
+    CheckSize(sizeof(eT));
+    size_t rows = cube.n_rows, cols = cube.n_cols, slices = cube.n_slices;
+    Size(rows);
+    Size(cols);
+    Size(slices);
+    if (Loading())
+      cube.set_size(rows, cols, slices);
+
+    Bytes(cube.memptr(), cube.n_elem * sizeof(eT));
+  }
+
+  //! Save or load a vector of serializable values.
+  template<typename T>
+  void operator()(std::vector<T>& values)
+  {
+    size_t size = values.size();
+    Size(size);
+    if (Loading())
+      values.resize(size);
+
+    for (size_t i = 0; i < size; ++i)
+    {
+      T value = values[i];
+      (*this)(value);
+      values[i] = value;
+    }
+  }
+
+  //! Save or load an object with a Serialize() method.
+  template<typename T>
+  typename std::enable_if<traits::HasSerialize<T>::value>::type
+  operator()(T& object)
+  {
+    object.Serialize(*this);
+  }
+
+  /**
+   * Save a size, or load a size into the given value.  Sizes are stored as 64
+   * bit integers.
+   *
+   * @param size Size to save or load.
+   */
+  void Size(size_t& size)
+  {
+    uint64_t value = size;
+    Bytes(&value, sizeof(value));
+    size = value;
+  }
+
+  /**
+   * Save a size, or load a size and check that it is the given one.
+   *
+   * @param size Expected size.
+   */
+  void CheckSize(const size_t size)
+  {
+    size_t value = size;
+    Size(value);
+    if (value != size)
+    {
+      std::ostringstream oss;
+      oss << "BinaryArchive: loaded size " << value << " does not match the "
+          << "expected size " << size << "!";
+      throw std::runtime_error(oss.str());
+    }
+  }
+
+ private:
+  //! Write or read the given bytes.
+  void Bytes(void* data, const size_t bytes)
+  {
+    if (Loading())
+      input->read(static_cast<char*>(data), bytes);
+    else
+      output->write(static_cast<const char*>(data), bytes);
+
+    if ((Loading() && !*input) || (!Loading() && !*output))
+      throw std::runtime_error("BinaryArchive: stream error!");
+  }
+
+  //! The stream saved into (NULL when loading).
+  std::ostream* output;
+  //! The stream loaded from (NULL when saving).
+  std::istream* input;
+};
+
+//! Magic number at the start of the archives written by SaveState().
+static const uint64_t stateArchiveMagic = 0x31534e45544154ULL;
+
+/**
+ * Save the state of the given object into the given stream.
+ *
+ * @param stream Stream to save into.
+ * @param object Object to save (it is not modified).
+ */
+template<typename T>
+void SaveState(std::ostream& stream, const T& object)
+{
+  BinaryArchive ar(stream);
+  size_t magic = stateArchiveMagic;
+  ar.Size(magic);
+  ar(const_cast<T&>(object));
+}
+
+/**
+ * Load the state of the given object from the given stream, written by
+ * SaveState().
+ *
+ * @param stream Stream to load from.
+ * @param object Object to load into.
+ */
+template<typename T>
+void LoadState(std::istream& stream, T& object)
+{
+  BinaryArchive ar(stream);
+  size_t magic;
+  ar.Size(magic);
+  if (magic != stateArchiveMagic)
+    throw std::runtime_error("LoadState(): the stream is not a state archive!");
+
+  ar(object);
+}
+
+/**
+ * Save the state of the given object into the given file.
+ *
+ * @param filename Name of the file to save into.
+ * @param object Object to save (it is not modified).
+ */
+template<typename T>
+void SaveState(const std::string& filename, const T& object)
+{
+  std::ofstream stream(filename.c_str(), std::ios::binary);
+  if (!stream.is_open())
+  {
+    throw std::runtime_error("SaveState(): cannot open file '" + filename +
+        "'!");
+  }
+
+  SaveState(static_cast<std::ostream&>(stream), object);
+}
+
+/**
+ * Load the state of the given object from the given file, written by
+ * SaveState().
+ *
+ * @param filename Name of the file to load from.
+ * @param object Object to load into.
+ */
+template<typename T>
+void LoadState(const std::string& filename, T& object)
+{
+  std::ifstream stream(filename.c_str(), std::ios::binary);
+  if (!stream.is_open())
+  {
+    throw std::runtime_error("LoadState(): cannot open file '" + filename +
+        "'!");
+  }
+
+  LoadState(static_cast<std::istream&>(stream), object);
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,227 @@
+/**
+ * @file thread_budget.hpp
+ *
+ * The budget of threads that the parallel loops of the optimizers share with
+ * the threads of BLAS (or of the function) inside each task.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_THREAD_BUDGET_HPP
+#define ENSMALLEN_UTILITY_THREAD_BUDGET_HPP
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+namespace ens {
+
+/**
+ * A ThreadBudget splits a number of threads (by default, all the cores)
+ * between the outer parallelism of the optimizers (the offspring of a
+ * population, the starts of MultiStart, the shards of a batch, ...) and the
+ * inner threads that each of their tasks may use, typically in BLAS calls
+ * made by the function.  Without a budget, a parallel loop of ensmallen on
+ * every core that calls a multithreaded BLAS in each task starts cores^2
+ * threads, which can be slower than evaluating the tasks serially.
+ *
+ * A parallel loop of the default executor runs its tasks on k threads, at
+ * most OuterThreads() if it is set (the OpenMP and std::thread executors start
+ * no more threads; the function of a custom executor is not limited, but the
+ * work of the loops is split for k threads), and gives each task
+ * InnerThreads(k) = TotalThreads() / k threads:
+ *
+ *  - the function given to SetInnerThreads() (for instance one that calls
+ *    openblas_set_num_threads() or mkl_set_num_threads()) is called with that
+ *    number before the tasks start, and with TotalThreads() once the loop is
+ *    done, so that the rest of the optimization (for instance the covariance
+ *    decomposition of CMAES) uses all the threads in BLAS again; the function
+ *    is only called when the number changes;
+ *
+ *  - with OpenMP and OuterThreads() set, the parallel regions inside a task
+ *    (for instance those of Armadillo, when it uses OpenMP) run on that many
+ *    threads, instead of serially.
+ *
+ * The phases of a program can change the split with a Phase, which sets the
+ * outer threads of the budget for its lifetime:
+ *
+ * @code
+ * // Evaluate 4 offspring at a time, each with 4 BLAS threads on 16 cores.
+ * ens::DefaultThreadBudget() = ens::ThreadBudget(16, 0,
+ *     [](const size_t n) { openblas_set_num_threads((int) n); });
+ * {
+ *   ens::ThreadBudget::Phase phase(ens::DefaultThreadBudget(), 4);
+ *   cmaes.Optimize(f, coordinates);
+ * }
+ * @endcode
+ *
+ * The budget is shared by all the threads of the program, so it should only
+ * be changed while no optimization runs.
+ */
+class ThreadBudget
+{
+ public:
+  //! The type of the function that sets the number of inner threads.
+  typedef std::function<void(size_t)> SetThreadsType;
+
+  /**
+   * Create a thread budget.
+   *
+   * @param totalThreads Number of threads to split (0 means the number of
+   *     OpenMP threads, or of hardware threads without OpenMP).
+   * @param outerThreads Maximum number of threads of the parallel loops of the
+   *     optimizers (0 means no limit but the executor's).
+   * @param setInnerThreads Function called with the number of threads that
+   *     BLAS (or the function) may use in each task (empty to call nothing).
+   */
+  ThreadBudget(const size_t totalThreads = 0,
+               const size_t outerThreads = 0,
+               SetThreadsType setInnerThreads = SetThreadsType()) :
+      totalThreads(totalThreads),
+      outerThreads(outerThreads),
+      setInnerThreads(std::move(setInnerThreads)),
+      appliedThreads(0)
+  { /* Nothing to do. */ }
+
+  //! Copy the budget (the copy calls the function to set the inner threads
+  //! again the first time).
+  ThreadBudget(const ThreadBudget& other) :
+      totalThreads(other.totalThreads),
+      outerThreads(other.outerThreads),
+      setInnerThreads(other.setInnerThreads),
+      appliedThreads(0)
+  { /* Nothing to do. */ }
+
+  //! Copy the given budget.
+  ThreadBudget& operator=(const ThreadBudget& other)
+  {
+    totalThreads = other.totalThreads;
+    outerThreads = other.outerThreads;
+    setInnerThreads = other.setInnerThreads;
+    appliedThreads = 0;
+    return *this;
+  }
+
+  /**
+   * The Phase sets the outer threads of a budget for its lifetime, and then
+   * restores the previous value.
+   */
+  class Phase
+  {
+   public:
+    /**
+     * Set the outer threads of the given budget.
+     *
+     * @param budget The budget to change.
+     * @param outerThreads Maximum number of threads of the parallel loops
+     *     (0 means no limit).
+     */
+    Phase(ThreadBudget& budget, const size_t outerThreads) :
+        budget(budget),
+        previous(budget.OuterThreads())
+    {
+      budget.OuterThreads() = outerThreads;
+    }
+
+    //! Restore the previous outer threads of the budget.
+    ~Phase() { budget.OuterThreads() = previous; }
+
+   private:
+    //! The budget that is changed.
+    ThreadBudget& budget;
+    //! The previous outer threads of the budget.
+    size_t previous;
+  };
+
+  //! Get the number of threads to split (resolving 0).
+  size_t TotalThreads() const
+  {
+    if (totalThreads != 0)
+      return totalThreads;
+
+    #ifdef ENS_USE_OPENMP
+      return std::max((size_t) omp_get_max_threads(), (size_t) 1);
+    #else
+      return std::max((size_t) std::thread::hardware_concurrency(),
+          (size_t) 1);
+    #endif
+  }
+  //! Modify the number of threads to split (0 means all of them).
+  size_t& TotalThreads() { return totalThreads; }
+
+  //! Get the maximum number of outer threads (0 means no limit).
+  size_t OuterThreads() const { return outerThreads; }
+  //! Modify the maximum number of outer threads (0 means no limit).
+  size_t& OuterThreads() { return outerThreads; }
+
+  //! Get the function that sets the number of inner threads.
+  const SetThreadsType& SetInnerThreads() const { return setInnerThreads; }
+  //! Modify the function that sets the number of inner threads.
+  SetThreadsType& SetInnerThreads() { return setInnerThreads; }
+
+  /**
+   * Get the number of threads a parallel loop may run its tasks on, given the
+   * number of threads available to it.
+   *
+   * @param available Number of threads of the executor.
+   */
+  size_t LimitOuterThreads(const size_t available) const
+  {
+    return (outerThreads == 0) ? available : std::min(available, outerThreads);
+  }
+
+  /**
+   * Get the number of threads each task of a loop with the given number of
+   * threads may use.
+   *
+   * @param outer Number of threads of the loop.
+   */
+  size_t InnerThreads(const size_t outer) const
+  {
+    return std::max(TotalThreads() / std::max(outer, (size_t) 1), (size_t) 1);
+  }
+
+  /**
+   * Call the function that sets the number of inner threads for a loop with
+   * the given number of threads (1 for the serial parts between the loops),
+   * if the number changed since the last call.
+   *
+   * @param outer Number of threads of the loop.
+   */
+  void Apply(const size_t outer)
+  {
+    if (!setInnerThreads)
+      return;
+
+    const size_t inner = InnerThreads(outer);
+    if (appliedThreads.exchange(inner) != inner)
+      setInnerThreads(inner);
+  }
+
+ private:
+  //! The number of threads to split (0 means all of them).
+  size_t totalThreads;
+  //! The maximum number of outer threads (0 means no limit).
+  size_t outerThreads;
+  //! The function that sets the number of inner threads.
+  SetThreadsType setInnerThreads;
+  //! The number of inner threads last set (0 if none).
+  std::atomic<size_t> appliedThreads;
+};
+
+/**
+ * Get the thread budget that the parallel loops of the optimizers use.  By
+ * default, it has no limit on the outer threads and does not set any inner
+ * threads, so the loops behave as without a budget.
+ */
+inline ThreadBudget& DefaultThreadBudget()
+{
+  static ThreadBudget budget;
+  return budget;
+}
+
+} // namespace ens
+
+#endif
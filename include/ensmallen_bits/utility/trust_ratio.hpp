@@ -0,0 +1,82 @@
+/**
+ * @file trust_ratio.hpp
+ *
+ * Partition of a matrix into the blocks that layer-wise adaptive update
+ * policies (LARS, LAMB) compute their trust ratios over.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_TRUST_RATIO_HPP
+#define ENSMALLEN_UTILITY_TRUST_RATIO_HPP
+
+#include <algorithm>
+#include <cmath>
+
+namespace ens {
+
+/**
+ * Call block(firstRow, firstCol, lastRow, lastCol) for each block of a
+ * rows x cols matrix, where the blocks have blockRows rows and blockCols
+ * columns (except at the last rows and columns, where they are cut); a block
+ * size of 0 means the whole dimension.  For instance, blockRows = 0 and
+ * blockCols = 1 makes each column a block, which is one layer when each
+ * column holds the weights of one layer.
+ *
+ * @param rows Number of rows of the matrix.
+ * @param cols Number of columns of the matrix.
+ * @param blockRows Number of rows of a block (0 for all).
+ * @param blockCols Number of columns of a block (0 for all).
+ * @param block Function to call with the bounds of each block.
+ */
+template<typename BlockFunctionType>
+inline void ForEachBlock(const size_t rows,
+                         const size_t cols,
+                         const size_t blockRows,
+                         const size_t blockCols,
+                         BlockFunctionType&& block)
+{
+  const size_t stepRows = (blockRows == 0) ? rows : blockRows;
+  const size_t stepCols = (blockCols == 0) ? cols : blockCols;
+  for (size_t c = 0; c < cols; c += stepCols)
+  {
+    for (size_t r = 0; r < rows; r += stepRows)
+    {
+      block(r, c, std::min(r + stepRows, rows) - 1,
+          std::min(c + stepCols, cols) - 1);
+    }
+  }
+}
+
+/**
+ * Get the Frobenius norm of the given block of a matrix, without copying it.
+ */
+template<typename MatType>
+inline double BlockNorm(const MatType& x,
+                        const size_t firstRow,
+                        const size_t firstCol,
+                        const size_t lastRow,
+                        const size_t lastCol)
+{
+  return std::sqrt((double) arma::accu(arma::square(x.submat(firstRow,
+      firstCol, lastRow, lastCol))));
+}
+
+/**
+ * Get the trust ratio of a block with the given weight and update norms:
+ * coefficient * weightNorm / updateNorm, or 1 if either norm is zero (so that
+ * blocks initialized at zero, such as biases, still move).
+ */
+inline double TrustRatio(const double weightNorm,
+                         const double updateNorm,
+                         const double coefficient = 1.0)
+{
+  return (weightNorm > 0.0 && updateNorm > 0.0) ?
+      coefficient * weightNorm / updateNorm : 1.0;
+}
+
+} // namespace ens
+
+#endif
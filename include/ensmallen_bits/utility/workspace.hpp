@@ -0,0 +1,102 @@
+/**
+ * @file workspace.hpp
+ *
+ * A set of buffers that optimizers can reuse across calls to Optimize().
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_WORKSPACE_HPP
+#define ENSMALLEN_UTILITY_WORKSPACE_HPP
+
+#include <map>
+
+#include "any.hpp"
+
+namespace ens {
+
+/**
+ * Workspace holds the temporaries of an optimizer (gradients, search
+ * directions, histories), so that repeated calls to Optimize() with iterates
+ * of the same size do not allocate them again.  Each temporary lives in a
+ * numbered slot and is created on first use; after that, resizing it to the
+ * same size (with set_size() or zeros()) keeps its memory.
+ *
+ * An optimizer uses a workspace only if one is given to it, for instance:
+ *
+ * @code
+ * ens::Workspace workspace;
+ * ens::L_BFGS lbfgs;
+ * lbfgs.Workspace() = &workspace;
+ * for (size_t i = 0; i < 1000; ++i)
+ *   lbfgs.Optimize(f, coordinates); // No allocations after the first call.
+ * @endcode
+ *
+ * The contents of the buffers are not kept: every optimizer initializes the
+ * temporaries it takes from the workspace.  So, a workspace may be shared by
+ * several optimizers, as long as they are not running at the same time (in
+ * particular, each thread needs its own workspace).  Copies of a workspace are
+ * empty.
+ */
+class Workspace
+{
+ public:
+  //! Create an empty workspace.
+  Workspace() : created(0) { }
+
+  //! Copying a workspace gives an empty workspace.
+  Workspace(const Workspace& /* other */) : created(0) { }
+
+  //! Copying a workspace gives an empty workspace.
+  Workspace& operator=(const Workspace& other)
+  {
+    if (this != &other)
+      Clear();
+
+    return *this;
+  }
+
+  /**
+   * Get the temporary of type T in the given slot; if the slot is empty or
+   * holds another type, a new default-constructed T is put there.
+   *
+   * @param slot Number of the slot.
+   * @return The temporary in the slot.
+   */
+  template<typename T>
+  T& Get(const size_t slot)
+  {
+    Any& any = slots[slot];
+    if (!any.Has<T>())
+    {
+      any.Set(new T());
+      ++created;
+    }
+
+    return any.As<T>();
+  }
+
+  //! Destroy all the temporaries.
+  void Clear() { slots.clear(); }
+
+  //! Get the number of slots in use.
+  size_t Size() const { return slots.size(); }
+
+  //! Get the number of temporaries that were created (for instance, to check
+  //! that a warm loop does not create any).
+  size_t Created() const { return created; }
+
+ private:
+  //! The temporaries, by slot.  (Map nodes never move, so the held objects are
+  //! not affected by the creation of other slots.)
+  std::map<size_t, Any> slots;
+
+  //! Number of temporaries created.
+  size_t created;
+};
+
+} // namespace ens
+
+#endif
@@ -37,41 +37,64 @@ class WNGradUpdate
   /**
    * Construct the WNGrad update policy.
    */
-  WNGradUpdate() : b(1.0)
+  WNGradUpdate()
   {
     // Nothing to do here.
   }
 
-  /**
-   * The Initialize method is called by SGD Optimizer method before the start of
-   * the iteration update process.
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
-   */
-  void Initialize(const size_t /* rows */, const size_t /* cols */)
+  //! WNGrad only keeps a scalar; this returns 0 for any iterate.
+  size_t EstimateStateBytes(const size_t /* rows */,
+                            const size_t /* cols */,
+                            const size_t /* elemSize */ = sizeof(double)) const
   {
-    // Nothing to do here.
+    return 0;
   }
 
   /**
-   * Update step for WNGrad.
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
    */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
+  template<typename MatType, typename GradType>
+  class Policy
   {
-    b += std::pow(stepSize, 2.0) / b * std::pow(arma::norm(gradient), 2);
-    iterate -= stepSize * gradient / b;
-  }
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const WNGradUpdate& /* parent */,
+           const size_t /* rows */,
+           const size_t /* cols */) :
+        b(1.0)
+    {
+      // Nothing to do here.
+    }
+
+    /**
+     * Update step for WNGrad.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      b += std::pow(stepSize, 2.0) / b * std::pow(arma::norm(gradient), 2);
+      iterate -= stepSize * gradient / b;
+    }
 
- private:
-  //! Learning rate adjustment.
-  double b;
+   private:
+    //! Learning rate adjustment.
+    double b;
+  };
 };
 
 } // namespace ens
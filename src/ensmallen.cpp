@@ -0,0 +1,13 @@
+/**
+ * @file ensmallen.cpp
+ *
+ * The compiled part of the optional ensmallen library: the explicit
+ * instantiations declared in ensmallen_bits/extern_templates.hpp.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#define ENS_INSTANTIATE_TEMPLATES
+#include <ensmallen.hpp>
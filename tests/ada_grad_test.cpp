@@ -57,3 +57,45 @@ TEST_CASE("AdaGradLogisticRegressionTest", "[AdaGradTest]")
       coordinates);
   REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
 }
+
+/**
+ * Make sure that the AdaGrad update for sparse gradients gives the same
+ * iterates as the dense update.
+ */
+TEST_CASE("AdaGradSparseUpdateTest", "[AdaGradTest]")
+{
+  AdaGradUpdate update(1e-8);
+  AdaGradUpdate::Policy<arma::mat, arma::mat> densePolicy(update, 20, 5);
+  AdaGradUpdate::Policy<arma::mat, arma::sp_mat> sparsePolicy(update, 20, 5);
+
+  arma::mat denseIterate(20, 5, arma::fill::randu);
+  arma::mat sparseIterate(denseIterate);
+  for (size_t i = 0; i < 100; ++i)
+  {
+    const arma::sp_mat gradient = arma::sprandn<arma::sp_mat>(20, 5, 0.05);
+    densePolicy.Update(denseIterate, 0.1, arma::mat(gradient));
+    sparsePolicy.Update(sparseIterate, 0.1, gradient);
+  }
+
+  for (size_t i = 0; i < denseIterate.n_elem; ++i)
+    REQUIRE(sparseIterate[i] == Approx(denseIterate[i]).margin(1e-10));
+}
+
+/**
+ * Run AdaGrad with sparse gradients on a function where each point only
+ * touches one coordinate.
+ */
+TEST_CASE("AdaGradSparseTestFunction", "[AdaGradTest]")
+{
+  SparseTestFunction f;
+  AdaGrad optimizer(0.5, 1, 1e-8, 500000, 1e-9, true);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  optimizer.Optimize<SparseTestFunction, arma::mat, arma::sp_mat>(f,
+      coordinates);
+
+  REQUIRE(coordinates[0] == Approx(2.0).epsilon(0.01));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(0.01));
+  REQUIRE(coordinates[2] == Approx(1.5).epsilon(0.01));
+  REQUIRE(coordinates[3] == Approx(4.0).epsilon(0.01));
+}
@@ -128,6 +128,207 @@ TEST_CASE("SimpleAdamTestFunction", "[AdamTest]")
   REQUIRE(coordinates[2] == Approx(0.0).margin(0.3));
 }
 
+/**
+ * Run the single-loop update of the given policy (used for dense matrices) and
+ * its Armadillo expression update (used for sparse gradients) side by side,
+ * and make sure they give the same iterates.
+ */
+template<typename UpdateType>
+void FusedUpdateTest(const UpdateType& update)
+{
+  typename UpdateType::template Policy<arma::mat, arma::mat> fusedPolicy(
+      update, 10, 3);
+  typename UpdateType::template Policy<arma::mat, arma::sp_mat>
+      expressionPolicy(update, 10, 3);
+
+  arma::mat fusedIterate(10, 3, arma::fill::randu);
+  arma::mat expressionIterate(fusedIterate);
+  for (size_t i = 0; i < 50; ++i)
+  {
+    const arma::mat gradient = arma::randn<arma::mat>(10, 3);
+    fusedPolicy.Update(fusedIterate, 0.01, gradient);
+    expressionPolicy.Update(expressionIterate, 0.01, arma::sp_mat(gradient));
+  }
+
+  for (size_t i = 0; i < fusedIterate.n_elem; ++i)
+  {
+    REQUIRE(fusedIterate[i] ==
+        Approx(expressionIterate[i]).epsilon(1e-10).margin(1e-12));
+  }
+}
+
+/**
+ * Make sure that the single-loop updates of the Adam family give the same
+ * results as their Armadillo expression forms.
+ */
+TEST_CASE("AdamFamilyFusedUpdateTest", "[AdamTest]")
+{
+  FusedUpdateTest(AdamUpdate());
+  FusedUpdateTest(AdaMaxUpdate());
+  FusedUpdateTest(AMSGradUpdate());
+  FusedUpdateTest(NadamUpdate());
+  FusedUpdateTest(NadaMaxUpdate());
+  FusedUpdateTest(OptimisticAdamUpdate());
+  FusedUpdateTest(AdamWUpdate(1e-8, 0.9, 0.999, 0.01));
+}
+
+/**
+ * Run the given update policy with separate and with interleaved state, and
+ * make sure both layouts give the same iterates.
+ */
+template<typename UpdateType>
+void InterleavedUpdateTest(UpdateType update)
+{
+  typename UpdateType::template Policy<arma::mat, arma::mat> separatePolicy(
+      update, 10, 3);
+  UpdateType interleavedUpdate(update);
+  interleavedUpdate.Interleaved() = true;
+  typename UpdateType::template Policy<arma::mat, arma::mat>
+      interleavedPolicy(interleavedUpdate, 10, 3);
+
+  arma::mat separateIterate(10, 3, arma::fill::randu);
+  arma::mat interleavedIterate(separateIterate);
+  for (size_t i = 0; i < 50; ++i)
+  {
+    const arma::mat gradient = arma::randn<arma::mat>(10, 3);
+    separatePolicy.Update(separateIterate, 0.01, gradient);
+    interleavedPolicy.Update(interleavedIterate, 0.01, gradient);
+  }
+
+  for (size_t i = 0; i < separateIterate.n_elem; ++i)
+  {
+    REQUIRE(interleavedIterate[i] ==
+        Approx(separateIterate[i]).epsilon(1e-10).margin(1e-12));
+  }
+}
+
+/**
+ * Make sure that storing the Adam, AMSGrad and SWATS state interleaved does
+ * not change the results.
+ */
+TEST_CASE("AdamInterleavedStateTest", "[AdamTest]")
+{
+  InterleavedUpdateTest(AdamUpdate());
+  InterleavedUpdateTest(AMSGradUpdate());
+  InterleavedUpdateTest(SWATSUpdate());
+}
+
+/**
+ * Checkpoint the given optimizer after some iterations, load the checkpoint
+ * into a fresh optimizer, and make sure that both continue with the same
+ * iterates.
+ */
+template<typename OptimizerType>
+void CheckpointResumeTest()
+{
+  SGDTestFunction f;
+  OptimizerType optimizer(1e-3, 1, 0.9, 0.999, 1e-8, 300, -1.0, false, false);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  optimizer.Optimize(f, coordinates);
+
+  std::stringstream stream;
+  SaveState(stream, optimizer);
+
+  OptimizerType resumed(1e-3, 1, 0.9, 0.999, 1e-8, 300, -1.0, false, false);
+  LoadState(stream, resumed);
+
+  arma::mat resumedCoordinates(coordinates);
+  optimizer.Optimize(f, coordinates);
+  resumed.Optimize(f, resumedCoordinates);
+
+  for (size_t i = 0; i < coordinates.n_elem; ++i)
+    REQUIRE(resumedCoordinates[i] == Approx(coordinates[i]).epsilon(1e-12));
+}
+
+/**
+ * Make sure that the optimizers of the Adam family can be checkpointed and
+ * resumed.
+ */
+TEST_CASE("AdamCheckpointResumeTest", "[AdamTest]")
+{
+  CheckpointResumeTest<Adam>();
+  CheckpointResumeTest<AdaMax>();
+  CheckpointResumeTest<AMSGrad>();
+  CheckpointResumeTest<LAMB>();
+  CheckpointResumeTest<Nadam>();
+  CheckpointResumeTest<NadaMax>();
+  CheckpointResumeTest<OptimisticAdam>();
+}
+
+/**
+ * Make sure that loading a stream that is not a state archive throws.
+ */
+TEST_CASE("AdamLoadInvalidStateTest", "[AdamTest]")
+{
+  std::stringstream stream;
+  stream << "this is not a state archive";
+
+  Adam optimizer;
+  REQUIRE_THROWS_AS(LoadState(stream, optimizer), std::runtime_error);
+}
+
+/**
+ * Make sure that the LazyAdam update gives the same iterates as Adam when
+ * every coordinate of the sparse gradient is nonzero.
+ */
+TEST_CASE("LazyAdamDenseGradientTest", "[AdamTest]")
+{
+  AdamUpdate update;
+  LazyAdamUpdate lazyUpdate;
+  AdamUpdate::Policy<arma::mat, arma::mat> densePolicy(update, 10, 3);
+  LazyAdamUpdate::Policy<arma::mat, arma::sp_mat> lazyPolicy(lazyUpdate, 10,
+      3);
+
+  arma::mat denseIterate(10, 3, arma::fill::randu);
+  arma::mat lazyIterate(denseIterate);
+  for (size_t i = 0; i < 100; ++i)
+  {
+    const arma::mat gradient = arma::randu<arma::mat>(10, 3) + 0.1;
+    densePolicy.Update(denseIterate, 0.01, gradient);
+    lazyPolicy.Update(lazyIterate, 0.01, arma::sp_mat(gradient));
+  }
+
+  for (size_t i = 0; i < denseIterate.n_elem; ++i)
+    REQUIRE(lazyIterate[i] == Approx(denseIterate[i]).margin(1e-10));
+}
+
+/**
+ * Run LazyAdam with sparse gradients on a function where each point only
+ * touches one coordinate.
+ */
+TEST_CASE("LazyAdamSparseTestFunction", "[AdamTest]")
+{
+  SparseTestFunction f;
+  LazyAdam optimizer(1e-2, 1, 0.9, 0.999, 1e-8, 500000, 1e-9, true);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  optimizer.Optimize<SparseTestFunction, arma::mat, arma::sp_mat>(f,
+      coordinates);
+
+  REQUIRE(coordinates[0] == Approx(2.0).margin(0.1));
+  REQUIRE(coordinates[1] == Approx(1.0).margin(0.1));
+  REQUIRE(coordinates[2] == Approx(1.5).margin(0.1));
+  REQUIRE(coordinates[3] == Approx(4.0).margin(0.1));
+}
+
+/**
+ * Tests the Adam optimizer using a simple test function and single-precision
+ * coordinates.
+ */
+TEST_CASE("SimpleAdamTestFunctionFMat", "[AdamTest]")
+{
+  SGDTestFunction f;
+  Adam optimizer(1e-3, 1, 0.9, 0.999, 1e-8, 500000, 1e-9, true);
+
+  arma::fmat coordinates = f.GetInitialPoint<arma::fmat>();
+  optimizer.Optimize(f, coordinates);
+
+  REQUIRE(coordinates[0] == Approx(0.0).margin(0.3));
+  REQUIRE(coordinates[1] == Approx(0.0).margin(0.3));
+  REQUIRE(coordinates[2] == Approx(0.0).margin(0.3));
+}
+
 /**
  * Tests the AdaMax optimizer using a simple test function.
  */
@@ -185,6 +386,34 @@ TEST_CASE("AdamLogisticRegressionTest", "[AdamTest]")
   REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
 }
 
+/**
+ * Run LAMB on logistic regression with large batches and make sure the results
+ * are acceptable.
+ */
+TEST_CASE("LAMBLogisticRegressionTest", "[AdamTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  LAMB lamb(0.01, 500, 0.9, 0.999, 1e-8, 1000000, -1.0, true);
+  REQUIRE(lamb.UpdatePolicy().WeightDecay() == 0.01);
+
+  arma::mat coordinates = lr.GetInitialPoint();
+  lamb.Optimize(lr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
 /**
  * Run AdaMax on logistic regression and make sure the results are acceptable.
  */
@@ -457,3 +686,162 @@ TEST_CASE("AdamWLogisticRegressionTest", "[AdamTest]")
       coordinates);
   REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
 }
+
+/**
+ * Make sure that Adam and AdamW with their state stored as floats give nearly
+ * the same iterates as the full precision updates, with half the state.
+ */
+TEST_CASE("ReducedPrecisionAdamFloat32Test", "[AdamTest]")
+{
+  AdamUpdate update;
+  AdamWUpdate wUpdate(1e-8, 0.9, 0.999, 0.01);
+  ReducedPrecisionAdamUpdate<Float32State> reducedUpdate;
+  ReducedPrecisionAdamUpdate<Float32State> reducedWUpdate(1e-8, 0.9, 0.999,
+      0.01);
+
+  AdamUpdate::Policy<arma::mat, arma::mat> policy(update, 300, 3);
+  AdamWUpdate::Policy<arma::mat, arma::mat> wPolicy(wUpdate, 300, 3);
+  ReducedPrecisionAdamUpdate<Float32State>::Policy<arma::mat, arma::mat>
+      reducedPolicy(reducedUpdate, 300, 3);
+  ReducedPrecisionAdamUpdate<Float32State>::Policy<arma::mat, arma::mat>
+      reducedWPolicy(reducedWUpdate, 300, 3);
+
+  arma::mat iterate(300, 3, arma::fill::randu);
+  arma::mat wIterate(iterate), reducedIterate(iterate),
+      reducedWIterate(iterate);
+  for (size_t i = 0; i < 50; ++i)
+  {
+    const arma::mat gradient = arma::randn<arma::mat>(300, 3);
+    policy.Update(iterate, 0.01, gradient);
+    wPolicy.Update(wIterate, 0.01, gradient);
+    reducedPolicy.Update(reducedIterate, 0.01, gradient);
+    reducedWPolicy.Update(reducedWIterate, 0.01, gradient);
+  }
+
+  for (size_t i = 0; i < iterate.n_elem; ++i)
+  {
+    REQUIRE(reducedIterate[i] == Approx(iterate[i]).margin(1e-5));
+    REQUIRE(reducedWIterate[i] == Approx(wIterate[i]).margin(1e-5));
+  }
+
+  REQUIRE(reducedPolicy.StateBytes() == 2 * 900 * sizeof(float));
+}
+
+/**
+ * Run Adam with its state stored as the given type on logistic regression and
+ * make sure the results are acceptable.
+ */
+template<typename StateType>
+void ReducedPrecisionAdamLogisticRegressionTest()
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  ReducedPrecisionAdam<StateType> adam;
+  arma::mat coordinates = lr.GetInitialPoint();
+  adam.Optimize(lr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+/**
+ * Run Adam with bfloat16, half precision and 8-bit state on logistic
+ * regression.
+ */
+TEST_CASE("ReducedPrecisionAdamLogisticRegressionTest", "[AdamTest]")
+{
+  ReducedPrecisionAdamLogisticRegressionTest<BFloat16State>();
+  ReducedPrecisionAdamLogisticRegressionTest<Float16State>();
+  ReducedPrecisionAdamLogisticRegressionTest<BlockQuantized8State>();
+}
+
+/**
+ * Make sure that the reduced precision states round trip representable
+ * values, and round the others to within their precision.
+ */
+TEST_CASE("ReducedPrecisionStateTest", "[AdamTest]")
+{
+  const float values[] = { 0.0f, 1.0f, -2.5f, 0.1f, -3e-5f, 1e-7f, 1000.0f,
+      -65504.0f };
+  float decoded[8];
+
+  BFloat16State bf16;
+  bf16.Zeros(8);
+  bf16.Encode(0, 8, values);
+  bf16.Decode(0, 8, decoded);
+  for (size_t i = 0; i < 8; ++i)
+    REQUIRE(decoded[i] == Approx(values[i]).epsilon(1.0 / 256));
+  REQUIRE(decoded[1] == 1.0f);
+  REQUIRE(decoded[2] == -2.5f);
+  REQUIRE(bf16.Bytes() == 16);
+
+  Float16State fp16;
+  fp16.Zeros(8);
+  fp16.Encode(0, 8, values);
+  fp16.Decode(0, 8, decoded);
+  for (size_t i = 0; i < 5; ++i)
+    REQUIRE(decoded[i] == Approx(values[i]).epsilon(1.0 / 2048).margin(1e-7));
+  REQUIRE(decoded[5] == Approx(1e-7).epsilon(0.5)); // Subnormal.
+  REQUIRE(decoded[6] == 1000.0f);
+  REQUIRE(decoded[7] == -65504.0f);
+
+  BlockQuantized8State q8;
+  q8.Zeros(8);
+  q8.Encode(0, 8, values);
+  q8.Decode(0, 8, decoded);
+  REQUIRE(decoded[0] == 0.0f);
+  REQUIRE(decoded[7] == -65504.0f);
+  for (size_t i = 1; i < 8; ++i)
+  {
+    // The companded magnitudes are rounded to the nearest multiple of 1/127.
+    const double t = std::pow(std::abs(values[i]) / 65504.0, 0.25);
+    const double decodedT = std::pow(std::abs(decoded[i]) / 65504.0, 0.25);
+    REQUIRE(std::abs(decodedT - t) <= 0.5 / 127 + 1e-6);
+    if (decoded[i] != 0.0f)
+      REQUIRE(std::signbit(decoded[i]) == std::signbit(values[i]));
+  }
+  REQUIRE(q8.Bytes() == 8 + sizeof(float));
+}
+
+/**
+ * Make sure that the memory estimates of the Adam variants add up the
+ * gradient and the state of their update policies.
+ */
+TEST_CASE("AdamEstimateMemoryTest", "[AdamTest]")
+{
+  const size_t n = 50 * 20;
+
+  // The gradient and the two moments, interleaved or not.
+  Adam adam;
+  REQUIRE(adam.EstimateMemory(50, 20) == 3 * n * sizeof(double));
+  adam.MicroBatchSize() = 4;
+  REQUIRE(adam.EstimateMemory(50, 20) == 4 * n * sizeof(double));
+  SGD<AdamUpdate> interleavedAdam(0.001, 32, 100000, 1e-5, true,
+      AdamUpdate(1e-8, 0.9, 0.999, true));
+  REQUIRE(interleavedAdam.EstimateMemory(50, 20) == 3 * n * sizeof(double));
+  REQUIRE(adam.EstimateMemory(n, 1, sizeof(float)) ==
+      4 * n * sizeof(float));
+
+  AMSGrad amsgrad;
+  REQUIRE(amsgrad.EstimateMemory(n) == 4 * n * sizeof(double));
+
+  // The reduced-precision moments do not depend on the element size.
+  ReducedPrecisionAdamUpdate<BFloat16State> bf16Update;
+  REQUIRE(bf16Update.EstimateStateBytes(50, 20) ==
+      2 * (n * 2 + 256 * sizeof(float)));
+  REQUIRE(BlockQuantized8State::BytesFor(100) == 100 + 2 * sizeof(float));
+
+  // Wrapped policies add their own state.
+  SGD<LookaheadUpdate<AdamUpdate>> lookahead;
+  REQUIRE(lookahead.EstimateMemory(n) == 4 * n * sizeof(double));
+}
@@ -0,0 +1,244 @@
+/**
+ * @file allocation_test.cpp
+ *
+ * Make sure that the steps of some optimizers do not allocate memory once the
+ * optimization is set up.  This test is built as a separate program, with
+ * ENS_COUNT_ALLOCATIONS defined and a counting global operator new, so that
+ * the other tests keep the default allocators.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <new>
+
+#include <ensmallen.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+using namespace ens;
+
+// Count the allocations of the standard library as well as the ones of
+// Armadillo.
+void* operator new(std::size_t bytes)
+{
+  CountAllocation();
+  void* memory = std::malloc((bytes == 0) ? 1 : bytes);
+  if (memory == NULL)
+    throw std::bad_alloc();
+  return memory;
+}
+
+void* operator new[](std::size_t bytes)
+{
+  return operator new(bytes);
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+
+void operator delete[](void* memory) noexcept { std::free(memory); }
+
+/**
+ * The generalized Rosenbrock function, whose terms are the separable
+ * functions, written with explicit loops so that it does not allocate itself:
+ * f_i(x) = 100 (x_{i + 1} - x_i^2)^2 + (1 - x_i)^2.
+ */
+class LoopRosenbrockFunction
+{
+ public:
+  LoopRosenbrockFunction(const size_t dimension) : dimension(dimension) { }
+
+  arma::mat GetInitialPoint() const
+  {
+    arma::mat point(dimension, 1);
+    for (size_t i = 0; i < dimension; ++i)
+      point[i] = (i % 2 == 0) ? -1.2 : 1.0;
+    return point;
+  }
+
+  size_t NumFunctions() const { return dimension - 1; }
+
+  void Shuffle() { }
+
+  double Evaluate(const arma::mat& x,
+                  const size_t begin,
+                  const size_t batchSize) const
+  {
+    double objective = 0.0;
+    for (size_t i = begin; i < begin + batchSize; ++i)
+    {
+      const double a = x[i + 1] - x[i] * x[i];
+      objective += 100.0 * a * a + (1.0 - x[i]) * (1.0 - x[i]);
+    }
+    return objective;
+  }
+
+  double EvaluateWithGradient(const arma::mat& x,
+                              const size_t begin,
+                              arma::mat& gradient,
+                              const size_t batchSize) const
+  {
+    // This only allocates if the gradient does not have the right size yet.
+    gradient.zeros(x.n_rows, x.n_cols);
+    double objective = 0.0;
+    for (size_t i = begin; i < begin + batchSize; ++i)
+    {
+      const double a = x[i + 1] - x[i] * x[i];
+      objective += 100.0 * a * a + (1.0 - x[i]) * (1.0 - x[i]);
+      gradient[i] += -400.0 * a * x[i] - 2.0 * (1.0 - x[i]);
+      gradient[i + 1] += 200.0 * a;
+    }
+    return objective;
+  }
+
+  double Evaluate(const arma::mat& x) const
+  {
+    return Evaluate(x, 0, NumFunctions());
+  }
+
+  double EvaluateWithGradient(const arma::mat& x, arma::mat& gradient) const
+  {
+    return EvaluateWithGradient(x, 0, gradient, NumFunctions());
+  }
+
+ private:
+  size_t dimension;
+};
+
+/**
+ * Run SGD with the given update policy on the Rosenbrock function, and make
+ * sure that no step after the first one allocates.
+ */
+template<typename UpdatePolicyType>
+void CheckSGDAllocations(const double stepSize)
+{
+  // Armadillo keeps matrices of up to 16 elements in the object itself, so the
+  // iterate must be larger for its copies to allocate at all.
+  LoopRosenbrockFunction f(100);
+  SGD<UpdatePolicyType> optimizer(stepSize, 1, 900, -1.0, true);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  AllocationTracker tracker;
+  optimizer.Optimize(f, coordinates, tracker);
+
+  REQUIRE(tracker.Allocations().size() == 900);
+  REQUIRE(tracker.MaxAllocations(1) == 0);
+}
+
+/**
+ * Make sure that the steps of SGD with VanillaUpdate do not allocate.
+ */
+TEST_CASE("VanillaUpdateAllocationTest", "[AllocationTest]")
+{
+  CheckSGDAllocations<VanillaUpdate>(1e-4);
+}
+
+/**
+ * Make sure that the steps of SGD with MomentumUpdate do not allocate.
+ */
+TEST_CASE("MomentumUpdateAllocationTest", "[AllocationTest]")
+{
+  CheckSGDAllocations<MomentumUpdate>(1e-4);
+}
+
+/**
+ * Make sure that the steps of SGD with AdamUpdate do not allocate.
+ */
+TEST_CASE("AdamUpdateAllocationTest", "[AllocationTest]")
+{
+  CheckSGDAllocations<AdamUpdate>(1e-3);
+}
+
+/**
+ * Make sure that the iterations of L-BFGS, including their line searches, do
+ * not allocate.
+ */
+TEST_CASE("LBFGSAllocationTest", "[AllocationTest]")
+{
+  // Large enough that the matrices of L-BFGS are not stored in the objects.
+  LoopRosenbrockFunction f(100);
+  L_BFGS optimizer;
+
+  arma::mat coordinates = f.GetInitialPoint();
+  AllocationTracker tracker;
+  optimizer.Optimize(f, coordinates, tracker);
+
+  REQUIRE(tracker.Allocations().size() > 10);
+  REQUIRE(tracker.MaxAllocations(1) == 0);
+}
+
+// Buffers of the test below; they are global, so that their allocations can't
+// be optimized away.
+std::vector<double> escapedBuffer;
+arma::mat escapedMatrix;
+
+/**
+ * Make sure that the allocations are counted at all, so that the tests above
+ * are not trivially true.
+ */
+TEST_CASE("AllocationCountTest", "[AllocationTest]")
+{
+  const size_t before = AllocationCount().load();
+  escapedBuffer.resize(1000);
+  const size_t afterVector = AllocationCount().load();
+
+  // Armadillo only allocates the memory of larger matrices.
+  escapedMatrix.set_size(100, 100);
+  const size_t afterMatrix = AllocationCount().load();
+
+  REQUIRE(afterVector == before + 1);
+  if (afterMatrix == afterVector)
+  {
+    WARN("This version of Armadillo does not support "
+        "ARMA_ALIEN_MEM_ALLOC_FUNCTION, so only operator new is counted.");
+  }
+  else
+  {
+    REQUIRE(afterMatrix == afterVector + 1);
+  }
+}
+
+/**
+ * Make sure that the peak of the bytes reported by AllocationTracker covers the
+ * memory estimates of the optimizers, and is not far above them.
+ */
+TEST_CASE("AllocationTrackerPeakBytesTest", "[AllocationTest]")
+{
+  const size_t before = AllocatedBytes().load();
+  escapedMatrix.set_size(200, 200);
+  if (AllocatedBytes().load() == before)
+  {
+    WARN("This version of Armadillo does not support "
+        "ARMA_ALIEN_MEM_ALLOC_FUNCTION, so no bytes are counted.");
+    return;
+  }
+  escapedMatrix.reset();
+  REQUIRE(AllocatedBytes().load() == before);
+
+  LoopRosenbrockFunction f(100);
+
+  Adam adam(1e-3, 1, 0.9, 0.999, 1e-8, 500, -1.0);
+  arma::mat coordinates = f.GetInitialPoint();
+  AllocationTracker adamTracker;
+  adam.Optimize(f, coordinates, adamTracker);
+
+  const size_t adamEstimate = adam.EstimateMemory(100);
+  REQUIRE(adamTracker.PeakBytes() >= adamEstimate);
+  REQUIRE(adamTracker.PeakBytes() <= 2 * adamEstimate);
+  REQUIRE(adamTracker.RetainedBytes() <= adamTracker.PeakBytes());
+
+  L_BFGS lbfgs;
+  lbfgs.MaxIterations() = 20;
+  coordinates = f.GetInitialPoint();
+  AllocationTracker lbfgsTracker;
+  lbfgs.Optimize(f, coordinates, lbfgsTracker);
+
+  const size_t lbfgsEstimate = lbfgs.EstimateMemory(100);
+  // Armadillo keeps small vectors like rho and alpha in the matrix objects,
+  // without allocating them.
+  REQUIRE(lbfgsTracker.PeakBytes() >= 0.9 * lbfgsEstimate);
+  REQUIRE(lbfgsTracker.PeakBytes() <= 2 * lbfgsEstimate);
+}
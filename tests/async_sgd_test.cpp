@@ -0,0 +1,74 @@
+/**
+ * @file async_sgd_test.cpp
+ *
+ * Test file for the AsyncSGD optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Run AsyncSGD on the sparse test function, with copies that are pulled
+ * before every gradient and with stale copies, and with one or several
+ * shards.
+ */
+TEST_CASE("AsyncSGDSparseTestFunctionTest", "[AsyncSGDTest]")
+{
+  SparseTestFunction f;
+
+  const size_t staleness[3] = { 0, 0, 16 };
+  const size_t shards[3] = { 1, 4, 2 };
+  for (size_t i = 0; i < 3; ++i)
+  {
+    AsyncSGD<ConstantStep> s(10000, 1, shards[i], staleness[i], 1e-5, true,
+        ConstantStep(0.4));
+
+    arma::mat coordinates = f.GetInitialPoint();
+    const double result = s.Optimize(f, coordinates);
+
+    REQUIRE(result == Approx(123.75).epsilon(0.0001));
+    REQUIRE(coordinates[0] == Approx(2.0).epsilon(0.0002));
+    REQUIRE(coordinates[1] == Approx(1.0).epsilon(0.0002));
+    REQUIRE(coordinates[2] == Approx(1.5).epsilon(0.0002));
+    REQUIRE(coordinates[3] == Approx(4.0).epsilon(0.0002));
+  }
+}
+
+/**
+ * Run AsyncSGD on a logistic regression function with sparse predictors and
+ * make sure the results are acceptable.
+ */
+TEST_CASE("AsyncSGDSparseLogisticRegressionTest", "[AsyncSGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  const arma::sp_mat sparseData(shuffledData);
+  LogisticRegressionFunction<arma::sp_mat> lr(sparseData, shuffledResponses,
+      0.5);
+
+  AsyncSGD<> s(100, 1, 2, 8, 1e-5, true, ConstantStep(0.01));
+  arma::mat coordinates = lr.GetInitialPoint();
+  const double result = s.Optimize(lr, coordinates);
+  REQUIRE(result == Approx(lr.Evaluate(coordinates)).epsilon(1e-10));
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(arma::sp_mat(data), responses,
+      coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(arma::sp_mat(testData),
+      testResponses, coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
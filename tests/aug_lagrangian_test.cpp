@@ -62,3 +62,110 @@ TEST_CASE("GockenbachFunctionTest", "[AugLagrangianTest]")
   REQUIRE(coords[1] == Approx(-1.10778185).epsilon(1e-7));
   REQUIRE(coords[2] == Approx(0.015099932).epsilon(1e-5));
 }
+
+/**
+ * Tests the Augmented Lagrangian optimizer with warm-started L-BFGS subproblems
+ * on the Gockenbach function, with both representations of L-BFGS.
+ */
+TEST_CASE("AugLagrangianWarmStartTest", "[AugLagrangianTest]")
+{
+  GockenbachFunction f;
+
+  for (const bool compact : { false, true })
+  {
+    L_BFGS lbfgs;
+    lbfgs.CompactRepresentation() = compact;
+    AugLagrangianType<L_BFGS> aug(1000, 0.25, 10.0, lbfgs, true);
+
+    arma::vec coords = f.GetInitialPoint();
+
+    if (!aug.Optimize(f, coords))
+      FAIL("Optimization reported failure.");
+
+    double finalValue = f.Evaluate(coords);
+
+    REQUIRE(finalValue == Approx(29.633926).epsilon(1e-7));
+    REQUIRE(coords[0] == Approx(0.12288178).epsilon(1e-5));
+    REQUIRE(coords[1] == Approx(-1.10778185).epsilon(1e-7));
+    REQUIRE(coords[2] == Approx(0.015099932).epsilon(1e-5));
+
+    // The setting of the inner optimizer is restored.
+    REQUIRE(aug.InnerOptimizer().ResetHistory() == true);
+  }
+}
+
+/**
+ * Test that the parallel evaluation of the constraints of the
+ * AugLagrangianFunction gives the same objective and gradient as the serial
+ * one, and that EvaluateWithGradient() agrees with Evaluate() and Gradient().
+ */
+TEST_CASE("AugLagrangianFunctionParallelConstraintsTest",
+    "[AugLagrangianTest]")
+{
+  GockenbachFunction f;
+  arma::vec lambda("0.5 -1.5");
+  AugLagrangianFunction<GockenbachFunction> augfunc(f, lambda, 10.0);
+
+  arma::mat coords("0.3; -0.7; 1.2");
+  const double objective = augfunc.Evaluate(coords);
+  arma::mat gradient(3, 1);
+  augfunc.Gradient(coords, gradient);
+
+  arma::mat combinedGradient(3, 1);
+  REQUIRE(augfunc.EvaluateWithGradient(coords, combinedGradient) ==
+      Approx(objective).epsilon(1e-12));
+  REQUIRE(arma::approx_equal(combinedGradient, gradient, "absdiff", 1e-10));
+
+  augfunc.ParallelConstraints() = true;
+  REQUIRE(augfunc.Evaluate(coords) == Approx(objective).epsilon(1e-12));
+  arma::mat parallelGradient(3, 1);
+  REQUIRE(augfunc.EvaluateWithGradient(coords, parallelGradient) ==
+      Approx(objective).epsilon(1e-12));
+  REQUIRE(arma::approx_equal(parallelGradient, gradient, "absdiff", 1e-10));
+
+  // The optimizer gives the same solution with parallel constraints.
+  AugLagrangian aug(1000, 0.25, 10.0, L_BFGS(), false, true);
+  arma::vec solution = f.GetInitialPoint();
+  if (!aug.Optimize(f, solution))
+    FAIL("Optimization reported failure.");
+
+  REQUIRE(f.Evaluate(solution) == Approx(29.633926).epsilon(1e-7));
+}
+
+/**
+ * Tests the Augmented Lagrangian optimizer with subproblem tolerances that
+ * adapt to the constraint violation.
+ */
+TEST_CASE("AugLagrangianAdaptiveTest", "[AugLagrangianTest]")
+{
+  L_BFGS lbfgs;
+  lbfgs.MinGradientNorm() = 1e-7;
+  AugLagrangian aug(1000, 0.25, 10.0, lbfgs, false, false, true);
+  REQUIRE(aug.Adaptive() == true);
+
+  GockenbachFunction f;
+  arma::vec coords = f.GetInitialPoint();
+  if (!aug.Optimize(f, coords))
+    FAIL("Optimization reported failure.");
+
+  REQUIRE(f.Evaluate(coords) == Approx(29.633926).epsilon(1e-6));
+  REQUIRE(coords[0] == Approx(0.12288178).epsilon(1e-5));
+  REQUIRE(coords[1] == Approx(-1.10778185).epsilon(1e-5));
+  REQUIRE(coords[2] == Approx(0.015099932).epsilon(1e-4));
+  for (size_t i = 0; i < f.NumConstraints(); ++i)
+    REQUIRE(std::abs(f.EvaluateConstraint(i, coords)) <= 1e-7);
+
+  // The sigma doesn't have to be driven up to terminate, and the tolerance of
+  // the inner optimizer is restored.
+  REQUIRE(aug.Sigma() < 500000);
+  REQUIRE(aug.InnerOptimizer().MinGradientNorm() == 1e-7);
+
+  AugLagrangianTestFunction g;
+  arma::vec gCoords = g.GetInitialPoint();
+  if (!aug.Optimize(g, gCoords))
+    FAIL("Optimization reported failure.");
+
+  REQUIRE(g.Evaluate(gCoords) == Approx(70.0).epsilon(1e-6));
+  REQUIRE(gCoords[0] == Approx(1.0).epsilon(1e-5));
+  REQUIRE(gCoords[1] == Approx(4.0).epsilon(1e-5));
+}
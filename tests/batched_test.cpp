@@ -0,0 +1,112 @@
+/**
+ * @file batched_test.cpp
+ *
+ * Test file for the batched optimizers.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+
+using namespace ens;
+
+// A batch of shifted Rosenbrock functions, f_j(x) = (a_j - x_0)^2 +
+// 100 (x_1 - x_0^2)^2, whose minima are at [a_j, a_j^2].
+class BatchedRosenbrockFunction
+{
+ public:
+  BatchedRosenbrockFunction(const arma::rowvec& a) : a(a) { }
+
+  void EvaluateWithGradient(const arma::mat& coordinates,
+                            const arma::uvec& problems,
+                            arma::rowvec& objectives,
+                            arma::mat& gradients)
+  {
+    const arma::rowvec x0 = coordinates.row(0);
+    const arma::rowvec x1 = coordinates.row(1);
+    const arma::rowvec shift = a.cols(problems);
+    const arma::rowvec r = x1 - arma::square(x0);
+
+    objectives = arma::square(shift - x0) + 100 * arma::square(r);
+    gradients.set_size(2, coordinates.n_cols);
+    gradients.row(0) = -2 * (shift - x0) - 400 * x0 % r;
+    gradients.row(1) = 200 * r;
+  }
+
+ private:
+  arma::rowvec a;
+};
+
+// A batch of separable quadratic functions f_j(x) = sum_i c_ij (x_i - b_ij)^2.
+class BatchedQuadraticFunction
+{
+ public:
+  BatchedQuadraticFunction(const arma::mat& b, const arma::mat& c) :
+      b(b), c(c) { }
+
+  void EvaluateWithGradient(const arma::mat& coordinates,
+                            const arma::uvec& problems,
+                            arma::rowvec& objectives,
+                            arma::mat& gradients)
+  {
+    const arma::mat diff = coordinates - b.cols(problems);
+    objectives = arma::sum(c.cols(problems) % arma::square(diff), 0);
+    gradients = 2 * c.cols(problems) % diff;
+  }
+
+ private:
+  arma::mat b;
+  arma::mat c;
+};
+
+/**
+ * Test batched L-BFGS on many shifted Rosenbrock functions at once.
+ */
+TEST_CASE("BatchedLBFGSRosenbrockFunctionTest", "[BatchedTest]")
+{
+  const arma::rowvec a = 0.5 + 1.5 * arma::randu<arma::rowvec>(200);
+  BatchedRosenbrockFunction f(a);
+
+  arma::mat coordinates = 4 * arma::randu<arma::mat>(2, 200) - 2;
+  BatchedL_BFGS optimizer;
+  const double objective = optimizer.Optimize(f, coordinates);
+
+  REQUIRE(objective == Approx(0.0).margin(1e-4));
+  REQUIRE(optimizer.NumConverged() == 200);
+  REQUIRE(optimizer.Objectives().n_elem == 200);
+  for (size_t j = 0; j < 200; ++j)
+  {
+    REQUIRE(coordinates(0, j) == Approx(a(j)).epsilon(1e-3));
+    REQUIRE(coordinates(1, j) == Approx(a(j) * a(j)).epsilon(1e-3));
+  }
+}
+
+/**
+ * Test batched gradient descent and batched L-BFGS on many quadratic
+ * functions.
+ */
+TEST_CASE("BatchedQuadraticFunctionTest", "[BatchedTest]")
+{
+  const arma::mat b = arma::randn<arma::mat>(10, 500);
+  const arma::mat c = 0.5 + 1.5 * arma::randu<arma::mat>(10, 500);
+  BatchedQuadraticFunction f(b, c);
+
+  arma::mat coordinates(10, 500, arma::fill::zeros);
+  BatchedGradientDescent gd(0.1, 100000, 1e-12);
+  gd.Optimize(f, coordinates);
+
+  REQUIRE(gd.NumConverged() == 500);
+  REQUIRE(arma::approx_equal(coordinates, b, "absdiff", 1e-4));
+
+  coordinates.zeros();
+  BatchedL_BFGS lbfgs;
+  lbfgs.Optimize(f, coordinates);
+
+  REQUIRE(lbfgs.NumConverged() == 500);
+  REQUIRE(arma::approx_equal(coordinates, b, "absdiff", 1e-4));
+  REQUIRE(arma::max(lbfgs.Objectives()) == Approx(0.0).margin(1e-8));
+}
@@ -0,0 +1,664 @@
+/**
+ * @file callbacks_test.cpp
+ *
+ * Test the callback functions of the optimizers.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace std;
+using namespace arma;
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Count the number of times each event is fired, and optionally terminate
+ * after a given number of steps.
+ */
+class CountingCallback
+{
+ public:
+  CountingCallback(const size_t maxSteps = 0) :
+      maxSteps(maxSteps),
+      begin(0),
+      end(0),
+      evaluations(0),
+      epochs(0),
+      steps(0)
+  { }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void BeginOptimization(OptimizerType&, FunctionType&, MatType&)
+  {
+    ++begin;
+  }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndOptimization(OptimizerType&, FunctionType&, MatType&)
+  {
+    ++end;
+  }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType,
+           typename GradType>
+  void EvaluateWithGradient(OptimizerType&,
+                            FunctionType&,
+                            const MatType&,
+                            const double,
+                            const GradType&)
+  {
+    ++evaluations;
+  }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndEpoch(OptimizerType&,
+                FunctionType&,
+                const MatType&,
+                const size_t,
+                const double)
+  {
+    ++epochs;
+  }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool StepTaken(OptimizerType&, FunctionType&, MatType&)
+  {
+    return (++steps == maxSteps);
+  }
+
+  size_t maxSteps;
+  size_t begin;
+  size_t end;
+  size_t evaluations;
+  size_t epochs;
+  size_t steps;
+};
+
+/**
+ * Make sure all events are fired by SGD.
+ */
+TEST_CASE("SGDCallbacksEventsTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  StandardSGD s(0.0003, 1, 300, -1.0, false);
+
+  CountingCallback cb;
+  arma::mat coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates, cb);
+
+  REQUIRE(cb.begin == 1);
+  REQUIRE(cb.end == 1);
+  REQUIRE(cb.evaluations == 300);
+  REQUIRE(cb.steps == 300);
+  REQUIRE(cb.epochs == 99);
+}
+
+/**
+ * Make sure a callback returning true terminates the optimization.
+ */
+TEST_CASE("SGDCallbacksTerminateTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  StandardSGD s(0.0003, 1, 0 /* no limit */, -1.0, false);
+
+  CountingCallback cb(10);
+  arma::mat coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates, cb);
+
+  REQUIRE(cb.steps == 10);
+  REQUIRE(cb.end == 1);
+}
+
+/**
+ * Make sure the early stopping callback terminates once the objective is
+ * stable.
+ */
+TEST_CASE("EarlyStopAtMinLossTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  StandardSGD s(0.0003, 1, 0 /* no limit */, -1.0, true);
+
+  EarlyStopAtMinLoss cb(5);
+  arma::mat coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates, cb);
+
+  REQUIRE(cb.BestObjective() == Approx(-1.0).epsilon(0.0005));
+}
+
+/**
+ * Make sure several callbacks may be combined, and passed as temporaries.
+ */
+TEST_CASE("MultipleCallbacksTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  Adam adam(0.01, 1, 0.9, 0.999, 1e-8, 3000, -1.0, false);
+
+  std::stringstream stream;
+  StoreBestCoordinates<arma::mat> store;
+  CountingCallback cb;
+  arma::mat coordinates = f.GetInitialPoint();
+  adam.Optimize(f, coordinates, store, cb, PrintLoss(stream));
+
+  REQUIRE(cb.steps == 3000);
+  REQUIRE(cb.epochs == 999);
+  REQUIRE(store.BestCoordinates().n_elem == coordinates.n_elem);
+  REQUIRE(store.BestObjective() < DBL_MAX);
+  REQUIRE(stream.str().length() > 0);
+}
+
+/**
+ * Make sure L-BFGS fires the events and can be terminated.
+ */
+TEST_CASE("LBFGSCallbacksTest", "[CallbacksTest]")
+{
+  RosenbrockFunction f;
+  L_BFGS lbfgs;
+
+  CountingCallback cb(5);
+  arma::mat coordinates = f.GetInitialPoint();
+  lbfgs.Optimize(f, coordinates, cb);
+
+  REQUIRE(cb.begin == 1);
+  REQUIRE(cb.end == 1);
+  REQUIRE(cb.steps == 5);
+  REQUIRE(cb.evaluations == 6);
+}
+
+/**
+ * Make sure gradient descent fires the events.
+ */
+TEST_CASE("GradientDescentCallbacksTest", "[CallbacksTest]")
+{
+  RosenbrockFunction f;
+  GradientDescent gd(0.001, 0, 1e-15);
+
+  CountingCallback cb(20);
+  arma::mat coordinates = f.GetInitialPoint();
+  gd.Optimize(f, coordinates, cb);
+
+  REQUIRE(cb.steps == 20);
+  REQUIRE(cb.evaluations == 20);
+  REQUIRE(cb.end == 1);
+}
+
+/**
+ * Make sure the budget callback stops SGD after the given number of
+ * evaluations, and that its counters are reset by the next optimization.
+ */
+TEST_CASE("BudgetEvaluationsTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  StandardSGD s(0.0003, 1, 0 /* no limit */, -1.0, false);
+
+  Budget budget(0, 100);
+  arma::mat coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates, budget);
+
+  REQUIRE(budget.Exhausted());
+  REQUIRE(budget.Evaluations() == 100);
+  REQUIRE(budget.Gradients() == 100);
+
+  budget.MaxEvaluations() = 0;
+  budget.MaxGradients() = 20;
+  s.Optimize(f, coordinates, budget);
+
+  REQUIRE(budget.Exhausted());
+  REQUIRE(budget.Gradients() == 20);
+}
+
+/**
+ * Make sure the budget callback enforces a wall-clock deadline.
+ */
+TEST_CASE("BudgetTimeTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  StandardSGD s(0.0003, 1, 0 /* no limit */, -1.0, false);
+
+  Budget budget(0.05);
+  arma::wall_clock timer;
+  timer.tic();
+  arma::mat coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates, budget);
+
+  REQUIRE(budget.Exhausted());
+  REQUIRE(timer.toc() >= 0.05);
+  REQUIRE(timer.toc() < 5.0);
+}
+
+/**
+ * Make sure a budget that is not used up does not stop the optimization.
+ */
+TEST_CASE("BudgetNotExhaustedTest", "[CallbacksTest]")
+{
+  RosenbrockFunction f;
+  L_BFGS lbfgs;
+
+  Budget budget(1000.0, 100000, 100000);
+  arma::mat coordinates = f.GetInitialPoint();
+  lbfgs.Optimize(f, coordinates, budget);
+
+  REQUIRE(!budget.Exhausted());
+  REQUIRE(budget.Evaluations() > 0);
+  REQUIRE(coordinates(0) == Approx(1.0).epsilon(1e-3));
+  REQUIRE(coordinates(1) == Approx(1.0).epsilon(1e-3));
+}
+
+/**
+ * Make sure the budget callback stops the derivative-free optimizers.  The
+ * population-based ones finish the generation they are evaluating, so they may
+ * go over the budget by less than one generation.
+ */
+TEST_CASE("BudgetDerivativeFreeTest", "[CallbacksTest]")
+{
+  RosenbrockFunction f;
+
+  Budget budget(0, 100);
+  arma::mat coordinates = f.GetInitialPoint();
+  ExponentialSchedule schedule;
+  SA<> sa(schedule, 1000000, 1000., 1000, 100, 1e-10, 3, 1.5,
+      0.5, 0.3);
+  sa.Optimize(f, coordinates, budget);
+  REQUIRE(budget.Exhausted());
+  REQUIRE(budget.Evaluations() == 100);
+
+  coordinates = f.GetInitialPoint();
+  SPSA spsa(0.1, 0.102, 0.16, 0.3, 100000, 0);
+  spsa.Optimize(f, coordinates, budget);
+  REQUIRE(budget.Exhausted());
+  REQUIRE(budget.Evaluations() == 103);
+
+  coordinates = f.GetInitialPoint();
+  CNE cne(20, 100000, 0.1, 0.02, 0.2, -1);
+  cne.Optimize(f, coordinates, budget);
+  REQUIRE(budget.Exhausted());
+  REQUIRE(budget.Evaluations() >= 100);
+  REQUIRE(budget.Evaluations() <= 122);
+
+  coordinates = f.GetInitialPoint();
+  DE de(20, 100000, 0.6, 0.8, -1);
+  de.Optimize(f, coordinates, budget);
+  REQUIRE(budget.Exhausted());
+  REQUIRE(budget.Evaluations() >= 100);
+  REQUIRE(budget.Evaluations() <= 140);
+
+  coordinates = f.GetInitialPoint();
+  CMAES<> cmaes(10, -1, 1, 1, 100000, -1);
+  cmaes.Optimize(f, coordinates, budget);
+  REQUIRE(budget.Exhausted());
+  REQUIRE(budget.Evaluations() >= 100);
+  REQUIRE(budget.Evaluations() <= 111);
+}
+
+/**
+ * Make sure the budget callback stops Frank-Wolfe.
+ */
+TEST_CASE("BudgetFrankWolfeTest", "[CallbacksTest]")
+{
+  arma::mat A = arma::join_horiz(arma::eye(3, 3), 0.1 * arma::randn(3, 5));
+  arma::vec b;
+  b << 1 << 1 << 0;
+
+  FuncSq f(A, b);
+  ConstrLpBallSolver linearConstrSolver(1);
+  UpdateSpan updateRule;
+  OMP omp(linearConstrSolver, updateRule);
+
+  Budget budget(0, 0, 2);
+  arma::mat coordinates = arma::zeros<arma::vec>(8);
+  omp.Optimize(f, coordinates, budget);
+
+  REQUIRE(budget.Exhausted());
+  REQUIRE(budget.Gradients() == 2);
+}
+
+/**
+ * Make sure that the Telemetry callback keeps the newest records and exports
+ * them.
+ */
+TEST_CASE("TelemetryTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  StandardSGD s(0.0003, 1, 100, -1.0, false);
+
+  // Record every 5th of the 100 steps, keeping the last 10 records.
+  Telemetry telemetry(10, 5);
+  arma::mat coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates, telemetry);
+
+  REQUIRE(telemetry.Size() == 10);
+  REQUIRE(telemetry.Dropped() == 10);
+  const std::vector<TelemetryRecord> records = telemetry.Records();
+  REQUIRE(records.size() == 10);
+  for (size_t i = 0; i < records.size(); ++i)
+  {
+    REQUIRE(records[i].iteration == 55 + 5 * i);
+    REQUIRE(records[i].stepSize == Approx(0.0003));
+    REQUIRE(std::isfinite(records[i].objective));
+    REQUIRE(records[i].gradientNorm >= 0.0);
+    if (i > 0)
+      REQUIRE(records[i].timestamp >= records[i - 1].timestamp);
+  }
+
+  std::ostringstream json;
+  telemetry.WriteJSON(json);
+  REQUIRE(json.str().find("{\"dropped\":10,\"records\":[{\"iteration\":55,")
+      == 0);
+
+  std::ostringstream prometheus;
+  telemetry.WritePrometheus(prometheus, "sgd");
+  REQUIRE(prometheus.str().find("sgd_records_total 20\n") !=
+      std::string::npos);
+  REQUIRE(prometheus.str().find("sgd_iteration 100\n") != std::string::npos);
+  REQUIRE(prometheus.str().find("sgd_step_size 0.0003\n") !=
+      std::string::npos);
+
+  // L-BFGS has no step size.
+  RosenbrockFunction r;
+  L_BFGS lbfgs;
+  coordinates = r.GetInitialPoint();
+  lbfgs.Optimize(r, coordinates, telemetry);
+
+  REQUIRE(telemetry.Size() > 0);
+  REQUIRE(telemetry.Record(0).iteration == 5);
+  REQUIRE(std::isnan(telemetry.Record(0).stepSize));
+}
+
+/**
+ * Make sure the RecordResult callback counts the events of SGD, and tells that
+ * the reason SGD stopped is not known.
+ */
+TEST_CASE("RecordResultSGDTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  StandardSGD s(0.0003, 1, 300, -1.0, false);
+
+  OptimizationResult result;
+  arma::mat coordinates = f.GetInitialPoint();
+  const double objective = s.Optimize(f, coordinates, RecordResult(result));
+
+  REQUIRE(result.reason == OptimizationResult::Stopped);
+  REQUIRE(result.evaluations == 300);
+  REQUIRE(result.gradients == 300);
+  REQUIRE(result.iterations == 300);
+  REQUIRE(result.epochs == 99);
+  REQUIRE(result.objective == Approx(objective));
+  REQUIRE(result.gradientNorm >= 0.0);
+  REQUIRE(result.setupTime >= 0.0);
+  REQUIRE(result.iterationTime >= 0.0);
+  REQUIRE(result.finalizationTime >= 0.0);
+  REQUIRE(result.totalTime == Approx(result.setupTime + result.iterationTime +
+      result.finalizationTime));
+}
+
+/**
+ * Make sure the RecordResult callback tells whether L-BFGS converged, reached
+ * its iteration limit or was terminated by another callback.
+ */
+TEST_CASE("RecordResultLBFGSTest", "[CallbacksTest]")
+{
+  RosenbrockFunction f;
+  L_BFGS lbfgs;
+
+  OptimizationResult result;
+  arma::mat coordinates = f.GetInitialPoint();
+  lbfgs.Optimize(f, coordinates, RecordResult(result));
+
+  REQUIRE(result.reason == OptimizationResult::Converged);
+  REQUIRE(std::string(result.ReasonString()) == "converged");
+  REQUIRE(result.iterations > 0);
+  REQUIRE(result.evaluations == result.iterations + 1);
+  REQUIRE(result.gradients == result.evaluations);
+  REQUIRE(result.objective == Approx(0.0).margin(1e-5));
+  REQUIRE(result.gradientNorm < 1e-2);
+
+  lbfgs.MaxIterations() = 5;
+  coordinates = f.GetInitialPoint();
+  lbfgs.Optimize(f, coordinates, RecordResult(result));
+
+  REQUIRE(result.reason == OptimizationResult::MaxIterations);
+  REQUIRE(result.iterations == 5);
+  REQUIRE(result.evaluations == 6);
+
+  lbfgs.MaxIterations() = 0;
+  CountingCallback cb(3);
+  coordinates = f.GetInitialPoint();
+  lbfgs.Optimize(f, coordinates, RecordResult(result), cb);
+
+  REQUIRE(result.reason == OptimizationResult::Callback);
+  REQUIRE(result.iterations == 3);
+}
+
+/**
+ * Make sure the ThroughputTuner callback sets the batch size of SGD to one of
+ * its candidates before the optimization, and that the optimization still
+ * converges.
+ */
+TEST_CASE("ThroughputTunerSGDTest", "[CallbacksTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  // The tuner sets the number of threads for the rest of the program.
+  #ifdef ENS_USE_OPENMP
+    const int threads = omp_get_max_threads();
+  #endif
+
+  StandardSGD s(0.01, 1, 100000, 1e-5, true);
+  ThroughputTuner tuner(5, 64, 1, 0.005);
+  arma::mat coordinates = lr.GetInitialPoint();
+  s.Optimize(lr, coordinates, tuner);
+
+  #ifdef ENS_USE_OPENMP
+    omp_set_num_threads(threads);
+  #endif
+
+  // The candidates are 5, 8, 16, 32 and 64, with one thread.
+  REQUIRE(tuner.Trials().n_rows == 3);
+  REQUIRE(tuner.Trials().n_cols == 5);
+  REQUIRE(tuner.Trials()(0, 0) == 5.0);
+  REQUIRE(tuner.Trials()(0, 4) == 64.0);
+  REQUIRE(tuner.Threads() == 1);
+  REQUIRE(s.BatchSize() == tuner.BatchSize());
+  REQUIRE(arma::any(tuner.Trials().row(0) == double(tuner.BatchSize())));
+  REQUIRE(arma::all(tuner.Trials().row(2) > 0.0));
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+}
+
+/**
+ * Tune the batch size of an optimizer without callbacks, and make sure that
+ * invalid ranges of batch sizes are rejected.
+ */
+TEST_CASE("ThroughputTunerTuneTest", "[CallbacksTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  #ifdef ENS_USE_OPENMP
+    const int threads = omp_get_max_threads();
+  #endif
+
+  BBS_BB s(1);
+  const arma::mat coordinates = lr.GetInitialPoint();
+  ThroughputTuner tuner(2, 2 * lr.NumFunctions(), 1, 0.001);
+  tuner.Tune(s, lr, coordinates);
+
+  #ifdef ENS_USE_OPENMP
+    omp_set_num_threads(threads);
+  #endif
+
+  // The largest candidate is limited by the number of functions.
+  REQUIRE(tuner.Trials().n_cols > 1);
+  REQUIRE(tuner.Trials()(0, tuner.Trials().n_cols - 1) == lr.NumFunctions());
+  REQUIRE(s.BatchSize() == tuner.BatchSize());
+  REQUIRE(arma::all(coordinates == lr.GetInitialPoint()));
+
+  ThroughputTuner invalid(64, 32);
+  REQUIRE_THROWS_AS(invalid.Tune(s, lr, coordinates), std::invalid_argument);
+}
+
+/**
+ * Cancel a copy of the given token after a given number of steps, as another
+ * thread would.
+ */
+class CancelAfterSteps
+{
+ public:
+  CancelAfterSteps(const CancellationToken<>& token, const size_t maxSteps) :
+      token(token),
+      maxSteps(maxSteps),
+      steps(0)
+  { }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void StepTaken(OptimizerType&, FunctionType&, MatType&)
+  {
+    if (++steps == maxSteps)
+      token.Cancel();
+  }
+
+  CancellationToken<> token;
+  size_t maxSteps;
+  size_t steps;
+};
+
+/**
+ * Make sure a cancelled token stops SGD at the next batch, and that the best
+ * coordinates are returned.
+ */
+TEST_CASE("CancellationTokenSGDTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  StandardSGD s(0.0003, 1, 0 /* no limit */, -1.0, false);
+
+  CancellationToken<> token;
+  CancelAfterSteps canceller(token, 100);
+  CountingCallback cb;
+  arma::mat coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates, canceller, token, cb);
+
+  // The token is checked at the step where it is cancelled.
+  REQUIRE(token.Cancelled());
+  REQUIRE(token.Stopped());
+  REQUIRE(cb.steps == 100);
+  REQUIRE(cb.end == 1);
+  REQUIRE(token.BestObjective() < DBL_MAX);
+  REQUIRE(arma::approx_equal(coordinates, token.BestCoordinates(), "absdiff",
+      0.0));
+
+  // A token that is already cancelled stops the optimization right away.
+  CountingCallback cb2;
+  coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates, token, cb2);
+  REQUIRE(token.Stopped());
+  REQUIRE(cb2.steps == 0);
+  REQUIRE(arma::approx_equal(coordinates, f.GetInitialPoint(), "absdiff",
+      0.0));
+
+  // Once reset, the token does not stop the optimization.
+  token.Reset();
+  StandardSGD s2(0.0003, 1, 300, -1.0, false);
+  CountingCallback cb3;
+  s2.Optimize(f, coordinates, token, cb3);
+  REQUIRE(!token.Stopped());
+  REQUIRE(cb3.steps == 300);
+}
+
+/**
+ * Make sure a cancelled token stops L-BFGS, and that the current coordinates
+ * are kept when restoreBest is false.
+ */
+TEST_CASE("CancellationTokenLBFGSTest", "[CallbacksTest]")
+{
+  RosenbrockFunction f;
+  L_BFGS lbfgs;
+
+  CancellationToken<> token(false);
+  CancelAfterSteps canceller(token, 3);
+  arma::mat coordinates = f.GetInitialPoint();
+  lbfgs.Optimize(f, coordinates, canceller, token);
+
+  REQUIRE(token.Stopped());
+  REQUIRE(canceller.steps == 3);
+  REQUIRE(token.BestCoordinates().n_elem == 0);
+
+  // The optimization did not converge yet.
+  REQUIRE(std::abs(coordinates(0) - 1.0) > 1e-3);
+}
+
+/**
+ * Keep the coordinates at the end of the last epoch.
+ */
+class LastEpochCoordinates
+{
+ public:
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndEpoch(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& coordinates,
+                const size_t /* epoch */,
+                const double /* objective */)
+  {
+    last = coordinates;
+  }
+
+  arma::mat last;
+};
+
+/**
+ * Checkpoint Adam asynchronously at the end of every epoch, with and without
+ * the memory mapping, and make sure that the last checkpoint holds the
+ * coordinates and the state of the last epoch.
+ */
+TEST_CASE("AsyncCheckpointTest", "[CallbacksTest]")
+{
+  for (size_t m = 0; m < 2; ++m)
+  {
+    SGDTestFunction f;
+    Adam optimizer(1e-3, 1, 0.9, 0.999, 1e-8, 300, -1.0, false, false);
+    AsyncCheckpoint checkpoint("async_checkpoint_test.bin", 1, m == 1);
+    LastEpochCoordinates last;
+
+    arma::mat coordinates = f.GetInitialPoint();
+    optimizer.Optimize(f, coordinates, last, checkpoint);
+    REQUIRE(checkpoint.Checkpoints() > 1);
+
+    arma::mat loadedCoordinates;
+    Adam resumed(1e-3, 1, 0.9, 0.999, 1e-8, 300, -1.0, false, false);
+    AsyncCheckpoint::Load("async_checkpoint_test.bin", loadedCoordinates,
+        resumed);
+    REQUIRE(loadedCoordinates.n_elem == last.last.n_elem);
+    for (size_t i = 0; i < last.last.n_elem; ++i)
+      REQUIRE(loadedCoordinates[i] == last.last[i]);
+
+    // The saved state is that of the optimizer.
+    std::stringstream saved, loaded;
+    SaveState(saved, optimizer);
+    SaveState(loaded, resumed);
+    REQUIRE(loaded.str().size() == saved.str().size());
+  }
+
+  std::remove("async_checkpoint_test.bin");
+  arma::mat coordinates;
+  REQUIRE_THROWS_AS(AsyncCheckpoint::Load("async_checkpoint_test.bin",
+      coordinates), std::runtime_error);
+  REQUIRE_THROWS_AS(AsyncCheckpoint("async_checkpoint_test.bin", 0),
+      std::invalid_argument);
+}
@@ -102,3 +102,436 @@ TEST_CASE("ApproxCMAESLogisticRegressionTest", "[CMAESTest]")
 
   REQUIRE(success == true);
 }
+
+/**
+ * Make sure that evaluating the offspring in parallel gives the same result as
+ * evaluating them sequentially.
+ */
+TEST_CASE("CMAESParallelEvaluationTest", "[CMAESTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  CMAES<> cmaes(0, -1, 1, 32, 50, -1);
+  CMAES<> parallelCmaes(0, -1, 1, 32, 50, -1, FullSelection(), true);
+  REQUIRE(parallelCmaes.ParallelEvaluation() == true);
+
+  arma::arma_rng::set_seed(42);
+  arma::mat coordinates = lr.GetInitialPoint();
+  const double objective = cmaes.Optimize(lr, coordinates);
+
+  arma::arma_rng::set_seed(42);
+  arma::mat parallelCoordinates = lr.GetInitialPoint();
+  const double parallelObjective = parallelCmaes.Optimize(lr,
+      parallelCoordinates);
+
+  REQUIRE(parallelObjective == Approx(objective).epsilon(1e-10));
+  for (size_t i = 0; i < coordinates.n_elem; ++i)
+    REQUIRE(parallelCoordinates[i] == Approx(coordinates[i]).margin(1e-10));
+}
+
+/**
+ * Run CMA-ES with the random selection policy and parallel evaluation on
+ * logistic regression and make sure the results are acceptable.
+ */
+TEST_CASE("ApproxCMAESParallelLogisticRegressionTest", "[CMAESTest]")
+{
+  const size_t trials = 3;
+  bool success = false;
+  for (size_t trial = 0; trial < trials; ++trial)
+  {
+    arma::mat data, testData, shuffledData;
+    arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+    LogisticRegressionTestData(data, testData, shuffledData,
+        responses, testResponses, shuffledResponses);
+    LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+    ApproxCMAES<> cmaes(0, -1, 1, 32, 200, 1e-3, RandomSelection(), true);
+    arma::mat coordinates = lr.GetInitialPoint();
+    cmaes.Optimize(lr, coordinates);
+
+    // Ensure that the error is close to zero.
+    const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+    const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+        coordinates);
+    if (acc >= 99.7 && testAcc >= 99.4)
+    {
+      success = true;
+      break;
+    }
+  }
+
+  REQUIRE(success == true);
+}
+
+/**
+ * Run CMA-ES with a random selection shared by the offspring of each
+ * generation, summed in parallel, on logistic regression and make sure the
+ * results are acceptable.
+ */
+TEST_CASE("ApproxCMAESSharedSelectionLogisticRegressionTest", "[CMAESTest]")
+{
+  const size_t trials = 3;
+  bool success = false;
+  for (size_t trial = 0; trial < trials; ++trial)
+  {
+    arma::mat data, testData, shuffledData;
+    arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+    LogisticRegressionTestData(data, testData, shuffledData,
+        responses, testResponses, shuffledResponses);
+    LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+    ApproxCMAES<> cmaes(0, -1, 1, 32, 200, 1e-3,
+        RandomSelection(0.3, true, true));
+    REQUIRE(cmaes.SelectionPolicy().SharedSelection() == true);
+    arma::mat coordinates = lr.GetInitialPoint();
+    cmaes.Optimize(lr, coordinates);
+
+    // Ensure that the error is close to zero.
+    const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+    const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+        coordinates);
+    if (acc >= 99.7 && testAcc >= 99.4)
+    {
+      success = true;
+      break;
+    }
+  }
+
+  REQUIRE(success == true);
+}
+
+/**
+ * With a shared selection, every evaluation of a generation uses the same
+ * batches, so the same point gets the same objective; the parallel sums of
+ * the full selection match the serial ones.
+ */
+TEST_CASE("CMAESSelectionPolicyTest", "[CMAESTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+  const arma::mat coordinates = lr.GetInitialPoint();
+
+  RandomSelection shared(0.3, true);
+  shared.BeginPopulation(lr, 10);
+  const double objective = shared.Select(lr, 10, coordinates);
+  REQUIRE(shared.Select(lr, 10, coordinates) == objective);
+
+  RNG generator(5);
+  REQUIRE(shared.Select(lr, 10, coordinates, generator) == objective);
+
+  shared.Parallel() = true;
+  REQUIRE(shared.Select(lr, 10, coordinates) == Approx(objective)
+      .epsilon(1e-12));
+
+  FullSelection serial;
+  FullSelection parallel(true);
+  REQUIRE(parallel.Select(lr, 10, coordinates) ==
+      Approx(serial.Select(lr, 10, coordinates)).epsilon(1e-12));
+}
+
+/**
+ * Tests sep-CMA-ES (diagonal covariance) using a simple test function.
+ */
+TEST_CASE("SepCMAESSimpleTestFunction", "[CMAESTest]")
+{
+  SGDTestFunction f;
+  SepCMAES<> optimizer(0, -1, 1, 32, 200, -1);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  optimizer.Optimize(f, coordinates);
+
+  REQUIRE(coordinates[0] == Approx(0.0).margin(0.003));
+  REQUIRE(coordinates[1] == Approx(0.0).margin(0.003));
+  REQUIRE(coordinates[2] == Approx(0.0).margin(0.003));
+}
+
+/**
+ * Run sep-CMA-ES on logistic regression and make sure the results are
+ * acceptable.
+ */
+TEST_CASE("SepCMAESLogisticRegressionTest", "[CMAESTest]")
+{
+  const size_t trials = 3;
+  bool success = false;
+  for (size_t trial = 0; trial < trials; ++trial)
+  {
+    arma::mat data, testData, shuffledData;
+    arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+    LogisticRegressionTestData(data, testData, shuffledData,
+        responses, testResponses, shuffledResponses);
+    LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+    SepCMAES<> cmaes(0, -1, 1, 32, 200, 1e-3);
+    arma::mat coordinates = lr.GetInitialPoint();
+    cmaes.Optimize(lr, coordinates);
+
+    // Ensure that the error is close to zero.
+    const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+    const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+        coordinates);
+    if (acc >= 99.7 && testAcc >= 99.4)
+    {
+      success = true;
+      break;
+    }
+  }
+
+  REQUIRE(success == true);
+}
+
+/**
+ * Run CMA-ES on logistic regression with the covariance matrix decomposed only
+ * every few generations and make sure the results are acceptable.
+ */
+TEST_CASE("CMAESLazyDecompositionLogisticRegressionTest", "[CMAESTest]")
+{
+  const size_t trials = 3;
+  bool success = false;
+  for (size_t trial = 0; trial < trials; ++trial)
+  {
+    arma::mat data, testData, shuffledData;
+    arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+    LogisticRegressionTestData(data, testData, shuffledData,
+        responses, testResponses, shuffledResponses);
+    LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+    CMAES<> cmaes(0, -1, 1, 32, 200, 1e-3, FullSelection(), false,
+        FullCovariance(5));
+    REQUIRE(cmaes.CovariancePolicy().DecompositionInterval() == 5);
+
+    arma::mat coordinates = lr.GetInitialPoint();
+    cmaes.Optimize(lr, coordinates);
+
+    // Ensure that the error is close to zero.
+    const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+    const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+        coordinates);
+    if (acc >= 99.7 && testAcc >= 99.4)
+    {
+      success = true;
+      break;
+    }
+  }
+
+  REQUIRE(success == true);
+}
+
+/**
+ * Make sure that IPOP-CMA-ES finds the global minimum of the multimodal
+ * Rastrigin function, and increases the population size at every restart.
+ */
+TEST_CASE("IPOPCMAESRastriginFunctionTest", "[CMAESTest]")
+{
+  RastriginFunction f(2);
+  CMAES<> cmaes(10, -5.12, 5.12, 32, 1000, 1e-8);
+  IPOP_CMAES<> optimizer(cmaes, 2, 6);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  const double objective = optimizer.Optimize(f, coordinates);
+
+  REQUIRE(optimizer.Restarts() <= 6);
+  REQUIRE(optimizer.FunctionEvaluations() > 0);
+  REQUIRE(objective == Approx(f.Evaluate(coordinates)).margin(1e-10));
+  REQUIRE(objective == Approx(0.0).margin(0.1));
+  REQUIRE(coordinates[0] == Approx(0.0).margin(0.05));
+  REQUIRE(coordinates[1] == Approx(0.0).margin(0.05));
+}
+
+/**
+ * Make sure that BIPOP-CMA-ES finds the global minimum of the Rastrigin
+ * function, and respects the evaluation budget.
+ */
+TEST_CASE("BIPOPCMAESRastriginFunctionTest", "[CMAESTest]")
+{
+  RastriginFunction f(2);
+  CMAES<> cmaes(10, -5.12, 5.12, 32, 1000, 1e-8);
+  BIPOP_CMAES<> optimizer(cmaes, 2, 10, 200000);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  const double objective = optimizer.Optimize(f, coordinates);
+
+  REQUIRE(optimizer.Restarts() <= 10);
+  REQUIRE(optimizer.SmallRestarts() <= optimizer.Restarts());
+  REQUIRE(optimizer.FunctionEvaluations() <= 200000);
+  REQUIRE(objective == Approx(0.0).margin(0.1));
+  REQUIRE(coordinates[0] == Approx(0.0).margin(0.05));
+  REQUIRE(coordinates[1] == Approx(0.0).margin(0.05));
+
+  // A small budget stops the restarts.
+  optimizer.MaxFunctionEvaluations() = 2000;
+  coordinates = f.GetInitialPoint();
+  optimizer.Optimize(f, coordinates);
+  REQUIRE(optimizer.FunctionEvaluations() <= 2000);
+}
+
+/**
+ * Make sure that running the regimes of BIPOP-CMA-ES concurrently gives
+ * reproducible results.
+ */
+/**
+ * Make sure that the covariance policies sample the whole population from the
+ * search distribution, and that the rank-mu update of the full covariance
+ * matches its definition.
+ */
+TEST_CASE("CMAESCovariancePolicySampleTest", "[CMAESTest]")
+{
+  FullCovariance full;
+  full.Initialize(3, 1, 20000);
+  full.Decompose();
+
+  arma::cube steps(3, 1, 20000);
+  full.Sample(steps);
+  // The slices are the columns of a 3 x 20000 matrix.
+  const arma::mat stepMatrix(steps.memptr(), 3, steps.n_slices, false, true);
+  const arma::mat empirical = stepMatrix * stepMatrix.t() / steps.n_slices;
+  REQUIRE(arma::norm(empirical - arma::eye(3, 3)) < 0.1);
+
+  DiagonalCovariance diagonal;
+  diagonal.Initialize(3, 1, 20000);
+  diagonal.Decompose();
+  diagonal.Sample(steps);
+  REQUIRE(arma::norm(arma::var(stepMatrix, 1, 1) - 1.0) < 0.1);
+
+  // A generation with four offspring, of which the two best are recombined.
+  arma::cube population(3, 1, 4, arma::fill::randn);
+  const arma::vec weights("0.7 0.3");
+  const arma::uvec idx("2 0 3 1");
+  const arma::mat pc(3, 1, arma::fill::randn);
+  full.Update(pc, true, 0.1, 0.2, 0.5, population, weights, idx);
+
+  const arma::mat expected = (1 - 0.1 - 0.2) * arma::eye(3, 3) +
+      0.1 * pc * pc.t() +
+      0.2 * 0.7 * population.slice(2) * population.slice(2).t() +
+      0.2 * 0.3 * population.slice(0) * population.slice(0).t();
+  REQUIRE(arma::approx_equal(full.Covariance(), expected, "absdiff", 1e-12));
+}
+
+TEST_CASE("BIPOPCMAESParallelRegimesTest", "[CMAESTest]")
+{
+  RastriginFunction f(2);
+  CMAES<> cmaes(10, -5.12, 5.12, 32, 1000, 1e-8);
+  BIPOP_CMAES<> optimizer(cmaes, 2, 6, 0, true);
+
+  arma::arma_rng::set_seed(42);
+  arma::mat first = f.GetInitialPoint();
+  const double firstObjective = optimizer.Optimize(f, first);
+  const size_t firstRestarts = optimizer.Restarts();
+
+  arma::arma_rng::set_seed(42);
+  arma::mat second = f.GetInitialPoint();
+  const double secondObjective = optimizer.Optimize(f, second);
+
+  REQUIRE(optimizer.Restarts() == firstRestarts);
+  REQUIRE(secondObjective == firstObjective);
+  REQUIRE(arma::approx_equal(first, second, "absdiff", 0.0));
+  REQUIRE(firstObjective == Approx(0.0).margin(0.1));
+}
+
+/**
+ * Make sure that the memory estimate of CMA-ES is dominated by the covariance
+ * matrix, and that sep-CMA-ES grows linearly with the iterate.
+ */
+TEST_CASE("CMAESEstimateMemoryTest", "[CMAESTest]")
+{
+  const size_t n = 1000;
+  CMAES<> cmaes(20);
+  SepCMAES<> sepCMAES(20);
+
+  REQUIRE(cmaes.EstimateMemory(n) - sepCMAES.EstimateMemory(n) ==
+      FullCovariance::EstimateStateBytes(n, 1, 20) -
+      DiagonalCovariance::EstimateStateBytes(n, 1, 20));
+  REQUIRE(cmaes.EstimateMemory(n) >= 5 * n * n * sizeof(double));
+  REQUIRE(sepCMAES.EstimateMemory(2 * n) < 3 * sepCMAES.EstimateMemory(n));
+
+  // Without a population size, the default one is used.
+  CMAES<> defaultCMAES;
+  const size_t lambda = CMAES<>::DefaultPopulationSize(n);
+  REQUIRE(defaultCMAES.EstimateMemory(n) - cmaes.EstimateMemory(n) ==
+      (lambda - 20) * (2 * n + 2) * sizeof(double) + (lambda / 2 - 10) *
+      sizeof(double) + (lambda - 20) * sizeof(arma::uword) +
+      (lambda - 20) * n * sizeof(double));
+}
+
+/**
+ * Make sure that the quadratic surrogate recovers a quadratic function once
+ * its archive has enough points, and that the rank correlation is right.
+ */
+TEST_CASE("QuadraticSurrogateTest", "[CMAESTest]")
+{
+  const size_t n = 3;
+  const arma::mat a = { { 2.0, 0.5, 0.0 },
+                        { 0.5, 1.0, 0.3 },
+                        { 0.0, 0.3, 3.0 } };
+  const arma::vec b = { 1.0, -2.0, 0.5 };
+  auto quadratic = [&](const arma::vec& x)
+  {
+    return arma::as_scalar(x.t() * a * x) + arma::dot(b, x) + 4.0;
+  };
+
+  QuadraticSurrogate model(n, QuadraticSurrogate::DefaultCapacity(n));
+  const arma::vec center = { 0.5, 0.5, 0.5 };
+
+  // Too few points for any model.
+  for (size_t i = 0; i < n + 1; ++i)
+  {
+    const arma::vec x = arma::randn<arma::vec>(n);
+    model.Add(x, quadratic(x));
+  }
+  REQUIRE(model.Fit(center, 2.0) == false);
+
+  // Enough points for the full quadratic model, which is then exact.
+  while (model.Size() < model.Capacity())
+  {
+    const arma::vec x = arma::randn<arma::vec>(n);
+    model.Add(x, quadratic(x));
+  }
+  REQUIRE(model.Fit(center, 2.0) == true);
+  for (size_t i = 0; i < 10; ++i)
+  {
+    const arma::vec x = arma::randn<arma::vec>(n);
+    REQUIRE(model.Predict(x) == Approx(quadratic(x)).epsilon(1e-6));
+  }
+
+  const arma::vec values = { 1.0, 2.0, 3.0, 4.0 };
+  const arma::vec swapped = { 2.0, 1.0, 3.0, 4.0 };
+  REQUIRE(QuadraticSurrogate::KendallTau(values, values) == Approx(1.0));
+  REQUIRE(QuadraticSurrogate::KendallTau(values, -values) == Approx(-1.0));
+  REQUIRE(QuadraticSurrogate::KendallTau(values, swapped) ==
+      Approx(4.0 / 6.0));
+}
+
+/**
+ * Make sure that the surrogate-assisted CMA-ES (lq-CMA-ES) finds the optimum
+ * of the sphere function with far fewer evaluations than CMA-ES.
+ */
+TEST_CASE("SurrogateCMAESSphereFunctionTest", "[CMAESTest]")
+{
+  SphereFunction f(4);
+
+  CMAES<> cmaes(0, -1, 1, 32, 100, -1);
+  arma::mat coordinates = f.GetInitialPoint();
+  const double objective = cmaes.Optimize(f, coordinates);
+
+  CMAES<> lqCMAES(0, -1, 1, 32, 100, -1);
+  lqCMAES.Surrogate() = true;
+  arma::mat lqCoordinates = f.GetInitialPoint();
+  const double lqObjective = lqCMAES.Optimize(f, lqCoordinates);
+
+  REQUIRE(objective == Approx(0.0).margin(1e-3));
+  REQUIRE(lqObjective == Approx(0.0).margin(1e-3));
+  REQUIRE(lqObjective == Approx(f.Evaluate(lqCoordinates)).margin(1e-10));
+  REQUIRE(lqCMAES.Evaluations() < cmaes.Evaluations() / 4);
+}
@@ -41,3 +41,99 @@ TEST_CASE("CNELogisticRegressionTest", "[CNETest]")
       coordinates);
   REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
 }
+
+/**
+ * Train and test a logistic regression function using CNE with parallel
+ * fitness evaluation.
+ */
+TEST_CASE("CNEParallelLogisticRegressionTest", "[CNETest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  CNE opt(200, 1000, 0.2, 0.2, 0.2, 1e-5, true);
+  REQUIRE(opt.ParallelEvaluation() == true);
+
+  arma::mat coordinates = lr.GetInitialPoint();
+  opt.Optimize(lr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+/**
+ * Train and test a logistic regression function using CNE in the steady
+ * state, with several evaluations in flight.
+ */
+TEST_CASE("CNESteadyStateLogisticRegressionTest", "[CNETest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  CNE opt(200, 300, 0.2, 0.2, 0.2, -1, false, 4);
+  REQUIRE(opt.SteadyStateWorkers() == 4);
+
+  arma::mat coordinates = lr.GetInitialPoint();
+  opt.Optimize(lr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+/**
+ * A squared norm that counts its evaluations.
+ */
+class CountingSquaredNorm
+{
+ public:
+  CountingSquaredNorm() : evaluations(0) { }
+
+  double Evaluate(const arma::mat& coordinates)
+  {
+    ++evaluations;
+    return arma::accu(arma::square(coordinates));
+  }
+
+  size_t evaluations;
+};
+
+/**
+ * Make sure the best candidate, which is carried over unchanged, is not
+ * evaluated again in the next generation.
+ */
+TEST_CASE("CNECachedEliteFitnessTest", "[CNETest]")
+{
+  CountingSquaredNorm f;
+
+  // A negative tolerance never terminates early.
+  const size_t populationSize = 20;
+  const size_t maxGenerations = 10;
+  CNE opt(populationSize, maxGenerations, 0.1, 0.02, 0.2, -1);
+  arma::mat coordinates(5, 1, arma::fill::ones);
+  const double result = opt.Optimize(f, coordinates);
+
+  // The starting point and the result are evaluated once each, every
+  // candidate in the first generation, and at most all but the best one in
+  // the later generations.
+  REQUIRE(f.evaluations <= 2 + populationSize + (maxGenerations - 1) *
+      (populationSize - 1));
+  REQUIRE(result == Approx(arma::accu(arma::square(coordinates))));
+}
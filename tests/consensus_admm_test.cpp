@@ -0,0 +1,91 @@
+/**
+ * @file consensus_admm_test.cpp
+ *
+ * Test file for the ConsensusADMM optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Run ConsensusADMM with L-BFGS on four shards of a logistic regression
+ * problem, and make sure that it finds the optimum found by L-BFGS on the
+ * whole problem.
+ */
+TEST_CASE("ConsensusADMMLogisticRegressionTest", "[ConsensusADMMTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  L_BFGS lbfgs;
+  arma::mat lbfgsCoordinates = lr.GetInitialPoint();
+  const double lbfgsObjective = lbfgs.Optimize(lr, lbfgsCoordinates);
+
+  ConsensusADMM<> admm(1.0, 4, 200);
+  arma::mat coordinates = lr.GetInitialPoint();
+  const double objective = admm.Optimize(lr, coordinates);
+
+  // The returned objective is the one of the consensus variable.
+  REQUIRE(objective == Approx(lr.Evaluate(coordinates)).epsilon(1e-7));
+  REQUIRE(objective == Approx(lbfgsObjective).epsilon(1e-3));
+  CheckMatrices(coordinates, lbfgsCoordinates, 1.0);
+
+  // The residuals met the tolerances.
+  REQUIRE(admm.PrimalResidual() < 1e-2);
+  REQUIRE(admm.DualResidual() < 1e-2);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+/**
+ * With a fixed penalty, ConsensusADMM should still converge, only in more
+ * rounds.
+ */
+TEST_CASE("ConsensusADMMFixedPenaltyTest", "[ConsensusADMMTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  ConsensusADMM<> admm(10.0, 3, 500, 1e-6, 1e-4, false);
+  arma::mat coordinates = lr.GetInitialPoint();
+  admm.Optimize(lr, coordinates);
+
+  REQUIRE(admm.FinalRho() == 10.0);
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+}
+
+/**
+ * A penalty parameter that is not positive should be rejected.
+ */
+TEST_CASE("ConsensusADMMInvalidRhoTest", "[ConsensusADMMTest]")
+{
+  SGDTestFunction f;
+  arma::mat coordinates = f.GetInitialPoint();
+
+  ConsensusADMM<> admm(0.0, 2);
+  REQUIRE_THROWS_AS(admm.Optimize(f, coordinates), std::invalid_argument);
+}
@@ -39,3 +39,89 @@ TEST_CASE("DELogisticRegressionTest", "[DETest]")
       coordinates);
   REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
 }
+
+/**
+ * Train and test a logistic regression function using DE with whole
+ * generations built and evaluated at once.
+ */
+TEST_CASE("DEBatchGenerationLogisticRegressionTest", "[DETest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  DE opt(200, 1000, 0.6, 0.8, -1, true);
+  REQUIRE(opt.BatchGeneration() == true);
+
+  arma::mat coordinates = lr.GetInitialPoint();
+  opt.Optimize(lr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+/**
+ * Train and test a logistic regression function using DE in the steady
+ * state, with several evaluations in flight.
+ */
+TEST_CASE("DESteadyStateLogisticRegressionTest", "[DETest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  DE opt(200, 1000, 0.6, 0.8, -1, false, 4);
+  REQUIRE(opt.SteadyStateWorkers() == 4);
+
+  arma::mat coordinates = lr.GetInitialPoint();
+  opt.Optimize(lr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+/**
+ * Make sure that the random numbers of DE follow Armadillo's seed, whether the
+ * generations are built member by member or all at once.
+ */
+TEST_CASE("DESeedTest", "[DETest]")
+{
+  RosenbrockFunction f;
+  for (size_t batchGeneration = 0; batchGeneration < 2; ++batchGeneration)
+  {
+    DE optimizer(50, 100, 0.6, 0.8, 1e-5, batchGeneration == 1);
+
+    arma::arma_rng::set_seed(17);
+    arma::mat first = f.GetInitialPoint();
+    optimizer.Optimize(f, first);
+
+    arma::arma_rng::set_seed(17);
+    arma::mat second = f.GetInitialPoint();
+    optimizer.Optimize(f, second);
+
+    REQUIRE(arma::approx_equal(first, second, "absdiff", 0.0));
+
+    // A different seed must give a different population.
+    arma::arma_rng::set_seed(18);
+    arma::mat third = f.GetInitialPoint();
+    optimizer.Optimize(f, third);
+
+    REQUIRE(!arma::approx_equal(first, third, "absdiff", 0.0));
+  }
+}
@@ -0,0 +1,516 @@
+/**
+ * @file distributed_sgd_test.cpp
+ *
+ * Test file for the DistributedSGD optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * A group of threads that play the ranks of a distributed job.  The
+ * collective operations wait until every rank has called them.
+ */
+class ThreadGroup
+{
+ public:
+  ThreadGroup(const size_t size) : size(size), arrived(0), generation(0) { }
+
+  template<typename ElemType>
+  void AllReduce(ElemType* values, const size_t n)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (arrived == 0)
+      sum.assign(n, 0.0);
+    for (size_t j = 0; j < n; ++j)
+      sum[j] += values[j];
+    Wait(lock);
+
+    for (size_t j = 0; j < n; ++j)
+      values[j] = ElemType(sum[j]);
+    // Nobody may start the next operation before everybody has read the sum.
+    Wait(lock);
+  }
+
+  template<typename ElemType>
+  void Broadcast(ElemType* values, const size_t n, const size_t rank,
+                 const size_t root)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (rank == root)
+      sum.assign(values, values + n);
+    Wait(lock);
+
+    for (size_t j = 0; j < n; ++j)
+      values[j] = ElemType(sum[j]);
+    Wait(lock);
+  }
+
+  void AllGather(const char* send, const size_t bytes, const size_t rank,
+                 char* receive)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    gathered.resize(size * bytes);
+    std::memcpy(gathered.data() + rank * bytes, send, bytes);
+    Wait(lock);
+
+    std::memcpy(receive, gathered.data(), size * bytes);
+    Wait(lock);
+  }
+
+  void AllToAll(const std::vector<std::vector<char>>& send, const size_t rank,
+                std::vector<std::vector<char>>& receive)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    exchanged.resize(size);
+    exchanged[rank] = send;
+    Wait(lock);
+
+    receive.resize(size);
+    for (size_t r = 0; r < size; ++r)
+      receive[r] = exchanged[r][rank];
+    Wait(lock);
+  }
+
+  size_t Size() const { return size; }
+
+ private:
+  //! Wait until all the ranks have arrived.
+  void Wait(std::unique_lock<std::mutex>& lock)
+  {
+    const size_t currentGeneration = generation;
+    if (++arrived == size)
+    {
+      arrived = 0;
+      ++generation;
+      condition.notify_all();
+    }
+    else
+    {
+      condition.wait(lock, [&] { return generation != currentGeneration; });
+    }
+  }
+
+  size_t size;
+  size_t arrived;
+  size_t generation;
+  std::vector<double> sum;
+  std::vector<char> gathered;
+  std::vector<std::vector<std::vector<char>>> exchanged;
+  std::mutex mutex;
+  std::condition_variable condition;
+};
+
+/**
+ * The communicator of one rank of a ThreadGroup.
+ */
+class ThreadCommunicator
+{
+ public:
+  ThreadCommunicator(ThreadGroup* group = NULL, const size_t rank = 0) :
+      group(group), rank(rank) { }
+
+  size_t Rank() const { return rank; }
+  size_t Size() const { return group->Size(); }
+
+  template<typename ElemType>
+  void AllReduce(ElemType* values, const size_t n) const
+  {
+    group->AllReduce(values, n);
+  }
+
+  template<typename ElemType>
+  void Broadcast(ElemType* values, const size_t n, const size_t root) const
+  {
+    group->Broadcast(values, n, rank, root);
+  }
+
+  void AllGather(const char* send, const size_t bytes, char* receive) const
+  {
+    group->AllGather(send, bytes, rank, receive);
+  }
+
+  void AllToAll(const std::vector<std::vector<char>>& send,
+                std::vector<std::vector<char>>& receive) const
+  {
+    group->AllToAll(send, rank, receive);
+  }
+
+ private:
+  ThreadGroup* group;
+  size_t rank;
+};
+
+/**
+ * With a single rank, DistributedSGD should take exactly the steps of SGD.
+ */
+TEST_CASE("LocalDistributedSGDMatchesSGDTest", "[DistributedSGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  StandardSGD sgd(0.01, 32, 20000, 1e-5, false);
+  arma::mat sgdCoordinates = lr.GetInitialPoint();
+  const double sgdObjective = sgd.Optimize(lr, sgdCoordinates);
+
+  DistributedSGD<> dsgd(0.01, 32, 20000, 1e-5, false);
+  arma::mat coordinates = lr.GetInitialPoint();
+  const double objective = dsgd.Optimize(lr, coordinates);
+
+  CheckMatrices(coordinates, sgdCoordinates);
+  REQUIRE(objective == Approx(sgdObjective).epsilon(1e-7));
+}
+
+/**
+ * Run DistributedSGD with momentum and the given compression on four ranks,
+ * each with a shard of a different size, and make sure that all the ranks end
+ * at the same point and that the results are acceptable.
+ */
+template<typename CompressionType>
+void DistributedLogisticRegressionTest(const CompressionType& compression)
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  const size_t ranks = 4;
+  const size_t bounds[ranks + 1] = { 0, 150, 400, 700, 1000 };
+  std::vector<arma::mat> shardData(ranks);
+  std::vector<arma::Row<size_t>> shardResponses(ranks);
+  for (size_t r = 0; r < ranks; ++r)
+  {
+    shardData[r] = shuffledData.cols(bounds[r], bounds[r + 1] - 1);
+    shardResponses[r] = shuffledResponses.cols(bounds[r], bounds[r + 1] - 1);
+  }
+
+  ThreadGroup group(ranks);
+  std::vector<arma::mat> coordinates(ranks);
+  std::vector<double> objectives(ranks);
+  std::vector<std::thread> threads;
+  for (size_t r = 0; r < ranks; ++r)
+  {
+    threads.push_back(std::thread([&, r]()
+    {
+      // The regularization of each shard is its share of the regularization
+      // of the full dataset.
+      LogisticRegression<> lr(shardData[r], shardResponses[r],
+          0.5 * shardData[r].n_cols / shuffledData.n_cols);
+
+      // Only the starting point of rank 0 should be used.
+      coordinates[r] = lr.GetInitialPoint() + double(r);
+
+      DistributedSGD<MomentumUpdate, NoDecay, ThreadCommunicator,
+          CompressionType> dsgd(0.0025, 32, 100000, 1e-5, true,
+          MomentumUpdate(0.5), NoDecay(), true, ThreadCommunicator(&group, r),
+          compression);
+      objectives[r] = dsgd.Optimize(lr, coordinates[r]);
+    }));
+  }
+  for (size_t r = 0; r < ranks; ++r)
+    threads[r].join();
+
+  for (size_t r = 1; r < ranks; ++r)
+  {
+    CheckMatrices(coordinates[r], coordinates[0], 1e-10);
+    REQUIRE(objectives[r] == Approx(objectives[0]).epsilon(1e-10));
+  }
+
+  // The objective is the one over the full dataset.
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+  REQUIRE(objectives[0] == Approx(lr.Evaluate(coordinates[0])).epsilon(1e-7));
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates[0]);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates[0]);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+TEST_CASE("ThreadDistributedSGDLogisticRegressionTest", "[DistributedSGDTest]")
+{
+  DistributedLogisticRegressionTest(NoCompression());
+}
+
+TEST_CASE("TopKDistributedSGDLogisticRegressionTest", "[DistributedSGDTest]")
+{
+  DistributedLogisticRegressionTest(TopKCompression(0.5));
+}
+
+TEST_CASE("QuantizedDistributedSGDLogisticRegressionTest",
+          "[DistributedSGDTest]")
+{
+  DistributedLogisticRegressionTest(QuantizedCompression(8));
+}
+
+/**
+ * Make sure that top-k compression sends exactly the largest entries.
+ */
+TEST_CASE("TopKCompressionTest", "[DistributedSGDTest]")
+{
+  arma::mat values("0.1 -5.0 0.3; 2.0 -0.2 4.0");
+  TopKCompression compression(0.5);
+  std::vector<char> message(compression.MessageSize<double>(values.n_elem));
+  compression.Encode(values, message.data());
+
+  arma::mat decoded(2, 3);
+  decoded.fill(1.0);
+  compression.Decode(message.data(), decoded);
+
+  // The decoded values are added.
+  arma::mat expected("1.0 -4.0 1.0; 3.0 1.0 5.0");
+  CheckMatrices(decoded, expected, 1e-12);
+}
+
+/**
+ * Make sure that the quantization error is within half a level, and that one
+ * bit gives the signs scaled by the mean magnitude.
+ */
+TEST_CASE("QuantizedCompressionTest", "[DistributedSGDTest]")
+{
+  arma::mat values(10, 7, arma::fill::randn);
+  arma::mat decoded(10, 7);
+
+  QuantizedCompression compression(8);
+  std::vector<char> message(compression.MessageSize<double>(values.n_elem));
+  REQUIRE(message.size() == sizeof(double) + 70);
+  compression.Encode(values, message.data());
+  decoded.zeros();
+  compression.Decode(message.data(), decoded);
+
+  const double maxValue = arma::max(arma::abs(arma::vectorise(values)));
+  REQUIRE(arma::max(arma::abs(arma::vectorise(decoded - values))) <=
+      0.5 * maxValue / 127 + 1e-12);
+
+  QuantizedCompression signs(1);
+  message.resize(signs.MessageSize<double>(values.n_elem));
+  REQUIRE(message.size() == sizeof(double) + 9);
+  signs.Encode(values, message.data());
+  decoded.zeros();
+  signs.Decode(message.data(), decoded);
+
+  const double mean = arma::mean(arma::abs(arma::vectorise(values)));
+  for (size_t i = 0; i < values.n_elem; ++i)
+    REQUIRE(decoded[i] == Approx(values[i] >= 0 ? mean : -mean));
+}
+
+/**
+ * Make sure that the rows of a ShardedIterate are split evenly, that other
+ * rows can only be read once they are cached, and that they are recorded when
+ * the iterate is recording.
+ */
+TEST_CASE("ShardedIterateTest", "[DistributedSGDTest]")
+{
+  ShardedIterate x(10, 2, 1, 3);
+  REQUIRE(x.n_elem == 20);
+  REQUIRE(x.FirstRow(0) == 0);
+  REQUIRE(x.FirstRow() == 4);
+  REQUIRE(x.FirstRow(2) == 7);
+  REQUIRE(x.FirstRow(3) == 10);
+  REQUIRE(x.LocalRows() == 3);
+  for (size_t row = 0; row < 10; ++row)
+    REQUIRE(x.Owner(row) == ((row < 4) ? 0 : (row < 7) ? 1 : 2));
+
+  x(5, 1) = 2.5;
+  REQUIRE(x.Local()(1, 1) == 2.5);
+  REQUIRE_THROWS_AS(x(2, 0) = 1.0, std::out_of_range);
+
+  const ShardedIterate& cx = x;
+  REQUIRE(cx(5, 1) == 2.5);
+  REQUIRE(cx[15] == 2.5);
+  REQUIRE_THROWS_AS(cx(8, 0), std::out_of_range);
+
+  // Recorded rows read as 0.
+  x.Record();
+  REQUIRE(cx(8, 0) == 0.0);
+  REQUIRE(cx(2, 1) == 0.0);
+  REQUIRE(cx(8, 1) == 0.0);
+  REQUIRE(cx(4, 0) == 0.0);
+  const std::vector<size_t> missing = x.TakeMissingRows();
+  REQUIRE(missing.size() == 2);
+  REQUIRE(missing[0] == 2);
+  REQUIRE(missing[1] == 8);
+  REQUIRE(!x.Recording());
+
+  x.CacheRows(missing, arma::mat("1.0 3.0; 2.0 4.0"));
+  REQUIRE(x.CachedRows() == 2);
+  REQUIRE(cx(2, 0) == 1.0);
+  REQUIRE(cx(2, 1) == 2.0);
+  REQUIRE(cx(8, 1) == 4.0);
+  REQUIRE_THROWS_AS(x(8, 1) = 0.0, std::out_of_range);
+
+  x.ClearCache();
+  REQUIRE_THROWS_AS(cx(2, 0), std::out_of_range);
+
+  // Fewer rows than shards.
+  ShardedIterate y(2, 1, 2, 3);
+  REQUIRE(y.LocalRows() == 0);
+  REQUIRE(y.Owner(1) == 1);
+}
+
+/**
+ * The shard of an embedding regression: function g pulls the row
+ * (7919 g) % n of the table towards a fixed target.  Every row is the target of
+ * two functions, which are usually on different ranks, and the rows mostly
+ * belong to other ranks than the functions that read them.
+ */
+class ShardedEmbeddingFunction
+{
+ public:
+  ShardedEmbeddingFunction(const size_t begin, const size_t end) :
+      begin(begin), end(end) { }
+
+  static size_t Rows() { return 1000; }
+  static size_t Cols() { return 3; }
+
+  static double Target(const size_t row, const size_t col)
+  {
+    return std::sin(row + 2.0 * col);
+  }
+
+  size_t Row(const size_t i) const { return ((begin + i) * 7919) % Rows(); }
+
+  size_t NumFunctions() const { return end - begin; }
+
+  double Evaluate(const ShardedIterate& coordinates,
+                  const size_t first,
+                  const size_t batchSize = 1) const
+  {
+    double objective = 0.0;
+    for (size_t i = first; i < first + batchSize; ++i)
+    {
+      for (size_t c = 0; c < Cols(); ++c)
+      {
+        objective += std::pow(coordinates(Row(i), c) - Target(Row(i), c),
+            2.0);
+      }
+    }
+    return objective;
+  }
+
+  void Gradient(const ShardedIterate& coordinates,
+                const size_t first,
+                arma::sp_mat& gradient,
+                const size_t batchSize = 1) const
+  {
+    gradient.zeros(coordinates.n_rows, coordinates.n_cols);
+    for (size_t i = first; i < first + batchSize; ++i)
+    {
+      for (size_t c = 0; c < Cols(); ++c)
+      {
+        gradient(Row(i), c) += 2.0 * (coordinates(Row(i), c) -
+            Target(Row(i), c));
+      }
+    }
+  }
+
+ private:
+  size_t begin;
+  size_t end;
+};
+
+/**
+ * Run ShardedSGD with the given update policy on four ranks, each with its
+ * shard of the table and a shard of the data of a different size, and make
+ * sure that every row reaches its target.
+ */
+template<typename UpdatePolicyType>
+void ShardedEmbeddingTest(const double stepSize)
+{
+  const size_t ranks = 4;
+  const size_t bounds[ranks + 1] = { 0, 300, 800, 1300, 2000 };
+
+  ThreadGroup group(ranks);
+  std::vector<arma::mat> shards(ranks);
+  std::vector<size_t> firstRows(ranks);
+  std::vector<double> objectives(ranks);
+  std::vector<std::thread> threads;
+  for (size_t r = 0; r < ranks; ++r)
+  {
+    threads.push_back(std::thread([&, r]()
+    {
+      ShardedEmbeddingFunction f(bounds[r], bounds[r + 1]);
+      ShardedIterate coordinates(ShardedEmbeddingFunction::Rows(),
+          ShardedEmbeddingFunction::Cols(), r, ranks);
+
+      ShardedSGD<ConstantStep, UpdatePolicyType, ThreadCommunicator> s(200,
+          10, 1e-10, true, ConstantStep(stepSize), UpdatePolicyType(),
+          ThreadCommunicator(&group, r));
+      objectives[r] = s.Optimize(f, coordinates);
+      shards[r] = coordinates.Local();
+      firstRows[r] = coordinates.FirstRow();
+    }));
+  }
+  for (size_t r = 0; r < ranks; ++r)
+    threads[r].join();
+
+  for (size_t r = 0; r < ranks; ++r)
+  {
+    REQUIRE(objectives[r] == Approx(objectives[0]).epsilon(1e-10));
+    REQUIRE(shards[r].n_rows == ShardedEmbeddingFunction::Rows() / ranks);
+    for (size_t i = 0; i < shards[r].n_rows; ++i)
+    {
+      for (size_t c = 0; c < shards[r].n_cols; ++c)
+      {
+        REQUIRE(shards[r](i, c) == Approx(ShardedEmbeddingFunction::Target(
+            firstRows[r] + i, c)).margin(1e-3));
+      }
+    }
+  }
+  REQUIRE(objectives[0] == Approx(0.0).margin(1e-6));
+}
+
+TEST_CASE("ShardedSGDEmbeddingTest", "[DistributedSGDTest]")
+{
+  ShardedEmbeddingTest<AtomicUpdate>(0.2);
+}
+
+TEST_CASE("SparseAdaGradShardedSGDEmbeddingTest", "[DistributedSGDTest]")
+{
+  ShardedEmbeddingTest<SparseAdaGradUpdate>(0.5);
+}
+
+/**
+ * With a single rank, every row is local and ShardedSGD should minimize the
+ * function as well.
+ */
+TEST_CASE("LocalShardedSGDEmbeddingTest", "[DistributedSGDTest]")
+{
+  ShardedEmbeddingFunction f(0, 2000);
+  ShardedIterate coordinates(ShardedEmbeddingFunction::Rows(),
+      ShardedEmbeddingFunction::Cols(), 0, 1);
+
+  ShardedSGD<> s(200, 10, 1e-10, false, ConstantStep(0.2));
+  const double objective = s.Optimize(f, coordinates);
+
+  REQUIRE(objective == Approx(0.0).margin(1e-6));
+  for (size_t i = 0; i < ShardedEmbeddingFunction::Rows(); ++i)
+  {
+    REQUIRE(coordinates(i, 2) == Approx(
+        ShardedEmbeddingFunction::Target(i, 2)).margin(1e-3));
+  }
+
+  // The iterate must hold the shard of the rank.
+  ShardedIterate other(ShardedEmbeddingFunction::Rows(), 1, 1, 2);
+  REQUIRE_THROWS_AS(s.Optimize(f, other), std::invalid_argument);
+}
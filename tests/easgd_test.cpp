@@ -0,0 +1,95 @@
+/**
+ * @file easgd_test.cpp
+ *
+ * Test file for the EASGD optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * With a single worker that communicates once per epoch, one epoch of EASGD
+ * should move the center by movingRate times the step of one epoch of SGD.
+ */
+TEST_CASE("SingleWorkerEASGDElasticStepTest", "[EASGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+  const size_t numFunctions = lr.NumFunctions();
+
+  StandardSGD sgd(0.01, 32, numFunctions, 1e-5, false);
+  arma::mat sgdCoordinates = lr.GetInitialPoint();
+  sgd.Optimize(lr, sgdCoordinates);
+
+  EASGD<> easgd(0.01, 32, numFunctions, 0.5, 1, numFunctions, 1e-5, false);
+  arma::mat coordinates = lr.GetInitialPoint();
+  const double objective = easgd.Optimize(lr, coordinates);
+
+  const arma::mat expected = lr.GetInitialPoint() +
+      0.5 * (sgdCoordinates - lr.GetInitialPoint());
+  CheckMatrices(coordinates, expected);
+  REQUIRE(objective == Approx(lr.Evaluate(coordinates)).epsilon(1e-7));
+}
+
+/**
+ * Run EASGD with momentum on four workers and make sure the results are
+ * acceptable.
+ */
+TEST_CASE("EASGDLogisticRegressionTest", "[EASGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  EASGD<MomentumUpdate> easgd(0.01, 8, 4, 0.9, 4, 100000, 1e-5, true,
+      MomentumUpdate(0.5));
+  arma::mat coordinates = lr.GetInitialPoint();
+  const double objective = easgd.Optimize(lr, coordinates);
+
+  // The returned objective is the one of the center variable.
+  REQUIRE(objective == Approx(lr.Evaluate(coordinates)).epsilon(1e-7));
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+/**
+ * A zero communication period or a moving rate outside (0, 1] should be
+ * rejected.
+ */
+TEST_CASE("EASGDInvalidParametersTest", "[EASGDTest]")
+{
+  SGDTestFunction f;
+  arma::mat coordinates = f.GetInitialPoint();
+
+  EASGD<> easgd(0.01, 1, 0, 0.9, 2);
+  REQUIRE_THROWS_AS(easgd.Optimize(f, coordinates), std::invalid_argument);
+
+  easgd.CommunicationPeriod() = 10;
+  easgd.MovingRate() = 0.0;
+  REQUIRE_THROWS_AS(easgd.Optimize(f, coordinates), std::invalid_argument);
+
+  easgd.MovingRate() = 1.5;
+  REQUIRE_THROWS_AS(easgd.Optimize(f, coordinates), std::invalid_argument);
+}
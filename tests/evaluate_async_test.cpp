@@ -0,0 +1,211 @@
+/**
+ * @file evaluate_async_test.cpp
+ *
+ * Test file for the asynchronous evaluation of functions with an
+ * EvaluateAsync() method.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * The sphere function, which can also be evaluated asynchronously, each
+ * evaluation running in its own thread as a remote call would.
+ */
+class AsyncSphereFunction : public SphereFunction
+{
+ public:
+  AsyncSphereFunction(const size_t n) : SphereFunction(n), started(0) { }
+
+  std::future<double> EvaluateAsync(const arma::mat& coordinates)
+  {
+    ++started;
+    const arma::mat point = coordinates;
+    return std::async(std::launch::async, [this, point]()
+    {
+      return SphereFunction::Evaluate(point);
+    });
+  }
+
+  //! The number of evaluations started.
+  std::atomic<size_t> started;
+};
+
+/**
+ * Make sure that EvaluateInFlight() collects every objective in order, and
+ * never has more than the given number of evaluations in flight.
+ */
+TEST_CASE("EvaluateInFlightTest", "[EvaluateAsyncTest]")
+{
+  AsyncSphereFunction f(2);
+  std::vector<arma::mat> points(20);
+  for (size_t i = 0; i < points.size(); ++i)
+    points[i] = { (double) i, 1.0 };
+
+  for (const size_t maxInFlight : { 0, 1, 3 })
+  {
+    std::vector<double> objectives;
+    size_t maxStarted = 0;
+    f.started = 0;
+    EvaluateInFlight(f, points.size(),
+        [&](const size_t i) -> const arma::mat& { return points[i]; },
+        [&](const size_t i, const double objective)
+        {
+          REQUIRE(i == objectives.size());
+          objectives.push_back(objective);
+          maxStarted = std::max(maxStarted, f.started - i);
+        }, maxInFlight);
+
+    REQUIRE(objectives.size() == points.size());
+    for (size_t i = 0; i < points.size(); ++i)
+      REQUIRE(objectives[i] == Approx(i * i + 1.0));
+    REQUIRE(maxStarted == ((maxInFlight == 0) ? points.size() : maxInFlight));
+  }
+}
+
+/**
+ * Make sure that an exception of an asynchronous evaluation reaches the
+ * caller.
+ */
+TEST_CASE("EvaluateInFlightExceptionTest", "[EvaluateAsyncTest]")
+{
+  struct FailingFunction
+  {
+    std::future<double> EvaluateAsync(const arma::mat& coordinates)
+    {
+      const double value = coordinates[0];
+      return std::async(std::launch::async, [value]()
+      {
+        if (value == 3.0)
+          throw std::runtime_error("evaluation failed");
+        return value;
+      });
+    }
+  } f;
+
+  std::vector<arma::mat> points(10);
+  for (size_t i = 0; i < points.size(); ++i)
+    points[i] = arma::mat(1, 1).fill((double) i);
+
+  REQUIRE_THROWS_AS(EvaluateInFlight(f, points.size(),
+      [&](const size_t i) -> const arma::mat& { return points[i]; },
+      [](const size_t, const double) { }), std::runtime_error);
+}
+
+/**
+ * Run the given optimizer on the asynchronous and on the synchronous sphere
+ * function, and make sure that the asynchronous evaluations were used and
+ * gave the same result.
+ */
+template<typename OptimizerType>
+void CheckAsyncOptimizer(OptimizerType& optimizer)
+{
+  SphereFunction f(5);
+  AsyncSphereFunction asyncF(5);
+
+  arma::arma_rng::set_seed(42);
+  arma::mat coordinates = f.GetInitialPoint();
+  const double objective = optimizer.Optimize(f, coordinates);
+
+  arma::arma_rng::set_seed(42);
+  arma::mat asyncCoordinates = asyncF.GetInitialPoint();
+  const double asyncObjective = optimizer.Optimize(asyncF, asyncCoordinates);
+
+  REQUIRE(asyncF.started > 0);
+  REQUIRE(asyncObjective == Approx(objective).epsilon(1e-10));
+  REQUIRE(arma::approx_equal(asyncCoordinates, coordinates, "absdiff",
+      1e-10));
+}
+
+/**
+ * The population-based optimizers and SPSA can keep their evaluations in
+ * flight.
+ */
+TEST_CASE("AsyncEvaluationOptimizersTest", "[EvaluateAsyncTest]")
+{
+  CNE cne(20, 20, 0.1, 0.02, 0.2, -1.0);
+  CheckAsyncOptimizer(cne);
+
+  DE de(20, 20, 0.6, 0.8, -1.0);
+  CheckAsyncOptimizer(de);
+
+  CMAES<> cmaes(0, -1, 1, 5, 20, -1.0);
+  CheckAsyncOptimizer(cmaes);
+
+  SPSA spsa(0.602, 0.101, 0.16, 0.3, 100, -1.0, true, 4);
+  CheckAsyncOptimizer(spsa);
+}
+
+/**
+ * A categorical function with an EvaluateAsync() method; its minimum is at
+ * [2, 1, 3].
+ */
+class AsyncCategoricalFunction
+{
+ public:
+  AsyncCategoricalFunction() : started(0) { }
+
+  double Evaluate(const arma::mat& x)
+  {
+    return std::abs(x[0] - 2) + std::abs(x[1] - 1) + std::abs(x[2] - 3);
+  }
+
+  std::future<double> EvaluateAsync(const arma::mat& x)
+  {
+    ++started;
+    const arma::mat point = x;
+    return std::async(std::launch::async,
+        [this, point]() { return Evaluate(point); });
+  }
+
+  std::atomic<size_t> started;
+};
+
+/**
+ * Make sure that GridSearch uses the asynchronous evaluations.
+ */
+TEST_CASE("AsyncGridSearchTest", "[EvaluateAsyncTest]")
+{
+  AsyncCategoricalFunction f;
+  std::vector<bool> categoricalDimensions(3, true);
+  arma::Row<size_t> numCategories("4 3 5");
+
+  GridSearch gs(false, 8);
+  arma::mat parameters;
+  const double objective = gs.Optimize(f, parameters, categoricalDimensions,
+      numCategories);
+
+  REQUIRE(f.started == 60);
+  REQUIRE(objective == 0.0);
+  REQUIRE(parameters[0] == 2);
+  REQUIRE(parameters[1] == 1);
+  REQUIRE(parameters[2] == 3);
+}
+
+/**
+ * Make sure that the steady-state variants of CNE and DE keep the
+ * asynchronous evaluations in flight, and still converge.
+ */
+TEST_CASE("AsyncSteadyStateTest", "[EvaluateAsyncTest]")
+{
+  AsyncSphereFunction f(5);
+
+  DE de(20, 200, 0.6, 0.8, -1.0, false, 8);
+  arma::mat coordinates = f.GetInitialPoint();
+  REQUIRE(de.Optimize(f, coordinates) < 1e-3);
+  REQUIRE(f.started >= 20);
+
+  f.started = 0;
+  CNE cne(50, 200, 0.1, 0.1, 0.2, -1.0, false, 8);
+  coordinates = f.GetInitialPoint();
+  REQUIRE(cne.Optimize(f, coordinates) < 1e-1);
+  REQUIRE(f.started >= 50);
+}
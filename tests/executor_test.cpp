@@ -0,0 +1,181 @@
+/**
+ * @file executor_test.cpp
+ *
+ * Test file for the executors that run the parallel loops of the optimizers.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Make sure that the std::thread executor runs every task once, and that
+ * ParallelSum() adds up the terms.
+ */
+TEST_CASE("ThreadsExecutorTest", "[ExecutorTest]")
+{
+  const Executor executor = Executor::Threads(4);
+  REQUIRE(executor.NumThreads() == 4);
+
+  std::vector<std::atomic<size_t>> counts(1000);
+  for (std::atomic<size_t>& count : counts)
+    count = 0;
+  executor.ParallelFor(counts.size(), [&](const size_t i) { ++counts[i]; });
+  for (size_t i = 0; i < counts.size(); ++i)
+    REQUIRE(counts[i] == 1);
+
+  // Both the small sums and the large ones.
+  for (const size_t n : { 10, 1000 })
+  {
+    const double sum = executor.ParallelSum<double>(n,
+        [](const size_t i) { return (double) i; });
+    REQUIRE(sum == Approx(n * (n - 1) / 2.0));
+  }
+}
+
+/**
+ * Make sure that a loop started from a task runs serially.
+ */
+TEST_CASE("NestedExecutorTest", "[ExecutorTest]")
+{
+  const Executor executor = Executor::Threads(4);
+  std::vector<size_t> innerThreads(8, 0);
+  std::vector<size_t> innerSums(8, 0);
+  executor.ParallelFor(innerThreads.size(), [&](const size_t i)
+  {
+    innerThreads[i] = executor.NumThreads();
+    executor.ParallelFor(10, [&](const size_t j) { innerSums[i] += j; });
+  });
+
+  for (size_t i = 0; i < innerThreads.size(); ++i)
+  {
+    REQUIRE(innerThreads[i] == 1);
+    REQUIRE(innerSums[i] == 45);
+  }
+}
+
+/**
+ * Make sure that an exception thrown by a task of the std::thread executor
+ * reaches the caller.
+ */
+TEST_CASE("ThreadsExecutorExceptionTest", "[ExecutorTest]")
+{
+  const Executor executor = Executor::Threads(3);
+  REQUIRE_THROWS_AS(executor.ParallelFor(100, [](const size_t i)
+  {
+    if (i == 42)
+      throw std::runtime_error("task failed");
+  }), std::runtime_error);
+}
+
+/**
+ * Make sure that the optimizers run their parallel loops with a user-provided
+ * default executor, and that the results do not depend on it.
+ */
+TEST_CASE("CustomExecutorCMAESTest", "[ExecutorTest]")
+{
+  SphereFunction f(10);
+  CMAES<> cmaes(0, -1, 1, 10, 50, -1);
+  CMAES<> parallelCmaes(0, -1, 1, 10, 50, -1, FullSelection(), true);
+
+  arma::arma_rng::set_seed(42);
+  arma::mat coordinates = f.GetInitialPoint();
+  const double objective = cmaes.Optimize(f, coordinates);
+
+  // Run the tasks in reverse order, and count them.
+  std::atomic<size_t> tasks(0);
+  const Executor previous = DefaultExecutor();
+  SetDefaultExecutor(Executor(2, [&](const size_t n,
+      const Executor::TaskType& task)
+  {
+    for (size_t i = n; i > 0; --i)
+    {
+      ++tasks;
+      task(i - 1);
+    }
+  }));
+
+  arma::arma_rng::set_seed(42);
+  arma::mat parallelCoordinates = f.GetInitialPoint();
+  const double parallelObjective = parallelCmaes.Optimize(f,
+      parallelCoordinates);
+  SetDefaultExecutor(previous);
+
+  REQUIRE(tasks > 0);
+  REQUIRE(parallelObjective == Approx(objective).epsilon(1e-10));
+  for (size_t i = 0; i < coordinates.n_elem; ++i)
+    REQUIRE(parallelCoordinates[i] == Approx(coordinates[i]).margin(1e-10));
+}
+
+/**
+ * Make sure that the thread budget limits the threads of the parallel loops,
+ * and tells BLAS how many threads each task may use while a loop runs, and
+ * that all the threads are given back afterwards.
+ */
+TEST_CASE("ThreadBudgetTest", "[ExecutorTest]")
+{
+  const ThreadBudget previous = DefaultThreadBudget();
+  std::vector<size_t> innerThreads;
+  DefaultThreadBudget() = ThreadBudget(16, 0, [&](const size_t n)
+  {
+    innerThreads.push_back(n);
+  });
+
+  REQUIRE(DefaultThreadBudget().TotalThreads() == 16);
+  REQUIRE(DefaultThreadBudget().InnerThreads(4) == 4);
+  REQUIRE(DefaultThreadBudget().InnerThreads(3) == 5);
+  REQUIRE(DefaultThreadBudget().InnerThreads(32) == 1);
+
+  // A custom executor with 8 threads that runs the tasks in order.
+  const Executor executor(8, [](const size_t n, const Executor::TaskType& task)
+  {
+    for (size_t i = 0; i < n; ++i)
+      task(i);
+  });
+  REQUIRE(executor.NumThreads() == 8);
+
+  size_t sum = 0;
+  executor.ParallelFor(100, [&](const size_t i) { sum += i; });
+  REQUIRE(sum == 4950);
+  REQUIRE(innerThreads == std::vector<size_t>({ 2, 16 }));
+
+  // In a phase with 4 outer threads, each task gets 4 threads; a loop with
+  // fewer tasks gets more threads per task.
+  {
+    ThreadBudget::Phase phase(DefaultThreadBudget(), 4);
+    REQUIRE(executor.NumThreads() == 4);
+
+    executor.ParallelFor(100, [&](const size_t i) { sum += i; });
+    executor.ParallelFor(2, [&](const size_t i) { sum += i; });
+  }
+  REQUIRE(DefaultThreadBudget().OuterThreads() == 0);
+  REQUIRE(executor.NumThreads() == 8);
+  REQUIRE(innerThreads == std::vector<size_t>({ 2, 16, 4, 16, 8, 16 }));
+
+  // Serial loops do not change the inner threads.
+  executor.ParallelFor(1, [&](const size_t i) { sum += i; });
+  Executor::Serial().ParallelFor(10, [&](const size_t i) { sum += i; });
+  REQUIRE(innerThreads.size() == 6);
+
+  // The std::thread executor starts no more threads than the phase allows.
+  {
+    ThreadBudget::Phase phase(DefaultThreadBudget(), 2);
+    std::mutex lock;
+    std::set<std::thread::id> ids;
+    Executor::Threads(8).ParallelFor(1000, [&](const size_t)
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      ids.insert(std::this_thread::get_id());
+    });
+    REQUIRE(ids.size() <= 2);
+  }
+
+  DefaultThreadBudget() = previous;
+}
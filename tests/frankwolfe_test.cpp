@@ -106,6 +106,51 @@ TEST_CASE("FWPruneSupportOMP", "[FrankWolfeTest]")
   REQUIRE(result == Approx(0.0).margin(1e-10));
 }
 
+/**
+ * Make sure that the incrementally factorized span solve of Atoms matches a
+ * direct least squares solve, also after atoms are pruned.
+ */
+TEST_CASE("FWAtomsSpanSolve", "[FrankWolfeTest]")
+{
+  mat A = randn(20, 10);
+  vec b = randn(20);
+  FuncSq f(A, b);
+
+  Atoms atoms;
+  for (size_t i = 0; i < 6; ++i)
+  {
+    vec v = zeros<vec>(10);
+    v(i) = 1;
+    atoms.AddAtom(v, f);
+  }
+
+  // The atoms are stored sparsely.
+  REQUIRE(atoms.CurrentAtoms().n_cols == 6);
+  REQUIRE(atoms.CurrentAtoms().n_nonzero == 6);
+
+  atoms.OptimizeInSpan(f);
+  vec expected = solve(mat(A * atoms.CurrentAtoms()), b);
+  REQUIRE(atoms.CurrentCoeffs().n_elem == 6);
+  for (size_t i = 0; i < 6; ++i)
+    REQUIRE(atoms.CurrentCoeffs()(i) == Approx(expected(i)).margin(1e-8));
+
+  // With a huge tolerance, every atom but one is pruned.
+  atoms.PruneSupport(1e10, f);
+  expected = solve(mat(A * atoms.CurrentAtoms()), b);
+  REQUIRE(atoms.CurrentCoeffs().n_elem == 1);
+  REQUIRE(atoms.CurrentCoeffs()(0) == Approx(expected(0)).margin(1e-8));
+
+  // Adding an atom after pruning must keep the solve consistent.
+  vec v = zeros<vec>(10);
+  v(8) = 1;
+  atoms.AddAtom(v, f);
+  atoms.OptimizeInSpan(f);
+  expected = solve(mat(A * atoms.CurrentAtoms()), b);
+  REQUIRE(atoms.CurrentCoeffs().n_elem == 2);
+  for (size_t i = 0; i < 2; ++i)
+    REQUIRE(atoms.CurrentCoeffs()(i) == Approx(expected(i)).margin(1e-8));
+}
+
 /**
  * Simple test of sparse soluton in atom domain with atom norm constraint.
  */
@@ -178,3 +223,227 @@ TEST_CASE("FWLineSearch", "[FrankWolfeTest]")
   REQUIRE(coordinates[1] - 0.2 == Approx(0.0).margin(1e-4));
   REQUIRE(coordinates[2] - 0.3 == Approx(0.0).margin(1e-4));
 }
+
+/**
+ * Exactly the same problem, with the closed-form line search for quadratic
+ * functions.
+ */
+TEST_CASE("FWQuadraticLineSearch", "[FrankWolfeTest]")
+{
+  TestFuncFW f;
+  double p = 2;   // Constraint set is unit lp ball.
+  ConstrLpBallSolver linearConstrSolver(p);
+  UpdateQuadraticLineSearch updateRule;
+
+  FrankWolfe<ConstrLpBallSolver, UpdateQuadraticLineSearch>
+      s(linearConstrSolver, updateRule);
+
+  vec coordinates = randu<vec>(3);
+  double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-4));
+  REQUIRE(coordinates[0] - 0.1 == Approx(0.0).margin(1e-4));
+  REQUIRE(coordinates[1] - 0.2 == Approx(0.0).margin(1e-4));
+  REQUIRE(coordinates[2] - 0.3 == Approx(0.0).margin(1e-4));
+}
+
+/**
+ * Make sure the closed-form line search finds the same minimum of a squared
+ * loss as the secant method.
+ */
+TEST_CASE("FWQuadraticLineSearchFuncSq", "[FrankWolfeTest]")
+{
+  mat A = randn(10, 5);
+  vec b = randn(10);
+  FuncSq f(A, b);
+
+  for (size_t trial = 0; trial < 10; ++trial)
+  {
+    const mat x1 = randn(5, 1);
+    const mat end = randn(5, 1);
+
+    mat secantX2 = end;
+    LineSearch secant(100000, 1e-10);
+    const double secantResult = secant.Optimize(f, x1, secantX2);
+
+    mat quadraticX2 = end;
+    QuadraticLineSearch quadratic;
+    const double quadraticResult = quadratic.Optimize(f, x1, quadraticX2);
+
+    REQUIRE(quadraticResult == Approx(secantResult).epsilon(1e-6));
+    REQUIRE(quadraticResult <= f.Evaluate(x1) + 1e-10);
+    REQUIRE(quadraticResult <= f.Evaluate(end) + 1e-10);
+    for (size_t i = 0; i < 5; ++i)
+      REQUIRE(quadraticX2[i] == Approx(secantX2[i]).margin(1e-5));
+  }
+}
+
+/**
+ * The same problem with away-step Frank-Wolfe, over the unit l1 ball.
+ */
+TEST_CASE("FWAwayStep", "[FrankWolfeTest]")
+{
+  TestFuncFW f;
+  ConstrLpBallSolver linearConstrSolver(1);
+  UpdateAwayStep updateRule;
+
+  FrankWolfe<ConstrLpBallSolver, UpdateAwayStep>
+      s(linearConstrSolver, updateRule, 10000);
+
+  vec coordinates = zeros<vec>(3);
+  double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-4));
+  REQUIRE(coordinates[0] - 0.1 == Approx(0.0).margin(1e-4));
+  REQUIRE(coordinates[1] - 0.2 == Approx(0.0).margin(1e-4));
+  REQUIRE(coordinates[2] - 0.3 == Approx(0.0).margin(1e-4));
+}
+
+/**
+ * The same problem with pairwise Frank-Wolfe, over the unit l1 ball.
+ */
+TEST_CASE("FWPairwise", "[FrankWolfeTest]")
+{
+  TestFuncFW f;
+  ConstrLpBallSolver linearConstrSolver(1);
+  UpdateAwayStep updateRule(true);
+
+  FrankWolfe<ConstrLpBallSolver, UpdateAwayStep>
+      s(linearConstrSolver, updateRule, 10000);
+
+  vec coordinates = zeros<vec>(3);
+  double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-4));
+  REQUIRE(coordinates[0] - 0.1 == Approx(0.0).margin(1e-4));
+  REQUIRE(coordinates[1] - 0.2 == Approx(0.0).margin(1e-4));
+  REQUIRE(coordinates[2] - 0.3 == Approx(0.0).margin(1e-4));
+
+  // Only the starting point and the vertices of the ball can be active.
+  REQUIRE(s.UpdateRule().ActiveSet().CurrentAtoms().n_cols <= 7);
+  REQUIRE(accu(s.UpdateRule().ActiveSet().CurrentCoeffs()) ==
+      Approx(1.0).epsilon(1e-8));
+}
+
+/**
+ * The same problem with fully-corrective Frank-Wolfe, over the unit l1 ball.
+ */
+TEST_CASE("FWFullyCorrective", "[FrankWolfeTest]")
+{
+  TestFuncFW f;
+  ConstrLpBallSolver linearConstrSolver(1);
+  UpdateFullyCorrective updateRule;
+
+  FrankWolfe<ConstrLpBallSolver, UpdateFullyCorrective>
+      s(linearConstrSolver, updateRule, 100);
+
+  vec coordinates = zeros<vec>(3);
+  double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-4));
+  REQUIRE(coordinates[0] - 0.1 == Approx(0.0).margin(1e-4));
+  REQUIRE(coordinates[1] - 0.2 == Approx(0.0).margin(1e-4));
+  REQUIRE(coordinates[2] - 0.3 == Approx(0.0).margin(1e-4));
+}
+
+/**
+ * Make sure that the structured group solver picks the group with the largest
+ * dual norm, with and without parallel scoring.
+ */
+TEST_CASE("FWStructGroupSolver", "[FrankWolfeTest]")
+{
+  std::vector<arma::uvec> groups;
+  for (size_t i = 0; i < 40; ++i)
+    groups.push_back(regspace<uvec>(3 * i, 3 * i + 2));
+
+  GroupLpBall groupExtractor(2, 120, groups);
+  vec v = 0.1 * randn<vec>(120);
+  v.subvec(60, 62) = vec("3.0 -4.0 0.0");
+
+  ConstrStructGroupSolver<GroupLpBall> serialSolver(groupExtractor);
+  ConstrStructGroupSolver<GroupLpBall> parallelSolver(groupExtractor, true);
+  mat s1, s2;
+  serialSolver.Optimize(v, s1);
+  parallelSolver.Optimize(v, s2);
+
+  REQUIRE(s1.n_elem == 120);
+  REQUIRE(s1(60) == Approx(-0.6));
+  REQUIRE(s1(61) == Approx(0.8));
+  REQUIRE(accu(abs(s1)) == Approx(1.4));
+  REQUIRE(approx_equal(s1, s2, "absdiff", 1e-12));
+}
+
+/**
+ * Make sure that lazy Frank-Wolfe finds the same solution as Frank-Wolfe, with
+ * fewer calls to the linear constrained solver.
+ */
+TEST_CASE("LazyFWLineSearch", "[FrankWolfeTest]")
+{
+  mat A = eye(4, 4);
+  vec b("0.2 -0.3 0.1 0.0"); // The solution is inside the unit l1 ball.
+
+  FuncSq f(A, b);
+  ConstrLpBallSolver linearConstrSolver(1);
+  UpdateLineSearch updateRule;
+
+  FrankWolfe<ConstrLpBallSolver, UpdateLineSearch>
+      s(linearConstrSolver, updateRule, 10000, 1e-6);
+  FrankWolfe<ConstrLpBallSolver, UpdateLineSearch>
+      lazy(linearConstrSolver, updateRule, 10000, 1e-6, 20);
+
+  REQUIRE(s.LazyAtoms() == 0);
+  REQUIRE(lazy.LazyAtoms() == 20);
+  REQUIRE(lazy.LazyFactor() == Approx(0.5));
+
+  vec coordinates = zeros<vec>(4);
+  double result = s.Optimize(f, coordinates);
+  vec lazyCoordinates = zeros<vec>(4);
+  double lazyResult = lazy.Optimize(f, lazyCoordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-6));
+  REQUIRE(lazyResult == Approx(0.0).margin(1e-6));
+  for (size_t i = 0; i < 4; ++i)
+  {
+    REQUIRE(coordinates[i] - b[i] == Approx(0.0).margin(1e-3));
+    REQUIRE(lazyCoordinates[i] - b[i] == Approx(0.0).margin(1e-3));
+  }
+
+  // The cached vertices of the l1 ball are reused most of the time.
+  REQUIRE(lazy.LinearConstrSolverCalls() > 0);
+  REQUIRE(lazy.LinearConstrSolverCalls() < s.LinearConstrSolverCalls());
+}
+
+/**
+ * Run stochastic Frank-Wolfe on logistic regression constrained to the unit l1
+ * ball, and compare with Frank-Wolfe with full gradients.
+ */
+TEST_CASE("StochasticFWLogisticRegression", "[FrankWolfeTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegressionFunction<> lr(shuffledData, shuffledResponses, 0.0);
+
+  ConstrLpBallSolver linearConstrSolver(1);
+
+  // Thirty epochs of batches of 32 points.
+  StochasticFrankWolfe<ConstrLpBallSolver> sfw(linearConstrSolver, 32, 30000,
+      -1.0);
+  mat coordinates = zeros<mat>(1, 4);
+  const double result = sfw.Optimize(lr, coordinates);
+
+  FrankWolfe<ConstrLpBallSolver, UpdateClassic> fw(linearConstrSolver,
+      UpdateClassic(), 2000);
+  mat fwCoordinates = zeros<mat>(1, 4);
+  const double fwResult = fw.Optimize(lr, fwCoordinates);
+
+  REQUIRE(accu(abs(coordinates)) <= 1.0 + 1e-10);
+  REQUIRE(result == Approx(lr.Evaluate(coordinates)));
+  REQUIRE(result == Approx(fwResult).epsilon(0.01));
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc >= 95.0);
+}
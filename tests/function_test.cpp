@@ -13,6 +13,7 @@
 
 #include <ensmallen.hpp>
 #include "catch.hpp"
+#include "test_function_tools.hpp"
 
 using namespace ens;
 using namespace ens::test;
@@ -330,6 +331,372 @@ TEST_CASE("LogisticRegressionEvaluateWithGradientTest", "[FunctionTest]")
   REQUIRE(hasEvaluateWithGradient == true);
 }
 
+/**
+ * Make sure that a memory-mapped matrix holds the values of the file, and that
+ * functions that use it give the same results as on the original data.
+ */
+TEST_CASE("MappedMatrixLogisticRegressionTest", "[FunctionTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  data.save("mapped_matrix_test.bin", arma::raw_binary);
+
+  {
+    MappedMatrix<double> mapped("mapped_matrix_test.bin", data.n_rows,
+        data.n_cols);
+    REQUIRE(mapped.Rows() == data.n_rows);
+    REQUIRE(mapped.Cols() == data.n_cols);
+    CheckMatrices(mapped.Matrix(), data, 1e-10);
+
+    LogisticRegressionFunction<> lr(data, responses, 0.5);
+    LogisticRegressionFunction<> mappedLr(mapped.Matrix(), responses, 0.5);
+    arma::mat coordinates(1, data.n_rows + 1, arma::fill::randn);
+    REQUIRE(mappedLr.Evaluate(coordinates) ==
+        Approx(lr.Evaluate(coordinates)).epsilon(1e-10));
+
+    SoftmaxRegressionFunction sr(data, responses, 2);
+    SoftmaxRegressionFunction mappedSr(mapped.Matrix(), responses, 2);
+    arma::mat parameters(2, data.n_rows, arma::fill::randn);
+    REQUIRE(mappedSr.Evaluate(parameters) ==
+        Approx(sr.Evaluate(parameters)).epsilon(1e-10));
+  }
+
+  // A file that is too small can't be mapped.
+  REQUIRE_THROWS_AS(MappedMatrix<double>("mapped_matrix_test.bin",
+      data.n_rows, data.n_cols + 1), std::runtime_error);
+
+  std::remove("mapped_matrix_test.bin");
+}
+
+/**
+ * Make sure that BlockShuffle() gives a permutation that keeps each block of
+ * consecutive points together.
+ */
+TEST_CASE("BlockShuffleTest", "[FunctionTest]")
+{
+  const arma::uvec ordering = BlockShuffle(103, 10);
+  REQUIRE(ordering.n_elem == 103);
+
+  const arma::uvec sorted = arma::sort(ordering);
+  for (size_t i = 0; i < sorted.n_elem; ++i)
+    REQUIRE(sorted[i] == i);
+
+  for (size_t i = 0; i < ordering.n_elem; ++i)
+  {
+    if (ordering[i] % 10 != 0)
+      REQUIRE(ordering[i] == ordering[i - 1] + 1);
+  }
+}
+
+/**
+ * Make sure that with an index shuffle, the batches of LogisticRegression
+ * still add up to the full objective and gradient, and that the data itself
+ * is not reordered.
+ */
+TEST_CASE("IndexShuffleLogisticRegressionTest", "[FunctionTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  LogisticRegressionFunction<> lr(data, responses, 0.5);
+  lr.IndexShuffle() = true;
+  lr.ShuffleBlockSize() = 16;
+  lr.Shuffle();
+  REQUIRE(lr.Predictors().memptr() == data.memptr());
+
+  arma::mat coordinates(1, data.n_rows + 1, arma::fill::randn);
+  arma::mat gradient, batchGradient;
+  const double objective = lr.EvaluateWithGradient(coordinates, gradient);
+
+  double batchObjective = 0.0;
+  arma::mat sumGradient(arma::size(coordinates), arma::fill::zeros);
+  for (size_t begin = 0; begin < lr.NumFunctions(); begin += 7)
+  {
+    const size_t batchSize = std::min(size_t(7), lr.NumFunctions() - begin);
+    batchObjective += lr.EvaluateWithGradient(coordinates, begin,
+        batchGradient, batchSize);
+    sumGradient += batchGradient;
+  }
+
+  REQUIRE(batchObjective == Approx(objective).epsilon(1e-8));
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+    REQUIRE(sumGradient[i] == Approx(gradient[i]).epsilon(1e-8));
+}
+
+/**
+ * Make sure that with an index shuffle, a batch of all the points of
+ * SoftmaxRegressionFunction gives the full objective and gradient.
+ */
+TEST_CASE("IndexShuffleSoftmaxRegressionTest", "[FunctionTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  // Without regularization, the batch and full objectives are the same.
+  SoftmaxRegressionFunction sr(data, responses, 2, 0.0, true);
+  sr.IndexShuffle() = true;
+  sr.Shuffle();
+
+  const arma::mat parameters = sr.InitializeWeights();
+  REQUIRE(sr.Evaluate(parameters, 0, sr.NumFunctions()) ==
+      Approx(sr.Evaluate(parameters)).epsilon(1e-10));
+
+  arma::mat gradient, batchGradient;
+  sr.Gradient(parameters, gradient);
+  sr.Gradient(parameters, 0, batchGradient, sr.NumFunctions());
+  CheckMatrices(batchGradient, gradient, 1e-8);
+}
+
+/**
+ * Make sure that the fused, blocked EvaluateWithGradient() of
+ * SoftmaxRegressionFunction gives the same results as Evaluate() and
+ * Gradient(), on the whole data and on (shuffled) batches, and that it stays
+ * finite when the scores are too large to exponentiate directly.
+ */
+TEST_CASE("SoftmaxRegressionEvaluateWithGradientTest", "[FunctionTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  SoftmaxRegressionFunction sr(data, responses, 2, 0.001, true);
+  sr.EvaluationBlockSize() = 37;
+  const arma::mat parameters = sr.InitializeWeights();
+
+  arma::mat gradient, fusedGradient;
+  sr.Gradient(parameters, gradient);
+  REQUIRE(sr.EvaluateWithGradient(parameters, fusedGradient) ==
+      Approx(sr.Evaluate(parameters)).epsilon(1e-10));
+  CheckMatrices(fusedGradient, gradient, 1e-8);
+
+  // The shuffle only permutes the visitation order.
+  sr.Shuffle();
+  REQUIRE(sr.IndexShuffle());
+  for (size_t begin = 0; begin < sr.NumFunctions(); begin += 100)
+  {
+    const size_t batchSize = std::min(size_t(100), sr.NumFunctions() - begin);
+    sr.Gradient(parameters, begin, gradient, batchSize);
+    REQUIRE(sr.EvaluateWithGradient(parameters, begin, fusedGradient,
+        batchSize) ==
+        Approx(sr.Evaluate(parameters, begin, batchSize)).epsilon(1e-10));
+    CheckMatrices(fusedGradient, gradient, 1e-8);
+  }
+
+  // exp() of these scores overflows, but the log-sum-exp does not.
+  const arma::mat large = 1000.0 * parameters / arma::norm(parameters);
+  const double objective = sr.EvaluateWithGradient(large, 0, fusedGradient,
+      sr.NumFunctions());
+  REQUIRE(std::isfinite(objective));
+  REQUIRE(fusedGradient.is_finite());
+}
+
+/**
+ * Make sure that the batches of GeneralizedRosenbrockFunction add up to the
+ * full objective and gradient, both in order (with the contiguous kernels)
+ * and shuffled, and with dense and sparse gradients.
+ */
+TEST_CASE("GeneralizedRosenbrockBatchTest", "[FunctionTest]")
+{
+  GeneralizedRosenbrockFunction f(50);
+  arma::mat coordinates(50, 1, arma::fill::randn);
+
+  arma::mat gradient;
+  const double objective = f.Evaluate(coordinates);
+  f.Gradient(coordinates, gradient);
+
+  for (size_t trial = 0; trial < 2; ++trial)
+  {
+    double batchObjective = 0.0;
+    arma::mat batchGradient, sumGradient(50, 1, arma::fill::zeros);
+    arma::sp_mat sparseGradient;
+    arma::mat sumSparseGradient(50, 1, arma::fill::zeros);
+    for (size_t begin = 0; begin < f.NumFunctions(); begin += 6)
+    {
+      const size_t batchSize = std::min(size_t(6), f.NumFunctions() - begin);
+      batchObjective += f.Evaluate(coordinates, begin, batchSize);
+      f.Gradient(coordinates, begin, batchGradient, batchSize);
+      sumGradient += batchGradient;
+      f.Gradient(coordinates, begin, sparseGradient, batchSize);
+      sumSparseGradient += arma::mat(sparseGradient);
+    }
+
+    REQUIRE(batchObjective == Approx(objective).epsilon(1e-10));
+    CheckMatrices(sumGradient, gradient, 1e-8);
+    CheckMatrices(sumSparseGradient, gradient, 1e-8);
+
+    f.Shuffle();
+  }
+}
+
+/**
+ * Make sure that GenerateSparseLogisticRegression() gives a dataset of the
+ * requested size and sparsity, whose generating parameters fit it better than
+ * the zero parameters.
+ */
+TEST_CASE("GenerateSparseLogisticRegressionTest", "[FunctionTest]")
+{
+  arma::sp_mat predictors;
+  arma::Row<size_t> responses;
+  arma::rowvec parameters;
+  GenerateSparseLogisticRegression(2000, 500, 0.01, 100.0, predictors,
+      responses, parameters, 7);
+
+  REQUIRE(predictors.n_rows == 500);
+  REQUIRE(predictors.n_cols == 2000);
+  REQUIRE(predictors.n_nonzero <= 5 * 2000);
+  REQUIRE(predictors.n_nonzero > 4 * 2000);
+  REQUIRE(responses.n_elem == 2000);
+  REQUIRE(parameters.n_elem == 501);
+  REQUIRE(arma::max(responses) == 1);
+  REQUIRE(arma::min(responses) == 0);
+
+  LogisticRegressionFunction<arma::sp_mat> lr(predictors, responses);
+  const arma::mat zeros(1, 501, arma::fill::zeros);
+  REQUIRE(lr.Evaluate(parameters) < 0.9 * lr.Evaluate(zeros));
+
+  // The same seed gives the same instance.
+  arma::sp_mat predictors2;
+  arma::Row<size_t> responses2;
+  arma::rowvec parameters2;
+  GenerateSparseLogisticRegression(2000, 500, 0.01, 100.0, predictors2,
+      responses2, parameters2, 7);
+  REQUIRE(arma::accu(arma::abs(predictors - predictors2)) == 0.0);
+  REQUIRE(arma::all(responses == responses2));
+}
+
+/**
+ * Make sure that the batches of MatrixFactorizationFunction add up to the full
+ * objective and gradient, and that a generated noiseless low-rank instance
+ * can be fit by L-BFGS.
+ */
+TEST_CASE("MatrixFactorizationFunctionTest", "[FunctionTest]")
+{
+  arma::umat locations;
+  arma::vec values;
+  GenerateMatrixFactorization(30, 40, 3, 0.5, 10.0, 0.0, locations, values);
+  REQUIRE(locations.n_rows == 2);
+  REQUIRE(locations.n_cols == values.n_elem);
+  REQUIRE(values.n_elem <= 600);
+  REQUIRE(values.n_elem > 400);
+  REQUIRE(arma::max(locations.row(0)) < 30);
+  REQUIRE(arma::max(locations.row(1)) < 40);
+
+  MatrixFactorizationFunction f(locations, values, 30, 40, 3, 0.001);
+  f.Shuffle();
+  const arma::mat parameters = f.GetInitialPoint();
+
+  arma::mat gradient, batchGradient, sumGradient(3, 70, arma::fill::zeros);
+  arma::sp_mat sparseGradient;
+  arma::mat sumSparseGradient(3, 70, arma::fill::zeros);
+  const double objective = f.EvaluateWithGradient(parameters, gradient);
+  double batchObjective = 0.0;
+  for (size_t begin = 0; begin < f.NumFunctions(); begin += 32)
+  {
+    const size_t batchSize = std::min(size_t(32), f.NumFunctions() - begin);
+    batchObjective += f.Evaluate(parameters, begin, batchSize);
+    f.Gradient(parameters, begin, batchGradient, batchSize);
+    sumGradient += batchGradient;
+    f.Gradient(parameters, begin, sparseGradient, batchSize);
+    sumSparseGradient += arma::mat(sparseGradient);
+  }
+
+  REQUIRE(batchObjective == Approx(objective).epsilon(1e-10));
+  REQUIRE(f.Evaluate(parameters) == Approx(objective).epsilon(1e-10));
+  CheckMatrices(sumGradient, gradient, 1e-8);
+  CheckMatrices(sumSparseGradient, gradient, 1e-8);
+
+  f.Lambda() = 0.0;
+  arma::mat coordinates = f.GetInitialPoint();
+  const double initialObjective = f.Evaluate(coordinates);
+  L_BFGS lbfgs;
+  lbfgs.MaxIterations() = 2000;
+  const double result = lbfgs.Optimize(f, coordinates);
+  REQUIRE(result < 1e-3 * initialObjective);
+}
+
+/**
+ * Make sure that GenerateMaxCutSDP() gives the negated Laplacian of a graph
+ * with the requested number of edges, and the unit diagonal constraints.
+ */
+TEST_CASE("GenerateMaxCutSDPTest", "[FunctionTest]")
+{
+  const SDP<arma::sp_mat> sdp = GenerateMaxCutSDP(200, 6.0, 10.0);
+  REQUIRE(sdp.N() == 200);
+  REQUIRE(sdp.NumSparseConstraints() == 200);
+  REQUIRE(sdp.NumDenseConstraints() == 0);
+
+  const arma::mat c(sdp.C());
+  REQUIRE(arma::approx_equal(c, c.t(), "absdiff", 1e-12));
+  REQUIRE(arma::abs(arma::sum(c, 1)).max() < 1e-10);
+  REQUIRE(arma::all(c.diag() <= 0.0));
+
+  // About 600 edges, each with two off-diagonal nonzeros (fewer if repeated).
+  const size_t offDiagonal = sdp.C().n_nonzero - arma::accu(c.diag() != 0.0);
+  REQUIRE(offDiagonal <= 1200);
+  REQUIRE(offDiagonal > 1100);
+
+  // The total weight of the edges is between 600 / 10 and 600.
+  REQUIRE(-arma::trace(c) / 2.0 >= 60.0);
+  REQUIRE(-arma::trace(c) / 2.0 <= 600.0);
+}
+
+/**
+ * Make sure that the logistic regression function on sparse predictors gives
+ * the same objectives and gradients as on dense predictors.  Every point has
+ * every feature, so the split regularization of the batches is the same too.
+ */
+TEST_CASE("SparseLogisticRegressionFunctionTest", "[FunctionTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  LogisticRegressionFunction<> lr(data, responses, 0.5);
+  LogisticRegressionFunction<arma::sp_mat> sparseLr(arma::sp_mat(data),
+      responses, 0.5);
+
+  arma::mat coordinates(1, data.n_rows + 1, arma::fill::randn);
+  coordinates *= 0.1;
+
+  arma::mat gradient, sparseGradient;
+  REQUIRE(sparseLr.Evaluate(coordinates) ==
+      Approx(lr.Evaluate(coordinates)).epsilon(1e-10));
+  REQUIRE(sparseLr.EvaluateWithGradient(coordinates, sparseGradient) ==
+      Approx(lr.EvaluateWithGradient(coordinates, gradient)).epsilon(1e-10));
+  CheckMatrices(sparseGradient, gradient, 1e-8);
+
+  for (size_t j = 0; j < coordinates.n_elem; ++j)
+  {
+    arma::sp_mat partial, sparsePartial;
+    lr.PartialGradient(coordinates, j, partial);
+    sparseLr.PartialGradient(coordinates, j, sparsePartial);
+    REQUIRE(sparsePartial(0, j) == Approx(partial(0, j)).epsilon(1e-8));
+  }
+
+  arma::sp_mat spGradient;
+  for (size_t batchSize = 1; batchSize <= 64; batchSize *= 4)
+  {
+    const double objective = lr.EvaluateWithGradient(coordinates, 5, gradient,
+        batchSize);
+    REQUIRE(sparseLr.Evaluate(coordinates, 5, batchSize) ==
+        Approx(objective).epsilon(1e-10));
+    REQUIRE(sparseLr.EvaluateWithGradient(coordinates, 5, sparseGradient,
+        batchSize) == Approx(objective).epsilon(1e-10));
+    CheckMatrices(sparseGradient, gradient, 1e-8);
+
+    sparseLr.Gradient(coordinates, 5, spGradient, batchSize);
+    CheckMatrices(arma::mat(spGradient), gradient, 1e-8);
+  }
+}
+
 TEST_CASE("SDPTest", "[FunctionTest]")
 {
   typedef AugLagrangianFunction<LRSDPFunction<SDP<arma::mat>>> FunctionType;
@@ -468,6 +835,80 @@ TEST_CASE("AddDecomposableEvaluateWithGradientAllThreeTest", "[FunctionTest]")
   REQUIRE(hasEvaluateWithGradient == true);
 }
 
+/**
+ * A separable function f_i(x) = 0.5 * ||x - a_i||^2 with a per-function
+ * kernel, which counts its calls.
+ */
+class SampleKernelTestFunction
+{
+ public:
+  SampleKernelTestFunction() : points(5, 200, arma::fill::randn), calls(0) { }
+
+  size_t NumFunctions() const { return points.n_cols; }
+
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t begin,
+                  const size_t batchSize) const
+  {
+    double objective = 0;
+    for (size_t i = begin; i < begin + batchSize; ++i)
+      objective += 0.5 * std::pow(arma::norm(coordinates - points.col(i)), 2);
+    return objective;
+  }
+
+  void Gradient(const arma::mat& coordinates,
+                const size_t begin,
+                arma::mat& gradient,
+                const size_t batchSize) const
+  {
+    gradient.zeros(coordinates.n_rows, coordinates.n_cols);
+    for (size_t i = begin; i < begin + batchSize; ++i)
+      gradient += coordinates - points.col(i);
+  }
+
+  double AccumulateEvaluateWithGradient(const arma::mat& coordinates,
+                                        const size_t i,
+                                        arma::mat& gradient) const
+  {
+    ++calls;
+    gradient += coordinates - points.col(i);
+    return 0.5 * std::pow(arma::norm(coordinates - points.col(i)), 2);
+  }
+
+  arma::mat points;
+  mutable std::atomic<size_t> calls;
+};
+
+/**
+ * Make sure the synthesized EvaluateWithGradient() uses the per-function
+ * kernel, once per function of the batch, and matches Evaluate() and
+ * Gradient().
+ */
+TEST_CASE("AddDecomposableEvaluateWithGradientSampleKernelTest",
+    "[FunctionTest]")
+{
+  REQUIRE(HasSampleKernel<SampleKernelTestFunction, arma::mat,
+      arma::mat>::value == true);
+  REQUIRE(HasSampleKernel<EvaluateGradientTestFunction, arma::mat,
+      arma::mat>::value == false);
+
+  Function<SampleKernelTestFunction> f;
+  const arma::mat coordinates(5, 1, arma::fill::randn);
+  for (size_t batchSize = 1; batchSize <= 150; batchSize += 149)
+  {
+    f.calls = 0;
+    arma::mat gradient, expectedGradient;
+    const double objective = f.EvaluateWithGradient(coordinates, 10, gradient,
+        batchSize);
+    f.Gradient(coordinates, 10, expectedGradient, batchSize);
+
+    REQUIRE(f.calls == batchSize);
+    REQUIRE(objective == Approx(f.Evaluate(coordinates, 10, batchSize)));
+    REQUIRE(arma::approx_equal(gradient, expectedGradient, "absdiff",
+        1e-10));
+  }
+}
+
 /**
  * Make sure we can properly create EvaluateWithGradient() even when one of the
  * functions is non-const.
@@ -668,3 +1109,675 @@ TEST_CASE("ResolvableFunctionTypeCheckTest", "[FunctionTest]")
   static_assert(!CheckPartialGradient<D>::value,
       "CheckPartialGradient static check failed.");
 }
+
+/**
+ * Utility class with Evaluate() and a batch Evaluate() that counts its calls.
+ */
+class BatchEvaluateTestFunction
+{
+ public:
+  BatchEvaluateTestFunction() : batchCalls(0) { }
+
+  double Evaluate(const arma::mat& coordinates)
+  {
+    return arma::accu(coordinates);
+  }
+
+  void Evaluate(const arma::cube& points, arma::vec& objectives)
+  {
+    ++batchCalls;
+    objectives.set_size(points.n_slices);
+    for (size_t i = 0; i < points.n_slices; ++i)
+      objectives[i] = arma::accu(points.slice(i));
+  }
+
+  size_t batchCalls;
+};
+
+/**
+ * Make sure the batch Evaluate() falls back to evaluating one point at a time
+ * when the function does not have one.
+ */
+TEST_CASE("AddBatchEvaluateFallbackTest", "[FunctionTest]")
+{
+  static_assert(!HasBatchEvaluate<EvaluateTestFunction, arma::mat>::value,
+      "HasBatchEvaluate static check failed.");
+
+  EvaluateTestFunction f;
+  arma::cube points(3, 2, 5, arma::fill::randu);
+  arma::vec objectives;
+  static_cast<Function<EvaluateTestFunction>&>(f).Evaluate(points,
+      objectives);
+
+  REQUIRE(objectives.n_elem == 5);
+  for (size_t i = 0; i < points.n_slices; ++i)
+    REQUIRE(objectives[i] == Approx(arma::accu(points.slice(i))));
+}
+
+/**
+ * Make sure the batch Evaluate() of the function is used when it has one.
+ */
+TEST_CASE("AddBatchEvaluateReflectTest", "[FunctionTest]")
+{
+  static_assert(HasBatchEvaluate<BatchEvaluateTestFunction, arma::mat>::value,
+      "HasBatchEvaluate static check failed.");
+
+  BatchEvaluateTestFunction f;
+  arma::cube points(3, 2, 5, arma::fill::randu);
+  arma::vec objectives;
+  static_cast<Function<BatchEvaluateTestFunction>&>(f).Evaluate(points,
+      objectives);
+
+  REQUIRE(f.batchCalls == 1);
+  REQUIRE(objectives.n_elem == 5);
+  for (size_t i = 0; i < points.n_slices; ++i)
+    REQUIRE(objectives[i] == Approx(arma::accu(points.slice(i))));
+
+  // The single-point Evaluate() must still be available.
+  REQUIRE(static_cast<Function<BatchEvaluateTestFunction>&>(f).Evaluate(
+      points.slice(0)) == Approx(arma::accu(points.slice(0))));
+}
+
+/**
+ * Make sure that the serial and parallel full passes give the same objective
+ * and gradient as evaluating all functions at once.
+ */
+TEST_CASE("FullPassTest", "[FunctionTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  const arma::mat coordinates = arma::randu<arma::mat>(1, data.n_rows + 1);
+  const double objective = lr.Evaluate(coordinates, 0, lr.NumFunctions());
+  arma::mat gradient;
+  lr.Gradient(coordinates, 0, gradient, lr.NumFunctions());
+
+  for (size_t batchSize = 7; batchSize < 70; batchSize += 31)
+  {
+    for (const bool parallel : { false, true })
+    {
+      REQUIRE(FullPassEvaluate(lr, coordinates, batchSize, parallel) ==
+          Approx(objective).epsilon(1e-10));
+
+      arma::mat fullPassGradient;
+      FullPassGradient(lr, coordinates, batchSize, fullPassGradient, parallel);
+      REQUIRE(arma::norm(fullPassGradient - gradient) <=
+          1e-8 * arma::norm(gradient));
+    }
+  }
+}
+
+/**
+ * Make sure that DualBatchGradient() uses DualGradient() when it is available,
+ * and that it gives the same gradients as two calls to Gradient() either way.
+ */
+TEST_CASE("DualBatchGradientTest", "[FunctionTest]")
+{
+  static_assert(traits::HasDualBatchGradient<LogisticRegression<>, arma::mat,
+      arma::mat>::value, "LogisticRegression should have DualGradient()");
+  static_assert(!traits::HasDualBatchGradient<SGDTestFunction, arma::mat,
+      arma::mat>::value, "SGDTestFunction should not have DualGradient()");
+
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  const arma::mat coordinates = arma::randu<arma::mat>(1, data.n_rows + 1);
+  const arma::mat coordinates2 = arma::randu<arma::mat>(1, data.n_rows + 1);
+
+  arma::mat gradient, gradient2, dualGradient, dualGradient2;
+  lr.Gradient(coordinates, 10, gradient, 25);
+  lr.Gradient(coordinates2, 10, gradient2, 25);
+  DualBatchGradient(lr, coordinates, coordinates2, 10, dualGradient,
+      dualGradient2, 25);
+
+  REQUIRE(arma::norm(dualGradient - gradient) <= 1e-10 * arma::norm(gradient));
+  REQUIRE(arma::norm(dualGradient2 - gradient2) <=
+      1e-10 * arma::norm(gradient2));
+
+  // The fallback calls Gradient() twice.
+  SGDTestFunction f;
+  const arma::mat point("1.0; 2.0; 3.0");
+  const arma::mat point2("-1.0; 0.5; 2.0");
+  f.Gradient(point, 1, gradient, 2);
+  f.Gradient(point2, 1, gradient2, 2);
+  DualBatchGradient(f, point, point2, 1, dualGradient, dualGradient2, 2);
+
+  REQUIRE(arma::norm(dualGradient - gradient) == Approx(0.0).margin(1e-10));
+  REQUIRE(arma::norm(dualGradient2 - gradient2) == Approx(0.0).margin(1e-10));
+}
+
+/**
+ * Make sure that BatchGradientStatistics() uses GradientStatistics() when it is
+ * available, and that it gives the gradient of the batch and the sum of the
+ * squared norms of the gradients of its functions either way.
+ */
+TEST_CASE("BatchGradientStatisticsTest", "[FunctionTest]")
+{
+  static_assert(traits::HasBatchGradientStatistics<LogisticRegression<>,
+      arma::mat, arma::mat>::value,
+      "LogisticRegression should have GradientStatistics()");
+  static_assert(!traits::HasBatchGradientStatistics<SGDTestFunction,
+      arma::mat, arma::mat>::value,
+      "SGDTestFunction should not have GradientStatistics()");
+
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  const arma::mat coordinates = arma::randu<arma::mat>(1, data.n_rows + 1);
+
+  // Compute the statistics one function at a time.
+  arma::mat gradient, functionGradient;
+  lr.Gradient(coordinates, 10, gradient, 25);
+  double sumSquaredNorms = 0.0;
+  for (size_t j = 10; j < 35; ++j)
+  {
+    lr.Gradient(coordinates, j, functionGradient, 1);
+    sumSquaredNorms += arma::accu(arma::square(functionGradient));
+  }
+
+  arma::mat batchGradient;
+  double batchSquaredNorms;
+  BatchGradientStatistics(lr, coordinates, 10, batchGradient,
+      batchSquaredNorms, 25);
+
+  REQUIRE(arma::norm(batchGradient - gradient) <=
+      1e-10 * arma::norm(gradient));
+  REQUIRE(batchSquaredNorms == Approx(sumSquaredNorms).epsilon(1e-10));
+
+  // The fallback calls Gradient() for each function.
+  SGDTestFunction f;
+  const arma::mat point("1.0; 2.0; 3.0");
+  f.Gradient(point, 0, gradient, 3);
+  sumSquaredNorms = 0.0;
+  for (size_t j = 0; j < 3; ++j)
+  {
+    f.Gradient(point, j, functionGradient, 1);
+    sumSquaredNorms += arma::accu(arma::square(functionGradient));
+  }
+  BatchGradientStatistics(f, point, 0, batchGradient, batchSquaredNorms, 3);
+
+  REQUIRE(arma::norm(batchGradient - gradient) == Approx(0.0).margin(1e-10));
+  REQUIRE(batchSquaredNorms == Approx(sumSquaredNorms).epsilon(1e-10));
+}
+
+/**
+ * Make sure that splitting BatchGradientStatistics() across threads gives the
+ * same statistics as computing them serially.
+ */
+TEST_CASE("ParallelBatchGradientStatisticsTest", "[FunctionTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  const arma::mat coordinates = arma::randu<arma::mat>(1, data.n_rows + 1);
+
+  arma::mat gradient, parallelGradient;
+  double sumSquaredNorms, parallelSquaredNorms;
+  for (size_t batchSize = 1; batchSize <= 100; batchSize += 33)
+  {
+    BatchGradientStatistics(lr, coordinates, 5, gradient, sumSquaredNorms,
+        batchSize, false);
+    BatchGradientStatistics(lr, coordinates, 5, parallelGradient,
+        parallelSquaredNorms, batchSize, true);
+
+    REQUIRE(arma::norm(parallelGradient - gradient) <=
+        1e-10 * arma::norm(gradient));
+    REQUIRE(parallelSquaredNorms == Approx(sumSquaredNorms).epsilon(1e-10));
+  }
+}
+
+/**
+ * Utility class that counts the calls to Evaluate() and Gradient().
+ */
+class CountingTestFunction
+{
+ public:
+  CountingTestFunction() : evaluations(0), gradients(0) { }
+
+  double Evaluate(const arma::mat& coordinates)
+  {
+    ++evaluations;
+    return arma::accu(arma::square(coordinates));
+  }
+
+  void Gradient(const arma::mat& coordinates, arma::mat& gradient)
+  {
+    ++gradients;
+    gradient = 2 * coordinates;
+  }
+
+  size_t evaluations;
+  size_t gradients;
+};
+
+/**
+ * Make sure that CachedFunction serves repeated queries at the same point from
+ * its cache, and recomputes at a new point.
+ */
+TEST_CASE("CachedFunctionTest", "[FunctionTest]")
+{
+  CountingTestFunction f;
+  CachedFunction<CountingTestFunction> cachedF(f);
+
+  const arma::mat point("1.0; 2.0; 3.0");
+  arma::mat gradient;
+
+  REQUIRE(cachedF.Evaluate(point) == Approx(14.0));
+  REQUIRE(cachedF.Evaluate(point) == Approx(14.0));
+  cachedF.Gradient(point, gradient);
+  REQUIRE(cachedF.EvaluateWithGradient(point, gradient) == Approx(14.0));
+  CheckMatrices(gradient, 2 * point);
+
+  REQUIRE(f.evaluations == 1);
+  REQUIRE(f.gradients == 1);
+  REQUIRE(cachedF.Hits() == 2);
+  REQUIRE(cachedF.Misses() == 2);
+
+  // A new point invalidates the cache.
+  const arma::mat point2("1.0; 2.0; 4.0");
+  cachedF.Gradient(point2, gradient);
+  REQUIRE(cachedF.EvaluateWithGradient(point2, gradient) == Approx(21.0));
+  CheckMatrices(gradient, 2 * point2);
+  REQUIRE(f.evaluations == 2);
+  REQUIRE(f.gradients == 2);
+
+  // After Reset(), nothing is served from the cache.
+  cachedF.Reset();
+  cachedF.Evaluate(point2);
+  REQUIRE(f.evaluations == 3);
+
+  // With gradientOnEvaluate, Evaluate() also computes the gradient.
+  CachedFunction<CountingTestFunction> eagerF(f, true);
+  eagerF.Evaluate(point);
+  eagerF.Gradient(point, gradient);
+  CheckMatrices(gradient, 2 * point);
+  REQUIRE(f.evaluations == 4);
+  REQUIRE(f.gradients == 3);
+}
+
+/**
+ * Make sure that an optimizer can be run on a CachedFunction.
+ */
+TEST_CASE("CachedFunctionLBFGSTest", "[FunctionTest]")
+{
+  RosenbrockFunction f;
+  CachedFunction<RosenbrockFunction> cachedF(f, true);
+
+  L_BFGS lbfgs;
+  arma::mat coordinates = f.GetInitialPoint();
+  lbfgs.Optimize(cachedF, coordinates);
+
+  REQUIRE(coordinates[0] == Approx(1.0).epsilon(1e-5));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(1e-5));
+}
+
+/**
+ * Make sure that EvaluationCache serves revisited points from its cache,
+ * rounds the coordinates to its resolution, and evicts the least recently
+ * used points.
+ */
+TEST_CASE("EvaluationCacheTest", "[FunctionTest]")
+{
+  CountingTestFunction f;
+  EvaluationCache<CountingTestFunction> cachedF(f, 2);
+
+  const arma::mat point1("1.0; 2.0; 3.0");
+  const arma::mat point2("1.0; 2.0; 4.0");
+  const arma::mat point3("0.0; 0.0; 1.0");
+
+  REQUIRE(cachedF.Evaluate(point1) == Approx(14.0));
+  REQUIRE(cachedF.Evaluate(point2) == Approx(21.0));
+  REQUIRE(cachedF.Evaluate(point1) == Approx(14.0));
+  REQUIRE(f.evaluations == 2);
+  REQUIRE(cachedF.Hits() == 1);
+  REQUIRE(cachedF.Misses() == 2);
+
+  // point2 is the least recently used, so it is evicted for point3.
+  REQUIRE(cachedF.Evaluate(point3) == Approx(1.0));
+  REQUIRE(cachedF.Size() == 2);
+  cachedF.Evaluate(point1);
+  REQUIRE(f.evaluations == 3);
+  cachedF.Evaluate(point2);
+  REQUIRE(f.evaluations == 4);
+
+  // A point of a different shape is a different point.
+  cachedF.Evaluate(point1.t());
+  REQUIRE(f.evaluations == 5);
+
+  // After Reset(), nothing is served from the cache.
+  cachedF.Reset();
+  REQUIRE(cachedF.Size() == 0);
+  cachedF.Evaluate(point1);
+  REQUIRE(f.evaluations == 6);
+
+  // With a resolution, nearby points share their objective.
+  CountingTestFunction g;
+  EvaluationCache<CountingTestFunction> roundedG(g, 0, 0.5);
+  REQUIRE(roundedG.Evaluate(point1) == Approx(14.0));
+  REQUIRE(roundedG.Evaluate(point1 + 0.1) == Approx(14.0));
+  REQUIRE(roundedG.Evaluate(point1 + 0.4) != Approx(14.0));
+  REQUIRE(g.evaluations == 2);
+}
+
+/**
+ * Make sure that a black-box optimizer can be run on an EvaluationCache, from
+ * several threads at once.
+ */
+TEST_CASE("EvaluationCacheCNETest", "[FunctionTest]")
+{
+  CountingTestFunction f;
+  EvaluationCache<CountingTestFunction> cachedF(f, 0, 0.01);
+
+  CNE cne(40, 50, 0.1, 0.05, 0.2, -1, true);
+  arma::mat coordinates("1.0; 1.0");
+  const double result = cne.Optimize(cachedF, coordinates);
+
+  // The final evaluation of the best candidate, at least, is a hit.  (The
+  // counter of the function itself is not thread-safe.)
+  REQUIRE(result < 2.0);
+  REQUIRE(cachedF.Hits() > 0);
+  REQUIRE(cachedF.Size() == cachedF.Misses());
+}
+
+//! A const objective that opts in to concurrent evaluation.
+class ThreadSafeTestFunction
+{
+ public:
+  typedef std::true_type ThreadSafe;
+
+  double Evaluate(const arma::mat& coordinates) const
+  {
+    return arma::accu(arma::square(coordinates));
+  }
+};
+
+//! A const objective that opts out of concurrent evaluation.
+class NotThreadSafeTestFunction
+{
+ public:
+  typedef std::false_type ThreadSafe;
+
+  double Evaluate(const arma::mat& coordinates) const
+  {
+    return arma::accu(arma::square(coordinates));
+  }
+};
+
+//! A non-const objective that claims to be thread-safe.
+class MutableThreadSafeTestFunction
+{
+ public:
+  typedef std::true_type ThreadSafe;
+
+  double Evaluate(const arma::mat& coordinates)
+  {
+    return arma::accu(arma::square(coordinates));
+  }
+};
+
+/**
+ * Make sure that IsThreadSafeFunction requires both the ThreadSafe tag and a
+ * const Evaluate(), and that a population optimizer still works on a function
+ * that is evaluated in parallel because of it.
+ */
+TEST_CASE("IsThreadSafeFunctionTest", "[FunctionTest]")
+{
+  static_assert(IsThreadSafeFunction<ThreadSafeTestFunction>::value,
+      "ThreadSafeTestFunction should be thread-safe");
+  static_assert(!IsThreadSafeFunction<NotThreadSafeTestFunction>::value,
+      "NotThreadSafeTestFunction should not be thread-safe");
+  static_assert(!IsThreadSafeFunction<MutableThreadSafeTestFunction>::value,
+      "MutableThreadSafeTestFunction should not be thread-safe");
+  static_assert(!IsThreadSafeFunction<CountingTestFunction>::value,
+      "CountingTestFunction should not be thread-safe");
+
+  ThreadSafeTestFunction f;
+  CNE cne(40, 50, 0.1, 0.05, 0.2, -1);
+  arma::mat coordinates("1.0; 1.0");
+  const double result = cne.Optimize(f, coordinates);
+
+  REQUIRE(result < 2.0);
+  REQUIRE(result == Approx(f.Evaluate(coordinates)));
+}
+
+/**
+ * Make sure that LatencyHistogram puts the durations in the right buckets and
+ * bounds the quantiles.
+ */
+TEST_CASE("LatencyHistogramTest", "[FunctionTest]")
+{
+  LatencyHistogram histogram;
+  histogram.Add(0);
+  histogram.Add(1);
+  histogram.Add(3);
+  histogram.Add(1000);
+  histogram.Count();
+
+  REQUIRE(histogram.Calls() == 5);
+  REQUIRE(histogram.Seconds() == Approx(1004e-9));
+  REQUIRE(histogram.Bucket(0) == 2);
+  REQUIRE(histogram.Bucket(1) == 1);
+  REQUIRE(histogram.Bucket(9) == 1);
+  REQUIRE(histogram.BucketSeconds(9) == Approx(512e-9));
+  REQUIRE(histogram.Quantile(0.5) == Approx(2e-9));
+  REQUIRE(histogram.Quantile(0.75) == Approx(4e-9));
+  REQUIRE(histogram.Quantile(1.0) == Approx(1024e-9));
+
+  histogram.Reset();
+  REQUIRE(histogram.Calls() == 0);
+  REQUIRE(histogram.Quantile(0.5) == 0.0);
+}
+
+/**
+ * Make sure that InstrumentedFunction has the methods of the wrapped function,
+ * and counts the calls the Function<> wrapper makes to them.
+ */
+TEST_CASE("InstrumentedFunctionTest", "[FunctionTest]")
+{
+  typedef InstrumentedFunction<CountingTestFunction> InstrumentedType;
+  REQUIRE(traits::HasEvaluate<InstrumentedType,
+      traits::EvaluateConstForm>::value);
+  REQUIRE(traits::HasGradient<InstrumentedType,
+      traits::GradientConstForm>::value);
+  REQUIRE(!traits::HasEvaluateWithGradient<InstrumentedType,
+      traits::EvaluateWithGradientConstForm>::value);
+  REQUIRE(!traits::HasNumFunctions<InstrumentedType,
+      traits::NumFunctionsConstForm>::value);
+  REQUIRE(!traits::IsThreadSafeFunction<InstrumentedType>::value);
+
+  CountingTestFunction f;
+  InstrumentedType instrumentedF(f);
+  Function<InstrumentedType>& fullF =
+      static_cast<Function<InstrumentedType>&>(instrumentedF);
+
+  const arma::mat point("1.0; 2.0; 3.0");
+  arma::mat gradient;
+  REQUIRE(fullF.Evaluate(point) == Approx(14.0));
+  REQUIRE(fullF.EvaluateWithGradient(point, gradient) == Approx(14.0));
+  CheckMatrices(gradient, 2 * point);
+
+  REQUIRE(f.evaluations == 2);
+  REQUIRE(f.gradients == 1);
+  REQUIRE(instrumentedF.EvaluateCalls().Calls() == 2);
+  REQUIRE(instrumentedF.GradientCalls().Calls() == 1);
+  REQUIRE(instrumentedF.EvaluateWithGradientCalls().Calls() == 0);
+  REQUIRE(instrumentedF.Calls() == 3);
+  REQUIRE(instrumentedF.Seconds() >= 0.0);
+
+  size_t timed = 0;
+  for (size_t i = 0; i < LatencyHistogram::NumBuckets; ++i)
+    timed += instrumentedF.EvaluateCalls().Bucket(i);
+  REQUIRE(timed == 2);
+
+  // Without timing, the calls are only counted.
+  instrumentedF.Reset();
+  instrumentedF.Timed() = false;
+  fullF.Evaluate(point);
+  REQUIRE(instrumentedF.EvaluateCalls().Calls() == 1);
+  REQUIRE(instrumentedF.EvaluateCalls().Bucket(0) == 0);
+  REQUIRE(instrumentedF.Seconds() == 0.0);
+}
+
+/**
+ * Make sure that optimizers can be run on an InstrumentedFunction, for
+ * separable and non-separable functions, and that the wrapper keeps the
+ * thread-safety of the wrapped function.
+ */
+TEST_CASE("InstrumentedFunctionOptimizersTest", "[FunctionTest]")
+{
+  SGDTestFunction f;
+  InstrumentedFunction<SGDTestFunction> instrumentedF(f);
+
+  StandardSGD s(0.0003, 1, 300, -1.0, false);
+  arma::mat coordinates = f.GetInitialPoint();
+  s.Optimize(instrumentedF, coordinates);
+
+  // SGDTestFunction has no EvaluateWithGradient(), so each step costs one
+  // separable Evaluate() and one Gradient(), and each epoch one more
+  // Evaluate() for the objective of the epoch when the objective tolerance is
+  // checked.
+  REQUIRE(instrumentedF.GradientCalls().Calls() == 300);
+  REQUIRE(instrumentedF.EvaluateCalls().Calls() >= 300);
+
+  RosenbrockFunction r;
+  InstrumentedFunction<RosenbrockFunction> instrumentedR(r);
+
+  L_BFGS lbfgs;
+  coordinates = r.GetInitialPoint();
+  lbfgs.Optimize(instrumentedR, coordinates);
+
+  REQUIRE(coordinates[0] == Approx(1.0).epsilon(1e-5));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(1e-5));
+  REQUIRE(instrumentedR.Calls() > 0);
+
+  ThreadSafeTestFunction t;
+  REQUIRE(traits::IsThreadSafeFunction<
+      InstrumentedFunction<ThreadSafeTestFunction>>::value);
+  InstrumentedFunction<ThreadSafeTestFunction> instrumentedT(t);
+  CNE cne(40, 50, 0.1, 0.05, 0.2, -1);
+  arma::mat point("1.0; 1.0");
+  REQUIRE(cne.Optimize(instrumentedT, point) < 2.0);
+  REQUIRE(instrumentedT.EvaluateCalls().Calls() > 0);
+}
+
+/**
+ * Make sure that RNG draws uniform, normal and integer numbers with the right
+ * moments, and that its streams and seeds behave as documented.
+ */
+TEST_CASE("RNGTest", "[FunctionTest]")
+{
+  RNG rng(42);
+
+  arma::mat u(200, 500);
+  rng.Randu(u);
+  REQUIRE(u.min() >= 0.0);
+  REQUIRE(u.max() < 1.0);
+  REQUIRE(arma::mean(arma::vectorise(u)) == Approx(0.5).margin(0.01));
+
+  arma::mat n(200, 501);
+  rng.Randn(n);
+  REQUIRE(arma::mean(arma::vectorise(n)) == Approx(0.0).margin(0.01));
+  REQUIRE(arma::var(arma::vectorise(n)) == Approx(1.0).epsilon(0.02));
+
+  arma::uvec counts(3, arma::fill::zeros);
+  for (size_t i = 0; i < 30000; ++i)
+  {
+    const size_t k = rng.Randi(5, 7);
+    REQUIRE(k >= 5);
+    REQUIRE(k <= 7);
+    counts(k - 5)++;
+  }
+  for (size_t k = 0; k < 3; ++k)
+    REQUIRE(counts(k) == Approx(10000).epsilon(0.05));
+
+  // The same seed gives the same sequence, and the streams are different.
+  RNG first(7), second(7);
+  REQUIRE(first() == second());
+  std::vector<RNG> streams = first.Streams(2);
+  REQUIRE(streams[0]() == second());
+  REQUIRE(streams[0]() != streams[1]());
+
+  // Seeds drawn from Armadillo follow arma::arma_rng::set_seed().
+  arma::arma_rng::set_seed(3);
+  const uint64_t seed = RNG::ArmaSeed();
+  arma::arma_rng::set_seed(3);
+  REQUIRE(RNG::ArmaSeed() == seed);
+}
+
+/**
+ * Make sure that PartialSortIndex() finds the smallest values in order, keeps
+ * the rest of the indices, and reuses the index buffer.
+ */
+TEST_CASE("PartialSortIndexTest", "[FunctionTest]")
+{
+  arma::vec values(100, arma::fill::randu);
+  values(17) = arma::datum::nan;
+  const arma::uvec sorted = arma::sort_index(values.elem(
+      arma::find_finite(values)));
+
+  arma::uvec index;
+  PartialSortIndex(values, 10, index);
+  REQUIRE(index.n_elem == 100);
+  for (size_t i = 1; i < 10; ++i)
+    REQUIRE(values(index(i - 1)) <= values(index(i)));
+  REQUIRE(values(index(9)) == values.elem(arma::find_finite(values))(
+      sorted(9)));
+
+  const arma::uvec all = arma::sort(index);
+  for (size_t i = 0; i < 100; ++i)
+    REQUIRE(all(i) == i);
+
+  // The buffer is reused for values of the same size.
+  const arma::uword* memory = index.memptr();
+  values.randu();
+  PartialSortIndex(values, 100, index);
+  REQUIRE(index.memptr() == memory);
+  for (size_t i = 1; i < 100; ++i)
+    REQUIRE(values(index(i - 1)) <= values(index(i)));
+}
+
+/**
+ * Make sure that the alias table draws each index with the probability of its
+ * weight, never draws indices of weight zero, and rejects invalid weights.
+ */
+TEST_CASE("AliasTableTest", "[FunctionTest]")
+{
+  const arma::vec weights({ 1.0, 2.0, 0.0, 5.0, 0.5 });
+  AliasTable table(weights);
+  REQUIRE(table.Size() == 5);
+
+  RNG rng(42);
+  arma::vec counts(5, arma::fill::zeros);
+  const size_t draws = 200000;
+  for (size_t i = 0; i < draws; ++i)
+    ++counts(table.Sample(rng));
+
+  REQUIRE(counts(2) == 0.0);
+  for (size_t i = 0; i < 5; ++i)
+  {
+    const double expected = weights(i) / arma::accu(weights);
+    REQUIRE(table.Probability(i) == Approx(expected).epsilon(1e-12));
+    REQUIRE(counts(i) / draws == Approx(expected).margin(0.005));
+  }
+
+  REQUIRE_THROWS_AS(table.Reset(arma::vec({ 1.0, -1.0 })),
+      std::invalid_argument);
+  REQUIRE_THROWS_AS(table.Reset(arma::vec(3, arma::fill::zeros)),
+      std::invalid_argument);
+}
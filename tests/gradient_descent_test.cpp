@@ -44,3 +44,113 @@ TEST_CASE("GDRosenbrockTest", "[GradientDescentTest]")
   for (size_t j = 0; j < 2; ++j)
     REQUIRE(coordinates[j] == Approx(1.0).epsilon(1e-5));
 }
+
+/**
+ * Run gradient descent on the Rosenbrock function in single precision.
+ */
+TEST_CASE("GDRosenbrockFMatTest", "[GradientDescentTest]")
+{
+  RosenbrockFunction f;
+
+  // The objective stops changing once the steps round to nothing; the
+  // iteration limit is only a safeguard.
+  GradientDescent s(0.001, 1000000, 1e-15);
+
+  arma::fmat coordinates = f.GetInitialPoint<arma::fmat>();
+  const float result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-5));
+  for (size_t j = 0; j < 2; ++j)
+    REQUIRE(coordinates[j] == Approx(1.0).epsilon(1e-3));
+}
+
+/**
+ * Run gradient descent on the Rosenbrock function with a sparse gradient.
+ */
+TEST_CASE("GDRosenbrockSparseGradientTest", "[GradientDescentTest]")
+{
+  RosenbrockFunction f;
+
+  GradientDescent s(0.001, 0, 1e-15);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  const double result = s.Optimize<RosenbrockFunction, arma::mat,
+      arma::sp_mat>(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-10));
+  for (size_t j = 0; j < 2; ++j)
+    REQUIRE(coordinates[j] == Approx(1.0).epsilon(1e-5));
+}
+
+/**
+ * Make sure that gradient descent can optimize a fixed-size iterate in place,
+ * so that the coordinates stay in the fixed-size object.
+ */
+TEST_CASE("GDFixedSizeBoothTest", "[GradientDescentTest]")
+{
+  BoothFunction f;
+  GradientDescent s(0.01, 100000, 1e-15);
+
+  arma::vec::fixed<2> coordinates;
+  coordinates = f.GetInitialPoint();
+  const double* memory = coordinates.memptr();
+  const double result = s.Optimize(f, coordinates);
+
+  REQUIRE(coordinates.memptr() == memory);
+  REQUIRE(result == Approx(0.0).margin(1e-8));
+  REQUIRE(coordinates[0] == Approx(1.0).epsilon(1e-4));
+  REQUIRE(coordinates[1] == Approx(3.0).epsilon(1e-4));
+}
+
+/**
+ * Nesterov-accelerated gradient descent should minimize the Rosenbrock
+ * function with far fewer gradient evaluations than the fixed step.
+ */
+TEST_CASE("GDAcceleratedRosenbrockTest", "[GradientDescentTest]")
+{
+  RosenbrockFunction f;
+  GradientDescent s(0.001, 5000, 1e-15, true);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-10));
+  for (size_t j = 0; j < 2; ++j)
+    REQUIRE(coordinates[j] == Approx(1.0).epsilon(1e-4));
+}
+
+/**
+ * Barzilai-Borwein step sizes with the nonmonotone line search should minimize
+ * the Rosenbrock function with far fewer gradient evaluations than the fixed
+ * step.
+ */
+TEST_CASE("GDBarzilaiBorweinRosenbrockTest", "[GradientDescentTest]")
+{
+  RosenbrockFunction f;
+  GradientDescent s(0.001, 5000, 1e-15, false, true, 10);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-10));
+  for (size_t j = 0; j < 2; ++j)
+    REQUIRE(coordinates[j] == Approx(1.0).epsilon(1e-4));
+
+  // The fixed step doesn't converge in the same number of evaluations.
+  GradientDescent fixed(0.001, 5000, 1e-15);
+  arma::mat fixedCoordinates = f.GetInitialPoint();
+  const double fixedResult = fixed.Optimize(f, fixedCoordinates);
+  REQUIRE(fixedResult > 1e-6);
+}
+
+/**
+ * Acceleration can't be combined with Barzilai-Borwein step sizes.
+ */
+TEST_CASE("GDAcceleratedBarzilaiBorweinTest", "[GradientDescentTest]")
+{
+  GDTestFunction f;
+  GradientDescent s(0.01, 1000, 1e-9, true, true);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  REQUIRE_THROWS_AS(s.Optimize(f, coordinates), std::invalid_argument);
+}
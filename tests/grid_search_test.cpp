@@ -68,3 +68,167 @@ TEST_CASE("GridSearchTest", "[GridSearchTest]")
   REQUIRE(params[1] == 2);
   REQUIRE(params[2] == 1);
 }
+
+// A categorical function with two minima, at [1, 3, 0, 2] and [4, 0, 2, 2].
+// Evaluate() is const, so it can be called from multiple threads at once.
+class TwoMinimaCategoricalFunction
+{
+ public:
+  double Evaluate(const arma::mat& x) const
+  {
+    const arma::vec a("1 3 0 2"), b("4 0 2 2");
+    return std::min(arma::accu(arma::square(x - a)),
+                    arma::accu(arma::square(x - b)));
+  }
+};
+
+/**
+ * Test that the parallel grid search finds the same point as the serial one,
+ * which is the first of the tied minima in the enumeration order.
+ */
+TEST_CASE("GridSearchParallelEvaluationTest", "[GridSearchTest]")
+{
+  TwoMinimaCategoricalFunction f;
+  std::vector<bool> categoricalDimensions(4, true);
+  arma::Row<size_t> numCategories("5 4 3 6");
+
+  for (const bool parallel : { false, true })
+  {
+    GridSearch gs(parallel);
+    REQUIRE(gs.ParallelEvaluation() == parallel);
+
+    arma::mat params;
+    const double objective = gs.Optimize(f, params, categoricalDimensions,
+        numCategories);
+
+    REQUIRE(objective == Approx(0.0).margin(1e-10));
+    REQUIRE(params.n_elem == 4);
+    REQUIRE(params[0] == 1);
+    REQUIRE(params[1] == 3);
+    REQUIRE(params[2] == 0);
+    REQUIRE(params[3] == 2);
+  }
+}
+
+// A categorical function evaluated with a budget, whose minimum is at [2, 5].
+// With small budgets the point [0, 0] looks better than it is, like a model
+// that learns fast but generalizes badly.
+class BudgetedCategoricalFunction
+{
+ public:
+  double Evaluate(const arma::mat& x, const size_t budget) const
+  {
+    const double objective = std::pow(x[0] - 2, 2.0) + std::pow(x[1] - 5, 2.0);
+    if (x[0] == 0 && x[1] == 0)
+      return objective - 30.0 / budget;
+    return objective;
+  }
+};
+
+/**
+ * Test that successive halving and Hyperband find the minimum of a budgeted
+ * categorical function with much less budget than an exhaustive search.
+ */
+TEST_CASE("HyperbandTest", "[GridSearchTest]")
+{
+  BudgetedCategoricalFunction f;
+  std::vector<bool> categoricalDimensions(2, true);
+  arma::Row<size_t> numCategories("3 9");
+
+  for (const bool parallel : { false, true })
+  {
+    // Successive halving: 27, 9, 3 and 1 points with budgets 1, 3, 9 and 27.
+    Hyperband sh(27, 3, 1, parallel);
+    arma::mat params;
+    double objective = sh.Optimize(f, params, categoricalDimensions,
+        numCategories);
+
+    REQUIRE(objective == Approx(0.0).margin(1e-10));
+    REQUIRE(params[0] == 2);
+    REQUIRE(params[1] == 5);
+    REQUIRE(sh.NumEvaluations() == 40);
+    REQUIRE(sh.TotalBudget() == 108);
+
+    Hyperband hb(27, 3, 0, parallel);
+    objective = hb.Optimize(f, params, categoricalDimensions, numCategories);
+
+    REQUIRE(objective == Approx(0.0).margin(1e-10));
+    REQUIRE(params[0] == 2);
+    REQUIRE(params[1] == 5);
+    REQUIRE(hb.TotalBudget() < 27 * 27);
+  }
+}
+
+// A function of two continuous parameters and one categorical parameter, whose
+// minimum is at [0.3, -0.2, 2].
+class MixedFunction
+{
+ public:
+  double Evaluate(const arma::mat& x) const
+  {
+    return std::pow(x[0] - 0.3, 2.0) + std::pow(x[1] + 0.2, 2.0) +
+        ((x[2] == 2) ? 0.0 : 0.5);
+  }
+};
+
+/**
+ * Test that batch Bayesian optimization finds the minimum of a mixed function
+ * with few evaluations, and that the result does not depend on whether the
+ * points of each round are evaluated in parallel.
+ */
+TEST_CASE("BayesianOptimizationTest", "[GridSearchTest]")
+{
+  MixedFunction f;
+  std::vector<bool> categoricalDimensions = { false, false, true };
+  arma::Row<size_t> numCategories("0 0 4");
+
+  arma::mat firstParams;
+  double firstObjective = 0.0;
+  for (const bool parallel : { false, true })
+  {
+    BayesianOptimization bo(40, 4, 10, -1.0, 1.0, 1000, parallel);
+
+    arma::arma_rng::set_seed(42);
+    arma::mat params;
+    const double objective = bo.Optimize(f, params, categoricalDimensions,
+        numCategories);
+
+    REQUIRE(bo.NumEvaluations() == 40);
+    REQUIRE(objective == Approx(f.Evaluate(params)).margin(1e-12));
+    REQUIRE(objective < 0.01);
+    REQUIRE(params[2] == 2);
+
+    if (!parallel)
+    {
+      firstParams = params;
+      firstObjective = objective;
+    }
+    else
+    {
+      REQUIRE(objective == firstObjective);
+      REQUIRE(arma::approx_equal(params, firstParams, "absdiff", 0.0));
+    }
+  }
+}
+
+/**
+ * Test the expected improvement of a normal objective.
+ */
+TEST_CASE("BayesianOptimizationExpectedImprovementTest", "[GridSearchTest]")
+{
+  // Without uncertainty, the improvement is known.
+  REQUIRE(BayesianOptimization::ExpectedImprovement(1.0, 0.0, 3.0) ==
+      Approx(2.0));
+  REQUIRE(BayesianOptimization::ExpectedImprovement(3.0, 0.0, 1.0) == 0.0);
+
+  // At the best objective, it is the standard deviation times the density of
+  // the standard normal distribution at 0.
+  REQUIRE(BayesianOptimization::ExpectedImprovement(1.0, 4.0, 1.0) ==
+      Approx(2.0 / std::sqrt(2.0 * arma::datum::pi)));
+
+  // More uncertainty and a better mean both mean more improvement.
+  REQUIRE(BayesianOptimization::ExpectedImprovement(1.0, 4.0, 1.0) >
+      BayesianOptimization::ExpectedImprovement(1.0, 1.0, 1.0));
+  REQUIRE(BayesianOptimization::ExpectedImprovement(0.5, 1.0, 1.0) >
+      BayesianOptimization::ExpectedImprovement(1.0, 1.0, 1.0));
+}
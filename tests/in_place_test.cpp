@@ -0,0 +1,137 @@
+/**
+ * @file in_place_test.cpp
+ *
+ * Make sure that the optimizers write their result into the memory of the
+ * given matrix, so that a matrix that uses external memory (created with
+ * copy_aux_mem = false) keeps using it.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Optimize the given function, starting from its initial point, in a matrix
+ * that uses an external buffer, and make sure that the buffer holds the
+ * result.  The problems have more than 16 coordinates, since Armadillo never
+ * takes over the memory of smaller matrices.
+ *
+ * @param bestObjective If true, the optimizer returns the objective of the
+ *     coordinates it leaves, which is checked too.
+ */
+template<typename OptimizerType, typename FunctionType>
+void CheckInPlace(OptimizerType& optimizer,
+                  FunctionType& f,
+                  const bool bestObjective = false)
+{
+  const arma::mat initialPoint = f.GetInitialPoint();
+  REQUIRE(initialPoint.n_elem > 16);
+
+  std::vector<double> buffer(initialPoint.begin(), initialPoint.end());
+  arma::mat coordinates(buffer.data(), initialPoint.n_rows,
+      initialPoint.n_cols, false, false);
+
+  const double objective = optimizer.Optimize(f, coordinates);
+
+  REQUIRE(coordinates.memptr() == buffer.data());
+  REQUIRE(coordinates.n_rows == initialPoint.n_rows);
+  REQUIRE(coordinates.n_cols == initialPoint.n_cols);
+  REQUIRE(!arma::approx_equal(coordinates, initialPoint, "absdiff", 1e-10));
+  if (bestObjective)
+    REQUIRE(objective == Approx(f.Evaluate(coordinates)).margin(1e-10));
+}
+
+/**
+ * The first-order optimizers update the external memory directly.
+ */
+TEST_CASE("InPlaceGradientOptimizersTest", "[InPlaceTest]")
+{
+  GeneralizedRosenbrockFunction f(20);
+
+  StandardSGD sgd(1e-4, 1, 10000);
+  CheckInPlace(sgd, f);
+
+  Adam adam(1e-3, 1, 0.9, 0.999, 1e-8, 10000);
+  CheckInPlace(adam, f);
+
+  L_BFGS lbfgs;
+  lbfgs.MaxIterations() = 100;
+  CheckInPlace(lbfgs, f);
+}
+
+/**
+ * The population-based optimizers copy the best member of the population into
+ * the external memory.
+ */
+TEST_CASE("InPlacePopulationOptimizersTest", "[InPlaceTest]")
+{
+  SphereFunction f(20);
+
+  CMAES<> cmaes(0, -1, 1, 20, 50, 1e-5);
+  CheckInPlace(cmaes, f);
+
+  CNE cne(50, 50, 0.1, 0.02, 0.2, -1.0);
+  CheckInPlace(cne, f);
+
+  DE de(50, 50, 0.6, 0.8, -1.0);
+  CheckInPlace(de, f);
+
+  SPSA spsa(0.602, 0.101, 0.16, 0.3, 1000);
+  CheckInPlace(spsa, f);
+}
+
+/**
+ * The restarting and multi-chain optimizers keep their candidates in their own
+ * memory, and copy the best one into the external memory at the end.
+ */
+TEST_CASE("InPlaceRestartOptimizersTest", "[InPlaceTest]")
+{
+  SphereFunction f(20);
+  CMAES<> cmaes(0, -1, 1, 20, 50, 1e-5);
+
+  IPOP_CMAES<> ipop(cmaes, 2, 2);
+  CheckInPlace(ipop, f, true);
+
+  BIPOP_CMAES<> bipop(cmaes, 2, 2);
+  CheckInPlace(bipop, f, true);
+
+  ParallelTempering pt(4, 1e-6, 10.0, 2000);
+  CheckInPlace(pt, f, true);
+
+  GeneralizedRosenbrockFunction g(20);
+  L_BFGS lbfgs;
+  lbfgs.MaxIterations() = 100;
+  MultiStart<L_BFGS> multiStart(lbfgs, 3);
+  CheckInPlace(multiStart, g, true);
+}
+
+/**
+ * Frank-Wolfe computes each new solution in a separate matrix; it has to be
+ * copied into the external memory.
+ */
+TEST_CASE("InPlaceFrankWolfeTest", "[InPlaceTest]")
+{
+  const size_t k = 17;
+  arma::mat a = arma::join_horiz(arma::eye(3, 3), 0.1 * arma::randn(3, k));
+  arma::vec b = { 1.0, 1.0, 0.0 };
+
+  FuncSq f(a, b);
+  ConstrLpBallSolver linearConstrSolver(1);
+  UpdateSpan updateRule;
+  OMP omp(linearConstrSolver, updateRule);
+
+  std::vector<double> buffer(k + 3, 0.0);
+  arma::mat coordinates(buffer.data(), k + 3, 1, false, false);
+  omp.Optimize(f, coordinates);
+
+  REQUIRE(coordinates.memptr() == buffer.data());
+  REQUIRE(buffer[0] == Approx(1.0).margin(1e-10));
+  REQUIRE(buffer[1] == Approx(1.0).margin(1e-10));
+}
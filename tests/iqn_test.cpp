@@ -47,3 +47,53 @@ TEST_CASE("IQNLogisticRegressionTest", "[IQNTest]")
     REQUIRE(testAcc == Approx(100.0).epsilon(0.016)); // 1.6% error tolerance.
   }
 }
+
+/**
+ * Run the limited-memory variant of IQN on logistic regression and make sure
+ * the results are acceptable.
+ */
+TEST_CASE("LimitedMemoryIQNLogisticRegressionTest", "[IQNTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  for (size_t batchSize = 1; batchSize < 9; batchSize += 4)
+  {
+    IQN iqn(0.01, batchSize, 5000, 1e-3, 10);
+    LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+    arma::mat coordinates = lr.GetInitialPoint();
+    iqn.Optimize(lr, coordinates);
+
+    // Ensure that the error is close to zero.
+    const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+    REQUIRE(acc == Approx(100.0).epsilon(0.013)); // 1.3% error tolerance.
+
+    const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+    REQUIRE(testAcc == Approx(100.0).epsilon(0.016)); // 1.6% error tolerance.
+  }
+}
+
+/**
+ * Make sure that the memory estimate of IQN grows with the square of the
+ * iterate for dense Hessians, and linearly for the limited-memory variant.
+ */
+TEST_CASE("IQNEstimateMemoryTest", "[IQNTest]")
+{
+  // 1000 functions in batches of 10 are 100 batches.
+  IQN iqn(0.01, 10);
+  const size_t n = 50;
+  REQUIRE(iqn.EstimateMemory(1000, n) == ((2 * 100 + 6) * n +
+      (100 + 2) * n * n + 2 * n) * sizeof(double));
+
+  iqn.NumBasis() = 5;
+  REQUIRE(iqn.EstimateMemory(1000, n) == ((2 * 100 + 6) * n + 10 * n + 5 +
+      n) * sizeof(double));
+
+  // The last batch may be smaller.
+  REQUIRE(iqn.EstimateMemory(1001, n) > iqn.EstimateMemory(1000, n));
+}
@@ -76,3 +76,61 @@ TEST_CASE("KatyushaProximalLogisticRegressionTest", "[KatyushaTest]")
     REQUIRE(testAcc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
   }
 }
+
+/**
+ * Run Katyusha with parallel full passes on logistic regression and make sure
+ * the results are acceptable.
+ */
+TEST_CASE("KatyushaParallelFullPassLogisticRegressionTest", "[KatyushaTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  Katyusha optimizer(1.0, 10.0, 35, 100, 0, 1e-10, true, true);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  arma::mat coordinates = lr.GetInitialPoint();
+  optimizer.Optimize(lr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+}
+
+/**
+ * Make sure that Katyusha with lazy updates takes the same steps as with dense
+ * updates on a logistic regression function with sparse predictors.
+ */
+TEST_CASE("KatyushaLazyUpdatesSparseLogisticRegressionTest", "[KatyushaTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  const arma::sp_mat sparseData(shuffledData);
+  LogisticRegressionFunction<arma::sp_mat> lr(sparseData, shuffledResponses,
+      0.5);
+
+  for (size_t batchSize = 1; batchSize <= 7; batchSize += 3)
+  {
+    Katyusha dense(1.0, 10.0, batchSize, 5, 0, -1.0, false);
+    arma::mat denseCoordinates = lr.GetInitialPoint();
+    dense.Optimize(lr, denseCoordinates);
+
+    Katyusha lazy(1.0, 10.0, batchSize, 5, 0, -1.0, false);
+    lazy.LazyUpdates() = true;
+    arma::mat lazyCoordinates = lr.GetInitialPoint();
+    lazy.Optimize(lr, lazyCoordinates);
+
+    REQUIRE(arma::approx_equal(lazyCoordinates, denseCoordinates, "reldiff",
+        1e-8));
+  }
+}
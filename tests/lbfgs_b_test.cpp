@@ -0,0 +1,110 @@
+/**
+ * @file lbfgs_b_test.cpp
+ *
+ * Tests for the L-BFGS-B optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Without bounds, L-BFGS-B should find the minimum of the Rosenbrock
+ * function.
+ */
+TEST_CASE("LBFGSBUnboundedRosenbrockTest", "[LBFGSBTest]")
+{
+  RosenbrockFunction f;
+  L_BFGS_B optimizer;
+
+  arma::mat coordinates = f.GetInitialPoint();
+  const double result = optimizer.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-5));
+  REQUIRE(coordinates[0] == Approx(1.0).epsilon(1e-3));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(1e-3));
+}
+
+/**
+ * With an upper bound of 0.5, the minimum of the Rosenbrock function over the
+ * box is on the boundary, at x = 0.5 and y = 0.25, where the objective is 0.25.
+ */
+TEST_CASE("LBFGSBBoundedRosenbrockTest", "[LBFGSBTest]")
+{
+  RosenbrockFunction f;
+  L_BFGS_B optimizer(-2.0, 0.5);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  const double result = optimizer.Optimize(f, coordinates);
+
+  REQUIRE(coordinates[0] == Approx(0.5).epsilon(1e-5));
+  REQUIRE(coordinates[1] == Approx(0.25).epsilon(1e-3));
+  REQUIRE(result == Approx(0.25).epsilon(1e-4));
+}
+
+/**
+ * Make sure that per-coordinate bounds are respected on the whole path, and
+ * that the solution of a nonnegative least squares problem is found.
+ */
+TEST_CASE("LBFGSBNonnegativeLeastSquaresTest", "[LBFGSBTest]")
+{
+  // Least squares ||A x - b||^2 with a solution that has negative entries.
+  const size_t n = 20;
+  arma::mat a = arma::randu<arma::mat>(50, n);
+  arma::vec b = arma::randn<arma::vec>(50);
+
+  struct LeastSquares
+  {
+    const arma::mat& a;
+    const arma::vec& b;
+    bool feasible;
+
+    double EvaluateWithGradient(const arma::mat& x, arma::mat& g)
+    {
+      feasible = feasible && arma::all(arma::vectorise(x) >= 0);
+      const arma::vec r = a * x - b;
+      g = 2 * a.t() * r;
+      return arma::dot(r, r);
+    }
+  } f = { a, b, true };
+
+  L_BFGS_B optimizer(0.0, std::numeric_limits<double>::infinity());
+  arma::mat x(n, 1, arma::fill::ones);
+  optimizer.Optimize(f, x);
+
+  REQUIRE(f.feasible);
+  REQUIRE(arma::all(arma::vectorise(x) >= 0));
+
+  // The KKT conditions: the gradient is zero on the free coordinates and
+  // nonnegative on the coordinates at the bound.
+  arma::mat g;
+  f.EvaluateWithGradient(x, g);
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (x[i] > 1e-8)
+      REQUIRE(g[i] == Approx(0.0).margin(1e-4));
+    else
+      REQUIRE(g[i] >= -1e-4);
+  }
+}
+
+/**
+ * Make sure that bounds of the wrong size are rejected.
+ */
+TEST_CASE("LBFGSBBoundSizeTest", "[LBFGSBTest]")
+{
+  RosenbrockFunction f;
+  L_BFGS_B optimizer(arma::mat(3, 1, arma::fill::zeros),
+      arma::mat(3, 1, arma::fill::ones));
+
+  arma::mat coordinates = f.GetInitialPoint();
+  REQUIRE_THROWS_AS(optimizer.Optimize(f, coordinates), std::invalid_argument);
+}
@@ -36,6 +36,24 @@ TEST_CASE("RosenbrockFunctionTest", "[LBFGSTest]")
   REQUIRE(coords[1] == Approx(1.0).epsilon(1e-7));
 }
 
+/**
+ * Tests the L-BFGS optimizer using the Rosenbrock Function, in single
+ * precision.
+ */
+TEST_CASE("RosenbrockFunctionFMatTest", "[LBFGSTest]")
+{
+  RosenbrockFunction f;
+  L_BFGS lbfgs;
+  lbfgs.MaxIterations() = 10000;
+
+  arma::fmat coords = f.GetInitialPoint<arma::fmat>();
+  const float result = lbfgs.Optimize(f, coords);
+
+  REQUIRE(result == Approx(0.0).margin(1e-5));
+  REQUIRE(coords[0] == Approx(1.0).epsilon(1e-3));
+  REQUIRE(coords[1] == Approx(1.0).epsilon(1e-3));
+}
+
 /**
  * Tests the L-BFGS optimizer using the Colville Function.
  */
@@ -127,3 +145,495 @@ TEST_CASE("RosenbrockWoodFunctionTest", "[LBFGSTest]")
     REQUIRE((coords(row, 1)) == Approx(1.0).epsilon(1e-7));
   }
 }
+
+/**
+ * Tests that the L-BFGS history wraps around correctly, both when only a
+ * single pair is stored and when many solves reuse the same optimizer.
+ */
+TEST_CASE("LBFGSHistoryWrapTest", "[LBFGSTest]")
+{
+  RosenbrockFunction f;
+
+  for (const size_t numBasis : { 1, 3, 10 })
+  {
+    L_BFGS lbfgs(numBasis, 100000);
+
+    for (size_t trial = 0; trial < 3; ++trial)
+    {
+      arma::vec coords = f.GetInitialPoint();
+      if (!lbfgs.Optimize(f, coords))
+        FAIL("L-BFGS optimization reported failure.");
+
+      REQUIRE(f.Evaluate(coords) == Approx(0.0).margin(1e-5));
+      REQUIRE(coords[0] == Approx(1.0).epsilon(1e-3));
+      REQUIRE(coords[1] == Approx(1.0).epsilon(1e-3));
+    }
+  }
+}
+
+/**
+ * Test that L-BFGS keeps its history between calls when resetHistory is false,
+ * and that a warm-started call from the solution of the last one converges
+ * immediately.
+ */
+TEST_CASE("LBFGSWarmStartTest", "[LBFGSTest]")
+{
+  GeneralizedRosenbrockFunction f(10);
+
+  for (const bool compact : { false, true })
+  {
+    L_BFGS lbfgs;
+    lbfgs.CompactRepresentation() = compact;
+    lbfgs.ResetHistory() = false;
+
+    arma::mat coords = f.GetInitialPoint();
+    lbfgs.Optimize(f, coords);
+    REQUIRE(lbfgs.HistorySize() > 0);
+    for (size_t j = 0; j < 10; ++j)
+      REQUIRE(coords(j) == Approx(1.0).epsilon(1e-3));
+
+    // Perturb the solution and solve again from the kept curvature.
+    const size_t historySize = lbfgs.HistorySize();
+    coords += 1e-3;
+    lbfgs.Optimize(f, coords);
+    REQUIRE(lbfgs.HistorySize() > historySize);
+    for (size_t j = 0; j < 10; ++j)
+      REQUIRE(coords(j) == Approx(1.0).epsilon(1e-3));
+
+    lbfgs.ClearHistory();
+    REQUIRE(lbfgs.HistorySize() == 0);
+  }
+}
+
+/**
+ * Make sure that the pairs kept by L-BFGS can be saved and loaded into another
+ * optimizer, which then continues with the same steps.
+ */
+TEST_CASE("LBFGSCheckpointResumeTest", "[LBFGSTest]")
+{
+  GeneralizedRosenbrockFunction f(10);
+
+  L_BFGS lbfgs;
+  lbfgs.ResetHistory() = false;
+  lbfgs.MaxIterations() = 10;
+
+  arma::mat coords = f.GetInitialPoint();
+  lbfgs.Optimize(f, coords);
+
+  std::stringstream stream;
+  SaveState(stream, lbfgs);
+
+  L_BFGS resumed;
+  resumed.ResetHistory() = false;
+  resumed.MaxIterations() = 10;
+  LoadState(stream, resumed);
+  REQUIRE(resumed.HistorySize() == lbfgs.HistorySize());
+
+  arma::mat resumedCoords(coords);
+  lbfgs.Optimize(f, coords);
+  resumed.Optimize(f, resumedCoords);
+
+  for (size_t j = 0; j < 10; ++j)
+    REQUIRE(resumedCoords(j) == Approx(coords(j)).epsilon(1e-12));
+}
+
+/**
+ * Tests the compact representation of L-BFGS using the generalized Rosenbrock
+ * function, and that it takes the same steps as the two-loop recursion.
+ */
+TEST_CASE("CompactLBFGSGeneralizedRosenbrockFunctionTest", "[LBFGSTest]")
+{
+  for (int i = 2; i < 8; i++)
+  {
+    // Dimension: powers of 2
+    int dim = std::pow(2.0, i);
+
+    GeneralizedRosenbrockFunction f(dim);
+    L_BFGS lbfgs(20);
+    lbfgs.CompactRepresentation() = true;
+
+    arma::vec coords = f.GetInitialPoint();
+    if (!lbfgs.Optimize(f, coords))
+      FAIL("L-BFGS optimization reported failure.");
+
+    double finalValue = f.Evaluate(coords);
+
+    // Test the output to make sure it is correct.
+    REQUIRE(finalValue == Approx(0.0).margin(1e-5));
+    for (int j = 0; j < dim; j++)
+      REQUIRE(coords[j] == Approx(1.0).epsilon(1e-7));
+
+    // A few iterations of both variants should end up at the same point.
+    L_BFGS twoLoop(5, 10);
+    L_BFGS compact(5, 10);
+    compact.CompactRepresentation() = true;
+
+    arma::vec twoLoopCoords = f.GetInitialPoint();
+    arma::vec compactCoords = f.GetInitialPoint();
+    twoLoop.Optimize(f, twoLoopCoords);
+    compact.Optimize(f, compactCoords);
+
+    for (int j = 0; j < dim; j++)
+      REQUIRE(compactCoords[j] == Approx(twoLoopCoords[j]).epsilon(1e-5).margin(1e-8));
+  }
+}
+
+/**
+ * Tests the L-BFGS optimizer with the parallel line search using the
+ * Rosenbrock and generalized Rosenbrock functions.
+ */
+TEST_CASE("ParallelLineSearchLBFGSTest", "[LBFGSTest]")
+{
+  RosenbrockFunction f;
+  L_BFGS lbfgs;
+  lbfgs.NumLineSearchCandidates() = 4;
+
+  arma::vec coords = f.GetInitialPoint();
+  if (!lbfgs.Optimize(f, coords))
+    FAIL("L-BFGS optimization reported failure.");
+
+  REQUIRE(f.Evaluate(coords) == Approx(0.0).margin(1e-5));
+  REQUIRE(coords[0] == Approx(1.0).epsilon(1e-5));
+  REQUIRE(coords[1] == Approx(1.0).epsilon(1e-5));
+
+  GeneralizedRosenbrockFunction g(64);
+  arma::vec gCoords = g.GetInitialPoint();
+  if (!lbfgs.Optimize(g, gCoords))
+    FAIL("L-BFGS optimization reported failure.");
+
+  REQUIRE(g.Evaluate(gCoords) == Approx(0.0).margin(1e-5));
+  for (size_t j = 0; j < gCoords.n_elem; j++)
+    REQUIRE(gCoords[j] == Approx(1.0).epsilon(1e-5));
+}
+
+/**
+ * Make sure that L-BFGS gives the same results with a workspace, and that
+ * repeated optimizations of the same size do not create any new temporaries.
+ */
+TEST_CASE("WorkspaceLBFGSTest", "[LBFGSTest]")
+{
+  GeneralizedRosenbrockFunction f(10);
+  L_BFGS lbfgs;
+
+  arma::mat expected = f.GetInitialPoint();
+  lbfgs.Optimize(f, expected);
+
+  Workspace workspace;
+  lbfgs.Workspace() = &workspace;
+
+  arma::mat coords = f.GetInitialPoint();
+  lbfgs.Optimize(f, coords);
+  const size_t created = workspace.Created();
+  REQUIRE(created > 0);
+
+  for (size_t i = 0; i < 5; ++i)
+  {
+    coords = f.GetInitialPoint();
+    lbfgs.Optimize(f, coords);
+
+    REQUIRE(workspace.Created() == created);
+    for (size_t j = 0; j < coords.n_elem; ++j)
+      REQUIRE(coords[j] == Approx(expected[j]).epsilon(1e-10));
+  }
+}
+
+/**
+ * Make sure that splitting the dot products and vector updates into small
+ * chunks (which are processed in parallel when OpenMP is enabled) gives the
+ * same results as the serial kernels.
+ */
+TEST_CASE("ParallelKernelsLBFGSTest", "[LBFGSTest]")
+{
+  GeneralizedRosenbrockFunction f(256);
+
+  L_BFGS serial;
+  serial.MinChunkSize() = 0;
+  arma::mat expected = f.GetInitialPoint();
+  serial.Optimize(f, expected);
+
+  L_BFGS parallel;
+  parallel.MinChunkSize() = 8;
+  arma::mat coords = f.GetInitialPoint();
+  if (!parallel.Optimize(f, coords))
+    FAIL("L-BFGS optimization reported failure.");
+
+  REQUIRE(f.Evaluate(coords) == Approx(0.0).margin(1e-5));
+  for (size_t j = 0; j < coords.n_elem; ++j)
+    REQUIRE(coords[j] == Approx(expected[j]).epsilon(1e-5));
+}
+
+/**
+ * Check the parallel kernels against the corresponding Armadillo expressions.
+ */
+TEST_CASE("ParallelKernelsTest", "[LBFGSTest]")
+{
+  arma::mat a(1000, 3, arma::fill::randu);
+  arma::mat b(1000, 3, arma::fill::randu);
+
+  REQUIRE(ParallelDot(a, b, 7) == Approx(arma::dot(a, b)).epsilon(1e-10));
+
+  arma::mat y = b;
+  ParallelAxpy(-0.5, a, y, 7);
+  arma::mat expected = b - 0.5 * a;
+  REQUIRE(arma::approx_equal(y, expected, "absdiff", 1e-12));
+
+  ParallelScale(3.0, y, 7);
+  expected *= 3.0;
+  REQUIRE(arma::approx_equal(y, expected, "absdiff", 1e-12));
+
+  arma::mat difference(1000, 3);
+  ParallelDifference(a, b, difference, 7);
+  expected = a - b;
+  REQUIRE(arma::approx_equal(difference, expected, "absdiff", 1e-12));
+}
+
+/**
+ * Make sure that L-BFGS can optimize a fixed-size iterate in place.
+ */
+TEST_CASE("FixedSizeLBFGSTest", "[LBFGSTest]")
+{
+  BoothFunction f;
+  L_BFGS lbfgs;
+
+  arma::mat::fixed<2, 1> coordinates;
+  coordinates = f.GetInitialPoint();
+  const double* memory = coordinates.memptr();
+  const double result = lbfgs.Optimize(f, coordinates);
+
+  REQUIRE(coordinates.memptr() == memory);
+  REQUIRE(result == Approx(0.0).margin(1e-8));
+  REQUIRE(coordinates[0] == Approx(1.0).epsilon(1e-4));
+  REQUIRE(coordinates[1] == Approx(3.0).epsilon(1e-4));
+}
+
+/**
+ * The quadratic 0.5 sum_i a_i (x_i - 1)^2, whose curvatures a_i range from
+ * 1e-3 to 1e3, counting its evaluations.
+ */
+class BadlyScaledQuadraticFunction
+{
+ public:
+  BadlyScaledQuadraticFunction(const size_t n) :
+      curvatures(arma::exp(std::log(10.0) *
+          arma::linspace<arma::vec>(-3.0, 3.0, n))),
+      evaluations(0)
+  { }
+
+  double EvaluateWithGradient(const arma::mat& x, arma::mat& gradient)
+  {
+    ++evaluations;
+    gradient = curvatures % (x - 1.0);
+    return 0.5 * arma::dot(gradient, x - 1.0);
+  }
+
+  //! The curvature of each parameter.
+  arma::vec curvatures;
+  //! The number of evaluations so far.
+  size_t evaluations;
+};
+
+/**
+ * Make sure that the diagonal initial Hessian approximation of L-BFGS,
+ * estimated from the stored pairs or given as a preconditioner, needs far fewer
+ * evaluations than the scalar one on a badly scaled problem.
+ */
+TEST_CASE("DiagonalScalingLBFGSTest", "[LBFGSTest]")
+{
+  const size_t n = 20;
+  BadlyScaledQuadraticFunction f(n);
+
+  L_BFGS lbfgs;
+  arma::mat coords(n, 1, arma::fill::zeros);
+  lbfgs.Optimize(f, coords);
+  const size_t scalarEvaluations = f.evaluations;
+
+  lbfgs.DiagonalScaling() = true;
+  coords.zeros();
+  f.evaluations = 0;
+  lbfgs.Optimize(f, coords);
+  REQUIRE(f.evaluations * 10 < scalarEvaluations);
+  for (size_t j = 0; j < n; ++j)
+    REQUIRE(coords[j] == Approx(1.0).epsilon(1e-3));
+
+  // The exact inverse Hessian as the preconditioner.
+  lbfgs.DiagonalScaling() = false;
+  lbfgs.Preconditioner() = 1.0 / f.curvatures;
+  coords.zeros();
+  f.evaluations = 0;
+  lbfgs.Optimize(f, coords);
+  REQUIRE(f.evaluations < 10);
+  for (size_t j = 0; j < n; ++j)
+    REQUIRE(coords[j] == Approx(1.0).epsilon(1e-3));
+
+  // The preconditioner must have the shape of the iterate and be positive.
+  arma::mat wrongCoords(n + 1, 1, arma::fill::zeros);
+  REQUIRE_THROWS_AS(lbfgs.Optimize(f, wrongCoords), std::invalid_argument);
+  lbfgs.Preconditioner()[0] = 0.0;
+  REQUIRE_THROWS_AS(lbfgs.Optimize(f, coords), std::invalid_argument);
+
+  // The diagonal is not available with the compact representation.
+  lbfgs.Preconditioner().reset();
+  lbfgs.DiagonalScaling() = true;
+  lbfgs.CompactRepresentation() = true;
+  REQUIRE_THROWS_AS(lbfgs.Optimize(f, coords), std::invalid_argument);
+}
+
+/**
+ * Make sure that L-BFGS with the diagonal scaling still converges on a problem
+ * that is not separable, also when the sums are recomputed as the history
+ * wraps around.
+ */
+TEST_CASE("DiagonalScalingGeneralizedRosenbrockLBFGSTest", "[LBFGSTest]")
+{
+  GeneralizedRosenbrockFunction f(10);
+
+  for (const size_t numBasis : { 1, 3, 10 })
+  {
+    L_BFGS lbfgs(numBasis, 100000);
+    lbfgs.DiagonalScaling() = true;
+
+    arma::mat coords = f.GetInitialPoint();
+    lbfgs.Optimize(f, coords);
+
+    REQUIRE(f.Evaluate(coords) == Approx(0.0).margin(1e-5));
+    for (size_t j = 0; j < 10; ++j)
+      REQUIRE(coords[j] == Approx(1.0).epsilon(1e-3));
+  }
+}
+
+/**
+ * Make sure that L-BFGS converges as usual with the pairs stored as floats or
+ * as bfloat16s, also when the history wraps around and when it is kept
+ * between calls.
+ */
+TEST_CASE("ReducedPrecisionHistoryLBFGSTest", "[LBFGSTest]")
+{
+  GeneralizedRosenbrockFunction f(10);
+
+  for (const L_BFGS::HistoryPrecisionType precision :
+      { L_BFGS::Float32Precision, L_BFGS::BFloat16Precision })
+  {
+    for (const size_t numBasis : { 1, 3, 10 })
+    {
+      L_BFGS lbfgs(numBasis, 100000);
+      lbfgs.HistoryPrecision() = precision;
+
+      arma::mat coords = f.GetInitialPoint();
+      lbfgs.Optimize(f, coords);
+
+      REQUIRE(f.Evaluate(coords) == Approx(0.0).margin(1e-5));
+      for (size_t j = 0; j < 10; ++j)
+        REQUIRE(coords[j] == Approx(1.0).epsilon(1e-3));
+    }
+
+    // Warm-start from the kept pairs.
+    L_BFGS lbfgs;
+    lbfgs.HistoryPrecision() = precision;
+    lbfgs.ResetHistory() = false;
+    arma::mat coords = f.GetInitialPoint();
+    lbfgs.Optimize(f, coords);
+    const size_t historySize = lbfgs.HistorySize();
+    REQUIRE(historySize > 0);
+
+    coords += 1e-3;
+    lbfgs.Optimize(f, coords);
+    REQUIRE(lbfgs.HistorySize() > historySize);
+    for (size_t j = 0; j < 10; ++j)
+      REQUIRE(coords[j] == Approx(1.0).epsilon(1e-3));
+
+    // The reduced precision history needs the two-loop recursion.
+    lbfgs.CompactRepresentation() = true;
+    REQUIRE_THROWS_AS(lbfgs.Optimize(f, coords), std::invalid_argument);
+  }
+}
+
+/**
+ * Make sure that the reduced precision pairs compute their dot products in
+ * double precision, and that splitting them into chunks of whole blocks gives
+ * the same results.
+ */
+TEST_CASE("ReducedPrecisionPairsTest", "[LBFGSTest]")
+{
+  const size_t n = 1000;
+  arma::mat a(n, 1, arma::fill::randn);
+  arma::mat b(n, 1, arma::fill::randn);
+  const arma::mat zero(n, 1, arma::fill::zeros);
+
+  for (const bool bfloat16 : { false, true })
+  {
+    const double tolerance = bfloat16 ? 1e-2 : 1e-6;
+
+    ReducedPrecisionPairs pairs;
+    pairs.Reset(2, n, 1, bfloat16);
+    REQUIRE(pairs.Bytes() == 4 * n * (bfloat16 ? 2 : 4));
+
+    pairs.Store(0, a, zero, 0);
+    pairs.Store(1, a, b, 0);
+    REQUIRE(pairs.Dot(0, a, 0) ==
+        Approx(arma::dot(a, a)).epsilon(tolerance));
+    REQUIRE(pairs.Dot(0, 1, 0) ==
+        Approx(arma::dot(a, a - b)).epsilon(tolerance));
+    REQUIRE(pairs.AbsSum(0, 0) ==
+        Approx(arma::accu(arma::abs(a))).epsilon(tolerance));
+
+    arma::mat x = b;
+    pairs.Axpy(2.0, 0, x, 0);
+    for (size_t i = 0; i < n; ++i)
+      REQUIRE(x[i] == Approx(b[i] + 2.0 * a[i]).margin(5 * tolerance));
+
+    // Small chunks give the same results, up to the order of the sums.
+    arma::mat chunkedX = b;
+    pairs.Axpy(2.0, 0, chunkedX, 100);
+    REQUIRE(arma::approx_equal(chunkedX, x, "absdiff", 1e-12));
+    REQUIRE(pairs.Dot(0, b, 100) ==
+        Approx(pairs.Dot(0, b, 0)).epsilon(1e-12));
+    REQUIRE(pairs.Dot(0, 1, 100) ==
+        Approx(pairs.Dot(0, 1, 0)).epsilon(1e-12));
+  }
+}
+
+/**
+ * Make sure that the memory estimate of L-BFGS follows the size of the history
+ * and of the parallel line search.
+ */
+TEST_CASE("LBFGSEstimateMemoryTest", "[LBFGSTest]")
+{
+  const size_t n = 1000;
+  const size_t e = sizeof(double);
+
+  // Five vectors, and the s and y cubes with rho and alpha.
+  L_BFGS lbfgs(10);
+  REQUIRE(lbfgs.EstimateMemory(n) == (5 * n + 20 * n + 20) * e);
+  REQUIRE(lbfgs.EstimateMemory(100, 10) == lbfgs.EstimateMemory(n));
+
+  // The compact representation stores the pairs and their products.
+  lbfgs.CompactRepresentation() = true;
+  REQUIRE(lbfgs.EstimateMemory(n) == (5 * n + 20 * n + 400) * e);
+
+  // Each candidate of the line search has an iterate and a gradient.
+  lbfgs.CompactRepresentation() = false;
+  lbfgs.NumLineSearchCandidates() = 4;
+  REQUIRE(lbfgs.EstimateMemory(n) == (5 * n + 20 * n + 20) * e +
+      4 * (2 * n * e + 2 * sizeof(double)));
+
+  // The kept history is a double copy, even for float iterates.
+  lbfgs.NumLineSearchCandidates() = 1;
+  lbfgs.ResetHistory() = false;
+  REQUIRE(lbfgs.EstimateMemory(n, 1, sizeof(float)) ==
+      (5 * n + 20 * n + 20) * sizeof(float) + (20 * n + 10) * sizeof(double));
+
+  // The diagonal, the preconditioner and the sums of the diagonal scaling.
+  lbfgs.ResetHistory() = true;
+  lbfgs.DiagonalScaling() = true;
+  REQUIRE(lbfgs.EstimateMemory(n) == (5 * n + 20 * n + 20 + 4 * n) * e);
+
+  // Reduced precision pairs use 4 or 2 bytes per element, and only rho is
+  // kept as a copy.
+  lbfgs.DiagonalScaling() = false;
+  lbfgs.HistoryPrecision() = L_BFGS::Float32Precision;
+  REQUIRE(lbfgs.EstimateMemory(n) == (5 * n + 20) * e + 20 * n * 4);
+  lbfgs.HistoryPrecision() = L_BFGS::BFloat16Precision;
+  lbfgs.ResetHistory() = false;
+  REQUIRE(lbfgs.EstimateMemory(n) == (5 * n + 20) * e + 20 * n * 2 +
+      10 * sizeof(double));
+}
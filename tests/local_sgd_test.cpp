@@ -0,0 +1,72 @@
+/**
+ * @file local_sgd_test.cpp
+ *
+ * Test file for the LocalSGD optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * With a single worker, LocalSGD should take exactly the steps of SGD, no
+ * matter how often the models are averaged.
+ */
+TEST_CASE("SingleWorkerLocalSGDMatchesSGDTest", "[LocalSGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  StandardSGD sgd(0.01, 32, 20000, 1e-5, false);
+  arma::mat sgdCoordinates = lr.GetInitialPoint();
+  const double sgdObjective = sgd.Optimize(lr, sgdCoordinates);
+
+  LocalSGD<> localSGD(0.01, 32, 5, 1, 20000, 1e-5, false);
+  arma::mat coordinates = lr.GetInitialPoint();
+  const double objective = localSGD.Optimize(lr, coordinates);
+
+  CheckMatrices(coordinates, sgdCoordinates);
+  REQUIRE(objective == Approx(sgdObjective).epsilon(1e-7));
+}
+
+/**
+ * Run LocalSGD with momentum on four workers and make sure the results are
+ * acceptable.
+ */
+TEST_CASE("LocalSGDLogisticRegressionTest", "[LocalSGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  LocalSGD<MomentumUpdate> localSGD(0.01, 8, 4, 4, 100000, 1e-5, true,
+      MomentumUpdate(0.5));
+  arma::mat coordinates = lr.GetInitialPoint();
+  const double objective = localSGD.Optimize(lr, coordinates);
+
+  // The returned objective is the one of the averaged model.
+  REQUIRE(objective == Approx(lr.Evaluate(coordinates)).epsilon(1e-7));
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
@@ -200,6 +200,51 @@ TEST_CASE("ErdosRenyiRandomGraphMaxCutSDP", "[LRSDPTest]")
   REQUIRE(finalValue == Approx(-3672.7).epsilon(1e-3));
 }
 
+/**
+ * Solve the same max-cut SDP in the rank-adaptive mode, starting from rank 2:
+ * the rank must grow only as far as needed, and the solution must match.
+ */
+TEST_CASE("AdaptiveRankMaxCutSDP", "[LRSDPTest]")
+{
+  arma::mat edges;
+  if (edges.load("data/erdosrenyi-n100.csv", arma::csv_ascii) == false)
+  {
+    FAIL("couldn't load data");
+    return;
+  }
+  edges = edges.t();
+
+  arma::sp_mat laplacian;
+  CreateSparseGraphLaplacian(edges, laplacian);
+
+  // A feasible point of rank 2.
+  arma::mat coordinates(laplacian.n_rows, 2, arma::fill::zeros);
+  for (size_t i = 0; i < coordinates.n_rows; ++i)
+    coordinates(i, i % 2) = 1.;
+
+  LRSDP<SDP<arma::sp_mat>> maxcut(laplacian.n_rows, 0, coordinates);
+  maxcut.SDP().C() = -laplacian;
+  maxcut.SDP().SparseB().ones(laplacian.n_rows);
+  for (size_t i = 0; i < laplacian.n_rows; ++i)
+  {
+    maxcut.SDP().SparseA()[i].zeros(laplacian.n_rows, laplacian.n_rows);
+    maxcut.SDP().SparseA()[i](i, i) = 1.;
+  }
+  maxcut.AdaptiveRank() = true;
+  maxcut.CertificateTolerance() = 1e-3;
+
+  const double finalValue = maxcut.Optimize(coordinates);
+  const arma::mat rrt = coordinates * trans(coordinates);
+
+  REQUIRE(coordinates.n_cols >= 2);
+  REQUIRE(coordinates.n_cols <= 15);
+  for (size_t i = 0; i < laplacian.n_rows; ++i)
+    REQUIRE(rrt(i, i) == Approx(1.0).epsilon(1e-5));
+
+  // Final value taken by solving with Mosek.
+  REQUIRE(finalValue == Approx(-3672.7).epsilon(1e-3));
+}
+
 /*
  * Test a nuclear norm minimization SDP.
  *
@@ -294,3 +339,201 @@ TEST_CASE("GaussianMatrixSensingSDP", "[LRSDPTest]")
       arma::norm(Xorig, "fro");
   REQUIRE(err == Approx(0.0).margin(0.05));
 }
+
+/**
+ * Make sure that LRSDPFunction computes the objective and the constraints
+ * without R * R^T correctly, for sparse and dense matrices.
+ */
+TEST_CASE("LRSDPFunctionTraceTest", "[LRSDPTest]")
+{
+  const size_t n = 20;
+  const arma::mat r = arma::randn<arma::mat>(n, 3);
+  const arma::mat rrt = r * trans(r);
+
+  arma::sp_mat c = arma::sprandu<arma::sp_mat>(n, n, 0.1);
+  c = c + trans(c);
+  arma::sp_mat as = arma::sprandu<arma::sp_mat>(n, n, 0.1);
+  as = as + trans(as);
+  arma::mat ad = arma::randu<arma::mat>(n, n);
+  ad = ad + trans(ad);
+
+  LRSDPFunction<SDP<arma::sp_mat>> f(1, 1, r);
+  f.SDP().C() = c;
+  f.SDP().SparseA()[0] = as;
+  f.SDP().SparseB()[0] = 1.0;
+  f.SDP().DenseA()[0] = ad;
+  f.SDP().DenseB()[0] = 2.0;
+
+  REQUIRE(f.Evaluate(r) ==
+      Approx(arma::accu(arma::mat(c) % rrt)).epsilon(1e-10));
+  REQUIRE(f.EvaluateConstraint(0, r) ==
+      Approx(arma::accu(arma::mat(as) % rrt) - 1.0).epsilon(1e-10));
+  REQUIRE(f.EvaluateConstraint(1, r) ==
+      Approx(arma::accu(ad % rrt) - 2.0).epsilon(1e-10));
+}
+
+/**
+ * Make sure that EvaluateWithGradient() of the augmented Lagrangian of an
+ * LRSDPFunction matches Evaluate() and the gradient 2 * S' * R.
+ */
+TEST_CASE("LRSDPAugLagrangianEvaluateWithGradientTest", "[LRSDPTest]")
+{
+  const size_t n = 15;
+  const arma::mat r = arma::randn<arma::mat>(n, 2);
+  const arma::mat rrt = r * trans(r);
+
+  LRSDPFunction<SDP<arma::sp_mat>> f(2, 1, r);
+  arma::sp_mat c = arma::sprandu<arma::sp_mat>(n, n, 0.2);
+  f.SDP().C() = c + trans(c);
+  for (size_t i = 0; i < 2; ++i)
+  {
+    arma::sp_mat a = arma::sprandu<arma::sp_mat>(n, n, 0.1);
+    f.SDP().SparseA()[i] = a + trans(a);
+    f.SDP().SparseB()[i] = i + 1.0;
+  }
+  arma::mat ad = arma::randu<arma::mat>(n, n);
+  f.SDP().DenseA()[0] = ad + trans(ad);
+  f.SDP().DenseB()[0] = 3.0;
+
+  const arma::vec lambda("0.5 -1.0 2.0");
+  const double sigma = 10.0;
+  AugLagrangianFunction<LRSDPFunction<SDP<arma::sp_mat>>> aug(f, lambda,
+      sigma);
+
+  // Compute the gradient the slow way.
+  arma::mat s(f.SDP().C());
+  for (size_t i = 0; i < 3; ++i)
+  {
+    const arma::mat a = (i < 2) ? arma::mat(f.SDP().SparseA()[i]) :
+        f.SDP().DenseA()[0];
+    const double b = (i < 2) ? f.SDP().SparseB()[i] : f.SDP().DenseB()[0];
+    const double constraint = arma::accu(a % rrt) - b;
+    s -= (lambda[i] - sigma * constraint) * a;
+  }
+  const arma::mat expected = 2 * s * r;
+
+  arma::mat gradient, gradient2;
+  const double objective = aug.EvaluateWithGradient(r, gradient);
+  aug.Gradient(r, gradient2);
+
+  REQUIRE(objective == Approx(aug.Evaluate(r)).epsilon(1e-10));
+  REQUIRE(arma::approx_equal(gradient, expected, "absdiff", 1e-8));
+  REQUIRE(arma::approx_equal(gradient2, expected, "absdiff", 1e-8));
+}
+
+/**
+ * Make sure that low-rank constraints A_i = V_i V_i^T give the same constraint
+ * values and augmented Lagrangian as the same constraints given as dense
+ * matrices.
+ */
+TEST_CASE("LRSDPLowRankConstraintTest", "[LRSDPTest]")
+{
+  const size_t n = 15;
+  const arma::mat r = arma::randn<arma::mat>(n, 3);
+
+  arma::sp_mat c = arma::sprandu<arma::sp_mat>(n, n, 0.2);
+  c = c + trans(c);
+  const arma::mat v0 = arma::randn<arma::mat>(n, 1);
+  const arma::mat v1 = arma::randn<arma::mat>(n, 2);
+
+  LRSDPFunction<SDP<arma::sp_mat>> dense(0, 2, r);
+  dense.SDP().C() = c;
+  dense.SDP().DenseA()[0] = v0 * trans(v0);
+  dense.SDP().DenseA()[1] = v1 * trans(v1);
+  dense.SDP().DenseB() = arma::vec("1.0 2.0");
+
+  LRSDPFunction<SDP<arma::sp_mat>> lowRank(SDP<arma::sp_mat>(n, 0, 0, 2), r);
+  lowRank.SDP().C() = c;
+  lowRank.SDP().LowRankA()[0] = v0;
+  lowRank.SDP().LowRankA()[1] = v1;
+  lowRank.SDP().LowRankB() = arma::vec("1.0 2.0");
+
+  REQUIRE(lowRank.NumConstraints() == 2);
+  for (size_t i = 0; i < 2; ++i)
+  {
+    REQUIRE(lowRank.EvaluateConstraint(i, r) ==
+        Approx(dense.EvaluateConstraint(i, r)).epsilon(1e-10));
+  }
+
+  const arma::vec lambda("0.5 -1.0");
+  const double sigma = 10.0;
+  AugLagrangianFunction<LRSDPFunction<SDP<arma::sp_mat>>> denseAug(dense,
+      lambda, sigma);
+  AugLagrangianFunction<LRSDPFunction<SDP<arma::sp_mat>>> lowRankAug(lowRank,
+      lambda, sigma);
+
+  arma::mat denseGradient, lowRankGradient;
+  const double denseObjective = denseAug.EvaluateWithGradient(r,
+      denseGradient);
+  const double lowRankObjective = lowRankAug.EvaluateWithGradient(r,
+      lowRankGradient);
+
+  REQUIRE(lowRankObjective == Approx(denseObjective).epsilon(1e-10));
+  REQUIRE(lowRankAug.Evaluate(r) == Approx(denseObjective).epsilon(1e-10));
+  REQUIRE(arma::approx_equal(lowRankGradient, denseGradient, "absdiff",
+      1e-8));
+}
+
+/**
+ * Make sure that the augmented Lagrangian of an LRSDPFunction with many
+ * constraints of each kind (which are split over the threads when OpenMP is
+ * enabled) matches the direct computation.
+ */
+TEST_CASE("LRSDPAugLagrangianManyConstraintsTest", "[LRSDPTest]")
+{
+  const size_t n = 20;
+  const size_t numSparse = 30, numDense = 8, numLowRank = 6;
+  const arma::mat r = arma::randn<arma::mat>(n, 3);
+  const arma::mat rrt = r * trans(r);
+
+  LRSDPFunction<SDP<arma::sp_mat>> f(SDP<arma::sp_mat>(n, numSparse, numDense,
+      numLowRank), r);
+  arma::sp_mat c = arma::sprandu<arma::sp_mat>(n, n, 0.2);
+  f.SDP().C() = c + trans(c);
+  std::vector<arma::mat> a;
+  for (size_t i = 0; i < numSparse; ++i)
+  {
+    arma::sp_mat ai = arma::sprandu<arma::sp_mat>(n, n, 0.05);
+    f.SDP().SparseA()[i] = ai + trans(ai);
+    a.push_back(arma::mat(f.SDP().SparseA()[i]));
+  }
+  for (size_t i = 0; i < numDense; ++i)
+  {
+    arma::mat ai = arma::randu<arma::mat>(n, n);
+    f.SDP().DenseA()[i] = ai + trans(ai);
+    a.push_back(f.SDP().DenseA()[i]);
+  }
+  for (size_t i = 0; i < numLowRank; ++i)
+  {
+    f.SDP().LowRankA()[i] = arma::randn<arma::mat>(n, 2);
+    a.push_back(f.SDP().LowRankA()[i] * trans(f.SDP().LowRankA()[i]));
+  }
+  f.SDP().SparseB().randu();
+  f.SDP().DenseB().randu();
+  f.SDP().LowRankB().randu();
+  const arma::vec b = arma::join_cols(arma::join_cols(f.SDP().SparseB(),
+      f.SDP().DenseB()), f.SDP().LowRankB());
+
+  const arma::vec lambda = arma::randn<arma::vec>(a.size());
+  const double sigma = 5.0;
+  AugLagrangianFunction<LRSDPFunction<SDP<arma::sp_mat>>> aug(f, lambda,
+      sigma);
+
+  // Compute the objective and the gradient the slow way.
+  arma::mat s(f.SDP().C());
+  double expectedObjective = arma::accu(s % rrt);
+  for (size_t i = 0; i < a.size(); ++i)
+  {
+    const double constraint = arma::accu(a[i] % rrt) - b[i];
+    expectedObjective -= lambda[i] * constraint;
+    expectedObjective += (sigma / 2.) * constraint * constraint;
+    s -= (lambda[i] - sigma * constraint) * a[i];
+  }
+  const arma::mat expected = 2 * s * r;
+
+  arma::mat gradient;
+  const double objective = aug.EvaluateWithGradient(r, gradient);
+  REQUIRE(objective == Approx(expectedObjective).epsilon(1e-10));
+  REQUIRE(aug.Evaluate(r) == Approx(expectedObjective).epsilon(1e-10));
+  REQUIRE(arma::approx_equal(gradient, expected, "both", 1e-8, 1e-8));
+}
@@ -12,6 +12,7 @@
 
 #include <ensmallen.hpp>
 #include "catch.hpp"
+#include "test_function_tools.hpp"
 
 using namespace ens;
 using namespace ens::test;
@@ -64,3 +65,659 @@ TEST_CASE("MomentumSGDGeneralizedRosenbrockTest", "[MomentumSGDTest]")
       REQUIRE(coordinates[j] == Approx(1.0).epsilon(1e-5));
   }
 }
+
+/**
+ * Run the given update policy directly and wrapped in ParallelUpdate (split
+ * into several chunks) side by side, and make sure they give the same
+ * iterates.
+ */
+template<typename UpdateType>
+void ParallelUpdateTest(const UpdateType& update)
+{
+  ParallelUpdate<UpdateType> parallelUpdate(update, 4, 1);
+
+  typename UpdateType::template Policy<arma::mat, arma::mat> policy(update,
+      30, 4);
+  typename ParallelUpdate<UpdateType>::template Policy<arma::mat, arma::mat>
+      parallelPolicy(parallelUpdate, 30, 4);
+
+  arma::mat iterate(30, 4, arma::fill::randu);
+  arma::mat parallelIterate(iterate);
+  for (size_t i = 0; i < 50; ++i)
+  {
+    const arma::mat gradient = arma::randn<arma::mat>(30, 4);
+    policy.Update(iterate, 0.01, gradient);
+    parallelPolicy.Update(parallelIterate, 0.01, gradient);
+  }
+
+  for (size_t i = 0; i < iterate.n_elem; ++i)
+    REQUIRE(parallelIterate[i] == Approx(iterate[i]).margin(1e-12));
+}
+
+/**
+ * Make sure that splitting element-wise updates into chunks does not change
+ * their results.
+ */
+TEST_CASE("ParallelUpdateTest", "[MomentumSGDTest]")
+{
+  ParallelUpdateTest(MomentumUpdate(0.7));
+  ParallelUpdateTest(NesterovMomentumUpdate(0.7));
+  ParallelUpdateTest(AdamUpdate());
+  ParallelUpdateTest(FTMLUpdate());
+  ParallelUpdateTest(PadamUpdate());
+}
+
+/**
+ * Run the given update policy on a dense iterate, for which the state and the
+ * iterate are updated in a single loop, and on a column vector, for which the
+ * Armadillo expressions are used, side by side, and make sure they give the
+ * same iterates.
+ */
+template<typename UpdateType>
+void SinglePassUpdateTest(const UpdateType& update)
+{
+  typename UpdateType::template Policy<arma::mat, arma::mat> policy(update,
+      120, 1);
+  typename UpdateType::template Policy<arma::vec, arma::vec> exprPolicy(update,
+      120, 1);
+
+  arma::mat iterate(120, 1, arma::fill::randu);
+  arma::vec exprIterate(iterate);
+  for (size_t i = 0; i < 50; ++i)
+  {
+    const arma::vec gradient = arma::randn<arma::vec>(120);
+    policy.Update(iterate, 0.01, arma::mat(gradient));
+    exprPolicy.Update(exprIterate, 0.01, gradient);
+  }
+
+  for (size_t i = 0; i < iterate.n_elem; ++i)
+    REQUIRE(iterate[i] == Approx(exprIterate[i]).margin(1e-10));
+}
+
+/**
+ * Make sure that the single loop updates of the adaptive policies take the
+ * same steps as their Armadillo expressions.
+ */
+TEST_CASE("SinglePassAdaptiveUpdateTest", "[MomentumSGDTest]")
+{
+  SinglePassUpdateTest(AdaDeltaUpdate());
+  SinglePassUpdateTest(RMSPropUpdate());
+  SinglePassUpdateTest(SMORMS3Update());
+  SinglePassUpdateTest(FTMLUpdate());
+  SinglePassUpdateTest(PadamUpdate());
+  SinglePassUpdateTest(AdamUpdate());
+}
+
+/**
+ * Run the given update policy on gradients whose norm is clipped by hand, and
+ * wrapped in GradientClipping with the given maximum norm and block size, side
+ * by side, and make sure they give the same iterates.
+ */
+template<typename UpdateType>
+void GradientNormClippingTest(UpdateType update, const size_t blockSize)
+{
+  GradientClipping<UpdateType> clipping(2.0, update, blockSize, 1);
+
+  typename UpdateType::template Policy<arma::mat, arma::mat> policy(update,
+      30, 4);
+  typename GradientClipping<UpdateType>::template Policy<arma::mat, arma::mat>
+      clippingPolicy(clipping, 30, 4);
+
+  arma::mat iterate(30, 4, arma::fill::randu);
+  arma::mat clippedIterate(iterate);
+  for (size_t i = 0; i < 50; ++i)
+  {
+    // Only some of the gradients (and of their blocks) have to be clipped.
+    const arma::mat gradient = (i % 3 + 0.1) * arma::randn<arma::mat>(30, 4);
+    arma::mat clipped(gradient);
+    const size_t size = (blockSize == 0) ? clipped.n_elem : blockSize;
+    for (size_t b = 0; b < clipped.n_elem; b += size)
+    {
+      arma::vec block(clipped.memptr() + b, size, false, true);
+      if (arma::norm(block) > 2.0)
+        block *= 2.0 / arma::norm(block);
+    }
+
+    policy.Update(iterate, 0.01, clipped);
+    clippingPolicy.Update(clippedIterate, 0.01, gradient);
+  }
+
+  for (size_t i = 0; i < iterate.n_elem; ++i)
+    REQUIRE(clippedIterate[i] == Approx(iterate[i]).margin(1e-12));
+}
+
+/**
+ * Make sure that global and per-column norm clipping give the clipped
+ * gradients to the wrapped policy, both when the scale is folded into the step
+ * size and when the clipped gradient is stored.
+ */
+TEST_CASE("GradientNormClippingTest", "[MomentumSGDTest]")
+{
+  GradientNormClippingTest(MomentumUpdate(0.7), 0);
+  GradientNormClippingTest(NesterovMomentumUpdate(0.7), 0);
+  GradientNormClippingTest(AdamUpdate(), 0);
+  GradientNormClippingTest(MomentumUpdate(0.7), 30);
+  GradientNormClippingTest(AdamUpdate(), 30);
+
+  VanillaUpdate vanilla;
+  REQUIRE_THROWS_AS(GradientClipping<VanillaUpdate>(0.0, vanilla),
+      std::invalid_argument);
+}
+
+/**
+ * Run the given update policy directly and as the single stage of a
+ * FusedUpdate side by side, with dense and sparse gradients, and make sure they
+ * give the same iterates.
+ */
+template<typename UpdateType>
+void FusedWrapperUpdateTest(const UpdateType& update)
+{
+  FusedUpdate<UpdateType> fusedUpdate(update);
+
+  typename UpdateType::template Policy<arma::mat, arma::mat> policy(update,
+      30, 4);
+  typename FusedUpdate<UpdateType>::template Policy<arma::mat, arma::mat>
+      fusedPolicy(fusedUpdate, 30, 4);
+  typename FusedUpdate<UpdateType>::template Policy<arma::mat, arma::sp_mat>
+      sparsePolicy(fusedUpdate, 30, 4);
+
+  arma::mat iterate(30, 4, arma::fill::randu);
+  arma::mat fusedIterate(iterate);
+  arma::mat sparseIterate(iterate);
+  for (size_t i = 0; i < 50; ++i)
+  {
+    const arma::sp_mat sparseGradient = arma::sprandn<arma::sp_mat>(30, 4,
+        0.3);
+    const arma::mat gradient(sparseGradient);
+    policy.Update(iterate, 0.01, gradient);
+    fusedPolicy.Update(fusedIterate, 0.01, gradient);
+    sparsePolicy.Update(sparseIterate, 0.01, sparseGradient);
+  }
+
+  for (size_t i = 0; i < iterate.n_elem; ++i)
+  {
+    REQUIRE(fusedIterate[i] == Approx(iterate[i]).margin(1e-12));
+    REQUIRE(sparseIterate[i] == Approx(iterate[i]).margin(1e-12));
+  }
+}
+
+/**
+ * Make sure that the kernels of the element-wise policies take the same steps
+ * as the policies, and that a chain of stages takes the steps of each of them.
+ */
+TEST_CASE("FusedUpdateTest", "[MomentumSGDTest]")
+{
+  FusedWrapperUpdateTest(VanillaUpdate());
+  FusedWrapperUpdateTest(MomentumUpdate(0.7));
+  FusedWrapperUpdateTest(DecoupledWeightDecayMomentumUpdate(0.7, 0.01));
+  FusedWrapperUpdateTest(AdamUpdate());
+
+  AdamUpdate adam;
+  FusedWrapperUpdateTest(GradientClipping<AdamUpdate>(-0.5, 0.5, adam));
+
+  // Momentum followed by a vanilla step on the same gradient.
+  MomentumUpdate momentum(0.7);
+  FusedUpdate<MomentumUpdate, VanillaUpdate> chain(momentum, VanillaUpdate());
+  MomentumUpdate::Policy<arma::mat, arma::mat> momentumPolicy(momentum, 30, 4);
+  VanillaUpdate::Policy<arma::mat, arma::mat> vanillaPolicy(VanillaUpdate(),
+      30, 4);
+  FusedUpdate<MomentumUpdate, VanillaUpdate>::Policy<arma::mat, arma::mat>
+      chainPolicy(chain, 30, 4);
+
+  arma::mat iterate(30, 4, arma::fill::randu);
+  arma::mat chainIterate(iterate);
+  for (size_t i = 0; i < 50; ++i)
+  {
+    const arma::mat gradient = arma::randn<arma::mat>(30, 4);
+    momentumPolicy.Update(iterate, 0.01, gradient);
+    vanillaPolicy.Update(iterate, 0.01, gradient);
+    chainPolicy.Update(chainIterate, 0.01, gradient);
+  }
+
+  for (size_t i = 0; i < iterate.n_elem; ++i)
+    REQUIRE(chainIterate[i] == Approx(iterate[i]).margin(1e-12));
+
+  // Norm clipping has no element-wise kernel.
+  typedef FusedUpdate<GradientClipping<AdamUpdate>> NormFusedUpdate;
+  NormFusedUpdate normFused(GradientClipping<AdamUpdate>(2.0, adam));
+  typedef NormFusedUpdate::Policy<arma::mat, arma::mat> NormFusedPolicy;
+  REQUIRE_THROWS_AS(NormFusedPolicy(normFused, 30, 4), std::invalid_argument);
+
+  // The fused policy takes the same steps in SGD.
+  GeneralizedRosenbrockFunction f(10);
+  MomentumUpdate sgdMomentum(0.4);
+  GradientClipping<MomentumUpdate> clipping(-100.0, 100.0, sgdMomentum);
+  SGD<GradientClipping<MomentumUpdate>> s(0.0008, 1, 100000, 1e-15, false,
+      clipping);
+  SGD<FusedUpdate<GradientClipping<MomentumUpdate>>> fusedS(0.0008, 1, 100000,
+      1e-15, false, FusedUpdate<GradientClipping<MomentumUpdate>>(clipping));
+
+  arma::mat coordinates = f.GetInitialPoint();
+  arma::mat fusedCoordinates = f.GetInitialPoint();
+  const double result = s.Optimize(f, coordinates);
+  const double fusedResult = fusedS.Optimize(f, fusedCoordinates);
+
+  REQUIRE(fusedResult == Approx(result).margin(1e-10));
+  for (size_t j = 0; j < coordinates.n_elem; ++j)
+    REQUIRE(fusedCoordinates[j] == Approx(coordinates[j]).margin(1e-8));
+}
+
+/**
+ * Run momentum SGD with parallel updates on the generalized Rosenbrock
+ * function, and make sure it takes the same steps as with serial updates.
+ */
+TEST_CASE("ParallelUpdateMomentumSGDTest", "[MomentumSGDTest]")
+{
+  GeneralizedRosenbrockFunction f(50);
+
+  MomentumSGD s(0.0008, 1, 100000, 1e-15, false, MomentumUpdate(0.4));
+  SGD<ParallelUpdate<MomentumUpdate>> parallelS(0.0008, 1, 100000, 1e-15,
+      false, ParallelUpdate<MomentumUpdate>(MomentumUpdate(0.4), 0, 8));
+
+  arma::mat coordinates = f.GetInitialPoint();
+  arma::mat parallelCoordinates = f.GetInitialPoint();
+  const double result = s.Optimize(f, coordinates);
+  const double parallelResult = parallelS.Optimize(f, parallelCoordinates);
+
+  REQUIRE(parallelResult == Approx(result).epsilon(1e-10));
+  for (size_t i = 0; i < coordinates.n_elem; ++i)
+    REQUIRE(parallelCoordinates[i] == Approx(coordinates[i]).margin(1e-10));
+}
+
+/**
+ * With a constant gradient the vanilla iterates grow by one each step, so the
+ * average of the iterates taken after the start, at the given frequency, is
+ * known.
+ */
+TEST_CASE("IterateAveragingTest", "[MomentumSGDTest]")
+{
+  IterateAveraging<> averaging(VanillaUpdate(), 2, 2);
+  IterateAveraging<>::Policy<arma::mat, arma::mat> p(averaging, 3, 1);
+
+  arma::mat iterate(3, 1, arma::fill::zeros);
+  const arma::mat gradient(3, 1, arma::fill::ones);
+  for (size_t i = 0; i < 8; ++i)
+    p.Update(iterate, -1.0, gradient);
+
+  // Steps 4, 6 and 8 are averaged.
+  REQUIRE(averaging.Count() == 3);
+  const arma::mat& average = averaging.Average();
+  REQUIRE(average.n_elem == 3);
+  for (size_t i = 0; i < average.n_elem; ++i)
+    REQUIRE(average[i] == Approx(6.0).epsilon(1e-10));
+
+  // The last iterate is returned unchanged.
+  REQUIRE(iterate[0] == Approx(8.0).epsilon(1e-10));
+
+  // Instantiating the policy again resets the average.
+  IterateAveraging<>::Policy<arma::mat, arma::mat> p2(averaging, 3, 1);
+  REQUIRE(averaging.Count() == 0);
+  REQUIRE(averaging.Average().n_elem == 0);
+  REQUIRE_THROWS_AS(averaging.Average<arma::fmat>(), std::logic_error);
+
+  averaging.Frequency() = 0;
+  REQUIRE_THROWS_AS((IterateAveraging<>::Policy<arma::mat, arma::mat>(
+      averaging, 3, 1)), std::invalid_argument);
+}
+
+/**
+ * Run momentum SGD with stochastic weight averaging over the last epochs on a
+ * logistic regression problem, and make sure the average classifies well.
+ */
+TEST_CASE("IterateAveragingLogisticRegressionTest", "[MomentumSGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  // Average once per epoch, after the first ten epochs.
+  const size_t batches = (lr.NumFunctions() + 31) / 32;
+  IterateAveraging<MomentumUpdate> averaging(MomentumUpdate(0.5),
+      10 * batches, batches);
+  SGD<IterateAveraging<MomentumUpdate>> s(0.01, 32, 20 * lr.NumFunctions(),
+      -1.0, true, averaging);
+
+  arma::mat coordinates = lr.GetInitialPoint();
+  s.Optimize(lr, coordinates);
+
+  REQUIRE(s.UpdatePolicy().Count() == 10);
+  coordinates = s.UpdatePolicy().Average();
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+/**
+ * With a constant gradient the vanilla iterates grow by one each step, so the
+ * Lookahead iterates after each synchronization are known.
+ */
+TEST_CASE("LookaheadUpdateTest", "[MomentumSGDTest]")
+{
+  LookaheadUpdate<> lookahead(VanillaUpdate(), 2, 0.5);
+  LookaheadUpdate<>::Policy<arma::mat, arma::mat> p(lookahead, 3, 1);
+
+  arma::mat iterate(3, 1, arma::fill::zeros);
+  const arma::mat gradient(3, 1, arma::fill::ones);
+
+  // The fast weights reach 2, and the slow weights move halfway from 0.
+  p.Update(iterate, -1.0, gradient);
+  REQUIRE(iterate[0] == Approx(1.0).epsilon(1e-10));
+  p.Update(iterate, -1.0, gradient);
+  REQUIRE(iterate[0] == Approx(1.0).epsilon(1e-10));
+
+  // Then the fast weights reach 3, and the slow weights move from 1 to 2.
+  p.Update(iterate, -1.0, gradient);
+  REQUIRE(iterate[0] == Approx(2.0).epsilon(1e-10));
+  p.Update(iterate, -1.0, gradient);
+  for (size_t i = 0; i < iterate.n_elem; ++i)
+    REQUIRE(iterate[i] == Approx(2.0).epsilon(1e-10));
+
+  lookahead.K() = 0;
+  REQUIRE_THROWS_AS((LookaheadUpdate<>::Policy<arma::mat, arma::mat>(
+      lookahead, 3, 1)), std::invalid_argument);
+
+  lookahead.K() = 5;
+  lookahead.Alpha() = 1.5;
+  REQUIRE_THROWS_AS((LookaheadUpdate<>::Policy<arma::mat, arma::mat>(
+      lookahead, 3, 1)), std::invalid_argument);
+}
+
+/**
+ * Run Lookahead Adam on a logistic regression problem and make sure the
+ * results are acceptable.
+ */
+TEST_CASE("LookaheadAdamLogisticRegressionTest", "[MomentumSGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  SGD<LookaheadUpdate<AdamUpdate>> s(0.001, 32, 100000, 1e-5, true,
+      LookaheadUpdate<AdamUpdate>(AdamUpdate(), 5, 0.5));
+
+  arma::mat coordinates = lr.GetInitialPoint();
+  s.Optimize(lr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+/**
+ * Make sure that each block of columns is updated by its own policy, with its
+ * own step size, exactly as that policy would update the block alone, and
+ * that the columns outside of the blocks are not updated.
+ */
+TEST_CASE("BlockUpdateColsTest", "[MomentumSGDTest]")
+{
+  BlockUpdate<MomentumUpdate, VanillaUpdate> update(
+      { UpdateBlock::Cols(0, 1), UpdateBlock::Cols(2, 3, 0.5) },
+      MomentumUpdate(0.5), VanillaUpdate());
+  BlockUpdate<MomentumUpdate, VanillaUpdate>::Policy<arma::mat, arma::mat>
+      p(update, 4, 6);
+
+  MomentumUpdate momentum(0.5);
+  MomentumUpdate::Policy<arma::mat, arma::mat> momentumPolicy(momentum, 4, 2);
+
+  arma::mat iterate(4, 6, arma::fill::randu);
+  arma::mat first = iterate.cols(0, 1);
+  arma::mat second = iterate.cols(2, 3);
+  const arma::mat rest = iterate.cols(4, 5);
+  for (size_t i = 0; i < 5; ++i)
+  {
+    const arma::mat gradient(4, 6, arma::fill::randn);
+    p.Update(iterate, 0.1, gradient);
+
+    const arma::mat firstGradient = gradient.cols(0, 1);
+    momentumPolicy.Update(first, 0.1, firstGradient);
+    second -= 0.05 * gradient.cols(2, 3);
+  }
+
+  CheckMatrices(iterate.cols(0, 1), first, 1e-10);
+  CheckMatrices(iterate.cols(2, 3), second, 1e-10);
+  CheckMatrices(iterate.cols(4, 5), rest, 1e-10);
+}
+
+/**
+ * Blocks of rows of a matrix are copied around their update, and sparse
+ * gradients are split into sparse blocks; make sure both give the same steps
+ * as the policies alone.
+ */
+TEST_CASE("BlockUpdateRowsTest", "[MomentumSGDTest]")
+{
+  BlockUpdate<AdaGradUpdate, AdamUpdate> update(
+      { UpdateBlock::Rows(3, 5), UpdateBlock::Rows(0, 2) },
+      AdaGradUpdate(), AdamUpdate());
+  BlockUpdate<AdaGradUpdate, AdamUpdate>::Policy<arma::mat, arma::mat>
+      p(update, 6, 3);
+
+  AdaGradUpdate adaGrad;
+  AdaGradUpdate::Policy<arma::mat, arma::mat> adaGradPolicy(adaGrad, 3, 3);
+  AdamUpdate adam;
+  AdamUpdate::Policy<arma::mat, arma::mat> adamPolicy(adam, 3, 3);
+
+  arma::mat iterate(6, 3, arma::fill::randu);
+  arma::mat first = iterate.rows(3, 5);
+  arma::mat second = iterate.rows(0, 2);
+  for (size_t i = 0; i < 5; ++i)
+  {
+    const arma::mat gradient(6, 3, arma::fill::randn);
+    p.Update(iterate, 0.1, gradient);
+
+    const arma::mat firstGradient = gradient.rows(3, 5);
+    adaGradPolicy.Update(first, 0.1, firstGradient);
+    const arma::mat secondGradient = gradient.rows(0, 2);
+    adamPolicy.Update(second, 0.1, secondGradient);
+  }
+
+  CheckMatrices(iterate.rows(3, 5), first, 1e-10);
+  CheckMatrices(iterate.rows(0, 2), second, 1e-10);
+
+  // Sparse AdaGrad on the first columns, vanilla steps on the others.
+  BlockUpdate<AdaGradUpdate, VanillaUpdate> sparseUpdate(
+      { UpdateBlock::Cols(0, 1), UpdateBlock::Cols(2, 2) },
+      AdaGradUpdate(), VanillaUpdate());
+  BlockUpdate<AdaGradUpdate, VanillaUpdate>::Policy<arma::mat, arma::sp_mat>
+      sparsePolicy(sparseUpdate, 6, 3);
+  AdaGradUpdate::Policy<arma::mat, arma::mat> densePolicy(adaGrad, 6, 2);
+
+  arma::mat sparseIterate = iterate;
+  arma::mat denseIterate = iterate.cols(0, 1);
+  arma::mat vanillaIterate = iterate.col(2);
+  for (size_t i = 0; i < 5; ++i)
+  {
+    const arma::sp_mat gradient = arma::sprandu<arma::sp_mat>(6, 3, 0.3);
+    sparsePolicy.Update(sparseIterate, 0.1, gradient);
+
+    const arma::mat denseGradient(gradient);
+    const arma::mat firstGradient = denseGradient.cols(0, 1);
+    densePolicy.Update(denseIterate, 0.1, firstGradient);
+    vanillaIterate -= 0.1 * denseGradient.col(2);
+  }
+
+  CheckMatrices(sparseIterate.cols(0, 1), denseIterate, 1e-10);
+  CheckMatrices(sparseIterate.col(2), vanillaIterate, 1e-10);
+}
+
+/**
+ * Blocks that overlap, go out of the iterate, mix rows and columns, or do not
+ * match the policies should be rejected.
+ */
+TEST_CASE("BlockUpdateInvalidBlocksTest", "[MomentumSGDTest]")
+{
+  typedef BlockUpdate<VanillaUpdate, VanillaUpdate> UpdateType;
+  typedef UpdateType::Policy<arma::mat, arma::mat> PolicyType;
+
+  UpdateType overlap({ UpdateBlock::Cols(0, 2), UpdateBlock::Cols(2, 3) },
+      VanillaUpdate(), VanillaUpdate());
+  REQUIRE_THROWS_AS(PolicyType(overlap, 4, 4), std::invalid_argument);
+
+  UpdateType outside({ UpdateBlock::Cols(0, 1), UpdateBlock::Cols(2, 4) },
+      VanillaUpdate(), VanillaUpdate());
+  REQUIRE_THROWS_AS(PolicyType(outside, 4, 4), std::invalid_argument);
+
+  UpdateType mixed({ UpdateBlock::Cols(0, 1), UpdateBlock::Rows(2, 3) },
+      VanillaUpdate(), VanillaUpdate());
+  REQUIRE_THROWS_AS(PolicyType(mixed, 4, 4), std::invalid_argument);
+
+  UpdateType missing({ UpdateBlock::Cols(0, 1) }, VanillaUpdate(),
+      VanillaUpdate());
+  REQUIRE_THROWS_AS(PolicyType(missing, 4, 4), std::invalid_argument);
+}
+
+/**
+ * Optimize a logistic regression problem with momentum on the weights and a
+ * smaller vanilla step on the intercept, and make sure the results are
+ * acceptable.
+ */
+TEST_CASE("BlockUpdateLogisticRegressionTest", "[MomentumSGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  // The coordinates are a row vector: the intercept, then the weights.
+  const size_t dimensionality = lr.GetInitialPoint().n_elem;
+  typedef BlockUpdate<VanillaUpdate, MomentumUpdate> UpdateType;
+  UpdateType update({ UpdateBlock::Cols(0, 0, 0.5),
+      UpdateBlock::Cols(1, dimensionality - 1) }, VanillaUpdate(),
+      MomentumUpdate(0.5));
+  SGD<UpdateType> s(0.01, 32, 100000, 1e-5, true, update);
+
+  arma::mat coordinates = lr.GetInitialPoint();
+  s.Optimize(lr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+/**
+ * Make sure that ForEachBlock() covers every element of a matrix exactly once,
+ * with the last blocks cut.
+ */
+TEST_CASE("ForEachBlockTest", "[MomentumSGDTest]")
+{
+  arma::umat counts(5, 7, arma::fill::zeros);
+  size_t numBlocks = 0;
+  ForEachBlock(5, 7, 2, 3, [&](const size_t r0, const size_t c0,
+                               const size_t r1, const size_t c1)
+  {
+    REQUIRE(r1 - r0 < 2);
+    REQUIRE(c1 - c0 < 3);
+    counts.submat(r0, c0, r1, c1) += 1;
+    ++numBlocks;
+  });
+
+  REQUIRE(numBlocks == 9);
+  REQUIRE(arma::all(arma::vectorise(counts) == 1));
+
+  // A block size of 0 means the whole dimension.
+  numBlocks = 0;
+  ForEachBlock(5, 7, 0, 1, [&](const size_t r0, const size_t,
+                               const size_t r1, const size_t)
+  {
+    REQUIRE(r0 == 0);
+    REQUIRE(r1 == 4);
+    ++numBlocks;
+  });
+  REQUIRE(numBlocks == 7);
+}
+
+/**
+ * Train and test a logistic regression function with LARS and large batches,
+ * with the whole iterate as one block and with one block per column.
+ */
+TEST_CASE("LARSLogisticRegressionTest", "[MomentumSGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  for (const size_t blockCols : { 0, 1 })
+  {
+    LARS s(1.0, 500, 1000000, -1.0, true,
+        LARSUpdate(0.9, 0.01, 0.0005, 0, blockCols));
+    REQUIRE(s.UpdatePolicy().BlockCols() == blockCols);
+
+    arma::mat coordinates = lr.GetInitialPoint();
+    s.Optimize(lr, coordinates);
+
+    // Ensure that the error is close to zero.
+    const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+    REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+    const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+        coordinates);
+    REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+  }
+}
+
+/**
+ * With a gradient that has no zeros, the lazy momentum update must be the same
+ * as the momentum update.
+ */
+TEST_CASE("LazyMomentumDenseGradientTest", "[MomentumSGDTest]")
+{
+  MomentumUpdate update(0.7);
+  LazyMomentumUpdate lazyUpdate(0.7);
+  MomentumUpdate::Policy<arma::mat, arma::mat> densePolicy(update, 10, 3);
+  LazyMomentumUpdate::Policy<arma::mat, arma::sp_mat> lazyPolicy(lazyUpdate,
+      10, 3);
+
+  arma::mat denseIterate(10, 3, arma::fill::randu);
+  arma::mat lazyIterate(denseIterate);
+  for (size_t i = 0; i < 100; ++i)
+  {
+    const arma::mat gradient = arma::randu<arma::mat>(10, 3) + 0.1;
+    densePolicy.Update(denseIterate, 0.01, gradient);
+    lazyPolicy.Update(lazyIterate, 0.01, arma::sp_mat(gradient));
+  }
+
+  for (size_t i = 0; i < denseIterate.n_elem; ++i)
+    REQUIRE(lazyIterate[i] == Approx(denseIterate[i]).margin(1e-10));
+}
+
+/**
+ * Run the lazy momentum update with sparse gradients on a function where each
+ * point only touches one coordinate.
+ */
+TEST_CASE("LazyMomentumSGDSparseTestFunction", "[MomentumSGDTest]")
+{
+  SparseTestFunction f;
+  LazyMomentumUpdate lazyUpdate(0.5);
+  LazyMomentumSGD s(0.1, 1, 100000, 1e-9, true, lazyUpdate);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  s.Optimize<SparseTestFunction, arma::mat, arma::sp_mat>(f, coordinates);
+
+  REQUIRE(coordinates[0] == Approx(2.0).margin(0.01));
+  REQUIRE(coordinates[1] == Approx(1.0).margin(0.01));
+  REQUIRE(coordinates[2] == Approx(1.5).margin(0.01));
+  REQUIRE(coordinates[3] == Approx(4.0).margin(0.01));
+}
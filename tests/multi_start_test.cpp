@@ -0,0 +1,87 @@
+/**
+ * @file multi_start_test.cpp
+ *
+ * Test file for the MultiStart wrapper.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Test that L-BFGS restarted from many points finds the global minimum of the
+ * Rastrigin function, while a single run from the initial point gets stuck in
+ * a local minimum, and that the distinct minima are reported best first.
+ */
+TEST_CASE("MultiStartRastriginFunctionTest", "[MultiStartTest]")
+{
+  RastriginFunction f(2);
+
+  for (const bool parallel : { false, true })
+  {
+    MultiStart<L_BFGS> optimizer(L_BFGS(), 100, -1.0, 1.0, -DBL_MAX, 1e-3,
+        parallel);
+
+    arma::mat coordinates = f.GetInitialPoint();
+    const double objective = optimizer.Optimize(f, coordinates);
+
+    REQUIRE(objective == Approx(0.0).margin(1e-5));
+    REQUIRE(coordinates[0] == Approx(0.0).margin(1e-3));
+    REQUIRE(coordinates[1] == Approx(0.0).margin(1e-3));
+    REQUIRE(optimizer.StartsRun() == 100);
+
+    // The run from the initial point ends in another minimum.
+    const arma::cube& minima = optimizer.Minima();
+    const arma::vec& objectives = optimizer.MinimaObjectives();
+    REQUIRE(minima.n_slices > 1);
+    REQUIRE(objectives.n_elem == minima.n_slices);
+    REQUIRE(arma::approx_equal(minima.slice(0), coordinates, "absdiff",
+        1e-12));
+    for (size_t i = 1; i < objectives.n_elem; ++i)
+      REQUIRE(objectives(i) >= objectives(i - 1));
+  }
+}
+
+/**
+ * Test that the remaining starts are skipped once the target objective is
+ * reached.
+ */
+TEST_CASE("MultiStartTargetObjectiveTest", "[MultiStartTest]")
+{
+  RastriginFunction f(2);
+
+  for (const bool parallel : { false, true })
+  {
+    MultiStart<L_BFGS> optimizer(L_BFGS(), 1000, -1.0, 1.0, 1e-6, 1e-3,
+        parallel);
+
+    arma::mat coordinates = f.GetInitialPoint();
+    const double objective = optimizer.Optimize(f, coordinates);
+
+    REQUIRE(objective <= 1e-6);
+    REQUIRE(optimizer.StartsRun() < 1000);
+  }
+}
+
+/**
+ * Test MultiStart with an optimizer that does not take callbacks.
+ */
+TEST_CASE("MultiStartSPSASphereFunctionTest", "[MultiStartTest]")
+{
+  SphereFunction f(2);
+  MultiStart<SPSA> optimizer(SPSA(0.1, 0.102, 0.16, 0.3, 100000, 0), 4);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  optimizer.Optimize(f, coordinates);
+
+  REQUIRE(coordinates[0] == Approx(0.0).margin(0.1));
+  REQUIRE(coordinates[1] == Approx(0.0).margin(0.1));
+  REQUIRE(optimizer.StartsRun() == 4);
+}
@@ -0,0 +1,160 @@
+/**
+ * @file newton_cg_test.cpp
+ *
+ * Tests for the Newton-CG optimizer and Hessian-vector products.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * The quadratic f(x) = 0.5 x^T A x - b^T x with a symmetric positive definite
+ * A, which gives its Hessian-vector products exactly and counts them.
+ */
+class QuadraticHessianFunction
+{
+ public:
+  QuadraticHessianFunction(const size_t dimension) : products(0)
+  {
+    const arma::mat m = arma::randu<arma::mat>(dimension, dimension);
+    a = m * m.t() + dimension * arma::eye<arma::mat>(dimension, dimension);
+    b = arma::randu<arma::vec>(dimension);
+  }
+
+  double Evaluate(const arma::mat& x)
+  {
+    const double quadratic = arma::as_scalar(x.t() * a * x);
+    const double linear = arma::as_scalar(b.t() * x);
+    return 0.5 * quadratic - linear;
+  }
+
+  void Gradient(const arma::mat& x, arma::mat& gradient)
+  {
+    gradient = a * x - b;
+  }
+
+  void HessianVectorProduct(const arma::mat& /* x */,
+                            const arma::mat& direction,
+                            arma::mat& product)
+  {
+    ++products;
+    product = a * direction;
+  }
+
+  arma::mat a;
+  arma::vec b;
+  size_t products;
+};
+
+/**
+ * Make sure that the exact Hessian-vector products of a function are used, and
+ * that Newton-CG finds the minimum of a quadratic in one Newton step.
+ */
+TEST_CASE("NewtonCGQuadraticTest", "[NewtonCGTest]")
+{
+  QuadraticHessianFunction f(10);
+  NewtonCG optimizer(10, 0, 1e-10);
+
+  arma::mat coordinates(10, 1, arma::fill::zeros);
+  optimizer.Optimize(f, coordinates);
+
+  const arma::vec expected = arma::solve(f.a, f.b);
+  for (size_t i = 0; i < 10; ++i)
+    REQUIRE(coordinates[i] == Approx(expected[i]).epsilon(1e-5));
+  REQUIRE(f.products > 0);
+}
+
+/**
+ * Make sure that the finite-difference Hessian-vector product of a function
+ * without a HessianVectorProduct() method is close to the exact one.
+ */
+TEST_CASE("NewtonCGFiniteDifferenceProductTest", "[NewtonCGTest]")
+{
+  RosenbrockFunction f;
+  arma::mat coordinates("0.5; 0.7");
+  arma::mat direction("1.0; -2.0");
+  arma::mat gradient, product;
+  f.Gradient(coordinates, gradient);
+  HessianVectorProduct(f, coordinates, gradient, direction, product);
+
+  // The Hessian of the Rosenbrock function, formed explicitly.
+  const double x = coordinates[0], y = coordinates[1];
+  arma::mat hessian(2, 2);
+  hessian(0, 0) = 1200 * x * x - 400 * y + 2;
+  hessian(0, 1) = hessian(1, 0) = -400 * x;
+  hessian(1, 1) = 200;
+  const arma::mat expected = hessian * direction;
+
+  REQUIRE(product[0] == Approx(expected[0]).epsilon(1e-4));
+  REQUIRE(product[1] == Approx(expected[1]).epsilon(1e-4));
+}
+
+/**
+ * Run Newton-CG on the Rosenbrock function, whose Hessian is not positive
+ * definite everywhere.
+ */
+TEST_CASE("NewtonCGRosenbrockTest", "[NewtonCGTest]")
+{
+  RosenbrockFunction f;
+  NewtonCG optimizer;
+
+  arma::mat coordinates = f.GetInitialPoint();
+  const double result = optimizer.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-5));
+  REQUIRE(coordinates[0] == Approx(1.0).epsilon(1e-3));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(1e-3));
+}
+
+/**
+ * Run Newton-CG on logistic regression and make sure the results are
+ * acceptable.
+ */
+TEST_CASE("NewtonCGLogisticRegressionTest", "[NewtonCGTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  NewtonCG optimizer;
+  arma::mat coordinates = lr.GetInitialPoint();
+  optimizer.Optimize(lr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+/**
+ * Make sure that Newton-CG calls the callbacks once per step.
+ */
+TEST_CASE("NewtonCGCallbackTest", "[NewtonCGTest]")
+{
+  RosenbrockFunction f;
+  NewtonCG optimizer;
+
+  arma::mat coordinates = f.GetInitialPoint();
+  Telemetry telemetry;
+  optimizer.Optimize(f, coordinates, telemetry);
+
+  REQUIRE(telemetry.Size() > 0);
+  REQUIRE(telemetry.Record(telemetry.Size() - 1).iteration == telemetry.Size());
+  REQUIRE(telemetry.Record(telemetry.Size() - 1).objective ==
+      Approx(0.0).margin(1e-5));
+}
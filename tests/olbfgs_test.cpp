@@ -0,0 +1,87 @@
+/**
+ * @file olbfgs_test.cpp
+ *
+ * Test file for oLBFGS (online L-BFGS).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Run oLBFGS on logistic regression and make sure the results are acceptable.
+ */
+TEST_CASE("OLBFGSLogisticRegressionTest", "[OLBFGSTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  for (size_t batchSize = 16; batchSize <= 64; batchSize *= 4)
+  {
+    OLBFGS olbfgs(0.1, batchSize, 10, 100000, 1e-5);
+    LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+    arma::mat coordinates = lr.GetInitialPoint();
+    olbfgs.Optimize(lr, coordinates);
+
+    // Ensure that the error is close to zero.
+    const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+    REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+    const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+        coordinates);
+    REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+  }
+}
+
+/**
+ * Run oLBFGS on the sphere function with a constant step size and damping.
+ */
+TEST_CASE("OLBFGSSphereFunctionTest", "[OLBFGSTest]")
+{
+  SphereFunction f(2);
+  OLBFGS olbfgs(0.5, 2, 5, 500000, 1e-10, 0, 1e-3);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  olbfgs.Optimize(f, coordinates);
+
+  REQUIRE(coordinates[0] == Approx(0.0).margin(0.1));
+  REQUIRE(coordinates[1] == Approx(0.0).margin(0.1));
+}
+
+/**
+ * Make sure that oLBFGS reports one step per batch to the callbacks, and that
+ * each step takes two batch gradients.
+ */
+TEST_CASE("OLBFGSCallbackTest", "[OLBFGSTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  // One pass over the data.
+  OLBFGS olbfgs(0.1, 10, 10, lr.NumFunctions());
+  olbfgs.ObjectiveEstimate() = ObjectiveEstimate::Reuse();
+
+  arma::mat coordinates = lr.GetInitialPoint();
+  Budget budget;
+  olbfgs.Optimize(lr, coordinates, budget);
+
+  const size_t numBatches = (lr.NumFunctions() + 9) / 10;
+  REQUIRE(budget.Evaluations() == numBatches);
+  REQUIRE(budget.Gradients() == 2 * numBatches);
+}
@@ -90,6 +90,428 @@ TEST_CASE("ParallelSGDGeneralizedRosenbrockTest", "[ParallelSGDTest]")
   }
 }
 
+/**
+ * Make sure every datapoint is visited in each iteration even if the share of
+ * a thread is much smaller than the number of datapoints per thread.
+ */
+TEST_CASE("ParallelSGDSmallThreadShareTest", "[ParallelSGDTest]")
+{
+  SparseTestFunction f;
+
+  for (size_t i = omp_get_max_threads(); i > 0; --i)
+  {
+    omp_set_num_threads(i);
+    ParallelSGD<ConstantStep> s(10000, 1, 1e-5, true, ConstantStep(0.4));
+
+    arma::mat coordinates = f.GetInitialPoint();
+    double result = s.Optimize(f, coordinates);
+
+    REQUIRE(result == Approx(123.75).epsilon(0.0001));
+    REQUIRE(coordinates[0] == Approx(2.0).epsilon(0.0002));
+    REQUIRE(coordinates[1] == Approx(1.0).epsilon(0.0002));
+    REQUIRE(coordinates[2] == Approx(1.5).epsilon(0.0002));
+    REQUIRE(coordinates[3] == Approx(4.0).epsilon(0.0002));
+  }
+}
+
+/**
+ * Make sure parallel SGD visits every function when the gradient is computed
+ * in batches, including a smaller last batch.
+ */
+TEST_CASE("ParallelSGDBatchSizeTest", "[ParallelSGDTest]")
+{
+  SparseTestFunction f;
+
+  for (size_t batchSize = 1; batchSize <= f.NumFunctions(); ++batchSize)
+  {
+    omp_set_num_threads(1);
+    ParallelSGD<ConstantStep> s(10000, f.NumFunctions(), 1e-5, true,
+        ConstantStep(0.4), AtomicUpdate(), batchSize);
+
+    arma::mat coordinates = f.GetInitialPoint();
+    double result = s.Optimize(f, coordinates);
+
+    REQUIRE(result == Approx(123.75).epsilon(0.0001));
+    REQUIRE(coordinates[0] == Approx(2.0).epsilon(0.0002));
+    REQUIRE(coordinates[1] == Approx(1.0).epsilon(0.0002));
+    REQUIRE(coordinates[2] == Approx(1.5).epsilon(0.0002));
+    REQUIRE(coordinates[3] == Approx(4.0).epsilon(0.0002));
+  }
+}
+
+/**
+ * Run parallel SGD with the given update policy on the sparse test function
+ * with all available threads.
+ */
+template<typename UpdatePolicyType>
+void SparseTestFunctionUpdatePolicy(const UpdatePolicyType& updatePolicy)
+{
+  SparseTestFunction f;
+
+  omp_set_num_threads(omp_get_max_threads());
+  size_t batchSize = std::ceil((float) f.NumFunctions() /
+      omp_get_max_threads());
+
+  ParallelSGD<ConstantStep, UpdatePolicyType> s(10000, batchSize, 1e-5, true,
+      ConstantStep(0.4), updatePolicy);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(123.75).epsilon(0.0001));
+  REQUIRE(coordinates[0] == Approx(2.0).epsilon(0.0002));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(0.0002));
+  REQUIRE(coordinates[2] == Approx(1.5).epsilon(0.0002));
+  REQUIRE(coordinates[3] == Approx(4.0).epsilon(0.0002));
+}
+
+/**
+ * Test parallel SGD with unsynchronized updates.
+ */
+TEST_CASE("HogwildUpdateParallelSGDTest", "[ParallelSGDTest]")
+{
+  SparseTestFunctionUpdatePolicy(HogwildUpdate());
+}
+
+/**
+ * Test parallel SGD with per-thread delta buffers, flushed both before and at
+ * the end of each thread's share.
+ */
+TEST_CASE("DeltaBufferUpdateParallelSGDTest", "[ParallelSGDTest]")
+{
+  SparseTestFunctionUpdatePolicy(DeltaBufferUpdate(1));
+  SparseTestFunctionUpdatePolicy(DeltaBufferUpdate());
+}
+
+/**
+ * Test parallel SGD with a replica of the iterate per group of threads, both
+ * reconciled after every batch and once per iteration, and with one replica
+ * per NUMA node.
+ */
+TEST_CASE("ReplicatedParallelSGDTest", "[ParallelSGDTest]")
+{
+  SparseTestFunction f;
+  REQUIRE(NumaNodes() >= 1);
+
+  omp_set_num_threads(omp_get_max_threads());
+  const size_t replicas[3] = { 2, 2, 0 };
+  const size_t reconcileIntervals[3] = { 1, 0, 2 };
+  for (size_t i = 0; i < 3; ++i)
+  {
+    ParallelSGD<ConstantStep, AtomicUpdate> s(10000, 1, 1e-5, true,
+        ConstantStep(0.4), AtomicUpdate(), 1, replicas[i],
+        reconcileIntervals[i]);
+
+    arma::mat coordinates = f.GetInitialPoint();
+    double result = s.Optimize(f, coordinates);
+
+    REQUIRE(result == Approx(123.75).epsilon(0.0001));
+    REQUIRE(coordinates[0] == Approx(2.0).epsilon(0.0002));
+    REQUIRE(coordinates[1] == Approx(1.0).epsilon(0.0002));
+    REQUIRE(coordinates[2] == Approx(1.5).epsilon(0.0002));
+    REQUIRE(coordinates[3] == Approx(4.0).epsilon(0.0002));
+  }
+}
+
+/**
+ * Run parallel SGD with unsynchronized updates on a logistic regression
+ * function with sparse predictors, whose batch gradients are sparse, and make
+ * sure the results are acceptable.
+ */
+TEST_CASE("ParallelSGDSparseLogisticRegressionTest", "[ParallelSGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  const arma::sp_mat sparseData(shuffledData);
+  LogisticRegressionFunction<arma::sp_mat> lr(sparseData, shuffledResponses,
+      0.5);
+
+  omp_set_num_threads(omp_get_max_threads());
+  const size_t threadShareSize = std::ceil((float) lr.NumFunctions() /
+      omp_get_max_threads());
+  ParallelSGD<ConstantStep, HogwildUpdate> s(100, threadShareSize, 1e-5, true,
+      ConstantStep(0.01));
+
+  arma::mat coordinates = lr.GetInitialPoint();
+  s.Optimize(lr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(arma::sp_mat(data), responses,
+      coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(arma::sp_mat(testData),
+      testResponses, coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+
+/**
+ * A SparseTestFunction that counts the calls to its separable Evaluate(),
+ * which may come from several threads.
+ */
+class EvaluateCountingSparseFunction : public SparseTestFunction
+{
+ public:
+  EvaluateCountingSparseFunction() : evaluations(0) { }
+
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t i,
+                  const size_t batchSize = 1) const
+  {
+    ++evaluations;
+    return SparseTestFunction::Evaluate(coordinates, i, batchSize);
+  }
+
+  size_t Evaluations() const { return evaluations; }
+
+ private:
+  mutable std::atomic<size_t> evaluations;
+};
+
+/**
+ * Make sure that the convergence checks of parallel SGD are only made every
+ * EvaluationInterval() iterations, with a full pass split across the threads.
+ */
+TEST_CASE("ParallelSGDEvaluationIntervalTest", "[ParallelSGDTest]")
+{
+  omp_set_num_threads(omp_get_max_threads());
+
+  // All 20 iterations run, and the objective is checked before iterations 1,
+  // 6, 11 and 16, each time with one call per function.
+  EvaluateCountingSparseFunction f;
+  ParallelSGD<ConstantStep> s(21, 1, -1.0, true, ConstantStep(0.4));
+  s.EvaluationInterval() = 5;
+
+  arma::mat coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates);
+  REQUIRE(f.Evaluations() == 16);
+
+  REQUIRE(coordinates[0] == Approx(2.0).epsilon(0.0002));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(0.0002));
+  REQUIRE(coordinates[2] == Approx(1.5).epsilon(0.0002));
+  REQUIRE(coordinates[3] == Approx(4.0).epsilon(0.0002));
+}
+
+/**
+ * Make sure that parallel SGD still converges when the objective of the
+ * convergence checks is estimated from a subsample.
+ */
+TEST_CASE("ParallelSGDSubsampledObjectiveTest", "[ParallelSGDTest]")
+{
+  omp_set_num_threads(omp_get_max_threads());
+
+  EvaluateCountingSparseFunction f;
+  ParallelSGD<ConstantStep> s(10000, 1, 1e-5, true, ConstantStep(0.4));
+  s.ObjectiveEstimate() = ObjectiveEstimate::Subsample(2);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates);
+
+  // Each check evaluates two of the four functions.
+  REQUIRE(f.Evaluations() % 2 == 0);
+  REQUIRE(coordinates[0] == Approx(2.0).epsilon(0.0002));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(0.0002));
+  REQUIRE(coordinates[2] == Approx(1.5).epsilon(0.0002));
+  REQUIRE(coordinates[3] == Approx(4.0).epsilon(0.0002));
+}
+
+/**
+ * The SparseTestFunction, with its gradient emitted through ScatterGradient()
+ * instead of a sparse Gradient(); the calls to ScatterGradient() are counted.
+ */
+class ScatterSparseTestFunction
+{
+ public:
+  ScatterSparseTestFunction() :
+      intercepts("20 12 15 100"), bi("-4 -2 -3 -8"), scatters(0) { }
+
+  size_t NumFunctions() const { return 4; }
+
+  void Shuffle() { }
+
+  arma::mat GetInitialPoint() const { return arma::mat("0 0 0 0;"); }
+
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t i,
+                  const size_t batchSize = 1) const
+  {
+    double result = 0.0;
+    for (size_t j = i; j < i + batchSize; ++j)
+    {
+      result += coordinates[j] * coordinates[j] + bi[j] * coordinates[j] +
+          intercepts[j];
+    }
+
+    return result;
+  }
+
+  template<typename ScatterType>
+  void ScatterGradient(const arma::mat& coordinates,
+                       const size_t i,
+                       ScatterType& scatter,
+                       const size_t batchSize = 1) const
+  {
+    ++scatters;
+    for (size_t j = i; j < i + batchSize; ++j)
+      scatter(0, j, 2 * coordinates[j] + bi[j]);
+  }
+
+  size_t Scatters() const { return scatters; }
+
+ private:
+  arma::vec intercepts;
+  arma::vec bi;
+  mutable std::atomic<size_t> scatters;
+};
+
+/**
+ * Make sure that parallel SGD applies the gradients emitted through
+ * ScatterGradient() with each update policy, for functions without a sparse
+ * Gradient().
+ */
+TEST_CASE("ParallelSGDScatterGradientTest", "[ParallelSGDTest]")
+{
+  omp_set_num_threads(omp_get_max_threads());
+
+  for (size_t policy = 0; policy < 3; ++policy)
+  {
+    ScatterSparseTestFunction f;
+    arma::mat coordinates = f.GetInitialPoint();
+    double result;
+    if (policy == 0)
+    {
+      ParallelSGD<ConstantStep> s(10000, 1, 1e-5, true, ConstantStep(0.4));
+      result = s.Optimize(f, coordinates);
+    }
+    else if (policy == 1)
+    {
+      ParallelSGD<ConstantStep, HogwildUpdate> s(10000, 1, 1e-5, true,
+          ConstantStep(0.4));
+      result = s.Optimize(f, coordinates);
+    }
+    else
+    {
+      ParallelSGD<ConstantStep, DeltaBufferUpdate> s(10000, 2, 1e-5, true,
+          ConstantStep(0.4), DeltaBufferUpdate(2), 2);
+      result = s.Optimize(f, coordinates);
+    }
+
+    REQUIRE(f.Scatters() > 0);
+    REQUIRE(result == Approx(123.75).epsilon(0.0001));
+    REQUIRE(coordinates[0] == Approx(2.0).epsilon(0.0002));
+    REQUIRE(coordinates[1] == Approx(1.0).epsilon(0.0002));
+    REQUIRE(coordinates[2] == Approx(1.5).epsilon(0.0002));
+    REQUIRE(coordinates[3] == Approx(4.0).epsilon(0.0002));
+  }
+}
+
+/**
+ * Test parallel SGD with per-coordinate AdaGrad step sizes, both with a sparse
+ * Gradient() and with ScatterGradient().
+ */
+TEST_CASE("SparseAdaGradUpdateParallelSGDTest", "[ParallelSGDTest]")
+{
+  omp_set_num_threads(omp_get_max_threads());
+
+  SparseTestFunction f;
+  ParallelSGD<ConstantStep, SparseAdaGradUpdate> s(1000, 1, -1.0, true,
+      ConstantStep(1.0));
+
+  arma::mat coordinates = f.GetInitialPoint();
+  double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(123.75).epsilon(0.0001));
+  REQUIRE(coordinates[0] == Approx(2.0).epsilon(0.0002));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(0.0002));
+  REQUIRE(coordinates[2] == Approx(1.5).epsilon(0.0002));
+  REQUIRE(coordinates[3] == Approx(4.0).epsilon(0.0002));
+
+  ScatterSparseTestFunction g;
+  coordinates = g.GetInitialPoint();
+  result = s.Optimize(g, coordinates);
+
+  REQUIRE(g.Scatters() > 0);
+  REQUIRE(result == Approx(123.75).epsilon(0.0001));
+  REQUIRE(coordinates[0] == Approx(2.0).epsilon(0.0002));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(0.0002));
+  REQUIRE(coordinates[2] == Approx(1.5).epsilon(0.0002));
+  REQUIRE(coordinates[3] == Approx(4.0).epsilon(0.0002));
+}
+
+/**
+ * A separable function over a hashed feature space of 2^30 coordinates, of
+ * which each function touches a single one: f_i(x) = (x[k_i] - (i + 1))^2.
+ */
+class HashedFeatureFunction
+{
+ public:
+  HashedFeatureFunction(const size_t numFunctions) : keys(numFunctions)
+  {
+    // Spread the keys over the whole space.
+    for (size_t i = 0; i < numFunctions; ++i)
+      keys[i] = (i * 10000019 + 12345) % Dimension();
+  }
+
+  static size_t Dimension() { return size_t(1) << 30; }
+
+  size_t NumFunctions() const { return keys.size(); }
+
+  size_t Key(const size_t i) const { return keys[i]; }
+
+  void Shuffle() { }
+
+  double Evaluate(const HashedIterate& coordinates,
+                  const size_t begin,
+                  const size_t batchSize = 1) const
+  {
+    double objective = 0.0;
+    for (size_t i = begin; i < begin + batchSize; ++i)
+      objective += std::pow(coordinates[keys[i]] - (i + 1.0), 2.0);
+    return objective;
+  }
+
+  void Gradient(const HashedIterate& coordinates,
+                const size_t begin,
+                arma::sp_mat& gradient,
+                const size_t batchSize = 1) const
+  {
+    gradient.zeros(coordinates.n_rows, coordinates.n_cols);
+    for (size_t i = begin; i < begin + batchSize; ++i)
+      gradient[keys[i]] = 2.0 * (coordinates[keys[i]] - (i + 1.0));
+  }
+
+ private:
+  std::vector<size_t> keys;
+};
+
+/**
+ * Make sure that parallel SGD can optimize a hashed iterate with 2^30 logical
+ * coordinates, with a shared iterate and with replicas.
+ */
+TEST_CASE("HashedIterateParallelSGDTest", "[ParallelSGDTest]")
+{
+  omp_set_num_threads(omp_get_max_threads());
+
+  HashedFeatureFunction f(100);
+  for (size_t replicas = 1; replicas <= 2; ++replicas)
+  {
+    ParallelSGD<ConstantStep, AtomicUpdate> s(10000, 4, 1e-10, true,
+        ConstantStep(0.4), AtomicUpdate(), 1, replicas);
+
+    HashedIterate coordinates(HashedFeatureFunction::Dimension(), 1, 256);
+    const double result = s.Optimize(f, coordinates);
+
+    REQUIRE(result == Approx(0.0).margin(1e-5));
+    REQUIRE(coordinates.Size() == 100);
+    for (size_t i = 0; i < 100; ++i)
+      REQUIRE(coordinates[f.Key(i)] == Approx(i + 1.0).epsilon(1e-4));
+  }
+}
+
 #endif
 
 /**
@@ -110,3 +532,42 @@ TEST_CASE("ExponentialBackoffDecayTest", "[ParallelSGDTest]")
   // At the 211th iteration, stepsize should be changed
   REQUIRE(decayPolicy.StepSize(211) == 81);
 }
+
+/**
+ * Make sure that HashedIterate stores the coordinates that are written to,
+ * returns 0 for the other ones, and copies deeply.
+ */
+TEST_CASE("HashedIterateTest", "[ParallelSGDTest]")
+{
+  HashedIterate x(size_t(1) << 30, 2, 5);
+  REQUIRE(x.Capacity() == 8);
+  REQUIRE(x.n_elem == (size_t(1) << 31));
+
+  x(3, 1) = 2.5;
+  x[7] += 1.0;
+  x(123456789, 0) = 0.0;
+  REQUIRE(x.Size() == 3);
+
+  const HashedIterate& cx = x;
+  REQUIRE(cx(3, 1) == 2.5);
+  REQUIRE(cx[(size_t(1) << 30) + 3] == 2.5);
+  REQUIRE(cx[7] == 1.0);
+  REQUIRE(cx[8] == 0.0);
+  REQUIRE(x.Size() == 3);
+
+  HashedIterate y = x;
+  y[7] = 4.0;
+  REQUIRE(cx[7] == 1.0);
+  REQUIRE(y[7] == 4.0);
+
+  const arma::sp_mat sparse = cx.ToSparse();
+  REQUIRE(sparse.n_nonzero == 2);
+  REQUIRE(sparse(3, 1) == 2.5);
+  REQUIRE(sparse(7, 0) == 1.0);
+
+  // The table is full after eight coordinates.
+  for (size_t i = 0; i < 5; ++i)
+    x[100 + i] = 1.0;
+  REQUIRE(x.Size() == 8);
+  REQUIRE_THROWS_AS(x[200] = 1.0, std::length_error);
+}
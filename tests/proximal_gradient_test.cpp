@@ -0,0 +1,250 @@
+/**
+ * @file proximal_gradient_test.cpp
+ *
+ * Tests for proximal gradient descent (ISTA and FISTA), its stochastic variant,
+ * and the proximal operators.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Create a noise-free least squares problem whose solution has three nonzero
+ * coordinates out of twenty.
+ */
+inline FuncSq SparseLeastSquares()
+{
+  arma::mat A = arma::randn<arma::mat>(100, 20);
+  arma::vec x(20, arma::fill::zeros);
+  x[2] = 5.0;
+  x[7] = -3.0;
+  x[11] = 4.0;
+
+  return FuncSq(A, A * x);
+}
+
+/**
+ * Check the optimality conditions of the lasso: the gradient is -lambda times
+ * the sign of every nonzero coordinate, and at most lambda in magnitude for
+ * the zero coordinates.
+ */
+inline void CheckLassoSolution(FuncSq& f,
+                               const arma::mat& coordinates,
+                               const double lambda)
+{
+  arma::mat gradient;
+  f.Gradient(coordinates, gradient);
+  for (size_t i = 0; i < coordinates.n_elem; ++i)
+  {
+    if (coordinates[i] > 0)
+      REQUIRE(gradient[i] == Approx(-lambda).margin(1e-2));
+    else if (coordinates[i] < 0)
+      REQUIRE(gradient[i] == Approx(lambda).margin(1e-2));
+    else
+      REQUIRE(std::abs(gradient[i]) <= lambda + 1e-2);
+  }
+}
+
+/**
+ * FISTA should solve a lasso problem, with an exactly sparse solution.
+ */
+TEST_CASE("FISTALassoTest", "[ProximalGradientTest]")
+{
+  FuncSq f = SparseLeastSquares();
+  ProximalGradient optimizer(L1Penalty(5.0));
+
+  arma::mat coordinates(20, 1, arma::fill::zeros);
+  const double result = optimizer.Optimize(f, coordinates);
+
+  CheckLassoSolution(f, coordinates, 5.0);
+  REQUIRE(result == Approx(f.Evaluate(coordinates) +
+      5.0 * arma::accu(arma::abs(coordinates))).epsilon(1e-10));
+
+  // Most coordinates are exactly zero.
+  REQUIRE(arma::accu(coordinates == 0.0) >= 15);
+}
+
+/**
+ * ISTA should find the same solution as FISTA.
+ */
+TEST_CASE("ISTALassoTest", "[ProximalGradientTest]")
+{
+  FuncSq f = SparseLeastSquares();
+  ProximalGradient fista(L1Penalty(5.0));
+  ProximalGradient ista(L1Penalty(5.0), 1.0, 10000, 1e-10, false);
+
+  arma::mat fistaCoordinates(20, 1, arma::fill::zeros);
+  arma::mat istaCoordinates(20, 1, arma::fill::zeros);
+  const double fistaResult = fista.Optimize(f, fistaCoordinates);
+  const double istaResult = ista.Optimize(f, istaCoordinates);
+
+  CheckLassoSolution(f, istaCoordinates, 5.0);
+  REQUIRE(istaResult == Approx(fistaResult).epsilon(1e-5));
+}
+
+/**
+ * With a fixed step size below the inverse of the Lipschitz constant, no
+ * backtracking is needed.
+ */
+TEST_CASE("FISTAFixedStepLassoTest", "[ProximalGradientTest]")
+{
+  FuncSq f = SparseLeastSquares();
+  const double lipschitz = arma::norm(f.MatrixA(), 2) *
+      arma::norm(f.MatrixA(), 2);
+  ProximalGradient optimizer(L1Penalty(5.0), 1.0 / lipschitz, 10000, 1e-10,
+      true, false);
+
+  arma::mat coordinates(20, 1, arma::fill::zeros);
+  optimizer.Optimize(f, coordinates);
+
+  CheckLassoSolution(f, coordinates, 5.0);
+}
+
+/**
+ * The group lasso should zero out whole groups, and satisfy its optimality
+ * conditions.
+ */
+TEST_CASE("FISTAGroupLassoTest", "[ProximalGradientTest]")
+{
+  FuncSq f = SparseLeastSquares();
+
+  // Five groups of four consecutive coordinates; only groups 0, 1 and 2 hold
+  // nonzeros of the solution.
+  arma::uvec groups(20);
+  for (size_t i = 0; i < 20; ++i)
+    groups[i] = i / 4;
+
+  const double lambda = 5.0;
+  ProximalGradientType<GroupLassoPenalty> optimizer(
+      GroupLassoPenalty(lambda, groups));
+
+  arma::mat coordinates(20, 1, arma::fill::zeros);
+  optimizer.Optimize(f, coordinates);
+
+  arma::mat gradient;
+  f.Gradient(coordinates, gradient);
+  for (size_t g = 0; g < 5; ++g)
+  {
+    const arma::vec x = coordinates.rows(4 * g, 4 * g + 3);
+    const arma::vec grad = gradient.rows(4 * g, 4 * g + 3);
+    const double norm = arma::norm(x);
+    if (norm > 0)
+      REQUIRE(arma::norm(grad + lambda * x / norm) == Approx(0.0).margin(1e-2));
+    else
+      REQUIRE(arma::norm(grad) <= lambda + 1e-2);
+  }
+
+  // The groups 3 and 4 are not used by the solution.
+  REQUIRE(arma::accu(arma::abs(coordinates.rows(12, 19))) == 0.0);
+}
+
+/**
+ * With the L1 ball constraint, proximal gradient is projected gradient: the
+ * solution is a fixed point of the projected gradient step, inside the ball.
+ */
+TEST_CASE("ProximalGradientL1BallTest", "[ProximalGradientTest]")
+{
+  FuncSq f = SparseLeastSquares();
+  L1BallConstraint constraint(6.0);
+  ProximalGradientType<L1BallConstraint> optimizer(constraint);
+
+  arma::mat coordinates(20, 1, arma::fill::zeros);
+  optimizer.Optimize(f, coordinates);
+
+  REQUIRE(arma::norm(coordinates, 1) <= 6.0 + 1e-8);
+
+  arma::mat gradient;
+  f.Gradient(coordinates, gradient);
+  arma::mat projected = coordinates - 1e-3 * gradient;
+  constraint.ProximalStep(projected, 1e-3);
+  REQUIRE(arma::norm(projected - coordinates) == Approx(0.0).margin(1e-5));
+}
+
+/**
+ * With the L0 ball constraint, proximal gradient is iterative hard
+ * thresholding, which recovers the support of the noise-free problem.
+ */
+TEST_CASE("ProximalGradientL0BallTest", "[ProximalGradientTest]")
+{
+  FuncSq f = SparseLeastSquares();
+  ProximalGradientType<L0BallConstraint> optimizer(L0BallConstraint(3), 1.0,
+      10000, 1e-12, false);
+
+  arma::mat coordinates(20, 1, arma::fill::zeros);
+  const double result = optimizer.Optimize(f, coordinates);
+
+  REQUIRE(arma::accu(coordinates != 0.0) <= 3);
+  REQUIRE(result == Approx(0.0).margin(1e-6));
+  REQUIRE(coordinates[2] == Approx(5.0).epsilon(1e-4));
+  REQUIRE(coordinates[7] == Approx(-3.0).epsilon(1e-4));
+  REQUIRE(coordinates[11] == Approx(4.0).epsilon(1e-4));
+}
+
+/**
+ * Make sure the soft-thresholding of the L1 penalty and the block
+ * soft-thresholding of the group lasso are correct.
+ */
+TEST_CASE("ProximalOperatorsTest", "[ProximalGradientTest]")
+{
+  arma::mat x("3.0 -0.5; -2.0 0.25");
+  L1Penalty l1(1.0);
+  REQUIRE(l1.Evaluate(x) == Approx(5.75));
+  l1.ProximalStep(x, 0.5);
+  REQUIRE(x(0, 0) == Approx(2.5));
+  REQUIRE(x(1, 0) == Approx(-1.5));
+  REQUIRE(x(0, 1) == 0.0);
+  REQUIRE(x(1, 1) == 0.0);
+
+  // Each row is a group: the norm of the first row is 5, of the second 0.5.
+  arma::mat y("3.0 4.0; 0.3 0.4");
+  GroupLassoPenalty groupLasso(2.0);
+  REQUIRE(groupLasso.Evaluate(y) == Approx(11.0));
+  groupLasso.ProximalStep(y, 0.5);
+  REQUIRE(y(0, 0) == Approx(2.4));
+  REQUIRE(y(0, 1) == Approx(3.2));
+  REQUIRE(y(1, 0) == 0.0);
+  REQUIRE(y(1, 1) == 0.0);
+}
+
+/**
+ * The stochastic variant should fit an L1-regularized logistic regression
+ * model, and keep the weights of pure noise features close to zero.
+ */
+TEST_CASE("StochasticProximalGradientLogisticRegressionTest",
+          "[ProximalGradientTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  // Add five features that are pure noise.
+  shuffledData = arma::join_cols(shuffledData,
+      arma::randn<arma::mat>(5, shuffledData.n_cols));
+  testData = arma::join_cols(testData,
+      arma::randn<arma::mat>(5, testData.n_cols));
+  LogisticRegressionFunction<> lr(shuffledData, shuffledResponses, 0.0);
+
+  StochasticProximalGradient optimizer(L1Penalty(10.0), 0.1, 32, 100000,
+      1e-5, true);
+  arma::mat coordinates = lr.GetInitialPoint();
+  optimizer.Optimize(lr, coordinates);
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.01)); // 1% error tolerance.
+
+  // The intercept comes first, then the three informative features.
+  for (size_t i = 4; i < coordinates.n_elem; ++i)
+    REQUIRE(std::abs(coordinates[i]) < 0.05);
+}
@@ -53,6 +53,40 @@ TEST_CASE("ProjectToL1","[ProximalTest]")
   }
 }
 
+/**
+ * Make sure that the l1 projection is exact: the result is on the surface of
+ * the ball and is the soft thresholding found by sorting the magnitudes.
+ */
+TEST_CASE("ProjectToL1Exact","[ProximalTest]")
+{
+  const double tau = 2.0;
+  for (size_t trial = 0; trial < 10; ++trial)
+  {
+    vec v = randn<vec>(1000);
+
+    // Reference threshold, from the sorted magnitudes.
+    const vec sorted = sort(abs(v), "descend");
+    const vec sums = cumsum(sorted);
+    double theta = 0.0;
+    for (size_t j = 0; j < sorted.n_elem; ++j)
+    {
+      if (sorted(j) > (sums(j) - tau) / (j + 1))
+        theta = (sums(j) - tau) / (j + 1);
+    }
+
+    vec expected = sign(v) % clamp(abs(v) - theta, 0.0, datum::inf);
+
+    Proximal::ProjectToL1Ball(v, tau);
+    REQUIRE(norm(v, 1) == Approx(tau).epsilon(1e-10));
+    REQUIRE(norm(v - expected, "inf") == Approx(0.0).margin(1e-10));
+  }
+
+  // A radius of zero projects onto the origin.
+  vec v = randn<vec>(10);
+  Proximal::ProjectToL1Ball(v, 0.0);
+  REQUIRE(norm(v, 1) == 0.0);
+}
+
 /**
  * Approximate a vector with a tau-sparse vector.
  */
@@ -82,3 +116,28 @@ TEST_CASE("ProjectToL0","[ProximalTest]")
     REQUIRE(distanceNew >= distance);
   }
 }
+
+/**
+ * Make sure that the l0 projection keeps the largest magnitudes, and handles
+ * sparsity levels outside of [0, n].
+ */
+TEST_CASE("ProjectToL0Selection","[ProximalTest]")
+{
+  vec v("0.5 -3.0 1.0 2.0 -0.1");
+
+  vec v0 = v;
+  Proximal::ProjectToL0Ball(v0, 2);
+  REQUIRE(v0(0) == 0.0);
+  REQUIRE(v0(1) == -3.0);
+  REQUIRE(v0(2) == 0.0);
+  REQUIRE(v0(3) == 2.0);
+  REQUIRE(v0(4) == 0.0);
+
+  v0 = v;
+  Proximal::ProjectToL0Ball(v0, 10);
+  REQUIRE(norm(v0 - v, 2) == 0.0);
+
+  v0 = v;
+  Proximal::ProjectToL0Ball(v0, 0);
+  REQUIRE(norm(v0, 2) == 0.0);
+}
@@ -53,3 +53,97 @@ TEST_CASE("RMSPropLogisticRegressionTest", "[rmsprop]")
       coordinates);
   REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
 }
+
+/**
+ * Make sure that the RMSProp update for sparse gradients, which defers the
+ * decay of untouched coordinates, gives the same iterates as the dense update.
+ */
+TEST_CASE("RMSPropSparseUpdateTest", "[rmsprop]")
+{
+  RMSPropUpdate update(1e-8, 0.9);
+  RMSPropUpdate::Policy<arma::mat, arma::mat> densePolicy(update, 20, 5);
+  RMSPropUpdate::Policy<arma::mat, arma::sp_mat> sparsePolicy(update, 20, 5);
+
+  arma::mat denseIterate(20, 5, arma::fill::randu);
+  arma::mat sparseIterate(denseIterate);
+  for (size_t i = 0; i < 100; ++i)
+  {
+    const arma::sp_mat gradient = arma::sprandn<arma::sp_mat>(20, 5, 0.05);
+    densePolicy.Update(denseIterate, 0.01, arma::mat(gradient));
+    sparsePolicy.Update(sparseIterate, 0.01, gradient);
+  }
+
+  for (size_t i = 0; i < denseIterate.n_elem; ++i)
+    REQUIRE(sparseIterate[i] == Approx(denseIterate[i]).margin(1e-10));
+}
+
+/**
+ * Run RMSProp with sparse gradients on a function where each point only
+ * touches one coordinate.
+ */
+TEST_CASE("RMSPropSparseTestFunction", "[rmsprop]")
+{
+  SparseTestFunction f;
+  RMSProp optimizer(1e-3, 1, 0.99, 1e-8, 5000000, 1e-9, true);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  optimizer.Optimize<SparseTestFunction, arma::mat, arma::sp_mat>(f,
+      coordinates);
+
+  REQUIRE(coordinates[0] == Approx(2.0).margin(0.1));
+  REQUIRE(coordinates[1] == Approx(1.0).margin(0.1));
+  REQUIRE(coordinates[2] == Approx(1.5).margin(0.1));
+  REQUIRE(coordinates[3] == Approx(4.0).margin(0.1));
+}
+
+/**
+ * Run RMSProp with its mean squared gradient stored in 8 bits on logistic
+ * regression and make sure the results are acceptable.
+ */
+TEST_CASE("ReducedPrecisionRMSPropLogisticRegressionTest", "[rmsprop]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  SGD<ReducedPrecisionRMSPropUpdate<BlockQuantized8State>> optimizer(0.01, 32,
+      100000, 1e-5, true);
+  arma::mat coordinates = lr.GetInitialPoint();
+  optimizer.Optimize(lr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+/**
+ * Make sure that RMSProp with its state stored as floats gives nearly the same
+ * iterates as the full precision update.
+ */
+TEST_CASE("ReducedPrecisionRMSPropFloat32Test", "[rmsprop]")
+{
+  RMSPropUpdate update;
+  ReducedPrecisionRMSPropUpdate<Float32State> reducedUpdate;
+  RMSPropUpdate::Policy<arma::mat, arma::mat> policy(update, 300, 3);
+  ReducedPrecisionRMSPropUpdate<Float32State>::Policy<arma::mat, arma::mat>
+      reducedPolicy(reducedUpdate, 300, 3);
+
+  arma::mat iterate(300, 3, arma::fill::randu);
+  arma::mat reducedIterate(iterate);
+  for (size_t i = 0; i < 50; ++i)
+  {
+    const arma::mat gradient = arma::randn<arma::mat>(300, 3);
+    policy.Update(iterate, 0.001, gradient);
+    reducedPolicy.Update(reducedIterate, 0.001, gradient);
+  }
+
+  for (size_t i = 0; i < iterate.n_elem; ++i)
+    REQUIRE(reducedIterate[i] == Approx(iterate[i]).margin(1e-5));
+}
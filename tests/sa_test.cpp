@@ -16,6 +16,33 @@
 using namespace ens;
 using namespace ens::test;
 
+/**
+ * A separable quadratic, f(x) = sum_i (x_i - 1)^2, that evaluates the change
+ * of one coordinate in O(1) and counts its evaluations.
+ */
+class SeparableQuadraticFunction
+{
+ public:
+  SeparableQuadraticFunction() : evaluations(0), deltaEvaluations(0) { }
+
+  double Evaluate(const arma::mat& x)
+  {
+    ++evaluations;
+    return arma::accu(arma::square(x - 1.0));
+  }
+
+  double EvaluateDelta(const arma::mat& x,
+                       const size_t index,
+                       const double newValue)
+  {
+    ++deltaEvaluations;
+    return std::pow(newValue - 1.0, 2.0) - std::pow(x(index) - 1.0, 2.0);
+  }
+
+  size_t evaluations;
+  size_t deltaEvaluations;
+};
+
 // The Generalized-Rosenbrock function is a simple function to optimize.
 TEST_CASE("SAGeneralizedRosenbrockTest","[SATest]")
 {
@@ -93,3 +120,125 @@ TEST_CASE("RastrigrinFunctionTest","[SATest]")
 
   REQUIRE(successes >= 1);
 }
+
+/**
+ * Parallel tempering should find the global minimum of the Rastrigin function;
+ * the hot chains escape from the local minima and hand the good states down.
+ */
+TEST_CASE("ParallelTemperingRastriginTest", "[SATest]")
+{
+  RastriginFunction f(2);
+  ParallelTempering pt(8, 1e-6, 100.0, 100000, 1, 100, 1e-12, 30, 2.0, 0.5,
+      0.3);
+  arma::mat coordinates = f.GetInitialPoint();
+
+  const double result = pt.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-3));
+  REQUIRE(coordinates[0] == Approx(0.0).margin(1e-3));
+  REQUIRE(coordinates[1] == Approx(0.0).margin(1e-3));
+  REQUIRE(pt.Temperatures().n_elem == 8);
+  REQUIRE(pt.SwapAcceptance().n_elem == 7);
+}
+
+// The Rosenbrock function is a simple function to optimize.
+TEST_CASE("ParallelTemperingRosenbrockTest", "[SATest]")
+{
+  RosenbrockFunction f;
+  ParallelTempering pt(8, 1e-8, 10.0, 500000, 1, 100, 1e-11, 30, 1.5, 0.3,
+      0.3);
+  arma::mat coordinates = f.GetInitialPoint();
+
+  const double result = pt.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-5));
+  REQUIRE(coordinates[0] == Approx(1.0).epsilon(1e-2));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(1e-2));
+}
+
+/**
+ * Running the chains on separate threads should give exactly the same result as
+ * running them one after the other.
+ */
+TEST_CASE("ParallelTemperingParallelChainsTest", "[SATest]")
+{
+  RastriginFunction f(4);
+  ParallelTempering pt(6, 1e-3, 10.0, 20000);
+
+  arma::arma_rng::set_seed(42);
+  arma::mat serialCoordinates = f.GetInitialPoint();
+  const double serialResult = pt.Optimize(f, serialCoordinates);
+
+  pt.ParallelChains() = true;
+  arma::arma_rng::set_seed(42);
+  arma::mat parallelCoordinates = f.GetInitialPoint();
+  const double parallelResult = pt.Optimize(f, parallelCoordinates);
+
+  REQUIRE(parallelResult == serialResult);
+  for (size_t j = 0; j < 4; ++j)
+    REQUIRE(parallelCoordinates[j] == serialCoordinates[j]);
+}
+
+/**
+ * SA and parallel tempering should evaluate the moves of a function with
+ * EvaluateDelta() incrementally, and track its objective accurately.
+ */
+TEST_CASE("SAEvaluateDeltaTest", "[SATest]")
+{
+  SeparableQuadraticFunction f;
+  ExponentialSchedule schedule;
+  SA<> sa(schedule, 1000000, 1000., 1000, 100, 1e-11, 3, 1.5, 0.3, 0.3);
+  arma::mat coordinates(10, 1, arma::fill::zeros);
+
+  const double result = sa.Optimize(f, coordinates);
+
+  REQUIRE(f.evaluations == 1);
+  REQUIRE(f.deltaEvaluations > 0);
+  REQUIRE(result == Approx(0.0).margin(1e-3));
+  REQUIRE(result == Approx(arma::accu(arma::square(coordinates - 1.0)))
+      .margin(1e-8));
+
+  SeparableQuadraticFunction g;
+  ParallelTempering pt(4, 1e-6, 1.0, 100000);
+  coordinates.zeros();
+
+  const double ptResult = pt.Optimize(g, coordinates);
+
+  REQUIRE(g.evaluations == 1);
+  REQUIRE(g.deltaEvaluations > 0);
+  REQUIRE(ptResult == Approx(0.0).margin(1e-3));
+  REQUIRE(ptResult == Approx(arma::accu(arma::square(coordinates - 1.0)))
+      .margin(1e-8));
+}
+
+/**
+ * SA with block moves should minimize a higher-dimensional function, both
+ * with a full evaluation per block and with EvaluateDelta(), and track the
+ * objective of the final point.
+ */
+TEST_CASE("SABlockMoveTest", "[SATest]")
+{
+  SphereFunction f(20);
+  ExponentialSchedule schedule;
+  SA<> sa(schedule, 1000000, 1000., 1000, 100, 1e-11, 3, 1.5, 0.3, 0.3, 4);
+  arma::mat coordinates = f.GetInitialPoint();
+
+  double result = sa.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-3));
+  REQUIRE(result == Approx(f.Evaluate(coordinates)).margin(1e-10));
+
+  // The last block of a sweep is smaller.
+  SeparableQuadraticFunction g;
+  sa.BlockSize() = 7;
+  sa.Temperature() = 1000.;
+  coordinates.zeros(30, 1);
+
+  result = sa.Optimize(g, coordinates);
+
+  REQUIRE(g.evaluations == 1);
+  REQUIRE(g.deltaEvaluations > 0);
+  REQUIRE(result == Approx(0.0).margin(1e-3));
+  REQUIRE(result == Approx(arma::accu(arma::square(coordinates - 1.0)))
+      .margin(1e-8));
+}
@@ -0,0 +1,102 @@
+/**
+ * @file saga_test.cpp
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Run the given SAGA variant on logistic regression and make sure the results
+ * are acceptable.
+ */
+template<typename OptimizerType>
+void SAGALogisticRegressionTest(OptimizerType& optimizer)
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  arma::mat coordinates = lr.GetInitialPoint();
+  optimizer.Optimize(lr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+}
+
+/**
+ * Run SAGA on logistic regression with a couple of batch sizes.
+ */
+TEST_CASE("SAGALogisticRegressionTest", "[SAGATest]")
+{
+  for (size_t batchSize = 1; batchSize < 45; batchSize += 20)
+  {
+    SAGA optimizer(0.005, batchSize, 100000, 1e-5, true);
+    SAGALogisticRegressionTest(optimizer);
+  }
+}
+
+/**
+ * Run SAG on logistic regression.
+ */
+TEST_CASE("SAGLogisticRegressionTest", "[SAGATest]")
+{
+  SAG optimizer(0.005, 10, 100000, 1e-5, true);
+  SAGALogisticRegressionTest(optimizer);
+}
+
+/**
+ * Run SAGA on logistic regression, storing one scalar per point, and visiting
+ * the batches in linear order.
+ */
+TEST_CASE("LinearSAGALogisticRegressionTest", "[SAGATest]")
+{
+  LinearSAGA optimizer(0.005, 10, 100000, 1e-5, false);
+  SAGALogisticRegressionTest(optimizer);
+}
+
+/**
+ * Make sure that storing one scalar per point gives the same iterates as
+ * storing the whole gradient of every batch.
+ */
+TEST_CASE("LinearSAGAMatchesSAGATest", "[SAGATest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  SAGA saga(0.005, 16, 5000, 0.0, false);
+  LinearSAGA linearSaga(0.005, 16, 5000, 0.0, false);
+
+  arma::mat coordinates = lr.GetInitialPoint();
+  arma::mat linearCoordinates = lr.GetInitialPoint();
+  saga.Optimize(lr, coordinates);
+  linearSaga.Optimize(lr, linearCoordinates);
+
+  for (size_t i = 0; i < coordinates.n_elem; ++i)
+  {
+    REQUIRE(linearCoordinates[i] ==
+        Approx(coordinates[i]).epsilon(1e-5).margin(1e-8));
+  }
+}
@@ -38,6 +38,26 @@ TEST_CASE("PreCalcSCDTest","[SCDTest]")
   REQUIRE(objective <= 0.055);
 }
 
+/**
+ * Test SCD on the logistic regression function with the same data given as a
+ * sparse matrix.
+ */
+TEST_CASE("PreCalcSCDSparseTest","[SCDTest]")
+{
+  arma::sp_mat predictors(arma::mat(
+      "0 0 0.4; 0 0 0.6; 0 0.3 0; 0.2 0 0; 0.2 -0.5 0;"));
+  arma::Row<size_t> responses("1  1  0;");
+
+  LogisticRegressionFunction<arma::sp_mat> f(predictors, responses, 0.0001);
+
+  SCD<> s(0.02, 60000, 1e-5);
+  arma::mat iterate = f.InitialPoint();
+
+  double objective = s.Optimize(f, iterate);
+
+  REQUIRE(objective <= 0.055);
+}
+
 /**
  * Test the correctness of the SCD implemenation by using the sparse test
  * function, with dijoint features which optimize to a precalculated minima.
@@ -64,6 +84,46 @@ TEST_CASE("DisjointFeatureTest","[SCDTest]")
   REQUIRE(iterate[3] == Approx(4.0).epsilon(0.0002));
 }
 
+/**
+ * Test SCD with parallel updates on the sparse test function.  The features
+ * are disjoint, so updating all of them at once finds the same minima.
+ */
+TEST_CASE("ParallelDisjointFeatureTest","[SCDTest]")
+{
+  SparseTestFunction f;
+  SCD<CyclicDescent> s(0.4, 100000, 1e-5, 1e3, CyclicDescent(), 4);
+
+  arma::mat iterate = f.GetInitialPoint();
+
+  double result = s.Optimize(f, iterate);
+
+  REQUIRE(result == Approx(123.75).epsilon(0.0001));
+
+  REQUIRE(iterate[0] == Approx(2.0).epsilon(0.0002));
+  REQUIRE(iterate[1] == Approx(1.0).epsilon(0.0002));
+  REQUIRE(iterate[2] == Approx(1.5).epsilon(0.0002));
+  REQUIRE(iterate[3] == Approx(4.0).epsilon(0.0002));
+}
+
+/**
+ * Test SCD with parallel updates of random coordinates on the logistic
+ * regression function with a precalculated minima.
+ */
+TEST_CASE("ParallelPreCalcSCDTest","[SCDTest]")
+{
+  arma::mat predictors("0 0 0.4; 0 0 0.6; 0 0.3 0; 0.2 0 0; 0.2 -0.5 0;");
+  arma::Row<size_t> responses("1  1  0;");
+
+  LogisticRegressionFunction<arma::mat> f(predictors, responses, 0.0001);
+
+  SCD<> s(0.02, 60000, 1e-5, 1e3, RandomDescent(), 2);
+  arma::mat iterate = f.InitialPoint();
+
+  double objective = s.Optimize(f, iterate);
+
+  REQUIRE(objective <= 0.055);
+}
+
 /**
  * Test the greedy descent policy.
  */
@@ -86,6 +146,50 @@ TEST_CASE("GreedyDescentTest","[SCDTest]")
   REQUIRE(descentPolicy.DescentFeature(0, point, f) == 1);
 }
 
+/**
+ * Test that the priority greedy descent policy picks the coordinate with the
+ * largest partial gradient as coordinates are descended on.
+ */
+TEST_CASE("PriorityGreedyDescentTest","[SCDTest]")
+{
+  // The partial gradients at this point are -1, 2, 3 and 0.
+  arma::mat point("1.5; 2; 3; 4;");
+
+  SparseTestFunction f;
+
+  PriorityGreedyDescent descentPolicy;
+
+  REQUIRE(descentPolicy.DescentFeature(1, point, f) == 2);
+
+  // Descend to the minimum along the picked coordinates.
+  point[2] = 1.5;
+  REQUIRE(descentPolicy.DescentFeature(2, point, f) == 1);
+
+  point[1] = 1;
+  REQUIRE(descentPolicy.DescentFeature(3, point, f) == 0);
+}
+
+/**
+ * Test SCD with the priority greedy descent policy on the sparse test
+ * function.
+ */
+TEST_CASE("PriorityGreedySCDTest","[SCDTest]")
+{
+  SparseTestFunction f;
+  SCD<PriorityGreedyDescent> s(0.4);
+
+  arma::mat iterate = f.GetInitialPoint();
+
+  double result = s.Optimize(f, iterate);
+
+  REQUIRE(result == Approx(123.75).epsilon(0.0001));
+
+  REQUIRE(iterate[0] == Approx(2.0).epsilon(0.0002));
+  REQUIRE(iterate[1] == Approx(1.0).epsilon(0.0002));
+  REQUIRE(iterate[2] == Approx(1.5).epsilon(0.0002));
+  REQUIRE(iterate[3] == Approx(4.0).epsilon(0.0002));
+}
+
 /**
  * Test the cyclic descent policy.
  */
@@ -162,6 +266,159 @@ TEST_CASE("LogisticRegressionFunctionPartialGradientTest","[SCDTest]")
   }
 }
 
+/**
+ * Test that LogisticRegressionFunction::PartialDerivative() matches the full
+ * gradient, and that CoordinateLipschitz() bounds the change of each partial
+ * derivative.
+ */
+TEST_CASE("LogisticRegressionFunctionPartialDerivativeTest","[SCDTest]")
+{
+  typedef LogisticRegressionFunction<arma::mat> FunctionType;
+  REQUIRE(traits::HasScalarPartialDerivative<FunctionType>::value);
+  REQUIRE(traits::HasCoordinateLipschitzConstant<FunctionType>::value);
+  REQUIRE(!traits::HasScalarPartialDerivative<SparseTestFunction>::value);
+
+  arma::mat predictors("0 0 0.4; 0 0 0.6; 0 0.3 0; 0.2 0 0; 0.2 -0.5 0;");
+  arma::Row<size_t> responses("1  1  0;");
+
+  FunctionType f(predictors, responses, 0.0001);
+
+  arma::mat testPoint(1, f.NumFeatures(), arma::fill::randu);
+
+  arma::mat testGradient;
+  f.Gradient(testPoint, testGradient);
+
+  for (size_t i = 0; i < f.NumFeatures(); ++i)
+  {
+    const double derivative = f.PartialDerivative(testPoint, i, 0);
+    REQUIRE(derivative == Approx(testGradient[i]).epsilon(1e-7));
+
+    arma::mat movedPoint(testPoint);
+    movedPoint[i] += 0.5;
+    const double change = std::abs(f.PartialDerivative(movedPoint, i, 0) -
+        derivative);
+    REQUIRE(change <= 0.5 * f.CoordinateLipschitz(i) + 1e-10);
+  }
+}
+
+/**
+ * Test SCD with the scalar partial derivatives and the Lipschitz step sizes of
+ * the logistic regression function, and with the given step size instead.
+ */
+TEST_CASE("LipschitzStepsSCDTest","[SCDTest]")
+{
+  arma::mat predictors("0 0 0.4; 0 0 0.6; 0 0.3 0; 0.2 0 0; 0.2 -0.5 0;");
+  arma::Row<size_t> responses("1  1  0;");
+
+  LogisticRegressionFunction<arma::mat> f(predictors, responses, 0.0001);
+
+  SCD<CyclicDescent> s(0.02, 60000, 1e-5, 1e3, CyclicDescent());
+  REQUIRE(s.LipschitzSteps());
+
+  arma::mat iterate = f.InitialPoint();
+  double objective = s.Optimize(f, iterate);
+  REQUIRE(objective <= 0.055);
+
+  s.LipschitzSteps() = false;
+  iterate = f.InitialPoint();
+  objective = s.Optimize(f, iterate);
+  REQUIRE(objective <= 0.055);
+}
+
+/**
+ * Test that the block PartialGradient() of LogisticRegressionFunction matches
+ * the full gradient, for blocks with and without the intercept.
+ */
+TEST_CASE("LogisticRegressionFunctionBlockPartialGradientTest","[SCDTest]")
+{
+  arma::mat predictors("0 0 0.4; 0 0 0.6; 0 0.3 0; 0.2 0 0; 0.2 -0.5 0;");
+  arma::Row<size_t> responses("1  1  0;");
+
+  LogisticRegressionFunction<arma::mat> f(predictors, responses, 0.0001);
+
+  arma::mat testPoint(1, f.NumFeatures(), arma::fill::randu);
+
+  arma::mat testGradient;
+  f.Gradient(testPoint, testGradient);
+
+  for (size_t begin = 0; begin < f.NumFeatures() - 2; ++begin)
+  {
+    arma::mat blockGradient;
+    f.PartialGradient(testPoint, begin, blockGradient, 3);
+
+    CheckMatrices(testGradient.cols(begin, begin + 2), blockGradient);
+  }
+}
+
+/**
+ * Test that the cached objective of LogisticRegressionFunction follows
+ * coordinate steps.
+ */
+TEST_CASE("LogisticRegressionFunctionObjectiveCacheTest","[SCDTest]")
+{
+  REQUIRE(traits::HasObjectiveCache<
+      LogisticRegressionFunction<arma::mat>>::value);
+
+  arma::mat predictors("0 0 0.4; 0 0 0.6; 0 0.3 0; 0.2 0 0; 0.2 -0.5 0;");
+  arma::Row<size_t> responses("1  1  0;");
+
+  LogisticRegressionFunction<arma::mat> f(predictors, responses, 0.0001);
+
+  arma::mat point(1, f.NumFeatures(), arma::fill::randu);
+  f.ResetCache(point);
+  REQUIRE(f.CachedEvaluate() == Approx(f.Evaluate(point)).epsilon(1e-7));
+
+  for (size_t j = 0; j < f.NumFeatures(); ++j)
+  {
+    arma::mat delta(1, 1);
+    delta[0] = 0.1 * (j + 1);
+    point(0, j) += delta[0];
+    f.UpdateCache(point, j, delta);
+
+    REQUIRE(f.CachedEvaluate() == Approx(f.Evaluate(point)).epsilon(1e-7));
+  }
+}
+
+/**
+ * Test block coordinate descent on the logistic regression function, with
+ * blocks that don't divide the number of features.
+ */
+TEST_CASE("BlockSCDLogisticRegressionTest","[SCDTest]")
+{
+  arma::mat predictors("0 0 0.4; 0 0 0.6; 0 0.3 0; 0.2 0 0; 0.2 -0.5 0;");
+  arma::Row<size_t> responses("1  1  0;");
+
+  LogisticRegressionFunction<arma::mat> f(predictors, responses, 0.0001);
+
+  SCD<CyclicDescent> s(0.02, 60000, 1e-5, 1e3, CyclicDescent(), 1, 4);
+  arma::mat iterate = f.InitialPoint();
+
+  double objective = s.Optimize(f, iterate);
+
+  REQUIRE(objective <= 0.055);
+}
+
+/**
+ * Test block coordinate descent with a function that has no block
+ * PartialGradient(), so the features of each block are computed one by one.
+ */
+TEST_CASE("BlockSCDDisjointFeatureTest","[SCDTest]")
+{
+  SparseTestFunction f;
+  SCD<CyclicDescent> s(0.4, 100000, 1e-5, 1e3, CyclicDescent(), 1, 3);
+
+  arma::mat iterate = f.GetInitialPoint();
+
+  double result = s.Optimize(f, iterate);
+
+  REQUIRE(result == Approx(123.75).epsilon(0.0001));
+
+  REQUIRE(iterate[0] == Approx(2.0).epsilon(0.0002));
+  REQUIRE(iterate[1] == Approx(1.0).epsilon(0.0002));
+  REQUIRE(iterate[2] == Approx(1.5).epsilon(0.0002));
+  REQUIRE(iterate[3] == Approx(4.0).epsilon(0.0002));
+}
+
 /**
  * Test that SoftmaxRegressionFunction::PartialGradient() works as expected.
  */
@@ -202,3 +459,68 @@ TEST_CASE("SoftmaxRegressionFunctionPartialGradientTest","[SCDTest]")
     CheckMatrices(gradient.col(j), arma::mat(fGrad.col(j)));
   }
 }
+
+/**
+ * Create a lasso problem whose features are orthonormal, so that the optimal
+ * weights are the soft-thresholded correlations of the features with the
+ * responses, and only the first five features are relevant.
+ */
+LassoFunction OrthonormalLassoProblem(const double lambda, arma::vec& optimum)
+{
+  const arma::mat predictors = arma::orth(arma::randn<arma::mat>(200, 100)).t();
+  arma::rowvec weights(100, arma::fill::zeros);
+  weights.head(5).fill(2.0);
+  const arma::rowvec responses = weights * predictors +
+      0.05 * arma::randn<arma::rowvec>(200);
+
+  const arma::vec correlations = predictors * responses.t();
+  optimum = arma::sign(correlations) %
+      arma::clamp(arma::abs(correlations) - lambda, 0.0, DBL_MAX);
+
+  return LassoFunction(predictors, responses, lambda);
+}
+
+/**
+ * Make sure that SCD with gap safe screening finds the lasso solution, and
+ * screens out exactly the irrelevant features once it is there.
+ */
+TEST_CASE("LassoScreeningSCDTest","[SCDTest]")
+{
+  arma::vec optimum;
+  LassoFunction f = OrthonormalLassoProblem(0.5, optimum);
+
+  SCD<CyclicDescent> s(1.0, 100000, 1e-10, 100);
+  arma::mat iterate = f.GetInitialPoint();
+  const double objective = s.Optimize(f, iterate);
+
+  REQUIRE(s.ScreenedFeatures() == 95);
+  for (size_t j = 0; j < 100; ++j)
+    REQUIRE(iterate[j] == Approx(optimum[j]).margin(1e-8));
+  REQUIRE(objective == Approx(f.Evaluate(iterate)).epsilon(1e-10));
+  REQUIRE(f.DualityGap(iterate) == Approx(0.0).margin(1e-8));
+
+  // Without screening, the solution is the same.
+  s.Screening() = false;
+  arma::mat unscreened = f.GetInitialPoint();
+  s.Optimize(f, unscreened);
+  REQUIRE(s.ScreenedFeatures() == 0);
+  for (size_t j = 0; j < 100; ++j)
+    REQUIRE(unscreened[j] == Approx(iterate[j]).margin(1e-8));
+}
+
+/**
+ * Make sure that SCD stops right away when lambda is so large that every
+ * feature is screened out at zero.
+ */
+TEST_CASE("LassoScreeningAllFeaturesSCDTest","[SCDTest]")
+{
+  arma::vec optimum;
+  LassoFunction f = OrthonormalLassoProblem(10.0, optimum);
+
+  SCD<RandomDescent> s(1.0, 100000, 1e-10, 100);
+  arma::mat iterate = f.GetInitialPoint();
+  s.Optimize(f, iterate);
+
+  REQUIRE(s.ScreenedFeatures() == 100);
+  REQUIRE(arma::accu(arma::abs(iterate)) == 0.0);
+}
@@ -564,3 +564,424 @@ TEST_CASE("CorrelationCoeffToySdp","[SdpPrimalDualTest]")
   REQUIRE(success == true);
   REQUIRE(obj == Approx(2 * (-0.978)).epsilon(1e-5));
 }
+
+// Load example 1 of the SDPA manual, whose feasible set is a single point.
+TEST_CASE("LoadSDPAExampleTest", "[SdpPrimalDualTest]")
+{
+  std::istringstream stream(
+      "\"Example 1: mDim = 3, nBLOCK = 1, {2}\"\n"
+      "   3  =  mDIM\n"
+      "   1  =  nBLOCK\n"
+      "   2  =  bLOCKsTRUCT\n"
+      "{48, -8, 20}\n"
+      "0 1 1 1 -11\n"
+      "0 1 2 2 23\n"
+      "1 1 1 1 10\n"
+      "1 1 1 2 4\n"
+      "2 1 2 2 -8\n"
+      "3 1 1 2 -8\n"
+      "3 1 2 2 -2\n");
+
+  SDP<arma::sp_mat> sdp;
+  LoadSDPA(stream, sdp);
+
+  REQUIRE(sdp.N() == 2);
+  REQUIRE(sdp.NumSparseConstraints() == 3);
+  REQUIRE(sdp.NumDenseConstraints() == 0);
+  REQUIRE(sdp.SparseB()[0] == Approx(48.0));
+  REQUIRE(sdp.SparseB()[1] == Approx(-8.0));
+  REQUIRE(sdp.SparseB()[2] == Approx(20.0));
+
+  // The objective is negated, and the off-diagonal entries are mirrored.
+  REQUIRE(sdp.C().n_nonzero == 2);
+  REQUIRE(sdp.C()(0, 0) == Approx(11.0));
+  REQUIRE(sdp.C()(1, 1) == Approx(-23.0));
+  REQUIRE(sdp.SparseA()[0].n_nonzero == 3);
+  REQUIRE(sdp.SparseA()[0](0, 1) == Approx(4.0));
+  REQUIRE(sdp.SparseA()[0](1, 0) == Approx(4.0));
+  REQUIRE(sdp.SparseA()[2](1, 0) == Approx(-8.0));
+  REQUIRE(sdp.HasLinearlyIndependentConstraints());
+
+  // The only feasible point, at which the objective is 41.9.
+  arma::mat X = { { 5.9, -1.375 }, { -1.375, 1.0 } };
+  for (size_t i = 0; i < 3; ++i)
+    REQUIRE(arma::accu(sdp.SparseA()[i] % X) == Approx(sdp.SparseB()[i]));
+  REQUIRE(arma::accu(sdp.C() % X) == Approx(41.9));
+}
+
+// Load an SDP with a dense objective, a diagonal block, and the entries of the
+// matrices in no particular order.
+TEST_CASE("LoadSDPABlocksTest", "[SdpPrimalDualTest]")
+{
+  std::istringstream stream(
+      "* Two blocks.\n"
+      "2\n"
+      "2\n"
+      "(2, -3)\n"
+      "1.5\n"
+      "-2.0\n"
+      "\n"
+      "1 2 3 3 1.0\n"
+      "0 1 2 1 0.5\n"
+      "2 1 1 2 1.0\n"
+      "1 1 1 1 2.0\n"
+      "1 2 3 3 1.0\n"
+      "0 2 1 1 -3.0\n");
+
+  SDP<arma::mat> sdp;
+  LoadSDPA(stream, sdp);
+
+  REQUIRE(sdp.N() == 5);
+  REQUIRE(sdp.NumSparseConstraints() == 2);
+
+  arma::mat c(5, 5, arma::fill::zeros);
+  c(0, 1) = c(1, 0) = -0.5;
+  c(2, 2) = 3.0;
+  REQUIRE(arma::abs(sdp.C() - c).max() < 1e-12);
+
+  // The duplicate entry is added.
+  arma::mat a0(5, 5, arma::fill::zeros);
+  a0(0, 0) = 2.0;
+  a0(4, 4) = 2.0;
+  REQUIRE(arma::abs(arma::mat(sdp.SparseA()[0]) - a0).max() < 1e-12);
+
+  arma::mat a1(5, 5, arma::fill::zeros);
+  a1(0, 1) = a1(1, 0) = 1.0;
+  REQUIRE(arma::abs(arma::mat(sdp.SparseA()[1]) - a1).max() < 1e-12);
+}
+
+// Invalid SDPA files are rejected.
+TEST_CASE("LoadSDPAInvalidTest", "[SdpPrimalDualTest]")
+{
+  SDP<arma::sp_mat> sdp;
+
+  // Truncated header.
+  std::istringstream truncated("1\n1\n");
+  REQUIRE_THROWS_AS(LoadSDPA(truncated, sdp), std::runtime_error);
+
+  // Off-diagonal entry in a diagonal block.
+  std::istringstream diagonal("1\n1\n-2\n1.0\n1 1 1 2 1.0\n");
+  REQUIRE_THROWS_AS(LoadSDPA(diagonal, sdp), std::runtime_error);
+
+  // Matrix number larger than the number of constraints.
+  std::istringstream matrix("1\n1\n2\n1.0\n2 1 1 1 1.0\n");
+  REQUIRE_THROWS_AS(LoadSDPA(matrix, sdp), std::runtime_error);
+
+  // Missing file.
+  REQUIRE_THROWS_AS(LoadSDPA("nonexistent.dat-s", sdp), std::runtime_error);
+}
+
+// The max-cut constraints X_ii = 1 are rank-one (A_i = e_i e_i^T), so giving
+// them as low-rank constraints must give the same solution as giving them as
+// sparse constraints.
+TEST_CASE("LowRankMaxCutSdp", "[SdpPrimalDualTest]")
+{
+  const SDP<arma::sp_mat> sparseSdp =
+      ConstructMaxCutSDPFromLaplacian("data/r10.txt");
+  const size_t n = sparseSdp.N();
+
+  SDP<arma::sp_mat> lowRankSdp(n, 0, 0, n);
+  lowRankSdp.C() = sparseSdp.C();
+  for (size_t i = 0; i < n; i++)
+  {
+    lowRankSdp.LowRankA()[i].zeros(n, 1);
+    lowRankSdp.LowRankA()[i](i, 0) = 1.;
+  }
+  lowRankSdp.LowRankB().ones();
+  REQUIRE(lowRankSdp.NumConstraints() == n);
+  REQUIRE(lowRankSdp.HasLinearlyIndependentConstraints());
+
+  PrimalDualSolver<SDP<arma::sp_mat>> sparseSolver(sparseSdp);
+  arma::mat sparseX;
+  const double sparseObj = sparseSolver.Optimize(sparseX);
+
+  PrimalDualSolver<SDP<arma::sp_mat>> lowRankSolver(lowRankSdp);
+  arma::mat X, Z;
+  arma::vec ysparse, ydense, ylowrank;
+  const double obj = lowRankSolver.Optimize(X, ysparse, ydense, ylowrank, Z);
+
+  REQUIRE(obj == Approx(sparseObj).epsilon(1e-5));
+  REQUIRE(ylowrank.n_elem == n);
+  for (size_t i = 0; i < n; i++)
+    REQUIRE(X(i, i) == Approx(1.0).epsilon(1e-5));
+
+  // Dual feasibility: Z = C - sum_i y_i e_i e_i^T.
+  const arma::mat dualCheck = Z - arma::mat(lowRankSdp.C()) +
+      arma::diagmat(ylowrank);
+  REQUIRE(arma::norm(dualCheck, "fro") < 1e-5);
+  REQUIRE(arma::norm(X * Z, "fro") < 1e-5);
+}
+
+// A low-accuracy LRSDP solution warm-starts the primal-dual solver, which
+// polishes it to the same optimum as a cold start.
+TEST_CASE("LRSDPWarmStartMaxCutSdp", "[SdpPrimalDualTest]")
+{
+  const SDP<arma::sp_mat> sdp = ConstructMaxCutSDPFromLaplacian("data/r10.txt");
+  const size_t n = sdp.N();
+
+  // Rank 5 is enough for the 10 constraints, since 5 * 6 / 2 > 10.
+  arma::mat coordinates = arma::randn<arma::mat>(n, 5);
+  coordinates = arma::normalise(coordinates, 2, 1);
+  LRSDP<SDP<arma::sp_mat>> lrsdp(n, 0, coordinates, 10);
+  lrsdp.SDP() = sdp;
+  lrsdp.Optimize(coordinates);
+
+  arma::vec y;
+  lrsdp.DualVariables(coordinates, y);
+  REQUIRE(y.n_elem == sdp.NumConstraints());
+
+  PrimalDualSolver<SDP<arma::sp_mat>> warmSolver(sdp);
+  warmSolver.WarmStart(coordinates, y);
+  arma::mat X, Z;
+  arma::vec ysparse, ydense;
+  const double warmObj = warmSolver.Optimize(X, ysparse, ydense, Z);
+  REQUIRE(CheckKKT(sdp, X, ysparse, ydense, Z));
+
+  PrimalDualSolver<SDP<arma::sp_mat>> coldSolver(sdp);
+  arma::mat coldX;
+  const double coldObj = coldSolver.Optimize(coldX);
+  REQUIRE(warmObj == Approx(coldObj).epsilon(1e-5));
+
+  // The warm start must be validated.
+  REQUIRE_THROWS_AS(warmSolver.WarmStart(coordinates.rows(0, n - 2), y),
+      std::logic_error);
+  REQUIRE_THROWS_AS(warmSolver.WarmStart(coordinates, y.head(n - 1)),
+      std::logic_error);
+}
+
+// Solving the Schur complement system iteratively, without forming it, must
+// give the same solutions as the direct solve, for sparse, dense and low-rank
+// constraints.
+TEST_CASE("IterativeSchurSdp", "[SdpPrimalDualTest]")
+{
+  const SDP<arma::sp_mat> sparseSdp =
+      ConstructMaxCutSDPFromLaplacian("data/r10.txt");
+  const size_t n = sparseSdp.N();
+
+  PrimalDualSolver<SDP<arma::sp_mat>> directSolver(sparseSdp);
+  arma::mat directX;
+  const double directObj = directSolver.Optimize(directX);
+  REQUIRE(directSolver.SchurIterations() == 0);
+
+  PrimalDualSolver<SDP<arma::sp_mat>> sparseSolver(sparseSdp);
+  sparseSolver.IterativeSchur() = true;
+  arma::mat X, Z;
+  arma::vec ysparse, ydense;
+  const double sparseObj = sparseSolver.Optimize(X, ysparse, ydense, Z);
+  REQUIRE(CheckKKT(sparseSdp, X, ysparse, ydense, Z));
+  REQUIRE(sparseObj == Approx(directObj).epsilon(1e-5));
+  REQUIRE(sparseSolver.SchurIterations() > 0);
+
+  // The same constraints X_ii = 1, given as dense and as low-rank
+  // constraints.
+  SDP<arma::sp_mat> denseSdp(n, 0, n);
+  SDP<arma::sp_mat> lowRankSdp(n, 0, 0, n);
+  denseSdp.C() = sparseSdp.C();
+  lowRankSdp.C() = sparseSdp.C();
+  for (size_t i = 0; i < n; i++)
+  {
+    denseSdp.DenseA()[i].zeros(n, n);
+    denseSdp.DenseA()[i](i, i) = 1.;
+    lowRankSdp.LowRankA()[i].zeros(n, 1);
+    lowRankSdp.LowRankA()[i](i, 0) = 1.;
+  }
+  denseSdp.DenseB().ones();
+  lowRankSdp.LowRankB().ones();
+
+  PrimalDualSolver<SDP<arma::sp_mat>> denseSolver(denseSdp);
+  denseSolver.IterativeSchur() = true;
+  arma::mat denseX;
+  REQUIRE(denseSolver.Optimize(denseX) == Approx(directObj).epsilon(1e-5));
+
+  PrimalDualSolver<SDP<arma::sp_mat>> lowRankSolver(lowRankSdp);
+  lowRankSolver.IterativeSchur() = true;
+  arma::mat lowRankX;
+  REQUIRE(lowRankSolver.Optimize(lowRankX) == Approx(directObj).epsilon(1e-5));
+
+  for (size_t i = 0; i < n; i++)
+  {
+    REQUIRE(denseX(i, i) == Approx(1.0).epsilon(1e-5));
+    REQUIRE(lowRankX(i, i) == Approx(1.0).epsilon(1e-5));
+  }
+
+  // A problem with many sparse constraints and a dense objective.
+  UndirectedGraph g;
+  UndirectedGraph::LoadFromEdges(g, "data/johnson8-4-4.csv", true);
+  const SDP<arma::mat> thetaSdp = ConstructLovaszThetaSDPFromGraph(g);
+
+  PrimalDualSolver<SDP<arma::mat>> thetaDirect(thetaSdp);
+  arma::mat thetaX;
+  const double thetaObj = thetaDirect.Optimize(thetaX);
+
+  PrimalDualSolver<SDP<arma::mat>> thetaSolver(thetaSdp);
+  thetaSolver.IterativeSchur() = true;
+  arma::mat iterativeThetaX;
+  const double iterativeThetaObj = thetaSolver.Optimize(iterativeThetaX);
+  REQUIRE(iterativeThetaObj == Approx(thetaObj).epsilon(1e-4));
+}
+
+TEST_CASE("ChordalDecompositionCycleTest", "[SdpPrimalDualTest]")
+{
+  // The 6-cycle is not chordal; a minimum degree elimination adds three
+  // chords, which gives four cliques of three vertices.
+  const size_t n = 6;
+  arma::sp_mat pattern(n, n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    pattern(i, (i + 1) % n) = 1.;
+    pattern((i + 1) % n, i) = 1.;
+  }
+
+  ChordalDecomposition decomposition(pattern);
+  REQUIRE(decomposition.N() == n);
+  REQUIRE(decomposition.NumCliques() == 4);
+  REQUIRE(decomposition.CliqueSizeSum() == 12);
+  REQUIRE(decomposition.TopDownOrder().size() == 4);
+
+  size_t roots = 0;
+  for (size_t k = 0; k < decomposition.NumCliques(); ++k)
+  {
+    REQUIRE(decomposition.Clique(k).n_elem == 3);
+    const size_t p = decomposition.Parent(k);
+    if (p == decomposition.NumCliques())
+    {
+      ++roots;
+      REQUIRE(decomposition.Separator(k).n_elem == 0);
+      continue;
+    }
+
+    // The separator is the intersection with the parent.
+    const arma::uvec& separator = decomposition.Separator(k);
+    REQUIRE(separator.n_elem == 2);
+    for (size_t a = 0; a < separator.n_elem; ++a)
+    {
+      const arma::uvec& clique = decomposition.Clique(k);
+      const arma::uvec& parent = decomposition.Clique(p);
+      REQUIRE(std::binary_search(clique.begin(), clique.end(), separator[a]));
+      REQUIRE(std::binary_search(parent.begin(), parent.end(), separator[a]));
+    }
+  }
+  REQUIRE(roots == 1);
+
+  // Every entry of the pattern is in its clique.
+  for (size_t i = 0; i < n; ++i)
+  {
+    const size_t j = (i + 1) % n;
+    const size_t k = decomposition.Clique(i, j);
+    const arma::uvec& clique = decomposition.Clique(k);
+    REQUIRE(clique(decomposition.LocalIndex(k, i)) == i);
+    REQUIRE(clique(decomposition.LocalIndex(k, j)) == j);
+  }
+
+  // The maximum determinant completion of the blocks of a positive definite
+  // matrix agrees with it on the cliques, and its inverse is zero outside of
+  // the chordal extension.
+  const arma::mat R = arma::randn<arma::mat>(n, n);
+  const arma::mat F = R * R.t() + n * arma::eye<arma::mat>(n, n);
+  std::vector<arma::mat> blocks(decomposition.NumCliques());
+  arma::umat extension(n, n, arma::fill::zeros);
+  for (size_t k = 0; k < decomposition.NumCliques(); ++k)
+  {
+    const arma::uvec& clique = decomposition.Clique(k);
+    blocks[k] = F.submat(clique, clique);
+    extension.submat(clique, clique).ones();
+  }
+
+  arma::mat X;
+  decomposition.Complete(blocks, X);
+  REQUIRE(CheckPositiveSemiDefinite(X));
+  const arma::mat Xinv = arma::inv_sympd(X);
+  for (size_t j = 0; j < n; ++j)
+  {
+    for (size_t i = 0; i < n; ++i)
+    {
+      if (extension(i, j))
+        REQUIRE(X(i, j) == Approx(F(i, j)).epsilon(1e-10));
+      else
+        REQUIRE(Xinv(i, j) == Approx(0.0).margin(1e-8));
+    }
+  }
+
+  arma::sp_mat assembled;
+  decomposition.Assemble(blocks, assembled);
+  REQUIRE(assembled.n_nonzero == arma::accu(extension));
+}
+
+/**
+ * Solve the SDP with the chordal and the dense solvers, and check that the
+ * completion of the chordal solution is a solution.
+ */
+static void SolveChordalMaxCutSDP(const SDP<arma::sp_mat>& sdp,
+                                  const bool iterativeSchur)
+{
+  PrimalDualSolver<SDP<arma::sp_mat>> denseSolver(sdp);
+  arma::mat denseX;
+  const double denseObj = denseSolver.Optimize(denseX);
+
+  ChordalPrimalDualSolver<SDP<arma::sp_mat>> solver(sdp);
+  solver.IterativeSchur() = iterativeSchur;
+  std::vector<arma::mat> blocks, dualBlocks;
+  arma::vec y;
+  const double obj = solver.Optimize(blocks, y, dualBlocks);
+  REQUIRE(obj == Approx(denseObj).epsilon(1e-5));
+  REQUIRE(y.n_elem == solver.NumConvertedConstraints());
+  if (iterativeSchur)
+    REQUIRE(solver.SchurIterations() > 0);
+
+  const ChordalDecomposition& decomposition = solver.Decomposition();
+  REQUIRE(blocks.size() == decomposition.NumCliques());
+  for (size_t k = 0; k < blocks.size(); ++k)
+  {
+    REQUIRE(CheckPositiveSemiDefinite(blocks[k]));
+    REQUIRE(CheckPositiveSemiDefinite(dualBlocks[k]));
+  }
+
+  arma::mat X;
+  decomposition.Complete(blocks, X);
+  REQUIRE(CheckPositiveSemiDefinite(X));
+  for (size_t i = 0; i < sdp.N(); ++i)
+    REQUIRE(X(i, i) == Approx(1.0).epsilon(1e-5));
+  REQUIRE(arma::dot(sdp.C(), X) == Approx(obj).epsilon(1e-5));
+
+  arma::sp_mat sparseX;
+  ChordalPrimalDualSolver<SDP<arma::sp_mat>> sparseSolver(sdp);
+  REQUIRE(sparseSolver.Optimize(sparseX) == Approx(obj).epsilon(1e-5));
+  REQUIRE(sparseX.n_rows == sdp.N());
+}
+
+TEST_CASE("ChordalPrimalDualMaxCutSdp", "[SdpPrimalDualTest]")
+{
+  // The solution for the 5-cycle has X_ij = cos(4 pi / 5) on the edges, so
+  // the objective -<L, X> is -10 (1 - cos(4 pi / 5)).
+  SDP<arma::sp_mat> cycleSdp(5, 5, 0);
+  cycleSdp.C().zeros(5, 5);
+  for (size_t i = 0; i < 5; ++i)
+  {
+    cycleSdp.C()(i, i) = -2.;
+    cycleSdp.C()(i, (i + 1) % 5) = 1.;
+    cycleSdp.C()((i + 1) % 5, i) = 1.;
+    cycleSdp.SparseA()[i].zeros(5, 5);
+    cycleSdp.SparseA()[i](i, i) = 1.;
+  }
+  cycleSdp.SparseB().ones();
+
+  ChordalPrimalDualSolver<SDP<arma::sp_mat>> cycleSolver(cycleSdp);
+  arma::sp_mat cycleX;
+  const double cycleObj = cycleSolver.Optimize(cycleX);
+  REQUIRE(cycleObj == Approx(-10.0 * (1.0 - std::cos(0.8 * arma::datum::pi)))
+      .epsilon(1e-6));
+  REQUIRE(cycleSolver.Decomposition().NumCliques() == 3);
+  SolveChordalMaxCutSDP(cycleSdp, false);
+
+  // A sparse random graph, with the direct and the iterative Schur complement
+  // solves.
+  UndirectedGraph g;
+  UndirectedGraph::ErdosRenyiRandomGraph(g, 20, 0.15, true);
+  const SDP<arma::sp_mat> sdp = ConstructMaxCutSDPFromGraph(g);
+  SolveChordalMaxCutSDP(sdp, false);
+  SolveChordalMaxCutSDP(sdp, true);
+
+  // A denser graph, whose chordal extension is almost complete.
+  SolveChordalMaxCutSDP(ConstructMaxCutSDPFromLaplacian("data/r10.txt"),
+      false);
+}
@@ -12,6 +12,7 @@
 
 #include <ensmallen.hpp>
 #include "catch.hpp"
+#include "test_function_tools.hpp"
 
 using namespace std;
 using namespace arma;
@@ -32,6 +33,20 @@ TEST_CASE("SimpleSGDTestFunction","[SGDTest]")
   REQUIRE(coordinates[2] == Approx(0.0).margin(1e-7));
 }
 
+TEST_CASE("SimpleSGDTestFunctionFMat","[SGDTest]")
+{
+  SGDTestFunction f;
+  StandardSGD s(0.0003, 1, 5000000, 1e-9, true);
+
+  arma::fmat coordinates = f.GetInitialPoint<arma::fmat>();
+  float result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(-1.0).epsilon(0.0005));
+  REQUIRE(coordinates[0] == Approx(0.0).margin(1e-3));
+  REQUIRE(coordinates[1] == Approx(0.0).margin(1e-3));
+  REQUIRE(coordinates[2] == Approx(0.0).margin(1e-3));
+}
+
 TEST_CASE("GeneralizedRosenbrockTest","[SGDTest]")
 {
   // Loop over several variants.
@@ -50,3 +65,936 @@ TEST_CASE("GeneralizedRosenbrockTest","[SGDTest]")
       REQUIRE(coordinates[j] == Approx(1.0).epsilon(1e-5));
   }
 }
+
+/**
+ * Make sure that splitting a batch across threads with ParallelBatchFunction
+ * gives the same objective and gradient as the serial evaluation.
+ */
+TEST_CASE("ParallelBatchFunctionGradientTest","[SGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+  ParallelBatchFunction<LogisticRegression<>> parallelLr(lr);
+
+  arma::mat coordinates = arma::randu<arma::mat>(1, shuffledData.n_rows + 1);
+  arma::mat gradient, parallelGradient;
+  for (size_t batchSize = 1; batchSize <= 64; batchSize *= 4)
+  {
+    const double objective = lr.EvaluateWithGradient(coordinates, 3,
+        gradient, batchSize);
+    const double parallelObjective = parallelLr.EvaluateWithGradient(
+        coordinates, 3, parallelGradient, batchSize);
+
+    REQUIRE(parallelObjective == Approx(objective).epsilon(1e-10));
+    REQUIRE(parallelLr.Evaluate(coordinates, 3, batchSize) ==
+        Approx(lr.Evaluate(coordinates, 3, batchSize)).epsilon(1e-10));
+    REQUIRE(parallelGradient.n_elem == gradient.n_elem);
+    for (size_t i = 0; i < gradient.n_elem; ++i)
+      REQUIRE(parallelGradient[i] == Approx(gradient[i]).margin(1e-10));
+  }
+}
+
+/**
+ * Run Adam on a logistic regression function whose batches are evaluated in
+ * parallel and make sure the results are acceptable.
+ */
+TEST_CASE("ParallelBatchAdamLogisticRegressionTest","[SGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+  ParallelBatchFunction<LogisticRegression<>> parallelLr(lr, 8);
+
+  Adam adam;
+  arma::mat coordinates = lr.GetInitialPoint();
+  adam.Optimize(parallelLr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+/**
+ * Make sure that in the deterministic reduction mode, the parallel batch
+ * gradients, the parallel full passes and a whole optimization give bitwise
+ * identical results with any number of threads and any executor.
+ */
+TEST_CASE("DeterministicReductionTest","[SGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+  ParallelBatchFunction<LogisticRegression<>> parallelLr(lr);
+
+  #ifdef ENS_USE_OPENMP
+    const int threads = omp_get_max_threads();
+  #endif
+
+  SetDeterministicReductions(true, 8);
+  REQUIRE(DeterministicReductions());
+  REQUIRE(DeterministicChunkCount(100) == 8);
+  REQUIRE(DeterministicChunkCount(100, 50) == 2);
+  REQUIRE(DeterministicChunkCount(3) == 3);
+
+  const arma::mat coordinates = arma::randu<arma::mat>(1,
+      shuffledData.n_rows + 1);
+  arma::mat gradient, fullGradient;
+  double objective = 0.0, fullObjective = 0.0;
+  arma::mat optimized;
+  for (size_t run = 0; run < 3; ++run)
+  {
+    // The first run uses a serial executor, the others 1 or 2 OpenMP threads.
+    if (run == 0)
+      SetDefaultExecutor(Executor::Serial());
+    else
+      SetDefaultExecutor(Executor());
+    #ifdef ENS_USE_OPENMP
+      omp_set_num_threads((run == 2) ? 2 : 1);
+    #endif
+
+    arma::mat runGradient, runFullGradient;
+    const double runObjective = parallelLr.EvaluateWithGradient(coordinates,
+        5, runGradient, 100);
+    const double runFullObjective = FullPassEvaluateWithGradient(lr,
+        coordinates, 7, runFullGradient, true);
+
+    Adam adam(0.01, 50, 0.9, 0.999, 1e-8, 5 * lr.NumFunctions(), -1.0, false);
+    arma::mat runOptimized = lr.GetInitialPoint();
+    adam.Optimize(parallelLr, runOptimized);
+
+    if (run == 0)
+    {
+      objective = runObjective;
+      gradient = runGradient;
+      fullObjective = runFullObjective;
+      fullGradient = runFullGradient;
+      optimized = runOptimized;
+      continue;
+    }
+
+    REQUIRE(runObjective == objective);
+    REQUIRE(arma::all(arma::vectorise(runGradient == gradient)));
+    REQUIRE(runFullObjective == fullObjective);
+    REQUIRE(arma::all(arma::vectorise(runFullGradient == fullGradient)));
+    REQUIRE(arma::all(arma::vectorise(runOptimized == optimized)));
+  }
+
+  SetDeterministicReductions(false);
+  SetDefaultExecutor(Executor());
+  #ifdef ENS_USE_OPENMP
+    omp_set_num_threads(threads);
+  #endif
+  REQUIRE(!DeterministicReductions());
+
+  // The deterministic sums are still the sums of the batches.
+  arma::mat serialGradient;
+  const double serialObjective = lr.EvaluateWithGradient(coordinates, 5,
+      serialGradient, 100);
+  REQUIRE(objective == Approx(serialObjective).epsilon(1e-10));
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+    REQUIRE(gradient[i] == Approx(serialGradient[i]).margin(1e-10));
+
+  REQUIRE_THROWS_AS(SetDeterministicReductions(true, 0),
+      std::invalid_argument);
+}
+
+/**
+ * Optimize the SGD test function evaluated in single precision with a
+ * double-precision iterate.
+ */
+TEST_CASE("MixedPrecisionSGDTestFunction","[SGDTest]")
+{
+  SGDTestFunction f;
+  MixedPrecisionFunction<SGDTestFunction> mixedF(f);
+  StandardSGD s(0.0003, 1, 5000000, 1e-9, true);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  double result = s.Optimize(mixedF, coordinates);
+
+  REQUIRE(result == Approx(-1.0).epsilon(0.0005));
+  REQUIRE(coordinates[0] == Approx(0.0).margin(1e-3));
+  REQUIRE(coordinates[1] == Approx(0.0).margin(1e-3));
+  REQUIRE(coordinates[2] == Approx(0.0).margin(1e-3));
+  REQUIRE(mixedF.SkippedBatches() == 0);
+  REQUIRE(mixedF.LossScale() == 1.0);
+}
+
+/**
+ * The SGD test function, with its objective and gradient multiplied by a loss
+ * scale in the precision of the coordinates.
+ */
+class ScaledSGDTestFunction
+{
+ public:
+  ScaledSGDTestFunction() : lossScale(1.0) { }
+
+  size_t NumFunctions() const { return f.NumFunctions(); }
+
+  void Shuffle() { f.Shuffle(); }
+
+  double& LossScale() { return lossScale; }
+
+  template<typename MatType>
+  typename MatType::elem_type Evaluate(const MatType& coordinates,
+                                       const size_t begin,
+                                       const size_t batchSize)
+  {
+    typedef typename MatType::elem_type ElemType;
+    return f.Evaluate(coordinates, begin, batchSize) * ElemType(lossScale);
+  }
+
+  template<typename MatType, typename GradType>
+  void Gradient(const MatType& coordinates,
+                const size_t begin,
+                GradType& gradient,
+                const size_t batchSize)
+  {
+    typedef typename MatType::elem_type ElemType;
+    f.Gradient(coordinates, begin, gradient, batchSize);
+    gradient *= ElemType(lossScale);
+  }
+
+  SGDTestFunction f;
+  double lossScale;
+};
+
+/**
+ * Make sure that dynamic loss scaling skips the batches whose scaled gradients
+ * overflow, backs the scale off until they do not, and lets it grow again.
+ */
+TEST_CASE("MixedPrecisionLossScalingTest","[SGDTest]")
+{
+  ScaledSGDTestFunction f;
+
+  // Scaled gradients of the starting point overflow in single precision.
+  MixedPrecisionFunction<ScaledSGDTestFunction> mixedF(f, true, 1e40, 100,
+      2.0, 1e-4);
+  StandardSGD s(0.0003, 1, 3000000, 1e-9, true);
+
+  arma::mat coordinates = f.f.GetInitialPoint();
+  double result = s.Optimize(mixedF, coordinates);
+
+  REQUIRE(mixedF.SkippedBatches() > 0);
+  REQUIRE(mixedF.LossScale() < 1e40);
+  REQUIRE(result == Approx(-1.0).epsilon(0.0005));
+  REQUIRE(coordinates[0] == Approx(0.0).margin(1e-3));
+  REQUIRE(coordinates[1] == Approx(0.0).margin(1e-3));
+  REQUIRE(coordinates[2] == Approx(0.0).margin(1e-3));
+
+  REQUIRE_THROWS_AS(MixedPrecisionFunction<ScaledSGDTestFunction>(f, true,
+      1.0, 100, 2.0, 2.0), std::invalid_argument);
+}
+
+/**
+ * Run SGD on a logistic regression function that shuffles only its visitation
+ * order, in blocks of points, and make sure the results are acceptable.
+ */
+TEST_CASE("IndexShuffleSGDLogisticRegressionTest","[SGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+  lr.IndexShuffle() = true;
+  lr.ShuffleBlockSize() = 8;
+
+  StandardSGD sgd;
+  arma::mat coordinates = lr.GetInitialPoint();
+  sgd.Optimize(lr, coordinates);
+
+  // The data itself is never reordered.
+  REQUIRE(lr.Predictors().memptr() == shuffledData.memptr());
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+/**
+ * A separable function f_i(x) = ||x - c_i||^2 that gathers the points of each
+ * batch into a staging matrix in PrefetchBatch(), and counts the batches that
+ * were evaluated without being prefetched first.
+ */
+class PrefetchTestFunction
+{
+ public:
+  PrefetchTestFunction() :
+      points(arma::randn<arma::mat>(3, 100) + 1.0),
+      order(arma::linspace<arma::uvec>(0, 99, 100)),
+      prefetchBegin(0),
+      prefetchSize(0),
+      prefetches(0),
+      misses(0)
+  { }
+
+  size_t NumFunctions() const { return points.n_cols; }
+
+  void Shuffle() { order = arma::shuffle(order); }
+
+  void PrefetchBatch(const size_t begin, const size_t batchSize)
+  {
+    staging = points.cols(order.subvec(begin, begin + batchSize - 1));
+    prefetchBegin = begin;
+    prefetchSize = batchSize;
+    ++prefetches;
+  }
+
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t begin,
+                  const size_t batchSize) const
+  {
+    const arma::mat batch = points.cols(order.subvec(begin,
+        begin + batchSize - 1));
+    return arma::accu(arma::square(batch.each_col() - coordinates));
+  }
+
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              const size_t begin,
+                              arma::mat& gradient,
+                              const size_t batchSize)
+  {
+    if (begin != prefetchBegin || batchSize != prefetchSize)
+    {
+      ++misses;
+      return EvaluateWithGradient(coordinates, points.cols(order.subvec(begin,
+          begin + batchSize - 1)), gradient);
+    }
+
+    return EvaluateWithGradient(coordinates, staging, gradient);
+  }
+
+  //! The mean of the points, which is the minimum.
+  arma::vec Minimum() const { return arma::mean(points, 1); }
+
+  size_t Prefetches() const { return prefetches; }
+  size_t Misses() const { return misses; }
+
+ private:
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              const arma::mat& batch,
+                              arma::mat& gradient) const
+  {
+    const arma::mat difference = batch.each_col() - coordinates;
+    gradient = -2 * arma::sum(difference, 1);
+    return arma::accu(arma::square(difference));
+  }
+
+  arma::mat points;
+  arma::uvec order;
+  arma::mat staging;
+  size_t prefetchBegin;
+  size_t prefetchSize;
+  size_t prefetches;
+  size_t misses;
+};
+
+/**
+ * Make sure that in pipelined mode, SGD prefetches every batch before it is
+ * evaluated, and still converges.
+ */
+TEST_CASE("SGDPrefetchTest","[SGDTest]")
+{
+  PrefetchTestFunction f;
+  StandardSGD s(0.001, 10, 100000, 1e-12, true, VanillaUpdate(), NoDecay(),
+      true, true);
+
+  arma::mat coordinates(3, 1, arma::fill::zeros);
+  s.Optimize(f, coordinates);
+
+  REQUIRE(f.Prefetches() > 0);
+  REQUIRE(f.Misses() == 0);
+
+  const arma::vec minimum = f.Minimum();
+  for (size_t i = 0; i < 3; ++i)
+    REQUIRE(coordinates[i] == Approx(minimum[i]).margin(0.1));
+
+  // Without pipelining, nothing is prefetched.
+  PrefetchTestFunction g;
+  s.Prefetch() = false;
+  coordinates.zeros();
+  s.Optimize(g, coordinates);
+
+  REQUIRE(g.Prefetches() == 0);
+}
+
+/**
+ * A separable function f_i(x) = ||x - c_i||^2 that records the largest batch
+ * it was evaluated on.
+ */
+class MicroBatchTestFunction
+{
+ public:
+  MicroBatchTestFunction() :
+      points(arma::randn<arma::mat>(3, 100) + 1.0),
+      largestBatch(0)
+  { }
+
+  size_t NumFunctions() const { return points.n_cols; }
+
+  void Shuffle() { }
+
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t begin,
+                  const size_t batchSize) const
+  {
+    return arma::accu(arma::square(points.cols(begin, begin + batchSize - 1)
+        .each_col() - coordinates));
+  }
+
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              const size_t begin,
+                              arma::mat& gradient,
+                              const size_t batchSize)
+  {
+    largestBatch = std::max(largestBatch, batchSize);
+    const arma::mat difference = points.cols(begin, begin + batchSize - 1)
+        .each_col() - coordinates;
+    gradient = -2 * arma::sum(difference, 1);
+    return arma::accu(arma::square(difference));
+  }
+
+  //! The mean of the points, which is the minimum.
+  arma::vec Minimum() const { return arma::mean(points, 1); }
+
+  size_t LargestBatch() const { return largestBatch; }
+
+ private:
+  arma::mat points;
+  size_t largestBatch;
+};
+
+/**
+ * Make sure that evaluating each batch in micro-batches gives the steps of the
+ * whole batch, without ever giving the function more than a micro-batch.
+ */
+TEST_CASE("SGDMicroBatchTest","[SGDTest]")
+{
+  MicroBatchTestFunction f;
+  MicroBatchTestFunction microF(f);
+
+  StandardSGD s(0.001, 40, 20000, -1.0, false);
+  arma::mat coordinates(3, 1, arma::fill::zeros);
+  const double objective = s.Optimize(f, coordinates);
+  REQUIRE(f.LargestBatch() == 40);
+
+  StandardSGD microS(0.001, 40, 20000, -1.0, false);
+  microS.MicroBatchSize() = 7;
+  arma::mat microCoordinates(3, 1, arma::fill::zeros);
+  const double microObjective = microS.Optimize(microF, microCoordinates);
+  REQUIRE(microF.LargestBatch() == 7);
+
+  REQUIRE(microObjective == Approx(objective).epsilon(1e-10));
+  REQUIRE(arma::approx_equal(microCoordinates, coordinates, "absdiff",
+      1e-10));
+  REQUIRE(arma::approx_equal(coordinates, f.Minimum(), "absdiff", 0.1));
+}
+
+/**
+ * Make sure that SGD gives the same results with a workspace, and that it
+ * reuses its temporaries across optimizations.
+ */
+TEST_CASE("SGDWorkspaceTest","[SGDTest]")
+{
+  SGDTestFunction f;
+  StandardSGD s(0.0003, 1, 100000, 1e-9, false);
+
+  arma::mat expected = f.GetInitialPoint();
+  s.Optimize(f, expected);
+
+  Workspace workspace;
+  s.Workspace() = &workspace;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    arma::mat coordinates = f.GetInitialPoint();
+    s.Optimize(f, coordinates);
+
+    REQUIRE(workspace.Created() == 1);
+    for (size_t j = 0; j < coordinates.n_elem; ++j)
+      REQUIRE(coordinates[j] == Approx(expected[j]).epsilon(1e-10));
+  }
+}
+
+/**
+ * A separable function f_i(x) = 0.5 * ||x - a_i||^2 whose
+ * EvaluateWithGradient() is built from a per-function kernel, which counts its
+ * calls.
+ */
+class SampleKernelSGDTestFunction
+{
+ public:
+  SampleKernelSGDTestFunction() :
+      points(arma::randn<arma::mat>(3, 50) + 1.0),
+      calls(0)
+  { }
+
+  size_t NumFunctions() const { return points.n_cols; }
+
+  void Shuffle() { }
+
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t begin,
+                  const size_t batchSize) const
+  {
+    return 0.5 * arma::accu(arma::square(points.cols(begin, begin +
+        batchSize - 1).each_col() - coordinates));
+  }
+
+  void Gradient(const arma::mat& coordinates,
+                const size_t begin,
+                arma::mat& gradient,
+                const size_t batchSize) const
+  {
+    gradient = -arma::sum(points.cols(begin, begin + batchSize - 1)
+        .each_col() - coordinates, 1);
+  }
+
+  double AccumulateEvaluateWithGradient(const arma::mat& coordinates,
+                                        const size_t i,
+                                        arma::mat& gradient) const
+  {
+    ++calls;
+    gradient += coordinates - points.col(i);
+    return 0.5 * std::pow(arma::norm(coordinates - points.col(i)), 2);
+  }
+
+  size_t Calls() const { return calls; }
+
+  arma::mat Mean() const { return arma::mean(points, 1); }
+
+ private:
+  arma::mat points;
+  mutable size_t calls;
+};
+
+//! A callback without any method, which only turns off the specialized loop
+//! of the small batches.
+class EmptyCallback { };
+
+/**
+ * Make sure that the specialized loop of the small batches takes the steps of
+ * the generic loop, with the per-function kernel of the function, including
+ * when the epochs end with a smaller batch and the last epoch is cut short.
+ */
+TEST_CASE("SGDSmallBatchTest","[SGDTest]")
+{
+  for (size_t batchSize = 1; batchSize <= 5; ++batchSize)
+  {
+    SampleKernelSGDTestFunction f;
+    SampleKernelSGDTestFunction genericF(f);
+
+    StandardSGD s(0.01, batchSize, 1234, -1.0, false);
+    arma::mat coordinates(3, 1, arma::fill::zeros);
+    const double objective = s.Optimize(f, coordinates);
+
+    arma::mat genericCoordinates(3, 1, arma::fill::zeros);
+    const double genericObjective = s.Optimize(genericF, genericCoordinates,
+        EmptyCallback());
+
+    REQUIRE(objective == genericObjective);
+    for (size_t j = 0; j < coordinates.n_elem; ++j)
+      REQUIRE(coordinates[j] == genericCoordinates[j]);
+
+    REQUIRE(f.Calls() == 1234);
+    REQUIRE(genericF.Calls() == 1234);
+    REQUIRE(arma::approx_equal(coordinates, f.Mean(), "absdiff", 0.05));
+  }
+
+  // A function with its own EvaluateWithGradient(), and an update policy with
+  // a state.
+  SGDTestFunction g;
+  MomentumSGD s(0.0003, 1, 30000, -1.0, false);
+  arma::mat coordinates = g.GetInitialPoint();
+  const double objective = s.Optimize(g, coordinates);
+
+  arma::mat genericCoordinates = g.GetInitialPoint();
+  const double genericObjective = s.Optimize(g, genericCoordinates,
+      EmptyCallback());
+
+  REQUIRE(objective == genericObjective);
+  for (size_t j = 0; j < coordinates.n_elem; ++j)
+    REQUIRE(coordinates[j] == genericCoordinates[j]);
+}
+
+/**
+ * A separable function f_i(x) = ||x - c_i||^2 that counts the calls to its
+ * separable Evaluate(), which SGD only uses for the final objective.
+ */
+class EvaluateCountingFunction
+{
+ public:
+  EvaluateCountingFunction() :
+      points(arma::randn<arma::mat>(3, 100) + 1.0),
+      evaluations(0)
+  { }
+
+  size_t NumFunctions() const { return points.n_cols; }
+
+  void Shuffle() { }
+
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t begin,
+                  const size_t batchSize) const
+  {
+    ++evaluations;
+    return arma::accu(arma::square(points.cols(begin, begin + batchSize - 1)
+        .each_col() - coordinates));
+  }
+
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              const size_t begin,
+                              arma::mat& gradient,
+                              const size_t batchSize) const
+  {
+    const arma::mat difference = points.cols(begin, begin + batchSize - 1)
+        .each_col() - coordinates;
+    gradient = -2 * arma::sum(difference, 1);
+    return arma::accu(arma::square(difference));
+  }
+
+  size_t Evaluations() const { return evaluations; }
+
+  const arma::mat& Points() const { return points; }
+
+ private:
+  arma::mat points;
+  mutable size_t evaluations;
+};
+
+/**
+ * Make sure that SGD computes the final objective as requested: exactly with
+ * a full pass, from a subsample, or from the batch objectives of the last
+ * pass without any evaluation.
+ */
+TEST_CASE("SGDObjectiveEstimateTest","[SGDTest]")
+{
+  EvaluateCountingFunction f;
+  StandardSGD s(0.001, 5, 10000, -1.0, false);
+
+  arma::mat coordinates(3, 1, arma::fill::zeros);
+  const double exact = s.Optimize(f, coordinates);
+  REQUIRE(f.Evaluations() == 20);
+
+  EvaluateCountingFunction g(f);
+  s.ObjectiveEstimate() = ObjectiveEstimate::Reuse();
+  arma::mat reusedCoordinates(3, 1, arma::fill::zeros);
+  const double reused = s.Optimize(g, reusedCoordinates);
+  REQUIRE(g.Evaluations() == f.Evaluations());
+  REQUIRE(reused == Approx(exact).epsilon(0.01));
+  for (size_t i = 0; i < 3; ++i)
+    REQUIRE(reusedCoordinates[i] == Approx(coordinates[i]).epsilon(1e-10));
+
+  // A subsample of 20 functions takes 4 batches of 5.
+  EvaluateCountingFunction h(f);
+  s.ObjectiveEstimate() = ObjectiveEstimate::Subsample(20);
+  arma::mat sampledCoordinates(3, 1, arma::fill::zeros);
+  const double sampled = s.Optimize(h, sampledCoordinates);
+  REQUIRE(h.Evaluations() == f.Evaluations() + 4);
+  REQUIRE(sampled == Approx(exact).epsilon(0.5));
+}
+
+/**
+ * Make sure that SGD with importance sampling converges to the minimum of
+ * sum_i ||x - c_i||^2 (the mean of the points), when the functions are sampled
+ * with probabilities proportional to the norms of their points.
+ */
+TEST_CASE("SGDImportanceSamplingTest","[SGDTest]")
+{
+  EvaluateCountingFunction f;
+  StandardSGD s(0.001, 5, 100000, -1.0, false);
+  s.SamplingWeights() = arma::sqrt(arma::sum(arma::square(f.Points()), 0)).t()
+      + 0.1;
+
+  arma::mat coordinates(3, 1, arma::fill::zeros);
+  s.Optimize(f, coordinates);
+
+  const arma::vec mean = arma::mean(f.Points(), 1);
+  for (size_t i = 0; i < 3; ++i)
+    REQUIRE(coordinates[i] == Approx(mean[i]).margin(0.1));
+
+  // There must be one weight per function.
+  s.SamplingWeights() = arma::vec(10, arma::fill::ones);
+  REQUIRE_THROWS_AS(s.Optimize(f, coordinates), std::invalid_argument);
+}
+
+/**
+ * A separable function of points that can be appended to, which counts how
+ * many times each of its functions is visited.
+ */
+class GrowingCountingFunction
+{
+ public:
+  GrowingCountingFunction(const arma::mat& points) : points(points) { }
+
+  void Append(const arma::mat& newPoints)
+  {
+    points = arma::join_rows(points, newPoints);
+  }
+
+  size_t NumFunctions() const { return points.n_cols; }
+
+  void Shuffle() { }
+
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t begin,
+                  const size_t batchSize) const
+  {
+    return arma::accu(arma::square(points.cols(begin, begin + batchSize - 1)
+        .each_col() - coordinates));
+  }
+
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              const size_t begin,
+                              arma::mat& gradient,
+                              const size_t batchSize)
+  {
+    visits.resize(points.n_cols, 0);
+    for (size_t j = begin; j < begin + batchSize; ++j)
+      ++visits[j];
+
+    const arma::mat difference = points.cols(begin, begin + batchSize - 1)
+        .each_col() - coordinates;
+    gradient = -2 * arma::sum(difference, 1);
+    return arma::accu(arma::square(difference));
+  }
+
+  std::vector<size_t> visits;
+
+ private:
+  arma::mat points;
+};
+
+/**
+ * In incremental mode, the next call to Optimize() should visit each new
+ * function once per epoch, replay the requested number of old functions, and
+ * move towards the new points.
+ */
+TEST_CASE("SGDIncrementalTest","[SGDTest]")
+{
+  GrowingCountingFunction f(arma::randn<arma::mat>(3, 100));
+  StandardSGD s(0.01, 5, 1000, -1.0, true);
+  s.ResetPolicy() = false;
+
+  arma::mat coordinates(3, 1, arma::fill::zeros);
+  s.Optimize(f, coordinates);
+  REQUIRE(s.SeenFunctions() == 100);
+
+  // Each epoch now has the 20 new functions and 10 replayed ones.
+  f.Append(arma::randn<arma::mat>(3, 20) + 5.0);
+  f.visits.assign(120, 0);
+  s.Incremental() = true;
+  s.ReplayRate() = 0.5;
+  s.MaxIterations() = 300;
+  s.Optimize(f, coordinates);
+
+  REQUIRE(s.SeenFunctions() == 120);
+  size_t oldVisits = 0;
+  for (size_t j = 0; j < 100; ++j)
+    oldVisits += f.visits[j];
+  REQUIRE(oldVisits == 100);
+  for (size_t j = 100; j < 120; ++j)
+    REQUIRE(f.visits[j] == 10);
+
+  // The new points pull the coordinates towards them.
+  for (size_t i = 0; i < 3; ++i)
+    REQUIRE(coordinates[i] > 1.0);
+
+  // Without new functions, all of them are visited.
+  f.visits.assign(120, 0);
+  s.MaxIterations() = 120;
+  s.Optimize(f, coordinates);
+  for (size_t j = 0; j < 120; ++j)
+    REQUIRE(f.visits[j] == 1);
+}
+
+/**
+ * Make sure that the profiled sections count their calls, and that only the
+ * outermost call to Optimize() writes a report.
+ */
+TEST_CASE("SGDProfilerTest","[SGDTest]")
+{
+  ProfileSection& section = Profiler::Get().Section("ProfilerTestSection");
+  REQUIRE(&Profiler::Get().Section("ProfilerTestSection") == &section);
+
+  section.Reset();
+  for (size_t i = 0; i < 3; ++i)
+    ProfileTimer timer(section);
+  REQUIRE(section.Calls() == 3);
+  REQUIRE(section.Seconds() >= 0.0);
+
+  std::ostringstream report;
+  std::ostream* output = Profiler::Get().Output();
+  Profiler::Get().Output() = &report;
+  {
+    // The outermost report zeroes the sections.
+    ProfileReport outer("Outer");
+    REQUIRE(section.Calls() == 0);
+    {
+      ProfileReport inner("Inner");
+      ProfileTimer timer(section);
+    }
+    REQUIRE(report.str().empty());
+  }
+  Profiler::Get().Output() = output;
+
+  REQUIRE(section.Calls() == 1);
+  REQUIRE(report.str().find("Outer profile") == 0);
+  REQUIRE(report.str().find("ProfilerTestSection") != std::string::npos);
+  REQUIRE(report.str().find("Inner") == std::string::npos);
+}
+
+/**
+ * Make sure that SGD can optimize a fixed-size iterate in place.
+ */
+TEST_CASE("SGDFixedSizeBoothTest", "[SGDTest]")
+{
+  BoothFunction f;
+  StandardSGD s(0.01, 1, 100000, 1e-15, false);
+
+  arma::vec::fixed<2> coordinates;
+  coordinates = f.GetInitialPoint();
+  const double* memory = coordinates.memptr();
+  const double result = s.Optimize(f, coordinates);
+
+  REQUIRE(coordinates.memptr() == memory);
+  REQUIRE(result == Approx(0.0).margin(1e-8));
+  REQUIRE(coordinates[0] == Approx(1.0).epsilon(1e-4));
+  REQUIRE(coordinates[1] == Approx(3.0).epsilon(1e-4));
+}
+
+/**
+ * Make sure the vanilla update applies a sparse gradient the same way as the
+ * equivalent dense gradient.
+ */
+TEST_CASE("VanillaUpdateSparseGradientTest", "[SGDTest]")
+{
+  VanillaUpdate update;
+  VanillaUpdate::Policy<arma::mat, arma::mat> densePolicy(update, 10, 3);
+  VanillaUpdate::Policy<arma::mat, arma::sp_mat> sparsePolicy(update, 10, 3);
+
+  arma::mat denseIterate(10, 3, arma::fill::randu);
+  arma::mat sparseIterate(denseIterate);
+  for (size_t i = 0; i < 20; ++i)
+  {
+    const arma::sp_mat gradient = arma::sprandu<arma::sp_mat>(10, 3, 0.2);
+    densePolicy.Update(denseIterate, 0.01, arma::mat(gradient));
+    sparsePolicy.Update(sparseIterate, 0.01, gradient);
+  }
+
+  for (size_t i = 0; i < denseIterate.n_elem; ++i)
+    REQUIRE(sparseIterate[i] == Approx(denseIterate[i]).margin(1e-12));
+}
+
+/**
+ * Run SGD with sparse gradients on a function where each point only touches
+ * one coordinate.
+ */
+TEST_CASE("SGDSparseTestFunction", "[SGDTest]")
+{
+  SparseTestFunction f;
+  StandardSGD s(0.1, 1, 100000, 1e-9, true);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  s.Optimize<SparseTestFunction, arma::mat, arma::sp_mat>(f, coordinates);
+
+  REQUIRE(coordinates[0] == Approx(2.0).margin(0.01));
+  REQUIRE(coordinates[1] == Approx(1.0).margin(0.01));
+  REQUIRE(coordinates[2] == Approx(1.5).margin(0.01));
+  REQUIRE(coordinates[3] == Approx(4.0).margin(0.01));
+}
+
+/**
+ * A separable function that computes the objectives and gradients of a batch
+ * at many points at once, and counts the calls.
+ */
+class MultiPointFunction : public GeneralizedRosenbrockFunction
+{
+ public:
+  MultiPointFunction() : GeneralizedRosenbrockFunction(10), calls(0) { }
+
+  void MultiEvaluateWithGradient(const arma::cube& coordinates,
+                                 const size_t begin,
+                                 arma::cube& gradients,
+                                 arma::vec& objectives,
+                                 const size_t batchSize)
+  {
+    ++calls;
+    objectives.set_size(coordinates.n_slices);
+    for (size_t k = 0; k < coordinates.n_slices; ++k)
+    {
+      arma::mat gradient;
+      objectives[k] = Evaluate(coordinates.slice(k), begin, batchSize);
+      Gradient(coordinates.slice(k), begin, gradient, batchSize);
+      gradients.slice(k) = gradient;
+    }
+  }
+
+  size_t calls;
+};
+
+/**
+ * Make sure that MultiSGD takes the same steps for each model as SGD with the
+ * same step size and update policy, with and without a multi-point
+ * MultiEvaluateWithGradient().
+ */
+TEST_CASE("MultiSGDTest", "[SGDTest]")
+{
+  MultiPointFunction f;
+  const arma::vec stepSizes = { 0.0008, 0.0005, 0.001 };
+  std::vector<MomentumUpdate> policies;
+  policies.push_back(MomentumUpdate(0.4));
+  policies.push_back(MomentumUpdate(0.6));
+  policies.push_back(MomentumUpdate(0.2));
+
+  MultiSGD<MomentumUpdate> multi(stepSizes, 1, 20000, 1e-15, false,
+      policies);
+  arma::cube iterates(f.GetInitialPoint().n_rows, 1, 3);
+  for (size_t k = 0; k < 3; ++k)
+    iterates.slice(k) = f.GetInitialPoint();
+  arma::cube fallbackIterates(iterates);
+
+  const arma::vec objectives = multi.Optimize(f, iterates);
+  REQUIRE(f.calls > 0);
+
+  // The base function has no multi-point method.
+  GeneralizedRosenbrockFunction& base = f;
+  const arma::vec fallbackObjectives = multi.Optimize(base, fallbackIterates);
+
+  for (size_t k = 0; k < 3; ++k)
+  {
+    MomentumSGD s(stepSizes[k], 1, 20000, 1e-15, false, policies[k]);
+    arma::mat coordinates = f.GetInitialPoint();
+    const double objective = s.Optimize(f, coordinates);
+
+    REQUIRE(objectives[k] == Approx(objective).epsilon(1e-10));
+    REQUIRE(fallbackObjectives[k] == Approx(objective).epsilon(1e-10));
+    for (size_t i = 0; i < coordinates.n_elem; ++i)
+    {
+      REQUIRE(iterates.slice(k)[i] == Approx(coordinates[i]).margin(1e-10));
+      REQUIRE(fallbackIterates.slice(k)[i] ==
+          Approx(coordinates[i]).margin(1e-10));
+    }
+  }
+
+  arma::cube wrongIterates(f.GetInitialPoint().n_rows, 1, 2);
+  REQUIRE_THROWS_AS(multi.Optimize(f, wrongIterates), std::invalid_argument);
+}
@@ -53,6 +53,93 @@ TEST_CASE("SGDRCyclicalResetTest","[SGDRTest]")
   }
 }
 
+/**
+ * When the running objective stops improving, CyclicalDecay should restart
+ * right away (and the next cycle should be longer); without a patience, or
+ * while the objective improves, the schedule should not change.
+ */
+TEST_CASE("SGDRCyclicalPlateauRestartTest","[SGDRTest]")
+{
+  arma::mat iterate;
+  double stepSize = 0.5;
+
+  CyclicalDecay plateauDecay(1000, 2.0, 0.5, 0.0, 5);
+  CyclicalDecay improvingDecay(1000, 2.0, 0.5, 0.0, 5);
+  CyclicalDecay fixedDecay(1000, 2.0, 0.5, 0.0);
+  for (size_t i = 0; i < 6; ++i)
+  {
+    // The first objective is the best one, and the five next ones are stale.
+    plateauDecay.ObserveObjective(10.0, 10);
+    plateauDecay.Update(iterate, stepSize, iterate);
+    if (i < 5)
+      REQUIRE(plateauDecay.EpochRestart() == 1000);
+  }
+  REQUIRE(stepSize == Approx(0.5).epsilon(1e-10));
+  REQUIRE(plateauDecay.EpochRestart() == 2000);
+
+  for (size_t i = 0; i < 100; ++i)
+  {
+    improvingDecay.ObserveObjective(100.0 - i, 1);
+    improvingDecay.Update(iterate, stepSize, iterate);
+    fixedDecay.ObserveObjective(1.0, 1);
+    fixedDecay.Update(iterate, stepSize, iterate);
+  }
+  REQUIRE(improvingDecay.EpochRestart() == 1000);
+  REQUIRE(fixedDecay.EpochRestart() == 1000);
+  REQUIRE(stepSize < 0.5);
+}
+
+/**
+ * Run SGDR with early restarts on logistic regression and make sure the
+ * results are acceptable.
+ */
+TEST_CASE("SGDRPlateauLogisticRegressionTest","[SGDRTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  SGDR<> sgdr(50, 2.0, 10, 0.01, 0.005, 10000, 1e-3);
+  sgdr.PlateauPatience() = 20;
+  sgdr.PlateauTolerance() = 1e-2;
+
+  arma::mat coordinates = lr.GetInitialPoint();
+  sgdr.Optimize(lr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+/**
+ * When the running objective stops improving, SnapshotEnsembles should take a
+ * snapshot and restart.
+ */
+TEST_CASE("SnapshotEnsemblesPlateauTest","[SGDRTest]")
+{
+  double stepSize = 0.5;
+  arma::mat iterate(3, 2, arma::fill::randu);
+
+  SnapshotEnsembles snapshots(1000, 2.0, 0.5, 100000, 1, SnapshotStore(), 5);
+  snapshots.EpochBatches() = 100;
+  REQUIRE(snapshots.PlateauPatience() == 5);
+  for (size_t i = 0; i < 6; ++i)
+  {
+    snapshots.ObserveObjective(1.0, 1);
+    snapshots.Update(iterate, stepSize, iterate);
+  }
+
+  REQUIRE(snapshots.Snapshots().size() == 1);
+  CheckMatrices(snapshots.Snapshots()[0], iterate);
+}
+
 /**
  * Run SGDR on logistic regression and make sure the results are acceptable.
  */
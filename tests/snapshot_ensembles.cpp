@@ -85,3 +85,140 @@ TEST_CASE("SnapshotEnsemblesLogisticRegressionTest","[SnapshotEnsemblesTest]")
     REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
   }
 }
+
+/**
+ * Make sure that every storage of SnapshotStore gives back the snapshots that
+ * were added, and that their sum is accumulated correctly.
+ */
+TEST_CASE("SnapshotStoreTest","[SnapshotEnsemblesTest]")
+{
+  const std::string prefix = "snapshot_store_test_";
+  SnapshotStore stores[4] = { SnapshotStore(), SnapshotStore(true),
+      SnapshotStore(false, prefix + "double_"),
+      SnapshotStore(true, prefix + "float_") };
+
+  std::vector<arma::mat> snapshots;
+  for (size_t i = 0; i < 3; ++i)
+    snapshots.push_back(arma::randu<arma::mat>(4, 3));
+  const arma::mat sum = snapshots[0] + snapshots[1] + snapshots[2];
+
+  for (size_t s = 0; s < 4; ++s)
+  {
+    const double tolerance = stores[s].SinglePrecision() ? 1e-6 : 1e-12;
+    for (size_t i = 0; i < snapshots.size(); ++i)
+      stores[s].Add(snapshots[i]);
+
+    REQUIRE(stores[s].Size() == 3);
+    // Only the default storage keeps the snapshots as matrices in memory.
+    REQUIRE(stores[s].Matrices().size() == ((s == 0) ? 3 : 0));
+
+    arma::mat snapshot;
+    for (size_t i = 0; i < snapshots.size(); ++i)
+    {
+      stores[s].Get(i, snapshot);
+      REQUIRE(arma::approx_equal(snapshot, snapshots[i], "absdiff",
+          tolerance));
+    }
+
+    arma::mat accumulated(4, 3, arma::fill::zeros);
+    stores[s].Accumulate(accumulated);
+    REQUIRE(arma::approx_equal(accumulated, sum, "absdiff", 3 * tolerance));
+
+    // The files of the last two stores are not needed anymore.
+    for (size_t i = 0; i < snapshots.size(); ++i)
+    {
+      if (!stores[s].FilePrefix().empty())
+        std::remove(stores[s].Filename(i).c_str());
+    }
+
+    stores[s].Clear();
+    REQUIRE(stores[s].Size() == 0);
+  }
+}
+
+/**
+ * Make sure that a bounded SnapshotStore keeps the snapshots with the lowest
+ * objectives, in memory and in files, and that an averaging store keeps their
+ * running mean.
+ */
+TEST_CASE("SnapshotStoreBoundedTest", "[SnapshotEnsemblesTest]")
+{
+  std::vector<arma::mat> snapshots;
+  for (size_t i = 0; i < 4; ++i)
+    snapshots.push_back(arma::randu<arma::mat>(4, 3));
+  const double objectives[4] = { 3.0, 1.0, 2.0, 0.0 };
+
+  SnapshotStore stores[2] = { SnapshotStore(false, "", 2),
+      SnapshotStore(false, "snapshot_store_bounded_test_", 2) };
+  for (size_t s = 0; s < 2; ++s)
+  {
+    for (size_t i = 0; i < snapshots.size(); ++i)
+      stores[s].Add(snapshots[i], objectives[i]);
+
+    // The snapshots with objectives 0 and 1 are kept, the first one in the
+    // place of the snapshot it replaced.
+    REQUIRE(stores[s].Size() == 2);
+    REQUIRE(stores[s].Objectives()[0] == 0.0);
+    REQUIRE(stores[s].Objectives()[1] == 1.0);
+
+    arma::mat snapshot;
+    stores[s].Get(0, snapshot);
+    REQUIRE(arma::approx_equal(snapshot, snapshots[3], "absdiff", 1e-12));
+    stores[s].Get(1, snapshot);
+    REQUIRE(arma::approx_equal(snapshot, snapshots[1], "absdiff", 1e-12));
+
+    for (size_t i = 0; i < stores[s].Size(); ++i)
+    {
+      if (!stores[s].FilePrefix().empty())
+        std::remove(stores[s].Filename(i).c_str());
+    }
+  }
+
+  SnapshotStore averages[2] = { SnapshotStore(false, "", 0, true),
+      SnapshotStore(true, "", 0, true) };
+  const arma::mat sum = snapshots[0] + snapshots[1] + snapshots[2] +
+      snapshots[3];
+  for (size_t s = 0; s < 2; ++s)
+  {
+    const double tolerance = averages[s].SinglePrecision() ? 1e-5 : 1e-12;
+    for (size_t i = 0; i < snapshots.size(); ++i)
+      averages[s].Add(snapshots[i]);
+
+    REQUIRE(averages[s].Size() == 4);
+    REQUIRE(averages[s].Matrices().size() == ((s == 0) ? 1 : 0));
+
+    arma::mat mean;
+    averages[s].Get(0, mean);
+    REQUIRE(arma::approx_equal(mean, sum / 4, "absdiff", tolerance));
+
+    arma::mat accumulated(4, 3, arma::fill::zeros);
+    averages[s].Accumulate(accumulated);
+    REQUIRE(arma::approx_equal(accumulated, sum, "absdiff", 4 * tolerance));
+  }
+
+  REQUIRE_THROWS_AS(SnapshotStore(false, "snapshot_", 0, true),
+      std::invalid_argument);
+}
+
+/**
+ * Make sure that SnapshotEnsembles takes its snapshots into the given store.
+ */
+TEST_CASE("SnapshotEnsemblesSinglePrecisionStoreTest",
+    "[SnapshotEnsemblesTest]")
+{
+  double stepSize = 0.5;
+  arma::mat iterate(3, 1, arma::fill::ones);
+
+  SnapshotEnsembles snapshotEnsembles(5, 2.0, stepSize, 1000, 2,
+      SnapshotStore(true));
+  snapshotEnsembles.EpochBatches() = 10 / (double) 1000;
+  for (size_t i = 0; i < 1000; ++i)
+    snapshotEnsembles.Update(iterate, stepSize, iterate);
+
+  REQUIRE(snapshotEnsembles.Store().Size() == 2);
+  REQUIRE(snapshotEnsembles.Snapshots().size() == 0);
+
+  arma::mat snapshot;
+  snapshotEnsembles.Store().Get(1, snapshot);
+  REQUIRE(arma::approx_equal(snapshot, iterate, "absdiff", 1e-12));
+}
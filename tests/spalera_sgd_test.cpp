@@ -58,3 +58,61 @@ TEST_CASE("LogisticRegressionTest","[SPALeRASGDTest]")
     REQUIRE(success == true); // At least one trial must succeed.
   }
 }
+
+/**
+ * Make sure that the in-place update of SPALeRAStepsize matches the
+ * parameter-wise update rule, keeps its buffers, and backtracks when the
+ * Page-Hinkley test detects an increase of the objective.
+ */
+TEST_CASE("SPALeRAStepsizeUpdateTest","[SPALeRASGDTest]")
+{
+  const double alpha = 0.1, epsilon = 1e-6, adaptRate = 0.01, stepSize = 0.1;
+  SPALeRAStepsize policy(alpha, epsilon, adaptRate);
+  policy.Initialize(3, 2, 0.5);
+  const double* rateMemory = policy.LearningRates().memptr();
+
+  arma::mat iterate = arma::linspace<arma::vec>(-1.0, 1.0, 6);
+  iterate.reshape(3, 2);
+  arma::mat expected = iterate;
+  arma::mat rates = arma::ones(3, 2);
+  arma::mat sums = arma::zeros(3, 2);
+  arma::mat previous;
+
+  for (size_t i = 0; i < 5; ++i)
+  {
+    const arma::mat gradient = 2.0 * iterate + 0.1 * (i + 1.0);
+    REQUIRE(policy.Update(stepSize, 1.0, 1, 10, iterate, gradient) == true);
+
+    // The update rule, computed directly.
+    const double n = 6;
+    const double paramMean = (alpha / (2 - alpha) *
+        (1 - std::pow(1 - alpha, 2 * (i + 1.0)))) / n;
+    const double paramStd = alpha / n;
+    const double normGradient = arma::norm(gradient, "fro");
+    sums = (1 - alpha) * sums + gradient * (alpha / normGradient);
+    rates %= arma::exp((arma::pow(sums, 2) - paramMean) *
+        (adaptRate / paramStd));
+    previous = expected;
+    expected -= stepSize * (rates % gradient);
+
+    for (size_t j = 0; j < iterate.n_elem; ++j)
+    {
+      REQUIRE(iterate[j] == Approx(expected[j]).epsilon(1e-12));
+      REQUIRE(policy.LearningRates()[j] == Approx(rates[j]).epsilon(1e-12));
+    }
+  }
+
+  // A jump of the objective makes the policy go back to the previous point
+  // and halve the learning rates.
+  const arma::mat gradient = 2.0 * iterate;
+  REQUIRE(policy.Update(stepSize, 100.0, 1, 10, iterate, gradient) == true);
+  for (size_t j = 0; j < iterate.n_elem; ++j)
+  {
+    REQUIRE(iterate[j] == Approx(previous[j]).epsilon(1e-12));
+    REQUIRE(policy.LearningRates()[j] ==
+        Approx(rates[j] / 2).epsilon(1e-12));
+  }
+
+  // The learning rates were updated in place.
+  REQUIRE(policy.LearningRates().memptr() == rateMemory);
+}
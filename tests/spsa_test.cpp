@@ -85,3 +85,19 @@ TEST_CASE("SPSALogisticRegressionTest", "[SPSATest]")
 
   REQUIRE(success == true);
 }
+
+/**
+ * Test the SPSA optimizer on the Sphere function, averaging several directions
+ * per iteration that are evaluated in parallel.
+ */
+TEST_CASE("SPSASphereFunctionPerturbationsTest", "[SPSATest]")
+{
+  SphereFunction f(4);
+  SPSA optimizer(0.1, 0.102, 0.16, 0.3, 20000, 0, true, 8, true);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  optimizer.Optimize(f, coordinates);
+
+  for (size_t j = 0; j < 4; ++j)
+    REQUIRE(coordinates[j] == Approx(0.0).margin(0.1));
+}
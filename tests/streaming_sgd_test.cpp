@@ -0,0 +1,132 @@
+/**
+ * @file streaming_sgd_test.cpp
+ *
+ * Test file for the StreamingSGD optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * A streaming function that reads the points of a logistic regression problem
+ * in order, one batch at a time, for the given number of passes.
+ */
+class LogisticRegressionStream
+{
+ public:
+  LogisticRegressionStream(const LogisticRegression<>& lr,
+                           const size_t passes) :
+      lr(lr),
+      passes(passes),
+      pass(0),
+      position(0),
+      begin(0),
+      batchSize(0),
+      batches(0)
+  { }
+
+  size_t NextBatch(const size_t maxBatchSize)
+  {
+    if (pass == passes)
+      return 0;
+
+    // Signal the end of the epoch, and start the next pass.
+    if (position == lr.NumFunctions())
+    {
+      position = 0;
+      ++pass;
+      return 0;
+    }
+
+    begin = position;
+    batchSize = std::min(maxBatchSize, lr.NumFunctions() - position);
+    position += batchSize;
+    ++batches;
+    return batchSize;
+  }
+
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              arma::mat& gradient)
+  {
+    return lr.EvaluateWithGradient(coordinates, begin, gradient, batchSize);
+  }
+
+  size_t Batches() const { return batches; }
+
+ private:
+  const LogisticRegression<>& lr;
+  size_t passes;
+  size_t pass;
+  size_t position;
+  size_t begin;
+  size_t batchSize;
+  size_t batches;
+};
+
+/**
+ * Run StreamingAdam on a stream of logistic regression points and make sure
+ * the results are acceptable.
+ */
+TEST_CASE("StreamingAdamLogisticRegressionTest", "[StreamingSGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+  LogisticRegressionStream stream(lr, std::numeric_limits<size_t>::max());
+
+  StreamingAdam optimizer(0.001, 32, 100000, 1e-5);
+  arma::mat coordinates = lr.GetInitialPoint();
+  optimizer.Optimize(stream, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+/**
+ * Make sure that StreamingSGD stops when the stream is exhausted, and returns
+ * the objective of the last pass.
+ */
+TEST_CASE("StreamingSGDSinglePassTest", "[StreamingSGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+  LogisticRegressionStream stream(lr, 1);
+
+  StreamingSGD<> optimizer(0.01, 32, 0, 1e-5);
+  arma::mat coordinates = lr.GetInitialPoint();
+  const double objective = optimizer.Optimize(stream, coordinates);
+
+  const size_t expectedBatches = (lr.NumFunctions() + 31) / 32;
+  REQUIRE(stream.Batches() == expectedBatches);
+  REQUIRE(objective > 0.0);
+  REQUIRE(std::isfinite(objective));
+
+  // The batches are only read up to the maximum number of iterations.
+  LogisticRegressionStream stream2(lr, std::numeric_limits<size_t>::max());
+  StreamingSGD<> optimizer2(0.01, 32, 100, 1e-5);
+  coordinates = lr.GetInitialPoint();
+  optimizer2.Optimize(stream2, coordinates);
+
+  REQUIRE(stream2.Batches() == 4);
+}
@@ -78,3 +78,162 @@ TEST_CASE("SVRGBBLogisticRegressionTest", "[SVRGTest]")
     REQUIRE(testAcc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
   }
 }
+
+/**
+ * Run SVRG with parallel full passes on logistic regression and make sure
+ * the results are acceptable.
+ */
+TEST_CASE("SVRGParallelFullPassLogisticRegressionTest", "[SVRGTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  SVRG optimizer(0.005, 40, 300, 0, 1e-5, true, SVRGUpdate(), NoDecay(),
+      true, true);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  arma::mat coordinates = lr.GetInitialPoint();
+  optimizer.Optimize(lr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+}
+
+/**
+ * Run SVRG on logistic regression, computing each objective in the same pass
+ * as the full gradient, and make sure the results are acceptable.
+ */
+TEST_CASE("SVRGReuseObjectiveLogisticRegressionTest", "[SVRGTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  SVRG optimizer(0.005, 40, 300, 0, 1e-5, true);
+  optimizer.ObjectiveEstimate() = ObjectiveEstimate::Reuse();
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  arma::mat coordinates = lr.GetInitialPoint();
+  const double objective = optimizer.Optimize(lr, coordinates);
+  REQUIRE(objective < lr.Evaluate(lr.GetInitialPoint()));
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+}
+
+/**
+ * Make sure that SVRG with lazy updates takes the same steps as with dense
+ * updates on a logistic regression function with sparse predictors.
+ */
+TEST_CASE("SVRGLazyUpdatesSparseLogisticRegressionTest", "[SVRGTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  const arma::sp_mat sparseData(shuffledData);
+  LogisticRegressionFunction<arma::sp_mat> lr(sparseData, shuffledResponses,
+      0.5);
+
+  for (size_t batchSize = 1; batchSize <= 7; batchSize += 3)
+  {
+    SVRG dense(0.005, batchSize, 5, 0, -1.0, false);
+    arma::mat denseCoordinates = lr.GetInitialPoint();
+    dense.Optimize(lr, denseCoordinates);
+
+    SVRG lazy(0.005, batchSize, 5, 0, -1.0, false);
+    lazy.LazyUpdates() = true;
+    arma::mat lazyCoordinates = lr.GetInitialPoint();
+    const double result = lazy.Optimize(lr, lazyCoordinates);
+
+    REQUIRE(arma::approx_equal(lazyCoordinates, denseCoordinates, "absdiff",
+        1e-8));
+    REQUIRE(result == Approx(lr.Evaluate(lazyCoordinates)).epsilon(1e-10));
+  }
+}
+
+/**
+ * Run the asynchronous SVRG, with atomic and unsynchronized updates, on a
+ * sparse logistic regression and make sure the results are acceptable.
+ */
+TEST_CASE("AsyncSVRGSparseLogisticRegressionTest", "[SVRGTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  const arma::sp_mat sparseData(shuffledData);
+  LogisticRegressionFunction<arma::sp_mat> lr(sparseData, shuffledResponses,
+      0.5);
+
+  AsyncSVRG atomic(0.005, 10, 100, 0, 1e-5, true);
+  arma::mat coordinates = lr.GetInitialPoint();
+  const double result = atomic.Optimize(lr, coordinates);
+
+  REQUIRE(result == Approx(lr.Evaluate(coordinates)).epsilon(1e-10));
+  double acc = lr.ComputeAccuracy(arma::sp_mat(data), responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+  double testAcc = lr.ComputeAccuracy(arma::sp_mat(testData), testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+
+  HogwildSVRG hogwild(0.005, 10, 100, 0, 1e-5, true);
+  coordinates = lr.GetInitialPoint();
+  hogwild.Optimize(lr, coordinates);
+
+  acc = lr.ComputeAccuracy(arma::sp_mat(data), responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+  testAcc = lr.ComputeAccuracy(arma::sp_mat(testData), testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+}
+
+/**
+ * Make sure that the memory estimate of SVRG counts its extra gradients, and
+ * the full gradient kept by the Barzilai-Borwein decay.
+ */
+TEST_CASE("SVRGEstimateMemoryTest", "[SVRGTest]")
+{
+  SVRG svrg;
+  REQUIRE(svrg.EstimateMemory(100, 3) == 4 * 300 * sizeof(double));
+
+  SVRG_BB svrgBB;
+  REQUIRE(svrgBB.EstimateMemory(300) == 5 * 300 * sizeof(double));
+
+  svrg.LazyUpdates() = true;
+  REQUIRE(svrg.EstimateMemory(300) == 4 * 300 * sizeof(double) +
+      300 * sizeof(size_t));
+}
+
+/**
+ * Make sure that the memory estimate of the asynchronous SVRG counts the
+ * partial sums of every thread.
+ */
+TEST_CASE("AsyncSVRGEstimateMemoryTest", "[SVRGTest]")
+{
+  size_t threads = 1;
+  #ifdef ENS_USE_OPENMP
+    threads = omp_get_max_threads();
+  #endif
+
+  AsyncSVRG svrg;
+  REQUIRE(svrg.EstimateMemory(100, 3) ==
+      (2 + 2 * threads) * 300 * sizeof(double));
+}
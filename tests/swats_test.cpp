@@ -71,3 +71,47 @@ TEST_CASE("SWATSStyblinskiTangFunctionTest","[SWATSTest]")
   REQUIRE(coordinates[0] == Approx(-2.9).epsilon(0.01));
   REQUIRE(coordinates[1] == Approx(-2.9).epsilon(0.01));
 }
+
+/**
+ * Test the SWATS optimizer with interleaved state on the Sphere function.
+ */
+TEST_CASE("SWATSInterleavedSphereFunctionTest","[SWATSTest]")
+{
+  SphereFunction f(2);
+  SWATS optimizer(1e-3, 2, 0.9, 0.999, 1e-6, 500000, 1e-9, true);
+  optimizer.Interleaved() = true;
+
+  arma::mat coordinates = f.GetInitialPoint();
+  optimizer.Optimize(f, coordinates);
+
+  REQUIRE(coordinates[0] == Approx(0.0).margin(0.1));
+  REQUIRE(coordinates[1] == Approx(0.0).margin(0.1));
+}
+
+/**
+ * Make sure that the SWATS update gives the same iterates with separate and
+ * with interleaved moments, through the switch to SGD.
+ */
+TEST_CASE("SWATSInterleavedMatchesSeparateTest","[SWATSTest]")
+{
+  SWATSUpdate separate(1e-6, 0.9, 0.999, false);
+  SWATSUpdate interleaved(1e-6, 0.9, 0.999, true);
+  SWATSUpdate::Policy<arma::mat, arma::mat> separatePolicy(separate, 3, 1);
+  SWATSUpdate::Policy<arma::mat, arma::mat> interleavedPolicy(interleaved, 3,
+      1);
+
+  SphereFunction f(3);
+  arma::mat x1 = f.GetInitialPoint();
+  arma::mat x2 = x1;
+  arma::mat g1, g2;
+  for (size_t i = 0; i < 2000; ++i)
+  {
+    f.Gradient(x1, g1);
+    f.Gradient(x2, g2);
+    separatePolicy.Update(x1, 1e-2, g1);
+    interleavedPolicy.Update(x2, 1e-2, g2);
+  }
+
+  for (size_t j = 0; j < x1.n_elem; ++j)
+    REQUIRE(x1[j] == Approx(x2[j]).margin(1e-8));
+}